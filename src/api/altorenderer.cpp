@@ -14,6 +14,7 @@
 // limitations under the License.
 
 #include <memory>
+#include <ostream>  // for std::ostream
 #include <sstream>  // for std::stringstream
 #include "baseapi.h"
 #ifdef _WIN32
@@ -27,7 +28,7 @@ namespace tesseract {
 /// Add word confidence if adding to a String bounding box.
 ///
 static void AddBoxToAlto(const ResultIterator* it, PageIteratorLevel level,
-                         std::stringstream& alto_str) {
+                         std::ostream& alto_str) {
   int left, top, right, bottom;
   it->BoundingBox(level, &left, &top, &right, &bottom);
 
@@ -90,12 +91,7 @@ bool TessAltoRenderer::BeginDocumentHandler() {
 /// Append the ALTO XML for the layout of the image
 ///
 bool TessAltoRenderer::AddImageHandler(TessBaseAPI* api) {
-  const std::unique_ptr<const char[]> text(api->GetAltoText(imagenum()));
-  if (text == nullptr) return false;
-
-  AppendString(text.get());
-
-  return true;
+  return api->GetAltoText(nullptr, imagenum(), output()) && happy();
 }
 
 ///
@@ -123,8 +119,22 @@ char* TessBaseAPI::GetAltoText(int page_number) {
 /// data structures.
 ///
 char* TessBaseAPI::GetAltoText(ETEXT_DESC* monitor, int page_number) {
+  std::stringstream alto_str;
+  if (!GetAltoText(monitor, page_number, alto_str)) return nullptr;
+
+  const std::string& text = alto_str.str();
+  char* result = new char[text.length() + 1];
+  strcpy(result, text.c_str());
+  return result;
+}
+
+///
+/// Write the ALTO markup of the page to alto_str while walking the results.
+///
+bool TessBaseAPI::GetAltoText(ETEXT_DESC* monitor, int page_number,
+                              std::ostream& alto_str) {
   if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(monitor) < 0))
-    return nullptr;
+    return false;
 
   int lcnt = 0, bcnt = 0, wcnt = 0;
 
@@ -147,7 +157,6 @@ char* TessBaseAPI::GetAltoText(ETEXT_DESC* monitor, int page_number) {
   delete[] utf8_str;
 #endif
 
-  std::stringstream alto_str;
   alto_str
       << "\t\t<Page WIDTH=\"" << rect_width_ << "\" HEIGHT=\""
       << rect_height_
@@ -219,12 +228,8 @@ char* TessBaseAPI::GetAltoText(ETEXT_DESC* monitor, int page_number) {
 
   alto_str << "\t\t\t</PrintSpace>\n"
            << "\t\t</Page>\n";
-  const std::string& text = alto_str.str();
-
-  char* result = new char[text.length() + 1];
-  strcpy(result, text.c_str());
   delete res_it;
-  return result;
+  return true;
 }
 
 }  // namespace tesseract
@@ -43,20 +43,32 @@
 #include <unistd.h>
 #endif  // _WIN32
 
+#include <algorithm>           // for std::max
+#include <climits>             // for LONG_MAX
 #include <cmath>               // for round, M_PI
-#include <cstdint>             // for int32_t
+#include <condition_variable>  // for std::condition_variable
+#include <cstdint>             // for int32_t, SIZE_MAX, UINT16_MAX
 #include <cstring>             // for strcmp, strcpy
+#include <deque>               // for std::deque
 #include <fstream>             // for size_t
+#include <functional>          // for std::function
 #include <iostream>            // for std::cin
 #include <locale>              // for std::locale::classic
 #include <memory>              // for std::unique_ptr
+#include <mutex>               // for std::mutex
 #include <set>                 // for std::pair
 #include <sstream>             // for std::stringstream
+#include <thread>              // for std::thread
+#include <type_traits>         // for std::remove_pointer
 #include <vector>              // for std::vector
 #include "allheaders.h"        // for pixDestroy, boxCreate, boxaAddBox, box...
+#include "blobbox.h"           // for BLOBNBOX
 #include "blobclass.h"         // for ExtractFontName
 #include "boxword.h"           // for BoxWord
+#include "colpartition.h"      // for ColPartition
 #include "config_auto.h"       // for PACKAGE_VERSION
+#include "counters.h"          // for Counters, ScopedCounters, CounterName
+#include "memoryusage.h"        // for MemoryUsage, MemoryTracker
 #include "coutln.h"            // for C_OUTLINE_IT, C_OUTLINE_LIST
 #include "dawg_cache.h"        // for DawgCache
 #include "dict.h"              // for Dict
@@ -67,16 +79,23 @@
 #include "errcode.h"           // for ASSERT_HOST
 #include "helpers.h"           // for IntCastRounded, chomp_string
 #include "imageio.h"           // for IFF_TIFF_G4, IFF_TIFF, IFF_TIFF_G3, ...
+#include "initprofile.h"       // for InitProfile, InitPhase
 #ifndef DISABLED_LEGACY_ENGINE
 #include "intfx.h"             // for INT_FX_RESULT_STRUCT
 #endif
+#include "layerprofile.h"      // for LayerProfile
+#ifndef ANDROID_BUILD
+#include "lstmrecognizer.h"    // for LSTMRecognizer
+#endif
 #include "mutableiterator.h"   // for MutableIterator
 #include "normalis.h"          // for kBlnBaselineOffset, kBlnXHeight
+#include "ocrblock.h"          // for BLOCK, BLOCK_LIST
 #include "ocrclass.h"          // for ETEXT_DESC
 #if defined(USE_OPENCL)
 #include "openclwrapper.h"     // for OpenclDevice
 #endif
 #include "osdetect.h"          // for OSResults, OSBestResult, OrientationId...
+#include "otsuthr.h"           // for OtsuThreshold
 #include "pageres.h"           // for PAGE_RES_IT, WERD_RES, PAGE_RES, CR_DE...
 #include "paragraphs.h"        // for DetectParagraphs
 #include "params.h"            // for BoolParam, IntParam, DoubleParam, Stri...
@@ -86,12 +105,15 @@
 #include "rect.h"              // for TBOX
 #include "renderer.h"          // for TessResultRenderer
 #include "resultiterator.h"    // for ResultIterator
+#include "simddetect.h"        // for SIMDDetect
 #include "stepblob.h"          // for C_BLOB_IT, C_BLOB, C_BLOB_LIST
 #include "strngs.h"            // for STRING
+#include "tabvector.h"         // for TabVector
 #include "tessdatamanager.h"   // for TessdataManager, kTrainedDataSuffix
 #include "tesseractclass.h"    // for Tesseract
 #include "thresholder.h"       // for ImageThresholder
 #include "tprintf.h"           // for tprintf
+#include "tracing.h"           // for TraceSpan, Tracing
 #include "werd.h"              // for WERD, WERD_IT, W_FUZZY_NON, W_FUZZY_SP
 
 static BOOL_VAR(stream_filelist, false, "Stream a filelist from stdin");
@@ -117,6 +139,19 @@ static const char* kInputFile = "noname.tif";
 static const char* kOldVarsFile = "failed_vars.txt";
 /** Max string length of an int.  */
 const int kMaxIntSize = 22;
+/** Reduction of the image in which DownscaleFactor measures the text. */
+const int kTextHeightReduction = 4;
+/** Min number of components for DownscaleFactor to trust their heights. */
+const size_t kMinTextHeightSamples = 20;
+/** Max factor by which tessedit_auto_downscale reduces an image. */
+const int kMaxDownscaleFactor = 4;
+/**
+ * Estimate of the bytes per pixel of the images, masks and grids of the
+ * layout analysis of a page, which get half of tessedit_memory_budget_mb.
+ */
+const int kPageBytesPerPixel = 4;
+/** Max factor by which tessedit_memory_budget_mb reduces an image. */
+const int kMaxBudgetReduction = 8;
 
 /* Add all available languages recursively.
 */
@@ -200,9 +235,23 @@ TessBaseAPI::TessBaseAPI()
       output_file_(nullptr),
       datapath_(nullptr),
       language_(nullptr),
+      init_profile_(new InitProfile),
+      counters_(new Counters),
+      memory_tracker_(new MemoryTracker),
+      init_non_debug_only_(false),
+      init_from_memory_(false),
       last_oem_requested_(OEM_DEFAULT),
       recognition_done_(false),
+      paragraphs_pending_(false),
       truth_cb_(nullptr),
+      keep_layout_(false),
+      kept_pageseg_mode_(PSM_AUTO),
+      kept_block_list_(nullptr),
+      kept_pix_binary_(nullptr),
+      kept_pix_grey_(nullptr),
+      kept_pix_thresholds_(nullptr),
+      kept_source_resolution_(0),
+      kept_image_reduction_(1),
       rect_left_(0),
       rect_top_(0),
       rect_width_(0),
@@ -223,6 +272,10 @@ TessBaseAPI::TessBaseAPI()
 
 TessBaseAPI::~TessBaseAPI() {
   End();
+  delete init_profile_;
+  delete counters_;
+  // After End, as the grids of tesseract_ take their bytes back from it.
+  delete memory_tracker_;
 }
 
 /**
@@ -232,6 +285,14 @@ const char* TessBaseAPI::Version() {
   return PACKAGE_VERSION;
 }
 
+/**
+ * Returns the name of the selected SIMD code for dot products and int
+ * matrices. Do not delete.
+ */
+const char* TessBaseAPI::SIMDKernel() {
+  return SIMDDetect::KernelName();
+}
+
 /**
  * If compiled with OpenCL AND an available OpenCL
  * device is deemed faster than serial code, then
@@ -286,7 +347,7 @@ bool TessBaseAPI::SetDebugVariable(const char* name, const char* value) {
 
 bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
   auto *p = ParamUtils::FindParam<IntParam>(
-      name, GlobalParams()->int_params, tesseract_->params()->int_params);
+      name, GlobalParams(), tesseract_->params());
   if (p == nullptr) return false;
   *value = (int32_t)(*p);
   return true;
@@ -294,7 +355,7 @@ bool TessBaseAPI::GetIntVariable(const char *name, int *value) const {
 
 bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
   auto *p = ParamUtils::FindParam<BoolParam>(
-      name, GlobalParams()->bool_params, tesseract_->params()->bool_params);
+      name, GlobalParams(), tesseract_->params());
   if (p == nullptr) return false;
   *value = bool(*p);
   return true;
@@ -302,13 +363,13 @@ bool TessBaseAPI::GetBoolVariable(const char *name, bool *value) const {
 
 const char *TessBaseAPI::GetStringVariable(const char *name) const {
   auto *p = ParamUtils::FindParam<StringParam>(
-      name, GlobalParams()->string_params, tesseract_->params()->string_params);
+      name, GlobalParams(), tesseract_->params());
   return (p != nullptr) ? p->string() : nullptr;
 }
 
 bool TessBaseAPI::GetDoubleVariable(const char *name, double *value) const {
   auto *p = ParamUtils::FindParam<DoubleParam>(
-      name, GlobalParams()->double_params, tesseract_->params()->double_params);
+      name, GlobalParams(), tesseract_->params());
   if (p == nullptr) return false;
   *value = (double)(*p);
   return true;
@@ -319,6 +380,167 @@ bool TessBaseAPI::GetVariableAsString(const char *name, STRING *val) {
   return ParamUtils::GetParamAsString(name, tesseract_->params(), val);
 }
 
+/**
+ * Parses each value once for every type of param of its name, as SetParam
+ * does, so that applying the profile needs no parsing.
+ */
+bool TessBaseAPI::CompileVariables(const GenericVector<STRING>* names,
+                                   const GenericVector<STRING>* values,
+                                   VariableProfile* profile) const {
+  profile->clear();
+  if (names == nullptr || values == nullptr) return true;
+  const ParamsVectors* member_params =
+      tesseract_ != nullptr ? tesseract_->params() : nullptr;
+  const SetParamConstraint constraint = SET_PARAM_CONSTRAINT_NON_INIT_ONLY;
+  bool ok = true;
+  for (int i = 0; i < names->size() && i < values->size(); ++i) {
+    const char* name = (*names)[i].c_str();
+    const char* value = (*values)[i].c_str();
+    VariableProfile::Value compiled = {nullptr, VariableProfile::kString, 0,
+                                       0.0, std::string()};
+    bool found = false;
+    auto* sp = ParamUtils::FindParam<StringParam>(name, GlobalParams(),
+                                                  member_params);
+    if (sp != nullptr && sp->constraint_ok(constraint)) {
+      compiled.name = sp->name_str();
+      compiled.type = VariableProfile::kString;
+      compiled.string_value = value;
+      profile->values_.push_back(compiled);
+      found = true;
+    }
+    auto* ip = ParamUtils::FindParam<IntParam>(name, GlobalParams(),
+                                               member_params);
+    int32_t intval;
+    if (ip != nullptr && ip->constraint_ok(constraint) &&
+        ParamUtils::ParseIntValue(value, &intval)) {
+      compiled.name = ip->name_str();
+      compiled.type = VariableProfile::kInt;
+      compiled.int_value = intval;
+      profile->values_.push_back(compiled);
+      found = true;
+    }
+    auto* bp = ParamUtils::FindParam<BoolParam>(name, GlobalParams(),
+                                                member_params);
+    bool boolval;
+    if (bp != nullptr && bp->constraint_ok(constraint) &&
+        ParamUtils::ParseBoolValue(value, &boolval)) {
+      compiled.name = bp->name_str();
+      compiled.type = VariableProfile::kBool;
+      compiled.int_value = boolval;
+      profile->values_.push_back(compiled);
+      found = true;
+    }
+    auto* dp = ParamUtils::FindParam<DoubleParam>(name, GlobalParams(),
+                                                  member_params);
+    double doubleval;
+    if (dp != nullptr && dp->constraint_ok(constraint) &&
+        ParamUtils::ParseDoubleValue(value, &doubleval)) {
+      compiled.name = dp->name_str();
+      compiled.type = VariableProfile::kDouble;
+      compiled.double_value = doubleval;
+      profile->values_.push_back(compiled);
+      found = true;
+    }
+    if (!found) ok = false;
+  }
+  return ok;
+}
+
+void TessBaseAPI::ApplyVariables(const VariableProfile& profile,
+                                 VariableProfile* previous) {
+  if (tesseract_ == nullptr) tesseract_ = new Tesseract;
+  const ParamsVectors* member_params = tesseract_->params();
+  // Collected apart, in case previous is the profile being applied.
+  VariableProfile old_values;
+  for (const auto& value : profile.values_) {
+    VariableProfile::Value old_value = value;
+    switch (value.type) {
+      case VariableProfile::kInt: {
+        auto* p = ParamUtils::FindParam<IntParam>(value.name, GlobalParams(),
+                                                  member_params);
+        if (p == nullptr) continue;
+        old_value.int_value = *p;
+        p->set_value(value.int_value);
+        break;
+      }
+      case VariableProfile::kBool: {
+        auto* p = ParamUtils::FindParam<BoolParam>(value.name, GlobalParams(),
+                                                   member_params);
+        if (p == nullptr) continue;
+        old_value.int_value = bool(*p);
+        p->set_value(value.int_value != 0);
+        break;
+      }
+      case VariableProfile::kDouble: {
+        auto* p = ParamUtils::FindParam<DoubleParam>(
+            value.name, GlobalParams(), member_params);
+        if (p == nullptr) continue;
+        old_value.double_value = *p;
+        p->set_value(value.double_value);
+        break;
+      }
+      case VariableProfile::kString: {
+        auto* p = ParamUtils::FindParam<StringParam>(
+            value.name, GlobalParams(), member_params);
+        if (p == nullptr) continue;
+        old_value.string_value = p->string();
+        p->set_value(STRING(value.string_value.c_str()));
+        break;
+      }
+    }
+    if (previous != nullptr) old_values.values_.push_back(old_value);
+  }
+  if (previous != nullptr) {
+    // Reverting in the reverse order restores a param set twice correctly.
+    old_values.values_.assign(old_values.values_.rbegin(),
+                              old_values.values_.rend());
+    previous->values_.swap(old_values.values_);
+  }
+}
+
+void TessBaseAPI::SaveVariables(VariableProfile* snapshot) const {
+  snapshot->clear();
+  const ParamsVectors* member_params =
+      tesseract_ != nullptr ? tesseract_->params() : nullptr;
+  // Only the params that SetVariable can set, and that are found by their
+  // name, are saved.
+  auto settable = [member_params](auto* param) {
+    using ParamType = typename std::remove_pointer<decltype(param)>::type;
+    return param->constraint_ok(SET_PARAM_CONSTRAINT_NON_INIT_ONLY) &&
+           ParamUtils::FindParam<ParamType>(param->name_str(), GlobalParams(),
+                                            member_params) == param;
+  };
+  const ParamsVectors* vecs[] = {GlobalParams(), member_params};
+  for (const ParamsVectors* vec : vecs) {
+    if (vec == nullptr) continue;
+    for (int i = 0; i < vec->int_params.size(); ++i) {
+      IntParam* p = vec->int_params[i];
+      if (!settable(p)) continue;
+      snapshot->values_.push_back({p->name_str(), VariableProfile::kInt,
+                                   static_cast<int32_t>(*p), 0.0,
+                                   std::string()});
+    }
+    for (int i = 0; i < vec->bool_params.size(); ++i) {
+      BoolParam* p = vec->bool_params[i];
+      if (!settable(p)) continue;
+      snapshot->values_.push_back({p->name_str(), VariableProfile::kBool,
+                                   bool(*p), 0.0, std::string()});
+    }
+    for (int i = 0; i < vec->double_params.size(); ++i) {
+      DoubleParam* p = vec->double_params[i];
+      if (!settable(p)) continue;
+      snapshot->values_.push_back({p->name_str(), VariableProfile::kDouble, 0,
+                                   static_cast<double>(*p), std::string()});
+    }
+    for (int i = 0; i < vec->string_params.size(); ++i) {
+      StringParam* p = vec->string_params[i];
+      if (!settable(p)) continue;
+      snapshot->values_.push_back({p->name_str(), VariableProfile::kString, 0,
+                                   0.0, std::string(p->string())});
+    }
+  }
+}
+
 /** Print Tesseract parameters to the given file. */
 void TessBaseAPI::PrintVariables(FILE *fp) const {
   ParamUtils::PrintParams(fp, tesseract_->params());
@@ -349,6 +571,10 @@ int TessBaseAPI::Init(const char* data, int data_size, const char* language,
                       const GenericVector<STRING>* vars_vec,
                       const GenericVector<STRING>* vars_values,
                       bool set_only_non_debug_params, FileReader reader) {
+  init_profile_->Clear();
+  ScopedInitProfile profiling(init_profile_);
+  ScopedCounters counting(counters_);
+  InitPhase phase("Init");
   // Default language is "eng".
   if (language == nullptr) language = "eng";
   STRING datapath = data_size == 0 ? data : language;
@@ -384,6 +610,18 @@ int TessBaseAPI::Init(const char* data, int data_size, const char* language,
             set_only_non_debug_params, &mgr) != 0) {
       return -1;
     }
+    // Remember how tesseract_ was loaded, for InitLike.
+    init_configs_.assign(configs, configs + configs_size);
+    init_vars_.clear();
+    init_values_.clear();
+    if (vars_vec != nullptr && vars_values != nullptr) {
+      for (int i = 0; i < vars_vec->size(); ++i) {
+        init_vars_.push_back((*vars_vec)[i].string());
+        init_values_.push_back((*vars_values)[i].string());
+      }
+    }
+    init_non_debug_only_ = set_only_non_debug_params;
+    init_from_memory_ = data_size != 0;
   }
 
   // Update datapath and language requested for the last valid initialization.
@@ -410,6 +648,37 @@ int TessBaseAPI::Init(const char* data, int data_size, const char* language,
   return 0;
 }
 
+int TessBaseAPI::InitLike(const TessBaseAPI& source) {
+  // There is no traineddata to load from if source read it from memory.
+  if (&source == this || source.tesseract_ == nullptr ||
+      source.datapath_ == nullptr || source.language_ == nullptr ||
+      source.init_from_memory_) {
+    return -1;
+  }
+  std::vector<char*> configs;
+  for (const std::string& config : source.init_configs_) {
+    configs.push_back(const_cast<char*>(config.c_str()));
+  }
+  GenericVector<STRING> vars_vec, vars_values;
+  for (size_t i = 0; i < source.init_vars_.size(); ++i) {
+    vars_vec.push_back(source.init_vars_[i].c_str());
+    vars_values.push_back(source.init_values_[i].c_str());
+  }
+  // Start again, so that the configs and vars are applied as they were to
+  // source even if this has the same language loaded.
+  End();
+  if (Init(source.datapath_->string(), 0, source.language_->string(),
+           source.last_oem_requested_, configs.data(), configs.size(),
+           &vars_vec, &vars_values, source.init_non_debug_only_,
+           source.reader_) != 0) {
+    return -1;
+  }
+  VariableProfile variables;
+  source.SaveVariables(&variables);
+  ApplyVariables(variables, nullptr);
+  return 0;
+}
+
 /**
  * Returns the languages string used in the last valid initialization.
  * If the last initialization specified "deu+hin" then that will be
@@ -423,6 +692,131 @@ const char* TessBaseAPI::GetInitLanguagesAsString() const {
       "" : language_->string();
 }
 
+/**
+ * Returns the time and memory taken by the phases of the last Init, one per
+ * line, indented under the phase that encloses them.
+ * The returned string must be freed with the delete [] operator.
+ */
+char* TessBaseAPI::GetInitProfileText() const {
+  std::string text;
+  init_profile_->Print(&text);
+  char* result = new char[text.length() + 1];
+  strcpy(result, text.c_str());
+  return result;
+}
+
+void TessBaseAPI::StartTracing() {
+  Tracing::Start();
+}
+
+void TessBaseAPI::StopTracing() {
+  Tracing::Stop();
+}
+
+char* TessBaseAPI::GetTraceJSON() {
+  std::string json;
+  Tracing::WriteChromeTrace(&json);
+  char* result = new char[json.length() + 1];
+  strcpy(result, json.c_str());
+  return result;
+}
+
+void TessBaseAPI::StartLayerProfile() {
+  LayerProfile::Start();
+}
+
+void TessBaseAPI::StopLayerProfile() {
+  LayerProfile::Stop();
+}
+
+char* TessBaseAPI::GetLayerProfileText() {
+  std::string text;
+  LayerProfile::Print(&text);
+  char* result = new char[text.length() + 1];
+  strcpy(result, text.c_str());
+  return result;
+}
+
+// Copies the first size values of snapshot to values.
+static int CopyCounters(const CounterSnapshot& snapshot, int64_t* values,
+                        int size) {
+  for (int i = 0; i < size && i < COUNTER_COUNT; ++i) {
+    values[i] = snapshot.values[i];
+  }
+  return COUNTER_COUNT;
+}
+
+int TessBaseAPI::GetCounters(int64_t* values, int size) const {
+  CounterSnapshot snapshot;
+  counters_->Snapshot(&snapshot);
+  return CopyCounters(snapshot, values, size);
+}
+
+void TessBaseAPI::ResetCounters() {
+  counters_->Reset();
+}
+
+int TessBaseAPI::GetProcessCounters(int64_t* values, int size) {
+  CounterSnapshot snapshot;
+  Counters::ProcessSnapshot(&snapshot);
+  return CopyCounters(snapshot, values, size);
+}
+
+const char* TessBaseAPI::GetCounterName(int index) {
+  return CounterName(static_cast<CounterId>(index));
+}
+
+void TessBaseAPI::EstimateMemoryUsage(MemoryUsage* usage) const {
+  std::vector<const void*> image_data;
+  if (thresholder_ != nullptr) {
+    Tesseract::AddImageMemoryUsage(thresholder_->source_pix(), &image_data,
+                                   usage);
+  }
+  for (Pix* pix : {kept_pix_binary_, kept_pix_grey_, kept_pix_thresholds_}) {
+    Tesseract::AddImageMemoryUsage(pix, &image_data, usage);
+  }
+  if (tesseract_ != nullptr) tesseract_->AddMemoryUsage(usage, &image_data);
+  if (osd_tesseract_ != nullptr && osd_tesseract_ != tesseract_)
+    osd_tesseract_->AddMemoryUsage(usage, &image_data);
+  if (page_res_ != nullptr)
+    usage->Add(MEMORY_PAGE_RES, page_res_->MemoryBytes());
+  usage->Add(MEMORY_BBGRIDS, memory_tracker_->bytes());
+}
+
+int TessBaseAPI::GetMemoryUsage(int64_t* values, int size) const {
+  MemoryUsage usage;
+  EstimateMemoryUsage(&usage);
+  for (int i = 0; i < size && i < MEMORY_COUNT; ++i) {
+    values[i] = usage.bytes[i];
+  }
+  return MEMORY_COUNT;
+}
+
+int64_t TessBaseAPI::GetPageMemoryHighWater() const {
+  MemoryUsage usage;
+  EstimateMemoryUsage(&usage);
+  return usage.Total() - usage.bytes[MEMORY_BBGRIDS] + memory_tracker_->peak();
+}
+
+char* TessBaseAPI::GetMemoryUsageText() const {
+  MemoryUsage usage;
+  EstimateMemoryUsage(&usage);
+  std::string text;
+  usage.Print(&text);
+  char line[64];
+  snprintf(line, sizeof(line), "%12.3f MB  page high-water mark\n",
+           (usage.Total() - usage.bytes[MEMORY_BBGRIDS] +
+            memory_tracker_->peak()) / 1048576.0);
+  text += line;
+  char* result = new char[text.length() + 1];
+  strcpy(result, text.c_str());
+  return result;
+}
+
+const char* TessBaseAPI::GetMemoryCategoryName(int index) {
+  return MemoryCategoryName(static_cast<MemoryCategory>(index));
+}
+
 /**
  * Returns the loaded languages in the vector of STRINGs.
  * Includes all languages loaded by the last Init, including those loaded
@@ -557,6 +951,24 @@ void TessBaseAPI::ClearAdaptiveClassifier() {
   tesseract_->ResetAdaptiveClassifier();
   tesseract_->ResetDocumentDictionary();
 }
+
+/**
+ * Writes the adaptive classifier state to filename. Returns false on error.
+ */
+bool TessBaseAPI::SaveAdaptiveClassifier(const char* filename) {
+  if (tesseract_ == nullptr)
+    return false;
+  return tesseract_->SaveAdaptiveClassifier(filename);
+}
+
+/**
+ * Reads the adaptive classifier state from filename. Returns false on error.
+ */
+bool TessBaseAPI::LoadAdaptiveClassifier(const char* filename) {
+  if (tesseract_ == nullptr)
+    return false;
+  return tesseract_->LoadAdaptiveClassifier(filename);
+}
 #endif  // ndef DISABLED_LEGACY_ENGINE
 
 /**
@@ -569,14 +981,17 @@ void TessBaseAPI::ClearAdaptiveClassifier() {
 void TessBaseAPI::SetImage(const unsigned char* imagedata,
                            int width, int height,
                            int bytes_per_pixel, int bytes_per_line) {
+  TraceSpan span("SetImage");
   if (InternalSetImage()) {
     thresholder_->SetImage(imagedata, width, height,
                            bytes_per_pixel, bytes_per_line);
-    SetInputImage(thresholder_->GetPixRect());
+    SetInputImage(thresholder_->IsEmpty() ? nullptr
+                                          : thresholder_->GetPixRect());
   }
 }
 
 void TessBaseAPI::SetSourceResolution(int ppi) {
+  ClearKeptLayout();
   if (thresholder_)
     thresholder_->SetSourceYResolution(ppi);
   else
@@ -592,6 +1007,7 @@ void TessBaseAPI::SetSourceResolution(int ppi) {
  * and it is therefore more efficient to provide a Pix directly.
  */
 void TessBaseAPI::SetImage(Pix* pix) {
+  TraceSpan span("SetImage");
   if (InternalSetImage()) {
     if (pixGetSpp(pix) == 4 && pixGetInputFormat(pix) == IFF_PNG) {
       // remove alpha channel from png
@@ -601,7 +1017,23 @@ void TessBaseAPI::SetImage(Pix* pix) {
       pixDestroy(&p1);
     }
     thresholder_->SetImage(pix);
-    SetInputImage(thresholder_->GetPixRect());
+    SetInputImage(thresholder_->IsEmpty() ? nullptr
+                                          : thresholder_->GetPixRect());
+  }
+}
+
+/**
+ * Provide an 8 bit greyscale image for Tesseract to recognize, without
+ * copying it. The image data must stay valid and unchanged until the next
+ * SetImage, SetImageView, Clear or End.
+ */
+void TessBaseAPI::SetImageView(const unsigned char* imagedata,
+                               int width, int height, int bytes_per_line) {
+  TraceSpan span("SetImage");
+  if (InternalSetImage()) {
+    thresholder_->SetImageView(imagedata, width, height, bytes_per_line);
+    // The input image is made from the view after thresholding.
+    SetInputImage(nullptr);
   }
 }
 
@@ -614,6 +1046,7 @@ void TessBaseAPI::SetRectangle(int left, int top, int width, int height) {
   if (thresholder_ == nullptr)
     return;
   thresholder_->SetRectangle(left, top, width, height);
+  ClearKeptLayout();
   ClearResults();
 }
 
@@ -697,6 +1130,28 @@ Boxa* TessBaseAPI::GetComponentImages(PageIteratorLevel level,
                                       const int raw_padding,
                                       Pixa** pixa, int** blockids,
                                       int** paraids) {
+  std::vector<ComponentView> views;
+  Boxa* boxa = GetComponentViews(level, text_only, raw_image, raw_padding,
+                                 pixa != nullptr ? &views : nullptr, blockids,
+                                 paraids);
+  if (boxa != nullptr && pixa != nullptr) {
+    *pixa = pixaCreate(views.size());
+    for (size_t i = 0; i < views.size(); ++i) {
+      pixaAddPix(*pixa, views[i].GetImage(), L_INSERT);
+      pixaAddBox(*pixa, boxaGetBox(boxa, i, L_CLONE), L_INSERT);
+    }
+  }
+  return boxa;
+}
+
+/**
+ * As GetComponentImages, but fills views with a ComponentView of each
+ * component, from which its image can be cropped on request.
+ */
+Boxa* TessBaseAPI::GetComponentViews(PageIteratorLevel level, bool text_only,
+                                     bool raw_image, int raw_padding,
+                                     std::vector<ComponentView>* views,
+                                     int** blockids, int** paraids) {
   PageIterator* page_it = GetIterator();
   if (page_it == nullptr)
     page_it = AnalyseLayout();
@@ -727,8 +1182,10 @@ Boxa* TessBaseAPI::GetComponentImages(PageIteratorLevel level,
   } while (page_it->Next(level));
 
   Boxa* boxa = boxaCreate(component_count);
-  if (pixa != nullptr)
-    *pixa = pixaCreate(component_count);
+  if (views != nullptr) {
+    views->clear();
+    views->reserve(component_count);
+  }
   if (blockids != nullptr)
     *blockids = new int[component_count];
   if (paraids != nullptr)
@@ -743,16 +1200,10 @@ Boxa* TessBaseAPI::GetComponentImages(PageIteratorLevel level,
         (!text_only || PTIsTextType(page_it->BlockType()))) {
       Box* lbox = boxCreate(left, top, right - left, bottom - top);
       boxaAddBox(boxa, lbox, L_INSERT);
-      if (pixa != nullptr) {
-        Pix* pix = nullptr;
-        if (raw_image) {
-          pix = page_it->GetImage(level, raw_padding, GetInputImage(), &left,
-                                  &top);
-        } else {
-          pix = page_it->GetBinaryImage(level);
-        }
-        pixaAddPix(*pixa, pix, L_INSERT);
-        pixaAddBox(*pixa, lbox, L_CLONE);
+      if (views != nullptr) {
+        views->emplace_back(*page_it, level,
+                            raw_image ? GetInputImage() : nullptr,
+                            raw_padding);
       }
       if (paraids != nullptr) {
         (*paraids)[component_index] = paraid;
@@ -774,6 +1225,19 @@ Boxa* TessBaseAPI::GetComponentImages(PageIteratorLevel level,
   return boxa;
 }
 
+ComponentView::ComponentView(const PageIterator& it, PageIteratorLevel level,
+                             Pix* raw_image, int raw_padding)
+    : it_(new PageIterator(it)),
+      level_(level),
+      raw_image_(raw_image),
+      raw_padding_(raw_padding) {}
+
+Pix* ComponentView::GetImage() const {
+  if (raw_image_ == nullptr) return it_->GetBinaryImage(level_);
+  int left, top;
+  return it_->GetImage(level_, raw_padding_, raw_image_, &left, &top);
+}
+
 int TessBaseAPI::GetThresholdedImageScaleFactor() const {
   if (thresholder_ == nullptr) {
     return 0;
@@ -816,12 +1280,34 @@ PageIterator* TessBaseAPI::AnalyseLayout(bool merge_similar_words) {
  * Recognize the tesseract global image and return the result as Tesseract
  * internal structures.
  */
+// Gives the monitor of a recognition to a Tesseract until it goes out of
+// scope, so that the layout analysis and the recognition of each line stop
+// when it says so, and not only between words.
+class MonitorScope {
+ public:
+  MonitorScope(Tesseract* tesseract, const ETEXT_DESC* monitor)
+      : tesseract_(tesseract) {
+    tesseract_->SetMonitor(monitor);
+  }
+  ~MonitorScope() {
+    tesseract_->SetMonitor(nullptr);
+  }
+
+ private:
+  Tesseract* tesseract_;
+};
+
 int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
+  TraceSpan span("Recognize");
+  ScopedCounters counting(counters_);
+  ScopedMemoryTracker tracking(memory_tracker_);
   if (tesseract_ == nullptr)
     return -1;
+  MonitorScope monitor_scope(tesseract_, monitor);
   if (FindLines() != 0)
     return -1;
   delete page_res_;
+  paragraphs_pending_ = false;
   if (block_list_->empty()) {
     page_res_ = new PAGE_RES(false, block_list_,
                              &tesseract_->prev_word_best_choice_);
@@ -897,7 +1383,9 @@ int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
     GetBoolVariable("paragraph_text_based", &wait_for_text);
     if (!wait_for_text) DetectParagraphs(false);
     if (tesseract_->recog_all_words(page_res_, monitor, nullptr, nullptr, 0)) {
-      if (wait_for_text) DetectParagraphs(true);
+      // Only the iterators report paragraphs, and the reading order depends
+      // on them, so they are found on the first call of GetIterator.
+      if (wait_for_text) paragraphs_pending_ = true;
     } else {
       result = -1;
     }
@@ -905,6 +1393,245 @@ int TessBaseAPI::Recognize(ETEXT_DESC* monitor) {
   return result;
 }
 
+// Appends a word to result, with its box in image coordinates.
+static void AddBatchWord(const char* text, float confidence, int left, int top,
+                         int right, int bottom, BatchResult* result) {
+  BatchWord word;
+  word.text = text;
+  word.confidence = ClipToRange(confidence, 0.0f, 100.0f);
+  word.left = left;
+  word.top = top;
+  word.right = right;
+  word.bottom = bottom;
+  if (!result->text.empty()) result->text += ' ';
+  result->text += text;
+  result->words.push_back(word);
+}
+
+// Sets the mean confidence of the words of result.
+static void SetBatchConfidence(BatchResult* result) {
+  float sum = 0.0f;
+  for (const auto& word : result->words) sum += word.confidence;
+  result->confidence =
+      result->words.empty() ? 0.0f : sum / result->words.size();
+}
+
+// Sets result to the words that RecognizeLinesLSTM found in a line image of
+// the given height, at (x, y) in the image.
+static void SetLineWords(const PointerVector<WERD_RES>& words, int height,
+                         int x, int y, BatchResult* result) {
+  for (int w = 0; w < words.size(); ++w) {
+    const WERD_RES* word = words[w];
+    if (word->best_choice == nullptr || word->best_choice->length() == 0)
+      continue;
+    // The words have y going up from the bottom of their line image.
+    const TBOX box = word->word->bounding_box();
+    AddBatchWord(word->best_choice->unichar_string().c_str(),
+                 100 + 5 * word->best_choice->certainty(), x + box.left(),
+                 y + height - box.top(), x + box.right(),
+                 y + height - box.bottom(), result);
+  }
+  SetBatchConfidence(result);
+}
+
+// Sets result to the words of an iterator, which is deleted.
+static void SetIteratorWords(ResultIterator* it, BatchResult* result) {
+  if (it != nullptr && !it->Empty(RIL_WORD)) {
+    do {
+      std::unique_ptr<char[]> text(it->GetUTF8Text(RIL_WORD));
+      int left, top, right, bottom;
+      if (text == nullptr || text[0] == '\0' ||
+          !it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom))
+        continue;
+      AddBatchWord(text.get(), it->Confidence(RIL_WORD), left, top, right,
+                   bottom, result);
+    } while (it->Next(RIL_WORD));
+  }
+  delete it;
+  SetBatchConfidence(result);
+}
+
+// Returns true for the modes that RecognizeLinesLSTM handles.
+static bool IsLineMode(PageSegMode mode) {
+  return mode == PSM_SINGLE_LINE || mode == PSM_RAW_LINE ||
+         mode == PSM_SINGLE_WORD;
+}
+
+bool TessBaseAPI::RecognizeBatch(const std::vector<Pix*>& images,
+                                 PageSegMode mode,
+                                 std::vector<BatchResult>* results) {
+  if (tesseract_ == nullptr) return false;
+  Clear();
+  results->clear();
+  results->resize(images.size());
+  std::vector<PointerVector<WERD_RES>> words;
+  if (IsLineMode(mode)) tesseract_->SetBlackAndWhitelist();
+  if (IsLineMode(mode) && tesseract_->RecognizeLinesLSTM(images, &words)) {
+    for (size_t i = 0; i < images.size(); ++i) {
+      if (images[i] == nullptr) continue;
+      SetLineWords(words[i], pixGetHeight(images[i]), 0, 0, &(*results)[i]);
+    }
+    return true;
+  }
+  // The layout of each image has to be found with the other engines.
+  PageSegMode saved_mode = GetPageSegMode();
+  SetPageSegMode(mode);
+  for (size_t i = 0; i < images.size(); ++i) {
+    if (images[i] == nullptr) continue;
+    SetImage(images[i]);
+    if (Recognize(nullptr) == 0)
+      SetIteratorWords(GetIterator(), &(*results)[i]);
+  }
+  SetPageSegMode(saved_mode);
+  Clear();
+  return true;
+}
+
+bool TessBaseAPI::RecognizeBatch(Pix* image, Boxa* boxes, PageSegMode mode,
+                                 std::vector<BatchResult>* results) {
+  if (image == nullptr || boxes == nullptr) return false;
+  int count = boxaGetCount(boxes);
+  std::vector<Pix*> images(count, nullptr);
+  std::vector<Box*> clipped(count, nullptr);
+  for (int i = 0; i < count; ++i) {
+    Box* box = boxaGetBox(boxes, i, L_CLONE);
+    images[i] = pixClipRectangle(image, box, &clipped[i]);
+    boxDestroy(&box);
+  }
+  bool ok = RecognizeBatch(images, mode, results);
+  for (int i = 0; i < count; ++i) {
+    if (ok && clipped[i] != nullptr) {
+      l_int32 x, y;
+      boxGetGeometry(clipped[i], &x, &y, nullptr, nullptr);
+      for (auto& word : (*results)[i].words) {
+        word.left += x;
+        word.top += y;
+        word.right += x;
+        word.bottom += y;
+      }
+    }
+    pixDestroy(&images[i]);
+    boxDestroy(&clipped[i]);
+  }
+  return ok;
+}
+
+bool TessBaseAPI::RecognizeRegions(const std::vector<BatchRegion>& regions,
+                                   std::vector<BatchResult>* results) {
+  if (tesseract_ == nullptr || thresholder_ == nullptr ||
+      thresholder_->IsEmpty())
+    return false;
+  // Threshold the whole image once.
+  int left, top, width, height, image_width, image_height;
+  thresholder_->GetImageSizes(&left, &top, &width, &height, &image_width,
+                              &image_height);
+  bool keep_layout = keep_layout_;
+  SetKeepLayout(false);
+  SetRectangle(0, 0, image_width, image_height);
+  // The regions are cut from the thresholded image in image coordinates.
+  bool auto_downscale = tesseract_->tessedit_auto_downscale;
+  tesseract_->tessedit_auto_downscale.set_value(false);
+  bool thresholded = Threshold(tesseract_->mutable_pix_binary());
+  tesseract_->tessedit_auto_downscale.set_value(auto_downscale);
+  if (!thresholded) {
+    keep_layout_ = keep_layout;
+    return false;
+  }
+  Pix* page_binary = pixClone(tesseract_->pix_binary());
+  Pix* page_grey = tesseract_->pix_grey() != nullptr
+                       ? pixClone(tesseract_->pix_grey())
+                       : nullptr;
+  Pix* page_thresholds = tesseract_->pix_thresholds() != nullptr
+                             ? pixClone(tesseract_->pix_thresholds())
+                             : nullptr;
+  if (page_thresholds != nullptr &&
+      (pixGetWidth(page_thresholds) != pixGetWidth(page_binary) ||
+       pixGetHeight(page_thresholds) != pixGetHeight(page_binary)))
+    pixDestroy(&page_thresholds);
+  Pix* page_best = pixClone(tesseract_->BestPix());
+  // Taken from the Tesseract, so that BestPix can't pick it over the grey
+  // image of a region that is as wide as the page.
+  Pix* page_original = tesseract_->pix_original() != nullptr
+                           ? pixClone(tesseract_->pix_original())
+                           : nullptr;
+  int resolution = tesseract_->source_resolution();
+  results->clear();
+  results->resize(regions.size());
+  std::vector<Box*> boxes(regions.size(), nullptr);
+  for (size_t i = 0; i < regions.size(); ++i) {
+    const BatchRegion& region = regions[i];
+    int x0 = std::max(region.left, 0);
+    int y0 = std::max(region.top, 0);
+    int x1 = std::min(region.left + region.width, image_width);
+    int y1 = std::min(region.top + region.height, image_height);
+    if (x1 > x0 && y1 > y0) boxes[i] = boxCreate(x0, y0, x1 - x0, y1 - y0);
+  }
+
+  // The line and word regions go to the LSTM engine in a single batch, cut
+  // from the image that it would use on the whole page.
+  std::vector<Pix*> line_images(regions.size(), nullptr);
+  for (size_t i = 0; i < regions.size(); ++i) {
+    if (boxes[i] != nullptr && IsLineMode(regions[i].mode))
+      line_images[i] = pixClipRectangle(page_best, boxes[i], nullptr);
+  }
+  std::vector<PointerVector<WERD_RES>> words;
+  tesseract_->SetBlackAndWhitelist();
+  bool lines_done = tesseract_->RecognizeLinesLSTM(line_images, &words);
+  for (size_t i = 0; i < regions.size(); ++i) {
+    if (lines_done && line_images[i] != nullptr) {
+      l_int32 x, y;
+      boxGetGeometry(boxes[i], &x, &y, nullptr, nullptr);
+      SetLineWords(words[i], pixGetHeight(line_images[i]), x, y,
+                   &(*results)[i]);
+    }
+    pixDestroy(&line_images[i]);
+  }
+
+  // The others get their layout found on the images cut from the page, in
+  // place of the thresholding of a rectangle.
+  PageSegMode saved_mode = GetPageSegMode();
+  for (size_t i = 0; i < regions.size(); ++i) {
+    if (boxes[i] == nullptr || (lines_done && IsLineMode(regions[i].mode)))
+      continue;
+    ClearResults();
+    SetPageSegMode(regions[i].mode);
+    *tesseract_->mutable_pix_binary() =
+        pixClipRectangle(page_binary, boxes[i], nullptr);
+    tesseract_->set_pix_grey(
+        page_grey != nullptr ? pixClipRectangle(page_grey, boxes[i], nullptr)
+                             : nullptr);
+    tesseract_->set_pix_thresholds(
+        page_thresholds != nullptr
+            ? pixClipRectangle(page_thresholds, boxes[i], nullptr)
+            : nullptr);
+    tesseract_->set_pix_original(
+        page_original != nullptr
+            ? pixClipRectangle(page_original, boxes[i], nullptr)
+            : nullptr);
+    tesseract_->set_source_resolution(resolution);
+    // The iterators give the boxes in page coordinates.
+    boxGetGeometry(boxes[i], &rect_left_, &rect_top_, &rect_width_,
+                   &rect_height_);
+    if (Recognize(nullptr) == 0)
+      SetIteratorWords(GetIterator(), &(*results)[i]);
+  }
+  SetPageSegMode(saved_mode);
+  for (auto& box : boxes) boxDestroy(&box);
+  pixDestroy(&page_binary);
+  pixDestroy(&page_grey);
+  pixDestroy(&page_thresholds);
+  pixDestroy(&page_best);
+  // The next recognition thresholds the page again as usual.
+  ClearResults();
+  SetInputImage(page_original);
+  rect_left_ = 0;
+  rect_top_ = 0;
+  rect_width_ = image_width;
+  rect_height_ = image_height;
+  keep_layout_ = keep_layout;
+  return true;
+}
+
 #ifndef DISABLED_LEGACY_ENGINE
 /** Tests the chopper by exhaustively running chop_one_blob. */
 int TessBaseAPI::RecognizeForChopTest(ETEXT_DESC* monitor) {
@@ -958,6 +1685,94 @@ int TessBaseAPI::GetSourceYResolution() {
   return thresholder_->GetSourceYResolution();
 }
 
+// Reads the pages of a document ahead of their recognition on a thread of its
+// own, so that reading and decoding the next pages overlaps with recognizing
+// the current one. At most depth pages are kept waiting: the reader waits for
+// one to be taken before it reads another. With a depth of 0, Next reads each
+// page itself and no thread is started.
+class PagePrefetcher {
+ public:
+  // Reads the next page into *pix, which is nullptr if the page can't be
+  // decoded, and its name into *name. Returns false at the end of the document.
+  using ReadFunction = std::function<bool(Pix** pix, std::string* name)>;
+
+  PagePrefetcher(ReadFunction read, int depth)
+      : read_(std::move(read)), depth_(std::max(depth, 0)) {
+    if (depth_ > 0) thread_ = std::thread(&PagePrefetcher::Run, this);
+  }
+  ~PagePrefetcher() {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      changed_.notify_all();
+      thread_.join();
+    }
+    for (auto& page : pages_) pixDestroy(&page.pix);
+  }
+
+  // Gets the next page, in document order, as for ReadFunction. The caller
+  // owns the returned pix.
+  bool Next(Pix** pix, std::string* name) {
+    if (depth_ == 0) return read_(pix, name);
+    Page page;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [this] { return !pages_.empty() || done_; });
+      if (pages_.empty()) return false;
+      page = std::move(pages_.front());
+      pages_.pop_front();
+    }
+    changed_.notify_all();
+    *pix = page.pix;
+    *name = std::move(page.name);
+    return true;
+  }
+
+ private:
+  struct Page {
+    Pix* pix = nullptr;
+    std::string name;
+  };
+
+  void Run() {
+    bool more = true;
+    while (more) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock,
+                      [this] { return stop_ || pages_.size() < depth_; });
+        if (stop_) break;
+      }
+      Page page;
+      more = read_(&page.pix, &page.name);
+      if (more) {
+        // A page that can't be decoded is the last one to be read, as the
+        // caller gives up on the document there.
+        more = page.pix != nullptr;
+        std::lock_guard<std::mutex> lock(mutex_);
+        pages_.push_back(std::move(page));
+      }
+      changed_.notify_all();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      done_ = true;
+    }
+    changed_.notify_all();
+  }
+
+  ReadFunction read_;
+  size_t depth_;
+  std::deque<Page> pages_;
+  bool stop_ = false;
+  bool done_ = false;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+};
+
 // If flist exists, get data from there. Otherwise get data from buf.
 // Seems convoluted, but is the easiest way I know of to meet multiple
 // goals. Support streaming from stdin, and also work on platforms
@@ -967,9 +1782,9 @@ bool TessBaseAPI::ProcessPagesFileList(FILE *flist,
                                        const char* retry_config,
                                        int timeout_millisec,
                                        TessResultRenderer* renderer,
-                                       int tessedit_page_number) {
+                                       int first_page, int page_count) {
   if (!flist && !buf) return false;
-  int page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
+  int page = first_page;
   char pagename[MAX_PATH];
 
   GenericVector<STRING> lines;
@@ -990,26 +1805,46 @@ bool TessBaseAPI::ProcessPagesFileList(FILE *flist,
     return false;
   }
 
-  // Loop over all pages - or just the requested one
-  while (true) {
+  // Read the pages ahead, unless there is just the requested one.
+  int line = page;
+  int pages_read = 0;
+  auto read_page = [&](Pix** pix, std::string* name) {
+    if (page_count > 0 && pages_read >= page_count) return false;
+    ++pages_read;
     if (flist) {
-      if (fgets(pagename, sizeof(pagename), flist) == nullptr) break;
+      if (fgets(pagename, sizeof(pagename), flist) == nullptr) return false;
     } else {
-      if (page >= lines.size()) break;
-      snprintf(pagename, sizeof(pagename), "%s", lines[page].c_str());
+      if (line >= lines.size()) return false;
+      snprintf(pagename, sizeof(pagename), "%s", lines[line++].c_str());
     }
     chomp_string(pagename);
-    Pix *pix = pixRead(pagename);
+    *name = pagename;
+    *pix = pixRead(pagename);
+    return true;
+  };
+  PagePrefetcher pages(read_page, page_count == 1
+                                      ? 0 : tesseract_->page_prefetch_depth);
+  int jobs = PageJobs(retry_config);
+  if (jobs > 1) {
+    if (!ProcessPagesInParallel(&pages, page, nullptr, timeout_millisec,
+                                renderer, jobs))
+      return false;
+    return !renderer || renderer->EndDocument();
+  }
+
+  // Loop over all pages - or just the requested one
+  Pix *pix;
+  std::string name;
+  while (pages.Next(&pix, &name)) {
     if (pix == nullptr) {
-      tprintf("Image file %s cannot be read!\n", pagename);
+      tprintf("Image file %s cannot be read!\n", name.c_str());
       return false;
     }
-    tprintf("Page %d : %s\n", page, pagename);
-    bool r = ProcessPage(pix, page, pagename, retry_config,
+    tprintf("Page %d : %s\n", page, name.c_str());
+    bool r = ProcessPage(pix, page, name.c_str(), retry_config,
                          timeout_millisec, renderer);
     pixDestroy(&pix);
     if (!r) return false;
-    if (tessedit_page_number >= 0) break;
     ++page;
   }
 
@@ -1020,23 +1855,97 @@ bool TessBaseAPI::ProcessPagesFileList(FILE *flist,
   return true;
 }
 
+// Finds the offset of the IFD of the given page of the TIFF image in data,
+// or in filename if data is nullptr, which pixReadFromMultipageTiff takes to
+// start reading from that page. Walks the chain of IFDs without decoding any
+// image, so a shard of a long document does not read the pages before it.
+// Returns false if there is no such page.
+static bool FindTiffPageOffset(const l_uint8* data, size_t size,
+                               const char* filename, int page,
+                               size_t* offset) {
+  FILE* fp = nullptr;
+  if (data == nullptr && (fp = fopen(filename, "rb")) == nullptr) return false;
+  auto read = [data, size, fp](uint64_t pos, size_t n, l_uint8* buf) {
+    if (data != nullptr) {
+      if (pos > size || size - pos < n) return false;
+      memcpy(buf, data + pos, n);
+      return true;
+    }
+    return pos <= LONG_MAX &&
+           fseek(fp, static_cast<long>(pos), SEEK_SET) == 0 &&
+           fread(buf, 1, n, fp) == n;
+  };
+  l_uint8 buf[8];
+  bool ok = read(0, 4, buf) && buf[0] == buf[1] &&
+            (buf[0] == 'I' || buf[0] == 'M');
+  const bool big_endian = buf[0] == 'M';
+  auto value = [big_endian](const l_uint8* bytes, int n) {
+    uint64_t result = 0;
+    for (int i = 0; i < n; ++i)
+      result |= static_cast<uint64_t>(bytes[big_endian ? n - 1 - i : i])
+                << (8 * i);
+    return result;
+  };
+  // Classic TIFF has 16 bit entry counts and 32 bit offsets, BigTIFF 64 bit.
+  const uint64_t magic = ok ? value(buf + 2, 2) : 0;
+  const bool big_tiff = magic == 43;
+  const int offset_size = big_tiff ? 8 : 4;
+  const int count_size = big_tiff ? 8 : 2;
+  const int entry_size = big_tiff ? 20 : 12;
+  uint64_t ifd = 0;
+  ok = (magic == 42 || big_tiff) &&
+       read(big_tiff ? 8 : 4, offset_size, buf);
+  if (ok) ifd = value(buf, offset_size);
+  for (int p = 0; ok && ifd != 0 && p < page; ++p) {
+    ok = read(ifd, count_size, buf);
+    if (!ok) break;
+    const uint64_t entries = value(buf, count_size);
+    ok = entries <= UINT16_MAX &&
+         read(ifd + count_size + entries * entry_size, offset_size, buf);
+    if (ok) ifd = value(buf, offset_size);
+  }
+  if (fp != nullptr) fclose(fp);
+  if (!ok || ifd == 0 || ifd > SIZE_MAX) return false;
+  *offset = static_cast<size_t>(ifd);
+  return true;
+}
+
 bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
                                             size_t size,
                                             const char* filename,
                                             const char* retry_config,
                                             int timeout_millisec,
                                             TessResultRenderer* renderer,
-                                            int tessedit_page_number) {
+                                            int first_page, int page_count) {
 #ifndef ANDROID_BUILD
-  Pix *pix = nullptr;
-  int page = (tessedit_page_number >= 0) ? tessedit_page_number : 0;
+  int page = first_page;
   size_t offset = 0;
-  for (; ; ++page) {
-    if (tessedit_page_number >= 0)
-      page = tessedit_page_number;
-    pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
-                 : pixReadFromMultipageTiff(filename, &offset);
-    if (pix == nullptr) break;
+  if (page > 0 && !FindTiffPageOffset(data, size, filename, page, &offset)) {
+    tprintf("Error, %s has no page %d\n", filename, page + 1);
+    return false;
+  }
+  bool last_page = false;
+  int pages_read = 0;
+  auto read_page = [&](Pix** pix, std::string*) {
+    if (last_page) return false;
+    if (page_count > 0 && pages_read >= page_count) return false;
+    *pix = (data) ? pixReadMemFromMultipageTiff(data, size, &offset)
+                  : pixReadFromMultipageTiff(filename, &offset);
+    if (*pix == nullptr) return false;
+    ++pages_read;
+    last_page = !offset;
+    return true;
+  };
+  PagePrefetcher pages(read_page, page_count == 1
+                                      ? 0 : tesseract_->page_prefetch_depth);
+  int jobs = PageJobs(retry_config);
+  if (jobs > 1) {
+    return ProcessPagesInParallel(&pages, page, filename, timeout_millisec,
+                                  renderer, jobs);
+  }
+  Pix *pix;
+  std::string name;
+  for (; pages.Next(&pix, &name); ++page) {
     tprintf("Page %d\n", page + 1);
     char page_str[kMaxIntSize];
     snprintf(page_str, kMaxIntSize - 1, "%d", page);
@@ -1045,8 +1954,6 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
                            timeout_millisec, renderer);
     pixDestroy(&pix);
     if (!r) return false;
-    if (tessedit_page_number >= 0) break;
-    if (!offset) break;
   }
   return true;
 #else
@@ -1054,6 +1961,121 @@ bool TessBaseAPI::ProcessPagesMultipageTiff(const l_uint8 *data,
 #endif
 }
 
+int TessBaseAPI::PageJobs(const char* retry_config) const {
+  if ((tesseract_->tessedit_page_number >= 0 &&
+       tesseract_->tessedit_page_count == 1) ||
+      (retry_config != nullptr && retry_config[0] != '\0') ||
+      tesseract_->tessedit_train_from_boxes ||
+      tesseract_->tessedit_make_boxes_from_boxes ||
+      tesseract_->tessedit_train_line_recognizer ||
+      tesseract_->tessedit_write_images)
+    return 1;
+  return std::max(static_cast<int>(tesseract_->page_parallel_jobs), 1);
+}
+
+// Appends the names and values of all the given params.
+static void GetParamValues(const ParamsVectors* params,
+                           GenericVector<STRING>* names,
+                           GenericVector<STRING>* values) {
+  auto add_param = [params, names, values](const Param* param) {
+    STRING value;
+    if (ParamUtils::GetParamAsString(param->name_str(), params, &value)) {
+      names->push_back(param->name_str());
+      values->push_back(value);
+    }
+  };
+  for (int i = 0; i < params->int_params.size(); ++i)
+    add_param(params->int_params[i]);
+  for (int i = 0; i < params->bool_params.size(); ++i)
+    add_param(params->bool_params[i]);
+  for (int i = 0; i < params->string_params.size(); ++i)
+    add_param(params->string_params[i]);
+  for (int i = 0; i < params->double_params.size(); ++i)
+    add_param(params->double_params[i]);
+}
+
+bool TessBaseAPI::ProcessPagesInParallel(PagePrefetcher* pages, int page,
+                                         const char* filename,
+                                         int timeout_millisec,
+                                         TessResultRenderer* renderer,
+                                         int jobs) {
+  // The other engines load the same models, which they share through the
+  // caches, and get the current values of all the params.
+  GenericVector<STRING> names, values;
+  GetParamValues(tesseract_->params(), &names, &values);
+  std::vector<std::unique_ptr<TessBaseAPI>> engines;
+  for (int j = 1; j < jobs; ++j) {
+    std::unique_ptr<TessBaseAPI> api(new TessBaseAPI);
+    if (output_file_ != nullptr) api->SetOutputName(output_file_->string());
+    if (api->Init(datapath_->string(), 0, language_->string(),
+                  last_oem_requested_, nullptr, 0, &names, &values, false,
+                  reader_) != 0) {
+      tprintf("Warning: recognizing pages on %d engines instead of %d\n", j,
+              jobs);
+      break;
+    }
+    engines.push_back(std::move(api));
+  }
+
+  // Each engine takes the next page, and once it has recognized it, waits
+  // for its turn to render it, so it takes no more pages than it renders.
+  std::mutex read_mutex;
+  std::mutex render_mutex;
+  std::condition_variable rendered;
+  int next_page = page;
+  int next_render = page;
+  bool failed = false;
+  auto process_pages = [&](TessBaseAPI* api) {
+    for (;;) {
+      Pix* pix;
+      std::string name;
+      int index;
+      {
+        std::lock_guard<std::mutex> lock(read_mutex);
+        {
+          std::lock_guard<std::mutex> render_lock(render_mutex);
+          if (failed) return;
+        }
+        if (!pages->Next(&pix, &name)) return;
+        if (pix == nullptr) {
+          tprintf("Image file %s cannot be read!\n", name.c_str());
+          std::lock_guard<std::mutex> render_lock(render_mutex);
+          failed = true;
+          return;
+        }
+        index = next_page++;
+        if (filename != nullptr) {
+          tprintf("Page %d\n", index + 1);
+          char page_str[kMaxIntSize];
+          snprintf(page_str, kMaxIntSize - 1, "%d", index);
+          api->SetVariable("applybox_page", page_str);
+        } else {
+          tprintf("Page %d : %s\n", index, name.c_str());
+        }
+      }
+      bool r = api->ProcessPage(pix, index,
+                                filename != nullptr ? filename : name.c_str(),
+                                nullptr, timeout_millisec, nullptr);
+      {
+        std::unique_lock<std::mutex> lock(render_mutex);
+        rendered.wait(lock, [&] { return next_render == index; });
+        if (!failed && r && renderer != nullptr)
+          r = renderer->AddImage(api);
+        if (!r) failed = true;
+        ++next_render;
+      }
+      rendered.notify_all();
+      pixDestroy(&pix);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (auto& api : engines)
+    threads.push_back(std::thread(process_pages, api.get()));
+  process_pages(this);
+  for (auto& thread : threads) thread.join();
+  return !failed;
+}
+
 // Master ProcessPages calls ProcessPagesInternal and then does any post-
 // processing required due to being in a training mode.
 bool TessBaseAPI::ProcessPages(const char* filename, const char* retry_config,
@@ -1096,10 +2118,17 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
 #endif  // WIN32
   }
 
+  // A range of pages is numbered in the output as in the whole document.
+  const int page_number = tesseract_->tessedit_page_number;
+  const int first_page = std::max(page_number, 0);
+  const int page_count =
+      page_number >= 0 ? std::max<int>(tesseract_->tessedit_page_count, 0) : 0;
+  if (renderer != nullptr) renderer->SetFirstPage(first_page);
+
   if (stream_filelist) {
     return ProcessPagesFileList(stdin, nullptr, retry_config,
-                                timeout_millisec, renderer,
-                                tesseract_->tessedit_page_number);
+                                timeout_millisec, renderer, first_page,
+                                page_count);
   }
 
   // At this point we are officially in autodection territory.
@@ -1140,8 +2169,8 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
       s = u.c_str();
     }
     return ProcessPagesFileList(nullptr, &s, retry_config,
-                                timeout_millisec, renderer,
-                                tesseract_->tessedit_page_number);
+                                timeout_millisec, renderer, first_page,
+                                page_count);
   }
 
   // Maybe we have a TIFF which is potentially multipage
@@ -1171,8 +2200,8 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
   // Produce output
   r = (tiff) ?
       ProcessPagesMultipageTiff(data, buf.size(), filename, retry_config,
-                                timeout_millisec, renderer,
-                                tesseract_->tessedit_page_number) :
+                                timeout_millisec, renderer, first_page,
+                                page_count) :
       ProcessPage(pix, 0, filename, retry_config,
                   timeout_millisec, renderer);
 
@@ -1189,6 +2218,7 @@ bool TessBaseAPI::ProcessPagesInternal(const char* filename,
 bool TessBaseAPI::ProcessPage(Pix* pix, int page_index, const char* filename,
                               const char* retry_config, int timeout_millisec,
                               TessResultRenderer* renderer) {
+  TraceSpan span("ProcessPage");
   SetInputName(filename);
   SetImage(pix);
   bool failed = false;
@@ -1273,6 +2303,7 @@ LTRResultIterator* TessBaseAPI::GetLTRIterator() {
 ResultIterator* TessBaseAPI::GetIterator() {
   if (tesseract_ == nullptr || page_res_ == nullptr)
     return nullptr;
+  DetectPendingParagraphs();
   return ResultIterator::StartOfParagraph(LTRResultIterator(
       page_res_, tesseract_,
       thresholder_->GetScaleFactor(), thresholder_->GetScaledYResolution(),
@@ -1290,12 +2321,35 @@ ResultIterator* TessBaseAPI::GetIterator() {
 MutableIterator* TessBaseAPI::GetMutableIterator() {
   if (tesseract_ == nullptr || page_res_ == nullptr)
     return nullptr;
+  DetectPendingParagraphs();
   return new MutableIterator(page_res_, tesseract_,
                              thresholder_->GetScaleFactor(),
                              thresholder_->GetScaledYResolution(),
                              rect_left_, rect_top_, rect_width_, rect_height_);
 }
 
+bool TessBaseAPI::PrepareResultsForReading() {
+  if (tesseract_ == nullptr || page_res_ == nullptr || !recognition_done_)
+    return false;
+  DetectPendingParagraphs();
+  // GetHOCRText and GetAltoText name the image even without an input name.
+  if (input_file_ == nullptr) SetInputName(nullptr);
+  // The choices build their UTF-8 strings on first use.
+  PAGE_RES_IT page_res_it(page_res_);
+  for (page_res_it.restart_page(); page_res_it.word() != nullptr;
+       page_res_it.forward()) {
+    WERD_RES* word = page_res_it.word();
+    if (word->best_choice != nullptr) word->best_choice->unichar_string();
+    if (word->raw_choice != nullptr) word->raw_choice->unichar_string();
+    WERD_CHOICE_IT choice_it(&word->best_choices);
+    for (choice_it.mark_cycle_pt(); !choice_it.cycled_list();
+         choice_it.forward()) {
+      choice_it.data()->unichar_string();
+    }
+  }
+  return true;
+}
+
 /** Make a text string from the internal data structures. */
 char* TessBaseAPI::GetUTF8Text() {
   if (tesseract_ == nullptr ||
@@ -1315,13 +2369,19 @@ char* TessBaseAPI::GetUTF8Text() {
 }
 
 static void AddBoxToTSV(const PageIterator* it, PageIteratorLevel level,
-                        STRING* text) {
+                        std::ostream& text) {
   int left, top, right, bottom;
   it->BoundingBox(level, &left, &top, &right, &bottom);
-  text->add_str_int("\t", left);
-  text->add_str_int("\t", top);
-  text->add_str_int("\t", right - left);
-  text->add_str_int("\t", bottom - top);
+  text << "\t" << left << "\t" << top << "\t" << right - left << "\t"
+       << bottom - top;
+}
+
+// Writes the level, page, block, paragraph, line and word numbers that
+// start each TSV row.
+static void AddRowToTSV(int level, int page_num, int block_num, int par_num,
+                        int line_num, int word_num, std::ostream& text) {
+  text << level << "\t" << page_num << "\t" << block_num << "\t" << par_num
+       << "\t" << line_num << "\t" << word_num;
 }
 
 /**
@@ -1330,13 +2390,26 @@ static void AddBoxToTSV(const PageIterator* it, PageIteratorLevel level,
  * Returned string must be freed with the delete [] operator.
  */
 char* TessBaseAPI::GetTSVText(int page_number) {
+  std::stringstream tsv_str;
+  if (!GetTSVText(page_number, tsv_str)) return nullptr;
+
+  const std::string& text = tsv_str.str();
+  char* ret = new char[text.length() + 1];
+  strcpy(ret, text.c_str());
+  return ret;
+}
+
+/**
+ * Write the TSV rows of the page to tsv_str while walking the results.
+ */
+bool TessBaseAPI::GetTSVText(int page_number, std::ostream& tsv_str) {
   if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(nullptr) < 0))
-    return nullptr;
+    return false;
 
-  int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1;
   int page_id = page_number + 1;  // we use 1-based page numbers.
 
-  STRING tsv_str("");
+  // Use "C" locale, so that the numbers are not grouped.
+  const std::locale locale = tsv_str.imbue(std::locale::classic());
 
   int page_num = page_id;
   int block_num = 0;
@@ -1344,18 +2417,12 @@ char* TessBaseAPI::GetTSVText(int page_number) {
   int line_num = 0;
   int word_num = 0;
 
-  tsv_str.add_str_int("1\t", page_num);  // level 1 - page
-  tsv_str.add_str_int("\t", block_num);
-  tsv_str.add_str_int("\t", par_num);
-  tsv_str.add_str_int("\t", line_num);
-  tsv_str.add_str_int("\t", word_num);
-  tsv_str.add_str_int("\t", rect_left_);
-  tsv_str.add_str_int("\t", rect_top_);
-  tsv_str.add_str_int("\t", rect_width_);
-  tsv_str.add_str_int("\t", rect_height_);
-  tsv_str += "\t-1\t\n";
-
-  ResultIterator* res_it = GetIterator();
+  AddRowToTSV(1, page_num, block_num, par_num, line_num, word_num,
+              tsv_str);  // level 1 - page
+  tsv_str << "\t" << rect_left_ << "\t" << rect_top_ << "\t" << rect_width_
+          << "\t" << rect_height_ << "\t-1\t\n";
+
+  std::unique_ptr<ResultIterator> res_it(GetIterator());
   while (!res_it->Empty(RIL_BLOCK)) {
     if (res_it->Empty(RIL_WORD)) {
       res_it->Next(RIL_WORD);
@@ -1368,72 +2435,92 @@ char* TessBaseAPI::GetTSVText(int page_number) {
       par_num = 0;
       line_num = 0;
       word_num = 0;
-      tsv_str.add_str_int("2\t", page_num);  // level 2 - block
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_BLOCK, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for block
+      AddRowToTSV(2, page_num, block_num, par_num, line_num, word_num,
+                  tsv_str);  // level 2 - block
+      AddBoxToTSV(res_it.get(), RIL_BLOCK, tsv_str);
+      tsv_str << "\t-1\t\n";  // end of row for block
     }
     if (res_it->IsAtBeginningOf(RIL_PARA)) {
       par_num++;
       line_num = 0;
       word_num = 0;
-      tsv_str.add_str_int("3\t", page_num);  // level 3 - paragraph
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_PARA, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for para
+      AddRowToTSV(3, page_num, block_num, par_num, line_num, word_num,
+                  tsv_str);  // level 3 - paragraph
+      AddBoxToTSV(res_it.get(), RIL_PARA, tsv_str);
+      tsv_str << "\t-1\t\n";  // end of row for para
     }
     if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
       line_num++;
       word_num = 0;
-      tsv_str.add_str_int("4\t", page_num);  // level 4 - line
-      tsv_str.add_str_int("\t", block_num);
-      tsv_str.add_str_int("\t", par_num);
-      tsv_str.add_str_int("\t", line_num);
-      tsv_str.add_str_int("\t", word_num);
-      AddBoxToTSV(res_it, RIL_TEXTLINE, &tsv_str);
-      tsv_str += "\t-1\t\n";  // end of row for line
+      AddRowToTSV(4, page_num, block_num, par_num, line_num, word_num,
+                  tsv_str);  // level 4 - line
+      AddBoxToTSV(res_it.get(), RIL_TEXTLINE, tsv_str);
+      tsv_str << "\t-1\t\n";  // end of row for line
     }
 
     // Now, process the word...
-    int left, top, right, bottom;
-    res_it->BoundingBox(RIL_WORD, &left, &top, &right, &bottom);
     word_num++;
-    tsv_str.add_str_int("5\t", page_num);  // level 5 - word
-    tsv_str.add_str_int("\t", block_num);
-    tsv_str.add_str_int("\t", par_num);
-    tsv_str.add_str_int("\t", line_num);
-    tsv_str.add_str_int("\t", word_num);
-    tsv_str.add_str_int("\t", left);
-    tsv_str.add_str_int("\t", top);
-    tsv_str.add_str_int("\t", right - left);
-    tsv_str.add_str_int("\t", bottom - top);
-    tsv_str.add_str_int("\t", res_it->Confidence(RIL_WORD));
-    tsv_str += "\t";
-
-    // Increment counts if at end of block/paragraph/textline.
-    if (res_it->IsAtFinalElement(RIL_TEXTLINE, RIL_WORD)) lcnt++;
-    if (res_it->IsAtFinalElement(RIL_PARA, RIL_WORD)) pcnt++;
-    if (res_it->IsAtFinalElement(RIL_BLOCK, RIL_WORD)) bcnt++;
+    AddRowToTSV(5, page_num, block_num, par_num, line_num, word_num,
+                tsv_str);  // level 5 - word
+    AddBoxToTSV(res_it.get(), RIL_WORD, tsv_str);
+    tsv_str << "\t" << static_cast<int>(res_it->Confidence(RIL_WORD)) << "\t";
 
     do {
-      tsv_str +=
-          std::unique_ptr<const char[]>(res_it->GetUTF8Text(RIL_SYMBOL)).get();
+      const std::unique_ptr<const char[]> grapheme(
+          res_it->GetUTF8Text(RIL_SYMBOL));
+      if (grapheme != nullptr) tsv_str << grapheme.get();
       res_it->Next(RIL_SYMBOL);
     } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
-    tsv_str += "\n";  // end of row
-    wcnt++;
+    tsv_str << "\n";  // end of row
   }
 
-  char* ret = new char[tsv_str.length() + 1];
-  strcpy(ret, tsv_str.string());
-  delete res_it;
-  return ret;
+  tsv_str.imbue(locale);
+  return true;
+}
+
+// Adds the element of the page at the iterator to the arrays of its level.
+static void AddResultArraysElement(const ResultIterator* it,
+                                   PageIteratorLevel level, int parent,
+                                   ResultArrays* arrays) {
+  int left, top, right, bottom;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  arrays->boxes.push_back(left);
+  arrays->boxes.push_back(top);
+  arrays->boxes.push_back(right);
+  arrays->boxes.push_back(bottom);
+  arrays->confidences.push_back(it->Confidence(level));
+  const std::unique_ptr<const char[]> text(it->GetUTF8Text(level));
+  if (text != nullptr) arrays->text += text.get();
+  arrays->text_offsets.push_back(arrays->text.size());
+  arrays->parents.push_back(parent);
+}
+
+bool TessBaseAPI::GetResultArrays(PageIteratorLevel level,
+                                  ResultArrays* arrays) {
+  if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(nullptr) < 0))
+    return false;
+
+  *arrays = ResultArrays();
+  arrays->text_offsets.push_back(0);
+  // Symbols are visited one by one, and the other levels at their words.
+  PageIteratorLevel step = level == RIL_SYMBOL ? RIL_SYMBOL : RIL_WORD;
+  int parent = -1;
+  std::unique_ptr<ResultIterator> res_it(GetIterator());
+  while (!res_it->Empty(RIL_BLOCK)) {
+    if (res_it->Empty(RIL_WORD)) {
+      res_it->Next(RIL_WORD);
+      continue;
+    }
+    if (level != RIL_BLOCK &&
+        res_it->IsAtBeginningOf(static_cast<PageIteratorLevel>(level - 1))) {
+      ++parent;
+    }
+    if (level == step || res_it->IsAtBeginningOf(level)) {
+      AddResultArraysElement(res_it.get(), level, parent, arrays);
+    }
+    res_it->Next(step);
+  }
+  return true;
 }
 
 /** The 5 numbers output for each box (the usual 4 and a page number.) */
@@ -1811,6 +2898,7 @@ bool TessBaseAPI::AdaptToWordStr(PageSegMode mode, const char* wordstr) {
 void TessBaseAPI::Clear() {
   if (thresholder_ != nullptr)
     thresholder_->Clear();
+  ClearKeptLayout();
   ClearResults();
   if (tesseract_ != nullptr) SetInputImage(nullptr);
 }
@@ -1821,6 +2909,28 @@ void TessBaseAPI::Clear() {
  * Once End() has been used, none of the other API functions may be used
  * other than Init and anything declared above it in the class definition.
  */
+// Returns the memory kept by all the threads for reuse by the layout and
+// recognition objects of the next page to the system.
+static void ReleaseFreeLists() {
+  // Memory kept for reuse by the layout objects of the next page.
+  C_OUTLINE::ReleaseFreeList();
+  C_BLOB::ReleaseFreeList();
+  BLOBNBOX::ReleaseFreeList();
+  ColPartition::ReleaseFreeList();
+  TabVector::ReleaseFreeList();
+  // And by the recognition results.
+  WERD::ReleaseFreeList();
+  WERD_RES::ReleaseFreeList();
+  WERD_CHOICE::ReleaseFreeList();
+  BLOB_CHOICE::ReleaseFreeList();
+  BLOB_CHOICE_LIST::ReleaseFreeList();
+  BoxWord::ReleaseFreeList();
+  TWERD::ReleaseFreeList();
+  TBLOB::ReleaseFreeList();
+  TESSLINE::ReleaseFreeList();
+  EDGEPT::ReleaseFreeList();
+}
+
 void TessBaseAPI::End() {
   Clear();
   delete thresholder_;
@@ -1849,6 +2959,8 @@ void TessBaseAPI::End() {
   datapath_ = nullptr;
   delete language_;
   language_ = nullptr;
+  // The objects of the last page are gone, so is the need for their memory.
+  ReleaseFreeLists();
 }
 
 // Clear any library-level memory caches.
@@ -1858,6 +2970,10 @@ void TessBaseAPI::End() {
 // of these caches.
 void TessBaseAPI::ClearPersistentCache() {
   Dict::GlobalDawgCache()->DeleteUnusedDawgs();
+#ifndef ANDROID_BUILD
+  LSTMRecognizer::GlobalNetworkCache()->DeleteUnusedObjects();
+#endif  // ndef ANDROID_BUILD
+  ReleaseFreeLists();
 }
 
 /**
@@ -1867,6 +2983,28 @@ void TessBaseAPI::ClearPersistentCache() {
 int TessBaseAPI::IsValidWord(const char *word) {
   return tesseract_->getDict().valid_word(word);
 }
+// Attaches the given words as an extra user dictionary of all the loaded
+// languages, until DetachExtraWords or End.
+bool TessBaseAPI::AttachExtraWords(const char *words) {
+  if (tesseract_ == nullptr || words == nullptr) return false;
+  GenericVector<STRING> lines;
+  STRING(words).split('\n', &lines);
+  GenericVector<STRING> word_list;
+  for (int i = 0; i < lines.size(); ++i) {
+    STRING& line = lines[i];
+    if (line.length() > 0 && line[line.length() - 1] == '\r') {
+      line.truncate_at(line.length() - 1);
+    }
+    if (line.length() > 0) word_list.push_back(line);
+  }
+  return tesseract_->AttachExtraWords(word_list);
+}
+
+// Detaches the words of AttachExtraWords.
+void TessBaseAPI::DetachExtraWords() {
+  if (tesseract_ != nullptr) tesseract_->DetachExtraWords();
+}
+
 // Returns true if utf8_character is defined in the UniCharset.
 bool TessBaseAPI::IsValidCharacter(const char *utf8_character) {
     return tesseract_->unicharset.contains_unichar(utf8_character);
@@ -1950,10 +3088,64 @@ bool TessBaseAPI::InternalSetImage() {
   }
   if (thresholder_ == nullptr)
     thresholder_ = new ImageThresholder;
+  thresholder_->set_memory_limit(
+      static_cast<int64_t>(tesseract_->image_memory_limit_mb) << 20);
+  ClearKeptLayout();
   ClearResults();
   return true;
 }
 
+/**
+ * Returns the factor by which the grey image can be reduced, keeping the
+ * median height of its components at least min_text_height pixels, so the
+ * lines of text are still taller than the input of the LSTM networks. The
+ * components are found in a quick Otsu thresholding of the image reduced
+ * by kTextHeightReduction, which takes a small part of the time that the
+ * full size thresholding and layout analysis do.
+ */
+static int DownscaleFactor(Pix* grey, int min_text_height) {
+  int width = pixGetWidth(grey);
+  int height = pixGetHeight(grey);
+  if (min_text_height <= 0 ||
+      std::min(width, height) < kTextHeightReduction * kMinRectSize)
+    return 1;
+  const float scale = 1.0f / kTextHeightReduction;
+  Pix* small = pixScaleAreaMap(grey, scale, scale);
+  int* thresholds;
+  int* hi_values;
+  OtsuThreshold(small, 0, 0, pixGetWidth(small), pixGetHeight(small),
+                &thresholds, &hi_values);
+  Pix* binary = nullptr;
+  if (hi_values[0] >= 0) {
+    binary = pixThresholdToBinary(small, thresholds[0] + 1);
+    if (hi_values[0] == 0) pixInvert(binary, binary);
+  }
+  delete [] thresholds;
+  delete [] hi_values;
+  int max_height = pixGetHeight(small) / 4;
+  pixDestroy(&small);
+  if (binary == nullptr) return 1;
+  Boxa* boxa = pixConnCompBB(binary, 8);
+  pixDestroy(&binary);
+  if (boxa == nullptr) return 1;
+  // Components of a pixel or two of the small image are noise, and those
+  // that are a large part of it are images or borders.
+  std::vector<int> heights;
+  int num_boxes = boxaGetCount(boxa);
+  for (int i = 0; i < num_boxes; ++i) {
+    l_int32 box_height;
+    boxaGetBoxGeometry(boxa, i, nullptr, nullptr, nullptr, &box_height);
+    if (box_height > 2 && box_height <= max_height)
+      heights.push_back(box_height);
+  }
+  boxaDestroy(&boxa);
+  if (heights.size() < kMinTextHeightSamples) return 1;
+  auto median = heights.begin() + heights.size() / 2;
+  std::nth_element(heights.begin(), median, heights.end());
+  int text_height = *median * kTextHeightReduction;
+  return ClipToRange(text_height / min_text_height, 1, kMaxDownscaleFactor);
+}
+
 /**
  * Run the thresholder to make the thresholded image, returned in pix,
  * which must not be nullptr. *pix must be initialized to nullptr, or point
@@ -1961,6 +3153,7 @@ bool TessBaseAPI::InternalSetImage() {
  * The usual argument to Threshold is Tesseract::mutable_pix_binary().
  */
 bool TessBaseAPI::Threshold(Pix** pix) {
+  TraceSpan span("Threshold");
   ASSERT_HOST(pix != nullptr);
   if (*pix != nullptr)
     pixDestroy(pix);
@@ -1986,28 +3179,96 @@ bool TessBaseAPI::Threshold(Pix** pix) {
   auto pageseg_mode =
       static_cast<PageSegMode>(
           static_cast<int>(tesseract_->tessedit_pageseg_mode));
-  if (!thresholder_->ThresholdToPix(pageseg_mode, pix)) return false;
+  auto method = static_cast<ThresholdMethod>(
+      static_cast<int>(tesseract_->thresholding_method));
+  if (method < ThresholdMethod::Otsu || method >= ThresholdMethod::Max) {
+    tprintf("Warning: Invalid thresholding method %d. Using Otsu instead.\n",
+            static_cast<int>(tesseract_->thresholding_method));
+    method = ThresholdMethod::Otsu;
+  }
+  // An image with large text, such as a 600 dpi scan or a photo, is
+  // thresholded and recognized from a reduced copy, and the internal
+  // coordinates are those of the copy.
+  int reduction = 1;
+  if (tesseract_->tessedit_auto_downscale && !thresholder_->IsBinary()) {
+    Pix* grey = thresholder_->GetPixRectGrey();
+    reduction =
+        DownscaleFactor(grey, tesseract_->tessedit_downscale_text_height);
+    pixDestroy(&grey);
+  }
+  // A page too large for the memory budget is reduced until it fits, which
+  // costs accuracy on small text, but not the whole page.
+  const int64_t budget =
+      static_cast<int64_t>(tesseract_->tessedit_memory_budget_mb) << 20;
+  int budget_reduction = 1;
+  if (budget > 0) {
+    int left, top, width, height, image_width, image_height;
+    thresholder_->GetImageSizes(&left, &top, &width, &height, &image_width,
+                                &image_height);
+    const int64_t page_bytes =
+        static_cast<int64_t>(width) * height * kPageBytesPerPixel;
+    int budget_factor = reduction;
+    while (page_bytes / (budget_factor * budget_factor) > budget / 2 &&
+           budget_factor < kMaxBudgetReduction)
+      ++budget_factor;
+    if (budget_factor > reduction) {
+      tprintf("Warning: reducing the page by %d to fit the memory budget of "
+              "%d MB\n", budget_factor,
+              static_cast<int>(tesseract_->tessedit_memory_budget_mb));
+      budget_reduction = budget_factor;
+      reduction = budget_factor;
+    }
+  }
+  tesseract_->set_image_reduction(reduction);
+  tesseract_->set_budget_reduction(budget_reduction);
+  ImageThresholder reduced;
+  ImageThresholder* source = thresholder_;
+  if (reduction > 1) {
+    const float scale = 1.0f / reduction;
+    Pix* rect = thresholder_->GetPixRect();
+    // A binary image, which only the budget reduces, is reduced to grey.
+    Pix* scaled = pixGetDepth(rect) == 1 ? pixScaleToGray(rect, scale)
+                                         : pixScaleAreaMap(rect, scale, scale);
+    pixDestroy(&rect);
+    reduced.set_memory_limit(
+        static_cast<int64_t>(tesseract_->image_memory_limit_mb) << 20);
+    reduced.SetImage(scaled);
+    pixDestroy(&scaled);
+    reduced.SetSourceYResolution(
+        std::max(thresholder_->GetScaledYResolution() / reduction, 1));
+    reduced.SetEstimatedResolution(std::max(
+        thresholder_->GetScaledEstimatedResolution() / reduction, 1));
+    source = &reduced;
+  }
+  int window_size = IntCastRounded(tesseract_->thresholding_window_size *
+                                   source->GetScaledYResolution());
+  source->SetThresholdMethod(method, window_size,
+                             tesseract_->thresholding_kfactor);
+  source->set_num_threads(tesseract_->tessedit_num_threads);
+  if (!source->ThresholdToPix(pageseg_mode, pix)) return false;
   thresholder_->GetImageSizes(&rect_left_, &rect_top_,
                               &rect_width_, &rect_height_,
                               &image_width_, &image_height_);
-  if (!thresholder_->IsBinary()) {
-    tesseract_->set_pix_thresholds(thresholder_->GetPixRectThresholds());
-    tesseract_->set_pix_grey(thresholder_->GetPixRectGrey());
+  if (!source->IsBinary()) {
+    tesseract_->set_pix_thresholds(source->GetPixRectThresholds());
+    tesseract_->set_pix_grey(source->GetPixRectGrey());
   } else {
     tesseract_->set_pix_thresholds(nullptr);
     tesseract_->set_pix_grey(nullptr);
   }
+  if (tesseract_->pix_original() == nullptr)
+    SetInputImage(thresholder_->GetPixImage());
   // Set the internal resolution that is used for layout parameters from the
   // estimated resolution, rather than the image resolution, which may be
   // fabricated, but we will use the image resolution, if there is one, to
   // report output point sizes.
-  int estimated_res = ClipToRange(thresholder_->GetScaledEstimatedResolution(),
+  int estimated_res = ClipToRange(source->GetScaledEstimatedResolution(),
                                   kMinCredibleResolution,
                                   kMaxCredibleResolution);
-  if (estimated_res != thresholder_->GetScaledEstimatedResolution()) {
+  if (estimated_res != source->GetScaledEstimatedResolution()) {
     tprintf("Estimated internal resolution %d out of range! "
             "Corrected to %d.\n",
-            thresholder_->GetScaledEstimatedResolution(), estimated_res);
+            source->GetScaledEstimatedResolution(), estimated_res);
   }
   tesseract_->set_source_resolution(estimated_res);
   return true;
@@ -2015,6 +3276,9 @@ bool TessBaseAPI::Threshold(Pix** pix) {
 
 /** Find lines from the image making the BLOCK_LIST. */
 int TessBaseAPI::FindLines() {
+  TraceSpan span("FindLines");
+  ScopedCounters counting(counters_);
+  ScopedMemoryTracker tracking(memory_tracker_);
   if (thresholder_ == nullptr || thresholder_->IsEmpty()) {
     tprintf("Please call SetImage before attempting recognition.\n");
     return -1;
@@ -2030,6 +3294,8 @@ int TessBaseAPI::FindLines() {
     tesseract_->InitAdaptiveClassifier(nullptr);
   #endif
   }
+  if (RestoreKeptLayout())
+    return 0;
   if (tesseract_->pix_binary() == nullptr &&
       !Threshold(tesseract_->mutable_pix_binary())) {
     return -1;
@@ -2086,9 +3352,87 @@ int TessBaseAPI::FindLines() {
   // If Devanagari is being recognized, we use different images for page seg
   // and for OCR.
   tesseract_->PrepareForTessOCR(block_list_, osd_tess, &osr);
+  KeepLayout();
   return 0;
 }
 
+void TessBaseAPI::SetKeepLayout(bool keep_layout) {
+  keep_layout_ = keep_layout;
+  if (!keep_layout)
+    ClearKeptLayout();
+}
+
+bool TessBaseAPI::HasKeptLayout() const {
+  return kept_block_list_ != nullptr;
+}
+
+const char* TessBaseAPI::GetBlankPageReason() const {
+  return tesseract_ != nullptr ? tesseract_->blank_page_reason() : nullptr;
+}
+
+bool TessBaseAPI::GetMemoryBudgetOutcome(int* reduction,
+                                         int* skipped_lines) const {
+  *reduction = tesseract_ != nullptr ? tesseract_->budget_reduction() : 1;
+  *skipped_lines = tesseract_ != nullptr ? tesseract_->NumWideLines() : 0;
+  return *reduction > 1 || *skipped_lines > 0;
+}
+
+/**
+ * Copy the layout and the images that recognition works on, which are the
+ * original binary image with any lines and images removed, and not the split
+ * Devanagari image used for the layout.
+ */
+void TessBaseAPI::KeepLayout() {
+  if (!keep_layout_)
+    return;
+  ClearKeptLayout();
+  kept_pageseg_mode_ = static_cast<PageSegMode>(
+      static_cast<int>(tesseract_->tessedit_pageseg_mode));
+  kept_block_list_ = new BLOCK_LIST;
+  kept_block_list_->deep_copy(block_list_, &BLOCK::deep_copy);
+  // Recognition may write to the binary image, so it needs a real copy.
+  kept_pix_binary_ = pixCopy(nullptr, tesseract_->pix_binary());
+  if (tesseract_->pix_grey() != nullptr)
+    kept_pix_grey_ = pixClone(tesseract_->pix_grey());
+  if (tesseract_->pix_thresholds() != nullptr)
+    kept_pix_thresholds_ = pixClone(tesseract_->pix_thresholds());
+  kept_source_resolution_ = tesseract_->source_resolution();
+  kept_image_reduction_ = tesseract_->image_reduction();
+}
+
+/**
+ * Put back what FindLines would have made from the kept layout. A Tesseract
+ * re-initialized for another language has lost its images, and its
+ * Devanagari split strategies may differ, so it is prepared as for a new
+ * segmentation.
+ */
+bool TessBaseAPI::RestoreKeptLayout() {
+  if (kept_block_list_ == nullptr ||
+      kept_pageseg_mode_ != static_cast<int>(tesseract_->tessedit_pageseg_mode))
+    return false;
+  *tesseract_->mutable_pix_binary() = pixCopy(nullptr, kept_pix_binary_);
+  tesseract_->set_pix_grey(kept_pix_grey_ != nullptr ?
+                           pixClone(kept_pix_grey_) : nullptr);
+  tesseract_->set_pix_thresholds(kept_pix_thresholds_ != nullptr ?
+                                 pixClone(kept_pix_thresholds_) : nullptr);
+  tesseract_->set_source_resolution(kept_source_resolution_);
+  tesseract_->set_image_reduction(kept_image_reduction_);
+  if (tesseract_->pix_original() == nullptr)
+    SetInputImage(thresholder_->GetPixRect());
+  tesseract_->PrepareForPageseg();
+  block_list_->deep_copy(kept_block_list_, &BLOCK::deep_copy);
+  tesseract_->PrepareForTessOCR(block_list_, nullptr, nullptr);
+  return true;
+}
+
+void TessBaseAPI::ClearKeptLayout() {
+  delete kept_block_list_;
+  kept_block_list_ = nullptr;
+  pixDestroy(&kept_pix_binary_);
+  pixDestroy(&kept_pix_grey_);
+  pixDestroy(&kept_pix_thresholds_);
+}
+
 /** Delete the pageres and clear the block list ready for a new page. */
 void TessBaseAPI::ClearResults() {
   if (tesseract_ != nullptr) {
@@ -2097,6 +3441,8 @@ void TessBaseAPI::ClearResults() {
   delete page_res_;
   page_res_ = nullptr;
   recognition_done_ = false;
+  paragraphs_pending_ = false;
+  memory_tracker_->ResetPeak();
   if (block_list_ == nullptr)
     block_list_ = new BLOCK_LIST;
   else
@@ -2239,6 +3585,14 @@ void TessBaseAPI::DetectParagraphs(bool after_text_recognition) {
   delete result_it;
 }
 
+void TessBaseAPI::DetectPendingParagraphs() {
+  if (!paragraphs_pending_)
+    return;
+  // DetectParagraphs itself uses a MutableIterator.
+  paragraphs_pending_ = false;
+  DetectParagraphs(true);
+}
+
 /** This method returns the string form of the specified unichar. */
 const char* TessBaseAPI::GetUnichar(int unichar_id) {
   return tesseract_->unicharset.id_to_unichar(unichar_id);
@@ -19,7 +19,12 @@
 #ifndef TESSERACT_API_BASEAPI_H_
 #define TESSERACT_API_BASEAPI_H_
 
+#include <cstdint>  // for int64_t
 #include <cstdio>
+#include <iosfwd>  // for std::ostream
+#include <memory>  // for std::unique_ptr
+#include <string>
+#include <vector>
 // To avoid collision with other typenames include the ABSOLUTE MINIMUM
 // complexity of includes here. Use forward declarations wherever possible
 // and hide includes of complex types in baseapi.cpp.
@@ -61,10 +66,15 @@ struct TBLOB;
 
 namespace tesseract {
 
+class Counters;
+class MemoryTracker;
+struct MemoryUsage;
 class Dawg;
 class Dict;
 class EquationDetect;
+class InitProfile;
 class PageIterator;
+class PagePrefetcher;
 class LTRResultIterator;
 class ResultIterator;
 class MutableIterator;
@@ -80,6 +90,103 @@ using FillLatticeFunc = void (Wordrec::*)(const MATRIX &, const WERD_CHOICE_LIST
 typedef TessCallback4<const UNICHARSET &, int, PageIterator *, Pix *>
     TruthCallback;
 
+/** A word recognized by TessBaseAPI::RecognizeBatch. */
+struct BatchWord {
+  std::string text;  // UTF-8.
+  float confidence;  // 0..100, as ResultIterator::Confidence.
+  // Bounding box in the coordinates of the image, with y going down.
+  int left, top, right, bottom;
+};
+
+/** The result of one image of TessBaseAPI::RecognizeBatch. */
+struct BatchResult {
+  std::string text;  // The words joined by spaces.
+  float confidence;  // Mean of the word confidences, 0 without words.
+  std::vector<BatchWord> words;
+};
+
+/** A region of the image for TessBaseAPI::RecognizeRegions. */
+struct BatchRegion {
+  int left, top, width, height;  // In the coordinates of the image.
+  PageSegMode mode;              // How to recognize the region.
+};
+
+/**
+ * The elements of one level of the page from TessBaseAPI::GetResultArrays,
+ * in reading order, as arrays with an entry for each element.
+ */
+struct ResultArrays {
+  int size() const {
+    return confidences.size();
+  }
+  // left, top, right, bottom of each element in the coordinates of the
+  // image, with y going down.
+  std::vector<int> boxes;
+  std::vector<float> confidences;  // 0..100, as ResultIterator::Confidence.
+  // The UTF-8 text of element i is text[text_offsets[i], text_offsets[i+1]).
+  std::string text;
+  std::vector<int> text_offsets;  // size() + 1 offsets into text.
+  // Index of the element of the level above that contains each element, as
+  // counted by GetResultArrays for that level, or -1 for blocks. The
+  // children of an element are all next to each other.
+  std::vector<int> parents;
+};
+
+/**
+ * Values of variables, compiled by TessBaseAPI::CompileVariables or saved by
+ * TessBaseAPI::SaveVariables, that TessBaseAPI::ApplyVariables sets without
+ * parsing them again. A profile may be applied to any engine.
+ */
+class TESS_API VariableProfile {
+ public:
+  int size() const {
+    return values_.size();
+  }
+  void clear() {
+    values_.clear();
+  }
+
+ private:
+  friend class TessBaseAPI;
+  enum Type { kInt, kBool, kDouble, kString };
+  struct Value {
+    const char* name;  // That of the param, which outlives the profile.
+    Type type;
+    int int_value;     // Also used for kBool.
+    double double_value;
+    std::string string_value;
+  };
+  std::vector<Value> values_;
+};
+
+/**
+ * A component of the page layout returned by TessBaseAPI::GetComponentViews.
+ * It refers to the position of the component in the page results instead of
+ * holding an image, so the image is only cropped if GetImage is called.
+ * Like an iterator, it is only valid while the TessBaseAPI that made it still
+ * holds the same page results.
+ */
+class TESS_API ComponentView {
+ public:
+  ComponentView(const PageIterator& it, PageIteratorLevel level,
+                Pix* raw_image, int raw_padding);
+
+  /**
+   * Returns the image of the component, the same as GetComponentImages puts
+   * in its Pixa, or nullptr on error. Use pixDestroy to delete it after use.
+   */
+  Pix* GetImage() const;
+
+ private:
+  // Positioned at the component.
+  std::unique_ptr<PageIterator> it_;
+  PageIteratorLevel level_;
+  // The original image to crop, or nullptr to crop the thresholded image.
+  // Borrowed pointer.
+  Pix* raw_image_;
+  int raw_padding_;
+};
+
 /**
  * Base class for all tesseract APIs.
  * Specific classes can add ability to work on different inputs or produce
@@ -98,6 +205,14 @@ class TESS_API TessBaseAPI {
    */
   static const char* Version();
 
+  /**
+   * Returns the name of the selected SIMD code for dot products and int
+   * matrices, as used by the dotproduct variable. After loading a model with
+   * dotproduct=fastest, it is the fastest code for that model.
+   * Returns a static string. Do not delete.
+   */
+  static const char* SIMDKernel();
+
   /**
    * If compiled with OpenCL AND an available OpenCL
    * device is deemed faster than serial code, then
@@ -169,6 +284,31 @@ class TESS_API TessBaseAPI {
    */
   bool GetVariableAsString(const char *name, STRING *val);
 
+  /**
+   * Compiles the assignments of values to the variables of the given names
+   * into profile, checking and parsing them once as SetVariable would, so
+   * that ApplyVariables can switch between configurations quickly.
+   * Returns false if a name is not a variable that SetVariable can set, or
+   * its value is not valid, in which case the other assignments are still
+   * compiled. Must be called after Init().
+   */
+  bool CompileVariables(const GenericVector<STRING>* names,
+                        const GenericVector<STRING>* values,
+                        VariableProfile* profile) const;
+
+  /**
+   * Sets the variables of profile. If previous is not nullptr, it gets the
+   * values the variables had before, so applying it reverts the change.
+   */
+  void ApplyVariables(const VariableProfile& profile,
+                      VariableProfile* previous);
+
+  /**
+   * Saves the values of all the variables in snapshot, so that applying
+   * it restores them, as ResetToDefaults would restore the defaults.
+   */
+  void SaveVariables(VariableProfile* snapshot) const;
+
   /**
    * Instances are now mostly thread-safe and totally independent,
    * but some global parameters remain. Basically it is safe to use multiple
@@ -225,6 +365,28 @@ class TESS_API TessBaseAPI {
            const GenericVector<STRING>* vars_values,
            bool set_only_non_debug_params, FileReader reader);
 
+  /**
+   * Initializes this engine as a copy of source, which must be initialized
+   * from a datapath: the same datapath, languages, OcrEngineMode, config
+   * files and variables of its Init, then the variables set on source since.
+   * The copy shares everything that the engines of a process share, the
+   * LSTM networks with their shaped weights and the dawgs, as long as source
+   * lives, and only loads its own mutable state, such as the unicharsets,
+   * the recoder and the adaptive classifier, which starts empty.
+   * Returns 0 on success and -1 on failure, as Init.
+   *
+   * Engines and forking: a process may Init an engine and then fork, and
+   * each child may use its copy of the engine, or initialize others from it
+   * with InitLike, provided that no other thread of the parent was using
+   * the API during the fork, as the caches of networks and dawgs are guarded
+   * by mutexes that such a thread could hold. The threads that the API
+   * starts, page_parallel_jobs workers, the PagePrefetcher and the threads
+   * of TessEnginePool, do not exist in the child, so start them after the
+   * fork. Neither do those of OpenMP, so an OpenMP build should not
+   * recognize in the parent before forking.
+   */
+  int InitLike(const TessBaseAPI& source);
+
   /**
    * Returns the languages string used in the last valid initialization.
    * If the last initialization specified "deu+hin" then that will be
@@ -235,6 +397,103 @@ class TESS_API TessBaseAPI {
    */
   const char* GetInitLanguagesAsString() const;
 
+  /**
+   * Returns the time and memory taken by the phases of the last Init, one
+   * phase per line: the milliseconds, the growth of the resident set in MB,
+   * the times the phase was entered and its name, indented under the phase
+   * that encloses it. Only the phases that ran are listed, so an Init that
+   * reused the loaded language shows little more than the Init itself.
+   * The returned string must be freed with the delete [] operator.
+   */
+  char* GetInitProfileText() const;
+
+  /**
+   * Starts recording the time spent in the stages of the engines of all
+   * the threads of the process, from setting the image and thresholding to
+   * layout analysis, each recognition pass, the LSTM forward pass and beam
+   * decoding of each line and the renderers, forgetting any recorded before.
+   * When not started, the stages cost next to nothing.
+   */
+  static void StartTracing();
+  /** Stops recording, keeping what was recorded for GetTraceJSON. */
+  static void StopTracing();
+  /**
+   * Returns the recorded stages as nested spans per thread, in the JSON
+   * trace event format that chrome://tracing and Perfetto load.
+   * The returned string must be freed with the delete [] operator.
+   */
+  static char* GetTraceJSON();
+
+  /**
+   * Starts adding up the time of the forward pass of each layer of the LSTM
+   * networks of all the engines of the process, with the timesteps and an
+   * estimate of the multiply-adds of its weights, per layer spec, forgetting
+   * any added up before.
+   */
+  static void StartLayerProfile();
+  /** Stops adding up, keeping the layers for GetLayerProfileText. */
+  static void StopLayerProfile();
+  /**
+   * Returns a line per layer, in the order of the network: the milliseconds,
+   * the share of the total time, the millions of operations, the timesteps,
+   * the runs and the spec of the layer, then a line of the totals.
+   * The returned string must be freed with the delete [] operator.
+   */
+  static char* GetLayerProfileText();
+
+  /**
+   * Copies the counters of the work that this engine did since it was
+   * constructed or ResetCounters was called, such as the blobs found, the
+   * lines and LSTM timesteps recognized, the beam search nodes, dawg
+   * lookups, chop attempts, classifier calls, recognizer scratch
+   * allocations, traineddata bytes loaded and pages rejected as blank, to
+   * values, which has room for size of them. Returns the number of
+   * counters, which may be more than size. Reading them takes no locks and no formatting, so it may be
+   * done often, even while the engine recognizes on another thread.
+   */
+  int GetCounters(int64_t* values, int size) const;
+  /** Sets the counters of this engine to zero. */
+  void ResetCounters();
+  /**
+   * As GetCounters, but counts the work of all the engines of the process
+   * since it started, including those that have been destroyed.
+   */
+  static int GetProcessCounters(int64_t* values, int size);
+  /**
+   * Returns the name of counter index of GetCounters, such as
+   * "blobs_found", or nullptr if there is no such counter. Do not delete.
+   */
+  static const char* GetCounterName(int index);
+
+  /**
+   * Copies the bytes that each subsystem of this engine holds, as named by
+   * GetMemoryCategoryName, to values, which has room for size of them:
+   * the float and int weights of the LSTM networks, their scratch buffers,
+   * the results of the page, the live grids of the layout analysis, the
+   * classifier templates, the dawgs and the copies of the image. These are
+   * estimates from the sizes of the major containers. Weights and dawgs
+   * that are shared with other engines are counted by each of them.
+   * Returns the number of categories, which may be more than size.
+   */
+  int GetMemoryUsage(int64_t* values, int size) const;
+  /**
+   * Returns the high-water mark of the bytes of GetMemoryUsage during the
+   * current page, since the last SetImage or Clear: the bytes held now,
+   * with the grids of the layout analysis at their peak.
+   */
+  int64_t GetPageMemoryHighWater() const;
+  /**
+   * Returns a line per category of GetMemoryUsage in MB, then the total and
+   * the page high-water mark.
+   * The returned string must be freed with the delete [] operator.
+   */
+  char* GetMemoryUsageText() const;
+  /**
+   * Returns the name of category index of GetMemoryUsage, such as
+   * "weights_int", or nullptr if there is no such category. Do not delete.
+   */
+  static const char* GetMemoryCategoryName(int index);
+
   /**
    * Returns the loaded languages in the vector of STRINGs.
    * Includes all languages loaded by the last Init, including those loaded
@@ -308,6 +567,21 @@ class TESS_API TessBaseAPI {
    */
   void ClearAdaptiveClassifier();
 
+  /**
+   * Writes the adaptive classifier state of the current document to
+   * filename, and to filename.<lang> for each additional language, so that
+   * another TessBaseAPI initialized with the same languages can continue
+   * from it with LoadAdaptiveClassifier, e.g. when the pages of a document
+   * are split over several instances. Returns false on error.
+   */
+  bool SaveAdaptiveClassifier(const char* filename);
+
+  /**
+   * Replaces the adaptive classifier state with one written by
+   * SaveAdaptiveClassifier. Returns false on error.
+   */
+  bool LoadAdaptiveClassifier(const char* filename);
+
   /**
    * @defgroup AdvancedAPI Advanced API
    * The following methods break TesseractRect into pieces, so you can
@@ -333,9 +607,23 @@ class TESS_API TessBaseAPI {
    * Pix vs raw, which to use?
    * Use Pix where possible. Tesseract uses Pix as its internal representation
    * and it is therefore more efficient to provide a Pix directly.
+   * With image_memory_limit_mb set, a color image whose page images don't
+   * fit in the limit is reduced to grey, and an image that still doesn't fit
+   * is rejected, leaving no image to recognize.
    */
   void SetImage(Pix* pix);
 
+  /**
+   * Provide an 8 bit greyscale image for Tesseract to recognize, without
+   * copying it. Lines of width bytes start bytes_per_line bytes apart.
+   * Unlike SetImage, the image data is used in place, so it must stay valid
+   * and unchanged until the next SetImage, SetImageView, Clear or End.
+   * Thresholding reads the data directly, and the single copy of it that
+   * Tesseract needs as a Pix for recognition is only made after that.
+   */
+  void SetImageView(const unsigned char* imagedata, int width, int height,
+                    int bytes_per_line);
+
   /**
    * Set the resolution of the source image in pixels per inch so font size
    * information can be calculated in results.  Call this after SetImage().
@@ -366,6 +654,7 @@ class TESS_API TessBaseAPI {
    * Get a copy of the internal thresholded image from Tesseract.
    * Caller takes ownership of the Pix and must pixDestroy it.
    * May be called any time after SetImage, or after TesseractRect.
+   * With tessedit_auto_downscale, it may be a reduction of the image.
    */
   Pix* GetThresholdedImage();
 
@@ -447,6 +736,18 @@ class TESS_API TessBaseAPI {
     return GetComponentImages(level, text_only, false, 0, pixa, blockids, nullptr);
   }
 
+  /**
+   * As GetComponentImages, but instead of a Pixa of cropped images, which is
+   * costly when only a few of the images are wanted, fills views with one
+   * ComponentView per component, in the same order as the boxes, from which
+   * the image of any component can be cropped on request.
+   * views may be nullptr to get just the boxes.
+   */
+  Boxa* GetComponentViews(PageIteratorLevel level, bool text_only,
+                          bool raw_image, int raw_padding,
+                          std::vector<ComponentView>* views, int** blockids,
+                          int** paraids);
+
   /**
    * Returns the scale factor of the thresholded image that would be returned by
    * GetThresholdedImage() and the various GetX() methods that call
@@ -478,9 +779,72 @@ class TESS_API TessBaseAPI {
    * internal structures. Returns 0 on success.
    * Optional. The Get*Text functions below will call Recognize if needed.
    * After Recognize, the output is kept internally until the next SetImage.
+   * Paragraphs are only detected when an iterator is first requested.
    */
   int Recognize(ETEXT_DESC* monitor);
 
+  /**
+   * Recognizes each of many small images on its own with the given page
+   * segmentation mode, leaving the result of images[i] in (*results)[i].
+   * In the single line and single word modes, the images skip thresholding
+   * and layout analysis and go to the LSTM engine in batches, when it runs
+   * alone; otherwise each image is recognized as by SetImage and Recognize.
+   * A nullptr image gets an empty result. The internal results are cleared.
+   * Returns false if the engine is not initialized.
+   */
+  bool RecognizeBatch(const std::vector<Pix*>& images, PageSegMode mode,
+                      std::vector<BatchResult>* results);
+  /**
+   * As above, for the rectangles boxes of image, giving the word boxes in the
+   * coordinates of image.
+   */
+  bool RecognizeBatch(Pix* image, Boxa* boxes, PageSegMode mode,
+                      std::vector<BatchResult>* results);
+
+  /**
+   * Recognizes many regions of the image from SetImage, such as the fields
+   * of a form, each with its own page segmentation mode, leaving the result
+   * of regions[i] in (*results)[i], with the word boxes in the coordinates
+   * of the image. The image is thresholded once, and each region is cut
+   * from the thresholded and grey images, instead of thresholding it again
+   * as SetRectangle would. The line and word regions are recognized as by
+   * RecognizeBatch, all in one batch, on lstm_line_threads threads.
+   * Replaces any rectangle from SetRectangle by the whole image, and clears
+   * the internal results and any kept layout.
+   * Returns false if the engine is not initialized or there is no image.
+   */
+  bool RecognizeRegions(const std::vector<BatchRegion>& regions,
+                        std::vector<BatchResult>* results);
+
+  /**
+   * Keeps the thresholded image and page layout of the current image once
+   * they have been found, so that later calls to Recognize with a different
+   * language, engine mode or variables only rerun word recognition.
+   * The kept layout is used only while the page segmentation mode is the same
+   * as the one that found it. SetImage, SetRectangle, SetSourceResolution,
+   * Clear and SetKeepLayout(false) discard it.
+   */
+  void SetKeepLayout(bool keep_layout);
+
+  /** Returns true if a layout of the current image is kept for reuse. */
+  bool HasKeptLayout() const;
+
+  /**
+   * Returns why the layout analysis of the current image gave an empty page
+   * without looking for text, such as "no ink", when textord_blank_page_reject
+   * is set, or nullptr if it did not. Do not delete.
+   */
+  const char* GetBlankPageReason() const;
+
+  /**
+   * Returns true if the current image was recognized with less than the
+   * usual care to stay within tessedit_memory_budget_mb: reduction is then
+   * the factor by which the page was reduced for it (1 for none), and
+   * skipped_lines the number of LSTM lines that got no words as they were
+   * too wide for it, or for lstm_max_line_timesteps.
+   */
+  bool GetMemoryBudgetOutcome(int* reduction, int* skipped_lines) const;
+
   /**
    * Methods to retrieve information after SetAndThresholdImage(),
    * Recognize() or TesseractRect(). (Recognize is called implicitly if needed.)
@@ -509,7 +873,9 @@ class TESS_API TessBaseAPI {
    * the TessPDFRender to produce searchable PDF.
    *
    * If tessedit_page_number is non-negative, will only process that
-   * single page. Works for multi-page tiff file, or filelist.
+   * single page, or the tessedit_page_count pages from it on (0 for all
+   * the rest), which are numbered in the output as in the whole document.
+   * Works for multi-page tiff file, or filelist.
    *
    * Returns true if successful, false on error.
    */
@@ -552,6 +918,14 @@ class TESS_API TessBaseAPI {
    */
   MutableIterator* GetMutableIterator();
 
+  /**
+   * Finishes the lazy work on the results of Recognize, such as the
+   * paragraph detection, so that GetIterator and the Get*Text methods only
+   * read them until they are next changed, and several threads may call
+   * them at once. Returns false if there are no recognition results yet.
+   */
+  bool PrepareResultsForReading();
+
   /**
    * The recognized text is returned as a char* which is coded
    * as UTF8 and must be freed with the delete [] operator.
@@ -577,6 +951,14 @@ class TESS_API TessBaseAPI {
    */
   char* GetHOCRText(int page_number);
 
+  /**
+   * Writes the hOCR markup of GetHOCRText to out as the page is walked,
+   * without building it in memory. The locale and precision of out are
+   * restored afterwards. Returns false if recognition failed, in which case
+   * nothing is written.
+   */
+  bool GetHOCRText(ETEXT_DESC* monitor, int page_number, std::ostream& out);
+
   /**
    * Make an XML-formatted string with Alto markup from the internal
    * data structures.
@@ -590,6 +972,12 @@ class TESS_API TessBaseAPI {
    */
   char* GetAltoText(int page_number);
 
+  /**
+   * Writes the Alto markup of GetAltoText to out as the page is walked.
+   * Returns false if recognition failed, in which case nothing is written.
+   */
+  bool GetAltoText(ETEXT_DESC* monitor, int page_number, std::ostream& out);
+
   /**
    * Make a TSV-formatted string from the internal data structures.
    * page_number is 0-based but will appear in the output as 1-based.
@@ -597,6 +985,30 @@ class TESS_API TessBaseAPI {
    */
   char* GetTSVText(int page_number);
 
+  /**
+   * Writes the rows of GetTSVText to out as the page is walked.
+   * Returns false if recognition failed, in which case nothing is written.
+   */
+  bool GetTSVText(int page_number, std::ostream& out);
+
+  /**
+   * Writes the records of a page in the tbr binary result format, which is
+   * described in renderer.h, to out as the page is walked. choices adds the
+   * choices of each symbol. Returns false if recognition failed, in which
+   * case nothing is written.
+   */
+  bool GetBinaryResult(int page_number, bool choices, std::ostream& out);
+  bool GetBinaryResult(int page_number, bool choices, std::string* data);
+
+  /**
+   * Fills arrays with the boxes, confidences, text and parents of all the
+   * elements of the page at level, in one walk of the results, so that
+   * there is no call or allocation for each of them. Only blocks,
+   * paragraphs and lines with words are counted. Returns false if
+   * recognition failed.
+   */
+  bool GetResultArrays(PageIteratorLevel level, ResultArrays* arrays);
+
   /**
    * Make a box file for LSTM training from the internal data structures.
    * Constructs coordinates in the original image - not just the rectangle.
@@ -693,7 +1105,9 @@ class TESS_API TessBaseAPI {
    * There are a variety of expensive-to-load constant data structures (mostly
    * language dictionaries) that are cached globally -- surviving the Init()
    * and End() of individual TessBaseAPI's.  This function allows the clearing
-   * of these caches.
+   * of these caches. It also frees the memory that all the threads keep
+   * for reuse by the layout and recognition objects of the next page, as
+   * End() does.
    **/
   static void ClearPersistentCache();
 
@@ -704,6 +1118,17 @@ class TESS_API TessBaseAPI {
    * in a separate API at some future time.
    */
   int IsValidWord(const char *word);
+  /**
+   * Attaches the given words, UTF-8 and one per line as in a user_words_file,
+   * as an extra user dictionary of all the loaded languages, for both engines,
+   * until DetachExtraWords or End, replacing any previous extra words.
+   * Unlike setting user_words_file, needs no Init, so the other dictionaries
+   * are not reloaded. Must not be called during recognition.
+   * @return false if there was no dictionary to attach to.
+   */
+  bool AttachExtraWords(const char *words);
+  /** Detaches the words of AttachExtraWords. */
+  void DetachExtraWords();
   // Returns true if utf8_character is defined in the UniCharset.
   bool IsValidCharacter(const char *utf8_character);
 
@@ -821,6 +1246,21 @@ class TESS_API TessBaseAPI {
   /** Delete the pageres and block list ready for a new page. */
   void ClearResults();
 
+  /** Adds the estimated bytes of each subsystem to usage. */
+  TESS_LOCAL void EstimateMemoryUsage(MemoryUsage* usage) const;
+
+  /** Copies the layout just found by FindLines, if SetKeepLayout is on. */
+  TESS_LOCAL void KeepLayout();
+
+  /**
+   * Restores the kept layout and thresholded image for FindLines.
+   * Returns false if there is none for the current page segmentation mode.
+   */
+  TESS_LOCAL bool RestoreKeptLayout();
+
+  /** Discards the kept layout, if any. */
+  TESS_LOCAL void ClearKeptLayout();
+
   /**
    * Return an LTR Result Iterator -- used only for training, as we really want
    * to ignore all BiDi smarts at that point.
@@ -839,6 +1279,9 @@ class TESS_API TessBaseAPI {
   //// paragraphs.cpp ////////////////////////////////////////////////////
   TESS_LOCAL void DetectParagraphs(bool after_text_recognition);
 
+  /** Runs the paragraph detection that Recognize left for later, if any. */
+  TESS_LOCAL void DetectPendingParagraphs();
+
   #ifndef DISABLED_LEGACY_ENGINE
 
   /** @defgroup ocropusAddOns ocropus add-ons */
@@ -891,9 +1334,26 @@ class TESS_API TessBaseAPI {
   STRING*           output_file_;     ///< Name used by debug code.
   STRING*           datapath_;        ///< Current location of tessdata.
   STRING*           language_;        ///< Last initialized language.
+  InitProfile*      init_profile_;    ///< Phases of the last Init.
+  Counters*         counters_;        ///< Work done by this engine.
+  MemoryTracker*    memory_tracker_;  ///< Grids of the current page.
+  std::vector<std::string> init_configs_;  ///< Configs that loaded tesseract_.
+  std::vector<std::string> init_vars_;     ///< Variables set by that Init,
+  std::vector<std::string> init_values_;   ///< and their values.
+  bool init_non_debug_only_;  ///< set_only_non_debug_params of that Init.
+  bool init_from_memory_;     ///< That Init read the traineddata from memory.
   OcrEngineMode last_oem_requested_;  ///< Last ocr language mode requested.
   bool          recognition_done_;   ///< page_res_ contains recognition data.
+  bool          paragraphs_pending_;  ///< Paragraphs not detected yet.
   TruthCallback *truth_cb_;           /// fxn for setting truth_* in WERD_RES
+  bool          keep_layout_;         ///< Keep layouts for SetKeepLayout.
+  PageSegMode   kept_pageseg_mode_;   ///< Mode that found kept_block_list_.
+  BLOCK_LIST*   kept_block_list_;     ///< Copy of the kept page layout.
+  Pix*          kept_pix_binary_;     ///< Thresholded image of the layout.
+  Pix*          kept_pix_grey_;       ///< Grey image of the layout.
+  Pix*          kept_pix_thresholds_; ///< Thresholds of the layout.
+  int           kept_source_resolution_;  ///< Resolution of the layout.
+  int           kept_image_reduction_;    ///< Reduction of the layout.
 
   /**
    * @defgroup ThresholderParams Thresholder Parameters
@@ -914,15 +1374,29 @@ class TESS_API TessBaseAPI {
                             STRING *buf,
                             const char* retry_config, int timeout_millisec,
                             TessResultRenderer* renderer,
-                            int tessedit_page_number);
+                            int first_page, int page_count);
   // TIFF supports multipage so gets special consideration.
+  // Both process page_count pages from first_page on, or all the rest if
+  // page_count is 0.
   bool ProcessPagesMultipageTiff(const unsigned char *data,
                                  size_t size,
                                  const char* filename,
                                  const char* retry_config,
                                  int timeout_millisec,
                                  TessResultRenderer* renderer,
-                                 int tessedit_page_number);
+                                 int first_page, int page_count);
+  // Returns the number of engines to recognize the pages of a document with:
+  // page_parallel_jobs, or 1 if one page, a retry config or a training mode
+  // is requested.
+  int PageJobs(const char* retry_config) const;
+  // Recognizes the pages got from pages, numbered from page, on jobs engines
+  // at once: this one, and others initialized like it, which share its
+  // models. The pages are rendered in page order, each by the engine that
+  // recognized it. The pages are those of the multipage file filename, or of
+  // a file list if filename is nullptr.
+  bool ProcessPagesInParallel(PagePrefetcher* pages, int page,
+                              const char* filename, int timeout_millisec,
+                              TessResultRenderer* renderer, int jobs);
   // There's currently no way to pass a document title from the
   // Tesseract command line, and we have multiple places that choose
   // to set the title to an empty string. Using a single named
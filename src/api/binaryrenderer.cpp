@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////
+// File:        binaryrenderer.cpp
+// Description: Renderer for the tbr binary result format.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include <cstdint>    // for int32_t, uint32_t
+#include <cstring>    // for memcpy, strlen
+#include <memory>     // for std::unique_ptr
+#include <ostream>    // for std::ostream
+#include <sstream>    // for std::stringstream
+#include "baseapi.h"  // for TessBaseAPI
+#include "renderer.h"
+#include "resultiterator.h"  // for ResultIterator
+
+namespace tesseract {
+
+// Writes value as 4 little-endian bytes, whatever the byte order of the
+// host.
+static void WriteTbrUInt32(uint32_t value, std::ostream& out) {
+  char bytes[4];
+  for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>(value >> (8 * i));
+  out.write(bytes, 4);
+}
+
+static void WriteTbrInt(int value, std::ostream& out) {
+  WriteTbrUInt32(static_cast<uint32_t>(static_cast<int32_t>(value)), out);
+}
+
+static void WriteTbrFloat(float value, std::ostream& out) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  WriteTbrUInt32(bits, out);
+}
+
+static void WriteTbrString(const char* text, std::ostream& out) {
+  int length = text != nullptr ? strlen(text) : 0;
+  WriteTbrInt(length, out);
+  if (length > 0) out.write(text, length);
+}
+
+static void WriteTbrBox(const PageIterator* it, PageIteratorLevel level,
+                        std::ostream& out) {
+  int left, top, right, bottom;
+  it->BoundingBox(level, &left, &top, &right, &bottom);
+  WriteTbrInt(left, out);
+  WriteTbrInt(top, out);
+  WriteTbrInt(right, out);
+  WriteTbrInt(bottom, out);
+}
+
+static void WriteTbrLine(const ResultIterator* it, std::ostream& out) {
+  out.put(kTbrLine);
+  WriteTbrBox(it, RIL_TEXTLINE, out);
+  int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+  bool has_baseline = it->Baseline(RIL_TEXTLINE, &x1, &y1, &x2, &y2);
+  out.put(has_baseline ? 1 : 0);
+  WriteTbrInt(x1, out);
+  WriteTbrInt(y1, out);
+  WriteTbrInt(x2, out);
+  WriteTbrInt(y2, out);
+  float row_height, descenders, ascenders;
+  it->RowAttributes(&row_height, &descenders, &ascenders);
+  WriteTbrFloat(row_height, out);
+  WriteTbrFloat(descenders, out);
+  WriteTbrFloat(ascenders, out);
+}
+
+/**
+ * Write the records of the page to out while walking the results, without
+ * making text of anything but the symbols.
+ */
+bool TessBaseAPI::GetBinaryResult(int page_number, bool choices,
+                                  std::ostream& out) {
+  if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(nullptr) < 0))
+    return false;
+
+  out.put(kTbrPage);
+  WriteTbrInt(page_number, out);
+  WriteTbrInt(rect_left_, out);
+  WriteTbrInt(rect_top_, out);
+  WriteTbrInt(rect_left_ + rect_width_, out);
+  WriteTbrInt(rect_top_ + rect_height_, out);
+
+  std::unique_ptr<ResultIterator> res_it(GetIterator());
+  while (!res_it->Empty(RIL_BLOCK)) {
+    if (res_it->Empty(RIL_WORD)) {
+      res_it->Next(RIL_WORD);
+      continue;
+    }
+
+    if (res_it->IsAtBeginningOf(RIL_BLOCK)) {
+      out.put(kTbrBlock);
+      out.put(static_cast<char>(res_it->BlockType()));
+      WriteTbrBox(res_it.get(), RIL_BLOCK, out);
+    }
+    if (res_it->IsAtBeginningOf(RIL_PARA)) {
+      out.put(kTbrPara);
+      out.put(res_it->ParagraphIsLtr() ? 1 : 0);
+      WriteTbrBox(res_it.get(), RIL_PARA, out);
+    }
+    if (res_it->IsAtBeginningOf(RIL_TEXTLINE)) {
+      WriteTbrLine(res_it.get(), out);
+    }
+
+    out.put(kTbrWord);
+    WriteTbrBox(res_it.get(), RIL_WORD, out);
+    WriteTbrFloat(res_it->Confidence(RIL_WORD), out);
+    int flags = 0;
+    if (res_it->WordIsFromDictionary()) flags |= kTbrFromDictionary;
+    if (res_it->WordIsNumeric()) flags |= kTbrNumeric;
+    out.put(static_cast<char>(flags));
+
+    do {
+      out.put(kTbrSymbol);
+      WriteTbrBox(res_it.get(), RIL_SYMBOL, out);
+      WriteTbrFloat(res_it->Confidence(RIL_SYMBOL), out);
+      const std::unique_ptr<const char[]> grapheme(
+          res_it->GetUTF8Text(RIL_SYMBOL));
+      WriteTbrString(grapheme.get(), out);
+      if (choices) {
+        ChoiceIterator ci(*res_it);
+        do {
+          const char* choice = ci.GetUTF8Text();
+          if (choice == nullptr) continue;
+          out.put(kTbrChoice);
+          WriteTbrFloat(ci.Confidence(), out);
+          WriteTbrString(choice, out);
+        } while (ci.Next());
+      }
+      res_it->Next(RIL_SYMBOL);
+    } while (!res_it->Empty(RIL_BLOCK) && !res_it->IsAtBeginningOf(RIL_WORD));
+  }
+  out.put(kTbrEndPage);
+  return true;
+}
+
+bool TessBaseAPI::GetBinaryResult(int page_number, bool choices,
+                                  std::string* data) {
+  std::stringstream stream;
+  if (!GetBinaryResult(page_number, choices, stream)) return false;
+  *data = stream.str();
+  return true;
+}
+
+/**********************************************************************
+ * Binary Result Renderer interface implementation
+ **********************************************************************/
+TessBinaryRenderer::TessBinaryRenderer(const char* outputbase, bool choices)
+    : TessResultRenderer(outputbase, "tbr"), choices_(choices) {}
+
+bool TessBinaryRenderer::BeginDocumentHandler() {
+  const char header[] = {'T', 'B', 'R', kTbrVersion};
+  AppendData(header, sizeof(header));
+  return happy();
+}
+
+bool TessBinaryRenderer::AddImageHandler(TessBaseAPI* api) {
+  return api->GetBinaryResult(imagenum(), choices_, output()) && happy();
+}
+
+}  // namespace tesseract
@@ -26,6 +26,10 @@ TESS_API const char* TESS_CALL TessVersion() {
   return TessBaseAPI::Version();
 }
 
+TESS_API const char* TESS_CALL TessSIMDKernel() {
+  return TessBaseAPI::SIMDKernel();
+}
+
 TESS_API void TESS_CALL TessDeleteText(const char* text) {
   delete[] text;
 }
@@ -72,6 +76,11 @@ TessTsvRendererCreate(const char* outputbase) {
   return new TessTsvRenderer(outputbase);
 }
 
+TESS_API TessResultRenderer* TESS_CALL
+TessBinaryRendererCreate(const char* outputbase, BOOL choices) {
+  return new TessBinaryRenderer(outputbase, choices != 0);
+}
+
 TESS_API TessResultRenderer* TESS_CALL TessPDFRendererCreate(
     const char* outputbase, const char* datadir, BOOL textonly) {
   return new TessPDFRenderer(outputbase, datadir, textonly != 0);
@@ -286,11 +295,82 @@ TESS_API int TESS_CALL TessBaseAPIInit3(TessBaseAPI* handle,
   return handle->Init(datapath, language);
 }
 
+TESS_API int TESS_CALL TessBaseAPIInitLike(TessBaseAPI* handle,
+                                           const TessBaseAPI* source) {
+  return handle->InitLike(*source);
+}
+
 TESS_API const char* TESS_CALL
 TessBaseAPIGetInitLanguagesAsString(const TessBaseAPI* handle) {
   return handle->GetInitLanguagesAsString();
 }
 
+TESS_API char* TESS_CALL
+TessBaseAPIGetInitProfileText(const TessBaseAPI* handle) {
+  return handle->GetInitProfileText();
+}
+
+TESS_API void TESS_CALL TessBaseAPIStartTracing() {
+  TessBaseAPI::StartTracing();
+}
+
+TESS_API void TESS_CALL TessBaseAPIStopTracing() {
+  TessBaseAPI::StopTracing();
+}
+
+TESS_API char* TESS_CALL TessBaseAPIGetTraceJSON() {
+  return TessBaseAPI::GetTraceJSON();
+}
+
+TESS_API void TESS_CALL TessBaseAPIStartLayerProfile() {
+  TessBaseAPI::StartLayerProfile();
+}
+
+TESS_API void TESS_CALL TessBaseAPIStopLayerProfile() {
+  TessBaseAPI::StopLayerProfile();
+}
+
+TESS_API char* TESS_CALL TessBaseAPIGetLayerProfileText() {
+  return TessBaseAPI::GetLayerProfileText();
+}
+
+TESS_API int TESS_CALL TessBaseAPIGetCounters(const TessBaseAPI* handle,
+                                              int64_t* values, int size) {
+  return handle->GetCounters(values, size);
+}
+
+TESS_API void TESS_CALL TessBaseAPIResetCounters(TessBaseAPI* handle) {
+  handle->ResetCounters();
+}
+
+TESS_API int TESS_CALL TessBaseAPIGetProcessCounters(int64_t* values,
+                                                     int size) {
+  return TessBaseAPI::GetProcessCounters(values, size);
+}
+
+TESS_API const char* TESS_CALL TessBaseAPIGetCounterName(int index) {
+  return TessBaseAPI::GetCounterName(index);
+}
+
+TESS_API int TESS_CALL TessBaseAPIGetMemoryUsage(const TessBaseAPI* handle,
+                                                 int64_t* values, int size) {
+  return handle->GetMemoryUsage(values, size);
+}
+
+TESS_API int64_t TESS_CALL
+TessBaseAPIGetPageMemoryHighWater(const TessBaseAPI* handle) {
+  return handle->GetPageMemoryHighWater();
+}
+
+TESS_API char* TESS_CALL
+TessBaseAPIGetMemoryUsageText(const TessBaseAPI* handle) {
+  return handle->GetMemoryUsageText();
+}
+
+TESS_API const char* TESS_CALL TessBaseAPIGetMemoryCategoryName(int index) {
+  return TessBaseAPI::GetMemoryCategoryName(index);
+}
+
 TESS_API char** TESS_CALL
 TessBaseAPIGetLoadedLanguagesAsVector(const TessBaseAPI* handle) {
   GenericVector<STRING> languages;
@@ -376,6 +456,13 @@ TESS_API void TESS_CALL TessBaseAPISetImage2(TessBaseAPI* handle,
   return handle->SetImage(pix);
 }
 
+TESS_API void TESS_CALL TessBaseAPISetImageView(TessBaseAPI* handle,
+                                                const unsigned char* imagedata,
+                                                int width, int height,
+                                                int bytes_per_line) {
+  handle->SetImageView(imagedata, width, height, bytes_per_line);
+}
+
 TESS_API void TESS_CALL TessBaseAPISetSourceResolution(TessBaseAPI* handle,
                                                        int ppi) {
   handle->SetSourceResolution(ppi);
@@ -462,6 +549,15 @@ TESS_API int TESS_CALL TessBaseAPIRecognize(TessBaseAPI* handle,
   return handle->Recognize(monitor);
 }
 
+TESS_API void TESS_CALL TessBaseAPISetKeepLayout(TessBaseAPI* handle,
+                                                 BOOL keep_layout) {
+  handle->SetKeepLayout(keep_layout != 0);
+}
+
+TESS_API BOOL TESS_CALL TessBaseAPIHasKeptLayout(const TessBaseAPI* handle) {
+  return static_cast<int>(handle->HasKeptLayout());
+}
+
 #ifndef DISABLED_LEGACY_ENGINE
 TESS_API int TESS_CALL TessBaseAPIRecognizeForChopTest(TessBaseAPI* handle,
                                                        ETEXT_DESC* monitor) {
@@ -536,6 +632,49 @@ TESS_API char* TESS_CALL TessBaseAPIGetUNLVText(TessBaseAPI* handle) {
   return handle->GetUNLVText();
 }
 
+TESS_API TessResultArrays* TESS_CALL
+TessBaseAPIGetResultArrays(TessBaseAPI* handle, TessPageIteratorLevel level) {
+  auto* arrays = new TessResultArrays;
+  if (!handle->GetResultArrays(level, arrays)) {
+    delete arrays;
+    return nullptr;
+  }
+  return arrays;
+}
+
+TESS_API void TESS_CALL TessResultArraysDelete(TessResultArrays* arrays) {
+  delete arrays;
+}
+
+TESS_API int TESS_CALL TessResultArraysSize(const TessResultArrays* arrays) {
+  return arrays->size();
+}
+
+TESS_API const int* TESS_CALL
+TessResultArraysBoxes(const TessResultArrays* arrays) {
+  return arrays->boxes.data();
+}
+
+TESS_API const float* TESS_CALL
+TessResultArraysConfidences(const TessResultArrays* arrays) {
+  return arrays->confidences.data();
+}
+
+TESS_API const char* TESS_CALL
+TessResultArraysText(const TessResultArrays* arrays) {
+  return arrays->text.c_str();
+}
+
+TESS_API const int* TESS_CALL
+TessResultArraysTextOffsets(const TessResultArrays* arrays) {
+  return arrays->text_offsets.data();
+}
+
+TESS_API const int* TESS_CALL
+TessResultArraysParents(const TessResultArrays* arrays) {
+  return arrays->parents.data();
+}
+
 TESS_API int TESS_CALL TessBaseAPIMeanTextConf(TessBaseAPI* handle) {
   return handle->MeanTextConf();
 }
@@ -674,6 +813,71 @@ TessBaseAPIFindLinesCreateBlockList(TessBaseAPI* handle) {
 }
 #endif
 
+TESS_API TessEnginePool* TESS_CALL TessEnginePoolCreate(const char* datapath,
+                                                         int max_engines) {
+  return new TessEnginePool(datapath, max_engines);
+}
+
+TESS_API void TESS_CALL TessEnginePoolDelete(TessEnginePool* pool) {
+  delete pool;
+}
+
+TESS_API TessBaseAPI* TESS_CALL TessEnginePoolAcquire(
+    TessEnginePool* pool, const char* language, TessOcrEngineMode oem,
+    char** vars_vec, char** vars_values, size_t vars_vec_size) {
+  GenericVector<STRING> varNames;
+  GenericVector<STRING> varValues;
+  if (vars_vec != nullptr && vars_values != nullptr) {
+    for (size_t i = 0; i < vars_vec_size; i++) {
+      varNames.push_back(STRING(vars_vec[i]));
+      varValues.push_back(STRING(vars_values[i]));
+    }
+  }
+  return pool->Acquire(language, oem, &varNames, &varValues);
+}
+
+TESS_API void TESS_CALL TessEnginePoolRecognizeAsync(
+    TessEnginePool* pool, struct Pix* pix, const char* language,
+    TessOcrEngineMode oem, char** vars_vec, char** vars_values,
+    size_t vars_vec_size, ETEXT_DESC* monitor, TessRecognizeCallback callback,
+    void* user_data) {
+  GenericVector<STRING> varNames;
+  GenericVector<STRING> varValues;
+  if (vars_vec != nullptr && vars_values != nullptr) {
+    for (size_t i = 0; i < vars_vec_size; i++) {
+      varNames.push_back(STRING(vars_vec[i]));
+      varValues.push_back(STRING(vars_values[i]));
+    }
+  }
+  TessEnginePool::RecognizeCallback done;
+  if (callback != nullptr) {
+    done = [callback, user_data](int status, TessResultIterator* it) {
+      (*callback)(user_data, status, it);
+    };
+  }
+  pool->RecognizeAsync(pix, language, oem, &varNames, &varValues, monitor,
+                       std::move(done));
+}
+
+TESS_API void TESS_CALL TessEnginePoolRelease(TessEnginePool* pool,
+                                              TessBaseAPI* handle) {
+  pool->Release(handle);
+}
+
+TESS_API void TESS_CALL TessEnginePoolGetStats(
+    TessEnginePool* pool, int* engines, int* leased, long long* leases,
+    long long* inits, long long* failed_inits, long long* waits,
+    int* queued) {
+  tesseract::EnginePoolStats stats = pool->GetStats();
+  if (engines != nullptr) *engines = stats.engines;
+  if (leased != nullptr) *leased = stats.leased;
+  if (leases != nullptr) *leases = stats.leases;
+  if (inits != nullptr) *inits = stats.inits;
+  if (failed_inits != nullptr) *failed_inits = stats.failed_inits;
+  if (waits != nullptr) *waits = stats.waits;
+  if (queued != nullptr) *queued = stats.queued;
+}
+
 TESS_API void TESS_CALL TessPageIteratorDelete(TessPageIterator* handle) {
   delete handle;
 }
@@ -903,6 +1107,11 @@ TessMonitorSetProgressFunc(ETEXT_DESC* monitor, TessProgressFunc progressFunc) {
   monitor->progress_callback2 = progressFunc;
 }
 
+TESS_API void TESS_CALL TessMonitorSetLineFunc(ETEXT_DESC* monitor,
+                                               TessLineFunc lineFunc) {
+  monitor->line_callback = lineFunc;
+}
+
 TESS_API int TESS_CALL TessMonitorGetProgress(ETEXT_DESC* monitor) {
   return monitor->progress;
 }
@@ -24,12 +24,14 @@
 
 #ifdef TESS_CAPI_INCLUDE_BASEAPI
 #  include "baseapi.h"
+#  include "enginepool.h"
 #  include "ocrclass.h"
 #  include "pageiterator.h"
 #  include "renderer.h"
 #  include "resultiterator.h"
 #else
 #  include <stdbool.h>
+#  include <stdint.h>
 #  include <stdio.h>
 #  include "platform.h"
 #endif
@@ -58,12 +60,15 @@ typedef tesseract::TessTextRenderer TessTextRenderer;
 typedef tesseract::TessHOcrRenderer TessHOcrRenderer;
 typedef tesseract::TessAltoRenderer TessAltoRenderer;
 typedef tesseract::TessTsvRenderer TessTsvRenderer;
+typedef tesseract::TessBinaryRenderer TessBinaryRenderer;
 typedef tesseract::TessPDFRenderer TessPDFRenderer;
 typedef tesseract::TessUnlvRenderer TessUnlvRenderer;
 typedef tesseract::TessBoxTextRenderer TessBoxTextRenderer;
 typedef tesseract::TessWordStrBoxRenderer TessWordStrBoxRenderer;
 typedef tesseract::TessLSTMBoxRenderer TessLSTMBoxRenderer;
 typedef tesseract::TessBaseAPI TessBaseAPI;
+typedef tesseract::TessEnginePool TessEnginePool;
+typedef tesseract::ResultArrays TessResultArrays;
 typedef tesseract::PageIterator TessPageIterator;
 typedef tesseract::ResultIterator TessResultIterator;
 typedef tesseract::MutableIterator TessMutableIterator;
@@ -91,6 +96,8 @@ typedef struct TessPDFRenderer TessPDFRenderer;
 typedef struct TessUnlvRenderer TessUnlvRenderer;
 typedef struct TessBoxTextRenderer TessBoxTextRenderer;
 typedef struct TessBaseAPI TessBaseAPI;
+typedef struct TessEnginePool TessEnginePool;
+typedef struct TessResultArrays TessResultArrays;
 typedef struct TessPageIterator TessPageIterator;
 typedef struct TessResultIterator TessResultIterator;
 typedef struct TessMutableIterator TessMutableIterator;
@@ -168,8 +175,12 @@ typedef struct ETEXT_DESC ETEXT_DESC;
 #endif
 
 typedef bool (*TessCancelFunc)(void* cancel_this, int words);
+typedef void (*TessRecognizeCallback)(void* user_data, int status,
+                                      TessResultIterator* it);
 typedef bool (*TessProgressFunc)(ETEXT_DESC* ths, int left, int right, int top,
                                  int bottom);
+typedef void (*TessLineFunc)(ETEXT_DESC* ths, const char* text, int left,
+                             int top, int right, int bottom, float confidence);
 
 struct Pix;
 struct Boxa;
@@ -178,6 +189,7 @@ struct Pixa;
 /* General free functions */
 
 TESS_API const char* TESS_CALL TessVersion();
+TESS_API const char* TESS_CALL TessSIMDKernel();
 TESS_API void TESS_CALL TessDeleteText(const char* text);
 TESS_API void TESS_CALL TessDeleteTextArray(char** arr);
 TESS_API void TESS_CALL TessDeleteIntArray(const int* arr);
@@ -193,6 +205,8 @@ TESS_API TessResultRenderer* TESS_CALL
 TessAltoRendererCreate(const char* outputbase);
 TESS_API TessResultRenderer* TESS_CALL
 TessTsvRendererCreate(const char* outputbase);
+TESS_API TessResultRenderer* TESS_CALL
+TessBinaryRendererCreate(const char* outputbase, BOOL choices);
 TESS_API TessResultRenderer* TESS_CALL TessPDFRendererCreate(
     const char* outputbase, const char* datadir, BOOL textonly);
 TESS_API TessResultRenderer* TESS_CALL
@@ -298,9 +312,32 @@ TESS_API int TESS_CALL TessBaseAPIInit4(
     TessBaseAPI* handle, const char* datapath, const char* language,
     TessOcrEngineMode mode, char** configs, int configs_size, char** vars_vec,
     char** vars_values, size_t vars_vec_size, BOOL set_only_non_debug_params);
+TESS_API int TESS_CALL TessBaseAPIInitLike(TessBaseAPI* handle,
+                                           const TessBaseAPI* source);
 
 TESS_API const char* TESS_CALL
 TessBaseAPIGetInitLanguagesAsString(const TessBaseAPI* handle);
+TESS_API char* TESS_CALL
+TessBaseAPIGetInitProfileText(const TessBaseAPI* handle);
+TESS_API void TESS_CALL TessBaseAPIStartTracing();
+TESS_API void TESS_CALL TessBaseAPIStopTracing();
+TESS_API char* TESS_CALL TessBaseAPIGetTraceJSON();
+TESS_API void TESS_CALL TessBaseAPIStartLayerProfile();
+TESS_API void TESS_CALL TessBaseAPIStopLayerProfile();
+TESS_API char* TESS_CALL TessBaseAPIGetLayerProfileText();
+TESS_API int TESS_CALL TessBaseAPIGetCounters(const TessBaseAPI* handle,
+                                              int64_t* values, int size);
+TESS_API void TESS_CALL TessBaseAPIResetCounters(TessBaseAPI* handle);
+TESS_API int TESS_CALL TessBaseAPIGetProcessCounters(int64_t* values,
+                                                     int size);
+TESS_API const char* TESS_CALL TessBaseAPIGetCounterName(int index);
+TESS_API int TESS_CALL TessBaseAPIGetMemoryUsage(const TessBaseAPI* handle,
+                                                 int64_t* values, int size);
+TESS_API int64_t TESS_CALL
+TessBaseAPIGetPageMemoryHighWater(const TessBaseAPI* handle);
+TESS_API char* TESS_CALL
+TessBaseAPIGetMemoryUsageText(const TessBaseAPI* handle);
+TESS_API const char* TESS_CALL TessBaseAPIGetMemoryCategoryName(int index);
 TESS_API char** TESS_CALL
 TessBaseAPIGetLoadedLanguagesAsVector(const TessBaseAPI* handle);
 TESS_API char** TESS_CALL
@@ -336,6 +373,10 @@ TESS_API void TESS_CALL TessBaseAPISetImage(TessBaseAPI* handle,
                                             int bytes_per_line);
 TESS_API void TESS_CALL TessBaseAPISetImage2(TessBaseAPI* handle,
                                              struct Pix* pix);
+TESS_API void TESS_CALL TessBaseAPISetImageView(TessBaseAPI* handle,
+                                                const unsigned char* imagedata,
+                                                int width, int height,
+                                                int bytes_per_line);
 
 TESS_API void TESS_CALL TessBaseAPISetSourceResolution(TessBaseAPI* handle,
                                                        int ppi);
@@ -381,6 +422,9 @@ TessBaseAPIAnalyseLayout(TessBaseAPI* handle);
 
 TESS_API int TESS_CALL TessBaseAPIRecognize(TessBaseAPI* handle,
                                             ETEXT_DESC* monitor);
+TESS_API void TESS_CALL TessBaseAPISetKeepLayout(TessBaseAPI* handle,
+                                                 BOOL keep_layout);
+TESS_API BOOL TESS_CALL TessBaseAPIHasKeptLayout(const TessBaseAPI* handle);
 
 #ifndef DISABLED_LEGACY_ENGINE
 TESS_API int TESS_CALL TessBaseAPIRecognizeForChopTest(TessBaseAPI* handle,
@@ -421,6 +465,26 @@ TESS_API char* TESS_CALL TessBaseAPIGetWordStrBoxText(TessBaseAPI* handle,
                                                       int page_number);
 
 TESS_API char* TESS_CALL TessBaseAPIGetUNLVText(TessBaseAPI* handle);
+
+// Returns NULL if recognition failed. The arrays point into the returned
+// object, which must be deleted with TessResultArraysDelete.
+TESS_API TessResultArrays* TESS_CALL
+TessBaseAPIGetResultArrays(TessBaseAPI* handle, TessPageIteratorLevel level);
+TESS_API void TESS_CALL TessResultArraysDelete(TessResultArrays* arrays);
+TESS_API int TESS_CALL TessResultArraysSize(const TessResultArrays* arrays);
+// 4 values for each element: left, top, right, bottom.
+TESS_API const int* TESS_CALL
+TessResultArraysBoxes(const TessResultArrays* arrays);
+TESS_API const float* TESS_CALL
+TessResultArraysConfidences(const TessResultArrays* arrays);
+// The text of all the elements, which is not null terminated between them.
+TESS_API const char* TESS_CALL
+TessResultArraysText(const TessResultArrays* arrays);
+// Size + 1 offsets of the text of each element.
+TESS_API const int* TESS_CALL
+TessResultArraysTextOffsets(const TessResultArrays* arrays);
+TESS_API const int* TESS_CALL
+TessResultArraysParents(const TessResultArrays* arrays);
 TESS_API int TESS_CALL TessBaseAPIMeanTextConf(TessBaseAPI* handle);
 
 TESS_API int* TESS_CALL TessBaseAPIAllWordConfidences(TessBaseAPI* handle);
@@ -481,6 +545,34 @@ TESS_API void TESS_CALL TessBaseGetBlockTextOrientations(
 
 #endif
 
+/* Engine pool */
+
+TESS_API TessEnginePool* TESS_CALL TessEnginePoolCreate(const char* datapath,
+                                                         int max_engines);
+TESS_API void TESS_CALL TessEnginePoolDelete(TessEnginePool* pool);
+
+// Returns NULL if no engine can be initialized for the language and variables.
+TESS_API TessBaseAPI* TESS_CALL TessEnginePoolAcquire(
+    TessEnginePool* pool, const char* language, TessOcrEngineMode oem,
+    char** vars_vec, char** vars_values, size_t vars_vec_size);
+TESS_API void TESS_CALL TessEnginePoolRelease(TessEnginePool* pool,
+                                              TessBaseAPI* handle);
+
+// Queues the recognition of a copy of pix, and calls callback, which may be
+// NULL, with user_data on a thread of the pool once it is done. The iterator
+// is NULL on failure, and is only valid during the call. monitor may be NULL.
+TESS_API void TESS_CALL TessEnginePoolRecognizeAsync(
+    TessEnginePool* pool, struct Pix* pix, const char* language,
+    TessOcrEngineMode oem, char** vars_vec, char** vars_values,
+    size_t vars_vec_size, ETEXT_DESC* monitor, TessRecognizeCallback callback,
+    void* user_data);
+
+// Any of the counters may be NULL.
+TESS_API void TESS_CALL TessEnginePoolGetStats(
+    TessEnginePool* pool, int* engines, int* leased, long long* leases,
+    long long* inits, long long* failed_inits, long long* waits,
+    int* queued);
+
 /* Page iterator */
 
 TESS_API void TESS_CALL TessPageIteratorDelete(TessPageIterator* handle);
@@ -582,6 +674,8 @@ TESS_API void TESS_CALL TessMonitorSetCancelThis(ETEXT_DESC* monitor,
 TESS_API void* TESS_CALL TessMonitorGetCancelThis(ETEXT_DESC* monitor);
 TESS_API void TESS_CALL
 TessMonitorSetProgressFunc(ETEXT_DESC* monitor, TessProgressFunc progressFunc);
+TESS_API void TESS_CALL TessMonitorSetLineFunc(ETEXT_DESC* monitor,
+                                               TessLineFunc lineFunc);
 TESS_API int TESS_CALL TessMonitorGetProgress(ETEXT_DESC* monitor);
 TESS_API void TESS_CALL TessMonitorSetDeadlineMSecs(ETEXT_DESC* monitor,
                                                     int deadline);
@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////
+// File:        enginepool.cpp
+// Description: Thread-safe pool of TessBaseAPI engines.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "enginepool.h"
+#if defined(__linux__)
+#include <pthread.h>        // for pthread_setaffinity_np
+#include <sched.h>          // for cpu_set_t
+#endif
+#include <algorithm>        // for std::max, std::sort
+#include "allheaders.h"     // for pixCopy, pixDestroy
+#include "baseapi.h"        // for TessBaseAPI
+#include "dict.h"           // for Dict::GlobalDawgCache
+#include "genericvector.h"
+#include "resultiterator.h" // for ResultIterator
+#include "strngs.h"         // for STRING
+
+namespace tesseract {
+
+// A queued recognition.
+struct TessEnginePool::Task {
+  Pix* pix;
+  std::string language;
+  OcrEngineMode oem;
+  GenericVector<STRING> vars_vec;
+  GenericVector<STRING> vars_values;
+  ETEXT_DESC* monitor;
+  RecognizeCallback callback;
+  std::promise<int> status;
+};
+
+// Returns the key of the profile of an engine: its language, oem and the
+// variables in name order, so that the order they are given in doesn't
+// matter.
+static std::string ProfileKey(const char* language, OcrEngineMode oem,
+                              const GenericVector<STRING>* vars_vec,
+                              const GenericVector<STRING>* vars_values) {
+  std::vector<std::string> vars;
+  if (vars_vec != nullptr && vars_values != nullptr) {
+    for (int i = 0; i < vars_vec->size() && i < vars_values->size(); ++i) {
+      vars.push_back(std::string((*vars_vec)[i].c_str()) + "=" +
+                     (*vars_values)[i].c_str());
+    }
+  }
+  std::sort(vars.begin(), vars.end());
+  std::string key = std::string(language) + "\n" + std::to_string(oem);
+  for (const auto& var : vars) key += "\n" + var;
+  return key;
+}
+
+TessEnginePool::TessEnginePool(const char* datapath, int max_engines)
+    : datapath_(datapath != nullptr ? datapath : ""),
+      max_engines_(std::max(max_engines, 1)) {
+  // Create the DawgCache before any engine, so that it is destroyed after
+  // the engines, even if the pool is a static object.
+  Dict::GlobalDawgCache();
+}
+
+TessEnginePool::~TessEnginePool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_all();
+  for (auto& thread : threads_) thread.join();
+  for (Engine* engine : engines_) {
+    delete engine->api;
+    delete engine;
+  }
+}
+
+TessBaseAPI* TessEnginePool::Acquire(const char* language, OcrEngineMode oem,
+                                     const GenericVector<STRING>* vars_vec,
+                                     const GenericVector<STRING>* vars_values) {
+  if (language == nullptr) language = "eng";
+  std::string profile = ProfileKey(language, oem, vars_vec, vars_values);
+  Engine* engine = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool waited = false;
+    while (engine == nullptr) {
+      Engine* other = nullptr;
+      for (Engine* idle : engines_) {
+        if (idle->leased) continue;
+        if (idle->profile == profile) {
+          idle->leased = true;
+          ++stats_.leases;
+          return idle->api;
+        }
+        if (other == nullptr) other = idle;
+      }
+      if (static_cast<int>(engines_.size()) < max_engines_) {
+        engine = new Engine{new TessBaseAPI, std::string(), true};
+        engines_.push_back(engine);
+      } else if (other != nullptr) {
+        engine = other;
+        engine->leased = true;
+      } else {
+        if (!waited) ++stats_.waits;
+        waited = true;
+        released_.wait(lock);
+      }
+    }
+  }
+  // Loading the models takes a while, so the others go on meanwhile.
+  bool ok = InitEngine(engine, profile, language, oem, vars_vec, vars_values);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (ok) {
+    ++stats_.inits;
+    ++stats_.leases;
+    return engine->api;
+  }
+  ++stats_.failed_inits;
+  engine->leased = false;
+  released_.notify_one();
+  return nullptr;
+}
+
+bool TessEnginePool::InitEngine(Engine* engine, const std::string& profile,
+                                const char* language, OcrEngineMode oem,
+                                const GenericVector<STRING>* vars_vec,
+                                const GenericVector<STRING>* vars_values) {
+  // Init keeps the variables of an engine that has the same language, so
+  // start again from the defaults.
+  engine->profile.clear();
+  engine->api->End();
+  if (engine->api->Init(datapath_.c_str(), language, oem, nullptr, 0,
+                        vars_vec, vars_values, false) != 0) {
+    engine->api->End();
+    return false;
+  }
+  engine->profile = profile;
+  return true;
+}
+
+void TessEnginePool::Release(TessBaseAPI* api) {
+  if (api == nullptr) return;
+  // The engine is still leased, so nobody else touches it.
+  api->Clear();
+#ifndef DISABLED_LEGACY_ENGINE
+  api->ClearAdaptiveClassifier();
+#endif  // ndef DISABLED_LEGACY_ENGINE
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Engine* engine : engines_) {
+      if (engine->api == api) {
+        engine->leased = false;
+        break;
+      }
+    }
+  }
+  released_.notify_one();
+}
+
+std::future<int> TessEnginePool::RecognizeAsync(
+    Pix* pix, const char* language, OcrEngineMode oem,
+    const GenericVector<STRING>* vars_vec,
+    const GenericVector<STRING>* vars_values, ETEXT_DESC* monitor,
+    RecognizeCallback callback) {
+  auto* task = new Task;
+  // Leptonica counts the references to a pix without a lock, so the task
+  // can't share the pix of the caller, who may destroy it at any time.
+  task->pix = pix != nullptr ? pixCopy(nullptr, pix) : nullptr;
+  task->language = language != nullptr ? language : "eng";
+  task->oem = oem;
+  if (vars_vec != nullptr && vars_values != nullptr) {
+    task->vars_vec = *vars_vec;
+    task->vars_values = *vars_values;
+  }
+  task->monitor = monitor;
+  task->callback = std::move(callback);
+  std::future<int> status = task->status.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(task);
+    if (threads_.empty()) {
+      for (int i = 0; i < max_engines_; ++i)
+        threads_.push_back(std::thread(&TessEnginePool::RunTasks, this, i));
+    }
+  }
+  queued_.notify_one();
+  return status;
+}
+
+bool TessEnginePool::SetNodeCpus(
+    const std::vector<std::vector<int>>& node_cpus) {
+#if defined(__linux__)
+  for (const auto& cpus : node_cpus) {
+    if (cpus.empty()) return false;
+    for (int cpu : cpus) {
+      if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!threads_.empty()) return false;
+  node_cpus_ = node_cpus;
+  return true;
+#else
+  return node_cpus.empty();
+#endif
+}
+
+// Pins the calling thread to the given CPUs.
+static void PinThread(const std::vector<int>& cpus) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) CPU_SET(cpu, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
+
+void TessEnginePool::RunTasks(int thread_index) {
+  // node_cpus_ is fixed once the threads are started.
+  int node = -1;
+  if (!node_cpus_.empty()) {
+    node = thread_index % node_cpus_.size();
+    // Pinned before any engine is initialized here, so that the memory that
+    // the engines touch first is allocated on the node.
+    PinThread(node_cpus_[node]);
+  }
+  for (;;) {
+    Task* task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queued_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      // Finish the queue before stopping.
+      if (tasks_.empty()) return;
+      task = tasks_.front();
+      tasks_.pop_front();
+    }
+    int status = -1;
+    ResultIterator* it = nullptr;
+    TessBaseAPI* api = nullptr;
+    if (task->pix != nullptr) {
+      if (node >= 0) {
+        // The replica is part of the profile, so the engines of each node
+        // are only leased to the threads of that node.
+        task->vars_vec.push_back("lstm_network_replica");
+        task->vars_values.push_back(STRING());
+        task->vars_values.back().add_str_int("", node);
+      }
+      api = Acquire(task->language.c_str(), task->oem, &task->vars_vec,
+                    &task->vars_values);
+    }
+    if (api != nullptr) {
+      api->SetImage(task->pix);
+      status = api->Recognize(task->monitor);
+      if (status == 0) it = api->GetIterator();
+    }
+    if (task->callback) task->callback(status, it);
+    delete it;
+    Release(api);
+    pixDestroy(&task->pix);
+    task->status.set_value(status);
+    delete task;
+  }
+}
+
+EnginePoolStats TessEnginePool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EnginePoolStats stats = stats_;
+  stats.engines = engines_.size();
+  stats.queued = tasks_.size();
+  stats.leased = 0;
+  for (const Engine* engine : engines_) {
+    if (engine->leased) ++stats.leased;
+  }
+  return stats;
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////
+// File:        enginepool.h
+// Description: Thread-safe pool of TessBaseAPI engines.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_API_ENGINEPOOL_H_
+#define TESSERACT_API_ENGINEPOOL_H_
+
+#include <condition_variable>  // for std::condition_variable
+#include <cstdint>             // for int64_t
+#include <deque>               // for std::deque
+#include <functional>          // for std::function
+#include <future>              // for std::future
+#include <mutex>               // for std::mutex
+#include <string>              // for std::string
+#include <thread>              // for std::thread
+#include <vector>              // for std::vector
+#include "platform.h"
+#include "publictypes.h"       // for OcrEngineMode
+
+class ETEXT_DESC;
+class STRING;
+struct Pix;
+template <typename T> class GenericVector;
+
+namespace tesseract {
+
+class ResultIterator;
+class TessBaseAPI;
+
+// Counters of a TessEnginePool.
+struct EnginePoolStats {
+  int engines = 0;           // Engines in the pool, idle or leased.
+  int leased = 0;            // Engines leased out now.
+  int64_t leases = 0;        // Leases handed out.
+  int64_t inits = 0;         // Engines initialized for a profile.
+  int64_t failed_inits = 0;  // Initializations that failed.
+  int64_t waits = 0;         // Leases that had to wait for an engine.
+  int queued = 0;            // Async recognitions not yet started.
+};
+
+/**
+ * Pool of up to max_engines TessBaseAPI engines with the tessdata of one
+ * datapath, from which any thread can lease an engine initialized for a
+ * profile: a language, an OcrEngineMode and the values of some variables.
+ * Engines are only initialized when a lease needs them: an idle engine with
+ * the same profile is preferred, then a new engine while the pool is not
+ * full, then an idle engine that is initialized again for the new profile.
+ * When all engines are leased, Acquire waits for one to be released.
+ *
+ * The engines share their dawgs and LSTM networks through the global caches.
+ * The variables of a profile must be member params of the engine: global
+ * params, such as dotproduct, would change all the engines of the process.
+ * An engine must be released with the variables of its profile.
+ *
+ * RecognizeAsync queues a page for recognition on a thread of the pool, of
+ * which there are max_engines, started on the first call, so a few threads
+ * serve any number of requests.
+ *
+ * On hosts with several NUMA nodes, SetNodeCpus can pin the threads of the
+ * pool to the CPUs of each node in turn. The engines of the threads of each
+ * node are then initialized on that node, with their own copy of the LSTM
+ * network (see lstm_network_replica), so their weights are in local memory.
+ */
+class TESS_API TessEnginePool {
+ public:
+  // All the engines must be released before the pool is deleted.
+  TessEnginePool(const char* datapath, int max_engines);
+  ~TessEnginePool();
+
+  /**
+   * Leases an engine initialized for language and oem, with the given
+   * variables (which may be nullptr) set, waiting for one if they are all
+   * leased. Returns nullptr if the engine can't be initialized.
+   */
+  TessBaseAPI* Acquire(const char* language, OcrEngineMode oem,
+                       const GenericVector<STRING>* vars_vec,
+                       const GenericVector<STRING>* vars_values);
+  // Returns a leased engine to the pool, clearing its results and the
+  // adaptations of its classifier to the pages it recognized.
+  void Release(TessBaseAPI* api);
+
+  /**
+   * Called on a thread of the pool with the result of Recognize (0 on
+   * success, -1 if the engine can't be initialized or recognition failed)
+   * and an iterator over the results, which is nullptr on failure. The
+   * iterator and the engine it points to are only valid during the call.
+   */
+  using RecognizeCallback = std::function<void(int status, ResultIterator* it)>;
+
+  /**
+   * Queues the recognition of a copy of pix on an engine leased as by
+   * Acquire, and returns a future that gets the status once the callback,
+   * which may be empty, has returned. monitor, which may be nullptr, reports
+   * the progress and may cancel the recognition, so it must outlive it.
+   * Queued recognitions are all done before the pool is deleted.
+   */
+  std::future<int> RecognizeAsync(Pix* pix, const char* language,
+                                  OcrEngineMode oem,
+                                  const GenericVector<STRING>* vars_vec,
+                                  const GenericVector<STRING>* vars_values,
+                                  ETEXT_DESC* monitor,
+                                  RecognizeCallback callback);
+
+  /**
+   * Pins the threads of RecognizeAsync to the given sets of CPUs, thread i
+   * to node_cpus[i % node_cpus.size()], and gives the engines that they use
+   * the lstm_network_replica of their set. Each set is normally the CPUs of
+   * a NUMA node. Only works on Linux, and must be called before the first
+   * RecognizeAsync. Returns false if it can't be done.
+   */
+  bool SetNodeCpus(const std::vector<std::vector<int>>& node_cpus);
+
+  EnginePoolStats GetStats() const;
+  int max_engines() const {
+    return max_engines_;
+  }
+
+ private:
+  struct Task;
+  struct Engine {
+    TessBaseAPI* api;
+    std::string profile;  // Language, oem and variables of the last Init.
+    bool leased;
+  };
+
+  // Initializes engine for the given profile, without the lock.
+  bool InitEngine(Engine* engine, const std::string& profile,
+                  const char* language, OcrEngineMode oem,
+                  const GenericVector<STRING>* vars_vec,
+                  const GenericVector<STRING>* vars_values);
+  // Runs the queued recognitions until the pool is deleted, on the node of
+  // node_cpus_ given by thread_index, if any.
+  void RunTasks(int thread_index);
+
+  std::string datapath_;
+  int max_engines_;
+  // Engines are owned by the pool, and not moved once created, so a lease
+  // may hold on to its Engine without the lock.
+  std::vector<Engine*> engines_;
+  EnginePoolStats stats_;
+  std::deque<Task*> tasks_;
+  std::vector<std::thread> threads_;
+  // See SetNodeCpus.
+  std::vector<std::vector<int>> node_cpus_;
+  bool stop_ = false;
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  std::condition_variable queued_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_API_ENGINEPOOL_H_
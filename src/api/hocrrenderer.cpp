@@ -19,6 +19,7 @@
 
 #include <locale>     // for std::locale::classic
 #include <memory>     // for std::unique_ptr
+#include <ostream>    // for std::ostream
 #include <sstream>    // for std::stringstream
 #include "baseapi.h"  // for TessBaseAPI
 #ifdef _WIN32
@@ -52,7 +53,7 @@ static tesseract::Orientation GetBlockTextOrientation(const PageIterator* it) {
  */
 static void AddBaselineCoordsTohOCR(const PageIterator* it,
                                     PageIteratorLevel level,
-                                    std::stringstream& hocr_str) {
+                                    std::ostream& hocr_str) {
   tesseract::Orientation orientation = GetBlockTextOrientation(it);
   if (orientation != ORIENTATION_PAGE_UP) {
     hocr_str << "; textangle " << 360 - orientation * 90;
@@ -87,7 +88,7 @@ static void AddBaselineCoordsTohOCR(const PageIterator* it,
 }
 
 static void AddBoxTohOCR(const ResultIterator* it, PageIteratorLevel level,
-                         std::stringstream& hocr_str) {
+                         std::ostream& hocr_str) {
   int left, top, right, bottom;
   it->BoundingBox(level, &left, &top, &right, &bottom);
   // This is the only place we use double quotes instead of single quotes,
@@ -130,8 +131,23 @@ char* TessBaseAPI::GetHOCRText(int page_number) {
  * Returned string must be freed with the delete [] operator.
  */
 char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
+  std::stringstream hocr_str;
+  if (!GetHOCRText(monitor, page_number, hocr_str)) return nullptr;
+
+  const std::string& text = hocr_str.str();
+  char* result = new char[text.length() + 1];
+  strcpy(result, text.c_str());
+  return result;
+}
+
+/**
+ * Write the hOCR markup of the page to hocr_str while walking the results,
+ * so that the renderer doesn't need a copy of the whole page.
+ */
+bool TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number,
+                              std::ostream& hocr_str) {
   if (tesseract_ == nullptr || (page_res_ == nullptr && Recognize(monitor) < 0))
-    return nullptr;
+    return false;
 
   int lcnt = 1, bcnt = 1, pcnt = 1, wcnt = 1, scnt = 1, tcnt = 1, gcnt = 1;
   int page_id = page_number + 1;  // hOCR uses 1-based page numbers.
@@ -161,11 +177,10 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   delete[] utf8_str;
 #endif
 
-  std::stringstream hocr_str;
   // Use "C" locale (needed for double values x_size and x_descenders).
-  hocr_str.imbue(std::locale::classic());
+  const std::locale locale = hocr_str.imbue(std::locale::classic());
   // Use 8 digits for double values.
-  hocr_str.precision(8);
+  const std::streamsize precision = hocr_str.precision(8);
   hocr_str << "  <div class='ocr_page'";
   hocr_str << " id='"
            << "page_" << page_id << "'";
@@ -391,10 +406,9 @@ char* TessBaseAPI::GetHOCRText(ETEXT_DESC* monitor, int page_number) {
   }
   hocr_str << "  </div>\n";
 
-  const std::string& text = hocr_str.str();
-  char* result = new char[text.length() + 1];
-  strcpy(result, text.c_str());
-  return result;
+  hocr_str.precision(precision);
+  hocr_str.imbue(locale);
+  return true;
 }
 
 /**********************************************************************
@@ -442,12 +456,7 @@ bool TessHOcrRenderer::EndDocumentHandler() {
 }
 
 bool TessHOcrRenderer::AddImageHandler(TessBaseAPI* api) {
-  const std::unique_ptr<const char[]> hocr(api->GetHOCRText(imagenum()));
-  if (hocr == nullptr) return false;
-
-  AppendString(hocr.get());
-
-  return true;
+  return api->GetHOCRText(nullptr, imagenum(), output()) && happy();
 }
 
 }  // namespace tesseract
@@ -23,6 +23,8 @@
 #include <locale>  // for std::locale::classic
 #include <memory>  // std::unique_ptr
 #include <sstream> // for std::stringstream
+#include <string>  // for std::string
+#include <thread>  // for std::thread
 #include "allheaders.h"
 #include "baseapi.h"
 #include <cmath>
@@ -176,15 +178,44 @@ static const int kMaxBytesPerCodepoint = 20;
 /**********************************************************************
  * PDF Renderer interface implementation
  **********************************************************************/
+
+// The image object of a page, and the thread that encodes it.
+struct TessPDFRenderer::ImageJob {
+  Pix* pix = nullptr;        // Owned copy of the page image.
+  bool has_filename = false;
+  std::string filename;
+  long int objnum = 0;
+  int jpg_quality = 0;
+  char* pdf_object = nullptr;
+  long int pdf_object_size = 0;
+  bool ok = false;
+  std::thread thread;
+
+  ~ImageJob() {
+    if (thread.joinable()) thread.join();
+    delete[] pdf_object;
+    pixDestroy(&pix);
+  }
+  void Encode() {
+    ok = imageToPDFObj(pix, has_filename ? filename.c_str() : nullptr, objnum,
+                       &pdf_object, &pdf_object_size, jpg_quality);
+  }
+};
+
 TessPDFRenderer::TessPDFRenderer(const char *outputbase, const char *datadir,
                                  bool textonly)
     : TessResultRenderer(outputbase, "pdf"),
-      datadir_(datadir) {
+      datadir_(datadir),
+      image_job_(nullptr) {
   obj_  = 0;
   textonly_ = textonly;
   offsets_.push_back(0);
 }
 
+TessPDFRenderer::~TessPDFRenderer() {
+  delete image_job_;
+}
+
 void TessPDFRenderer::AppendPDFObjectDIY(size_t objectsize) {
   offsets_.push_back(objectsize + offsets_.back());
   obj_++;
@@ -781,7 +812,22 @@ bool TessPDFRenderer::imageToPDFObj(Pix *pix,
   return true;
 }
 
+bool TessPDFRenderer::FinishImage() {
+  if (image_job_ == nullptr) return true;
+  if (image_job_->thread.joinable()) image_job_->thread.join();
+  bool ok = image_job_->ok;
+  if (ok) {
+    AppendData(image_job_->pdf_object, image_job_->pdf_object_size);
+    AppendPDFObjectDIY(image_job_->pdf_object_size);
+  }
+  delete image_job_;
+  image_job_ = nullptr;
+  return ok;
+}
+
 bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
+  // The image of the last page comes before the objects of this one.
+  bool ok = FinishImage();
   Pix *pix = api->GetInputImage();
   const char* filename = api->GetInputName();
   int ppi = api->GetSourceYResolution();
@@ -845,18 +891,23 @@ bool TessPDFRenderer::AddImageHandler(TessBaseAPI* api) {
   AppendPDFObjectDIY(objsize);
 
   if (!textonly_) {
-    char *pdf_object = nullptr;
-    int jpg_quality;
-    api->GetIntVariable("jpg_quality", &jpg_quality);
-    if (!imageToPDFObj(pix, filename, obj_, &pdf_object, &objsize,
-                       jpg_quality)) {
-      return false;
+    bool background = false;
+    api->GetBoolVariable("pdf_background_images", &background);
+    image_job_ = new ImageJob;
+    // Leptonica counts the references to a pix without a lock, so the
+    // thread needs a copy of its own.
+    image_job_->pix = background ? pixCopy(nullptr, pix) : pixClone(pix);
+    image_job_->has_filename = filename != nullptr;
+    if (filename != nullptr) image_job_->filename = filename;
+    image_job_->objnum = obj_;
+    api->GetIntVariable("jpg_quality", &image_job_->jpg_quality);
+    if (!background) {
+      image_job_->Encode();
+      return FinishImage() && ok;
     }
-    AppendData(pdf_object, objsize);
-    AppendPDFObjectDIY(objsize);
-    delete[] pdf_object;
+    image_job_->thread = std::thread(&ImageJob::Encode, image_job_);
   }
-  return true;
+  return ok;
 }
 
 
@@ -868,6 +919,8 @@ bool TessPDFRenderer::EndDocumentHandler() {
   // out of order in the file.
 
   // PAGES
+  // The image of the last page is the last object before the /Pages.
+  bool ok = FinishImage();
   const long int kPagesObjectNumber = 2;
   offsets_[kPagesObjectNumber] = offsets_.back();  // manipulation #1
   std::stringstream stream;
@@ -925,6 +978,6 @@ bool TessPDFRenderer::EndDocumentHandler() {
     "  /Info " << (obj_ - 1) << " 0 R\n" // info
     ">>\nstartxref\n" << offsets_.back() << "\n%%EOF\n";
   AppendString(stream.str().c_str());
-  return true;
+  return ok;
 }
 }  // namespace tesseract
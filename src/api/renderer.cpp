@@ -20,23 +20,57 @@
 #endif
 
 #include <cstring>
-#include <memory>  // std::unique_ptr
+#include <locale>     // for std::locale::classic
+#include <memory>     // std::unique_ptr
+#include <ostream>    // for std::ostream
+#include <streambuf>  // for std::streambuf
+#include <thread>     // for std::thread
+#include <vector>     // for std::vector
 #include "baseapi.h"
 #include "genericvector.h"
 #include "renderer.h"
+#include "tracing.h"
 
 namespace tesseract {
 
 /**********************************************************************
  * Base Renderer interface implementation
  **********************************************************************/
+
+// Passes everything written to output() on to AppendData without a buffer
+// of its own, so it keeps its order with AppendString. The output file is
+// buffered anyway.
+class TessResultRenderer::OutputBuffer : public std::streambuf {
+ public:
+  explicit OutputBuffer(TessResultRenderer* renderer) : renderer_(renderer) {}
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (traits_type::eq_int_type(c, traits_type::eof())) {
+      return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    renderer_->AppendData(&ch, 1);
+    return renderer_->happy_ ? c : traits_type::eof();
+  }
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    renderer_->AppendData(s, static_cast<int>(n));
+    return renderer_->happy_ ? n : 0;
+  }
+
+ private:
+  TessResultRenderer* renderer_;
+};
+
 TessResultRenderer::TessResultRenderer(const char *outputbase,
                                        const char* extension)
     : file_extension_(extension),
-      title_(""), imagenum_(-1),
+      title_(""), imagenum_(-1), first_page_(0),
       fout_(stdout),
       next_(nullptr),
-      happy_(true) {
+      happy_(true),
+      output_buffer_(nullptr),
+      output_(nullptr) {
   if (strcmp(outputbase, "-") && strcmp(outputbase, "stdout")) {
     STRING outfile = STRING(outputbase) + STRING(".") + STRING(file_extension_);
     fout_ = fopen(outfile.string(), "wb");
@@ -47,6 +81,8 @@ TessResultRenderer::TessResultRenderer(const char *outputbase,
 }
 
 TessResultRenderer::~TessResultRenderer() {
+  delete output_;
+  delete output_buffer_;
   if (fout_ != nullptr) {
     if (fout_ != stdout)
       fclose(fout_);
@@ -72,7 +108,7 @@ void TessResultRenderer::insert(TessResultRenderer* next) {
 bool TessResultRenderer::BeginDocument(const char* title) {
   if (!happy_) return false;
   title_ = title;
-  imagenum_ = -1;
+  imagenum_ = first_page_ - 1;
   bool ok = BeginDocumentHandler();
   if (next_) {
     ok = next_->BeginDocument(title) && ok;
@@ -80,12 +116,56 @@ bool TessResultRenderer::BeginDocument(const char* title) {
   return ok;
 }
 
+void TessResultRenderer::SetFirstPage(int page) {
+  for (TessResultRenderer* renderer = this; renderer != nullptr;
+       renderer = renderer->next_) {
+    renderer->first_page_ = page;
+  }
+}
+
 bool TessResultRenderer::AddImage(TessBaseAPI* api) {
-  if (!happy_) return false;
-  ++imagenum_;
-  bool ok = AddImageHandler(api);
-  if (next_) {
-    ok = next_->AddImage(api) && ok;
+  TraceSpan span("TessResultRenderer::AddImage");
+  int num_threads = 1;
+  api->GetIntVariable("renderer_threads", &num_threads);
+  if (num_threads > 1 && next_ != nullptr &&
+      !api->PrepareResultsForReading()) {
+    num_threads = 1;
+  }
+  bool ok = true;
+  TessResultRenderer* renderer = this;
+  while (renderer != nullptr) {
+    if (!renderer->happy_) return false;
+    // The renderers that only read the results and don't share stdout
+    // with each other run together, the others one at a time.
+    std::vector<TessResultRenderer*> batch;
+    while (renderer != nullptr && renderer->happy_ &&
+           static_cast<int>(batch.size()) < num_threads &&
+           renderer->ReadsResultsOnly() && renderer->fout_ != stdout) {
+      batch.push_back(renderer);
+      renderer = renderer->next_;
+    }
+    if (batch.size() < 2) {
+      if (batch.empty()) {
+        batch.push_back(renderer);
+        renderer = renderer->next_;
+      }
+      ++batch[0]->imagenum_;
+      ok = batch[0]->AddImageHandler(api) && ok;
+      continue;
+    }
+    std::vector<char> results(batch.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      ++batch[i]->imagenum_;
+      if (i > 0) {
+        threads.push_back(std::thread([&batch, &results, api, i]() {
+          results[i] = batch[i]->AddImageHandler(api);
+        }));
+      }
+    }
+    results[0] = batch[0]->AddImageHandler(api);
+    for (auto& thread : threads) thread.join();
+    for (char result : results) ok = result && ok;
   }
   return ok;
 }
@@ -107,6 +187,15 @@ void TessResultRenderer::AppendData(const char* s, int len) {
   if (!tesseract::Serialize(fout_, s, len)) happy_ = false;
 }
 
+std::ostream& TessResultRenderer::output() {
+  if (output_ == nullptr) {
+    output_buffer_ = new OutputBuffer(this);
+    output_ = new std::ostream(output_buffer_);
+    output_->imbue(std::locale::classic());
+  }
+  return *output_;
+}
+
 bool TessResultRenderer::BeginDocumentHandler() {
   return happy_;
 }
@@ -163,12 +252,7 @@ bool TessTsvRenderer::BeginDocumentHandler() {
 bool TessTsvRenderer::EndDocumentHandler() { return true; }
 
 bool TessTsvRenderer::AddImageHandler(TessBaseAPI* api) {
-  const std::unique_ptr<const char[]> tsv(api->GetTSVText(imagenum()));
-  if (tsv == nullptr) return false;
-
-  AppendString(tsv.get());
-
-  return true;
+  return api->GetTSVText(imagenum(), output()) && happy();
 }
 
 /**********************************************************************
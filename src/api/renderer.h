@@ -21,6 +21,7 @@
 // To avoid collision with other typenames include the ABSOLUTE MINIMUM
 // complexity of includes here. Use forward declarations wherever possible
 // and hide includes of complex types in baseapi.cpp.
+#include <iosfwd>  // for std::ostream
 #include <string>  // for std::string
 #include "genericvector.h"
 #include "platform.h"
@@ -72,6 +73,9 @@ class TESS_API TessResultRenderer {
    * Note that this API is a bit weird but is designed to fit into the
    * current TessBaseAPI implementation where the api has lots of state
    * information that we might want to add in.
+   *
+   * If renderer_threads is more than 1, the renderers of the chain whose
+   * handlers only read the results write the page concurrently.
    */
   bool AddImage(TessBaseAPI* api);
 
@@ -81,6 +85,13 @@ class TESS_API TessResultRenderer {
    */
   bool EndDocument();
 
+  /**
+   * Numbers the images of the documents begun after this from page instead
+   * of 0, for a document made of the pages from page on of a bigger one,
+   * so that its output numbers the pages as the output of the whole would.
+   */
+  void SetFirstPage(int page);
+
   const char* file_extension() const {
     return file_extension_;
   }
@@ -125,6 +136,13 @@ class TESS_API TessResultRenderer {
   // This must be overridden to render the OCR'd results
   virtual bool AddImageHandler(TessBaseAPI* api) = 0;
 
+  // Returns true if AddImageHandler only reads the results of the api after
+  // TessBaseAPI::PrepareResultsForReading, so that it may run at the same
+  // time as the handlers of other renderers of the chain.
+  virtual bool ReadsResultsOnly() const {
+    return false;
+  }
+
   // Hook for specialized handling in EndDocument()
   virtual bool EndDocumentHandler();
 
@@ -139,14 +157,24 @@ class TESS_API TessResultRenderer {
   // This method will grow the output buffer if needed.
   void AppendData(const char* s, int len);
 
+  // Renderers can write to this stream to append their output as it is
+  // made, as AppendData does, instead of building it in memory first.
+  // The stream uses the "C" locale.
+  std::ostream& output();
+
  private:
+  class OutputBuffer;  // std::streambuf that writes through AppendData.
+
   const char* file_extension_;  // standard extension for generated output
   STRING title_;                // title of document being renderered
   int imagenum_;                // index of last image added
+  int first_page_;              // index of the first image of a document
 
   FILE* fout_;                // output file pointer
   TessResultRenderer* next_;  // Can link multiple renderers together
   bool happy_;                // I get grumpy when the disk fills up, etc.
+  OutputBuffer* output_buffer_;  // Created by the first call of output().
+  std::ostream* output_;
 };
 
 /**
@@ -158,6 +186,7 @@ class TESS_API TessTextRenderer : public TessResultRenderer {
 
  protected:
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
 };
 
 /**
@@ -171,6 +200,7 @@ class TESS_API TessHOcrRenderer : public TessResultRenderer {
  protected:
   bool BeginDocumentHandler() override;
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
   bool EndDocumentHandler() override;
 
  private:
@@ -187,6 +217,7 @@ class TESS_API TessAltoRenderer : public TessResultRenderer {
  protected:
   bool BeginDocumentHandler() override;
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
   bool EndDocumentHandler() override;
 };
 
@@ -201,12 +232,62 @@ class TESS_API TessTsvRenderer : public TessResultRenderer {
  protected:
   bool BeginDocumentHandler() override;
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
   bool EndDocumentHandler() override;
 
  private:
   bool font_info_;  // whether to print font information
 };
 
+/**
+ * Records of the tbr binary result format, in which each record is a tag
+ * byte followed by its fields. Integers are 32 bit little-endian, floats are
+ * 32 bit IEEE little-endian, boxes are left, top, right, bottom in image
+ * coordinates, and strings are an integer length and that many bytes of
+ * UTF-8. Each record belongs to the last record of the enclosing level, so
+ * a word belongs to the last line, and the text of a word is that of its
+ * symbols. A document starts with the 4 bytes "TBR" kTbrVersion, and has
+ * the records of each page.
+ */
+enum TbrRecord {
+  kTbrPage = 1,      // int page number (0-based), box of the rectangle.
+  kTbrBlock = 2,     // byte PolyBlockType, box.
+  kTbrPara = 3,      // byte 1 if left-to-right else 0, box.
+  kTbrLine = 4,      // box, byte 1 if it has a baseline else 0, baseline
+                     // x1, y1, x2, y2, float row height, descenders and
+                     // ascenders.
+  kTbrWord = 5,      // box, float confidence, byte flags of kTbrWordFlags.
+  kTbrSymbol = 6,    // box, float confidence, string text.
+  kTbrChoice = 7,    // float confidence, string text of a choice of the
+                     // last symbol.
+  kTbrEndPage = 8,   // No fields.
+};
+// Version of the tbr format, which follows the "TBR" of a document.
+const char kTbrVersion = 1;
+// Flags of a kTbrWord.
+enum TbrWordFlags {
+  kTbrFromDictionary = 1,
+  kTbrNumeric = 2,
+};
+
+/**
+ * Renders tesseract output into the tbr binary result format, which
+ * downstream code can read without parsing text. The LSTM only has choices
+ * for the symbols if lstm_choice_mode is set.
+ */
+class TESS_API TessBinaryRenderer : public TessResultRenderer {
+ public:
+  explicit TessBinaryRenderer(const char* outputbase, bool choices = false);
+
+ protected:
+  bool BeginDocumentHandler() override;
+  bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
+
+ private:
+  bool choices_;  // whether to add the choices of each symbol
+};
+
 /**
  * Renders tesseract output into searchable PDF
  */
@@ -216,10 +297,12 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   // we load a custom PDF font from this location.
   TessPDFRenderer(const char* outputbase, const char* datadir,
                   bool textonly = false);
+  ~TessPDFRenderer() override;
 
  protected:
   bool BeginDocumentHandler() override;
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
   bool EndDocumentHandler() override;
 
  private:
@@ -233,6 +316,14 @@ class TESS_API TessPDFRenderer : public TessResultRenderer {
   GenericVector<long int> pages_;    // object number for every /Page object
   std::string datadir_;              // where to find the custom font
   bool textonly_;                    // skip images if set
+  // The image of the last page, which is encoded on another thread while
+  // the next page is recognized if pdf_background_images is set, and
+  // written before the objects of the next page.
+  struct ImageJob;
+  ImageJob* image_job_;
+  // Waits for the image of the last page and writes its object.
+  // Returns false if it couldn't be encoded.
+  bool FinishImage();
   // Bookkeeping only. DIY = Do It Yourself.
   void AppendPDFObjectDIY(size_t objectsize);
   // Bookkeeping + emit data.
@@ -254,6 +345,7 @@ class TESS_API TessUnlvRenderer : public TessResultRenderer {
 
  protected:
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
 };
 
 /**
@@ -265,6 +357,7 @@ class TESS_API TessLSTMBoxRenderer : public TessResultRenderer {
 
  protected:
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
 };
 
 /**
@@ -276,6 +369,7 @@ class TESS_API TessBoxTextRenderer : public TessResultRenderer {
 
  protected:
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
 };
 
 /**
@@ -287,6 +381,7 @@ class TESS_API TessWordStrBoxRenderer : public TessResultRenderer {
 
  protected:
   bool AddImageHandler(TessBaseAPI* api) override;
+  bool ReadsResultsOnly() const override { return true; }
 };
 
 #ifndef DISABLED_LEGACY_ENGINE
@@ -22,11 +22,19 @@
 #endif
 
 #include <cerrno>               // for errno
+#include <condition_variable>   // for std::condition_variable
+#include <deque>                // for std::deque
 #include <iostream>
+#include <mutex>                // for std::mutex
+#include <sstream>              // for std::istringstream
+#include <string>               // for std::string, std::getline
+#include <thread>               // for std::thread
+#include <vector>               // for std::vector
 
 #include "allheaders.h"
 #include "baseapi.h"
 #include "dict.h"
+#include "enginepool.h"         // for TessEnginePool
 #if defined(USE_OPENCL)
 #include "openclwrapper.h"      // for OpenclDevice
 #endif
@@ -121,6 +129,8 @@ static void PrintVersionInfo() {
   if (tesseract::SIMDDetect::IsAVX2Available()) printf(" Found AVX2\n");
   if (tesseract::SIMDDetect::IsAVXAvailable()) printf(" Found AVX\n");
   if (tesseract::SIMDDetect::IsSSEAvailable()) printf(" Found SSE\n");
+  if (tesseract::SIMDDetect::IsNEONAvailable()) printf(" Found NEON\n");
+  printf(" Selected dotproduct=%s\n", tesseract::SIMDDetect::KernelName());
 #ifdef _OPENMP
   printf(" Found OpenMP %d\n", _OPENMP);
 #endif
@@ -186,6 +196,7 @@ static void PrintHelpExtra(const char* program) {
       "--version\n"
       "  %s --list-langs [--tessdata-dir PATH]\n"
       "  %s --print-parameters [options...] [configfile...]\n"
+      "  %s --print-init-profile [options...] [configfile...]\n"
       "  %s imagename|imagelist|stdin outputbase|stdout [options...] [configfile...]\n"
       "\n"
       "OCR options:\n"
@@ -200,9 +211,14 @@ static void PrintHelpExtra(const char* program) {
 #ifndef DISABLED_LEGACY_ENGINE
       "  --oem NUM             Specify OCR Engine mode.\n"
 #endif
+      "  --jobs NUM            Recognize NUM pages of a document at once.\n"
+      "  --trace FILE          Write the time of each stage to FILE as a Chrome\n"
+      "                        trace.\n"
+      "  --serve NUM           Keep NUM engines loaded and recognize the jobs\n"
+      "                        read from stdin, NUM at once (see below).\n"
       "NOTE: These options must occur before any configfile.\n"
       "\n",
-      program, program, program, program
+      program, program, program, program, program
   );
 
   PrintHelpForPSM();
@@ -223,6 +239,15 @@ static void PrintHelpExtra(const char* program) {
       "  -v, --version         Show version information.\n"
       "  --list-langs          List available languages for tesseract engine.\n"
       "  --print-parameters    Print tesseract parameters.\n"
+      "  --print-init-profile  Print the time and memory taken by initialization.\n"
+      "\n"
+      "Serve mode:\n"
+      "  Each line of stdin is a job, with the words\n"
+      "    [-l LANG] [--psm NUM] [-c VAR=VALUE]... imagename outputbase [format...]\n"
+      "  where format is txt, hocr, tsv, pdf, alto, lstmbox, wordstrbox or\n"
+      "  makebox, and the options default to those of the command line. When a\n"
+      "  job is done, \"N ok\" or \"N error\" is written to stdout, where N is\n"
+      "  the number of its line. Jobs may finish out of order.\n"
   );
 }
 
@@ -317,7 +342,9 @@ static void checkArgValues(int arg, const char* mode, int count) {
 static void ParseArgs(const int argc, char** argv, const char** lang,
                       const char** image, const char** outputbase,
                       const char** datapath, l_int32* dpi, bool* list_langs,
-                      bool* print_parameters, GenericVector<STRING>* vars_vec,
+                      bool* print_parameters, bool* print_init_profile,
+                      const char** trace_file, int* serve_engines,
+                      GenericVector<STRING>* vars_vec,
                       GenericVector<STRING>* vars_values, l_int32* arg_i,
                       tesseract::PageSegMode* pagesegmode,
                       tesseract::OcrEngineMode* enginemode) {
@@ -362,6 +389,20 @@ static void ParseArgs(const int argc, char** argv, const char** lang,
       vars_vec->push_back("user_patterns_file");
       vars_values->push_back(argv[i + 1]);
       ++i;
+    } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+      vars_vec->push_back("page_parallel_jobs");
+      vars_values->push_back(argv[i + 1]);
+      ++i;
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      *trace_file = argv[i + 1];
+      ++i;
+    } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+      *serve_engines = atoi(argv[i + 1]);
+      if (*serve_engines < 1) {
+        fprintf(stderr, "Error, --serve needs at least 1 engine\n");
+        exit(EXIT_FAILURE);
+      }
+      ++i;
     } else if (strcmp(argv[i], "--list-langs") == 0) {
       noocr = true;
       *list_langs = true;
@@ -379,6 +420,9 @@ static void ParseArgs(const int argc, char** argv, const char** lang,
     } else if (strcmp(argv[i], "--print-parameters") == 0) {
       noocr = true;
       *print_parameters = true;
+    } else if (strcmp(argv[i], "--print-init-profile") == 0) {
+      noocr = true;
+      *print_init_profile = true;
     } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
       // handled properly after api init
       ++i;
@@ -405,7 +449,7 @@ static void ParseArgs(const int argc, char** argv, const char** lang,
     }
   }
 
-  if (*outputbase == nullptr && noocr == false) {
+  if (*outputbase == nullptr && noocr == false && *serve_engines == 0) {
     PrintHelpMessage(argv[0]);
     exit(EXIT_FAILURE);
   }
@@ -468,6 +512,26 @@ static void PreloadRenderers(
       }
     }
 
+    api->GetBoolVariable("tessedit_create_tbr", &b);
+    if (b) {
+      #ifdef WIN32
+        if (_setmode(_fileno(stdout), _O_BINARY) == -1)
+          tprintf("ERROR: cin to binary: %s", strerror(errno));
+      #endif  // WIN32
+      bool choices;
+      api->GetBoolVariable("tbr_choices", &choices);
+      auto* renderer =
+          new tesseract::TessBinaryRenderer(outputbase, choices);
+      if (renderer->happy()) {
+        renderers->push_back(renderer);
+      } else {
+        delete renderer;
+        tprintf("Error, could not create tbr output file: %s\n",
+                strerror(errno));
+        error = true;
+      }
+    }
+
     api->GetBoolVariable("tessedit_create_pdf", &b);
     if (b) {
       #ifdef WIN32
@@ -571,6 +635,197 @@ static void PreloadRenderers(
 }
 
 
+// Splits a VAR=VALUE argument of -c into name and value.
+static bool SplitConfigVar(const char* arg, STRING* name, STRING* value) {
+  const char* p = strchr(arg, '=');
+  if (p == nullptr) {
+    fprintf(stderr, "Missing = in configvar assignment\n");
+    return false;
+  }
+  *name = STRING(arg, static_cast<int>(p - arg));
+  *value = p + 1;
+  return true;
+}
+
+// Recognizes the job given by the words of a line of stdin in serve mode,
+// on an engine leased from pool, with the options of the command line,
+// unless the job overrides them. The language and the -c variables select
+// the engine, while the page segmentation mode and the output formats are
+// set on it for the job only, so they don't make it initialize again.
+static bool RunServeJob(tesseract::TessEnginePool* pool, const char* lang,
+                        tesseract::OcrEngineMode enginemode,
+                        tesseract::PageSegMode pagesegmode,
+                        GenericVector<STRING> vars_vec,
+                        GenericVector<STRING> vars_values,
+                        const std::string& line) {
+  static const char* const kFormats[][2] = {
+      {"txt", "tessedit_create_txt"},
+      {"hocr", "tessedit_create_hocr"},
+      {"tsv", "tessedit_create_tsv"},
+      {"pdf", "tessedit_create_pdf"},
+      {"alto", "tessedit_create_alto"},
+      {"lstmbox", "tessedit_create_lstmbox"},
+      {"wordstrbox", "tessedit_create_wordstrbox"},
+      {"makebox", "tessedit_create_boxfile"},
+  };
+  std::string job_lang = lang;
+  std::string image, outputbase;
+  std::vector<const char*> formats;
+  std::istringstream words(line);
+  std::string word;
+  while (words >> word) {
+    if (word == "-l" && words >> word) {
+      job_lang = word;
+    } else if (word == "--psm" && words >> word) {
+      int psm = atoi(word.c_str());
+      if (psm < 0 || psm >= tesseract::PSM_COUNT) return false;
+      pagesegmode = static_cast<tesseract::PageSegMode>(psm);
+    } else if (word == "-c" && words >> word) {
+      STRING name, value;
+      if (!SplitConfigVar(word.c_str(), &name, &value)) return false;
+      vars_vec.push_back(name);
+      vars_values.push_back(value);
+    } else if (image.empty()) {
+      image = word;
+    } else if (outputbase.empty()) {
+      // The results can't go to stdout, which has the replies to the jobs.
+      if (word == "-" || word == "stdout") return false;
+      outputbase = word;
+    } else {
+      bool known = false;
+      for (const auto& format : kFormats) {
+        if (word == format[0]) {
+          formats.push_back(format[1]);
+          known = true;
+        }
+      }
+      if (!known) {
+        fprintf(stderr, "Error, unknown output format '%s'\n", word.c_str());
+        return false;
+      }
+    }
+  }
+  if (outputbase.empty()) return false;
+  tesseract::TessBaseAPI* api =
+      pool->Acquire(job_lang.c_str(), enginemode, &vars_vec, &vars_values);
+  if (api == nullptr) return false;
+  api->SetOutputName(outputbase.c_str());
+  const tesseract::PageSegMode old_pagesegmode = api->GetPageSegMode();
+  api->SetPageSegMode(pagesegmode);
+  std::vector<bool> old_formats(formats.size());
+  for (size_t f = 0; f < formats.size(); ++f) {
+    bool value = false;
+    api->GetBoolVariable(formats[f], &value);
+    old_formats[f] = value;
+    api->SetVariable(formats[f], "1");
+  }
+  bool succeed = false;
+  {
+    tesseract::PointerVector<tesseract::TessResultRenderer> renderers;
+    PreloadRenderers(api, &renderers, pagesegmode, outputbase.c_str());
+    if (!renderers.empty()) {
+      succeed = api->ProcessPages(image.c_str(), nullptr, 0, renderers[0]);
+    }
+  }
+  // Leave the engine with the variables of its profile.
+  for (size_t f = 0; f < formats.size(); ++f) {
+    api->SetVariable(formats[f], old_formats[f] ? "1" : "0");
+  }
+  api->SetPageSegMode(old_pagesegmode);
+  pool->Release(api);
+  return succeed;
+}
+
+// Keeps serve_engines engines loaded, and recognizes the jobs read from
+// stdin with them, serve_engines at once, replying to each job on stdout
+// once it is done, until the end of stdin.
+static int ServeJobs(int serve_engines, const char* datapath, const char* lang,
+                     tesseract::OcrEngineMode enginemode,
+                     tesseract::PageSegMode pagesegmode, int argc, char** argv,
+                     const GenericVector<STRING>& vars_vec,
+                     const GenericVector<STRING>& vars_values) {
+  GenericVector<STRING> names = vars_vec;
+  GenericVector<STRING> values = vars_values;
+  for (int i = 1; i + 1 < argc; ++i) {
+    if (strcmp(argv[i], "-c") == 0) {
+      STRING name, value;
+      if (!SplitConfigVar(argv[++i], &name, &value)) return EXIT_FAILURE;
+      names.push_back(name);
+      values.push_back(value);
+    }
+  }
+  tesseract::TessEnginePool pool(datapath, serve_engines);
+  // Initialize an engine up front, so a bad language fails at once.
+  tesseract::TessBaseAPI* api =
+      pool.Acquire(lang, enginemode, &names, &values);
+  if (api == nullptr) {
+    fprintf(stderr, "Could not initialize tesseract.\n");
+    return EXIT_FAILURE;
+  }
+  pool.Release(api);
+
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::deque<std::pair<int, std::string>> jobs;
+  bool done = false;
+  auto run_jobs = [&]() {
+    for (;;) {
+      std::pair<int, std::string> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        queued.wait(lock, [&] { return done || !jobs.empty(); });
+        if (jobs.empty()) return;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      bool ok = RunServeJob(&pool, lang, enginemode, pagesegmode, names,
+                            values, job.second);
+      std::lock_guard<std::mutex> lock(mutex);
+      printf("%d %s\n", job.first, ok ? "ok" : "error");
+      fflush(stdout);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < serve_engines; ++t) threads.emplace_back(run_jobs);
+  std::string line;
+  for (int line_number = 1; std::getline(std::cin, line); ++line_number) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.emplace_back(line_number, line);
+    queued.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  queued.notify_all();
+  for (auto& thread : threads) thread.join();
+  return EXIT_SUCCESS;
+}
+
+// Traces the stages of recognition from construction, and writes the trace
+// to filename on destruction, unless filename is nullptr.
+class TraceWriter {
+ public:
+  explicit TraceWriter(const char* filename) : filename_(filename) {
+    if (filename_ != nullptr) tesseract::TessBaseAPI::StartTracing();
+  }
+  ~TraceWriter() {
+    if (filename_ == nullptr) return;
+    tesseract::TessBaseAPI::StopTracing();
+    char* json = tesseract::TessBaseAPI::GetTraceJSON();
+    FILE* fp = fopen(filename_, "wb");
+    if (fp == nullptr || fputs(json, fp) == EOF) {
+      fprintf(stderr, "Can't write trace file %s\n", filename_);
+    }
+    if (fp != nullptr) fclose(fp);
+    delete[] json;
+  }
+
+ private:
+  const char* filename_;
+};
+
 /**********************************************************************
  *  main()
  *
@@ -583,6 +838,9 @@ int main(int argc, char** argv) {
   const char* datapath = nullptr;
   bool list_langs = false;
   bool print_parameters = false;
+  bool print_init_profile = false;
+  const char* trace_file = nullptr;
+  int serve_engines = 0;
   l_int32 dpi = 0;
   int arg_i = 1;
   tesseract::PageSegMode pagesegmode = tesseract::PSM_AUTO;
@@ -609,15 +867,18 @@ int main(int argc, char** argv) {
 #endif // HAVE_TIFFIO_H && _WIN32
 
   ParseArgs(argc, argv, &lang, &image, &outputbase, &datapath, &dpi,
-            &list_langs, &print_parameters, &vars_vec, &vars_values, &arg_i,
-            &pagesegmode, &enginemode);
+            &list_langs, &print_parameters, &print_init_profile, &trace_file,
+            &serve_engines, &vars_vec, &vars_values, &arg_i, &pagesegmode,
+            &enginemode);
+  TraceWriter trace_writer(trace_file);
 
   if (lang == nullptr) {
     // Set default language if none was given.
     lang = "eng";
   }
 
-  if (image == nullptr && !list_langs && !print_parameters)
+  if (image == nullptr && !list_langs && !print_parameters &&
+      !print_init_profile && serve_engines == 0)
     return EXIT_SUCCESS;
 
   // Call GlobalDawgCache here to create the global DawgCache object before
@@ -625,6 +886,17 @@ int main(int argc, char** argv) {
   // first TessBaseAPI must be destructed, DawgCache must be the last object.
   tesseract::Dict::GlobalDawgCache();
 
+  if (serve_engines > 0) {
+    if (dpi) {
+      char dpi_string[255];
+      snprintf(dpi_string, 254, "%d", dpi);
+      vars_vec.push_back("user_defined_dpi");
+      vars_values.push_back(dpi_string);
+    }
+    return ServeJobs(serve_engines, datapath, lang, enginemode, pagesegmode,
+                     argc, argv, vars_vec, vars_values);
+  }
+
   // Avoid memory leak caused by auto variable when return is called.
   static tesseract::TessBaseAPI api;
 
@@ -656,6 +928,16 @@ int main(int argc, char** argv) {
     return EXIT_SUCCESS;
   }
 
+  if (print_init_profile) {
+    char* profile = api.GetInitProfileText();
+    printf("Tesseract initialization profile:\n"
+           "%13s %13s %6s  %s\n%s", "time", "memory", "count", "phase",
+           profile);
+    delete[] profile;
+    api.End();
+    return EXIT_SUCCESS;
+  }
+
   FixPageSegMode(&api, pagesegmode);
 
   if (dpi) {
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activation.h
+// Description: Architecture-specific vectorized activation functions.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_ACTIVATION_H_
+#define TESSERACT_ARCH_ACTIVATION_H_
+
+namespace tesseract {
+
+// Vector versions of Tanh and Logistic in lstm/functions.h, which are applied
+// in-place to the n values of inout. They compute exp with a polynomial,
+// which is more accurate than the interpolated tables used by the scalar code.
+// TanhMultiply puts tanh(u) * v, component-wise, in out.
+void TanhVectorAVX2(int n, double* inout);
+void LogisticVectorAVX2(int n, double* inout);
+void TanhMultiplyAVX2(const double* u, const double* v, int n, double* out);
+
+void TanhVectorAVX512(int n, double* inout);
+void LogisticVectorAVX512(int n, double* inout);
+void TanhMultiplyAVX512(const double* u, const double* v, int n, double* out);
+
+void TanhVectorNEON(int n, double* inout);
+void LogisticVectorNEON(int n, double* inout);
+void TanhMultiplyNEON(const double* u, const double* v, int n, double* out);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_ACTIVATION_H_
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationavx2.cpp
+// Description: Vectorized activation functions for avx2.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#error Implementation only for AVX2 capable architectures
+#endif
+
+#include <immintrin.h>
+#include <cstring>
+#include "activation.h"
+
+namespace tesseract {
+
+// Number of doubles in a register.
+constexpr int kNumDoubles = 4;
+// Limit on the argument to exp, well inside the range of double, and beyond
+// which the activation functions are saturated to double precision.
+constexpr double kMaxExpArg = 40.0;
+
+// Computes exp(x) for 4 values of x in [-kMaxExpArg, kMaxExpArg].
+// x is split into k ln(2) + r, with |r| <= ln(2) / 2, so exp(x) = 2^k exp(r),
+// and exp(r) is computed with a degree 8 Taylor polynomial, which has a
+// relative error of less than 1e-8.
+static inline __m256d Exp(__m256d x) {
+  const __m256d kd = _mm256_round_pd(
+      _mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  // ln(2) split in 2 parts so r is computed accurately.
+  __m256d r = _mm256_sub_pd(
+      x, _mm256_mul_pd(kd, _mm256_set1_pd(6.93145751953125e-1)));
+  r = _mm256_sub_pd(
+      r, _mm256_mul_pd(kd, _mm256_set1_pd(1.42860682030941723e-6)));
+  __m256d p = _mm256_set1_pd(1.0 / 40320);
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 5040));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 720));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 120));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 24));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0 / 6));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(0.5));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0));
+  p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(1.0));
+  // Adding 1.5 * 2^52 puts the integer k + 1023 in the low mantissa bits,
+  // which are then shifted into the exponent to make 2^k.
+  __m256i bits = _mm256_castpd_si256(
+      _mm256_add_pd(kd, _mm256_set1_pd(6755399441055744.0 + 1023)));
+  __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52));
+  return _mm256_mul_pd(p, scale);
+}
+
+// Computes tanh(x) = sign(x) (1 - 2 / (exp(2|x|) + 1)) for 4 values of x.
+static inline __m256d Tanh(__m256d x) {
+  const __m256d sign_mask = _mm256_set1_pd(-0.0);
+  __m256d sign = _mm256_and_pd(x, sign_mask);
+  __m256d abs_x = _mm256_andnot_pd(sign_mask, x);
+  abs_x = _mm256_min_pd(abs_x, _mm256_set1_pd(kMaxExpArg / 2));
+  __m256d e = Exp(_mm256_add_pd(abs_x, abs_x));
+  const __m256d one = _mm256_set1_pd(1.0);
+  __m256d result = _mm256_sub_pd(
+      one, _mm256_div_pd(_mm256_set1_pd(2.0), _mm256_add_pd(e, one)));
+  return _mm256_or_pd(result, sign);
+}
+
+// Computes logistic(x) = 1 / (1 + exp(-x)) for 4 values of x.
+static inline __m256d Logistic(__m256d x) {
+  x = _mm256_max_pd(x, _mm256_set1_pd(-kMaxExpArg));
+  x = _mm256_min_pd(x, _mm256_set1_pd(kMaxExpArg));
+  __m256d e = Exp(_mm256_sub_pd(_mm256_setzero_pd(), x));
+  const __m256d one = _mm256_set1_pd(1.0);
+  return _mm256_div_pd(one, _mm256_add_pd(one, e));
+}
+
+// Applies Func in-place to the n values of inout. The remainder that doesn't
+// fill a register is computed in a zero-padded temporary.
+template <__m256d (*Func)(__m256d)>
+static void FuncInplace(int n, double* inout) {
+  int i = 0;
+  for (; i + kNumDoubles <= n; i += kNumDoubles) {
+    _mm256_storeu_pd(inout + i, Func(_mm256_loadu_pd(inout + i)));
+  }
+  if (i < n) {
+    double tmp[kNumDoubles] = {};
+    memcpy(tmp, inout + i, (n - i) * sizeof(*tmp));
+    _mm256_storeu_pd(tmp, Func(_mm256_loadu_pd(tmp)));
+    memcpy(inout + i, tmp, (n - i) * sizeof(*tmp));
+  }
+}
+
+void TanhVectorAVX2(int n, double* inout) {
+  FuncInplace<Tanh>(n, inout);
+}
+
+void LogisticVectorAVX2(int n, double* inout) {
+  FuncInplace<Logistic>(n, inout);
+}
+
+void TanhMultiplyAVX2(const double* u, const double* v, int n, double* out) {
+  int i = 0;
+  for (; i + kNumDoubles <= n; i += kNumDoubles) {
+    __m256d result = Tanh(_mm256_loadu_pd(u + i));
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(result, _mm256_loadu_pd(v + i)));
+  }
+  if (i < n) {
+    double tmp_u[kNumDoubles] = {};
+    double tmp_v[kNumDoubles] = {};
+    memcpy(tmp_u, u + i, (n - i) * sizeof(*tmp_u));
+    memcpy(tmp_v, v + i, (n - i) * sizeof(*tmp_v));
+    __m256d result = Tanh(_mm256_loadu_pd(tmp_u));
+    _mm256_storeu_pd(tmp_u, _mm256_mul_pd(result, _mm256_loadu_pd(tmp_v)));
+    memcpy(out + i, tmp_u, (n - i) * sizeof(*tmp_u));
+  }
+}
+
+}  // namespace tesseract.
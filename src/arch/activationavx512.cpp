@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationavx512.cpp
+// Description: Vectorized activation functions for avx512.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512F__)
+#error Implementation only for AVX512 capable architectures
+#endif
+
+#include <immintrin.h>
+#include <cstdint>
+#include "activation.h"
+
+namespace tesseract {
+
+// Number of doubles in a register.
+constexpr int kNumDoubles = 8;
+// Limit on the argument to exp, well inside the range of double, and beyond
+// which the activation functions are saturated to double precision.
+constexpr double kMaxExpArg = 40.0;
+
+// Computes exp(x) for 8 values of x in [-kMaxExpArg, kMaxExpArg].
+// x is split into k ln(2) + r, with |r| <= ln(2) / 2, so exp(x) = 2^k exp(r),
+// and exp(r) is computed with a degree 8 Taylor polynomial, which has a
+// relative error of less than 1e-8.
+static inline __m512d Exp(__m512d x) {
+  const __m512d kd = _mm512_roundscale_pd(
+      _mm512_mul_pd(x, _mm512_set1_pd(1.4426950408889634)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  // ln(2) split in 2 parts so r is computed accurately.
+  __m512d r = _mm512_fnmadd_pd(kd, _mm512_set1_pd(6.93145751953125e-1), x);
+  r = _mm512_fnmadd_pd(kd, _mm512_set1_pd(1.42860682030941723e-6), r);
+  __m512d p = _mm512_set1_pd(1.0 / 40320);
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 5040));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 720));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 120));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 24));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0 / 6));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(0.5));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+  p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(1.0));
+  // scalef computes p * 2^kd directly.
+  return _mm512_scalef_pd(p, kd);
+}
+
+// Computes tanh(x) = sign(x) (1 - 2 / (exp(2|x|) + 1)) for 8 values of x.
+static inline __m512d Tanh(__m512d x) {
+  const __m512i sign_mask = _mm512_set1_epi64(INT64_MIN);
+  __m512i bits = _mm512_castpd_si512(x);
+  __m512i sign = _mm512_and_epi64(bits, sign_mask);
+  __m512d abs_x = _mm512_castsi512_pd(_mm512_andnot_epi64(sign_mask, bits));
+  abs_x = _mm512_min_pd(abs_x, _mm512_set1_pd(kMaxExpArg / 2));
+  __m512d e = Exp(_mm512_add_pd(abs_x, abs_x));
+  const __m512d one = _mm512_set1_pd(1.0);
+  __m512d result = _mm512_sub_pd(
+      one, _mm512_div_pd(_mm512_set1_pd(2.0), _mm512_add_pd(e, one)));
+  return _mm512_castsi512_pd(
+      _mm512_or_epi64(_mm512_castpd_si512(result), sign));
+}
+
+// Computes logistic(x) = 1 / (1 + exp(-x)) for 8 values of x.
+static inline __m512d Logistic(__m512d x) {
+  x = _mm512_max_pd(x, _mm512_set1_pd(-kMaxExpArg));
+  x = _mm512_min_pd(x, _mm512_set1_pd(kMaxExpArg));
+  __m512d e = Exp(_mm512_sub_pd(_mm512_setzero_pd(), x));
+  const __m512d one = _mm512_set1_pd(1.0);
+  return _mm512_div_pd(one, _mm512_add_pd(one, e));
+}
+
+// Returns a mask for the first n (up to 8) elements of a register.
+static inline __mmask8 TailMask(int n) {
+  return static_cast<__mmask8>(n >= kNumDoubles ? 0xff : (1u << n) - 1);
+}
+
+// Applies Func in-place to the n values of inout, using masked loads and
+// stores for the remainder that doesn't fill a register.
+template <__m512d (*Func)(__m512d)>
+static void FuncInplace(int n, double* inout) {
+  for (int i = 0; i < n; i += kNumDoubles) {
+    __mmask8 mask = TailMask(n - i);
+    __m512d x = _mm512_maskz_loadu_pd(mask, inout + i);
+    _mm512_mask_storeu_pd(inout + i, mask, Func(x));
+  }
+}
+
+void TanhVectorAVX512(int n, double* inout) {
+  FuncInplace<Tanh>(n, inout);
+}
+
+void LogisticVectorAVX512(int n, double* inout) {
+  FuncInplace<Logistic>(n, inout);
+}
+
+void TanhMultiplyAVX512(const double* u, const double* v, int n, double* out) {
+  for (int i = 0; i < n; i += kNumDoubles) {
+    __mmask8 mask = TailMask(n - i);
+    __m512d result = Tanh(_mm512_maskz_loadu_pd(mask, u + i));
+    result = _mm512_mul_pd(result, _mm512_maskz_loadu_pd(mask, v + i));
+    _mm512_mask_storeu_pd(out + i, mask, result);
+  }
+}
+
+}  // namespace tesseract.
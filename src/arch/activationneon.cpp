@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////
+// File:        activationneon.cpp
+// Description: Vectorized activation functions for ARM NEON.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__ARM_NEON)
+#error Implementation only for NEON capable architectures
+#endif
+
+#include "activation.h"
+
+// Double precision NEON is only available on aarch64.
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+#include <cstring>
+
+namespace tesseract {
+
+// Number of doubles in a register.
+constexpr int kNumDoubles = 2;
+// Limit on the argument to exp, well inside the range of double, and beyond
+// which the activation functions are saturated to double precision.
+constexpr double kMaxExpArg = 40.0;
+
+// Computes exp(x) for 2 values of x in [-kMaxExpArg, kMaxExpArg].
+// x is split into k ln(2) + r, with |r| <= ln(2) / 2, so exp(x) = 2^k exp(r),
+// and exp(r) is computed with a degree 8 Taylor polynomial, which has a
+// relative error of less than 1e-8.
+static inline float64x2_t Exp(float64x2_t x) {
+  const float64x2_t kd = vrndnq_f64(vmulq_n_f64(x, 1.4426950408889634));
+  // ln(2) split in 2 parts so r is computed accurately.
+  float64x2_t r = vfmsq_f64(x, kd, vdupq_n_f64(6.93145751953125e-1));
+  r = vfmsq_f64(r, kd, vdupq_n_f64(1.42860682030941723e-6));
+  float64x2_t p = vdupq_n_f64(1.0 / 40320);
+  p = vfmaq_f64(vdupq_n_f64(1.0 / 5040), p, r);
+  p = vfmaq_f64(vdupq_n_f64(1.0 / 720), p, r);
+  p = vfmaq_f64(vdupq_n_f64(1.0 / 120), p, r);
+  p = vfmaq_f64(vdupq_n_f64(1.0 / 24), p, r);
+  p = vfmaq_f64(vdupq_n_f64(1.0 / 6), p, r);
+  p = vfmaq_f64(vdupq_n_f64(0.5), p, r);
+  p = vfmaq_f64(vdupq_n_f64(1.0), p, r);
+  p = vfmaq_f64(vdupq_n_f64(1.0), p, r);
+  // Shift k + 1023 into the exponent to make 2^k.
+  int64x2_t k = vaddq_s64(vcvtq_s64_f64(kd), vdupq_n_s64(1023));
+  float64x2_t scale = vreinterpretq_f64_s64(vshlq_n_s64(k, 52));
+  return vmulq_f64(p, scale);
+}
+
+// Computes tanh(x) = sign(x) (1 - 2 / (exp(2|x|) + 1)) for 2 values of x.
+static inline float64x2_t Tanh(float64x2_t x) {
+  float64x2_t abs_x = vminq_f64(vabsq_f64(x), vdupq_n_f64(kMaxExpArg / 2));
+  float64x2_t e = Exp(vaddq_f64(abs_x, abs_x));
+  const float64x2_t one = vdupq_n_f64(1.0);
+  float64x2_t result =
+      vsubq_f64(one, vdivq_f64(vdupq_n_f64(2.0), vaddq_f64(e, one)));
+  // Copy the sign of x to the result.
+  const uint64x2_t sign_mask = vdupq_n_u64(0x8000000000000000ull);
+  return vbslq_f64(sign_mask, x, result);
+}
+
+// Computes logistic(x) = 1 / (1 + exp(-x)) for 2 values of x.
+static inline float64x2_t Logistic(float64x2_t x) {
+  x = vmaxq_f64(x, vdupq_n_f64(-kMaxExpArg));
+  x = vminq_f64(x, vdupq_n_f64(kMaxExpArg));
+  float64x2_t e = Exp(vnegq_f64(x));
+  const float64x2_t one = vdupq_n_f64(1.0);
+  return vdivq_f64(one, vaddq_f64(one, e));
+}
+
+// Applies Func in-place to the n values of inout. The remainder that doesn't
+// fill a register is computed in a zero-padded temporary.
+template <float64x2_t (*Func)(float64x2_t)>
+static void FuncInplace(int n, double* inout) {
+  int i = 0;
+  for (; i + kNumDoubles <= n; i += kNumDoubles) {
+    vst1q_f64(inout + i, Func(vld1q_f64(inout + i)));
+  }
+  if (i < n) {
+    double tmp[kNumDoubles] = {};
+    memcpy(tmp, inout + i, (n - i) * sizeof(*tmp));
+    vst1q_f64(tmp, Func(vld1q_f64(tmp)));
+    memcpy(inout + i, tmp, (n - i) * sizeof(*tmp));
+  }
+}
+
+void TanhVectorNEON(int n, double* inout) {
+  FuncInplace<Tanh>(n, inout);
+}
+
+void LogisticVectorNEON(int n, double* inout) {
+  FuncInplace<Logistic>(n, inout);
+}
+
+void TanhMultiplyNEON(const double* u, const double* v, int n, double* out) {
+  int i = 0;
+  for (; i + kNumDoubles <= n; i += kNumDoubles) {
+    float64x2_t result = Tanh(vld1q_f64(u + i));
+    vst1q_f64(out + i, vmulq_f64(result, vld1q_f64(v + i)));
+  }
+  if (i < n) {
+    // The remainder is a single value.
+    double tmp_u[kNumDoubles] = {u[i], 0.0};
+    vst1q_f64(tmp_u, Tanh(vld1q_f64(tmp_u)));
+    out[i] = tmp_u[0] * v[i];
+  }
+}
+
+}  // namespace tesseract.
+
+#endif  // __aarch64__
@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classpruner.h
+// Description: Vectorized class pruner counts and config evidence of the
+//              legacy classifier.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_CLASSPRUNER_H_
+#define TESSERACT_ARCH_CLASSPRUNER_H_
+
+#include <cstdint>  // for uint8_t, uint32_t
+
+namespace tesseract {
+
+// Number of classes covered by each class pruner.
+constexpr int kClassesPerPruner = 32;
+
+// For each of the num_pruners class pruners, adds the 2-bit counts packed in
+// the pair of words at each of the num_offsets offsets (in words) into the
+// pruner, to the kClassesPerPruner counts of that pruner, so pruner p adds
+// to counts[kClassesPerPruner * p ...]. The count of class c of a pruner is
+// in bits 2 * (c % 16) of word c / 16. Used by the class pruner of the
+// legacy classifier, where each offset is the quantized position of one
+// feature.
+void AddClassPrunerCountsAVX2(const uint32_t* const* pruners, int num_pruners,
+                              const int* offsets, int num_offsets,
+                              int* counts);
+
+void AddClassPrunerCountsNEON(const uint32_t* const* pruners, int num_pruners,
+                              const int* offsets, int num_offsets,
+                              int* counts);
+
+// Number of configs covered by each config word.
+constexpr int kConfigsPerWord = 32;
+
+// For each of the n protos, raises each of the kConfigsPerWord values of
+// feature_evidence, for which the bit of config_words[i] is set, to at least
+// evidence[i]. Used by the integer matcher of the legacy classifier to find
+// the best evidence of one feature for each config of a class.
+void MaxConfigEvidenceAVX2(const uint32_t* config_words,
+                           const uint8_t* evidence, int n,
+                           uint8_t* feature_evidence);
+
+void MaxConfigEvidenceNEON(const uint32_t* config_words,
+                           const uint8_t* evidence, int n,
+                           uint8_t* feature_evidence);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_CLASSPRUNER_H_
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classpruneravx2.cpp
+// Description: Vectorized class pruner counts and config evidence of the
+//              legacy classifier for avx2.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#error Implementation only for AVX2 capable architectures
+#endif
+
+#include <immintrin.h>
+#include "classpruner.h"
+
+namespace tesseract {
+
+void AddClassPrunerCountsAVX2(const uint32_t* const* pruners, int num_pruners,
+                              const int* offsets, int num_offsets,
+                              int* counts) {
+  // Shifts that bring the counts of 8 consecutive classes in a word down to
+  // the low 2 bits of each lane.
+  const __m256i low_shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+  const __m256i high_shifts = _mm256_setr_epi32(16, 18, 20, 22, 24, 26, 28, 30);
+  const __m256i mask = _mm256_set1_epi32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    // The counts of the 32 classes of the pruner stay in registers over all
+    // the features.
+    auto* dest = reinterpret_cast<__m256i*>(counts + p * kClassesPerPruner);
+    __m256i sum0 = _mm256_loadu_si256(dest);
+    __m256i sum1 = _mm256_loadu_si256(dest + 1);
+    __m256i sum2 = _mm256_loadu_si256(dest + 2);
+    __m256i sum3 = _mm256_loadu_si256(dest + 3);
+    const uint32_t* pruner = pruners[p];
+    for (int f = 0; f < num_offsets; ++f) {
+      const uint32_t* words = pruner + offsets[f];
+      __m256i word0 = _mm256_set1_epi32(words[0]);
+      __m256i word1 = _mm256_set1_epi32(words[1]);
+      sum0 = _mm256_add_epi32(
+          sum0, _mm256_and_si256(_mm256_srlv_epi32(word0, low_shifts), mask));
+      sum1 = _mm256_add_epi32(
+          sum1, _mm256_and_si256(_mm256_srlv_epi32(word0, high_shifts), mask));
+      sum2 = _mm256_add_epi32(
+          sum2, _mm256_and_si256(_mm256_srlv_epi32(word1, low_shifts), mask));
+      sum3 = _mm256_add_epi32(
+          sum3, _mm256_and_si256(_mm256_srlv_epi32(word1, high_shifts), mask));
+    }
+    _mm256_storeu_si256(dest, sum0);
+    _mm256_storeu_si256(dest + 1, sum1);
+    _mm256_storeu_si256(dest + 2, sum2);
+    _mm256_storeu_si256(dest + 3, sum3);
+  }
+}
+
+void MaxConfigEvidenceAVX2(const uint32_t* config_words,
+                           const uint8_t* evidence, int n,
+                           uint8_t* feature_evidence) {
+  // Spreads byte i / 8 of the config word to byte i, and selects bit i % 8.
+  const __m256i spread = _mm256_setr_epi8(
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+      2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  const __m256i bits = _mm256_setr_epi8(
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+  auto* dest = reinterpret_cast<__m256i*>(feature_evidence);
+  __m256i best = _mm256_loadu_si256(dest);
+  for (int i = 0; i < n; ++i) {
+    __m256i word = _mm256_shuffle_epi8(
+        _mm256_set1_epi32(static_cast<int>(config_words[i])), spread);
+    __m256i mask = _mm256_cmpeq_epi8(_mm256_and_si256(word, bits), bits);
+    __m256i value = _mm256_and_si256(
+        mask, _mm256_set1_epi8(static_cast<char>(evidence[i])));
+    best = _mm256_max_epu8(best, value);
+  }
+  _mm256_storeu_si256(dest, best);
+}
+
+}  // namespace tesseract.
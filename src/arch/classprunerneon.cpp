@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classprunerneon.cpp
+// Description: Vectorized class pruner counts and config evidence of the
+//              legacy classifier for ARM NEON.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__ARM_NEON)
+#error Implementation only for NEON capable architectures
+#endif
+
+#include <arm_neon.h>
+#include "classpruner.h"
+
+namespace tesseract {
+
+// Number of counts in each register.
+constexpr int kNumCounts = 4;
+// Number of registers holding the counts of one pruner.
+constexpr int kNumSums = kClassesPerPruner / kNumCounts;
+
+void AddClassPrunerCountsNEON(const uint32_t* const* pruners, int num_pruners,
+                              const int* offsets, int num_offsets,
+                              int* counts) {
+  // Negative shifts shift right, bringing the counts of 4 consecutive classes
+  // in a word down to the low 2 bits of each lane.
+  static const int32_t kShifts[kNumSums / 2][kNumCounts] = {
+      {0, -2, -4, -6}, {-8, -10, -12, -14},
+      {-16, -18, -20, -22}, {-24, -26, -28, -30}};
+  int32x4_t shifts[kNumSums / 2];
+  for (int s = 0; s < kNumSums / 2; ++s) shifts[s] = vld1q_s32(kShifts[s]);
+  const uint32x4_t mask = vdupq_n_u32(3);
+  for (int p = 0; p < num_pruners; ++p) {
+    // The counts of the 32 classes of the pruner stay in registers over all
+    // the features.
+    int* dest = counts + p * kClassesPerPruner;
+    uint32x4_t sums[kNumSums];
+    for (int s = 0; s < kNumSums; ++s) {
+      sums[s] = vreinterpretq_u32_s32(vld1q_s32(dest + s * kNumCounts));
+    }
+    const uint32_t* pruner = pruners[p];
+    for (int f = 0; f < num_offsets; ++f) {
+      const uint32_t* words = pruner + offsets[f];
+      for (int w = 0; w < 2; ++w) {
+        uint32x4_t word = vdupq_n_u32(words[w]);
+        for (int s = 0; s < kNumSums / 2; ++s) {
+          uint32x4_t& sum = sums[w * kNumSums / 2 + s];
+          sum = vaddq_u32(sum, vandq_u32(vshlq_u32(word, shifts[s]), mask));
+        }
+      }
+    }
+    for (int s = 0; s < kNumSums; ++s) {
+      vst1q_s32(dest + s * kNumCounts, vreinterpretq_s32_u32(sums[s]));
+    }
+  }
+}
+
+void MaxConfigEvidenceNEON(const uint32_t* config_words,
+                           const uint8_t* evidence, int n,
+                           uint8_t* feature_evidence) {
+  // Selects bit i % 8 of byte i / 8 of the config word.
+  static const uint8_t kBits[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                    1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t bits = vld1q_u8(kBits);
+  uint8x16_t best_low = vld1q_u8(feature_evidence);
+  uint8x16_t best_high = vld1q_u8(feature_evidence + 16);
+  for (int i = 0; i < n; ++i) {
+    uint32_t word = config_words[i];
+    uint8x16_t low = vcombine_u8(vdup_n_u8(word & 0xff),
+                                 vdup_n_u8((word >> 8) & 0xff));
+    uint8x16_t high = vcombine_u8(vdup_n_u8((word >> 16) & 0xff),
+                                  vdup_n_u8(word >> 24));
+    uint8x16_t value = vdupq_n_u8(evidence[i]);
+    best_low = vmaxq_u8(best_low, vandq_u8(vtstq_u8(low, bits), value));
+    best_high = vmaxq_u8(best_high, vandq_u8(vtstq_u8(high, bits), value));
+  }
+  vst1q_u8(feature_evidence, best_low);
+  vst1q_u8(feature_evidence + 16, best_high);
+}
+
+}  // namespace tesseract.
@@ -57,4 +57,38 @@ double DotProductAVX(const double* u, const double* v, int n) {
   return result;
 }
 
+// Computes and returns the dot product of the n-vectors u and v in single
+// precision, using 2 registers of 8 floats each.
+float DotProductAVX(const float* u, const float* v, int n) {
+  const unsigned quot = n / 16;
+  const unsigned rem = n % 16;
+  __m256 t0 = _mm256_setzero_ps();
+  __m256 t1 = _mm256_setzero_ps();
+  for (unsigned k = 0; k < quot; k++) {
+    __m256 f0 = _mm256_loadu_ps(u);
+    __m256 f1 = _mm256_loadu_ps(v);
+    f0 = _mm256_mul_ps(f0, f1);
+    t0 = _mm256_add_ps(t0, f0);
+    u += 8;
+    v += 8;
+    __m256 f2 = _mm256_loadu_ps(u);
+    __m256 f3 = _mm256_loadu_ps(v);
+    f2 = _mm256_mul_ps(f2, f3);
+    t1 = _mm256_add_ps(t1, f2);
+    u += 8;
+    v += 8;
+  }
+  t0 = _mm256_add_ps(t0, t1);
+  // Add the 8 sums in t0 horizontally.
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(t0),
+                          _mm256_extractf128_ps(t0, 1));
+  sum = _mm_hadd_ps(sum, sum);
+  sum = _mm_hadd_ps(sum, sum);
+  float result = _mm_cvtss_f32(sum);
+  for (unsigned k = 0; k < rem; k++) {
+    result += *u++ * *v++;
+  }
+  return result;
+}
+
 }  // namespace tesseract.
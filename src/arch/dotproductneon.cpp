@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dotproductneon.cpp
+// Description: Architecture-specific dot-product function.
+//
+// (C) Copyright 2015, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__ARM_NEON)
+#error Implementation only for NEON capable architectures
+#endif
+
+#include "dotproductneon.h"
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+namespace tesseract {
+
+// Computes and returns the dot product of the n-vectors u and v.
+// Uses ARM NEON intrinsics to access the SIMD instruction set.
+double DotProductNEON(const double* u, const double* v, int n) {
+  int max_offset = n - 4;
+  int offset = 0;
+  // Accumulate two sets of 2 sums in sum0 and sum1, by loading pairs of 2
+  // values from u and v, and multiplying them together in parallel.
+  // Two accumulators hide the latency of the fused multiply-add.
+  float64x2_t sum0 = vdupq_n_f64(0.0);
+  float64x2_t sum1 = vdupq_n_f64(0.0);
+  while (offset <= max_offset) {
+    sum0 = vfmaq_f64(sum0, vld1q_f64(u + offset), vld1q_f64(v + offset));
+    sum1 = vfmaq_f64(sum1, vld1q_f64(u + offset + 2),
+                     vld1q_f64(v + offset + 2));
+    offset += 4;
+  }
+  // Add the 4 sums horizontally.
+  double result = vaddvq_f64(vaddq_f64(sum0, sum1));
+  // Add on any left-over products.
+  while (offset < n) {
+    result += u[offset] * v[offset];
+    ++offset;
+  }
+  return result;
+}
+
+// Computes and returns the dot product of the n-vectors u and v in single
+// precision.
+float DotProductNEON(const float* u, const float* v, int n) {
+  int max_offset = n - 8;
+  int offset = 0;
+  // Accumulate two sets of 4 sums in sum0 and sum1.
+  float32x4_t sum0 = vdupq_n_f32(0.0f);
+  float32x4_t sum1 = vdupq_n_f32(0.0f);
+  while (offset <= max_offset) {
+    sum0 = vfmaq_f32(sum0, vld1q_f32(u + offset), vld1q_f32(v + offset));
+    sum1 = vfmaq_f32(sum1, vld1q_f32(u + offset + 4),
+                     vld1q_f32(v + offset + 4));
+    offset += 8;
+  }
+  // Add the 8 sums horizontally.
+  float result = vaddvq_f32(vaddq_f32(sum0, sum1));
+  // Add on any left-over products.
+  while (offset < n) {
+    result += u[offset] * v[offset];
+    ++offset;
+  }
+  return result;
+}
+
+}  // namespace tesseract.
+
+#endif  // __aarch64__
@@ -0,0 +1,30 @@
+///////////////////////////////////////////////////////////////////////
+// File:        dotproductneon.h
+// Description: Architecture-specific dot-product function.
+//
+// (C) Copyright 2015, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_DOTPRODUCTNEON_H_
+#define TESSERACT_ARCH_DOTPRODUCTNEON_H_
+
+namespace tesseract {
+
+// Computes and returns the dot product of the n-vectors u and v.
+// Uses ARM NEON intrinsics to access the SIMD instruction set.
+// Only available on aarch64, as 32 bit NEON has no double precision support.
+double DotProductNEON(const double* u, const double* v, int n);
+float DotProductNEON(const float* u, const float* v, int n);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_DOTPRODUCTNEON_H_
@@ -78,4 +78,32 @@ double DotProductSSE(const double* u, const double* v, int n) {
   return result;
 }
 
+// Computes and returns the dot product of the n-vectors u and v in single
+// precision, 4 floats at a time.
+float DotProductSSE(const float* u, const float* v, int n) {
+  int max_offset = n - 4;
+  int offset = 0;
+  // Accumulate a set of 4 sums in sum, by loading sets of 4 values from u and
+  // v, and multiplying them together in parallel.
+  __m128 sum = _mm_setzero_ps();
+  while (offset <= max_offset) {
+    __m128 floats1 = _mm_loadu_ps(u + offset);
+    __m128 floats2 = _mm_loadu_ps(v + offset);
+    offset += 4;
+    floats1 = _mm_mul_ps(floats1, floats2);
+    sum = _mm_add_ps(sum, floats1);
+  }
+  // Add the 4 sums in sum horizontally.
+  sum = _mm_hadd_ps(sum, sum);
+  sum = _mm_hadd_ps(sum, sum);
+  // Extract the low result.
+  float result = _mm_cvtss_f32(sum);
+  // Add on any left-over products.
+  while (offset < n) {
+    result += u[offset] * v[offset];
+    ++offset;
+  }
+  return result;
+}
+
 }  // namespace tesseract.
@@ -18,6 +18,7 @@
 
 #include "intsimdmatrix.h"
 #include "genericvector.h"      // for GenericVector
+#include "initprofile.h"        // for InitPhase
 #include "matrix.h"             // for GENERIC_2D_ARRAY
 #include "simddetect.h"         // for SIMDDetect
 
@@ -25,9 +26,53 @@ namespace tesseract {
 
 const IntSimdMatrix* IntSimdMatrix::intSimdMatrix = nullptr;
 
+// Returns the dot product of num_in weights in wi with u. If kNumIn is not 0,
+// it must equal num_in, and the fixed size lets the compiler unroll and
+// vectorize the loop for that size.
+template <int kNumIn>
+static int IntDotProduct(const int8_t* wi, const int8_t* u, int num_in) {
+  if (kNumIn > 0) num_in = kNumIn;
+  int total = 0;
+  for (int j = 0; j < num_in; ++j) total += wi[j] * u[j];
+  return total;
+}
+
+using IntDotProductFunction = int (*)(const int8_t*, const int8_t*, int);
+
+// Returns the version of IntDotProduct for num_in inputs. The fixed sizes are
+// the numbers of inputs of the weight matrices in the layers of the shipped
+// models, eg [1,36,0,1 Ct3,3,16 Mp3,3 Lfys48 Lfx96 Lrx96 Lfx192 O1c1] for the
+// fast models and [1,36,0,1 Ct3,3,16 Mp3,3 Lfys64 Lfx96 Lrx96 Lfx512 O1c1] for
+// the best models. Any other size uses the generic loop.
+static IntDotProductFunction SelectIntDotProduct(int num_in) {
+  switch (num_in) {
+    case 9:
+      return IntDotProduct<9>;
+    case 64:
+      return IntDotProduct<64>;
+    case 80:
+      return IntDotProduct<80>;
+    case 144:
+      return IntDotProduct<144>;
+    case 160:
+      return IntDotProduct<160>;
+    case 192:
+      return IntDotProduct<192>;
+    case 288:
+      return IntDotProduct<288>;
+    case 512:
+      return IntDotProduct<512>;
+    case 608:
+      return IntDotProduct<608>;
+    default:
+      return IntDotProduct<0>;
+  }
+}
+
 // Computes a reshaped copy of the weight matrix w.
 void IntSimdMatrix::Init(const GENERIC_2D_ARRAY<int8_t>& w,
                          std::vector<int8_t>& shaped_w) const {
+  InitPhase phase("IntSimdMatrix::Init");
   const int num_out = w.dim1();
   const int num_in = w.dim2() - 1;
   // The rounded-up sizes of the reshaped weight matrix, excluding biases.
@@ -81,14 +126,36 @@ void IntSimdMatrix::MatrixDotVector(const GENERIC_2D_ARRAY<int8_t>& w,
                                     const int8_t* u, double* v) {
   int num_out = w.dim1();
   int num_in = w.dim2() - 1;
+  IntDotProductFunction dot_product = SelectIntDotProduct(num_in);
   // Base implementation.
   for (int i = 0; i < num_out; ++i) {
     const int8_t* wi = w[i];
-    int total = 0;
-    for (int j = 0; j < num_in; ++j) total += wi[j] * u[j];
+    int total = dot_product(wi, u, num_in);
     // Add in the bias and correct for integer values.
     v[i] = (static_cast<double>(total) / INT8_MAX + wi[num_in]) * scales[i];
   }
 }
 
+// Computes matrix.matrix v_t = Wu_t for num_vectors input vectors.
+// See MatrixDotVector for the meaning of the sizes.
+void IntSimdMatrix::MatrixDotMatrix(const GENERIC_2D_ARRAY<int8_t>& w,
+                                    const GenericVector<double>& scales,
+                                    const int8_t* u, int u_stride,
+                                    int num_vectors, double* v, int v_stride) {
+  int num_out = w.dim1();
+  int num_in = w.dim2() - 1;
+  IntDotProductFunction dot_product = SelectIntDotProduct(num_in);
+  // Iterating over the outputs in the outer loop keeps each row of weights
+  // in cache while it is applied to all the inputs.
+  for (int i = 0; i < num_out; ++i) {
+    const int8_t* wi = w[i];
+    for (int t = 0; t < num_vectors; ++t) {
+      int total = dot_product(wi, u + t * u_stride, num_in);
+      // Add in the bias and correct for integer values.
+      v[t * v_stride + i] =
+          (static_cast<double>(total) / INT8_MAX + wi[num_in]) * scales[i];
+    }
+  }
+}
+
 }  // namespace tesseract
@@ -83,6 +83,17 @@ struct IntSimdMatrix {
                               const GenericVector<double>& scales,
                               const int8_t* u, double* v);
 
+  // Computes matrix.matrix v_t = Wu_t for num_vectors input vectors u_t,
+  // which are u_stride apart in u, writing the results v_stride apart in v.
+  // Each u_t is of size W.dim2() - 1 and each v_t is of size W.dim1().
+  // The inputs are imagined to have an extra element at the end with value 1,
+  // as in MatrixDotVector above.
+  // Computes the base C++ implementation.
+  static void MatrixDotMatrix(const GENERIC_2D_ARRAY<int8_t>& w,
+                              const GenericVector<double>& scales,
+                              const int8_t* u, int u_stride, int num_vectors,
+                              double* v, int v_stride);
+
   // Rounds the input up to a multiple of the given factor.
   static int Roundup(int input, int factor) {
     return (input + factor - 1) / factor * factor;
@@ -102,6 +113,18 @@ struct IntSimdMatrix {
                                            double*);
   MatrixDotVectorFunction matrixDotVectorFunction;
 
+  // Computes matrix.matrix as MatrixDotMatrix above, for a tile of
+  // num_vectors inputs, using the same shaped weights and input padding as
+  // matrixDotVectorFunction. Each block of shaped weights is applied to all
+  // the inputs in the tile before moving on to the next block, so the weights
+  // are streamed from memory once per tile instead of once per input.
+  // Arguments are dim1, dim2, shaped weights, scales, u, u_stride,
+  // num_vectors, v, v_stride.
+  using MatrixDotMatrixFunction = void (*)(int, int, const int8_t*,
+                                           const double*, const int8_t*, int,
+                                           int, double*, int);
+  MatrixDotMatrixFunction matrixDotMatrixFunction;
+
   // Number of 32 bit outputs held in each register.
   int num_outputs_per_register_;
   // Maximum number of registers that we will use to hold outputs.
@@ -113,9 +136,33 @@ struct IntSimdMatrix {
   // Number of groups of inputs to be broadcast.
   // num_input_groups_ = num_inputs_per_register_ / num_inputs_per_group_
 
+  // The rest is only set by code that runs on a device with its own memory,
+  // and is nullptr for the CPU code.
+  // Copies the shaped weights of a dim1 x dim2 matrix to the device.
+  // Returns a handle that the caller owns and must free with
+  // releaseWeightsFunction, or nullptr on failure.
+  using UploadWeightsFunction = void* (*)(int, int, const int8_t*);
+  UploadWeightsFunction uploadWeightsFunction;
+  using ReleaseWeightsFunction = void (*)(void*);
+  ReleaseWeightsFunction releaseWeightsFunction;
+  // As matrixDotMatrixFunction, using the weights uploaded to the device,
+  // whose handle is the first argument.
+  using DeviceMatrixDotMatrixFunction = void (*)(void*, int, int,
+                                                 const int8_t*, const double*,
+                                                 const int8_t*, int, int,
+                                                 double*, int);
+  DeviceMatrixDotMatrixFunction deviceMatrixDotMatrixFunction;
+
   static const IntSimdMatrix* intSimdMatrix;
+  static const IntSimdMatrix intSimdMatrixAVX512;
+  static const IntSimdMatrix intSimdMatrixAVX512VNNI;
   static const IntSimdMatrix intSimdMatrixAVX2;
   static const IntSimdMatrix intSimdMatrixSSE;
+  static const IntSimdMatrix intSimdMatrixNEON;
+#if defined(USE_OPENCL)
+  // Runs the tiles of MatrixDotMatrix on the OpenCL device.
+  static const IntSimdMatrix intSimdMatrixOpenCL;
+#endif
 };
 
 }  // namespace tesseract
@@ -274,8 +274,14 @@ static void PartialMatrixDotVector8(const int8_t* wi, const double* scales,
   ExtractResults(result0, shift_id, wi, scales, num_out, v);
 }
 
-static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
-                            const double* scales, const int8_t* u, double* v) {
+// Computes matrix.matrix v_t = Wu_t for num_vectors inputs u_t, which are
+// u_stride apart in u, writing the results v_stride apart in v. Each block of
+// weights is applied to all the inputs before moving to the next block, so it
+// is only read from memory once.
+static void matrixDotMatrix(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u,
+                            int u_stride, int num_vectors, double* v,
+                            int v_stride) {
   const int num_out = dim1;
   const int num_in = dim2 - 1;
   // Each call to a partial_func_ produces group_size outputs, except the
@@ -292,7 +298,10 @@ static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
   // Run with this group size, until it would produce too much output, then
   // switch to a smaller size.
   for (; output + group_size <= rounded_num_out; output += group_size) {
-    PartialMatrixDotVector64(wi, scales, u, rounded_num_in, num_out - output, v);
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector64(wi, scales, u + t * u_stride, rounded_num_in,
+                               num_out - output, v + t * v_stride);
+    }
     wi += w_step;
     scales += group_size;
     v += group_size;
@@ -301,7 +310,10 @@ static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
   w_step /= 2;
 
   for (; output + group_size <= rounded_num_out; output += group_size) {
-    PartialMatrixDotVector32(wi, scales, u, rounded_num_in, num_out - output, v);
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector32(wi, scales, u + t * u_stride, rounded_num_in,
+                               num_out - output, v + t * v_stride);
+    }
     wi += w_step;
     scales += group_size;
     v += group_size;
@@ -310,7 +322,10 @@ static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
   w_step /= 2;
 
   for (; output + group_size <= rounded_num_out; output += group_size) {
-    PartialMatrixDotVector16(wi, scales, u, rounded_num_in, num_out - output, v);
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector16(wi, scales, u + t * u_stride, rounded_num_in,
+                               num_out - output, v + t * v_stride);
+    }
     wi += w_step;
     scales += group_size;
     v += group_size;
@@ -319,16 +334,25 @@ static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
   w_step /= 2;
 
   for (; output + group_size <= rounded_num_out; output += group_size) {
-    PartialMatrixDotVector8(wi, scales, u, rounded_num_in, num_out - output, v);
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector8(wi, scales, u + t * u_stride, rounded_num_in,
+                              num_out - output, v + t * v_stride);
+    }
     wi += w_step;
     scales += group_size;
     v += group_size;
   }
 }
 
+static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u, double* v) {
+  matrixDotMatrix(dim1, dim2, wi, scales, u, 0, 1, v, 0);
+}
+
 const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX2 = {
-  // Function.
+  // Functions.
   matrixDotVector,
+  matrixDotMatrix,
   // Number of 32 bit outputs held in each register.
   kNumOutputsPerRegister,
   // Maximum number of registers that we will use to hold outputs.
@@ -336,7 +360,11 @@ const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX2 = {
   // Number of 8 bit inputs in the inputs register.
   kNumInputsPerRegister,
   // Number of inputs in each weight group.
-  kNumInputsPerGroup
+  kNumInputsPerGroup,
+  // No device functions.
+  nullptr,
+  nullptr,
+  nullptr
 };
 
 }  // namespace tesseract.
@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixavx512.cpp
+// Description: matrix-vector product for 8-bit data on avx512.
+//              Also compiled with VNNI by intsimdmatrixavx512vnni.cpp.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512F__) || !defined(__AVX512BW__)
+#error Implementation only for AVX512BW capable architectures
+#endif
+
+#include "intsimdmatrix.h"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace tesseract {
+
+// Number of outputs held in each register. 16 x 32 bit ints.
+constexpr int kNumOutputsPerRegister = 16;
+// Maximum number of registers that we will use.
+constexpr int kMaxOutputRegisters = 8;
+// Number of inputs in the inputs register.
+constexpr int kNumInputsPerRegister = 64;
+// Number of inputs in each weight group.
+constexpr int kNumInputsPerGroup = 4;
+
+// Functions to compute part of a matrix.vector multiplication. The weights
+// are in a very specific order (see intsimdmatrix.h) in w, which is multiplied
+// by u of length num_in, to produce output v after scaling the integer results
+// by the corresponding member of scales.
+// The amount of w and scales consumed is fixed and not available to the
+// caller. The number of outputs written to v will be at most num_out.
+
+// Computes one set of 4x16 products of inputs and weights, adding to result.
+// Horizontally adds 4 adjacent results, making 16x32-bit results.
+// rep_input is assumed to be a 16x replicated set of 4x8-bit signed integers.
+// Note that wi must previously have been re-organized with blocks of 4x16
+// weights in contiguous memory.
+// ones is a register of 32x16-bit values all equal to 1, which is only used
+// when VNNI is not available.
+// Note: wi is incremented by the amount of data read.
+static inline void MultiplyGroup(const __m512i& rep_input, const __m512i& ones,
+                                 const int8_t*& wi, __m512i& result) {
+  // Load a 4x16 block of weights.
+  __m512i weights = _mm512_loadu_si512(reinterpret_cast<const void*>(wi));
+  wi += kNumInputsPerRegister;
+  // Normalize the signs on rep_input, weights, so weights is always +ve.
+  // There is no 512 bit version of _mm256_sign_epi8, so negate the inputs
+  // wherever the weight is negative and take the absolute value of weights.
+  __mmask64 negative = _mm512_movepi8_mask(weights);
+  __m512i reps = _mm512_mask_sub_epi8(rep_input, negative,
+                                      _mm512_setzero_si512(), rep_input);
+  weights = _mm512_abs_epi8(weights);
+#if defined(__AVX512VNNI__)
+  // Multiply 64x8-bit unsigned weights by 64x8-bit signed reps and add each
+  // group of 4 adjacent products straight into the 16x32-bit result.
+  result = _mm512_dpbusd_epi32(result, weights, reps);
+  (void)ones;
+#else
+  // Multiply 64x8-bit reps by 64x8-bit weights to make 32x16-bit results,
+  // with adjacent pairs added.
+  weights = _mm512_maddubs_epi16(weights, reps);
+  // Multiply 32x16-bit result by 32x16-bit ones to make 16x32-bit results,
+  // with adjacent pairs added.
+  weights = _mm512_madd_epi16(weights, ones);
+  result = _mm512_add_epi32(result, weights);
+#endif
+}
+
+// Converts 8 32-bit results from result, adding the bias from wi and scaling
+// by scales, before storing the first num_out of them in *v.
+static inline void ExtractHalf(const __m256i& result, const __m128i& bias,
+                               const double* scales, int num_out, double* v) {
+  if (num_out <= 0) return;
+  const __mmask8 mask = static_cast<__mmask8>(
+      num_out >= 8 ? 0xff : (1u << num_out) - 1);
+  __m512d res = _mm512_cvtepi32_pd(result);
+  __m512d b = _mm512_cvtepi32_pd(_mm256_cvtepi8_epi32(bias));
+  __m512d s = _mm512_maskz_loadu_pd(mask, scales);
+  res = _mm512_div_pd(res, _mm512_set1_pd(INT8_MAX));
+  res = _mm512_mul_pd(_mm512_add_pd(res, b), s);
+  _mm512_mask_storeu_pd(v, mask, res);
+}
+
+// Extracts and converts 16x32-bit results from result, adding the bias from wi
+// and scaling by scales, before storing in *v. Note that wi, scales and v are
+// expected to contain 16 consecutive elements or num_out if less.
+static inline void ExtractResults(const __m512i& result, const int8_t*& wi,
+                                  const double*& scales, int num_out,
+                                  double*& v) {
+  // The shaped weights always contain a full register of bias weights.
+  __m128i bias = _mm_loadu_si128(reinterpret_cast<const __m128i*>(wi));
+  ExtractHalf(_mm512_extracti64x4_epi64(result, 0), bias, scales, num_out, v);
+  ExtractHalf(_mm512_extracti64x4_epi64(result, 1), _mm_srli_si128(bias, 8),
+              scales + 8, num_out - 8, v + 8);
+  wi += kNumOutputsPerRegister;
+  scales += kNumOutputsPerRegister;
+  v += kNumOutputsPerRegister;
+}
+
+// Computes part of matrix.vector v = Wu. Computes N=16*kNumRegisters results.
+// The weights *must* be arranged so that consecutive reads from wi
+// provides (num_in/kNumInputsPerGroup groups of (N output dim groups of
+// (kNumInputsPerGroup inputs))). After that there must be N consecutive
+// bias weights, before continuing with any more weights.
+// u must be padded out with zeros to
+// kNumInputsPerGroup*ceil(num_in/kNumInputsPerGroup) elements.
+template <int kNumRegisters>
+static void PartialMatrixDotVector(const int8_t* wi, const double* scales,
+                                   const int8_t* u, int num_in, int num_out,
+                                   double* v) {
+  // Register containing 16-bit ones for horizontal add with 16->32 bit
+  // conversion.
+  const __m512i ones = _mm512_set1_epi16(1);
+  // Initialize all the results to 0.
+  __m512i results[kNumRegisters];
+  for (int r = 0; r < kNumRegisters; ++r) results[r] = _mm512_setzero_si512();
+  // Iterate over the input (u), one group of kNumInputsPerGroup at a time.
+  for (int j = 0; j < num_in; j += kNumInputsPerGroup) {
+    // Replicate the 32 bits (4 inputs) 16 times.
+    int32_t group;
+    memcpy(&group, u + j, sizeof(group));
+    const __m512i rep_input = _mm512_set1_epi32(group);
+    // Mul-add, with horizontal add of the 4 inputs to each of the results.
+    for (int r = 0; r < kNumRegisters; ++r) {
+      MultiplyGroup(rep_input, ones, wi, results[r]);
+    }
+  }
+  for (int r = 0; r < kNumRegisters; ++r) {
+    ExtractResults(results[r], wi, scales,
+                   std::min(kNumOutputsPerRegister, num_out), v);
+    num_out -= kNumOutputsPerRegister;
+  }
+}
+
+// Computes matrix.matrix v_t = Wu_t for num_vectors inputs u_t, which are
+// u_stride apart in u, writing the results v_stride apart in v. Each block of
+// weights is applied to all the inputs before moving to the next block, so it
+// is only read from memory once.
+static void matrixDotMatrix(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u,
+                            int u_stride, int num_vectors, double* v,
+                            int v_stride) {
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  // Each call to a partial_func_ produces group_size outputs, except the
+  // last one, which can produce less.
+  const int rounded_num_in =
+    IntSimdMatrix::Roundup(num_in, kNumInputsPerGroup);
+  const int rounded_num_out =
+    IntSimdMatrix::Roundup(num_out, kNumOutputsPerRegister);
+  int group_size = kNumOutputsPerRegister * kMaxOutputRegisters;
+  int output = 0;
+
+  int w_step = (rounded_num_in + 1) * group_size;
+
+  // Run with this group size, until it would produce too much output, then
+  // switch to a smaller size.
+  for (; output + group_size <= rounded_num_out; output += group_size) {
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector<8>(wi, scales, u + t * u_stride, rounded_num_in,
+                                num_out - output, v + t * v_stride);
+    }
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+  }
+  group_size /= 2;
+  w_step /= 2;
+
+  for (; output + group_size <= rounded_num_out; output += group_size) {
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector<4>(wi, scales, u + t * u_stride, rounded_num_in,
+                                num_out - output, v + t * v_stride);
+    }
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+  }
+  group_size /= 2;
+  w_step /= 2;
+
+  for (; output + group_size <= rounded_num_out; output += group_size) {
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector<2>(wi, scales, u + t * u_stride, rounded_num_in,
+                                num_out - output, v + t * v_stride);
+    }
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+  }
+  group_size /= 2;
+  w_step /= 2;
+
+  for (; output + group_size <= rounded_num_out; output += group_size) {
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector<1>(wi, scales, u + t * u_stride, rounded_num_in,
+                                num_out - output, v + t * v_stride);
+    }
+    wi += w_step;
+    scales += group_size;
+    v += group_size;
+  }
+}
+
+static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u, double* v) {
+  matrixDotMatrix(dim1, dim2, wi, scales, u, 0, 1, v, 0);
+}
+
+#if defined(__AVX512VNNI__)
+const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX512VNNI = {
+#else
+const IntSimdMatrix IntSimdMatrix::intSimdMatrixAVX512 = {
+#endif
+  // Functions.
+  matrixDotVector,
+  matrixDotMatrix,
+  // Number of 32 bit outputs held in each register.
+  kNumOutputsPerRegister,
+  // Maximum number of registers that we will use to hold outputs.
+  kMaxOutputRegisters,
+  // Number of 8 bit inputs in the inputs register.
+  kNumInputsPerRegister,
+  // Number of inputs in each weight group.
+  kNumInputsPerGroup,
+  // No device functions.
+  nullptr,
+  nullptr,
+  nullptr
+};
+
+}  // namespace tesseract.
@@ -0,0 +1,25 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixavx512vnni.cpp
+// Description: matrix-vector product for 8-bit data on avx512 with vnni.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX512VNNI__)
+#error Implementation only for AVX512VNNI capable architectures
+#endif
+
+// The same kernel as intSimdMatrixAVX512, which multiplies with vpdpbusd
+// when compiled with VNNI, defining intSimdMatrixAVX512VNNI instead. It is a
+// separate translation unit, so that a build with VNNI still runs the plain
+// AVX512 kernel on a CPU without it.
+#include "intsimdmatrixavx512.cpp"
@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intsimdmatrixneon.cpp
+// Description: NEON implementation of 8-bit int SIMD matrix multiply.
+//
+// (C) Copyright 2017, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__ARM_NEON)
+#error Implementation only for NEON capable architectures
+#endif
+
+#include "intsimdmatrix.h"
+
+#include <arm_neon.h>
+#include <cstdint>
+
+namespace tesseract {
+
+// Number of 8 bit inputs consumed by each step of IntDotProductNEON.
+constexpr int kNumInputsPerStep = 16;
+
+// Adds the 4 32 bit sums in sum horizontally.
+static inline int32_t HorizontalSum(int32x4_t sum) {
+#if defined(__aarch64__)
+  return vaddvq_s32(sum);
+#else
+  int32x2_t pair = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+  pair = vpadd_s32(pair, pair);
+  return vget_lane_s32(pair, 0);
+#endif
+}
+
+// Computes and returns the dot product of the n-vectors u and v.
+// Uses ARM NEON intrinsics to access the SIMD instruction set.
+static int32_t IntDotProductNEON(const int8_t* u, const int8_t* v, int n) {
+  int max_offset = n - kNumInputsPerStep;
+  int offset = 0;
+  int32x4_t sum = vdupq_n_s32(0);
+  while (offset <= max_offset) {
+    int8x16_t packed1 = vld1q_s8(u + offset);
+    int8x16_t packed2 = vld1q_s8(v + offset);
+    offset += kNumInputsPerStep;
+#if defined(__ARM_FEATURE_DOTPROD)
+    // Multiply 16 pairs of 8 bit ints and add each group of 4 adjacent
+    // products into the 4 32 bit sums.
+    sum = vdotq_s32(sum, packed1, packed2);
+#else
+    // Multiply 8 pairs of 8 bit ints to make 16 bit results, which are then
+    // added in adjacent pairs to the 4 32 bit sums. The two halves are
+    // widened separately, so the 16 bit products can never overflow.
+    int16x8_t low = vmull_s8(vget_low_s8(packed1), vget_low_s8(packed2));
+    int16x8_t high = vmull_s8(vget_high_s8(packed1), vget_high_s8(packed2));
+    sum = vpadalq_s16(sum, low);
+    sum = vpadalq_s16(sum, high);
+#endif
+  }
+  int32_t result = HorizontalSum(sum);
+  while (offset < n) {
+    result += u[offset] * v[offset];
+    ++offset;
+  }
+  return result;
+}
+
+// Computes part of matrix.vector v = Wu. Computes 1 result.
+static void PartialMatrixDotVector1(const int8_t* wi, const double* scales,
+                                    const int8_t* u, int num_in,
+                                    double* v) {
+  double total = IntDotProductNEON(u, wi, num_in);
+  // Add in the bias and correct for integer values.
+  *v = (total / INT8_MAX + wi[num_in]) * *scales;
+}
+
+// Computes matrix.matrix v_t = Wu_t for num_vectors inputs u_t, which are
+// u_stride apart in u, writing the results v_stride apart in v. Each row of
+// weights is applied to all the inputs while it is in cache.
+static void matrixDotMatrix(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u,
+                            int u_stride, int num_vectors, double* v,
+                            int v_stride) {
+  const int num_out = dim1;
+  const int num_in = dim2 - 1;
+  int output = 0;
+
+  for (; output < num_out; output++) {
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector1(wi, scales, u + t * u_stride, num_in,
+                              v + t * v_stride);
+    }
+    wi += dim2;
+    scales++;
+    v++;
+  }
+}
+
+static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u, double* v) {
+  matrixDotMatrix(dim1, dim2, wi, scales, u, 0, 1, v, 0);
+}
+
+const IntSimdMatrix IntSimdMatrix::intSimdMatrixNEON = {
+  // Functions.
+  matrixDotVector,
+  matrixDotMatrix,
+  // Number of 32 bit outputs held in each register.
+  1,
+  // Maximum number of registers that we will use to hold outputs.
+  1,
+  // Number of 8 bit inputs in the inputs register.
+  1,
+  // Number of inputs in each weight group.
+  1,
+  // No device functions.
+  nullptr,
+  nullptr,
+  nullptr
+};
+
+}  // namespace tesseract.
@@ -76,22 +76,37 @@ static void PartialMatrixDotVector1(const int8_t* wi, const double* scales,
   *v = (total / INT8_MAX + wi[num_in]) * *scales;
 }
 
-static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
-                            const double* scales, const int8_t* u, double* v) {
+// Computes matrix.matrix v_t = Wu_t for num_vectors inputs u_t, which are
+// u_stride apart in u, writing the results v_stride apart in v. Each row of
+// weights is applied to all the inputs while it is in cache.
+static void matrixDotMatrix(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u,
+                            int u_stride, int num_vectors, double* v,
+                            int v_stride) {
   const int num_out = dim1;
   const int num_in = dim2 - 1;
   int output = 0;
 
   for (; output < num_out; output++) {
-    PartialMatrixDotVector1(wi, scales, u, num_in, v);
+    for (int t = 0; t < num_vectors; ++t) {
+      PartialMatrixDotVector1(wi, scales, u + t * u_stride, num_in,
+                              v + t * v_stride);
+    }
     wi += dim2;
     scales++;
     v++;
   }
 }
 
+static void matrixDotVector(int dim1, int dim2, const int8_t* wi,
+                            const double* scales, const int8_t* u, double* v) {
+  matrixDotMatrix(dim1, dim2, wi, scales, u, 0, 1, v, 0);
+}
+
 const IntSimdMatrix IntSimdMatrix::intSimdMatrixSSE = {
+  // Functions.
   matrixDotVector,
+  matrixDotMatrix,
   // Number of 32 bit outputs held in each register.
   1,
   // Maximum number of registers that we will use to hold outputs.
@@ -99,7 +114,11 @@ const IntSimdMatrix IntSimdMatrix::intSimdMatrixSSE = {
   // Number of 8 bit inputs in the inputs register.
   1,
   // Number of inputs in each weight group.
-  1
+  1,
+  // No device functions.
+  nullptr,
+  nullptr,
+  nullptr
 };
 
 }  // namespace tesseract.
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////
+// File:        quantize.h
+// Description: Architecture-specific conversion between double and int8_t.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_QUANTIZE_H_
+#define TESSERACT_ARCH_QUANTIZE_H_
+
+#include <cstdint>
+
+namespace tesseract {
+
+// Vector versions of the conversions used by NetworkIO in int mode, which
+// give exactly the same results as the scalar code.
+// Quantize puts ClipToRange(IntCastRounded(u[i] * INT8_MAX), -INT8_MAX,
+// INT8_MAX) in out[i], for n values of u.
+// Dequantize puts u[i] / INT8_MAX in out[i], and DequantizeAdd adds it to
+// inout[i].
+void QuantizeAVX2(const double* u, int n, int8_t* out);
+void DequantizeAVX2(const int8_t* u, int n, double* out);
+void DequantizeAddAVX2(const int8_t* u, int n, double* inout);
+
+void QuantizeSSE(const double* u, int n, int8_t* out);
+void DequantizeSSE(const int8_t* u, int n, double* out);
+void DequantizeAddSSE(const int8_t* u, int n, double* inout);
+
+void QuantizeNEON(const double* u, int n, int8_t* out);
+void DequantizeNEON(const int8_t* u, int n, double* out);
+void DequantizeAddNEON(const int8_t* u, int n, double* inout);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_QUANTIZE_H_
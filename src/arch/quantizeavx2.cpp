@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////
+// File:        quantizeavx2.cpp
+// Description: Conversion between double and int8_t for avx2.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#error Implementation only for AVX2 capable architectures
+#endif
+
+#include <immintrin.h>
+#include "helpers.h"
+#include "quantize.h"
+
+namespace tesseract {
+
+// Number of values converted in each iteration.
+constexpr int kNumValues = 8;
+
+// Converts 4 doubles to int32 as ClipToRange(IntCastRounded(x * INT8_MAX)).
+// Clipping before rounding gives the same result, and rounding half away
+// from zero is done by adding +/-0.5 and truncating.
+static inline __m128i Quantize4(const double* u) {
+  const __m256d kMax = _mm256_set1_pd(INT8_MAX);
+  __m256d x = _mm256_mul_pd(_mm256_loadu_pd(u), kMax);
+  x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-INT8_MAX)), kMax);
+  __m256d half = _mm256_or_pd(_mm256_and_pd(x, _mm256_set1_pd(-0.0)),
+                              _mm256_set1_pd(0.5));
+  return _mm256_cvttpd_epi32(_mm256_add_pd(x, half));
+}
+
+// Converts 4 int8_t from the low bytes of bytes to double and divides by
+// INT8_MAX.
+static inline __m256d Dequantize4(__m128i bytes) {
+  return _mm256_div_pd(_mm256_cvtepi32_pd(_mm_cvtepi8_epi32(bytes)),
+                       _mm256_set1_pd(INT8_MAX));
+}
+
+void QuantizeAVX2(const double* u, int n, int8_t* out) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    __m128i words = _mm_packs_epi32(Quantize4(u + i), Quantize4(u + i + 4));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packs_epi16(words, words));
+  }
+  for (; i < n; ++i) {
+    out[i] = ClipToRange<int>(IntCastRounded(u[i] * INT8_MAX), -INT8_MAX,
+                              INT8_MAX);
+  }
+}
+
+void DequantizeAVX2(const int8_t* u, int n, double* out) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + i));
+    _mm256_storeu_pd(out + i, Dequantize4(bytes));
+    _mm256_storeu_pd(out + i + 4, Dequantize4(_mm_srli_si128(bytes, 4)));
+  }
+  for (; i < n; ++i) {
+    out[i] = static_cast<double>(u[i]) / INT8_MAX;
+  }
+}
+
+void DequantizeAddAVX2(const int8_t* u, int n, double* inout) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + i));
+    _mm256_storeu_pd(inout + i, _mm256_add_pd(_mm256_loadu_pd(inout + i),
+                                              Dequantize4(bytes)));
+    _mm256_storeu_pd(inout + i + 4,
+                     _mm256_add_pd(_mm256_loadu_pd(inout + i + 4),
+                                   Dequantize4(_mm_srli_si128(bytes, 4))));
+  }
+  for (; i < n; ++i) {
+    inout[i] += static_cast<double>(u[i]) / INT8_MAX;
+  }
+}
+
+}  // namespace tesseract.
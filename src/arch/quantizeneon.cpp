@@ -0,0 +1,107 @@
+///////////////////////////////////////////////////////////////////////
+// File:        quantizeneon.cpp
+// Description: Conversion between double and int8_t for ARM NEON.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__ARM_NEON)
+#error Implementation only for NEON capable architectures
+#endif
+
+#include "quantize.h"
+
+// Double precision NEON is only available on aarch64.
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+#include "helpers.h"
+
+namespace tesseract {
+
+// Number of values converted in each iteration.
+constexpr int kNumValues = 8;
+
+// Converts 2 doubles to int64 as ClipToRange(IntCastRounded(x * INT8_MAX)).
+// Clipping before rounding gives the same result, and rounding half away
+// from zero is done by adding +/-0.5 and truncating.
+static inline int64x2_t Quantize2(const double* u) {
+  const float64x2_t kMax = vdupq_n_f64(INT8_MAX);
+  float64x2_t x = vmulq_f64(vld1q_f64(u), kMax);
+  x = vminq_f64(vmaxq_f64(x, vdupq_n_f64(-INT8_MAX)), kMax);
+  uint64x2_t sign = vandq_u64(vreinterpretq_u64_f64(x),
+                              vdupq_n_u64(0x8000000000000000ULL));
+  float64x2_t half = vreinterpretq_f64_u64(
+      vorrq_u64(sign, vreinterpretq_u64_f64(vdupq_n_f64(0.5))));
+  return vcvtq_s64_f64(vaddq_f64(x, half));
+}
+
+// Converts 2 int32 to double and divides by INT8_MAX.
+static inline float64x2_t Dequantize2(int32x2_t ints) {
+  return vdivq_f64(vcvtq_f64_s64(vmovl_s32(ints)), vdupq_n_f64(INT8_MAX));
+}
+
+void QuantizeNEON(const double* u, int n, int8_t* out) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    int32x4_t low = vcombine_s32(vmovn_s64(Quantize2(u + i)),
+                                 vmovn_s64(Quantize2(u + i + 2)));
+    int32x4_t high = vcombine_s32(vmovn_s64(Quantize2(u + i + 4)),
+                                  vmovn_s64(Quantize2(u + i + 6)));
+    int16x8_t words = vcombine_s16(vmovn_s32(low), vmovn_s32(high));
+    vst1_s8(out + i, vmovn_s16(words));
+  }
+  for (; i < n; ++i) {
+    out[i] = ClipToRange<int>(IntCastRounded(u[i] * INT8_MAX), -INT8_MAX,
+                              INT8_MAX);
+  }
+}
+
+void DequantizeNEON(const int8_t* u, int n, double* out) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    int16x8_t words = vmovl_s8(vld1_s8(u + i));
+    int32x4_t low = vmovl_s16(vget_low_s16(words));
+    int32x4_t high = vmovl_s16(vget_high_s16(words));
+    vst1q_f64(out + i, Dequantize2(vget_low_s32(low)));
+    vst1q_f64(out + i + 2, Dequantize2(vget_high_s32(low)));
+    vst1q_f64(out + i + 4, Dequantize2(vget_low_s32(high)));
+    vst1q_f64(out + i + 6, Dequantize2(vget_high_s32(high)));
+  }
+  for (; i < n; ++i) {
+    out[i] = static_cast<double>(u[i]) / INT8_MAX;
+  }
+}
+
+void DequantizeAddNEON(const int8_t* u, int n, double* inout) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    int16x8_t words = vmovl_s8(vld1_s8(u + i));
+    int32x4_t low = vmovl_s16(vget_low_s16(words));
+    int32x4_t high = vmovl_s16(vget_high_s16(words));
+    double* v = inout + i;
+    vst1q_f64(v, vaddq_f64(vld1q_f64(v), Dequantize2(vget_low_s32(low))));
+    vst1q_f64(v + 2,
+              vaddq_f64(vld1q_f64(v + 2), Dequantize2(vget_high_s32(low))));
+    vst1q_f64(v + 4,
+              vaddq_f64(vld1q_f64(v + 4), Dequantize2(vget_low_s32(high))));
+    vst1q_f64(v + 6,
+              vaddq_f64(vld1q_f64(v + 6), Dequantize2(vget_high_s32(high))));
+  }
+  for (; i < n; ++i) {
+    inout[i] += static_cast<double>(u[i]) / INT8_MAX;
+  }
+}
+
+}  // namespace tesseract.
+
+#endif  // __aarch64__
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////
+// File:        quantizesse.cpp
+// Description: Conversion between double and int8_t for SSE4.1.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__SSE4_1__)
+#error Implementation only for SSE 4.1 capable architectures
+#endif
+
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <cstring>
+#include "helpers.h"
+#include "quantize.h"
+
+namespace tesseract {
+
+// Number of values converted in each iteration.
+constexpr int kNumValues = 4;
+
+// Converts 2 doubles to int32 as ClipToRange(IntCastRounded(x * INT8_MAX)),
+// in the low half of the result.
+// Clipping before rounding gives the same result, and rounding half away
+// from zero is done by adding +/-0.5 and truncating.
+static inline __m128i Quantize2(const double* u) {
+  const __m128d kMax = _mm_set1_pd(INT8_MAX);
+  __m128d x = _mm_mul_pd(_mm_loadu_pd(u), kMax);
+  x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(-INT8_MAX)), kMax);
+  __m128d half = _mm_or_pd(_mm_and_pd(x, _mm_set1_pd(-0.0)),
+                           _mm_set1_pd(0.5));
+  return _mm_cvttpd_epi32(_mm_add_pd(x, half));
+}
+
+// Converts 2 int8_t from the low bytes of bytes to double and divides by
+// INT8_MAX.
+static inline __m128d Dequantize2(__m128i bytes) {
+  return _mm_div_pd(_mm_cvtepi32_pd(_mm_cvtepi8_epi32(bytes)),
+                    _mm_set1_pd(INT8_MAX));
+}
+
+// Loads 4 bytes into the low bytes of a register.
+static inline __m128i Load4(const int8_t* u) {
+  int32_t bytes;
+  memcpy(&bytes, u, sizeof(bytes));
+  return _mm_cvtsi32_si128(bytes);
+}
+
+void QuantizeSSE(const double* u, int n, int8_t* out) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    __m128i ints = _mm_unpacklo_epi64(Quantize2(u + i), Quantize2(u + i + 2));
+    __m128i words = _mm_packs_epi32(ints, ints);
+    int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(words, words));
+    memcpy(out + i, &bytes, sizeof(bytes));
+  }
+  for (; i < n; ++i) {
+    out[i] = ClipToRange<int>(IntCastRounded(u[i] * INT8_MAX), -INT8_MAX,
+                              INT8_MAX);
+  }
+}
+
+void DequantizeSSE(const int8_t* u, int n, double* out) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    __m128i bytes = Load4(u + i);
+    _mm_storeu_pd(out + i, Dequantize2(bytes));
+    _mm_storeu_pd(out + i + 2, Dequantize2(_mm_srli_si128(bytes, 2)));
+  }
+  for (; i < n; ++i) {
+    out[i] = static_cast<double>(u[i]) / INT8_MAX;
+  }
+}
+
+void DequantizeAddSSE(const int8_t* u, int n, double* inout) {
+  int i = 0;
+  for (; i + kNumValues <= n; i += kNumValues) {
+    __m128i bytes = Load4(u + i);
+    _mm_storeu_pd(inout + i,
+                  _mm_add_pd(_mm_loadu_pd(inout + i), Dequantize2(bytes)));
+    _mm_storeu_pd(inout + i + 2,
+                  _mm_add_pd(_mm_loadu_pd(inout + i + 2),
+                             Dequantize2(_mm_srli_si128(bytes, 2))));
+  }
+  for (; i < n; ++i) {
+    inout[i] += static_cast<double>(u[i]) / INT8_MAX;
+  }
+}
+
+}  // namespace tesseract.
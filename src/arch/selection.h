@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////
+// File:        selection.h
+// Description: Vectorized searches for values above a threshold and for
+//              dawg edges.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_SELECTION_H_
+#define TESSERACT_ARCH_SELECTION_H_
+
+#include <cstdint>  // for int32_t
+
+namespace tesseract {
+
+// Returns the index of the first of the n values of u that is greater than
+// threshold, or n if there is none. Used to skip quickly over the outputs
+// that can't be in the top-n of a softmax.
+int FindAboveAVX2(const float* u, int n, float threshold);
+
+int FindAboveNEON(const float* u, int n, float threshold);
+
+// Returns the index of the first of keys for which (keys[i] & mask) == key,
+// or which has its low bit set, which marks the end of the search. keys may
+// be read up to 7 past the returned index. Used to search the edges of a
+// node of a SquishedDawg.
+int FindKeyAVX2(const int32_t* keys, int32_t key, int32_t mask);
+
+int FindKeyNEON(const int32_t* keys, int32_t key, int32_t mask);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_SELECTION_H_
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////
+// File:        selectionavx2.cpp
+// Description: Vectorized searches for values above a threshold and for
+//              dawg edges for avx2.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#error Implementation only for AVX2 capable architectures
+#endif
+
+#include <immintrin.h>
+#include "selection.h"
+
+namespace tesseract {
+
+// Number of floats compared in each iteration.
+constexpr int kNumFloats = 8;
+
+int FindAboveAVX2(const float* u, int n, float threshold) {
+  const __m256 limit = _mm256_set1_ps(threshold);
+  int i = 0;
+  for (; i + 2 * kNumFloats <= n; i += 2 * kNumFloats) {
+    __m256 above0 = _mm256_cmp_ps(_mm256_loadu_ps(u + i), limit, _CMP_GT_OQ);
+    __m256 above1 = _mm256_cmp_ps(_mm256_loadu_ps(u + i + kNumFloats), limit,
+                                  _CMP_GT_OQ);
+    // The rare block with a value above the threshold is searched below.
+    if (_mm256_movemask_ps(_mm256_or_ps(above0, above1)) != 0) break;
+  }
+  for (; i < n; ++i) {
+    if (u[i] > threshold) return i;
+  }
+  return n;
+}
+
+// Number of keys compared in each iteration.
+constexpr int kNumKeys = 8;
+
+int FindKeyAVX2(const int32_t* keys, int32_t key, int32_t mask) {
+  const __m256i target = _mm256_set1_epi32(key);
+  const __m256i masks = _mm256_set1_epi32(mask);
+  const __m256i ends = _mm256_set1_epi32(1);
+  int i = 0;
+  for (;; i += kNumKeys) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+    __m256i found = _mm256_or_si256(
+        _mm256_cmpeq_epi32(_mm256_and_si256(v, masks), target),
+        _mm256_cmpeq_epi32(_mm256_and_si256(v, ends), ends));
+    if (!_mm256_testz_si256(found, found)) break;
+  }
+  while ((keys[i] & mask) != key && (keys[i] & 1) == 0) ++i;
+  return i;
+}
+
+}  // namespace tesseract.
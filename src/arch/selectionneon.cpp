@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////
+// File:        selectionneon.cpp
+// Description: Vectorized searches for values above a threshold and for
+//              dawg edges for ARM NEON.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__ARM_NEON)
+#error Implementation only for NEON capable architectures
+#endif
+
+#include <arm_neon.h>
+#include "selection.h"
+
+namespace tesseract {
+
+// Number of floats compared in each iteration.
+constexpr int kNumFloats = 8;
+
+int FindAboveNEON(const float* u, int n, float threshold) {
+  const float32x4_t limit = vdupq_n_f32(threshold);
+  int i = 0;
+  for (; i + kNumFloats <= n; i += kNumFloats) {
+    uint32x4_t above = vorrq_u32(vcgtq_f32(vld1q_f32(u + i), limit),
+                                 vcgtq_f32(vld1q_f32(u + i + 4), limit));
+    uint32x2_t any = vorr_u32(vget_low_u32(above), vget_high_u32(above));
+    // The rare block with a value above the threshold is searched below.
+    if (vget_lane_u32(vpmax_u32(any, any), 0) != 0) break;
+  }
+  for (; i < n; ++i) {
+    if (u[i] > threshold) return i;
+  }
+  return n;
+}
+
+// Number of keys compared in each iteration.
+constexpr int kNumKeys = 4;
+
+int FindKeyNEON(const int32_t* keys, int32_t key, int32_t mask) {
+  const int32x4_t target = vdupq_n_s32(key);
+  const int32x4_t masks = vdupq_n_s32(mask);
+  const int32x4_t ends = vdupq_n_s32(1);
+  int i = 0;
+  for (;; i += kNumKeys) {
+    int32x4_t v = vld1q_s32(keys + i);
+    uint32x4_t found = vorrq_u32(vceqq_s32(vandq_s32(v, masks), target),
+                                 vceqq_s32(vandq_s32(v, ends), ends));
+    uint32x2_t any = vorr_u32(vget_low_u32(found), vget_high_u32(found));
+    if (vget_lane_u32(vpmax_u32(any, any), 0) != 0) break;
+  }
+  while ((keys[i] & mask) != key && (keys[i] & 1) == 0) ++i;
+  return i;
+}
+
+}  // namespace tesseract.
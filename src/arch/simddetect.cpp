@@ -15,16 +15,30 @@
 // limitations under the License.
 ///////////////////////////////////////////////////////////////////////
 
+#include <algorithm>         // for std::sort, std::unique
+#include <chrono>            // for std::chrono::steady_clock
+#include <cstring>           // for strcmp
+#include <map>               // for std::map
+#include <mutex>             // for std::mutex
 #include <numeric>           // for std::inner_product
+#include <string>            // for std::string
 #include "simddetect.h"
+#include "activation.h"
+#include "classpruner.h"
 #include "dotproduct.h"
 #include "dotproductavx.h"
+#include "dotproductneon.h"
 #include "dotproductsse.h"
+#include "genericvector.h"   // for GenericVector
 #include "intsimdmatrix.h"   // for IntSimdMatrix
+#include "quantize.h"
+#include "selection.h"
+#include "threshold.h"
+#include "matrix.h"          // for GENERIC_2D_ARRAY
 #include "params.h"   // for STRING_VAR
 #include "tprintf.h"  // for tprintf
 
-#if defined(AVX) || defined(AVX2) || defined(SSE4_1)
+#if defined(AVX) || defined(AVX2) || defined(AVX512BW) || defined(SSE4_1)
 # define HAS_CPUID
 #endif
 
@@ -36,6 +50,13 @@
 #endif
 #endif
 
+#if defined(NEON) && defined(__linux__) && !defined(__aarch64__)
+# include <sys/auxv.h>
+# ifndef HWCAP_NEON
+#  define HWCAP_NEON (1 << 12)
+# endif
+#endif
+
 namespace tesseract {
 
 // Computes and returns the dot product of the two n-vectors u and v.
@@ -49,9 +70,23 @@ namespace tesseract {
 // bandwidth constrained and could benefit from holding the reused vector
 // in AVX registers.
 DotProductFunction DotProduct;
+DotProductFloatFunction DotProductFloat;
+ActivationFunction TanhVector;
+ActivationFunction LogisticVector;
+ActivationMultiplyFunction TanhMultiply;
+QuantizeFunction QuantizeVector;
+DequantizeFunction DequantizeVector;
+DequantizeFunction DequantizeAddVector;
+FindAboveFunction FindAbove;
+FindKeyFunction FindKey;
+ClassPrunerFunction AddClassPrunerCounts;
+ConfigEvidenceFunction MaxConfigEvidence;
+ThresholdLineFunction ThresholdLine;
+ThresholdGreyLineFunction ThresholdGreyLine;
 
 static STRING_VAR(dotproduct, "auto",
-                  "Function used for calculation of dot product");
+                  "Function used for calculation of dot product, or fastest "
+                  "to time the available functions on the loaded model");
 
 SIMDDetect SIMDDetect::detector;
 
@@ -60,8 +95,13 @@ bool SIMDDetect::avx_available_;
 bool SIMDDetect::avx2_available_;
 bool SIMDDetect::avx512F_available_;
 bool SIMDDetect::avx512BW_available_;
+bool SIMDDetect::avx512VNNI_available_;
 // If true, then SSe4.1 has been detected.
 bool SIMDDetect::sse_available_;
+// If true, then NEON has been detected.
+bool SIMDDetect::neon_available_;
+// Name of the selected code.
+const char* SIMDDetect::kernel_name_;
 
 // Computes and returns the dot product of the two n-vectors u and v.
 static double DotProductGeneric(const double* u, const double* v, int n) {
@@ -71,24 +111,96 @@ static double DotProductGeneric(const double* u, const double* v, int n) {
 }
 
 // Compute dot product using std::inner_product.
+static float DotProductGeneric(const float* u, const float* v, int n) {
+  float total = 0.0f;
+  for (int k = 0; k < n; ++k) total += u[k] * v[k];
+  return total;
+}
+
 static double DotProductStdInnerProduct(const double* u, const double* v, int n) {
   return std::inner_product(u, u + n, v, 0.0);
 }
 
-static void SetDotProduct(DotProductFunction f, const IntSimdMatrix* m = nullptr) {
+static float DotProductStdInnerProduct(const float* u, const float* v, int n) {
+  return std::inner_product(u, u + n, v, 0.0f);
+}
+
+// Sets the double and float dot products and the int matrix code. The dot
+// product functions are overloaded, so f and ff are usually the same name.
+static void SetDotProduct(DotProductFunction f, DotProductFloatFunction ff,
+                          const IntSimdMatrix* m = nullptr) {
   DotProduct = f;
+  DotProductFloat = ff;
   IntSimdMatrix::intSimdMatrix = m;
 }
 
+// Sets the vectorized activation functions, or resets them to use the scalar
+// code if called without arguments.
+static void SetActivations(
+    ActivationFunction tanh_f = nullptr,
+    ActivationFunction logistic_f = nullptr,
+    ActivationMultiplyFunction tanh_multiply_f = nullptr) {
+  TanhVector = tanh_f;
+  LogisticVector = logistic_f;
+  TanhMultiply = tanh_multiply_f;
+}
+
+// Sets the vectorized conversions between double and int8_t, or resets them
+// to use the scalar code if called without arguments.
+static void SetQuantize(QuantizeFunction quantize_f = nullptr,
+                        DequantizeFunction dequantize_f = nullptr,
+                        DequantizeFunction dequantize_add_f = nullptr) {
+  QuantizeVector = quantize_f;
+  DequantizeVector = dequantize_f;
+  DequantizeAddVector = dequantize_add_f;
+}
+
+// Sets the vectorized searches used to select the top-n outputs and the dawg
+// edges, or resets them to use the scalar code if called without arguments.
+static void SetSelection(FindAboveFunction find_above_f = nullptr,
+                         FindKeyFunction find_key_f = nullptr) {
+  FindAbove = find_above_f;
+  FindKey = find_key_f;
+}
+
+// Sets the vectorized class pruner accumulation and config evidence of the
+// legacy classifier, or resets them to use the scalar code if called without
+// arguments.
+static void SetClassPruner(ClassPrunerFunction class_pruner_f = nullptr,
+                           ConfigEvidenceFunction config_evidence_f = nullptr) {
+  AddClassPrunerCounts = class_pruner_f;
+  MaxConfigEvidence = config_evidence_f;
+}
+
+// Sets the functions for thresholding lines of images, or nullptr for the
+// scalar code.
+static void SetThreshold(
+    ThresholdLineFunction threshold_line_f = nullptr,
+    ThresholdGreyLineFunction threshold_grey_line_f = nullptr) {
+  ThresholdLine = threshold_line_f;
+  ThresholdGreyLine = threshold_grey_line_f;
+}
+
+#if defined(AVX512BW)
+// Returns true if intSimdMatrixAVX512 can run on this system.
+static bool IsAVX512Usable() {
+  return SIMDDetect::IsAVX512FAvailable() && SIMDDetect::IsAVX512BWAvailable();
+}
+#endif
+#if defined(AVX512VNNI)
+// Returns true if intSimdMatrixAVX512VNNI, which uses vpdpbusd, can run on
+// this system.
+static bool IsAVX512VNNIUsable() {
+  return IsAVX512Usable() && SIMDDetect::IsAVX512VNNIAvailable();
+}
+#endif
+
 // Constructor.
 // Tests the architecture in a system-dependent way to detect AVX, SSE and
 // any other available SIMD equipment.
 // __GNUC__ is also defined by compilers that include GNU extensions such as
 // clang.
 SIMDDetect::SIMDDetect() {
-  // The fallback is a generic dot product calculation.
-  SetDotProduct(DotProductGeneric);
-
 #if defined(HAS_CPUID)
 #if defined(__GNUC__)
   unsigned int eax, ebx, ecx, edx;
@@ -108,6 +220,7 @@ SIMDDetect::SIMDDetect() {
       avx2_available_ = (ebx & 0x00000020) != 0;
       avx512F_available_ = (ebx & 0x00010000) != 0;
       avx512BW_available_ = (ebx & 0x40000000) != 0;
+      avx512VNNI_available_ = (ecx & 0x00000800) != 0;
     }
 #endif
   }
@@ -130,86 +243,386 @@ SIMDDetect::SIMDDetect() {
       avx2_available_ = (cpuInfo[1] & 0x00000020) != 0;
       avx512F_available_ = (cpuInfo[1] & 0x00010000) != 0;
       avx512BW_available_ = (cpuInfo[1] & 0x40000000) != 0;
+      avx512VNNI_available_ = (cpuInfo[2] & 0x00000800) != 0;
     }
 #endif
   }
 #else
 #error "I don't know how to test for SIMD with this compiler"
 #endif
+#endif
+
+#if defined(NEON)
+#if defined(__aarch64__)
+  // NEON is a mandatory part of ARMv8-A.
+  neon_available_ = true;
+#elif defined(__linux__)
+  neon_available_ = (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
 #endif
 
   // Select code for calculation of dot product based on autodetection.
+  const char* method = "generic";
   if (false) {
     // This is a dummy to support conditional compilation.
+#if defined(AVX512VNNI)
+  } else if (IsAVX512VNNIUsable()) {
+    // AVX512BW with VNNI detected.
+    method = "avx512vnni";
+#endif
+#if defined(AVX512BW)
+  } else if (IsAVX512Usable()) {
+    // AVX512BW detected.
+    method = "avx512";
+#endif
 #if defined(AVX2)
   } else if (avx2_available_) {
     // AVX2 detected.
-    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVX2);
+    method = "avx2";
 #endif
 #if defined(AVX)
   } else if (avx_available_) {
     // AVX detected.
-    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixSSE);
+    method = "avx";
 #endif
 #if defined(SSE4_1)
   } else if (sse_available_) {
     // SSE detected.
-    SetDotProduct(DotProductSSE, &IntSimdMatrix::intSimdMatrixSSE);
+    method = "sse";
+#endif
+#if defined(NEON)
+  } else if (neon_available_) {
+    // NEON detected.
+    method = "neon";
 #endif
   }
+  SetMethod(method);
 }
 
-void SIMDDetect::Update() {
-  // Select code for calculation of dot product based on the
-  // value of the config variable if that value is not empty.
-  const char* dotproduct_method = "generic";
-  if (!strcmp(dotproduct.string(), "auto")) {
-    // Automatic detection. Nothing to be done.
-  } else if (!strcmp(dotproduct.string(), "generic")) {
-    // Generic code selected by config variable.
-    SetDotProduct(DotProductGeneric);
-    dotproduct_method = "generic";
-  } else if (!strcmp(dotproduct.string(), "native")) {
-    // Native optimized code selected by config variable.
-    SetDotProduct(DotProductNative);
-    dotproduct_method = "native";
+bool SIMDDetect::SetMethod(const char* name) {
+  if (!strcmp(name, "generic")) {
+    SetDotProduct(DotProductGeneric, DotProductGeneric);
+    SetActivations();
+    SetQuantize();
+    SetSelection();
+    SetClassPruner();
+    SetThreshold();
+    kernel_name_ = "generic";
+  } else if (!strcmp(name, "native")) {
+    SetDotProduct(DotProductNative, DotProductNative);
+    SetActivations();
+    SetQuantize();
+    SetSelection();
+    SetClassPruner();
+    SetThreshold();
+    kernel_name_ = "native";
+#if defined(AVX512BW)
+  } else if (!strcmp(name, "avx512") || !strcmp(name, "avx512vnni")) {
+    bool vnni = !strcmp(name, "avx512vnni");
+#if !defined(AVX512VNNI)
+    if (vnni) return false;
+#endif
+    SetDotProduct(DotProductAVX, DotProductAVX,
+#if defined(AVX512VNNI)
+                  vnni ? &IntSimdMatrix::intSimdMatrixAVX512VNNI :
+#endif
+                  &IntSimdMatrix::intSimdMatrixAVX512);
+    SetActivations(TanhVectorAVX512, LogisticVectorAVX512, TanhMultiplyAVX512);
+#if defined(AVX2)
+    SetQuantize(QuantizeAVX2, DequantizeAVX2, DequantizeAddAVX2);
+    SetSelection(FindAboveAVX2, FindKeyAVX2);
+    SetClassPruner(AddClassPrunerCountsAVX2, MaxConfigEvidenceAVX2);
+    SetThreshold(ThresholdLineAVX2, ThresholdGreyLineAVX2);
+#else
+    SetQuantize();
+    SetSelection();
+    SetClassPruner();
+    SetThreshold();
+#endif
+    kernel_name_ = vnni ? "avx512vnni" : "avx512";
+#endif
 #if defined(AVX2)
-  } else if (!strcmp(dotproduct.string(), "avx2")) {
-    // AVX2 selected by config variable.
-    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixAVX2);
-    dotproduct_method = "avx2";
+  } else if (!strcmp(name, "avx2")) {
+    SetDotProduct(DotProductAVX, DotProductAVX,
+                  &IntSimdMatrix::intSimdMatrixAVX2);
+    SetActivations(TanhVectorAVX2, LogisticVectorAVX2, TanhMultiplyAVX2);
+    SetQuantize(QuantizeAVX2, DequantizeAVX2, DequantizeAddAVX2);
+    SetSelection(FindAboveAVX2, FindKeyAVX2);
+    SetClassPruner(AddClassPrunerCountsAVX2, MaxConfigEvidenceAVX2);
+    SetThreshold(ThresholdLineAVX2, ThresholdGreyLineAVX2);
+    kernel_name_ = "avx2";
 #endif
 #if defined(AVX)
-  } else if (!strcmp(dotproduct.string(), "avx")) {
-    // AVX selected by config variable.
-    SetDotProduct(DotProductAVX, &IntSimdMatrix::intSimdMatrixSSE);
-    dotproduct_method = "avx";
+  } else if (!strcmp(name, "avx")) {
+    SetDotProduct(DotProductAVX, DotProductAVX,
+                  &IntSimdMatrix::intSimdMatrixSSE);
+    SetActivations();
+#if defined(SSE4_1)
+    SetQuantize(QuantizeSSE, DequantizeSSE, DequantizeAddSSE);
+    SetThreshold(ThresholdLineSSE, ThresholdGreyLineSSE);
+#else
+    SetQuantize();
+    SetThreshold();
+#endif
+    SetSelection();
+    SetClassPruner();
+    kernel_name_ = "avx";
 #endif
 #if defined(SSE4_1)
-  } else if (!strcmp(dotproduct.string(), "sse")) {
-    // SSE selected by config variable.
-    SetDotProduct(DotProductSSE, &IntSimdMatrix::intSimdMatrixSSE);
-    dotproduct_method = "sse";
-#endif
-  } else if (!strcmp(dotproduct.string(), "std::inner_product")) {
-    // std::inner_product selected by config variable.
-    SetDotProduct(DotProductStdInnerProduct);
-    dotproduct_method = "std::inner_product";
+  } else if (!strcmp(name, "sse")) {
+    SetDotProduct(DotProductSSE, DotProductSSE,
+                  &IntSimdMatrix::intSimdMatrixSSE);
+    SetActivations();
+    SetQuantize(QuantizeSSE, DequantizeSSE, DequantizeAddSSE);
+    SetSelection();
+    SetClassPruner();
+    SetThreshold(ThresholdLineSSE, ThresholdGreyLineSSE);
+    kernel_name_ = "sse";
+#endif
+#if defined(NEON)
+  } else if (!strcmp(name, "neon")) {
+#if defined(__aarch64__)
+    SetDotProduct(DotProductNEON, DotProductNEON,
+                  &IntSimdMatrix::intSimdMatrixNEON);
+    SetActivations(TanhVectorNEON, LogisticVectorNEON, TanhMultiplyNEON);
+    SetQuantize(QuantizeNEON, DequantizeNEON, DequantizeAddNEON);
+    SetSelection(FindAboveNEON, FindKeyNEON);
+    SetClassPruner(AddClassPrunerCountsNEON, MaxConfigEvidenceNEON);
+    SetThreshold();
+#else
+    SetDotProduct(DotProductGeneric, DotProductGeneric,
+                  &IntSimdMatrix::intSimdMatrixNEON);
+    SetActivations();
+    SetQuantize();
+    SetSelection();
+    SetClassPruner();
+    SetThreshold();
+#endif
+    kernel_name_ = "neon";
+#endif
+#if defined(USE_OPENCL)
+  } else if (!strcmp(name, "opencl")) {
+    // The batched int matrix products run on the OpenCL device, and all the
+    // rest on the CPU as with "generic".
+    SetDotProduct(DotProductGeneric, DotProductGeneric,
+                  &IntSimdMatrix::intSimdMatrixOpenCL);
+    SetActivations();
+    SetQuantize();
+    SetSelection();
+    SetClassPruner();
+    SetThreshold();
+    kernel_name_ = "opencl";
+#endif
+  } else if (!strcmp(name, "std::inner_product")) {
+    SetDotProduct(DotProductStdInnerProduct, DotProductStdInnerProduct);
+    SetActivations();
+    SetQuantize();
+    SetSelection();
+    SetClassPruner();
+    SetThreshold();
+    kernel_name_ = "std::inner_product";
   } else {
+    return false;
+  }
+  return true;
+}
+
+std::vector<const char*> SIMDDetect::AvailableMethods() {
+  std::vector<const char*> methods = {"generic", "native", "std::inner_product"};
+#if defined(AVX512VNNI)
+  if (IsAVX512VNNIUsable()) methods.push_back("avx512vnni");
+#endif
+#if defined(AVX512BW)
+  if (IsAVX512Usable()) methods.push_back("avx512");
+#endif
+#if defined(AVX2)
+  if (avx2_available_) methods.push_back("avx2");
+#endif
+#if defined(AVX)
+  if (avx_available_) methods.push_back("avx");
+#endif
+#if defined(SSE4_1)
+  if (sse_available_) methods.push_back("sse");
+#endif
+#if defined(NEON)
+  if (neon_available_) methods.push_back("neon");
+#endif
+  return methods;
+}
+
+void SIMDDetect::Update() {
+  // Select code for calculation of dot product based on the
+  // value of the config variable if that value is not empty.
+  if (!strcmp(dotproduct.string(), "auto")) {
+    // Automatic detection. Nothing to be done.
+    return;
+  } else if (!strcmp(dotproduct.string(), "fastest")) {
+    // Selected by Autotune when a model is loaded. Nothing to be done.
+    return;
+  } else if (!SetMethod(dotproduct.string())) {
     // Unsupported value of config variable.
     tprintf("Warning, ignoring unsupported config variable value: dotproduct=%s\n",
             dotproduct.string());
-    tprintf("Support values for dotproduct: auto generic native"
+    tprintf("Support values for dotproduct: auto fastest generic native"
+#if defined(AVX512VNNI)
+            " avx512vnni"
+#endif
+#if defined(AVX512BW)
+            " avx512"
+#endif
+#if defined(AVX2)
+            " avx2"
+#endif
 #if defined(AVX)
             " avx"
 #endif
 #if defined(SSE4_1)
             " sse"
+#endif
+#if defined(NEON)
+            " neon"
+#endif
+#if defined(USE_OPENCL)
+            " opencl"
 #endif
             " std::inner_product.\n");
   }
 
-  dotproduct.set_value(dotproduct_method);
+  dotproduct.set_value(kernel_name_);
+}
+
+// Receives the timed results, so they are not optimized away.
+static volatile double tune_sink;
+// Guards the selection of code by Autotune against FreezeMethod.
+static std::mutex tune_mutex;
+// Set by FreezeMethod, after which Autotune leaves the selected code alone.
+static bool method_frozen = false;
+
+// Returns the time in seconds taken by the current dot product (or int matrix
+// if int_mode) code to multiply random matrices of the given shapes by a
+// vector, repeated so each shape costs about kTuneMultiplyAdds.
+static double TimeKernel(const std::vector<std::pair<int, int>>& shapes,
+                         bool int_mode) {
+  const int kTuneMultiplyAdds = 1 << 22;
+  const IntSimdMatrix* m = IntSimdMatrix::intSimdMatrix;
+  double total = 0.0;
+  for (const auto& shape : shapes) {
+    const int num_out = shape.first;
+    const int num_in = shape.second;
+    const int reps = std::max(1, kTuneMultiplyAdds / (num_out * (num_in + 1)));
+    std::vector<double> v(m != nullptr ? m->RoundOutputs(num_out) : num_out);
+    double sum = 0.0;
+    std::chrono::steady_clock::duration elapsed;
+    if (int_mode) {
+      GENERIC_2D_ARRAY<int8_t> w(num_out, num_in + 1, 0);
+      for (int i = 0; i < num_out; ++i) {
+        for (int j = 0; j <= num_in; ++j) {
+          w(i, j) = static_cast<int8_t>((i * 31 + j * 17) % 255 - 127);
+        }
+      }
+      GenericVector<double> scales;
+      scales.init_to_size(num_out, 1.0 / INT8_MAX);
+      std::vector<int8_t> shaped_w;
+      if (m != nullptr) m->Init(w, shaped_w);
+      std::vector<int8_t> u(m != nullptr ? m->RoundInputs(num_in) : num_in);
+      for (int j = 0; j < num_in; ++j) u[j] = static_cast<int8_t>(j % 127);
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < reps; ++r) {
+        if (m != nullptr) {
+          m->matrixDotVectorFunction(num_out, num_in + 1, &shaped_w[0],
+                                     &scales[0], &u[0], &v[0]);
+        } else {
+          IntSimdMatrix::MatrixDotVector(w, scales, &u[0], &v[0]);
+        }
+        sum += v[r % num_out];
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+    } else {
+      std::vector<double> w(num_out * (num_in + 1));
+      std::vector<float> wf(w.size());
+      for (size_t i = 0; i < w.size(); ++i) {
+        w[i] = (i % 255) / 255.0 - 0.5;
+        wf[i] = static_cast<float>(w[i]);
+      }
+      std::vector<double> u(w.begin(), w.begin() + num_in);
+      std::vector<float> uf(wf.begin(), wf.begin() + num_in);
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < reps; ++r) {
+        for (int i = 0; i < num_out; ++i) {
+          v[i] = DotProduct(&u[0], &w[i * (num_in + 1)], num_in) +
+                 DotProductFloat(&uf[0], &wf[i * (num_in + 1)], num_in);
+        }
+        sum += v[r % num_out];
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+    }
+    // Use the result, so the compiler can't optimize the loop away.
+    tune_sink = sum;
+    total += std::chrono::duration<double>(elapsed).count();
+  }
+  return total;
+}
+
+bool SIMDDetect::AutotunePending() {
+  if (strcmp(dotproduct.string(), "fastest") != 0) return false;
+  std::lock_guard<std::mutex> lock(tune_mutex);
+  return !method_frozen;
+}
+
+void SIMDDetect::FreezeMethod() {
+  std::lock_guard<std::mutex> lock(tune_mutex);
+  method_frozen = true;
+}
+
+void SIMDDetect::Autotune(const std::vector<std::pair<int, int>>& shapes,
+                          bool int_mode) {
+  if (strcmp(dotproduct.string(), "fastest") != 0) return;
+  // Each distinct shape is timed once.
+  std::vector<std::pair<int, int>> unique_shapes;
+  for (const auto& shape : shapes) {
+    if (shape.first > 0 && shape.second > 0) unique_shapes.push_back(shape);
+  }
+  std::sort(unique_shapes.begin(), unique_shapes.end());
+  unique_shapes.erase(std::unique(unique_shapes.begin(), unique_shapes.end()),
+                      unique_shapes.end());
+  if (unique_shapes.empty()) return;
+  std::string key = int_mode ? "int" : "float";
+  for (const auto& shape : unique_shapes) {
+    key += " " + std::to_string(shape.first) + "x" +
+           std::to_string(shape.second);
+  }
+  static std::map<std::string, const char*> cache;
+  std::lock_guard<std::mutex> lock(tune_mutex);
+  if (method_frozen) {
+    // The int weights of a loaded network are shaped for the selected code,
+    // which may also be running on other threads.
+    tprintf("Keeping dotproduct=%s, as a network is already loaded.\n",
+            kernel_name_);
+    return;
+  }
+  auto cached = cache.find(key);
+  if (cached != cache.end()) {
+    SetMethod(cached->second);
+    return;
+  }
+  std::vector<const char*> methods = AvailableMethods();
+  const char* best_method = kernel_name_;
+  double best_time = 0.0;
+  tprintf("Timing dot product code for %s:", key.c_str());
+  for (const char* method : methods) {
+    SetMethod(method);
+    // The first run warms up the caches and the SIMD units.
+    TimeKernel(unique_shapes, int_mode);
+    double time = TimeKernel(unique_shapes, int_mode);
+    tprintf(" %s=%.3gms", method, time * 1000.0);
+    if (best_time == 0.0 || time < best_time) {
+      best_time = time;
+      best_method = method;
+    }
+  }
+  tprintf("\nSelected dotproduct=%s\n", best_method);
+  SetMethod(best_method);
+  cache[key] = kernel_name_;
 }
 
 }  // namespace tesseract
@@ -17,6 +17,9 @@
 #ifndef TESSERACT_ARCH_SIMDDETECT_H_
 #define TESSERACT_ARCH_SIMDDETECT_H_
 
+#include <cstdint>  // for int8_t, int32_t, uint8_t, uint32_t
+#include <utility>  // for std::pair
+#include <vector>   // for std::vector
 #include "platform.h"
 
 namespace tesseract {
@@ -24,6 +27,62 @@ namespace tesseract {
 // Function pointer for best calculation of dot product.
 using DotProductFunction = double (*)(const double*, const double*, int);
 extern DotProductFunction DotProduct;
+// Function pointer for best calculation of single precision dot product,
+// used by float32 inference.
+using DotProductFloatFunction = float (*)(const float*, const float*, int);
+extern DotProductFloatFunction DotProductFloat;
+// Function pointers for vectorized activation functions applied in-place to
+// n values, and for tanh(u) * v. They are nullptr if there is no SIMD
+// implementation, in which case the scalar functions are used.
+using ActivationFunction = void (*)(int n, double* inout);
+using ActivationMultiplyFunction = void (*)(const double* u, const double* v,
+                                            int n, double* out);
+extern ActivationFunction TanhVector;
+extern ActivationFunction LogisticVector;
+extern ActivationMultiplyFunction TanhMultiply;
+// Function pointers for vectorized conversion of n values between double in
+// [-1, 1] and int8_t, as used by int mode networks. They are nullptr if there
+// is no SIMD implementation, in which case the scalar code is used.
+using QuantizeFunction = void (*)(const double* u, int n, int8_t* out);
+using DequantizeFunction = void (*)(const int8_t* u, int n, double* out);
+extern QuantizeFunction QuantizeVector;
+extern DequantizeFunction DequantizeVector;
+extern DequantizeFunction DequantizeAddVector;
+// Function pointer for a vectorized search of n values for the first that is
+// greater than a threshold, returning its index, or n if there is none. It is
+// nullptr if there is no SIMD implementation.
+using FindAboveFunction = int (*)(const float* u, int n, float threshold);
+extern FindAboveFunction FindAbove;
+// Function pointer for a vectorized search of dawg edge keys, as
+// FindKeyAVX2 in selection.h. It is nullptr if there is no SIMD
+// implementation.
+using FindKeyFunction = int (*)(const int32_t* keys, int32_t key,
+                                int32_t mask);
+extern FindKeyFunction FindKey;
+using ClassPrunerFunction = void (*)(const uint32_t* const* pruners,
+                                     int num_pruners, const int* offsets,
+                                     int num_offsets, int* counts);
+extern ClassPrunerFunction AddClassPrunerCounts;
+using ConfigEvidenceFunction = void (*)(const uint32_t* config_words,
+                                        const uint8_t* evidence, int n,
+                                        uint8_t* feature_evidence);
+extern ConfigEvidenceFunction MaxConfigEvidence;
+// Function pointer for vectorized thresholding of an image line to 1 bit
+// per pixel, as ThresholdLineAVX2 in threshold.h. It is nullptr if there is
+// no SIMD implementation.
+using ThresholdLineFunction = int (*)(const uint32_t* src_line, int left,
+                                      int width, int num_channels,
+                                      const int* thresholds,
+                                      const int* hi_values,
+                                      uint32_t* dest_line);
+extern ThresholdLineFunction ThresholdLine;
+// Function pointer for thresholding a line of 8 bit bytes in memory order,
+// as ThresholdGreyLineAVX2 in threshold.h. It is nullptr if there is no SIMD
+// implementation.
+using ThresholdGreyLineFunction = int (*)(const uint8_t* src_line, int width,
+                                          int threshold, int hi_value,
+                                          uint32_t* dest_line);
+extern ThresholdGreyLineFunction ThresholdGreyLine;
 
 // Architecture detector. Add code here to detect any other architectures for
 // SIMD-based faster dot product functions. Intended to be a single static
@@ -46,18 +105,56 @@ class SIMDDetect {
   static inline bool IsAVX512BWAvailable() {
     return detector.avx512BW_available_;
   }
+  // Returns true if AVX512 Vector Neural Network Instructions are available.
+  static inline bool IsAVX512VNNIAvailable() {
+    return detector.avx512VNNI_available_;
+  }
+  // Returns true if NEON is available on this system.
+  static inline bool IsNEONAvailable() {
+    return detector.neon_available_;
+  }
   // Returns true if SSE4.1 is available on this system.
   static inline bool IsSSEAvailable() {
     return detector.sse_available_;
   }
 
+  // Returns the name of the selected dot product and int matrix code, as
+  // accepted by the dotproduct config variable.
+  static inline const char* KernelName() {
+    return detector.kernel_name_;
+  }
+
+  // Returns the values of the dotproduct config variable which select code
+  // that is supported by this build and can run on this system.
+  static TESS_API std::vector<const char*> AvailableMethods();
+
   // Update settings after config variable was set.
   static TESS_API void Update();
 
+  // If the dotproduct config variable is "fastest", times each of the
+  // available implementations on matrices of the given (outputs, inputs)
+  // shapes, and selects the fastest. int_mode selects timing of the int8
+  // matrix code instead of the float dot products. The choice is cached, so
+  // loading another model with the same shapes doesn't repeat the timing.
+  // Must be called before any network is loaded: once FreezeMethod has been
+  // called, the selected code is kept.
+  static TESS_API void Autotune(const std::vector<std::pair<int, int>>& shapes,
+                                bool int_mode);
+  // Returns true if the dotproduct config variable is "fastest" and
+  // FreezeMethod has not been called yet.
+  static TESS_API bool AutotunePending();
+  // Called before a network is loaded for recognition. The int weights are
+  // shaped for the selected code, so Autotune must not change it afterwards.
+  static TESS_API void FreezeMethod();
+
  private:
   // Constructor, must set all static member variables.
   SIMDDetect();
 
+  // Selects the code for the given value of the dotproduct config variable.
+  // Returns false if it is not supported by this build.
+  static bool SetMethod(const char* name);
+
  private:
   // Singleton.
   static SIMDDetect detector;
@@ -66,8 +163,13 @@ class SIMDDetect {
   static TESS_API bool avx2_available_;
   static TESS_API bool avx512F_available_;
   static TESS_API bool avx512BW_available_;
+  static TESS_API bool avx512VNNI_available_;
   // If true, then SSe4.1 has been detected.
   static TESS_API bool sse_available_;
+  // If true, then NEON has been detected.
+  static TESS_API bool neon_available_;
+  // Name of the selected code.
+  static TESS_API const char* kernel_name_;
 };
 
 }  // namespace tesseract
@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////
+// File:        threshold.h
+// Description: Vectorized thresholding of image lines to 1 bit per pixel.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_ARCH_THRESHOLD_H_
+#define TESSERACT_ARCH_THRESHOLD_H_
+
+#include <cstdint>  // for uint8_t, uint32_t
+
+namespace tesseract {
+
+// Thresholds pixels left to left + width - 1 of src_line, a line of a
+// Leptonica image with num_channels bytes per pixel, to bits 0 to width - 1
+// of dest_line, a line of a 1 bit image. A pixel is set (foreground) if any
+// channel ch with hi_values[ch] >= 0 has (value > thresholds[ch]) ==
+// (hi_values[ch] == 0), as in ImageThresholder::ThresholdRectToPix.
+// Only whole words of dest_line are written, and the number of pixels done is
+// returned, leaving the rest of the line to the scalar code. Lines of 1 and 4
+// channels are supported, of 1 channel only for left a multiple of 4.
+int ThresholdLineAVX2(const uint32_t* src_line, int left, int width,
+                      int num_channels, const int* thresholds,
+                      const int* hi_values, uint32_t* dest_line);
+
+int ThresholdLineSSE(const uint32_t* src_line, int left, int width,
+                     int num_channels, const int* thresholds,
+                     const int* hi_values, uint32_t* dest_line);
+
+// Thresholds the first width bytes of src_line, a line of an 8 bit grey image
+// in plain memory order, as a caller's buffer given to
+// ImageThresholder::SetImageView, to bits 0 to width - 1 of dest_line, with
+// the meaning of threshold and hi_value as above. Only whole words of
+// dest_line are written, and the number of pixels done is returned.
+int ThresholdGreyLineAVX2(const uint8_t* src_line, int width, int threshold,
+                          int hi_value, uint32_t* dest_line);
+
+int ThresholdGreyLineSSE(const uint8_t* src_line, int width, int threshold,
+                         int hi_value, uint32_t* dest_line);
+
+// Per byte values for the vectorized compare of a 32 bit word of pixel
+// bytes, in the order of the bytes in memory.
+struct ThresholdBytes {
+  // Returns false if the number of channels is not supported.
+  bool Init(int left, int num_channels, const int* thresholds,
+            const int* hi_values) {
+    if (num_channels == 1 ? left % 4 != 0 : num_channels != 4) return false;
+    thresholds_word = 0;
+    invert_word = 0;
+    enable_word = 0;
+    for (int b = 0; b < 4; ++b) {
+      // GET_DATA_BYTE puts byte n of a word in memory byte 3 - n on little
+      // endian machines, which are the only ones with the SIMD code.
+      int ch = num_channels == 1 ? 0 : 3 - b;
+      if (hi_values[ch] < 0) continue;
+      if (thresholds[ch] < 0 || thresholds[ch] > 255) return false;
+      int shift = 8 * b;
+      enable_word |= 0xffu << shift;
+      thresholds_word |= static_cast<uint32_t>(thresholds[ch]) << shift;
+      // The compare gives value <= threshold, which is the foreground if
+      // hi_value is not 0.
+      if (hi_values[ch] == 0)
+        invert_word |= 0xffu << shift;
+    }
+    return true;
+  }
+
+  uint32_t thresholds_word;
+  uint32_t invert_word;
+  uint32_t enable_word;
+};
+
+// Returns a 1 bit image word from a mask with pixel n in bit n. Leptonica
+// keeps the first pixel of a word in the most significant bit.
+inline uint32_t ReverseBits(uint32_t word) {
+  word = ((word >> 1) & 0x55555555u) | ((word & 0x55555555u) << 1);
+  word = ((word >> 2) & 0x33333333u) | ((word & 0x33333333u) << 2);
+  word = ((word >> 4) & 0x0f0f0f0fu) | ((word & 0x0f0f0f0fu) << 4);
+  word = ((word >> 8) & 0x00ff00ffu) | ((word & 0x00ff00ffu) << 8);
+  return (word >> 16) | (word << 16);
+}
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_ARCH_THRESHOLD_H_
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdavx2.cpp
+// Description: Vectorized thresholding of image lines for avx2.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__AVX2__)
+#error Implementation only for AVX2 capable architectures
+#endif
+
+#include <immintrin.h>
+#include "threshold.h"
+
+namespace tesseract {
+
+// Number of pixels in a word of a 1 bit image.
+constexpr int kPixelsPerWord = 32;
+
+// Returns 0xff in each foreground byte of pixels.
+static inline __m256i ForegroundBytes(__m256i pixels, __m256i thresholds,
+                                      __m256i invert, __m256i enable) {
+  __m256i above = _mm256_subs_epu8(pixels, thresholds);
+  __m256i not_above = _mm256_cmpeq_epi8(above, _mm256_setzero_si256());
+  return _mm256_and_si256(_mm256_xor_si256(not_above, invert), enable);
+}
+
+int ThresholdLineAVX2(const uint32_t* src_line, int left, int width,
+                      int num_channels, const int* thresholds,
+                      const int* hi_values, uint32_t* dest_line) {
+  ThresholdBytes bytes;
+  if (!bytes.Init(left, num_channels, thresholds, hi_values)) return 0;
+  const __m256i threshold_vec = _mm256_set1_epi32(bytes.thresholds_word);
+  const __m256i invert = _mm256_set1_epi32(bytes.invert_word);
+  const __m256i enable = _mm256_set1_epi32(bytes.enable_word);
+  const int num_done = width - width % kPixelsPerWord;
+  if (num_channels == 1) {
+    // Puts the bytes of each word in pixel order.
+    const __m256i pixel_order = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(src_line) + left;
+    for (int x = 0; x < num_done; x += kPixelsPerWord) {
+      __m256i pixels =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+      __m256i fg = ForegroundBytes(pixels, threshold_vec, invert, enable);
+      fg = _mm256_shuffle_epi8(fg, pixel_order);
+      dest_line[x / kPixelsPerWord] =
+          ReverseBits(static_cast<uint32_t>(_mm256_movemask_epi8(fg)));
+    }
+  } else {
+    // A pixel is foreground if any of its channels is.
+    const __m256i zero = _mm256_setzero_si256();
+    const uint32_t* src = src_line + left;
+    for (int x = 0; x < num_done; x += kPixelsPerWord) {
+      uint32_t mask = 0;
+      for (int i = 0; i < kPixelsPerWord; i += 8) {
+        __m256i pixels = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(src + x + i));
+        __m256i fg = ForegroundBytes(pixels, threshold_vec, invert, enable);
+        __m256i background = _mm256_cmpeq_epi32(fg, zero);
+        uint32_t bg_mask = _mm256_movemask_ps(_mm256_castsi256_ps(background));
+        mask |= (~bg_mask & 0xffu) << i;
+      }
+      dest_line[x / kPixelsPerWord] = ReverseBits(mask);
+    }
+  }
+  return num_done;
+}
+
+int ThresholdGreyLineAVX2(const uint8_t* src_line, int width, int threshold,
+                          int hi_value, uint32_t* dest_line) {
+  ThresholdBytes bytes;
+  if (!bytes.Init(0, 1, &threshold, &hi_value)) return 0;
+  const __m256i threshold_vec = _mm256_set1_epi32(bytes.thresholds_word);
+  const __m256i invert = _mm256_set1_epi32(bytes.invert_word);
+  const __m256i enable = _mm256_set1_epi32(bytes.enable_word);
+  const int num_done = width - width % kPixelsPerWord;
+  for (int x = 0; x < num_done; x += kPixelsPerWord) {
+    __m256i pixels =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_line + x));
+    __m256i fg = ForegroundBytes(pixels, threshold_vec, invert, enable);
+    dest_line[x / kPixelsPerWord] =
+        ReverseBits(static_cast<uint32_t>(_mm256_movemask_epi8(fg)));
+  }
+  return num_done;
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////
+// File:        thresholdsse.cpp
+// Description: Vectorized thresholding of image lines for SSE4.1.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#if !defined(__SSE4_1__)
+#error Implementation only for SSE 4.1 capable architectures
+#endif
+
+#include <smmintrin.h>
+#include "threshold.h"
+
+namespace tesseract {
+
+// Number of pixels in a word of a 1 bit image.
+constexpr int kPixelsPerWord = 32;
+
+// Returns 0xff in each foreground byte of pixels.
+static inline __m128i ForegroundBytes(__m128i pixels, __m128i thresholds,
+                                      __m128i invert, __m128i enable) {
+  __m128i above = _mm_subs_epu8(pixels, thresholds);
+  __m128i not_above = _mm_cmpeq_epi8(above, _mm_setzero_si128());
+  return _mm_and_si128(_mm_xor_si128(not_above, invert), enable);
+}
+
+int ThresholdLineSSE(const uint32_t* src_line, int left, int width,
+                     int num_channels, const int* thresholds,
+                     const int* hi_values, uint32_t* dest_line) {
+  ThresholdBytes bytes;
+  if (!bytes.Init(left, num_channels, thresholds, hi_values)) return 0;
+  const __m128i threshold_vec = _mm_set1_epi32(bytes.thresholds_word);
+  const __m128i invert = _mm_set1_epi32(bytes.invert_word);
+  const __m128i enable = _mm_set1_epi32(bytes.enable_word);
+  const int num_done = width - width % kPixelsPerWord;
+  if (num_channels == 1) {
+    // Puts the bytes of each word in pixel order.
+    const __m128i pixel_order =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(src_line) + left;
+    for (int x = 0; x < num_done; x += kPixelsPerWord) {
+      uint32_t mask = 0;
+      for (int i = 0; i < kPixelsPerWord; i += 16) {
+        __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + i));
+        __m128i fg = ForegroundBytes(pixels, threshold_vec, invert, enable);
+        fg = _mm_shuffle_epi8(fg, pixel_order);
+        mask |= static_cast<uint32_t>(_mm_movemask_epi8(fg)) << i;
+      }
+      dest_line[x / kPixelsPerWord] = ReverseBits(mask);
+    }
+  } else {
+    // A pixel is foreground if any of its channels is.
+    const __m128i zero = _mm_setzero_si128();
+    const uint32_t* src = src_line + left;
+    for (int x = 0; x < num_done; x += kPixelsPerWord) {
+      uint32_t mask = 0;
+      for (int i = 0; i < kPixelsPerWord; i += 4) {
+        __m128i pixels =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + i));
+        __m128i fg = ForegroundBytes(pixels, threshold_vec, invert, enable);
+        __m128i background = _mm_cmpeq_epi32(fg, zero);
+        uint32_t bg_mask = _mm_movemask_ps(_mm_castsi128_ps(background));
+        mask |= (~bg_mask & 0xfu) << i;
+      }
+      dest_line[x / kPixelsPerWord] = ReverseBits(mask);
+    }
+  }
+  return num_done;
+}
+
+int ThresholdGreyLineSSE(const uint8_t* src_line, int width, int threshold,
+                         int hi_value, uint32_t* dest_line) {
+  ThresholdBytes bytes;
+  if (!bytes.Init(0, 1, &threshold, &hi_value)) return 0;
+  const __m128i threshold_vec = _mm_set1_epi32(bytes.thresholds_word);
+  const __m128i invert = _mm_set1_epi32(bytes.invert_word);
+  const __m128i enable = _mm_set1_epi32(bytes.enable_word);
+  const int num_done = width - width % kPixelsPerWord;
+  for (int x = 0; x < num_done; x += kPixelsPerWord) {
+    uint32_t mask = 0;
+    for (int i = 0; i < kPixelsPerWord; i += 16) {
+      __m128i pixels =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_line + x + i));
+      __m128i fg = ForegroundBytes(pixels, threshold_vec, invert, enable);
+      mask |= static_cast<uint32_t>(_mm_movemask_epi8(fg)) << i;
+    }
+    dest_line[x / kPixelsPerWord] = ReverseBits(mask);
+  }
+  return num_done;
+}
+
+}  // namespace tesseract.
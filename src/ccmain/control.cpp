@@ -26,8 +26,12 @@
 #include <cstdio>                // for fclose, fopen, FILE
 #include <ctime>                 // for clock
 #include <cctype>
+#include <chrono>                // for std::chrono::steady_clock
+#include <thread>                // for std::thread
+#include <vector>                // for std::vector
 #include "callcpp.h"
 #include "control.h"
+#include "counters.h"          // for Counters, ScopedCounters
 #ifndef DISABLED_LEGACY_ENGINE
 #include "docqual.h"
 #include "drawfx.h"
@@ -43,6 +47,7 @@
 #include "sorthelper.h"
 #include "tesseractclass.h"
 #include "tessvars.h"
+#include "tracing.h"
 #include "werdit.h"
 
 const char* const kBackUpConfigFile = "tempconfigdata.config";
@@ -213,12 +218,25 @@ void Tesseract::SetupWordPassN(int pass_n, WordData* word) {
 bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
                                    PAGE_RES_IT* pr_it,
                                    GenericVector<WordData>* words) {
+  TraceSpan span(pass_n == 1 ? "RecogAllWordsPassN 1"
+                             : "RecogAllWordsPassN 2");
   // TODO(rays) Before this loop can be parallelized (it would yield a massive
   // speed-up) all remaining member globals need to be converted to local/heap
   // (eg set_pass1 and set_pass2) and an intermediate adaption pass needs to be
   // added. The results will be significantly different with adaption on, and
   // deterioration will need investigation.
   pr_it->restart_page();
+  // The language gate of multi-language configurations: the number of words
+  // of gate_block in a row that gate_lang read best.
+  const BLOCK* gate_block = nullptr;
+  const Tesseract* gate_lang = nullptr;
+  int gate_run = 0;
+  const bool stream_lines = pass_n == 1 && monitor != nullptr &&
+                            monitor->line_callback != nullptr;
+  // The line of the last word recognized, which is given to the line
+  // callback of the monitor once the words after it are on another line.
+  const BLOCK* stream_block = nullptr;
+  ROW_RES* stream_row = nullptr;
   for (int w = 0; w < words->size(); ++w) {
     WordData* word = &(*words)[w];
     if (w > 0) word->prev_word = &(*words)[w - 1];
@@ -258,6 +276,10 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
     while (pr_it->word() != nullptr && pr_it->word() != word->word)
       pr_it->forward();
     ASSERT_HOST(pr_it->word() != nullptr);
+    if (stream_row != nullptr && pr_it->row() != stream_row) {
+      StreamLine(monitor, stream_block, stream_row);
+      stream_row = nullptr;
+    }
     bool make_next_word_fuzzy = false;
     if (!AnyLSTMLang() &&
         ReassignDiacritics(pass_n, pr_it, &make_next_word_fuzzy)) {
@@ -265,20 +287,104 @@ bool Tesseract::RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor,
       SetupWordPassN(pass_n, word);
     }
 
-    classify_word_and_language(pass_n, pr_it, word);
+    if (word->block != gate_block) {
+      gate_block = word->block;
+      gate_lang = nullptr;
+      gate_run = 0;
+    }
+    // A block that one language reads well is read with that language
+    // alone, which costs as little as a single language. Only blocks that
+    // mix languages keep retrying the words with all of them.
+    bool gated = multilang_gate_words > 0 && !sub_langs_.empty() &&
+                 gate_run >= multilang_gate_words &&
+                 most_recently_used_ == gate_lang;
+    classify_word_and_language(pass_n, pr_it, word, !gated);
+    if (most_recently_used_ == gate_lang) {
+      ++gate_run;
+    } else {
+      gate_lang = most_recently_used_;
+      gate_run = 1;
+    }
     if (tessedit_dump_choices || debug_noise_removal) {
       tprintf("Pass%d: %s [%s]\n", pass_n,
               word->word->best_choice->unichar_string().string(),
               word->word->best_choice->debug_string().string());
     }
+    if (stream_lines) {
+      stream_block = word->block;
+      stream_row = pr_it->row();
+    }
     pr_it->forward();
     if (make_next_word_fuzzy && pr_it->word() != nullptr) {
       pr_it->MakeCurrentWordFuzzy();
     }
   }
+  if (stream_row != nullptr) StreamLine(monitor, stream_block, stream_row);
   return true;
 }
 
+bool Tesseract::StreamsFinalLines(const ETEXT_DESC* monitor) const {
+  return monitor != nullptr && monitor->line_callback != nullptr &&
+         tessedit_stream_final_lines;
+}
+
+void Tesseract::StreamLine(ETEXT_DESC* monitor, const BLOCK* block,
+                           ROW_RES* row_res) {
+  const bool final_line = StreamsFinalLines(monitor);
+  STRING text;
+  TBOX box;
+  float mean_certainty = 0.0f;
+  int num_words = 0;
+  WERD_RES_IT word_it(&row_res->word_res_list);
+  for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
+    WERD_RES* word = word_it.data();
+    if (word->part_of_combo) continue;
+    // A final line can't wait for the post-processing of pass 1.
+    if (final_line && word->word->flag(W_REP_CHAR)) fix_rep_char(word);
+    // Skip the words that recog_all_words removes in the end.
+    if (word->best_choice == nullptr || word->best_choice->length() == 0 ||
+        word->best_choice->IsAllSpaces()) {
+      continue;
+    }
+    if (num_words > 0) text += " ";
+    text += word->best_choice->unichar_string();
+    box += word->word->bounding_box();
+    mean_certainty += word->best_choice->certainty();
+    ++num_words;
+  }
+  if (num_words == 0) return;
+  box.rotate(block->re_rotation());
+  // Convert to the top-down coordinates of the image, as the iterators do.
+  const int reduction = image_reduction();
+  const int height = ImageHeight();
+  const float confidence = ClipToRange(
+      100.0f + 5.0f * mean_certainty / num_words, 0.0f, 100.0f);
+  (*monitor->line_callback)(monitor, text.c_str(), box.left() * reduction,
+                            (height - box.top()) * reduction,
+                            box.right() * reduction,
+                            (height - box.bottom()) * reduction, confidence);
+}
+
+// Prints the time each pass of recog_all_words takes, if enabled.
+class PassTimer {
+ public:
+  explicit PassTimer(bool enabled)
+      : enabled_(enabled), start_(std::chrono::steady_clock::now()) {}
+
+  // Prints the time since the previous pass ended as the time of pass.
+  void Report(const char* pass) {
+    if (!enabled_) return;
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = now - start_;
+    tprintf("%s took %.3f ms\n", pass, elapsed.count());
+    start_ = now;
+  }
+
+ private:
+  bool enabled_;
+  std::chrono::steady_clock::time_point start_;
+};
+
 /**
  * recog_all_words()
  *
@@ -306,12 +412,25 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
                                 const char* word_config,
                                 int dopasses) {
   PAGE_RES_IT page_res_it(page_res);
+  // The dictionary lookups and blob choices of the last page are no use on
+  // this one, as the params may have changed.
+  ClearDictWordCaches();
+#ifndef DISABLED_LEGACY_ENGINE
+  ClearBlobChoiceCache();
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->ClearBlobChoiceCache();
+  }
+#endif  // ndef DISABLED_LEGACY_ENGINE
 
   if (tessedit_minimal_rej_pass1) {
     tessedit_test_adaption.set_value (true);
     tessedit_minimal_rejection.set_value (true);
   }
 
+  PassTimer timer(tessedit_timing_debug);
+  // True if pass 1 was confident of every word, so no later pass is run.
+  bool page_finished = false;
+
   if (dopasses==0 || dopasses==1) {
     page_res_it.restart_page();
     // ****************** Pass 1 *******************
@@ -346,10 +465,22 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
       PrerecAllWordsPar(words);
     }
     #endif  // ndef DISABLED_LEGACY_ENGINE
+    int lstm_allocations = lstm_recognizer_ != nullptr
+                               ? lstm_recognizer_->NumScratchAllocations()
+                               : 0;
+    #ifndef ANDROID_BUILD
+    if (lstm_batch_size > 1 || lstm_line_threads > 1) {
+      PrerecAllLinesLSTM(words);
+    }
+    #endif  // ndef ANDROID_BUILD
 
     stats_.word_count = words.size();
 
     stats_.dict_words = 0;
+    stats_.x_ht_fixes_tried = 0;
+    stats_.x_ht_fixes_skipped = 0;
+    stats_.superscript_fixes_tried = 0;
+    stats_.superscript_fixes_skipped = 0;
     stats_.doc_blob_quality = 0;
     stats_.doc_outline_errs = 0;
     stats_.doc_char_quality = 0;
@@ -358,15 +489,45 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
 
     most_recently_used_ = this;
     // Run pass 1 word recognition.
-    if (!RecogAllWordsPassN(1, monitor, &page_res_it, &words)) return false;
+    bool completed = RecogAllWordsPassN(1, monitor, &page_res_it, &words);
+    // Drop any batched results that were not used.
+    lstm_batch_words_.clear();
+    if (!completed) return false;
+    if (tessedit_timing_debug && lstm_recognizer_ != nullptr) {
+      tprintf("LSTM scratch allocations on this page: %d\n",
+              lstm_recognizer_->NumScratchAllocations() - lstm_allocations);
+      const OutputCacheStats& stats = lstm_recognizer_->output_cache_stats();
+      tprintf("LSTM output cache: %ld hits, %ld store hits, %ld misses,"
+              " %ld evictions\n",
+              static_cast<long>(stats.hits),
+              static_cast<long>(stats.store_hits),
+              static_cast<long>(stats.misses),
+              static_cast<long>(stats.evictions));
+    }
+    const bool early_finish = tessedit_early_finish_certainty < 0.0;
+    int num_words = 0;
+    int num_finished = 0;
     // Pass 1 post-processing.
     for (page_res_it.restart_page(); page_res_it.word() != nullptr;
          page_res_it.forward()) {
       if (page_res_it.word()->word->flag(W_REP_CHAR)) {
-        fix_rep_char(&page_res_it);
+        // The final streamed lines had their repeated chars fixed already.
+        if (!StreamsFinalLines(monitor)) fix_rep_char(page_res_it.word());
         continue;
       }
 
+      // A word that pass 1 is confident of is done, so pass 2 skips it.
+      if (early_finish) {
+        WERD_RES* word = page_res_it.word();
+        ++num_words;
+        if (!word->tess_failed && word->best_choice != nullptr &&
+            word->best_choice->certainty() >=
+                tessedit_early_finish_certainty) {
+          word->done = true;
+          ++num_finished;
+        }
+      }
+
       // Count dict words.
       if (page_res_it.word()->best_choice->permuter() == USER_DAWG_PERM)
         ++(stats_.dict_words);
@@ -379,6 +540,14 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
             page_res_it.word()->blamer_bundle->misadaption_debug());
       }
     }
+    page_finished = early_finish && num_finished == num_words;
+    timer.Report("Pass 1");
+    if (page_finished && tessedit_timing_debug) {
+      tprintf("All %d words are certain, skipping the later passes\n",
+              num_words);
+    }
+    // Nothing may change the lines that were streamed as final.
+    if (StreamsFinalLines(monitor)) page_finished = true;
   }
 
   if (dopasses == 1) return true;
@@ -387,7 +556,7 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
 
   // ****************** Pass 2 *******************
   if (tessedit_tess_adaption_mode != 0x0 && !tessedit_test_adaption &&
-      AnyTessLang()) {
+      AnyTessLang() && !page_finished) {
     page_res_it.restart_page();
     GenericVector<WordData> words;
     SetupAllWordsPassN(2, target_word_box, word_config, page_res, &words);
@@ -397,10 +566,18 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     most_recently_used_ = this;
     // Run pass 2 word recognition.
     if (!RecogAllWordsPassN(2, monitor, &page_res_it, &words)) return false;
+    timer.Report("Pass 2");
+    if (debug_x_ht_level >= 1 || superscript_debug >= 1) {
+      tprintf("Re-recognized %d words for x-height (%d skipped), "
+              "%d for superscripts (%d skipped)\n",
+              stats_.x_ht_fixes_tried, stats_.x_ht_fixes_skipped,
+              stats_.superscript_fixes_tried,
+              stats_.superscript_fixes_skipped);
+    }
   }
 
   // The next passes are only required for Tess-only.
-  if (AnyTessLang() && !AnyLSTMLang()) {
+  if (AnyTessLang() && !AnyLSTMLang() && !page_finished) {
     // ****************** Pass 3 *******************
     // Fix fuzzy spaces.
     set_global_loc_code(LOC_FUZZY_SPACE);
@@ -408,21 +585,31 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     if (!tessedit_test_adaption && tessedit_fix_fuzzy_spaces
         && !tessedit_word_for_word && !right_to_left())
       fix_fuzzy_spaces(monitor, stats_.word_count, page_res);
+    timer.Report("Pass 3 (fuzzy spaces)");
+
+    // The passes after fix_fuzzy_spaces keep the words, so they share a
+    // single walk of the page.
+    GenericVector<PAGE_RES_WORD> page_words;
+    page_res->GetWords(&page_words);
 
     // ****************** Pass 4 *******************
-    if (tessedit_enable_dict_correction) dictionary_correction_pass(page_res);
-    if (tessedit_enable_bigram_correction) bigram_correction_pass(page_res);
+    if (tessedit_enable_dict_correction) dictionary_correction_pass(page_words);
+    if (tessedit_enable_bigram_correction) bigram_correction_pass(page_words);
+    timer.Report("Pass 4 (dictionary and bigram correction)");
 
     // ****************** Pass 5,6 *******************
     rejection_passes(page_res, monitor, target_word_box, word_config);
+    timer.Report("Pass 5,6 (rejection)");
 
     // ****************** Pass 8 *******************
-    font_recognition_pass(page_res);
+    font_recognition_pass(page_words);
+    timer.Report("Pass 8 (fonts)");
 
     // ****************** Pass 9 *******************
     // Check the correctness of the final results.
-    blamer_pass(page_res);
+    blamer_pass(page_res, page_words);
     script_pos_pass(page_res);
+    timer.Report("Pass 9 (blamer and script positions)");
   }
 
   #endif  // ndef DISABLED_LEGACY_ENGINE
@@ -442,7 +629,9 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
 
   const auto pageseg_mode = static_cast<PageSegMode>(
       static_cast<int>(tessedit_pageseg_mode));
-  textord_.CleanupSingleRowResult(pageseg_mode, page_res);
+  if (!StreamsFinalLines(monitor)) {
+    textord_.CleanupSingleRowResult(pageseg_mode, page_res);
+  }
 
   // Remove empty words, as these mess up the result iterators.
   for (page_res_it.restart_page(); page_res_it.word() != nullptr;
@@ -457,6 +646,8 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     }
   }
 
+  timer.Report("Write results");
+
   if (monitor != nullptr) {
     monitor->progress = 100;
   }
@@ -465,20 +656,12 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
 
 #ifndef DISABLED_LEGACY_ENGINE
 
-void Tesseract::bigram_correction_pass(PAGE_RES *page_res) {
-  PAGE_RES_IT word_it(page_res);
-
-  WERD_RES *w_prev = nullptr;
-  WERD_RES *w = word_it.word();
-  while (true) {
-    w_prev = w;
-    while (word_it.forward() != nullptr &&
-           (!word_it.word() || word_it.word()->part_of_combo)) {
-      // advance word_it, skipping over parts of combos
-    }
-    if (!word_it.word()) break;
-    w = word_it.word();
-    if (!w || !w_prev || w->uch_set != w_prev->uch_set) {
+void Tesseract::bigram_correction_pass(
+    const GenericVector<PAGE_RES_WORD>& words) {
+  for (int word_index = 1; word_index < words.size(); ++word_index) {
+    WERD_RES* w_prev = words[word_index - 1].word;
+    WERD_RES* w = words[word_index].word;
+    if (w->uch_set != w_prev->uch_set) {
       continue;
     }
     if (w_prev->word->flag(W_REP_CHAR) || w->word->flag(W_REP_CHAR)) {
@@ -615,6 +798,9 @@ void Tesseract::rejection_passes(PAGE_RES* page_res,
                                  const TBOX* target_word_box,
                                  const char* word_config) {
   PAGE_RES_IT page_res_it(page_res);
+  // The blob quality of every word, in page order, for the block and row
+  // rejection of pass 6, which would otherwise match up the blobs again.
+  GenericVector<int16_t> blob_qualities;
   // ****************** Pass 5 *******************
   // Gather statistics on rejects.
   int word_index = 0;
@@ -628,11 +814,21 @@ void Tesseract::rejection_passes(PAGE_RES* page_res,
     }
     if (word->rebuild_word == nullptr) {
       // Word was not processed by tesseract.
+      blob_qualities.push_back(0);
       page_res_it.forward();
       continue;
     }
     check_debug_pt(word, 70);
 
+    // A single blob matching walk gives both the blob quality, which is just
+    // the number of matched blobs, and the char quality counts.
+    int16_t all_char_quality;
+    int16_t accepted_all_char_quality;
+    word_char_quality(word, page_res_it.row()->row,
+                      &all_char_quality, &accepted_all_char_quality);
+    const int blob_quality = all_char_quality;
+    blob_qualities.push_back(blob_quality);
+
     // changed by jetsoft
     // specific to its needs to extract one word when need
     if (target_word_box &&
@@ -647,14 +843,9 @@ void Tesseract::rejection_passes(PAGE_RES* page_res,
     const int chars_in_word = word->reject_map.length();
     const int rejects_in_word = word->reject_map.reject_count();
 
-    const int blob_quality = word_blob_quality(word, page_res_it.row()->row);
     stats_.doc_blob_quality += blob_quality;
     const int outline_errs = word_outline_errs(word);
     stats_.doc_outline_errs += outline_errs;
-    int16_t all_char_quality;
-    int16_t accepted_all_char_quality;
-    word_char_quality(word, page_res_it.row()->row,
-                      &all_char_quality, &accepted_all_char_quality);
     stats_.doc_char_quality += all_char_quality;
     const uint8_t permuter_type = word->best_choice->permuter();
     if ((permuter_type == SYSTEM_DAWG_PERM) ||
@@ -702,18 +893,17 @@ void Tesseract::rejection_passes(PAGE_RES* page_res,
   // Do whole document or whole block rejection pass
   if (!tessedit_test_adaption) {
     set_global_loc_code(LOC_DOC_BLK_REJ);
-    quality_based_rejection(page_res_it, good_quality_doc);
+    quality_based_rejection(page_res_it, good_quality_doc, blob_qualities);
   }
 }
 
 #endif  // ndef DISABLED_LEGACY_ENGINE
 
-void Tesseract::blamer_pass(PAGE_RES* page_res) {
+void Tesseract::blamer_pass(PAGE_RES* page_res,
+                            const GenericVector<PAGE_RES_WORD>& words) {
   if (!wordrec_run_blamer) return;
-  PAGE_RES_IT page_res_it(page_res);
-  for (page_res_it.restart_page(); page_res_it.word() != nullptr;
-      page_res_it.forward()) {
-    WERD_RES *word = page_res_it.word();
+  for (int w = 0; w < words.size(); ++w) {
+    WERD_RES *word = words[w].word;
     BlamerBundle::LastChanceBlame(wordrec_debug_blamer, word);
     page_res->blame_reasons[word->blamer_bundle->incorrect_result_reason()]++;
   }
@@ -906,28 +1096,41 @@ int Tesseract::RetryWithLanguage(const WordData& word_data,
                                  WordRecognizer recognizer, bool debug,
                                  WERD_RES** in_word,
                                  PointerVector<WERD_RES>* best_words) {
+  PointerVector<WERD_RES> new_words;
+  RecognizeWithLanguage(word_data, recognizer, debug, in_word, &new_words);
+  return SelectWithLanguage(debug, &new_words, best_words);
+}
+
+void Tesseract::RecognizeWithLanguage(const WordData& word_data,
+                                      WordRecognizer recognizer, bool debug,
+                                      WERD_RES** in_word,
+                                      PointerVector<WERD_RES>* new_words) {
   if (debug) {
     tprintf("Trying word using lang %s, oem %d\n",
             lang.string(), static_cast<int>(tessedit_ocr_engine_mode));
   }
   // Run the recognizer on the word.
-  PointerVector<WERD_RES> new_words;
-  (this->*recognizer)(word_data, in_word, &new_words);
-  if (new_words.empty()) {
+  (this->*recognizer)(word_data, in_word, new_words);
+  if (new_words->empty()) {
     // Transfer input word to new_words, as the classifier must have put
     // the result back in the input.
-    new_words.push_back(*in_word);
+    new_words->push_back(*in_word);
     *in_word = nullptr;
   }
   if (debug) {
-    for (int i = 0; i < new_words.size(); ++i)
-      new_words[i]->DebugTopChoice("Lang result");
+    for (int i = 0; i < new_words->size(); ++i)
+      (*new_words)[i]->DebugTopChoice("Lang result");
   }
+}
+
+int Tesseract::SelectWithLanguage(bool debug,
+                                  PointerVector<WERD_RES>* new_words,
+                                  PointerVector<WERD_RES>* best_words) {
   // Initial version is a bit of a hack based on better certainty and rating
   // or a dictionary vs non-dictionary word.
   return SelectBestWords(classify_max_rating_ratio,
                          classify_max_certainty_margin,
-                         debug, &new_words, best_words);
+                         debug, new_words, best_words);
 }
 
 // Helper returns true if all the words are acceptable.
@@ -938,6 +1141,38 @@ static bool WordsAcceptable(const PointerVector<WERD_RES>& words) {
   return true;
 }
 
+Tesseract* Tesseract::RetryWithLanguagesInParallel(
+    const WordData& word_data, WordRecognizer recognizer, bool debug,
+    const std::vector<Tesseract*>& others,
+    const std::vector<WERD_RES**>& in_words,
+    PointerVector<WERD_RES>* best_words) {
+  const int num_langs = others.size();
+  std::vector<PointerVector<WERD_RES>> new_words(num_langs);
+  std::vector<std::thread> threads;
+  Counters* counters = Counters::current();
+  for (int i = 1; i < num_langs; ++i) {
+    threads.push_back(std::thread([&, i] {
+      ScopedCounters counting(counters);
+      others[i]->RecognizeWithLanguage(word_data, recognizer, debug,
+                                       in_words[i], &new_words[i]);
+    }));
+  }
+  others[0]->RecognizeWithLanguage(word_data, recognizer, debug, in_words[0],
+                                   &new_words[0]);
+  for (auto& thread : threads) thread.join();
+  // Select as the languages would have been tried one after another, so the
+  // result is the same, only sooner. An LSTM only language learns nothing
+  // from a word, so the words of the languages that would not have been
+  // tried are just dropped.
+  Tesseract* best_lang_tess = nullptr;
+  for (int i = 0; i < num_langs; ++i) {
+    if (i > 0 && WordsAcceptable(*best_words)) break;
+    if (others[i]->SelectWithLanguage(debug, &new_words[i], best_words) > 0)
+      best_lang_tess = others[i];
+  }
+  return best_lang_tess;
+}
+
 // Moves good-looking "noise"/diacritics from the reject list to the main
 // blob list on the current word. Returns true if anything was done, and
 // sets make_next_word_fuzzy if blob(s) were added to the end of the word.
@@ -953,6 +1188,10 @@ bool Tesseract::ReassignDiacritics(int pass, PAGE_RES_IT* pr_it,
       real_word->rej_cblob_list()->length() > noise_maxperword)
     return false;
   real_word->rej_cblob_list()->sort(&C_BLOB::SortByXMiddle);
+  // Each candidate outline subset costs a full classification of the blob, so
+  // the work on a noisy word is capped by the budget.
+  noise_classifications_left_ =
+      noise_maxclassifications > 0 ? noise_maxclassifications : INT32_MAX;
   // Get the noise outlines into a vector with matching bool map.
   GenericVector<C_OUTLINE*> outlines;
   real_word->GetNoiseOutlines(&outlines);
@@ -1149,6 +1388,7 @@ bool Tesseract::SelectGoodDiacriticOutlines(
     const GenericVector<C_OUTLINE*>& outlines, int num_outlines,
     GenericVector<bool>* ok_outlines) {
 #ifndef DISABLED_LEGACY_ENGINE
+  if (noise_classifications_left_ <= 0) return false;
   STRING best_str;
   float target_cert = certainty_threshold;
   if (blob != nullptr) {
@@ -1177,13 +1417,16 @@ bool Tesseract::SelectGoodDiacriticOutlines(
     ol_box.print();
   }
   // Iteratively zero out the bit that improves the certainty the most, until
-  // we get past the threshold, have zero bits, or fail to improve.
+  // we get past the threshold, have zero bits, fail to improve, or run out of
+  // classification budget, in which case the best combination so far is used.
   int best_index = 0;  // To zero out.
   while (num_outlines > 1 && best_index >= 0 &&
+         noise_classifications_left_ > 0 &&
          (blob == nullptr || best_cert < target_cert || blob != nullptr)) {
     // Find the best bit to zero out.
     best_index = -1;
-    for (int i = 0; i < outlines.size(); ++i) {
+    for (int i = 0; i < outlines.size() && noise_classifications_left_ > 0;
+         ++i) {
       if (test_outlines[i]) {
         test_outlines[i] = false;
         STRING str;
@@ -1282,6 +1525,7 @@ float Tesseract::ClassifyBlobPlusOutlines(
 float Tesseract::ClassifyBlobAsWord(int pass_n, PAGE_RES_IT* pr_it,
                                     C_BLOB* blob, STRING* best_str, float* c2) {
 #ifndef DISABLED_LEGACY_ENGINE
+  --noise_classifications_left_;
   WERD* real_word = pr_it->word()->word;
   WERD* word = real_word->ConstructFromSingleBlob(
       real_word->flag(W_BOL), real_word->flag(W_EOL), C_BLOB::deep_copy(blob));
@@ -1331,7 +1575,8 @@ float Tesseract::ClassifyBlobAsWord(int pass_n, PAGE_RES_IT* pr_it,
 // If recognition was not successful, tries all available languages until
 // it gets a successful result or runs out of languages. Keeps the best result.
 void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
-                                           WordData* word_data) {
+                                           WordData* word_data,
+                                           bool retry_langs) {
 #ifdef DISABLED_LEGACY_ENGINE
   WordRecognizer recognizer = &Tesseract::classify_word_pass1;
 #else
@@ -1366,7 +1611,34 @@ void Tesseract::classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
   most_recently_used_->RetryWithLanguage(
       *word_data, recognizer, debug, &word_data->lang_words[sub], &best_words);
   Tesseract* best_lang_tess = most_recently_used_;
-  if (!WordsAcceptable(best_words)) {
+  std::vector<Tesseract*> others;
+  std::vector<WERD_RES**> in_words;
+  if (retry_langs && multilang_parallel_retry &&
+      !WordsAcceptable(best_words)) {
+    // The other languages in the order they are retried below.
+    if (most_recently_used_ != this) {
+      others.push_back(this);
+      in_words.push_back(&word_data->lang_words[sub_langs_.size()]);
+    }
+    for (int i = 0; i < sub_langs_.size(); ++i) {
+      if (most_recently_used_ == sub_langs_[i]) continue;
+      others.push_back(sub_langs_[i]);
+      in_words.push_back(&word_data->lang_words[i]);
+    }
+    // The legacy engine adapts to the words it recognizes, so a language
+    // that uses it must only see the words it would have been tried on.
+    for (Tesseract* other : others) {
+      if (other->tessedit_ocr_engine_mode != OEM_LSTM_ONLY) {
+        others.clear();
+        break;
+      }
+    }
+  }
+  if (others.size() > 1) {
+    Tesseract* lang_tess = RetryWithLanguagesInParallel(
+        *word_data, recognizer, debug, others, in_words, &best_words);
+    if (lang_tess != nullptr) best_lang_tess = lang_tess;
+  } else if (retry_langs && !WordsAcceptable(best_words)) {
     // Try all the other languages to see if they are any better.
     if (most_recently_used_ != this &&
         this->RetryWithLanguage(*word_data, recognizer, debug,
@@ -1498,8 +1770,10 @@ void Tesseract::ReportXhtFixResult(bool accept_new_word, float new_x_ht,
 // See the comment in fixxht.cpp for a description of the overall process.
 bool Tesseract::TrainedXheightFix(WERD_RES *word, BLOCK* block, ROW *row) {
   int original_misfits = CountMisfitTops(word);
-  if (original_misfits == 0)
+  if (original_misfits == 0) {
+    ++stats_.x_ht_fixes_skipped;
     return false;
+  }
   float baseline_shift = 0.0f;
   float new_x_ht = ComputeCompatibleXheight(word, &baseline_shift);
   if (baseline_shift != 0.0f) {
@@ -1524,6 +1798,7 @@ bool Tesseract::TrainedXheightFix(WERD_RES *word, BLOCK* block, ROW *row) {
     return TestNewNormalization(original_misfits, 0.0f, new_x_ht,
                                 word, block, row);
   } else {
+    ++stats_.x_ht_fixes_skipped;
     return false;
   }
 }
@@ -1533,6 +1808,22 @@ bool Tesseract::TrainedXheightFix(WERD_RES *word, BLOCK* block, ROW *row) {
 bool Tesseract::TestNewNormalization(int original_misfits,
                                      float baseline_shift, float new_x_ht,
                                      WERD_RES *word, BLOCK* block, ROW *row) {
+  // The new misfits must improve for the result to be used, which is very
+  // unlikely if the new normalization doesn't even fit the characters
+  // already recognized better.
+  if (x_ht_precheck && !classify_bln_numeric_mode) {
+    int predicted_misfits = PredictMisfitTops(word, baseline_shift, new_x_ht);
+    if (predicted_misfits >= original_misfits) {
+      if (debug_x_ht_level >= 1) {
+        tprintf("Skipping x-height %f, shift %f: misfits %d -> %d predicted\n",
+                new_x_ht, baseline_shift, original_misfits,
+                predicted_misfits);
+      }
+      ++stats_.x_ht_fixes_skipped;
+      return false;
+    }
+  }
+  ++stats_.x_ht_fixes_tried;
   bool accept_new_x_ht = false;
   WERD_RES new_x_ht_word(word->word);
   if (word->blamer_bundle != nullptr) {
@@ -1717,8 +2008,7 @@ static void CorrectRepcharChoices(BLOB_CHOICE* blob_choice,
  * the size of spaces in between blobs, and correct the classifications
  * where some of the characters disagree with the majority.
  */
-void Tesseract::fix_rep_char(PAGE_RES_IT* page_res_it) {
-  WERD_RES *word_res = page_res_it->word();
+void Tesseract::fix_rep_char(WERD_RES* word_res) {
   const WERD_CHOICE &word = *(word_res->best_choice);
 
   // Find the frequency of each unique character in the word.
@@ -2052,15 +2342,14 @@ void Tesseract::set_word_fonts(WERD_RES *word) {
  *
  * Smooth the fonts for the document.
  */
-void Tesseract::font_recognition_pass(PAGE_RES* page_res) {
-  PAGE_RES_IT page_res_it(page_res);
+void Tesseract::font_recognition_pass(
+    const GenericVector<PAGE_RES_WORD>& words) {
   WERD_RES *word;                // current word
   STATS doc_fonts(0, font_table_size_);           // font counters
 
   // Gather font id statistics.
-  for (page_res_it.restart_page(); page_res_it.word() != nullptr;
-       page_res_it.forward()) {
-    word = page_res_it.word();
+  for (int w = 0; w < words.size(); ++w) {
+    word = words[w].word;
     if (word->fontinfo != nullptr) {
       doc_fonts.add(word->fontinfo->universal_id, word->fontinfo_id_count);
     }
@@ -2075,9 +2364,8 @@ void Tesseract::font_recognition_pass(PAGE_RES* page_res) {
     return;
   // Get the modal font pointer.
   const FontInfo* modal_font = nullptr;
-  for (page_res_it.restart_page(); page_res_it.word() != nullptr;
-       page_res_it.forward()) {
-    word = page_res_it.word();
+  for (int w = 0; w < words.size(); ++w) {
+    word = words[w].word;
     if (word->fontinfo != nullptr && word->fontinfo->universal_id == doc_font) {
       modal_font = word->fontinfo;
       break;
@@ -2090,9 +2378,8 @@ void Tesseract::font_recognition_pass(PAGE_RES* page_res) {
   ASSERT_HOST(modal_font != nullptr);
 
   // Assign modal font to weak words.
-  for (page_res_it.restart_page(); page_res_it.word() != nullptr;
-       page_res_it.forward()) {
-    word = page_res_it.word();
+  for (int w = 0; w < words.size(); ++w) {
+    word = words[w].word;
     const int length = word->best_choice->length();
 
     const int count = word->fontinfo_id_count;
@@ -2109,10 +2396,10 @@ void Tesseract::font_recognition_pass(PAGE_RES* page_res) {
 // If a word has multiple alternates check if the best choice is in the
 // dictionary. If not, replace it with an alternate that exists in the
 // dictionary.
-void Tesseract::dictionary_correction_pass(PAGE_RES *page_res) {
-  PAGE_RES_IT word_it(page_res);
-  for (WERD_RES* word = word_it.word(); word != nullptr;
-       word = word_it.forward()) {
+void Tesseract::dictionary_correction_pass(
+    const GenericVector<PAGE_RES_WORD>& words) {
+  for (int w = 0; w < words.size(); ++w) {
+    WERD_RES* word = words[w].word;
     if (word->best_choices.singleton())
       continue;  // There are no alternates.
 
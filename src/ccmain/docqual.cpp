@@ -135,11 +135,12 @@ int16_t Tesseract::count_outline_errs(char c, int16_t outline_count) {
   return abs (outline_count - expected_outline_count);
 }
 
-void Tesseract::quality_based_rejection(PAGE_RES_IT &page_res_it,
-                                        bool good_quality_doc) {
+void Tesseract::quality_based_rejection(
+    PAGE_RES_IT &page_res_it, bool good_quality_doc,
+    const GenericVector<int16_t>& blob_qualities) {
   if ((tessedit_good_quality_unrej && good_quality_doc))
     unrej_good_quality_words(page_res_it);
-  doc_and_block_rejection(page_res_it, good_quality_doc);
+  doc_and_block_rejection(page_res_it, good_quality_doc, blob_qualities);
   if (unlv_tilde_crunching) {
     tilde_crunch(page_res_it);
     tilde_delete(page_res_it);
@@ -227,11 +228,13 @@ void Tesseract::unrej_good_quality_words(  //unreject potential
  *
  * If the page has too many rejects - reject all of it.
  * If any block has too many rejects - reject all words in the block
+ * The char quality of a word is the number of its matched blobs, so it is
+ * looked up in blob_qualities by the index of the word on the page.
  *************************************************************************/
 
 void Tesseract::doc_and_block_rejection(  //reject big chunks
-                                        PAGE_RES_IT &page_res_it,
-                                        bool good_quality_doc) {
+    PAGE_RES_IT &page_res_it, bool good_quality_doc,
+    const GenericVector<int16_t>& blob_qualities) {
   int16_t block_no = 0;
   int16_t row_no = 0;
   BLOCK_RES *current_block;
@@ -241,6 +244,7 @@ void Tesseract::doc_and_block_rejection(  //reject big chunks
   bool prev_word_rejected;
   int16_t char_quality = 0;
   int16_t accepted_char_quality;
+  int word_index = 0;  // Of page_res_it.word() in blob_qualities.
 
   if (page_res_it.page_res->rej_count * 100.0 /
       page_res_it.page_res->char_count > tessedit_reject_doc_percent) {
@@ -285,9 +289,12 @@ void Tesseract::doc_and_block_rejection(  //reject big chunks
                     word->best_choice->unichar_string().string(),
                     word->best_choice->unichar_lengths().string()) !=
                 AC_UNACCEPTABLE) {
-              word_char_quality(word, page_res_it.row()->row,
-                                &char_quality,
-                                &accepted_char_quality);
+              if (word_index < blob_qualities.size()) {
+                char_quality = blob_qualities[word_index];
+              } else {
+                word_char_quality(word, page_res_it.row()->row,
+                                  &char_quality, &accepted_char_quality);
+              }
               rej_word = char_quality !=  word->reject_map.length();
             }
           } else {
@@ -308,6 +315,7 @@ void Tesseract::doc_and_block_rejection(  //reject big chunks
           }
           prev_word_rejected = rej_word;
           page_res_it.forward();
+          ++word_index;
         }
       } else {
         if (tessedit_debug_block_rejection) {
@@ -356,9 +364,12 @@ void Tesseract::doc_and_block_rejection(  //reject big chunks
                         word->best_choice->unichar_string().string(),
                         word->best_choice->unichar_lengths().string()) !=
                             AC_UNACCEPTABLE) {
-                  word_char_quality(word, page_res_it.row()->row,
-                                    &char_quality,
-                                    &accepted_char_quality);
+                  if (word_index < blob_qualities.size()) {
+                    char_quality = blob_qualities[word_index];
+                  } else {
+                    word_char_quality(word, page_res_it.row()->row,
+                                      &char_quality, &accepted_char_quality);
+                  }
                   rej_word = char_quality != word->reject_map.length();
                 }
               } else {
@@ -379,6 +390,7 @@ void Tesseract::doc_and_block_rejection(  //reject big chunks
               }
               prev_word_rejected = rej_word;
               page_res_it.forward();
+              ++word_index;
             }
           } else {
             if (tessedit_debug_block_rejection) {
@@ -386,8 +398,10 @@ void Tesseract::doc_and_block_rejection(  //reject big chunks
                       row_no, current_row->char_count, current_row->rej_count);
             }
             while (page_res_it.word() != nullptr &&
-                   page_res_it.row() == current_row)
+                   page_res_it.row() == current_row) {
               page_res_it.forward();
+              ++word_index;
+            }
           }
         }
       }
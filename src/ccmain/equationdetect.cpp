@@ -46,6 +46,9 @@ static BOOL_VAR(equationdetect_save_bi_image, false, "Save input bi image");
 static BOOL_VAR(equationdetect_save_spt_image, false, "Save special character image");
 static BOOL_VAR(equationdetect_save_seed_image, false, "Save the seed image");
 static BOOL_VAR(equationdetect_save_merged_image, false, "Save the merged image");
+static BOOL_VAR(equationdetect_skip_plain_text, false,
+                "Don't classify the blobs of text partitions whose blob"
+                " geometry looks like plain text");
 
 namespace tesseract {
 
@@ -161,20 +164,18 @@ void EquationDetect::IdentifySpecialText(
   C_BLOB* blob = blobnbox->cblob();
   // TODO(joeliu/rays) Fix this. We may have to normalize separately for
   // each classifier here, as they may require different PolygonalCopy.
-  TBLOB* tblob = TBLOB::PolygonalCopy(false, blob);
-  const TBOX& box = tblob->bounding_box();
+  std::unique_ptr<TBLOB> normed_blob(TBLOB::PolygonalCopy(false, blob));
+  const TBOX box = normed_blob->bounding_box();
 
-  // Normalize the blob. Set the origin to the place we want to be the
+  // Normalize the blob in place. Set the origin to the place we want to be the
   // bottom-middle, and scaling is to make the height the x-height.
   const float scaling = static_cast<float>(kBlnXHeight) / box.height();
   const float x_orig = (box.left() + box.right()) / 2.0f, y_orig = box.bottom();
-  std::unique_ptr<TBLOB> normed_blob(new TBLOB(*tblob));
   normed_blob->Normalize(nullptr, nullptr, nullptr, x_orig, y_orig, scaling, scaling,
                          0.0f, static_cast<float>(kBlnBaselineOffset),
                          false, nullptr);
   equ_tesseract_.AdaptiveClassifier(normed_blob.get(), &ratings_equ);
   lang_tesseract_->AdaptiveClassifier(normed_blob.get(), &ratings_lang);
-  delete tblob;
 
   // Get the best choice from ratings_lang and rating_equ. As the choice in the
   // list has already been sorted by the certainty, we simply use the first
@@ -284,8 +285,23 @@ void EquationDetect::IdentifySpecialText() {
         blob_heights.push_back(bbox_it.data()->bounding_box().height());
       }
     }
+    if (blob_heights.empty()) {
+      continue;
+    }
     blob_heights.sort();
-    const int height_th =  blob_heights[blob_heights.size() / 2] / 3 * 2;
+    const int median_height = blob_heights[blob_heights.size() / 2];
+    const int height_th = median_height / 3 * 2;
+    if (equationdetect_skip_plain_text &&
+        IsPlainTextPart(part, median_height, height_th)) {
+      // Nothing to classify here, all the blobs are regular text.
+      for (bbox_it.mark_cycle_pt(); !bbox_it.cycled_list();
+           bbox_it.forward()) {
+        if (bbox_it.data()->special_text_type() != BSTT_SKIP) {
+          bbox_it.data()->set_special_text_type(BSTT_NONE);
+        }
+      }
+      continue;
+    }
     for (bbox_it.mark_cycle_pt (); !bbox_it.cycled_list();
          bbox_it.forward()) {
       if (bbox_it.data()->special_text_type() != BSTT_SKIP) {
@@ -307,6 +323,42 @@ void EquationDetect::IdentifySpecialText() {
   }
 }
 
+bool EquationDetect::IsPlainTextPart(ColPartition* part,
+                                     const int median_height,
+                                     const int height_th) const {
+  ASSERT_HOST(part);
+  // Only long lines of flowing text are considered, anything shorter is
+  // cheap enough to classify anyway.
+  const int kMinPlainTextBlobs = 20;
+  const float kMaxHeightRatio = 1.5f, kMaxAspectRatio = 1.2f;
+  if (part->type() != PT_FLOWING_TEXT || median_height <= 0) {
+    return false;
+  }
+  BLOBNBOX_C_IT blob_it(part->boxes());
+  int num_blobs = 0;
+  for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
+    const BLOBNBOX* blob = blob_it.data();
+    if (blob->special_text_type() == BSTT_SKIP) {
+      continue;
+    }
+    const TBOX& box = blob->bounding_box();
+    if (box.height() < height_th) {
+      // Small blobs are set to BSTT_NONE without classification anyway, but
+      // a wide one may be a fraction bar or a minus sign.
+      if (box.width() > box.height()) return false;
+      continue;
+    }
+    // Big operators, brackets and wide symbols all break the uniform size of
+    // a plain text line.
+    if (box.height() > median_height * kMaxHeightRatio ||
+        box.width() > median_height * kMaxAspectRatio) {
+      return false;
+    }
+    ++num_blobs;
+  }
+  return num_blobs >= kMinPlainTextBlobs;
+}
+
 void EquationDetect::IdentifyBlobsToSkip(ColPartition* part) {
   ASSERT_HOST(part);
   BLOBNBOX_C_IT blob_it(part->boxes());
@@ -85,6 +85,12 @@ class EquationDetect : public EquationDetectBase {
   // classification.
   void IdentifyBlobsToSkip(ColPartition* part);
 
+  // Cheap geometric pre-filter for IdentifySpecialText: returns true if part
+  // is a long flowing text line whose blobs all have a uniform, text-like
+  // size, so running the classifiers on them can be skipped.
+  bool IsPlainTextPart(ColPartition* part, const int median_height,
+                       const int height_th) const;
+
   // The ColPartitions in part_grid_ maybe over-segmented, particularly in the
   // block equation regions. So we like to identify these partitions and merge
   // them before we do the searching.
@@ -176,6 +176,7 @@ void Tesseract::fix_fuzzy_space_list(WERD_RES_LIST &best_perm,
   WERD_RES_LIST current_perm;
   int16_t current_score;
   bool improved = false;
+  int num_perms = 0;
 
   best_score = eval_word_spacing(best_perm);  // default score
   dump_words(best_perm, best_score, 1, improved);
@@ -183,7 +184,10 @@ void Tesseract::fix_fuzzy_space_list(WERD_RES_LIST &best_perm,
   if (best_score != PERFECT_WERDS)
     initialise_search(best_perm, current_perm);
 
-  while ((best_score != PERFECT_WERDS) && !current_perm.empty()) {
+  // Each permutation re-recognizes the words it joined, so a long run of
+  // uncertain gaps is bounded by fixsp_max_perms.
+  while ((best_score != PERFECT_WERDS) && !current_perm.empty() &&
+         (fixsp_max_perms <= 0 || num_perms++ < fixsp_max_perms)) {
     match_current_words(current_perm, row, block);
     current_score = eval_word_spacing(current_perm);
     dump_words(current_perm, current_score, 2, improved);
@@ -602,6 +606,7 @@ void Tesseract::fix_noisy_space_list(WERD_RES_LIST &best_perm, ROW *row,
   WERD_RES *old_word_res;
   int16_t current_score;
   bool improved = false;
+  int num_perms = 0;
 
   best_score = fp_eval_word_spacing(best_perm);  // default score
 
@@ -616,7 +621,8 @@ void Tesseract::fix_noisy_space_list(WERD_RES_LIST &best_perm, ROW *row,
 
   break_noisiest_blob_word(current_perm);
 
-  while (best_score != PERFECT_WERDS && !current_perm.empty()) {
+  while (best_score != PERFECT_WERDS && !current_perm.empty() &&
+         (fixsp_max_perms <= 0 || num_perms++ < fixsp_max_perms)) {
     match_current_words(current_perm, row, block);
     current_score = fp_eval_word_spacing(current_perm);
     dump_words(current_perm, current_score, 2, improved);
@@ -97,6 +97,39 @@ int Tesseract::CountMisfitTops(WERD_RES *word_res) {
   return bad_blobs;
 }
 
+// Returns the number of misfit blob tops that word_res would get from a
+// renormalization with baseline_shift and new_x_ht. The tops are mapped back
+// to image space with the current normalization and forward again with the
+// new one, which is exact unless numeric mode normalizes blobs separately.
+int Tesseract::PredictMisfitTops(WERD_RES* word_res, float baseline_shift,
+                                 float new_x_ht) {
+  const float old_scale = word_res->denorm.y_scale();
+  const float new_scale = kBlnXHeight / new_x_ht;
+  const float shift = word_res->baseline_shift - baseline_shift;
+  int bad_blobs = 0;
+  int num_blobs = word_res->rebuild_word->NumBlobs();
+  for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
+    TBLOB* blob = word_res->rebuild_word->blobs[blob_id];
+    UNICHAR_ID class_id = word_res->best_choice->unichar_id(blob_id);
+    if (unicharset.get_isalpha(class_id) || unicharset.get_isdigit(class_id)) {
+      float old_top = blob->bounding_box().top() - kBlnBaselineOffset;
+      int top = IntCastRounded((old_top / old_scale + shift) * new_scale) +
+                kBlnBaselineOffset;
+      if (top >= INT_FEAT_RANGE)
+        top = INT_FEAT_RANGE - 1;
+      int min_bottom, max_bottom, min_top, max_top;
+      unicharset.get_top_bottom(class_id, &min_bottom, &max_bottom,
+                                &min_top, &max_top);
+      if (max_top - min_top > kMaxCharTopRange)
+        continue;
+      if (top < min_top - x_ht_acceptance_tolerance ||
+          top > max_top + x_ht_acceptance_tolerance)
+        ++bad_blobs;
+    }
+  }
+  return bad_blobs;
+}
+
 // Returns a new x-height maximally compatible with the result in word_res.
 // See comment above for overall algorithm.
 float Tesseract::ComputeCompatibleXheight(WERD_RES *word_res,
@@ -63,7 +63,11 @@ void Tesseract::TrainLineRecognizer(const STRING& input_imagename,
   }
   TrainFromBoxes(boxes, texts, block_list, &images);
   images.Shuffle();
-  if (!images.SaveDocument(lstmf_name.string(), nullptr)) {
+  bool saved = lstm_indexed_lstmf
+                   ? images.SaveIndexedDocument(lstmf_name.string(),
+                                                lstm_compress_lstmf, nullptr)
+                   : images.SaveDocument(lstmf_name.string(), nullptr);
+  if (!saved) {
     tprintf("Failed to write training data to %s!\n", lstmf_name.string());
   }
 }
@@ -161,7 +165,8 @@ ImageData* Tesseract::GetLineData(const TBOX& line_box,
 // can be used to invoke a different CJK recognition engine. The revised_box
 // is also returned to enable calculation of output bounding boxes.
 ImageData* Tesseract::GetRectImage(const TBOX& box, const BLOCK& block,
-                                   int padding, TBOX* revised_box) const {
+                                   int padding, TBOX* revised_box,
+                                   bool keep_decoded) const {
   TBOX wbox = box;
   wbox.pad(padding, padding);
   *revised_box = wbox;
@@ -213,37 +218,313 @@ ImageData* Tesseract::GetRectImage(const TBOX& box, const BLOCK& block,
     if (num_rotations != 2)
       vertical_text = true;
   }
-  return new ImageData(vertical_text, box_pix);
+  return new ImageData(vertical_text, box_pix, keep_decoded);
 }
 
 #ifndef ANDROID_BUILD
-// Recognizes a word or group of words, converting to WERD_RES in *words.
-// Analogous to classify_word_pass1, but can handle a group of words as well.
-void Tesseract::LSTMRecognizeWord(const BLOCK& block, ROW *row, WERD_RES *word,
-                                  PointerVector<WERD_RES>* words) {
-  TBOX word_box = word->word->bounding_box();
+// Returns the image to be given to the LSTM recognizer for the given word or
+// group of words, setting *word_box to the box it covers, or nullptr if
+// there is nothing to recognize.
+ImageData* Tesseract::GetLSTMWordImage(const BLOCK& block, ROW* row,
+                                       WERD_RES* word, TBOX* word_box) const {
+  *word_box = word->word->bounding_box();
   // Get the word image - no frills.
   if (tessedit_pageseg_mode == PSM_SINGLE_WORD ||
       tessedit_pageseg_mode == PSM_RAW_LINE) {
     // In single word mode, use the whole image without any other row/word
     // interpretation.
-    word_box = TBOX(0, 0, ImageWidth(), ImageHeight());
+    *word_box = TBOX(0, 0, ImageWidth(), ImageHeight());
   } else {
-    float baseline = row->base_line((word_box.left() + word_box.right()) / 2);
-    if (baseline + row->descenders() < word_box.bottom())
-      word_box.set_bottom(baseline + row->descenders());
-    if (baseline + row->x_height() + row->ascenders() > word_box.top())
-      word_box.set_top(baseline + row->x_height() + row->ascenders());
+    float baseline = row->base_line((word_box->left() + word_box->right()) / 2);
+    if (baseline + row->descenders() < word_box->bottom())
+      word_box->set_bottom(baseline + row->descenders());
+    if (baseline + row->x_height() + row->ascenders() > word_box->top())
+      word_box->set_top(baseline + row->x_height() + row->ascenders());
   }
-  ImageData* im_data = GetRectImage(word_box, block, kImagePadding, &word_box);
+  // The image is only recognized, so it isn't worth encoding.
+  return GetRectImage(*word_box, block, kImagePadding, word_box, true);
+}
+
+void Tesseract::GetLSTMWordChunks(const BLOCK& block, ROW* row, WERD_RES* word,
+                                  std::vector<ImageData*>* images,
+                                  std::vector<TBOX>* boxes,
+                                  std::vector<bool>* spaced) const {
+  TBOX word_box;
+  ImageData* im_data = GetLSTMWordImage(block, row, word, &word_box);
   if (im_data == nullptr) return;
-  lstm_recognizer_->RecognizeLine(*im_data, true, classify_debug_level > 0,
-                                  kWorstDictCertainty / kCertaintyScale,
-                                  word_box, words, lstm_choice_mode);
+  // The chunks are cut from the binary image, which is only in the
+  // coordinates of the word box if the block is not rotated.
+  const bool rotated =
+      block.re_rotation().x() < 0.0f || block.re_rotation().y() != 0.0f;
+  std::vector<TBOX> chunks;
+  std::vector<bool> chunk_spaced;
+  if (lstm_chunk_timesteps > 0 && !rotated && pix_binary_ != nullptr) {
+    // The line is scaled to the height of the network input, and each
+    // timestep covers XScaleFactor of its columns.
+    const int64_t max_width =
+        static_cast<int64_t>(lstm_chunk_timesteps) *
+        lstm_recognizer_->XScaleFactor() * word_box.height() /
+        std::max(lstm_recognizer_->NumInputs(), 1);
+    if (word_box.width() > max_width) {
+      SplitWideLineBox(word_box, static_cast<int>(max_width), &chunks,
+                       &chunk_spaced);
+    }
+  }
+  if (chunks.size() < 2) {
+    images->push_back(im_data);
+    boxes->push_back(word_box);
+    spaced->push_back(false);
+    return;
+  }
   delete im_data;
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    TBOX chunk_box;
+    ImageData* chunk = GetRectImage(chunks[c], block, 0, &chunk_box, true);
+    if (chunk == nullptr) continue;
+    images->push_back(chunk);
+    boxes->push_back(chunk_box);
+    spaced->push_back(chunk_spaced[c]);
+  }
+}
+
+void Tesseract::SplitWideLineBox(const TBOX& box, int max_width,
+                                 std::vector<TBOX>* chunks,
+                                 std::vector<bool>* spaced) const {
+  const int width = box.width();
+  const int image_width = pixGetWidth(pix_binary_);
+  const int image_height = pixGetHeight(pix_binary_);
+  // The ink in each column of the box.
+  std::vector<int> ink(width, 0);
+  const int wpl = pixGetWpl(pix_binary_);
+  const l_uint32* data = pixGetData(pix_binary_);
+  const int end_x = std::min(width, image_width - box.left());
+  for (int y = std::max(image_height - box.top(), 0);
+       y < std::min(image_height - box.bottom(), image_height); ++y) {
+    const l_uint32* line = data + y * wpl;
+    for (int x = std::max(-box.left(), 0); x < end_x; ++x) {
+      if (GET_DATA_BIT(line, box.left() + x)) ++ink[x];
+    }
+  }
+  // A gap as wide as a quarter of the line height is taken as a space.
+  const int min_space = std::max(box.height() / 4, 1);
+  bool after_space = false;
+  int start = 0;
+  while (width - start > max_width) {
+    // Look for a gap in the second half of the chunk, so chunks don't get
+    // much narrower than max_width.
+    const int window_start = start + std::max(max_width / 2, 1);
+    const int window_end = start + std::max(max_width, 2);
+    int best_start = -1, best_run = 0, run = 0;
+    int least = window_start;
+    for (int x = window_start; x < window_end; ++x) {
+      if (ink[x] == 0) {
+        if (++run > best_run) {
+          best_run = run;
+          best_start = x - run + 1;
+        }
+      } else {
+        run = 0;
+      }
+      if (ink[x] < ink[least]) least = x;
+    }
+    const int split = best_run > 0 ? best_start + best_run / 2 : least;
+    chunks->push_back(TBOX(box.left() + start, box.bottom(),
+                           box.left() + split, box.top()));
+    spaced->push_back(after_space);
+    after_space = best_run >= min_space;
+    start = split;
+  }
+  chunks->push_back(TBOX(box.left() + start, box.bottom(), box.right(),
+                         box.top()));
+  spaced->push_back(after_space);
+}
+
+// Moves the words of chunks [start, end) of a line to words, in order, giving
+// the first word of a chunk that starts after a space its space.
+static void StitchChunks(const std::vector<bool>& spaced, size_t start,
+                         size_t end,
+                         std::vector<PointerVector<WERD_RES>>* chunk_words,
+                         PointerVector<WERD_RES>* words) {
+  for (size_t c = start; c < end; ++c) {
+    PointerVector<WERD_RES>& chunk = (*chunk_words)[c];
+    for (int w = 0; w < chunk.size(); ++w) {
+      if (w == 0 && spaced[c] && chunk[w]->word->space() == 0)
+        chunk[w]->word->set_blanks(1);
+      words->push_back(chunk[w]);
+      chunk[w] = nullptr;
+    }
+  }
+}
+
+// Recognizes a word or group of words, converting to WERD_RES in *words.
+// Analogous to classify_word_pass1, but can handle a group of words as well.
+void Tesseract::LSTMRecognizeWord(const BLOCK& block, ROW *row, WERD_RES *word,
+                                  PointerVector<WERD_RES>* words) {
+  auto batched = lstm_batch_words_.find(word);
+  if (batched != lstm_batch_words_.end()) {
+    // Already recognized by PrerecAllLinesLSTM, so take over the results.
+    for (int w = 0; w < batched->second.size(); ++w) {
+      words->push_back(batched->second[w]);
+      batched->second[w] = nullptr;
+    }
+    lstm_batch_words_.erase(batched);
+    SearchWords(words);
+    return;
+  }
+  std::vector<ImageData*> images;
+  std::vector<TBOX> boxes;
+  std::vector<bool> spaced;
+  GetLSTMWordChunks(block, row, word, &images, &boxes, &spaced);
+  if (images.empty()) return;
+  lstm_recognizer_->SetNumThreads(tessedit_num_threads);
+  lstm_recognizer_->SetMaxBlankGap(lstm_max_blank_gap);
+  lstm_recognizer_->SetGreedyDecode(lstm_greedy_decode);
+  lstm_recognizer_->SetBeamCollapseMargin(lstm_beam_collapse_margin);
+  lstm_recognizer_->SetLatticeSize(lstm_lattice_size);
+  lstm_recognizer_->SetPolarityCheck(lstm_polarity_check);
+  lstm_recognizer_->SetMaxLineTimesteps(LSTMMaxLineTimesteps());
+  lstm_recognizer_->SetOutputCacheSize(lstm_output_cache_size);
+  if (images.size() == 1) {
+    lstm_recognizer_->RecognizeLineCached(
+        *images[0], true, classify_debug_level > 0,
+        kWorstDictCertainty / kCertaintyScale, boxes[0], words,
+        lstm_choice_mode);
+  } else {
+    // The chunks of a wide line are recognized as a batch of lines, on
+    // lstm_line_threads threads.
+    std::vector<PointerVector<WERD_RES>> chunk_words(images.size());
+    std::vector<const ImageData*> chunk_images(images.begin(), images.end());
+    std::vector<PointerVector<WERD_RES>*> results;
+    for (auto& chunk : chunk_words) results.push_back(&chunk);
+    lstm_recognizer_->SetPipelineDecode(lstm_pipeline_decode);
+    lstm_recognizer_->RecognizeLines(
+        chunk_images, lstm_batch_size, lstm_line_threads, true,
+        classify_debug_level > 0, kWorstDictCertainty / kCertaintyScale,
+        boxes, results, lstm_choice_mode);
+    StitchChunks(spaced, 0, images.size(), &chunk_words, words);
+  }
+  for (auto im_data : images) delete im_data;
   SearchWords(words);
 }
 
+
+// Runs the LSTM recognizer on all the words, lstm_batch_size lines at a time
+// on up to lstm_line_threads threads, keeping the results for
+// LSTMRecognizeWord to pick up, so that the normal word loop gets the same
+// results, only faster.
+void Tesseract::PrerecAllLinesLSTM(const GenericVector<WordData>& words) {
+  lstm_batch_words_.clear();
+  // With sub languages, it isn't known in advance which recognizer will be
+  // used for each word.
+  if (lstm_recognizer_ == nullptr ||
+      tessedit_ocr_engine_mode != OEM_LSTM_ONLY || !sub_langs_.empty())
+    return;
+  std::vector<ImageData*> images;
+  std::vector<TBOX> word_boxes;
+  std::vector<bool> spaced;
+  // The word of each image, as a wide line may be split into many chunks.
+  std::vector<WERD_RES*> image_words;
+  for (int w = 0; w < words.size(); ++w) {
+    WERD_RES* word = words[w].lang_words[0];
+    GetLSTMWordChunks(*words[w].block, words[w].row, word, &images,
+                      &word_boxes, &spaced);
+    image_words.resize(images.size(), word);
+  }
+  std::vector<PointerVector<WERD_RES>> chunk_words(images.size());
+  std::vector<PointerVector<WERD_RES>*> results;
+  for (auto& chunk : chunk_words) results.push_back(&chunk);
+  lstm_recognizer_->SetNumThreads(tessedit_num_threads);
+  lstm_recognizer_->SetMaxBlankGap(lstm_max_blank_gap);
+  lstm_recognizer_->SetGreedyDecode(lstm_greedy_decode);
+  lstm_recognizer_->SetBeamCollapseMargin(lstm_beam_collapse_margin);
+  lstm_recognizer_->SetLatticeSize(lstm_lattice_size);
+  lstm_recognizer_->SetPolarityCheck(lstm_polarity_check);
+  lstm_recognizer_->SetMaxLineTimesteps(LSTMMaxLineTimesteps());
+  lstm_recognizer_->SetPipelineDecode(lstm_pipeline_decode);
+  std::vector<const ImageData*> line_images(images.begin(), images.end());
+  lstm_recognizer_->RecognizeLines(line_images, lstm_batch_size,
+                                   lstm_line_threads, true,
+                                   classify_debug_level > 0,
+                                   kWorstDictCertainty / kCertaintyScale,
+                                   word_boxes, results, lstm_choice_mode);
+  for (auto im_data : images) delete im_data;
+  // Gather the chunks of each word.
+  for (size_t start = 0; start < images.size();) {
+    size_t end = start + 1;
+    while (end < images.size() && image_words[end] == image_words[start])
+      ++end;
+    StitchChunks(spaced, start, end, &chunk_words,
+                 &lstm_batch_words_[image_words[start]]);
+    start = end;
+  }
+}
+
+bool Tesseract::RecognizeLinesLSTM(
+    const std::vector<Pix*>& pixes,
+    std::vector<PointerVector<WERD_RES>>* words) {
+  if (lstm_recognizer_ == nullptr ||
+      tessedit_ocr_engine_mode != OEM_LSTM_ONLY || !sub_langs_.empty())
+    return false;
+  words->clear();
+  words->resize(pixes.size());
+  std::vector<const ImageData*> images;
+  std::vector<TBOX> line_boxes;
+  std::vector<PointerVector<WERD_RES>*> results;
+  for (size_t i = 0; i < pixes.size(); ++i) {
+    if (pixes[i] == nullptr) continue;
+    // The LSTM input doesn't handle colormaps.
+    Pix* pix = pixGetColormap(pixes[i]) != nullptr
+                   ? pixRemoveColormap(pixes[i], REMOVE_CMAP_BASED_ON_SRC)
+                   : pixClone(pixes[i]);
+    if (pix == nullptr) continue;
+    line_boxes.push_back(TBOX(0, 0, pixGetWidth(pix), pixGetHeight(pix)));
+    // ImageData takes the pix, and keeps it as it is only to be recognized.
+    images.push_back(new ImageData(false, pix, true));
+    results.push_back(&(*words)[i]);
+  }
+  lstm_recognizer_->SetNumThreads(tessedit_num_threads);
+  lstm_recognizer_->SetMaxBlankGap(lstm_max_blank_gap);
+  lstm_recognizer_->SetGreedyDecode(lstm_greedy_decode);
+  lstm_recognizer_->SetBeamCollapseMargin(lstm_beam_collapse_margin);
+  lstm_recognizer_->SetLatticeSize(lstm_lattice_size);
+  lstm_recognizer_->SetPolarityCheck(lstm_polarity_check);
+  lstm_recognizer_->SetMaxLineTimesteps(LSTMMaxLineTimesteps());
+  lstm_recognizer_->SetPipelineDecode(lstm_pipeline_decode);
+  lstm_recognizer_->RecognizeLines(images, lstm_batch_size, lstm_line_threads,
+                                   true, classify_debug_level > 0,
+                                   kWorstDictCertainty / kCertaintyScale,
+                                   line_boxes, results, lstm_choice_mode);
+  for (auto im_data : images) delete im_data;
+  for (auto result : results) SearchWords(result);
+  return true;
+}
+
+// The lines of a batch are recognized at once on each thread, and get a
+// quarter of the memory budget between them, the rest being left for the
+// images and layout of the page and for the results.
+int Tesseract::LSTMMaxLineTimesteps() const {
+  int max_timesteps = lstm_max_line_timesteps;
+  if (tessedit_memory_budget_mb <= 0 || lstm_recognizer_ == nullptr)
+    return max_timesteps;
+  const int64_t lines = std::max(static_cast<int>(lstm_line_threads), 1) *
+                        std::max(static_cast<int>(lstm_batch_size), 1);
+  const int64_t line_bytes =
+      (static_cast<int64_t>(tessedit_memory_budget_mb) << 20) / 4 / lines;
+  const int64_t budget_timesteps = std::max<int64_t>(
+      line_bytes / lstm_recognizer_->BytesPerTimestep(), 1);
+  if (max_timesteps <= 0 || budget_timesteps < max_timesteps)
+    max_timesteps = static_cast<int>(budget_timesteps);
+  return max_timesteps;
+}
+
+int Tesseract::NumWideLines() const {
+  int count =
+      lstm_recognizer_ != nullptr ? lstm_recognizer_->num_wide_lines() : 0;
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    count += sub_langs_[i]->NumWideLines();
+  return count;
+}
+
 // Apply segmentation search to the given set of words, within the constraints
 // of the existing ratings matrix. If there is already a best_choice on a word
 // leaves it untouched and just sets the done/accepted etc flags.
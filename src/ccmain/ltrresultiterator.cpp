@@ -147,10 +147,13 @@ float LTRResultIterator::Confidence(PageIteratorLevel level) const {
 
 void LTRResultIterator::RowAttributes(float* row_height, float* descenders,
                                       float* ascenders) const {
-  *row_height = it_->row()->row->x_height() + it_->row()->row->ascenders() -
-                it_->row()->row->descenders();
-  *descenders = it_->row()->row->descenders();
-  *ascenders = it_->row()->row->ascenders();
+  // The row is in internal coordinates, which may be a reduction of the
+  // original image.
+  const int reduction = tesseract_->image_reduction();
+  *row_height = (it_->row()->row->x_height() + it_->row()->row->ascenders() -
+                 it_->row()->row->descenders()) * reduction;
+  *descenders = it_->row()->row->descenders() * reduction;
+  *ascenders = it_->row()->row->ascenders() * reduction;
 }
 
 // Returns the font attributes of the current word. If iterating at a higher
@@ -170,9 +173,10 @@ const char* LTRResultIterator::WordFontAttributes(
     // Already at the end!
     *pointsize = 0;
   } else {
-    float row_height = it_->row()->row->x_height() +
-                       it_->row()->row->ascenders() -
-                       it_->row()->row->descenders();
+    float row_height = (it_->row()->row->x_height() +
+                        it_->row()->row->ascenders() -
+                        it_->row()->row->descenders()) *
+                       tesseract_->image_reduction();
     // Convert from pixels to printers points.
     *pointsize =
         scaled_yres_ > 0
@@ -361,6 +365,7 @@ ChoiceIterator::ChoiceIterator(const LTRResultIterator& result_it) {
   oemLegacy_ = word_res_->tesseract->AnyTessLang();
   BLOB_CHOICE_LIST* choices = nullptr;
   tstep_index_ = &result_it.blob_index_;
+  word_res_->ComputeLSTMChoices();
   if (oemLSTM_ && !oemLegacy_ && !word_res_->accumulated_timesteps.empty()) {
     if (word_res_->leadingSpace)
       LSTM_choices_ = &word_res_->accumulated_timesteps[(*tstep_index_) + 1];
@@ -47,6 +47,9 @@ const float kHanRatioInJapanese = 0.3;
 
 const float kNonAmbiguousMargin = 1.0;
 
+// Lowest resolution of the reduced image of fast OSD.
+const int kMinFastOSDResolution = 150;
+
 // General scripts
 static const char* han_script = "Han";
 static const char* latin_script = "Latin";
@@ -154,10 +157,9 @@ void OSResults::accumulate(const OSResults& osr) {
 
 // Detect and erase horizontal/vertical lines and picture regions from the
 // image, so that non-text blobs are removed from consideration.
-static void remove_nontext_regions(tesseract::Tesseract *tess,
+static void remove_nontext_regions(tesseract::Tesseract *tess, Pix *pix,
                                    BLOCK_LIST *blocks,
                                    TO_BLOCK_LIST *to_blocks) {
-  Pix *pix = tess->pix_binary();
   ASSERT_HOST(pix != nullptr);
   int vertical_x = 0;
   int vertical_y = 1;
@@ -180,8 +182,30 @@ static void remove_nontext_regions(tesseract::Tesseract *tess,
     pixSubtract(pix, pix, im_pix);
     pixDestroy(&im_pix);
   }
-  tess->mutable_textord()->find_components(tess->pix_binary(),
-                                           blocks, to_blocks);
+  tess->mutable_textord()->find_components(pix, blocks, to_blocks);
+}
+
+// Returns a copy of the binary image of tess reduced by a power of 2, up to
+// 16, to the lowest resolution of at least kMinFastOSDResolution, or nullptr
+// if it is already too small to reduce. The reduction keeps every foreground
+// pixel, so thin strokes don't break up, and it scales the resolution.
+// The reduction comes from the pyramid of tess, so the layout analysis that
+// follows can use it again, but it is copied, as the caller removes lines
+// and images from it.
+static Pix* reduce_for_fast_osd(tesseract::Tesseract *tess) {
+  Pix* pix = tess->pix_binary();
+  int resolution = pixGetXRes(pix);
+  int factor = 1;
+  for (int level = 0; level < tesseract::kMaxPyramidLevels; ++level) {
+    if (resolution < 2 * kMinFastOSDResolution) break;
+    factor *= 2;
+    resolution /= 2;
+  }
+  if (factor == 1) return nullptr;
+  Pix* reduced = tess->binary_pyramid()->GetReduction(pix, factor);
+  Pix* result = pixCopy(nullptr, reduced);
+  pixDestroy(&reduced);
+  return result;
 }
 
 // Find connected components in the page and process a subset until finished or
@@ -203,17 +227,32 @@ int orientation_and_script_detection(STRING& filename,
   int height = pixGetHeight(tess->pix_binary());
 
   BLOCK_LIST blocks;
-  if (!read_unlv_file(name, width, height, &blocks))
+  // Fast OSD works on a reduced image, except with a zone file, whose blocks
+  // are in the coordinates of the full image.
+  Pix* pix = nullptr;
+  if (!read_unlv_file(name, width, height, &blocks)) {
+    if (tess->osd_fast)
+      pix = reduce_for_fast_osd(tess);
+    if (pix != nullptr) {
+      width = pixGetWidth(pix);
+      height = pixGetHeight(pix);
+    }
     FullPageBlock(width, height, &blocks);
+  }
+  bool modifies_binary = pix == nullptr;
+  if (pix == nullptr)
+    pix = pixClone(tess->pix_binary());
 
   // Try to remove non-text regions from consideration.
   TO_BLOCK_LIST land_blocks, port_blocks;
-  remove_nontext_regions(tess, &blocks, &port_blocks);
+  remove_nontext_regions(tess, pix, &blocks, &port_blocks);
+  // The clone shares the pixels of the binary image, so its reductions no
+  // longer match it.
+  if (modifies_binary) tess->binary_pyramid()->Invalidate();
 
   if (port_blocks.empty()) {
     // page segmentation did not succeed, so we need to find_components first.
-    tess->mutable_textord()->find_components(tess->pix_binary(),
-                                             &blocks, &port_blocks);
+    tess->mutable_textord()->find_components(pix, &blocks, &port_blocks);
   } else {
     page_box.set_left(0);
     page_box.set_bottom(0);
@@ -223,6 +262,7 @@ int orientation_and_script_detection(STRING& filename,
     tess->mutable_textord()->filter_blobs(page_box.topright(),
                                           &port_blocks, true);
   }
+  pixDestroy(&pix);
 
   return os_detect(&port_blocks, osr, tess);
 }
@@ -281,11 +321,22 @@ int os_detect_blobs(const GenericVector<int>* allowed_scripts,
   OSResults osr_;
   int minCharactersToTry = tess->min_characters_to_try;
   int maxCharactersToTry = 5 * minCharactersToTry;
+  // Fast OSD classifies fewer blobs, and may stop as soon as the orientation
+  // is clear, after the least number of blobs that is still reliable.
+  double min_margin = 0.0;
+  int min_to_stop = minCharactersToTry;
+  if (tess->osd_fast) {
+    int max_blobs = std::max(static_cast<int>(tess->osd_fast_max_blobs),
+                             minCharactersToTry / 2);
+    maxCharactersToTry = std::min(maxCharactersToTry, max_blobs);
+    min_margin = tess->min_orientation_margin;
+    min_to_stop = minCharactersToTry / 2;
+  }
   if (osr == nullptr)
     osr = &osr_;
 
   osr->unicharset = &tess->unicharset;
-  OrientationDetector o(allowed_scripts, osr);
+  OrientationDetector o(allowed_scripts, osr, min_margin);
   ScriptDetector s(allowed_scripts, osr, tess);
 
   BLOBNBOX_C_IT filtered_it(blob_list);
@@ -310,7 +361,7 @@ int os_detect_blobs(const GenericVector<int>* allowed_scripts,
   int num_blobs_evaluated = 0;
   for (int i = 0; i < real_max; ++i) {
     if (os_detect_blob(blobs[sequence.GetVal()], &o, &s, osr, tess)
-        && i > minCharactersToTry) {
+        && i > min_to_stop) {
       break;
     }
     ++num_blobs_evaluated;
@@ -372,9 +423,11 @@ bool os_detect_blob(BLOBNBOX* bbox, OrientationDetector* o,
 
 
 OrientationDetector::OrientationDetector(
-    const GenericVector<int>* allowed_scripts, OSResults* osr) {
+    const GenericVector<int>* allowed_scripts, OSResults* osr,
+    double min_margin) {
   osr_ = osr;
   allowed_scripts_ = allowed_scripts;
+  min_margin_ = min_margin;
 }
 
 // Score the given blob and return true if it is now sure of the orientation
@@ -439,9 +492,11 @@ bool OrientationDetector::detect_blob(BLOB_CHOICE_LIST* scores) {
     osr_->orientations[i] += log(blob_o_score[i] / total_blob_o_score);
   }
 
-  // TODO(ranjith) Add an early exit test, based on min_orientation_margin,
-  // as used in pagesegmain.cpp.
-  return false;
+  // Exit early once the best orientation is convincing, by the same margin
+  // as is required of it in pagesegmain.cpp.
+  if (min_margin_ <= 0.0) return false;
+  osr_->update_best_orientation();
+  return osr_->best_result.oconfidence >= min_margin_;
 }
 
 int OrientationDetector::get_orientation() {
@@ -83,13 +83,16 @@ struct OSResults {
 
 class OrientationDetector {
  public:
+  // If min_margin is positive, detect_blob returns true once the margin of
+  // the best orientation over the second best reaches it.
   OrientationDetector(const GenericVector<int>* allowed_scripts,
-                      OSResults* results);
+                      OSResults* results, double min_margin = 0.0);
   bool detect_blob(BLOB_CHOICE_LIST* scores);
   int get_orientation();
  private:
   OSResults* osr_;
   const GenericVector<int>* allowed_scripts_;
+  double min_margin_;
 };
 
 class ScriptDetector {
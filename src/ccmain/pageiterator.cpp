@@ -335,14 +335,17 @@ bool PageIterator::BoundingBox(PageIteratorLevel level, const int padding,
   if (!BoundingBoxInternal(level, left, top, right, bottom))
     return false;
   // Convert to the coordinate system of the original image.
-  *left = ClipToRange(*left / scale_ + rect_left_ - padding,
+  const int reduction = tesseract_->image_reduction();
+  *left = ClipToRange(*left * reduction / scale_ + rect_left_ - padding,
                       rect_left_, rect_left_ + rect_width_);
-  *top = ClipToRange(*top / scale_ + rect_top_ - padding,
+  *top = ClipToRange(*top * reduction / scale_ + rect_top_ - padding,
                      rect_top_, rect_top_ + rect_height_);
-  *right = ClipToRange((*right + scale_ - 1) / scale_ + rect_left_ + padding,
-                       *left, rect_left_ + rect_width_);
-  *bottom = ClipToRange((*bottom + scale_ - 1) / scale_ + rect_top_ + padding,
-                        *top, rect_top_ + rect_height_);
+  *right = ClipToRange(
+      (*right * reduction + scale_ - 1) / scale_ + rect_left_ + padding,
+      *left, rect_left_ + rect_width_);
+  *bottom = ClipToRange(
+      (*bottom * reduction + scale_ - 1) / scale_ + rect_top_ + padding,
+      *top, rect_top_ + rect_height_);
   return true;
 }
 
@@ -373,12 +376,14 @@ Pta* PageIterator::BlockPolygon() const {
     return nullptr;  // No layout analysis used - no polygon.
   ICOORDELT_IT it(it_->block()->block->pdblk.poly_block()->points());
   Pta* pta = ptaCreate(it.length());
+  const float scale = static_cast<float>(tesseract_->image_reduction()) /
+                      scale_;
   int num_pts = 0;
   for (it.mark_cycle_pt(); !it.cycled_list(); it.forward(), ++num_pts) {
     ICOORD* pt = it.data();
     // Convert to top-down coords within the input image.
-    float x = static_cast<float>(pt->x()) / scale_ + rect_left_;
-    float y = rect_top_ + rect_height_ - static_cast<float>(pt->y()) / scale_;
+    float x = pt->x() * scale + rect_left_;
+    float y = rect_top_ + rect_height_ - pt->y() * scale;
     ptaAddPt(pta, x, y);
   }
   return pta;
@@ -463,6 +468,17 @@ Pix* PageIterator::GetImage(PageIteratorLevel level, int padding,
     // Clip to the block polygon as well.
     TBOX mask_box;
     Pix* mask = it_->block()->block->render_mask(&mask_box);
+    const int reduction = tesseract_->image_reduction();
+    if (reduction > 1) {
+      // The mask is in the reduced internal coordinates.
+      Pix* expanded = pixExpandReplicate(mask, reduction);
+      pixDestroy(&mask);
+      mask = expanded;
+      mask_box = TBOX(mask_box.left() * reduction,
+                      mask_box.bottom() * reduction,
+                      mask_box.right() * reduction,
+                      mask_box.top() * reduction);
+    }
     // Copy the mask registered correctly into an image the size of grey_pix.
     int mask_x = *left - mask_box.left();
     int mask_y = *top - (pixGetHeight(original_img) - mask_box.top());
@@ -501,10 +517,11 @@ bool PageIterator::Baseline(PageIteratorLevel level,
   // Rotate to image coordinates and convert to global image coords.
   startpt.rotate(it_->block()->block->re_rotation());
   endpt.rotate(it_->block()->block->re_rotation());
-  *x1 = startpt.x() / scale_ + rect_left_;
-  *y1 = (rect_height_ - startpt.y()) / scale_ + rect_top_;
-  *x2 = endpt.x() / scale_ + rect_left_;
-  *y2 = (rect_height_ - endpt.y()) / scale_ + rect_top_;
+  const int reduction = tesseract_->image_reduction();
+  *x1 = startpt.x() * reduction / scale_ + rect_left_;
+  *y1 = (rect_height_ - startpt.y() * reduction) / scale_ + rect_top_;
+  *x2 = endpt.x() * reduction / scale_ + rect_left_;
+  *y2 = (rect_height_ - endpt.y() * reduction) / scale_ + rect_top_;
   return true;
 }
 
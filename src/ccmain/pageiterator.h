@@ -210,7 +210,8 @@ class TESS_API PageIterator {
   /**
    * Returns the bounding rectangle of the object in a coordinate system of the
    * working image rectangle having its origin at (rect_left_, rect_top_) with
-   * respect to the original image and is scaled by a factor scale_.
+   * respect to the original image and is scaled by a factor scale_, and
+   * reduced by the image_reduction of the Tesseract.
    */
   bool BoundingBoxInternal(PageIteratorLevel level,
                            int* left, int* top, int* right, int* bottom) const;
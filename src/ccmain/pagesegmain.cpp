@@ -24,6 +24,9 @@
 #include <unistd.h>
 #endif  // _WIN32
 
+#include <algorithm>
+#include <vector>
+
 // Include automatically generated configuration file if running autoconf.
 #ifdef HAVE_CONFIG_H
 #include "config_auto.h"
@@ -33,6 +36,7 @@
 #include "blobbox.h"
 #include "blread.h"
 #include "colfind.h"
+#include "counters.h"
 #include "debugpixa.h"
 #include "equationdetect.h"
 #include "imagefind.h"
@@ -44,6 +48,7 @@
 #include "tessvars.h"
 #include "textord.h"
 #include "tordmain.h"
+#include "tracing.h"
 #include "wordseg.h"
 
 namespace tesseract {
@@ -91,6 +96,134 @@ static Pix* RemoveEnclosingCircle(Pix* pixs) {
   return pixout;
 }
 
+// Height of the horizontal strips of the page, as a fraction of an inch, in
+// which IsSingleColumnPage looks for column gutters.
+const int kGutterStripFraction = 2;
+// Min width of a column gutter as a fraction of an inch. Wider than the
+// word spaces of ordinary justified text.
+const int kMinGutterWidthFraction = 5;
+// Min number of consecutive strips that a gutter must cross.
+const int kMinGutterStrips = 3;
+// Max foreground pixels in a column of a strip for it to count as empty,
+// so isolated specks of noise don't hide a gutter.
+const int kMaxGutterColumnPixels = 2;
+
+// Returns true if the binary page image looks like a single column of text:
+// it is cut into strips, and no strip has a gap free of ink, wide enough to
+// be a column gutter and with ink on both sides, that continues in the same
+// place through kMinGutterStrips strips. Tables, images and multi-column
+// text all make such gaps. This is a cheap test on the raw pixels, used to
+// decide that full layout analysis isn't needed.
+static bool IsSingleColumnPage(Pix* pix, int resolution) {
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  int wpl = pixGetWpl(pix);
+  const l_uint32* data = pixGetData(pix);
+  int strip_height = std::max(resolution / kGutterStripFraction, 1);
+  int min_gutter = std::max(resolution / kMinGutterWidthFraction, 1);
+  std::vector<int> column_counts(width);
+  // Gutters found in the previous strips, as [start, end) x ranges, and the
+  // number of consecutive strips that each of them has crossed.
+  std::vector<ICOORD> gutters, prev_gutters;
+  std::vector<int> gutter_strips, prev_gutter_strips;
+  for (int top = 0; top < height; top += strip_height) {
+    int bottom = std::min(top + strip_height, height);
+    std::fill(column_counts.begin(), column_counts.end(), 0);
+    for (int y = top; y < bottom; ++y) {
+      const l_uint32* line = data + y * wpl;
+      for (int w = 0; w < wpl; ++w) {
+        l_uint32 bits = line[w];
+        if (bits == 0) continue;
+        // Leptonica stores the leftmost pixel in the most significant bit.
+        int end = std::min(32, width - w * 32);
+        for (int b = 0; b < end; ++b) {
+          if (bits & (0x80000000u >> b)) ++column_counts[w * 32 + b];
+        }
+      }
+    }
+    int left = 0;
+    while (left < width && column_counts[left] <= kMaxGutterColumnPixels)
+      ++left;
+    int right = width - 1;
+    while (right > left && column_counts[right] <= kMaxGutterColumnPixels)
+      --right;
+    prev_gutters.swap(gutters);
+    prev_gutter_strips.swap(gutter_strips);
+    gutters.clear();
+    gutter_strips.clear();
+    for (int x = left; x < right;) {
+      if (column_counts[x] > kMaxGutterColumnPixels) {
+        ++x;
+        continue;
+      }
+      int start = x;
+      while (x < right && column_counts[x] <= kMaxGutterColumnPixels) ++x;
+      if (x - start < min_gutter) continue;
+      // A gutter. Continue the longest run of an overlapping previous one.
+      int strips = 1;
+      for (size_t g = 0; g < prev_gutters.size(); ++g) {
+        if (prev_gutters[g].x() < x && start < prev_gutters[g].y())
+          strips = std::max(strips, prev_gutter_strips[g] + 1);
+      }
+      if (strips >= kMinGutterStrips) return false;
+      gutters.push_back(ICOORD(start, x));
+      gutter_strips.push_back(strips);
+    }
+  }
+  return true;
+}
+
+// Reduction of the page image in which BlankPageReason counts components.
+const int kBlankPageReduction = 4;
+// Min and max heights of a text-sized component, as fractions and multiples
+// of an inch. The min is below the x-height of 6 point text, so speckle
+// and the bleed-through of the back of a sheet count as noise, and the max
+// is above the size of large headings, so borders and shadows don't count.
+const int kMinBlankTextHeightFraction = 40;
+const int kMaxBlankTextHeight = 2;
+
+// Returns why the binary page image has nothing text-like on it, or nullptr
+// if it may have text: either it has no ink at all, or at most max_ink of
+// its pixels are ink and, in an image reduced by kBlankPageReduction, it
+// has no more than max_blobs components of the height of text. This takes
+// a few milliseconds even on a large page, much less than the layout
+// analysis and noise removal that it saves on blank sheets. The reduction
+// is taken from pyramid, where line finding can use it again.
+static const char* BlankPageReason(Pix* pix, ImagePyramid* pyramid,
+                                   int resolution, double max_ink,
+                                   int max_blobs) {
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  l_int32 ink = 0;
+  pixCountPixels(pix, &ink, nullptr);
+  if (ink == 0) return "no ink";
+  if (ink > max_ink * width * height) return nullptr;
+  // The rank 1 reduction keeps every speck of ink, so thin strokes stay
+  // connected.
+  Pix* reduced = width >= kBlankPageReduction * 8 &&
+                         height >= kBlankPageReduction * 8
+                     ? pyramid->GetReduction(pix, kBlankPageReduction)
+                     : pixClone(pix);
+  int reduction = pixGetWidth(reduced) < width ? kBlankPageReduction : 1;
+  int min_height = resolution / kMinBlankTextHeightFraction / reduction;
+  int max_height = resolution * kMaxBlankTextHeight / reduction;
+  Boxa* boxa = pixConnCompBB(reduced, 8);
+  pixDestroy(&reduced);
+  if (boxa == nullptr) return nullptr;
+  int num_text_blobs = 0;
+  int num_boxes = boxaGetCount(boxa);
+  for (int i = 0; i < num_boxes && num_text_blobs <= max_blobs; ++i) {
+    l_int32 box_width, box_height;
+    boxaGetBoxGeometry(boxa, i, nullptr, nullptr, &box_width, &box_height);
+    if (box_height >= min_height && box_height <= max_height &&
+        box_width <= max_height) {
+      ++num_text_blobs;
+    }
+  }
+  boxaDestroy(&boxa);
+  return num_text_blobs <= max_blobs ? "no text-sized components" : nullptr;
+}
+
 /**
  * Segment the page according to the current value of tessedit_pageseg_mode.
  * pix_binary_ is used as the source image and should not be nullptr.
@@ -98,12 +231,28 @@ static Pix* RemoveEnclosingCircle(Pix* pixs) {
  */
 int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
                            Tesseract* osd_tess, OSResults* osr) {
+  TraceSpan span("SegmentPage");
   ASSERT_HOST(pix_binary_ != nullptr);
   int width = pixGetWidth(pix_binary_);
   int height = pixGetHeight(pix_binary_);
   // Get page segmentation mode.
   auto pageseg_mode = static_cast<PageSegMode>(
       static_cast<int>(tessedit_pageseg_mode));
+  // Blank separator sheets and the backs of pages are common in batch scans,
+  // so they are rejected before any layout analysis.
+  blank_page_reason_ = nullptr;
+  if (textord_blank_page_reject && pageseg_mode != PSM_OSD_ONLY) {
+    blank_page_reason_ =
+        BlankPageReason(pix_binary_, &binary_pyramid_, source_resolution_,
+                        textord_blank_page_max_ink,
+                        textord_blank_page_max_blobs);
+    if (blank_page_reason_ != nullptr) {
+      if (textord_debug_tabfind)
+        tprintf("Blank page: %s\n", blank_page_reason_);
+      CountEvent(COUNTER_BLANK_PAGES);
+      return 0;
+    }
+  }
   // If a UNLV zone file can be found, use that instead of segmentation.
   if (!PSM_COL_FIND_ENABLED(pageseg_mode) &&
       input_file != nullptr && input_file->length() > 0) {
@@ -124,6 +273,16 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
     // UNLV file present. Use PSM_SINGLE_BLOCK.
     pageseg_mode = PSM_SINGLE_BLOCK;
   }
+  // In fast auto layout, a page of a single column of text is segmented just
+  // by the textline finding of PSM_SINGLE_BLOCK, and only pages with more
+  // structure get full layout analysis.
+  if (textord_fast_auto_layout && PSM_COL_FIND_ENABLED(pageseg_mode) &&
+      !PSM_OSD_ENABLED(pageseg_mode) &&
+      IsSingleColumnPage(pix_binary_, source_resolution_)) {
+    if (textord_debug_tabfind)
+      tprintf("Single column page: skipping layout analysis\n");
+    pageseg_mode = PSM_SINGLE_BLOCK;
+  }
   // The diacritic_blobs holds noise blobs that may be diacritics. They
   // are separated out on areas of the image that seem noisy and short-circuit
   // the layout process, going straight from the initial partition creation
@@ -133,6 +292,12 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
   BLOBNBOX_LIST diacritic_blobs;
   int auto_page_seg_ret_val = 0;
   TO_BLOCK_LIST to_blocks;
+  // The layout analysis of a big page takes long, so it stops between its
+  // stages when out of time.
+  if (Cancelled()) {
+    blocks->clear();
+    return -1;
+  }
   if (PSM_OSD_ENABLED(pageseg_mode) || PSM_BLOCK_FIND_ENABLED(pageseg_mode) ||
       PSM_SPARSE(pageseg_mode)) {
     auto_page_seg_ret_val = AutoPageSeg(
@@ -157,6 +322,10 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
   if (auto_page_seg_ret_val < 0) {
     return -1;
   }
+  if (Cancelled()) {
+    blocks->clear();
+    return -1;
+  }
 
   if (blocks->empty()) {
     if (textord_debug_tabfind)
@@ -170,6 +339,10 @@ int Tesseract::SegmentPage(const STRING* input_file, BLOCK_LIST* blocks,
   textord_.TextordPage(pageseg_mode, reskew_, width, height, pix_binary_,
                        pix_thresholds_, pix_grey_, splitting || cjk_mode,
                        &diacritic_blobs, blocks, &to_blocks);
+  if (Cancelled()) {
+    blocks->clear();
+    return -1;
+  }
   return auto_page_seg_ret_val;
 }
 
@@ -211,6 +384,11 @@ int Tesseract::AutoPageSeg(PageSegMode pageseg_mode, BLOCK_LIST* blocks,
       pageseg_mode, blocks, osd_tess, osr, &temp_blocks, &photomask_pix,
       &musicmask_pix);
   int result = 0;
+  if (finder != nullptr && Cancelled()) {
+    delete finder;
+    finder = nullptr;
+    result = -1;
+  }
   if (finder != nullptr) {
     TO_BLOCK_IT to_block_it(&temp_blocks);
     TO_BLOCK* to_block = to_block_it.data();
@@ -285,12 +463,14 @@ ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
   LineFinder::FindAndRemoveLines(source_resolution_,
                                  textord_tabfind_show_vlines, pix_binary_,
                                  &vertical_x, &vertical_y, music_mask_pix,
-                                 &v_lines, &h_lines);
+                                 &v_lines, &h_lines, tessedit_num_threads,
+                                 &binary_pyramid_);
   if (tessedit_dump_pageseg_images) {
     pixa_debug_.AddPix(pix_binary_, "NoLines");
   }
   // Leptonica is used to find a mask of the photo regions in the input.
-  *photo_mask_pix = ImageFind::FindImages(pix_binary_, &pixa_debug_);
+  *photo_mask_pix =
+      ImageFind::FindImages(pix_binary_, &pixa_debug_, &binary_pyramid_);
   if (tessedit_dump_pageseg_images) {
     pixa_debug_.AddPix(pix_binary_, "NoImages");
   }
@@ -322,6 +502,8 @@ ColumnFinder* Tesseract::SetupPageSegAndDetectOrientation(
                               estimated_resolution, textord_use_cjk_fp_model,
                               textord_tabfind_aligned_gap_fraction, &v_lines,
                               &h_lines, vertical_x, vertical_y);
+    finder->set_num_threads(tessedit_num_threads);
+    finder->set_compute_edge_offsets(NeedEdgeOffsets());
 
     finder->SetupAndFilterNoise(pageseg_mode, *photo_mask_pix, to_block);
 
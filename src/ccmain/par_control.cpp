@@ -17,6 +17,7 @@
 //
 ///////////////////////////////////////////////////////////////////////
 
+#include "numthreads.h"
 #include "tesseractclass.h"
 #ifdef _OPENMP
 #include <omp.h>
@@ -51,21 +52,18 @@ void Tesseract::PrerecAllWordsPar(const GenericVector<WordData>& words) {
       }
     }
   }
-  // Pre-classify all the blobs.
-  if (tessedit_parallelize > 1) {
+  // Pre-classify all the blobs. classify_blob is reentrant, as the integer
+  // matcher keeps its scratch tables per thread and the blob choice cache is
+  // locked, so by default all the available threads share the work.
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(10)
+  const int num_threads =
+      NumThreads(omp_get_max_threads(), tessedit_num_threads);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) \
+    if (num_threads > 1)
 #endif  // _OPENMP
-    for (int b = 0; b < blobs.size(); ++b) {
-      *blobs[b].choices =
-          blobs[b].tesseract->classify_blob(blobs[b].blob, "par", White, nullptr);
-    }
-  } else {
-    // TODO(AMD) parallelize this.
-    for (int b = 0; b < blobs.size(); ++b) {
-      *blobs[b].choices =
-          blobs[b].tesseract->classify_blob(blobs[b].blob, "par", White, nullptr);
-    }
+  for (int b = 0; b < blobs.size(); ++b) {
+    *blobs[b].choices =
+        blobs[b].tesseract->classify_blob(blobs[b].blob, "par", White, nullptr);
   }
 }
 
@@ -39,8 +39,7 @@ ResultIterator::ResultIterator(const LTRResultIterator &resit)
   preserve_interword_spaces_ = false;
 
   auto *p = ParamUtils::FindParam<BoolParam>(
-      "preserve_interword_spaces", GlobalParams()->bool_params,
-      tesseract_->params()->bool_params);
+      "preserve_interword_spaces", GlobalParams(), tesseract_->params());
   if (p != nullptr) preserve_interword_spaces_ = (bool)(*p);
 
   current_paragraph_is_ltr_ = CurrentParagraphIsLtr();
@@ -607,6 +606,7 @@ char* ResultIterator::GetUTF8Text(PageIteratorLevel level) const {
 std::vector<std::vector<std::pair<const char*, float>>>*
 ResultIterator::GetRawLSTMTimesteps() const {
   if (it_->word() != nullptr) {
+    it_->word()->ComputeLSTMChoices();
     return &it_->word()->raw_timesteps;
   } else {
     return nullptr;
@@ -616,6 +616,7 @@ ResultIterator::GetRawLSTMTimesteps() const {
 std::vector<std::vector<std::pair<const char*, float>>>*
   ResultIterator::GetBestLSTMSymbolChoices() const {
   if (it_->word() != nullptr) {
+    it_->word()->ComputeLSTMChoices();
     return &it_->word()->accumulated_timesteps;
   } else {
     return nullptr;
@@ -625,12 +626,30 @@ std::vector<std::vector<std::pair<const char*, float>>>*
 std::vector<std::vector<std::vector<std::pair<const char*, float>>>>*
   ResultIterator::GetSegmentedLSTMTimesteps() const {
   if (it_->word() != nullptr) {
+    it_->word()->ComputeLSTMChoices();
     return &it_->word()->symbol_steps;
   } else {
     return nullptr;
   }
 }
 
+const std::vector<LSTMLatticeNode>* ResultIterator::GetLSTMLattice() const {
+  if (it_->word() != nullptr) {
+    return it_->word()->lstm_lattice.get();
+  } else {
+    return nullptr;
+  }
+}
+
+const char* ResultIterator::GetLSTMUnichar(int unichar_id) const {
+  if (it_->word() != nullptr && it_->word()->uch_set != nullptr &&
+      it_->word()->uch_set->contains_unichar_id(unichar_id)) {
+    return it_->word()->uch_set->id_to_unichar_ext(unichar_id);
+  } else {
+    return nullptr;
+  }
+}
+
 void ResultIterator::AppendUTF8WordText(STRING *text) const {
   if (!it_->word()) return;
   ASSERT_HOST(it_->word()->best_choice != nullptr);
@@ -705,8 +724,7 @@ void ResultIterator::AppendUTF8ParagraphText(STRING *text) const {
 bool ResultIterator::BidiDebug(int min_level) const {
   int debug_level = 1;
   auto *p = ParamUtils::FindParam<IntParam>(
-      "bidi_debug", GlobalParams()->int_params,
-      tesseract_->params()->int_params);
+      "bidi_debug", GlobalParams(), tesseract_->params());
   if (p != nullptr) debug_level = (int32_t)(*p);
   return debug_level >= min_level;
 }
@@ -26,7 +26,7 @@
 #include <vector>               // for std::vector
 #include "ltrresultiterator.h"  // for LTRResultIterator
 #include "platform.h"           // for TESS_API, TESS_LOCAL
-#include "publictypes.h"        // for PageIteratorLevel
+#include "publictypes.h"        // for PageIteratorLevel, LSTMLatticeNode
 #include "unichar.h"            // for StrongScriptDirection
 
 template <typename T> class GenericVector;
@@ -107,6 +107,19 @@ class TESS_API ResultIterator : public LTRResultIterator {
   virtual std::vector<std::vector<std::vector<std::pair<const char*, float>>>>*
     GetSegmentedLSTMTimesteps() const;
 
+  /**
+   * Returns the lattice of the LSTM beam search of the text line of the
+   * current word, which is shared by all the words of the line, or nullptr
+   * if there is none. A lattice is only kept with lstm_lattice_size set.
+   * The nodes are in order of timestep and then decreasing score.
+  */
+  virtual const std::vector<LSTMLatticeNode>* GetLSTMLattice() const;
+  /**
+   * Returns the UTF-8 text of a unichar_id of the lattice of the current
+   * word. Do NOT delete [] the result.
+  */
+  virtual const char* GetLSTMUnichar(int unichar_id) const;
+
   /**
    * Return whether the current paragraph's dominant reading direction
    * is left-to-right (as opposed to right-to-left).
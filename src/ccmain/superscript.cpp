@@ -163,8 +163,10 @@ bool Tesseract::SubAndSuperscriptFix(WERD_RES *word) {
   // If nothing to do, bail now.
   if (num_leading + num_trailing +
       num_remainder_leading + num_remainder_trailing == 0) {
+    ++stats_.superscript_fixes_skipped;
     return false;
   }
+  ++stats_.superscript_fixes_tried;
 
   if (superscript_debug >= 1) {
     tprintf("Candidate for superscript detection: %s (",
@@ -25,6 +25,7 @@
 
 #include "basedir.h"
 #include "control.h"
+#include "initprofile.h"
 #  include "matchdefs.h"
 #include "pageres.h"
 #include "params.h"
@@ -115,32 +116,36 @@ bool Tesseract::init_tesseract_lang_data(
   }
 #endif  // ndef DISABLED_LEGACY_ENGINE
 
-  // If a language specific config file (lang.config) exists, load it in.
   TFile fp;
-  if (mgr->GetComponent(TESSDATA_LANG_CONFIG, &fp)) {
-    ParamUtils::ReadParamsFromFp(SET_PARAM_CONSTRAINT_NONE, &fp,
-                                 this->params());
-  }
+  {
+    InitPhase phase("config");
+    // If a language specific config file (lang.config) exists, load it in.
+    if (mgr->GetComponent(TESSDATA_LANG_CONFIG, &fp)) {
+      ParamUtils::ReadParamsFromFp(SET_PARAM_CONSTRAINT_NONE, &fp,
+                                   this->params());
+    }
 
-  SetParamConstraint set_params_constraint =
-      set_only_non_debug_params ? SET_PARAM_CONSTRAINT_NON_DEBUG_ONLY
-                                : SET_PARAM_CONSTRAINT_NONE;
-  // Load tesseract variables from config files. This is done after loading
-  // language-specific variables from [lang].traineddata file, so that custom
-  // config files can override values in [lang].traineddata file.
-  for (int i = 0; i < configs_size; ++i) {
-    read_config_file(configs[i], set_params_constraint);
-  }
+    SetParamConstraint set_params_constraint =
+        set_only_non_debug_params ? SET_PARAM_CONSTRAINT_NON_DEBUG_ONLY
+                                  : SET_PARAM_CONSTRAINT_NONE;
+    // Load tesseract variables from config files. This is done after loading
+    // language-specific variables from [lang].traineddata file, so that
+    // custom config files can override values in [lang].traineddata file.
+    for (int i = 0; i < configs_size; ++i) {
+      read_config_file(configs[i], set_params_constraint);
+    }
 
-  // Set params specified in vars_vec (done after setting params from config
-  // files, so that params in vars_vec can override those from files).
-  if (vars_vec != nullptr && vars_values != nullptr) {
-    for (int i = 0; i < vars_vec->size(); ++i) {
-      if (!ParamUtils::SetParam((*vars_vec)[i].string(),
-                                (*vars_values)[i].string(),
-                                set_params_constraint, this->params())) {
-        tprintf("Error setting param %s\n", (*vars_vec)[i].string());
-        exit(1);
+    // Set params specified in vars_vec (done after setting params from
+    // config files, so that params in vars_vec can override those from
+    // files).
+    if (vars_vec != nullptr && vars_values != nullptr) {
+      for (int i = 0; i < vars_vec->size(); ++i) {
+        if (!ParamUtils::SetParam((*vars_vec)[i].string(),
+                                  (*vars_values)[i].string(),
+                                  set_params_constraint, this->params())) {
+          tprintf("Error setting param %s\n", (*vars_vec)[i].string());
+          exit(1);
+        }
       }
     }
   }
@@ -176,9 +181,15 @@ bool Tesseract::init_tesseract_lang_data(
       tessedit_ocr_engine_mode == OEM_TESSERACT_LSTM_COMBINED) {
 #  endif  // ndef DISABLED_LEGACY_ENGINE
     if (mgr->IsComponentAvailable(TESSDATA_LSTM)) {
+      InitPhase phase("lstm");
+      // Any timing of the SIMD code has to happen before the weights are
+      // shaped for it.
+      LSTMRecognizer::TuneKernels(mgr);
       lstm_recognizer_ = new LSTMRecognizer;
-      ASSERT_HOST(lstm_recognizer_->Load(
-          this->params(), lstm_use_matrix ? language : nullptr, mgr));
+      // The network is shared with any other instance using the same model.
+      ASSERT_HOST(lstm_recognizer_->LoadShared(
+          this->params(), lstm_use_matrix ? language : nullptr, mgr,
+          lstm_use_float32, lstm_approx_softmax, lstm_network_replica));
     } else {
       tprintf("Error: LSTM requested, but not present!! Loading tesseract.\n");
       tessedit_ocr_engine_mode.set_value(OEM_TESSERACT_ONLY);
@@ -206,27 +217,36 @@ bool Tesseract::init_tesseract_lang_data(
   right_to_left_ = unicharset.major_right_to_left();
 
   // Setup initial unichar ambigs table and read universal ambigs.
-  UNICHARSET encoder_unicharset;
-  encoder_unicharset.CopyFrom(unicharset);
+  // Only the legacy engine uses the ambigs, so LSTM_ONLY leaves the table
+  // empty, and the ambigs component of the traineddata is never loaded.
   unichar_ambigs.InitUnicharAmbigs(unicharset, use_ambigs_for_adaption);
-  unichar_ambigs.LoadUniversal(encoder_unicharset, &unicharset);
-
-  if (!tessedit_ambigs_training && mgr->GetComponent(TESSDATA_AMBIGS, &fp)) {
-    unichar_ambigs.LoadUnicharAmbigs(encoder_unicharset, &fp,
-                                     ambigs_debug_level,
-                                     use_ambigs_for_adaption, &unicharset);
+  if (tessedit_ocr_engine_mode != OEM_LSTM_ONLY) {
+    InitPhase phase("ambigs");
+    UNICHARSET encoder_unicharset;
+    encoder_unicharset.CopyFrom(unicharset);
+    unichar_ambigs.LoadUniversal(encoder_unicharset, &unicharset);
+
+    if (!tessedit_ambigs_training && mgr->GetComponent(TESSDATA_AMBIGS, &fp)) {
+      unichar_ambigs.LoadUnicharAmbigs(encoder_unicharset, &fp,
+                                       ambigs_debug_level,
+                                       use_ambigs_for_adaption, &unicharset);
+    }
   }
 #ifndef DISABLED_LEGACY_ENGINE
-  // Init ParamsModel.
+  // Init ParamsModel, which only the legacy engine uses.
   // Load pass1 and pass2 weights (for now these two sets are the same, but in
   // the future separate sets of weights can be generated).
-  for (int p = ParamsModel::PTRAIN_PASS1; p < ParamsModel::PTRAIN_NUM_PASSES;
-       ++p) {
-    language_model_->getParamsModel().SetPass(
-        static_cast<ParamsModel::PassEnum>(p));
-    if (mgr->GetComponent(TESSDATA_PARAMS_MODEL, &fp)) {
-      if (!language_model_->getParamsModel().LoadFromFp(lang.string(), &fp)) {
-        return false;
+  if (tessedit_ocr_engine_mode != OEM_LSTM_ONLY) {
+    InitPhase phase("params model");
+    for (int p = ParamsModel::PTRAIN_PASS1; p < ParamsModel::PTRAIN_NUM_PASSES;
+         ++p) {
+      language_model_->getParamsModel().SetPass(
+          static_cast<ParamsModel::PassEnum>(p));
+      if (mgr->GetComponent(TESSDATA_PARAMS_MODEL, &fp)) {
+        if (!language_model_->getParamsModel().LoadFromFp(lang.string(),
+                                                          &fp)) {
+          return false;
+        }
       }
     }
   }
@@ -388,6 +408,8 @@ int Tesseract::init_tesseract_internal(const char* arg0, const char* textbase,
                                        const GenericVector<STRING>* vars_values,
                                        bool set_only_non_debug_params,
                                        TessdataManager* mgr) {
+  InitPhase phase(std::string("language ") +
+                  (language != nullptr ? language : "eng"));
   if (!init_tesseract_lang_data(arg0, textbase, language, oem, configs,
                                 configs_size, vars_vec, vars_values,
                                 set_only_non_debug_params, mgr)) {
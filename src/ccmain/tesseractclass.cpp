@@ -43,6 +43,7 @@
 #include "allheaders.h"
 #include "edgblob.h"
 #include "equationdetect.h"
+#include "trie.h"
 #ifndef ANDROID_BUILD
 #include "lstmrecognizer.h"
 #endif
@@ -89,6 +90,29 @@ Tesseract::Tesseract()
                     this->params()),
       BOOL_MEMBER(tessedit_ambigs_training, false,
                   "Perform training for ambiguities", this->params()),
+      INT_MEMBER(thresholding_method, 0,
+                 "Thresholding method: 0 = Otsu, 1 = adaptive Sauvola, "
+                 "2 = adaptive Niblack",
+                 this->params()),
+      double_MEMBER(thresholding_window_size, 0.33,
+                    "Window size of the adaptive thresholding methods, as a "
+                    "fraction of the image resolution",
+                    this->params()),
+      double_MEMBER(thresholding_kfactor, 0.34,
+                    "Weight of the local standard deviation in the adaptive "
+                    "thresholding methods",
+                    this->params()),
+      INT_MEMBER(image_memory_limit_mb, 0,
+                 "Approximate limit in MB of the memory for the images of a "
+                 "page, 0 for no limit. Color pages over it are reduced to "
+                 "grey, and pages that still don't fit are rejected",
+                 this->params()),
+      INT_MEMBER(tessedit_memory_budget_mb, 0,
+                 "Approximate memory in MB that recognizing a page should "
+                 "stay within, 0 for no budget. Pages too large for it are "
+                 "recognized from a reduced copy, and LSTM lines too wide for "
+                 "it are skipped",
+                 this->params()),
       INT_MEMBER(pageseg_devanagari_split_strategy,
                  tesseract::ShiroRekhaSplitter::NO_SPLIT,
                  "Whether to use the top-line splitting process for Devanagari "
@@ -131,6 +155,15 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(tessedit_timing_debug, false, "Print timing stats",
                   this->params()),
+      double_MEMBER(tessedit_early_finish_certainty, 0.0,
+                    "Words of pass 1 with at least this (negative) certainty"
+                    " skip pass 2, and a page of only such words skips all"
+                    " the later passes (0 = off)",
+                    this->params()),
+      BOOL_MEMBER(tessedit_stream_final_lines, false,
+                  "Skip the passes after pass 1 that could change the lines"
+                  " given to the line callback of the progress monitor",
+                  this->params()),
       BOOL_MEMBER(tessedit_fix_fuzzy_spaces, true,
                   "Try to improve fuzzy spaces", this->params()),
       BOOL_MEMBER(tessedit_unrej_any_wd, false,
@@ -181,6 +214,10 @@ Tesseract::Tesseract()
                  this->params()),
       INT_MEMBER(noise_maxperword, 16, "Max diacritics to apply to a word",
                  this->params()),
+      INT_MEMBER(noise_maxclassifications, 0,
+                 "Max blob classifications to spend on the diacritics of a"
+                 " word, 0 for no limit",
+                 this->params()),
       INT_MEMBER(debug_x_ht_level, 0, "Reestimate debug", this->params()),
       BOOL_MEMBER(debug_acceptable_wds, false, "Dump word pass/fail chk",
                   this->params()),
@@ -215,6 +252,15 @@ Tesseract::Tesseract()
       double_MEMBER(test_pt_y, 99999.99, "ycoord", this->params()),
       INT_MEMBER(multilang_debug_level, 0, "Print multilang debug info.",
                  this->params()),
+      INT_MEMBER(multilang_gate_words, 0,
+                 "Once this many words of a block in a row are best read by"
+                 " the same language, read the rest of the block with it"
+                 " alone (0 = off)",
+                 this->params()),
+      BOOL_MEMBER(multilang_parallel_retry, false,
+                  "Retry a word with all the other languages at once, on a"
+                  " thread each, if they are all LSTM only",
+                  this->params()),
       INT_MEMBER(paragraph_debug_level, 0, "Print paragraph debug info.",
                  this->params()),
       BOOL_MEMBER(paragraph_text_based, true,
@@ -223,6 +269,16 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(lstm_use_matrix, 1,
                   "Use ratings matrix/beam search with lstm", this->params()),
+      BOOL_MEMBER(lstm_use_float32, false,
+                  "Run float lstm models in single precision", this->params()),
+      BOOL_MEMBER(lstm_approx_softmax, false,
+                  "Compute only the likely lstm outputs of large models",
+                  this->params()),
+      INT_MEMBER(lstm_network_replica, -1,
+                 "Copy of the shared lstm network to use, so that engines on "
+                 "different NUMA nodes can each have one, -1 to share one "
+                 "copy",
+                 this->params()),
       STRING_MEMBER(outlines_odd, "%| ", "Non standard number of outlines",
                     this->params()),
       STRING_MEMBER(outlines_2, "ij!?%\":;", "Non standard number of outlines",
@@ -276,6 +332,9 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(hocr_char_boxes, false, "Add coordinates for each character to hocr output",
                   this->params()),
+      BOOL_MEMBER(tbr_choices, false,
+                  "Add the choices for each character to tbr output",
+                  this->params()),
       BOOL_MEMBER(crunch_early_merge_tess_fails, true, "Before word crunch?",
                   this->params()),
       BOOL_MEMBER(crunch_early_convert_bad_unlv_chs, false,
@@ -338,6 +397,10 @@ Tesseract::Tesseract()
                   "Reward punctuation joins", this->params()),
       INT_MEMBER(fixsp_done_mode, 1, "What constitues done for spacing",
                  this->params()),
+      INT_MEMBER(fixsp_max_perms, 0,
+                 "Max spacing permutations to recognize per run of fuzzy or"
+                 " noisy spaces, 0 for no limit",
+                 this->params()),
       INT_MEMBER(debug_fix_space_level, 0, "Contextual fixspace debug",
                  this->params()),
       STRING_MEMBER(numeric_punctuation, ".,",
@@ -347,6 +410,10 @@ Tesseract::Tesseract()
                  this->params()),
       INT_MEMBER(x_ht_min_change, 8,
                  "Min change in xht before actually trying it", this->params()),
+      BOOL_MEMBER(x_ht_precheck, true,
+                  "Don't re-recognize with a new xht unless it would fit the"
+                  " current characters better",
+                  this->params()),
       INT_MEMBER(superscript_debug, 0,
                  "Debug level for sub & superscript fixer", this->params()),
       double_MEMBER(
@@ -394,6 +461,8 @@ Tesseract::Tesseract()
                   this->params()),
       BOOL_MEMBER(tessedit_create_tsv, false, "Write .tsv output file",
                   this->params()),
+      BOOL_MEMBER(tessedit_create_tbr, false,
+                  "Write .tbr binary result output file", this->params()),
       BOOL_MEMBER(tessedit_create_wordstrbox, false, "Write WordStr format .box output file",
                   this->params()),
       BOOL_MEMBER(tessedit_create_pdf, false, "Write .pdf output file",
@@ -402,11 +471,27 @@ Tesseract::Tesseract()
                   "Create PDF with only one invisible text layer",
                   this->params()),
       INT_MEMBER(jpg_quality, 85, "Set JPEG quality level", this->params()),
+      BOOL_MEMBER(pdf_background_images, true,
+                  "Encode the images of PDF pages while the next page is"
+                  " recognized",
+                  this->params()),
+      INT_MEMBER(renderer_threads, 1,
+                 "Max number of output renderers writing a page "
+                 "concurrently, 1 for one at a time",
+                 this->params()),
       INT_MEMBER(user_defined_dpi, 0, "Specify DPI for input image",
                  this->params()),
       INT_MEMBER(min_characters_to_try, 50,
                  "Specify minimum characters to try during OSD",
                  this->params()),
+      BOOL_MEMBER(osd_fast, false,
+                  "Fast OSD: find the blobs on a binary image reduced to "
+                  "about 150 dpi, classify at most osd_fast_max_blobs of "
+                  "them, and stop once the orientation margin reaches "
+                  "min_orientation_margin",
+                  this->params()),
+      INT_MEMBER(osd_fast_max_blobs, 100, "Max blobs to classify in fast OSD",
+                 this->params()),
       STRING_MEMBER(unrecognised_char, "|",
                     "Output char for unidentified blobs", this->params()),
       INT_MEMBER(suspect_level, 99, "Suspect marker level", this->params()),
@@ -472,6 +557,18 @@ Tesseract::Tesseract()
                  "-1 -> All pages"
                  " , else specific page to process",
                  this->params()),
+      INT_MEMBER(tessedit_page_count, 1,
+                 "Number of pages to process from tessedit_page_number on, 0"
+                 " for all the rest",
+                 this->params()),
+      INT_MEMBER(page_prefetch_depth, 2,
+                 "Max pages of a document to read ahead on another thread"
+                 " while recognizing, 0 to read each page when it is needed",
+                 this->params()),
+      INT_MEMBER(page_parallel_jobs, 1,
+                 "Number of engines recognizing the pages of a document at"
+                 " once, 1 for one page at a time",
+                 this->params()),
       BOOL_MEMBER(tessedit_write_images, false,
                   "Capture the image from the IPE", this->params()),
       BOOL_MEMBER(interactive_display_mode, false, "Run interactively?",
@@ -514,8 +611,96 @@ Tesseract::Tesseract()
           textord_tabfind_aligned_gap_fraction, 0.75,
           "Fraction of height used as a minimum gap for aligned blobs.",
           this->params()),
+      BOOL_MEMBER(textord_fast_auto_layout, false,
+                  "In automatic page segmentation without OSD, segment pages "
+                  "that look like a single column of text as a single block, "
+                  "skipping line, image, tab-stop, table and equation "
+                  "analysis",
+                  this->params()),
+      BOOL_MEMBER(textord_blank_page_reject, false,
+                  "Give an empty result, without layout analysis, for pages "
+                  "with little ink and no more than "
+                  "textord_blank_page_max_blobs text-sized components",
+                  this->params()),
+      double_MEMBER(textord_blank_page_max_ink, 0.002,
+                    "Max fraction of the pixels of a page that are ink for it "
+                    "to be taken as blank",
+                    this->params()),
+      INT_MEMBER(textord_blank_page_max_blobs, 0,
+                 "Max number of text-sized components of a page for it to be "
+                 "taken as blank",
+                 this->params()),
+      BOOL_MEMBER(tessedit_auto_downscale, false,
+                  "Threshold, analyse the layout and recognize greyscale and "
+                  "color images with large text at a reduced size",
+                  this->params()),
+      INT_MEMBER(tessedit_downscale_text_height, 20,
+                 "Min median height in pixels of the text components of an "
+                 "image reduced by tessedit_auto_downscale",
+                 this->params()),
       INT_MEMBER(tessedit_parallelize, 0, "Run in parallel where possible",
                  this->params()),
+      INT_MEMBER(tessedit_num_threads, 0,
+                 "Number of threads for internal parallel operations, 0 for "
+                 "the built-in defaults, 1 for no internal threading",
+                 this->params()),
+      INT_MEMBER(lstm_batch_size, 1,
+                 "Max number of text lines to run through the LSTM network "
+                 "together, 1 for one line at a time",
+                 this->params()),
+      INT_MEMBER(lstm_line_threads, 1,
+                 "Max number of threads recognizing LSTM text lines "
+                 "concurrently, 1 for one at a time",
+                 this->params()),
+      double_MEMBER(lstm_max_blank_gap, 0.0,
+                    "Max width of blank gaps in text lines, as a multiple of "
+                    "the line height, to run through the LSTM, 0 to keep all "
+                    "gaps",
+                    this->params()),
+      BOOL_MEMBER(lstm_greedy_decode, false,
+                  "Decode LSTM lines with the best path instead of the beam "
+                  "search, when there is no dictionary and lstm_choice_mode "
+                  "is 0",
+                  this->params()),
+      double_MEMBER(lstm_beam_collapse_margin, 0.0,
+                    "Min margin between the best two LSTM outputs of a "
+                    "timestep at which the beam search keeps only its best "
+                    "paths, 0 to keep the full beam",
+                    this->params()),
+      BOOL_MEMBER(lstm_pipeline_decode, false,
+                  "Decode batches of LSTM lines on a thread of their own, "
+                  "while the others run the network on the next batches",
+                  this->params()),
+      INT_MEMBER(lstm_lattice_size, 0,
+                 "Number of nodes of each timestep of the LSTM beam search to "
+                 "keep in the lattice of the words, 0 to keep no lattice",
+                 this->params()),
+      BOOL_MEMBER(lstm_polarity_check, false,
+                  "Judge from its grey levels whether each text line is "
+                  "inverted, and only run the LSTM again on an inverted copy "
+                  "of the lines that it can't tell",
+                  this->params()),
+      INT_MEMBER(lstm_max_line_timesteps, 20000,
+                 "Max width of a text line in timesteps of the LSTM network, "
+                 "beyond which the line is not recognized, 0 for no limit",
+                 this->params()),
+      INT_MEMBER(lstm_output_cache_size, 0,
+                 "Number of LSTM word images whose network outputs are kept, "
+                 "by a hash of their pixels, to decode again when the same "
+                 "pixels are recognized again on any page, 0 to keep none",
+                 this->params()),
+      INT_MEMBER(lstm_chunk_timesteps, 0,
+                 "Width in timesteps of the LSTM network over which a line is "
+                 "split at low-ink gaps into chunks recognized separately, 0 "
+                 "to recognize every line whole",
+                 this->params()),
+      BOOL_MEMBER(lstm_indexed_lstmf, false,
+                  "Write lstmf training files in the indexed format, whose "
+                  "lines can be read without reading the whole file",
+                  this->params()),
+      BOOL_MEMBER(lstm_compress_lstmf, false,
+                  "Compress the lines of indexed lstmf training files",
+                  this->params()),
       BOOL_MEMBER(preserve_interword_spaces, false,
                   "Preserve multiple interword spaces", this->params()),
       STRING_MEMBER(page_separator, "\f",
@@ -537,6 +722,9 @@ Tesseract::Tesseract()
       pix_original_(nullptr),
       pix_thresholds_(nullptr),
       source_resolution_(0),
+      image_reduction_(1),
+      budget_reduction_(1),
+      blank_page_reason_(nullptr),
       textord_(this),
       right_to_left_(false),
       scaled_color_(nullptr),
@@ -545,6 +733,7 @@ Tesseract::Tesseract()
       reskew_(1.0f, 0.0f),
       most_recently_used_(this),
       font_table_size_(0),
+      noise_classifications_left_(0),
       equ_detect_(nullptr),
 #ifndef ANDROID_BUILD
       lstm_recognizer_(nullptr),
@@ -553,6 +742,7 @@ Tesseract::Tesseract()
 }
 
 Tesseract::~Tesseract() {
+  DetachExtraWordsInternal();
   Clear();
   pixDestroy(&pix_original_);
   end_tesseract();
@@ -579,6 +769,7 @@ Dict& Tesseract::getDict()
 void Tesseract::Clear() {
   STRING debug_name = imagebasename + "_debug.pdf";
   pixa_debug_.WritePDF(debug_name.string());
+  binary_pyramid_.Reset(nullptr);
   pixDestroy(&pix_binary_);
   pixDestroy(&pix_grey_);
   pixDestroy(&pix_thresholds_);
@@ -587,10 +778,44 @@ void Tesseract::Clear() {
   reskew_ = FCOORD(1.0f, 0.0f);
   splitter_.Clear();
   scaled_factor_ = -1;
+  image_reduction_ = 1;
+  budget_reduction_ = 1;
+  blank_page_reason_ = nullptr;
+  if (lstm_recognizer_ != nullptr) lstm_recognizer_->ResetNumWideLines();
   for (int i = 0; i < sub_langs_.size(); ++i)
     sub_langs_[i]->Clear();
 }
 
+void Tesseract::AddMemoryUsage(MemoryUsage* usage,
+                               std::vector<const void*>* image_data) {
+#ifndef ANDROID_BUILD
+  if (lstm_recognizer_ != nullptr) lstm_recognizer_->AddMemoryUsage(usage);
+#endif
+  // Not getDict(), which may be that of the LSTM recognizer.
+  Classify::getDict().AddMemoryUsage(usage);
+  usage->Add(MEMORY_ADAPTIVE_TEMPLATES, TemplatesMemoryBytes());
+  for (Pix* pix : {pix_original_, pix_grey_, pix_binary_, pix_thresholds_,
+                   scaled_color_}) {
+    AddImageMemoryUsage(pix, image_data, usage);
+  }
+  for (int i = 0; i < sub_langs_.size(); ++i)
+    sub_langs_[i]->AddMemoryUsage(usage, image_data);
+}
+
+void Tesseract::AddImageMemoryUsage(Pix* pix,
+                                    std::vector<const void*>* image_data,
+                                    MemoryUsage* usage) {
+  if (pix == nullptr) return;
+  const void* data = pixGetData(pix);
+  if (std::find(image_data->begin(), image_data->end(), data) !=
+      image_data->end()) {
+    return;
+  }
+  image_data->push_back(data);
+  usage->Add(MEMORY_IMAGES, static_cast<int64_t>(pixGetWpl(pix)) *
+                                pixGetHeight(pix) * sizeof(l_uint32));
+}
+
 #ifndef DISABLED_LEGACY_ENGINE
 
 void Tesseract::SetEquationDetect(EquationDetect* detector) {
@@ -598,6 +823,16 @@ void Tesseract::SetEquationDetect(EquationDetect* detector) {
   equ_detect_->SetLangTesseract(this);
 }
 
+void Tesseract::SetMonitor(const ETEXT_DESC* monitor) {
+  set_monitor(monitor);
+  if (lstm_recognizer_ != nullptr) lstm_recognizer_->SetMonitor(monitor);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->set_monitor(monitor);
+    if (sub_langs_[i]->lstm_recognizer_ != nullptr)
+      sub_langs_[i]->lstm_recognizer_->SetMonitor(monitor);
+  }
+}
+
 // Clear all memory of adaption for this and all subclassifiers.
 void Tesseract::ResetAdaptiveClassifier() {
   ResetAdaptiveClassifierInternal();
@@ -606,6 +841,30 @@ void Tesseract::ResetAdaptiveClassifier() {
   }
 }
 
+// Saves the adapted templates of this and all subclassifiers.
+bool Tesseract::SaveAdaptiveClassifier(const char* filename) {
+  bool success = SaveAdaptedTemplates(filename);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    STRING sub_filename = filename;
+    sub_filename += '.';
+    sub_filename += sub_langs_[i]->lang;
+    success &= sub_langs_[i]->SaveAdaptedTemplates(sub_filename.string());
+  }
+  return success;
+}
+
+// Loads the adapted templates of this and all subclassifiers.
+bool Tesseract::LoadAdaptiveClassifier(const char* filename) {
+  bool success = LoadAdaptedTemplates(filename);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    STRING sub_filename = filename;
+    sub_filename += '.';
+    sub_filename += sub_langs_[i]->lang;
+    success &= sub_langs_[i]->LoadAdaptedTemplates(sub_filename.string());
+  }
+  return success;
+}
+
 #endif  //ndef DISABLED_LEGACY_ENGINE
 
 // Clear the document dictionary for this and all subclassifiers.
@@ -616,6 +875,75 @@ void Tesseract::ResetDocumentDictionary() {
   }
 }
 
+// Clears the per-page word caches of the dictionaries of this and all
+// subclassifiers.
+void Tesseract::ClearDictWordCaches() {
+  for (int i = 0; i <= sub_langs_.size(); ++i) {
+    Tesseract* lang_tess = i < sub_langs_.size() ? sub_langs_[i] : this;
+    lang_tess->Classify::getDict().ClearWordCache();
+#ifndef ANDROID_BUILD
+    if (lang_tess->lstm_recognizer_ != nullptr &&
+        lang_tess->lstm_recognizer_->GetDict() != nullptr) {
+      lang_tess->lstm_recognizer_->GetDict()->ClearWordCache();
+    }
+#endif
+  }
+}
+
+// Attaches a user dawg of the given words to the legacy and LSTM dictionaries
+// of this and all the sub_langs_, replacing any previous ones.
+bool Tesseract::AttachExtraWords(const GenericVector<STRING>& words) {
+  DetachExtraWords();
+  bool attached = AttachExtraWordsInternal(words);
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    if (sub_langs_[i]->AttachExtraWordsInternal(words)) attached = true;
+  }
+  return attached;
+}
+
+// Detaches and deletes the dawgs of AttachExtraWords.
+void Tesseract::DetachExtraWords() {
+  DetachExtraWordsInternal();
+  for (int i = 0; i < sub_langs_.size(); ++i) {
+    sub_langs_[i]->DetachExtraWordsInternal();
+  }
+}
+
+// As AttachExtraWords, but just for this.
+bool Tesseract::AttachExtraWordsInternal(const GenericVector<STRING>& words) {
+  GenericVector<Dict*> dicts;
+  dicts.push_back(&Classify::getDict());
+#ifndef ANDROID_BUILD
+  if (lstm_recognizer_ != nullptr) dicts.push_back(lstm_recognizer_->GetDict());
+#endif
+  for (int i = 0; i < dicts.size(); ++i) {
+    Dict* dict = dicts[i];
+    if (dict == nullptr || dict->NumDawgs() == 0) continue;
+    auto* trie = new Trie(DAWG_TYPE_WORD, lang, USER_DAWG_PERM,
+                          dict->getUnicharset().size(),
+                          dict->dawg_debug_level);
+    if (!trie->add_word_list(words, dict->getUnicharset(),
+                             Trie::RRP_REVERSE_IF_HAS_RTL) ||
+        !dict->AttachDawg(trie)) {
+      delete trie;
+      continue;
+    }
+    extra_dawgs_.push_back(trie);
+    extra_dicts_.push_back(dict);
+  }
+  return !extra_dawgs_.empty();
+}
+
+// As DetachExtraWords, but just for this.
+void Tesseract::DetachExtraWordsInternal() {
+  for (int i = 0; i < extra_dawgs_.size(); ++i) {
+    extra_dicts_[i]->DetachDawg(extra_dawgs_[i]);
+  }
+  extra_dawgs_.delete_data_pointers();
+  extra_dawgs_.clear();
+  extra_dicts_.clear();
+}
+
 void Tesseract::SetBlackAndWhitelist() {
   // Set the white and blacklists (if any)
   unicharset.set_black_and_whitelist(tessedit_char_blacklist.string(),
@@ -645,6 +973,8 @@ void Tesseract::SetBlackAndWhitelist() {
 // page segmentation.
 void Tesseract::PrepareForPageseg() {
   textord_.set_use_cjk_fp_model(textord_use_cjk_fp_model);
+  textord_.set_num_threads(tessedit_num_threads);
+  textord_.set_compute_edge_offsets(NeedEdgeOffsets());
   // Find the max splitter strategy over all langs.
   auto max_pageseg_strategy =
       static_cast<ShiroRekhaSplitter::SplitStrategy>(
@@ -704,7 +1034,7 @@ void Tesseract::PrepareForTessOCR(BLOCK_LIST* block_list,
                 pixGetHeight(pix_binary_));
     Pix* pix_for_ocr = split_for_ocr ? splitter_.splitted_image() :
         splitter_.orig_pix();
-    extract_edges(pix_for_ocr, &block);
+    extract_edges(pix_for_ocr, &block, textord_.edge_params());
     splitter_.RefreshSegmentationWithNewBlobs(block.blob_list());
   }
   // The splitter isn't needed any more after this, so save memory by clearing.
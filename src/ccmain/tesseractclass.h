@@ -27,6 +27,8 @@
 
 #include <cstdint>                  // for int16_t, int32_t, uint16_t
 #include <cstdio>                   // for FILE
+#include <map>                      // for std::map
+#include <vector>                   // for std::vector
 #include "allheaders.h"             // for pixDestroy, pixGetWidth, pixGetHe...
 #include "control.h"                // for ACCEPTABLE_WERD_TYPE
 #include "debugpixa.h"              // for DebugPixa
@@ -35,6 +37,8 @@
 #include "docqual.h"                // for GARBAGE_LEVEL
 #endif
 #include "genericvector.h"          // for GenericVector, PointerVector
+#include "imagepyramid.h"           // for ImagePyramid
+#include "memoryusage.h"            // for MemoryUsage
 #include "pageres.h"                // for WERD_RES (ptr only), PAGE_RES (pt...
 #include "params.h"                 // for BOOL_VAR_H, BoolParam, DoubleParam
 #include "points.h"                 // for FCOORD
@@ -121,6 +125,10 @@ struct TesseractStats {
         doc_good_char_quality(0),
         word_count(0),
         dict_words(0),
+        x_ht_fixes_tried(0),
+        x_ht_fixes_skipped(0),
+        superscript_fixes_tried(0),
+        superscript_fixes_skipped(0),
         tilde_crunch_written(false),
         last_char_was_newline(true),
         last_char_was_tilde(false),
@@ -134,6 +142,12 @@ struct TesseractStats {
   int16_t doc_good_char_quality;
   int32_t word_count;     // count of word in the document
   int32_t dict_words;     // number of dicitionary words in the document
+  // Words whose x-height/baseline or sub/superscript fix re-ran recognition,
+  // and words that reached the fix but were skipped by its cheap checks.
+  int32_t x_ht_fixes_tried;
+  int32_t x_ht_fixes_skipped;
+  int32_t superscript_fixes_tried;
+  int32_t superscript_fixes_skipped;
   STRING dump_words_str;  // accumulator used by dump_words()
   // Flags used by write_results()
   bool tilde_crunch_written;
@@ -182,26 +196,57 @@ class Tesseract : public Wordrec {
   // Clear as much used memory as possible without resetting the adaptive
   // classifier or losing any other classifier data.
   void Clear();
+  // Adds the bytes held by this and the sub-languages to usage: the LSTM
+  // recognizers, the dictionaries, the classifier templates and the images
+  // of the page. image_data holds the data of the images already added, so
+  // that clones, which share their data, are added once.
+  void AddMemoryUsage(MemoryUsage* usage,
+                      std::vector<const void*>* image_data);
+  // Adds the bytes of the data of pix, if any, to usage, unless its data is
+  // in image_data, and then puts it there.
+  static void AddImageMemoryUsage(Pix* pix,
+                                  std::vector<const void*>* image_data,
+                                  MemoryUsage* usage);
   // Clear all memory of adaption for this and all subclassifiers.
   void ResetAdaptiveClassifier();
+  // Saves the adapted templates of this and all subclassifiers, the latter
+  // to filename.<lang>. Returns false on error.
+  bool SaveAdaptiveClassifier(const char* filename);
+  // Loads adapted templates saved by SaveAdaptiveClassifier into this and
+  // all subclassifiers. Returns false on error.
+  bool LoadAdaptiveClassifier(const char* filename);
   // Clear the document dictionary for this and all subclassifiers.
   void ResetDocumentDictionary();
+  // Clears the per-page word caches of the dictionaries of this and all
+  // subclassifiers.
+  void ClearDictWordCaches();
 
   // Set the equation detector.
   void SetEquationDetect(EquationDetect* detector);
 
+  // Gives the monitor of a recognition to the layout analysis, the chopper,
+  // the segmentation search and the LSTM recognizers of this and all the
+  // sub languages, so that they stop at its deadline or when it cancels.
+  // nullptr for none.
+  void SetMonitor(const ETEXT_DESC* monitor);
+
   // Simple accessors.
   const FCOORD& reskew() const {
     return reskew_;
   }
   // Destroy any existing pix and return a pointer to the pointer.
   Pix** mutable_pix_binary() {
+    binary_pyramid_.Reset(nullptr);
     pixDestroy(&pix_binary_);
     return &pix_binary_;
   }
   Pix* pix_binary() const {
     return pix_binary_;
   }
+  // Reductions of pix_binary_ shared by the layout stages.
+  ImagePyramid* binary_pyramid() {
+    return &binary_pyramid_;
+  }
   Pix* pix_grey() const {
     return pix_grey_;
   }
@@ -239,6 +284,9 @@ class Tesseract : public Wordrec {
       return pix_binary_;
     }
   }
+  Pix* pix_thresholds() const {
+    return pix_thresholds_;
+  }
   void set_pix_thresholds(Pix* thresholds) {
     pixDestroy(&pix_thresholds_);
     pix_thresholds_ = thresholds;
@@ -249,6 +297,27 @@ class Tesseract : public Wordrec {
   void set_source_resolution(int ppi) {
     source_resolution_ = ppi;
   }
+  // Returns the factor by which the images of the page, and so the internal
+  // coordinates, are reduced from the input image.
+  int image_reduction() const {
+    return image_reduction_;
+  }
+  void set_image_reduction(int reduction) {
+    image_reduction_ = reduction;
+  }
+  // Returns the factor by which the page was reduced to fit the memory
+  // budget, beyond any tessedit_auto_downscale reduction, or 1 if it was not.
+  int budget_reduction() const {
+    return budget_reduction_;
+  }
+  void set_budget_reduction(int reduction) {
+    budget_reduction_ = reduction;
+  }
+  // Returns why the last SegmentPage took the page as blank, such as
+  // "no ink", or nullptr if it did not.
+  const char* blank_page_reason() const {
+    return blank_page_reason_;
+  }
   int ImageWidth() const {
     return pixGetWidth(pix_binary_);
   }
@@ -265,6 +334,9 @@ class Tesseract : public Wordrec {
     scaled_factor_ = factor;
     scaled_color_ = color;
   }
+  const TesseractStats& stats() const {
+    return stats_;
+  }
   const Textord& textord() const {
     return textord_;
   }
@@ -302,8 +374,21 @@ class Tesseract : public Wordrec {
     }
     return false;
   }
+  // Returns true if layout analysis must compute the sub-pixel edge offsets
+  // of the blob outlines, as only the features of the legacy classifier,
+  // used by Tesseract languages and equation detection, need them.
+  bool NeedEdgeOffsets() const {
+    return AnyTessLang() || equ_detect_ != nullptr;
+  }
 
   void SetBlackAndWhitelist();
+  // Attaches a user dawg of the given words to the legacy and LSTM
+  // dictionaries of this and all the sub_langs_, replacing any previous ones,
+  // without reloading the loaded dawgs. Returns false if there was no
+  // dictionary to attach to.
+  bool AttachExtraWords(const GenericVector<STRING>& words);
+  // Detaches and deletes the dawgs of AttachExtraWords.
+  void DetachExtraWords();
 
   // Perform steps to prepare underlying binary image/other data structures for
   // page segmentation. Uses the strategy specified in the global variable
@@ -358,12 +443,49 @@ class Tesseract : public Wordrec {
   // is set in the returned ImageData if the text was originally vertical, which
   // can be used to invoke a different CJK recognition engine. The revised_box
   // is also returned to enable calculation of output bounding boxes.
+  // If keep_decoded, the image is kept in the ImageData without encoding it,
+  // for images that are only to be recognized.
   ImageData* GetRectImage(const TBOX& box, const BLOCK& block, int padding,
-                          TBOX* revised_box) const;
+                          TBOX* revised_box, bool keep_decoded = false) const;
+  // Returns the image to be given to the LSTM recognizer for the given word or
+  // group of words, setting *word_box to the box it covers, or nullptr if
+  // there is nothing to recognize.
+  ImageData* GetLSTMWordImage(const BLOCK& block, ROW* row, WERD_RES* word,
+                              TBOX* word_box) const;
+  // As GetLSTMWordImage, but if the image is wider than lstm_chunk_timesteps,
+  // and not rotated, splits it at low-ink gaps into chunks, appending the
+  // images and boxes of the chunks to images and boxes. spaced[i] is set to
+  // whether chunk i starts after a space.
+  void GetLSTMWordChunks(const BLOCK& block, ROW* row, WERD_RES* word,
+                         std::vector<ImageData*>* images,
+                         std::vector<TBOX>* boxes,
+                         std::vector<bool>* spaced) const;
+  // Splits box, of the binary image, into chunks of at most about max_width,
+  // at the widest blank gaps, or the columns with the least ink where there
+  // are none, as for GetLSTMWordChunks.
+  void SplitWideLineBox(const TBOX& box, int max_width,
+                        std::vector<TBOX>* chunks,
+                        std::vector<bool>* spaced) const;
   // Recognizes a word or group of words, converting to WERD_RES in *words.
   // Analogous to classify_word_pass1, but can handle a group of words as well.
   void LSTMRecognizeWord(const BLOCK& block, ROW* row, WERD_RES* word,
                          PointerVector<WERD_RES>* words);
+  // Runs the LSTM recognizer on all the words in batches of lstm_batch_size
+  // lines on lstm_line_threads threads, keeping the results for
+  // LSTMRecognizeWord to pick up.
+  void PrerecAllLinesLSTM(const GenericVector<WordData>& words);
+  // Recognizes each of the pixes as a single text line, without any layout
+  // analysis, in batches as PrerecAllLinesLSTM, leaving the words of pixes[i]
+  // in (*words)[i], with their boxes in the coordinates of pixes[i].
+  // Returns false if not running the LSTM engine alone, of a single language.
+  bool RecognizeLinesLSTM(const std::vector<Pix*>& pixes,
+                          std::vector<PointerVector<WERD_RES>>* words);
+  // Returns lstm_max_line_timesteps, or fewer if the lines recognized at once
+  // would not fit in their share of tessedit_memory_budget_mb otherwise.
+  int LSTMMaxLineTimesteps() const;
+  // Returns the number of lines that the LSTM recognizers of this and the
+  // sub languages refused as too wide since Clear.
+  int NumWideLines() const;
   // Apply segmentation search to the given set of words, within the constraints
   // of the existing ratings matrix. If there is already a best_choice on a word
   // leaves it untouched and just sets the done/accepted etc flags.
@@ -381,13 +503,20 @@ class Tesseract : public Wordrec {
   // Runs word recognition on all the words.
   bool RecogAllWordsPassN(int pass_n, ETEXT_DESC* monitor, PAGE_RES_IT* pr_it,
                           GenericVector<WordData>* words);
+  // Returns true if the lines given to the line_callback of the monitor are
+  // final, so nothing after pass 1 may change them.
+  bool StreamsFinalLines(const ETEXT_DESC* monitor) const;
+  // Gives the recognized words of row_res to the line_callback of the
+  // monitor.
+  void StreamLine(ETEXT_DESC* monitor, const BLOCK* block, ROW_RES* row_res);
   bool recog_all_words(PAGE_RES* page_res, ETEXT_DESC* monitor,
                        const TBOX* target_word_box, const char* word_config,
                        int dopasses);
   void rejection_passes(PAGE_RES* page_res, ETEXT_DESC* monitor,
                         const TBOX* target_word_box, const char* word_config);
-  void bigram_correction_pass(PAGE_RES* page_res);
-  void blamer_pass(PAGE_RES* page_res);
+  void bigram_correction_pass(const GenericVector<PAGE_RES_WORD>& words);
+  void blamer_pass(PAGE_RES* page_res,
+                   const GenericVector<PAGE_RES_WORD>& words);
   // Sets script positions and detects smallcaps on all output words.
   void script_pos_pass(PAGE_RES* page_res);
   // Helper to recognize the word using the given (language-specific) tesseract.
@@ -396,6 +525,24 @@ class Tesseract : public Wordrec {
   int RetryWithLanguage(const WordData& word_data, WordRecognizer recognizer,
                         bool debug, WERD_RES** in_word,
                         PointerVector<WERD_RES>* best_words);
+  // The two halves of RetryWithLanguage: recognizes the word into new_words,
+  // which may be done for several languages at once, then keeps the best of
+  // new_words and best_words in best_words.
+  void RecognizeWithLanguage(const WordData& word_data,
+                             WordRecognizer recognizer, bool debug,
+                             WERD_RES** in_word,
+                             PointerVector<WERD_RES>* new_words);
+  int SelectWithLanguage(bool debug, PointerVector<WERD_RES>* new_words,
+                         PointerVector<WERD_RES>* best_words);
+  // Retries the word with the languages of others, which are all LSTM only,
+  // each on its own thread, and selects the results in order, as if they
+  // were retried one after another. Returns the language of the best words,
+  // or nullptr if no language improved on best_words.
+  Tesseract* RetryWithLanguagesInParallel(
+      const WordData& word_data, WordRecognizer recognizer, bool debug,
+      const std::vector<Tesseract*>& others,
+      const std::vector<WERD_RES**>& in_words,
+      PointerVector<WERD_RES>* best_words);
   // Moves good-looking "noise"/diacritics from the reject list to the main
   // blob list on the current word. Returns true if anything was done, and
   // sets make_next_word_fuzzy if blob(s) were added to the end of the word.
@@ -435,14 +582,17 @@ class Tesseract : public Wordrec {
   // best raw choice, and undoing all the work done to fake out the word.
   float ClassifyBlobAsWord(int pass_n, PAGE_RES_IT* pr_it, C_BLOB* blob,
                            STRING* best_str, float* c2);
+  // Recognizes the word with the most recently used language, then, unless
+  // retry_langs is false, with the other languages if it isn't acceptable.
   void classify_word_and_language(int pass_n, PAGE_RES_IT* pr_it,
-                                  WordData* word_data);
+                                  WordData* word_data,
+                                  bool retry_langs = true);
   void classify_word_pass1(const WordData& word_data, WERD_RES** in_word,
                            PointerVector<WERD_RES>* out_words);
   void recog_pseudo_word(PAGE_RES* page_res,  // blocks to check
                          TBOX& selection_box);
 
-  void fix_rep_char(PAGE_RES_IT* page_res_it);
+  void fix_rep_char(WERD_RES* word_res);
 
   ACCEPTABLE_WERD_TYPE acceptable_word_string(const UNICHARSET& char_set,
                                               const char* s,
@@ -463,8 +613,8 @@ class Tesseract : public Wordrec {
 
   // Set fonts of this word.
   void set_word_fonts(WERD_RES* word);
-  void font_recognition_pass(PAGE_RES* page_res);
-  void dictionary_correction_pass(PAGE_RES* page_res);
+  void font_recognition_pass(const GenericVector<PAGE_RES_WORD>& words);
+  void dictionary_correction_pass(const GenericVector<PAGE_RES_WORD>& words);
   bool check_debug_pt(WERD_RES* word, int location);
 
   //// superscript.cpp ////////////////////////////////////////////////////
@@ -643,9 +793,13 @@ class Tesseract : public Wordrec {
   void tilde_crunch(PAGE_RES_IT& page_res_it);
   void unrej_good_quality_words(  // unreject potential
       PAGE_RES_IT& page_res_it);
+  // blob_qualities holds the word_blob_quality of each word of the page, in
+  // PAGE_RES_IT order, as gathered by rejection_passes.
   void doc_and_block_rejection(  // reject big chunks
-      PAGE_RES_IT& page_res_it, bool good_quality_doc);
-  void quality_based_rejection(PAGE_RES_IT& page_res_it, bool good_quality_doc);
+      PAGE_RES_IT& page_res_it, bool good_quality_doc,
+      const GenericVector<int16_t>& blob_qualities);
+  void quality_based_rejection(PAGE_RES_IT& page_res_it, bool good_quality_doc,
+                               const GenericVector<int16_t>& blob_qualities);
   void convert_bad_unlv_chs(WERD_RES* word_res);
   void tilde_delete(PAGE_RES_IT& page_res_it);
   int16_t word_blob_quality(WERD_RES* word, ROW* row);
@@ -773,6 +927,11 @@ class Tesseract : public Wordrec {
   //// fixxht.cpp ///////////////////////////////////////////////////////
   // Returns the number of misfit blob tops in this word.
   int CountMisfitTops(WERD_RES* word_res);
+  // Returns the number of misfit blob tops this word would have if it were
+  // normalized with the given baseline shift and x-height and recognized as
+  // the same characters, without running any recognition.
+  int PredictMisfitTops(WERD_RES* word_res, float baseline_shift,
+                        float new_x_ht);
   // Returns a new x-height in pixels (original image coords) that is
   // maximally compatible with the result in word_res.
   // Returns 0.0f if no x-height is found that is better than the current
@@ -806,6 +965,23 @@ class Tesseract : public Wordrec {
                "List of chars to override tessedit_char_blacklist");
   BOOL_VAR_H(tessedit_ambigs_training, false,
              "Perform training for ambiguities");
+  INT_VAR_H(thresholding_method, 0,
+            "Thresholding method: 0 = Otsu, 1 = adaptive Sauvola, "
+            "2 = adaptive Niblack");
+  double_VAR_H(thresholding_window_size, 0.33,
+               "Window size of the adaptive thresholding methods, as a "
+               "fraction of the image resolution");
+  double_VAR_H(thresholding_kfactor, 0.34,
+               "Weight of the local standard deviation in the adaptive "
+               "thresholding methods");
+  INT_VAR_H(image_memory_limit_mb, 0,
+            "Approximate limit in MB of the memory for the images of a page, "
+            "0 for no limit. Color pages over it are reduced to grey, and "
+            "pages that still don't fit are rejected");
+  INT_VAR_H(tessedit_memory_budget_mb, 0,
+            "Approximate memory in MB that recognizing a page should stay "
+            "within, 0 for no budget. Pages too large for it are recognized "
+            "from a reduced copy, and LSTM lines too wide for it are skipped");
   INT_VAR_H(pageseg_devanagari_split_strategy,
             tesseract::ShiroRekhaSplitter::NO_SPLIT,
             "Whether to use the top-line splitting process for Devanagari "
@@ -835,6 +1011,13 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_display_outwords, false, "Draw output words");
   BOOL_VAR_H(tessedit_dump_choices, false, "Dump char choices");
   BOOL_VAR_H(tessedit_timing_debug, false, "Print timing stats");
+  double_VAR_H(tessedit_early_finish_certainty, 0.0,
+               "Words of pass 1 with at least this (negative) certainty skip"
+               " pass 2, and a page of only such words skips all the later"
+               " passes (0 = off)");
+  BOOL_VAR_H(tessedit_stream_final_lines, false,
+             "Skip the passes after pass 1 that could change the lines given"
+             " to the line callback of the progress monitor");
   BOOL_VAR_H(tessedit_fix_fuzzy_spaces, true, "Try to improve fuzzy spaces");
   BOOL_VAR_H(tessedit_unrej_any_wd, false,
              "Don't bother with word plausibility");
@@ -869,6 +1052,9 @@ class Tesseract : public Wordrec {
                "Scaling on certainty diff from Hingepoint");
   INT_VAR_H(noise_maxperblob, 8, "Max diacritics to apply to a blob");
   INT_VAR_H(noise_maxperword, 16, "Max diacritics to apply to a word");
+  INT_VAR_H(noise_maxclassifications, 0,
+            "Max blob classifications to spend on the diacritics of a word,"
+            " 0 for no limit");
   INT_VAR_H(debug_x_ht_level, 0, "Reestimate debug");
   BOOL_VAR_H(debug_acceptable_wds, false, "Dump word pass/fail chk");
   STRING_VAR_H(chs_leading_punct, "('`\"", "Leading punctuation");
@@ -892,11 +1078,25 @@ class Tesseract : public Wordrec {
   double_VAR_H(test_pt_x, 99999.99, "xcoord");
   double_VAR_H(test_pt_y, 99999.99, "ycoord");
   INT_VAR_H(multilang_debug_level, 0, "Print multilang debug info.");
+  INT_VAR_H(multilang_gate_words, 0,
+            "Once this many words of a block in a row are best read by the"
+            " same language, read the rest of the block with it alone"
+            " (0 = off)");
+  BOOL_VAR_H(multilang_parallel_retry, false,
+             "Retry a word with all the other languages at once, on a thread"
+             " each, if they are all LSTM only");
   INT_VAR_H(paragraph_debug_level, 0, "Print paragraph debug info.");
   BOOL_VAR_H(paragraph_text_based, true,
              "Run paragraph detection on the post-text-recognition "
              "(more accurate)");
   BOOL_VAR_H(lstm_use_matrix, 1, "Use ratings matrix/beam searct with lstm");
+  BOOL_VAR_H(lstm_use_float32, false,
+             "Run float lstm models in single precision");
+  BOOL_VAR_H(lstm_approx_softmax, false,
+             "Compute only the likely lstm outputs of large models");
+  INT_VAR_H(lstm_network_replica, -1,
+            "Copy of the shared lstm network to use, so that engines on "
+            "different NUMA nodes can each have one, -1 to share one copy");
   STRING_VAR_H(outlines_odd, "%| ", "Non standard number of outlines");
   STRING_VAR_H(outlines_2, "ij!?%\":;", "Non standard number of outlines");
   BOOL_VAR_H(docqual_excuse_outline_errs, false,
@@ -937,6 +1137,8 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(hocr_font_info, false, "Add font info to hocr output");
   BOOL_VAR_H(hocr_char_boxes, false,
              "Add coordinates for each character to hocr output");
+  BOOL_VAR_H(tbr_choices, false,
+             "Add the choices for each character to tbr output");
   BOOL_VAR_H(crunch_early_merge_tess_fails, true, "Before word crunch?");
   BOOL_VAR_H(crunch_early_convert_bad_unlv_chs, false, "Take out ~^ early?");
   double_VAR_H(crunch_terrible_rating, 80.0, "crunch rating lt this");
@@ -971,11 +1173,17 @@ class Tesseract : public Wordrec {
   double_VAR_H(fixsp_small_outlines_size, 0.28, "Small if lt xht x this");
   BOOL_VAR_H(tessedit_prefer_joined_punct, false, "Reward punctuation joins");
   INT_VAR_H(fixsp_done_mode, 1, "What constitues done for spacing");
+  INT_VAR_H(fixsp_max_perms, 0,
+            "Max spacing permutations to recognize per run of fuzzy or"
+            " noisy spaces, 0 for no limit");
   INT_VAR_H(debug_fix_space_level, 0, "Contextual fixspace debug");
   STRING_VAR_H(numeric_punctuation, ".,", "Punct. chs expected WITHIN numbers");
   INT_VAR_H(x_ht_acceptance_tolerance, 8,
             "Max allowed deviation of blob top outside of font data");
   INT_VAR_H(x_ht_min_change, 8, "Min change in xht before actually trying it");
+  BOOL_VAR_H(x_ht_precheck, true,
+             "Don't re-recognize with a new xht unless it would fit the"
+             " current characters better");
   INT_VAR_H(superscript_debug, 0, "Debug level for sub & superscript fixer");
   double_VAR_H(superscript_worse_certainty, 2.0,
                "How many times worse "
@@ -1008,15 +1216,28 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_create_lstmbox, false,
              "Write .box file for LSTM training");
   BOOL_VAR_H(tessedit_create_tsv, false, "Write .tsv output file");
+  BOOL_VAR_H(tessedit_create_tbr, false,
+             "Write .tbr binary result output file");
   BOOL_VAR_H(tessedit_create_wordstrbox, false,
              "Write WordStr format .box output file");
   BOOL_VAR_H(tessedit_create_pdf, false, "Write .pdf output file");
   BOOL_VAR_H(textonly_pdf, false,
              "Create PDF with only one invisible text layer");
   INT_VAR_H(jpg_quality, 85, "Set JPEG quality level");
+  BOOL_VAR_H(pdf_background_images, true,
+             "Encode the images of PDF pages while the next page is"
+             " recognized");
+  INT_VAR_H(renderer_threads, 1,
+            "Max number of output renderers writing a page concurrently, "
+            "1 for one at a time");
   INT_VAR_H(user_defined_dpi, 0, "Specify DPI for input image");
   INT_VAR_H(min_characters_to_try, 50,
             "Specify minimum characters to try during OSD");
+  BOOL_VAR_H(osd_fast, false,
+             "Fast OSD: find the blobs on a binary image reduced to about "
+             "150 dpi, classify at most osd_fast_max_blobs of them, and stop "
+             "once the orientation margin reaches min_orientation_margin");
+  INT_VAR_H(osd_fast_max_blobs, 100, "Max blobs to classify in fast OSD");
   STRING_VAR_H(unrecognised_char, "|", "Output char for unidentified blobs");
   INT_VAR_H(suspect_level, 99, "Suspect marker level");
   INT_VAR_H(suspect_space_level, 100, "Min suspect level for rejecting spaces");
@@ -1052,6 +1273,15 @@ class Tesseract : public Wordrec {
   BOOL_VAR_H(tessedit_create_boxfile, false, "Output text with boxes");
   INT_VAR_H(tessedit_page_number, -1,
             "-1 -> All pages, else specific page to process");
+  INT_VAR_H(tessedit_page_count, 1,
+            "Number of pages to process from tessedit_page_number on, 0 for"
+            " all the rest");
+  INT_VAR_H(page_prefetch_depth, 2,
+            "Max pages of a document to read ahead on another thread while"
+            " recognizing, 0 to read each page when it is needed");
+  INT_VAR_H(page_parallel_jobs, 1,
+            "Number of engines recognizing the pages of a document at once, 1"
+            " for one page at a time");
   BOOL_VAR_H(tessedit_write_images, false, "Capture the image from the IPE");
   BOOL_VAR_H(interactive_display_mode, false, "Run interactively?");
   STRING_VAR_H(file_type, ".tif", "Filename extension");
@@ -1080,7 +1310,72 @@ class Tesseract : public Wordrec {
                "mode");
   double_VAR_H(textord_tabfind_aligned_gap_fraction, 0.75,
                "Fraction of height used as a minimum gap for aligned blobs.");
+  BOOL_VAR_H(textord_fast_auto_layout, false,
+             "In automatic page segmentation without OSD, segment pages that "
+             "look like a single column of text as a single block, skipping "
+             "line, image, tab-stop, table and equation analysis");
+  BOOL_VAR_H(textord_blank_page_reject, false,
+             "Give an empty result, without layout analysis, for pages with "
+             "little ink and no more than textord_blank_page_max_blobs "
+             "text-sized components");
+  double_VAR_H(textord_blank_page_max_ink, 0.002,
+               "Max fraction of the pixels of a page that are ink for it to "
+               "be taken as blank");
+  INT_VAR_H(textord_blank_page_max_blobs, 0,
+            "Max number of text-sized components of a page for it to be "
+            "taken as blank");
+  BOOL_VAR_H(tessedit_auto_downscale, false,
+             "Threshold, analyse the layout and recognize greyscale and color "
+             "images with large text at a reduced size");
+  INT_VAR_H(tessedit_downscale_text_height, 20,
+            "Min median height in pixels of the text components of an image "
+            "reduced by tessedit_auto_downscale");
   INT_VAR_H(tessedit_parallelize, 0, "Run in parallel where possible");
+  INT_VAR_H(tessedit_num_threads, 0,
+            "Number of threads for internal parallel operations, 0 for the "
+            "built-in defaults, 1 for no internal threading");
+  INT_VAR_H(lstm_batch_size, 1,
+            "Max number of text lines to run through the LSTM network "
+            "together, 1 for one line at a time");
+  INT_VAR_H(lstm_line_threads, 1,
+            "Max number of threads recognizing LSTM text lines concurrently, "
+            "1 for one at a time");
+  double_VAR_H(lstm_max_blank_gap, 0.0,
+               "Max width of blank gaps in text lines, as a multiple of the "
+               "line height, to run through the LSTM, 0 to keep all gaps");
+  BOOL_VAR_H(lstm_greedy_decode, false,
+             "Decode LSTM lines with the best path instead of the beam search,"
+             " when there is no dictionary and lstm_choice_mode is 0");
+  double_VAR_H(lstm_beam_collapse_margin, 0.0,
+               "Min margin between the best two LSTM outputs of a timestep at "
+               "which the beam search keeps only its best paths, 0 to keep "
+               "the full beam");
+  BOOL_VAR_H(lstm_pipeline_decode, false,
+             "Decode batches of LSTM lines on a thread of their own, while "
+             "the others run the network on the next batches");
+  INT_VAR_H(lstm_lattice_size, 0,
+            "Number of nodes of each timestep of the LSTM beam search to keep "
+            "in the lattice of the words, 0 to keep no lattice");
+  BOOL_VAR_H(lstm_polarity_check, false,
+             "Judge from its grey levels whether each text line is inverted, "
+             "and only run the LSTM again on an inverted copy of the lines "
+             "that it can't tell");
+  INT_VAR_H(lstm_max_line_timesteps, 20000,
+            "Max width of a text line in timesteps of the LSTM network, "
+            "beyond which the line is not recognized, 0 for no limit");
+  INT_VAR_H(lstm_output_cache_size, 0,
+            "Number of LSTM word images whose network outputs are kept, by "
+            "a hash of their pixels, to decode again when the same pixels "
+            "are recognized again on any page, 0 to keep none");
+  INT_VAR_H(lstm_chunk_timesteps, 0,
+            "Width in timesteps of the LSTM network over which a line is "
+            "split at low-ink gaps into chunks recognized separately, 0 to "
+            "recognize every line whole");
+  BOOL_VAR_H(lstm_indexed_lstmf, false,
+             "Write lstmf training files in the indexed format, whose lines "
+             "can be read without reading the whole file");
+  BOOL_VAR_H(lstm_compress_lstmf, false,
+             "Compress the lines of indexed lstmf training files");
   BOOL_VAR_H(preserve_interword_spaces, false,
              "Preserve multiple interword spaces");
   STRING_VAR_H(page_separator, "\f",
@@ -1104,6 +1399,10 @@ class Tesseract : public Wordrec {
                                   FILE* output_file);
 
  private:
+  // As AttachExtraWords and DetachExtraWords, but just for this.
+  bool AttachExtraWordsInternal(const GenericVector<STRING>& words);
+  void DetachExtraWordsInternal();
+
   // The filename of a backup config file. If not null, then we currently
   // have a temporary debug config file loaded, and backup_config_file_
   // will be loaded, and set to null when debug is complete.
@@ -1113,6 +1412,10 @@ class Tesseract : public Wordrec {
   // Image used for input to layout analysis and tesseract recognition.
   // May be modified by the ShiroRekhaSplitter to eliminate the top-line.
   Pix* pix_binary_;
+  // Cache of the reductions of pix_binary_, built on demand by blank page
+  // detection, line and image finding and fast OSD. Anything that modifies
+  // pix_binary_ in place must invalidate it.
+  ImagePyramid binary_pyramid_;
   // Grey-level input image if the input was not binary, otherwise nullptr.
   Pix* pix_grey_;
   // Original input image. Color if the input was color.
@@ -1124,6 +1427,12 @@ class Tesseract : public Wordrec {
   // Input image resolution after any scaling. The resolution is not well
   // transmitted by operations on Pix, so we keep an independent record here.
   int source_resolution_;
+  // Factor by which the page images are reduced from the input image.
+  int image_reduction_;
+  // See budget_reduction.
+  int budget_reduction_;
+  // Why the last SegmentPage took the page as blank, or nullptr.
+  const char* blank_page_reason_;
   // The shiro-rekha splitter object which is used to split top-lines in
   // Devanagari words to provide a better word and grapheme segmentation.
   ShiroRekhaSplitter splitter_;
@@ -1143,12 +1452,22 @@ class Tesseract : public Wordrec {
   Tesseract* most_recently_used_;
   // The size of the font table, ie max possible font id + 1.
   int font_table_size_;
+  // Number of blob classifications ReassignDiacritics may still spend on the
+  // current word.
+  int noise_classifications_left_;
   // Equation detector. Note: this pointer is NOT owned by the class.
   EquationDetect* equ_detect_;
   // LSTM recognizer, if available.
   LSTMRecognizer* lstm_recognizer_;
+  // Words already recognized by PrerecAllLinesLSTM, ready for
+  // LSTMRecognizeWord to pick up.
+  std::map<const WERD_RES*, PointerVector<WERD_RES>> lstm_batch_words_;
   // Output "page" number (actually line number) using TrainLineRecognizer.
   int train_line_page_num_;
+  // The user dawgs of AttachExtraWords, each attached to the Dict of the same
+  // index in extra_dicts_.
+  GenericVector<Dawg*> extra_dawgs_;
+  GenericVector<Dict*> extra_dicts_;
 };
 
 }  // namespace tesseract
@@ -20,12 +20,21 @@
 
 #include "thresholder.h"
 
+#include <algorithm>    // for std::max, std::min
+#include <cmath>        // for std::sqrt
 #include <cstdint>      // for uint32_t
 #include <cstring>
+#include <vector>       // for std::vector
 
+#include "numthreads.h"  // for NumThreads
 #include "otsuthr.h"
+#include "simddetect.h"  // for ThresholdLine
 #include "tprintf.h"    // for tprintf
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
 #if defined(USE_OPENCL)
 #include "openclwrapper.h" // for OpenclDevice
 #endif
@@ -33,10 +42,12 @@
 namespace tesseract {
 
 ImageThresholder::ImageThresholder()
-  : pix_(nullptr),
+  : pix_(nullptr), view_data_(nullptr), view_bytes_per_line_(0),
     image_width_(0), image_height_(0),
     pix_channels_(0), pix_wpl_(0),
-    scale_(1), yres_(300), estimated_res_(300) {
+    scale_(1), yres_(300), estimated_res_(300),
+    threshold_method_(ThresholdMethod::Otsu), window_size_(0), kfactor_(0.0),
+    num_threads_(0), memory_limit_(0) {
   SetRectangle(0, 0, 0, 0);
 }
 
@@ -47,11 +58,12 @@ ImageThresholder::~ImageThresholder() {
 // Destroy the Pix if there is one, freeing memory.
 void ImageThresholder::Clear() {
   pixDestroy(&pix_);
+  view_data_ = nullptr;
 }
 
 // Return true if no image has been set.
 bool ImageThresholder::IsEmpty() const {
-  return pix_ == nullptr;
+  return pix_ == nullptr && view_data_ == nullptr;
 }
 
 // SetImage makes a copy of all the image data, so it may be deleted
@@ -114,8 +126,27 @@ void ImageThresholder::SetImage(const unsigned char* imagedata,
   default:
     tprintf("Cannot convert RAW image to Pix with bpp = %d\n", bpp);
   }
-  SetImage(pix);
-  pixDestroy(&pix);
+  // The pix is already our own copy, so it doesn't need copying again.
+  TakeImage(pix);
+}
+
+// SetImageView uses the given 8 bit greyscale image data in place, without
+// copying it, so the caller must keep it valid and unchanged until the next
+// SetImage, SetImageView or Clear, or the destruction of the thresholder.
+void ImageThresholder::SetImageView(const unsigned char* imagedata,
+                                    int width, int height,
+                                    int bytes_per_line) {
+  pixDestroy(&pix_);
+  view_data_ = imagedata;
+  view_bytes_per_line_ = bytes_per_line;
+  image_width_ = width;
+  image_height_ = height;
+  pix_channels_ = 1;
+  pix_wpl_ = 0;
+  scale_ = 1;
+  // As for a raw image, there is no resolution until SetSourceYResolution.
+  estimated_res_ = yres_ = 0;
+  Init();
 }
 
 // Store the coordinates of the rectangle to process for later use.
@@ -148,29 +179,58 @@ void ImageThresholder::GetImageSizes(int* left, int* top,
 // immediately after, but may not go away until after the Thresholder has
 // finished with it.
 void ImageThresholder::SetImage(const Pix* pix) {
-  if (pix_ != nullptr)
-    pixDestroy(&pix_);
   Pix* src = const_cast<Pix*>(pix);
-  int depth;
-  pixGetDimensions(src, &image_width_, &image_height_, &depth);
+  int depth = pixGetDepth(src);
   // Convert the image as necessary so it is one of binary, plain RGB, or
   // 8 bit with no colormap. Guarantee that we always end up with our own copy,
   // not just a clone of the input.
+  Pix* copy;
   if (pixGetColormap(src)) {
     Pix* tmp = pixRemoveColormap(src, REMOVE_CMAP_BASED_ON_SRC);
     depth = pixGetDepth(tmp);
     if (depth > 1 && depth < 8) {
-      pix_ = pixConvertTo8(tmp, false);
+      copy = pixConvertTo8(tmp, false);
       pixDestroy(&tmp);
     } else {
-      pix_ = tmp;
+      copy = tmp;
     }
   } else if (depth > 1 && depth < 8) {
-    pix_ = pixConvertTo8(src, false);
+    copy = pixConvertTo8(src, false);
+  } else if (depth == 32 &&
+             !FitsMemoryLimit(pixGetWidth(src), pixGetHeight(src), depth)) {
+    // Don't copy the color image just for TakeImage to reduce it to grey.
+    copy = pixConvertRGBToLuminance(src);
   } else {
-    pix_ = pixCopy(nullptr, src);
+    copy = pixCopy(nullptr, src);
+  }
+  TakeImage(copy);
+}
+
+// Takes ownership of pix, which must be binary, 8 bit without a colormap,
+// or 32 bit, as the source image.
+void ImageThresholder::TakeImage(Pix* pix) {
+  pixDestroy(&pix_);
+  view_data_ = nullptr;
+  int depth;
+  pixGetDimensions(pix, &image_width_, &image_height_, &depth);
+  if (depth == 32 && !FitsMemoryLimit(image_width_, image_height_, depth)) {
+    Pix* grey = pixConvertRGBToLuminance(pix);
+    pixDestroy(&pix);
+    pix = grey;
+    depth = 8;
   }
-  depth = pixGetDepth(pix_);
+  if (!FitsMemoryLimit(image_width_, image_height_, depth)) {
+    tprintf("Image of %dx%d pixels doesn't fit in the memory limit of %d MB\n",
+            image_width_, image_height_,
+            static_cast<int>(memory_limit_ >> 20));
+    pixDestroy(&pix);
+    image_width_ = image_height_ = 0;
+    pix_channels_ = 0;
+    pix_wpl_ = 0;
+    Init();
+    return;
+  }
+  pix_ = pix;
   pix_channels_ = depth / 8;
   pix_wpl_ = pixGetWpl(pix_);
   scale_ = 1;
@@ -178,6 +238,20 @@ void ImageThresholder::SetImage(const Pix* pix) {
   Init();
 }
 
+// Returns true if the images of a page of the given size and source depth fit
+// in the memory limit. They are the source image, the grey image that is made
+// of a color one for recognition, and the binary image.
+bool ImageThresholder::FitsMemoryLimit(int width, int height,
+                                       int depth) const {
+  if (memory_limit_ <= 0) return true;
+  auto line_bytes = [width](int line_depth) {
+    return (static_cast<int64_t>(width) * line_depth + 31) / 32 * 4;
+  };
+  int64_t line_total = line_bytes(depth) + line_bytes(1);
+  if (depth == 32) line_total += line_bytes(8);
+  return line_total * height <= memory_limit_;
+}
+
 // Threshold the source image as efficiently as possible to the output Pix.
 // Creates a Pix and sets pix to point to the resulting pointer.
 // Caller must use pixDestroy to free the created Pix.
@@ -193,6 +267,10 @@ bool ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
     Pix* original = GetPixRect();
     *pix = pixCopy(nullptr, original);
     pixDestroy(&original);
+  } else if (threshold_method_ != ThresholdMethod::Otsu) {
+    AdaptiveThresholdRectToPix(pix);
+  } else if (view_data_ != nullptr) {
+    ThresholdViewToPix(pix);
   } else {
     OtsuThresholdRectToPix(pix_, pix);
   }
@@ -208,18 +286,33 @@ bool ImageThresholder::ThresholdToPix(PageSegMode pageseg_mode, Pix** pix) {
 // Returns nullptr if the input is binary. PixDestroy after use.
 Pix* ImageThresholder::GetPixRectThresholds() {
   if (IsBinary()) return nullptr;
-  Pix* pix_grey = GetPixRectGrey();
-  int width = pixGetWidth(pix_grey);
-  int height = pixGetHeight(pix_grey);
-  int* thresholds;
-  int* hi_values;
-  OtsuThreshold(pix_grey, 0, 0, width, height, &thresholds, &hi_values);
-  pixDestroy(&pix_grey);
-  Pix* pix_thresholds = pixCreate(width, height, 8);
-  int threshold = thresholds[0] > 0 ? thresholds[0] : 128;
-  pixSetAllArbitrary(pix_thresholds, threshold);
-  delete [] thresholds;
-  delete [] hi_values;
+  int width;
+  int height;
+  int threshold;
+  if (view_data_ != nullptr) {
+    // The view is already grey, so it doesn't need a Pix to be made.
+    width = rect_width_;
+    height = rect_height_;
+    int hi_value;
+    OtsuThreshold(view_data_, view_bytes_per_line_, rect_left_, rect_top_,
+                  width, height, &threshold, &hi_value);
+  } else {
+    Pix* pix_grey = GetPixRectGrey();
+    width = pixGetWidth(pix_grey);
+    height = pixGetHeight(pix_grey);
+    int* thresholds;
+    int* hi_values;
+    OtsuThreshold(pix_grey, 0, 0, width, height, &thresholds, &hi_values);
+    pixDestroy(&pix_grey);
+    threshold = thresholds[0];
+    delete [] thresholds;
+    delete [] hi_values;
+  }
+  // The threshold is the same everywhere, so rather than a full page of
+  // bytes, the image is a single line reduced by the factor of the height.
+  int reduction = std::max(height, 1);
+  Pix* pix_thresholds = pixCreate((width + reduction - 1) / reduction, 1, 8);
+  pixSetAllArbitrary(pix_thresholds, threshold > 0 ? threshold : 128);
   return pix_thresholds;
 }
 
@@ -236,7 +329,10 @@ void ImageThresholder::Init() {
 Pix* ImageThresholder::GetPixRect() {
   if (IsFullImage()) {
     // Just clone the whole thing.
-    return pixClone(pix_);
+    return GetPixImage();
+  } else if (view_data_ != nullptr) {
+    // Copy the rectangle straight from the view.
+    return ViewRectToPix(rect_left_, rect_top_, rect_width_, rect_height_);
   } else {
     // Crop to the given rectangle.
     Box* box = boxCreate(rect_left_, rect_top_, rect_width_, rect_height_);
@@ -246,6 +342,15 @@ Pix* ImageThresholder::GetPixRect() {
   }
 }
 
+// Get a clone of the whole source image, regardless of the rectangle.
+// The returned Pix must be pixDestroyed.
+// With an image view, the Pix is made on the first call and kept.
+Pix* ImageThresholder::GetPixImage() {
+  if (pix_ == nullptr && view_data_ != nullptr)
+    pix_ = ViewRectToPix(0, 0, image_width_, image_height_);
+  return pixClone(pix_);
+}
+
 // Get a clone/copy of the source image rectangle, reduced to greyscale,
 // and at the same resolution as the output binary.
 // The returned Pix must be pixDestroyed.
@@ -306,7 +411,13 @@ void ImageThresholder::ThresholdRectToPix(Pix* src_pix,
   for (int y = 0; y < rect_height_; ++y) {
     const uint32_t* linedata = srcdata + (y + rect_top_) * src_wpl;
     uint32_t* pixline = pixdata + y * wpl;
-    for (int x = 0; x < rect_width_; ++x) {
+    // The SIMD code does whole words of the line, leaving the rest to here.
+    int x = 0;
+    if (ThresholdLine != nullptr) {
+      x = ThresholdLine(linedata, rect_left_, rect_width_, num_channels,
+                        thresholds, hi_values, pixline);
+    }
+    for (; x < rect_width_; ++x) {
       bool white_result = true;
       for (int ch = 0; ch < num_channels; ++ch) {
         int pixel =
@@ -325,4 +436,167 @@ void ImageThresholder::ThresholdRectToPix(Pix* src_pix,
   }
 }
 
+// Otsu thresholds the rectangle of the image view to the output pix.
+void ImageThresholder::ThresholdViewToPix(Pix** pix) const {
+  int threshold;
+  int hi_value;
+  OtsuThreshold(view_data_, view_bytes_per_line_, rect_left_, rect_top_,
+                rect_width_, rect_height_, &threshold, &hi_value);
+  *pix = pixCreate(rect_width_, rect_height_, 1);
+  uint32_t* pixdata = pixGetData(*pix);
+  int wpl = pixGetWpl(*pix);
+  for (int y = 0; y < rect_height_; ++y) {
+    const unsigned char* linedata =
+        view_data_ + (y + rect_top_) * view_bytes_per_line_ + rect_left_;
+    uint32_t* pixline = pixdata + y * wpl;
+    // The SIMD code does whole words of the line, leaving the rest to here.
+    int x = 0;
+    if (ThresholdGreyLine != nullptr) {
+      x = ThresholdGreyLine(linedata, rect_width_, threshold, hi_value,
+                            pixline);
+    }
+    for (; x < rect_width_; ++x) {
+      if (hi_value >= 0 && (linedata[x] > threshold) == (hi_value == 0))
+        SET_DATA_BIT(pixline, x);
+      else
+        CLEAR_DATA_BIT(pixline, x);
+    }
+  }
+}
+
+// Number of lines in each tile of the adaptive thresholding. Each thread keeps
+// the column sums of one tile at a time, so the memory used is bounded by the
+// width of the image and the number of threads, not by the size of the image.
+const int kAdaptiveTileHeight = 128;
+// Dynamic range of the standard deviation in Sauvola's method.
+const double kSauvolaDeviationRange = 128.0;
+
+// Source of the grey lines of the rectangle for the adaptive thresholding,
+// which is either a caller's image view or a grey Pix.
+struct GreyLines {
+  // Returns line y of the rectangle, unpacked into buffer for a Pix.
+  const unsigned char* Line(int y, unsigned char* buffer) const {
+    if (view != nullptr) return view + y * bytes_per_line;
+    const l_uint32* line = data + y * wpl;
+    for (int x = 0; x < width; ++x) buffer[x] = GET_DATA_BYTE(line, x);
+    return buffer;
+  }
+
+  const unsigned char* view;  // First pixel of the rectangle of a view.
+  int bytes_per_line;         // Of the view.
+  const l_uint32* data;       // Data of the Pix if there is no view.
+  int wpl;                    // Of the Pix.
+  int width;
+  int height;
+};
+
+// Thresholds lines top to bottom - 1 of the grey lines to the lines of the 1
+// bit image pixdata. The window sums are kept as sums of each column over the
+// lines of the window, which move down one line at a time, and are integrated
+// along each line to get the sum of any window of the line.
+static void AdaptiveThresholdTile(const GreyLines& lines, int top, int bottom,
+                                  int radius, ThresholdMethod method,
+                                  double kfactor, l_uint32* pixdata, int wpl) {
+  const int width = lines.width;
+  const int height = lines.height;
+  std::vector<uint32_t> column_sums(width);
+  std::vector<uint64_t> column_squares(width);
+  std::vector<uint64_t> sums(width + 1);
+  std::vector<uint64_t> squares(width + 1);
+  std::vector<unsigned char> buffer(width);
+  auto add_line = [&](int y, int sign) {
+    const unsigned char* line = lines.Line(y, &buffer[0]);
+    for (int x = 0; x < width; ++x) {
+      int value = line[x];
+      column_sums[x] += sign * value;
+      column_squares[x] += sign * value * value;
+    }
+  };
+  for (int y = std::max(0, top - radius); y < std::min(height, top + radius);
+       ++y) {
+    add_line(y, 1);
+  }
+  std::vector<unsigned char> pixel_buffer(width);
+  for (int y = top; y < bottom; ++y) {
+    if (y + radius < height) add_line(y + radius, 1);
+    int num_lines = std::min(height - 1, y + radius) - std::max(0, y - radius)
+        + 1;
+    sums[0] = 0;
+    squares[0] = 0;
+    for (int x = 0; x < width; ++x) {
+      sums[x + 1] = sums[x] + column_sums[x];
+      squares[x + 1] = squares[x] + column_squares[x];
+    }
+    const unsigned char* line = lines.Line(y, &pixel_buffer[0]);
+    l_uint32* pixline = pixdata + (y * wpl);
+    for (int x = 0; x < width; ++x) {
+      int left = std::max(0, x - radius);
+      int right = std::min(width - 1, x + radius) + 1;
+      double count = static_cast<double>(right - left) * num_lines;
+      double mean = (sums[right] - sums[left]) / count;
+      double variance = (squares[right] - squares[left]) / count - mean * mean;
+      double deviation = variance > 0.0 ? std::sqrt(variance) : 0.0;
+      double threshold =
+          method == ThresholdMethod::Sauvola
+              ? mean * (1.0 + kfactor * (deviation / kSauvolaDeviationRange -
+                                         1.0))
+              : mean - kfactor * deviation;
+      if (line[x] < threshold)
+        SET_DATA_BIT(pixline, x);
+      else
+        CLEAR_DATA_BIT(pixline, x);
+    }
+    if (y - radius >= 0) add_line(y - radius, -1);
+  }
+}
+
+// Thresholds the rectangle of the greyscale image with the adaptive
+// threshold_method_ to the output pix. The tiles are independent, as each one
+// finds the sums of its first window itself, so they run in parallel.
+void ImageThresholder::AdaptiveThresholdRectToPix(Pix** pix) {
+  GreyLines lines = {nullptr, view_bytes_per_line_, nullptr, 0, rect_width_,
+                     rect_height_};
+  Pix* pix_grey = nullptr;
+  if (view_data_ != nullptr) {
+    lines.view = view_data_ + rect_top_ * view_bytes_per_line_ + rect_left_;
+  } else {
+    pix_grey = GetPixRectGrey();
+    lines.data = pixGetData(pix_grey);
+    lines.wpl = pixGetWpl(pix_grey);
+  }
+  *pix = pixCreate(rect_width_, rect_height_, 1);
+  l_uint32* pixdata = pixGetData(*pix);
+  int wpl = pixGetWpl(*pix);
+  int radius = std::max(1, window_size_ / 2);
+  int num_tiles = (rect_height_ + kAdaptiveTileHeight - 1) /
+                  kAdaptiveTileHeight;
+#ifdef _OPENMP
+  const int num_threads = NumThreads(omp_get_max_threads(), num_threads_);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int t = 0; t < num_tiles; ++t) {
+    int top = t * kAdaptiveTileHeight;
+    int bottom = std::min(rect_height_, top + kAdaptiveTileHeight);
+    AdaptiveThresholdTile(lines, top, bottom, radius, threshold_method_,
+                          kfactor_, pixdata, wpl);
+  }
+  pixDestroy(&pix_grey);
+}
+
+// Returns a new Pix of the rectangle of the image view.
+Pix* ImageThresholder::ViewRectToPix(int left, int top,
+                                     int width, int height) const {
+  Pix* pix = pixCreate(width, height, 8);
+  l_uint32* data = pixGetData(pix);
+  int wpl = pixGetWpl(pix);
+  const unsigned char* imagedata =
+      view_data_ + top * view_bytes_per_line_ + left;
+  for (int y = 0; y < height; ++y, data += wpl,
+       imagedata += view_bytes_per_line_) {
+    for (int x = 0; x < width; ++x)
+      SET_DATA_BYTE(data, x, imagedata[x]);
+  }
+  return pix;
+}
+
 }  // namespace tesseract.
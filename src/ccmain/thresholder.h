@@ -19,6 +19,7 @@
 #ifndef TESSERACT_CCMAIN_THRESHOLDER_H_
 #define TESSERACT_CCMAIN_THRESHOLDER_H_
 
+#include <cstdint>      // for int64_t
 #include "platform.h"
 #include "publictypes.h"
 
@@ -26,6 +27,14 @@ struct Pix;
 
 namespace tesseract {
 
+/// Methods of thresholding the source image to a binary image.
+enum class ThresholdMethod {
+  Otsu,     ///< Global Otsu threshold of each channel.
+  Sauvola,  ///< Adaptive threshold from the local mean and deviation.
+  Niblack,  ///< Adaptive threshold from the local mean and deviation.
+  Max,      ///< Number of thresholding methods.
+};
+
 /// Base class for all tesseract image thresholding classes.
 /// Specific classes can add new thresholding methods by
 /// overriding ThresholdToPix.
@@ -54,6 +63,16 @@ class TESS_API ImageThresholder {
   void SetImage(const unsigned char* imagedata, int width, int height,
                 int bytes_per_pixel, int bytes_per_line);
 
+  /// SetImageView uses the given 8 bit greyscale image data in place,
+  /// without copying it, so the caller must keep it valid and unchanged until
+  /// the next SetImage, SetImageView or Clear, or the destruction of the
+  /// thresholder. Lines start bytes_per_line bytes apart, which may be more
+  /// than width. Thresholding reads the data directly, and a Pix of it is
+  /// only made when one is requested with GetPixImage, GetPixRect or
+  /// GetPixRectGrey.
+  void SetImageView(const unsigned char* imagedata, int width, int height,
+                    int bytes_per_line);
+
   /// Store the coordinates of the rectangle to process for later use.
   /// Doesn't actually do any thresholding.
   void SetRectangle(int left, int top, int width, int height);
@@ -75,6 +94,12 @@ class TESS_API ImageThresholder {
     return pix_channels_ == 0;
   }
 
+  /// Returns the copy of the source image, or nullptr if none has been made
+  /// yet, as for an image view. Clones of it share its data. Do not destroy.
+  Pix* source_pix() const {
+    return pix_;
+  }
+
   int GetScaleFactor() const {
     return scale_;
   }
@@ -113,6 +138,32 @@ class TESS_API ImageThresholder {
   /// finished with it.
   void SetImage(const Pix* pix);
 
+  /// Set the method used by ThresholdToPix. The adaptive methods compute a
+  /// threshold for each pixel of the greyscale image from the mean m and the
+  /// standard deviation s of the pixels in a window_size x window_size window
+  /// around it. Sauvola uses m * (1 + kfactor * (s / 128 - 1)) and Niblack
+  /// uses m - kfactor * s. Pixels darker than the threshold are foreground.
+  void SetThresholdMethod(ThresholdMethod method, int window_size,
+                          double kfactor) {
+    threshold_method_ = method;
+    window_size_ = window_size;
+    kfactor_ = kfactor;
+  }
+
+  /// Set the number of threads for the adaptive methods, which threshold
+  /// horizontal tiles of the image in parallel. 0 uses the default.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+
+  /// Set an approximate limit in bytes of the memory used by the images of a
+  /// page, 0 for no limit. SetImage reduces a color image that doesn't fit to
+  /// grey, and drops any image that still doesn't fit, leaving the
+  /// thresholder empty. Image views are exempt, as they are not copied.
+  void set_memory_limit(int64_t bytes) {
+    memory_limit_ = bytes;
+  }
+
   /// Threshold the source image as efficiently as possible to the output Pix.
   /// Creates a Pix and sets pix to point to the resulting pointer.
   /// Caller must use pixDestroy to free the created Pix.
@@ -135,6 +186,11 @@ class TESS_API ImageThresholder {
   /// so there is no raw equivalent.
   Pix* GetPixRect();
 
+  /// Get a clone of the whole source image, regardless of the rectangle.
+  /// The returned Pix must be pixDestroyed.
+  /// With an image view, the Pix is made on the first call and kept.
+  Pix* GetPixImage();
+
   // Get a clone/copy of the source image rectangle, reduced to greyscale,
   // and at the same resolution as the output binary.
   // The returned Pix must be pixDestroyed.
@@ -148,6 +204,14 @@ class TESS_API ImageThresholder {
   /// Common initialization shared between SetImage methods.
   virtual void Init();
 
+  /// Takes ownership of pix, which must be binary, 8 bit without a colormap,
+  /// or 32 bit, as the source image.
+  void TakeImage(Pix* pix);
+
+  /// Returns true if the images of a page of the given size and source depth
+  /// fit in the memory limit.
+  bool FitsMemoryLimit(int width, int height, int depth) const;
+
   /// Return true if we are processing the full image.
   bool IsFullImage() const {
     return rect_left_ == 0 && rect_top_ == 0 &&
@@ -165,10 +229,24 @@ class TESS_API ImageThresholder {
                           const int* thresholds, const int* hi_values,
                           Pix** pix) const;
 
+  /// Otsu thresholds the rectangle of the image view to the output pix.
+  void ThresholdViewToPix(Pix** pix) const;
+
+  /// Thresholds the rectangle of the greyscale image with the adaptive
+  /// threshold_method_ to the output pix.
+  void AdaptiveThresholdRectToPix(Pix** pix);
+
+  /// Returns a new Pix of the rectangle of the image view.
+  Pix* ViewRectToPix(int left, int top, int width, int height) const;
+
  protected:
   /// Clone or other copy of the source Pix.
   /// The pix will always be PixDestroy()ed on destruction of the class.
+  /// With an image view, it is only made by GetPixRect of the full image.
   Pix*                 pix_;
+  /// Caller's 8 bit image data given to SetImageView, or nullptr.
+  const unsigned char* view_data_;
+  int                  view_bytes_per_line_;  ///< Bytes per line of view_data_.
 
   int                  image_width_;    ///< Width of source pix_.
   int                  image_height_;   ///< Height of source pix_.
@@ -182,6 +260,12 @@ class TESS_API ImageThresholder {
   int                  rect_top_;
   int                  rect_width_;
   int                  rect_height_;
+  // Thresholding method and the parameters of the adaptive methods.
+  ThresholdMethod      threshold_method_;
+  int                  window_size_;    ///< Window size in pixels.
+  double               kfactor_;        ///< Weight of the deviation.
+  int                  num_threads_;    ///< Requested number of threads.
+  int64_t              memory_limit_;   ///< Max bytes of the page images.
 };
 
 }  // namespace tesseract.
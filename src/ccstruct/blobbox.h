@@ -25,6 +25,7 @@
 #include "elst.h"              // for ELIST_ITERATOR, ELISTIZEH, ELIST_LINK
 #include "elst2.h"             // for ELIST2_ITERATOR, ELIST2IZEH, ELIST2_LINK
 #include "errcode.h"           // for ASSERT_HOST
+#include "freelist.h"          // for FREE_LIST_ALLOCATED
 #include "ocrblock.h"          // for BLOCK
 #include "params.h"            // for DoubleParam, double_VAR_H
 #include "pdblock.h"           // for PDBLK
@@ -155,6 +156,7 @@ class BLOBNBOX:public ELIST_LINK
     ~BLOBNBOX() {
       if (owns_cblob_) delete cblob_ptr;
     }
+    FREE_LIST_ALLOCATED(BLOBNBOX, tesseract::kMaxFreeBlobBytes)
     static BLOBNBOX* RealBlob(C_OUTLINE* outline) {
       auto* blob = new C_BLOB(outline);
       return new BLOBNBOX(blob);
@@ -27,6 +27,7 @@
 #include <cstdint>             // for int16_t
 #include <cstring>             // for memcpy, memset
 #include "clst.h"              // for CLIST_ITERATOR, CLISTIZEH
+#include "freelist.h"          // for FREE_LIST_ALLOCATED
 #include "genericvector.h"     // for GenericVector
 #include "normalis.h"          // for DENORM
 #include "points.h"            // for FCOORD, ICOORD
@@ -87,6 +88,7 @@ struct EDGEPT {
     CopyFrom(src);
     return *this;
   }
+  FREE_LIST_ALLOCATED(EDGEPT, tesseract::kMaxFreeBlobBytes)
   // Copies the data elements, but leaves the pointers untouched.
   void CopyFrom(const EDGEPT& src) {
     pos = src.pos;
@@ -187,6 +189,7 @@ struct TESSLINE {
   ~TESSLINE() {
     Clear();
   }
+  FREE_LIST_ALLOCATED(TESSLINE, tesseract::kMaxFreeBlobBytes)
   TESSLINE& operator=(const TESSLINE& src) {
     CopyFrom(src);
     return *this;
@@ -268,6 +271,7 @@ struct TBLOB {
   ~TBLOB() {
     Clear();
   }
+  FREE_LIST_ALLOCATED(TBLOB, tesseract::kMaxFreeBlobBytes)
   TBLOB& operator=(const TBLOB& src) {
     CopyFrom(src);
     return *this;
@@ -402,6 +406,7 @@ struct TWERD {
   ~TWERD() {
     Clear();
   }
+  FREE_LIST_ALLOCATED(TWERD, tesseract::kMaxFreeWordBytes)
   TWERD& operator=(const TWERD& src) {
     CopyFrom(src);
     return *this;
@@ -20,6 +20,7 @@
 #ifndef TESSERACT_CSTRUCT_BOXWORD_H_
 #define TESSERACT_CSTRUCT_BOXWORD_H_
 
+#include "freelist.h"       // for FREE_LIST_ALLOCATED
 #include "genericvector.h"  // for GenericVector
 #include "rect.h"           // for TBOX
 
@@ -39,6 +40,7 @@ class BoxWord {
   BoxWord();
   explicit BoxWord(const BoxWord& src);
   ~BoxWord() = default;
+  FREE_LIST_ALLOCATED(BoxWord, tesseract::kMaxFreeWordBytes)
 
   BoxWord& operator=(const BoxWord& src);
 
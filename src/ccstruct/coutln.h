@@ -23,6 +23,7 @@
 #include <cstdint>      // for int16_t, int32_t
 #include "bits16.h"     // for BITS16
 #include "elst.h"       // for ELIST_ITERATOR, ELISTIZEH, ELIST_LINK
+#include "freelist.h"   // for FREE_LIST_ALLOCATED
 #include "mod128.h"     // for DIR128, DIRBITS
 #include "platform.h"   // for DLLSYM
 #include "points.h"     // for ICOORD, FCOORD
@@ -86,6 +87,7 @@ class DLLSYM C_OUTLINE:public ELIST_LINK {
               int16_t length);     //length of loop
                                  //outline to copy
     C_OUTLINE(C_OUTLINE *srcline, FCOORD rotation);  //and rotate
+    FREE_LIST_ALLOCATED(C_OUTLINE, tesseract::kMaxFreeBlobBytes)
 
     // Build a fake outline, given just a bounding box and append to the list.
     static void FakeOutline(const TBOX& box, C_OUTLINE_LIST* outlines);
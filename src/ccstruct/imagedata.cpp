@@ -42,6 +42,13 @@
 // Number of documents to read ahead while training. Doesn't need to be very
 // large.
 const int kMaxReadAhead = 8;
+// Marker that starts an indexed document, in place of the page count of a
+// plain one, which is never negative.
+const int32_t kIndexedDocumentMarker = -1;
+// Version of the indexed document format.
+const int32_t kIndexedDocumentVersion = 1;
+// Flag bit of a page of an indexed document, set if the page is compressed.
+const int8_t kPageCompressed = 1;
 
 namespace tesseract {
 
@@ -120,14 +127,20 @@ int FloatWordFeature::SortByXBucket(const void* v1, const void* v2) {
   return x_diff;
 }
 
-ImageData::ImageData() : page_number_(-1), vertical_text_(false) {
+ImageData::ImageData()
+  : page_number_(-1), vertical_text_(false), decoded_pix_(nullptr) {
 }
-// Takes ownership of the pix and destroys it.
-ImageData::ImageData(bool vertical, Pix* pix)
-  : page_number_(0), vertical_text_(vertical) {
-  SetPix(pix);
+// Takes ownership of the pix and destroys it, unless keep_decoded.
+ImageData::ImageData(bool vertical, Pix* pix, bool keep_decoded)
+  : page_number_(0), vertical_text_(vertical), decoded_pix_(nullptr) {
+  if (keep_decoded) {
+    decoded_pix_ = pix;
+  } else {
+    SetPix(pix);
+  }
 }
 ImageData::~ImageData() {
+  pixDestroy(&decoded_pix_);
 }
 
 // Builds and returns an ImageData from the basic data. Note that imagedata,
@@ -166,7 +179,14 @@ ImageData* ImageData::Build(const char* name, int page_number, const char* lang,
 bool ImageData::Serialize(TFile* fp) const {
   if (!imagefilename_.Serialize(fp)) return false;
   if (!fp->Serialize(&page_number_)) return false;
-  if (!image_data_.Serialize(fp)) return false;
+  if (image_data_.empty() && IsDecoded()) {
+    // The image was kept without encoding it, so it is encoded now.
+    GenericVector<char> image_data;
+    SetPixInternal(GetPix(), &image_data);
+    if (!image_data.Serialize(fp)) return false;
+  } else if (!image_data_.Serialize(fp)) {
+    return false;
+  }
   if (!language_.Serialize(fp)) return false;
   if (!transcription_.Serialize(fp)) return false;
   // WARNING: Will not work across different endian machines.
@@ -176,11 +196,30 @@ bool ImageData::Serialize(TFile* fp) const {
   return fp->Serialize(&vertical);
 }
 
+// Returns a deep copy of *this, or nullptr in case of error. The caller
+// takes ownership. The decoded image cache is not copied, unless the image
+// was kept without encoding it.
+ImageData* ImageData::Copy() const {
+  auto* copy = new ImageData;
+  copy->imagefilename_ = imagefilename_;
+  copy->page_number_ = page_number_;
+  copy->image_data_ = image_data_;
+  copy->language_ = language_;
+  copy->transcription_ = transcription_;
+  copy->boxes_ = boxes_;
+  copy->box_texts_ = box_texts_;
+  copy->vertical_text_ = vertical_text_;
+  // An image that was never encoded exists only as the decoded one.
+  if (image_data_.empty() && IsDecoded()) copy->decoded_pix_ = GetPix();
+  return copy;
+}
+
 // Reads from the given file. Returns false in case of error.
 // If swap is true, assumes a big/little-endian swap is needed.
 bool ImageData::DeSerialize(TFile* fp) {
   if (!imagefilename_.DeSerialize(fp)) return false;
   if (!fp->DeSerialize(&page_number_)) return false;
+  ForgetDecoded();
   if (!image_data_.DeSerialize(fp)) return false;
   if (!language_.DeSerialize(fp)) return false;
   if (!transcription_.DeSerialize(fp)) return false;
@@ -211,14 +250,114 @@ bool ImageData::SkipDeSerialize(TFile* fp) {
 // In case of missing PNG support in Leptonica use PNM format,
 // which requires more memory.
 void ImageData::SetPix(Pix* pix) {
+  ForgetDecoded();
   SetPixInternal(pix, &image_data_);
 }
 
 // Returns the Pix image for *this. Must be pixDestroyed after use.
 Pix* ImageData::GetPix() const {
+  {
+    SVAutoLock lock(&pix_mutex_);
+    if (decoded_pix_ != nullptr) return pixCopy(nullptr, decoded_pix_);
+  }
   return GetPixInternal(image_data_);
 }
 
+// Decodes the image now and keeps it, so that GetPix only has to copy it.
+// May be called on another thread while *this is being used.
+void ImageData::Predecode() {
+  if (IsDecoded()) return;
+  // The decoding is the slow part, so it is done without the lock.
+  Pix* pix = GetPixInternal(image_data_);
+  SVAutoLock lock(&pix_mutex_);
+  if (decoded_pix_ == nullptr) {
+    decoded_pix_ = pix;
+  } else {
+    pixDestroy(&pix);
+  }
+}
+
+// Frees the image kept by Predecode.
+void ImageData::ForgetDecoded() {
+  SVAutoLock lock(&pix_mutex_);
+  pixDestroy(&decoded_pix_);
+}
+
+// Returns true if the image has been kept by Predecode.
+bool ImageData::IsDecoded() const {
+  SVAutoLock lock(&pix_mutex_);
+  return decoded_pix_ != nullptr;
+}
+
+// Returns src_pix scaled to *target_height, which is first set to the
+// height of src_pix, up to max_height, if 0. Sets *im_factor to the scale.
+static Pix* ScaleToHeight(Pix* src_pix, int max_height, int* target_height,
+                          float* im_factor) {
+  int input_height = pixGetHeight(src_pix);
+  if (*target_height == 0) {
+    *target_height = std::min(input_height, max_height);
+  }
+  *im_factor = static_cast<float>(*target_height) / input_height;
+  return pixScale(src_pix, *im_factor, *im_factor);
+}
+
+// Returns the size and depth of pix, with the FNV-1a hash and an independent
+// multiply-rotate hash of them and of the pixels, leaving out the padding
+// bits at the end of each line, which may be anything.
+static ImageFingerprint HashPix(Pix* pix) {
+  const uint64_t kPrime = 1099511628211ull;
+  const uint64_t kCheckMultiplier = 0x9e3779b97f4a7c15ull;
+  uint64_t hash = 14695981039346656037ull;
+  uint64_t check = 0;
+  auto add = [&hash, &check](uint32_t value) {
+    for (int b = 0; b < 4; ++b) {
+      hash = (hash ^ ((value >> (8 * b)) & 0xff)) * kPrime;
+    }
+    check = ((check << 27) | (check >> 37)) ^ value;
+    check *= kCheckMultiplier;
+  };
+  ImageFingerprint fingerprint;
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  int depth = pixGetDepth(pix);
+  add(width);
+  add(height);
+  add(depth);
+  int64_t line_bits = static_cast<int64_t>(width) * depth;
+  int full_words = line_bits / 32;
+  int last_bits = line_bits % 32;
+  // Pixels are in the high bits of each word first.
+  uint32_t last_mask = last_bits > 0 ? ~0u << (32 - last_bits) : 0;
+  const l_uint32* data = pixGetData(pix);
+  int wpl = pixGetWpl(pix);
+  for (int y = 0; y < height; ++y, data += wpl) {
+    for (int w = 0; w < full_words; ++w) add(data[w]);
+    if (last_bits > 0) add(data[full_words] & last_mask);
+  }
+  fingerprint.width = width;
+  fingerprint.height = height;
+  fingerprint.depth = depth;
+  fingerprint.hash = hash;
+  fingerprint.check = check;
+  return fingerprint;
+}
+
+uint64_t ImageData::ContentHash() const {
+  return Fingerprint().hash;
+}
+
+ImageFingerprint ImageData::Fingerprint() const {
+  {
+    SVAutoLock lock(&pix_mutex_);
+    if (decoded_pix_ != nullptr) return HashPix(decoded_pix_);
+  }
+  Pix* pix = GetPixInternal(image_data_);
+  if (pix == nullptr) return ImageFingerprint();
+  ImageFingerprint fingerprint = HashPix(pix);
+  pixDestroy(&pix);
+  return fingerprint;
+}
+
 // Gets anything and everything with a non-nullptr pointer, prescaled to a
 // given target_height (if 0, then the original image height), and aligned.
 // Also returns (if not nullptr) the width and height of the scaled image.
@@ -230,27 +369,35 @@ Pix* ImageData::PreScale(int target_height, int max_height, float* scale_factor,
                          GenericVector<TBOX>* boxes) const {
   int input_width = 0;
   int input_height = 0;
-  Pix* src_pix = GetPix();
-  ASSERT_HOST(src_pix != nullptr);
-  input_width = pixGetWidth(src_pix);
-  input_height = pixGetHeight(src_pix);
-  if (target_height == 0) {
-    target_height = std::min(input_height, max_height);
-  }
-  float im_factor = static_cast<float>(target_height) / input_height;
-  if (scaled_width != nullptr)
-    *scaled_width = IntCastRounded(im_factor * input_width);
-  if (scaled_height != nullptr)
-    *scaled_height = target_height;
-  // Get the scaled image.
-  Pix* pix = pixScale(src_pix, im_factor, im_factor);
+  float im_factor = 1.0f;
+  Pix* pix = nullptr;
+  bool scaled = false;
+  {
+    // The decoded image is only read, so it is scaled without copying it
+    // first, under the lock that keeps ForgetDecoded off it meanwhile.
+    SVAutoLock lock(&pix_mutex_);
+    if (decoded_pix_ != nullptr) {
+      pix = ScaleToHeight(decoded_pix_, max_height, &target_height,
+                          &im_factor);
+      input_width = pixGetWidth(decoded_pix_);
+      input_height = pixGetHeight(decoded_pix_);
+      scaled = true;
+    }
+  }
+  if (!scaled) {
+    Pix* src_pix = GetPixInternal(image_data_);
+    ASSERT_HOST(src_pix != nullptr);
+    pix = ScaleToHeight(src_pix, max_height, &target_height, &im_factor);
+    input_width = pixGetWidth(src_pix);
+    input_height = pixGetHeight(src_pix);
+    pixDestroy(&src_pix);
+  }
   if (pix == nullptr) {
     tprintf("Scaling pix of size %d, %d by factor %g made null pix!!\n",
             input_width, input_height, im_factor);
   }
   if (scaled_width != nullptr) *scaled_width = pixGetWidth(pix);
   if (scaled_height != nullptr) *scaled_height = pixGetHeight(pix);
-  pixDestroy(&src_pix);
   if (boxes != nullptr) {
     // Get the boxes.
     boxes->truncate(0);
@@ -373,6 +520,136 @@ bool ImageData::AddBoxes(const char* box_text) {
   return false;
 }
 
+// Gives access to the bytes of an lstmf file. Without a reader, the file is
+// kept open and only the parts that are asked for are read from it, so the
+// pages of an indexed document can be read without reading all of it.
+// A custom reader can only read the whole file, which is then kept in memory.
+class DocumentFile {
+ public:
+  DocumentFile() : fp_(nullptr) {}
+  ~DocumentFile() {
+    if (fp_ != nullptr) fclose(fp_);
+  }
+
+  // Opens the given file with the given reader. Returns false on error.
+  bool Open(const STRING& filename, FileReader reader) {
+    if (reader != nullptr) return (*reader)(filename, &data_);
+    fp_ = fopen(filename.string(), "rb");
+    return fp_ != nullptr;
+  }
+  // Reads size bytes starting at offset into buffer. Returns false on error.
+  bool Read(int64_t offset, int64_t size, GenericVector<char>* buffer) {
+    if (offset < 0 || size < 0 || size > INT32_MAX) return false;
+    buffer->resize_no_init(size);
+    if (size == 0) return true;
+    if (fp_ == nullptr) {
+      if (offset + size > data_.size()) return false;
+      memcpy(&(*buffer)[0], &data_[offset], size);
+      return true;
+    }
+    return fseek(fp_, offset, SEEK_SET) == 0 &&
+           static_cast<int64_t>(fread(&(*buffer)[0], 1, size, fp_)) == size;
+  }
+  // Opens fp on the whole file. Returns false on error.
+  bool OpenAll(TFile* fp) {
+    if (fp_ == nullptr) {
+      fp->OpenNoCopy(&data_);
+      return true;
+    }
+    return fseek(fp_, 0, SEEK_SET) == 0 && fp->Open(fp_, -1);
+  }
+
+ private:
+  FILE* fp_;
+  GenericVector<char> data_;
+};
+
+// Reads the header of the given file and sets indexed to whether it is an
+// indexed document. If so, offsets is filled with the file offset of each
+// page, plus the end of the last page. Returns false on error.
+static bool ReadDocumentIndex(DocumentFile* file, bool* indexed,
+                              std::vector<int64_t>* offsets) {
+  const int kHeaderSize = 3 * sizeof(int32_t);
+  GenericVector<char> buffer;
+  *indexed = false;
+  // A plain document may be shorter than the header, so that is not an error.
+  if (!file->Read(0, sizeof(int32_t), &buffer)) return false;
+  TFile fp;
+  int32_t marker;
+  if (!fp.Open(&buffer[0], buffer.size()) || !fp.DeSerialize(&marker)) {
+    return false;
+  }
+  if (marker != kIndexedDocumentMarker) return true;
+  *indexed = true;
+  int32_t version, num_pages;
+  if (!file->Read(0, kHeaderSize, &buffer) ||
+      !fp.Open(&buffer[0], buffer.size()) || !fp.Skip(sizeof(marker)) ||
+      !fp.DeSerialize(&version) || !fp.DeSerialize(&num_pages)) {
+    return false;
+  }
+  if (version != kIndexedDocumentVersion || num_pages < 0) {
+    tprintf("Unsupported indexed document version %d with %d pages\n",
+            version, num_pages);
+    return false;
+  }
+  offsets->resize(num_pages + 1);
+  if (!file->Read(kHeaderSize, offsets->size() * sizeof(int64_t), &buffer) ||
+      !fp.Open(&buffer[0], buffer.size()) ||
+      !fp.DeSerialize(&(*offsets)[0], offsets->size())) {
+    return false;
+  }
+  for (int i = 0; i < num_pages; ++i) {
+    if ((*offsets)[i] > (*offsets)[i + 1]) return false;
+  }
+  return true;
+}
+
+// Reads the page with the given index of an indexed document, using the
+// offsets from ReadDocumentIndex. Returns nullptr on error. The caller takes
+// ownership.
+static ImageData* ReadIndexedPage(DocumentFile* file,
+                                  const std::vector<int64_t>& offsets,
+                                  int index) {
+  GenericVector<char> buffer;
+  TFile fp;
+  int8_t flags;
+  uint32_t raw_size;
+  const int kPageHeaderSize = sizeof(flags) + sizeof(raw_size);
+  int64_t size = offsets[index + 1] - offsets[index];
+  if (size < kPageHeaderSize ||
+      !file->Read(offsets[index], size, &buffer) ||
+      !fp.Open(&buffer[0], buffer.size()) || !fp.DeSerialize(&flags) ||
+      !fp.DeSerialize(&raw_size)) {
+    tprintf("Failed to read page %d of indexed document\n", index);
+    return nullptr;
+  }
+  const auto* data = reinterpret_cast<const l_uint8*>(&buffer[0]) +
+                     kPageHeaderSize;
+  size -= kPageHeaderSize;
+  l_uint8* uncompressed = nullptr;
+  if (flags & kPageCompressed) {
+    size_t uncompressed_size = 0;
+    uncompressed = zlibUncompress(data, size, &uncompressed_size);
+    if (uncompressed == nullptr || uncompressed_size != raw_size) {
+      tprintf("Failed to uncompress page %d of indexed document\n", index);
+      lept_free(uncompressed);
+      return nullptr;
+    }
+    data = uncompressed;
+    size = uncompressed_size;
+  }
+  auto* page = new ImageData;
+  bool ok = fp.Open(reinterpret_cast<const char*>(data), size) &&
+            page->DeSerialize(&fp);
+  lept_free(uncompressed);
+  if (!ok) {
+    tprintf("Failed to deserialize page %d of indexed document\n", index);
+    delete page;
+    return nullptr;
+  }
+  return page;
+}
+
 // Thread function to call ReCachePages.
 void* ReCachePagesFunc(void* data) {
   auto* document_data = static_cast<DocumentData*>(data);
@@ -386,10 +663,12 @@ DocumentData::DocumentData(const STRING& name)
       total_pages_(-1),
       memory_used_(0),
       max_memory_(0),
-      reader_(nullptr) {}
+      reader_(nullptr),
+      num_predecoding_(0) {}
 
 DocumentData::~DocumentData() {
   SVAutoLock lock_p(&pages_mutex_);
+  WaitForPredecodes();
   SVAutoLock lock_g(&general_mutex_);
 }
 
@@ -424,6 +703,66 @@ bool DocumentData::SaveDocument(const char* filename, FileWriter writer) {
   }
   return true;
 }
+
+// Writes all the pages to the given filename as an indexed document, in which
+// each page can be found without reading the ones before it. If compress, the
+// pages are compressed with zlib, where that makes them smaller.
+// Returns false on error.
+bool DocumentData::SaveIndexedDocument(const char* filename, bool compress,
+                                       FileWriter writer) {
+  SVAutoLock lock(&pages_mutex_);
+  int32_t num_pages = pages_.size();
+  const int64_t header_size =
+      3 * sizeof(int32_t) + (num_pages + 1) * sizeof(int64_t);
+  std::vector<int64_t> offsets;
+  GenericVector<char> body;
+  TFile body_fp;
+  body_fp.OpenWrite(&body);
+  for (int p = 0; p < num_pages; ++p) {
+    GenericVector<char> page_data;
+    TFile page_fp;
+    page_fp.OpenWrite(&page_data);
+    if (!pages_[p]->Serialize(&page_fp)) {
+      tprintf("Serialize failed: %s page %d\n", filename, p);
+      return false;
+    }
+    int8_t flags = 0;
+    uint32_t raw_size = page_data.size();
+    const auto* data = reinterpret_cast<const l_uint8*>(&page_data[0]);
+    size_t size = page_data.size();
+    l_uint8* compressed = nullptr;
+    if (compress && size > 0) {
+      size_t compressed_size = 0;
+      compressed = zlibCompress(data, size, &compressed_size);
+      if (compressed != nullptr && compressed_size < size) {
+        flags |= kPageCompressed;
+        data = compressed;
+        size = compressed_size;
+      }
+    }
+    offsets.push_back(header_size + body.size());
+    bool ok = body_fp.Serialize(&flags) && body_fp.Serialize(&raw_size) &&
+              body_fp.FWrite(data, 1, size) == static_cast<int>(size);
+    lept_free(compressed);
+    if (!ok) {
+      tprintf("Serialize failed: %s page %d\n", filename, p);
+      return false;
+    }
+  }
+  offsets.push_back(header_size + body.size());
+  TFile fp;
+  fp.OpenWrite(nullptr);
+  if (!fp.Serialize(&kIndexedDocumentMarker) ||
+      !fp.Serialize(&kIndexedDocumentVersion) || !fp.Serialize(&num_pages) ||
+      !fp.Serialize(&offsets[0], offsets.size()) ||
+      (!body.empty() &&
+       fp.FWrite(&body[0], 1, body.size()) != body.size()) ||
+      !fp.CloseWrite(filename, writer)) {
+    tprintf("Serialize failed: %s\n", filename);
+    return false;
+  }
+  return true;
+}
 bool DocumentData::SaveToBuffer(GenericVector<char>* buffer) {
   SVAutoLock lock(&pages_mutex_);
   TFile fp;
@@ -446,6 +785,7 @@ void DocumentData::LoadPageInBackground(int index) {
   SVAutoLock lock(&pages_mutex_);
   if (pages_offset_ == index) return;
   pages_offset_ = index;
+  WaitForPredecodes();
   pages_.clear();
   SVSync::StartThread(ReCachePagesFunc, this);
 }
@@ -495,6 +835,7 @@ bool DocumentData::IsPageAvailable(int index, ImageData** page) {
 // the document metadata.
 int64_t DocumentData::UnCache() {
   SVAutoLock lock(&pages_mutex_);
+  WaitForPredecodes();
   int64_t memory_saved = memory_used();
   pages_.clear();
   pages_offset_ = -1;
@@ -520,42 +861,112 @@ void DocumentData::Shuffle() {
   }
 }
 
+// Predecodes the page with the given index, modulo the total number of
+// pages, if it is loaded, without waiting for it to be, or for a background
+// load. Called on a prefetch thread.
+void DocumentData::PredecodePage(int index) {
+  ImageData* page;
+  {
+    SVAutoLock lock(&pages_mutex_);
+    page = LoadedPage(index);
+    if (page == nullptr || page->IsDecoded()) return;
+    // The page can't be deleted until the count is back down.
+    std::lock_guard<std::mutex> count_lock(predecode_mutex_);
+    ++num_predecoding_;
+  }
+  page->Predecode();
+  std::lock_guard<std::mutex> count_lock(predecode_mutex_);
+  --num_predecoding_;
+  predecoded_.notify_all();
+}
+
+// Frees the image of the page with the given index kept by PredecodePage.
+void DocumentData::ForgetDecodedPage(int index) {
+  SVAutoLock lock(&pages_mutex_);
+  ImageData* page = LoadedPage(index);
+  if (page != nullptr) page->ForgetDecoded();
+}
+
+// Returns the page with the given index, modulo the total number of pages,
+// if it is loaded, or nullptr. The caller must hold pages_mutex_.
+ImageData* DocumentData::LoadedPage(int index) {
+  int num_pages = NumPages();
+  if (num_pages <= 0 || index < 0) return nullptr;
+  index = Modulo(index, num_pages);
+  if (index < pages_offset_ || index >= pages_offset_ + pages_.size()) {
+    return nullptr;
+  }
+  return pages_[index - pages_offset_];
+}
+
+// Waits for any PredecodePage to finish with the pages, before they are
+// deleted. The caller must hold pages_mutex_.
+void DocumentData::WaitForPredecodes() {
+  std::unique_lock<std::mutex> count_lock(predecode_mutex_);
+  predecoded_.wait(count_lock, [this] { return num_predecoding_ == 0; });
+}
+
 // Locks the pages_mutex_ and Loads as many pages can fit in max_memory_
 // starting at index pages_offset_.
 bool DocumentData::ReCachePages() {
   SVAutoLock lock(&pages_mutex_);
+  WaitForPredecodes();
   // Read the file.
   set_total_pages(0);
   set_memory_used(0);
   int loaded_pages = 0;
   pages_.truncate(0);
+  DocumentFile file;
+  bool indexed = false;
+  std::vector<int64_t> offsets;
+  if (!file.Open(document_name_, reader_) ||
+      !ReadDocumentIndex(&file, &indexed, &offsets)) {
+    tprintf("Deserialize header failed: %s\n", document_name_.string());
+    return false;
+  }
   TFile fp;
-  if (!fp.Open(document_name_, reader_) ||
-      !PointerVector<ImageData>::DeSerializeSize(&fp, &loaded_pages) ||
-      loaded_pages <= 0) {
+  if (indexed) {
+    loaded_pages = offsets.size() - 1;
+  } else if (!file.OpenAll(&fp) ||
+             !PointerVector<ImageData>::DeSerializeSize(&fp, &loaded_pages)) {
+    loaded_pages = 0;
+  }
+  if (loaded_pages <= 0) {
     tprintf("Deserialize header failed: %s\n", document_name_.string());
     return false;
   }
   pages_offset_ %= loaded_pages;
   // Skip pages before the first one we want, and load the rest until max
-  // memory and skip the rest after that.
+  // memory and skip the rest after that. The pages of an indexed document
+  // that are skipped are not even read.
   int page;
   for (page = 0; page < loaded_pages; ++page) {
-    if (page < pages_offset_ ||
-        (max_memory_ > 0 && memory_used() > max_memory_)) {
+    bool wanted = page >= pages_offset_ &&
+                  (max_memory_ <= 0 || memory_used() <= max_memory_);
+    if (indexed) {
+      if (!wanted) {
+        if (page < pages_offset_) continue;
+        page = loaded_pages;
+        break;
+      }
+      ImageData* image_data = ReadIndexedPage(&file, offsets, page);
+      if (image_data == nullptr) break;
+      pages_.push_back(image_data);
+    } else if (!wanted) {
       if (!PointerVector<ImageData>::DeSerializeSkip(&fp)) {
         tprintf("Deserializeskip failed\n");
         break;
       }
-    } else {
-      if (!pages_.DeSerializeElement(&fp)) break;
-      ImageData* image_data = pages_.back();
-      if (image_data->imagefilename().length() == 0) {
-        image_data->set_imagefilename(document_name_);
-        image_data->set_page_number(page);
-      }
-      set_memory_used(memory_used() + image_data->MemoryUsed());
+      continue;
+    } else if (!pages_.DeSerializeElement(&fp)) {
+      break;
     }
+    ImageData* image_data = pages_.back();
+    if (image_data->imagefilename().length() == 0) {
+      image_data->set_imagefilename(document_name_);
+      image_data->set_page_number(page);
+    }
+    set_memory_used(memory_used() + image_data->MemoryUsed());
   }
   if (page < loaded_pages) {
     tprintf("Deserialize failed: %s read %d/%d lines\n",
@@ -570,10 +981,172 @@ bool DocumentData::ReCachePages() {
   return !pages_.empty();
 }
 
+// Reads the page with the given index, modulo the number of pages in the
+// file, straight from the file, without caching it, and returns it, or
+// nullptr in case of error. The caller takes ownership. The pages of an
+// indexed document are read by seeking to them. Otherwise all the pages
+// before it have to be read and skipped.
+ImageData* DocumentData::ReadPage(int index) const {
+  STRING name = document_name();
+  DocumentFile file;
+  bool indexed = false;
+  std::vector<int64_t> offsets;
+  if (!file.Open(name, reader_) ||
+      !ReadDocumentIndex(&file, &indexed, &offsets)) {
+    return nullptr;
+  }
+  ImageData* page = nullptr;
+  if (indexed) {
+    int num_pages = offsets.size() - 1;
+    if (num_pages <= 0) return nullptr;
+    index = Modulo(index, num_pages);
+    page = ReadIndexedPage(&file, offsets, index);
+  } else {
+    TFile fp;
+    int32_t num_pages;
+    if (!file.OpenAll(&fp) ||
+        !PointerVector<ImageData>::DeSerializeSize(&fp, &num_pages) ||
+        num_pages <= 0) {
+      return nullptr;
+    }
+    index = Modulo(index, num_pages);
+    for (int p = 0; p < index; ++p) {
+      if (!PointerVector<ImageData>::DeSerializeSkip(&fp)) return nullptr;
+    }
+    PointerVector<ImageData> pages;
+    if (!pages.DeSerializeElement(&fp) || pages.empty() ||
+        pages[0] == nullptr) {
+      return nullptr;
+    }
+    page = pages[0];
+    pages[0] = nullptr;
+  }
+  if (page != nullptr && page->imagefilename().length() == 0) {
+    page->set_imagefilename(name);
+    page->set_page_number(index);
+  }
+  return page;
+}
+
 // A collection of DocumentData that knows roughly how much memory it is using.
 DocumentCache::DocumentCache(int64_t max_memory)
-    : num_pages_per_doc_(0), max_memory_(max_memory) {}
-DocumentCache::~DocumentCache() {}
+    : num_pages_per_doc_(0),
+      max_memory_(max_memory),
+      prefetch_pages_(0),
+      last_serial_(-1),
+      next_prefetch_(0),
+      stop_prefetch_(false) {}
+DocumentCache::~DocumentCache() {
+  StopPrefetch();
+}
+
+// Returns a page by serial number using the current cache_strategy_ to
+// determine the mapping from serial number to page.
+const ImageData* DocumentCache::GetPageBySerial(int serial) {
+  const ImageData* page = cache_strategy_ == CS_SEQUENTIAL
+                              ? GetPageSequential(serial)
+                              : GetPageRoundRobin(serial);
+  if (!prefetch_threads_.empty()) Prefetch(serial);
+  return page;
+}
+
+// Starts num_threads background threads, which decode the images of up to
+// num_pages pages ahead of the last one returned by GetPageBySerial, so the
+// caller doesn't have to wait for them. Only the pages of documents that are
+// already loaded are decoded, and the images of the pages behind are freed.
+void DocumentCache::StartPrefetch(int num_pages, int num_threads) {
+  StopPrefetch();
+  if (num_pages <= 0 || num_threads <= 0) return;
+  prefetch_pages_ = num_pages;
+  last_serial_ = -1;
+  next_prefetch_ = 0;
+  stop_prefetch_ = false;
+  for (int t = 0; t < num_threads; ++t) {
+    prefetch_threads_.push_back(std::thread(&DocumentCache::RunPrefetch, this));
+  }
+}
+
+// Stops the prefetch threads.
+void DocumentCache::StopPrefetch() {
+  if (prefetch_threads_.empty()) return;
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    stop_prefetch_ = true;
+    prefetch_queue_.clear();
+  }
+  prefetch_queued_.notify_all();
+  for (auto& thread : prefetch_threads_) thread.join();
+  prefetch_threads_.clear();
+  // Free the images of the pages that were decoded ahead.
+  for (int serial = last_serial_; serial >= 0 && serial < next_prefetch_;
+       ++serial) {
+    int doc_index, page_index;
+    if (PageOfSerial(serial, &doc_index, &page_index)) {
+      documents_[doc_index]->ForgetDecodedPage(page_index);
+    }
+  }
+  last_serial_ = -1;
+}
+
+// Sets the document and page index within it of the page with the given
+// serial number. Returns false if that isn't known yet.
+bool DocumentCache::PageOfSerial(int serial, int* doc_index,
+                                 int* page_index) const {
+  int num_docs = documents_.size();
+  if (num_docs == 0) return false;
+  if (cache_strategy_ == CS_SEQUENTIAL) {
+    if (num_pages_per_doc_ == 0) return false;
+    *doc_index = serial / num_pages_per_doc_ % num_docs;
+    *page_index = serial % num_pages_per_doc_;
+  } else {
+    *doc_index = serial % num_docs;
+    *page_index = serial / num_docs;
+  }
+  return true;
+}
+
+// Queues the pages ahead of serial for the prefetch threads, and frees the
+// image of the previous page.
+void DocumentCache::Prefetch(int serial) {
+  int doc_index, page_index;
+  if (last_serial_ >= 0 && last_serial_ != serial &&
+      PageOfSerial(last_serial_, &doc_index, &page_index)) {
+    documents_[doc_index]->ForgetDecodedPage(page_index);
+  }
+  last_serial_ = serial;
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    // After a seek, anything still queued is of no use.
+    if (next_prefetch_ <= serial ||
+        next_prefetch_ > serial + prefetch_pages_ + 1) {
+      prefetch_queue_.clear();
+      next_prefetch_ = serial + 1;
+    }
+    while (next_prefetch_ <= serial + prefetch_pages_) {
+      prefetch_queue_.push_back(next_prefetch_++);
+    }
+  }
+  prefetch_queued_.notify_all();
+}
+
+// Predecodes the queued pages until StopPrefetch.
+void DocumentCache::RunPrefetch() {
+  for (;;) {
+    int serial;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_mutex_);
+      prefetch_queued_.wait(
+          lock, [this] { return stop_prefetch_ || !prefetch_queue_.empty(); });
+      if (stop_prefetch_) return;
+      serial = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+    }
+    int doc_index, page_index;
+    if (PageOfSerial(serial, &doc_index, &page_index)) {
+      documents_[doc_index]->PredecodePage(page_index);
+    }
+  }
+}
 
 // Adds all the documents in the list of filenames, counting memory.
 // The reader is used to read the files.
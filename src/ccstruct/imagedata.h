@@ -20,6 +20,12 @@
 #ifndef TESSERACT_IMAGE_IMAGEDATA_H_
 #define TESSERACT_IMAGE_IMAGEDATA_H_
 
+#include <condition_variable>   // for std::condition_variable
+#include <cstdint>              // for uint64_t
+#include <deque>                // for std::deque
+#include <mutex>                // for std::mutex
+#include <thread>               // for std::thread
+#include <vector>               // for std::vector
 #include "genericvector.h"      // for GenericVector, PointerVector, FileReader
 #include "points.h"             // for FCOORD
 #include "strngs.h"             // for STRING
@@ -97,6 +103,24 @@ struct FloatWordFeature {
   int x_bucket;
 };
 
+// Identifies the pixels of an image for caches that key on them: the size
+// and two independent hashes, so a key that matches by chance is caught.
+struct ImageFingerprint {
+  int width = 0;
+  int height = 0;
+  int depth = 0;
+  uint64_t hash = 0;   // FNV-1a, as returned by ImageData::ContentHash.
+  uint64_t check = 0;  // Multiply-rotate hash of the same words.
+
+  bool operator==(const ImageFingerprint& other) const {
+    return width == other.width && height == other.height &&
+           depth == other.depth && hash == other.hash && check == other.check;
+  }
+  bool operator!=(const ImageFingerprint& other) const {
+    return !(*this == other);
+  }
+};
+
 // Class to hold information on a single image:
 // Filename, cached image as a Pix*, character boxes, text transcription.
 // The text transcription is the ground truth UTF-8 text for the image.
@@ -105,8 +129,11 @@ struct FloatWordFeature {
 class ImageData {
  public:
   ImageData();
-  // Takes ownership of the pix.
-  ImageData(bool vertical, Pix* pix);
+  // Takes ownership of the pix. If keep_decoded, the pix is kept as it is,
+  // as by Predecode, instead of being encoded, which saves encoding and
+  // decoding an image that is only to be recognized. It is encoded only if
+  // serialized, and must not be forgotten with ForgetDecoded.
+  ImageData(bool vertical, Pix* pix, bool keep_decoded = false);
   ~ImageData();
 
   // Builds and returns an ImageData from the basic data. Note that imagedata,
@@ -121,6 +148,9 @@ class ImageData {
   bool DeSerialize(TFile* fp);
   // As DeSerialize, but only seeks past the data - hence a static method.
   static bool SkipDeSerialize(TFile* fp);
+  // Returns a deep copy of *this, or nullptr in case of error. The caller
+  // takes ownership. The decoded image cache is not copied.
+  ImageData* Copy() const;
 
   // Other accessors.
   const STRING& imagefilename() const {
@@ -162,6 +192,19 @@ class ImageData {
   void SetPix(Pix* pix);
   // Returns the Pix image for *this. Must be pixDestroyed after use.
   Pix* GetPix() const;
+  // Decodes the image now and keeps it, so that GetPix only has to copy it.
+  // May be called on another thread while *this is being used.
+  void Predecode();
+  // Frees the image kept by Predecode.
+  void ForgetDecoded();
+  // Returns true if the image has been kept by Predecode.
+  bool IsDecoded() const;
+  // Returns a hash of the size and pixels of the image, which is the same
+  // for all images with the same pixels, however they are held.
+  uint64_t ContentHash() const;
+  // Returns the size and two hashes of the pixels, of which the first is
+  // ContentHash. All zero if there is no image.
+  ImageFingerprint Fingerprint() const;
   // Gets anything and everything with a non-nullptr pointer, prescaled to a
   // given target_height (if 0, then the original image height), and aligned.
   // Also returns (if not nullptr) the width and height of the scaled image.
@@ -203,6 +246,10 @@ class ImageData {
   GenericVector<TBOX> boxes_;        // If non-empty boxes of the image.
   GenericVector<STRING> box_texts_;  // String for text in each box.
   bool vertical_text_;               // Image has been rotated from vertical.
+  // Image decoded ahead of use by Predecode, or nullptr.
+  Pix* decoded_pix_;
+  // Protects decoded_pix_.
+  mutable SVMutex pix_mutex_;
 };
 
 // A collection of ImageData that knows roughly how much memory it is using.
@@ -221,6 +268,11 @@ class DocumentData {
   void SetDocument(const char* filename, int64_t max_memory, FileReader reader);
   // Writes all the pages to the given filename. Returns false on error.
   bool SaveDocument(const char* filename, FileWriter writer);
+  // Writes all the pages to the given filename as an indexed document, whose
+  // pages can be read without reading the whole file, optionally compressed.
+  // Both formats are read by LoadDocument. Returns false on error.
+  bool SaveIndexedDocument(const char* filename, bool compress,
+                           FileWriter writer);
   bool SaveToBuffer(GenericVector<char>* buffer);
 
   // Adds the given page data to this document, counting up memory.
@@ -272,8 +324,25 @@ class DocumentData {
   int64_t UnCache();
   // Shuffles all the pages in the document.
   void Shuffle();
+  // Predecodes the page with the given index, modulo the total number of
+  // pages, if it is loaded, without waiting for it to be, or for a
+  // background load. Called on a prefetch thread.
+  void PredecodePage(int index);
+  // Frees the image of the page with the given index kept by PredecodePage.
+  void ForgetDecodedPage(int index);
+  // Reads the page with the given index, modulo the number of pages in the
+  // file, straight from the file, bypassing the cache. Pages of an indexed
+  // document are found without reading the others. Returns nullptr on error.
+  // The caller takes ownership.
+  ImageData* ReadPage(int index) const;
 
  private:
+  // Returns the page with the given index, modulo the total number of pages,
+  // if it is loaded, or nullptr. The caller must hold pages_mutex_.
+  ImageData* LoadedPage(int index);
+  // Waits for any PredecodePage to finish with the pages, before they are
+  // deleted. The caller must hold pages_mutex_.
+  void WaitForPredecodes();
   // Sets the value of total_pages_ behind a mutex.
   void set_total_pages(int total) {
     SVAutoLock lock(&general_mutex_);
@@ -308,6 +377,11 @@ class DocumentData {
   // Mutex that protects other data members that callers want to access without
   // waiting for a load operation.
   mutable SVMutex general_mutex_;
+  // Number of pages being decoded by PredecodePage, which runs without the
+  // pages_mutex_, so it doesn't hold up GetPage.
+  int num_predecoding_;
+  std::mutex predecode_mutex_;
+  std::condition_variable predecoded_;
 };
 
 // A collection of DocumentData that knows roughly how much memory it is using.
@@ -322,6 +396,7 @@ class DocumentCache {
 
   // Deletes all existing documents from the cache.
   void Clear() {
+    StopPrefetch();
     documents_.clear();
     num_pages_per_doc_ = 0;
   }
@@ -338,12 +413,15 @@ class DocumentCache {
 
   // Returns a page by serial number using the current cache_strategy_ to
   // determine the mapping from serial number to page.
-  const ImageData* GetPageBySerial(int serial) {
-    if (cache_strategy_ == CS_SEQUENTIAL)
-      return GetPageSequential(serial);
-    else
-      return GetPageRoundRobin(serial);
-  }
+  const ImageData* GetPageBySerial(int serial);
+
+  // Starts num_threads background threads, which decode the images of up to
+  // num_pages pages ahead of the last one returned by GetPageBySerial, so the
+  // caller doesn't have to wait for them. Only the pages of documents that are
+  // already loaded are decoded, and the images of the pages behind are freed.
+  void StartPrefetch(int num_pages, int num_threads);
+  // Stops the prefetch threads.
+  void StopPrefetch();
 
   const PointerVector<DocumentData>& documents() const {
     return documents_;
@@ -365,6 +443,14 @@ class DocumentCache {
   // Helper counts the number of adjacent cached neighbour documents_ of index
   // looking in direction dir, ie index+dir, index+2*dir etc.
   int CountNeighbourDocs(int index, int dir);
+  // Sets the document and page index within it of the page with the given
+  // serial number. Returns false if that isn't known yet.
+  bool PageOfSerial(int serial, int* doc_index, int* page_index) const;
+  // Queues the pages ahead of serial for the prefetch threads, and frees the
+  // image of the previous page.
+  void Prefetch(int serial);
+  // Predecodes the queued pages until StopPrefetch.
+  void RunPrefetch();
 
   // A group of pages that corresponds in some loose way to a document.
   PointerVector<DocumentData> documents_;
@@ -375,6 +461,17 @@ class DocumentCache {
   int num_pages_per_doc_;
   // Max memory allowed in this cache.
   int64_t max_memory_;
+  // Number of pages ahead of the last one returned to prefetch.
+  int prefetch_pages_;
+  // Serial number of the last page returned while prefetching, or -1.
+  int last_serial_;
+  // Serial number after the last page queued for prefetch.
+  int next_prefetch_;
+  std::deque<int> prefetch_queue_;
+  std::vector<std::thread> prefetch_threads_;
+  bool stop_prefetch_;
+  std::mutex prefetch_mutex_;
+  std::condition_variable prefetch_queued_;
 };
 
 }  // namespace tesseract
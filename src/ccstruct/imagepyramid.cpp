@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////
+// File:        imagepyramid.cpp
+// Description: Cache of the reductions of a binary page image.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "imagepyramid.h"
+
+#include "allheaders.h"  // for pixReduceRankBinary2, pixClone, pixDestroy
+#include "errcode.h"     // for ASSERT_HOST
+
+namespace tesseract {
+
+ImagePyramid::ImagePyramid() : source_(nullptr) {
+  for (auto& level : levels_) level = nullptr;
+}
+
+ImagePyramid::~ImagePyramid() {
+  Reset(nullptr);
+}
+
+void ImagePyramid::Reset(Pix* pix) {
+  Invalidate();
+  pixDestroy(&source_);
+  if (pix != nullptr) source_ = pixClone(pix);
+}
+
+void ImagePyramid::Invalidate() {
+  for (auto& level : levels_) pixDestroy(&level);
+}
+
+Pix* ImagePyramid::GetReduction(Pix* pix, int factor) {
+  ASSERT_HOST(pix != nullptr);
+  if (pix != source_) Reset(pix);
+  if (factor <= 1) return pixClone(source_);
+  int num_levels = 0;
+  while ((2 << num_levels) < factor) ++num_levels;
+  ASSERT_HOST((2 << num_levels) == factor && num_levels < kMaxPyramidLevels);
+  Pix* prev = source_;
+  for (int i = 0; i <= num_levels; ++i) {
+    if (levels_[i] == nullptr) {
+      levels_[i] = pixReduceRankBinary2(prev, 1, nullptr);
+      if (levels_[i] == nullptr) return nullptr;
+    }
+    prev = levels_[i];
+  }
+  return pixClone(prev);
+}
+
+}  // namespace tesseract
@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////
+// File:        imagepyramid.h
+// Description: Cache of the reductions of a binary page image.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCSTRUCT_IMAGEPYRAMID_H_
+#define TESSERACT_CCSTRUCT_IMAGEPYRAMID_H_
+
+struct Pix;
+
+namespace tesseract {
+
+// Number of levels of reduction held, the last being a reduction by 2^4.
+const int kMaxPyramidLevels = 4;
+
+// Lazily built rank 1 reductions by 2, 4, 8 and 16 of a binary page image,
+// so that the layout stages that each look at the page at a lower resolution
+// (blank page detection, line finding, image finding, fast OSD) share the
+// reductions instead of each making its own. Rank 1 keeps every foreground
+// pixel, so thin strokes stay connected, and each level is made from the
+// one above it exactly as pixReduceRankBinaryCascade would make it.
+// The pyramid holds a reference to the source image, but can't see changes
+// to its pixels, so whoever modifies the image in place must call
+// Invalidate.
+class ImagePyramid {
+ public:
+  ImagePyramid();
+  ~ImagePyramid();
+
+  // Makes pix the source of the pyramid and discards any reductions of a
+  // previous source. pix may be nullptr to release everything.
+  void Reset(Pix* pix);
+  // Discards the reductions, but keeps the source, after the source has been
+  // modified in place.
+  void Invalidate();
+
+  // Returns a clone of the source reduced by the given factor, which must be
+  // 1 or a power of 2 up to 2^kMaxPyramidLevels, building any missing levels.
+  // If pix is not the current source, the pyramid is first Reset to it, so
+  // a pyramid passed along with an image is always consistent with it.
+  // The caller must pixDestroy the result.
+  Pix* GetReduction(Pix* pix, int factor);
+
+ private:
+  // The source image, a clone of the caller's pix.
+  Pix* source_;
+  // The reductions by 2^(i+1), or nullptr if not built yet.
+  Pix* levels_[kMaxPyramidLevels];
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CCSTRUCT_IMAGEPYRAMID_H_
@@ -32,6 +32,7 @@
 #include <cstdint>      // for int32_t
 #include <cstdio>       // for FILE
 #include <cstring>      // for memcpy
+#include <utility>      // for move, swap
 #include "errcode.h"    // for ASSERT_HOST
 #include "helpers.h"    // for ReverseN, ClipToRange
 #include "kdpair.h"     // for KDPairInc
@@ -77,6 +78,12 @@ class GENERIC_2D_ARRAY {
       size_allocated_(0) {
     *this = src;
   }
+  // Move takes the array of src, which is left empty.
+  GENERIC_2D_ARRAY(GENERIC_2D_ARRAY<T>&& src) noexcept
+    : array_(nullptr), empty_(static_cast<T>(0)), dim1_(0), dim2_(0),
+      size_allocated_(0) {
+    *this = std::move(src);
+  }
   virtual ~GENERIC_2D_ARRAY() { delete[] array_; }
 
   void operator=(const GENERIC_2D_ARRAY<T>& src) {
@@ -86,6 +93,13 @@ class GENERIC_2D_ARRAY {
       memcpy(array_, src.array_, size * sizeof(array_[0]));
     }
   }
+  void operator=(GENERIC_2D_ARRAY<T>&& src) noexcept {
+    std::swap(array_, src.array_);
+    std::swap(empty_, src.empty_);
+    std::swap(dim1_, src.dim1_);
+    std::swap(dim2_, src.dim2_);
+    std::swap(size_allocated_, src.size_allocated_);
+  }
 
   // Reallocates the array to the given size. Does not keep old data, but does
   // not initialize the array either.
@@ -104,6 +118,17 @@ class GENERIC_2D_ARRAY {
     for (int i = size1 * size2; i < new_size; ++i) array_[i] = empty_;
   }
 
+  // Reallocates the array, not keeping old data, if needed to hold at least
+  // size elements. The allocation grows by at least half each time, so that a
+  // slowly increasing size only causes a few reallocations.
+  void ReserveNoInit(int size) {
+    if (size <= size_allocated_) return;
+    size = std::max(size, size_allocated_ + size_allocated_ / 2);
+    delete [] array_;
+    array_ = new T[size];
+    size_allocated_ = size;
+  }
+
   // Reallocate the array to the given size. Does not keep old data.
   void Resize(int size1, int size2, const T& empty) {
     empty_ = empty;
@@ -179,6 +204,15 @@ class GENERIC_2D_ARRAY {
            fp->DeSerialize(&empty_) &&
            fp->DeSerialize(&array_[0], num_elements());
   }
+  // As DeSerialize, but only seeks past the data - hence a static method.
+  static bool SkipDeSerialize(tesseract::TFile* fp) {
+    int32_t size1, size2;
+    if (!fp->DeSerialize(&size1)) return false;
+    if (!fp->DeSerialize(&size2)) return false;
+    if (size1 < 0 || size1 > UINT16_MAX) return false;
+    if (size2 < 0 || size2 > UINT16_MAX) return false;
+    return fp->Skip(sizeof(T) * (1 + static_cast<size_t>(size1) * size2));
+  }
 
   // Writes to the given file. Returns false in case of error.
   // Assumes a T::Serialize(FILE*) const function.
@@ -208,6 +242,8 @@ class GENERIC_2D_ARRAY {
   // Provide the dimensions of this rectangular matrix.
   int dim1() const { return dim1_; }
   int dim2() const { return dim2_; }
+  // Returns the number of elements that fit without reallocation.
+  int size_allocated() const { return size_allocated_; }
   // Returns the number of elements in the array.
   // Banded/triangular matrices may override.
   virtual int num_elements() const { return dim1_ * dim2_; }
@@ -237,6 +237,35 @@ const BLOCK & source             //from this
   return *this;
 }
 
+/**
+ * BLOCK::deep_copy
+ *
+ * Duplicate the block structure, including the rows and blobs.
+ */
+
+BLOCK* BLOCK::deep_copy(const BLOCK* src) {
+  auto* block = new BLOCK;
+  *block = *src;
+  // Assignment leaves out the contents and the statistics of textord.
+  block->pdblk.set_index(src->pdblk.index());
+  POLY_BLOCK* poly_block = src->pdblk.poly_block();
+  if (poly_block != nullptr) {
+    ICOORDELT_LIST vertices;
+    vertices.deep_copy(poly_block->points(), &ICOORDELT::deep_copy);
+    block->pdblk.set_poly_block(new POLY_BLOCK(&vertices, poly_block->isA()));
+  }
+  block->right_to_left_ = src->right_to_left_;
+  block->pitch = src->pitch;
+  block->font_class = src->font_class;
+  block->xheight = src->xheight;
+  block->cell_over_xheight_ = src->cell_over_xheight_;
+  block->median_size_ = src->median_size_;
+  block->rows.deep_copy(&src->rows, &ROW::deep_copy);
+  block->c_blobs.deep_copy(&src->c_blobs, &C_BLOB::deep_copy);
+  block->rej_blobs.deep_copy(&src->rej_blobs, &C_BLOB::deep_copy);
+  return block;
+}
+
 // This function is for finding the approximate (horizontal) distance from
 // the x-coordinate of the left edge of a symbol to the left edge of the
 // text block which contains it.  We are passed:
@@ -188,6 +188,10 @@ class BLOCK:public ELIST_LINK
   void print(FILE* fp, bool dump);
 
   BLOCK& operator=(const BLOCK & source);
+  /// Returns a new copy of src with deep copies of its polygon, rows, words
+  /// and blobs, so that a page layout can be reused after recognition has
+  /// changed the original. The paragraphs are not copied.
+  static BLOCK* deep_copy(const BLOCK* src);
   PDBLK pdblk;                 ///< Page Description Block
 
  private:
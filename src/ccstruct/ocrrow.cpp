@@ -240,3 +240,17 @@ ROW & ROW::operator= (const ROW & source) {
   para_ = source.para_;
   return *this;
 }
+
+/**********************************************************************
+ * ROW::deep_copy
+ *
+ * Duplicate the row structure AND the WERDLIST.
+ **********************************************************************/
+
+ROW* ROW::deep_copy(const ROW* src) {
+  auto* row = new ROW;
+  *row = *src;
+  row->words.deep_copy(&src->words, &WERD::deep_copy);
+  row->para_ = nullptr;
+  return row;
+}
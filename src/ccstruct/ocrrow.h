@@ -143,6 +143,10 @@ class ROW:public ELIST_LINK
     #endif  // GRAPHICS_DISABLED
     ROW& operator= (const ROW & source);
 
+    // Returns a new copy of src with deep copies of its words. The copy is
+    // not part of any paragraph.
+    static ROW* deep_copy(const ROW* src);
+
   private:
     // Copy constructor (currently unused, therefore private).
     ROW(const ROW& source);
@@ -20,6 +20,7 @@
 #include "otsuthr.h"
 
 #include <cstring>
+#include <vector>
 #include "allheaders.h"
 #include "helpers.h"
 #if defined(USE_OPENCL)
@@ -28,6 +29,54 @@
 
 namespace tesseract {
 
+// Computes the thresholds and hi_values of num_channels channels from their
+// consecutive histograms, as described for OtsuThreshold.
+static void ThresholdHistograms(int num_channels, const int* histograms,
+                                int* thresholds, int* hi_values) {
+  // Of all channels with no good hi_value, keep the best so we can always
+  // produce at least one answer.
+  int best_hi_value = 1;
+  int best_hi_index = 0;
+  bool any_good_hivalue = false;
+  double best_hi_dist = 0.0;
+  for (int ch = 0; ch < num_channels; ++ch) {
+    thresholds[ch] = -1;
+    hi_values[ch] = -1;
+    const int* histogram = &histograms[kHistogramSize * ch];
+    int H;
+    int best_omega_0;
+    int best_t = OtsuStats(histogram, &H, &best_omega_0);
+    if (best_omega_0 == 0 || best_omega_0 == H) {
+       // This channel is empty.
+       continue;
+     }
+    // To be a convincing foreground we must have a small fraction of H
+    // or to be a convincing background we must have a large fraction of H.
+    // In between we assume this channel contains no thresholding information.
+    int hi_value = best_omega_0 < H * 0.5;
+    thresholds[ch] = best_t;
+    if (best_omega_0 > H * 0.75) {
+      any_good_hivalue = true;
+      hi_values[ch] = 0;
+    } else if (best_omega_0 < H * 0.25) {
+      any_good_hivalue = true;
+      hi_values[ch] = 1;
+    } else {
+      // In case all channels are like this, keep the best of the bad lot.
+      double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
+      if (hi_dist > best_hi_dist) {
+        best_hi_dist = hi_dist;
+        best_hi_value = hi_value;
+        best_hi_index = ch;
+      }
+    }
+  }
+  if (!any_good_hivalue) {
+    // Use the best of the ones that were not good enough.
+    hi_values[best_hi_index] = best_hi_value;
+  }
+}
+
 // Computes the Otsu threshold(s) for the given image rectangle, making one
 // for each channel. Each channel is always one byte per pixel.
 // Returns an array of threshold values and an array of hi_values, such
@@ -40,107 +89,58 @@ namespace tesseract {
 int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
                   int** thresholds, int** hi_values) {
   int num_channels = pixGetDepth(src_pix) / 8;
-  // Of all channels with no good hi_value, keep the best so we can always
-  // produce at least one answer.
-  int best_hi_value = 1;
-  int best_hi_index = 0;
-  bool any_good_hivalue = false;
-  double best_hi_dist = 0.0;
   *thresholds = new int[num_channels];
   *hi_values = new int[num_channels];
+  // All of channel 0 then all of channel 1...
+  std::vector<int> histograms(kHistogramSize * num_channels);
 
   // only use opencl if compiled w/ OpenCL and selected device is opencl
 #ifdef USE_OPENCL
-  // all of channel 0 then all of channel 1...
-  int* histogramAllChannels = new int[kHistogramSize * num_channels];
-
   // Calculate Histogram on GPU
   OpenclDevice od;
   if (od.selectedDeviceIsOpenCL() && (num_channels == 1 || num_channels == 4) &&
       top == 0 && left == 0) {
     od.HistogramRectOCL(pixGetData(src_pix), num_channels,
                         pixGetWpl(src_pix) * 4, left, top, width, height,
-                        kHistogramSize, histogramAllChannels);
-
-    // Calculate Threshold from Histogram on cpu
-    for (int ch = 0; ch < num_channels; ++ch) {
-      (*thresholds)[ch] = -1;
-      (*hi_values)[ch] = -1;
-      int *histogram = &histogramAllChannels[kHistogramSize * ch];
-      int H;
-      int best_omega_0;
-      int best_t = OtsuStats(histogram, &H, &best_omega_0);
-      if (best_omega_0 == 0 || best_omega_0 == H) {
-         // This channel is empty.
-         continue;
-       }
-      // To be a convincing foreground we must have a small fraction of H
-      // or to be a convincing background we must have a large fraction of H.
-      // In between we assume this channel contains no thresholding information.
-      int hi_value = best_omega_0 < H * 0.5;
-      (*thresholds)[ch] = best_t;
-      if (best_omega_0 > H * 0.75) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 0;
-      } else if (best_omega_0 < H * 0.25) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 1;
-      } else {
-        // In case all channels are like this, keep the best of the bad lot.
-        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
-        if (hi_dist > best_hi_dist) {
-          best_hi_dist = hi_dist;
-          best_hi_value = hi_value;
-          best_hi_index = ch;
-        }
-      }
-    }
+                        kHistogramSize, &histograms[0]);
   } else {
 #endif
-    for (int ch = 0; ch < num_channels; ++ch) {
-      (*thresholds)[ch] = -1;
-      (*hi_values)[ch] = -1;
-      // Compute the histogram of the image rectangle.
-      int histogram[kHistogramSize];
-      HistogramRect(src_pix, ch, left, top, width, height, histogram);
-      int H;
-      int best_omega_0;
-      int best_t = OtsuStats(histogram, &H, &best_omega_0);
-      if (best_omega_0 == 0 || best_omega_0 == H) {
-         // This channel is empty.
-         continue;
-       }
-      // To be a convincing foreground we must have a small fraction of H
-      // or to be a convincing background we must have a large fraction of H.
-      // In between we assume this channel contains no thresholding information.
-      int hi_value = best_omega_0 < H * 0.5;
-      (*thresholds)[ch] = best_t;
-      if (best_omega_0 > H * 0.75) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 0;
-      } else if (best_omega_0 < H * 0.25) {
-        any_good_hivalue = true;
-        (*hi_values)[ch] = 1;
-      } else {
-        // In case all channels are like this, keep the best of the bad lot.
-        double hi_dist = hi_value ? (H - best_omega_0) : best_omega_0;
-        if (hi_dist > best_hi_dist) {
-          best_hi_dist = hi_dist;
-          best_hi_value = hi_value;
-          best_hi_index = ch;
-        }
-      }
-    }
+    // Compute the histograms of the image rectangle.
+    HistogramRectAllChannels(src_pix, left, top, width, height,
+                             &histograms[0]);
 #ifdef USE_OPENCL
   }
-  delete[] histogramAllChannels;
 #endif  // USE_OPENCL
+  // Calculate the thresholds from the histograms on the cpu.
+  ThresholdHistograms(num_channels, &histograms[0], *thresholds, *hi_values);
+  return num_channels;
+}
 
-  if (!any_good_hivalue) {
-    // Use the best of the ones that were not good enough.
-    (*hi_values)[best_hi_index] = best_hi_value;
+// As OtsuThreshold above, but for a rectangle of an 8 bit grey image in a
+// buffer of bytes in plain memory order, with bytes_per_line bytes from the
+// start of one line to the next. Makes a single threshold and hi_value.
+void OtsuThreshold(const unsigned char* imagedata, int bytes_per_line,
+                   int left, int top, int width, int height,
+                   int* threshold, int* hi_value) {
+  int histogram[kHistogramSize];
+  HistogramRect(imagedata, bytes_per_line, left, top, width, height,
+                histogram);
+  ThresholdHistograms(1, histogram, threshold, hi_value);
+}
+
+// Number of histograms that consecutive pixels are counted in, so that
+// runs of equal pixels, which are most of a page, don't wait for the
+// increment of the previous pixel.
+const int kSubHistograms = 4;
+
+// Adds the sub-histograms of size kHistogramSize * num_histograms together
+// into the first num_histograms histograms.
+static void AddSubHistograms(int num_histograms, int* sub_histograms) {
+  const int size = kHistogramSize * num_histograms;
+  for (int s = 1; s < kSubHistograms; ++s) {
+    const int* sub_histogram = sub_histograms + s * size;
+    for (int i = 0; i < size; ++i) sub_histograms[i] += sub_histogram[i];
   }
-  return num_channels;
 }
 
 // Computes the histogram for the given image rectangle, and the given
@@ -153,16 +153,61 @@ void HistogramRect(Pix* src_pix, int channel,
   int num_channels = pixGetDepth(src_pix) / 8;
   channel = ClipToRange(channel, 0, num_channels - 1);
   int bottom = top + height;
-  memset(histogram, 0, sizeof(*histogram) * kHistogramSize);
+  std::vector<int> sub_histograms(kHistogramSize * kSubHistograms);
   int src_wpl = pixGetWpl(src_pix);
   l_uint32* srcdata = pixGetData(src_pix);
   for (int y = top; y < bottom; ++y) {
     const l_uint32* linedata = srcdata + y * src_wpl;
     for (int x = 0; x < width; ++x) {
       int pixel = GET_DATA_BYTE(linedata, (x + left) * num_channels + channel);
-      ++histogram[pixel];
+      ++sub_histograms[(x % kSubHistograms) * kHistogramSize + pixel];
+    }
+  }
+  AddSubHistograms(1, &sub_histograms[0]);
+  memcpy(histogram, &sub_histograms[0], sizeof(*histogram) * kHistogramSize);
+}
+
+// Computes the histograms of all the channels of the given image rectangle
+// in a single pass over the image.
+void HistogramRectAllChannels(Pix* src_pix,
+                              int left, int top, int width, int height,
+                              int* histograms) {
+  int num_channels = pixGetDepth(src_pix) / 8;
+  const int size = kHistogramSize * num_channels;
+  int bottom = top + height;
+  std::vector<int> sub_histograms(size * kSubHistograms);
+  int src_wpl = pixGetWpl(src_pix);
+  l_uint32* srcdata = pixGetData(src_pix);
+  for (int y = top; y < bottom; ++y) {
+    const l_uint32* linedata = srcdata + y * src_wpl;
+    for (int x = 0; x < width; ++x) {
+      int* sub_histogram = &sub_histograms[(x % kSubHistograms) * size];
+      int offset = (x + left) * num_channels;
+      for (int ch = 0; ch < num_channels; ++ch) {
+        int pixel = GET_DATA_BYTE(linedata, offset + ch);
+        ++sub_histogram[ch * kHistogramSize + pixel];
+      }
+    }
+  }
+  AddSubHistograms(num_channels, &sub_histograms[0]);
+  memcpy(histograms, &sub_histograms[0], sizeof(*histograms) * size);
+}
+
+// Computes the histogram of the given rectangle of an 8 bit grey image in a
+// buffer of bytes in plain memory order.
+void HistogramRect(const unsigned char* imagedata, int bytes_per_line,
+                   int left, int top, int width, int height,
+                   int* histogram) {
+  int bottom = top + height;
+  std::vector<int> sub_histograms(kHistogramSize * kSubHistograms);
+  for (int y = top; y < bottom; ++y) {
+    const unsigned char* linedata = imagedata + y * bytes_per_line + left;
+    for (int x = 0; x < width; ++x) {
+      ++sub_histograms[(x % kSubHistograms) * kHistogramSize + linedata[x]];
     }
   }
+  AddSubHistograms(1, &sub_histograms[0]);
+  memcpy(histogram, &sub_histograms[0], sizeof(*histogram) * kHistogramSize);
 }
 
 // Computes the Otsu threshold(s) for the given histogram.
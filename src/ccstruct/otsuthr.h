@@ -38,6 +38,13 @@ const int kHistogramSize = 256;  // The size of a histogram of pixel values.
 int OtsuThreshold(Pix* src_pix, int left, int top, int width, int height,
                   int** thresholds, int** hi_values);
 
+// As OtsuThreshold above, but for a rectangle of an 8 bit grey image in a
+// buffer of bytes in plain memory order, with bytes_per_line bytes from the
+// start of one line to the next. Makes a single threshold and hi_value.
+void OtsuThreshold(const unsigned char* imagedata, int bytes_per_line,
+                   int left, int top, int width, int height,
+                   int* threshold, int* hi_value);
+
 // Computes the histogram for the given image rectangle, and the given
 // single channel. Each channel is always one byte per pixel.
 // Histogram is always a kHistogramSize(256) element array to count
@@ -46,6 +53,20 @@ void HistogramRect(Pix* src_pix, int channel,
                    int left, int top, int width, int height,
                    int* histogram);
 
+// Computes the histograms of all the channels of the given image rectangle
+// in a single pass over the image. Histograms is an array of num_channels
+// consecutive kHistogramSize element histograms, where num_channels is
+// the number of bytes per pixel.
+void HistogramRectAllChannels(Pix* src_pix,
+                              int left, int top, int width, int height,
+                              int* histograms);
+
+// Computes the histogram of the given rectangle of an 8 bit grey image in a
+// buffer of bytes in plain memory order.
+void HistogramRect(const unsigned char* imagedata, int bytes_per_line,
+                   int left, int top, int width, int height,
+                   int* histogram);
+
 // Computes the Otsu threshold(s) for the given histogram.
 // Also returns H = total count in histogram, and
 // omega0 = count of histogram below threshold.
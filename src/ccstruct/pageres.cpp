@@ -25,6 +25,7 @@
 #include <cassert>         // for assert
 #include <cstdint>         // for INT32_MAX
 #include <cstring>         // for strlen
+#include <map>             // for std::map
 #include "blamer.h"        // for BlamerBundle
 #include "blobs.h"         // for TWERD, TBLOB
 #include "boxword.h"       // for BoxWord
@@ -87,6 +88,44 @@ PAGE_RES::PAGE_RES(
   prev_word_best_choice = prev_word_best_choice_ptr;
 }
 
+// Walks the lists directly, as a PAGE_RES_IT would update the previous best
+// choice of the recognizer.
+int64_t PAGE_RES::MemoryBytes() {
+  int64_t bytes = sizeof(*this);
+  BLOCK_RES_IT block_it(&block_res_list);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    bytes += sizeof(BLOCK_RES);
+    ROW_RES_IT row_it(&block_it.data()->row_res_list);
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      bytes += sizeof(ROW_RES);
+      WERD_RES_IT word_it(&row_it.data()->word_res_list);
+      for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
+        bytes += word_it.data()->MemoryBytes();
+      }
+    }
+  }
+  return bytes;
+}
+
+void PAGE_RES::GetWords(GenericVector<PAGE_RES_WORD>* words) {
+  words->truncate(0);
+  BLOCK_RES_IT block_it(&block_res_list);
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
+    BLOCK_RES* block = block_it.data();
+    ROW_RES_IT row_it(&block->row_res_list);
+    for (row_it.mark_cycle_pt(); !row_it.cycled_list(); row_it.forward()) {
+      ROW_RES* row = row_it.data();
+      WERD_RES_IT word_it(&row->word_res_list);
+      for (word_it.mark_cycle_pt(); !word_it.cycled_list(); word_it.forward()) {
+        // Like PAGE_RES_IT, give the combination and not its parts.
+        if (word_it.data()->part_of_combo) continue;
+        PAGE_RES_WORD word = {block, row, word_it.data()};
+        words->push_back(word);
+      }
+    }
+  }
+}
+
 /*************************************************************************
  * BLOCK_RES::BLOCK_RES
  *
@@ -211,6 +250,7 @@ WERD_RES& WERD_RES::operator=(const WERD_RES & source) {
   correct_text = source.correct_text;
   blob_widths = source.blob_widths;
   blob_gaps = source.blob_gaps;
+  lstm_lattice = source.lstm_lattice;
   // None of the uses of operator= require the ratings matrix to be copied,
   // so don't as it would be really slow.
 
@@ -416,6 +456,85 @@ void WERD_RES::SetupBlobWidthsAndGaps() {
   }
 }
 
+// Computes raw_timesteps, accumulated_timesteps and symbol_steps from
+// lstm_outputs, if not already done.
+void WERD_RES::ComputeLSTMChoices() {
+  const LSTMTimestepOutputs& outputs = lstm_outputs;
+  if (outputs.starts.empty()) return;
+  int end = outputs.first + outputs.starts.size() - 1;
+  // The choices of each timestep, beginning with the most likely.
+  for (size_t t = 0; t + 1 < outputs.starts.size(); ++t) {
+    std::vector<std::pair<const char*, float>> choices;
+    for (int c = outputs.starts[t]; c < outputs.starts[t + 1]; ++c) {
+      UNICHAR_ID id = outputs.choices[c].first;
+      float prob = outputs.choices[c].second;
+      const char* character =
+          id == INVALID_UNICHAR_ID ? "" : uch_set->id_to_unichar_ext(id);
+      size_t pos = 0;
+      while (choices.size() > pos && choices[pos].second > prob) {
+        pos++;
+      }
+      choices.insert(choices.begin() + pos,
+                     std::pair<const char*, float>(character, prob));
+    }
+    raw_timesteps.push_back(choices);
+  }
+  // Accumulated Timesteps (choice mode 2 processing)
+  float sum = 0;
+  std::vector<std::pair<const char*, float>> choice_pairs;
+  size_t next_end = 0;
+  for (int i = outputs.accumulated_start; i < end; i++) {
+    for (std::pair<const char*, float> choice :
+         raw_timesteps[i - outputs.first]) {
+      if (std::strcmp(choice.first, "")) {
+        sum += choice.second;
+        choice_pairs.push_back(choice);
+      }
+    }
+    if (next_end < outputs.accumulated_ends.size() &&
+        i == outputs.accumulated_ends[next_end]) {
+      ++next_end;
+      std::map<const char*, float> summed_propabilities;
+      for (auto& choice_pair : choice_pairs) {
+        summed_propabilities[choice_pair.first] += choice_pair.second;
+      }
+      std::vector<std::pair<const char*, float>> accumulated_timestep;
+      for (auto& summed_propability : summed_propabilities) {
+        if (sum == 0) break;
+        summed_propability.second /= sum;
+        size_t pos = 0;
+        while (accumulated_timestep.size() > pos &&
+               accumulated_timestep[pos].second > summed_propability.second) {
+          pos++;
+        }
+        accumulated_timestep.insert(
+            accumulated_timestep.begin() + pos,
+            std::pair<const char*, float>(summed_propability.first,
+                                          summed_propability.second));
+      }
+      choice_pairs.clear();
+      accumulated_timesteps.push_back(accumulated_timestep);
+      sum = 0;
+    }
+  }
+  // Symbol Step (choice mode 3 processing)
+  std::vector<std::vector<std::pair<const char*, float>>> current_symbol;
+  size_t next_start = 0;
+  for (int i = outputs.symbol_start; i < end; i++) {
+    if (next_start < outputs.symbol_starts.size() &&
+        i == outputs.symbol_starts[next_start]) {
+      ++next_start;
+      if (!current_symbol.empty()) {
+        symbol_steps.push_back(current_symbol);
+        current_symbol.clear();
+      }
+    }
+    current_symbol.push_back(raw_timesteps[i - outputs.first]);
+  }
+  symbol_steps.push_back(current_symbol);
+  lstm_outputs = LSTMTimestepOutputs();
+}
+
 // Updates internal data to account for a new SEAM (chop) at the given
 // blob_number. Fixes the ratings matrix and states in the choices, as well
 // as the blob widths and gaps.
@@ -1095,6 +1214,51 @@ WERD_RES::~WERD_RES () {
   Clear();
 }
 
+// Returns an estimate of the bytes held by the blobs of word.
+static int64_t TwerdBytes(const TWERD* word) {
+  if (word == nullptr) return 0;
+  int64_t bytes = sizeof(*word) + word->blobs.size_reserved() * sizeof(TBLOB*);
+  for (int b = 0; b < word->NumBlobs(); ++b) {
+    bytes += sizeof(TBLOB);
+    for (const TESSLINE* outline = word->blobs[b]->outlines; outline != nullptr;
+         outline = outline->next) {
+      bytes += sizeof(*outline);
+      const EDGEPT* pt = outline->loop;
+      if (pt == nullptr) continue;
+      do {
+        bytes += sizeof(*pt);
+        pt = pt->next;
+      } while (pt != outline->loop);
+    }
+  }
+  return bytes;
+}
+
+int64_t WERD_RES::MemoryBytes() {
+  int64_t bytes = sizeof(*this);
+  WERD_CHOICE_IT it(&best_choices);
+  for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
+    bytes += it.data()->MemoryBytes();
+  }
+  if (raw_choice != nullptr) bytes += raw_choice->MemoryBytes();
+  if (ratings != nullptr) {
+    int dim = ratings->dimension();
+    bytes += sizeof(*ratings) +
+             ratings->size_allocated() * sizeof(BLOB_CHOICE_LIST*);
+    for (int col = 0; col < dim; ++col) {
+      for (int row = col; row < dim && row < col + ratings->bandwidth();
+           ++row) {
+        BLOB_CHOICE_LIST* choices = ratings->get(col, row);
+        if (choices != nullptr) {
+          bytes += sizeof(*choices) + choices->length() * sizeof(BLOB_CHOICE);
+        }
+      }
+    }
+  }
+  bytes += TwerdBytes(chopped_word) + TwerdBytes(rebuild_word);
+  return bytes;
+}
+
 void WERD_RES::InitNonPointers() {
   tess_failed = false;
   tess_accepted = false;
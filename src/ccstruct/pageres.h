@@ -20,15 +20,18 @@
 #define PAGERES_H
 
 #include <cstdint>             // for int32_t, int16_t
+#include <memory>              // for std::shared_ptr
 #include <set>                 // for std::pair
 #include <vector>              // for std::vector
 #include <sys/types.h>         // for int8_t
 #include "blamer.h"            // for BlamerBundle (ptr only), IRR_NUM_REASONS
 #include "clst.h"              // for CLIST_ITERATOR, CLISTIZEH
 #include "elst.h"              // for ELIST_ITERATOR, ELIST_LINK, ELISTIZEH
+#include "freelist.h"          // for FREE_LIST_ALLOCATED
 #include "genericvector.h"     // for GenericVector, PointerVector (ptr only)
 #include "matrix.h"            // for MATRIX
 #include "normalis.h"          // for DENORM
+#include "publictypes.h"       // for LSTMLatticeNode
 #include "ratngs.h"            // for WERD_CHOICE, BLOB_CHOICE (ptr only)
 #include "rect.h"              // for TBOX
 #include "rejctmap.h"          // for REJMAP
@@ -70,6 +73,13 @@ class WERD_RES;
 
 ELISTIZEH (WERD_RES)
 
+// A word of a PAGE_RES with the row and block that hold it.
+struct PAGE_RES_WORD {
+  BLOCK_RES* block;
+  ROW_RES* row;
+  WERD_RES* word;
+};
+
 /*************************************************************************
  * PAGE_RES - Page results
  *************************************************************************/
@@ -105,6 +115,14 @@ class PAGE_RES {                 // page result
            WERD_CHOICE **prev_word_best_choice_ptr);
 
   ~PAGE_RES () = default;
+
+  // Returns an estimate of the bytes held by the page and its words.
+  int64_t MemoryBytes();
+
+  // Fills words with the words of the page in the order PAGE_RES_IT gives
+  // them, for passes that walk the page several times. The words stay valid
+  // until a word is added, deleted or replaced.
+  void GetWords(GenericVector<PAGE_RES_WORD>* words);
 };
 
 /*************************************************************************
@@ -163,6 +181,27 @@ enum CRUNCH_MODE
   CR_DELETE
 };
 
+// The compact LSTM outputs of the timesteps of a word, from which its
+// per-timestep choices are computed on demand by
+// WERD_RES::ComputeLSTMChoices.
+struct LSTMTimestepOutputs {
+  // The first timestep of the word in the line.
+  int first = 0;
+  // The outputs above the cutoff of each timestep in index order, as their
+  // unichar-id, or INVALID_UNICHAR_ID for those without one, and their
+  // probability. Timestep first + t has choices[starts[t], starts[t + 1]).
+  std::vector<std::pair<UNICHAR_ID, float>> choices;
+  std::vector<int> starts;
+  // The timestep at which the accumulated choices begin, and the last
+  // timestep of each of them.
+  int accumulated_start = 0;
+  std::vector<int> accumulated_ends;
+  // The timestep at which the symbol steps begin, and the timesteps at which
+  // each new symbol starts.
+  int symbol_start = 0;
+  std::vector<int> symbol_starts;
+};
+
 // WERD_RES is a collection of publicly accessible members that gathers
 // information about a word result.
 class WERD_RES : public ELIST_LINK {
@@ -219,13 +258,20 @@ class WERD_RES : public ELIST_LINK {
   // Gaps between blobs in chopped_word. blob_gaps[i] is the gap between
   // blob i and blob i+1.
   GenericVector<int> blob_gaps;
-  // Stores the lstm choices of every timestep
+  // Stores the lstm choices of every timestep, computed from lstm_outputs
+  // by ComputeLSTMChoices, which must be called before using them.
   std::vector<std::vector<std::pair<const char*, float>>> raw_timesteps;
   std::vector<std::vector<std::pair<const char*, float>>> accumulated_timesteps;
   std::vector<std::vector<std::vector<std::pair<const char*, float>>>>
       symbol_steps;
   //Stores if the timestep vector starts with a space
   bool leadingSpace = false;
+  // The LSTM outputs from which the choices above are computed, cleared once
+  // they have been.
+  LSTMTimestepOutputs lstm_outputs;
+  // The lattice of the LSTM beam search of the text line of the word, shared
+  // by all the words of the line, or null if it wasn't kept.
+  std::shared_ptr<const std::vector<tesseract::LSTMLatticeNode>> lstm_lattice;
   // Ratings matrix contains classifier choices for each classified combination
   // of blobs. The dimension is the same as the number of blobs in chopped_word
   // and the leading diagonal corresponds to classifier results of the blobs
@@ -358,6 +404,11 @@ class WERD_RES : public ELIST_LINK {
   }
 
   ~WERD_RES();
+  FREE_LIST_ALLOCATED(WERD_RES, tesseract::kMaxFreeWordBytes)
+
+  // Returns an estimate of the bytes held by the word: its choices, its
+  // ratings matrix and the outlines of its chopped and rebuilt words.
+  int64_t MemoryBytes();
 
   // Returns the UTF-8 string for the given blob index in the best_choice word,
   // given that we know whether we are in a right-to-left reading context.
@@ -491,6 +542,10 @@ class WERD_RES : public ELIST_LINK {
   // Computes the blob_widths and blob_gaps from the chopped_word.
   void SetupBlobWidthsAndGaps();
 
+  // Computes raw_timesteps, accumulated_timesteps and symbol_steps from
+  // lstm_outputs, if not already done.
+  void ComputeLSTMChoices();
+
   // Updates internal data to account for a new SEAM (chop) at the given
   // blob_number. Fixes the ratings matrix and states in the choices, as well
   // as the blob widths and gaps.
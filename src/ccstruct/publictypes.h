@@ -20,6 +20,8 @@
 #ifndef TESSERACT_CCSTRUCT_PUBLICTYPES_H_
 #define TESSERACT_CCSTRUCT_PUBLICTYPES_H_
 
+#include <cstdint>  // for int32_t
+
 // This file contains types that are used both by the API and internally
 // to Tesseract. In order to decouple the API from Tesseract and prevent cyclic
 // dependencies, THIS FILE SHOULD NOT DEPEND ON ANY OTHER PART OF TESSERACT.
@@ -281,6 +283,28 @@ enum OcrEngineMode {
   OEM_COUNT                     // Number of OEMs
 };
 
+/**
+ * A node of the lattice of the LSTM beam search of a text line, for
+ * rescoring the alternatives outside of Tesseract. Each node is a network
+ * output label (code) at a timestep, and refers back to the previous node
+ * of its path, so that any path can be traced from its last node. A unichar
+ * is complete at a node that has a unichar_id other than -1, as a unichar
+ * may be encoded as a sequence of several codes.
+ */
+struct LSTMLatticeNode {
+  int32_t prev;        // Index of the previous node of the path, or -1.
+  int32_t timestep;    // Network timestep of the node in the text line.
+  int32_t x;           // Image x-coordinate of the timestep.
+  int32_t code;        // Network output label.
+  int32_t unichar_id;  // Unichar completed by this node, or -1.
+  float certainty;     // Certainty (log prob) of just this node.
+  float score;         // Total certainty of the path to this node.
+  int32_t permuter;    // PermuterType of the path at this node.
+  bool start_of_word;  // True if the node starts a dictionary word.
+  bool end_of_word;    // True if a dictionary word can end at the node.
+  bool duplicate;      // True if the code is a duplicate of the previous one.
+};
+
 }  // namespace tesseract.
 
 #endif  // TESSERACT_CCSTRUCT_PUBLICTYPES_H_
@@ -96,7 +96,8 @@ BLOB_CHOICE::BLOB_CHOICE(UNICHAR_ID src_unichar_id, // character id
                          float min_xheight,        // min xheight allowed
                          float max_xheight,        // max xheight by this char
                          float yshift,             // yshift out of position
-                         BlobChoiceClassifier c) {  // adapted match or other
+                         BlobChoiceClassifier c)   // adapted match or other
+    : fonts_(0, tesseract::ScoredFont()) {
   unichar_id_ = src_unichar_id;
   rating_ = src_rating;
   certainty_ = src_cert;
@@ -114,7 +115,8 @@ BLOB_CHOICE::BLOB_CHOICE(UNICHAR_ID src_unichar_id, // character id
  *
  * Constructor to build a BLOB_CHOICE from another BLOB_CHOICE.
  */
-BLOB_CHOICE::BLOB_CHOICE(const BLOB_CHOICE &other) : ELIST_LINK(other) {
+BLOB_CHOICE::BLOB_CHOICE(const BLOB_CHOICE &other)
+    : ELIST_LINK(other), fonts_(other.fonts_) {
   unichar_id_ = other.unichar_id();
   rating_ = other.rating();
   certainty_ = other.certainty();
@@ -126,7 +128,6 @@ BLOB_CHOICE::BLOB_CHOICE(const BLOB_CHOICE &other) : ELIST_LINK(other) {
   max_xheight_ = other.max_xheight_;
   yshift_ = other.yshift();
   classifier_ = other.classifier_;
-  fonts_ = other.fonts_;
 }
 
 // Copy assignment operator.
@@ -251,8 +252,9 @@ void WERD_CHOICE::init(const char *src_string,
   if (src_string_len == 0) {
     this->init(8);
   } else {
-    this->init(src_lengths ? strlen(src_lengths): src_string_len);
-    length_ = reserved_;
+    int length = src_lengths ? strlen(src_lengths): src_string_len;
+    this->init(length);
+    length_ = length;
     int offset = 0;
     for (int i = 0; i < length_; ++i) {
       int unichar_length = src_lengths ? src_lengths[i] : 1;
@@ -274,6 +276,7 @@ void WERD_CHOICE::init(const char *src_string,
  * WERD_CHOICE::~WERD_CHOICE
  */
 WERD_CHOICE::~WERD_CHOICE() {
+  if (reserved_ <= kLocalLength) return;
   delete[] unichar_ids_;
   delete[] script_pos_;
   delete[] state_;
@@ -312,6 +315,7 @@ MATRIX_COORD WERD_CHOICE::MatrixCoord(int index) const {
 void WERD_CHOICE::set_blob_choice(int index, int blob_count,
                                   const BLOB_CHOICE* blob_choice) {
   unichar_ids_[index] = blob_choice->unichar_id();
+  strings_valid_ = false;
   script_pos_[index] = tesseract::SP_NORMAL;
   state_[index] = blob_count;
   certainties_[index] = blob_choice->certainty();
@@ -355,6 +359,7 @@ void WERD_CHOICE::remove_unichar_ids(int start, int num) {
     certainties_[i] = certainties_[i + num];
   }
   length_ -= num;
+  strings_valid_ = false;
 }
 
 /**
@@ -371,6 +376,7 @@ void WERD_CHOICE::reverse_and_mirror_unichar_ids() {
   if (length_ % 2 != 0) {
     unichar_ids_[length_/2] = unicharset_->get_mirror(unichar_ids_[length_/2]);
   }
+  strings_valid_ = false;
 }
 
 /**
@@ -495,6 +501,7 @@ WERD_CHOICE & WERD_CHOICE::operator+= (const WERD_CHOICE & second) {
     script_pos_[length_ + i] = second.BlobPosition(i);
   }
   length_ += second.length();
+  strings_valid_ = false;
   if (second.adjust_factor_ > adjust_factor_)
     adjust_factor_ = second.adjust_factor_;
   rating_ += second.rating();  // add ratings
@@ -532,6 +539,7 @@ WERD_CHOICE& WERD_CHOICE::operator=(const WERD_CHOICE& source) {
     script_pos_[i] = source.BlobPosition(i);
   }
   length_ = source.length();
+  strings_valid_ = false;
   adjust_factor_ = source.adjust_factor_;
   rating_ = source.rating();
   certainty_ = source.certainty();
@@ -613,11 +621,8 @@ void WERD_CHOICE::SetScriptPositions(bool small_caps, TWERD* word, int debug) {
 void WERD_CHOICE::SetScriptPositions(const tesseract::ScriptPos* positions,
                                      int length) {
   ASSERT_HOST(length == length_);
-  if (positions != script_pos_) {
-    delete [] script_pos_;
-    script_pos_ = new ScriptPos[length];
+  if (positions != script_pos_)
     memcpy(script_pos_, positions, sizeof(positions[0]) * length);
-  }
 }
 // Sets all the script_pos_ positions to the given position.
 void WERD_CHOICE::SetAllScriptPositions(tesseract::ScriptPos position) {
@@ -22,10 +22,12 @@
 
 #include <cassert>
 #include <cfloat>      // for FLT_MAX
+#include <cstring>     // for memcpy
 
 #include "clst.h"
 #include "elst.h"
 #include "fontinfo.h"
+#include "freelist.h"
 #include "genericvector.h"
 #include "matrix.h"
 #include "unichar.h"
@@ -49,7 +51,9 @@ enum BlobChoiceClassifier {
 class BLOB_CHOICE: public ELIST_LINK
 {
   public:
-    BLOB_CHOICE() {
+    // fonts_ starts without storage, as most choices, eg those of the LSTM,
+    // never get any fonts.
+    BLOB_CHOICE() : fonts_(0, tesseract::ScoredFont()) {
       unichar_id_ = UNICHAR_SPACE;
       fontinfo_id_ = -1;
       fontinfo_id2_ = -1;
@@ -73,6 +77,7 @@ class BLOB_CHOICE: public ELIST_LINK
                 BlobChoiceClassifier c);   // adapted match or other
     BLOB_CHOICE(const BLOB_CHOICE &other);
     ~BLOB_CHOICE() = default;
+    FREE_LIST_ALLOCATED(BLOB_CHOICE, tesseract::kMaxFreeBlobBytes)
 
     UNICHAR_ID unichar_id() const {
       return unichar_id_;
@@ -231,8 +236,13 @@ class BLOB_CHOICE: public ELIST_LINK
   BlobChoiceClassifier classifier_;  // What generated *this.
 };
 
-// Make BLOB_CHOICE listable.
-ELISTIZEH(BLOB_CHOICE)
+// Make BLOB_CHOICE listable. The lists are allocated from a free list like
+// their elements, as there is one for every cell of every ratings MATRIX.
+ELISTIZEH_A(BLOB_CHOICE)
+ELISTIZEH_B(BLOB_CHOICE)
+ public:
+  FREE_LIST_ALLOCATED(BLOB_CHOICE_LIST, tesseract::kMaxFreeBlobBytes)
+ELISTIZEH_C(BLOB_CHOICE)
 
 // Return the BLOB_CHOICE in bc_list matching a given unichar_id,
 // or nullptr if there is no match.
@@ -296,6 +306,7 @@ class WERD_CHOICE : public ELIST_LINK {
     this->operator=(word);
   }
   ~WERD_CHOICE();
+  FREE_LIST_ALLOCATED(WERD_CHOICE, tesseract::kMaxFreeWordBytes)
 
   const UNICHARSET *unicharset() const {
     return unicharset_;
@@ -303,6 +314,14 @@ class WERD_CHOICE : public ELIST_LINK {
   inline int length() const {
     return length_;
   }
+  // Returns the bytes of the choice and its per-unichar arrays.
+  int64_t MemoryBytes() const {
+    if (reserved_ <= kLocalLength) return sizeof(*this);
+    return sizeof(*this) +
+           static_cast<int64_t>(reserved_) *
+               (sizeof(*unichar_ids_) + sizeof(*script_pos_) +
+                sizeof(*state_) + sizeof(*certainties_));
+  }
   float adjust_factor() const {
     return adjust_factor_;
   }
@@ -359,6 +378,7 @@ class WERD_CHOICE : public ELIST_LINK {
   inline void set_unichar_id(UNICHAR_ID unichar_id, int index) {
     assert(index < length_);
     unichar_ids_[index] = unichar_id;
+    strings_valid_ = false;
   }
   bool dangerous_ambig_found() const {
     return dangerous_ambig_found_;
@@ -381,45 +401,38 @@ class WERD_CHOICE : public ELIST_LINK {
   inline void set_length(int len) {
     ASSERT_HOST(reserved_ >= len);
     length_ = len;
+    strings_valid_ = false;
   }
 
   /// Make more space in unichar_id_ and fragment_lengths_ arrays.
   inline void double_the_size() {
-    if (reserved_ > 0) {
-      unichar_ids_ = GenericVector<UNICHAR_ID>::double_the_size_memcpy(
-          reserved_, unichar_ids_);
-      script_pos_ = GenericVector<tesseract::ScriptPos>::double_the_size_memcpy(
-          reserved_, script_pos_);
-      state_ = GenericVector<int>::double_the_size_memcpy(
-          reserved_, state_);
-      certainties_ = GenericVector<float>::double_the_size_memcpy(
-          reserved_, certainties_);
-      reserved_ *= 2;
-    } else {
-      unichar_ids_ = new UNICHAR_ID[1];
-      script_pos_ = new tesseract::ScriptPos[1];
-      state_ = new int[1];
-      certainties_ = new float[1];
-      reserved_ = 1;
-    }
+    bool on_heap = reserved_ > kLocalLength;
+    unichar_ids_ = GrowArray(unichar_ids_, reserved_, on_heap);
+    script_pos_ = GrowArray(script_pos_, reserved_, on_heap);
+    state_ = GrowArray(state_, reserved_, on_heap);
+    certainties_ = GrowArray(certainties_, reserved_, on_heap);
+    reserved_ *= 2;
   }
 
   /// Initializes WERD_CHOICE - reserves length slots in unichar_ids_ and
   /// fragment_length_ arrays. Sets other values to default (blank) values.
+  /// Words of up to kLocalLength unichars use the arrays inside the object.
   inline void init(int reserved) {
-    reserved_ = reserved;
-    if (reserved > 0) {
+    if (reserved > kLocalLength) {
+      reserved_ = reserved;
       unichar_ids_ = new UNICHAR_ID[reserved];
       script_pos_ = new tesseract::ScriptPos[reserved];
       state_ = new int[reserved];
       certainties_ = new float[reserved];
     } else {
-      unichar_ids_ = nullptr;
-      script_pos_ = nullptr;
-      state_ = nullptr;
-      certainties_ = nullptr;
+      reserved_ = kLocalLength;
+      unichar_ids_ = local_unichar_ids_;
+      script_pos_ = local_script_pos_;
+      state_ = local_state_;
+      certainties_ = local_certainties_;
     }
     length_ = 0;
+    strings_valid_ = false;
     adjust_factor_ = 1.0f;
     rating_ = 0.0;
     certainty_ = FLT_MAX;
@@ -442,6 +455,7 @@ class WERD_CHOICE : public ELIST_LINK {
   /// Set the fields in this choice to be default (bad) values.
   inline void make_bad() {
     length_ = 0;
+    strings_valid_ = false;
     rating_ = kBadRating;
     certainty_ = -FLT_MAX;
   }
@@ -465,6 +479,7 @@ class WERD_CHOICE : public ELIST_LINK {
                              float rating, float certainty, int index) {
     assert(index < length_);
     unichar_ids_[index] = unichar_id;
+    strings_valid_ = false;
     state_[index] = blob_count;
     certainties_[index] = certainty;
     script_pos_[index] = tesseract::SP_NORMAL;
@@ -480,7 +495,10 @@ class WERD_CHOICE : public ELIST_LINK {
 
   bool contains_unichar_id(UNICHAR_ID unichar_id) const;
   void remove_unichar_ids(int index, int num);
-  inline void remove_last_unichar_id() { --length_; }
+  inline void remove_last_unichar_id() {
+    --length_;
+    strings_valid_ = false;
+  }
   inline void remove_unichar_id(int index) {
     this->remove_unichar_ids(index, 1);
   }
@@ -539,14 +557,14 @@ class WERD_CHOICE : public ELIST_LINK {
   // Returns a UTF-8 string equivalent to the current choice
   // of UNICHAR IDs.
   const STRING &unichar_string() const {
-    this->string_and_lengths(&unichar_string_, &unichar_lengths_);
+    UpdateStrings();
     return unichar_string_;
   }
 
   // Returns the lengths, one byte each, representing the number of bytes
   // required in the unichar_string for each UNICHAR_ID.
   const STRING &unichar_lengths() const {
-    this->string_and_lengths(&unichar_string_, &unichar_lengths_);
+    UpdateStrings();
     return unichar_lengths_;
   }
 
@@ -592,6 +610,16 @@ class WERD_CHOICE : public ELIST_LINK {
   WERD_CHOICE& operator= (const WERD_CHOICE& source);
 
  private:
+  // Returns a copy of data, of the given size, in a new array of twice the
+  // size, deleting data if it was on the heap.
+  template <typename T>
+  static T* GrowArray(T* data, int size, bool on_heap) {
+    T* new_data = new T[size * 2];
+    memcpy(new_data, data, size * sizeof(*data));
+    if (on_heap) delete[] data;
+    return new_data;
+  }
+
   const UNICHARSET *unicharset_;
   // TODO(rays) Perhaps replace the multiple arrays with an array of structs?
   // unichar_ids_ is an array of classifier "results" that make up a word.
@@ -613,6 +641,13 @@ class WERD_CHOICE : public ELIST_LINK {
   int* state_;               // Number of blobs in each unichar.
   float* certainties_;       // Certainty of each unichar.
   int reserved_;             // size of the above arrays
+  // Storage for the above arrays while reserved_ <= kLocalLength, as most
+  // words are short and thousands of choices are made per page.
+  static const int kLocalLength = 16;
+  UNICHAR_ID local_unichar_ids_[kLocalLength];
+  tesseract::ScriptPos local_script_pos_[kLocalLength];
+  int local_state_[kLocalLength];
+  float local_certainties_[kLocalLength];
   int length_;               // word length
   // Factor that was used to adjust the rating.
   float adjust_factor_;
@@ -633,10 +668,21 @@ class WERD_CHOICE : public ELIST_LINK {
   // True if NoDangerousAmbig found an ambiguity.
   bool dangerous_ambig_found_;
 
-  // The following variables are populated and passed by reference any
-  // time unichar_string() or unichar_lengths() are called.
+  // Rebuilds unichar_string_ and unichar_lengths_ if the unichar ids
+  // changed since they were last built.
+  void UpdateStrings() const {
+    if (strings_valid_) return;
+    this->string_and_lengths(&unichar_string_, &unichar_lengths_);
+    strings_valid_ = true;
+  }
+
+  // The following variables are built by the first call of unichar_string()
+  // or unichar_lengths() after a change of the unichar ids, and only read by
+  // the calls after that, so a choice that is no longer changed may be read
+  // by several threads once they are built.
   mutable STRING unichar_string_;
   mutable STRING unichar_lengths_;
+  mutable bool strings_valid_;
 };
 
 // Make WERD_CHOICE listable.
@@ -23,6 +23,7 @@
 #include <cstdint>             // for int32_t, int16_t
 #include "coutln.h"            // for C_OUTLINE_LIST, C_OUTLINE
 #include "elst.h"              // for ELIST_ITERATOR, ELISTIZEH, ELIST_LINK
+#include "freelist.h"          // for FREE_LIST_ALLOCATED
 #include "points.h"            // for FCOORD, ICOORD (ptr only)
 #include "rect.h"              // for TBOX
 #include "scrollview.h"        // for ScrollView, ScrollView::Color
@@ -42,6 +43,7 @@ class C_BLOB:public ELIST_LINK
     // Simpler constructor to build a blob from a single outline that has
     // already been fully initialized.
     explicit C_BLOB(C_OUTLINE* outline);
+    FREE_LIST_ALLOCATED(C_BLOB, tesseract::kMaxFreeBlobBytes)
 
     // Builds a set of one or more blobs from a list of outlines.
     // Input: one outline on outline_list contains all the others, but the
@@ -21,6 +21,7 @@
 
 #include "bits16.h"
 #include "elst2.h"
+#include "freelist.h"
 #include "params.h"
 #include "stepblob.h"
 #include "strngs.h"
@@ -72,10 +73,17 @@ class WERD : public ELIST2_LINK {
   WERD* ConstructFromSingleBlob(bool bol, bool eol, C_BLOB* blob);
 
   ~WERD() = default;
+  FREE_LIST_ALLOCATED(WERD, tesseract::kMaxFreeWordBytes)
 
   // assignment
   WERD& operator=(const WERD& source);
 
+  static WERD* deep_copy(const WERD* src) {
+    auto* word = new WERD;
+    *word = *src;
+    return word;
+  }
+
   // This method returns a new werd constructed using the blobs in the input
   // all_blobs list, which correspond to the blobs in this werd object. The
   // blobs used to construct the new word are consumed and removed from the
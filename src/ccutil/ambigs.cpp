@@ -21,6 +21,7 @@
 #include "ambigs.h"
 
 #include <cstdio>
+#include <vector>
 #include "helpers.h"
 #include "universalambigs.h"
 
@@ -59,12 +60,73 @@ void UnicharAmbigs::InitUnicharAmbigs(const UNICHARSET& unicharset,
   }
 }
 
+// The lines of kUniversalAmbigsFile, split into their fields, which is all
+// of the parsing that doesn't depend on the unicharset.
+struct UniversalAmbigs {
+  struct Ambig {
+    int line_num;
+    int wrong;    // Offsets of the strings in text.
+    int correct;
+    int type;
+  };
+  // The file with the fields of each line terminated by a nul.
+  std::vector<char> text;
+  std::vector<Ambig> ambigs;
+};
+
+// Splits the universal ambigs file, which has the simpler format of
+// version 2, as ParseAmbiguityLine would.
+static UniversalAmbigs SplitUniversalAmbigs() {
+  UniversalAmbigs table;
+  table.text.assign(kUniversalAmbigsFile,
+                    kUniversalAmbigsFile + ksizeofUniversalAmbigsFile);
+  table.text.push_back('\0');
+  std::vector<int> fields;
+  int line_num = 0;
+  int start = 0;
+  const int size = table.text.size();
+  for (int i = 0; i < size; ++i) {
+    char ch = table.text[i];
+    if (ch != ' ' && ch != '\n' && ch != '\r' && ch != '\0') continue;
+    table.text[i] = '\0';
+    if (i != start) fields.push_back(start);
+    start = i + 1;
+    if (ch == ' ' || ch == '\r') continue;
+    ++line_num;
+    int type;
+    if (line_num == 1) {
+      ASSERT_HOST(fields.size() == 1 && table.text[fields[0]] == 'v' &&
+                  strtol(&table.text[fields[0] + 1], nullptr, 10) > 1);
+    } else if (fields.size() == 3 &&
+               sscanf(&table.text[fields[2]], "%d", &type) == 1) {
+      table.ambigs.push_back({line_num, fields[0], fields[1], type});
+    }
+    fields.clear();
+  }
+  return table;
+}
+
 // Loads the universal ambigs that are useful for any language.
+// The file is split once per process, so each call only encodes the
+// strings with encoder_set.
 void UnicharAmbigs::LoadUniversal(const UNICHARSET& encoder_set,
                                   UNICHARSET* unicharset) {
-  TFile file;
-  if (!file.Open(kUniversalAmbigsFile, ksizeofUniversalAmbigsFile)) return;
-  LoadUnicharAmbigs(encoder_set, &file, 0, false, unicharset);
+  static const UniversalAmbigs table = SplitUniversalAmbigs();
+  int test_ambig_part_size;
+  int replacement_ambig_part_size;
+  UNICHAR_ID test_unichar_ids[MAX_AMBIG_SIZE + 1];
+  char replacement_string[kMaxAmbigStringSize];
+  for (const auto& ambig : table.ambigs) {
+    if (!EncodeAmbiguity(ambig.line_num, 0, encoder_set,
+                         &table.text[ambig.wrong], &table.text[ambig.correct],
+                         &test_ambig_part_size, test_unichar_ids,
+                         &replacement_ambig_part_size, replacement_string)) {
+      continue;
+    }
+    AddAmbiguity(test_ambig_part_size, test_unichar_ids,
+                 replacement_ambig_part_size, replacement_string, ambig.type,
+                 false, unicharset);
+  }
 }
 
 void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
@@ -105,54 +167,9 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
                             buffer, &test_ambig_part_size, test_unichar_ids,
                             &replacement_ambig_part_size,
                             replacement_string, &type)) continue;
-    // Construct AmbigSpec and add it to the appropriate AmbigSpec_LIST.
-    auto *ambig_spec = new AmbigSpec();
-    if (!InsertIntoTable((type == REPLACE_AMBIG) ? replace_ambigs_
-                                                 : dang_ambigs_,
-                         test_ambig_part_size, test_unichar_ids,
-                         replacement_ambig_part_size, replacement_string, type,
-                         ambig_spec, unicharset))
-      continue;
-
-    // Update one_to_one_definite_ambigs_.
-    if (test_ambig_part_size == 1 &&
-        replacement_ambig_part_size == 1 && type == DEFINITE_AMBIG) {
-      if (one_to_one_definite_ambigs_[test_unichar_ids[0]] == nullptr) {
-        one_to_one_definite_ambigs_[test_unichar_ids[0]] = new UnicharIdVector();
-      }
-      one_to_one_definite_ambigs_[test_unichar_ids[0]]->push_back(
-          ambig_spec->correct_ngram_id);
-    }
-    // Update ambigs_for_adaption_.
-    if (use_ambigs_for_adaption) {
-      GenericVector<UNICHAR_ID> encoding;
-      // Silently ignore invalid strings, as before, so it is safe to use a
-      // universal ambigs file.
-      if (unicharset->encode_string(replacement_string, true, &encoding,
-                                    nullptr, nullptr)) {
-        for (i = 0; i < test_ambig_part_size; ++i) {
-          if (ambigs_for_adaption_[test_unichar_ids[i]] == nullptr) {
-            ambigs_for_adaption_[test_unichar_ids[i]] = new UnicharIdVector();
-          }
-          adaption_ambigs_entry = ambigs_for_adaption_[test_unichar_ids[i]];
-          for (int r = 0; r < encoding.size(); ++r) {
-            UNICHAR_ID id_to_insert = encoding[r];
-            ASSERT_HOST(id_to_insert != INVALID_UNICHAR_ID);
-            // Add the new unichar id to adaption_ambigs_entry (only if the
-            // vector does not already contain it) keeping it in sorted order.
-            for (j = 0; j < adaption_ambigs_entry->size() &&
-                 (*adaption_ambigs_entry)[j] > id_to_insert; ++j);
-            if (j < adaption_ambigs_entry->size()) {
-              if ((*adaption_ambigs_entry)[j] != id_to_insert) {
-                adaption_ambigs_entry->insert(id_to_insert, j);
-              }
-            } else {
-              adaption_ambigs_entry->push_back(id_to_insert);
-            }
-          }
-        }
-      }
-    }
+    AddAmbiguity(test_ambig_part_size, test_unichar_ids,
+                 replacement_ambig_part_size, replacement_string, type,
+                 use_ambigs_for_adaption, unicharset);
   }
   delete[] buffer;
 
@@ -216,6 +233,98 @@ void UnicharAmbigs::LoadUnicharAmbigs(const UNICHARSET& encoder_set,
   }
 }
 
+void UnicharAmbigs::AddAmbiguity(int test_ambig_part_size,
+                                 UNICHAR_ID *test_unichar_ids,
+                                 int replacement_ambig_part_size,
+                                 const char *replacement_string, int type,
+                                 bool use_ambigs_for_adaption,
+                                 UNICHARSET *unicharset) {
+  // Construct AmbigSpec and add it to the appropriate AmbigSpec_LIST.
+  auto *ambig_spec = new AmbigSpec();
+  if (!InsertIntoTable((type == REPLACE_AMBIG) ? replace_ambigs_
+                                               : dang_ambigs_,
+                       test_ambig_part_size, test_unichar_ids,
+                       replacement_ambig_part_size, replacement_string, type,
+                       ambig_spec, unicharset))
+    return;
+
+  // Update one_to_one_definite_ambigs_.
+  if (test_ambig_part_size == 1 &&
+      replacement_ambig_part_size == 1 && type == DEFINITE_AMBIG) {
+    if (one_to_one_definite_ambigs_[test_unichar_ids[0]] == nullptr) {
+      one_to_one_definite_ambigs_[test_unichar_ids[0]] = new UnicharIdVector();
+    }
+    one_to_one_definite_ambigs_[test_unichar_ids[0]]->push_back(
+        ambig_spec->correct_ngram_id);
+  }
+  // Update ambigs_for_adaption_.
+  if (use_ambigs_for_adaption) {
+    GenericVector<UNICHAR_ID> encoding;
+    // Silently ignore invalid strings, as before, so it is safe to use a
+    // universal ambigs file.
+    if (unicharset->encode_string(replacement_string, true, &encoding,
+                                  nullptr, nullptr)) {
+      for (int i = 0; i < test_ambig_part_size; ++i) {
+        if (ambigs_for_adaption_[test_unichar_ids[i]] == nullptr) {
+          ambigs_for_adaption_[test_unichar_ids[i]] = new UnicharIdVector();
+        }
+        UnicharIdVector *adaption_ambigs_entry =
+            ambigs_for_adaption_[test_unichar_ids[i]];
+        for (int r = 0; r < encoding.size(); ++r) {
+          UNICHAR_ID id_to_insert = encoding[r];
+          ASSERT_HOST(id_to_insert != INVALID_UNICHAR_ID);
+          // Add the new unichar id to adaption_ambigs_entry (only if the
+          // vector does not already contain it) keeping it in sorted order.
+          int j;
+          for (j = 0; j < adaption_ambigs_entry->size() &&
+               (*adaption_ambigs_entry)[j] > id_to_insert; ++j);
+          if (j < adaption_ambigs_entry->size()) {
+            if ((*adaption_ambigs_entry)[j] != id_to_insert) {
+              adaption_ambigs_entry->insert(id_to_insert, j);
+            }
+          } else {
+            adaption_ambigs_entry->push_back(id_to_insert);
+          }
+        }
+      }
+    }
+  }
+}
+
+bool UnicharAmbigs::EncodeAmbiguity(
+    int line_num, int debug_level, const UNICHARSET &unicharset,
+    const char *wrong, const char *correct, int *test_ambig_part_size,
+    UNICHAR_ID *test_unichar_ids, int *replacement_ambig_part_size,
+    char *replacement_string) {
+  // Encode wrong-string.
+  GenericVector<UNICHAR_ID> unichars;
+  if (!unicharset.encode_string(wrong, true, &unichars, nullptr, nullptr)) {
+    return false;
+  }
+  *test_ambig_part_size = unichars.size();
+  if (*test_ambig_part_size > MAX_AMBIG_SIZE) {
+    if (debug_level)
+      tprintf("Too many unichars in ambiguity on line %d\n", line_num);
+    return false;
+  }
+  // Copy encoded string to output.
+  for (int i = 0; i < unichars.size(); ++i)
+    test_unichar_ids[i] = unichars[i];
+  test_unichar_ids[unichars.size()] = INVALID_UNICHAR_ID;
+  // Encode replacement-string to check validity.
+  if (!unicharset.encode_string(correct, true, &unichars, nullptr, nullptr)) {
+    return false;
+  }
+  *replacement_ambig_part_size = unichars.size();
+  if (*replacement_ambig_part_size > MAX_AMBIG_SIZE) {
+    if (debug_level)
+      tprintf("Too many unichars in ambiguity on line %d\n", line_num);
+    return false;
+  }
+  snprintf(replacement_string, kMaxAmbigStringSize, "%s", correct);
+  return true;
+}
+
 bool UnicharAmbigs::ParseAmbiguityLine(
     int line_num, int version, int debug_level, const UNICHARSET &unicharset,
     char *buffer, int *test_ambig_part_size, UNICHAR_ID *test_unichar_ids,
@@ -229,38 +338,16 @@ bool UnicharAmbigs::ParseAmbiguityLine(
       if (debug_level) tprintf(kIllegalMsg, line_num);
       return false;
     }
-    // Encode wrong-string.
-    GenericVector<UNICHAR_ID> unichars;
-    if (!unicharset.encode_string(fields[0].string(), true, &unichars, nullptr,
-                                  nullptr)) {
-      return false;
-    }
-    *test_ambig_part_size = unichars.size();
-    if (*test_ambig_part_size > MAX_AMBIG_SIZE) {
-      if (debug_level)
-        tprintf("Too many unichars in ambiguity on line %d\n", line_num);
-      return false;
-    }
-    // Copy encoded string to output.
-    for (int i = 0; i < unichars.size(); ++i)
-      test_unichar_ids[i] = unichars[i];
-    test_unichar_ids[unichars.size()] = INVALID_UNICHAR_ID;
-    // Encode replacement-string to check validity.
-    if (!unicharset.encode_string(fields[1].string(), true, &unichars, nullptr,
-                                  nullptr)) {
-      return false;
-    }
-    *replacement_ambig_part_size = unichars.size();
-    if (*replacement_ambig_part_size > MAX_AMBIG_SIZE) {
-      if (debug_level)
-        tprintf("Too many unichars in ambiguity on line %d\n", line_num);
+    if (!EncodeAmbiguity(line_num, debug_level, unicharset,
+                         fields[0].string(), fields[1].string(),
+                         test_ambig_part_size, test_unichar_ids,
+                         replacement_ambig_part_size, replacement_string)) {
       return false;
     }
     if (sscanf(fields[2].string(), "%d", type) != 1) {
       if (debug_level) tprintf(kIllegalMsg, line_num);
       return false;
     }
-    snprintf(replacement_string, kMaxAmbigStringSize, "%s", fields[1].string());
     return true;
   }
   int i;
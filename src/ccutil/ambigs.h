@@ -203,6 +203,19 @@ class UnicharAmbigs {
   }
 
  private:
+  // Adds the parsed ambiguity to the tables.
+  void AddAmbiguity(int test_ambig_part_size, UNICHAR_ID *test_unichar_ids,
+                    int replacement_ambig_part_size,
+                    const char *replacement_string, int type,
+                    bool use_ambigs_for_adaption, UNICHARSET *unicharset);
+  // Encodes the strings of an ambiguity of the simpler format of version 2,
+  // returning false if either is invalid.
+  bool EncodeAmbiguity(int line_num, int debug_level,
+                       const UNICHARSET &unicharset, const char *wrong,
+                       const char *correct, int *test_ambig_part_size,
+                       UNICHAR_ID *test_unichar_ids,
+                       int *replacement_ambig_part_size,
+                       char *replacement_string);
   bool ParseAmbiguityLine(int line_num, int version, int debug_level,
                           const UNICHARSET &unicharset, char *buffer,
                           int *test_ambig_part_size,
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////
+// File:        counters.cpp
+// Description: Counters of the work done on the hot paths of recognition.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "counters.h"
+
+#include <algorithm>  // for std::find
+#include <mutex>      // for std::mutex, std::lock_guard
+#include <vector>     // for std::vector
+
+namespace tesseract {
+
+namespace {
+
+// The live Counters of the process and what the reset or destroyed ones
+// counted.
+struct CounterRegistry {
+  std::mutex mutex;
+  std::vector<const Counters*> live;
+  int64_t retired[COUNTER_COUNT] = {};
+};
+
+CounterRegistry& Registry() {
+  static CounterRegistry registry;
+  return registry;
+}
+
+// Counts the events of the threads that are outside of any ScopedCounters.
+Counters unscoped_counters;
+
+const char* const kCounterNames[COUNTER_COUNT] = {
+  "blobs_found",
+  "textlines",
+  "lstm_timesteps",
+  "beam_nodes",
+  "dawg_lookups",
+  "chop_attempts",
+  "classifier_calls",
+  "scratch_allocations",
+  "traineddata_bytes",
+  "blank_pages",
+};
+
+}  // namespace
+
+thread_local Counters* Counters::current_ = &unscoped_counters;
+
+const char* CounterName(CounterId id) {
+  return id >= 0 && id < COUNTER_COUNT ? kCounterNames[id] : nullptr;
+}
+
+Counters::Counters() {
+  for (auto& value : values_) value.store(0, std::memory_order_relaxed);
+  CounterRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.live.push_back(this);
+}
+
+Counters::~Counters() {
+  CounterRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (int i = 0; i < COUNTER_COUNT; ++i) {
+    registry.retired[i] += values_[i].load(std::memory_order_relaxed);
+  }
+  registry.live.erase(
+      std::find(registry.live.begin(), registry.live.end(), this));
+}
+
+void Counters::Snapshot(CounterSnapshot* snapshot) const {
+  for (int i = 0; i < COUNTER_COUNT; ++i) {
+    snapshot->values[i] = values_[i].load(std::memory_order_relaxed);
+  }
+}
+
+void Counters::Reset() {
+  CounterRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (int i = 0; i < COUNTER_COUNT; ++i) {
+    registry.retired[i] += values_[i].exchange(0, std::memory_order_relaxed);
+  }
+}
+
+void Counters::ProcessSnapshot(CounterSnapshot* snapshot) {
+  CounterRegistry& registry = Registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (int i = 0; i < COUNTER_COUNT; ++i) {
+    snapshot->values[i] = registry.retired[i];
+  }
+  for (const Counters* counters : registry.live) {
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+      snapshot->values[i] +=
+          counters->values_[i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace tesseract.
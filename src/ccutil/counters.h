@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////
+// File:        counters.h
+// Description: Counters of the work done on the hot paths of recognition.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_COUNTERS_H_
+#define TESSERACT_CCUTIL_COUNTERS_H_
+
+#include <atomic>   // for std::atomic
+#include <cstdint>  // for int64_t
+
+namespace tesseract {
+
+// The events that are counted. Keep CounterName in step.
+enum CounterId {
+  COUNTER_BLOBS_FOUND,          // Blobs found by the page layout analysis.
+  COUNTER_TEXTLINES,            // Textlines recognized by LSTMRecognizer.
+  COUNTER_LSTM_TIMESTEPS,       // Timesteps of the LSTM outputs.
+  COUNTER_BEAM_NODES,           // Nodes pushed to the heaps of the beams.
+  COUNTER_DAWG_LOOKUPS,         // Calls of Dict::def_letter_is_okay.
+  COUNTER_CHOP_ATTEMPTS,        // Calls of Wordrec::attempt_blob_chop.
+  COUNTER_CLASSIFIER_CALLS,     // Calls of Classify::AdaptiveClassifier.
+  COUNTER_SCRATCH_ALLOCATIONS,  // Heap allocations of NetworkScratch buffers.
+  COUNTER_TRAINEDDATA_BYTES,    // Bytes of traineddata files loaded.
+  COUNTER_BLANK_PAGES,          // Pages rejected as blank before layout.
+
+  COUNTER_COUNT
+};
+
+// The values of all the counters at one time, indexed by CounterId.
+struct CounterSnapshot {
+  int64_t values[COUNTER_COUNT];
+};
+
+// Returns the name of a counter, such as "blobs_found", for exporters.
+const char* CounterName(CounterId id);
+
+// A set of counters, such as those of one engine. Each counter is
+// incremented with a relaxed atomic add, which the threads of one engine
+// rarely contend for, and read without locking. The counters of all the
+// Counters of the process, live or destroyed, add up to the process-wide
+// counters of ProcessSnapshot.
+class Counters {
+ public:
+  Counters();
+  ~Counters();
+  Counters(const Counters&) = delete;
+  Counters& operator=(const Counters&) = delete;
+
+  void Add(CounterId id, int64_t count) {
+    values_[id].fetch_add(count, std::memory_order_relaxed);
+  }
+  void Snapshot(CounterSnapshot* snapshot) const;
+  // Sets the counters to zero, keeping what they counted in the
+  // process-wide counters.
+  void Reset();
+
+  // The Counters that CountEvent increments on the calling thread, which is
+  // that of a ScopedCounters or, outside of any, a process-wide one.
+  static Counters* current() {
+    return current_;
+  }
+  // Sums the counters of all the Counters of the process since it started.
+  static void ProcessSnapshot(CounterSnapshot* snapshot);
+
+ private:
+  friend class ScopedCounters;
+
+  std::atomic<int64_t> values_[COUNTER_COUNT];
+
+  static thread_local Counters* current_;
+};
+
+// Makes counters the current Counters of the calling thread for the
+// lifetime of the object.
+class ScopedCounters {
+ public:
+  explicit ScopedCounters(Counters* counters) : previous_(Counters::current_) {
+    Counters::current_ = counters;
+  }
+  ~ScopedCounters() {
+    Counters::current_ = previous_;
+  }
+  ScopedCounters(const ScopedCounters&) = delete;
+  ScopedCounters& operator=(const ScopedCounters&) = delete;
+
+ private:
+  Counters* previous_;
+};
+
+// Counts count events of the given id in the current Counters of the thread.
+inline void CountEvent(CounterId id, int64_t count = 1) {
+  Counters::current()->Add(id, count);
+}
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_COUNTERS_H_
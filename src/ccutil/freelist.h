@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////
+// File:        freelist.h
+// Description: Per-thread free lists for frequently allocated classes.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_FREELIST_H_
+#define TESSERACT_CCUTIL_FREELIST_H_
+
+#include <algorithm>  // for std::find
+#include <cstddef>    // for size_t
+#include <mutex>      // for std::mutex, std::lock_guard
+#include <new>        // for operator new
+#include <vector>     // for std::vector
+
+namespace tesseract {
+
+// Free list of memory blocks for objects of class T, of which thousands are
+// created and destroyed for every word or page.
+// Deleted objects go back on the free list of the current thread, which
+// keeps up to kMaxFreeBytes of them, and new ones reuse them. Each list has
+// its own lock, which only Release takes from another thread.
+// Blocks may be freed on a different thread than they were allocated on, as
+// they all come from the global operator new. The blocks of a thread are
+// returned to the system when it exits, or by Release.
+template <typename T, size_t kMaxFreeBytes>
+class FreeList {
+ public:
+  static void* Alloc(size_t size) {
+    if (size == sizeof(T)) {
+      Blocklist& free_list = Blocks();
+      std::lock_guard<std::mutex> lock(free_list.mutex);
+      if (!free_list.blocks.empty()) {
+        void* block = free_list.blocks.back();
+        free_list.blocks.pop_back();
+        return block;
+      }
+    }
+    return ::operator new(size);
+  }
+  static void Free(void* block, size_t size) {
+    if (block == nullptr) return;
+    if (size == sizeof(T)) {
+      Blocklist& free_list = Blocks();
+      std::lock_guard<std::mutex> lock(free_list.mutex);
+      if (!free_list.released && free_list.blocks.size() < kMaxFreeBlocks) {
+        free_list.blocks.push_back(block);
+        return;
+      }
+    }
+    ::operator delete(block);
+  }
+  // Returns the free blocks of all the threads to the system.
+  static void Release() {
+    Registry& registry = Lists();
+    std::lock_guard<std::mutex> registry_lock(registry.mutex);
+    for (Blocklist* free_list : registry.lists) {
+      std::lock_guard<std::mutex> lock(free_list->mutex);
+      free_list->Clear();
+    }
+  }
+
+ private:
+  static const size_t kMaxFreeBlocks = kMaxFreeBytes / sizeof(T);
+
+  struct Blocklist {
+    Blocklist() {
+      Registry& registry = Lists();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.lists.push_back(this);
+    }
+    ~Blocklist() {
+      Registry& registry = Lists();
+      std::lock_guard<std::mutex> registry_lock(registry.mutex);
+      registry.lists.erase(
+          std::find(registry.lists.begin(), registry.lists.end(), this));
+      std::lock_guard<std::mutex> lock(mutex);
+      Clear();
+      // Objects deleted later in the thread's exit go straight to the system.
+      released = true;
+    }
+    void Clear() {
+      for (void* block : blocks) ::operator delete(block);
+      blocks.clear();
+      blocks.shrink_to_fit();
+    }
+    std::mutex mutex;
+    std::vector<void*> blocks;
+    bool released = false;
+  };
+  // The lists of all the threads, for Release.
+  struct Registry {
+    std::mutex mutex;
+    std::vector<Blocklist*> lists;
+  };
+  static Blocklist& Blocks() {
+    thread_local Blocklist free_list;
+    return free_list;
+  }
+  static Registry& Lists() {
+    // Constructed before the first Blocklist, so destroyed after the last.
+    static Registry registry;
+    return registry;
+  }
+};
+
+// Max bytes of free blocks kept per thread for each of the classes of which
+// layout analysis and recognition create many thousands per page: the small
+// blob, outline and choice classes, the larger partitions and vectors that
+// are made from them, and the word results, which are rebuilt for every page.
+const size_t kMaxFreeBlobBytes = 1 << 20;
+const size_t kMaxFreePartitionBytes = 1 << 20;
+const size_t kMaxFreeWordBytes = 1 << 20;
+
+}  // namespace tesseract.
+
+// Makes the operators new and delete of CLASSNAME use a FreeList that keeps
+// up to MAX_FREE_BYTES of blocks per thread. ReleaseFreeList returns the
+// blocks of all the threads to the system.
+#define FREE_LIST_ALLOCATED(CLASSNAME, MAX_FREE_BYTES)                    \
+  static void* operator new(size_t size) {                               \
+    return tesseract::FreeList<CLASSNAME, MAX_FREE_BYTES>::Alloc(size);   \
+  }                                                                      \
+  static void operator delete(void* block, size_t size) {                \
+    tesseract::FreeList<CLASSNAME, MAX_FREE_BYTES>::Free(block, size);    \
+  }                                                                      \
+  static void ReleaseFreeList() {                                        \
+    tesseract::FreeList<CLASSNAME, MAX_FREE_BYTES>::Release();            \
+  }
+
+#endif  // TESSERACT_CCUTIL_FREELIST_H_
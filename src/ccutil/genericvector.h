@@ -23,6 +23,9 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>      // for memmove
+#include <type_traits>  // for std::is_trivially_copyable
+#include <utility>      // for std::move, std::forward
 
 #include "helpers.h"
 #include "serialis.h"
@@ -48,8 +51,17 @@ class GenericVector {
     this->init(other.size());
     this->operator+=(other);
   }
+  // Move, taking the data and callbacks of other, which is left empty.
+  GenericVector(GenericVector&& other) noexcept {
+    this->init(0);
+    this->move(&other);
+  }
   GenericVector<T>& operator+=(const GenericVector& other);
   GenericVector<T>& operator=(const GenericVector& other);
+  GenericVector<T>& operator=(GenericVector&& other) noexcept {
+    if (&other != this) this->move(&other);
+    return *this;
+  }
 
   ~GenericVector();
 
@@ -111,6 +123,12 @@ class GenericVector {
   // Push an element in the end of the array
   int push_back(T object);
   void operator+=(const T& t);
+  // Constructs an element from args in the end of the array and returns
+  // its index.
+  template <typename... Args>
+  int emplace_back(Args&&... args) {
+    return push_back(T(std::forward<Args>(args)...));
+  }
 
   // Push an element in the end of the array if the same
   // element is not already contained in the array.
@@ -350,6 +368,22 @@ class GenericVector {
   // Init the object, allocating size memory.
   void init(int size);
 
+  // Moves count elements from src to dest, which may overlap, with memmove
+  // if T is trivially copyable, and by move assignment otherwise.
+  static void MoveElements(T* src, int count, T* dest) {
+    MoveElements(src, count, dest, std::is_trivially_copyable<T>());
+  }
+  static void MoveElements(T* src, int count, T* dest, std::true_type) {
+    if (count > 0) memmove(dest, src, count * sizeof(T));
+  }
+  static void MoveElements(T* src, int count, T* dest, std::false_type) {
+    if (dest < src) {
+      std::move(src, src + count, dest);
+    } else {
+      std::move_backward(src, src + count, dest + count);
+    }
+  }
+
   // We are assuming that the object generally placed in the
   // vector are small enough that for efficiency it makes sense
   // to start with a larger initial size.
@@ -479,6 +513,9 @@ class PointerVector : public GenericVector<T*> {
     this->init(other.size());
     this->operator+=(other);
   }
+  // Move takes the pointers without copying the objects.
+  PointerVector(PointerVector&& other) noexcept
+      : GenericVector<T*>(std::move(other)) {}
   PointerVector<T>& operator+=(const PointerVector& other) {
     this->reserve(this->size_used_ + other.size_used_);
     for (int i = 0; i < other.size(); ++i) {
@@ -494,6 +531,13 @@ class PointerVector : public GenericVector<T*> {
     }
     return *this;
   }
+  PointerVector<T>& operator=(PointerVector&& other) noexcept {
+    if (&other != this) {
+      clear();
+      GenericVector<T*>::move(&other);
+    }
+    return *this;
+  }
 
   // Removes an element at the given index and
   // shifts the remaining elements to the left.
@@ -723,7 +767,7 @@ GenericVector<T>::~GenericVector() {
 }
 
 // Reserve some memory. If the internal array contains elements, they are
-// copied.
+// moved.
 template <typename T>
 void GenericVector<T>::reserve(int size) {
   if (size_reserved_ >= size || size <= 0) {
@@ -733,9 +777,7 @@ void GenericVector<T>::reserve(int size) {
     size = kDefaultVectorSize;
   }
   T* new_array = new T[size];
-  for (int i = 0; i < size_used_; ++i) {
-    new_array[i] = data_[i];
-  }
+  MoveElements(data_, size_used_, new_array);
   delete[] data_;
   data_ = new_array;
   size_reserved_ = size;
@@ -801,9 +843,7 @@ void GenericVector<T>::insert(const T& t, int index) {
   if (size_reserved_ == size_used_) {
     double_the_size();
   }
-  for (int i = size_used_; i > index; --i) {
-    data_[i] = data_[i - 1];
-  }
+  MoveElements(data_ + index, size_used_ - index, data_ + index + 1);
   data_[index] = t;
   size_used_++;
 }
@@ -813,9 +853,7 @@ void GenericVector<T>::insert(const T& t, int index) {
 template <typename T>
 void GenericVector<T>::remove(int index) {
   assert(index >= 0 && index < size_used_);
-  for (int i = index; i < size_used_ - 1; ++i) {
-    data_[i] = data_[i + 1];
-  }
+  MoveElements(data_ + index + 1, size_used_ - index - 1, data_ + index);
   size_used_--;
 }
 
@@ -851,7 +889,7 @@ int GenericVector<T>::push_back(T object) {
     double_the_size();
   }
   index = size_used_++;
-  data_[index] = object;
+  data_[index] = std::move(object);
   return index;
 }
 
@@ -870,9 +908,7 @@ int GenericVector<T>::push_front(const T& object) {
   if (size_used_ == size_reserved_) {
     double_the_size();
   }
-  for (int i = size_used_; i > 0; --i) {
-    data_[i] = data_[i - 1];
-  }
+  MoveElements(data_, size_used_, data_ + 1);
   data_[0] = object;
   ++size_used_;
   return 0;
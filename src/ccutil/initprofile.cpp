@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////
+// File:        initprofile.cpp
+// Description: Time and memory profile of the phases of initialization.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "initprofile.h"
+
+#include <cstdio>   // for fopen, fscanf, snprintf
+#include <cstring>  // for strcmp
+
+#if defined(__linux__)
+#include <unistd.h>  // for sysconf
+#endif
+
+namespace tesseract {
+
+// The profile that the InitPhases of each thread record into.
+static thread_local InitProfile* current_profile = nullptr;
+
+void InitProfile::Clear() {
+  phases_.clear();
+  open_.clear();
+}
+
+void InitProfile::Start() {
+  previous_ = current_profile;
+  current_profile = this;
+}
+
+void InitProfile::Stop() {
+  if (current_profile == this) current_profile = previous_;
+  previous_ = nullptr;
+}
+
+int InitProfile::Open(const char* name) {
+  int parent = open_.empty() ? -1 : open_.back();
+  int index = 0;
+  while (index < static_cast<int>(phases_.size()) &&
+         (phases_[index].parent != parent ||
+          strcmp(phases_[index].name.c_str(), name) != 0)) {
+    ++index;
+  }
+  if (index == static_cast<int>(phases_.size())) {
+    phases_.push_back({name, parent, 0, 0.0, 0});
+  }
+  open_.push_back(index);
+  return index;
+}
+
+void InitProfile::Close(int index, double ms, int64_t rss_bytes) {
+  // Phases close in the reverse order they open, as they are scoped.
+  if (!open_.empty() && open_.back() == index) open_.pop_back();
+  Phase& phase = phases_[index];
+  ++phase.count;
+  phase.ms += ms;
+  phase.rss_bytes += rss_bytes;
+}
+
+void InitProfile::Print(std::string* text) const {
+  PrintChildren(-1, 0, text);
+}
+
+void InitProfile::PrintChildren(int parent, int depth,
+                                std::string* text) const {
+  for (int i = 0; i < static_cast<int>(phases_.size()); ++i) {
+    const Phase& phase = phases_[i];
+    if (phase.parent != parent) continue;
+    char line[64];
+    snprintf(line, sizeof(line), "%10.3f ms %10.3f MB %6d  ", phase.ms,
+             phase.rss_bytes / 1048576.0, phase.count);
+    *text += line;
+    text->append(2 * depth, ' ');
+    *text += phase.name;
+    *text += '\n';
+    PrintChildren(i, depth + 1, text);
+  }
+}
+
+int64_t InitProfile::ResidentBytes() {
+#if defined(__linux__)
+  FILE* fp = fopen("/proc/self/statm", "r");
+  if (fp == nullptr) return 0;
+  long size, resident;
+  int fields = fscanf(fp, "%ld %ld", &size, &resident);
+  fclose(fp);
+  if (fields != 2) return 0;
+  return static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+InitPhase::InitPhase(const char* name)
+    : profile_(current_profile), index_(-1), start_rss_(0) {
+  if (profile_ == nullptr) return;
+  index_ = profile_->Open(name);
+  start_rss_ = InitProfile::ResidentBytes();
+  start_ = std::chrono::steady_clock::now();
+}
+
+InitPhase::~InitPhase() {
+  if (profile_ == nullptr) return;
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start_;
+  profile_->Close(index_, elapsed.count(),
+                  InitProfile::ResidentBytes() - start_rss_);
+}
+
+}  // namespace tesseract.
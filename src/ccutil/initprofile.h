@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////
+// File:        initprofile.h
+// Description: Time and memory profile of the phases of initialization.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_INITPROFILE_H_
+#define TESSERACT_CCUTIL_INITPROFILE_H_
+
+#include <chrono>   // for std::chrono::steady_clock
+#include <cstdint>  // for int64_t
+#include <string>   // for std::string
+#include <vector>   // for std::vector
+
+namespace tesseract {
+
+// The wall time and the growth of the resident set size of the phases of an
+// initialization, such as TessBaseAPI::Init, which InitPhase objects record
+// on the thread on which the profile is started. Phases nest, and the phases
+// of the same name within a parent are added up into one, so the shaping of
+// the many weight matrices of a network is a single phase that is counted.
+class InitProfile {
+ public:
+  struct Phase {
+    std::string name;
+    int parent;         // Index of the enclosing phase, or -1.
+    int count;          // Times the phase was entered.
+    double ms;          // Total wall time.
+    int64_t rss_bytes;  // Total growth of the resident set, may be negative.
+  };
+
+  InitProfile() = default;
+  InitProfile(const InitProfile&) = delete;
+  InitProfile& operator=(const InitProfile&) = delete;
+
+  // Forgets the recorded phases.
+  void Clear();
+  // Makes this the profile of the calling thread until Stop, which must be
+  // called on the same thread. Profiles that are started while another is
+  // current stack.
+  void Start();
+  void Stop();
+
+  const std::vector<Phase>& phases() const {
+    return phases_;
+  }
+  // Appends a line per phase to text, with the phases indented under the
+  // one that encloses them.
+  void Print(std::string* text) const;
+
+  // Returns the current resident set size of the process in bytes, or 0 if
+  // it is not known on this platform.
+  static int64_t ResidentBytes();
+
+ private:
+  friend class InitPhase;
+
+  // Returns the index of the phase of the given name in the innermost open
+  // phase, adding it if it doesn't exist yet, and opens it.
+  int Open(const char* name);
+  void Close(int index, double ms, int64_t rss_bytes);
+  void PrintChildren(int parent, int depth, std::string* text) const;
+
+  std::vector<Phase> phases_;
+  // Indices of the phases that are open, innermost last.
+  std::vector<int> open_;
+  // The profile that was current when this was started.
+  InitProfile* previous_ = nullptr;
+};
+
+// Starts a profile for the lifetime of the object.
+class ScopedInitProfile {
+ public:
+  explicit ScopedInitProfile(InitProfile* profile) : profile_(profile) {
+    profile_->Start();
+  }
+  ~ScopedInitProfile() {
+    profile_->Stop();
+  }
+  ScopedInitProfile(const ScopedInitProfile&) = delete;
+  ScopedInitProfile& operator=(const ScopedInitProfile&) = delete;
+
+ private:
+  InitProfile* profile_;
+};
+
+// Records a phase in the current profile of the thread, if there is one,
+// from its construction to its destruction. Does nothing otherwise, so the
+// code that loads each component can always declare its phase.
+class InitPhase {
+ public:
+  explicit InitPhase(const char* name);
+  explicit InitPhase(const std::string& name) : InitPhase(name.c_str()) {}
+  ~InitPhase();
+  InitPhase(const InitPhase&) = delete;
+  InitPhase& operator=(const InitPhase&) = delete;
+
+ private:
+  InitProfile* profile_;
+  int index_;
+  std::chrono::steady_clock::time_point start_;
+  int64_t start_rss_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_INITPROFILE_H_
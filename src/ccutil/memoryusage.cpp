@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////
+// File:        memoryusage.cpp
+// Description: Accounting of the memory held by the subsystems of an engine.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "memoryusage.h"
+
+#include <cstdio>  // for snprintf
+
+namespace tesseract {
+
+namespace {
+
+const char* const kMemoryCategoryNames[MEMORY_COUNT] = {
+  "weights_float",
+  "weights_int",
+  "network_scratch",
+  "page_res",
+  "bbgrids",
+  "adaptive_templates",
+  "dawgs",
+  "images",
+};
+
+}  // namespace
+
+thread_local MemoryTracker* MemoryTracker::current_ = nullptr;
+
+const char* MemoryCategoryName(MemoryCategory category) {
+  return category >= 0 && category < MEMORY_COUNT
+             ? kMemoryCategoryNames[category]
+             : nullptr;
+}
+
+int64_t MemoryUsage::Total() const {
+  int64_t total = 0;
+  for (int64_t size : bytes) total += size;
+  return total;
+}
+
+void MemoryUsage::Print(std::string* text) const {
+  char line[64];
+  for (int i = 0; i < MEMORY_COUNT; ++i) {
+    snprintf(line, sizeof(line), "%12.3f MB  %s\n", bytes[i] / 1048576.0,
+             kMemoryCategoryNames[i]);
+    *text += line;
+  }
+  snprintf(line, sizeof(line), "%12.3f MB  total\n", Total() / 1048576.0);
+  *text += line;
+}
+
+void MemoryTracker::Add(int64_t size) {
+  int64_t live = bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+  int64_t peak = peak_.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !peak_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////
+// File:        memoryusage.h
+// Description: Accounting of the memory held by the subsystems of an engine.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_MEMORYUSAGE_H_
+#define TESSERACT_CCUTIL_MEMORYUSAGE_H_
+
+#include <atomic>   // for std::atomic
+#include <cstdint>  // for int64_t
+#include <string>   // for std::string
+
+namespace tesseract {
+
+// The subsystems that memory is accounted to. Keep MemoryCategoryName in
+// step.
+enum MemoryCategory {
+  MEMORY_WEIGHTS_FLOAT,        // Float and double WeightMatrix weights.
+  MEMORY_WEIGHTS_INT,          // Int8 WeightMatrix weights and their scales.
+  MEMORY_NETWORK_SCRATCH,      // NetworkScratch buffers of the recognizers.
+  MEMORY_PAGE_RES,             // PAGE_RES and WERD_RES trees of the results.
+  MEMORY_BBGRIDS,              // Cells of the live BBGrids and IntGrids.
+  MEMORY_ADAPTIVE_TEMPLATES,   // Static and adapted classifier templates.
+  MEMORY_DAWGS,                // Edges of the dawgs and tries.
+  MEMORY_IMAGES,               // Copies of the image in the thresholder.
+
+  MEMORY_COUNT
+};
+
+// Returns the name of a category, such as "weights_float", for exporters.
+const char* MemoryCategoryName(MemoryCategory category);
+
+// The bytes held by each category at one time. These are estimates from
+// the sizes of the major containers, not counts of the allocations, so they
+// leave out the small objects, but they are cheap enough to report often.
+struct MemoryUsage {
+  int64_t bytes[MEMORY_COUNT] = {};
+
+  void Add(MemoryCategory category, int64_t size) {
+    bytes[category] += size;
+  }
+  int64_t Total() const;
+  // Appends a line per category and one of the total to text.
+  void Print(std::string* text) const;
+};
+
+// Tracks the live bytes of the containers that only exist during the
+// processing of a page, such as the grids of the layout analysis, which an
+// estimate after the page would miss, and their high-water mark.
+class MemoryTracker {
+ public:
+  MemoryTracker() = default;
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+  void Add(int64_t size);
+  int64_t bytes() const {
+    return bytes_.load(std::memory_order_relaxed);
+  }
+  int64_t peak() const {
+    return peak_.load(std::memory_order_relaxed);
+  }
+  // Starts a new high-water mark from the live bytes.
+  void ResetPeak() {
+    peak_.store(bytes(), std::memory_order_relaxed);
+  }
+
+  // The tracker that TrackedBytes record into on the calling thread, which
+  // is that of a ScopedMemoryTracker, or null outside of any.
+  static MemoryTracker* current() {
+    return current_;
+  }
+
+ private:
+  friend class ScopedMemoryTracker;
+
+  std::atomic<int64_t> bytes_{0};
+  std::atomic<int64_t> peak_{0};
+
+  static thread_local MemoryTracker* current_;
+};
+
+// Makes tracker the current MemoryTracker of the calling thread for the
+// lifetime of the object.
+class ScopedMemoryTracker {
+ public:
+  explicit ScopedMemoryTracker(MemoryTracker* tracker)
+      : previous_(MemoryTracker::current_) {
+    MemoryTracker::current_ = tracker;
+  }
+  ~ScopedMemoryTracker() {
+    MemoryTracker::current_ = previous_;
+  }
+  ScopedMemoryTracker(const ScopedMemoryTracker&) = delete;
+  ScopedMemoryTracker& operator=(const ScopedMemoryTracker&) = delete;
+
+ private:
+  MemoryTracker* previous_;
+};
+
+// The bytes of one container in the tracker that was current when they were
+// first set, so they are taken back from the same tracker when they change
+// or the container is destroyed, on whatever thread.
+class TrackedBytes {
+ public:
+  TrackedBytes() = default;
+  ~TrackedBytes() {
+    Set(0);
+  }
+  TrackedBytes(const TrackedBytes&) = delete;
+  TrackedBytes& operator=(const TrackedBytes&) = delete;
+
+  void Set(int64_t size) {
+    if (tracker_ == nullptr) tracker_ = MemoryTracker::current();
+    if (tracker_ == nullptr) return;
+    tracker_->Add(size - size_);
+    size_ = size;
+  }
+
+ private:
+  MemoryTracker* tracker_ = nullptr;
+  int64_t size_ = 0;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_MEMORYUSAGE_H_
@@ -0,0 +1,40 @@
+///////////////////////////////////////////////////////////////////////
+// File:        numthreads.cpp
+// Description: Configurable thread counts for internal parallelism.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "numthreads.h"
+#include "params.h"
+
+namespace tesseract {
+
+// Process-wide limit, so many engines running in one process don't
+// oversubscribe the cores. Set it to 1 to disable all internal threading.
+static INT_VAR(max_threads, 0,
+               "Maximum number of threads used by any internal parallel "
+               "operation, 0 for no limit");
+
+int NumThreads(int default_threads, int requested) {
+#ifdef _OPENMP
+  int num_threads = requested > 0 ? requested : default_threads;
+  if (max_threads > 0 && num_threads > max_threads) num_threads = max_threads;
+  return num_threads > 1 ? num_threads : 1;
+#else
+  (void)default_threads;
+  (void)requested;
+  return 1;
+#endif
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////
+// File:        numthreads.h
+// Description: Configurable thread counts for internal parallelism.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_NUMTHREADS_H_
+#define TESSERACT_CCUTIL_NUMTHREADS_H_
+
+namespace tesseract {
+
+// Returns the number of threads to use for an internal parallel operation,
+// such as an OpenMP loop. default_threads is the built-in number of threads
+// for the operation, which is used if requested is 0. Otherwise requested is
+// the number of threads wanted by the caller, usually the tessedit_num_threads
+// of the engine. The result is limited by the process-wide max_threads
+// parameter if that is positive, and is always at least 1, meaning that the
+// operation runs in the calling thread. Without OpenMP the result is always 1.
+int NumThreads(int default_threads, int requested = 0);
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_NUMTHREADS_H_
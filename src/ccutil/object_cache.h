@@ -20,6 +20,11 @@
 #ifndef TESSERACT_CCUTIL_OBJECT_CACHE_H_
 #define TESSERACT_CCUTIL_OBJECT_CACHE_H_
 
+#include <condition_variable>  // for std::condition_variable
+#include <functional>          // for std::hash
+#include <mutex>               // for std::mutex, std::unique_lock
+#include <string>              // for std::string
+#include <unordered_map>       // for std::unordered_map
 #include "ccutil.h"
 #include "errcode.h"
 #include "genericvector.h"
@@ -31,24 +36,29 @@ namespace tesseract {
 // Usually, these are expensive objects that are loaded from disk.
 // Reference counting is performed, so every Get() needs to be followed later
 // by a Free().  Actual deletion is accomplished by DeleteUnusedObjects().
+// The objects are spread over independently locked shards by a hash of their
+// id, and loaded without holding any lock, so that different objects can be
+// loaded in parallel, while the users of an object that is being loaded wait
+// for the single loader.
 template<typename T>
 class ObjectCache {
  public:
   ObjectCache() = default;
   ~ObjectCache() {
-    mu_.Lock();
-    for (int i = 0; i < cache_.size(); i++) {
-      if (cache_[i].count > 0) {
-        tprintf("ObjectCache(%p)::~ObjectCache(): WARNING! LEAK! object %p "
-                "still has count %d (id %s)\n",
-                this, cache_[i].object, cache_[i].count,
-                cache_[i].id.string());
-      } else {
-        delete cache_[i].object;
-        cache_[i].object = nullptr;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mu);
+      for (auto& entry : shard.entries) {
+        if (entry.second.count > 0) {
+          tprintf("ObjectCache(%p)::~ObjectCache(): WARNING! LEAK! object %p "
+                  "still has count %d (id %s)\n",
+                  this, entry.second.object, entry.second.count,
+                  entry.first.c_str());
+        } else {
+          delete entry.second.object;
+          entry.second.object = nullptr;
+        }
       }
     }
-    mu_.Unlock();
   }
 
   // Return a pointer to the object identified by id.
@@ -59,25 +69,36 @@ class ObjectCache {
   // We delete the given loader.
   T *Get(STRING id,
          TessResultCallback<T *> *loader) {
-    T *retval = nullptr;
-    mu_.Lock();
-    for (int i = 0; i < cache_.size(); i++) {
-      if (id == cache_[i].id) {
-        retval = cache_[i].object;
-        if (cache_[i].object != nullptr) {
-          cache_[i].count++;
-        }
-        mu_.Unlock();
+    std::string key(id.string());
+    Shard &shard = ShardOf(key);
+    std::unique_lock<std::mutex> lock(shard.mu);
+    for (;;) {
+      auto it = shard.entries.find(key);
+      if (it == shard.entries.end()) break;
+      ReferenceCount &rc = it->second;
+      if (!rc.loading) {
+        T *retval = rc.object;
+        if (retval != nullptr) rc.count++;
+        lock.unlock();
         delete loader;
         return retval;
       }
+      // Another thread is loading it, so wait for that to finish, and look
+      // again, as the entry may have been deleted in the meantime.
+      shard.loaded.wait(lock);
     }
-    cache_.push_back(ReferenceCount());
-    ReferenceCount &rc = cache_.back();
-    rc.id = id;
-    retval = rc.object = loader->Run();
+    // The entry can't be deleted while it is loading, so rc stays valid.
+    ReferenceCount &rc = shard.entries[key];
+    rc.loading = true;
+    lock.unlock();
+    T *retval = loader->Run();
+    lock.lock();
+    rc.object = retval;
     rc.count = (retval != nullptr) ? 1 : 0;
-    mu_.Unlock();
+    rc.loading = false;
+    if (retval != nullptr) shard.ids[retval] = key;
+    lock.unlock();
+    shard.loaded.notify_all();
     return retval;
   }
 
@@ -85,38 +106,55 @@ class ObjectCache {
   // Return whether we knew about the given pointer.
   bool Free(T *t) {
     if (t == nullptr) return false;
-    mu_.Lock();
-    for (int i = 0; i < cache_.size(); i++) {
-      if (cache_[i].object == t) {
-        --cache_[i].count;
-        mu_.Unlock();
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mu);
+      auto it = shard.ids.find(t);
+      if (it != shard.ids.end()) {
+        --shard.entries[it->second].count;
         return true;
       }
     }
-    mu_.Unlock();
     return false;
   }
 
   void DeleteUnusedObjects() {
-    mu_.Lock();
-    for (int i = cache_.size() - 1; i >= 0; i--) {
-      if (cache_[i].count <= 0) {
-        delete cache_[i].object;
-        cache_.remove(i);
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.mu);
+      for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+        if (it->second.count <= 0 && !it->second.loading) {
+          shard.ids.erase(it->second.object);
+          delete it->second.object;
+          it = shard.entries.erase(it);
+        } else {
+          ++it;
+        }
       }
     }
-    mu_.Unlock();
   }
 
  private:
   struct ReferenceCount {
-    STRING id;  // A unique ID to identify the object (think path on disk)
-    T *object;  // A copy of the object in memory.  Can be delete'd.
-    int count;  // A count of the number of active users of this object.
+    T *object = nullptr;   // A copy of the object in memory.  Can be delete'd.
+    int count = 0;         // A count of the number of active users of this object.
+    bool loading = false;  // True while the object is being loaded.
   };
+  // The objects whose ids hash to the same shard, indexed by their id (think
+  // path on disk), with a reverse index for Free.
+  struct Shard {
+    std::mutex mu;
+    std::condition_variable loaded;
+    std::unordered_map<std::string, ReferenceCount> entries;
+    std::unordered_map<const T *, std::string> ids;
+  };
+  // Number of shards. Different ids mostly go to different shards, so the
+  // users of different objects rarely wait on each other's lock.
+  static const int kNumShards = 16;
+
+  Shard &ShardOf(const std::string &key) {
+    return shards_[std::hash<std::string>()(key) % kNumShards];
+  }
 
-  CCUtilMutex mu_;
-  GenericVector<ReferenceCount> cache_;
+  Shard shards_[kNumShards];
 };
 
 }  // namespace tesseract
@@ -89,12 +89,18 @@ typedef struct { /*single character */
  * to 1 indicates that the OCR engine is dead.
  * If the cancel function is not null then it is called with the number of
  * user words found. If it returns true then operation is cancelled.
+ * The deadline and the cancel function are also checked during layout
+ * analysis and inside the recognition of a word or line, where the cancel
+ * function may be called from the threads of the line recognizer, with 0
+ * words, so it must be thread-safe.
  **********************************************************************/
 class ETEXT_DESC;
 
 using CANCEL_FUNC = bool (*)(void*, int);
 using PROGRESS_FUNC = bool (*)(int, int, int, int, int);
 using PROGRESS_FUNC2 = bool (*)(ETEXT_DESC*, int, int, int, int);
+using LINE_FUNC = void (*)(ETEXT_DESC*, const char*, int, int, int, int,
+                           float);
 
 class ETEXT_DESC {  // output header
  public:
@@ -110,6 +116,13 @@ class ETEXT_DESC {  // output header
   PROGRESS_FUNC progress_callback{
       nullptr};                       /// called whenever progress increases
   PROGRESS_FUNC2 progress_callback2;  /// monitor-aware progress callback
+  /** Called by the first recognition pass with each text line as soon as
+   * its words are recognized, with the UTF-8 text of the words from left to
+   * right, the left, top, right and bottom of the line in top-down
+   * coordinates of the recognized rectangle of the image, and the mean
+   * confidence (0-100) of the words. The later passes may still change the
+   * line unless tessedit_stream_final_lines is set. */
+  LINE_FUNC line_callback{nullptr};
   void* cancel_this{nullptr};         /// this or other data for cancel
   std::chrono::steady_clock::time_point end_time;
   /// Time to stop. Expected to be set only
@@ -139,6 +152,13 @@ class ETEXT_DESC {  // output header
     return (now > end_time);
   }
 
+  // Returns true if the deadline has passed, or the cancel function, called
+  // with the given number of words, asks to stop.
+  bool cancelled(int words) const {
+    return deadline_exceeded() ||
+           (cancel != nullptr && (*cancel)(cancel_this, words));
+  }
+
  private:
   static bool default_progress_func(ETEXT_DESC* ths, int left, int right,
                                     int top, int bottom) {
@@ -93,65 +93,77 @@ bool ParamUtils::SetParam(const char *name, const char* value,
                           SetParamConstraint constraint,
                           ParamsVectors *member_params) {
   // Look for the parameter among string parameters.
-  auto *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  auto *sp = FindParam<StringParam>(name, GlobalParams(), member_params);
   if (sp != nullptr && sp->constraint_ok(constraint)) sp->set_value(value);
   if (*value == '\0') return (sp != nullptr);
 
   // Look for the parameter among int parameters.
-  auto *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  auto *ip = FindParam<IntParam>(name, GlobalParams(), member_params);
   if (ip && ip->constraint_ok(constraint)) {
-    int intval = INT_MIN;
-    std::stringstream stream(value);
-    stream.imbue(std::locale::classic());
-    stream >> intval;
-    if (intval != INT_MIN) {
-      ip->set_value(intval);
-    }
+    int32_t intval;
+    if (ParseIntValue(value, &intval)) ip->set_value(intval);
   }
 
   // Look for the parameter among bool parameters.
-  auto *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  auto *bp = FindParam<BoolParam>(name, GlobalParams(), member_params);
   if (bp != nullptr && bp->constraint_ok(constraint)) {
-    if (*value == 'T' || *value == 't' ||
-        *value == 'Y' || *value == 'y' || *value == '1') {
-      bp->set_value(true);
-    } else if (*value == 'F' || *value == 'f' ||
-                *value == 'N' || *value == 'n' || *value == '0') {
-      bp->set_value(false);
-    }
+    bool boolval;
+    if (ParseBoolValue(value, &boolval)) bp->set_value(boolval);
   }
 
   // Look for the parameter among double parameters.
-  auto *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  auto *dp = FindParam<DoubleParam>(name, GlobalParams(), member_params);
   if (dp != nullptr && dp->constraint_ok(constraint)) {
-    double doubleval = NAN;
-    std::stringstream stream(value);
-    stream.imbue(std::locale::classic());
-    stream >> doubleval;
-    if (!std::isnan(doubleval)) {
-      dp->set_value(doubleval);
-    }
+    double doubleval;
+    if (ParseDoubleValue(value, &doubleval)) dp->set_value(doubleval);
   }
   return (sp || ip || bp || dp);
 }
 
+bool ParamUtils::ParseIntValue(const char* value, int32_t* result) {
+  int intval = INT_MIN;
+  std::stringstream stream(value);
+  stream.imbue(std::locale::classic());
+  stream >> intval;
+  if (intval == INT_MIN) return false;
+  *result = intval;
+  return true;
+}
+
+bool ParamUtils::ParseBoolValue(const char* value, bool* result) {
+  if (*value == 'T' || *value == 't' ||
+      *value == 'Y' || *value == 'y' || *value == '1') {
+    *result = true;
+  } else if (*value == 'F' || *value == 'f' ||
+             *value == 'N' || *value == 'n' || *value == '0') {
+    *result = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParamUtils::ParseDoubleValue(const char* value, double* result) {
+  double doubleval = NAN;
+  std::stringstream stream(value);
+  stream.imbue(std::locale::classic());
+  stream >> doubleval;
+  if (std::isnan(doubleval)) return false;
+  *result = doubleval;
+  return true;
+}
+
 bool ParamUtils::GetParamAsString(const char *name,
                                   const ParamsVectors* member_params,
                                   STRING *value) {
   // Look for the parameter among string parameters.
-  auto *sp = FindParam<StringParam>(name, GlobalParams()->string_params,
-                                           member_params->string_params);
+  auto *sp = FindParam<StringParam>(name, GlobalParams(), member_params);
   if (sp) {
     *value = sp->string();
     return true;
   }
   // Look for the parameter among int parameters.
-  auto *ip = FindParam<IntParam>(name, GlobalParams()->int_params,
-                                     member_params->int_params);
+  auto *ip = FindParam<IntParam>(name, GlobalParams(), member_params);
   if (ip) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%d", int32_t(*ip));
@@ -159,15 +171,13 @@ bool ParamUtils::GetParamAsString(const char *name,
     return true;
   }
   // Look for the parameter among bool parameters.
-  auto *bp = FindParam<BoolParam>(name, GlobalParams()->bool_params,
-                                       member_params->bool_params);
+  auto *bp = FindParam<BoolParam>(name, GlobalParams(), member_params);
   if (bp != nullptr) {
     *value = bool(*bp) ? "1": "0";
     return true;
   }
   // Look for the parameter among double parameters.
-  auto *dp = FindParam<DoubleParam>(name, GlobalParams()->double_params,
-                                           member_params->double_params);
+  auto *dp = FindParam<DoubleParam>(name, GlobalParams(), member_params);
   if (dp != nullptr) {
     char buf[128];
     snprintf(buf, sizeof(buf), "%g", double(*dp));
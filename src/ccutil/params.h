@@ -20,6 +20,8 @@
 #define PARAMS_H
 
 #include <cstdio>
+#include <cstring>        // for strcmp
+#include <unordered_map>  // for std::unordered_map
 
 #include "genericvector.h"
 #include "strngs.h"
@@ -39,11 +41,93 @@ enum SetParamConstraint {
   SET_PARAM_CONSTRAINT_NON_INIT_ONLY,
 };
 
+// Hash and equality of param names, to look them up without copying them.
+struct ParamNameHash {
+  size_t operator()(const char* name) const {
+    size_t hash = 5381;
+    for (; *name != '\0'; ++name)
+      hash = hash * 33 + static_cast<unsigned char>(*name);
+    return hash;
+  }
+};
+struct ParamNameEqual {
+  bool operator()(const char* a, const char* b) const {
+    return strcmp(a, b) == 0;
+  }
+};
+
 struct ParamsVectors {
   GenericVector<IntParam*> int_params;
   GenericVector<BoolParam*> bool_params;
   GenericVector<StringParam*> string_params;
   GenericVector<DoubleParam*> double_params;
+
+  // Adds param to the vector of its type, and to the index of its name.
+  template <class T>
+  void Add(T* param) {
+    vec(param).push_back(param);
+    // The first param of a name is the one that is found, as it was when
+    // the vectors were searched.
+    index(param).emplace(param->name_str(), param);
+  }
+  // Removes param from the vector of its type, and from the index, where
+  // the next param of the same name, if any, takes its place.
+  template <class T>
+  void Remove(T* param) {
+    GenericVector<T*>& params = vec(param);
+    for (int i = 0; i < params.size(); ++i) {
+      if (params[i] == param) {
+        params.remove(i);
+        break;
+      }
+    }
+    auto& params_index = index(param);
+    auto it = params_index.find(param->name_str());
+    if (it == params_index.end() || it->second != param) return;
+    params_index.erase(it);
+    for (int i = 0; i < params.size(); ++i) {
+      if (strcmp(params[i]->name_str(), param->name_str()) == 0) {
+        params_index.emplace(params[i]->name_str(), params[i]);
+        break;
+      }
+    }
+  }
+  // Returns the param of type T with the given name, or nullptr.
+  template <class T>
+  T* Find(const char* name) const {
+    const auto& params_index = index(static_cast<T*>(nullptr));
+    auto it = params_index.find(name);
+    return it != params_index.end() ? it->second : nullptr;
+  }
+
+ private:
+  template <class T>
+  using ParamIndex =
+      std::unordered_map<const char*, T*, ParamNameHash, ParamNameEqual>;
+
+  // The vector and index of the type of the given param, which may be
+  // nullptr.
+  GenericVector<IntParam*>& vec(IntParam*) { return int_params; }
+  GenericVector<BoolParam*>& vec(BoolParam*) { return bool_params; }
+  GenericVector<StringParam*>& vec(StringParam*) { return string_params; }
+  GenericVector<DoubleParam*>& vec(DoubleParam*) { return double_params; }
+  ParamIndex<IntParam>& index(IntParam*) { return int_index_; }
+  ParamIndex<BoolParam>& index(BoolParam*) { return bool_index_; }
+  ParamIndex<StringParam>& index(StringParam*) { return string_index_; }
+  ParamIndex<DoubleParam>& index(DoubleParam*) { return double_index_; }
+  const ParamIndex<IntParam>& index(IntParam*) const { return int_index_; }
+  const ParamIndex<BoolParam>& index(BoolParam*) const { return bool_index_; }
+  const ParamIndex<StringParam>& index(StringParam*) const {
+    return string_index_;
+  }
+  const ParamIndex<DoubleParam>& index(DoubleParam*) const {
+    return double_index_;
+  }
+
+  ParamIndex<IntParam> int_index_;
+  ParamIndex<BoolParam> bool_index_;
+  ParamIndex<StringParam> string_index_;
+  ParamIndex<DoubleParam> double_index_;
 };
 
 // Utility functions for working with Tesseract parameters.
@@ -67,30 +151,22 @@ class ParamUtils {
                        SetParamConstraint constraint,
                        ParamsVectors* member_params);
 
+  // Parse the value of a param of the type as SetParam does. Return false
+  // if the value is not valid for the type.
+  static bool ParseIntValue(const char* value, int32_t* result);
+  static bool ParseBoolValue(const char* value, bool* result);
+  static bool ParseDoubleValue(const char* value, double* result);
+
   // Returns the pointer to the parameter with the given name (of the
-  // appropriate type) if it was found in the vector obtained from
-  // GlobalParams() or in the given member_params.
+  // appropriate type) if it was found in global_params, such as
+  // GlobalParams(), or in the given member_params, which may be nullptr.
   template <class T>
-  static T* FindParam(const char* name, const GenericVector<T*>& global_vec,
-                      const GenericVector<T*>& member_vec) {
-    int i;
-    for (i = 0; i < global_vec.size(); ++i) {
-      if (strcmp(global_vec[i]->name_str(), name) == 0) return global_vec[i];
-    }
-    for (i = 0; i < member_vec.size(); ++i) {
-      if (strcmp(member_vec[i]->name_str(), name) == 0) return member_vec[i];
-    }
-    return nullptr;
-  }
-  // Removes the given pointer to the param from the given vector.
-  template <class T>
-  static void RemoveParam(T* param_ptr, GenericVector<T*>* vec) {
-    for (int i = 0; i < vec->size(); ++i) {
-      if ((*vec)[i] == param_ptr) {
-        vec->remove(i);
-        return;
-      }
-    }
+  static T* FindParam(const char* name, const ParamsVectors* global_params,
+                      const ParamsVectors* member_params) {
+    T* param = global_params->Find<T>(name);
+    if (param == nullptr && member_params != nullptr)
+      param = member_params->Find<T>(name);
+    return param;
   }
   // Fetches the value of the named param as a STRING. Returns false if not
   // found.
@@ -142,30 +218,24 @@ class IntParam : public Param {
       : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->int_params);
-    vec->int_params.push_back(this);
+    params_vec_ = vec;
+    vec->Add(this);
   }
-  ~IntParam() { ParamUtils::RemoveParam<IntParam>(this, params_vec_); }
+  ~IntParam() { params_vec_->Remove(this); }
   operator int32_t() const { return value_; }
   void operator=(int32_t value) { value_ = value; }
   void set_value(int32_t value) { value_ = value; }
   void ResetToDefault() { value_ = default_; }
   void ResetFrom(const ParamsVectors* vec) {
-    for (int i = 0; i < vec->int_params.size(); ++i) {
-      if (strcmp(vec->int_params[i]->name_str(), name_) == 0) {
-        // printf("overriding param %s=%d by =%d\n", name_, value_,
-        // *vec->int_params[i]);
-        value_ = *vec->int_params[i];
-        break;
-      }
-    }
+    const IntParam* param = vec->Find<IntParam>(name_);
+    if (param != nullptr) value_ = *param;
   }
 
  private:
   int32_t value_;
   int32_t default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<IntParam*>* params_vec_;
+  // Pointer to the vectors that contain this param (not owned by this class).
+  ParamsVectors* params_vec_;
 };
 
 class BoolParam : public Param {
@@ -175,30 +245,24 @@ class BoolParam : public Param {
       : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->bool_params);
-    vec->bool_params.push_back(this);
+    params_vec_ = vec;
+    vec->Add(this);
   }
-  ~BoolParam() { ParamUtils::RemoveParam<BoolParam>(this, params_vec_); }
+  ~BoolParam() { params_vec_->Remove(this); }
   operator bool() const { return value_; }
   void operator=(bool value) { value_ = value; }
   void set_value(bool value) { value_ = value; }
   void ResetToDefault() { value_ = default_; }
   void ResetFrom(const ParamsVectors* vec) {
-    for (int i = 0; i < vec->bool_params.size(); ++i) {
-      if (strcmp(vec->bool_params[i]->name_str(), name_) == 0) {
-        // printf("overriding param %s=%s by =%s\n", name_, value_ ? "true" :
-        // "false", *vec->bool_params[i] ? "true" : "false");
-        value_ = *vec->bool_params[i];
-        break;
-      }
-    }
+    const BoolParam* param = vec->Find<BoolParam>(name_);
+    if (param != nullptr) value_ = *param;
   }
 
  private:
   bool value_;
   bool default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<BoolParam*>* params_vec_;
+  // Pointer to the vectors that contain this param (not owned by this class).
+  ParamsVectors* params_vec_;
 };
 
 class StringParam : public Param {
@@ -208,10 +272,10 @@ class StringParam : public Param {
       : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->string_params);
-    vec->string_params.push_back(this);
+    params_vec_ = vec;
+    vec->Add(this);
   }
-  ~StringParam() { ParamUtils::RemoveParam<StringParam>(this, params_vec_); }
+  ~StringParam() { params_vec_->Remove(this); }
   operator STRING&() { return value_; }
   const char* string() const { return value_.string(); }
   const char* c_str() const { return value_.string(); }
@@ -221,21 +285,15 @@ class StringParam : public Param {
   void set_value(const STRING& value) { value_ = value; }
   void ResetToDefault() { value_ = default_; }
   void ResetFrom(const ParamsVectors* vec) {
-    for (int i = 0; i < vec->string_params.size(); ++i) {
-      if (strcmp(vec->string_params[i]->name_str(), name_) == 0) {
-        // printf("overriding param %s=%s by =%s\n", name_, value_,
-        // vec->string_params[i]->c_str());
-        value_ = *vec->string_params[i];
-        break;
-      }
-    }
+    const StringParam* param = vec->Find<StringParam>(name_);
+    if (param != nullptr) value_ = param->string();
   }
 
  private:
   STRING value_;
   STRING default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<StringParam*>* params_vec_;
+  // Pointer to the vectors that contain this param (not owned by this class).
+  ParamsVectors* params_vec_;
 };
 
 class DoubleParam : public Param {
@@ -245,30 +303,24 @@ class DoubleParam : public Param {
       : Param(name, comment, init) {
     value_ = value;
     default_ = value;
-    params_vec_ = &(vec->double_params);
-    vec->double_params.push_back(this);
+    params_vec_ = vec;
+    vec->Add(this);
   }
-  ~DoubleParam() { ParamUtils::RemoveParam<DoubleParam>(this, params_vec_); }
+  ~DoubleParam() { params_vec_->Remove(this); }
   operator double() const { return value_; }
   void operator=(double value) { value_ = value; }
   void set_value(double value) { value_ = value; }
   void ResetToDefault() { value_ = default_; }
   void ResetFrom(const ParamsVectors* vec) {
-    for (int i = 0; i < vec->double_params.size(); ++i) {
-      if (strcmp(vec->double_params[i]->name_str(), name_) == 0) {
-        // printf("overriding param %s=%f by =%f\n", name_, value_,
-        // *vec->double_params[i]);
-        value_ = *vec->double_params[i];
-        break;
-      }
-    }
+    const DoubleParam* param = vec->Find<DoubleParam>(name_);
+    if (param != nullptr) value_ = *param;
   }
 
  private:
   double value_;
   double default_;
-  // Pointer to the vector that contains this param (not owned by this class).
-  GenericVector<DoubleParam*>* params_vec_;
+  // Pointer to the vectors that contain this param (not owned by this class).
+  ParamsVectors* params_vec_;
 };
 
 }  // namespace tesseract
@@ -18,6 +18,7 @@
  **********************************************************************/
 
 #include "serialis.h"
+#include <algorithm>  // for std::max
 #include <cstdio>
 #include "errcode.h"
 #include "genericvector.h"
@@ -91,9 +92,13 @@ bool Serialize(FILE* fp, const uint32_t* data, size_t n) {
 TFile::TFile()
     : offset_(0),
       data_(nullptr),
+      read_data_(nullptr),
+      read_size_(0),
       data_is_owned_(false),
       is_writing_(false),
-      swap_(false) {}
+      swap_(false),
+      compact_(false),
+      half_precision_(false) {}
 
 TFile::~TFile() {
   if (data_is_owned_)
@@ -193,6 +198,11 @@ bool TFile::Skip(size_t count) {
   return true;
 }
 
+void TFile::SetReadData() {
+  read_size_ = data_->size();
+  read_data_ = read_size_ > 0 ? &(*data_)[0] : nullptr;
+}
+
 bool TFile::Open(const STRING& filename, FileReader reader) {
   if (!data_is_owned_) {
     data_ = new GenericVector<char>;
@@ -201,10 +211,10 @@ bool TFile::Open(const STRING& filename, FileReader reader) {
   offset_ = 0;
   is_writing_ = false;
   swap_ = false;
-  if (reader == nullptr)
-    return LoadDataFromFile(filename, data_);
-  else
-    return (*reader)(filename, data_);
+  bool result = reader == nullptr ? LoadDataFromFile(filename, data_)
+                                  : (*reader)(filename, data_);
+  SetReadData();
+  return result;
 }
 
 bool TFile::Open(const char* data, int size) {
@@ -217,6 +227,7 @@ bool TFile::Open(const char* data, int size) {
   swap_ = false;
   data_->resize_no_init(size);
   memcpy(&(*data_)[0], data, size);
+  SetReadData();
   return true;
 }
 
@@ -242,15 +253,38 @@ bool TFile::Open(FILE* fp, int64_t end_offset) {
     data_is_owned_ = true;
   }
   data_->resize_no_init(size);
+  SetReadData();
   return static_cast<int>(fread(&(*data_)[0], 1, size, fp)) == size;
 }
 
+void TFile::OpenNoCopy(const GenericVector<char>* data) {
+  if (data_is_owned_) delete data_;
+  // The data is only ever read, as is_writing_ is false.
+  data_ = const_cast<GenericVector<char>*>(data);
+  data_is_owned_ = false;
+  SetReadData();
+  offset_ = 0;
+  is_writing_ = false;
+  swap_ = false;
+}
+
+void TFile::OpenNoCopy(const char* data, int size) {
+  if (data_is_owned_) delete data_;
+  data_ = nullptr;
+  data_is_owned_ = false;
+  read_data_ = data;
+  read_size_ = size;
+  offset_ = 0;
+  is_writing_ = false;
+  swap_ = false;
+}
+
 char* TFile::FGets(char* buffer, int buffer_size) {
   ASSERT_HOST(!is_writing_);
   int size = 0;
-  while (size + 1 < buffer_size && offset_ < data_->size()) {
-    buffer[size++] = (*data_)[offset_++];
-    if ((*data_)[offset_ - 1] == '\n') break;
+  while (size + 1 < buffer_size && offset_ < read_size_) {
+    buffer[size++] = read_data_[offset_++];
+    if (read_data_[offset_ - 1] == '\n') break;
   }
   if (size < buffer_size) buffer[size] = '\0';
   return size > 0 ? buffer : nullptr;
@@ -274,15 +308,15 @@ int TFile::FRead(void* buffer, size_t size, int count) {
   size_t required_size;
   if (SIZE_MAX / size <= count) {
     // Avoid integer overflow.
-    required_size = data_->size() - offset_;
+    required_size = read_size_ - offset_;
   } else {
     required_size = size * count;
-    if (data_->size() - offset_ < required_size) {
-      required_size = data_->size() - offset_;
+    if (read_size_ - offset_ < required_size) {
+      required_size = read_size_ - offset_;
     }
   }
   if (required_size > 0 && buffer != nullptr)
-    memcpy(buffer, &(*data_)[offset_], required_size);
+    memcpy(buffer, read_data_ + offset_, required_size);
   offset_ += required_size;
   return required_size / size;
 }
@@ -321,11 +355,14 @@ int TFile::FWrite(const void* buffer, size_t size, int count) {
   ASSERT_HOST(count >= 0);
   ASSERT_HOST(SIZE_MAX / size > count);
   size_t total = size * count;
-  const char* buf = static_cast<const char*>(buffer);
-  // This isn't very efficient, but memory is so fast compared to disk
-  // that it is relatively unimportant, and very simple.
-  for (size_t i = 0; i < total; ++i)
-    data_->push_back(buf[i]);
+  if (total == 0) return count;
+  int used = data_->size();
+  int new_size = used + static_cast<int>(total);
+  // Grow geometrically, as resize_no_init would allocate exactly.
+  if (data_->size_reserved() < new_size)
+    data_->reserve(std::max(new_size, 2 * used));
+  data_->resize_no_init(new_size);
+  memcpy(&(*data_)[used], buffer, total);
   return count;
 }
 
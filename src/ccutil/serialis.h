@@ -86,10 +86,31 @@ class TFile {
   bool Open(const char* data, int size);
   // From an open file and an end offset.
   bool Open(FILE* fp, int64_t end_offset);
+  // Reads directly from an existing buffer, without making a copy, so the
+  // buffer must outlive the reading, and not change during it.
+  void OpenNoCopy(const GenericVector<char>* data);
+  // As OpenNoCopy above, from raw memory, such as a memory-mapped file.
+  void OpenNoCopy(const char* data, int size);
   // Sets the value of the swap flag, so that FReadEndian does the right thing.
   void set_swap(bool value) {
     swap_ = value;
   }
+  // Sets whether writers that have a compact encoding of their data may use
+  // it. Readers recognize the encoding by themselves.
+  void set_compact(bool value) {
+    compact_ = value;
+  }
+  bool compact() const {
+    return compact_;
+  }
+  // Sets whether float weights written without training data may be stored
+  // as half precision. Readers recognize the encoding by themselves.
+  void set_half_precision(bool value) {
+    half_precision_ = value;
+  }
+  bool half_precision() const {
+    return half_precision_;
+  }
 
   // Deserialize data.
   bool DeSerialize(char* data, size_t count = 1);
@@ -117,6 +138,27 @@ class TFile {
   bool Serialize(const uint32_t* data, size_t count = 1);
   bool Serialize(const uint64_t* data, size_t count = 1);
 
+  // Sets *data to point to the next count elements of T in the buffer,
+  // without copying them, and moves past them. The view is only valid as long
+  // as the buffer, so as the data given to OpenNoCopy, or until the TFile is
+  // re-opened. Returns false, without reading anything, if there are too few
+  // elements, or they can't be used in place, because they need byte-swapping
+  // or are misaligned. Then the caller should fall back to DeSerialize.
+  // Only works with bitwise-serializeable types!
+  template <typename T>
+  bool DeSerializeView(const T** data, size_t count) {
+    if (swap_ && sizeof(T) > 1) return false;
+    if (offset_ > read_size_ ||
+        count > static_cast<size_t>(read_size_ - offset_) / sizeof(T)) {
+      return false;
+    }
+    const char* start = read_data_ + offset_;
+    if (reinterpret_cast<uintptr_t>(start) % alignof(T) != 0) return false;
+    *data = reinterpret_cast<const T*>(start);
+    offset_ += count * sizeof(T);
+    return true;
+  }
+
   // Skip data.
   bool Skip(size_t count);
 
@@ -134,6 +176,10 @@ class TFile {
   // Resets the TFile as if it has been Opened, but nothing read.
   // Only allowed while reading!
   void Rewind();
+  // Returns the number of bytes read so far.
+  int Offset() const {
+    return offset_;
+  }
 
   // Open for writing. Either supply a non-nullptr data with OpenWrite before
   // calling FWrite, (no close required), or supply a nullptr data to OpenWrite
@@ -146,16 +192,26 @@ class TFile {
   int FWrite(const void* buffer, size_t size, int count);
 
  private:
+  // Points read_data_ and read_size_ at the contents of data_.
+  void SetReadData();
+
   // The number of bytes used so far.
   int offset_;
-  // The buffered data from the file.
+  // The buffered data from the file, or the written data.
   GenericVector<char>* data_;
+  // The data being read, either that of data_ or given to OpenNoCopy.
+  const char* read_data_;
+  int read_size_;
   // True if the data_ pointer is owned by *this.
   bool data_is_owned_;
   // True if the TFile is open for writing.
   bool is_writing_;
   // True if bytes need to be swapped in FReadEndian.
   bool swap_;
+  // True if writers may use a compact encoding.
+  bool compact_;
+  // True if float weights without training data may be half precision.
+  bool half_precision_;
 };
 
 }  // namespace tesseract.
@@ -37,8 +37,9 @@ const int kMaxIntSize = 22;
  * including total capacity and how much used (strlen with '\0').
  *
  * The implementation hides this header at the start of the data
- * buffer and appends the string on the end to keep sizeof(STRING)
- * unchanged from earlier versions so serialization is not affected.
+ * buffer and appends the string on the end. Strings of up to
+ * kLocalCapacity (including the '\0') use a buffer inside the STRING
+ * itself instead of the heap.
  *
  * The collection of MACROS provide different implementations depending
  * on whether the string keeps track of its strlen or not so that this
@@ -49,7 +50,13 @@ const int kMaxIntSize = 22;
 const int kMinCapacity = 16;
 
 char* STRING::AllocData(int used, int capacity) {
-  data_ = static_cast<STRING_HEADER *>(malloc(capacity + sizeof(STRING_HEADER)));
+  if (capacity <= kLocalCapacity) {
+    data_ = nullptr;
+    capacity = kLocalCapacity;
+  } else {
+    data_ = static_cast<STRING_HEADER *>(
+        malloc(capacity + sizeof(STRING_HEADER)));
+  }
 
   // header is the metadata for this memory block
   STRING_HEADER* header = GetHeader();
@@ -58,6 +65,7 @@ char* STRING::AllocData(int used, int capacity) {
   return GetCStr();
 }
 
+// Frees any heap storage, leaving the local buffer in use but uninitialized.
 void STRING::DiscardData() {
   free(data_);
   data_ = nullptr;
@@ -68,7 +76,7 @@ void STRING::DiscardData() {
 char* STRING::ensure_cstr(int32_t min_capacity) {
   STRING_HEADER* orig_header = GetHeader();
   if (min_capacity <= orig_header->capacity_)
-    return (reinterpret_cast<char *>(this->data_)) + sizeof(STRING_HEADER);
+    return GetCStr();
 
   // if we are going to grow bigger, than double our existing
   // size, but if that still is not big enough then keep the
@@ -88,7 +96,7 @@ char* STRING::ensure_cstr(int32_t min_capacity) {
   data_ = new_header;
 
   assert(InvariantOk());
-  return (reinterpret_cast<char *>(data_)) + sizeof(STRING_HEADER);
+  return GetCStr();
 }
 
 // This is const, but is modifying a mutable field
@@ -114,6 +122,17 @@ STRING::STRING(const STRING& str) {
   assert(InvariantOk());
 }
 
+STRING::STRING(STRING&& str) noexcept {
+  if (str.data_ != nullptr) {
+    data_ = str.data_;
+    // Leave str empty, in its local buffer.
+    memcpy(str.AllocData(1, kMinCapacity), "", 1);
+  } else {
+    data_ = nullptr;
+    memcpy(local_, str.local_, sizeof(local_));
+  }
+}
+
 STRING::STRING(const char* cstr) {
   if (cstr == nullptr) {
     // Empty STRINGs contain just the "\0".
@@ -351,6 +370,21 @@ STRING& STRING::operator=(const STRING& str) {
   return *this;
 }
 
+STRING& STRING::operator=(STRING&& str) noexcept {
+  if (&str == this) return *this;
+  if (str.data_ != nullptr) {
+    DiscardData();
+    data_ = str.data_;
+    // Leave str empty, in its local buffer.
+    memcpy(str.AllocData(1, kMinCapacity), "", 1);
+  } else {
+    // Short strings are as cheap to copy as to move, and this keeps any heap
+    // storage we already have.
+    *this = static_cast<const STRING&>(str);
+  }
+  return *this;
+}
+
 STRING & STRING::operator+=(const STRING& str) {
   FixHeader();
   str.FixHeader();
@@ -440,19 +474,8 @@ STRING STRING::operator+(const STRING& str) const {
 
 
 STRING STRING::operator+(const char ch) const {
-  STRING result;
-  FixHeader();
-  const STRING_HEADER* this_header = GetHeader();
-  const int this_used = this_header->used_;
-  char* result_cstr = result.ensure_cstr(this_used + 1);
-  STRING_HEADER* result_header = result.GetHeader();
-  const int result_used = result_header->used_;
-
-  // copies '\0' but we'll overwrite that
-  memcpy(result_cstr, GetCStr(), this_used);
-  result_cstr[result_used] = ch;      // overwrite old '\0'
-  result_cstr[result_used + 1] = '\0';  // append on '\0'
-  ++result_header->used_;
+  STRING result(*this);
+  result += ch;
 
   assert(InvariantOk());
   return result;
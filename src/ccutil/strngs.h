@@ -46,6 +46,7 @@ class TESS_API STRING {
  public:
   STRING();
   STRING(const STRING& string);
+  STRING(STRING&& string) noexcept;
   STRING(const char* string);
   STRING(const char* data, int length);
   ~STRING();
@@ -99,6 +100,7 @@ class TESS_API STRING {
 
   STRING& operator=(const char* string);
   STRING& operator=(const STRING& string);
+  STRING& operator=(STRING&& string) noexcept;
 
   STRING operator+(const STRING& string) const;
   STRING operator+(char ch) const;
@@ -142,27 +144,35 @@ class TESS_API STRING {
     mutable int used_;
   } STRING_HEADER;
 
-  // To preserve the behavior of the old serialization, we only have space
-  // for one pointer in this structure. So we are embedding a data structure
-  // at the start of the storage that will hold additional state variables,
-  // then storing the actual string contents immediately after.
+  // Capacity of the local buffer, including the '\0' terminator. Strings
+  // that fit (most unichars and words) need no heap allocation.
+  static const int kLocalCapacity = 16;
+
+  // The storage starts with a data structure that holds additional state
+  // variables, and the actual string contents are stored immediately after.
+  // Short strings use local_ as the storage, signalled by data_ == nullptr,
+  // so that a STRING may still be relocated bitwise. Longer strings are
+  // stored on the heap, pointed to by data_.
   STRING_HEADER* data_;
+  alignas(STRING_HEADER) char local_[sizeof(STRING_HEADER) + kLocalCapacity];
 
   // returns the header part of the storage
   inline STRING_HEADER* GetHeader() {
-    return data_;
+    return data_ != nullptr ? data_ : reinterpret_cast<STRING_HEADER*>(local_);
   }
   inline const STRING_HEADER* GetHeader() const {
-    return data_;
+    return data_ != nullptr ? data_
+                            : reinterpret_cast<const STRING_HEADER*>(local_);
   }
 
   // returns the string data part of storage
   inline char* GetCStr() {
-    return (reinterpret_cast<char*>(data_)) + sizeof(STRING_HEADER);
+    return (reinterpret_cast<char*>(GetHeader())) + sizeof(STRING_HEADER);
   }
 
   inline const char* GetCStr() const {
-    return (reinterpret_cast<const char*>(data_)) + sizeof(STRING_HEADER);
+    return (reinterpret_cast<const char*>(GetHeader())) +
+           sizeof(STRING_HEADER);
   }
   inline bool InvariantOk() const {
 #if STRING_IS_PROTECTED
@@ -22,16 +22,26 @@
 
 #include "tessdatamanager.h"
 
+#include <climits>
 #include <cstdio>
 #include <string>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #if defined(HAVE_LIBARCHIVE)
 #include <archive.h>
 #include <archive_entry.h>
 #endif
 
+#include "counters.h"
 #include "errcode.h"
 #include "helpers.h"
+#include "initprofile.h"
 #include "serialis.h"
 #include "strngs.h"
 #include "tprintf.h"
@@ -39,6 +49,10 @@
 
 namespace tesseract {
 
+static INT_VAR(tessdata_manager_debug_level, 0,
+               "Debug level for TessdataManager: 1 reports the components"
+               " loaded from traineddata files as they are used");
+
 TessdataManager::TessdataManager() : reader_(nullptr), is_loaded_(false), swap_(false) {
   SetVersionString(PACKAGE_VERSION);
 }
@@ -94,12 +108,41 @@ bool TessdataManager::LoadArchiveFile(const char *filename) {
 }
 #endif
 
+// The file is read straight from the page cache, instead of into a buffer of
+// its own first, and its components are only copied out of the mapping when
+// they are first asked for, so those that are never used cost no memory.
+// The mapping is kept for GetMappedComponent, until nothing uses it.
+bool TessdataManager::LoadMappedFile(const char *filename) {
+#ifdef _WIN32
+  return false;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) return false;
+  bool result = false;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size <= INT_MAX) {
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      size_t size = st.st_size;
+      std::shared_ptr<const char> mapping(
+          static_cast<const char *>(data),
+          [size](const char *p) { munmap(const_cast<char *>(p), size); });
+      result = LoadMemBuffer(filename, mapping.get(), st.st_size, mapping);
+    }
+  }
+  close(fd);
+  return result;
+#endif
+}
+
 bool TessdataManager::Init(const char *data_file_name) {
+  InitPhase phase("traineddata");
   GenericVector<char> data;
   if (reader_ == nullptr) {
 #if defined(HAVE_LIBARCHIVE)
     if (LoadArchiveFile(data_file_name)) return true;
 #endif
+    if (LoadMappedFile(data_file_name)) return true;
     if (!LoadDataFromFile(data_file_name, &data)) return false;
   } else {
     if (!(*reader_)(data_file_name, &data)) return false;
@@ -110,6 +153,16 @@ bool TessdataManager::Init(const char *data_file_name) {
 // Loads from the given memory buffer as if a file.
 bool TessdataManager::LoadMemBuffer(const char *name, const char *data,
                                     int size) {
+  return LoadMemBuffer(name, data, size, nullptr);
+}
+
+// As the public LoadMemBuffer, but data is in the given mapping, which is
+// kept for GetMappedComponent, if not null.
+bool TessdataManager::LoadMemBuffer(
+    const char *name, const char *data, int size,
+    const std::shared_ptr<const char> &mapping) {
+  InitPhase phase("traineddata directory");
+  CountEvent(COUNTER_TRAINEDDATA_BYTES, size);
   // TODO: This method supports only the proprietary file format.
   Clear();
   data_file_name_ = name;
@@ -130,11 +183,24 @@ bool TessdataManager::LoadMemBuffer(const char *name, const char *data,
       unsigned j = i + 1;
       while (j < num_entries && offset_table[j] == -1) ++j;
       if (j < num_entries) entry_size = offset_table[j] - offset_table[i];
-      entries_[i].resize_no_init(entry_size);
-      if (!fp.DeSerialize(&entries_[i][0], entry_size)) return false;
+      if (offset_table[i] > size || entry_size < 0 ||
+          entry_size > size - offset_table[i]) {
+        return false;
+      }
+      if (mapping != nullptr && !swap_) {
+        // Read in place by GetComponent, or copied out by LoadComponent.
+        if (entry_size > 0) {
+          mapped_entries_[i] =
+              std::shared_ptr<const char>(mapping, data + offset_table[i]);
+          mapped_sizes_[i] = entry_size;
+        }
+      } else {
+        entries_[i].resize_no_init(entry_size);
+        if (!fp.DeSerialize(&entries_[i][0], entry_size)) return false;
+      }
     }
   }
-  if (entries_[TESSDATA_VERSION].empty()) {
+  if (!IsComponentAvailable(TESSDATA_VERSION)) {
     SetVersionString("Pre-4.0.0");
   }
   is_loaded_ = true;
@@ -147,6 +213,33 @@ void TessdataManager::OverwriteEntry(TessdataType type, const char *data,
   is_loaded_ = true;
   entries_[type].resize_no_init(size);
   memcpy(&entries_[type][0], data, size);
+  mapped_entries_[type].reset();
+  mapped_sizes_[type] = 0;
+}
+
+// Overwrites a single entry of the given type, taking the contents of data.
+void TessdataManager::OverwriteEntry(TessdataType type,
+                                     GenericVector<char> *data) {
+  is_loaded_ = true;
+  entries_[type] = std::move(*data);
+  mapped_entries_[type].reset();
+  mapped_sizes_[type] = 0;
+}
+
+const char *TessdataManager::ComponentData(TessdataType type) const {
+  if (mapped_entries_[type] != nullptr) return mapped_entries_[type].get();
+  return entries_[type].empty() ? nullptr : &entries_[type][0];
+}
+
+void TessdataManager::LoadComponent(TessdataType type) {
+  if (mapped_entries_[type] == nullptr || !entries_[type].empty()) return;
+  entries_[type].resize_no_init(mapped_sizes_[type]);
+  memcpy(&entries_[type][0], mapped_entries_[type].get(),
+         mapped_sizes_[type]);
+  if (tessdata_manager_debug_level > 0) {
+    tprintf("Loaded %s from %s: %d bytes\n", kTessdataFileSuffixes[type],
+            data_file_name_.string(), entries_[type].size());
+  }
 }
 
 // Saves to the given filename.
@@ -170,11 +263,12 @@ void TessdataManager::Serialize(GenericVector<char> *data) const {
   int64_t offset_table[TESSDATA_NUM_ENTRIES];
   int64_t offset = sizeof(int32_t) + sizeof(offset_table);
   for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (entries_[i].empty()) {
+    auto type = static_cast<TessdataType>(i);
+    if (!IsComponentAvailable(type)) {
       offset_table[i] = -1;
     } else {
       offset_table[i] = offset;
-      offset += entries_[i].size();
+      offset += ComponentSize(type);
     }
   }
   data->init_to_size(offset, 0);
@@ -183,9 +277,10 @@ void TessdataManager::Serialize(GenericVector<char> *data) const {
   fp.OpenWrite(data);
   fp.Serialize(&num_entries);
   fp.Serialize(&offset_table[0], countof(offset_table));
-  for (const auto& entry : entries_) {
-    if (!entry.empty()) {
-      fp.Serialize(&entry[0], entry.size());
+  for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
+    auto type = static_cast<TessdataType>(i);
+    if (IsComponentAvailable(type)) {
+      fp.Serialize(ComponentData(type), ComponentSize(type));
     }
   }
 }
@@ -195,6 +290,15 @@ void TessdataManager::Clear() {
   for (auto& entry : entries_) {
     entry.clear();
   }
+  for (auto& entry : mapped_entries_) {
+    entry.reset();
+  }
+  for (auto& size : mapped_sizes_) {
+    size = 0;
+  }
+  for (auto& used : used_) {
+    used = false;
+  }
   is_loaded_ = false;
 }
 
@@ -203,10 +307,12 @@ void TessdataManager::Directory() const {
   tprintf("Version string:%s\n", VersionString().c_str());
   int offset = TESSDATA_NUM_ENTRIES * sizeof(int64_t);
   for (unsigned i = 0; i < TESSDATA_NUM_ENTRIES; ++i) {
-    if (!entries_[i].empty()) {
-      tprintf("%d:%s:size=%d, offset=%d\n", i, kTessdataFileSuffixes[i],
-              entries_[i].size(), offset);
-      offset += entries_[i].size();
+    auto type = static_cast<TessdataType>(i);
+    if (IsComponentAvailable(type)) {
+      int size = ComponentSize(type);
+      tprintf("%d:%s:size=%d, offset=%d%s\n", i, kTessdataFileSuffixes[i],
+              size, offset, used_[i] ? ", used" : "");
+      offset += size;
     }
   }
 }
@@ -219,26 +325,49 @@ bool TessdataManager::GetComponent(TessdataType type, TFile *fp) {
   return const_this->GetComponent(type, fp);
 }
 
-// As non-const version except it can't load the component if not already
-// loaded.
+// As non-const version except the file must have been loaded.
 bool TessdataManager::GetComponent(TessdataType type, TFile *fp) const {
   ASSERT_HOST(is_loaded_);
-  if (entries_[type].empty()) return false;
-  fp->Open(&entries_[type][0], entries_[type].size());
+  if (!IsComponentAvailable(type)) return false;
+  used_[type] = true;
+  if (entries_[type].empty()) {
+    // The mapping outlives fp, as it is kept until the manager is cleared.
+    fp->OpenNoCopy(ComponentData(type), ComponentSize(type));
+  } else {
+    fp->OpenNoCopy(&entries_[type]);
+  }
   fp->set_swap(swap_);
   return true;
 }
 
+// If the component was loaded from a memory-mapped file, and is in native
+// byte order, returns its bytes in the mapping and sets *size.
+std::shared_ptr<const char> TessdataManager::GetMappedComponent(
+    TessdataType type, int *size) const {
+  *size = ComponentSize(type);
+  if (mapped_entries_[type] != nullptr) {
+    used_[type] = true;
+    if (tessdata_manager_debug_level > 0) {
+      tprintf("Mapped %s from %s: %d bytes\n", kTessdataFileSuffixes[type],
+              data_file_name_.string(), *size);
+    }
+  }
+  return mapped_entries_[type];
+}
+
 // Returns the current version string.
 std::string TessdataManager::VersionString() const {
-  return std::string(&entries_[TESSDATA_VERSION][0],
-                     entries_[TESSDATA_VERSION].size());
+  if (!IsComponentAvailable(TESSDATA_VERSION)) return std::string();
+  return std::string(ComponentData(TESSDATA_VERSION),
+                     ComponentSize(TESSDATA_VERSION));
 }
 
 // Sets the version string to the given v_str.
 void TessdataManager::SetVersionString(const std::string &v_str) {
   entries_[TESSDATA_VERSION].resize_no_init(v_str.size());
   memcpy(&entries_[TESSDATA_VERSION][0], v_str.data(), v_str.size());
+  mapped_entries_[TESSDATA_VERSION].reset();
+  mapped_sizes_[TESSDATA_VERSION] = 0;
 }
 
 bool TessdataManager::CombineDataFiles(
@@ -281,6 +410,8 @@ bool TessdataManager::OverwriteComponents(
   for (int i = 0; i < num_new_components; ++i) {
     TessdataType type;
     if (TessdataTypeFromFileName(component_filenames[i], &type)) {
+      mapped_entries_[type].reset();
+      mapped_sizes_[type] = 0;
       if (!LoadDataFromFile(component_filenames[i], &entries_[type])) {
         tprintf("Failed to read component file:%s\n", component_filenames[i]);
         return false;
@@ -296,7 +427,8 @@ bool TessdataManager::ExtractToFile(const char *filename) {
   TessdataType type = TESSDATA_NUM_ENTRIES;
   ASSERT_HOST(
       tesseract::TessdataManager::TessdataTypeFromFileName(filename, &type));
-  if (entries_[type].empty()) return false;
+  if (!IsComponentAvailable(type)) return false;
+  LoadComponent(type);
   return SaveDataToFile(entries_[type], filename);
 }
 
@@ -20,6 +20,7 @@
 #ifndef TESSERACT_CCUTIL_TESSDATAMANAGER_H_
 #define TESSERACT_CCUTIL_TESSDATAMANAGER_H_
 
+#include <memory>  // std::shared_ptr
 #include "genericvector.h"
 
 static const char kTrainedDataSuffix[] = "traineddata";
@@ -146,6 +147,9 @@ class TessdataManager {
   bool LoadMemBuffer(const char *name, const char *data, int size);
   // Overwrites a single entry of the given type.
   void OverwriteEntry(TessdataType type, const char *data, int size);
+  // As OverwriteEntry above, but takes the contents of data without copying,
+  // leaving it empty.
+  void OverwriteEntry(TessdataType type, GenericVector<char> *data);
 
   // Saves to the given filename.
   bool SaveFile(const STRING &filename, FileWriter writer) const;
@@ -159,14 +163,25 @@ class TessdataManager {
 
   // Returns true if the component requested is present.
   bool IsComponentAvailable(TessdataType type) const {
-    return !entries_[type].empty();
+    return ComponentSize(type) > 0;
   }
-  // Opens the given TFile pointer to the given component type.
+  // Returns true if the component has been asked for since the file was
+  // loaded, so a component that is available but not used was never loaded.
+  bool IsComponentUsed(TessdataType type) const { return used_[type]; }
+  // Opens the given TFile pointer to the given component type, loading the
+  // file first if needed. fp reads the component in place, whether loaded or
+  // mapped, so it must not be used after *this is cleared or destroyed.
   // Returns false in case of failure.
   bool GetComponent(TessdataType type, TFile *fp);
-  // As non-const version except it can't load the component if not already
-  // loaded.
+  // As non-const version except the file must have been loaded.
   bool GetComponent(TessdataType type, TFile *fp) const;
+  // If the component was loaded from a memory-mapped file, and is in native
+  // byte order, returns its bytes in the mapping and sets *size. The mapping
+  // stays alive while any copy of the returned pointer does, even after *this
+  // is cleared, so the bytes can be used in place, shared with any other
+  // process that maps the same file. Otherwise returns nullptr.
+  std::shared_ptr<const char> GetMappedComponent(TessdataType type,
+                                                 int *size) const;
 
   // Returns the current version string.
   std::string VersionString() const;
@@ -175,12 +190,12 @@ class TessdataManager {
 
   // Returns true if the base Tesseract components are present.
   bool IsBaseAvailable() const {
-    return !entries_[TESSDATA_UNICHARSET].empty() &&
-           !entries_[TESSDATA_INTTEMP].empty();
+    return IsComponentAvailable(TESSDATA_UNICHARSET) &&
+           IsComponentAvailable(TESSDATA_INTTEMP);
   }
 
   // Returns true if the LSTM components are present.
-  bool IsLSTMAvailable() const { return !entries_[TESSDATA_LSTM].empty(); }
+  bool IsLSTMAvailable() const { return IsComponentAvailable(TESSDATA_LSTM); }
 
   // Return the name of the underlying data file.
   const STRING &GetDataFileName() const { return data_file_name_; }
@@ -218,6 +233,23 @@ class TessdataManager {
 
   // Use libarchive.
   bool LoadArchiveFile(const char *filename);
+  // Maps the file into memory to load it, saving a copy of the whole file.
+  bool LoadMappedFile(const char *filename);
+  // As the public LoadMemBuffer, but data is in the given mapping, which is
+  // kept for GetMappedComponent, if not null.
+  bool LoadMemBuffer(const char *name, const char *data, int size,
+                     const std::shared_ptr<const char> &mapping);
+  // Returns the size of the component, whether it is loaded or still only
+  // in the mapping.
+  int64_t ComponentSize(TessdataType type) const {
+    return mapped_entries_[type] != nullptr ? mapped_sizes_[type]
+                                            : entries_[type].size();
+  }
+  // Returns the bytes of the component, without loading it.
+  const char *ComponentData(TessdataType type) const;
+  // Copies the component out of the mapping, if it isn't yet, for callers
+  // that need it in entries_.
+  void LoadComponent(TessdataType type);
 
   /**
    * Fills type with TessdataType of the tessdata component represented by the
@@ -243,8 +275,15 @@ class TessdataManager {
   bool is_loaded_;
   // True if the bytes need swapping.
   bool swap_;
-  // Contents of each element of the traineddata file.
+  // Contents of each element of the traineddata file. The elements of a
+  // mapped file are only copied here when they are first asked for.
   GenericVector<char> entries_[TESSDATA_NUM_ENTRIES];
+  // The bytes of each element in the mapped file, if loaded by LoadMappedFile
+  // and not swapped. Each shares the ownership of the whole mapping.
+  std::shared_ptr<const char> mapped_entries_[TESSDATA_NUM_ENTRIES];
+  int64_t mapped_sizes_[TESSDATA_NUM_ENTRIES] = {};
+  // True for each element that has been asked for since the file was loaded.
+  mutable bool used_[TESSDATA_NUM_ENTRIES] = {};
 };
 
 }  // namespace tesseract
@@ -21,8 +21,10 @@
 #include "config_auto.h"
 #endif
 
+#include <atomic>
 #include <cstdio>
 #include <cstdarg>
+#include <cstring>
 #include "ccutil.h"
 #include "params.h"
 #include "strngs.h"
@@ -32,28 +34,48 @@
 
 static STRING_VAR(debug_file, "", "File to send tprintf output to");
 
+static std::atomic<TprintfCallback> tprintf_callback(nullptr);
+
+DLLSYM void SetTprintfCallback(TprintfCallback callback) {
+  tprintf_callback.store(callback);
+}
+
+// Returns true if the debug file discards all output.
+static bool DebugFileIsNull(const char* debug_file_name) {
+  if (debug_file_name == nullptr) return false;
+#ifdef _WIN32
+  if (strcmp(debug_file_name, "nul") == 0) return true;
+#endif
+  return strcmp(debug_file_name, "/dev/null") == 0;
+}
+
 // Trace printf
 DLLSYM void tprintf(const char *format, ...)
 {
-  tesseract::tprintfMutex.Lock();
-  va_list args;                  // variable args
+  TprintfCallback callback = tprintf_callback.load();
   const char* debug_file_name = debug_file.string();
-  static FILE *debugfp = nullptr;   // debug file
-                                 // debug window
-  int32_t offset = 0;              // into message
+  // Don't even format messages that nobody will see.
+  if (callback == nullptr && DebugFileIsNull(debug_file_name))
+    return;
+  va_list args;                  // variable args
   char msg[MAX_MSG_LEN + 1];
 
+  // Format without the lock, as msg is private to this call.
   va_start(args, format);  // variable list
-  // Format into msg
   #ifdef _WIN32
-  offset += _vsnprintf(msg + offset, MAX_MSG_LEN - offset, format, args);
-  if (debug_file_name && strcmp(debug_file_name, "/dev/null") == 0)
-    debug_file.set_value("nul");
+  _vsnprintf(msg, MAX_MSG_LEN, format, args);
   #else
-  offset += vsnprintf(msg + offset, MAX_MSG_LEN - offset, format, args);
+  vsnprintf(msg, MAX_MSG_LEN, format, args);
   #endif
   va_end(args);
+  msg[MAX_MSG_LEN] = '\0';
+  if (callback != nullptr) {
+    callback(msg);
+    return;
+  }
 
+  tesseract::tprintfMutex.Lock();
+  static FILE *debugfp = nullptr;   // debug file
   if (debugfp == nullptr && debug_file_name && strlen(debug_file_name) > 0) {
     debugfp = fopen(debug_file.string(), "wb");
   } else if (debugfp != nullptr && debug_file_name && strlen(debug_file_name) == 0) {
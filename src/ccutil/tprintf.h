@@ -22,6 +22,14 @@
 
 #include "platform.h"   // for TESS_API
 
+// Receives each formatted tprintf message in place of the debug file or
+// stderr. It may be called from several threads at once, without any lock.
+typedef void (*TprintfCallback)(const char* message);
+
+// Routes all tprintf output to callback, or back to the debug file or
+// stderr if callback is nullptr.
+extern TESS_API void SetTprintfCallback(TprintfCallback callback);
+
 // Main logging function.
 extern TESS_API void tprintf(  // Trace printf
     const char *format, ...);  // Message
@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tracing.cpp
+// Description: Scoped spans of time, exported as a Chrome trace.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "tracing.h"
+
+#include <chrono>   // for std::chrono::steady_clock
+#include <cstdio>   // for snprintf
+#include <cstring>  // for strcmp
+#include <mutex>    // for std::mutex
+
+namespace tesseract {
+
+// Spans beyond this many are dropped, so that a trace that is never stopped
+// can't use up the memory.
+const size_t kMaxTraceSpans = 1 << 22;
+
+struct TraceEvent {
+  const char* name;
+  int tid;
+  double start_us;
+  double end_us;
+};
+
+std::atomic<bool> Tracing::enabled_(false);
+
+static std::mutex trace_mutex;
+static std::vector<TraceEvent> trace_events;
+static int64_t dropped_spans = 0;
+static std::atomic<int> num_trace_threads(0);
+
+// Returns a small id of the calling thread, in the order in which the
+// threads first record a span.
+static int TraceThreadId() {
+  static thread_local int tid = ++num_trace_threads;
+  return tid;
+}
+
+void Tracing::Start() {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  trace_events.clear();
+  dropped_spans = 0;
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracing::Stop() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+double Tracing::NowMicros() {
+  std::chrono::duration<double, std::micro> now =
+      std::chrono::steady_clock::now().time_since_epoch();
+  return now.count();
+}
+
+void Tracing::Record(const char* name, double start_us, double end_us) {
+  int tid = TraceThreadId();
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  if (trace_events.size() >= kMaxTraceSpans) {
+    ++dropped_spans;
+    return;
+  }
+  trace_events.push_back({name, tid, start_us, end_us});
+}
+
+// Appends text to json as the contents of a JSON string.
+static void AppendJsonString(const char* text, std::string* json) {
+  for (const char* c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      *json += '\\';
+      *json += *c;
+    } else if (static_cast<unsigned char>(*c) < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", static_cast<int>(*c));
+      *json += escape;
+    } else {
+      *json += *c;
+    }
+  }
+}
+
+void Tracing::WriteChromeTrace(std::string* json) {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  // The times are relative to the first span, which keeps them short.
+  double origin = trace_events.empty() ? 0.0 : trace_events[0].start_us;
+  for (const TraceEvent& event : trace_events) {
+    if (event.start_us < origin) origin = event.start_us;
+  }
+  *json = "{\"traceEvents\":[";
+  for (size_t i = 0; i < trace_events.size(); ++i) {
+    const TraceEvent& event = trace_events[i];
+    if (i > 0) *json += ",\n";
+    *json += "{\"name\":\"";
+    AppendJsonString(event.name, json);
+    char fields[128];
+    snprintf(fields, sizeof(fields),
+             "\",\"cat\":\"tesseract\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+             "\"ts\":%.3f,\"dur\":%.3f}",
+             event.tid, event.start_us - origin,
+             event.end_us - event.start_us);
+    *json += fields;
+  }
+  char footer[96];
+  snprintf(footer, sizeof(footer),
+           "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":"
+           "%ld}}\n",
+           static_cast<long>(dropped_spans));
+  *json += footer;
+}
+
+void Tracing::GetTotals(std::vector<SpanTotal>* totals) {
+  totals->clear();
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  for (const TraceEvent& event : trace_events) {
+    // The same literal may have another address in another file.
+    size_t i = 0;
+    while (i < totals->size() &&
+           strcmp((*totals)[i].name.c_str(), event.name) != 0) {
+      ++i;
+    }
+    if (i == totals->size()) totals->push_back({event.name, 0, 0.0});
+    ++(*totals)[i].count;
+    (*totals)[i].total_us += event.end_us - event.start_us;
+  }
+}
+
+}  // namespace tesseract.
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tracing.h
+// Description: Scoped spans of time, exported as a Chrome trace.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CCUTIL_TRACING_H_
+#define TESSERACT_CCUTIL_TRACING_H_
+
+#include <atomic>   // for std::atomic
+#include <cstdint>  // for int64_t
+#include <string>   // for std::string
+#include <vector>   // for std::vector
+
+namespace tesseract {
+
+// Records the TraceSpans of all the threads of the process while it is
+// started, as the complete events of the Chrome trace event format, which
+// chrome://tracing and Perfetto show as nested spans per thread.
+// When it is stopped, a TraceSpan costs a relaxed atomic load.
+class Tracing {
+ public:
+  // The recorded spans of one name, added up.
+  struct SpanTotal {
+    std::string name;
+    int64_t count;
+    double total_us;
+  };
+
+  // Forgets the recorded spans and starts recording.
+  static void Start();
+  // Stops recording, keeping the recorded spans.
+  static void Stop();
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  // Sets json to the recorded spans in the JSON object format of the Chrome
+  // trace event format.
+  static void WriteChromeTrace(std::string* json);
+  // Sets totals to the recorded spans added up by name, in the order that
+  // the names were first recorded, which is the order in which the first of
+  // their spans ended, so a span comes after those that it encloses.
+  static void GetTotals(std::vector<SpanTotal>* totals);
+
+  // The time in microseconds since an arbitrary epoch.
+  static double NowMicros();
+  // Adds a span of the calling thread, with a name that must outlive the
+  // Tracing, as string literals do.
+  static void Record(const char* name, double start_us, double end_us);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Records a span named name, which must be a string literal or outlive the
+// Tracing otherwise, from its construction to its destruction, if tracing
+// is started at its construction.
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name)
+      : name_(Tracing::enabled() ? name : nullptr),
+        start_us_(name_ != nullptr ? Tracing::NowMicros() : 0.0) {}
+  ~TraceSpan() {
+    if (name_ != nullptr)
+      Tracing::Record(name_, start_us_, Tracing::NowMicros());
+  }
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name_;
+  double start_us_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_CCUTIL_TRACING_H_
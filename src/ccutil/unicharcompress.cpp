@@ -21,6 +21,7 @@
 #include "unicharcompress.h"
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
 #include "tprintf.h"
 
 namespace tesseract {
@@ -83,6 +84,15 @@ static bool DecodeRadicalTable(STRING* radical_data, RSMap* radical_map) {
   return true;
 }
 
+// Returns the index of code in codes, or -1 if it isn't there. The lists of
+// the decoding trie are short, except for state 0, which has a direct lookup.
+static int IndexOfCode(const GenericVector<int>& codes, int code) {
+  for (int i = 0; i < codes.size(); ++i) {
+    if (codes[i] == code) return i;
+  }
+  return -1;
+}
+
 UnicharCompress::UnicharCompress() : code_range_(0) {}
 UnicharCompress::UnicharCompress(const UnicharCompress& src) { *this = src; }
 UnicharCompress::~UnicharCompress() { Cleanup(); }
@@ -291,9 +301,35 @@ int UnicharCompress::EncodeUnichar(int unichar_id, RecodedCharID* code) const {
 int UnicharCompress::DecodeUnichar(const RecodedCharID& code) const {
   int len = code.length();
   if (len <= 0 || len > RecodedCharID::kMaxCodeLen) return INVALID_UNICHAR_ID;
-  auto it = decoder_.find(code);
-  if (it == decoder_.end()) return INVALID_UNICHAR_ID;
-  return it->second;
+  int last = code(len - 1);
+  if (len == 1) {
+    if (last < 0 || last >= code_range_) return INVALID_UNICHAR_ID;
+    return single_unichars_[last];
+  }
+  RecodedCharID prefix = code;
+  prefix.Truncate(len - 1);
+  int state = GetPrefixState(prefix);
+  if (state < 0) return INVALID_UNICHAR_ID;
+  int index = IndexOfCode(trie_[state].final_codes, last);
+  if (index < 0) return INVALID_UNICHAR_ID;
+  return trie_[state].final_unichars[index];
+}
+
+// Returns the state reached by the codes of prefix, or -1 if no code starts
+// with prefix. The state of the empty prefix is 0.
+int UnicharCompress::GetPrefixState(const RecodedCharID& prefix) const {
+  int len = prefix.length();
+  if (trie_.empty() || len > RecodedCharID::kMaxCodeLen) return -1;
+  if (len == 0) return 0;
+  int code = prefix(0);
+  if (code < 0 || code >= code_range_) return -1;
+  int state = first_states_[code];
+  for (int i = 1; i < len && state >= 0; ++i) {
+    const TrieState& trie_state = trie_[state];
+    int index = IndexOfCode(trie_state.next_codes, prefix(i));
+    state = index < 0 ? -1 : trie_state.next_states[index];
+  }
+  return state;
 }
 
 // Writes to the given file. Returns false in case of error.
@@ -369,56 +405,55 @@ void UnicharCompress::ComputeCodeRange() {
   ++code_range_;
 }
 
-// Initializes the decoding hash_map from the encoding array.
+// Initializes the decoding trie from the encoding array.
+// The codes are added in order, so the lists of each state are in order of
+// first use by the encoder_. A repeated code decodes to its last unichar-id.
 void UnicharCompress::SetupDecoder() {
   Cleanup();
   is_valid_start_.init_to_size(code_range_, false);
+  first_states_.init_to_size(code_range_, -1);
+  single_unichars_.init_to_size(code_range_, INVALID_UNICHAR_ID);
+  trie_.resize(1);
   for (int c = 0; c < encoder_.size(); ++c) {
     const RecodedCharID& code = encoder_[c];
-    decoder_[code] = c;
-    is_valid_start_[code(0)] = true;
-    RecodedCharID prefix = code;
     int len = code.length() - 1;
-    prefix.Truncate(len);
-    auto final_it = final_codes_.find(prefix);
-    if (final_it == final_codes_.end()) {
-      auto* code_list = new GenericVectorEqEq<int>;
-      code_list->push_back(code(len));
-      final_codes_[prefix] = code_list;
-      while (--len >= 0) {
-        prefix.Truncate(len);
-        auto next_it = next_codes_.find(prefix);
-        if (next_it == next_codes_.end()) {
-          auto* code_list = new GenericVectorEqEq<int>;
-          code_list->push_back(code(len));
-          next_codes_[prefix] = code_list;
-        } else {
-          // We still have to search the list as we may get here via multiple
-          // lengths of code.
-          if (!next_it->second->contains(code(len)))
-            next_it->second->push_back(code(len));
-          break;  // This prefix has been processed.
-        }
+    is_valid_start_[code(0)] = true;
+    int state = 0;
+    for (int i = 0; i < len; ++i) {
+      int next_state = -1;
+      if (state == 0) {
+        next_state = first_states_[code(i)];
+      } else {
+        int index = IndexOfCode(trie_[state].next_codes, code(i));
+        if (index >= 0) next_state = trie_[state].next_states[index];
+      }
+      if (next_state < 0) {
+        next_state = trie_.size();
+        trie_.emplace_back();
+        trie_[state].next_codes.push_back(code(i));
+        trie_[state].next_states.push_back(next_state);
+        if (state == 0) first_states_[code(i)] = next_state;
       }
+      state = next_state;
+    }
+    TrieState& final_state = trie_[state];
+    int index = IndexOfCode(final_state.final_codes, code(len));
+    if (index < 0) {
+      final_state.final_codes.push_back(code(len));
+      final_state.final_unichars.push_back(c);
     } else {
-      if (!final_it->second->contains(code(len)))
-        final_it->second->push_back(code(len));
+      final_state.final_unichars[index] = c;
     }
+    if (len == 0) single_unichars_[code(0)] = c;
   }
 }
 
 // Frees allocated memory.
 void UnicharCompress::Cleanup() {
-  decoder_.clear();
   is_valid_start_.clear();
-  for (auto& next_code : next_codes_) {
-    delete next_code.second;
-  }
-  for (auto& final_code : final_codes_) {
-    delete final_code.second;
-  }
-  next_codes_.clear();
-  final_codes_.clear();
+  first_states_.clear();
+  single_unichars_.clear();
+  trie_.clear();
 }
 
 }  // namespace tesseract.
@@ -22,7 +22,7 @@
 #ifndef TESSERACT_CCUTIL_UNICHARCOMPRESS_H_
 #define TESSERACT_CCUTIL_UNICHARCOMPRESS_H_
 
-#include <unordered_map>
+#include <vector>
 
 #include "serialis.h"
 #include "strngs.h"
@@ -171,14 +171,39 @@ class UnicharCompress {
   // Returns a list of valid non-final next codes for a given prefix code,
   // which may be empty.
   const GenericVector<int>* GetNextCodes(const RecodedCharID& code) const {
-    auto it = next_codes_.find(code);
-    return it == next_codes_.end() ? nullptr : it->second;
+    return GetNextCodes(GetPrefixState(code));
   }
   // Returns a list of valid final codes for a given prefix code, which may
   // be empty.
   const GenericVector<int>* GetFinalCodes(const RecodedCharID& code) const {
-    auto it = final_codes_.find(code);
-    return it == final_codes_.end() ? nullptr : it->second;
+    return GetFinalCodes(GetPrefixState(code));
+  }
+
+  // The decoder is a trie of the codes, whose states are the prefixes of the
+  // codes, so a decoder can follow a code sequence without hashing it.
+  // Returns the state reached by the codes of prefix, or -1 if no code starts
+  // with prefix. The state of the empty prefix is 0.
+  int GetPrefixState(const RecodedCharID& prefix) const;
+  // Returns the list of valid non-final next codes from the given state, or
+  // nullptr if there are none.
+  const GenericVector<int>* GetNextCodes(int state) const {
+    if (state < 0 || trie_[state].next_codes.empty()) return nullptr;
+    return &trie_[state].next_codes;
+  }
+  // Returns the state reached by the index-th entry of GetNextCodes(state).
+  int GetNextState(int state, int index) const {
+    return trie_[state].next_states[index];
+  }
+  // Returns the list of valid final codes from the given state, or nullptr if
+  // there are none.
+  const GenericVector<int>* GetFinalCodes(int state) const {
+    if (state < 0 || trie_[state].final_codes.empty()) return nullptr;
+    return &trie_[state].final_codes;
+  }
+  // Returns the unichar-id completed by the index-th entry of
+  // GetFinalCodes(state).
+  int GetFinalUnichar(int state, int index) const {
+    return trie_[state].final_unichars[index];
   }
 
   // Writes to the given file. Returns false in case of error.
@@ -207,7 +232,7 @@ class UnicharCompress {
   void DefragmentCodeValues(int encoded_null);
   // Computes the value of code_range_ from the encoder_.
   void ComputeCodeRange();
-  // Initializes the decoding hash_map from the encoder_ array.
+  // Initializes the decoding trie from the encoder_ array.
   void SetupDecoder();
   // Frees allocated memory.
   void Cleanup();
@@ -215,21 +240,25 @@ class UnicharCompress {
   // The encoder that maps a unichar-id to a sequence of small codes.
   // encoder_ is the only part that is serialized. The rest is computed on load.
   GenericVector<RecodedCharID> encoder_;
-  // Decoder converts the output of encoder back to a unichar-id.
-  std::unordered_map<RecodedCharID, int, RecodedCharID::RecodedCharIDHash>
-      decoder_;
+  // A state of the decoding trie, being a prefix of one or more codes.
+  struct TrieState {
+    // Valid non-final next codes, and the states that they lead to.
+    GenericVector<int> next_codes;
+    GenericVector<int> next_states;
+    // Valid final codes, and the unichar-ids that they complete.
+    GenericVector<int> final_codes;
+    GenericVector<int> final_unichars;
+  };
+  // The states of the decoding trie, which converts the output of encoder
+  // back to a unichar-id. State 0 is the empty prefix.
+  std::vector<TrieState> trie_;
+  // The state reached from state 0 by each code, or -1, so that the widest
+  // state, which has an entry for every valid start code, is a direct lookup.
+  GenericVector<int> first_states_;
+  // The unichar-id of each code as a single code, or INVALID_UNICHAR_ID.
+  GenericVector<int> single_unichars_;
   // True if the index is a valid single or start code.
   GenericVector<bool> is_valid_start_;
-  // Maps a prefix code to a list of valid next codes.
-  // The map owns the vectors.
-  std::unordered_map<RecodedCharID, GenericVectorEqEq<int>*,
-                     RecodedCharID::RecodedCharIDHash>
-      next_codes_;
-  // Maps a prefix code to a list of valid final codes.
-  // The map owns the vectors.
-  std::unordered_map<RecodedCharID, GenericVectorEqEq<int>*,
-                     RecodedCharID::RecodedCharIDHash>
-      final_codes_;
   // Max of any value in encoder_ + 1.
   int code_range_;
 };
@@ -78,10 +78,16 @@ void UNICHARMAP::insert(const char* const unichar_repr, UNICHAR_ID id) {
 // found the right unichar_repr.
 bool UNICHARMAP::contains(const char* const unichar_repr,
                           int length) const {
-  if (unichar_repr == nullptr || *unichar_repr == '\0') return false;
-  if (length <= 0 || length > UNICHAR_LEN) return false;
+  if (unichar_repr == nullptr) return false;
+  return find(unichar_repr, length) >= 0;
+}
+
+// As contains, but returning the id that was found.
+UNICHAR_ID UNICHARMAP::find(const char* const unichar_repr,
+                            int length) const {
+  if (*unichar_repr == '\0') return INVALID_UNICHAR_ID;
+  if (length <= 0 || length > UNICHAR_LEN) return INVALID_UNICHAR_ID;
   int index = 0;
-  if (unichar_repr[index] == '\0') return false;
   UNICHARMAP_NODE* current_nodes = nodes;
 
   while (current_nodes != nullptr && index + 1 < length &&
@@ -90,9 +96,26 @@ bool UNICHARMAP::contains(const char* const unichar_repr,
         current_nodes[static_cast<unsigned char>(unichar_repr[index])].children;
     ++index;
   }
-  return current_nodes != nullptr &&
-         (index + 1 >= length || unichar_repr[index + 1] == '\0') &&
-         current_nodes[static_cast<unsigned char>(unichar_repr[index])].id >= 0;
+  if (current_nodes == nullptr) return INVALID_UNICHAR_ID;
+  UNICHAR_ID id =
+      current_nodes[static_cast<unsigned char>(unichar_repr[index])].id;
+  return id >= 0 ? id : INVALID_UNICHAR_ID;
+}
+
+// Search the given unichar representation in the tree once, recording the id
+// of each node on the way.
+int UNICHARMAP::prefix_ids(const char* const unichar_repr, int length,
+                           UNICHAR_ID* prefix_ids) const {
+  UNICHARMAP_NODE* current_nodes = nodes;
+  int index = 0;
+  while (current_nodes != nullptr && index < length &&
+         unichar_repr[index] != '\0') {
+    const UNICHARMAP_NODE& node =
+        current_nodes[static_cast<unsigned char>(unichar_repr[index])];
+    prefix_ids[index++] = node.id >= 0 ? node.id : INVALID_UNICHAR_ID;
+    current_nodes = node.children;
+  }
+  return index;
 }
 
 // Return the minimum number of characters that must be used from this string
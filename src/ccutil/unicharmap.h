@@ -47,6 +47,19 @@ class UNICHARMAP {
   // used. The length MUST be non-zero.
   bool contains(const char* const unichar_repr, int length) const;
 
+  // Return the id associated with the given unichar representation, or
+  // INVALID_UNICHAR_ID if it is not present. The first length characters
+  // (maximum) from unichar_repr are used.
+  UNICHAR_ID find(const char* const unichar_repr, int length) const;
+
+  // Walk the tree once along unichar_repr, using length characters from it
+  // maximum, setting prefix_ids[i] to the id of its first i + 1 characters,
+  // or to INVALID_UNICHAR_ID if they are not present. Return the number of
+  // characters walked, beyond which no prefix can be present. prefix_ids
+  // must have room for length ids.
+  int prefix_ids(const char* const unichar_repr, int length,
+                 UNICHAR_ID* prefix_ids) const;
+
   // Return the minimum number of characters that must be used from this string
   // to obtain a match in the UNICHARMAP.
   int minmatch(const char* const unichar_repr) const;
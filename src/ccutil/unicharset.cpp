@@ -26,6 +26,7 @@
 #include <locale>     // for std::locale::classic
 #include <sstream>    // for std::istringstream, std::ostringstream
 
+#include "initprofile.h"
 #include "params.h"
 #include "serialis.h"
 #include "tesscallback.h"
@@ -210,9 +211,7 @@ UNICHAR_ID
 UNICHARSET::unichar_to_id(const char* const unichar_repr) const {
   std::string cleaned =
       old_style_included_ ? unichar_repr : CleanupString(unichar_repr);
-  return ids.contains(cleaned.data(), cleaned.size())
-             ? ids.unichar_to_id(cleaned.data(), cleaned.size())
-             : INVALID_UNICHAR_ID;
+  return ids.find(cleaned.data(), cleaned.size());
 }
 
 UNICHAR_ID UNICHARSET::unichar_to_id(const char* const unichar_repr,
@@ -220,9 +219,7 @@ UNICHAR_ID UNICHARSET::unichar_to_id(const char* const unichar_repr,
   assert(length > 0 && length <= UNICHAR_LEN);
   std::string cleaned(unichar_repr, length);
   if (!old_style_included_) cleaned = CleanupString(unichar_repr, length);
-  return ids.contains(cleaned.data(), cleaned.size())
-             ? ids.unichar_to_id(cleaned.data(), cleaned.size())
-             : INVALID_UNICHAR_ID;
+  return ids.find(cleaned.data(), cleaned.size());
 }
 
 // Return the minimum number of bytes that matches a legal UNICHAR_ID,
@@ -268,8 +265,11 @@ bool UNICHARSET::encode_string(const char* str, bool give_up_on_failure,
   int str_pos = 0;
   bool perfect = true;
   while (str_pos < str_length) {
+    int best_pending = -1;
     encode_string(str, str_pos, str_length, &working_encoding, &working_lengths,
-                  &str_pos, encoding, &best_lengths);
+                  &str_pos, encoding, &best_lengths, &best_pending);
+    SaveBestEncoding(working_encoding, working_lengths, &best_pending,
+                     encoding, &best_lengths);
     if (str_pos < str_length) {
       // This is a non-match. Skip one utf-8 character.
       perfect = false;
@@ -504,37 +504,65 @@ void UNICHARSET::encode_string(const char* str, int str_index, int str_length,
                                GenericVector<char>* lengths,
                                int* best_total_length,
                                GenericVector<UNICHAR_ID>* best_encoding,
-                               GenericVector<char>* best_lengths) const {
+                               GenericVector<char>* best_lengths,
+                               int* best_pending) const {
   if (str_index > *best_total_length) {
-    // This is the best result so far.
+    // This is the best result so far. It is only copied out of encoding
+    // before encoding is truncated, so a string that encodes at the first
+    // try isn't copied at every step.
     *best_total_length = str_index;
-    *best_encoding = *encoding;
-    if (best_lengths != nullptr)
-      *best_lengths = *lengths;
+    *best_pending = encoding->size();
   }
   if (str_index == str_length) return;
   int encoding_index = encoding->size();
+  // Find the ids of all the prefixes of the rest of str in a single walk.
+  UNICHAR_ID prefix_ids[UNICHAR_LEN];
+  int max_length = ids.prefix_ids(str + str_index,
+                                  std::min(UNICHAR_LEN, str_length - str_index),
+                                  prefix_ids);
   // Find the length of the first matching unicharset member.
-  int length = ids.minmatch(str + str_index);
-  if (length == 0 || str_index + length > str_length) return;
-  do {
-    if (ids.contains(str + str_index, length)) {
+  int length = 1;
+  while (length <= max_length && prefix_ids[length - 1] == INVALID_UNICHAR_ID)
+    ++length;
+  while (length <= max_length) {
+    UNICHAR_ID id = prefix_ids[length - 1];
+    if (id != INVALID_UNICHAR_ID) {
       // Successful encoding so far.
-      UNICHAR_ID id = ids.unichar_to_id(str + str_index, length);
       encoding->push_back(id);
       lengths->push_back(length);
       encode_string(str, str_index + length, str_length, encoding, lengths,
-                    best_total_length, best_encoding, best_lengths);
+                    best_total_length, best_encoding, best_lengths,
+                    best_pending);
       if (*best_total_length == str_length)
         return;  // Tail recursion success!
       // Failed with that length, truncate back and try again.
+      if (*best_pending > encoding_index) {
+        SaveBestEncoding(*encoding, *lengths, best_pending, best_encoding,
+                         best_lengths);
+      }
       encoding->truncate(encoding_index);
       lengths->truncate(encoding_index);
     }
     int step = UNICHAR::utf8_step(str + str_index + length);
     if (step == 0) step = 1;
     length += step;
-  } while (length <= UNICHAR_LEN && str_index + length <= str_length);
+  }
+}
+
+// Copies the best encoding out of the start of encoding, if it is there.
+void UNICHARSET::SaveBestEncoding(const GenericVector<UNICHAR_ID>& encoding,
+                                  const GenericVector<char>& lengths,
+                                  int* best_pending,
+                                  GenericVector<UNICHAR_ID>* best_encoding,
+                                  GenericVector<char>* best_lengths) {
+  if (*best_pending < 0) return;
+  best_encoding->truncate(0);
+  if (best_lengths != nullptr) best_lengths->truncate(0);
+  for (int i = 0; i < *best_pending; ++i) {
+    best_encoding->push_back(encoding[i]);
+    if (best_lengths != nullptr) best_lengths->push_back(lengths[i]);
+  }
+  *best_pending = -1;
 }
 
 // Gets the properties for a grapheme string, combining properties for
@@ -788,6 +816,7 @@ bool UNICHARSET::load_from_file(FILE *file, bool skip_fragments) {
 }
 
 bool UNICHARSET::load_from_file(tesseract::TFile *file, bool skip_fragments) {
+  tesseract::InitPhase phase("unicharset");
   TessResultCallback2<char *, char *, int> *fgets_cb =
       NewPermanentTessCallback(file, &tesseract::TFile::FGets);
   bool success = load_via_fgets(fgets_cb, skip_fragments);
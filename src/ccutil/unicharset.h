@@ -976,7 +976,9 @@ class UNICHARSET {
   // lengths is a working set of lengths of each element of encoding.
   // best_total_length is the longest length of str that has been successfully
   // encoded so far.
-  // On return:
+  // best_pending is the size of the start of encoding that is the best
+  // encoding, or -1 if best_encoding already has it.
+  // On return, after SaveBestEncoding:
   // best_encoding contains the encoding that used the longest part of str.
   // best_lengths (may be null) contains the lengths of best_encoding.
   void encode_string(const char* str, int str_index, int str_length,
@@ -984,7 +986,15 @@ class UNICHARSET {
                      GenericVector<char>* lengths,
                      int* best_total_length,
                      GenericVector<UNICHAR_ID>* best_encoding,
-                     GenericVector<char>* best_lengths) const;
+                     GenericVector<char>* best_lengths,
+                     int* best_pending) const;
+  // Copies the best encoding out of encoding and lengths, if best_pending
+  // says it is there, and resets best_pending.
+  static void SaveBestEncoding(const GenericVector<UNICHAR_ID>& encoding,
+                               const GenericVector<char>& lengths,
+                               int* best_pending,
+                               GenericVector<UNICHAR_ID>* best_encoding,
+                               GenericVector<char>* best_lengths);
 
   // Gets the properties for a grapheme string, combining properties for
   // multiple characters in a meaningful way where possible.
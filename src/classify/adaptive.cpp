@@ -190,6 +190,40 @@ void free_adapted_templates(ADAPT_TEMPLATES templates) {
 }
 
 
+/*---------------------------------------------------------------------------*/
+/**
+ * Returns an estimate of the bytes held by the adapted templates, including
+ * their integer templates.
+ */
+int64_t AdaptedTemplatesBytes(ADAPT_TEMPLATES templates) {
+  if (templates == nullptr) return 0;
+  int64_t bytes =
+      sizeof(ADAPT_TEMPLATES_STRUCT) + IntTemplatesBytes(templates->Templates);
+  for (int i = 0; i < (templates->Templates)->NumClasses; i++) {
+    ADAPT_CLASS adapt_class = templates->Class[i];
+    if (adapt_class == nullptr) continue;
+    bytes += sizeof(ADAPT_CLASS_STRUCT) +
+             (WordsInVectorOfSize(MAX_NUM_PROTOS) +
+              WordsInVectorOfSize(MAX_NUM_CONFIGS)) * sizeof(uint32_t) +
+             count(adapt_class->TempProtos) * sizeof(TEMP_PROTO_STRUCT);
+    for (int c = 0; c < MAX_NUM_CONFIGS; c++) {
+      if (ConfigIsPermanent(adapt_class, c)) {
+        PERM_CONFIG config = PermConfigFor(adapt_class, c);
+        if (config == nullptr) continue;
+        int num_ambigs = 0;
+        while (config->Ambigs[num_ambigs] > 0) ++num_ambigs;
+        bytes += sizeof(PERM_CONFIG_STRUCT) +
+                 (num_ambigs + 1) * sizeof(UNICHAR_ID);
+      } else if (TempConfigFor(adapt_class, c) != nullptr) {
+        bytes += sizeof(TEMP_CONFIG_STRUCT) +
+                 TempConfigFor(adapt_class, c)->ProtoVectorSize *
+                     sizeof(uint32_t);
+      }
+    }
+  }
+  return bytes;
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine allocates and returns a new temporary config.
@@ -110,6 +110,8 @@ void free_adapted_class(ADAPT_CLASS adapt_class);
 
 void free_adapted_templates(ADAPT_TEMPLATES templates);
 
+int64_t AdaptedTemplatesBytes(ADAPT_TEMPLATES templates);
+
 TEMP_CONFIG NewTempConfig(int MaxProtoId, int FontinfoId);
 
 TEMP_PROTO NewTempProto();
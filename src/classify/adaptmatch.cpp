@@ -35,6 +35,7 @@
 #include "blobs.h"              // for TBLOB, TWERD
 #include "callcpp.h"            // for cprintf, window_wait
 #include "classify.h"           // for Classify, CST_FRAGMENT, CST_WHOLE
+#include "counters.h"           // for CountEvent, COUNTER_CLASSIFIER_CALLS
 #include "dict.h"               // for Dict
 #include "errcode.h"            // for ASSERT_HOST
 #include "featdefs.h"           // for CharNormDesc
@@ -42,6 +43,7 @@
 #include "fontinfo.h"           // for ScoredFont, FontSet
 #include "genericvector.h"      // for GenericVector
 #include "helpers.h"            // for IntCastRounded, ClipToRange
+#include "initprofile.h"        // for InitPhase
 #include "intfx.h"              // for BlobToTrainingSample, INT_FX_RESULT_S...
 #include "intmatcher.h"         // for CP_RESULT_STRUCT, IntegerMatcher
 #include "intproto.h"           // for INT_FEATURE_STRUCT, (anonymous), Clas...
@@ -190,6 +192,15 @@ namespace tesseract {
  */
 void Classify::AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices) {
   assert(Choices != nullptr);
+  CountEvent(COUNTER_CLASSIFIER_CALLS);
+  // Unless there is debug output to show, a blob classified before with the
+  // same templates gets a copy of the same choices.
+  bool use_cache = matcher_debug_level < 1 && !classify_enable_adaptive_debugger;
+  BlobChoiceKey key;
+  if (use_cache) {
+    key = BlobChoiceCache::MakeKey(*Blob);
+    if (blob_choice_cache_.Lookup(key, Choices)) return;
+  }
   auto *Results = new ADAPT_RESULTS;
   Results->Initialize();
 
@@ -219,8 +230,15 @@ void Classify::AdaptiveClassifier(TBLOB *Blob, BLOB_CHOICE_LIST *Choices) {
 #endif
 
   delete Results;
+  if (use_cache) blob_choice_cache_.Store(key, Choices);
 }                                /* AdaptiveClassifier */
 
+// Forgets the choices remembered by AdaptiveClassifier. Called whenever the
+// adapted templates change, and at the start of each page.
+void Classify::ClearBlobChoiceCache() {
+  blob_choice_cache_.Clear();
+}
+
 // If *win is nullptr, sets it to a new ScrollView() object with title msg.
 // Clears the window and draws baselines.
 void Classify::RefreshDebugWindow(ScrollView **win, const char *msg,
@@ -460,6 +478,7 @@ void Classify::EndAdaptiveClassifier() {
   STRING Filename;
   FILE *File;
 
+  ClearBlobChoiceCache();
   if (AdaptedTemplates != nullptr &&
       classify_enable_adaptive_matcher && classify_save_adapted_templates) {
     Filename = imagefile + ADAPT_TEMPLATE_SUFFIX;
@@ -534,10 +553,14 @@ void Classify::InitAdaptiveClassifier(TessdataManager* mgr) {
   // adaptive only.
   if (language_data_path_prefix.length() > 0 && mgr != nullptr) {
     TFile fp;
-    ASSERT_HOST(mgr->GetComponent(TESSDATA_INTTEMP, &fp));
-    PreTrainedTemplates = ReadIntTemplates(&fp);
+    {
+      InitPhase phase("inttemp");
+      ASSERT_HOST(mgr->GetComponent(TESSDATA_INTTEMP, &fp));
+      PreTrainedTemplates = ReadIntTemplates(&fp);
+    }
 
     if (mgr->GetComponent(TESSDATA_SHAPE_TABLE, &fp)) {
+      InitPhase phase("shapetable");
       shape_table_ = new ShapeTable(unicharset);
       if (!shape_table_->DeSerialize(&fp)) {
         tprintf("Error loading shape table!\n");
@@ -546,11 +569,17 @@ void Classify::InitAdaptiveClassifier(TessdataManager* mgr) {
       }
     }
 
-    ASSERT_HOST(mgr->GetComponent(TESSDATA_PFFMTABLE, &fp));
-    ReadNewCutoffs(&fp, CharNormCutoffs);
+    {
+      InitPhase phase("pffmtable");
+      ASSERT_HOST(mgr->GetComponent(TESSDATA_PFFMTABLE, &fp));
+      ReadNewCutoffs(&fp, CharNormCutoffs);
+    }
 
-    ASSERT_HOST(mgr->GetComponent(TESSDATA_NORMPROTO, &fp));
-    NormProtos = ReadNormProtos(&fp);
+    {
+      InitPhase phase("normproto");
+      ASSERT_HOST(mgr->GetComponent(TESSDATA_NORMPROTO, &fp));
+      NormProtos = ReadNormProtos(&fp);
+    }
     static_classifier_ = new TessClassifier(false, this);
   }
 
@@ -596,6 +625,7 @@ void Classify::InitAdaptiveClassifier(TessdataManager* mgr) {
 }                                /* InitAdaptiveClassifier */
 
 void Classify::ResetAdaptiveClassifierInternal() {
+  ClearBlobChoiceCache();
   if (classify_learning_debug_level > 0) {
     tprintf("Resetting adaptive classifier (NumAdaptationsFailed=%d)\n",
             NumAdaptationsFailed);
@@ -619,6 +649,7 @@ void Classify::SwitchAdaptiveClassifier() {
     tprintf("Switch to backup adaptive classifier (NumAdaptationsFailed=%d)\n",
             NumAdaptationsFailed);
   }
+  ClearBlobChoiceCache();
   free_adapted_templates(AdaptedTemplates);
   AdaptedTemplates = BackupAdaptedTemplates;
   BackupAdaptedTemplates = nullptr;
@@ -632,6 +663,40 @@ void Classify::StartBackupAdaptiveClassifier() {
   BackupAdaptedTemplates = NewAdaptedTemplates(true);
 }
 
+// Writes the current adapted templates to filename. Returns false on error.
+bool Classify::SaveAdaptedTemplates(const char* filename) {
+  if (AdaptedTemplates == nullptr) return false;
+  FILE* File = fopen(filename, "wb");
+  if (File == nullptr) return false;
+  WriteAdaptedTemplates(File, AdaptedTemplates);
+  return fclose(File) == 0;
+}
+
+// Replaces the adapted templates with those read from filename.
+// Returns false on error.
+bool Classify::LoadAdaptedTemplates(const char* filename) {
+  TFile fp;
+  if (!fp.Open(filename, nullptr)) return false;
+  ClearBlobChoiceCache();
+  // The font tables are part of the snapshot, including any font sets added
+  // by adaption, and reading them overwrites the entries without freeing them.
+  fontinfo_table_.clear();
+  fontset_table_.clear();
+  ADAPT_TEMPLATES templates = ReadAdaptedTemplates(&fp);
+  if (AdaptedTemplates != nullptr)
+    free_adapted_templates(AdaptedTemplates);
+  AdaptedTemplates = templates;
+  if (BackupAdaptedTemplates != nullptr) {
+    free_adapted_templates(BackupAdaptedTemplates);
+    BackupAdaptedTemplates = nullptr;
+  }
+  NumAdaptationsFailed = 0;
+  for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
+    BaselineCutoffs[i] = CharNormCutoffs[i];
+  }
+  return true;
+}
+
 /*---------------------------------------------------------------------------*/
 /**
  * This routine prepares the adaptive
@@ -864,6 +929,8 @@ void Classify::AdaptToChar(TBLOB* Blob, CLASS_ID ClassId, int FontinfoId,
 
   if (!LegalClassId (ClassId))
     return;
+  // Whether or not the adaption succeeds, the templates may change.
+  ClearBlobChoiceCache();
 
   int_result.unichar_id = ClassId;
   Class = adaptive_templates->Class[ClassId];
@@ -1097,6 +1164,7 @@ void Classify::MasterMatcher(INT_TEMPLATES templates,
                              ADAPT_RESULTS* final_results) {
   int top = blob_box.top();
   int bottom = blob_box.bottom();
+  const bool is_debug = matcher_debug_level >= 2 || classify_debug_level > 1;
   UnicharRating int_result;
   for (int c = 0; c < results.size(); c++) {
     CLASS_ID class_id = results[c].Class;
@@ -1111,7 +1179,6 @@ void Classify::MasterMatcher(INT_TEMPLATES templates,
               num_features, features,
               &int_result, classify_adapt_feature_threshold, debug,
               matcher_debug_separate_windows);
-    bool is_debug = matcher_debug_level >= 2 || classify_debug_level > 1;
     ExpandShapesAndApplyCorrections(classes, is_debug, class_id, bottom, top,
                                     results[c].Rating,
                                     final_results->BlobLength,
@@ -1531,7 +1598,9 @@ void Classify::DoAdaptiveMatch(TBLOB *Blob, ADAPT_RESULTS *Results) {
   UNICHAR_ID *Ambiguities;
 
   INT_FX_RESULT_STRUCT fx_info;
-  GenericVector<INT_FEATURE_STRUCT> bl_features;
+  // Every classified blob comes through here, so the features go in a buffer
+  // kept per thread. DoAdaptiveMatch isn't reentered while they are in use.
+  thread_local GenericVector<INT_FEATURE_STRUCT> bl_features;
   TrainingSample* sample =
       BlobToTrainingSample(*Blob, classify_nonlinear_norm, &fx_info,
                            &bl_features);
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////
+// File:        blobchoicecache.cpp
+// Description: Cache of the choices of the adaptive classifier for blobs
+//              that are classified again unchanged.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "blobchoicecache.h"
+
+#include "blobs.h"     // for TBLOB, TESSLINE, EDGEPT
+#include "coutln.h"    // for C_OUTLINE
+#include "normalis.h"  // for DENORM
+
+namespace tesseract {
+
+// Accumulates a 64-bit FNV-1a hash of the bytes of the values it is given.
+class BlobHasher {
+ public:
+  template <typename T>
+  void Add(const T& value) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0; i < sizeof(value); ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ULL;
+    }
+  }
+  uint64_t hash() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 14695981039346656037ULL;
+};
+
+// Adds the steps of outline and their edge offsets to hasher.
+static void HashSourceOutline(const C_OUTLINE& outline, BlobHasher* hasher) {
+  hasher->Add(outline.start_pos().x());
+  hasher->Add(outline.start_pos().y());
+  hasher->Add(outline.pathlength());
+  ICOORD origin;
+  for (int i = 0; i < outline.pathlength(); ++i) {
+    FCOORD pos = outline.sub_pixel_pos_at_index(origin, i);
+    hasher->Add(outline.chain_code(i));
+    hasher->Add(outline.edge_strength_at_index(i));
+    hasher->Add(outline.direction_at_index(i));
+    hasher->Add(pos.x());
+    hasher->Add(pos.y());
+  }
+}
+
+BlobChoiceKey BlobChoiceCache::MakeKey(const TBLOB& blob) {
+  BlobChoiceKey key;
+  key.box = blob.bounding_box();
+  key.num_outlines = 0;
+  key.num_points = 0;
+  key.num_steps = 0;
+  BlobHasher hasher;
+  const DENORM& denorm = blob.denorm();
+  hasher.Add(denorm.inverse());
+  const TPOINT corners[] = {TPOINT(key.box.left(), key.box.bottom()),
+                            TPOINT(key.box.right(), key.box.bottom()),
+                            TPOINT(key.box.left(), key.box.top())};
+  for (const TPOINT& corner : corners) {
+    FCOORD original;
+    denorm.DenormTransform(nullptr, FCOORD(corner.x, corner.y), &original);
+    hasher.Add(original.x());
+    hasher.Add(original.y());
+  }
+  for (const TESSLINE* outline = blob.outlines; outline != nullptr;
+       outline = outline->next) {
+    ++key.num_outlines;
+    hasher.Add(outline->is_hole);
+    const C_OUTLINE* prev_src = nullptr;
+    const EDGEPT* pt = outline->loop;
+    do {
+      ++key.num_points;
+      key.num_steps += pt->step_count;
+      hasher.Add(pt->pos.x);
+      hasher.Add(pt->pos.y);
+      for (char flag : pt->flags) hasher.Add(flag);
+      hasher.Add(pt->start_step);
+      hasher.Add(pt->step_count);
+      if (pt->src_outline != nullptr && pt->src_outline != prev_src) {
+        HashSourceOutline(*pt->src_outline, &hasher);
+      }
+      prev_src = pt->src_outline;
+      pt = pt->next;
+    } while (pt != outline->loop);
+  }
+  key.hash = hasher.hash();
+  return key;
+}
+
+bool BlobChoiceCache::Lookup(const BlobChoiceKey& key,
+                             BLOB_CHOICE_LIST* choices) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key.hash);
+  if (it == entries_.end() || it->second.key != key) return false;
+  BLOB_CHOICE_LIST copy;
+  copy.deep_copy(it->second.choices, &BLOB_CHOICE::deep_copy);
+  BLOB_CHOICE_IT choice_it(choices);
+  choice_it.add_list_after(&copy);
+  return true;
+}
+
+void BlobChoiceCache::Store(const BlobChoiceKey& key,
+                            const BLOB_CHOICE_LIST* choices) {
+  auto* copy = new BLOB_CHOICE_LIST;
+  copy->deep_copy(choices, &BLOB_CHOICE::deep_copy);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key.hash);
+  if (it != entries_.end()) {
+    // Another thread got here first, or a different blob has the same hash.
+    delete it->second.choices;
+    it->second.key = key;
+    it->second.choices = copy;
+    return;
+  }
+  if (entries_.size() >= kMaxSize) {
+    for (auto& entry : entries_) delete entry.second.choices;
+    entries_.clear();
+  }
+  entries_.emplace(key.hash, Entry{key, copy});
+}
+
+void BlobChoiceCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& entry : entries_) delete entry.second.choices;
+  entries_.clear();
+}
+
+size_t BlobChoiceCache::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+}  // namespace tesseract
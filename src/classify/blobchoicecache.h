@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////
+// File:        blobchoicecache.h
+// Description: Cache of the choices of the adaptive classifier for blobs
+//              that are classified again unchanged.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_CLASSIFY_BLOBCHOICECACHE_H_
+#define TESSERACT_CLASSIFY_BLOBCHOICECACHE_H_
+
+#include <cstdint>        // for uint64_t
+#include <mutex>          // for std::mutex
+#include <unordered_map>  // for std::unordered_map
+#include "ratngs.h"       // for BLOB_CHOICE_LIST
+#include "rect.h"         // for TBOX
+
+struct TBLOB;
+
+namespace tesseract {
+
+// Identifies a blob in the BlobChoiceCache. The hash covers everything the
+// features are computed from; the rest is an exact fingerprint compared on
+// every hit, so two blobs whose hashes collide never share choices.
+struct BlobChoiceKey {
+  bool operator==(const BlobChoiceKey& other) const {
+    return hash == other.hash && box == other.box &&
+           num_outlines == other.num_outlines &&
+           num_points == other.num_points && num_steps == other.num_steps;
+  }
+  bool operator!=(const BlobChoiceKey& other) const {
+    return !(*this == other);
+  }
+
+  uint64_t hash;
+  TBOX box;          // Bounding box of the normalized blob.
+  int num_outlines;  // Number of outlines, including holes.
+  int num_points;    // Total number of edge points of all outlines.
+  int num_steps;     // Total number of source outline steps of all outlines.
+};
+
+// Copies of the choices made by Classify::AdaptiveClassifier, as the chopper
+// and the second pass classify many blobs again unchanged. All methods are
+// thread-safe, as blobs may be classified in parallel.
+class BlobChoiceCache {
+ public:
+  // Beyond this many blobs the cache is emptied, so a huge page can't make
+  // it grow without bound.
+  static const size_t kMaxSize = 10000;
+
+  BlobChoiceCache() = default;
+  ~BlobChoiceCache() { Clear(); }
+  BlobChoiceCache(const BlobChoiceCache&) = delete;
+  BlobChoiceCache& operator=(const BlobChoiceCache&) = delete;
+
+  // Returns the key of blob: a hash of the normalized outlines, the source
+  // outlines in image coordinates and where the normalization maps the blob
+  // in the image, together with its exact fingerprint.
+  static BlobChoiceKey MakeKey(const TBLOB& blob);
+
+  // If the choices for key are cached, appends a copy of them to choices and
+  // returns true. Otherwise returns false and leaves choices unchanged.
+  bool Lookup(const BlobChoiceKey& key, BLOB_CHOICE_LIST* choices);
+  // Remembers a copy of choices for key. An entry with the same hash but a
+  // different fingerprint is replaced.
+  void Store(const BlobChoiceKey& key, const BLOB_CHOICE_LIST* choices);
+  // Forgets all the cached choices.
+  void Clear();
+  // Returns the number of cached blobs.
+  size_t size();
+
+ private:
+  struct Entry {
+    BlobChoiceKey key;
+    BLOB_CHOICE_LIST* choices;
+  };
+
+  std::unordered_map<uint64_t, Entry> entries_;
+  std::mutex mutex_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_CLASSIFY_BLOBCHOICECACHE_H_
@@ -212,6 +212,7 @@ Classify::Classify()
 
 Classify::~Classify() {
   EndAdaptiveClassifier();
+  ClearBlobChoiceCache();
   delete learn_debug_win_;
   delete learn_fragmented_word_debug_win_;
   delete learn_fragments_debug_win_;
@@ -39,6 +39,10 @@ class Classify : public CCStruct {
   virtual Dict& getDict() {
     return dict_;
   }
+  // There are no templates without the legacy engine.
+  int64_t TemplatesMemoryBytes() const {
+    return 0;
+  }
 
   // Member variables.
 
@@ -63,6 +67,7 @@ class Classify : public CCStruct {
 #else  // DISABLED_LEGACY_ENGINE not defined
 
 #include "adaptive.h"
+#include "blobchoicecache.h"
 #include "ccstruct.h"
 #include "dict.h"
 #include "featdefs.h"
@@ -74,6 +79,7 @@ class Classify : public CCStruct {
 #include "ratngs.h"
 #include "ocrfeatures.h"
 #include "unicity_table.h"
+#include <vector>         // for std::vector
 
 class ScrollView;
 class WERD_CHOICE;
@@ -306,6 +312,17 @@ class Classify : public CCStruct {
   void ResetAdaptiveClassifierInternal();
   void SwitchAdaptiveClassifier();
   void StartBackupAdaptiveClassifier();
+  // Writes the current adapted templates to the given file, so that another
+  // Classify with the same language data can continue from them.
+  // Returns false on error.
+  bool SaveAdaptedTemplates(const char* filename);
+  // Replaces the adapted templates with those written by SaveAdaptedTemplates
+  // to the given file, discarding any backup. Returns false if the file can't
+  // be opened.
+  bool LoadAdaptedTemplates(const char* filename);
+  // Forgets the choices remembered by AdaptiveClassifier. Called whenever the
+  // adapted templates change, and at the start of each page.
+  void ClearBlobChoiceCache();
 
   int GetCharNormFeature(const INT_FX_RESULT_STRUCT& fx_info,
                          INT_TEMPLATES templates,
@@ -326,6 +343,13 @@ class Classify : public CCStruct {
   bool AdaptiveClassifierIsEmpty() const {
     return AdaptedTemplates->NumPermClasses == 0;
   }
+  // Returns an estimate of the bytes held by the static and the adapted
+  // templates.
+  int64_t TemplatesMemoryBytes() const {
+    return IntTemplatesBytes(PreTrainedTemplates) +
+           AdaptedTemplatesBytes(AdaptedTemplates) +
+           AdaptedTemplatesBytes(BackupAdaptedTemplates);
+  }
   bool LooksLikeGarbage(TBLOB *blob);
   void RefreshDebugWindow(ScrollView **win, const char *msg,
                           int y_offset, const TBOX &wbox);
@@ -364,12 +388,23 @@ class Classify : public CCStruct {
   // number of cn features generated for each outline in the blob (in order).
   // Thus after the first outline, there were (*outline_cn_counts)[0] features,
   // after the second outline, there were (*outline_cn_counts)[1] features etc.
+  // Any previous contents of bl_features and cn_features are replaced, but
+  // their memory is reused, so the caller may keep them for many blobs.
   static void ExtractFeatures(const TBLOB& blob,
                               bool nonlinear_norm,
                               GenericVector<INT_FEATURE_STRUCT>* bl_features,
                               GenericVector<INT_FEATURE_STRUCT>* cn_features,
                               INT_FX_RESULT_STRUCT* results,
                               GenericVector<int>* outline_cn_counts);
+  // As ExtractFeatures above, but into the caller-owned features.
+  static void ExtractFeatures(const TBLOB& blob, bool nonlinear_norm,
+                              BlobFeatures* features);
+  // Extracts the features of all the blobs of word in one call, into
+  // (*features)[b] for blob b < word.NumBlobs(). features is grown as needed
+  // but never shrunk, and the BlobFeatures in it are reused, so a vector kept
+  // across words stops allocating.
+  static void ExtractWordFeatures(const TWERD& word, bool nonlinear_norm,
+                                  std::vector<BlobFeatures>* features);
   /* float2int.cpp ************************************************************/
   void ClearCharNormArray(uint8_t* char_norm_array);
   void ComputeIntCharNormArray(const FEATURE_STRUCT& norm_feature,
@@ -576,6 +611,10 @@ class Classify : public CCStruct {
   ScrollView* learn_debug_win_;
   ScrollView* learn_fragmented_word_debug_win_;
   ScrollView* learn_fragments_debug_win_;
+
+  // Copies of the choices made by AdaptiveClassifier. See
+  // ClearBlobChoiceCache.
+  BlobChoiceCache blob_choice_cache_;
 };
 }  // namespace tesseract
 
@@ -18,7 +18,11 @@
 #define _USE_MATH_DEFINES // for M_PI
 #include <cfloat>       // for FLT_MAX
 #include <cmath>        // for M_PI
+#include <mutex>        // for std::mutex
 #include <vector>       // for std::vector
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
 
 #include "cluster.h"
 #include "emalloc.h"
@@ -26,6 +30,7 @@
 #include "helpers.h"
 #include "kdpair.h"
 #include "matrix.h"
+#include "numthreads.h"  // for NumThreads
 #include "tprintf.h"
 
 #define HOTELLING 1  // If true use Hotelling's test to decide where to split.
@@ -193,6 +198,10 @@ struct CHISTRUCT{
   double ChiSquared;
 };
 
+// Minimum number of samples for the nearest neighbor searches of
+// CreateClusterTree to be worth running in parallel.
+const int kMinParallelNeighborSearches = 256;
+
 // For use with KDWalk / MakePotentialClusters
 struct ClusteringContext {
   ClusterHeap *heap;  // heap used to hold temp clusters, "best" on top
@@ -660,6 +669,31 @@ static void CreateClusterTree(CLUSTERER *Clusterer) {
   context.heap = new ClusterHeap(Clusterer->NumberOfSamples);
   KDWalk(context.tree, reinterpret_cast<void_proc>(MakePotentialClusters), &context);
 
+  // The nearest neighbors of all the samples are independent queries of the
+  // same tree, so run them as a batch, then push the potential clusters in
+  // the order of the walk, so the result doesn't depend on the thread count.
+  int num_candidates = context.next;
+  std::vector<float> distances(num_candidates);
+#ifdef _OPENMP
+  const int num_threads = tesseract::NumThreads(omp_get_max_threads());
+#pragma omp parallel for num_threads(num_threads) \
+    if (num_threads > 1 && num_candidates >= kMinParallelNeighborSearches)
+#endif  // _OPENMP
+  for (int i = 0; i < num_candidates; ++i) {
+    context.candidates[i].Neighbor =
+        FindNearestNeighbor(context.tree, context.candidates[i].Cluster,
+                            &distances[i]);
+  }
+  context.next = 0;
+  for (int i = 0; i < num_candidates; ++i) {
+    if (context.candidates[i].Neighbor != nullptr) {
+      context.candidates[context.next] = context.candidates[i];
+      HeapEntry.data = &(context.candidates[context.next++]);
+      HeapEntry.key = distances[i];
+      context.heap->Push(&HeapEntry);
+    }
+  }
+
   // form potential clusters into actual clusters - always do "best" first
   while (context.heap->Pop(&HeapEntry)) {
     PotentialCluster = HeapEntry.data;
@@ -707,26 +741,16 @@ static void CreateClusterTree(CLUSTERER *Clusterer) {
 /**
  * This routine is designed to be used in concert with the
  * KDWalk routine.  It will create a potential cluster for
- * each sample in the kd-tree that is being walked.  This
- * potential cluster will then be pushed on the heap.
+ * each sample in the kd-tree that is being walked.  The
+ * nearest neighbors of the potential clusters are found
+ * afterwards by CreateClusterTree.
  * @param context  ClusteringContext (see definition above)
  * @param Cluster  current cluster being visited in kd-tree walk
  * @param Level  level of this cluster in the kd-tree
  */
 static void MakePotentialClusters(ClusteringContext* context,
                                   CLUSTER* Cluster, int32_t /*Level*/) {
-  ClusterPair HeapEntry;
-  int next = context->next;
-  context->candidates[next].Cluster = Cluster;
-  HeapEntry.data = &(context->candidates[next]);
-  context->candidates[next].Neighbor =
-      FindNearestNeighbor(context->tree,
-                          context->candidates[next].Cluster,
-                          &HeapEntry.key);
-  if (context->candidates[next].Neighbor != nullptr) {
-    context->heap->Push(&HeapEntry);
-    context->next++;
-  }
+  context->candidates[context->next++].Cluster = Cluster;
 }                                // MakePotentialClusters
 
 /**
@@ -1763,6 +1787,9 @@ ComputeChiSquared (uint16_t DegreesOfFreedom, double Alpha)
 #define MINALPHA  (1e-200)
 {
   static LIST ChiWith[MAXDEGREESOFFREEDOM + 1];
+  // Guards ChiWith, as classes may be clustered in parallel.
+  static std::mutex chi_mutex;
+  std::lock_guard<std::mutex> lock(chi_mutex);
 
   CHISTRUCT *OldChiSquared;
   CHISTRUCT SearchKey;
@@ -2283,7 +2310,8 @@ MultipleCharSamples(CLUSTERER* Clusterer,
                     CLUSTER* Cluster, float MaxIllegal)
 #define ILLEGAL_CHAR    2
 {
-  static std::vector<uint8_t> CharFlags;
+  // Scratch kept per thread, as classes may be clustered in parallel.
+  thread_local std::vector<uint8_t> CharFlags;
   LIST SearchState;
   SAMPLE *Sample;
   int32_t CharID;
@@ -14,6 +14,10 @@
 ///////////////////////////////////////////////////////////////////////
 #include <algorithm>
 #include <ctime>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "errorcounter.h"
 
@@ -29,6 +33,8 @@ namespace tesseract {
 
 // Difference in result rating to be thought of as an "equal" choice.
 const double kRatingEpsilon = 1.0 / 32;
+// Number of samples given to each thread in a round of a parallel evaluation.
+const int kEvalSamplesPerThread = 64;
 
 // Tests a classifier, computing its error rate.
 // See errorcounter.h for description of arguments.
@@ -41,47 +47,102 @@ double ErrorCounter::ComputeErrorRate(ShapeClassifier* classifier,
     const FontInfoTable& fontinfo_table,
     const GenericVector<Pix*>& page_images, SampleIterator* it,
     double* unichar_error,  double* scaled_error, STRING* fonts_report) {
+  GenericVector<ShapeClassifier*> classifiers;
+  classifiers.push_back(classifier);
+  return ComputeErrorRate(classifiers, 1, report_level, boosting_mode,
+                          fontinfo_table, page_images, it, unichar_error,
+                          scaled_error, fonts_report);
+}
+
+// Tests a classifier on every sample_stride-th sample, classifying in
+// rounds of samples in parallel, with one classifier per thread.
+// See errorcounter.h for description of arguments.
+double ErrorCounter::ComputeErrorRate(
+    const GenericVector<ShapeClassifier*>& classifiers, int sample_stride,
+    int report_level, CountTypes boosting_mode,
+    const FontInfoTable& fontinfo_table,
+    const GenericVector<Pix*>& page_images, SampleIterator* it,
+    double* unichar_error, double* scaled_error, STRING* fonts_report) {
+  ShapeClassifier* classifier = classifiers[0];
   const int fontsize = it->sample_set()->NumFonts();
   ErrorCounter counter(classifier->GetUnicharset(), fontsize);
-  GenericVector<UnicharRating> results;
+  int num_threads = classifiers.size();
+#ifndef _OPENMP
+  num_threads = 1;
+#endif
+  sample_stride = std::max(sample_stride, 1);
+  const int round_size = num_threads * kEvalSamplesPerThread;
+  std::vector<TrainingSample*> samples;
+  std::vector<Pix*> sample_pixes;
+  std::vector<int> sample_indices;
+  std::vector<GenericVector<UnicharRating>> sample_results(round_size);
 
   clock_t start = clock();
   unsigned total_samples = 0;
   double unscaled_error = 0.0;
   // Set a number of samples on which to run the classify debug mode.
   int error_samples = report_level > 3 ? report_level * report_level : 0;
-  // Iterate over all the samples, accumulating errors.
-  for (it->Begin(); !it->AtEnd(); it->Next()) {
-    TrainingSample* mutable_sample = it->MutableSample();
-    int page_index = mutable_sample->page_num();
-    Pix* page_pix = 0 <= page_index && page_index < page_images.size()
-                  ? page_images[page_index] : nullptr;
-    // No debug, no keep this.
-    classifier->UnicharClassifySample(*mutable_sample, page_pix, 0,
-                                      INVALID_UNICHAR_ID, &results);
-    bool debug_it = false;
-    int correct_id = mutable_sample->class_id();
-    if (counter.unicharset_.has_special_codes() &&
-        (correct_id == UNICHAR_SPACE || correct_id == UNICHAR_JOINED ||
-         correct_id == UNICHAR_BROKEN)) {
-      // This is junk so use the special counter.
-      debug_it = counter.AccumulateJunk(report_level > 3,
-                                        results,
-                                        mutable_sample);
-    } else {
-      debug_it = counter.AccumulateErrors(report_level > 3, boosting_mode,
-                                          fontinfo_table,
-                                          results, mutable_sample);
+  int sample_count = 0;
+  it->Begin();
+  while (!it->AtEnd()) {
+    // Gather the next round of samples.
+    samples.clear();
+    sample_pixes.clear();
+    sample_indices.clear();
+    for (; !it->AtEnd() && static_cast<int>(samples.size()) < round_size; it->Next()) {
+      if (sample_count++ % sample_stride != 0) continue;
+      TrainingSample* mutable_sample = it->MutableSample();
+      int page_index = mutable_sample->page_num();
+      samples.push_back(mutable_sample);
+      sample_pixes.push_back(0 <= page_index && page_index < page_images.size()
+                             ? page_images[page_index] : nullptr);
+      sample_indices.push_back(it->GlobalSampleIndex());
     }
-    if (debug_it && error_samples > 0) {
-      // Running debug, keep the correct answer, and debug the classifier.
-      tprintf("Error on sample %d: %s Classifier debug output:\n",
-              it->GlobalSampleIndex(),
-              it->sample_set()->SampleToString(*mutable_sample).string());
-      classifier->DebugDisplay(*mutable_sample, page_pix, correct_id);
-      --error_samples;
+    const int num_samples = samples.size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1) \
+    if (num_threads > 1)
+#endif
+    for (int s = 0; s < num_samples; ++s) {
+#ifdef _OPENMP
+      ShapeClassifier* thread_classifier = classifiers[omp_get_thread_num()];
+#else
+      ShapeClassifier* thread_classifier = classifier;
+#endif
+      // No debug, no keep this.
+      thread_classifier->UnicharClassifySample(*samples[s], sample_pixes[s], 0,
+                                               INVALID_UNICHAR_ID,
+                                               &sample_results[s]);
+    }
+    // Accumulate the errors in sample order.
+    for (int s = 0; s < num_samples; ++s) {
+      TrainingSample* mutable_sample = samples[s];
+      Pix* page_pix = sample_pixes[s];
+      const GenericVector<UnicharRating>& results = sample_results[s];
+      bool debug_it = false;
+      int correct_id = mutable_sample->class_id();
+      if (counter.unicharset_.has_special_codes() &&
+          (correct_id == UNICHAR_SPACE || correct_id == UNICHAR_JOINED ||
+           correct_id == UNICHAR_BROKEN)) {
+        // This is junk so use the special counter.
+        debug_it = counter.AccumulateJunk(report_level > 3,
+                                          results,
+                                          mutable_sample);
+      } else {
+        debug_it = counter.AccumulateErrors(report_level > 3, boosting_mode,
+                                            fontinfo_table,
+                                            results, mutable_sample);
+      }
+      if (debug_it && error_samples > 0) {
+        // Running debug, keep the correct answer, and debug the classifier.
+        tprintf("Error on sample %d: %s Classifier debug output:\n",
+                sample_indices[s],
+                it->sample_set()->SampleToString(*mutable_sample).string());
+        classifier->DebugDisplay(*mutable_sample, page_pix, correct_id);
+        --error_samples;
+      }
+      ++total_samples;
     }
-    ++total_samples;
   }
   const double total_time = 1.0 * (clock() - start) / CLOCKS_PER_SEC;
   // Create the appropriate error report.
@@ -127,6 +127,18 @@ class ErrorCounter {
                                  double* unichar_error,
                                  double* scaled_error,
                                  STRING* fonts_report);
+  // As above, but classifies the samples in parallel, with classifiers[t]
+  // used only by thread t, so each classifier only needs to be safe to use
+  // from one thread at a time. classifiers[0] is used for debug output.
+  // Only every sample_stride-th sample of it is tested, for quick checks.
+  // The errors are accumulated in sample order, so the results are the same
+  // for any number of classifiers.
+  static double ComputeErrorRate(
+      const GenericVector<ShapeClassifier*>& classifiers, int sample_stride,
+      int report_level, CountTypes boosting_mode,
+      const FontInfoTable& fontinfo_table,
+      const GenericVector<Pix*>& page_images, SampleIterator* it,
+      double* unichar_error, double* scaled_error, STRING* fonts_report);
   // Tests a pair of classifiers, debugging errors of the new against the old.
   // See errorcounter.h for description of arguments.
   // Iterates over the samples, calling the classifiers in normal/silent mode.
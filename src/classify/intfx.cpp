@@ -77,7 +77,8 @@ namespace tesseract {
 TrainingSample* BlobToTrainingSample(
     const TBLOB& blob, bool nonlinear_norm, INT_FX_RESULT_STRUCT* fx_info,
     GenericVector<INT_FEATURE_STRUCT>* bl_features) {
-  GenericVector<INT_FEATURE_STRUCT> cn_features;
+  // The cn_features are copied into the sample, so a buffer per thread will do.
+  thread_local GenericVector<INT_FEATURE_STRUCT> cn_features;
   Classify::ExtractFeatures(blob, nonlinear_norm, bl_features,
                             &cn_features, fx_info, nullptr);
   // TODO(rays) Use blob->PreciseBoundingBox() instead.
@@ -439,6 +440,7 @@ static void ExtractFeaturesFromRun(
 // number of cn features generated for each outline in the blob (in order).
 // Thus after the first outline, there were (*outline_cn_counts)[0] features,
 // after the second outline, there were (*outline_cn_counts)[1] features etc.
+// Any previous contents of bl_features and cn_features are replaced.
 void Classify::ExtractFeatures(const TBLOB& blob,
                                bool nonlinear_norm,
                                GenericVector<INT_FEATURE_STRUCT>* bl_features,
@@ -448,6 +450,8 @@ void Classify::ExtractFeatures(const TBLOB& blob,
   DENORM bl_denorm, cn_denorm;
   tesseract::Classify::SetupBLCNDenorms(blob, nonlinear_norm,
                                         &bl_denorm, &cn_denorm, results);
+  bl_features->truncate(0);
+  cn_features->truncate(0);
   if (outline_cn_counts != nullptr)
     outline_cn_counts->truncate(0);
   // Iterate the outlines.
@@ -483,4 +487,25 @@ void Classify::ExtractFeatures(const TBLOB& blob,
   results->Width = blob.bounding_box().width();
 }
 
+// As ExtractFeatures above, but into the caller-owned features.
+void Classify::ExtractFeatures(const TBLOB& blob, bool nonlinear_norm,
+                               BlobFeatures* features) {
+  ExtractFeatures(blob, nonlinear_norm, &features->bl_features,
+                  &features->cn_features, &features->fx_info, nullptr);
+}
+
+// Extracts the features of all the blobs of word into (*features)[b].
+void Classify::ExtractWordFeatures(const TWERD& word, bool nonlinear_norm,
+                                   std::vector<BlobFeatures>* features) {
+  int num_blobs = word.NumBlobs();
+  // The vector is never shrunk, so that the spare BlobFeatures keep their
+  // memory for a longer word.
+  if (features->size() < static_cast<size_t>(num_blobs)) {
+    features->resize(num_blobs);
+  }
+  for (int b = 0; b < num_blobs; ++b) {
+    ExtractFeatures(*word.blobs[b], nonlinear_norm, &(*features)[b]);
+  }
+}
+
 }  // namespace tesseract
@@ -25,6 +25,7 @@
 #include "intproto.h"
 #include "normalis.h"
 #include <cmath>
+#include <vector>
 
 class DENORM;
 
@@ -55,6 +56,15 @@ void InitIntegerFX();
 FCOORD FeatureDirection(uint8_t theta);
 
 namespace tesseract {
+  // The features extracted from a blob by Classify::ExtractFeatures. The
+  // vectors keep their memory when reused, so extraction into a long-lived
+  // BlobFeatures stops allocating once it has grown to fit the largest blob.
+  struct BlobFeatures {
+    INT_FX_RESULT_STRUCT fx_info;
+    GenericVector<INT_FEATURE_STRUCT> bl_features;
+    GenericVector<INT_FEATURE_STRUCT> cn_features;
+  };
+
   // Generates a TrainingSample from a TBLOB. Extracts features and sets
   // the bounding box, so classifiers that operate on the image can work.
   // TODO(rays) BlobToTrainingSample must remain a global function until
@@ -33,7 +33,9 @@
 #include "float2int.h"
 #include "helpers.h"
 #include "classify.h"
+#include "classpruner.h"
 #include "shapetable.h"
+#include "simddetect.h"
 
 using tesseract::ScoredFont;
 using tesseract::UnicharRating;
@@ -181,6 +183,31 @@ class ClassPruner {
                      int num_features, const INT_FEATURE_STRUCT* features) {
     num_features_ = num_features;
     int num_pruners = int_templates->NumClassPruners;
+    if (AddClassPrunerCounts != nullptr && num_features > 0) {
+      // The vector code takes the position of each feature as an offset into
+      // every pruner, and adds up all the features for one pruner at a time.
+      static_assert(kClassesPerPruner == CLASSES_PER_CP &&
+                    WERDS_PER_CP_VECTOR == 2 && NUM_BITS_PER_CLASS == 2,
+                    "AddClassPrunerCounts doesn't match the pruner layout");
+      GenericVector<int> offsets;
+      offsets.resize_no_init(num_features);
+      for (int f = 0; f < num_features; ++f) {
+        const INT_FEATURE_STRUCT* feature = &features[f];
+        int x = feature->X * NUM_CP_BUCKETS >> 8;
+        int y = feature->Y * NUM_CP_BUCKETS >> 8;
+        int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
+        offsets[f] = ((x * NUM_CP_BUCKETS + y) * NUM_CP_BUCKETS + theta) *
+                     WERDS_PER_CP_VECTOR;
+      }
+      GenericVector<const uint32_t*> pruners;
+      pruners.resize_no_init(num_pruners);
+      for (int p = 0; p < num_pruners; ++p) {
+        pruners[p] = int_templates->ClassPruners[p]->p[0][0][0];
+      }
+      AddClassPrunerCounts(&pruners[0], num_pruners, &offsets[0],
+                           num_features, class_count_);
+      return;
+    }
     for (int f = 0; f < num_features; ++f) {
       const INT_FEATURE_STRUCT* feature = &features[f];
       // Quantize the feature to NUM_CP_BUCKETS*NUM_CP_BUCKETS*NUM_CP_BUCKETS.
@@ -493,6 +520,15 @@ int Classify::PruneClasses(const INT_TEMPLATES_STRUCT* int_templates,
 
 }  // namespace tesseract
 
+// Returns the scratch tables of the calling thread. A ScratchEvidence is too
+// big to allocate and zero for every class matched, and Clear resets just the
+// part a class uses, so each thread keeps one. That also keeps the matcher
+// reentrant, so blobs may be classified in parallel.
+static ScratchEvidence* ThreadScratchEvidence() {
+  thread_local ScratchEvidence tables;
+  return &tables;
+}
+
 /**
  * IntegerMatcher returns the best configuration and rating
  * for a single class.  The class matched against is determined
@@ -517,7 +553,7 @@ void IntegerMatcher::Match(INT_CLASS ClassTemplate,
                            int AdaptFeatureThreshold,
                            int Debug,
                            bool SeparateDebugWindows) {
-  auto *tables = new ScratchEvidence();
+  ScratchEvidence *tables = ThreadScratchEvidence();
   int Feature;
 
   if (MatchDebuggingOn (Debug))
@@ -566,7 +602,6 @@ void IntegerMatcher::Match(INT_CLASS ClassTemplate,
     cprintf("Match Complete --------------------------------------------\n");
 #endif
 
-  delete tables;
 }
 
 /**
@@ -595,7 +630,7 @@ int IntegerMatcher::FindGoodProtos(
     PROTO_ID *ProtoArray,
     int AdaptProtoThreshold,
     int Debug) {
-  auto *tables = new ScratchEvidence();
+  ScratchEvidence *tables = ThreadScratchEvidence();
   int NumGoodProtos = 0;
 
   /* DEBUG opening heading */
@@ -636,7 +671,6 @@ int IntegerMatcher::FindGoodProtos(
 
   if (MatchDebuggingOn (Debug))
     cprintf ("Match Complete --------------------------------------------\n");
-  delete tables;
 
   return NumGoodProtos;
 }
@@ -663,7 +697,7 @@ int IntegerMatcher::FindBadFeatures(
     FEATURE_ID *FeatureArray,
     int AdaptFeatureThreshold,
     int Debug) {
-  auto *tables = new ScratchEvidence();
+  ScratchEvidence *tables = ThreadScratchEvidence();
   int NumBadFeatures = 0;
 
   /* DEBUG opening heading */
@@ -701,7 +735,6 @@ int IntegerMatcher::FindBadFeatures(
   if (MatchDebuggingOn(Debug))
     cprintf("Match Complete --------------------------------------------\n");
 
-  delete tables;
   return NumBadFeatures;
 }
 
@@ -813,6 +846,15 @@ int IntegerMatcher::UpdateTablesForFeature(
   uint32_t ThetaFeatureAddress;
 
   tables->ClearFeatureEvidence(ClassTemplate);
+  // With MaxConfigEvidence, the config words and evidence of the matching
+  // protos are gathered here, and the feature evidence is raised for all of
+  // them at the end.
+  static_assert(tesseract::kConfigsPerWord == BITS_PER_WERD &&
+                MAX_NUM_CONFIGS >= tesseract::kConfigsPerWord,
+                "MaxConfigEvidence doesn't match the config words");
+  uint32_t matched_configs[MAX_NUM_PROTOS];
+  uint8_t matched_evidence[MAX_NUM_PROTOS];
+  int num_matched = 0;
 
   /* Precompute Feature Address offset for Proto Pruning */
   XFeatureAddress = ((Feature->X >> 2) << 1);
@@ -876,19 +918,24 @@ int IntegerMatcher::UpdateTablesForFeature(
 
           ConfigWord &= *ConfigMask;
 
-          uint8_t feature_evidence_index = 0;
-          uint8_t config_byte = 0;
-          while (ConfigWord != 0 || config_byte != 0) {
-            while (config_byte == 0) {
-              config_byte = ConfigWord & 0xff;
-              ConfigWord >>= 8;
-              feature_evidence_index += 8;
+          if (tesseract::MaxConfigEvidence != nullptr) {
+            matched_configs[num_matched] = ConfigWord;
+            matched_evidence[num_matched++] = Evidence;
+          } else {
+            uint8_t feature_evidence_index = 0;
+            uint8_t config_byte = 0;
+            while (ConfigWord != 0 || config_byte != 0) {
+              while (config_byte == 0) {
+                config_byte = ConfigWord & 0xff;
+                ConfigWord >>= 8;
+                feature_evidence_index += 8;
+              }
+              const uint8_t config_offset =
+                offset_table[config_byte] + feature_evidence_index - 8;
+              config_byte = next_table[config_byte];
+              if (Evidence > tables->feature_evidence_[config_offset])
+                tables->feature_evidence_[config_offset] = Evidence;
             }
-            const uint8_t config_offset =
-              offset_table[config_byte] + feature_evidence_index - 8;
-            config_byte = next_table[config_byte];
-            if (Evidence > tables->feature_evidence_[config_offset])
-              tables->feature_evidence_[config_offset] = Evidence;
           }
 
           uint8_t* UINT8Pointer =
@@ -908,6 +955,10 @@ int IntegerMatcher::UpdateTablesForFeature(
       }
     }
   }
+  if (num_matched > 0) {
+    tesseract::MaxConfigEvidence(matched_configs, matched_evidence,
+                                 num_matched, tables->feature_evidence_);
+  }
 
   if (PrintFeatureMatchesOn(Debug)) {
     IMDebugConfigurationSum(FeatureNum, tables->feature_evidence_,
@@ -1197,12 +1248,13 @@ int IntegerMatcher::FindBestMatch(
   result->config = 0;
   result->fonts.truncate(0);
   result->fonts.reserve(class_template->NumConfigs);
+  const bool debug = *classify_debug_level_ > 2;
 
   /* Find best match */
   assert(class_template->NumConfigs < MAX_NUM_CONFIGS);
   for (int c = 0; c < MAX_NUM_CONFIGS && c < class_template->NumConfigs; ++c) {
     int rating = tables.sum_feature_evidence_[c];
-    if (*classify_debug_level_ > 2)
+    if (debug)
       tprintf("Config %d, rating=%d\n", c, rating);
     if (rating > best_match) {
       result->config = c;
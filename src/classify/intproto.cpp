@@ -706,6 +706,23 @@ void free_int_templates(INT_TEMPLATES templates) {
 }
 
 
+/// Returns an estimate of the bytes held by the templates.
+int64_t IntTemplatesBytes(INT_TEMPLATES templates) {
+  if (templates == nullptr) return 0;
+  int64_t bytes = sizeof(INT_TEMPLATES_STRUCT) +
+                  static_cast<int64_t>(templates->NumClassPruners) *
+                      sizeof(CLASS_PRUNER_STRUCT);
+  for (int i = 0; i < templates->NumClasses; i++) {
+    INT_CLASS int_class = templates->Class[i];
+    if (int_class == nullptr) continue;
+    // Each proto set has a length for each of its protos.
+    bytes += sizeof(INT_CLASS_STRUCT) +
+             int_class->NumProtoSets *
+                 (sizeof(PROTO_SET_STRUCT) + PROTOS_PER_PROTO_SET);
+  }
+  return bytes;
+}
+
 namespace tesseract {
 /**
  * This routine reads a set of integer templates from
@@ -234,6 +234,8 @@ INT_TEMPLATES NewIntTemplates();
 
 void free_int_templates(INT_TEMPLATES templates);
 
+int64_t IntTemplatesBytes(INT_TEMPLATES templates);
+
 void ShowMatchDisplay();
 
 namespace tesseract {
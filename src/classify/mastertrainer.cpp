@@ -25,11 +25,15 @@
 #include "mastertrainer.h"
 #include <cmath>
 #include <ctime>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "allheaders.h"
 #include "boxread.h"
 #include "classify.h"
 #include "errorcounter.h"
 #include "featdefs.h"
+#include "numthreads.h"  // for NumThreads
 #include "sampleiterator.h"
 #include "shapeclassifier.h"
 #include "shapetable.h"
@@ -281,6 +285,30 @@ void MasterTrainer::SetupMasterShapes() {
   tprintf("Master shape_table:%s\n", master_shapes_.SummaryStr().string());
 }
 
+// Loads the sample distances used by SetupMasterShapes from a file written
+// by SaveDistanceCache in an earlier run on the same training data.
+// Returns false if the file can't be read or is for different data.
+bool MasterTrainer::LoadDistanceCache(const char* filename) {
+  FILE* fp = fopen(filename, "rb");
+  if (fp == nullptr) return false;
+  bool success = samples_.DeSerializeDistanceCache(fp);
+  fclose(fp);
+  if (!success)
+    tprintf("Ignoring distance cache %s from different training data\n",
+            filename);
+  return success;
+}
+
+// Saves the sample distances computed so far for reuse by a later run.
+// Returns false in case of error.
+bool MasterTrainer::SaveDistanceCache(const char* filename) const {
+  FILE* fp = fopen(filename, "wb");
+  if (fp == nullptr) return false;
+  bool success = samples_.SerializeDistanceCache(fp);
+  if (fclose(fp) != 0) success = false;
+  return success;
+}
+
 // Adds the junk_samples_ to the main samples_ set. Junk samples are initially
 // fragments and n-grams (all incorrectly segmented characters).
 // Various training functions may result in incorrectly segmented characters
@@ -767,6 +795,25 @@ void MasterTrainer::TestClassifierOnSamples(CountTypes error_mode,
                  test_classifier, report_string);
 }
 
+// Tests the given test_classifiers in parallel on every sample_stride-th
+// internal sample. See TestClassifier for details.
+void MasterTrainer::TestClassifiersOnSamples(
+    CountTypes error_mode, int report_level, bool replicate_samples,
+    const GenericVector<ShapeClassifier*>& test_classifiers,
+    int sample_stride, STRING* report_string) {
+  SampleIterator sample_it;
+  sample_it.Init(nullptr, nullptr, replicate_samples, &samples_);
+  if (report_level > 0) {
+    tprintf("Testing %sREPLICATED on every %d sample(s) with %d threads:\n",
+            replicate_samples ? "" : "NON-", sample_stride,
+            test_classifiers.size());
+  }
+  ErrorCounter::ComputeErrorRate(test_classifiers, sample_stride,
+                                 report_level, error_mode, fontinfo_table_,
+                                 page_images_, &sample_it, nullptr, nullptr,
+                                 report_string);
+}
+
 // Tests the given test_classifier on the given samples.
 // error_mode indicates what counts as an error.
 // report_levels:
@@ -913,20 +960,36 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
   float min_dist = kInfiniteDist;
   int min_s1 = 0;
   int min_s2 = 0;
+#ifdef _OPENMP
+  const int num_threads = NumThreads(omp_get_max_threads());
+#else
+  const int num_threads = 1;
+#endif
   tprintf("Computing shape distances...");
+  // The rows get shorter with s1, so they are handed out dynamically. Each
+  // row is written by a single thread, and the minimum is found afterwards
+  // in the original order, so the result doesn't depend on the threading.
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) \
+    if (num_threads > 1)
+#endif
   for (int s1 = 0; s1 < num_shapes; ++s1) {
+    shape_dists[s1].reserve(num_shapes - s1 - 1);
     for (int s2 = s1 + 1; s2 < num_shapes; ++s2) {
-      ShapeDist dist(s1, s2, ShapeDistance(*shapes, s1, s2));
-      shape_dists[s1].push_back(dist);
-      if (dist.distance < min_dist) {
-        min_dist = dist.distance;
+      shape_dists[s1].push_back(
+          ShapeDist(s1, s2, ShapeDistance(*shapes, s1, s2)));
+    }
+  }
+  for (int s1 = 0; s1 < num_shapes; ++s1) {
+    for (int i = 0; i < shape_dists[s1].size(); ++i) {
+      if (shape_dists[s1][i].distance < min_dist) {
+        min_dist = shape_dists[s1][i].distance;
         min_s1 = s1;
-        min_s2 = s2;
+        min_s2 = s1 + 1 + i;
       }
     }
-    tprintf(" %d", s1);
   }
-  tprintf("\n");
+  tprintf(" %d\n", num_shapes);
   int num_merged = 0;
   while (num_merged < max_merges && min_dist < max_dist) {
     tprintf("Distance = %f: ", min_dist);
@@ -940,6 +1003,12 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
       shape_dists[min_s2].clear();
       ++num_merged;
 
+      // Each s writes only its own entries, so the distances to the merged
+      // shape can be recomputed in parallel.
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) \
+    if (num_threads > 1)
+#endif
       for (int s = 0; s < min_s1; ++s) {
         if (!shape_dists[s].empty()) {
           shape_dists[s][min_s1 - s - 1].distance =
@@ -947,6 +1016,10 @@ void MasterTrainer::ClusterShapes(int min_shapes,  int max_shape_unichars,
           shape_dists[s][min_s2 - s -1].distance = kInfiniteDist;
         }
       }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) \
+    if (num_threads > 1)
+#endif
       for (int s2 = min_s1 + 1; s2 < num_shapes; ++s2) {
         if (shape_dists[min_s1][s2 - min_s1 - 1].distance < kInfiniteDist)
           shape_dists[min_s1][s2 - min_s1 - 1].distance =
@@ -117,6 +117,14 @@ class MasterTrainer {
   // together until they get to a leaf node classifier.
   void SetupMasterShapes();
 
+  // Loads the sample distances used by SetupMasterShapes from a file written
+  // by SaveDistanceCache in an earlier run on the same training data.
+  // Returns false if the file can't be read or is for different data.
+  bool LoadDistanceCache(const char* filename);
+  // Saves the sample distances computed so far for reuse by a later run.
+  // Returns false in case of error.
+  bool SaveDistanceCache(const char* filename) const;
+
   // Adds the junk_samples_ to the main samples_ set. Junk samples are initially
   // fragments and n-grams (all incorrectly segmented characters).
   // Various training functions may result in incorrectly segmented characters
@@ -222,6 +230,13 @@ class MasterTrainer {
                                bool replicate_samples,
                                ShapeClassifier* test_classifier,
                                STRING* report_string);
+  // As TestClassifierOnSamples, but classifies the samples in parallel with
+  // one of test_classifiers per thread, testing only every sample_stride-th
+  // sample. See ErrorCounter::ComputeErrorRate.
+  void TestClassifiersOnSamples(
+      CountTypes error_mode, int report_level, bool replicate_samples,
+      const GenericVector<ShapeClassifier*>& test_classifiers,
+      int sample_stride, STRING* report_string);
   // Tests the given test_classifier on the given samples
   // error_mode indicates what counts as an error.
   // report_levels:
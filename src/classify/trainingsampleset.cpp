@@ -35,6 +35,9 @@ const int kSquareLimit = 25;
 // Prime numbers for subsampling distances.
 const int kPrime1 = 17;
 const int kPrime2 = 13;
+// Number of values in the header that identifies the sample set of a
+// distance cache file.
+const int kDistanceCacheHeaderSize = 3;
 
 TrainingSampleSet::FontClassInfo::FontClassInfo()
   : num_raw_samples(0), canonical_sample(-1), canonical_dist(0.0f) {
@@ -109,6 +112,87 @@ bool TrainingSampleSet::DeSerialize(bool swap, FILE* fp) {
   return true;
 }
 
+// Writes the ClusterDistance caches to the given file, so that a later run
+// on the same samples and feature map can skip recomputing them.
+// Returns false in case of error.
+bool TrainingSampleSet::SerializeDistanceCache(FILE* fp) const {
+  ASSERT_HOST(font_class_array_ != nullptr);
+  std::lock_guard<std::mutex> lock(distance_cache_mutex_);
+  // Header to identify the sample set that the caches belong to.
+  int32_t header[kDistanceCacheHeaderSize] = {
+      samples_.size(), unicharset_size_, font_id_map_.CompactSize()};
+  if (fwrite(header, sizeof(header[0]), kDistanceCacheHeaderSize, fp) !=
+      kDistanceCacheHeaderSize)
+    return false;
+  for (int f = 0; f < font_class_array_->dim1(); ++f) {
+    for (int c = 0; c < font_class_array_->dim2(); ++c) {
+      const FontClassInfo& fc_info = (*font_class_array_)(f, c);
+      if (!fc_info.font_distance_cache.Serialize(fp)) return false;
+      if (!fc_info.unichar_distance_cache.Serialize(fp)) return false;
+      // The list cache may exceed the size limit of GenericVector::DeSerialize,
+      // so it is written raw.
+      int32_t size = fc_info.distance_cache.size();
+      if (fwrite(&size, sizeof(size), 1, fp) != 1) return false;
+      if (size > 0 &&
+          fwrite(&fc_info.distance_cache[0], sizeof(FontClassDistance), size,
+                 fp) != static_cast<size_t>(size))
+        return false;
+    }
+  }
+  return true;
+}
+
+// Reads the ClusterDistance caches written by SerializeDistanceCache.
+// Returns false in case of error, or if the file was written for a
+// different sample set, in which case the caches are left empty.
+bool TrainingSampleSet::DeSerializeDistanceCache(FILE* fp) {
+  ASSERT_HOST(font_class_array_ != nullptr);
+  std::lock_guard<std::mutex> lock(distance_cache_mutex_);
+  int32_t header[kDistanceCacheHeaderSize];
+  if (fread(header, sizeof(header[0]), kDistanceCacheHeaderSize, fp) !=
+      kDistanceCacheHeaderSize)
+    return false;
+  if (header[0] != samples_.size() || header[1] != unicharset_size_ ||
+      header[2] != font_id_map_.CompactSize() ||
+      font_class_array_->dim1() != font_id_map_.CompactSize() ||
+      font_class_array_->dim2() != unicharset_size_)
+    return false;
+  bool success = true;
+  for (int f = 0; success && f < font_class_array_->dim1(); ++f) {
+    for (int c = 0; success && c < font_class_array_->dim2(); ++c) {
+      FontClassInfo& fc_info = (*font_class_array_)(f, c);
+      int32_t size;
+      success = fc_info.font_distance_cache.DeSerialize(false, fp) &&
+                fc_info.unichar_distance_cache.DeSerialize(false, fp) &&
+                fread(&size, sizeof(size), 1, fp) == 1 && size >= 0;
+      // The cached vectors must be empty or of the size that the caches use.
+      success = success &&
+          (fc_info.font_distance_cache.empty() ||
+           fc_info.font_distance_cache.size() == header[2]) &&
+          (fc_info.unichar_distance_cache.empty() ||
+           fc_info.unichar_distance_cache.size() == header[1]);
+      if (success) {
+        fc_info.distance_cache.init_to_size(size, FontClassDistance());
+        success = size == 0 ||
+            fread(&fc_info.distance_cache[0], sizeof(FontClassDistance), size,
+                  fp) == static_cast<size_t>(size);
+      }
+    }
+  }
+  if (!success) {
+    // Don't leave a partially read or invalid cache behind.
+    for (int f = 0; f < font_class_array_->dim1(); ++f) {
+      for (int c = 0; c < font_class_array_->dim2(); ++c) {
+        FontClassInfo& fc_info = (*font_class_array_)(f, c);
+        fc_info.font_distance_cache.clear();
+        fc_info.unichar_distance_cache.clear();
+        fc_info.distance_cache.clear();
+      }
+    }
+  }
+  return success;
+}
+
 // Load an initial unicharset, or set one up if the file cannot be read.
 void TrainingSampleSet::LoadUnicharset(const char* filename) {
   if (!unicharset_.load_from_file(filename)) {
@@ -297,70 +381,96 @@ float TrainingSampleSet::ClusterDistance(int font_id1, int class_id1,
                                          int font_id2, int class_id2,
                                          const IntFeatureMap& feature_map) {
   ASSERT_HOST(font_class_array_ != nullptr);
+  if (font_id_map_.SparseToCompact(font_id1) < 0 ||
+      font_id_map_.SparseToCompact(font_id2) < 0)
+    return 0.0f;
+  float result;
+  {
+    std::lock_guard<std::mutex> lock(distance_cache_mutex_);
+    if (LookupClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                              &result))
+      return result;
+  }
+  // Distance has to be calculated. The lock is not held while computing, as
+  // that is the expensive part. If another thread computes the same distance
+  // meanwhile, it gets the same result, so it doesn't matter who stores it.
+  result = ComputeClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                                  feature_map);
+  std::lock_guard<std::mutex> lock(distance_cache_mutex_);
+  StoreClusterDistance(font_id1, class_id1, font_id2, class_id2, result);
+  return result;
+}
+
+// Looks up the given pair of font/class pairs in the ClusterDistance
+// caches. Returns false if the distance is not there yet.
+bool TrainingSampleSet::LookupClusterDistance(int font_id1, int class_id1,
+                                              int font_id2, int class_id2,
+                                              float* distance) const {
   int font_index1 = font_id_map_.SparseToCompact(font_id1);
   int font_index2 = font_id_map_.SparseToCompact(font_id2);
-  if (font_index1 < 0 || font_index2 < 0)
-    return 0.0f;
-  FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
+  const FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
   if (font_id1 == font_id2) {
     // Special case cache for speed.
-    if (fc_info.unichar_distance_cache.size() == 0)
-      fc_info.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
-    if (fc_info.unichar_distance_cache[class_id2] < 0) {
-      // Distance has to be calculated.
-      float result = ComputeClusterDistance(font_id1, class_id1,
-                                            font_id2, class_id2,
-                                            feature_map);
-      fc_info.unichar_distance_cache[class_id2] = result;
-      // Copy to the symmetric cache entry.
-      FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-      if (fc_info2.unichar_distance_cache.size() == 0)
-        fc_info2.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
-      fc_info2.unichar_distance_cache[class_id1] = result;
-    }
-    return fc_info.unichar_distance_cache[class_id2];
+    if (fc_info.unichar_distance_cache.empty()) return false;
+    *distance = fc_info.unichar_distance_cache[class_id2];
   } else if (class_id1 == class_id2) {
     // Another special-case cache for equal class-id.
-    if (fc_info.font_distance_cache.size() == 0)
+    if (fc_info.font_distance_cache.empty()) return false;
+    *distance = fc_info.font_distance_cache[font_index2];
+  } else {
+    // Both font and class are different. Linear search for class_id2/font_id2
+    // in what is a hopefully short list of distances.
+    int cache_index = 0;
+    while (cache_index < fc_info.distance_cache.size() &&
+           (fc_info.distance_cache[cache_index].unichar_id != class_id2 ||
+            fc_info.distance_cache[cache_index].font_id != font_id2))
+      ++cache_index;
+    if (cache_index == fc_info.distance_cache.size()) return false;
+    *distance = fc_info.distance_cache[cache_index].distance;
+  }
+  return *distance >= 0.0f;
+}
+
+// Stores the given distance in the ClusterDistance caches, along with its
+// symmetric entry, unless another thread got there first.
+void TrainingSampleSet::StoreClusterDistance(int font_id1, int class_id1,
+                                             int font_id2, int class_id2,
+                                             float distance) {
+  float cached_distance;
+  if (LookupClusterDistance(font_id1, class_id1, font_id2, class_id2,
+                            &cached_distance))
+    return;
+  int font_index1 = font_id_map_.SparseToCompact(font_id1);
+  int font_index2 = font_id_map_.SparseToCompact(font_id2);
+  FontClassInfo& fc_info = (*font_class_array_)(font_index1, class_id1);
+  FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
+  if (font_id1 == font_id2) {
+    if (fc_info.unichar_distance_cache.empty())
+      fc_info.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
+    fc_info.unichar_distance_cache[class_id2] = distance;
+    // Copy to the symmetric cache entry.
+    if (fc_info2.unichar_distance_cache.empty())
+      fc_info2.unichar_distance_cache.init_to_size(unicharset_size_, -1.0f);
+    fc_info2.unichar_distance_cache[class_id1] = distance;
+  } else if (class_id1 == class_id2) {
+    if (fc_info.font_distance_cache.empty())
       fc_info.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
                                                -1.0f);
-    if (fc_info.font_distance_cache[font_index2] < 0) {
-      // Distance has to be calculated.
-      float result = ComputeClusterDistance(font_id1, class_id1,
-                                            font_id2, class_id2,
-                                            feature_map);
-      fc_info.font_distance_cache[font_index2] = result;
-      // Copy to the symmetric cache entry.
-      FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
-      if (fc_info2.font_distance_cache.size() == 0)
-        fc_info2.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
-                                                  -1.0f);
-      fc_info2.font_distance_cache[font_index1] = result;
-    }
-    return fc_info.font_distance_cache[font_index2];
-  }
-  // Both font and class are different. Linear search for class_id2/font_id2
-  // in what is a hopefully short list of distances.
-  int cache_index = 0;
-  while (cache_index < fc_info.distance_cache.size() &&
-         (fc_info.distance_cache[cache_index].unichar_id != class_id2 ||
-          fc_info.distance_cache[cache_index].font_id != font_id2))
-    ++cache_index;
-  if (cache_index == fc_info.distance_cache.size()) {
-    // Distance has to be calculated.
-    float result = ComputeClusterDistance(font_id1, class_id1,
-                                          font_id2, class_id2,
-                                          feature_map);
-    FontClassDistance fc_dist = { class_id2, font_id2, result };
+    fc_info.font_distance_cache[font_index2] = distance;
+    // Copy to the symmetric cache entry.
+    if (fc_info2.font_distance_cache.empty())
+      fc_info2.font_distance_cache.init_to_size(font_id_map_.CompactSize(),
+                                                -1.0f);
+    fc_info2.font_distance_cache[font_index1] = distance;
+  } else {
+    FontClassDistance fc_dist = { class_id2, font_id2, distance };
     fc_info.distance_cache.push_back(fc_dist);
     // Copy to the symmetric cache entry. We know it isn't there already, as
     // we always copy to the symmetric entry.
-    FontClassInfo& fc_info2 = (*font_class_array_)(font_index2, class_id2);
     fc_dist.unichar_id = class_id1;
     fc_dist.font_id = font_id1;
     fc_info2.distance_cache.push_back(fc_dist);
   }
-  return fc_info.distance_cache[cache_index].distance;
 }
 
 // Computes the distance between the given pair of font/class pairs.
@@ -16,6 +16,7 @@
 #ifndef TESSERACT_TRAINING_TRAININGSAMPLESET_H_
 #define TESSERACT_TRAINING_TRAININGSAMPLESET_H_
 
+#include <mutex>          // for std::mutex
 #include "bitvector.h"
 #include "genericvector.h"
 #include "indexmapbidi.h"
@@ -51,6 +52,17 @@ class TrainingSampleSet {
   // If swap is true, assumes a big/little-endian swap is needed.
   bool DeSerialize(bool swap, FILE* fp);
 
+  // Writes the ClusterDistance caches to the given file, so that a later run
+  // on the same samples and feature map can skip recomputing them.
+  // Returns false in case of error.
+  bool SerializeDistanceCache(FILE* fp) const;
+  // Reads the ClusterDistance caches written by SerializeDistanceCache.
+  // Returns false in case of error, or if the file was written for a
+  // different sample set, in which case the caches are left empty.
+  // The file is not portable between machines of different endianness.
+  // OrganizeByFontAndClass must have been already called.
+  bool DeSerializeDistanceCache(FILE* fp);
+
   // Accessors
   int num_samples() const {
     return samples_.size();
@@ -121,6 +133,7 @@ class TrainingSampleSet {
   // Returns the distance between the given pair of font/class pairs.
   // Finds in cache or computes and caches.
   // OrganizeByFontAndClass must have been already called.
+  // Thread-safe, so distances may be computed on several threads at once.
   float ClusterDistance(int font_id1, int class_id1,
                         int font_id2, int class_id2,
                         const IntFeatureMap& feature_map);
@@ -227,6 +240,18 @@ class TrainingSampleSet {
     int font_id;  // Real font id.
     float distance;
   };
+  // Looks up the given pair of font/class pairs in the ClusterDistance
+  // caches. Returns false if the distance is not there yet.
+  // distance_cache_mutex_ must be held.
+  bool LookupClusterDistance(int font_id1, int class_id1,
+                             int font_id2, int class_id2,
+                             float* distance) const;
+  // Stores the given distance in the ClusterDistance caches, along with its
+  // symmetric entry, unless another thread got there first.
+  // distance_cache_mutex_ must be held.
+  void StoreClusterDistance(int font_id1, int class_id1,
+                            int font_id2, int class_id2, float distance);
+
   // Simple struct to store information related to each font/class combination.
   struct FontClassInfo {
     FontClassInfo();
@@ -277,6 +302,8 @@ class TrainingSampleSet {
   // A 2-d array of FontClassInfo holding information related to each
   // (font_id, class_id) pair.
   GENERIC_2D_ARRAY<FontClassInfo>* font_class_array_;
+  // Guards the ClusterDistance caches in font_class_array_.
+  mutable std::mutex distance_cache_mutex_;
 
   // Reference to the fontinfo_table_ in MasterTrainer. Provides names
   // for font_ids in the samples. Not serialized!
@@ -25,6 +25,7 @@
 
 #include "dict.h"
 #include "helpers.h"
+#include "simddetect.h"
 #include "strngs.h"
 #include "tesscallback.h"
 #include "tprintf.h"
@@ -203,7 +204,7 @@ EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
     while (start <= end) {
       edge = (start + end) >> 1;  // (start + end) / 2
       compare = given_greater_than_edge_rec(NO_EDGE, word_end,
-                                            unichar_id, edges_[edge]);
+                                            unichar_id, edge_rec(edge));
       if (compare == 0) {  // given == vec[k]
         return edge;
       } else if (compare == 1) {  // given > vec[k]
@@ -212,14 +213,33 @@ EDGE_REF SquishedDawg::edge_char_of(NODE_REF node,
         end = edge - 1;
       }
     }
-  } else {  // linear search
-    if (edge != NO_EDGE && edge_occupied(edge)) {
+  } else if (edge != NO_EDGE && edge_keys_.empty()) {  // linear search
+    if (edge_occupied(edge)) {
       do {
-        if ((unichar_id_from_edge_rec(edges_[edge]) == unichar_id) &&
-            (!word_end || end_of_word_from_edge_rec(edges_[edge])))
-          return (edge);
+        EDGE_RECORD rec = edge_rec(edge);
+        if (unichar_id_from_edge_rec(rec) == unichar_id &&
+            (!word_end || end_of_word_from_edge_rec(rec)))
+          return edge;
       } while (!last_edge(edge++));
     }
+  } else if (edge != NO_EDGE && unichar_id >= 0) {  // linear search
+    // Find the first edge with the unichar_id, and the end_of_word flag if
+    // word_end, from the packed keys, stopping at the last edge of the node.
+    int32_t key = unichar_id << 2;
+    int32_t mask = ~3;
+    if (word_end) {
+      key |= 2;
+      mask = ~1;
+    }
+    const int32_t* keys = &edge_keys_[edge];
+    int i;
+    if (FindKey != nullptr) {
+      i = FindKey(keys, key, mask);
+    } else {
+      for (i = 0; (keys[i] & mask) != key && (keys[i] & 1) == 0; ++i) {
+      }
+    }
+    if ((keys[i] & mask) == key) return edge + i;
   }
   return (NO_EDGE);  // not found
 }
@@ -327,6 +347,7 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
   Dawg::init(unicharset_size);
 
   edges_ = new EDGE_RECORD[num_edges_];
+  edge_data_ = reinterpret_cast<const char *>(edges_);
   if (!file->DeSerialize(&edges_[0], num_edges_)) return false;
   if (debug_level_ > 2) {
     tprintf("type: %d lang: %s perm: %d unicharset_size: %d num_edges: %d\n",
@@ -336,6 +357,59 @@ bool SquishedDawg::read_squished_dawg(TFile *file) {
   return true;
 }
 
+bool SquishedDawg::LoadMapped(std::shared_ptr<const char> data, int size) {
+  if (debug_level_) tprintf("Using mapped squished dawg\n");
+  // The header is as read by read_squished_dawg, in native byte order.
+  int16_t magic;
+  int32_t unicharset_size;
+  const int kHeaderSize =
+      sizeof(magic) + sizeof(unicharset_size) + sizeof(num_edges_);
+  if (data == nullptr || size < kHeaderSize) return false;
+  const char *header = data.get();
+  memcpy(&magic, header, sizeof(magic));
+  header += sizeof(magic);
+  if (magic != kDawgMagicNumber) {
+    tprintf("Bad magic number on dawg: %d vs %d\n", magic, kDawgMagicNumber);
+    return false;
+  }
+  memcpy(&unicharset_size, header, sizeof(unicharset_size));
+  header += sizeof(unicharset_size);
+  memcpy(&num_edges_, header, sizeof(num_edges_));
+  ASSERT_HOST(num_edges_ > 0);  // DAWG should not be empty
+  if ((size - kHeaderSize) / sizeof(EDGE_RECORD) <
+      static_cast<size_t>(num_edges_)) {
+    return false;
+  }
+  Dawg::init(unicharset_size);
+  delete[] edges_;
+  edges_ = nullptr;
+  edge_data_ = data.get() + kHeaderSize;
+  mapped_data_ = std::move(data);
+  if (debug_level_ > 2) {
+    tprintf("type: %d lang: %s perm: %d unicharset_size: %d num_edges: %d\n",
+            type_, lang_.string(), perm_, unicharset_size_, num_edges_);
+    for (EDGE_REF edge = 0; edge < num_edges_; ++edge) print_edge(edge);
+  }
+  num_forward_edges_in_node0 = num_forward_edges(0);
+  // The keys can't be mapped, but they are a small fraction of the edges.
+  build_edge_keys();
+  return true;
+}
+
+// Fills edge_keys_ from edges_.
+void SquishedDawg::build_edge_keys() {
+  // Enough padding for the widest SIMD read past the last edge.
+  const int kPadding = 8;
+  edge_keys_.assign(num_edges_ + kPadding, -1);
+  for (EDGE_REF edge = 0; edge < num_edges_; ++edge) {
+    if (!edge_occupied(edge)) continue;
+    EDGE_RECORD rec = edge_rec(edge);
+    edge_keys_[edge] = unichar_id_from_edge_rec(rec) << 2 |
+                       end_of_word_from_edge_rec(rec) << 1 |
+                       last_edge(edge);
+  }
+}
+
 std::unique_ptr<EDGE_REF[]> SquishedDawg::build_node_map(
     int32_t *num_nodes) const {
   EDGE_REF   edge;
@@ -398,11 +472,10 @@ bool SquishedDawg::write_squished_dawg(TFile *file) {
   for (edge = 0; edge < num_edges_; edge++) {
     if (forward_edge(edge)) {  // write forward edges
       do {
-        old_index = next_node_from_edge_rec(edges_[edge]);
-        set_next_node(edge, node_map[old_index]);
-        temp_record = edges_[edge];
+        temp_record = edge_rec(edge);
+        old_index = next_node_from_edge_rec(temp_record);
+        set_next_node_in_edge_rec(&temp_record, node_map[old_index]);
         if (!file->Serialize(&temp_record)) return false;
-        set_next_node(edge, old_index);
       } while (!last_edge(edge++));
 
       if (edge >= num_edges_) break;
@@ -27,7 +27,9 @@
 ----------------------------------------------------------------------*/
 
 #include <cinttypes>            // for PRId64
+#include <cstring>              // for memcpy
 #include <memory>
+#include <vector>
 #include "elst.h"
 #include "params.h"
 #include "ratngs.h"
@@ -127,6 +129,9 @@ class Dawg {
 
   virtual ~Dawg();
 
+  /// Returns an estimate of the bytes held by the edges of the Dawg.
+  virtual int64_t MemoryBytes() const = 0;
+
   /// Returns true if the given word is in the Dawg.
   bool word_in_dawg(const WERD_CHOICE &word) const;
 
@@ -404,7 +409,8 @@ class DawgPositionVector : public GenericVector<DawgPosition> {
 /// new words can not be added to an instance of SquishedDawg.
 /// The underlying representation of the nodes and edges in SquishedDawg
 /// is stored as a contiguous EDGE_ARRAY (read from file or given as an
-/// argument to the constructor).
+/// argument to the constructor), or used in place in the bytes of a mapped
+/// traineddata file (see LoadMapped).
 //
 class SquishedDawg : public Dawg {
  public:
@@ -418,27 +424,43 @@ class SquishedDawg : public Dawg {
     ASSERT_HOST(file.Open(filename, nullptr));
     ASSERT_HOST(read_squished_dawg(&file));
     num_forward_edges_in_node0 = num_forward_edges(0);
+    build_edge_keys();
   }
   SquishedDawg(EDGE_ARRAY edges, int num_edges, DawgType type,
                const STRING &lang, PermuterType perm, int unicharset_size,
                int debug_level)
       : Dawg(type, lang, perm, debug_level),
         edges_(edges),
+        edge_data_(reinterpret_cast<const char *>(edges)),
         num_edges_(num_edges) {
     init(unicharset_size);
     num_forward_edges_in_node0 = num_forward_edges(0);
+    build_edge_keys();
     if (debug_level > 3) print_all("SquishedDawg:");
   }
   ~SquishedDawg() override;
 
+  int64_t MemoryBytes() const override {
+    return static_cast<int64_t>(num_edges_) * sizeof(EDGE_RECORD) +
+           edge_keys_.capacity() * sizeof(edge_keys_[0]);
+  }
+
   // Loads using the given TFile. Returns false on failure.
   bool Load(TFile *fp) {
     if (!read_squished_dawg(fp)) return false;
     num_forward_edges_in_node0 = num_forward_edges(0);
+    build_edge_keys();
     return true;
   }
+  // Loads from the bytes of a traineddata component, as returned by
+  // TessdataManager::GetMappedComponent, using the edges in place without a
+  // copy, and keeping data alive. Returns false on failure.
+  bool LoadMapped(std::shared_ptr<const char> data, int size);
 
   int NumEdges() { return num_edges_; }
+  // Returns true if edge_char_of looks up the edges of a node in the packed
+  // key index rather than in the edge records.
+  bool has_edge_keys() const { return !edge_keys_.empty(); }
 
   /// Returns the edge that corresponds to the letter out of this node.
   EDGE_REF edge_char_of(NODE_REF node, UNICHAR_ID unichar_id,
@@ -452,8 +474,9 @@ class SquishedDawg : public Dawg {
     if (!edge_occupied(edge) || edge == NO_EDGE) return;
     assert(forward_edge(edge));  // we don't expect any backward edges to
     do {                         // be present when this function is called
-      if (!word_end || end_of_word_from_edge_rec(edges_[edge])) {
-        vec->push_back(NodeChild(unichar_id_from_edge_rec(edges_[edge]), edge));
+      EDGE_RECORD rec = edge_rec(edge);
+      if (!word_end || end_of_word_from_edge_rec(rec)) {
+        vec->push_back(NodeChild(unichar_id_from_edge_rec(rec), edge));
       }
     } while (!last_edge(edge++));
   }
@@ -461,18 +484,18 @@ class SquishedDawg : public Dawg {
   /// Returns the next node visited by following the edge
   /// indicated by the given EDGE_REF.
   NODE_REF next_node(EDGE_REF edge) const override {
-    return next_node_from_edge_rec((edges_[edge]));
+    return next_node_from_edge_rec(edge_rec(edge));
   }
 
   /// Returns true if the edge indicated by the given EDGE_REF
   /// marks the end of a word.
   bool end_of_word(EDGE_REF edge_ref) const override {
-    return end_of_word_from_edge_rec((edges_[edge_ref]));
+    return end_of_word_from_edge_rec(edge_rec(edge_ref));
   }
 
   /// Returns UNICHAR_ID stored in the edge indicated by the given EDGE_REF.
   UNICHAR_ID edge_letter(EDGE_REF edge_ref) const override {
-    return unichar_id_from_edge_rec((edges_[edge_ref]));
+    return unichar_id_from_edge_rec(edge_rec(edge_ref));
   }
 
   /// Prints the contents of the node indicated by the given NODE_REF.
@@ -499,39 +522,31 @@ class SquishedDawg : public Dawg {
   }
 
  private:
-  /// Sets the next node link for this edge.
-  inline void set_next_node(EDGE_REF edge_ref, EDGE_REF value) {
-    set_next_node_in_edge_rec(&(edges_[edge_ref]), value);
-  }
-  /// Sets the edge to be empty.
-  inline void set_empty_edge(EDGE_REF edge_ref) {
-    (edges_[edge_ref] = next_node_mask_);
-  }
-  /// Goes through all the edges and clears each one out.
-  inline void clear_all_edges() {
-    for (int edge = 0; edge < num_edges_; edge++) set_empty_edge(edge);
-  }
-  /// Clears the last flag of this edge.
-  inline void clear_marker_flag(EDGE_REF edge_ref) {
-     (edges_[edge_ref] &= ~(MARKER_FLAG << flag_start_bit_));
+  /// Returns the record of the edge indicated by the given EDGE_REF.
+  /// The edges may be in a mapped file, with no alignment, so they are
+  /// copied out, which compiles to a plain load.
+  inline EDGE_RECORD edge_rec(EDGE_REF edge_ref) const {
+    EDGE_RECORD rec;
+    memcpy(&rec, edge_data_ + edge_ref * sizeof(rec), sizeof(rec));
+    return rec;
   }
   /// Returns true if this edge is in the forward direction.
   inline bool forward_edge(EDGE_REF edge_ref) const {
     return (edge_occupied(edge_ref) &&
-            (FORWARD_EDGE == direction_from_edge_rec(edges_[edge_ref])));
+            (FORWARD_EDGE == direction_from_edge_rec(edge_rec(edge_ref))));
   }
   /// Returns true if this edge is in the backward direction.
   inline bool backward_edge(EDGE_REF edge_ref) const {
     return (edge_occupied(edge_ref) &&
-            (BACKWARD_EDGE == direction_from_edge_rec(edges_[edge_ref])));
+            (BACKWARD_EDGE == direction_from_edge_rec(edge_rec(edge_ref))));
   }
   /// Returns true if the edge spot in this location is occupied.
   inline bool edge_occupied(EDGE_REF edge_ref) const {
-    return (edges_[edge_ref] != next_node_mask_);
+    return (edge_rec(edge_ref) != next_node_mask_);
   }
   /// Returns true if this edge is the last edge in a sequence.
   inline bool last_edge(EDGE_REF edge_ref) const {
-    return (edges_[edge_ref] & (MARKER_FLAG << flag_start_bit_)) != 0;
+    return (edge_rec(edge_ref) & (MARKER_FLAG << flag_start_bit_)) != 0;
   }
 
   /// Counts and returns the number of forward edges in this node.
@@ -551,11 +566,25 @@ class SquishedDawg : public Dawg {
   }
   /// Constructs a mapping from the memory node indices to disk node indices.
   std::unique_ptr<EDGE_REF[]> build_node_map(int32_t *num_nodes) const;
+  /// Fills edge_keys_ from edges_.
+  void build_edge_keys();
 
   // Member variables.
-  EDGE_ARRAY edges_;
+  // The edges, if owned, else nullptr.
+  EDGE_ARRAY edges_ = nullptr;
+  // The bytes of the edges, of edges_ or in mapped_data_.
+  const char *edge_data_ = nullptr;
+  // The mapped traineddata component that the edges are in, if LoadMapped.
+  std::shared_ptr<const char> mapped_data_;
   int32_t num_edges_;
   int num_forward_edges_in_node0;
+  // A compact copy of the parts of edges_ used by edge_char_of, so that the
+  // edges of a node can be searched in a few cache lines, with SIMD where
+  // available. Each edge has unichar_id << 2 | end_of_word << 1 | last_edge,
+  // or -1 if unoccupied, which also ends the search. Padded with -1 for the
+  // SIMD reads past the end. Not built for mapped edges, which are shared,
+  // in which case edge_char_of searches the edges themselves.
+  std::vector<int32_t> edge_keys_;
 };
 
 }  // namespace tesseract
@@ -20,6 +20,7 @@
 #include "dawg_cache.h"
 
 #include "dawg.h"
+#include "initprofile.h"
 #include "object_cache.h"
 #include "strngs.h"
 #include "tessdatamanager.h"
@@ -52,8 +53,14 @@ Dawg *DawgCache::GetSquishedDawg(const STRING &lang,
 }
 
 Dawg *DawgLoader::Load() {
+  InitPhase phase(kTessdataFileSuffixes[tessdata_dawg_type_]);
+  int mapped_size;
+  std::shared_ptr<const char> mapped =
+      data_file_->GetMappedComponent(tessdata_dawg_type_, &mapped_size);
+  // A mapped dawg is not loaded at all, as its edges are used in place.
   TFile fp;
-  if (!data_file_->GetComponent(tessdata_dawg_type_, &fp)) return nullptr;
+  if (mapped == nullptr && !data_file_->GetComponent(tessdata_dawg_type_, &fp))
+    return nullptr;
   DawgType dawg_type;
   PermuterType perm_type;
   switch (tessdata_dawg_type_) {
@@ -89,7 +96,12 @@ Dawg *DawgLoader::Load() {
   }
   auto *retval =
       new SquishedDawg(dawg_type, lang_, perm_type, dawg_debug_level_);
-  if (retval->Load(&fp)) return retval;
+  // Use the edges in place if they are mapped from the file, so the memory is
+  // shared with other processes using the same traineddata.
+  if (mapped != nullptr ? retval->LoadMapped(std::move(mapped), mapped_size)
+                        : retval->Load(&fp)) {
+    return retval;
+  }
   delete retval;
   return nullptr;
 }
@@ -19,6 +19,7 @@
 #include <cstdio>
 
 #include "dict.h"
+#include "counters.h"
 #include "unicodes.h"
 
 #include "tprintf.h"
@@ -27,6 +28,16 @@ namespace tesseract {
 
 class Image;
 
+// Beyond this many words the valid_word and valid_punctuation caches are
+// emptied, so a huge page can't make them grow without bound.
+const size_t kMaxWordCacheSize = 50000;
+
+// Returns the key of word in the valid_word and valid_punctuation caches.
+static std::string WordCacheKey(const WERD_CHOICE& word) {
+  return std::string(reinterpret_cast<const char*>(word.unichar_ids()),
+                     word.length() * sizeof(UNICHAR_ID));
+}
+
 Dict::Dict(CCUtil* ccutil)
     : letter_is_okay_(&tesseract::Dict::def_letter_is_okay),
       probability_in_context_(&tesseract::Dict::def_probability_in_context),
@@ -359,6 +370,15 @@ void Dict::LoadLSTM(const STRING& lang, TessdataManager* data_file) {
 // Returns false if no dictionaries were loaded.
 bool Dict::FinishLoad() {
   if (dawgs_.empty()) return false;
+  SetupSuccessors();
+  return true;
+}
+
+// Fills successors_ from dawgs_.
+void Dict::SetupSuccessors() {
+  ClearWordCache();
+  successors_.delete_data_pointers();
+  successors_.clear();
   // Construct a list of corresponding successors for each dawg. Each entry, i,
   // in the successors_ vector is a vector of integers that represent the
   // indices into the dawgs_ vector of the successors for dawg i.
@@ -375,11 +395,12 @@ bool Dict::FinishLoad() {
     }
     successors_ += lst;
   }
-  return true;
 }
 
 void Dict::End() {
   if (dawgs_.length() == 0) return;  // Not safe to call twice.
+  // The attached dawgs belong to the caller.
+  while (!attached_dawgs_.empty()) DetachDawg(attached_dawgs_.back());
   for (int i = 0; i < dawgs_.size(); i++) {
     if (!dawg_cache_->FreeDawg(dawgs_[i])) {
       delete dawgs_[i];
@@ -393,17 +414,44 @@ void Dict::End() {
   successors_.delete_data_pointers();
   dawgs_.clear();
   successors_.clear();
+  ClearWordCache();
   document_words_ = nullptr;
   delete pending_words_;
   pending_words_ = nullptr;
 }
 
+bool Dict::AttachDawg(Dawg* dawg) {
+  if (dawgs_.empty()) return false;
+  dawgs_ += dawg;
+  attached_dawgs_ += dawg;
+  SetupSuccessors();
+  // A hyphenated word in progress has positions in the old dawgs_.
+  reset_hyphen_vars(true);
+  return true;
+}
+
+bool Dict::DetachDawg(Dawg* dawg) {
+  int index = 0;
+  while (index < attached_dawgs_.size() && attached_dawgs_[index] != dawg) {
+    ++index;
+  }
+  if (index == attached_dawgs_.size()) return false;
+  attached_dawgs_.remove(index);
+  index = 0;
+  while (dawgs_[index] != dawg) ++index;
+  dawgs_.remove(index);
+  SetupSuccessors();
+  reset_hyphen_vars(true);
+  return true;
+}
+
 // Returns true if in light of the current state unichar_id is allowed
 // according to at least one of the dawgs in the dawgs_ vector.
 // See more extensive comments in dict.h where this function is declared.
 int Dict::def_letter_is_okay(void* void_dawg_args, const UNICHARSET& unicharset,
                              UNICHAR_ID unichar_id, bool word_end) const {
   auto* dawg_args = static_cast<DawgArgs*>(void_dawg_args);
+  CountEvent(COUNTER_DAWG_LOOKUPS);
 
   ASSERT_HOST(unicharset.contains_unichar_id(unichar_id));
 
@@ -447,7 +495,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, const UNICHARSET& unicharset,
       // We're in the punctuation dawg.  A core dawg has not been chosen.
       NODE_REF punc_node = GetStartingNode(punc_dawg, pos.punc_ref);
       EDGE_REF punc_transition_edge =
-          punc_dawg->edge_char_of(punc_node, Dawg::kPatternUnicharID, word_end);
+          CachedEdgeCharOf(*dawg_args, pos.punc_index, punc_node,
+                           Dawg::kPatternUnicharID, word_end);
       if (punc_transition_edge != NO_EDGE) {
         // Find all successors, and see which can transition.
         const SuccessorList& slist = *(successors_[pos.punc_index]);
@@ -455,7 +504,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, const UNICHARSET& unicharset,
           int sdawg_index = slist[s];
           const Dawg* sdawg = dawgs_[sdawg_index];
           UNICHAR_ID ch = char_for_dawg(unicharset, unichar_id, sdawg);
-          EDGE_REF dawg_edge = sdawg->edge_char_of(0, ch, word_end);
+          EDGE_REF dawg_edge =
+              CachedEdgeCharOf(*dawg_args, sdawg_index, 0, ch, word_end);
           if (dawg_edge != NO_EDGE) {
             if (dawg_debug_level >= 3) {
               tprintf("Letter found in dawg %d\n", sdawg_index);
@@ -472,8 +522,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, const UNICHARSET& unicharset,
           }
         }
       }
-      EDGE_REF punc_edge =
-          punc_dawg->edge_char_of(punc_node, unichar_id, word_end);
+      EDGE_REF punc_edge = CachedEdgeCharOf(*dawg_args, pos.punc_index,
+                                            punc_node, unichar_id, word_end);
       if (punc_edge != NO_EDGE) {
         if (dawg_debug_level >= 3) {
           tprintf("Letter found in punctuation dawg\n");
@@ -494,7 +544,8 @@ int Dict::def_letter_is_okay(void* void_dawg_args, const UNICHARSET& unicharset,
       EDGE_REF punc_edge =
           punc_node == NO_EDGE
               ? NO_EDGE
-              : punc_dawg->edge_char_of(punc_node, unichar_id, word_end);
+              : CachedEdgeCharOf(*dawg_args, pos.punc_index, punc_node,
+                                 unichar_id, word_end);
       if (punc_edge != NO_EDGE) {
         dawg_args->updated_dawgs->add_unique(
             DawgPosition(pos.dawg_index, pos.dawg_ref, pos.punc_index,
@@ -523,8 +574,9 @@ int Dict::def_letter_is_okay(void* void_dawg_args, const UNICHARSET& unicharset,
     EDGE_REF edge =
         (node == NO_EDGE)
             ? NO_EDGE
-            : dawg->edge_char_of(
-                  node, char_for_dawg(unicharset, unichar_id, dawg), word_end);
+            : CachedEdgeCharOf(*dawg_args, pos.dawg_index, node,
+                               char_for_dawg(unicharset, unichar_id, dawg),
+                               word_end);
 
     if (dawg_debug_level >= 3) {
       tprintf("Active dawg: [%d, " REFFORMAT "] edge=" REFFORMAT "\n",
@@ -705,6 +757,7 @@ void Dict::add_document_word(const WERD_CHOICE& best_choice) {
     fclose(doc_word_file);
   }
   document_words_->add_word_to_dawg(best_choice);
+  valid_word_cache_.clear();
 }
 
 void Dict::adjust_word(WERD_CHOICE* word, bool nonword,
@@ -787,12 +840,31 @@ void Dict::adjust_word(WERD_CHOICE* word, bool nonword,
 int Dict::valid_word(const WERD_CHOICE& word, bool numbers_ok) const {
   const WERD_CHOICE* word_ptr = &word;
   WERD_CHOICE temp_word(word.unicharset());
-  if (hyphenated() && hyphen_word_->unicharset() == word.unicharset()) {
+  bool continues_hyphen =
+      hyphenated() && hyphen_word_->unicharset() == word.unicharset();
+  if (continues_hyphen) {
     copy_hyphen_info(&temp_word);
     temp_word += word;
     word_ptr = &temp_word;
   }
   if (word_ptr->length() == 0) return NO_PERM;
+  // The same words are looked up many times over a page, so the permuter is
+  // remembered, unless it depends on the hyphenated word before it.
+  std::string key;
+  if (!continues_hyphen) {
+    if (word.unicharset() != valid_word_cache_unicharset_ ||
+        letter_is_okay_ != valid_word_cache_func_) {
+      valid_word_cache_.clear();
+      valid_word_cache_unicharset_ = word.unicharset();
+      valid_word_cache_func_ = letter_is_okay_;
+    }
+    key = WordCacheKey(word);
+    auto it = valid_word_cache_.find(key);
+    if (it != valid_word_cache_.end()) {
+      return valid_word_permuter(it->second, numbers_ok) ? it->second
+                                                         : NO_PERM;
+    }
+  }
   // Allocate vectors for holding current and updated
   // active_dawgs and initialize them.
   auto* active_dawgs = new DawgPositionVector[2];
@@ -814,6 +886,10 @@ int Dict::valid_word(const WERD_CHOICE& word, bool numbers_ok) const {
     }
   }
   delete[] active_dawgs;
+  if (!continues_hyphen) {
+    if (valid_word_cache_.size() >= kMaxWordCacheSize) valid_word_cache_.clear();
+    valid_word_cache_[key] = dawg_args.permuter;
+  }
   return valid_word_permuter(dawg_args.permuter, numbers_ok)
              ? dawg_args.permuter
              : NO_PERM;
@@ -864,6 +940,18 @@ bool Dict::valid_bigram(const WERD_CHOICE& word1,
 
 bool Dict::valid_punctuation(const WERD_CHOICE& word) {
   if (word.length() == 0) return NO_PERM;
+  std::string key = WordCacheKey(word);
+  auto it = valid_punctuation_cache_.find(key);
+  if (it != valid_punctuation_cache_.end()) return it->second;
+  if (valid_punctuation_cache_.size() >= kMaxWordCacheSize) {
+    valid_punctuation_cache_.clear();
+  }
+  bool valid = valid_punctuation_uncached(word);
+  valid_punctuation_cache_[key] = valid;
+  return valid;
+}
+
+bool Dict::valid_punctuation_uncached(const WERD_CHOICE& word) const {
   int i;
   WERD_CHOICE new_word(word.unicharset());
   int last_index = word.length() - 1;
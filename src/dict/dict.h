@@ -22,11 +22,16 @@
 #include "ambigs.h"
 #include "dawg.h"
 #include "dawg_cache.h"
+#include "memoryusage.h"
 #include "ratngs.h"
 #include "stopper.h"
 #include "trie.h"
 #include "unicharset.h"
 #include "params_training_featdef.h"
+#include <cstdint>  // for uint32_t, uint64_t
+#include <string>   // for std::string
+#include <unordered_map>  // for std::unordered_map
+#include <vector>   // for std::vector
 
 class MATRIX;
 class WERD_RES;
@@ -73,15 +78,90 @@ static const int kDocDictMaxRepChars = 4;
 //  2 - the word is inconsistent.
 enum XHeightConsistencyEnum {XH_GOOD, XH_SUBNORMAL, XH_INCONSISTENT};
 
+// A bounded cache of the edges found by Dawg::edge_char_of, keyed on the index
+// of the dawg in the Dict, the node and the unichar_id, so that the beam
+// search, which looks up the same transitions many times over on a line,
+// only searches the dawg once for each. The entries are direct-mapped, so a
+// new entry replaces any old one in its place. Not thread-safe, so each
+// thread needs its own. Clear must be called whenever the dawgs may have
+// changed.
+class DawgTransitionCache {
+ public:
+  DawgTransitionCache() : entries_(kNumEntries), generation_(1) {}
+
+  // Invalidates all the entries.
+  void Clear() {
+    if (++generation_ == 0) {
+      // All the old entries must be reset before the generation can be reused.
+      for (auto &entry : entries_) entry.generation = 0;
+      generation_ = 1;
+    }
+  }
+  // Returns true and the cached edge if there is one for the given key.
+  bool Lookup(int dawg_index, NODE_REF node, UNICHAR_ID unichar_id,
+              bool word_end, EDGE_REF *edge) const {
+    const Entry &entry = entries_[Index(dawg_index, node, unichar_id, word_end)];
+    if (entry.generation != generation_ || entry.node != node ||
+        entry.dawg_index != dawg_index || entry.unichar_id != unichar_id ||
+        entry.word_end != word_end) {
+      return false;
+    }
+    *edge = entry.edge;
+    return true;
+  }
+  // Stores the edge for the given key.
+  void Insert(int dawg_index, NODE_REF node, UNICHAR_ID unichar_id,
+              bool word_end, EDGE_REF edge) {
+    Entry &entry = entries_[Index(dawg_index, node, unichar_id, word_end)];
+    entry.node = node;
+    entry.edge = edge;
+    entry.dawg_index = dawg_index;
+    entry.unichar_id = unichar_id;
+    entry.generation = generation_;
+    entry.word_end = word_end;
+  }
+
+ private:
+  // Number of bits in the index of an entry.
+  static const int kNumBits = 12;
+  static const int kNumEntries = 1 << kNumBits;
+
+  struct Entry {
+    NODE_REF node;
+    EDGE_REF edge;
+    int32_t dawg_index;
+    UNICHAR_ID unichar_id;
+    // Entries of an older generation than generation_ are invalid.
+    uint32_t generation = 0;
+    bool word_end;
+  };
+
+  // Returns the index of the entry for the given key, by multiplicative
+  // hashing.
+  static int Index(int dawg_index, NODE_REF node, UNICHAR_ID unichar_id,
+                   bool word_end) {
+    uint64_t key = static_cast<uint64_t>(node);
+    key = key * 31 + static_cast<uint32_t>(unichar_id);
+    key = key * 31 + static_cast<uint32_t>(dawg_index) * 2 + word_end;
+    return static_cast<int>((key * 0x9E3779B97F4A7C15ULL) >> (64 - kNumBits));
+  }
+
+  std::vector<Entry> entries_;
+  uint32_t generation_;
+};
+
 struct DawgArgs {
   DawgArgs(DawgPositionVector *d, DawgPositionVector *up, PermuterType p)
-      : active_dawgs(d), updated_dawgs(up), permuter(p), valid_end(false) {}
+      : active_dawgs(d), updated_dawgs(up), permuter(p), valid_end(false),
+        transition_cache(nullptr) {}
 
   DawgPositionVector *active_dawgs;
   DawgPositionVector *updated_dawgs;
   PermuterType permuter;
   // True if the current position is a valid word end.
   bool valid_end;
+  // Optional cache of the dawg transitions, owned by the caller.
+  DawgTransitionCache *transition_cache;
 };
 
 class Dict {
@@ -312,6 +392,14 @@ class Dict {
   // Returns false if no dictionaries were loaded.
   bool FinishLoad();
   void End();
+  // Attaches the given dawg, made with the unicharset of *this, to be searched
+  // with the loaded dawgs, as for user_words_file, until DetachDawg or End.
+  // The loaded dawgs are untouched, so they stay shared in the DawgCache, and
+  // the caller keeps the ownership of dawg. Must not be called during
+  // recognition. Returns false if nothing is loaded.
+  bool AttachDawg(Dawg *dawg);
+  // Detaches a dawg attached with AttachDawg. Returns false if not attached.
+  bool DetachDawg(Dawg *dawg);
 
   // Resets the document dictionary analogous to ResetAdaptiveClassifier.
   void ResetDocumentDictionary() {
@@ -319,6 +407,13 @@ class Dict {
       pending_words_->clear();
     if (document_words_ != nullptr)
       document_words_->clear();
+    ClearWordCache();
+  }
+  /// Forgets the results remembered by valid_word and valid_punctuation.
+  /// Called whenever the dawgs change, and at the start of each page.
+  void ClearWordCache() const {
+    valid_word_cache_.clear();
+    valid_punctuation_cache_.clear();
   }
 
   /**
@@ -415,8 +510,19 @@ class Dict {
         getCCUtil()->lang.string(), path);
   }
 
+  // Fills successors_ from dawgs_.
+  void SetupSuccessors();
+  // Computes valid_punctuation without the cache.
+  bool valid_punctuation_uncached(const WERD_CHOICE &word) const;
+
   inline void SetWildcardID(UNICHAR_ID id) { wildcard_unichar_id_ = id; }
   inline UNICHAR_ID WildcardID() const { return wildcard_unichar_id_; }
+  /// Adds the bytes of the loaded dawgs to usage.
+  void AddMemoryUsage(MemoryUsage* usage) const {
+    for (int i = 0; i < dawgs_.size(); ++i) {
+      usage->Add(MEMORY_DAWGS, dawgs_[i]->MemoryBytes());
+    }
+  }
   /// Return the number of dawgs in the dawgs_ vector.
   inline int NumDawgs() const { return dawgs_.size(); }
   /// Return i-th dawg pointer recorded in the dawgs_ vector.
@@ -433,6 +539,23 @@ class Dict {
     return node;
   }
 
+  /// Returns dawgs_[dawg_index]->edge_char_of(node, unichar_id, word_end),
+  /// using the transition cache of dawg_args if it has one.
+  EDGE_REF CachedEdgeCharOf(const DawgArgs &dawg_args, int dawg_index,
+                            NODE_REF node, UNICHAR_ID unichar_id,
+                            bool word_end) const {
+    DawgTransitionCache *cache = dawg_args.transition_cache;
+    EDGE_REF edge;
+    if (cache != nullptr &&
+        cache->Lookup(dawg_index, node, unichar_id, word_end, &edge)) {
+      return edge;
+    }
+    edge = dawgs_[dawg_index]->edge_char_of(node, unichar_id, word_end);
+    if (cache != nullptr)
+      cache->Insert(dawg_index, node, unichar_id, word_end, edge);
+    return edge;
+  }
+
   // Given a unichar from a string and a given dawg, return the unichar
   // we should use to match in that dawg type.  (for example, in the number
   // dawg, all numbers are transformed to kPatternUnicharId).
@@ -539,6 +662,19 @@ class Dict {
   // Dawgs.
   DawgVector dawgs_;
   SuccessorListsVector successors_;
+  // The dawgs of AttachDawg, also in dawgs_, but not owned.
+  DawgVector attached_dawgs_;
+  // Results of valid_word, before the numbers_ok test, and of
+  // valid_punctuation, keyed on the unichar ids of the word. Words that
+  // continue a hyphenated word are not cached. See ClearWordCache.
+  mutable std::unordered_map<std::string, int> valid_word_cache_;
+  mutable std::unordered_map<std::string, bool> valid_punctuation_cache_;
+  // The unicharset and letter_is_okay_ that valid_word_cache_ was filled with.
+  mutable const UNICHARSET* valid_word_cache_unicharset_ = nullptr;
+  mutable int (Dict::*valid_word_cache_func_)(void* void_dawg_args,
+                                              const UNICHARSET& unicharset,
+                                              UNICHAR_ID unichar_id,
+                                              bool word_end) const = nullptr;
   Trie *pending_words_;
   /// The following pointers are only cached for convenience.
   /// The dawgs will be deleted when dawgs_ vector is destroyed.
@@ -23,6 +23,10 @@
 
 #include "trie.h"
 
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
 #include "callcpp.h"
 #include "dawg.h"
 #include "dict.h"
@@ -53,6 +57,17 @@ const char *Trie::get_reverse_policy_name(RTLReversePolicy reverse_policy) {
   return RTLReversePolicyNames[reverse_policy];
 }
 
+int64_t Trie::MemoryBytes() const {
+  int64_t bytes = nodes_.size_reserved() * sizeof(TRIE_NODE_RECORD *);
+  for (int i = 0; i < nodes_.size(); ++i) {
+    bytes += sizeof(TRIE_NODE_RECORD) +
+             (nodes_[i]->forward_edges.size_reserved() +
+              nodes_[i]->backward_edges.size_reserved()) *
+                 sizeof(EDGE_RECORD);
+  }
+  return bytes;
+}
+
 // Reset the Trie to empty.
 void Trie::clear() {
   nodes_.delete_data_pointers();
@@ -334,6 +349,218 @@ bool Trie::add_word_list(const GenericVector<STRING> &words,
   return true;
 }
 
+// Builds the minimal dawg of a sorted list of words, one word at a time.
+// The nodes on the path of the last word added are kept open for the next
+// word, and the rest are frozen in their final SquishedDawg form, and
+// registered, so that a node equivalent to an existing one is replaced by it,
+// which is all the minimization needed, as the words come in order.
+class Trie::SortedDawgBuilder {
+ public:
+  explicit SortedDawgBuilder(Trie *trie)
+      : trie_(trie),
+        depth_(0),
+        path_(1),
+        registry_(kInitialBuckets, NodeHash(this), NodeEqual(this)) {}
+
+  // Adds the next word, if valid. Returns false if it is out of order.
+  bool AddWord(const char *word_str, const UNICHARSET &unicharset,
+               Trie::RTLReversePolicy reverse_policy);
+  // Returns the dawg of all the words added, or nullptr if there are none.
+  SquishedDawg *Finish();
+
+ private:
+  static const int kInitialBuckets = 1024;
+
+  // Hash and equality of the edges of the frozen nodes, which are given by
+  // the index of their first edge in edges_.
+  struct NodeHash {
+    explicit NodeHash(const SortedDawgBuilder *builder) : builder(builder) {}
+    size_t operator()(EDGE_REF edge) const {
+      const std::vector<EDGE_RECORD> &edges = builder->edges_;
+      size_t hash = 0;
+      do {
+        hash = hash * 31 + std::hash<EDGE_RECORD>()(edges[edge]);
+      } while (!builder->trie_->marker_flag_from_edge_rec(edges[edge++]));
+      return hash;
+    }
+    const SortedDawgBuilder *builder;
+  };
+  struct NodeEqual {
+    explicit NodeEqual(const SortedDawgBuilder *builder) : builder(builder) {}
+    bool operator()(EDGE_REF edge1, EDGE_REF edge2) const {
+      const std::vector<EDGE_RECORD> &edges = builder->edges_;
+      for (;; ++edge1, ++edge2) {
+        if (edges[edge1] != edges[edge2]) return false;
+        if (builder->trie_->marker_flag_from_edge_rec(edges[edge1])) {
+          return true;
+        }
+      }
+    }
+    const SortedDawgBuilder *builder;
+  };
+
+  // Sorts the edges of the given node in increasing order of unichar ids.
+  void SortEdges(std::vector<EDGE_RECORD> *node) const;
+  // Freezes the last open node, and links the edge to it from the node
+  // before.
+  void FreezeLast();
+
+  Trie *trie_;
+  // The unichar-ids of the last word added.
+  std::vector<UNICHAR_ID> last_word_;
+  // Number of the open nodes after the root.
+  int depth_;
+  // Edges of the open nodes, path_[i] being the node after the first i
+  // unichars of last_word_. The last edge of each leads to the next one, and
+  // path_[i] for i > depth_ are empty.
+  std::vector<std::vector<EDGE_RECORD>> path_;
+  // Edges of the frozen nodes, with the last edge of each node marked, and
+  // the next node of each edge as one more than the index of its first edge,
+  // or 0 for none.
+  std::vector<EDGE_RECORD> edges_;
+  // The distinct frozen nodes.
+  std::unordered_set<EDGE_REF, NodeHash, NodeEqual> registry_;
+};
+
+bool Trie::SortedDawgBuilder::AddWord(const char *word_str,
+                                      const UNICHARSET &unicharset,
+                                      Trie::RTLReversePolicy reverse_policy) {
+  WERD_CHOICE word(word_str, unicharset);
+  if (word.length() == 0 || word.contains_unichar_id(INVALID_UNICHAR_ID))
+    return true;
+  if ((reverse_policy == RRP_REVERSE_IF_HAS_RTL &&
+       word.has_rtl_unichar_id()) ||
+      reverse_policy == RRP_FORCE_REVERSE) {
+    word.reverse_and_mirror_unichar_ids();
+  }
+  int length = word.length();
+  for (int i = 0; i < length; ++i) {
+    if (word.unichar_id(i) >= trie_->unicharset_size_) return true;
+  }
+  int prefix = 0;
+  int last_length = last_word_.size();
+  while (prefix < length && prefix < last_length &&
+         word.unichar_id(prefix) == last_word_[prefix]) {
+    ++prefix;
+  }
+  if (prefix == length && prefix == last_length) return true;
+  // The nodes past the common prefix get no more edges.
+  while (depth_ > prefix) FreezeLast();
+  last_word_.resize(prefix);
+  if (prefix == length) {
+    // A prefix of the last word just ends at the edge to the open node.
+    path_[depth_ - 1].back() |= (WERD_END_FLAG << trie_->flag_start_bit_);
+    return true;
+  }
+  // A frozen edge with the next unichar means the words are out of order.
+  UNICHAR_ID unichar_id = word.unichar_id(prefix);
+  for (const EDGE_RECORD &edge_rec : path_[depth_]) {
+    if (trie_->unichar_id_from_edge_rec(edge_rec) == unichar_id) {
+      tprintf("Word list is not sorted at '%s'\n", word_str);
+      return false;
+    }
+  }
+  for (int i = prefix; i < length; ++i) {
+    EDGE_RECORD edge_rec;
+    trie_->link_edge(&edge_rec, 0, false, FORWARD_EDGE, i == length - 1,
+                     word.unichar_id(i));
+    path_[depth_].push_back(edge_rec);
+    if (++depth_ == static_cast<int>(path_.size())) path_.resize(depth_ + 1);
+    last_word_.push_back(word.unichar_id(i));
+  }
+  return true;
+}
+
+SquishedDawg *Trie::SortedDawgBuilder::Finish() {
+  while (depth_ > 0) FreezeLast();
+  std::vector<EDGE_RECORD> &root = path_[0];
+  if (root.empty()) return nullptr;
+  SortEdges(&root);
+  trie_->set_marker_flag_in_edge_rec(&root.back());
+  // The root goes first, so the frozen nodes move up by its size.
+  int num_root_edges = root.size();
+  int num_edges = num_root_edges + edges_.size();
+  auto edge_array = new EDGE_RECORD[num_edges];
+  std::copy(root.begin(), root.end(), edge_array);
+  std::copy(edges_.begin(), edges_.end(), edge_array + num_root_edges);
+  for (int i = 0; i < num_edges; ++i) {
+    NODE_REF next_node = trie_->next_node_from_edge_rec(edge_array[i]);
+    if (next_node != 0) {
+      trie_->set_next_node_in_edge_rec(&edge_array[i],
+                                       next_node - 1 + num_root_edges);
+    }
+  }
+  if (trie_->debug_level_) {
+    tprintf("%zu nodes, %d edges in DAWG\n", registry_.size() + 1, num_edges);
+  }
+  return new SquishedDawg(edge_array, num_edges, trie_->type_, trie_->lang_,
+                          trie_->perm_, trie_->unicharset_size_,
+                          trie_->debug_level_);
+}
+
+// Sorts the edges of the given node in increasing order of unichar ids.
+void Trie::SortedDawgBuilder::SortEdges(std::vector<EDGE_RECORD> *node) const {
+  std::sort(node->begin(), node->end(),
+            [this](const EDGE_RECORD &edge1, const EDGE_RECORD &edge2) {
+              return trie_->unichar_id_from_edge_rec(edge1) <
+                     trie_->unichar_id_from_edge_rec(edge2);
+            });
+}
+
+// Freezes the last open node, and links the edge to it from the node before.
+void Trie::SortedDawgBuilder::FreezeLast() {
+  std::vector<EDGE_RECORD> &node = path_[depth_--];
+  NODE_REF next_node = 0;
+  if (!node.empty()) {
+    // Sorting makes equivalent nodes identical, whatever the order of the
+    // words that made them.
+    SortEdges(&node);
+    EDGE_REF first_edge = edges_.size();
+    edges_.insert(edges_.end(), node.begin(), node.end());
+    trie_->set_marker_flag_in_edge_rec(&edges_.back());
+    node.clear();
+    auto result = registry_.insert(first_edge);
+    if (!result.second) edges_.resize(first_edge);
+    next_node = *result.first + 1;
+  }
+  trie_->set_next_node_in_edge_rec(&path_[depth_].back(), next_node);
+}
+
+SquishedDawg *Trie::sorted_word_list_to_dawg(
+    const GenericVector<STRING> &words, const UNICHARSET &unicharset,
+    Trie::RTLReversePolicy reverse_policy) {
+  SortedDawgBuilder builder(this);
+  for (int i = 0; i < words.size(); ++i) {
+    if (!builder.AddWord(words[i].string(), unicharset, reverse_policy)) {
+      return nullptr;
+    }
+  }
+  return builder.Finish();
+}
+
+SquishedDawg *Trie::read_sorted_word_list_to_dawg(
+    const char *filename, const UNICHARSET &unicharset,
+    Trie::RTLReversePolicy reverse_policy) {
+  FILE *word_file = fopen(filename, "rb");
+  if (word_file == nullptr) return nullptr;
+  SortedDawgBuilder builder(this);
+  char line_str[CHARS_PER_LINE];
+  int word_count = 0;
+  bool sorted = true;
+  while (sorted && fgets(line_str, sizeof(line_str), word_file) != nullptr) {
+    chomp_string(line_str);  // remove newline
+    ++word_count;
+    if (debug_level_ && word_count % 10000 == 0)
+      tprintf("Read %d words so far\n", word_count);
+    sorted = builder.AddWord(line_str, unicharset, reverse_policy);
+  }
+  fclose(word_file);
+  if (!sorted) return nullptr;
+  if (debug_level_)
+    tprintf("Read %d words total.\n", word_count);
+  return builder.Finish();
+}
+
 void Trie::initialize_patterns(UNICHARSET *unicharset) {
   unicharset->unichar_insert(kAlphaPatternUnicode);
   alpha_pattern_ = unicharset->unichar_to_id(kAlphaPatternUnicode);
@@ -157,6 +157,8 @@ class Trie : public Dawg {
   // At most max_num_edges will be printed.
   void print_node(NODE_REF node, int max_num_edges) const override;
 
+  int64_t MemoryBytes() const override;
+
   // Writes edges from nodes_ to an EDGE_ARRAY and creates a SquishedDawg.
   // Eliminates redundant edges and returns the pointer to the SquishedDawg.
   // Note: the caller is responsible for deallocating memory associated
@@ -182,6 +184,25 @@ class Trie : public Dawg {
                      const UNICHARSET &unicharset,
                      Trie::RTLReversePolicy reverse_policy);
 
+  // Builds a minimal SquishedDawg straight from the given list of words, in
+  // a single pass with the incremental algorithm of Daciuk et al. for sorted
+  // input, without using the nodes of the Trie, so memory use is bounded by
+  // the size of the result. The words must be sorted so that all the words
+  // with the same prefix, in unichar-ids after any reversal, are together,
+  // as by a byte order sort (LC_ALL=C sort) of an LTR list. Returns nullptr
+  // if they are not, or there are no words, in which case trie_to_dawg can
+  // still be used.
+  // Note: the caller is responsible for deallocating memory associated
+  // with the returned SquishedDawg pointer.
+  SquishedDawg *sorted_word_list_to_dawg(const GenericVector<STRING> &words,
+                                         const UNICHARSET &unicharset,
+                                         Trie::RTLReversePolicy reverse_policy);
+  // As sorted_word_list_to_dawg, but streams the words from the given file,
+  // reading it as read_word_list.
+  SquishedDawg *read_sorted_word_list_to_dawg(
+      const char *filename, const UNICHARSET &unicharset,
+      Trie::RTLReversePolicy reverse_policy);
+
   // Inserts the list of patterns from the given file into the Trie.
   // The pattern list file should contain one pattern per line in UTF-8 format.
   //
@@ -265,6 +286,9 @@ class Trie : public Dawg {
   }
 
  protected:
+  // Builds the minimal dawg of sorted_word_list_to_dawg.
+  class SortedDawgBuilder;
+
   // The structure of an EDGE_REF for Trie edges is as follows:
   // [LETTER_START_BIT, flag_start_bit_):
   //                             edge index in *_edges in a TRIE_NODE_RECORD
@@ -20,11 +20,19 @@
 
 #include "convolve.h"
 
+#include <algorithm>  // for std::min
+#include <vector>     // for std::vector
+
+#include "fullyconnected.h"
+#include "maxpool.h"
 #include "networkscratch.h"
 #include "serialis.h"
 
 namespace tesseract {
 
+// Max number of timesteps stacked together by ForwardWithFullyConnected.
+const int kMaxPartWidth = 256;
+
 Convolve::Convolve(const STRING& name, int ni, int half_x, int half_y)
   : Network(NT_CONVOLVE, name, ni, ni * (2*half_x + 1) * (2*half_y + 1)),
     half_x_(half_x), half_y_(half_y) {
@@ -51,32 +59,164 @@ void Convolve::Forward(bool debug, const NetworkIO& input,
                        const TransposedArray* input_transpose,
                        NetworkScratch* scratch, NetworkIO* output) {
   output->Resize(input, no_);
-  int y_scale = 2 * half_y_ + 1;
+  TRand* randomizer =
+      scratch->randomizer() != nullptr ? scratch->randomizer() : randomizer_;
+  // For inference, each image of a batch gets the same random padding that it
+  // would get on its own, so the results don't depend on the batching.
+  bool reset_randomizer = !IsTraining() && randomizer != nullptr;
+  TRand batch_randomizer;
+  if (reset_randomizer) batch_randomizer = *randomizer;
   StrideMap::Index dest_index(output->stride_map());
   do {
-    // Stack x_scale groups of y_scale * ni_ inputs together.
-    int t = dest_index.t();
-    int out_ix = 0;
-    for (int x = -half_x_; x <= half_x_; ++x, out_ix += y_scale * ni_) {
-      StrideMap::Index x_index(dest_index);
-      if (!x_index.AddOffset(x, FD_WIDTH)) {
-        // This x is outside the image.
-        output->Randomize(t, out_ix, y_scale * ni_, randomizer_);
-      } else {
-        int out_iy = out_ix;
-        for (int y = -half_y_; y <= half_y_; ++y, out_iy += ni_) {
-          StrideMap::Index y_index(x_index);
-          if (!y_index.AddOffset(y, FD_HEIGHT)) {
-            // This y is outside the image.
-            output->Randomize(t, out_iy, ni_, randomizer_);
-          } else {
-            output->CopyTimeStepGeneral(t, out_iy, ni_, input, y_index.t(), 0);
+    if (reset_randomizer && dest_index.index(FD_HEIGHT) == 0 &&
+        dest_index.index(FD_WIDTH) == 0) {
+      *randomizer = batch_randomizer;
+    }
+    StackInputs(input, dest_index, randomizer, dest_index.t(), output);
+  } while (dest_index.Increment());
+  if (debug) DisplayForward(*output);
+}
+
+// Runs inference of *this followed by fc, giving the output of
+// fc->Forward on the output of Forward, but stacking the inputs a part of
+// the line at a time into a small buffer that stays in the cache, instead
+// of into a whole NetworkIO at the full resolution of the image.
+void Convolve::ForwardWithFullyConnected(const NetworkIO& input,
+                                         FullyConnected* fc,
+                                         NetworkScratch* scratch,
+                                         NetworkIO* output) {
+  ASSERT_HOST(!IsTraining() && !fc->IsTraining());
+  if (fc->type() == NT_SOFTMAX)
+    output->ResizeFloat(input, fc->NumOutputs());
+  else
+    output->Resize(input, fc->NumOutputs());
+  if (output->int_mode()) output->set_int_range(fc->int_range());
+  fc->SetupForward(input, nullptr);
+  TRand* randomizer =
+      scratch->randomizer() != nullptr ? scratch->randomizer() : randomizer_;
+  TRand batch_randomizer;
+  if (randomizer != nullptr) batch_randomizer = *randomizer;
+  int width = input.Width();
+  NetworkScratch::IO part;
+  StrideMap::Index src_index(input.stride_map());
+  bool more = true;
+  for (int start = 0; start < width; start += kMaxPartWidth) {
+    int num_steps = std::min(kMaxPartWidth, width - start);
+    part.Resize2d(input.int_mode(), num_steps, no_, scratch);
+    // Any padding between the images of a batch isn't written below.
+    part->Zero();
+    while (more && src_index.t() < start + num_steps) {
+      if (randomizer != nullptr && src_index.index(FD_HEIGHT) == 0 &&
+          src_index.index(FD_WIDTH) == 0) {
+        *randomizer = batch_randomizer;
+      }
+      StackInputs(input, src_index, randomizer, src_index.t() - start, part);
+      more = src_index.Increment();
+    }
+    fc->ForwardPart(*part, start, scratch, output);
+  }
+  output->ZeroInvalidElements();
+  if (fc->type() != NT_SOFTMAX) fc->CalibrateRange(*output);
+}
+
+// Runs inference of *this, fc and maxpool together, a band of y_scale rows
+// of each image at a time. Only the rows that the pool uses are run through
+// fc, but every position of the image is stacked, in the same order as
+// Forward, so that the random padding is the same.
+void Convolve::ForwardWithFullyConnectedMaxpool(const NetworkIO& input,
+                                                FullyConnected* fc,
+                                                const Maxpool* maxpool,
+                                                NetworkScratch* scratch,
+                                                NetworkIO* output) {
+  ASSERT_HOST(!IsTraining() && !fc->IsTraining() && fc->type() != NT_SOFTMAX);
+  int x_scale = maxpool->x_scale();
+  int y_scale = maxpool->y_scale();
+  int num_outputs = fc->NumOutputs();
+  output->ResizeScaled(input, x_scale, y_scale, num_outputs);
+  if (output->int_mode()) output->set_int_range(fc->int_range());
+  fc->SetupForward(input, nullptr);
+  TRand* randomizer =
+      scratch->randomizer() != nullptr ? scratch->randomizer() : randomizer_;
+  TRand batch_randomizer;
+  if (randomizer != nullptr) batch_randomizer = *randomizer;
+  const StrideMap& input_map = input.stride_map();
+  const StrideMap& output_map = output->stride_map();
+  NetworkScratch::IO part, band;
+  std::vector<int> max_line(num_outputs);
+  for (int b = 0; b < input_map.Size(FD_BATCH); ++b) {
+    StrideMap::Index image_index(input_map, b, 0, 0);
+    int width = image_index.MaxIndexOfDim(FD_WIDTH) + 1;
+    int height = image_index.MaxIndexOfDim(FD_HEIGHT) + 1;
+    int pooled_width = width / x_scale;
+    int pooled_height = pooled_width > 0 ? height / y_scale : 0;
+    if (randomizer != nullptr) *randomizer = batch_randomizer;
+    int num_steps = y_scale * width;
+    for (int py = 0; py < pooled_height; ++py) {
+      part.Resize2d(input.int_mode(), num_steps, no_, scratch);
+      for (int y = 0; y < y_scale; ++y) {
+        StrideMap::Index src_index(input_map, b, py * y_scale + y, 0);
+        for (int x = 0; x < width; ++x) {
+          StackInputs(input, src_index, randomizer, y * width + x, part);
+          src_index.AddOffset(1, FD_WIDTH);
+        }
+      }
+      band.Resize2d(input.int_mode(), num_steps, num_outputs, scratch);
+      if (band->int_mode()) band->set_int_range(fc->int_range());
+      fc->ForwardPart(*part, 0, scratch, band);
+      for (int px = 0; px < pooled_width; ++px) {
+        int out_t = StrideMap::Index(output_map, b, py, px).t();
+        int band_t = px * x_scale;
+        output->CopyTimeStepFrom(out_t, *band, band_t);
+        for (int x = 0; x < x_scale; ++x) {
+          for (int y = 0; y < y_scale; ++y) {
+            output->MaxpoolTimeStep(out_t, *band, band_t + y * width + x,
+                                    &max_line[0]);
           }
         }
       }
     }
-  } while (dest_index.Increment());
-  if (debug) DisplayForward(*output);
+    // The rows that the pool truncates only use up their random padding.
+    for (int y = pooled_height * y_scale; y < height; ++y) {
+      part.Resize2d(input.int_mode(), width, no_, scratch);
+      StrideMap::Index src_index(input_map, b, y, 0);
+      for (int x = 0; x < width; ++x) {
+        StackInputs(input, src_index, randomizer, x, part);
+        src_index.AddOffset(1, FD_WIDTH);
+      }
+    }
+  }
+  output->ZeroInvalidElements();
+}
+
+// Writes the inputs over the rectangle around the position of index to
+// timestep dest_t of dest, with random values outside the image.
+void Convolve::StackInputs(const NetworkIO& input,
+                           const StrideMap::Index& index, TRand* randomizer,
+                           int dest_t, NetworkIO* dest) const {
+  int y_scale = 2 * half_y_ + 1;
+  int x0 = index.index(FD_WIDTH);
+  int y0 = index.index(FD_HEIGHT);
+  int max_x = index.MaxIndexOfDim(FD_WIDTH);
+  int max_y = index.MaxIndexOfDim(FD_HEIGHT);
+  // Stack x_scale groups of y_scale * ni_ inputs together.
+  int out_ix = 0;
+  for (int x = -half_x_; x <= half_x_; ++x, out_ix += y_scale * ni_) {
+    if (x0 + x < 0 || x0 + x > max_x) {
+      // This x is outside the image.
+      dest->Randomize(dest_t, out_ix, y_scale * ni_, randomizer);
+    } else {
+      int out_iy = out_ix;
+      for (int y = -half_y_; y <= half_y_; ++y, out_iy += ni_) {
+        if (y0 + y < 0 || y0 + y > max_y) {
+          // This y is outside the image.
+          dest->Randomize(dest_t, out_iy, ni_, randomizer);
+        } else {
+          dest->CopyTimeStepGeneral(dest_t, out_iy, ni_, input,
+                                    index.OffsetT(x, y), 0);
+        }
+      }
+    }
+  }
 }
 
 // Runs backward propagation of errors on the deltas line.
@@ -93,16 +233,18 @@ bool Convolve::Backward(bool debug, const NetworkIO& fwd_deltas,
   do {
     // Stack x_scale groups of y_scale * ni_ inputs together.
     int t = src_index.t();
+    int x0 = src_index.index(FD_WIDTH);
+    int y0 = src_index.index(FD_HEIGHT);
+    int max_x = src_index.MaxIndexOfDim(FD_WIDTH);
+    int max_y = src_index.MaxIndexOfDim(FD_HEIGHT);
     int out_ix = 0;
     for (int x = -half_x_; x <= half_x_; ++x, out_ix += y_scale * ni_) {
-      StrideMap::Index x_index(src_index);
-      if (x_index.AddOffset(x, FD_WIDTH)) {
+      if (x0 + x >= 0 && x0 + x <= max_x) {
         int out_iy = out_ix;
         for (int y = -half_y_; y <= half_y_; ++y, out_iy += ni_) {
-          StrideMap::Index y_index(x_index);
-          if (y_index.AddOffset(y, FD_HEIGHT)) {
+          if (y0 + y >= 0 && y0 + y <= max_y) {
             fwd_deltas.AddTimeStepPart(t, out_iy, ni_,
-                                       delta_sum->f(y_index.t()));
+                                       delta_sum->f(src_index.OffsetT(x, y)));
           }
         }
       }
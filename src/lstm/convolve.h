@@ -26,6 +26,9 @@
 
 namespace tesseract {
 
+class FullyConnected;
+class Maxpool;
+
 // Makes each time-step deeper by stacking inputs over its rectangle. Does not
 // affect the size of its input. Achieves this by bringing in random values in
 // out-of-input areas.
@@ -53,6 +56,21 @@ class Convolve : public Network {
   void Forward(bool debug, const NetworkIO& input,
                const TransposedArray* input_transpose,
                NetworkScratch* scratch, NetworkIO* output) override;
+  // Runs inference of *this followed by fc, giving the output of
+  // fc->Forward on the output of Forward, but stacking the inputs a part of
+  // the line at a time into a small buffer that stays in the cache, instead
+  // of into a whole NetworkIO at the full resolution of the image.
+  void ForwardWithFullyConnected(const NetworkIO& input, FullyConnected* fc,
+                                 NetworkScratch* scratch, NetworkIO* output);
+  // As ForwardWithFullyConnected, followed by maxpool, giving the output of
+  // maxpool->Forward, but running a band of rows of the height of the pool
+  // at a time, so the full resolution output of fc is never stored.
+  // fc must not be a softmax.
+  void ForwardWithFullyConnectedMaxpool(const NetworkIO& input,
+                                        FullyConnected* fc,
+                                        const Maxpool* maxpool,
+                                        NetworkScratch* scratch,
+                                        NetworkIO* output);
 
   // Runs backward propagation of errors on the deltas line.
   // See Network for a detailed discussion of the arguments.
@@ -61,6 +79,11 @@ class Convolve : public Network {
                 NetworkIO* back_deltas) override;
 
  private:
+  // Writes the inputs over the rectangle around the position of index to
+  // timestep dest_t of dest, with random values outside the image.
+  void StackInputs(const NetworkIO& input, const StrideMap::Index& index,
+                   TRand* randomizer, int dest_t, NetworkIO* dest) const;
+
   void DebugWeights() override {
     tprintf("Must override Network::DebugWeights for type %d\n", type_);
   }
@@ -26,6 +26,7 @@
 #include "networkio.h"
 
 #include "network.h"
+#include "numthreads.h"  // for NumThreads
 #include "scrollview.h"
 
 namespace tesseract {
@@ -68,10 +69,25 @@ bool CTC::ComputeCTCTargets(const GenericVector<int>& labels, int null_char,
   ctc->outputs_ += simple_targets;
   NormalizeProbs(&ctc->outputs_);
   // Run regular CTC on the biased outputs.
-  // Run forward and backward
+  // Run forward and backward, which are independent, so they can run at the
+  // same time.
+  GENERIC_2D_ARRAY<double> log_label_probs;
+  ctc->ComputeLogLabelProbs(&log_label_probs);
   GENERIC_2D_ARRAY<double> log_alphas, log_betas;
-  ctc->Forward(&log_alphas);
-  ctc->Backward(&log_betas);
+#ifdef _OPENMP
+  int num_threads = NumThreads(2);
+#pragma omp parallel sections num_threads(num_threads) if (num_threads > 1)
+#endif  // _OPENMP
+  {
+#ifdef _OPENMP
+#pragma omp section
+#endif  // _OPENMP
+    ctc->Forward(log_label_probs, &log_alphas);
+#ifdef _OPENMP
+#pragma omp section
+#endif  // _OPENMP
+    ctc->Backward(log_label_probs, &log_betas);
+  }
   // Normalize and come out of log space with a clipped softmax over time.
   log_alphas += log_betas;
   ctc->NormalizeSequence(&log_alphas);
@@ -267,14 +283,34 @@ static double LogSumExp(double ln_x, double ln_y) {
   }
 }
 
+// Computes the log of the output prob of each label at each timestep, for
+// just the labels that Forward and Backward can use at that timestep. Forward
+// uses the labels between the limits at t, and Backward uses the labels at t
+// from the lower limit at t - 1, which is at most 2 less, to 2 beyond the upper
+// limit at t - 1, which is no more than the upper limit at t.
+void CTC::ComputeLogLabelProbs(
+    GENERIC_2D_ARRAY<double>* log_label_probs) const {
+  log_label_probs->Resize(num_timesteps_, num_labels_, -FLT_MAX);
+  for (int t = 0; t < num_timesteps_; ++t) {
+    const float* outputs_t = outputs_[t];
+    double* log_probs_t = (*log_label_probs)[t];
+    int min_u = std::max(min_labels_[t] - 2, 0);
+    int max_u = std::min(max_labels_[t] + 2, num_labels_ - 1);
+    for (int u = min_u; u <= max_u; ++u) {
+      log_probs_t[u] = log(static_cast<double>(outputs_t[labels_[u]]));
+    }
+  }
+}
+
 // Runs the forward CTC pass, filling in log_probs.
-void CTC::Forward(GENERIC_2D_ARRAY<double>* log_probs) const {
+void CTC::Forward(const GENERIC_2D_ARRAY<double>& log_label_probs,
+                  GENERIC_2D_ARRAY<double>* log_probs) const {
   log_probs->Resize(num_timesteps_, num_labels_, -FLT_MAX);
-  log_probs->put(0, 0, log(outputs_(0, labels_[0])));
+  log_probs->put(0, 0, log_label_probs(0, 0));
   if (labels_[0] == null_char_)
-    log_probs->put(0, 1, log(outputs_(0, labels_[1])));
+    log_probs->put(0, 1, log_label_probs(0, 1));
   for (int t = 1; t < num_timesteps_; ++t) {
-    const float* outputs_t = outputs_[t];
+    const double* log_label_probs_t = log_label_probs[t];
     for (int u = min_labels_[t]; u <= max_labels_[t]; ++u) {
       // Continuing the same label.
       double log_sum = log_probs->get(t - 1, u);
@@ -288,36 +324,34 @@ void CTC::Forward(GENERIC_2D_ARRAY<double>* log_probs) const {
         log_sum = LogSumExp(log_sum, log_probs->get(t - 1, u - 2));
       }
       // Add in the log prob of the current label.
-      double label_prob = outputs_t[labels_[u]];
-      log_sum += log(label_prob);
+      log_sum += log_label_probs_t[u];
       log_probs->put(t, u, log_sum);
     }
   }
 }
 
 // Runs the backward CTC pass, filling in log_probs.
-void CTC::Backward(GENERIC_2D_ARRAY<double>* log_probs) const {
+void CTC::Backward(const GENERIC_2D_ARRAY<double>& log_label_probs,
+                   GENERIC_2D_ARRAY<double>* log_probs) const {
   log_probs->Resize(num_timesteps_, num_labels_, -FLT_MAX);
   log_probs->put(num_timesteps_ - 1, num_labels_ - 1, 0.0);
   if (labels_[num_labels_ - 1] == null_char_)
     log_probs->put(num_timesteps_ - 1, num_labels_ - 2, 0.0);
   for (int t = num_timesteps_ - 2; t >= 0; --t) {
-    const float* outputs_tp1 = outputs_[t + 1];
+    const double* log_label_probs_tp1 = log_label_probs[t + 1];
     for (int u = min_labels_[t]; u <= max_labels_[t]; ++u) {
       // Continuing the same label.
-      double log_sum = log_probs->get(t + 1, u) + log(outputs_tp1[labels_[u]]);
+      double log_sum = log_probs->get(t + 1, u) + log_label_probs_tp1[u];
       // Change from previous label.
       if (u + 1 < num_labels_) {
-        double prev_prob = outputs_tp1[labels_[u + 1]];
-        log_sum =
-            LogSumExp(log_sum, log_probs->get(t + 1, u + 1) + log(prev_prob));
+        log_sum = LogSumExp(log_sum, log_probs->get(t + 1, u + 1) +
+                                         log_label_probs_tp1[u + 1]);
       }
       // Skip the null if allowed.
       if (u + 2 < num_labels_ && labels_[u + 1] == null_char_ &&
           labels_[u] != labels_[u + 2]) {
-        double skip_prob = outputs_tp1[labels_[u + 2]];
-        log_sum =
-            LogSumExp(log_sum, log_probs->get(t + 1, u + 2) + log(skip_prob));
+        log_sum = LogSumExp(log_sum, log_probs->get(t + 1, u + 2) +
+                                         log_label_probs_tp1[u + 2]);
       }
       log_probs->put(t, u, log_sum);
     }
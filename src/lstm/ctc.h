@@ -73,10 +73,17 @@ class CTC {
   // Calculates and returns a suitable fraction of the simple targets to add
   // to the network outputs.
   float CalculateBiasFraction();
-  // Runs the forward CTC pass, filling in log_probs.
-  void Forward(GENERIC_2D_ARRAY<double>* log_probs) const;
-  // Runs the backward CTC pass, filling in log_probs.
-  void Backward(GENERIC_2D_ARRAY<double>* log_probs) const;
+  // Computes the log of the output prob of each label at each timestep, for
+  // just the labels that Forward and Backward can use at that timestep.
+  void ComputeLogLabelProbs(GENERIC_2D_ARRAY<double>* log_label_probs) const;
+  // Runs the forward CTC pass, filling in log_probs, using the output of
+  // ComputeLogLabelProbs.
+  void Forward(const GENERIC_2D_ARRAY<double>& log_label_probs,
+               GENERIC_2D_ARRAY<double>* log_probs) const;
+  // Runs the backward CTC pass, filling in log_probs, using the output of
+  // ComputeLogLabelProbs.
+  void Backward(const GENERIC_2D_ARRAY<double>& log_label_probs,
+                GENERIC_2D_ARRAY<double>* log_probs) const;
   // Normalizes and brings probs out of log space with a softmax over time.
   void NormalizeSequence(GENERIC_2D_ARRAY<double>* probs) const;
   // For each timestep computes the max prob for each class over all
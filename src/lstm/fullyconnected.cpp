@@ -21,24 +21,43 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 
 #include "functions.h"
 #include "networkscratch.h"
+#include "numthreads.h"
 
-// Number of threads to use for parallel calculation of Forward and Backward.
+// Default number of threads to use for parallel calculation of Forward and
+// Backward. See NumThreads for the actual number.
 #ifdef _OPENMP
 const int kNumThreads = 4;
 #else
 const int kNumThreads = 1;
 #endif
 
+// Number of timesteps that are computed together in int mode, with a single
+// pass over the weights.
+const int kIntTileSize = 16;
+
+// Min number of outputs for SetupApproxSoftmax to do anything, as smaller
+// softmaxes are too cheap to gain from it.
+const int kMinApproxOutputs = 256;
+// Number of iterations of k-means used to cluster the outputs.
+const int kApproxClusterIterations = 4;
+// Number of groups with the highest mean that get exact outputs.
+const int kNumExactGroups = 4;
+// Min probability of the best approximate output to use the approximation.
+const double kMinApproxConfidence = 0.95;
+
 namespace tesseract {
 
 FullyConnected::FullyConnected(const STRING& name, int ni, int no,
                                NetworkType type)
-  : Network(type, name, ni, no), external_source_(nullptr), int_mode_(false) {
+  : Network(type, name, ni, no), external_source_(nullptr), int_mode_(false),
+    max_approx_group_(0) {
 }
 
 // Returns the shape output from the network given an input shape (which may
@@ -93,8 +112,105 @@ int FullyConnected::RemapOutputs(int old_no, const std::vector<int>& code_map) {
 }
 
 // Converts a float network to an int network.
-void FullyConnected::ConvertToInt() {
+float FullyConnected::ConvertToInt(float input_range) {
+  if (input_range != 1.0f) weights_.ScaleInputs(input_range, ni_);
   weights_.ConvertToInt();
+  if (!approx_groups_.empty()) SetupApproxSoftmax();
+  return int_range_;
+}
+
+// Converts a double network to a single precision float network.
+void FullyConnected::ConvertToFloat32() {
+  weights_.ConvertToFloat32();
+  if (!approx_groups_.empty()) SetupApproxSoftmax();
+}
+
+// Prunes the smallest blocks of weights.
+int FullyConnected::PruneWeights(double fraction) {
+  return weights_.PruneBlocks(fraction);
+}
+
+// Sets up a softmax to compute approximate outputs for inference.
+void FullyConnected::SetupApproxSoftmax() {
+  approx_groups_.clear();
+  approx_outputs_.clear();
+  max_approx_group_ = 0;
+  if ((type_ != NT_SOFTMAX && type_ != NT_SOFTMAX_NO_CTC) ||
+      no_ < kMinApproxOutputs) {
+    return;
+  }
+  GENERIC_2D_ARRAY<double> weights;
+  weights_.GetDoubleWeights(&weights);
+  int dim2 = weights.dim2();
+  // Cluster the weight rows by k-means, starting from evenly spaced rows,
+  // with about sqrt(no_) groups of about sqrt(no_) outputs.
+  int num_groups = static_cast<int>(std::sqrt(static_cast<double>(no_)));
+  GENERIC_2D_ARRAY<double> means(num_groups, dim2, 0.0);
+  for (int g = 0; g < num_groups; ++g) {
+    memcpy(means[g], weights[g * no_ / num_groups], dim2 * sizeof(double));
+  }
+  std::vector<int> group_of(no_, 0);
+  for (int iteration = 0; iteration < kApproxClusterIterations; ++iteration) {
+    for (int i = 0; i < no_; ++i) {
+      double best_dist = 0.0;
+      for (int g = 0; g < num_groups; ++g) {
+        double dist = 0.0;
+        for (int j = 0; j < dim2; ++j) {
+          double diff = weights(i, j) - means(g, j);
+          dist += diff * diff;
+        }
+        if (g == 0 || dist < best_dist) {
+          best_dist = dist;
+          group_of[i] = g;
+        }
+      }
+    }
+    // Empty groups keep their old mean.
+    std::vector<int> counts(num_groups, 0);
+    for (int i = 0; i < no_; ++i) ++counts[group_of[i]];
+    for (int g = 0; g < num_groups; ++g) {
+      if (counts[g] > 0) {
+        for (int j = 0; j < dim2; ++j) means(g, j) = 0.0;
+      }
+    }
+    for (int i = 0; i < no_; ++i) {
+      int g = group_of[i];
+      for (int j = 0; j < dim2; ++j) means(g, j) += weights(i, j) / counts[g];
+    }
+  }
+  std::vector<std::vector<int>> outputs(num_groups);
+  for (int i = 0; i < no_; ++i) outputs[group_of[i]].push_back(i);
+  // Drop the empty groups, and their means.
+  int num_used = 0;
+  for (int g = 0; g < num_groups; ++g) {
+    if (!outputs[g].empty()) ++num_used;
+  }
+  GENERIC_2D_ARRAY<double> used_means(num_used, dim2, 0.0);
+  for (int g = 0; g < num_groups; ++g) {
+    if (outputs[g].empty()) continue;
+    memcpy(used_means[approx_outputs_.size()], means[g], dim2 * sizeof(double));
+    approx_outputs_.push_back(std::move(outputs[g]));
+  }
+  approx_means_.InitConverted(used_means, weights_);
+  approx_groups_.resize(approx_outputs_.size());
+  for (int g = 0; g < approx_outputs_.size(); ++g) {
+    approx_groups_[g].InitRows(weights_, approx_outputs_[g]);
+    int size = approx_outputs_[g].size();
+    max_approx_group_ = std::max(max_approx_group_, size);
+  }
+}
+
+// Appends the shapes of the weight matrices used by Forward.
+void FullyConnected::MatrixShapes(
+    std::vector<std::pair<int, int>>* shapes) const {
+  shapes->emplace_back(weights_.NumOutputs(), weights_.NumInputs());
+}
+
+// Adds the bytes of the weight matrices to usage.
+void FullyConnected::AddMemoryUsage(MemoryUsage* usage) const {
+  weights_.AddMemoryUsage(usage);
+  approx_means_.AddMemoryUsage(usage);
+  for (const auto& group : approx_groups_) group.AddMemoryUsage(usage);
 }
 
 // Provides debug output on the weights.
@@ -124,17 +240,60 @@ void FullyConnected::Forward(bool debug, const NetworkIO& input,
     output->ResizeFloat(input, no_);
   else
     output->Resize(input, no_);
+  if (output->int_mode()) output->set_int_range(int_range_);
   SetupForward(input, input_transpose);
+  if (!approx_groups_.empty() && !IsTraining()) {
+    ForwardApprox(input, 0, scratch, output);
+  } else if (input.int_mode()) {
+    ForwardIntTiles(input, 0, scratch, output);
+  } else {
+    ForwardFloat(input, 0, scratch, output);
+  }
+  // Zero all the elements that are in the padding around images that allows
+  // multiple different-sized images to exist in a single array.
+  // acts_ is only used if this is not a softmax op.
+  if (IsTraining() && type_ != NT_SOFTMAX) {
+    acts_.ZeroInvalidElements();
+  }
+  output->ZeroInvalidElements();
+  if (type_ != NT_SOFTMAX) CalibrateRange(*output);
+#if DEBUG_DETAIL > 0
+  tprintf("F Output:%s\n", name_.string());
+  output->Print(10);
+#endif
+  if (debug) DisplayForward(*output);
+}
+
+// Runs inference on all the timesteps of input, writing the results to
+// output from timestep out_start onwards, so that the input can be supplied
+// a part at a time. SetupForward must be called first.
+void FullyConnected::ForwardPart(const NetworkIO& input, int out_start,
+                                 NetworkScratch* scratch, NetworkIO* output) {
+  ASSERT_HOST(!IsTraining());
+  if (!approx_groups_.empty()) {
+    ForwardApprox(input, out_start, scratch, output);
+  } else if (input.int_mode()) {
+    ForwardIntTiles(input, out_start, scratch, output);
+  } else {
+    ForwardFloat(input, out_start, scratch, output);
+  }
+}
+
+// Part of Forward that runs a float input one timestep at a time.
+void FullyConnected::ForwardFloat(const NetworkIO& input, int out_start,
+                                  NetworkScratch* scratch, NetworkIO* output) {
+  int width = input.Width();
+  int num_threads = NumThreads(kNumThreads, scratch->num_threads());
   GenericVector<NetworkScratch::FloatVec> temp_lines;
-  temp_lines.init_to_size(kNumThreads, NetworkScratch::FloatVec());
+  temp_lines.init_to_size(num_threads, NetworkScratch::FloatVec());
   GenericVector<NetworkScratch::FloatVec> curr_input;
-  curr_input.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-  for (int i = 0; i < kNumThreads; ++i) {
+  curr_input.init_to_size(num_threads, NetworkScratch::FloatVec());
+  for (int i = 0; i < num_threads; ++i) {
     temp_lines[i].Init(no_, scratch);
     curr_input[i].Init(ni_, scratch);
   }
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(kNumThreads)
+#pragma omp parallel for num_threads(num_threads)
   for (int t = 0; t < width; ++t) {
     // Thread-local pointer to temporary storage.
     int thread_id = omp_get_thread_num();
@@ -144,37 +303,157 @@ void FullyConnected::Forward(bool debug, const NetworkIO& input,
     int thread_id = 0;
 #endif
     double* temp_line = temp_lines[thread_id];
-    if (input.int_mode()) {
-      ForwardTimeStep(input.i(t), t, temp_line);
+    int out_t = out_start + t;
+    if (weights_.is_float32_mode()) {
+      // The float input can be used directly, without conversion to double.
+      ForwardTimeStep(input.f(t), out_t, temp_line);
     } else {
       input.ReadTimeStep(t, curr_input[thread_id]);
-      ForwardTimeStep(curr_input[thread_id], t, temp_line);
+      ForwardTimeStep(curr_input[thread_id], out_t, temp_line);
     }
-    output->WriteTimeStep(t, temp_line);
+    output->WriteTimeStep(out_t, temp_line);
     if (IsTraining() && type_ != NT_SOFTMAX) {
-      acts_.CopyTimeStepFrom(t, *output, t);
+      acts_.CopyTimeStepFrom(out_t, *output, out_t);
     }
   }
-  // Zero all the elements that are in the padding around images that allows
-  // multiple different-sized images to exist in a single array.
-  // acts_ is only used if this is not a softmax op.
-  if (IsTraining() && type_ != NT_SOFTMAX) {
-    acts_.ZeroInvalidElements();
+}
+
+// Part of Forward that runs an int input in tiles of kIntTileSize timesteps.
+// All the timesteps are known up front, so each tile is multiplied by the
+// weights in a single pass, which makes the layer compute-bound instead of
+// memory bandwidth-bound on long lines.
+void FullyConnected::ForwardIntTiles(const NetworkIO& input, int out_start,
+                                     NetworkScratch* scratch,
+                                     NetworkIO* output) {
+  int width = input.Width();
+  int num_tiles = (width + kIntTileSize - 1) / kIntTileSize;
+  int num_threads = NumThreads(kNumThreads, scratch->num_threads());
+  GenericVector<NetworkScratch::FloatVec> temp_tiles;
+  temp_tiles.init_to_size(num_threads, NetworkScratch::FloatVec());
+  for (int i = 0; i < num_threads; ++i) {
+    temp_tiles[i].Init(no_ * kIntTileSize, scratch);
   }
-  output->ZeroInvalidElements();
-#if DEBUG_DETAIL > 0
-  tprintf("F Output:%s\n", name_.string());
-  output->Print(10);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads)
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    // Thread-local pointer to temporary storage.
+    int thread_id = omp_get_thread_num();
+#else
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    // Thread-local pointer to temporary storage.
+    int thread_id = 0;
 #endif
-  if (debug) DisplayForward(*output);
+    double* temp_tile = temp_tiles[thread_id];
+    int start = tile * kIntTileSize;
+    int num_steps = std::min(kIntTileSize, width - start);
+    weights_.MatrixDotMatrix(input.i(start), input.NumFeatures(), num_steps,
+                             temp_tile, no_);
+    for (int s = 0; s < num_steps; ++s) {
+      int t = out_start + start + s;
+      double* temp_line = temp_tile + s * no_;
+      ForwardTimeStep(t, temp_line);
+      output->WriteTimeStep(t, temp_line);
+      if (IsTraining() && type_ != NT_SOFTMAX) {
+        acts_.CopyTimeStepFrom(t, *output, t);
+      }
+    }
+  }
+}
+
+// As ForwardFloat, but for any input, using the approximate softmax.
+void FullyConnected::ForwardApprox(const NetworkIO& input, int out_start,
+                                   NetworkScratch* scratch,
+                                   NetworkIO* output) {
+  int width = input.Width();
+  int num_threads = NumThreads(kNumThreads, scratch->num_threads());
+  int temp_size = approx_means_.NumOutputs() + max_approx_group_;
+  GenericVector<NetworkScratch::FloatVec> temp_lines;
+  temp_lines.init_to_size(num_threads, NetworkScratch::FloatVec());
+  GenericVector<NetworkScratch::FloatVec> output_lines;
+  output_lines.init_to_size(num_threads, NetworkScratch::FloatVec());
+  GenericVector<NetworkScratch::FloatVec> curr_input;
+  curr_input.init_to_size(num_threads, NetworkScratch::FloatVec());
+  for (int i = 0; i < num_threads; ++i) {
+    temp_lines[i].Init(temp_size, scratch);
+    output_lines[i].Init(no_, scratch);
+    curr_input[i].Init(ni_, scratch);
+  }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads)
+  for (int t = 0; t < width; ++t) {
+    // Thread-local pointer to temporary storage.
+    int thread_id = omp_get_thread_num();
+#else
+  for (int t = 0; t < width; ++t) {
+    // Thread-local pointer to temporary storage.
+    int thread_id = 0;
+#endif
+    double* temp_line = temp_lines[thread_id];
+    double* output_line = output_lines[thread_id];
+    int out_t = out_start + t;
+    if (input.int_mode()) {
+      const int8_t* i_input = input.i(t);
+      if (!ApproxTimeStep(i_input, temp_line, output_line)) {
+        ForwardTimeStep(i_input, out_t, output_line);
+      }
+    } else if (weights_.is_float32_mode()) {
+      const float* f_input = input.f(t);
+      if (!ApproxTimeStep(f_input, temp_line, output_line)) {
+        ForwardTimeStep(f_input, out_t, output_line);
+      }
+    } else {
+      input.ReadTimeStep(t, curr_input[thread_id]);
+      const double* d_input = curr_input[thread_id];
+      if (!ApproxTimeStep(d_input, temp_line, output_line)) {
+        ForwardTimeStep(d_input, out_t, output_line);
+      }
+    }
+    output->WriteTimeStep(out_t, output_line);
+  }
+}
+
+// Computes the approximate softmax of one timestep into output_line.
+template <typename T>
+bool FullyConnected::ApproxTimeStep(const T* input, double* temp_line,
+                                    double* output_line) const {
+  int num_groups = approx_means_.NumOutputs();
+  double* group_means = temp_line;
+  double* group_outputs = temp_line + num_groups;
+  approx_means_.MatrixDotVector(input, group_means);
+  // As the outputs are linear in the weights, each mean is the exact mean of
+  // the outputs in its group, which they all get to start with.
+  for (int g = 0; g < num_groups; ++g) {
+    for (int i : approx_outputs_[g]) output_line[i] = group_means[g];
+  }
+  // The groups with the highest means get their exact outputs.
+  int exact_groups[kNumExactGroups];
+  int num_exact = std::min(kNumExactGroups, num_groups);
+  for (int e = 0; e < num_exact; ++e) {
+    int best_g = -1;
+    for (int g = 0; g < num_groups; ++g) {
+      if (std::find(exact_groups, exact_groups + e, g) != exact_groups + e) {
+        continue;
+      }
+      if (best_g < 0 || group_means[g] > group_means[best_g]) best_g = g;
+    }
+    exact_groups[e] = best_g;
+    approx_groups_[best_g].MatrixDotVector(input, group_outputs);
+    const std::vector<int>& outputs = approx_outputs_[best_g];
+    for (int i = 0; i < outputs.size(); ++i) {
+      output_line[outputs[i]] = group_outputs[i];
+    }
+  }
+  SoftmaxInPlace(no_, output_line);
+  return *std::max_element(output_line, output_line + no_) >=
+         kMinApproxConfidence;
 }
 
 // Components of Forward so FullyConnected can be reused inside LSTM.
 void FullyConnected::SetupForward(const NetworkIO& input,
                                   const TransposedArray* input_transpose) {
-  // Softmax output is always float, so save the input type.
-  int_mode_ = input.int_mode();
   if (IsTraining()) {
+    // Softmax output is always float, so save the input type.
+    int_mode_ = input.int_mode();
     acts_.Resize(input, no_);
     // Source_ is a transposed copy of input. It isn't needed if provided.
     external_source_ = input_transpose;
@@ -216,6 +495,13 @@ void FullyConnected::ForwardTimeStep(const int8_t* i_input,
   ForwardTimeStep(t, output_line);
 }
 
+void FullyConnected::ForwardTimeStep(const float* f_input,
+                                     int t, double* output_line) {
+  // Only used in float32 mode, which doesn't support training.
+  weights_.MatrixDotVector(f_input, output_line);
+  ForwardTimeStep(t, output_line);
+}
+
 // Runs backward propagation of errors on the deltas line.
 // See NetworkCpp for a detailed discussion of the arguments.
 bool FullyConnected::Backward(bool debug, const NetworkIO& fwd_deltas,
@@ -223,19 +509,20 @@ bool FullyConnected::Backward(bool debug, const NetworkIO& fwd_deltas,
                               NetworkIO* back_deltas) {
   if (debug) DisplayBackward(fwd_deltas);
   back_deltas->Resize(fwd_deltas, ni_);
+  int num_threads = NumThreads(kNumThreads, scratch->num_threads());
   GenericVector<NetworkScratch::FloatVec> errors;
-  errors.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-  for (int i = 0; i < kNumThreads; ++i) errors[i].Init(no_, scratch);
+  errors.init_to_size(num_threads, NetworkScratch::FloatVec());
+  for (int i = 0; i < num_threads; ++i) errors[i].Init(no_, scratch);
   GenericVector<NetworkScratch::FloatVec> temp_backprops;
   if (needs_to_backprop_) {
-    temp_backprops.init_to_size(kNumThreads, NetworkScratch::FloatVec());
-    for (int i = 0; i < kNumThreads; ++i) temp_backprops[i].Init(ni_, scratch);
+    temp_backprops.init_to_size(num_threads, NetworkScratch::FloatVec());
+    for (int i = 0; i < num_threads; ++i) temp_backprops[i].Init(ni_, scratch);
   }
   int width = fwd_deltas.Width();
   NetworkScratch::GradientStore errors_t;
   errors_t.Init(no_, width, scratch);
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(kNumThreads)
+#pragma omp parallel for num_threads(num_threads)
   for (int t = 0; t < width; ++t) {
     int thread_id = omp_get_thread_num();
 #else
@@ -310,4 +597,20 @@ void FullyConnected::CountAlternators(const Network& other, double* same,
   weights_.CountAlternators(fc->weights_, same, changed);
 }
 
+// Sets the weight deltas of *this to the means of those of others.
+void FullyConnected::AverageDeltas(const std::vector<const Network*>& others) {
+  std::vector<const WeightMatrix*> weights;
+  for (const Network* other : others) {
+    ASSERT_HOST(other->type() == type_);
+    weights.push_back(&static_cast<const FullyConnected*>(other)->weights_);
+  }
+  weights_.AverageDeltas(weights);
+}
+
+// Copies the weights of other, which has the same structure, to *this.
+void FullyConnected::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  weights_.CopyWeights(static_cast<const FullyConnected*>(&other)->weights_);
+}
+
 }  // namespace tesseract.
@@ -19,6 +19,7 @@
 #ifndef TESSERACT_LSTM_FULLYCONNECTED_H_
 #define TESSERACT_LSTM_FULLYCONNECTED_H_
 
+#include <vector>  // for std::vector
 #include "network.h"
 #include "networkscratch.h"
 
@@ -73,7 +74,24 @@ class FullyConnected : public Network {
   int RemapOutputs(int old_no, const std::vector<int>& code_map) override;
 
   // Converts a float network to an int network.
-  void ConvertToInt() override;
+  float ConvertToInt(float input_range) override;
+
+  // Converts a double network to a single precision float network.
+  void ConvertToFloat32() override;
+  // Prunes the smallest blocks of weights. See Network::PruneWeights.
+  int PruneWeights(double fraction) override;
+
+  // Sets up a softmax to compute approximate outputs for inference. The
+  // outputs are clustered by their weights into groups, and the exact
+  // outputs are computed only for the groups with the highest mean, while
+  // the rest get their group mean. A timestep where the best output isn't
+  // confident enough is computed in full. Has no effect on other types.
+  void SetupApproxSoftmax();
+
+  // Appends the shapes of the weight matrices used by Forward.
+  void MatrixShapes(std::vector<std::pair<int, int>>* shapes) const override;
+  // Adds the bytes of the weight matrices to usage.
+  void AddMemoryUsage(MemoryUsage* usage) const override;
 
   // Provides debug output on the weights.
   void DebugWeights() override;
@@ -88,12 +106,24 @@ class FullyConnected : public Network {
   void Forward(bool debug, const NetworkIO& input,
                const TransposedArray* input_transpose, NetworkScratch* scratch,
                NetworkIO* output) override;
+  // Returns true if type is one of the variants of FullyConnected.
+  static bool IsFullyConnectedType(NetworkType type) {
+    return type == NT_SOFTMAX || type == NT_SOFTMAX_NO_CTC ||
+           type == NT_RELU || type == NT_TANH || type == NT_LINEAR ||
+           type == NT_LOGISTIC || type == NT_POSCLIP || type == NT_SYMCLIP;
+  }
   // Components of Forward so FullyConnected can be reused inside LSTM.
   void SetupForward(const NetworkIO& input,
                     const TransposedArray* input_transpose);
   void ForwardTimeStep(int t, double* output_line);
   void ForwardTimeStep(const double* d_input, int t, double* output_line);
   void ForwardTimeStep(const int8_t* i_input, int t, double* output_line);
+  void ForwardTimeStep(const float* f_input, int t, double* output_line);
+  // Runs inference on all the timesteps of input, writing the results to
+  // output from timestep out_start onwards, so that the input can be supplied
+  // a part at a time. SetupForward must be called first.
+  void ForwardPart(const NetworkIO& input, int out_start,
+                   NetworkScratch* scratch, NetworkIO* output);
 
   // Runs backward propagation of errors on the deltas line.
   // See Network for a detailed discussion of the arguments.
@@ -113,8 +143,29 @@ class FullyConnected : public Network {
   // *changed.
   void CountAlternators(const Network& other, double* same,
                         double* changed) const override;
+  // Sets the weight deltas of *this to the means of those of others.
+  void AverageDeltas(const std::vector<const Network*>& others) override;
+  // Copies the weights of other, which has the same structure, to *this.
+  void CopyWeights(const Network& other) override;
 
  protected:
+  // Components of Forward for float and int inputs respectively. Input
+  // timestep t goes to output timestep out_start + t.
+  void ForwardFloat(const NetworkIO& input, int out_start,
+                    NetworkScratch* scratch, NetworkIO* output);
+  void ForwardIntTiles(const NetworkIO& input, int out_start,
+                       NetworkScratch* scratch, NetworkIO* output);
+  // As ForwardFloat, but for any input, using the approximate softmax set
+  // up by SetupApproxSoftmax.
+  void ForwardApprox(const NetworkIO& input, int out_start,
+                     NetworkScratch* scratch, NetworkIO* output);
+  // Computes the approximate softmax of one timestep into output_line, using
+  // temp_line of size approx_means_.NumOutputs() + max group size. Returns
+  // false if the result isn't confident enough to use.
+  template <typename T>
+  bool ApproxTimeStep(const T* input, double* temp_line,
+                      double* output_line) const;
+
   // Weight arrays of size [no, ni + 1].
   WeightMatrix weights_;
   // Transposed copy of input used during training of size [ni, width].
@@ -127,6 +178,15 @@ class FullyConnected : public Network {
   // Memory of the integer mode input to forward as softmax always outputs
   // float, so the information is otherwise lost.
   bool int_mode_;
+  // The approximate softmax, not serialized. See SetupApproxSoftmax.
+  // Weights of the mean of each group of outputs.
+  WeightMatrix approx_means_;
+  // Weights of the outputs of each group.
+  std::vector<WeightMatrix> approx_groups_;
+  // Output indices of each group.
+  std::vector<std::vector<int>> approx_outputs_;
+  // Size of the largest group.
+  int max_approx_group_;
 };
 
 }  // namespace tesseract.
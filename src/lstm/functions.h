@@ -19,6 +19,7 @@
 #define TESSERACT_LSTM_FUNCTIONS_H_
 
 #include "helpers.h"
+#include "simddetect.h"  // for TanhVector, LogisticVector, TanhMultiply
 
 // Setting this to 1 or more causes massive dumps of debug data: weights,
 // updates, internal calculations etc, and reduces the number of test iterations
@@ -172,6 +173,33 @@ inline void FuncMultiply(const double* u, const double* v, int n, double* out) {
     out[i] = f(u[i]) * v[i];
   }
 }
+// Specializations for the sigmoid functions of the forward pass use the
+// vectorized versions selected by SIMDDetect if there are any.
+template <>
+inline void FuncInplace<GFunc>(int n, double* inout) {
+  if (TanhVector != nullptr) {
+    TanhVector(n, inout);
+    return;
+  }
+  for (int i = 0; i < n; ++i) inout[i] = Tanh(inout[i]);
+}
+template <>
+inline void FuncInplace<FFunc>(int n, double* inout) {
+  if (LogisticVector != nullptr) {
+    LogisticVector(n, inout);
+    return;
+  }
+  for (int i = 0; i < n; ++i) inout[i] = Logistic(inout[i]);
+}
+template <>
+inline void FuncMultiply<HFunc>(const double* u, const double* v, int n,
+                                double* out) {
+  if (TanhMultiply != nullptr) {
+    TanhMultiply(u, v, n, out);
+    return;
+  }
+  for (int i = 0; i < n; ++i) out[i] = Tanh(u[i]) * v[i];
+}
 // Applies the Softmax function in-place to inout, of size n.
 template <typename T>
 inline void SoftmaxInPlace(int n, T* inout) {
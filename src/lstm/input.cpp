@@ -17,6 +17,8 @@
 
 #include "input.h"
 
+#include <algorithm>  // for std::max, std::min
+
 #include "allheaders.h"
 #include "imagedata.h"
 #include "pageres.h"
@@ -26,6 +28,9 @@ namespace tesseract {
 
 // Max height for variable height inputs before scaling anyway.
 const int kMaxInputHeight = 48;
+// Max range of grey levels in a blank group of columns, as a fraction of the
+// range of the whole image.
+const double kMaxBlankContrast = 0.25;
 
 Input::Input(const STRING& name, int ni, int no)
     : Network(NT_INPUT, name, ni, no), cached_x_scale_(1) {}
@@ -110,37 +115,141 @@ Pix* Input::PrepareLSTMInputs(const ImageData& image_data,
 /* static */
 void Input::PreparePixInput(const StaticShape& shape, const Pix* pix,
                             TRand* randomizer, NetworkIO* input) {
+  std::vector<const Pix*> pixes(1, pix);
+  PreparePixesInput(shape, pixes, randomizer, input);
+}
+
+// Converts the given pixes to a batch NetworkIO of height and depth
+// appropriate to the given StaticShape, as PreparePixInput does for one.
+/* static */
+void Input::PreparePixesInput(const StaticShape& shape,
+                              const std::vector<const Pix*>& pixes,
+                              TRand* randomizer, NetworkIO* input) {
   bool color = shape.depth() == 3;
-  Pix* var_pix = const_cast<Pix*>(pix);
-  int depth = pixGetDepth(var_pix);
-  Pix* normed_pix = nullptr;
-  // On input to BaseAPI, an image is forced to be 1, 8 or 24 bit, without
-  // colormap, so we just have to deal with depth conversion here.
-  if (color) {
-    // Force RGB.
-    if (depth == 32)
-      normed_pix = pixClone(var_pix);
-    else
-      normed_pix = pixConvertTo32(var_pix);
-  } else {
-    // Convert non-8-bit images to 8 bit.
-    if (depth == 8)
-      normed_pix = pixClone(var_pix);
-    else
-      normed_pix = pixConvertTo8(var_pix, false);
-  }
-  int height = pixGetHeight(normed_pix);
   int target_height = shape.height();
   if (target_height == 1) target_height = shape.depth();
-  if (target_height != 0 && target_height != height) {
-    // Get the scaled image.
-    float im_factor = static_cast<float>(target_height) / height;
-    Pix* scaled_pix = pixScale(normed_pix, im_factor, im_factor);
-    pixDestroy(&normed_pix);
-    normed_pix = scaled_pix;
+  std::vector<Pix*> normed_pixes;
+  for (auto pix : pixes) {
+    Pix* var_pix = const_cast<Pix*>(pix);
+    int depth = pixGetDepth(var_pix);
+    Pix* normed_pix = nullptr;
+    // On input to BaseAPI, an image is forced to be 1, 8 or 24 bit, without
+    // colormap, so we just have to deal with depth conversion here.
+    if (color) {
+      // Force RGB.
+      if (depth == 32)
+        normed_pix = pixClone(var_pix);
+      else
+        normed_pix = pixConvertTo32(var_pix);
+    } else {
+      // Convert non-8-bit images to 8 bit.
+      if (depth == 8)
+        normed_pix = pixClone(var_pix);
+      else
+        normed_pix = pixConvertTo8(var_pix, false);
+    }
+    int height = pixGetHeight(normed_pix);
+    if (target_height != 0 && target_height != height) {
+      // Get the scaled image.
+      float im_factor = static_cast<float>(target_height) / height;
+      Pix* scaled_pix = pixScale(normed_pix, im_factor, im_factor);
+      pixDestroy(&normed_pix);
+      normed_pix = scaled_pix;
+    }
+    normed_pixes.push_back(normed_pix);
+  }
+  input->FromPixes(shape,
+                   std::vector<const Pix*>(normed_pixes.begin(),
+                                           normed_pixes.end()),
+                   randomizer);
+  for (auto& normed_pix : normed_pixes) pixDestroy(&normed_pix);
+}
+
+// Returns a copy of pix with each run of blank columns wider than
+// max_gap_width cut down to max_gap_width, or nullptr if there are none.
+// The columns are taken in groups of x_scale, the width of a network output
+// timestep, the last of which may be narrower, and timestep_map is set to
+// the timestep of the copy for each timestep of pix, or for a removed one,
+// the last one kept before the cut.
+// A group is blank if its range of grey levels is small compared with that
+// of the whole image, so it works with either polarity of text.
+Pix* Input::CompressBlankColumns(const Pix* pix, int x_scale,
+                                 int max_gap_width,
+                                 std::vector<int>* timestep_map) {
+  auto* var_pix = const_cast<Pix*>(pix);
+  int width = pixGetWidth(var_pix);
+  int height = pixGetHeight(var_pix);
+  int num_steps = (width + x_scale - 1) / x_scale;
+  int max_gap_steps = std::max(max_gap_width / x_scale, 1);
+  if (num_steps <= max_gap_steps) return nullptr;
+  // Find the range of grey levels in each timestep.
+  Pix* grey = pixGetDepth(var_pix) == 8 ? pixClone(var_pix)
+                                        : pixConvertTo8(var_pix, false);
+  if (grey == nullptr) return nullptr;
+  std::vector<int> mins(num_steps, UINT8_MAX), maxes(num_steps, 0);
+  l_uint32* data = pixGetData(grey);
+  int wpl = pixGetWpl(grey);
+  for (int y = 0; y < height; ++y, data += wpl) {
+    for (int x = 0; x < width; ++x) {
+      int pixel = GET_DATA_BYTE(data, x);
+      int step = x / x_scale;
+      mins[step] = std::min(mins[step], pixel);
+      maxes[step] = std::max(maxes[step], pixel);
+    }
+  }
+  pixDestroy(&grey);
+  int image_range = *std::max_element(maxes.begin(), maxes.end()) -
+                    *std::min_element(mins.begin(), mins.end());
+  if (image_range <= 0) return nullptr;
+  std::vector<bool> blank(num_steps);
+  for (int s = 0; s < num_steps; ++s) {
+    blank[s] = maxes[s] - mins[s] < image_range * kMaxBlankContrast;
+  }
+  // Keep the middle of each long blank run out of the copy, leaving half of
+  // max_gap_steps on each side.
+  std::vector<int> kept_steps;
+  timestep_map->clear();
+  for (int start = 0; start < num_steps;) {
+    int end = start + 1;
+    if (blank[start]) {
+      while (end < num_steps && blank[end]) ++end;
+    }
+    int cut_start = end, cut_end = end;
+    if (blank[start] && end - start > max_gap_steps) {
+      cut_start = start + (max_gap_steps + 1) / 2;
+      cut_end = end - max_gap_steps / 2;
+    }
+    for (int s = start; s < end; ++s) {
+      if (s < cut_start || s >= cut_end) kept_steps.push_back(s);
+      timestep_map->push_back(kept_steps.size() - 1);
+    }
+    start = end;
+  }
+  if (kept_steps.size() == static_cast<size_t>(num_steps)) {
+    timestep_map->clear();
+    return nullptr;
+  }
+  // Copy the columns of the kept timesteps.
+  int new_width = 0;
+  for (int s : kept_steps) {
+    new_width += std::min((s + 1) * x_scale, width) - s * x_scale;
+  }
+  Pix* result = pixCreate(new_width, height, pixGetDepth(var_pix));
+  int dest_x = 0;
+  for (size_t i = 0; i < kept_steps.size();) {
+    size_t end = i + 1;
+    while (end < kept_steps.size() &&
+           kept_steps[end] == kept_steps[end - 1] + 1) {
+      ++end;
+    }
+    int run_end = std::min((kept_steps[end - 1] + 1) * x_scale, width);
+    int run_width = run_end - kept_steps[i] * x_scale;
+    pixRasterop(result, dest_x, 0, run_width, height, PIX_SRC, var_pix,
+                kept_steps[i] * x_scale, 0);
+    dest_x += run_width;
+    i = end;
   }
-  input->FromPix(shape, normed_pix, randomizer);
-  pixDestroy(&normed_pix);
+  return result;
 }
 
 }  // namespace tesseract.
@@ -90,6 +90,22 @@ class Input : public Network {
   // NOTE: It isn't safe for multiple threads to call this on the same pix.
   static void PreparePixInput(const StaticShape& shape, const Pix* pix,
                               TRand* randomizer, NetworkIO* input);
+  // As PreparePixInput, but converts several pixes to a single batch, with
+  // each pix at the corresponding FD_BATCH index of input.
+  static void PreparePixesInput(const StaticShape& shape,
+                                const std::vector<const Pix*>& pixes,
+                                TRand* randomizer, NetworkIO* input);
+  // Returns a copy of pix with each run of blank columns wider than
+  // max_gap_width cut down to max_gap_width, or nullptr if there are none.
+  // The columns are taken in groups of x_scale, the width of a network output
+  // timestep, the last of which may be narrower, and timestep_map is set to
+  // the timestep of the copy for each timestep of pix, or for a removed one,
+  // the last one kept before the cut.
+  // A group is blank if its range of grey levels is small compared with that
+  // of the whole image, so it works with either polarity of text.
+  static Pix* CompressBlankColumns(const Pix* pix, int x_scale,
+                                   int max_gap_width,
+                                   std::vector<int>* timestep_map);
 
  private:
   void DebugWeights() override {
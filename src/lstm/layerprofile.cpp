@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////
+// File:        layerprofile.cpp
+// Description: Profile of the forward pass of the layers of networks.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "layerprofile.h"
+
+#include <cstdio>  // for snprintf
+#include <mutex>   // for std::mutex, std::lock_guard
+#include "network.h"
+#include "networkio.h"
+
+namespace tesseract {
+
+std::atomic<bool> LayerProfile::enabled_(false);
+
+namespace {
+
+std::mutex& ProfileMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<LayerProfile::Layer>& ProfileLayers() {
+  static std::vector<LayerProfile::Layer> layers;
+  return layers;
+}
+
+// True while a LayerTimer of the thread records.
+thread_local bool timing_layer = false;
+
+}  // namespace
+
+void LayerProfile::Start() {
+  std::lock_guard<std::mutex> lock(ProfileMutex());
+  ProfileLayers().clear();
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void LayerProfile::Stop() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+std::vector<LayerProfile::Layer> LayerProfile::Layers() {
+  std::lock_guard<std::mutex> lock(ProfileMutex());
+  return ProfileLayers();
+}
+
+void LayerProfile::Print(std::string* text) {
+  std::vector<Layer> layers = Layers();
+  double total_ms = 0.0, total_ops = 0.0;
+  for (const Layer& layer : layers) {
+    total_ms += layer.ms;
+    total_ops += layer.ops;
+  }
+  char line[128];
+  for (const Layer& layer : layers) {
+    snprintf(line, sizeof(line), "%10.3f ms %5.1f%% %12.3f Mops %10lld steps "
+             "%8lld calls  ", layer.ms,
+             total_ms > 0.0 ? 100.0 * layer.ms / total_ms : 0.0,
+             layer.ops / 1e6, static_cast<long long>(layer.timesteps),
+             static_cast<long long>(layer.calls));
+    *text += line;
+    *text += layer.spec;
+    *text += '\n';
+  }
+  snprintf(line, sizeof(line), "%10.3f ms %5.1f%% %12.3f Mops  total\n",
+           total_ms, 100.0, total_ops / 1e6);
+  *text += line;
+}
+
+void LayerProfile::Record(const Network* first, const Network* last,
+                          const NetworkIO& input, double ms) {
+  std::string spec = first->spec().string();
+  double weights = first->num_weights();
+  if (last != nullptr) {
+    spec += last->spec().string();
+    weights += last->num_weights();
+  }
+  int timesteps = input.Width();
+  std::lock_guard<std::mutex> lock(ProfileMutex());
+  std::vector<Layer>& layers = ProfileLayers();
+  size_t index = 0;
+  while (index < layers.size() && layers[index].spec != spec) ++index;
+  if (index == layers.size()) layers.push_back({spec, 0, 0, 0.0, 0.0});
+  Layer& layer = layers[index];
+  ++layer.calls;
+  layer.timesteps += timesteps;
+  layer.ops += weights * timesteps;
+  layer.ms += ms;
+}
+
+LayerTimer::LayerTimer(const Network* first, const Network* last,
+                       const NetworkIO& input)
+    : first_(nullptr), last_(last), input_(input) {
+  if (first == nullptr || !LayerProfile::enabled() || timing_layer) return;
+  timing_layer = true;
+  first_ = first;
+  start_ = std::chrono::steady_clock::now();
+}
+
+LayerTimer::~LayerTimer() {
+  if (first_ == nullptr) return;
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start_;
+  LayerProfile::Record(first_, last_, input_, elapsed.count());
+  timing_layer = false;
+}
+
+}  // namespace tesseract.
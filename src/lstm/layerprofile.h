@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////
+// File:        layerprofile.h
+// Description: Profile of the forward pass of the layers of networks.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#ifndef TESSERACT_LSTM_LAYERPROFILE_H_
+#define TESSERACT_LSTM_LAYERPROFILE_H_
+
+#include <atomic>   // for std::atomic
+#include <chrono>   // for std::chrono::steady_clock
+#include <cstdint>  // for int64_t
+#include <string>   // for std::string
+#include <vector>   // for std::vector
+
+namespace tesseract {
+
+class Network;
+class NetworkIO;
+
+// Adds up the wall time, the estimated operations and the timesteps of the
+// layers of the Series of all the networks that run Forward in the process
+// while it is started, per layer spec, such as "Ct3,3,16" or "Lbx96", so
+// the cost of a model can be seen layer by layer. The same spec in two
+// places of a network, or in two networks, is one layer of the profile.
+// When it is stopped, a layer costs a relaxed atomic load.
+class LayerProfile {
+ public:
+  struct Layer {
+    std::string spec;
+    int64_t calls;      // Times the layer ran Forward.
+    int64_t timesteps;  // Total width of its inputs.
+    double ops;         // Estimated multiply-adds of its weights.
+    double ms;          // Total wall time.
+  };
+
+  // Forgets the recorded layers and starts recording.
+  static void Start();
+  // Stops recording, keeping the recorded layers.
+  static void Stop();
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  // Returns the recorded layers in the order that they first ran.
+  static std::vector<Layer> Layers();
+  // Appends a line per layer to text, with the share of the total time,
+  // and a line of the totals.
+  static void Print(std::string* text);
+
+  // Adds a run of the layer first, fused with the next layer last, if not
+  // null, on input, which took ms.
+  static void Record(const Network* first, const Network* last,
+                     const NetworkIO& input, double ms);
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Records the Forward of the layer first, or of a Convolve first fused with
+// the FullyConnected last, from its construction to its destruction, if
+// first is not null, the profile is started at its construction and no
+// enclosing layer records on the same thread, so the layers inside a
+// Parallel are not counted twice.
+class LayerTimer {
+ public:
+  LayerTimer(const Network* first, const Network* last,
+             const NetworkIO& input);
+  ~LayerTimer();
+  LayerTimer(const LayerTimer&) = delete;
+  LayerTimer& operator=(const LayerTimer&) = delete;
+
+ private:
+  const Network* first_;
+  const Network* last_;
+  const NetworkIO& input_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace tesseract.
+
+#endif  // TESSERACT_LSTM_LAYERPROFILE_H_
@@ -21,8 +21,11 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <numeric>  // for std::iota
+#include <vector>
 
 #if !defined(__GNUC__) && defined(_MSC_VER)
 #include <intrin.h>     // _BitScanReverse
@@ -31,6 +34,7 @@
 #include "fullyconnected.h"
 #include "functions.h"
 #include "networkscratch.h"
+#include "numthreads.h"
 #include "tprintf.h"
 
 // Macros for openmp code if it is available, otherwise empty macros.
@@ -70,6 +74,14 @@ namespace tesseract {
 const double kStateClip = 100.0;
 // Max absolute value of gate_errors (the gradients).
 const double kErrClip = 1.0f;
+// Max number of rows run together by ForwardRows.
+const int kRowTileSize = 16;
+// Default number of threads used by ForwardRows.
+#ifdef _OPENMP
+const int kNumRowThreads = 4;
+#else
+const int kNumRowThreads = 1;
+#endif
 
 // Calculate ceil(log2(n)).
 static inline uint32_t ceil_log2(uint32_t n)
@@ -143,6 +155,7 @@ void LSTM::SetEnableTraining(TrainingState state) {
     if (training_ == TS_ENABLED) training_ = state;
   } else {
     if (state == TS_ENABLED && training_ != TS_ENABLED) {
+      SplitGateWeights();
       for (int w = 0; w < WT_COUNT; ++w) {
         if (w == GFS && !Is2D()) continue;
         gate_weights_[w].InitBackward();
@@ -151,12 +164,14 @@ void LSTM::SetEnableTraining(TrainingState state) {
     training_ = state;
   }
   if (softmax_ != nullptr) softmax_->SetEnableTraining(state);
+  FuseGateWeights();
 }
 
 // Sets up the network for training. Initializes weights using weights of
 // scale `range` picked according to the random number generator `randomizer`.
 int LSTM::InitWeights(float range, TRand* randomizer) {
   Network::SetRandomizer(randomizer);
+  SplitGateWeights();
   num_weights_ = 0;
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
@@ -166,6 +181,7 @@ int LSTM::InitWeights(float range, TRand* randomizer) {
   if (softmax_ != nullptr) {
     num_weights_ += softmax_->InitWeights(range, randomizer);
   }
+  FuseGateWeights();
   return num_weights_;
 }
 
@@ -179,19 +195,74 @@ int LSTM::RemapOutputs(int old_no, const std::vector<int>& code_map) {
   return num_weights_;
 }
 
-// Converts a float network to an int network.
-void LSTM::ConvertToInt() {
+// Converts a float network to an int network. Only the first ni_ inputs of
+// the gates come from the input. The rest are recurrent, in [-1, 1], as is
+// the input to the softmax.
+float LSTM::ConvertToInt(float input_range) {
+  SplitGateWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
+    if (input_range != 1.0f) gate_weights_[w].ScaleInputs(input_range, ni_);
     gate_weights_[w].ConvertToInt();
   }
   if (softmax_ != nullptr) {
-    softmax_->ConvertToInt();
+    softmax_->ConvertToInt(1.0f);
+  }
+  FuseGateWeights();
+  return int_range_;
+}
+
+// Converts a double network to a single precision float network.
+void LSTM::ConvertToFloat32() {
+  SplitGateWeights();
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].ConvertToFloat32();
+  }
+  if (softmax_ != nullptr) {
+    softmax_->ConvertToFloat32();
+  }
+  FuseGateWeights();
+}
+
+// Prunes the smallest blocks of the gate weights and of any softmax.
+int LSTM::PruneWeights(double fraction) {
+  SplitGateWeights();
+  int num_pruned = 0;
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    num_pruned += gate_weights_[w].PruneBlocks(fraction);
   }
+  if (softmax_ != nullptr) num_pruned += softmax_->PruneWeights(fraction);
+  FuseGateWeights();
+  return num_pruned;
+}
+
+// Appends the shapes of the weight matrices used by Forward.
+void LSTM::MatrixShapes(std::vector<std::pair<int, int>>* shapes) const {
+  if (fused_weights_ != nullptr) {
+    shapes->emplace_back(fused_weights_->NumOutputs(),
+                         fused_weights_->NumInputs());
+  } else {
+    for (int w = 0; w < WT_COUNT; ++w) {
+      if (w == GFS && !Is2D()) continue;
+      shapes->emplace_back(gate_weights_[w].NumOutputs(),
+                           gate_weights_[w].NumInputs());
+    }
+  }
+  if (softmax_ != nullptr) softmax_->MatrixShapes(shapes);
+}
+
+// Adds the bytes of the weight matrices to usage.
+void LSTM::AddMemoryUsage(MemoryUsage* usage) const {
+  for (const auto& weights : gate_weights_) weights.AddMemoryUsage(usage);
+  if (fused_weights_ != nullptr) fused_weights_->AddMemoryUsage(usage);
+  if (softmax_ != nullptr) softmax_->AddMemoryUsage(usage);
 }
 
 // Sets up the network for training using the given weight_range.
 void LSTM::DebugWeights() {
+  SplitGateWeights();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     STRING msg = name_;
@@ -201,15 +272,27 @@ void LSTM::DebugWeights() {
   if (softmax_ != nullptr) {
     softmax_->DebugWeights();
   }
+  FuseGateWeights();
 }
 
 // Writes to the given file. Returns false in case of error.
 bool LSTM::Serialize(TFile* fp) const {
   if (!Network::Serialize(fp)) return false;
   if (!fp->Serialize(&na_)) return false;
+  int gate = 0;
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
-    if (!gate_weights_[w].Serialize(IsTraining(), fp)) return false;
+    if (fused_weights_ != nullptr) {
+      // Write the gate from its rows of the fused weights.
+      std::vector<int> rows(ns_);
+      std::iota(rows.begin(), rows.end(), gate * ns_);
+      WeightMatrix gate_weights;
+      gate_weights.InitRows(*fused_weights_, rows);
+      if (!gate_weights.Serialize(IsTraining(), fp)) return false;
+    } else if (!gate_weights_[w].Serialize(IsTraining(), fp)) {
+      return false;
+    }
+    ++gate;
   }
   if (softmax_ != nullptr && !softmax_->Serialize(fp)) return false;
   return true;
@@ -227,6 +310,7 @@ bool LSTM::DeSerialize(TFile* fp) {
     nf_ = 0;
   }
   is_2d_ = false;
+  fused_weights_.reset();
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
     if (!gate_weights_[w].DeSerialize(IsTraining(), fp)) return false;
@@ -242,26 +326,117 @@ bool LSTM::DeSerialize(TFile* fp) {
   } else {
     softmax_ = nullptr;
   }
+  FuseGateWeights();
   return true;
 }
 
+// Builds fused_weights_ from gate_weights_ if training is disabled, freeing
+// the gates, or splits it back into the gates otherwise, as it would not see
+// any weight updates.
+void LSTM::FuseGateWeights() {
+  if (training_ != TS_DISABLED) {
+    SplitGateWeights();
+    return;
+  }
+  if (fused_weights_ != nullptr) return;
+  std::vector<const WeightMatrix*> parts;
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    parts.push_back(&gate_weights_[w]);
+  }
+  fused_weights_.reset(new WeightMatrix);
+  fused_weights_->InitFused(parts);
+  for (auto& weights : gate_weights_) weights = WeightMatrix();
+}
+
+void LSTM::SplitGateWeights() {
+  if (fused_weights_ == nullptr) return;
+  int gate = 0;
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    std::vector<int> rows(ns_);
+    std::iota(rows.begin(), rows.end(), gate * ns_);
+    gate_weights_[w].InitRows(*fused_weights_, rows);
+    ++gate;
+  }
+  fused_weights_.reset();
+}
+
 // Runs forward propagation of activations on the input line.
 // See NetworkCpp for a detailed discussion of the arguments.
 void LSTM::Forward(bool debug, const NetworkIO& input,
                    const TransposedArray* input_transpose,
                    NetworkScratch* scratch, NetworkIO* output) {
-  input_map_ = input.stride_map();
-  input_width_ = input.Width();
+  ForwardInternal(debug, input, false, scratch, output);
+}
+
+// Runs forward propagation along each row of the input from right to left,
+// which gives the same output as Forward on an x-reversed copy of the input,
+// reversed back, without making either copy.
+void LSTM::ForwardXReversed(bool debug, const NetworkIO& input,
+                            NetworkScratch* scratch, NetworkIO* output) {
+  ASSERT_HOST(CanForwardXReversed());
+  ForwardInternal(debug, input, true, scratch, output);
+}
+
+// Common code for Forward and ForwardXReversed. As each row starts from a
+// zero state, only the direction along the rows matters, so reversal just
+// walks the timesteps backwards.
+void LSTM::ForwardInternal(bool debug, const NetworkIO& input, bool x_reversed,
+                           NetworkScratch* scratch, NetworkIO* output) {
+  const StrideMap& input_map = input.stride_map();
   if (softmax_ != nullptr)
     output->ResizeFloat(input, no_);
   else if (type_ == NT_LSTM_SUMMARY)
     output->ResizeXTo1(input, no_);
   else
     output->Resize(input, no_);
-  ResizeForward(input);
-  // Temporary storage of forward computation for each gate.
-  NetworkScratch::FloatVec temp_lines[WT_COUNT];
-  for (auto & temp_line : temp_lines) temp_line.Init(ns_, scratch);
+  if (output->int_mode()) output->set_int_range(int_range_);
+  // The padded source is only kept in source_ for Backward. For inference
+  // it goes in the scratch space, leaving the network unchanged, so that
+  // separate threads can run it.
+  NetworkScratch::IO inference_source;
+  NetworkIO* source = &source_;
+  if (IsTraining()) {
+    input_map_ = input_map;
+    input_width_ = input.Width();
+    ResizeForward(input);
+  } else {
+    inference_source.Resize(input, SourceWeights().RoundInputs(na_),
+                            scratch);
+    source = inference_source;
+    // The input part is copied unchanged, as its range is folded into the
+    // weights, but the recurrent part is written in [-1, 1].
+    source->set_int_range(1.0f);
+  }
+  if (fused_weights_ != nullptr && source->int_mode() && !Is2D() &&
+      softmax_ == nullptr &&
+      input_map.Size(FD_BATCH) * input_map.Size(FD_HEIGHT) > 1) {
+    ForwardRows(input, x_reversed, scratch, source, output);
+    CalibrateRange(*output);
+    if (debug) DisplayForward(*output);
+    return;
+  }
+  // Number of threads to run the gate sections on.
+  int num_threads = std::min<int>(GFS, NumThreads(GFS, scratch->num_threads()));
+  // Output of the fused gate weights, with the gates in WeightType order.
+  NetworkScratch::FloatVec fused_lines;
+  int num_gates = Is2D() ? WT_COUNT : GFS;
+  // Temporary storage of forward computation for each gate, which points
+  // into fused_lines if the gates are fused.
+  NetworkScratch::FloatVec temp_vecs[WT_COUNT];
+  double* temp_lines[WT_COUNT];
+  if (fused_weights_ != nullptr) {
+    fused_lines.Init(num_gates * ns_, scratch);
+    for (int w = 0; w < WT_COUNT; ++w) {
+      temp_lines[w] = w < num_gates ? fused_lines + w * ns_ : nullptr;
+    }
+  } else {
+    for (int w = 0; w < WT_COUNT; ++w) {
+      temp_vecs[w].Init(ns_, scratch);
+      temp_lines[w] = temp_vecs[w];
+    }
+  }
   // Single timestep buffers for the current/recurrent output and state.
   NetworkScratch::FloatVec curr_state, curr_output;
   curr_state.Init(ns_, scratch);
@@ -271,7 +446,7 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
   // Rotating buffers of width buf_width allow storage of the state and output
   // for the other dimension, used only when working in true 2D mode. The width
   // is enough to hold an entire strip of the major direction.
-  int buf_width = Is2D() ? input_map_.Size(FD_WIDTH) : 1;
+  int buf_width = Is2D() ? input_map.Size(FD_WIDTH) : 1;
   GenericVector<NetworkScratch::FloatVec> states, outputs;
   if (Is2D()) {
     states.init_to_size(buf_width, NetworkScratch::FloatVec());
@@ -283,99 +458,129 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
       ZeroVector<double>(ns_, outputs[i]);
     }
   }
+  // In float32 mode the float source is used directly, without conversion.
+  bool float32_mode =
+      !source->int_mode() && SourceWeights().is_float32_mode();
   // Used only if a softmax LSTM.
   NetworkScratch::FloatVec softmax_output;
   NetworkScratch::IO int_output;
+  NetworkScratch::IO float_output;
   if (softmax_ != nullptr) {
     softmax_output.Init(no_, scratch);
     ZeroVector<double>(no_, softmax_output);
-    int rounded_softmax_inputs = gate_weights_[CI].RoundInputs(ns_);
+    int rounded_softmax_inputs = SourceWeights().RoundInputs(ns_);
     if (input.int_mode())
       int_output.Resize2d(true, 1, rounded_softmax_inputs, scratch);
+    else if (float32_mode)
+      float_output.Resize2d(false, 1, ns_, scratch);
     softmax_->SetupForward(input, nullptr);
   }
   NetworkScratch::FloatVec curr_input;
   curr_input.Init(na_, scratch);
-  StrideMap::Index src_index(input_map_);
+  StrideMap::Index src_index(input_map);
+  if (x_reversed) src_index.InitToLast();
   // Used only by NT_LSTM_SUMMARY.
   StrideMap::Index dest_index(output->stride_map());
   do {
     int t = src_index.t();
     // True if there is a valid old state for the 2nd dimension.
-    bool valid_2d = Is2D();
-    if (valid_2d) {
-      StrideMap::Index dim_index(src_index);
-      if (!dim_index.AddOffset(-1, FD_HEIGHT)) valid_2d = false;
-    }
+    bool valid_2d = Is2D() && src_index.index(FD_HEIGHT) > 0;
     // Index of the 2-D revolving buffers (outputs, states).
     int mod_t = Modulo(t, buf_width);      // Current timestep.
     // Setup the padded input in source.
-    source_.CopyTimeStepGeneral(t, 0, ni_, input, t, 0);
+    source->CopyTimeStepGeneral(t, 0, ni_, input, t, 0);
     if (softmax_ != nullptr) {
-      source_.WriteTimeStepPart(t, ni_, nf_, softmax_output);
+      source->WriteTimeStepPart(t, ni_, nf_, softmax_output);
     }
-    source_.WriteTimeStepPart(t, ni_ + nf_, ns_, curr_output);
+    source->WriteTimeStepPart(t, ni_ + nf_, ns_, curr_output);
     if (Is2D())
-      source_.WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
-    if (!source_.int_mode()) source_.ReadTimeStep(t, curr_input);
+      source->WriteTimeStepPart(t, ni_ + nf_ + ns_, ns_, outputs[mod_t]);
+    if (!source->int_mode() && !float32_mode)
+      source->ReadTimeStep(t, curr_input);
     // Matrix multiply the inputs with the source.
-    PARALLEL_IF_OPENMP(GFS)
-    // It looks inefficient to create the threads on each t iteration, but the
-    // alternative of putting the parallel outside the t loop, a single around
-    // the t-loop and then tasks in place of the sections is a *lot* slower.
-    // Cell inputs.
-    if (source_.int_mode())
-      gate_weights_[CI].MatrixDotVector(source_.i(t), temp_lines[CI]);
-    else
-      gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
-    FuncInplace<GFunc>(ns_, temp_lines[CI]);
+    if (fused_weights_ != nullptr) {
+      // All the gates in a single pass over the input.
+      if (source->int_mode())
+        fused_weights_->MatrixDotVector(source->i(t), fused_lines);
+      else if (float32_mode)
+        fused_weights_->MatrixDotVector(source->f(t), fused_lines);
+      else
+        fused_weights_->MatrixDotVector(curr_input, fused_lines);
+      // CI is followed by the sigmoid gates, which are all contiguous.
+      // temp_lines point at the gates in place.
+      FuncInplace<GFunc>(ns_, fused_lines);
+      FuncInplace<FFunc>((num_gates - 1) * ns_, fused_lines + ns_);
+    } else {
+      PARALLEL_IF_OPENMP(num_threads)
+      // It looks inefficient to create the threads on each t iteration, but the
+      // alternative of putting the parallel outside the t loop, a single around
+      // the t-loop and then tasks in place of the sections is a *lot* slower.
+      // Cell inputs.
+      if (source->int_mode())
+        gate_weights_[CI].MatrixDotVector(source->i(t), temp_lines[CI]);
+      else if (float32_mode)
+        gate_weights_[CI].MatrixDotVector(source->f(t), temp_lines[CI]);
+      else
+        gate_weights_[CI].MatrixDotVector(curr_input, temp_lines[CI]);
+      FuncInplace<GFunc>(ns_, temp_lines[CI]);
 
-    SECTION_IF_OPENMP
-    // Input Gates.
-    if (source_.int_mode())
-      gate_weights_[GI].MatrixDotVector(source_.i(t), temp_lines[GI]);
-    else
-      gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
-    FuncInplace<FFunc>(ns_, temp_lines[GI]);
+      SECTION_IF_OPENMP
+      // Input Gates.
+      if (source->int_mode())
+        gate_weights_[GI].MatrixDotVector(source->i(t), temp_lines[GI]);
+      else if (float32_mode)
+        gate_weights_[GI].MatrixDotVector(source->f(t), temp_lines[GI]);
+      else
+        gate_weights_[GI].MatrixDotVector(curr_input, temp_lines[GI]);
+      FuncInplace<FFunc>(ns_, temp_lines[GI]);
 
-    SECTION_IF_OPENMP
-    // 1-D forget gates.
-    if (source_.int_mode())
-      gate_weights_[GF1].MatrixDotVector(source_.i(t), temp_lines[GF1]);
-    else
-      gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
-    FuncInplace<FFunc>(ns_, temp_lines[GF1]);
-
-    // 2-D forget gates.
-    if (Is2D()) {
-      if (source_.int_mode())
-        gate_weights_[GFS].MatrixDotVector(source_.i(t), temp_lines[GFS]);
+      SECTION_IF_OPENMP
+      // 1-D forget gates.
+      if (source->int_mode())
+        gate_weights_[GF1].MatrixDotVector(source->i(t), temp_lines[GF1]);
+      else if (float32_mode)
+        gate_weights_[GF1].MatrixDotVector(source->f(t), temp_lines[GF1]);
       else
-        gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
-      FuncInplace<FFunc>(ns_, temp_lines[GFS]);
-    }
+        gate_weights_[GF1].MatrixDotVector(curr_input, temp_lines[GF1]);
+      FuncInplace<FFunc>(ns_, temp_lines[GF1]);
 
-    SECTION_IF_OPENMP
-    // Output gates.
-    if (source_.int_mode())
-      gate_weights_[GO].MatrixDotVector(source_.i(t), temp_lines[GO]);
-    else
-      gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
-    FuncInplace<FFunc>(ns_, temp_lines[GO]);
-    END_PARALLEL_IF_OPENMP
+      // 2-D forget gates.
+      if (Is2D()) {
+        if (source->int_mode())
+          gate_weights_[GFS].MatrixDotVector(source->i(t), temp_lines[GFS]);
+        else if (float32_mode)
+          gate_weights_[GFS].MatrixDotVector(source->f(t), temp_lines[GFS]);
+        else
+          gate_weights_[GFS].MatrixDotVector(curr_input, temp_lines[GFS]);
+        FuncInplace<FFunc>(ns_, temp_lines[GFS]);
+      }
+
+      SECTION_IF_OPENMP
+      // Output gates.
+      if (source->int_mode())
+        gate_weights_[GO].MatrixDotVector(source->i(t), temp_lines[GO]);
+      else if (float32_mode)
+        gate_weights_[GO].MatrixDotVector(source->f(t), temp_lines[GO]);
+      else
+        gate_weights_[GO].MatrixDotVector(curr_input, temp_lines[GO]);
+      FuncInplace<FFunc>(ns_, temp_lines[GO]);
+      END_PARALLEL_IF_OPENMP
+    }
 
     // Apply forget gate to state.
     MultiplyVectorsInPlace(ns_, temp_lines[GF1], curr_state);
     if (Is2D()) {
       // Max-pool the forget gates (in 2-d) instead of blindly adding.
-      int8_t* which_fg_col = which_fg_[t];
-      memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
+      // The choices are only recorded for Backward.
+      int8_t* which_fg_col = IsTraining() ? which_fg_[t] : nullptr;
+      if (which_fg_col != nullptr)
+        memset(which_fg_col, 1, ns_ * sizeof(which_fg_col[0]));
       if (valid_2d) {
         const double* stepped_state = states[mod_t];
         for (int i = 0; i < ns_; ++i) {
           if (temp_lines[GF1][i] < temp_lines[GFS][i]) {
             curr_state[i] = temp_lines[GFS][i] * stepped_state[i];
-            which_fg_col[i] = 2;
+            if (which_fg_col != nullptr) which_fg_col[i] = 2;
           }
         }
       }
@@ -397,6 +602,9 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
       if (input.int_mode()) {
         int_output->WriteTimeStepPart(0, 0, ns_, curr_output);
         softmax_->ForwardTimeStep(int_output->i(0), t, softmax_output);
+      } else if (float32_mode) {
+        float_output->WriteTimeStepPart(0, 0, ns_, curr_output);
+        softmax_->ForwardTimeStep(float_output->f(0), t, softmax_output);
       } else {
         softmax_->ForwardTimeStep(curr_output, t, softmax_output);
       }
@@ -420,22 +628,122 @@ void LSTM::Forward(bool debug, const NetworkIO& input,
     }
     // Always zero the states at the end of every row, but only for the major
     // direction. The 2-D state remains intact.
-    if (src_index.IsLast(FD_WIDTH)) {
+    if (x_reversed ? src_index.index(FD_WIDTH) == 0
+                   : src_index.IsLast(FD_WIDTH)) {
       ZeroVector<double>(ns_, curr_state);
       ZeroVector<double>(ns_, curr_output);
     }
-  } while (src_index.Increment());
+    // A huge line may take long, so the deadline is checked as it goes. The
+    // caller discards the outputs once cancelled.
+    if (scratch->Cancelled()) {
+      output->Zero();
+      break;
+    }
+  } while (x_reversed ? src_index.Decrement() : src_index.Increment());
 #if DEBUG_DETAIL > 0
   tprintf("Source:%s\n", name_.string());
-  source_.Print(10);
+  source->Print(10);
   tprintf("State:%s\n", name_.string());
   state_.Print(10);
   tprintf("Output:%s\n", name_.string());
   output->Print(10);
 #endif
+  if (softmax_ == nullptr) CalibrateRange(*output);
   if (debug) DisplayForward(*output);
 }
 
+// Part of ForwardInternal that runs tiles of independent rows as a batch.
+void LSTM::ForwardRows(const NetworkIO& input, bool x_reversed,
+                       NetworkScratch* scratch, NetworkIO* source,
+                       NetworkIO* output) {
+  const StrideMap& input_map = input.stride_map();
+  const StrideMap& output_map = output->stride_map();
+  // A tile is consecutive rows of the same image, which have the same width
+  // and whose timesteps are a fixed distance apart in the source.
+  struct RowTile {
+    int batch, y, num_rows, width;
+  };
+  std::vector<RowTile> tiles;
+  for (int b = 0; b < input_map.Size(FD_BATCH); ++b) {
+    StrideMap::Index index(input_map, b, 0, 0);
+    int height = index.MaxIndexOfDim(FD_HEIGHT) + 1;
+    int width = index.MaxIndexOfDim(FD_WIDTH) + 1;
+    for (int y = 0; y < height; y += kRowTileSize) {
+      tiles.push_back({b, y, std::min(kRowTileSize, height - y), width});
+    }
+  }
+  int num_tiles = tiles.size();
+  // The gates are in WeightType order in the output of fused_weights_.
+  int gates_size = GFS * ns_;
+  int row_stride = input_map.Size(FD_WIDTH);
+  int num_threads = NumThreads(kNumRowThreads, scratch->num_threads());
+  num_threads = std::max(1, std::min(num_threads, num_tiles));
+  GenericVector<NetworkScratch::FloatVec> gate_tiles, state_tiles, output_tiles;
+  gate_tiles.init_to_size(num_threads, NetworkScratch::FloatVec());
+  state_tiles.init_to_size(num_threads, NetworkScratch::FloatVec());
+  output_tiles.init_to_size(num_threads, NetworkScratch::FloatVec());
+  for (int i = 0; i < num_threads; ++i) {
+    gate_tiles[i].Init(kRowTileSize * gates_size, scratch);
+    state_tiles[i].Init(kRowTileSize * ns_, scratch);
+    output_tiles[i].Init(kRowTileSize * ns_, scratch);
+  }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1) if (num_threads > 1)
+  for (int i = 0; i < num_tiles; ++i) {
+    // Thread-local pointers to temporary storage.
+    int thread_id = omp_get_thread_num();
+#else
+  for (int i = 0; i < num_tiles; ++i) {
+    // Thread-local pointers to temporary storage.
+    int thread_id = 0;
+#endif
+    const RowTile& tile = tiles[i];
+    double* gates = gate_tiles[thread_id];
+    double* states = state_tiles[thread_id];
+    double* outputs = output_tiles[thread_id];
+    ZeroVector<double>(tile.num_rows * ns_, states);
+    ZeroVector<double>(tile.num_rows * ns_, outputs);
+    int first_t = StrideMap::Index(input_map, tile.batch, tile.y, 0).t();
+    for (int step = 0; step < tile.width; ++step) {
+      if (scratch->Cancelled()) break;
+      int x = x_reversed ? tile.width - 1 - step : step;
+      // Setup the padded input of each row in source.
+      for (int r = 0; r < tile.num_rows; ++r) {
+        int t = first_t + r * row_stride + x;
+        source->CopyTimeStepGeneral(t, 0, ni_, input, t, 0);
+        source->WriteTimeStepPart(t, ni_, ns_, outputs + r * ns_);
+      }
+      fused_weights_->MatrixDotMatrix(source->i(first_t + x),
+                                      row_stride * source->NumFeatures(),
+                                      tile.num_rows, gates, gates_size);
+      for (int r = 0; r < tile.num_rows; ++r) {
+        double* gate_line = gates + r * gates_size;
+        double* curr_state = states + r * ns_;
+        double* curr_output = outputs + r * ns_;
+        FuncInplace<GFunc>(ns_, gate_line + CI * ns_);
+        FuncInplace<FFunc>(gates_size - ns_, gate_line + GI * ns_);
+        MultiplyVectorsInPlace(ns_, gate_line + GF1 * ns_, curr_state);
+        MultiplyAccumulate(ns_, gate_line + CI * ns_, gate_line + GI * ns_,
+                           curr_state);
+        ClipVector<double>(ns_, -kStateClip, kStateClip, curr_state);
+        FuncMultiply<HFunc>(curr_state, gate_line + GO * ns_, ns_,
+                            curr_output);
+        if (type_ != NT_LSTM_SUMMARY)
+          output->WriteTimeStep(first_t + r * row_stride + x, curr_output);
+      }
+    }
+    if (type_ == NT_LSTM_SUMMARY) {
+      // Output only the end of each row.
+      for (int r = 0; r < tile.num_rows; ++r) {
+        StrideMap::Index dest_index(output_map, tile.batch, tile.y + r, 0);
+        output->WriteTimeStep(dest_index.t(), outputs + r * ns_);
+      }
+    }
+  }
+  // The caller discards the outputs once cancelled.
+  if (scratch->Cancelled()) output->Zero();
+}
+
 // Runs backward propagation of errors on the deltas line.
 // See NetworkCpp for a detailed discussion of the arguments.
 bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
@@ -453,6 +761,8 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
   curr_sourceerr.Init(na_, scratch);
   ZeroVector<double>(ns_, curr_stateerr);
   ZeroVector<double>(na_, curr_sourceerr);
+  // Number of threads to run the gate sections on.
+  int num_threads = std::min<int>(GFS, NumThreads(GFS, scratch->num_threads()));
   // Errors in the gates.
   NetworkScratch::FloatVec gate_errors[WT_COUNT];
   for (auto & gate_error : gate_errors) gate_error.Init(ns_, scratch);
@@ -505,14 +815,8 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
     int up_pos = -1;
     int down_pos = -1;
     if (Is2D()) {
-      if (dest_index.index(FD_HEIGHT) > 0) {
-        StrideMap::Index up_index(dest_index);
-        if (up_index.AddOffset(-1, FD_HEIGHT)) up_pos = up_index.t();
-      }
-      if (!dest_index.IsLast(FD_HEIGHT)) {
-        StrideMap::Index down_index(dest_index);
-        if (down_index.AddOffset(1, FD_HEIGHT)) down_pos = down_index.t();
-      }
+      if (dest_index.index(FD_HEIGHT) > 0) up_pos = dest_index.OffsetT(0, -1);
+      if (!dest_index.IsLast(FD_HEIGHT)) down_pos = dest_index.OffsetT(0, 1);
     }
     // Index of the 2-D revolving buffers (sourceerr, stateerr).
     int mod_t = Modulo(t, buf_width);      // Current timestep.
@@ -574,7 +878,7 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
     }
 #endif
     // Matrix multiply to get the source errors.
-    PARALLEL_IF_OPENMP(GFS)
+    PARALLEL_IF_OPENMP(num_threads)
 
     // Cell inputs.
     node_values_[CI].FuncMultiply3<GPrime>(t, node_values_[GI], t,
@@ -650,7 +954,7 @@ bool LSTM::Backward(bool debug, const NetworkIO& fwd_deltas,
   state_t.Init(ns_, width, scratch);
   state_.Transpose(state_t.get());
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(GFS) if (!Is2D())
+#pragma omp parallel for num_threads(num_threads) if (!Is2D())
 #endif
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
@@ -697,8 +1001,43 @@ void LSTM::CountAlternators(const Network& other, double* same,
   }
 }
 
+// Sets the weight deltas of *this to the means of those of others.
+void LSTM::AverageDeltas(const std::vector<const Network*>& others) {
+  std::vector<const LSTM*> lstms;
+  for (const Network* other : others) {
+    ASSERT_HOST(other->type() == type_);
+    lstms.push_back(static_cast<const LSTM*>(other));
+  }
+  std::vector<const WeightMatrix*> weights(lstms.size());
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    for (size_t n = 0; n < lstms.size(); ++n)
+      weights[n] = &lstms[n]->gate_weights_[w];
+    gate_weights_[w].AverageDeltas(weights);
+  }
+  if (softmax_ != nullptr) {
+    std::vector<const Network*> softmaxes;
+    for (const LSTM* lstm : lstms) softmaxes.push_back(lstm->softmax_);
+    softmax_->AverageDeltas(softmaxes);
+  }
+}
+
+// Copies the weights of other, which has the same structure, to *this.
+void LSTM::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const LSTM* lstm = static_cast<const LSTM*>(&other);
+  for (int w = 0; w < WT_COUNT; ++w) {
+    if (w == GFS && !Is2D()) continue;
+    gate_weights_[w].CopyWeights(lstm->gate_weights_[w]);
+  }
+  if (softmax_ != nullptr) {
+    softmax_->CopyWeights(*lstm->softmax_);
+  }
+}
+
 // Prints the weights for debug purposes.
 void LSTM::PrintW() {
+  SplitGateWeights();
   tprintf("Weight state:%s\n", name_.string());
   for (int w = 0; w < WT_COUNT; ++w) {
     if (w == GFS && !Is2D()) continue;
@@ -721,6 +1060,7 @@ void LSTM::PrintW() {
       tprintf(" %g", gate_weights_[w].GetWeights(s)[na_]);
     tprintf("\n");
   }
+  FuseGateWeights();
 }
 
 // Prints the weight deltas for debug purposes.
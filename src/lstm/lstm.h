@@ -19,6 +19,7 @@
 #ifndef TESSERACT_LSTM_LSTM_H_
 #define TESSERACT_LSTM_LSTM_H_
 
+#include <memory>  // for std::unique_ptr
 #include "network.h"
 #include "fullyconnected.h"
 
@@ -81,7 +82,17 @@ class LSTM : public Network {
   int RemapOutputs(int old_no, const std::vector<int>& code_map) override;
 
   // Converts a float network to an int network.
-  void ConvertToInt() override;
+  float ConvertToInt(float input_range) override;
+
+  // Converts a double network to a single precision float network.
+  void ConvertToFloat32() override;
+  // Prunes the smallest blocks of weights. See Network::PruneWeights.
+  int PruneWeights(double fraction) override;
+
+  // Appends the shapes of the weight matrices used by Forward.
+  void MatrixShapes(std::vector<std::pair<int, int>>* shapes) const override;
+  // Adds the bytes of the weight matrices to usage.
+  void AddMemoryUsage(MemoryUsage* usage) const override;
 
   // Provides debug output on the weights.
   void DebugWeights() override;
@@ -96,6 +107,16 @@ class LSTM : public Network {
   void Forward(bool debug, const NetworkIO& input,
                const TransposedArray* input_transpose, NetworkScratch* scratch,
                NetworkIO* output) override;
+  // Returns true if ForwardXReversed can be used in place of running Forward
+  // on an x-reversed copy of the input: 1-D and not training.
+  bool CanForwardXReversed() const {
+    return type_ == NT_LSTM && !Is2D() && !IsTraining();
+  }
+  // Runs forward propagation along each row of the input from right to left,
+  // which gives the same output as Forward on an x-reversed copy of the input,
+  // reversed back, without making either copy.
+  void ForwardXReversed(bool debug, const NetworkIO& input,
+                        NetworkScratch* scratch, NetworkIO* output);
 
   // Runs backward propagation of errors on the deltas line.
   // See Network for a detailed discussion of the arguments.
@@ -110,6 +131,10 @@ class LSTM : public Network {
   // *changed.
   void CountAlternators(const Network& other, double* same,
                         double* changed) const override;
+  // Sets the weight deltas of *this to the means of those of others.
+  void AverageDeltas(const std::vector<const Network*>& others) override;
+  // Copies the weights of other, which has the same structure, to *this.
+  void CopyWeights(const Network& other) override;
   // Prints the weights for debug purposes.
   void PrintW();
   // Prints the weight deltas for debug purposes.
@@ -123,6 +148,30 @@ class LSTM : public Network {
  private:
   // Resizes forward data to cope with an input image of the given width.
   void ResizeForward(const NetworkIO& input);
+  // Common code for Forward and ForwardXReversed.
+  void ForwardInternal(bool debug, const NetworkIO& input, bool x_reversed,
+                       NetworkScratch* scratch, NetworkIO* output);
+  // Part of ForwardInternal for a 1-D LSTM with int input and fused weights,
+  // which runs many rows of the input together. The rows are independent
+  // sequences, so in tiles of rows, each timestep of all the rows is a single
+  // matrix-matrix product, and the tiles run on separate threads. This is
+  // most useful for the summarizing LSTM over the columns of a transposed
+  // line image, which has a row for every x position of the line.
+  void ForwardRows(const NetworkIO& input, bool x_reversed,
+                   NetworkScratch* scratch, NetworkIO* source,
+                   NetworkIO* output);
+  // Builds fused_weights_ from gate_weights_ and frees them if training is
+  // disabled, or splits fused_weights_ back into gate_weights_ otherwise.
+  void FuseGateWeights();
+  // Rebuilds gate_weights_ from the rows of fused_weights_ and deletes it, so
+  // the gates can be changed or read on their own. Does nothing if there is
+  // no fused_weights_.
+  void SplitGateWeights();
+  // Returns the weights that Forward multiplies the source with, which have
+  // the mode and input rounding of all the gates.
+  const WeightMatrix& SourceWeights() const {
+    return fused_weights_ != nullptr ? *fused_weights_ : gate_weights_[CI];
+  }
 
  private:
   // Size of padded input to weight matrices = ni_ + no_ for 1-D operation
@@ -139,8 +188,12 @@ class LSTM : public Network {
   // Flag indicating 2-D operation.
   bool is_2d_;
 
-  // Gate weight arrays of size [na + 1, no].
+  // Gate weight arrays of size [na + 1, no]. Empty while fused_weights_ holds
+  // them.
   WeightMatrix gate_weights_[WT_COUNT];
+  // All the gate weights concatenated in WeightType order, so a single pass
+  // over the input computes all the gates. Used only when not training.
+  std::unique_ptr<WeightMatrix> fused_weights_;
   // Used only if this is a softmax LSTM.
   FullyConnected* softmax_;
   // Input padded with previous output of size [width, na].
@@ -23,21 +23,36 @@
 
 #include "lstmrecognizer.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <algorithm>  // for std::stable_sort
+#include <condition_variable>  // for std::condition_variable
+#include <deque>      // for std::deque
+#include <memory>     // for std::unique_ptr
+#include <mutex>      // for std::mutex
 #include "allheaders.h"
 #include "callcpp.h"
+#include "counters.h"
 #include "dict.h"
+#include "fullyconnected.h"
 #include "genericheap.h"
 #include "helpers.h"
 #include "imagedata.h"
+#include "initprofile.h"
 #include "input.h"
 #include "lstm.h"
 #include "normalis.h"
+#include "numthreads.h"
 #include "pageres.h"
+#include "plumbing.h"
 #include "ratngs.h"
 #include "recodebeam.h"
 #include "scrollview.h"
 #include "statistc.h"
+#include "tessdatamanager.h"
 #include "tprintf.h"
+#include "tracing.h"
 
 namespace tesseract {
 
@@ -45,9 +60,101 @@ namespace tesseract {
 const double kDictRatio = 2.25;
 // Default certainty offset to give the dictionary a chance.
 const double kCertOffset = -0.085;
+// Lines are only batched together if the widest is at most this multiple of
+// the narrowest, to limit the work wasted on padding.
+const double kMaxBatchWidthRatio = 1.5;
+// Max fraction of the pixels of a line that are darker than the middle of its
+// range of grey levels for the line to be taken as dark text on a light
+// background without trying it inverted. A line with more than 1 minus this
+// fraction dark is taken to be inverted.
+const double kMaxInkFraction = 0.3;
+// Fraction of the pixels at each end of the histogram of a line that are
+// ignored in finding its range of grey levels, to skip noise.
+const double kPolarityTailFraction = 0.02;
+// Min range of grey levels of a line for its polarity to be judged.
+const int kMinPolarityContrast = 64;
+
+// Result of LinePolarity.
+enum LinePolarityType { LP_NORMAL, LP_INVERTED, LP_UNSURE };
+
+// Judges from its grey levels whether the prepared line image pix is dark
+// text on a light background, or inverted, on the basis that the text takes
+// up the smaller part of the line. Only works on grey images.
+static LinePolarityType LinePolarity(Pix* pix) {
+  if (pixGetDepth(pix) != 8) return LP_UNSURE;
+  int width = pixGetWidth(pix);
+  int height = pixGetHeight(pix);
+  int wpl = pixGetWpl(pix);
+  l_uint32* data = pixGetData(pix);
+  int histogram[256] = {0};
+  for (int y = 0; y < height; ++y, data += wpl) {
+    for (int x = 0; x < width; ++x) ++histogram[GET_DATA_BYTE(data, x)];
+  }
+  int total = width * height;
+  int tail = static_cast<int>(total * kPolarityTailFraction);
+  int low = 0;
+  for (int sum = histogram[0]; sum <= tail && low < 255;) {
+    sum += histogram[++low];
+  }
+  int high = 255;
+  for (int sum = histogram[255]; sum <= tail && high > 0;) {
+    sum += histogram[--high];
+  }
+  if (high - low < kMinPolarityContrast) return LP_UNSURE;
+  int middle = (low + high) / 2;
+  int dark = 0;
+  for (int level = 0; level < middle; ++level) dark += histogram[level];
+  if (dark < total * kMaxInkFraction) return LP_NORMAL;
+  if (dark > total * (1.0 - kMaxInkFraction)) return LP_INVERTED;
+  return LP_UNSURE;
+}
+
+// Sets up the approximate softmax on the output layer of network, if it is
+// a FullyConnected softmax. See FullyConnected::SetupApproxSoftmax.
+static void SetupApproxOutput(Network* network) {
+  if (network->type() != NT_SERIES) return;
+  Network* output = static_cast<Series*>(network)->stack().back();
+  if (output->type() == NT_SOFTMAX || output->type() == NT_SOFTMAX_NO_CTC) {
+    static_cast<FullyConnected*>(output)->SetupApproxSoftmax();
+  }
+}
+
+// Loads a network for sharing through the NetworkCache.
+struct NetworkLoader {
+  NetworkLoader(TessdataManager* mgr, bool float32, bool approx_softmax)
+      : mgr_(mgr), float32_(float32), approx_softmax_(approx_softmax) {}
+
+  SharedNetwork* Load();
+
+  TessdataManager* mgr_;
+  bool float32_;
+  bool approx_softmax_;
+};
+
+SharedNetwork* NetworkLoader::Load() {
+  TFile fp;
+  if (!mgr_->GetComponent(TESSDATA_LSTM, &fp)) return nullptr;
+  Network* network = Network::CreateFromFile(&fp);
+  if (network == nullptr) return nullptr;
+  // A network that is training changes itself in Forward, so it can't be
+  // used by more than one recognizer.
+  if (network->IsTraining()) {
+    delete network;
+    return nullptr;
+  }
+  auto* shared = new SharedNetwork(network, fp.Offset());
+  network->SetRandomizer(&shared->randomizer);
+  network->CacheXScaleFactor(network->XScaleFactor());
+  // Does nothing to an int network.
+  if (float32_) network->ConvertToFloat32();
+  if (approx_softmax_) SetupApproxOutput(network);
+  return shared;
+}
 
 LSTMRecognizer::LSTMRecognizer()
     : network_(nullptr),
+      shared_network_(nullptr),
+      borrowed_network_(false),
       training_flags_(0),
       training_iteration_(0),
       sample_iteration_(0),
@@ -55,12 +162,28 @@ LSTMRecognizer::LSTMRecognizer()
       learning_rate_(0.0f),
       momentum_(0.0f),
       adam_beta_(0.0f),
+      max_blank_gap_(0.0),
+      greedy_decode_(false),
+      beam_collapse_margin_(0.0),
+      pipeline_decode_(false),
+      lattice_size_(0),
+      polarity_check_(false),
+      max_line_timesteps_(0),
+      num_wide_lines_(0),
+      output_cache_size_(0),
+      output_store_(nullptr),
+      model_hash_(0),
+      monitor_(nullptr),
       dict_(nullptr),
       search_(nullptr),
-      debug_win_(nullptr) {}
+      debug_win_(nullptr) {
+  // The layers use the scratch randomizer ahead of their own, which keeps
+  // a shared network from using the randomizer of another recognizer.
+  scratch_space_.set_randomizer(&randomizer_);
+}
 
 LSTMRecognizer::~LSTMRecognizer() {
-  delete network_;
+  FreeNetwork();
   delete dict_;
   delete search_;
 }
@@ -68,6 +191,7 @@ LSTMRecognizer::~LSTMRecognizer() {
 // Loads a model from mgr, including the dictionary only if lang is not null.
 bool LSTMRecognizer::Load(const ParamsVectors* params, const char* lang,
                           TessdataManager* mgr) {
+  SIMDDetect::FreezeMethod();
   TFile fp;
   if (!mgr->GetComponent(TESSDATA_LSTM, &fp)) return false;
   if (!DeSerialize(mgr, &fp)) return false;
@@ -77,6 +201,108 @@ bool LSTMRecognizer::Load(const ParamsVectors* params, const char* lang,
   return true;
 }
 
+// As Load, but shares the network with other LSTMRecognizers.
+bool LSTMRecognizer::LoadShared(const ParamsVectors* params, const char* lang,
+                                TessdataManager* mgr, bool float32,
+                                bool approx_softmax, int replica) {
+  // The shared network may be shaped for the selected code here.
+  SIMDDetect::FreezeMethod();
+  STRING data_id = mgr->GetDataFileName();
+  data_id += kTessdataFileSuffixes[TESSDATA_LSTM];
+  if (float32) data_id += ".float32";
+  if (approx_softmax) data_id += ".approx";
+  if (replica >= 0) data_id.add_str_int(".replica", replica);
+  NetworkLoader loader(mgr, float32, approx_softmax);
+  SharedNetwork* shared = GlobalNetworkCache()->Get(
+      data_id, NewTessCallback(&loader, &NetworkLoader::Load));
+  if (shared == nullptr) {
+    if (!Load(params, lang, mgr)) return false;
+    if (float32) ConvertToFloat32();
+    if (approx_softmax) SetupApproxSoftmax();
+    return true;
+  }
+  FreeNetwork();
+  network_ = shared->network;
+  shared_network_ = shared;
+  TFile fp;
+  if (!mgr->GetComponent(TESSDATA_LSTM, &fp)) return false;
+  if (!fp.Skip(shared->serialized_size)) return false;
+  if (!DeSerializeModel(mgr, &fp)) return false;
+  if (lang == nullptr) return true;
+  // Allow it to run without a dictionary.
+  LoadDictionary(params, lang, mgr);
+  return true;
+}
+
+void LSTMRecognizer::TuneKernels(TessdataManager* mgr) {
+  if (!SIMDDetect::AutotunePending()) return;
+  // DeSerialize doesn't freeze the selected code, as Load does.
+  LSTMRecognizer scratch;
+  TFile fp;
+  if (!mgr->GetComponent(TESSDATA_LSTM, &fp) || !scratch.DeSerialize(mgr, &fp)) {
+    return;
+  }
+  std::vector<std::pair<int, int>> shapes;
+  scratch.MatrixShapes(&shapes);
+  SIMDDetect::Autotune(shapes, scratch.IsIntMode());
+}
+
+// Sets up the output softmax to compute approximate outputs for inference.
+void LSTMRecognizer::SetupApproxSoftmax() {
+  ASSERT_HOST(OwnsNetwork());
+  SetupApproxOutput(network_);
+}
+
+void LSTMRecognizer::AddMemoryUsage(MemoryUsage* usage) const {
+  if (network_ != nullptr) network_->AddMemoryUsage(usage);
+  usage->Add(MEMORY_NETWORK_SCRATCH, scratch_space_.AllocatedBytes());
+  for (const auto& state : thread_states_) {
+    usage->Add(MEMORY_NETWORK_SCRATCH, state->scratch.AllocatedBytes());
+  }
+  if (dict_ != nullptr) dict_->AddMemoryUsage(usage);
+}
+
+NetworkCache* LSTMRecognizer::GlobalNetworkCache() {
+  // As Dict::GlobalDawgCache, this singleton outlives every Tesseract
+  // instance.
+  static NetworkCache cache;
+  return &cache;
+}
+
+// Makes *this recognize with the model of other, using its network.
+void LSTMRecognizer::ShareModel(const LSTMRecognizer& other) {
+  ASSERT_HOST(!other.network_->IsTraining());
+  FreeNetwork();
+  network_ = other.network_;
+  borrowed_network_ = true;
+  ccutil_.unicharset.CopyFrom(other.GetUnicharset());
+  recoder_ = other.recoder_;
+  network_str_ = other.network_str_;
+  training_flags_ = other.training_flags_;
+  training_iteration_ = other.training_iteration_;
+  sample_iteration_ = other.sample_iteration_;
+  null_char_ = other.null_char_;
+  adam_beta_ = other.adam_beta_;
+  learning_rate_ = other.learning_rate_;
+  momentum_ = other.momentum_;
+  model_hash_ = 0;
+  ClearOutputCache();
+  delete search_;
+  search_ = nullptr;
+}
+
+// Deletes the network, or releases it if it is shared or borrowed.
+void LSTMRecognizer::FreeNetwork() {
+  if (shared_network_ != nullptr) {
+    GlobalNetworkCache()->Free(shared_network_);
+    shared_network_ = nullptr;
+  } else if (!borrowed_network_) {
+    delete network_;
+  }
+  borrowed_network_ = false;
+  network_ = nullptr;
+}
+
 // Writes to the given file. Returns false in case of error.
 bool LSTMRecognizer::Serialize(const TessdataManager* mgr, TFile* fp) const {
   bool include_charsets = mgr == nullptr ||
@@ -98,9 +324,17 @@ bool LSTMRecognizer::Serialize(const TessdataManager* mgr, TFile* fp) const {
 
 // Reads from the given file. Returns false in case of error.
 bool LSTMRecognizer::DeSerialize(const TessdataManager* mgr, TFile* fp) {
-  delete network_;
+  FreeNetwork();
   network_ = Network::CreateFromFile(fp);
   if (network_ == nullptr) return false;
+  if (!DeSerializeModel(mgr, fp)) return false;
+  network_->SetRandomizer(&randomizer_);
+  network_->CacheXScaleFactor(network_->XScaleFactor());
+  return true;
+}
+
+// Reads everything after the network in the lstm component.
+bool LSTMRecognizer::DeSerializeModel(const TessdataManager* mgr, TFile* fp) {
   bool include_charsets = mgr == nullptr ||
                           !mgr->IsComponentAvailable(TESSDATA_LSTM_RECODER) ||
                           !mgr->IsComponentAvailable(TESSDATA_LSTM_UNICHARSET);
@@ -114,10 +348,10 @@ bool LSTMRecognizer::DeSerialize(const TessdataManager* mgr, TFile* fp) {
   if (!fp->DeSerialize(&adam_beta_)) return false;
   if (!fp->DeSerialize(&learning_rate_)) return false;
   if (!fp->DeSerialize(&momentum_)) return false;
+  model_hash_ = 0;
+  ClearOutputCache();
   if (include_charsets && !LoadRecoder(fp)) return false;
   if (!include_charsets && !LoadCharsets(mgr)) return false;
-  network_->SetRandomizer(&randomizer_);
-  network_->CacheXScaleFactor(network_->XScaleFactor());
   return true;
 }
 
@@ -133,6 +367,7 @@ bool LSTMRecognizer::LoadCharsets(const TessdataManager* mgr) {
 
 // Loads the Recoder.
 bool LSTMRecognizer::LoadRecoder(TFile* fp) {
+  InitPhase phase("lstm recoder");
   if (IsRecoding()) {
     if (!recoder_.DeSerialize(fp)) return false;
     RecodedCharID code;
@@ -158,6 +393,7 @@ bool LSTMRecognizer::LoadRecoder(TFile* fp) {
 // Some parameters have to be passed in (from langdata/config/api via Tesseract)
 bool LSTMRecognizer::LoadDictionary(const ParamsVectors* params,
                                     const char* lang, TessdataManager* mgr) {
+  InitPhase phase("lstm dictionary");
   delete dict_;
   dict_ = new Dict(&ccutil_);
   dict_->user_words_file.ResetFrom(params);
@@ -184,6 +420,7 @@ void LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
   NetworkIO outputs;
   float scale_factor;
   NetworkIO inputs;
+  scratch_space_.set_monitor(monitor_);
   if (!RecognizeLine(image_data, invert, debug, false, false, &scale_factor,
                      &inputs, &outputs))
     return;
@@ -191,12 +428,364 @@ void LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
     search_ =
         new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
   }
-  search_->Decode(outputs, kDictRatio, kCertOffset, worst_dict_cert,
-                  &GetUnicharset(), lstm_choice_mode);
+  DecodeLine(outputs, worst_dict_cert, lstm_choice_mode, search_);
+  if (search_->Cancelled()) return;
   search_->ExtractBestPathAsWords(line_box, scale_factor, debug,
                                   &GetUnicharset(), words, lstm_choice_mode);
 }
 
+void LSTMRecognizer::SetOutputCacheSize(int size) {
+  output_cache_size_ = size;
+  while (output_cache_.size() > static_cast<size_t>(std::max(size, 0))) {
+    output_cache_index_.erase(output_cache_.back().key.hash);
+    output_cache_.pop_back();
+    ++output_cache_stats_.evictions;
+  }
+}
+
+// Mixes value into the FNV-1a hash.
+static void MixHash(uint64_t value, uint64_t* hash) {
+  for (int b = 0; b < 8; ++b) {
+    *hash = (*hash ^ ((value >> (8 * b)) & 0xff)) * 1099511628211ull;
+  }
+}
+
+LineOutputKey LSTMRecognizer::OutputCacheKey(const ImageData& image_data,
+                                             bool invert) {
+  if (model_hash_ == 0) {
+    model_hash_ = 14695981039346656037ull;
+    STRING spec = network_->spec();
+    for (int i = 0; i < spec.length(); ++i) MixHash(spec[i], &model_hash_);
+    // The serialized network holds the weights, as int, double or float32.
+    GenericVector<char> weights;
+    TFile fp;
+    fp.OpenWrite(&weights);
+    if (network_->Serialize(&fp)) {
+      for (int i = 0; i < weights.size(); ++i) {
+        model_hash_ = (model_hash_ ^ static_cast<uint8_t>(weights[i])) *
+                      1099511628211ull;
+      }
+    }
+    MixHash(IsIntMode(), &model_hash_);
+    MixHash(network_->NumOutputs(), &model_hash_);
+    MixHash(training_iteration_, &model_hash_);
+    MixHash(sample_iteration_, &model_hash_);
+  }
+  LineOutputKey key;
+  key.settings = model_hash_;
+  MixHash(invert, &key.settings);
+  MixHash(polarity_check_, &key.settings);
+  MixHash(static_cast<uint64_t>(max_blank_gap_ * 1000), &key.settings);
+  key.image = image_data.Fingerprint();
+  key.hash = key.settings;
+  MixHash(key.image.hash, &key.hash);
+  return key;
+}
+
+// As RecognizeLine, but keeps the network outputs of the last lines, keyed
+// by their pixels, to decode them again when the same pixels
+// come back, as they do when a word is recognized again after its first
+// results were thrown away, or when a page repeats a line or another page.
+void LSTMRecognizer::RecognizeLineCached(const ImageData& image_data,
+                                         bool invert, bool debug,
+                                         double worst_dict_cert,
+                                         const TBOX& line_box,
+                                         PointerVector<WERD_RES>* words,
+                                         int lstm_choice_mode) {
+  if ((output_cache_size_ <= 0 && output_store_ == nullptr) || debug ||
+      network_->IsTraining()) {
+    RecognizeLine(image_data, invert, debug, worst_dict_cert, line_box, words,
+                  lstm_choice_mode);
+    return;
+  }
+  if (search_ == nullptr) {
+    search_ =
+        new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+  }
+  LineOutputKey key = OutputCacheKey(image_data, invert);
+  auto found = output_cache_index_.find(key.hash);
+  if (found != output_cache_index_.end() && !(found->second->key == key)) {
+    // Another line with the same hash: replace it.
+    output_cache_.erase(found->second);
+    output_cache_index_.erase(found);
+    found = output_cache_index_.end();
+  }
+  if (found != output_cache_index_.end()) {
+    ++output_cache_stats_.hits;
+    // Move to the front, as the most recently used.
+    output_cache_.splice(output_cache_.begin(), output_cache_, found->second);
+    const CachedOutputs& cached = output_cache_.front();
+    DecodeLine(cached.outputs, worst_dict_cert, lstm_choice_mode, search_);
+    if (search_->Cancelled()) return;
+    search_->ExtractBestPathAsWords(line_box, cached.scale_factor, debug,
+                                    &GetUnicharset(), words, lstm_choice_mode);
+    return;
+  }
+  CachedOutputs entry;
+  entry.key = key;
+  bool stored = output_store_ != nullptr &&
+                output_store_->Lookup(key, &entry.outputs, &entry.scale_factor);
+  if (stored) {
+    ++output_cache_stats_.store_hits;
+  } else {
+    ++output_cache_stats_.misses;
+    NetworkIO inputs;
+    scratch_space_.set_monitor(monitor_);
+    if (!RecognizeLine(image_data, invert, debug, false, false,
+                       &entry.scale_factor, &inputs, &entry.outputs))
+      return;
+  }
+  DecodeLine(entry.outputs, worst_dict_cert, lstm_choice_mode, search_);
+  // Cancelled outputs may be incomplete, so they are not kept.
+  if (search_->Cancelled()) return;
+  search_->ExtractBestPathAsWords(line_box, entry.scale_factor, debug,
+                                  &GetUnicharset(), words, lstm_choice_mode);
+  if (output_store_ != nullptr && !stored) {
+    output_store_->Store(key, entry.outputs, entry.scale_factor);
+  }
+  if (output_cache_size_ <= 0) return;
+  if (output_cache_.size() >= static_cast<size_t>(output_cache_size_)) {
+    output_cache_index_.erase(output_cache_.back().key.hash);
+    output_cache_.pop_back();
+    ++output_cache_stats_.evictions;
+  }
+  output_cache_.push_front(std::move(entry));
+  output_cache_index_[key.hash] = output_cache_.begin();
+}
+
+// Recognizes the batch of images, as RecognizeLine does for each of them,
+// but runs up to batch_size lines of similar size through the network at
+// once, with up to num_threads batches running concurrently. Lines that need
+// the auto inversion check fall back to recognizing them on their own.
+void LSTMRecognizer::RecognizeLines(
+    const std::vector<const ImageData*>& images, int batch_size,
+    int num_threads, bool invert, bool debug, double worst_dict_cert,
+    const std::vector<TBOX>& line_boxes,
+    const std::vector<PointerVector<WERD_RES>*>& words,
+    int lstm_choice_mode) {
+  if (batch_size < 1) batch_size = 1;
+  num_threads = NumThreads(1, num_threads);
+  scratch_space_.set_monitor(monitor_);
+  for (auto& state : thread_states_) state->scratch.set_monitor(monitor_);
+  if (debug || network_->IsTraining() ||
+      (batch_size == 1 && num_threads == 1 && !pipeline_decode_)) {
+    // Debug display and training only work one line at a time.
+    for (size_t i = 0; i < images.size(); ++i) {
+      RecognizeLine(*images[i], invert, debug, worst_dict_cert, line_boxes[i],
+                    words[i], lstm_choice_mode);
+    }
+    return;
+  }
+  int min_width = network_->XScaleFactor();
+  std::vector<Pix*> pixes(images.size(), nullptr);
+  std::vector<float> scale_factors(images.size());
+  std::vector<std::vector<int>> timestep_maps(images.size());
+  // Only the lines whose polarity is unsure get the auto inversion check.
+  std::vector<LinePolarityType> polarities(images.size(), LP_UNSURE);
+  std::vector<int> order;
+  for (size_t i = 0; i < images.size(); ++i) {
+    // This ensures consistent recognition results.
+    SetRandomSeed();
+    pixes[i] = Input::PrepareLSTMInputs(*images[i], network_, min_width,
+                                        &randomizer_, &scale_factors[i]);
+    if (pixes[i] == nullptr) {
+      tprintf("Line cannot be recognized!!\n");
+      continue;
+    }
+    if (invert && polarity_check_) {
+      polarities[i] = LinePolarity(pixes[i]);
+      if (polarities[i] == LP_INVERTED) pixInvert(pixes[i], pixes[i]);
+    }
+    CompressBlankGaps(&pixes[i], &timestep_maps[i]);
+    // Reduction factor from image to coords.
+    scale_factors[i] = min_width / scale_factors[i];
+    order.push_back(i);
+  }
+  // Sort by size, so that similar lines end up in the same batch.
+  std::stable_sort(order.begin(), order.end(), [&pixes](int a, int b) {
+    int height_a = pixGetHeight(pixes[a]);
+    int height_b = pixGetHeight(pixes[b]);
+    if (height_a != height_b) return height_a < height_b;
+    return pixGetWidth(pixes[a]) < pixGetWidth(pixes[b]);
+  });
+  // Start (in order) of each batch, with a final end.
+  std::vector<size_t> batch_starts;
+  size_t start = 0;
+  while (start < order.size()) {
+    batch_starts.push_back(start);
+    Pix* first = pixes[order[start]];
+    ++start;
+    while (start < order.size() &&
+           static_cast<int>(start - batch_starts.back()) < batch_size &&
+           pixGetHeight(pixes[order[start]]) == pixGetHeight(first) &&
+           pixGetWidth(pixes[order[start]]) <=
+               pixGetWidth(first) * kMaxBatchWidthRatio) {
+      ++start;
+    }
+  }
+  batch_starts.push_back(order.size());
+  int num_batches = batch_starts.size() - 1;
+  if (num_threads > num_batches) num_threads = std::max(num_batches, 1);
+#ifdef _OPENMP
+  // With pipelining, one more thread decodes the outputs of the others.
+  int num_decoders = pipeline_decode_ && num_batches > 1 ? 1 : 0;
+#else
+  int num_decoders = 0;
+#endif
+  int team_size = num_threads + num_decoders;
+  // Each thread gets its own scratch space, randomizer and beam search, and
+  // shares the network, which is left unchanged by inference. Thread 0 uses
+  // the members, as when running a line at a time.
+  if (search_ == nullptr) {
+    search_ =
+        new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
+  }
+  while (static_cast<int>(thread_states_.size()) < team_size - 1) {
+    auto* state = new ThreadState;
+    // Each thread is already one of many, so it runs the layers serially.
+    state->scratch.set_num_threads(1);
+    state->scratch.set_randomizer(&state->randomizer);
+    state->scratch.set_monitor(monitor_);
+    state->search.reset(
+        new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_));
+    thread_states_.emplace_back(state);
+  }
+  std::vector<RecodeBeamSearch*> thread_searches(team_size, search_);
+  std::vector<NetworkScratch*> scratches(team_size, &scratch_space_);
+  std::vector<TRand*> randomizers(team_size, &randomizer_);
+  for (int i = 1; i < team_size; ++i) {
+    ThreadState* state = thread_states_[i - 1].get();
+    scratches[i] = &state->scratch;
+    randomizers[i] = &state->randomizer;
+    thread_searches[i] = state->search.get();
+  }
+  // The threads of the team count their work for the engine of this one.
+  Counters* counters = Counters::current();
+  // Runs the network on batch b, putting the result in outputs.
+  auto forward_batch = [&](int b, int thread_id, NetworkIO* outputs) {
+    ScopedCounters counting(counters);
+    std::vector<const Pix*> batch;
+    for (size_t i = batch_starts[b]; i < batch_starts[b + 1]; ++i) {
+      batch.push_back(pixes[order[i]]);
+    }
+    NetworkIO inputs;
+    inputs.set_int_mode(IsIntMode());
+    // The padding of the narrower lines is never used, so it gets its own
+    // randomizer, leaving randomizer in the same state as for a single line.
+    TRand padding_randomizer;
+    Input::PreparePixesInput(network_->InputShape(), batch,
+                             &padding_randomizer, &inputs);
+    SetRandomSeed(randomizers[thread_id]);
+    TraceSpan span("LSTM forward");
+    network_->Forward(false, inputs, nullptr, scratches[thread_id], outputs);
+  };
+  // Decodes the lines of batch b from the outputs of forward_batch.
+  auto decode_batch = [&](int b, int thread_id, const NetworkIO& outputs) {
+    ScopedCounters counting(counters);
+    NetworkScratch* scratch = scratches[thread_id];
+    TRand* randomizer = randomizers[thread_id];
+    RecodeBeamSearch* search = thread_searches[thread_id];
+    for (size_t i = batch_starts[b]; i < batch_starts[b + 1]; ++i) {
+      // Once cancelled, the outputs are no use, and the lines get no words.
+      if (scratch->Cancelled()) break;
+      int line = order[i];
+      NetworkIO line_inputs, line_outputs;
+      float scale_factor = scale_factors[line];
+      line_outputs.CopyBatchElement(outputs, i - batch_starts[b]);
+      float pos_min, pos_mean, pos_sd;
+      OutputStats(line_outputs, &pos_min, &pos_mean, &pos_sd);
+      if (invert && polarities[line] == LP_UNSURE && pos_min < 0.5) {
+        if (!RecognizeLine(*images[line], invert, false, false, false,
+                           &scale_factor, &line_inputs, &line_outputs, scratch,
+                           randomizer)) {
+          // It may be better inverted, but that can't be checked.
+          continue;
+        }
+      } else if (!timestep_maps[line].empty()) {
+        NetworkIO cut_outputs(line_outputs);
+        line_outputs.CopyWithTimestepMap(cut_outputs, timestep_maps[line]);
+      }
+      DecodeLine(line_outputs, worst_dict_cert, lstm_choice_mode, search);
+      if (search->Cancelled()) break;
+      search->ExtractBestPathAsWords(line_boxes[line], scale_factor, false,
+                                     &GetUnicharset(), words[line],
+                                     lstm_choice_mode);
+    }
+  };
+  if (num_decoders == 0) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+    for (int b = 0; b < num_batches; ++b) {
+      int thread_id = omp_get_thread_num();
+#else
+    for (int b = 0; b < num_batches; ++b) {
+      int thread_id = 0;
+#endif
+      NetworkIO outputs;
+      forward_batch(b, thread_id, &outputs);
+      decode_batch(b, thread_id, outputs);
+    }
+  } else {
+#ifdef _OPENMP
+    // The last thread of the team decodes the batches in the order that the
+    // others finish them, and holds them up if it falls too far behind, as
+    // the outputs of each batch are kept until decoded.
+    std::vector<std::unique_ptr<NetworkIO>> batch_outputs(num_batches);
+    std::deque<int> ready;
+    std::mutex mutex;
+    std::condition_variable changed;
+    int next_batch = 0;
+    size_t max_ready = 2 * num_threads;
+#pragma omp parallel num_threads(team_size)
+    {
+      int thread_id = omp_get_thread_num();
+      // The team may be smaller than asked for, even a single thread, which
+      // then has to do everything.
+      int team = omp_get_num_threads();
+      if (team > 1 && thread_id == team - 1) {
+        for (int done = 0; done < num_batches; ++done) {
+          int b;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&ready] { return !ready.empty(); });
+            b = ready.front();
+            ready.pop_front();
+          }
+          changed.notify_all();
+          decode_batch(b, thread_id, *batch_outputs[b]);
+          batch_outputs[b].reset();
+        }
+      } else {
+        for (;;) {
+          int b;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] {
+              return team == 1 || ready.size() < max_ready;
+            });
+            if (next_batch >= num_batches) break;
+            b = next_batch++;
+          }
+          batch_outputs[b].reset(new NetworkIO);
+          forward_batch(b, thread_id, batch_outputs[b].get());
+          if (team == 1) {
+            decode_batch(b, thread_id, *batch_outputs[b]);
+            batch_outputs[b].reset();
+            continue;
+          }
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(b);
+          }
+          changed.notify_all();
+        }
+      }
+    }
+#endif
+  }
+  for (auto& pix : pixes) pixDestroy(&pix);
+}
+
 // Helper computes min and mean best results in the output.
 void LSTMRecognizer::OutputStats(const NetworkIO& outputs, float* min_output,
                                  float* mean_output, float* sd) {
@@ -228,30 +817,99 @@ bool LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
                                    bool debug, bool re_invert, bool upside_down,
                                    float* scale_factor, NetworkIO* inputs,
                                    NetworkIO* outputs) {
-  // Maximum width of image to train on.
-  const int kMaxImageWidth = 2560;
+  return RecognizeLine(image_data, invert, debug, re_invert, upside_down,
+                       scale_factor, inputs, outputs, &scratch_space_,
+                       &randomizer_);
+}
+
+// Returns the sum of the outputs of the layers of network.
+static int64_t SumLayerOutputs(const Network* network) {
+  if (!network->IsPlumbingType()) return network->NumOutputs();
+  int64_t sum = 0;
+  const auto* plumbing = static_cast<const Plumbing*>(network);
+  for (int i = 0; i < plumbing->stack().size(); ++i)
+    sum += SumLayerOutputs(plumbing->stack()[i]);
+  return sum;
+}
+
+int64_t LSTMRecognizer::BytesPerTimestep() const {
+  // The outputs are counted as floats, and twice, as a layer has its inputs
+  // and outputs at once.
+  return 2 * SumLayerOutputs(network_) * sizeof(float) +
+         RecodeBeamSearch::MaxBytesPerTimestep();
+}
+
+// Runs the float network on up to max_lines lines of data to calibrate the
+// int ranges of its layers.
+int LSTMRecognizer::CalibrateIntRanges(DocumentCache* data, int max_lines) {
+  ASSERT_HOST(OwnsNetwork() && !IsIntMode());
+  int num_lines = std::min(data->TotalPages(), max_lines);
+  int num_run = 0;
+  network_->SetCalibrating(true);
+  for (int i = 0; i < num_lines; ++i) {
+    const ImageData* line = data->GetPageBySerial(i);
+    if (line == nullptr) continue;
+    float scale_factor;
+    NetworkIO inputs, outputs;
+    if (RecognizeLine(*line, false, false, false, false, &scale_factor,
+                      &inputs, &outputs)) {
+      ++num_run;
+    }
+  }
+  network_->SetCalibrating(false);
+  return num_run;
+}
+
+// As RecognizeLine above, but using the given scratch space and randomizer.
+bool LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
+                                   bool debug, bool re_invert, bool upside_down,
+                                   float* scale_factor, NetworkIO* inputs,
+                                   NetworkIO* outputs, NetworkScratch* scratch,
+                                   TRand* randomizer) {
+  TraceSpan span("LSTM forward");
   // This ensures consistent recognition results.
-  SetRandomSeed();
+  SetRandomSeed(randomizer);
   int min_width = network_->XScaleFactor();
   Pix* pix = Input::PrepareLSTMInputs(image_data, network_, min_width,
-                                      &randomizer_, scale_factor);
+                                      randomizer, scale_factor);
   if (pix == nullptr) {
     tprintf("Line cannot be recognized!!\n");
     return false;
   }
-  if (network_->IsTraining() && pixGetWidth(pix) > kMaxImageWidth) {
+  if (network_->IsTraining() && pixGetWidth(pix) > kMaxTrainingImageWidth) {
     tprintf("Image too large to learn!! Size = %dx%d\n", pixGetWidth(pix),
             pixGetHeight(pix));
     pixDestroy(&pix);
     return false;
   }
   if (upside_down) pixRotate180(pix, pix);
+  if (invert && polarity_check_) {
+    // Only a line whose polarity is unsure gets the auto inversion check.
+    LinePolarityType polarity = LinePolarity(pix);
+    if (polarity == LP_INVERTED) pixInvert(pix, pix);
+    if (polarity != LP_UNSURE) invert = false;
+  }
+  // The outputs are mapped back over any cut gaps below.
+  std::vector<int> timestep_map;
+  if (!debug) CompressBlankGaps(&pix, &timestep_map);
+  if (max_line_timesteps_ > 0 && !network_->IsTraining() &&
+      pixGetWidth(pix) / min_width > max_line_timesteps_) {
+    tprintf("Line too wide to recognize!! %d timesteps > %d\n",
+            pixGetWidth(pix) / min_width, max_line_timesteps_);
+    num_wide_lines_.fetch_add(1, std::memory_order_relaxed);
+    pixDestroy(&pix);
+    return false;
+  }
   // Reduction factor from image to coords.
   *scale_factor = min_width / *scale_factor;
   inputs->set_int_mode(IsIntMode());
-  SetRandomSeed();
-  Input::PreparePixInput(network_->InputShape(), pix, &randomizer_, inputs);
-  network_->Forward(debug, *inputs, nullptr, &scratch_space_, outputs);
+  SetRandomSeed(randomizer);
+  Input::PreparePixInput(network_->InputShape(), pix, randomizer, inputs);
+  network_->Forward(debug, *inputs, nullptr, scratch, outputs);
+  if (scratch->Cancelled()) {
+    pixDestroy(&pix);
+    return false;
+  }
   // Check for auto inversion.
   float pos_min, pos_mean, pos_sd;
   OutputStats(*outputs, &pos_min, &pos_mean, &pos_sd);
@@ -259,12 +917,11 @@ bool LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
     // Run again inverted and see if it is any better.
     NetworkIO inv_inputs, inv_outputs;
     inv_inputs.set_int_mode(IsIntMode());
-    SetRandomSeed();
+    SetRandomSeed(randomizer);
     pixInvert(pix, pix);
-    Input::PreparePixInput(network_->InputShape(), pix, &randomizer_,
+    Input::PreparePixInput(network_->InputShape(), pix, randomizer,
                            &inv_inputs);
-    network_->Forward(debug, inv_inputs, nullptr, &scratch_space_,
-                      &inv_outputs);
+    network_->Forward(debug, inv_inputs, nullptr, scratch, &inv_outputs);
     float inv_min, inv_mean, inv_sd;
     OutputStats(inv_outputs, &inv_min, &inv_mean, &inv_sd);
     if (inv_min > pos_min && inv_mean > pos_mean && inv_sd < pos_sd) {
@@ -278,11 +935,16 @@ bool LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
     } else if (re_invert) {
       // Inverting was not an improvement, so undo and run again, so the
       // outputs match the best forward result.
-      SetRandomSeed();
-      network_->Forward(debug, *inputs, nullptr, &scratch_space_, outputs);
+      SetRandomSeed(randomizer);
+      network_->Forward(debug, *inputs, nullptr, scratch, outputs);
     }
   }
   pixDestroy(&pix);
+  if (scratch->Cancelled()) return false;
+  if (!timestep_map.empty()) {
+    NetworkIO cut_outputs(*outputs);
+    outputs->CopyWithTimestepMap(cut_outputs, timestep_map);
+  }
   if (debug) {
     GenericVector<int> labels, coords;
     LabelsFromOutputs(*outputs, &labels, &coords);
@@ -292,6 +954,46 @@ bool LSTMRecognizer::RecognizeLine(const ImageData& image_data, bool invert,
   return true;
 }
 
+// Decodes the outputs of a line with the given search, with the beam search
+// or greedily, as set by SetGreedyDecode and SetBeamCollapseMargin.
+void LSTMRecognizer::DecodeLine(const NetworkIO& outputs,
+                                double worst_dict_cert, int lstm_choice_mode,
+                                RecodeBeamSearch* search) {
+  TraceSpan span("LSTM decode");
+  CountEvent(COUNTER_TEXTLINES);
+  CountEvent(COUNTER_LSTM_TIMESTEPS, outputs.Width());
+  if (greedy_decode_ && dict_ == nullptr && lstm_choice_mode == 0 &&
+      lattice_size_ == 0) {
+    search->DecodeGreedy(outputs, kDictRatio, kCertOffset, &GetUnicharset());
+  } else {
+    search->SetCollapseMargin(beam_collapse_margin_);
+    search->SetLatticeSize(lattice_size_);
+    search->SetMonitor(monitor_);
+    search->Decode(outputs, kDictRatio, kCertOffset, worst_dict_cert,
+                   &GetUnicharset(), lstm_choice_mode);
+  }
+}
+
+// Cuts down the wide blank gaps in *pix, scaled for the network, as set by
+// SetMaxBlankGap, replacing *pix if anything was cut. timestep_map is set
+// as by Input::CompressBlankColumns, or cleared if nothing was cut.
+void LSTMRecognizer::CompressBlankGaps(Pix** pix,
+                                       std::vector<int>* timestep_map) const {
+  timestep_map->clear();
+  // The outputs can only be mapped back if they are a single row.
+  if (max_blank_gap_ <= 0.0 || network_->IsTraining() ||
+      network_->OutputShape(network_->InputShape()).height() != 1) {
+    return;
+  }
+  int max_gap_width = IntCastRounded(max_blank_gap_ * pixGetHeight(*pix));
+  Pix* cut_pix = Input::CompressBlankColumns(*pix, network_->XScaleFactor(),
+                                             max_gap_width, timestep_map);
+  if (cut_pix != nullptr) {
+    pixDestroy(pix);
+    *pix = cut_pix;
+  }
+}
+
 // Converts an array of labels to utf-8, whether or not the labels are
 // augmented with character boundaries.
 STRING LSTMRecognizer::DecodeLabels(const GenericVector<int>& labels) {
@@ -441,6 +1143,8 @@ void LSTMRecognizer::LabelsViaReEncode(const NetworkIO& output,
     search_ =
         new RecodeBeamSearch(recoder_, null_char_, SimpleTextOutput(), dict_);
   }
+  // The labels are for training and debugging, which need the whole line.
+  search_->SetMonitor(nullptr);
   search_->Decode(output, 1.0, 0.0, RecodeBeamSearch::kMinCertainty, nullptr);
   search_->ExtractBestPathAsLabels(labels, xcoords);
 }
@@ -19,15 +19,23 @@
 #ifndef TESSERACT_LSTM_LSTMRECOGNIZER_H_
 #define TESSERACT_LSTM_LSTMRECOGNIZER_H_
 
+#include <atomic>  // for std::atomic
+#include <cstdint>  // for uint64_t
+#include <list>  // for std::list
+#include <memory>  // for std::unique_ptr
+#include <unordered_map>  // for std::unordered_map
+#include <vector>  // for std::vector
 #include "ccutil.h"
 #include "helpers.h"
 #include "imagedata.h"
 #include "matrix.h"
 #include "network.h"
 #include "networkscratch.h"
+#include "object_cache.h"
 #include "params.h"
 #include "recodebeam.h"
 #include "series.h"
+#include "simddetect.h"
 #include "strngs.h"
 #include "unicharcompress.h"
 
@@ -49,6 +57,65 @@ enum TrainingFlags {
   TF_COMPRESS_UNICHARSET = 64,
 };
 
+// Maximum width of image to train on.
+const int kMaxTrainingImageWidth = 2560;
+
+// A network that LSTMRecognizers loaded from the same traineddata share
+// through the NetworkCache, as inference never changes it.
+struct SharedNetwork {
+  SharedNetwork(Network* net, int size)
+      : network(net), serialized_size(size) {}
+  ~SharedNetwork() {
+    delete network;
+  }
+
+  Network* network;
+  // Number of bytes of the network at the start of the lstm component.
+  int serialized_size;
+  // The network's own randomizer, only used if the NetworkScratch has none.
+  TRand randomizer;
+};
+
+using NetworkCache = ObjectCache<SharedNetwork>;
+
+// Counts of the lookups in the output cache of LSTMRecognizer.
+struct OutputCacheStats {
+  int64_t hits = 0;        // Found in the recognizer's own cache.
+  int64_t store_hits = 0;  // Found in the OutputStore only.
+  int64_t misses = 0;      // The network had to run.
+  int64_t evictions = 0;   // Dropped to keep the cache within its size.
+};
+
+// Key of the network outputs of a line in the output cache of LSTMRecognizer
+// and in an OutputStore. Entries are indexed by hash, but the whole key is
+// compared on a hit, so a hash that matches by chance is not trusted.
+struct LineOutputKey {
+  uint64_t hash = 0;      // Of settings and image.
+  uint64_t settings = 0;  // Of the model, its weights and the settings.
+  ImageFingerprint image;
+
+  bool operator==(const LineOutputKey& other) const {
+    return hash == other.hash && settings == other.settings &&
+           image == other.image;
+  }
+};
+
+// External store of network outputs, keyed as the output cache of
+// LSTMRecognizer is, by the line image, the model and the settings that
+// change the outputs. It may be shared by many recognizers and outlive them,
+// so implementations must be thread-safe.
+class OutputStore {
+ public:
+  virtual ~OutputStore() = default;
+  // Returns true and fills outputs and scale_factor if key is stored.
+  // Implementations may index by key.hash, but must compare the whole key.
+  virtual bool Lookup(const LineOutputKey& key, NetworkIO* outputs,
+                      float* scale_factor) = 0;
+  // Stores a copy of outputs and scale_factor under key.
+  virtual void Store(const LineOutputKey& key, const NetworkIO& outputs,
+                     float scale_factor) = 0;
+};
+
 // Top-level line recognizer class for LSTM-based networks.
 // Note that a sub-class, LSTMTrainer is used for training.
 class LSTMRecognizer {
@@ -120,13 +187,61 @@ class LSTMRecognizer {
     series->ScaleLayerLearningRate(&id[1], factor);
   }
 
+  // Runs the float network on up to max_lines lines of data, so that the
+  // next ConvertToInt quantizes the activations of each layer to the range
+  // that they use on those lines, instead of [-1, 1]. Returns the number of
+  // lines that were run.
+  int CalibrateIntRanges(DocumentCache* data, int max_lines);
   // Converts the network to int if not already.
   void ConvertToInt() {
+    ASSERT_HOST(OwnsNetwork());
     if ((training_flags_ & TF_INT_MODE) == 0) {
-      network_->ConvertToInt();
+      network_->ConvertToInt(1.0f);
       training_flags_ |= TF_INT_MODE;
     }
   }
+  // Returns true if the network still has its training data, which it
+  // serializes with its weights.
+  bool HasTrainingData() const { return network_->IsTraining(); }
+  // Permanently disables training, so that the network is serialized as a
+  // recognizer, without its training data.
+  void StripTrainingData() {
+    ASSERT_HOST(OwnsNetwork());
+    network_->SetEnableTraining(TS_DISABLED);
+  }
+  // Converts a float network to single precision for faster inference.
+  // The conversion isn't recorded in training_flags_, as it is not a training
+  // mode, and the network is still serialized as double.
+  void ConvertToFloat32() {
+    ASSERT_HOST(OwnsNetwork());
+    if (!IsIntMode()) network_->ConvertToFloat32();
+  }
+  // Prunes the given fraction of the smallest blocks of each weight matrix,
+  // for fine-tuning by further training, after which the int or float32
+  // converted network skips them. Returns the number of pruned blocks.
+  int PruneWeights(double fraction) {
+    ASSERT_HOST(OwnsNetwork() && !IsIntMode());
+    return network_->PruneWeights(fraction);
+  }
+  // Sets up the output softmax to skip computing most of the low scoring
+  // outputs, for faster inference with a large unicharset, at some cost in
+  // accuracy. See FullyConnected::SetupApproxSoftmax.
+  void SetupApproxSoftmax();
+  // Appends the (outputs, inputs) shapes of the weight matrices used by the
+  // network.
+  void MatrixShapes(std::vector<std::pair<int, int>>* shapes) const {
+    network_->MatrixShapes(shapes);
+  }
+  // Adds the bytes of the weights, of the scratch space of all the threads
+  // and of the dawgs of the dictionary to usage. Weights that LoadShared
+  // shares with other recognizers are added by each of them.
+  void AddMemoryUsage(MemoryUsage* usage) const;
+  // Selects the fastest SIMD code for the weight matrices of the network in
+  // mgr, if requested by the dotproduct config variable. The timing runs on
+  // scratch matrices, so it must be called before the first Load or
+  // LoadShared, which shape the weights for the selected code.
+  // See SIMDDetect::Autotune.
+  static void TuneKernels(TessdataManager* mgr);
 
   // Provides access to the UNICHARSET that this classifier works with.
   const UNICHARSET& GetUnicharset() const { return ccutil_.unicharset; }
@@ -134,17 +249,137 @@ class LSTMRecognizer {
   const UnicharCompress& GetRecoder() const { return recoder_; }
   // Provides access to the Dict that this classifier works with.
   const Dict* GetDict() const { return dict_; }
+  Dict* GetDict() { return dict_; }
   // Sets the sample iteration to the given value. The sample_iteration_
   // determines the seed for the random number generator. The training
   // iteration is incremented only by a successful training iteration.
   void SetIteration(int iteration) { sample_iteration_ = iteration; }
+  // Sets the number of threads used by the network's internal parallel
+  // operations. 0 selects the built-in defaults. See NumThreads.
+  void SetNumThreads(int num_threads) {
+    scratch_space_.set_num_threads(num_threads);
+  }
+  // Sets the max width of blank gaps in the text lines, as a multiple of the
+  // line height, that are run through the network for inference. Wider gaps
+  // are cut down first, and the outputs mapped back to the whole line, which
+  // saves time on sparse lines. 0 keeps all the gaps.
+  void SetMaxBlankGap(double max_blank_gap) {
+    max_blank_gap_ = max_blank_gap;
+  }
+  // Sets whether lines are decoded with RecodeBeamSearch::DecodeGreedy,
+  // which is much faster than the beam search, at some cost in accuracy. It
+  // is only used when there is no dictionary and lstm_choice_mode is 0.
+  void SetGreedyDecode(bool greedy_decode) {
+    greedy_decode_ = greedy_decode;
+  }
+  // Sets the min margin between the best two outputs of a timestep at which
+  // the beam search keeps only its best paths. See
+  // RecodeBeamSearch::SetCollapseMargin. 0 keeps the full beam.
+  void SetBeamCollapseMargin(double margin) {
+    beam_collapse_margin_ = margin;
+  }
+  // Sets whether RecognizeLines decodes the batches on a thread of its own,
+  // while the others run the network on the next batches, instead of each
+  // thread decoding the batches that it ran. Needs OpenMP.
+  void SetPipelineDecode(bool pipeline_decode) {
+    pipeline_decode_ = pipeline_decode;
+  }
+  // Sets the number of nodes of each timestep of the beam search to keep in
+  // the lattice of the words. See RecodeBeamSearch::SetLatticeSize. A lattice
+  // needs the beam search, so it disables the greedy decoding.
+  void SetLatticeSize(int size) {
+    lattice_size_ = size;
+  }
+  // Sets whether the lines to be recognized with invert first get a cheap
+  // check of their grey levels, so that only the lines whose polarity it
+  // can't tell get the auto inversion check, which runs the network again
+  // on an inverted copy of the line. The lines that it finds inverted are
+  // inverted up front.
+  void SetPolarityCheck(bool polarity_check) {
+    polarity_check_ = polarity_check;
+  }
+  // Sets the max width of a line in timesteps of the network, after any
+  // blank gaps are cut down. RecognizeLine fails on wider lines, which would
+  // take the network and the beam search long, without trying them, as if
+  // they were cancelled. 0 for no limit.
+  void SetMaxLineTimesteps(int max_timesteps) {
+    max_line_timesteps_ = max_timesteps;
+  }
+  // Returns an estimate of the most memory that recognizing a line takes
+  // per timestep: the outputs of all the layers and a full beam search step.
+  int64_t BytesPerTimestep() const;
+  // Returns the number of lines that were too wide to recognize, as set by
+  // SetMaxLineTimesteps, since the last ResetNumWideLines.
+  int num_wide_lines() const {
+    return num_wide_lines_.load(std::memory_order_relaxed);
+  }
+  void ResetNumWideLines() {
+    num_wide_lines_.store(0, std::memory_order_relaxed);
+  }
+  // Sets the number of lines whose network outputs RecognizeLineCached keeps
+  // for reuse, dropping the least recently used beyond it. 0 keeps none.
+  void SetOutputCacheSize(int size);
+  // Drops the network outputs kept by RecognizeLineCached.
+  void ClearOutputCache() {
+    output_cache_.clear();
+    output_cache_index_.clear();
+  }
+  // Returns the counts of the lookups made by RecognizeLineCached.
+  const OutputCacheStats& output_cache_stats() const {
+    return output_cache_stats_;
+  }
+  // Sets the store that RecognizeLineCached looks in when its own cache
+  // misses, and that it adds new outputs to. nullptr for none. Not owned.
+  void SetOutputStore(OutputStore* store) {
+    output_store_ = store;
+  }
+  // Sets the monitor whose deadline and cancel function stop the network and
+  // the beam search in the middle of a line, which then gets no words.
+  // nullptr for none. Not owned.
+  void SetMonitor(const ETEXT_DESC* monitor) {
+    monitor_ = monitor;
+    scratch_space_.set_monitor(monitor);
+    for (auto& state : thread_states_) state->scratch.set_monitor(monitor);
+  }
+  // Returns the number of heap allocations made for the network scratch
+  // buffers since construction, over all the threads of RecognizeLines.
+  // Once the buffers are big enough for the lines, it stops changing.
+  int NumScratchAllocations() const {
+    int count = scratch_space_.num_allocations();
+    for (const auto& state : thread_states_) {
+      count += state->scratch.num_allocations();
+    }
+    return count;
+  }
   // Accessors for textline image normalization.
   int NumInputs() const { return network_->NumInputs(); }
+  int XScaleFactor() const { return network_->XScaleFactor(); }
   int null_char() const { return null_char_; }
 
   // Loads a model from mgr, including the dictionary only if lang is not null.
   bool Load(const ParamsVectors* params, const char* lang,
             TessdataManager* mgr);
+  // As Load, but the network is shared with every other LSTMRecognizer that
+  // was loaded by LoadShared from the same traineddata and flags, so many
+  // instances of the same model only hold one copy of the weights. float32
+  // and approx_softmax are applied to the shared network as by
+  // ConvertToFloat32 and SetupApproxSoftmax. The network may then only be
+  // used for inference, and not converted or trained.
+  // Falls back to a private copy if the network can't be shared.
+  // If replica >= 0, the network is only shared with the recognizers of the
+  // same replica, so that the engines pinned to each NUMA node can have a
+  // copy of their own, loaded (and so placed) by the first of them.
+  bool LoadShared(const ParamsVectors* params, const char* lang,
+                  TessdataManager* mgr, bool float32, bool approx_softmax,
+                  int replica = -1);
+  // Returns the cache of networks shared by LoadShared.
+  static NetworkCache* GlobalNetworkCache();
+  // Makes *this recognize with the model of other, using the network of other
+  // instead of a copy of its own, so that several recognizers, each with its
+  // own scratch space, can run the one network on different threads at once.
+  // other must outlive *this, and its network must not be training, as a
+  // training network changes itself in Forward. The dictionary is not shared.
+  void ShareModel(const LSTMRecognizer& other);
 
   // Writes to the given file. Returns false in case of error.
   // If mgr contains a unicharset and recoder, then they are not encoded to fp.
@@ -176,6 +411,26 @@ class LSTMRecognizer {
   void RecognizeLine(const ImageData& image_data, bool invert, bool debug,
                      double worst_dict_cert, const TBOX& line_box,
                      PointerVector<WERD_RES>* words, int lstm_choice_mode = 0);
+  // As RecognizeLine above, but reuses the network outputs of an earlier call
+  // with the same pixels and invert, if still in the cache or the
+  // OutputStore, and decodes them again instead of running the network.
+  // Duplicate lines thus cost only the beam search, on any page.
+  void RecognizeLineCached(const ImageData& image_data, bool invert,
+                           bool debug, double worst_dict_cert,
+                           const TBOX& line_box,
+                           PointerVector<WERD_RES>* words,
+                           int lstm_choice_mode = 0);
+  // Recognizes each of the images as RecognizeLine above, with the output
+  // words for images[i] in *words[i], using line_boxes[i]. Up to batch_size
+  // lines of similar size are packed together into each batch passed through
+  // the network, which is faster than a line at a time, and up to
+  // num_threads batches are recognized concurrently. See NumThreads.
+  void RecognizeLines(const std::vector<const ImageData*>& images,
+                      int batch_size, int num_threads, bool invert, bool debug,
+                      double worst_dict_cert,
+                      const std::vector<TBOX>& line_boxes,
+                      const std::vector<PointerVector<WERD_RES>*>& words,
+                      int lstm_choice_mode = 0);
 
   // Helper computes min and mean best results in the output.
   void OutputStats(const NetworkIO& outputs, float* min_output,
@@ -210,12 +465,44 @@ class LSTMRecognizer {
                          GenericVector<int>* xcoords);
 
  protected:
+  // Deletes the network, or releases it if it is shared or borrowed.
+  void FreeNetwork();
+  // Returns true if network_ is private to *this, so it may be changed.
+  bool OwnsNetwork() const {
+    return shared_network_ == nullptr && !borrowed_network_;
+  }
+  // Reads everything after the network in the lstm component, as written by
+  // Serialize.
+  bool DeSerializeModel(const TessdataManager* mgr, TFile* fp);
   // Sets the random seed from the sample_iteration_;
-  void SetRandomSeed() {
+  void SetRandomSeed() { SetRandomSeed(&randomizer_); }
+  // Sets the seed of the given randomizer from the sample_iteration_;
+  void SetRandomSeed(TRand* randomizer) const {
     int64_t seed = static_cast<int64_t>(sample_iteration_) * 0x10000001;
-    randomizer_.set_seed(seed);
-    randomizer_.IntRand();
+    randomizer->set_seed(seed);
+    randomizer->IntRand();
   }
+  // Cuts down the wide blank gaps in *pix, scaled for the network, as set by
+  // SetMaxBlankGap, replacing *pix if anything was cut. timestep_map is set
+  // as by Input::CompressBlankColumns, or cleared if nothing was cut.
+  void CompressBlankGaps(Pix** pix, std::vector<int>* timestep_map) const;
+  // Returns the key of the outputs of image_data in the output cache and the
+  // OutputStore, which covers the pixels, invert, the model and the
+  // settings applied before the network runs.
+  LineOutputKey OutputCacheKey(const ImageData& image_data, bool invert);
+  // Decodes the outputs of a line with the given search, with the beam search
+  // or greedily, as set by SetGreedyDecode, SetBeamCollapseMargin and
+  // SetLatticeSize.
+  void DecodeLine(const NetworkIO& outputs, double worst_dict_cert,
+                  int lstm_choice_mode, RecodeBeamSearch* search);
+  // As the public RecognizeLine that returns the outputs, but using the given
+  // scratch space and randomizer, so that separate threads can recognize
+  // lines with the same network. randomizer must be the scratch randomizer,
+  // or the network's own if the scratch has none.
+  bool RecognizeLine(const ImageData& image_data, bool invert, bool debug,
+                     bool re_invert, bool upside_down, float* scale_factor,
+                     NetworkIO* inputs, NetworkIO* outputs,
+                     NetworkScratch* scratch, TRand* randomizer);
 
   // Displays the labels and cuts at the corresponding xcoords.
   // Size of labels should match xcoords.
@@ -256,6 +543,10 @@ class LSTMRecognizer {
  protected:
   // The network hierarchy.
   Network* network_;
+  // The cache entry holding network_ if it is shared, otherwise nullptr.
+  SharedNetwork* shared_network_;
+  // True if network_ belongs to another recognizer, as set by ShareModel.
+  bool borrowed_network_;
   // The unicharset. Only the unicharset element is serialized.
   // Has to be a CCUtil, so Dict can point to it.
   CCUtil ccutil_;
@@ -285,10 +576,54 @@ class LSTMRecognizer {
   // === NOT SERIALIZED.
   TRand randomizer_;
   NetworkScratch scratch_space_;
+  // Max width of blank gaps in the text lines. See SetMaxBlankGap.
+  double max_blank_gap_;
+  // True to decode greedily when possible. See SetGreedyDecode.
+  bool greedy_decode_;
+  // See SetBeamCollapseMargin.
+  double beam_collapse_margin_;
+  // See SetPipelineDecode.
+  bool pipeline_decode_;
+  // See SetLatticeSize.
+  int lattice_size_;
+  // See SetPolarityCheck.
+  bool polarity_check_;
+  // See SetMaxLineTimesteps.
+  int max_line_timesteps_;
+  // See num_wide_lines. Lines of a batch may be refused on any thread.
+  std::atomic<int> num_wide_lines_;
+  // See SetOutputCacheSize.
+  int output_cache_size_;
+  // Network outputs of the last lines of RecognizeLineCached, most recently
+  // used first, and indexed by OutputCacheKey.
+  struct CachedOutputs {
+    LineOutputKey key;
+    float scale_factor;
+    NetworkIO outputs;
+  };
+  std::list<CachedOutputs> output_cache_;
+  std::unordered_map<uint64_t, std::list<CachedOutputs>::iterator>
+      output_cache_index_;
+  OutputCacheStats output_cache_stats_;
+  // See SetOutputStore.
+  OutputStore* output_store_;
+  // Hash of the network spec, weights, int mode and iterations, computed on
+  // first use.
+  uint64_t model_hash_;
+  // See SetMonitor.
+  const ETEXT_DESC* monitor_;
   // Language model (optional) to use with the beam search.
   Dict* dict_;
   // Beam search held between uses to optimize memory allocation/use.
   RecodeBeamSearch* search_;
+  // Scratch space, randomizer and beam search for each thread after the
+  // first in RecognizeLines, held between calls for the same reason.
+  struct ThreadState {
+    NetworkScratch scratch;
+    TRand randomizer;
+    std::unique_ptr<RecodeBeamSearch> search;
+  };
+  std::vector<std::unique_ptr<ThreadState>> thread_states_;
 
   // == Debugging parameters.==
   // Recognition debug display window.
@@ -23,7 +23,16 @@
 #endif
 
 #include "lstmtrainer.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <algorithm>  // for std::min, std::max
+#include <cstdio>     // for rename
+#include <memory>     // for std::unique_ptr, std::shared_ptr
+#include <mutex>      // for std::mutex
 #include <string>
+#include <utility>    // for std::move
+#include <vector>     // for std::vector
 
 #include "allheaders.h"
 #include "boxread.h"
@@ -115,6 +124,7 @@ LSTMTrainer::LSTMTrainer(FileReader file_reader, FileWriter file_writer,
 }
 
 LSTMTrainer::~LSTMTrainer() {
+  FinishCheckpointWrite();
   delete align_win_;
   delete target_win_;
   delete ctc_win_;
@@ -163,6 +173,31 @@ bool LSTMTrainer::TryLoadingCheckpoint(const char* filename,
   return true;
 }
 
+// Loads the LSTM model of the traineddata file as the teacher.
+bool LSTMTrainer::LoadTeacher(const char* filename, double weight) {
+  TessdataManager mgr;
+  std::shared_ptr<LSTMTrainer> teacher(new LSTMTrainer);
+  if (!mgr.Init(filename) || !teacher->Load(nullptr, nullptr, &mgr)) {
+    tprintf("Failed to load the teacher LSTM model from %s\n", filename);
+    return false;
+  }
+  if (teacher->network_->NumOutputs() != network_->NumOutputs() ||
+      teacher->GetUnicharset().size() != GetUnicharset().size()) {
+    tprintf("Teacher %s has %d outputs and %d unichars, instead of %d and %d\n",
+            filename, teacher->network_->NumOutputs(),
+            teacher->GetUnicharset().size(), network_->NumOutputs(),
+            GetUnicharset().size());
+    return false;
+  }
+  teacher->network_->SetEnableTraining(TS_DISABLED);
+  teacher_ = teacher;
+  teacher_weight_ = ClipToRange(weight, 0.0, 1.0);
+  if (sub_trainer_ != nullptr) ShareTeacher(sub_trainer_);
+  tprintf("Distilling from teacher %s with weight %g\n", filename,
+          teacher_weight_);
+  return true;
+}
+
 // Initializes the trainer with a network_spec in the network description
 // net_flags control network behavior according to the NetworkFlags enum.
 // There isn't really much difference between them - only where the effects
@@ -306,6 +341,29 @@ bool LSTMTrainer::LoadAllTrainingData(const GenericVector<STRING>& filenames,
   return training_data_.LoadDocuments(filenames, cache_strategy, file_reader_);
 }
 
+// Writes data to filename with writer, and if rename_file, does so through a
+// temporary file that then replaces filename, so a reader of filename never
+// sees a partly written file. Returns false on error.
+static bool WriteCheckpointFile(const GenericVector<char>& data,
+                                const STRING& filename, FileWriter writer,
+                                bool rename_file) {
+  if (!rename_file) return (*writer)(data, filename);
+  STRING temp_name = filename + ".tmp";
+  if (!(*writer)(data, temp_name)) return false;
+#ifdef _WIN32
+  // rename does not replace an existing file on Windows.
+  remove(filename.string());
+#endif
+  return rename(temp_name.string(), filename.string()) == 0;
+}
+
+// Waits for any checkpoint that is being written in the background to be
+// written. Returns false if writing it failed.
+bool LSTMTrainer::FinishCheckpointWrite() {
+  if (checkpoint_thread_.joinable()) checkpoint_thread_.join();
+  return !checkpoint_write_failed_.exchange(false);
+}
+
 // Keeps track of best and locally worst char error_rate and launches tests
 // using tester, when a new min or max is reached.
 // Writes checkpoints at appropriate times and builds and returns a log message
@@ -385,9 +443,28 @@ bool LSTMTrainer::MaintainCheckpoints(TestCallback tester, STRING* log_msg) {
   if (checkpoint_writer_ != nullptr && file_writer_ != nullptr &&
       checkpoint_name_.length() > 0) {
     // Write a current checkpoint.
-    GenericVector<char> checkpoint;
-    if (!checkpoint_writer_->Run(FULL, this, &checkpoint) ||
-        !(*file_writer_)(checkpoint, checkpoint_name_)) {
+    // Only one checkpoint is ever in flight, so wait for the last one.
+    if (!FinishCheckpointWrite()) {
+      *log_msg += " failed to write last checkpoint.";
+    }
+    auto checkpoint = std::make_shared<GenericVector<char>>();
+    if (!checkpoint_writer_->Run(FULL, this, checkpoint.get())) {
+      *log_msg += " failed to write checkpoint.";
+    } else if (background_checkpoints_) {
+      // The checkpoint is a snapshot, so training can go on while it is
+      // written.
+      STRING filename = checkpoint_name_;
+      FileWriter writer = file_writer_;
+      bool rename_file = rename_checkpoints_;
+      checkpoint_thread_ = std::thread([this, checkpoint, filename, writer,
+                                        rename_file]() {
+        if (!WriteCheckpointFile(*checkpoint, filename, writer, rename_file)) {
+          checkpoint_write_failed_ = true;
+        }
+      });
+      *log_msg += " writing checkpoint.";
+    } else if (!WriteCheckpointFile(*checkpoint, checkpoint_name_,
+                                    file_writer_, rename_checkpoints_)) {
       *log_msg += " failed to write checkpoint.";
     } else {
       *log_msg += " wrote checkpoint.";
@@ -506,6 +583,7 @@ bool LSTMTrainer::DeSerialize(const TessdataManager* mgr, TFile* fp) {
   } else {
     sub_trainer_ = new LSTMTrainer();
     if (!ReadTrainingDump(sub_data, sub_trainer_)) return false;
+    ShareTeacher(sub_trainer_);
   }
   if (!best_error_history_.DeSerialize(fp)) return false;
   if (!best_error_iterations_.DeSerialize(fp)) return false;
@@ -523,6 +601,7 @@ void LSTMTrainer::StartSubtrainer(STRING* log_msg) {
     delete sub_trainer_;
     sub_trainer_ = nullptr;
   } else {
+    ShareTeacher(sub_trainer_);
     log_msg->add_str_int(" Trial sub_trainer_ from iteration ",
                          sub_trainer_->training_iteration());
     // Reduce learning rate so it doesn't diverge this time.
@@ -794,6 +873,280 @@ Trainability LSTMTrainer::TrainOnLine(const ImageData* trainingdata,
   return trainable;
 }
 
+// Returns a copy of the given training sample, or nullptr if there is none,
+// so that the original may be evicted from the document cache while the copy
+// is still being trained on a different thread.
+static ImageData* CopyTrainingSample(const ImageData* image) {
+  return image == nullptr ? nullptr : image->Copy();
+}
+
+// Trains on the next num_samples samples of samples_trainer, using up to
+// num_threads threads, each of which runs forward-backward on its own copy
+// of the network. Without hogwild, the samples are taken in rounds of
+// num_threads, and the mean of the gradients of each round is applied in a
+// single Update, so learning_rate_ is the step size of each round as it is of
+// each sample in TrainOnLine. With hogwild, each thread applies its own
+// gradient as soon as it has one, without waiting for the others. Returns
+// the number of samples that were usable.
+int LSTMTrainer::TrainOnLines(LSTMTrainer* samples_trainer, int num_samples,
+                              int num_threads, bool hogwild) {
+#ifndef _OPENMP
+  // The rounds then run one sample at a time.
+  num_threads = 1;
+  hogwild = false;
+#endif
+  num_threads = std::max(1, std::min(num_threads, num_samples));
+  int num_usable = 0;
+  // Each worker is a light copy of *this that only computes gradients.
+  GenericVector<char> dump;
+  if (!samples_trainer->SaveTrainingDump(LIGHT, this, &dump)) return 0;
+  std::vector<std::unique_ptr<LSTMTrainer>> workers(num_threads);
+  for (auto& worker : workers) {
+    worker.reset(new LSTMTrainer);
+    if (!samples_trainer->ReadTrainingDump(dump, worker.get())) return 0;
+    worker->SetNumThreads(1);
+    ShareTeacher(worker.get());
+  }
+  int first_sample = sample_iteration_;
+  if (!hogwild) {
+    std::vector<std::unique_ptr<ImageData>> images(num_threads);
+    std::vector<Trainability> trainables(num_threads);
+    std::vector<bool> backprops(num_threads);
+    for (int start = 0; start < num_samples; start += num_threads) {
+      int round_size = std::min(num_threads, num_samples - start);
+      for (int s = 0; s < round_size; ++s) {
+        images[s].reset(CopyTrainingSample(
+            samples_trainer->training_data_.GetPageBySerial(first_sample +
+                                                            start + s)));
+        PrepareWorker(s, first_sample + start + s, workers[s].get());
+      }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(round_size) schedule(static, 1)
+#endif
+      for (int s = 0; s < round_size; ++s) {
+        bool backprop = false;
+        trainables[s] = images[s] == nullptr
+                            ? UNENCODABLE
+                            : workers[s]->BackpropSample(images[s].get(),
+                                                         &backprop);
+        backprops[s] = backprop;
+      }
+      std::vector<const Network*> gradients;
+      for (int s = 0; s < round_size; ++s) {
+        RecordWorkerSample(*workers[s], trainables[s]);
+        if (trainables[s] != UNENCODABLE && trainables[s] != NOT_BOXED)
+          ++num_usable;
+        if (backprops[s]) gradients.push_back(workers[s]->network_);
+      }
+      if (gradients.empty()) continue;
+      network_->AverageDeltas(gradients);
+      network_->Update(learning_rate_, momentum_, adam_beta_,
+                       training_iteration_);
+      for (auto& worker : workers) worker->network_->CopyWeights(*network_);
+    }
+    return num_usable;
+  }
+#ifdef _OPENMP
+  // Hogwild: each thread takes the next sample, and applies its gradient to
+  // the weights of *this as soon as it has it. Only the fetching of samples
+  // and the updates are serialized, so the backprop of each sample may run on
+  // weights that other threads have since updated.
+  std::mutex update_mutex;
+  int next_sample = 0;
+#pragma omp parallel num_threads(num_threads)
+  {
+    LSTMTrainer* worker = workers[omp_get_thread_num()].get();
+    while (true) {
+      std::unique_ptr<ImageData> image;
+      {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        if (next_sample >= num_samples) break;
+        int sample = first_sample + next_sample++;
+        image.reset(CopyTrainingSample(
+            samples_trainer->training_data_.GetPageBySerial(sample)));
+        PrepareWorker(0, sample, worker);
+        worker->network_->CopyWeights(*network_);
+      }
+      bool backprop = false;
+      Trainability trainable =
+          image == nullptr ? UNENCODABLE
+                           : worker->BackpropSample(image.get(), &backprop);
+      std::lock_guard<std::mutex> lock(update_mutex);
+      RecordWorkerSample(*worker, trainable);
+      if (trainable != UNENCODABLE && trainable != NOT_BOXED) ++num_usable;
+      if (backprop) {
+        network_->AverageDeltas({worker->network_});
+        network_->Update(learning_rate_, momentum_, adam_beta_,
+                         training_iteration_);
+      }
+    }
+  }
+#endif  // _OPENMP
+  return num_usable;
+}
+
+// Copies the training iteration state of *this to worker, ready to train on
+// the given sample at the given offset from the current training iteration.
+void LSTMTrainer::PrepareWorker(int offset, int sample,
+                                LSTMTrainer* worker) const {
+  worker->training_iteration_ = training_iteration_ + offset;
+  worker->sample_iteration_ = sample;
+  worker->prev_sample_iteration_ = sample;
+  worker->last_perfect_training_iteration_ = last_perfect_training_iteration_;
+  worker->perfect_delay_ = perfect_delay_;
+  worker->randomly_rotate_ = randomly_rotate_;
+}
+
+// Runs forward-backward on the given trainingdata as TrainOnLine does, but
+// leaves the gradient in the network instead of applying it. Sets *backprop
+// to whether the gradient was computed.
+Trainability LSTMTrainer::BackpropSample(const ImageData* trainingdata,
+                                         bool* backprop) {
+  NetworkIO fwd_outputs, targets;
+  Trainability trainable =
+      PrepareForBackward(trainingdata, &fwd_outputs, &targets);
+  *backprop = false;
+  if (trainable == UNENCODABLE || trainable == NOT_BOXED) return trainable;
+  if (network_->IsTraining() &&
+      (trainable != PERFECT ||
+       training_iteration() >
+           last_perfect_training_iteration_ + perfect_delay_)) {
+    NetworkIO bp_deltas;
+    network_->Backward(false, targets, &scratch_space_, &bp_deltas);
+    *backprop = true;
+  }
+  return trainable;
+}
+
+// Records the errors computed by worker on a sample of the given
+// trainability, as TrainOnLine would have done had *this trained on it.
+void LSTMTrainer::RecordWorkerSample(const LSTMTrainer& worker,
+                                     Trainability trainable) {
+  if (trainable == UNENCODABLE || trainable == NOT_BOXED) {
+    ++sample_iteration_;  // Sample was unusable.
+    return;
+  }
+  for (int type = 0; type < ET_COUNT; ++type) {
+    if (type == ET_SKIP_RATIO) continue;
+    ErrorTypes error_type = static_cast<ErrorTypes>(type);
+    UpdateErrorBuffer(worker.NewSingleError(error_type), error_type);
+  }
+  UpdateErrorBuffer(sample_iteration_ - prev_sample_iteration_,
+                    ET_SKIP_RATIO);
+  ++sample_iteration_;
+  RollErrorBuffers();
+}
+
+// Trains on a mini-batch of up to batch_size consecutive samples of
+// samples_trainer, which run through the network together as a single
+// batch, so the weights get a single Update with the sum of their gradients.
+// A sample that cannot join the batch, because it needs the auto-inversion
+// check, or is too wide, or is of a different height, ends the batch, and is
+// trained on its own if it would have been the first.
+// Returns the number of samples consumed.
+int LSTMTrainer::TrainOnBatch(LSTMTrainer* samples_trainer, int batch_size) {
+  if (batch_size <= 1) {
+    TrainOnLine(samples_trainer, false);
+    return 1;
+  }
+  int min_width = network_->XScaleFactor();
+  std::vector<std::unique_ptr<ImageData>> images;
+  std::vector<GenericVector<int>> truth_labels;
+  std::vector<int> samples;
+  std::vector<bool> upside_downs;
+  std::vector<Pix*> pixes;
+  int num_consumed = 0;
+  while (num_consumed < batch_size) {
+    const ImageData* image =
+        samples_trainer->training_data_.GetPageBySerial(sample_iteration_);
+    if (image == nullptr) {
+      ++sample_iteration_;
+      ++num_consumed;
+      continue;
+    }
+    // Lines without boxes get the auto-inversion check, which needs a
+    // forward pass of their own.
+    Pix* pix = nullptr;
+    if (!image->boxes().empty()) {
+      float scale_factor;
+      SetRandomSeed();
+      pix = Input::PrepareLSTMInputs(*image, network_, min_width, &randomizer_,
+                                     &scale_factor);
+    }
+    if (pix == nullptr || pixGetWidth(pix) > kMaxTrainingImageWidth ||
+        (!pixes.empty() && pixGetHeight(pix) != pixGetHeight(pixes[0]))) {
+      pixDestroy(&pix);
+      if (pixes.empty()) {
+        TrainOnLine(image, false);
+        ++num_consumed;
+      }
+      break;
+    }
+    GenericVector<int> labels;
+    bool upside_down = false;
+    std::unique_ptr<ImageData> copy(CopyTrainingSample(image));
+    if (copy == nullptr ||
+        !PrepareTruthLabels(image, &labels, &upside_down)) {
+      pixDestroy(&pix);
+      ++sample_iteration_;  // Sample was unusable.
+      ++num_consumed;
+      continue;
+    }
+    if (upside_down) pixRotate180(pix, pix);
+    images.push_back(std::move(copy));
+    truth_labels.push_back(labels);
+    samples.push_back(sample_iteration_);
+    upside_downs.push_back(upside_down);
+    pixes.push_back(pix);
+    ++sample_iteration_;
+    ++num_consumed;
+  }
+  if (pixes.empty()) return num_consumed;
+  NetworkIO inputs, outputs;
+  inputs.set_int_mode(IsIntMode());
+  SetRandomSeed();
+  Input::PreparePixesInput(network_->InputShape(),
+                           std::vector<const Pix*>(pixes.begin(), pixes.end()),
+                           &randomizer_, &inputs);
+  for (auto& pix : pixes) pixDestroy(&pix);
+  network_->Forward(false, inputs, nullptr, &scratch_space_, &outputs);
+  // The deltas of the lines that are not to be trained, and of the padding
+  // of the narrower lines, stay zero.
+  NetworkIO deltas;
+  deltas.Resize(outputs, network_->NumOutputs());
+  deltas.Zero();
+  int end_sample = sample_iteration_;
+  bool backprop = false;
+  for (size_t b = 0; b < samples.size(); ++b) {
+    NetworkIO line_inputs, line_outputs, line_targets;
+    line_inputs.CopyBatchElement(inputs, b);
+    line_outputs.CopyBatchElement(outputs, b);
+    // Record the errors as if the lines had been trained one at a time.
+    sample_iteration_ = samples[b];
+    Trainability trainable =
+        ComputeTargets(images[b].get(), upside_downs[b], line_inputs,
+                       &truth_labels[b], &line_outputs, &line_targets);
+    sample_iteration_ = samples[b] + 1;
+    if (trainable == UNENCODABLE || trainable == NOT_BOXED) continue;
+    if (network_->IsTraining() &&
+        (trainable != PERFECT ||
+         training_iteration() >
+             last_perfect_training_iteration_ + perfect_delay_)) {
+      deltas.CopyToBatchElement(line_targets, b);
+      backprop = true;
+    }
+    RollErrorBuffers();
+  }
+  sample_iteration_ = end_sample;
+  if (backprop) {
+    NetworkIO bp_deltas;
+    network_->Backward(false, deltas, &scratch_space_, &bp_deltas);
+    network_->Update(learning_rate_, momentum_, adam_beta_,
+                     training_iteration_);
+  }
+  return num_consumed;
+}
+
 // Prepares the ground truth, runs forward, and prepares the targets.
 // Returns a Trainability enum to indicate the suitability of the sample.
 Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
@@ -807,55 +1160,82 @@ Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
   bool debug = debug_interval_ > 0 &&
       training_iteration() % debug_interval_ == 0;
   GenericVector<int> truth_labels;
-  if (!EncodeString(trainingdata->transcription(), &truth_labels)) {
+  bool upside_down = false;
+  if (!PrepareTruthLabels(trainingdata, &truth_labels, &upside_down))
+    return UNENCODABLE;
+  float image_scale;
+  NetworkIO inputs;
+  bool invert = trainingdata->boxes().empty();
+  if (!RecognizeLine(*trainingdata, invert, debug, invert, upside_down,
+                     &image_scale, &inputs, fwd_outputs)) {
+    tprintf("Image not trainable\n");
+    return UNENCODABLE;
+  }
+  return ComputeTargets(trainingdata, upside_down, inputs, &truth_labels,
+                        fwd_outputs, targets);
+}
+
+// Encodes the transcription of trainingdata in truth_labels, and decides
+// whether it is to be trained upside-down. Returns false if the sample is
+// unusable.
+bool LSTMTrainer::PrepareTruthLabels(const ImageData* trainingdata,
+                                     GenericVector<int>* truth_labels,
+                                     bool* upside_down) {
+  if (!EncodeString(trainingdata->transcription(), truth_labels)) {
     tprintf("Can't encode transcription: '%s' in language '%s'\n",
             trainingdata->transcription().string(),
             trainingdata->language().string());
-    return UNENCODABLE;
+    return false;
   }
-  bool upside_down = false;
   if (randomly_rotate_) {
     // This ensures consistent training results.
     SetRandomSeed();
-    upside_down = randomizer_.SignedRand(1.0) > 0.0;
-    if (upside_down) {
+    *upside_down = randomizer_.SignedRand(1.0) > 0.0;
+    if (*upside_down) {
       // Modify the truth labels to match the rotation:
       // Apart from space and null, increment the label. This is changes the
       // script-id to the same script-id but upside-down.
       // The labels need to be reversed in order, as the first is now the last.
-      for (int c = 0; c < truth_labels.size(); ++c) {
-        if (truth_labels[c] != UNICHAR_SPACE && truth_labels[c] != null_char_)
-          ++truth_labels[c];
+      for (int c = 0; c < truth_labels->size(); ++c) {
+        int& label = (*truth_labels)[c];
+        if (label != UNICHAR_SPACE && label != null_char_) ++label;
       }
-      truth_labels.reverse();
+      truth_labels->reverse();
     }
   }
   int w = 0;
-  while (w < truth_labels.size() &&
-         (truth_labels[w] == UNICHAR_SPACE || truth_labels[w] == null_char_))
+  while (w < truth_labels->size() &&
+         ((*truth_labels)[w] == UNICHAR_SPACE ||
+          (*truth_labels)[w] == null_char_))
     ++w;
-  if (w == truth_labels.size()) {
+  if (w == truth_labels->size()) {
     tprintf("Blank transcription: %s\n",
             trainingdata->transcription().string());
-    return UNENCODABLE;
-  }
-  float image_scale;
-  NetworkIO inputs;
-  bool invert = trainingdata->boxes().empty();
-  if (!RecognizeLine(*trainingdata, invert, debug, invert, upside_down,
-                     &image_scale, &inputs, fwd_outputs)) {
-    tprintf("Image not trainable\n");
-    return UNENCODABLE;
+    return false;
   }
+  return true;
+}
+
+// Computes the targets for fwd_outputs, the result of running the network on
+// inputs, prepared from trainingdata, with the given truth_labels, and then
+// subtracts fwd_outputs, leaving the deltas to backprop in targets, and
+// records the errors. Returns a Trainability enum to indicate the
+// suitability of the sample.
+Trainability LSTMTrainer::ComputeTargets(const ImageData* trainingdata,
+                                         bool upside_down,
+                                         const NetworkIO& inputs,
+                                         GenericVector<int>* truth_labels,
+                                         NetworkIO* fwd_outputs,
+                                         NetworkIO* targets) {
   targets->Resize(*fwd_outputs, network_->NumOutputs());
   LossType loss_type = OutputLossType();
   if (loss_type == LT_SOFTMAX) {
-    if (!ComputeTextTargets(*fwd_outputs, truth_labels, targets)) {
+    if (!ComputeTextTargets(*fwd_outputs, *truth_labels, targets)) {
       tprintf("Compute simple targets failed!\n");
       return UNENCODABLE;
     }
   } else if (loss_type == LT_CTC) {
-    if (!ComputeCTCTargets(truth_labels, fwd_outputs, targets)) {
+    if (!ComputeCTCTargets(*truth_labels, fwd_outputs, targets)) {
       tprintf("Compute CTC targets failed!\n");
       return UNENCODABLE;
     }
@@ -863,20 +1243,25 @@ Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
     tprintf("Logistic outputs not implemented yet!\n");
     return UNENCODABLE;
   }
+  if (teacher_ != nullptr &&
+      !BlendTeacherTargets(trainingdata, upside_down, targets)) {
+    tprintf("Teacher failed to recognize the line!\n");
+    return UNENCODABLE;
+  }
   GenericVector<int> ocr_labels;
   GenericVector<int> xcoords;
   LabelsFromOutputs(*fwd_outputs, &ocr_labels, &xcoords);
   // CTC does not produce correct target labels to begin with.
   if (loss_type != LT_CTC) {
-    LabelsFromOutputs(*targets, &truth_labels, &xcoords);
+    LabelsFromOutputs(*targets, truth_labels, &xcoords);
   }
-  if (!DebugLSTMTraining(inputs, *trainingdata, *fwd_outputs, truth_labels,
+  if (!DebugLSTMTraining(inputs, *trainingdata, *fwd_outputs, *truth_labels,
                          *targets)) {
     tprintf("Input width was %d\n", inputs.Width());
     return UNENCODABLE;
   }
   STRING ocr_text = DecodeLabels(ocr_labels);
-  STRING truth_text = DecodeLabels(truth_labels);
+  STRING truth_text = DecodeLabels(*truth_labels);
   targets->SubtractAllFromFloat(*fwd_outputs);
   if (debug_interval_ != 0) {
       if (truth_text != ocr_text) {
@@ -884,7 +1269,7 @@ Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
             training_iteration(), ocr_text.string());
       }
   }
-  double char_error = ComputeCharError(truth_labels, ocr_labels);
+  double char_error = ComputeCharError(*truth_labels, ocr_labels);
   double word_error = ComputeWordError(&truth_text, &ocr_text);
   double delta_error = ComputeErrorRates(*targets, char_error, word_error);
   if (debug_interval_ != 0) {
@@ -896,6 +1281,34 @@ Trainability LSTMTrainer::PrepareForBackward(const ImageData* trainingdata,
   return TRAINABLE;
 }
 
+// Runs the teacher on trainingdata and blends its outputs into targets.
+bool LSTMTrainer::BlendTeacherTargets(const ImageData* trainingdata,
+                                      bool upside_down, NetworkIO* targets) {
+  float image_scale;
+  NetworkIO inputs, outputs;
+  bool invert = trainingdata->boxes().empty();
+  SetRandomSeed(&teacher_randomizer_);
+  if (!teacher_->RecognizeLine(*trainingdata, invert, false, invert,
+                               upside_down, &image_scale, &inputs, &outputs,
+                               &teacher_scratch_, &teacher_randomizer_)) {
+    return false;
+  }
+  int width = targets->Width();
+  int teacher_width = outputs.Width();
+  if (width == 0 || teacher_width == 0) return false;
+  int num_features = targets->NumFeatures();
+  std::vector<double> teacher_outputs(num_features);
+  for (int t = 0; t < width; ++t) {
+    outputs.ReadTimeStep(t * teacher_width / width, &teacher_outputs[0]);
+    float* target = targets->f(t);
+    for (int i = 0; i < num_features; ++i) {
+      target[i] = (1.0 - teacher_weight_) * target[i] +
+                  teacher_weight_ * teacher_outputs[i];
+    }
+  }
+  return true;
+}
+
 // Writes the trainer to memory, so that the current training state can be
 // restored.  *this must always be the master trainer that retains the only
 // copy of the training data and language model. trainer is the model that is
@@ -905,6 +1318,9 @@ bool LSTMTrainer::SaveTrainingDump(SerializeAmount serialize_amount,
                                    GenericVector<char>* data) const {
   TFile fp;
   fp.OpenWrite(data);
+  // Only the checkpoint file is compact. The in-memory copies that are used
+  // for reverting keep every bit of the training state.
+  fp.set_compact(serialize_amount == FULL && compact_checkpoints_);
   return trainer->Serialize(serialize_amount, &mgr_, &fp);
 }
 
@@ -924,8 +1340,7 @@ bool LSTMTrainer::ReadLocalTrainingDump(const TessdataManager* mgr,
 bool LSTMTrainer::SaveTraineddata(const STRING& filename) {
   GenericVector<char> recognizer_data;
   SaveRecognitionDump(&recognizer_data);
-  mgr_.OverwriteEntry(TESSDATA_LSTM, &recognizer_data[0],
-                      recognizer_data.size());
+  mgr_.OverwriteEntry(TESSDATA_LSTM, &recognizer_data);
   return mgr_.SaveFile(filename, file_writer_);
 }
 
@@ -1015,6 +1430,11 @@ void LSTMTrainer::SetNullChar() {
 
 // Factored sub-constructor sets up reasonable default values.
 void LSTMTrainer::EmptyConstructor() {
+  background_checkpoints_ = false;
+  compact_checkpoints_ = false;
+  rename_checkpoints_ = false;
+  checkpoint_write_failed_ = false;
+  teacher_weight_ = 0.0;
   align_win_ = nullptr;
   target_win_ = nullptr;
   ctc_win_ = nullptr;
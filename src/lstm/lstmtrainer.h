@@ -19,6 +19,10 @@
 #ifndef TESSERACT_LSTM_LSTMTRAINER_H_
 #define TESSERACT_LSTM_LSTMTRAINER_H_
 
+#include <atomic>
+#include <memory>
+#include <thread>
+
 #include "imagedata.h"
 #include "lstmrecognizer.h"
 #include "rect.h"
@@ -102,6 +106,13 @@ class LSTMTrainer : public LSTMRecognizer {
   // assumed that the character set is to be re-mapped from old_traineddata to
   // the new, with consequent change in weight matrices etc.
   bool TryLoadingCheckpoint(const char* filename, const char* old_traineddata);
+  // Loads the LSTM model of the given traineddata file as a teacher for the
+  // network being trained, which must have the same unicharset and recoder.
+  // The targets of each line are then weight times the outputs of the teacher
+  // plus 1 - weight times the usual targets, so that a small, fast network
+  // can learn from a larger, more accurate one. The teacher is not part of
+  // the checkpoints. Returns false on error.
+  bool LoadTeacher(const char* filename, double weight);
 
   // Initializes the character set encode/decode mechanism directly from a
   // previously setup traineddata containing dawgs, UNICHARSET and
@@ -149,6 +160,21 @@ class LSTMTrainer : public LSTMRecognizer {
   int learning_iteration() const { return learning_iteration_; }
   int32_t improvement_steps() const { return improvement_steps_; }
   void set_perfect_delay(int delay) { perfect_delay_ = delay; }
+  // Sets how MaintainCheckpoints writes the checkpoint file. With background,
+  // the checkpoint is still serialized to memory first, which snapshots the
+  // weights and moments, but it is written to disk on a separate thread while
+  // training carries on. With compact, the updates and adam moments of the
+  // weights are written as float instead of double. With rename, the
+  // checkpoint is written to a temporary file that then replaces the old one,
+  // so an interrupted write never leaves a truncated checkpoint.
+  void set_checkpoint_options(bool background, bool compact, bool rename) {
+    background_checkpoints_ = background;
+    compact_checkpoints_ = compact;
+    rename_checkpoints_ = rename;
+  }
+  // Waits for any checkpoint that is being written in the background to be
+  // written. Returns false if writing it failed.
+  bool FinishCheckpointWrite();
   const GenericVector<char>& best_trainer() const { return best_trainer_; }
   // Returns the error that was just calculated by PrepareForBackward.
   double NewSingleError(ErrorTypes type) const {
@@ -271,11 +297,58 @@ class LSTMTrainer : public LSTMRecognizer {
     return image;
   }
   Trainability TrainOnLine(const ImageData* trainingdata, bool batch);
+  // Trains on the next num_samples samples of samples_trainer, using up to
+  // num_threads threads, each of which runs forward-backward on its own copy
+  // of the network. Without hogwild, the samples are taken in rounds of
+  // num_threads, and the mean of the gradients of each round is applied in a
+  // single Update, so learning_rate_ is the step size of each round as it is
+  // of each sample in TrainOnLine, and a single thread trains exactly as
+  // TrainOnLine does. With hogwild, each thread applies its own gradient as
+  // soon as it has one, without waiting for the others, so gradients may be
+  // computed on slightly stale weights. The errors of each sample are
+  // recorded as if trained by TrainOnLine. Returns the number of samples that
+  // were usable.
+  int TrainOnLines(LSTMTrainer* samples_trainer, int num_samples,
+                   int num_threads, bool hogwild);
+  // Trains on a mini-batch of up to batch_size consecutive samples of
+  // samples_trainer, which run through the network together as a single
+  // batch, so the weights get a single Update with the sum of their
+  // gradients. A sample that cannot join the batch, because it needs the
+  // auto-inversion check, or is too wide, or is of a different height, ends
+  // the batch, and is trained on its own if it would have been the first.
+  // Returns the number of samples consumed.
+  int TrainOnBatch(LSTMTrainer* samples_trainer, int batch_size);
 
   // Prepares the ground truth, runs forward, and prepares the targets.
   // Returns a Trainability enum to indicate the suitability of the sample.
   Trainability PrepareForBackward(const ImageData* trainingdata,
                                   NetworkIO* fwd_outputs, NetworkIO* targets);
+  // Encodes the transcription of trainingdata in truth_labels, and decides
+  // whether it is to be trained upside-down. Returns false if the sample is
+  // unusable.
+  bool PrepareTruthLabels(const ImageData* trainingdata,
+                          GenericVector<int>* truth_labels, bool* upside_down);
+  // Computes the targets for fwd_outputs, the result of running the network
+  // on inputs, prepared from trainingdata, with the given truth_labels, and
+  // then subtracts fwd_outputs, leaving the deltas to backprop in targets,
+  // and records the errors. Returns a Trainability enum to indicate the
+  // suitability of the sample.
+  // upside_down is as set by PrepareTruthLabels, for running any teacher.
+  Trainability ComputeTargets(const ImageData* trainingdata, bool upside_down,
+                              const NetworkIO& inputs,
+                              GenericVector<int>* truth_labels,
+                              NetworkIO* fwd_outputs, NetworkIO* targets);
+  // Runs teacher_ on trainingdata, and blends its outputs into targets,
+  // which must not yet have had the forward outputs subtracted. The teacher
+  // timesteps are resampled if its x scale differs. Returns false if the
+  // teacher fails to recognize the line.
+  bool BlendTeacherTargets(const ImageData* trainingdata, bool upside_down,
+                           NetworkIO* targets);
+  // Gives trainer the same teacher as *this.
+  void ShareTeacher(LSTMTrainer* trainer) const {
+    trainer->teacher_ = teacher_;
+    trainer->teacher_weight_ = teacher_weight_;
+  }
 
   // Writes the trainer to memory, so that the current training state can be
   // restored.  *this must always be the master trainer that retains the only
@@ -386,6 +459,17 @@ class LSTMTrainer : public LSTMRecognizer {
   // Rolls error buffers and reports the current means.
   void RollErrorBuffers();
 
+  // Copies the training iteration state of *this to worker, ready to train on
+  // the given sample at the given offset from the current training iteration.
+  void PrepareWorker(int offset, int sample, LSTMTrainer* worker) const;
+  // Runs forward-backward on the given trainingdata as TrainOnLine does, but
+  // leaves the gradient in the network instead of applying it. Sets *backprop
+  // to whether the gradient was computed.
+  Trainability BackpropSample(const ImageData* trainingdata, bool* backprop);
+  // Records the errors computed by worker on a sample of the given
+  // trainability, as TrainOnLine would have done had *this trained on it.
+  void RecordWorkerSample(const LSTMTrainer& worker, Trainability trainable);
+
   // Given that error_rate is either a new min or max, updates the best/worst
   // error rates, and record of progress.
   STRING UpdateErrorGraph(int iteration, double error_rate,
@@ -423,6 +507,20 @@ class LSTMTrainer : public LSTMRecognizer {
   // when we can commit to c++11.
   CheckPointReader checkpoint_reader_;
   CheckPointWriter checkpoint_writer_;
+  // Options for writing the checkpoint file. See set_checkpoint_options.
+  bool background_checkpoints_;
+  bool compact_checkpoints_;
+  bool rename_checkpoints_;
+  // Thread writing the last checkpoint in the background, if any.
+  std::thread checkpoint_thread_;
+  // True if the last background write of a checkpoint failed.
+  std::atomic<bool> checkpoint_write_failed_;
+  // Optional teacher network set by LoadTeacher, shared with the workers,
+  // each of which runs it with its own scratch space and randomizer.
+  std::shared_ptr<LSTMTrainer> teacher_;
+  double teacher_weight_;
+  NetworkScratch teacher_scratch_;
+  TRand teacher_randomizer_;
 
   // ===Serialized data to ensure that a restart produces the same results.===
   // These members are only serialized when serialize_amount != LIGHT.
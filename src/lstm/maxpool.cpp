@@ -17,6 +17,8 @@
 
 #include "maxpool.h"
 
+#include <algorithm>  // for std::min
+
 namespace tesseract {
 
 Maxpool::Maxpool(const STRING& name, int ni, int x_scale, int y_scale)
@@ -38,8 +40,16 @@ void Maxpool::Forward(bool debug, const NetworkIO& input,
                       const TransposedArray* input_transpose,
                       NetworkScratch* scratch, NetworkIO* output) {
   output->ResizeScaled(input, x_scale_, y_scale_, no_);
-  maxes_.ResizeNoInit(output->Width(), ni_);
-  back_map_ = input.stride_map();
+  // The positions of the maxes are only needed for Backward, so inference
+  // keeps them locally, leaving the network unchanged, so that separate
+  // threads can run it.
+  std::vector<int> inference_maxes;
+  if (IsTraining()) {
+    maxes_.ResizeNoInit(output->Width(), ni_);
+    back_map_ = input.stride_map();
+  } else {
+    inference_maxes.resize(ni_);
+  }
 
   StrideMap::Index dest_index(output->stride_map());
   do {
@@ -49,18 +59,20 @@ void Maxpool::Forward(bool debug, const NetworkIO& input,
                                dest_index.index(FD_WIDTH) * x_scale_);
     // Find the max input out of x_scale_ groups of y_scale_ inputs.
     // Do it independently for each input dimension.
-    int* max_line = maxes_[out_t];
+    int* max_line = IsTraining() ? maxes_[out_t] : &inference_maxes[0];
     int in_t = src_index.t();
     output->CopyTimeStepFrom(out_t, input, in_t);
     for (int i = 0; i < ni_; ++i) {
       max_line[i] = in_t;
     }
-    for (int x = 0; x < x_scale_; ++x) {
-      for (int y = 0; y < y_scale_; ++y) {
-        StrideMap::Index src_xy(src_index);
-        if (src_xy.AddOffset(x, FD_WIDTH) && src_xy.AddOffset(y, FD_HEIGHT)) {
-          output->MaxpoolTimeStep(out_t, input, src_xy.t(), max_line);
-        }
+    int num_x = std::min(x_scale_, src_index.MaxIndexOfDim(FD_WIDTH) + 1 -
+                                       src_index.index(FD_WIDTH));
+    int num_y = std::min(y_scale_, src_index.MaxIndexOfDim(FD_HEIGHT) + 1 -
+                                       src_index.index(FD_HEIGHT));
+    for (int x = 0; x < num_x; ++x) {
+      for (int y = 0; y < num_y; ++y) {
+        output->MaxpoolTimeStep(out_t, input, src_index.OffsetT(x, y),
+                                max_line);
       }
     }
   } while (dest_index.Increment());
@@ -22,6 +22,7 @@
 
 #include "network.h"
 
+#include <algorithm>  // for std::max
 #include <cstdlib>
 
 // This base class needs to know about all its sub-classes because of the
@@ -29,6 +30,7 @@
 #include "allheaders.h"
 #include "convolve.h"
 #include "fullyconnected.h"
+#include "initprofile.h"
 #include "input.h"
 #include "lstm.h"
 #include "maxpool.h"
@@ -81,9 +83,11 @@ Network::Network()
       ni_(0),
       no_(0),
       num_weights_(0),
+      int_range_(1.0f),
       forward_win_(nullptr),
       backward_win_(nullptr),
-      randomizer_(nullptr) {}
+      randomizer_(nullptr),
+      calibrating_(false) {}
 Network::Network(NetworkType type, const STRING& name, int ni, int no)
     : type_(type),
       training_(TS_ENABLED),
@@ -93,9 +97,11 @@ Network::Network(NetworkType type, const STRING& name, int ni, int no)
       no_(no),
       num_weights_(0),
       name_(name),
+      int_range_(1.0f),
       forward_win_(nullptr),
       backward_win_(nullptr),
-      randomizer_(nullptr) {}
+      randomizer_(nullptr),
+      calibrating_(false) {}
 
 
 // Suspends/Enables/Permanently disables training by setting the training_
@@ -125,6 +131,25 @@ void Network::SetNetworkFlags(uint32_t flags) {
   network_flags_ = flags;
 }
 
+// Starts or ends the calibration of the int ranges. The range is only
+// changed by layers that record it, and a layer that never saw a non-zero
+// output keeps the default.
+void Network::SetCalibrating(bool calibrating) {
+  calibrating_ = calibrating;
+  if (calibrating) {
+    int_range_ = 0.0f;
+  } else if (int_range_ <= 0.0f) {
+    int_range_ = 1.0f;
+  }
+}
+
+// Records the max absolute value of output in int_range_ if calibrating.
+void Network::CalibrateRange(const NetworkIO& output) {
+  if (calibrating_ && !output.int_mode()) {
+    int_range_ = std::max(int_range_, output.MaxAbs());
+  }
+}
+
 // Sets up the network for training. Initializes weights using weights of
 // scale `range` picked according to the random number generator `randomizer`.
 int Network::InitWeights(float range, TRand* randomizer) {
@@ -157,11 +182,16 @@ bool Network::Serialize(TFile* fp) const {
   if (!fp->Serialize(&data)) return false;
   data = needs_to_backprop_;
   if (!fp->Serialize(&data)) return false;
-  if (!fp->Serialize(&network_flags_)) return false;
+  // A calibrated range is flagged, so older files, and files without one,
+  // stay the same.
+  bool has_range = int_range_ != 1.0f;
+  int32_t flags = network_flags_ | (has_range ? NF_INT_RANGE : 0);
+  if (!fp->Serialize(&flags)) return false;
   if (!fp->Serialize(&ni_)) return false;
   if (!fp->Serialize(&no_)) return false;
   if (!fp->Serialize(&num_weights_)) return false;
   if (!name_.Serialize(fp)) return false;
+  if (has_range && !fp->Serialize(&int_range_)) return false;
   return true;
 }
 
@@ -185,6 +215,7 @@ static NetworkType getNetworkType(TFile* fp) {
 // Determines the type of the serialized class and calls its DeSerialize
 // on a new object of the appropriate type, which is returned.
 Network* Network::CreateFromFile(TFile* fp) {
+  InitPhase phase("lstm network");
   NetworkType type;          // Type of the derived network class.
   TrainingState training;    // Are we currently training?
   bool needs_to_backprop;    // This network needs to output back_deltas.
@@ -193,6 +224,7 @@ Network* Network::CreateFromFile(TFile* fp) {
   int32_t no;                // Number of output values.
   int32_t num_weights;       // Number of weights in this and sub-network.
   STRING name;               // A unique name for this layer.
+  float int_range = 1.0f;    // Value of INT8_MAX in the int outputs.
   int8_t data;
   Network* network = nullptr;
   type = getNetworkType(fp);
@@ -205,6 +237,10 @@ Network* Network::CreateFromFile(TFile* fp) {
   if (!fp->DeSerialize(&no)) return nullptr;
   if (!fp->DeSerialize(&num_weights)) return nullptr;
   if (!name.DeSerialize(fp)) return nullptr;
+  if (network_flags & NF_INT_RANGE) {
+    if (!fp->DeSerialize(&int_range)) return nullptr;
+    network_flags &= ~NF_INT_RANGE;
+  }
 
   switch (type) {
     case NT_CONVOLVE:
@@ -269,6 +305,7 @@ Network* Network::CreateFromFile(TFile* fp) {
     network->needs_to_backprop_ = needs_to_backprop;
     network->network_flags_ = network_flags;
     network->num_weights_ = num_weights;
+    network->int_range_ = int_range;
     if (!network->DeSerialize(fp)) {
       delete network;
       network = nullptr;
@@ -20,10 +20,13 @@
 
 #include <cstdio>
 #include <cmath>
+#include <utility>  // for std::pair
+#include <vector>   // for std::vector
 
 #include "genericvector.h"
 #include "helpers.h"
 #include "matrix.h"
+#include "memoryusage.h"
 #include "networkio.h"
 #include "serialis.h"
 #include "static_shape.h"
@@ -85,6 +88,9 @@ enum NetworkFlags {
   // Network forward/backprop behavior.
   NF_LAYER_SPECIFIC_LR = 64,  // Separate learning rate for each layer.
   NF_ADAM = 128,              // Weight-specific learning rate.
+  // Serialization only: the int_range_ follows the name. Never set in
+  // network_flags_ itself.
+  NF_INT_RANGE = 256,
 };
 
 // State of training and desired state used in SetEnableTraining.
@@ -112,6 +118,7 @@ class Network {
     return type_;
   }
   bool IsTraining() const { return training_ == TS_ENABLED; }
+  bool IsCalibrating() const { return calibrating_; }
   bool needs_to_backprop() const {
     return needs_to_backprop_;
   }
@@ -143,6 +150,11 @@ class Network {
   bool TestFlag(NetworkFlags flag) const {
     return (network_flags_ & flag) != 0;
   }
+  // Returns the value represented by INT8_MAX in the int outputs of this
+  // layer. 1 unless calibrated by SetCalibrating.
+  float int_range() const {
+    return int_range_;
+  }
 
   // Initialization and administrative functions that are mostly provided
   // by Plumbing.
@@ -186,8 +198,36 @@ class Network {
     return 0;
   }
 
-  // Converts a float network to an int network.
-  virtual void ConvertToInt() {}
+  // Converts a float network to an int network. input_range is the value
+  // represented by INT8_MAX in the int input to this network, which is
+  // folded into the weights that take it. Returns the corresponding range of
+  // the int output. Layers without weights pass their input through.
+  virtual float ConvertToInt(float input_range) {
+    return input_range;
+  }
+  // Starts (calibrating = true) or ends the calibration of the int ranges.
+  // While calibrating, each layer with weights records the max absolute
+  // value of its float outputs in int_range_, so that ConvertToInt quantizes
+  // its activations with the range that they actually use, instead of
+  // [-1, 1]. Forward must then be run by a single thread.
+  virtual void SetCalibrating(bool calibrating);
+  // Records the max absolute value of output in int_range_ if calibrating.
+  void CalibrateRange(const NetworkIO& output);
+  // Converts a double network to a single precision float network, which can
+  // be used for inference only.
+  virtual void ConvertToFloat32() {}
+  // Sets to zero the given fraction of the blocks of each weight matrix with
+  // the smallest magnitude, and holds them at zero through further training,
+  // so the converted network can skip them. Returns the number of pruned
+  // blocks.
+  virtual int PruneWeights(double fraction) {
+    return 0;
+  }
+  // Appends the (outputs, inputs) shapes of the weight matrices used by
+  // Forward to shapes, so the SIMD code can be timed on them.
+  virtual void MatrixShapes(std::vector<std::pair<int, int>>* shapes) const {}
+  // Adds the bytes of the weight matrices to usage.
+  virtual void AddMemoryUsage(MemoryUsage* usage) const {}
 
   // Provides a pointer to a TRand for any networks that care to use it.
   // Note that randomizer is a borrowed pointer that should outlive the network
@@ -233,6 +273,12 @@ class Network {
   // *changed.
   virtual void CountAlternators(const Network& other, double* same,
                                 double* changed) const {}
+  // Sets the weight deltas of *this to the means of those of others, which
+  // have the same structure, so that Update applies their mean gradient, with
+  // the same effective learning rate as a gradient of a single sample.
+  virtual void AverageDeltas(const std::vector<const Network*>& others) {}
+  // Copies the weights of other, which has the same structure, to *this.
+  virtual void CopyWeights(const Network& other) {}
 
   // Reads from the given file. Returns nullptr in case of error.
   // Determines the type of the serialized class and calls its DeSerialize
@@ -297,11 +343,13 @@ class Network {
   int32_t no_;                // Number of output values.
   int32_t num_weights_;       // Number of weights in this and sub-network.
   STRING name_;               // A unique name for this layer.
+  float int_range_;           // Value of INT8_MAX in the int outputs.
 
   // NOT-serialized debug data.
   ScrollView* forward_win_;   // Recognition debug display window.
   ScrollView* backward_win_;  // Training debug display window.
   TRand* randomizer_;         // Random number generator.
+  bool calibrating_;          // Recording int_range_ in Forward.
 };
 
 }  // namespace tesseract.
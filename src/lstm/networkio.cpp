@@ -17,10 +17,12 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include "networkio.h"
+#include <algorithm>     // for std::min
 #include <cfloat>        // for FLT_MAX
 
 #include "allheaders.h"
 #include "functions.h"
+#include "simddetect.h"  // for QuantizeVector, DequantizeVector
 #include "statistc.h"
 #include "tprintf.h"
 
@@ -35,9 +37,15 @@ const float kMinProb = exp(kMinCertainty);
 void NetworkIO::Resize2d(bool int_mode, int width, int num_features) {
   stride_map_ = StrideMap();
   int_mode_ = int_mode;
+  int_range_ = 1.0f;
+  // The buffers are reused for lines of varying width, so they grow
+  // geometrically rather than reallocate for every wider line.
   if (int_mode_) {
-    i_.ResizeNoInit(width, num_features, GetPadding(num_features));
+    int padding = GetPadding(num_features);
+    i_.ReserveNoInit(width * num_features + padding);
+    i_.ResizeNoInit(width, num_features, padding);
   } else {
+    f_.ReserveNoInit(width * num_features);
     f_.ResizeNoInit(width, num_features);
   }
 }
@@ -50,10 +58,15 @@ void NetworkIO::ResizeToMap(bool int_mode, const StrideMap& stride_map,
   // ie call NetworkScratch::IO::Resizexxx() not NetworkIO::Resizexxx()!!
   stride_map_ = stride_map;
   int_mode_ = int_mode;
+  int_range_ = 1.0f;
+  int width = stride_map.Width();
   if (int_mode_) {
-    i_.ResizeNoInit(stride_map.Width(), num_features, GetPadding(num_features));
+    int padding = GetPadding(num_features);
+    i_.ReserveNoInit(width * num_features + padding);
+    i_.ResizeNoInit(width, num_features, padding);
   } else {
-    f_.ResizeNoInit(stride_map.Width(), num_features);
+    f_.ReserveNoInit(width * num_features);
+    f_.ResizeNoInit(width, num_features);
   }
   ZeroInvalidElements();
 }
@@ -64,6 +77,7 @@ void NetworkIO::ResizeScaled(const NetworkIO& src,
   StrideMap stride_map = src.stride_map_;
   stride_map.ScaleXY(x_scale, y_scale);
   ResizeToMap(src.int_mode_, stride_map, num_features);
+  int_range_ = src.int_range_;
 }
 
 // Resizes to just 1 x-coord, whatever the input.
@@ -71,6 +85,7 @@ void NetworkIO::ResizeXTo1(const NetworkIO& src, int num_features) {
   StrideMap stride_map = src.stride_map_;
   stride_map.ReduceWidthTo1();
   ResizeToMap(src.int_mode_, stride_map, num_features);
+  int_range_ = src.int_range_;
 }
 
 // Initialize all the array to zero.
@@ -369,7 +384,7 @@ void NetworkIO::Print(int num) const {
     for (int t = 0; t < Width(); ++t) {
       if (num == 0 || t < num || t + num >= Width()) {
         if (int_mode_) {
-          tprintf(" %g", static_cast<float>(i_[t][y]) / INT8_MAX);
+          tprintf(" %g", static_cast<float>(i_[t][y]) * int_range_ / INT8_MAX);
         } else {
           tprintf(" %g", f_[t][y]);
         }
@@ -594,12 +609,18 @@ bool NetworkIO::AnySuspiciousTruth(float confidence_thr) const {
   return false;
 }
 
-// Reads a single timestep to floats in the range [-1, 1].
+// Reads a single timestep to floats in the range [-1, 1], or
+// [-int_range_, int_range_] in int mode.
 void NetworkIO::ReadTimeStep(int t, double* output) const {
   if (int_mode_) {
     const int8_t* line = i_[t];
+    if (DequantizeVector != nullptr && int_range_ == 1.0f) {
+      DequantizeVector(line, i_.dim2(), output);
+      return;
+    }
+    double scale = int_range_ / static_cast<double>(INT8_MAX);
     for (int i = 0; i < i_.dim2(); ++i) {
-      output[i] = static_cast<double>(line[i]) / INT8_MAX;
+      output[i] = line[i] * scale;
     }
   } else {
     const float* line = f_[t];
@@ -614,8 +635,13 @@ void NetworkIO::AddTimeStep(int t, double* inout) const {
   int num_features = NumFeatures();
   if (int_mode_) {
     const int8_t* line = i_[t];
+    if (DequantizeAddVector != nullptr && int_range_ == 1.0f) {
+      DequantizeAddVector(line, num_features, inout);
+      return;
+    }
+    double scale = int_range_ / static_cast<double>(INT8_MAX);
     for (int i = 0; i < num_features; ++i) {
-      inout[i] += static_cast<double>(line[i]) / INT8_MAX;
+      inout[i] += line[i] * scale;
     }
   } else {
     const float* line = f_[t];
@@ -630,8 +656,9 @@ void NetworkIO::AddTimeStepPart(int t, int offset, int num_features,
                                 float* inout) const {
   if (int_mode_) {
     const int8_t* line = i_[t] + offset;
+    float scale = int_range_ / INT8_MAX;
     for (int i = 0; i < num_features; ++i) {
-      inout[i] += static_cast<float>(line[i]) / INT8_MAX;
+      inout[i] += line[i] * scale;
     }
   } else {
     const float* line = f_[t] + offset;
@@ -648,12 +675,19 @@ void NetworkIO::WriteTimeStep(int t, const double* input) {
 
 // Writes a single timestep from floats in the range [-1, 1] writing only
 // num_features elements of input to (*this)[t], starting at offset.
+// In int mode the range is [-int_range_, int_range_] and values outside it
+// are clipped.
 void NetworkIO::WriteTimeStepPart(int t, int offset, int num_features,
                                   const double* input) {
   if (int_mode_) {
     int8_t* line = i_[t] + offset;
+    if (QuantizeVector != nullptr && int_range_ == 1.0f) {
+      QuantizeVector(input, num_features, line);
+      return;
+    }
+    double scale = INT8_MAX / static_cast<double>(int_range_);
     for (int i = 0; i < num_features; ++i) {
-      line[i] = ClipToRange<int>(IntCastRounded(input[i] * INT8_MAX),
+      line[i] = ClipToRange<int>(IntCastRounded(input[i] * scale),
                                  -INT8_MAX, INT8_MAX);
     }
   } else {
@@ -807,6 +841,14 @@ void NetworkIO::ComputeCombinerDeltas(const NetworkIO& fwd_deltas,
   }
 }
 
+// Returns the max absolute value over the whole array.
+float NetworkIO::MaxAbs() const {
+  if (int_mode_) {
+    return static_cast<float>(i_.MaxAbs()) * int_range_ / INT8_MAX;
+  }
+  return f_.MaxAbs();
+}
+
 // Copies the array checking that the types match.
 void NetworkIO::CopyAll(const NetworkIO& src) {
   ASSERT_HOST(src.int_mode_ == int_mode_);
@@ -893,6 +935,7 @@ void NetworkIO::CopyWithXYTranspose(const NetworkIO& src) {
   stride_map_ = src.stride_map_;
   stride_map_.TransposeXY();
   ResizeToMap(src.int_mode(), stride_map_, num_features);
+  int_range_ = src.int_range_;
   StrideMap::Index src_b_index(src.stride_map_);
   StrideMap::Index dest_b_index(stride_map_);
   do {
@@ -911,16 +954,88 @@ void NetworkIO::CopyWithXYTranspose(const NetworkIO& src) {
            dest_b_index.AddOffset(1, FD_BATCH));
 }
 
+// Copies the image at the given batch index of src to *this, which becomes
+// a batch of one image of the same size.
+void NetworkIO::CopyBatchElement(const NetworkIO& src, int batch) {
+  StrideMap::Index src_b_index(src.stride_map_, batch, 0, 0);
+  int height = src_b_index.MaxIndexOfDim(FD_HEIGHT) + 1;
+  int width = src_b_index.MaxIndexOfDim(FD_WIDTH) + 1;
+  std::vector<std::pair<int, int>> h_w_pairs(1, std::make_pair(height, width));
+  StrideMap stride_map;
+  stride_map.SetStride(h_w_pairs);
+  ResizeToMap(src.int_mode(), stride_map, src.NumFeatures());
+  int_range_ = src.int_range_;
+  StrideMap::Index dest_index(stride_map_);
+  do {
+    StrideMap::Index src_index(src.stride_map_, batch,
+                               dest_index.index(FD_HEIGHT),
+                               dest_index.index(FD_WIDTH));
+    CopyTimeStepFrom(dest_index.t(), src, src_index.t());
+  } while (dest_index.Increment());
+}
+
+// Copies src, a batch of one image, to the given batch index of *this,
+// where there must already be an image of the same size. Undoes
+// CopyBatchElement.
+void NetworkIO::CopyToBatchElement(const NetworkIO& src, int batch) {
+  ASSERT_HOST(src.stride_map_.Size(FD_BATCH) == 1);
+  StrideMap::Index dest_b_index(stride_map_, batch, 0, 0);
+  ASSERT_HOST(dest_b_index.MaxIndexOfDim(FD_HEIGHT) + 1 ==
+              src.stride_map_.Size(FD_HEIGHT));
+  ASSERT_HOST(dest_b_index.MaxIndexOfDim(FD_WIDTH) + 1 ==
+              src.stride_map_.Size(FD_WIDTH));
+  StrideMap::Index src_index(src.stride_map_);
+  do {
+    StrideMap::Index dest_index(stride_map_, batch,
+                                src_index.index(FD_HEIGHT),
+                                src_index.index(FD_WIDTH));
+    CopyTimeStepFrom(dest_index.t(), src, src_index.t());
+  } while (src_index.Increment());
+}
+
+// Copies src, a single image with a height of 1, to *this, copying each
+// timestep t of *this from timestep timestep_map[t] of src. Undoes a cut of
+// timesteps made to the input, such as by Input::CompressBlankColumns.
+void NetworkIO::CopyWithTimestepMap(const NetworkIO& src,
+                                    const std::vector<int>& timestep_map) {
+  ASSERT_HOST(src.stride_map_.Size(FD_BATCH) == 1 &&
+              src.stride_map_.Size(FD_HEIGHT) == 1);
+  int width = timestep_map.size();
+  std::vector<std::pair<int, int>> h_w_pairs(1, std::make_pair(1, width));
+  StrideMap stride_map;
+  stride_map.SetStride(h_w_pairs);
+  ResizeToMap(src.int_mode(), stride_map, src.NumFeatures());
+  int_range_ = src.int_range_;
+  int max_t = src.Width() - 1;
+  for (int t = 0; t < width; ++t) {
+    CopyTimeStepFrom(t, src, std::min(timestep_map[t], max_t));
+  }
+}
+
 // Copies src to *this, at the given feature_offset, returning the total
 // feature offset after the copy. Multiple calls will stack outputs from
-// multiple sources in feature space.
+// multiple sources in feature space. Int values of src with a different
+// int_range are rescaled to that of *this.
 int NetworkIO::CopyPacking(const NetworkIO& src, int feature_offset) {
   ASSERT_HOST(int_mode_ == src.int_mode_);
   int width = src.Width();
   ASSERT_HOST(width <= Width());
   int num_features = src.NumFeatures();
   ASSERT_HOST(num_features + feature_offset <= NumFeatures());
-  if (int_mode_) {
+  if (int_mode_ && src.int_range_ != int_range_) {
+    float scale = src.int_range_ / int_range_;
+    for (int t = 0; t < width; ++t) {
+      const int8_t* src_line = src.i_[t];
+      int8_t* line = i_[t] + feature_offset;
+      for (int i = 0; i < num_features; ++i) {
+        line[i] = ClipToRange<int>(IntCastRounded(src_line[i] * scale),
+                                   -INT8_MAX, INT8_MAX);
+      }
+    }
+    for (int t = width; t < i_.dim1(); ++t) {
+      memset(i_[t] + feature_offset, 0, num_features * sizeof(i_[t][0]));
+    }
+  } else if (int_mode_) {
     for (int t = 0; t < width; ++t) {
       memcpy(i_[t] + feature_offset, src.i_[t],
              num_features * sizeof(i_[t][0]));
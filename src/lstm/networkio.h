@@ -38,12 +38,14 @@ namespace tesseract {
 // enough calculating functions to hide the detail of the implementation.
 class NetworkIO {
  public:
-  NetworkIO() : int_mode_(false) {}
+  NetworkIO() : int_mode_(false), int_range_(1.0f) {}
   // Resizes the array (and stride), avoiding realloc if possible, to the given
   // size from various size specs:
   // Same stride size, but given number of features.
+  // In int mode, the int_range of src is kept too.
   void Resize(const NetworkIO& src, int num_features) {
     ResizeToMap(src.int_mode(), src.stride_map(), num_features);
+    int_range_ = src.int_range_;
   }
   // Resizes to a specific size as a 2-d temp buffer. No batches, no y-dim.
   void Resize2d(bool int_mode, int width, int num_features);
@@ -52,7 +54,7 @@ class NetworkIO {
   void ResizeFloat(const NetworkIO& src, int num_features) {
     ResizeToMap(false, src.stride_map(), num_features);
   }
-  // Resizes to a specific stride_map.
+  // Resizes to a specific stride_map, with an int_range of 1.
   void ResizeToMap(bool int_mode, const StrideMap& stride_map,
                    int num_features);
   // Shrinks image size by x_scale,y_scale, and use given number of features.
@@ -111,6 +113,16 @@ class NetworkIO {
   int NumFeatures() const {
     return int_mode_ ? i_.dim2() : f_.dim2();
   }
+  // Returns the number of elements allocated for both representations, which
+  // changes only when a Resize has to reallocate.
+  int AllocatedSize() const {
+    return i_.size_allocated() + f_.size_allocated();
+  }
+  // Returns the bytes allocated for both representations.
+  int64_t AllocatedBytes() const {
+    return i_.size_allocated() * sizeof(int8_t) +
+           static_cast<int64_t>(f_.size_allocated()) * sizeof(float);
+  }
   // Accessor to a timestep of the float matrix.
   float* f(int t) {
     ASSERT_HOST(!int_mode_);
@@ -130,6 +142,15 @@ class NetworkIO {
   void set_int_mode(bool is_quantized) {
     int_mode_ = is_quantized;
   }
+  // In int mode, the value represented by INT8_MAX. The int values of each
+  // layer are scaled to the range of its outputs if it was calibrated, and
+  // the functions that convert to and from float take it into account.
+  float int_range() const {
+    return int_range_;
+  }
+  void set_int_range(float range) {
+    int_range_ = range;
+  }
   const StrideMap& stride_map() const {
     return stride_map_;
   }
@@ -213,6 +234,8 @@ class NetworkIO {
   float MinOfMaxes() const;
   // Returns the min over time.
   float Max() const { return int_mode_ ? i_.Max() : f_.Max(); }
+  // Returns the max absolute value over the whole array.
+  float MaxAbs() const;
   // Computes combined results for a combiner that chooses between an existing
   // input and itself, with an additional output to indicate the choice.
   void CombineOutputs(const NetworkIO& base_output,
@@ -238,6 +261,18 @@ class NetworkIO {
   void CopyWithXReversal(const NetworkIO& src);
   // Copies src to *this with independent transpose of the x and y dimensions.
   void CopyWithXYTranspose(const NetworkIO& src);
+  // Copies the image at the given batch index of src to *this, which becomes
+  // a batch of one image of the same size.
+  void CopyBatchElement(const NetworkIO& src, int batch);
+  // Copies src, a batch of one image, to the given batch index of *this,
+  // where there must already be an image of the same size. Undoes
+  // CopyBatchElement.
+  void CopyToBatchElement(const NetworkIO& src, int batch);
+  // Copies src, a single image with a height of 1, to *this, copying each
+  // timestep t of *this from timestep timestep_map[t] of src. Undoes a cut of
+  // timesteps made to the input, such as by Input::CompressBlankColumns.
+  void CopyWithTimestepMap(const NetworkIO& src,
+                           const std::vector<int>& timestep_map);
   // Copies src to *this, at the given feature_offset, returning the total
   // feature offset after the copy. Multiple calls will stack outputs from
   // multiple sources in feature space.
@@ -336,6 +371,8 @@ class NetworkIO {
   GENERIC_2D_ARRAY<int8_t> i_;
   // Which of f_ and i_ are we actually using.
   bool int_mode_;
+  // The value represented by INT8_MAX in i_.
+  float int_range_;
   // Stride for 2d input data.
   StrideMap stride_map_;
 };
@@ -19,9 +19,12 @@
 #ifndef TESSERACT_LSTM_NETWORKSCRATCH_H_
 #define TESSERACT_LSTM_NETWORKSCRATCH_H_
 
+#include <atomic>
+#include "counters.h"
 #include "genericvector.h"
 #include "matrix.h"
 #include "networkio.h"
+#include "ocrclass.h"
 #include "svutil.h"
 
 namespace tesseract {
@@ -33,7 +36,13 @@ namespace tesseract {
 // and don't have to be reallocated on each call.
 class NetworkScratch {
  public:
-  NetworkScratch() : int_mode_(false) {}
+  NetworkScratch()
+      : int_mode_(false),
+        num_threads_(0),
+        randomizer_(nullptr),
+        monitor_(nullptr),
+        cancelled_(false),
+        num_reallocations_(0) {}
   ~NetworkScratch() = default;
 
   // Sets the network representation. If the representation is integer, then
@@ -44,6 +53,60 @@ class NetworkScratch {
   void set_int_mode(bool int_mode) {
     int_mode_ = int_mode;
   }
+  // Sets the number of threads that network layers may use, as requested by
+  // the caller. 0 leaves each layer with its built-in default. See NumThreads.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+  int num_threads() const {
+    return num_threads_;
+  }
+  // Sets a randomizer for the network layers to use instead of the one owned
+  // by the network, so that separate threads can run the same network, each
+  // with its own NetworkScratch. nullptr reverts to the network's randomizer.
+  void set_randomizer(TRand* randomizer) {
+    randomizer_ = randomizer;
+  }
+  TRand* randomizer() const {
+    return randomizer_;
+  }
+  // Sets the monitor whose deadline and cancel function stop the layers in
+  // the middle of a forward pass, leaving outputs that are to be discarded.
+  // nullptr for none.
+  void set_monitor(const ETEXT_DESC* monitor) {
+    monitor_ = monitor;
+    cancelled_ = false;
+  }
+  // Returns true once the monitor asks to stop, and from then on until the
+  // next set_monitor, so that all the layers stop, even if some run on
+  // separate threads.
+  bool Cancelled() {
+    if (!cancelled_ && monitor_ != nullptr && monitor_->cancelled(0))
+      cancelled_ = true;
+    return cancelled_;
+  }
+  // Returns the number of heap allocations made for the buffers since
+  // construction, counting both new buffers and reallocations of existing
+  // ones. Once the buffers are big enough for the input, it stops changing.
+  int num_allocations() const {
+    return int_stack_.num_created() + float_stack_.num_created() +
+           vec_stack_.num_created() + array_stack_.num_created() +
+           num_reallocations_;
+  }
+  // Returns the bytes held by all the buffers, lent out or not.
+  int64_t AllocatedBytes() const {
+    return int_stack_.AllocatedBytes(
+               [](const NetworkIO& io) { return io.AllocatedBytes(); }) +
+           float_stack_.AllocatedBytes(
+               [](const NetworkIO& io) { return io.AllocatedBytes(); }) +
+           vec_stack_.AllocatedBytes([](const GenericVector<double>& vec) {
+             return static_cast<int64_t>(vec.size_reserved()) * sizeof(double);
+           }) +
+           array_stack_.AllocatedBytes([](const TransposedArray& array) {
+             return static_cast<int64_t>(array.size_allocated()) *
+                    sizeof(double);
+           });
+  }
 
   // Class that acts like a NetworkIO (by having an implicit cast operator),
   // yet actually holds a pointer to NetworkIOs in the source NetworkScratch,
@@ -81,7 +144,9 @@ class NetworkScratch {
         network_io_ = int_mode_ ? scratch_space_->int_stack_.Borrow()
                                 : scratch_space_->float_stack_.Borrow();
       }
+      int allocated = network_io_->AllocatedSize();
       network_io_->Resize(src, num_features);
+      CountReallocation(allocated);
     }
     // Resizes to a specific size as a temp buffer. No batches, no y-dim.
     void Resize2d(bool int_mode, int width, int num_features,
@@ -92,7 +157,9 @@ class NetworkScratch {
         network_io_ = int_mode_ ? scratch_space_->int_stack_.Borrow()
                                 : scratch_space_->float_stack_.Borrow();
       }
+      int allocated = network_io_->AllocatedSize();
       network_io_->Resize2d(int_mode, width, num_features);
+      CountReallocation(allocated);
     }
     // Resize forcing a float representation with the width of src and the given
     // number of features.
@@ -103,7 +170,9 @@ class NetworkScratch {
         scratch_space_ = scratch;
         network_io_ = scratch_space_->float_stack_.Borrow();
       }
+      int allocated = network_io_->AllocatedSize();
       network_io_->ResizeFloat(src, num_features);
+      CountReallocation(allocated);
     }
 
     // Returns a ref to a NetworkIO that enables *this to be treated as if
@@ -119,6 +188,14 @@ class NetworkScratch {
     }
 
    private:
+    // Counts a reallocation if the allocated size changed from allocated.
+    void CountReallocation(int allocated) {
+      if (network_io_->AllocatedSize() != allocated) {
+        ++scratch_space_->num_reallocations_;
+        CountEvent(COUNTER_SCRATCH_ALLOCATIONS);
+      }
+    }
+
     // True if this is from the always-float stack, otherwise the default stack.
     bool int_mode_;
     // The NetworkIO that we have borrowed from the scratch_space_.
@@ -149,7 +226,12 @@ class NetworkScratch {
         scratch_space_->vec_stack_.Return(vec_);
       scratch_space_ = scratch;
       vec_ = scratch_space_->vec_stack_.Borrow();
+      int reserved = vec_->size_reserved();
       vec_->resize_no_init(size);
+      if (vec_->size_reserved() != reserved) {
+        ++scratch_space_->num_reallocations_;
+        CountEvent(COUNTER_SCRATCH_ALLOCATIONS);
+      }
       data_ = &(*vec_)[0];
     }
 
@@ -204,7 +286,7 @@ class NetworkScratch {
   // It is safe to attempt to Borrow/Return in multiple threads.
   template<typename T> class Stack {
    public:
-    Stack() : stack_top_(0) {
+    Stack() : stack_top_(0), num_created_(0) {
     }
 
     // Lends out the next free item, creating one if none available, sets
@@ -214,6 +296,8 @@ class NetworkScratch {
       if (stack_top_ == stack_.size()) {
         stack_.push_back(new T);
         flags_.push_back(false);
+        ++num_created_;
+        CountEvent(COUNTER_SCRATCH_ALLOCATIONS);
       }
       flags_[stack_top_] = true;
       return stack_[stack_top_++];
@@ -231,17 +315,43 @@ class NetworkScratch {
       if (index >= 0) flags_[index] = false;
       while (stack_top_ > 0 && !flags_[stack_top_ - 1]) --stack_top_;
     }
+    // Returns the number of items created since construction.
+    int num_created() const {
+      return num_created_;
+    }
+    // Returns the sum of the sizes of the items and of bytes_of each item.
+    template <typename BytesOf>
+    int64_t AllocatedBytes(BytesOf bytes_of) const {
+      SVAutoLock lock(&mutex_);
+      int64_t bytes = 0;
+      for (int i = 0; i < stack_.size(); ++i)
+        bytes += sizeof(T) + bytes_of(*stack_[i]);
+      return bytes;
+    }
 
    private:
     PointerVector<T> stack_;
     GenericVector<bool> flags_;
     int stack_top_;
-    SVMutex mutex_;
+    // Number of items ever created. Only changed under the mutex.
+    int num_created_;
+    mutable SVMutex mutex_;
   };  // class Stack.
 
  private:
   // If true, the network weights are int8_t, if false, float.
   bool int_mode_;
+  // Number of threads requested for the network layers, 0 for the default.
+  int num_threads_;
+  // If not null, replaces the network's randomizer. Not owned.
+  TRand* randomizer_;
+  // Monitor of the recognition, if any. Not owned.
+  const ETEXT_DESC* monitor_;
+  // Set once the monitor asks to stop. Atomic, as parallel layers share it.
+  std::atomic<bool> cancelled_;
+  // Number of reallocations of borrowed buffers. Atomic, as layers may resize
+  // their buffers in parallel.
+  std::atomic<int> num_reallocations_;
   // Stacks of NetworkIO and GenericVector<float>. Once allocated, they are not
   // deleted until the NetworkScratch is deleted.
   Stack<NetworkIO> int_stack_;
@@ -21,9 +21,11 @@
 #ifdef _OPENMP
 #include <omp.h>
 #endif
+#include <algorithm>
 
 #include "functions.h"  // For conditional undef of _OPENMP.
 #include "networkscratch.h"
+#include "numthreads.h"
 
 namespace tesseract {
 
@@ -44,6 +46,22 @@ StaticShape Parallel::OutputShape(const StaticShape& input_shape) const {
   return result;
 }
 
+// Returns the number of threads to run the stack members on concurrently.
+// The members of a 2-d LSTM quad run in parallel by default, and those of
+// a 1-d LSTM pair only if more threads are requested through the scratch.
+int Parallel::NumStackThreads(const NetworkScratch* scratch) const {
+  int stack_size = stack_.size();
+  int default_threads;
+  if (type_ == NT_PAR_2D_LSTM)
+    default_threads = stack_size;
+  else if (type_ == NT_PAR_RL_LSTM || type_ == NT_PAR_UD_LSTM)
+    default_threads = 1;
+  else
+    return 1;
+  return std::min(stack_size,
+                  NumThreads(default_threads, scratch->num_threads()));
+}
+
 // Runs forward propagation of activations on the input line.
 // See NetworkCpp for a detailed discussion of the arguments.
 void Parallel::Forward(bool debug, const NetworkIO& input,
@@ -57,15 +75,17 @@ void Parallel::Forward(bool debug, const NetworkIO& input,
     debug = false;
   }
   int stack_size = stack_.size();
-  if (type_ == NT_PAR_2D_LSTM) {
-    // Special case, run parallel in parallel.
+  int num_threads = NumStackThreads(scratch);
+  if (type_ == NT_PAR_2D_LSTM || num_threads > 1) {
+    // Special case, run parallel in parallel. The members share the scratch,
+    // which is safe to use from multiple threads.
     GenericVector<NetworkScratch::IO> results;
     results.init_to_size(stack_size, NetworkScratch::IO());
     for (int i = 0; i < stack_size; ++i) {
       results[i].Resize(input, stack_[i]->NumOutputs(), scratch);
     }
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(stack_size)
+#pragma omp parallel for num_threads(num_threads)
 #endif
     for (int i = 0; i < stack_size; ++i) {
       stack_[i]->Forward(debug, input, nullptr, scratch, results[i]);
@@ -73,6 +93,7 @@ void Parallel::Forward(bool debug, const NetworkIO& input,
     // Now pack all the results (serially) into the output.
     int out_offset = 0;
     output->Resize(*results[0], NumOutputs());
+    if (output->int_mode()) output->set_int_range(int_range_);
     for (int i = 0; i < stack_size; ++i) {
       out_offset = output->CopyPacking(*results[i], out_offset);
     }
@@ -94,6 +115,7 @@ void Parallel::Forward(bool debug, const NetworkIO& input,
       // All networks must have the same output width
       if (i == 0) {
         output->Resize(*result, NumOutputs());
+        if (output->int_mode()) output->set_int_range(int_range_);
       } else {
         ASSERT_HOST(result->Width() == output->Width());
       }
@@ -117,7 +139,8 @@ bool Parallel::Backward(bool debug, const NetworkIO& fwd_deltas,
     debug = false;
   }
   int stack_size = stack_.size();
-  if (type_ == NT_PAR_2D_LSTM) {
+  int num_threads = NumStackThreads(scratch);
+  if (type_ == NT_PAR_2D_LSTM || num_threads > 1) {
     // Special case, run parallel in parallel.
     GenericVector<NetworkScratch::IO> in_deltas, out_deltas;
     in_deltas.init_to_size(stack_size, NetworkScratch::IO());
@@ -132,7 +155,7 @@ bool Parallel::Backward(bool debug, const NetworkIO& fwd_deltas,
       feature_offset += num_features;
     }
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(stack_size)
+#pragma omp parallel for num_threads(num_threads)
 #endif
     for (int i = 0; i < stack_size; ++i) {
       stack_[i]->Backward(debug, *in_deltas[i], scratch,
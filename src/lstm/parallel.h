@@ -74,6 +74,11 @@ class Parallel : public Plumbing {
                 NetworkIO* back_deltas) override;
 
  private:
+  // Returns the number of threads to run the stack members on concurrently.
+  // The members of a 2-d LSTM quad run in parallel by default, and those of
+  // a 1-d LSTM pair only if more threads are requested through the scratch.
+  int NumStackThreads(const NetworkScratch* scratch) const;
+
   // If *this is a NT_REPLICATED, then it feeds a replicated network with
   // identical inputs, and it would be extremely wasteful for them to each
   // calculate and store the same transpose of the inputs, so Parallel does it
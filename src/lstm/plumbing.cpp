@@ -19,6 +19,8 @@
 
 #include "plumbing.h"
 
+#include <algorithm>  // for std::max
+
 namespace tesseract {
 
 // ni_ and no_ will be set by AddToStack.
@@ -65,9 +67,48 @@ int Plumbing::RemapOutputs(int old_no, const std::vector<int>& code_map) {
 }
 
 // Converts a float network to an int network.
-void Plumbing::ConvertToInt() {
+// Each member gets the same input, and the output range is the largest of
+// theirs, so that a Parallel can pack them all into one output.
+float Plumbing::ConvertToInt(float input_range) {
+  int_range_ = 0.0f;
+  for (int i = 0; i < stack_.size(); ++i) {
+    int_range_ = std::max(int_range_, stack_[i]->ConvertToInt(input_range));
+  }
+  if (int_range_ <= 0.0f) int_range_ = input_range;
+  return int_range_;
+}
+
+// Starts or ends the calibration of the int ranges.
+void Plumbing::SetCalibrating(bool calibrating) {
+  Network::SetCalibrating(calibrating);
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->SetCalibrating(calibrating);
+}
+
+// Converts a double network to a single precision float network.
+void Plumbing::ConvertToFloat32() {
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->ConvertToFloat32();
+}
+
+// Prunes the smallest blocks of weights of all the members.
+int Plumbing::PruneWeights(double fraction) {
+  int num_pruned = 0;
+  for (int i = 0; i < stack_.size(); ++i)
+    num_pruned += stack_[i]->PruneWeights(fraction);
+  return num_pruned;
+}
+
+// Appends the shapes of the weight matrices used by Forward.
+void Plumbing::MatrixShapes(std::vector<std::pair<int, int>>* shapes) const {
   for (int i = 0; i < stack_.size(); ++i)
-    stack_[i]->ConvertToInt();
+    stack_[i]->MatrixShapes(shapes);
+}
+
+// Adds the bytes of the weight matrices to usage.
+void Plumbing::AddMemoryUsage(MemoryUsage* usage) const {
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->AddMemoryUsage(usage);
 }
 
 // Provides a pointer to a TRand for any networks that care to use it.
@@ -240,4 +281,27 @@ void Plumbing::CountAlternators(const Network& other, double* same,
     stack_[i]->CountAlternators(*plumbing->stack_[i], same, changed);
 }
 
+// Sets the weight deltas of *this to the means of those of others.
+void Plumbing::AverageDeltas(const std::vector<const Network*>& others) {
+  std::vector<const Network*> layers(others.size());
+  for (int i = 0; i < stack_.size(); ++i) {
+    for (size_t n = 0; n < others.size(); ++n) {
+      ASSERT_HOST(others[n]->type() == type_);
+      const auto* plumbing = static_cast<const Plumbing*>(others[n]);
+      ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+      layers[n] = plumbing->stack_[i];
+    }
+    stack_[i]->AverageDeltas(layers);
+  }
+}
+
+// Copies the weights of other, which has the same structure, to *this.
+void Plumbing::CopyWeights(const Network& other) {
+  ASSERT_HOST(other.type() == type_);
+  const auto* plumbing = static_cast<const Plumbing*>(&other);
+  ASSERT_HOST(plumbing->stack_.size() == stack_.size());
+  for (int i = 0; i < stack_.size(); ++i)
+    stack_[i]->CopyWeights(*plumbing->stack_[i]);
+}
+
 }  // namespace tesseract.
@@ -62,7 +62,19 @@ class Plumbing : public Network {
   int RemapOutputs(int old_no, const std::vector<int>& code_map) override;
 
   // Converts a float network to an int network.
-  void ConvertToInt() override;
+  float ConvertToInt(float input_range) override;
+  // Starts or ends the calibration of the int ranges.
+  void SetCalibrating(bool calibrating) override;
+
+  // Converts a double network to a single precision float network.
+  void ConvertToFloat32() override;
+  // Prunes the smallest blocks of weights. See Network::PruneWeights.
+  int PruneWeights(double fraction) override;
+
+  // Appends the shapes of the weight matrices used by Forward.
+  void MatrixShapes(std::vector<std::pair<int, int>>* shapes) const override;
+  // Adds the bytes of the weight matrices to usage.
+  void AddMemoryUsage(MemoryUsage* usage) const override;
 
   // Provides a pointer to a TRand for any networks that care to use it.
   // Note that randomizer is a borrowed pointer that should outlive the network
@@ -130,6 +142,10 @@ class Plumbing : public Network {
   // *changed.
   void CountAlternators(const Network& other, double* same,
                         double* changed) const override;
+  // Sets the weight deltas of *this to the means of those of others.
+  void AverageDeltas(const std::vector<const Network*>& others) override;
+  // Copies the weights of other, which has the same structure, to *this.
+  void CopyWeights(const Network& other) override;
 
  protected:
   // The networks.
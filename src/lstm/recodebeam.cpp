@@ -18,13 +18,16 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include "recodebeam.h"
+#include "counters.h"
 #include "networkio.h"
 #include "pageres.h"
+#include "simddetect.h"
 #include "unicharcompress.h"
 #include <deque>
-#include <map>
+#include <memory>
 #include <set>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include <algorithm>
@@ -44,6 +47,16 @@ const int RecodeBeamSearch::kBeamWidths[RecodedCharID::kMaxCodeLen + 1] = {
 
 static const char* kNodeContNames[] = {"Anything", "OnlyDup", "NoDup"};
 
+int64_t RecodeBeamSearch::MaxBytesPerTimestep() {
+  int64_t nodes = 0;
+  for (int length = 0; length < kNumLengths; ++length)
+    nodes += kBeamWidths[length];
+  // There is a heap of each length for each continuation, with and without
+  // a dawg.
+  nodes *= 2 * NC_COUNT;
+  return sizeof(RecodeBeam) + nodes * sizeof(RecodePair);
+}
+
 // Prints debug details of the node.
 void RecodeNode::Print(int null_char, const UNICHARSET& unicharset,
                        int depth) const {
@@ -71,6 +84,12 @@ RecodeBeamSearch::RecodeBeamSearch(const UnicharCompress& recoder,
       beam_size_(0),
       top_code_(-1),
       second_code_(-1),
+      collapse_margin_(0.0),
+      lstm_choice_mode_(0),
+      lattice_size_(0),
+      monitor_(nullptr),
+      cancelled_(false),
+      nodes_pushed_(0),
       dict_(dict),
       space_delimited_(true),
       is_simple_text_(simple_text),
@@ -82,57 +101,114 @@ RecodeBeamSearch::RecodeBeamSearch(const UnicharCompress& recoder,
 void RecodeBeamSearch::Decode(const NetworkIO& output, double dict_ratio,
                               double cert_offset, double worst_dict_cert,
                               const UNICHARSET* charset, int lstm_choice_mode) {
-  beam_size_ = 0;
-  int width = output.Width();
-  if (lstm_choice_mode)
-    timesteps.clear();
-  for (int t = 0; t < width; ++t) {
-    ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
-    DecodeStep(output.f(t), t, dict_ratio, cert_offset, worst_dict_cert,
-               charset);
-    if (lstm_choice_mode) {
-      SaveMostCertainChoices(output.f(t), output.NumFeatures(), charset, t);
-    }
-  }
+  BeginLine(lstm_choice_mode);
+  DecodeTimesteps(output, 0, output.Width(), dict_ratio, cert_offset,
+                  worst_dict_cert, charset);
 }
 void RecodeBeamSearch::Decode(const GENERIC_2D_ARRAY<float>& output,
                               double dict_ratio, double cert_offset,
                               double worst_dict_cert,
                               const UNICHARSET* charset) {
-  beam_size_ = 0;
+  BeginLine();
   int width = output.dim1();
   for (int t = 0; t < width; ++t) {
+    if (monitor_ != nullptr && monitor_->cancelled(0)) {
+      cancelled_ = true;
+      break;
+    }
     ComputeTopN(output[t], output.dim2(), kBeamWidths[0]);
     DecodeStep(output[t], t, dict_ratio, cert_offset, worst_dict_cert, charset);
+    if (collapse_margin_ > 0.0) CollapseIfConfident(output[t], beam_[t]);
+  }
+  CountEvent(COUNTER_BEAM_NODES, nodes_pushed_);
+  nodes_pushed_ = 0;
+}
+
+// Decodes the set of network outputs by taking the best code at each
+// timestep, storing the path for ExtractBestPaths.
+void RecodeBeamSearch::DecodeGreedy(const NetworkIO& output, double dict_ratio,
+                                    double cert_offset,
+                                    const UNICHARSET* charset) {
+  int width = output.Width();
+  cancelled_ = false;
+  greedy_nodes_.clear();
+  greedy_nodes_.reserve(width);
+  RecodedCharID prefix;
+  for (int t = 0; t < width; ++t) {
+    GreedyStep(output.f(t), output.NumFeatures(), dict_ratio, cert_offset,
+               charset, &prefix);
+  }
+  FinishGreedy();
+}
+void RecodeBeamSearch::DecodeGreedy(const GENERIC_2D_ARRAY<float>& output,
+                                    double dict_ratio, double cert_offset,
+                                    const UNICHARSET* charset) {
+  int width = output.dim1();
+  cancelled_ = false;
+  greedy_nodes_.clear();
+  greedy_nodes_.reserve(width);
+  RecodedCharID prefix;
+  for (int t = 0; t < width; ++t) {
+    GreedyStep(output[t], output.dim2(), dict_ratio, cert_offset, charset,
+               &prefix);
+  }
+  FinishGreedy();
+}
+
+// Starts the decoding of a new line.
+void RecodeBeamSearch::BeginLine(int lstm_choice_mode) {
+  beam_size_ = 0;
+  cancelled_ = false;
+  dawg_cache_.Clear();
+  lstm_choice_mode_ = lstm_choice_mode;
+  if (lstm_choice_mode) {
+    choices_.clear();
+    choice_starts_.assign(1, 0);
+  }
+}
+
+// Decodes the timesteps [start, end) of output, following on from those
+// already decoded since BeginLine.
+void RecodeBeamSearch::DecodeTimesteps(const NetworkIO& output, int start,
+                                       int end, double dict_ratio,
+                                       double cert_offset,
+                                       double worst_dict_cert,
+                                       const UNICHARSET* charset) {
+  ASSERT_HOST(start == beam_size_);
+  for (int t = start; t < end; ++t) {
+    // A huge line may take long, so the deadline is checked as it goes.
+    if (monitor_ != nullptr && monitor_->cancelled(0)) {
+      cancelled_ = true;
+      break;
+    }
+    ComputeTopN(output.f(t), output.NumFeatures(), kBeamWidths[0]);
+    DecodeStep(output.f(t), t, dict_ratio, cert_offset, worst_dict_cert,
+               charset);
+    if (collapse_margin_ > 0.0) CollapseIfConfident(output.f(t), beam_[t]);
+    if (lstm_choice_mode_) {
+      SaveMostCertainChoices(output.f(t), output.NumFeatures());
+    }
   }
+  CountEvent(COUNTER_BEAM_NODES, nodes_pushed_);
+  nodes_pushed_ = 0;
 }
 
 void RecodeBeamSearch::SaveMostCertainChoices(const float* outputs,
-                                             int num_outputs,
-                                             const UNICHARSET* charset,
-                                             int xCoord) {
-  std::vector<std::pair<const char*, float>> choices;
+                                              int num_outputs) {
   for (int i = 0; i < num_outputs; ++i) {
     if (outputs[i] >= 0.01f) {
-      const char* character;
+      UNICHAR_ID id;
       if (i + 2 >= num_outputs) {
-        character = "";
+        id = INVALID_UNICHAR_ID;
       } else if (i > 0) {
-        character = charset->id_to_unichar_ext(i + 2);
+        id = i + 2;
       } else {
-        character = charset->id_to_unichar_ext(i);
+        id = i;
       }
-      size_t pos = 0;
-      //order the possible choices within one timestep
-      //beginning with the most likely
-      while (choices.size() > pos && choices[pos].second > outputs[i]) {
-        pos++;
-      }
-      choices.insert(choices.begin() + pos,
-                    std::pair<const char*, float>(character, outputs[i]));
+      choices_.emplace_back(id, outputs[i]);
     }
   }
-  timesteps.push_back(choices);
+  choice_starts_.push_back(choices_.size());
 }
 
 // Returns the best path as labels/scores/xcoords similar to simple CTC.
@@ -245,66 +321,45 @@ void RecodeBeamSearch::ExtractBestPathAsWords(const TBOX& line_box,
         leading_space, line_box, word_start, word_end,
         std::min(space_cert, prev_space_cert), unicharset, xcoords, scale_factor);
     if (lstm_choice_mode) {
-      for (size_t i = timestepEndRaw; i < xcoords[word_end]; i++) {
-        word_res->raw_timesteps.push_back(timesteps[i]);
+      // Only the outputs of the word and the positions of its symbols are
+      // kept, as the choices are costly to make and mostly unused.
+      LSTMTimestepOutputs* outputs = &word_res->lstm_outputs;
+      int end = xcoords[word_end];
+      outputs->first = timestepEndRaw;
+      outputs->starts.push_back(0);
+      for (int i = timestepEndRaw; i < end; i++) {
+        outputs->choices.insert(outputs->choices.end(),
+                                choices_.begin() + choice_starts_[i],
+                                choices_.begin() + choice_starts_[i + 1]);
+        outputs->starts.push_back(outputs->choices.size());
       }
-      timestepEndRaw = xcoords[word_end];
+      timestepEndRaw = end;
       // Accumulated Timesteps (choice mode 2 processing)
-      float sum = 0;
-      std::vector<std::pair<const char*, float>> choice_pairs;
-      for (size_t i = timestepEnd_acc; i < xcoords[word_end]; i++) {
-        for (std::pair<const char*, float> choice : timesteps[i]) {
-          if (std::strcmp(choice.first, "")) {
-            sum += choice.second;
-            choice_pairs.push_back(choice);
-          }
-        }
-        if ((best_choices_acc.size() > 0 && i == std::get<1>(best_choices_acc.front()) - 1)
-            || i == xcoords[word_end]-1) {
-          std::map<const char*, float> summed_propabilities;
-          for (auto & choice_pair : choice_pairs) {
-            summed_propabilities[choice_pair.first] += choice_pair.second;
-          }
-          std::vector<std::pair<const char*, float>> accumulated_timestep;
-          for (auto& summed_propability : summed_propabilities) {
-            if(sum == 0) break;
-            summed_propability.second/=sum;
-            size_t pos = 0;
-            while (accumulated_timestep.size() > pos
-                   && accumulated_timestep[pos].second > summed_propability.second) {
-              pos++;
-            }
-            accumulated_timestep.insert(accumulated_timestep.begin() + pos,
-                                        std::pair<const char*,float>(summed_propability.first,
-                                        summed_propability.second));
-          }
+      outputs->accumulated_start = timestepEnd_acc;
+      for (int i = timestepEnd_acc; i < end; i++) {
+        if ((best_choices_acc.size() > 0 &&
+             i == std::get<1>(best_choices_acc.front()) - 1) ||
+            i == end - 1) {
+          outputs->accumulated_ends.push_back(i);
           if (best_choices_acc.size() > 0) {
             best_choices_acc.pop_front();
           }
-          choice_pairs.clear();
-          word_res->accumulated_timesteps.push_back(accumulated_timestep);
-          sum = 0;
         }
       }
-      timestepEnd_acc = xcoords[word_end];
+      timestepEnd_acc = end;
       //Symbol Step (choice mode 3 processing)
-      std::vector<std::vector<std::pair<const char*, float>>> currentSymbol;
-      for (size_t i = timestepEnd; i < xcoords[word_end]; i++) {
-        if (i == std::get<1>(best_choices.front())) {
-          if (currentSymbol.size() > 0) {
-            word_res->symbol_steps.push_back(currentSymbol);
-            currentSymbol.clear();
-          }
+      outputs->symbol_start = timestepEnd;
+      for (int i = timestepEnd; i < end; i++) {
+        if (best_choices.size() > 0 && i == std::get<1>(best_choices.front())) {
+          outputs->symbol_starts.push_back(i);
           const char* leadCharacter =
               unicharset->id_to_unichar_ext(std::get<0>(best_choices.front()));
           if (!strcmp(leadCharacter, " "))
             word_res->leadingSpace = true;
           if(best_choices.size()>1) best_choices.pop_front();
         }
-        currentSymbol.push_back(timesteps[i]);
       }
-      word_res->symbol_steps.push_back(currentSymbol);
-      timestepEnd = xcoords[word_end];
+      timestepEnd = end;
     }
     for (int i = word_start; i < word_end; ++i) {
       auto* choices = new BLOB_CHOICE_LIST;
@@ -324,6 +379,13 @@ void RecodeBeamSearch::ExtractBestPathAsWords(const TBOX& line_box,
     if (word_end < num_ids && unichar_ids[word_end] == UNICHAR_SPACE)
       ++word_end;
   }
+  if (lattice_size_ > 0) {
+    auto lattice = std::make_shared<std::vector<LSTMLatticeNode>>();
+    ExtractLattice(line_box, scale_factor, lattice.get());
+    for (int w = 0; w < words->size(); ++w) {
+      (*words)[w]->lstm_lattice = lattice;
+    }
+  }
 }
 
 // Generates debug output of the content of the beams after a Decode.
@@ -476,24 +538,123 @@ WERD_RES* RecodeBeamSearch::InitializeWord(bool leading_space,
   return word_res;
 }
 
+// Adds a node for the best code of outputs to greedy_nodes_, folding
+// duplicates as in CTC. prefix holds the codes of the unichar decoded so far.
+void RecodeBeamSearch::GreedyStep(const float* outputs, int num_outputs,
+                                  double dict_ratio, double cert_offset,
+                                  const UNICHARSET* charset,
+                                  RecodedCharID* prefix) {
+  const RecodeNode* prev =
+      greedy_nodes_.empty() ? nullptr : &greedy_nodes_.back();
+  int code = std::max_element(outputs, outputs + num_outputs) - outputs;
+  // As the non-dawg nodes of the beam search.
+  float cert =
+      (NetworkIO::ProbToCertainty(outputs[code]) + cert_offset) * dict_ratio;
+  int unichar_id = INVALID_UNICHAR_ID;
+  bool dup = prev != nullptr && prev->code == code && !is_simple_text_;
+  if (dup) {
+    unichar_id = prev->unichar_id;
+  } else if (code != null_char_) {
+    // Nulls may occur within a multi code sequence, so they don't end it.
+    RecodedCharID full_code(*prefix);
+    full_code.Set(prefix->length(), code);
+    unichar_id = recoder_.DecodeUnichar(full_code);
+    if (unichar_id == INVALID_UNICHAR_ID && prefix->length() > 0 &&
+        !IsCodePrefix(full_code)) {
+      // The code can't continue the sequence, so it starts a new one.
+      full_code.Truncate(0);
+      full_code.Set(0, code);
+      unichar_id = recoder_.DecodeUnichar(full_code);
+    }
+    if (unichar_id != INVALID_UNICHAR_ID) {
+      prefix->Truncate(0);
+      if (charset != nullptr && !charset->get_enabled(unichar_id))
+        unichar_id = INVALID_UNICHAR_ID;  // disabled by whitelist/blacklist
+    } else if (IsCodePrefix(full_code)) {
+      *prefix = full_code;
+    } else {
+      prefix->Truncate(0);
+    }
+  }
+  float score = prev == nullptr ? cert : prev->score + cert;
+  greedy_nodes_.emplace_back(code, unichar_id, TOP_CHOICE_PERM, false, false,
+                             false, dup, cert, score, prev, nullptr, 0);
+}
+
+// Reduces each heap of step to its best node, if the best output of the
+// timestep beats the second by at least collapse_margin_.
+void RecodeBeamSearch::CollapseIfConfident(const float* outputs,
+                                           RecodeBeam* step) {
+  if (top_code_ < 0) return;
+  float second = second_code_ >= 0 ? outputs[second_code_] : 0.0f;
+  if (outputs[top_code_] - second < collapse_margin_) return;
+  for (auto& heap : step->beams_) {
+    int size = heap.size();
+    if (size <= 1) continue;
+    int best = 0;
+    for (int i = 1; i < size; ++i) {
+      if (heap.get(i).key > heap.get(best).key) best = i;
+    }
+    RecodePair entry(heap.get(best));
+    heap.clear();
+    heap.Push(&entry);
+  }
+}
+
+// Puts the last node of greedy_nodes_ in a single beam, where
+// ExtractBestPaths finds it.
+void RecodeBeamSearch::FinishGreedy() {
+  beam_size_ = 0;
+  if (greedy_nodes_.empty()) return;
+  if (beam_.empty()) beam_.push_back(new RecodeBeam);
+  RecodeBeam* step = beam_[0];
+  step->Clear();
+  const RecodeNode& last = greedy_nodes_.back();
+  RecodePair entry(last.score, last);
+  step->beams_[BeamIndex(false, NC_ANYTHING, 0)].Push(&entry);
+  beam_size_ = 1;
+}
+
 // Fills top_n_flags_ with bools that are true iff the corresponding output
 // is one of the top_n.
 void RecodeBeamSearch::ComputeTopN(const float* outputs, int num_outputs,
                                    int top_n) {
-  top_n_flags_.init_to_size(num_outputs, TN_ALSO_RAN);
+  // Only the flags set by the previous timestep need to be reset.
+  if (top_n_flags_.size() != num_outputs) {
+    top_n_flags_.init_to_size(num_outputs, TN_ALSO_RAN);
+    top_certs_.init_to_size(num_outputs, 0.0f);
+  } else {
+    for (int code : top_n_codes_) top_n_flags_[code] = TN_ALSO_RAN;
+  }
+  top_n_codes_.clear();
   top_code_ = -1;
   second_code_ = -1;
   top_heap_.clear();
-  for (int i = 0; i < num_outputs; ++i) {
-    if (top_heap_.size() < top_n || outputs[i] > top_heap_.PeekTop().key) {
-      TopPair entry(outputs[i], i);
-      top_heap_.Push(&entry);
-      if (top_heap_.size() > top_n) top_heap_.Pop(&entry);
+  int i = 0;
+  for (; i < num_outputs && top_heap_.size() < top_n; ++i) {
+    TopPair entry(outputs[i], i);
+    top_heap_.Push(&entry);
+  }
+  // Once the heap is full, only the outputs above its minimum matter, and
+  // they are few, so the rest is skipped with a vectorized search if there is
+  // one.
+  for (; i < num_outputs; ++i) {
+    float threshold = top_heap_.PeekTop().key;
+    if (FindAbove != nullptr) {
+      i += FindAbove(outputs + i, num_outputs - i, threshold);
+      if (i == num_outputs) break;
+    } else if (!(outputs[i] > threshold)) {
+      continue;
     }
+    TopPair entry(outputs[i], i);
+    top_heap_.Push(&entry);
+    top_heap_.Pop(&entry);
   }
   while (!top_heap_.empty()) {
     TopPair entry;
     top_heap_.Pop(&entry);
+    top_n_codes_.push_back(entry.data);
+    top_certs_[entry.data] = NetworkIO::ProbToCertainty(entry.key);
     if (top_heap_.size() > 1) {
       top_n_flags_[entry.data] = TN_TOPN;
     } else {
@@ -505,6 +666,8 @@ void RecodeBeamSearch::ComputeTopN(const float* outputs, int num_outputs,
     }
   }
   top_n_flags_[null_char_] = TN_TOP2;
+  top_n_codes_.push_back(null_char_);
+  top_certs_[null_char_] = NetworkIO::ProbToCertainty(outputs[null_char_]);
 }
 
 // Adds the computation for the current time-step to the beam. Call at each
@@ -591,7 +754,6 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
                                        double worst_dict_cert,
                                        RecodeBeam* step) {
   RecodedCharID prefix;
-  RecodedCharID full_code;
   const RecodeNode* previous = prev;
   int length = LengthFromBeamsIndex(index);
   bool use_dawgs = IsDawgFromBeamsIndex(index);
@@ -603,14 +765,13 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
     }
     if (previous != nullptr) {
       prefix.Set(p, previous->code);
-      full_code.Set(p, previous->code);
     }
   }
   if (prev != nullptr && !is_simple_text_) {
     if (top_n_flags_[prev->code] == top_n_flag) {
       if (prev_cont != NC_NO_DUP) {
         float cert =
-            NetworkIO::ProbToCertainty(outputs[prev->code]) + cert_offset;
+            CodeCertainty(outputs, prev->code, top_n_flag) + cert_offset;
         PushDupOrNoDawgIfBetter(length, true, prev->code, prev->unichar_id,
                                 cert, worst_dict_cert, dict_ratio, use_dawgs,
                                 NC_ANYTHING, prev, step);
@@ -631,22 +792,24 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
       // Allow nulls within multi code sequences, as the nulls within are not
       // explicitly included in the code sequence.
       float cert =
-          NetworkIO::ProbToCertainty(outputs[null_char_]) + cert_offset;
+          CodeCertainty(outputs, null_char_, top_n_flag) + cert_offset;
       PushDupOrNoDawgIfBetter(length, false, null_char_, INVALID_UNICHAR_ID,
                               cert, worst_dict_cert, dict_ratio, use_dawgs,
                               NC_ANYTHING, prev, step);
     }
   }
-  const GenericVector<int>* final_codes = recoder_.GetFinalCodes(prefix);
+  // Look up the prefix once, so its continuations are read from the decoding
+  // trie without decoding each code.
+  int prefix_state = recoder_.GetPrefixState(prefix);
+  const GenericVector<int>* final_codes = recoder_.GetFinalCodes(prefix_state);
   if (final_codes != nullptr) {
     for (int i = 0; i < final_codes->size(); ++i) {
       int code = (*final_codes)[i];
       if (top_n_flags_[code] != top_n_flag) continue;
       if (prev != nullptr && prev->code == code && !is_simple_text_) continue;
-      float cert = NetworkIO::ProbToCertainty(outputs[code]) + cert_offset;
+      float cert = CodeCertainty(outputs, code, top_n_flag) + cert_offset;
       if (cert < kMinCertainty && code != null_char_) continue;
-      full_code.Set(length, code);
-      int unichar_id = recoder_.DecodeUnichar(full_code);
+      int unichar_id = recoder_.GetFinalUnichar(prefix_state, i);
       // Map the null char to INVALID.
       if (length == 0 && code == null_char_) unichar_id = INVALID_UNICHAR_ID;
       if (unichar_id != INVALID_UNICHAR_ID &&
@@ -669,13 +832,13 @@ void RecodeBeamSearch::ContinueContext(const RecodeNode* prev, int index,
       }
     }
   }
-  const GenericVector<int>* next_codes = recoder_.GetNextCodes(prefix);
+  const GenericVector<int>* next_codes = recoder_.GetNextCodes(prefix_state);
   if (next_codes != nullptr) {
     for (int i = 0; i < next_codes->size(); ++i) {
       int code = (*next_codes)[i];
       if (top_n_flags_[code] != top_n_flag) continue;
       if (prev != nullptr && prev->code == code && !is_simple_text_) continue;
-      float cert = NetworkIO::ProbToCertainty(outputs[code]) + cert_offset;
+      float cert = CodeCertainty(outputs, code, top_n_flag) + cert_offset;
       PushDupOrNoDawgIfBetter(length + 1, false, code, INVALID_UNICHAR_ID, cert,
                               worst_dict_cert, dict_ratio, use_dawgs,
                               NC_ANYTHING, prev, step);
@@ -783,13 +946,13 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
              dict_->getUnicharset().IsSpaceDelimited(unichar_id)) {
     return;  // Can't break words between space delimited chars.
   }
-  DawgPositionVector initial_dawgs;
-  auto* updated_dawgs = new DawgPositionVector;
-  DawgArgs dawg_args(&initial_dawgs, updated_dawgs, NO_PERM);
+  DawgArgs dawg_args(nullptr, nullptr, NO_PERM);
+  dawg_args.transition_cache = &dawg_cache_;
   bool word_start = false;
   if (uni_prev == nullptr) {
     // Starting from beginning of line.
-    dict_->default_dawgs(&initial_dawgs, false);
+    dawg_args.active_dawgs = step->NewDawgs();
+    dict_->default_dawgs(dawg_args.active_dawgs, false);
     word_start = true;
   } else if (uni_prev->dawgs != nullptr) {
     // Continuing a previous dict word.
@@ -798,6 +961,7 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
   } else {
     return;  // Can't continue if not a dict word.
   }
+  dawg_args.updated_dawgs = step->NewDawgs();
   auto permuter = static_cast<PermuterType>(
       dict_->def_letter_is_okay(&dawg_args,
                                 dict_->getUnicharset(), unichar_id, false));
@@ -814,8 +978,6 @@ void RecodeBeamSearch::ContinueDawg(int code, int unichar_id, float cert,
       PushHeapIfBetter(kBeamWidths[0], code, unichar_id, permuter, false,
                        word_start, true, false, cert, prev, nullptr, nodawg_heap);
     }
-  } else {
-    delete updated_dawgs;
   }
 }
 
@@ -832,7 +994,7 @@ void RecodeBeamSearch::PushInitialDawgIfBetter(int code, int unichar_id,
   float score = cert;
   if (prev != nullptr) score += prev->score;
   if (best_initial_dawg->code < 0 || score > best_initial_dawg->score) {
-    auto* initial_dawgs = new DawgPositionVector;
+    DawgPositionVector* initial_dawgs = step->NewDawgs();
     dict_->default_dawgs(initial_dawgs, false);
     RecodeNode node(code, unichar_id, permuter, true, start, end, false, cert,
                     score, prev, initial_dawgs,
@@ -884,10 +1046,8 @@ void RecodeBeamSearch::PushHeapIfBetter(int max_size, int code, int unichar_id,
     if (UpdateHeapIfMatched(&node, heap)) return;
     RecodePair entry(score, node);
     heap->Push(&entry);
-    ASSERT_HOST(entry.data.dawgs == nullptr);
+    ++nodes_pushed_;
     if (heap->size() > max_size) heap->Pop(&entry);
-  } else {
-    delete d;
   }
 }
 
@@ -901,7 +1061,7 @@ void RecodeBeamSearch::PushHeapIfBetter(int max_size, RecodeNode* node,
     }
     RecodePair entry(node->score, *node);
     heap->Push(&entry);
-    ASSERT_HOST(entry.data.dawgs == nullptr);
+    ++nodes_pushed_;
     if (heap->size() > max_size) heap->Pop(&entry);
   }
 }
@@ -993,6 +1153,75 @@ void RecodeBeamSearch::ExtractBestPaths(
   ExtractPath(best_node, best_nodes);
 }
 
+// Extracts the pruned lattice as set by SetLatticeSize, in order of
+// timestep and then decreasing score, with the timesteps placed in the image
+// as the words of ExtractBestPathAsWords.
+void RecodeBeamSearch::ExtractLattice(
+    const TBOX& line_box, float scale_factor,
+    std::vector<LSTMLatticeNode>* lattice) const {
+  lattice->clear();
+  // The timestep of each node to keep. The prev of every node is in the
+  // timestep before, so all the nodes on the paths of the best nodes of a
+  // timestep can be added by backtracking until one that is already kept.
+  std::unordered_map<const RecodeNode*, int> timesteps;
+  std::vector<const RecodeNode*> step_nodes;
+  for (int t = 0; t < beam_size_; ++t) {
+    step_nodes.clear();
+    for (const auto& heap : beam_[t]->beams_) {
+      for (int h = 0; h < heap.size(); ++h) {
+        step_nodes.push_back(&heap.get(h).data);
+      }
+    }
+    int num_nodes = std::min(lattice_size_, static_cast<int>(step_nodes.size()));
+    std::partial_sort(step_nodes.begin(), step_nodes.begin() + num_nodes,
+                      step_nodes.end(),
+                      [](const RecodeNode* a, const RecodeNode* b) {
+                        return a->score > b->score;
+                      });
+    for (int i = 0; i < num_nodes; ++i) {
+      int node_t = t;
+      for (const RecodeNode* node = step_nodes[i];
+           node != nullptr && timesteps.emplace(node, node_t).second;
+           node = node->prev) {
+        --node_t;
+      }
+    }
+  }
+  std::vector<std::pair<int, const RecodeNode*>> nodes;
+  nodes.reserve(timesteps.size());
+  for (const auto& node : timesteps) nodes.emplace_back(node.second, node.first);
+  std::sort(nodes.begin(), nodes.end(),
+            [](const std::pair<int, const RecodeNode*>& a,
+               const std::pair<int, const RecodeNode*>& b) {
+              if (a.first != b.first) return a.first < b.first;
+              if (a.second->score != b.second->score)
+                return a.second->score > b.second->score;
+              return a.second->code < b.second->code;
+            });
+  // Index in lattice of each node.
+  std::unordered_map<const RecodeNode*, int> indices;
+  lattice->reserve(nodes.size());
+  for (const auto& entry : nodes) {
+    const RecodeNode* node = entry.second;
+    LSTMLatticeNode lattice_node;
+    auto prev = indices.find(node->prev);
+    lattice_node.prev = prev == indices.end() ? -1 : prev->second;
+    lattice_node.timestep = entry.first;
+    lattice_node.x =
+        line_box.left() + IntCastRounded(entry.first * scale_factor);
+    lattice_node.code = node->code;
+    lattice_node.unichar_id = node->unichar_id;
+    lattice_node.certainty = node->certainty;
+    lattice_node.score = node->score;
+    lattice_node.permuter = node->permuter;
+    lattice_node.start_of_word = node->start_of_word;
+    lattice_node.end_of_word = node->end_of_word;
+    lattice_node.duplicate = node->duplicate;
+    indices[node] = lattice->size();
+    lattice->push_back(lattice_node);
+  }
+}
+
 // Helper backtracks through the lattice from the given node, storing the
 // path and reversing it.
 void RecodeBeamSearch::ExtractPath(
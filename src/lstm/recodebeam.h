@@ -25,6 +25,8 @@
 #include "genericheap.h"
 #include "kdpair.h"
 #include "networkio.h"
+#include "ocrclass.h"
+#include "publictypes.h"
 #include "ratngs.h"
 #include "unicharcompress.h"
 #include <deque>
@@ -118,22 +120,6 @@ struct RecodeNode {
         prev(p),
         dawgs(d),
         code_hash(hash) {}
-  // NOTE: If we could use C++11, then this would be a move constructor.
-  // Instead we have copy constructor that does a move!! This is because we
-  // don't want to copy the whole DawgPositionVector each time, and true
-  // copying isn't necessary for this struct. It does get moved around a lot
-  // though inside the heap and during heap push, hence the move semantics.
-  RecodeNode(RecodeNode& src) : dawgs(nullptr) {
-    *this = src;
-    ASSERT_HOST(src.dawgs == nullptr);
-  }
-  RecodeNode& operator=(RecodeNode& src) {
-    delete dawgs;
-    memcpy(this, &src, sizeof(src));
-    src.dawgs = nullptr;
-    return *this;
-  }
-  ~RecodeNode() { delete dawgs; }
   // Prints details of the node.
   void Print(int null_char, const UNICHARSET& unicharset, int depth) const;
 
@@ -165,7 +151,8 @@ struct RecodeNode {
   float score;
   // The previous node in this chain. Borrowed pointer.
   const RecodeNode* prev;
-  // The currently active dawgs at this position. Owned pointer.
+  // The currently active dawgs at this position. Borrowed pointer, owned by
+  // the RecodeBeam of the same timestep, so the nodes are simple to copy.
   DawgPositionVector* dawgs;
   // A hash of all codes in the prefix and this->code as well. Used for
   // duplicate path removal.
@@ -190,6 +177,49 @@ class RecodeBeamSearch {
   void Decode(const GENERIC_2D_ARRAY<float>& output, double dict_ratio,
               double cert_offset, double worst_dict_cert,
               const UNICHARSET* charset);
+  // As Decode, a part at a time, so the decoding can follow the network
+  // outputs as they are produced. BeginLine starts a new line, and
+  // DecodeTimesteps then decodes the timesteps [start, end) of output, which
+  // must follow on from those already decoded. Once all the timesteps are
+  // decoded, the results are available as after Decode.
+  void BeginLine(int lstm_choice_mode = 0);
+  void DecodeTimesteps(const NetworkIO& output, int start, int end,
+                       double dict_ratio, double cert_offset,
+                       double worst_dict_cert, const UNICHARSET* charset);
+
+  // Decodes the set of network outputs much faster than Decode, by taking
+  // just the best code at each timestep and folding the codes as in CTC,
+  // without the dictionary or the alternatives for lstm_choice_mode. The best
+  // path is stored for the ExtractBestPath* functions as after Decode.
+  // If charset is not null, its disabled unichars are dropped from the path.
+  void DecodeGreedy(const NetworkIO& output, double dict_ratio,
+                    double cert_offset, const UNICHARSET* charset);
+  void DecodeGreedy(const GENERIC_2D_ARRAY<float>& output, double dict_ratio,
+                    double cert_offset, const UNICHARSET* charset);
+
+  // Sets the min margin between the best two outputs of a timestep at which
+  // Decode keeps only the best node of each beam, as the alternatives are
+  // unlikely to recover. The beam stays at full width on ambiguous
+  // timesteps. 0 disables the collapse.
+  void SetCollapseMargin(double margin) {
+    collapse_margin_ = margin;
+  }
+  // Sets the max number of nodes of each timestep kept in the lattice that
+  // ExtractBestPathAsWords gives to the words, along with all the nodes on
+  // their paths. 0 keeps no lattice.
+  void SetLatticeSize(int size) {
+    lattice_size_ = size;
+  }
+  // Sets the monitor whose deadline and cancel function stop Decode at the
+  // timestep reached, leaving an incomplete line that must not be extracted.
+  // nullptr for none.
+  void SetMonitor(const ETEXT_DESC* monitor) {
+    monitor_ = monitor;
+  }
+  // Returns true if the last line stopped early for the monitor.
+  bool Cancelled() const {
+    return cancelled_;
+  }
 
   // Returns the best path as labels/scores/xcoords similar to simple CTC.
   void ExtractBestPathAsLabels(GenericVector<int>* labels,
@@ -211,10 +241,6 @@ class RecodeBeamSearch {
   // Generates debug output of the content of the beams after a Decode.
   void DebugBeams(const UNICHARSET& unicharset) const;
 
-  // Stores the alternative characters of every timestep together with their
-  // probability.
-  std::vector< std::vector<std::pair<const char*, float>>> timesteps;
-
   // Clipping value for certainty inside Tesseract. Reflects the minimum value
   // of certainty that will be returned by ExtractBestPathAsUnicharIds.
   // Supposedly on a uniform scale that can be compared across languages and
@@ -237,6 +263,9 @@ class RecodeBeamSearch {
   static int BeamIndex(bool is_dawg, NodeContinuation cont, int length) {
     return (is_dawg * NC_COUNT + cont) * kNumLengths + length;
   }
+  // Returns the bytes of the beam of a timestep with all its heaps full,
+  // which bounds the memory that the search of a line takes per timestep.
+  static int64_t MaxBytesPerTimestep();
 
  private:
   // Struct for the Re-encode beam search. This struct holds the data for
@@ -252,6 +281,16 @@ class RecodeBeamSearch {
       for (auto & best_initial_dawg : best_initial_dawgs_) {
         best_initial_dawg = empty;
       }
+      num_dawgs_ = 0;
+    }
+    // Returns an empty DawgPositionVector for a node of this step. The
+    // vectors are only freed with the step, so it can be reused for another
+    // line without allocating them again.
+    DawgPositionVector* NewDawgs() {
+      if (num_dawgs_ == dawgs_.size()) dawgs_.push_back(new DawgPositionVector);
+      DawgPositionVector* dawgs = dawgs_[num_dawgs_++];
+      dawgs->clear();
+      return dawgs;
     }
 
     // A separate beam for each combination of code length,
@@ -270,6 +309,10 @@ class RecodeBeamSearch {
     // best one here and push it on the heap, if it qualifies, after processing
     // all of the step.
     RecodeNode best_initial_dawgs_[NC_COUNT];
+    // The dawgs of the nodes of this step, of which the first num_dawgs_ are
+    // in use.
+    PointerVector<DawgPositionVector> dawgs_;
+    int num_dawgs_ = 0;
   };
   using TopPair = KDPairInc<float, int>;
 
@@ -293,9 +336,36 @@ class RecodeBeamSearch {
                            const GenericVector<int>& xcoords,
                            float scale_factor);
 
+  // Adds a node for the best code of outputs to greedy_nodes_, folding
+  // duplicates as in CTC. prefix holds the codes of the unichar decoded so
+  // far, and is updated.
+  void GreedyStep(const float* outputs, int num_outputs, double dict_ratio,
+                  double cert_offset, const UNICHARSET* charset,
+                  RecodedCharID* prefix);
+  // Returns true if code is the start of the code of a unichar.
+  bool IsCodePrefix(const RecodedCharID& code) const {
+    return recoder_.GetNextCodes(code) != nullptr ||
+           recoder_.GetFinalCodes(code) != nullptr;
+  }
+  // Reduces each heap of step to its best node, if the best output of the
+  // timestep beats the second by at least collapse_margin_.
+  void CollapseIfConfident(const float* outputs, RecodeBeam* step);
+  // Puts the last node of greedy_nodes_ in a single beam, where
+  // ExtractBestPaths finds it.
+  void FinishGreedy();
+
   // Fills top_n_flags_ with bools that are true iff the corresponding output
-  // is one of the top_n.
+  // is one of the top_n, and top_certs_ with the certainties of the top_n.
   void ComputeTopN(const float* outputs, int num_outputs, int top_n);
+  // Returns the certainty of the output for code, whose top_n_flags_ is
+  // top_n_flag, from top_certs_ if it is one of the top_n, or else from
+  // outputs. Each of the nodes of the previous beam may continue with the
+  // same top codes, so their logs are only taken once per timestep.
+  float CodeCertainty(const float* outputs, int code,
+                      TopNState top_n_flag) const {
+    return top_n_flag == TN_ALSO_RAN ? NetworkIO::ProbToCertainty(outputs[code])
+                                     : top_certs_[code];
+  }
 
   // Adds the computation for the current time-step to the beam. Call at each
   // time-step in sequence from left to right. outputs is the activation vector
@@ -304,8 +374,10 @@ class RecodeBeamSearch {
                   double cert_offset, double worst_dict_cert,
                   const UNICHARSET* charset, bool debug = false);
 
-  //Saves the most certain choices for the current time-step
-  void SaveMostCertainChoices(const float* outputs, int num_outputs, const UNICHARSET* charset, int xCoord);
+  // Saves the most certain choices for the current time-step, to be made
+  // into the per-timestep choices of the words only when they are used. See
+  // WERD_RES::ComputeLSTMChoices.
+  void SaveMostCertainChoices(const float* outputs, int num_outputs);
 
   // Adds to the appropriate beams the legal (according to recoder)
   // continuations of context prev, which is from the given index to beams_,
@@ -358,6 +430,11 @@ class RecodeBeamSearch {
   // the recoder can decode the code sequence back to a sequence of unichar-ids.
   void ExtractBestPaths(GenericVector<const RecodeNode*>* best_nodes,
                         GenericVector<const RecodeNode*>* second_nodes) const;
+  // Extracts the pruned lattice as set by SetLatticeSize, in order of
+  // timestep and then decreasing score, with the timesteps placed in the image
+  // as the words of ExtractBestPathAsWords.
+  void ExtractLattice(const TBOX& line_box, float scale_factor,
+                      std::vector<LSTMLatticeNode>* lattice) const;
   // Helper backtracks through the lattice from the given node, storing the
   // path and reversing it.
   void ExtractPath(const RecodeNode* node,
@@ -381,16 +458,44 @@ class RecodeBeamSearch {
   PointerVector<RecodeBeam> beam_;
   // The number of timesteps valid in beam_;
   int beam_size_;
+  // The path found by DecodeGreedy, reserved for the whole line so that the
+  // prev pointers stay valid.
+  std::vector<RecodeNode> greedy_nodes_;
   // A flag to indicate which outputs are the top-n choices. Current timestep
   // only.
   GenericVector<TopNState> top_n_flags_;
+  // The codes whose top_n_flags_ are set, so they can be reset cheaply.
+  std::vector<int> top_n_codes_;
+  // Certainties of the outputs, valid only for top_n_codes_.
+  GenericVector<float> top_certs_;
   // A record of the highest and second scoring codes.
   int top_code_;
   int second_code_;
+  // Margin at which the beam is collapsed. See SetCollapseMargin.
+  double collapse_margin_;
+  // The lstm_choice_mode of the current line. See BeginLine.
+  int lstm_choice_mode_;
+  // Number of nodes of each timestep to keep in the lattice. See
+  // SetLatticeSize.
+  int lattice_size_;
+  // See SetMonitor. Not owned.
+  const ETEXT_DESC* monitor_;
+  // True if the current line stopped early for monitor_.
+  bool cancelled_;
+  // Nodes pushed to the heaps since the last CountEvent, which is made once
+  // per call of a Decode method rather than per node.
+  int64_t nodes_pushed_;
+  // The choices saved by SaveMostCertainChoices for each timestep t of the
+  // line, as choices_[choice_starts_[t], choice_starts_[t + 1]).
+  std::vector<std::pair<UNICHAR_ID, float>> choices_;
+  std::vector<int> choice_starts_;
   // Heap used to compute the top_n_flags_.
   GenericHeap<TopPair> top_heap_;
   // Borrowed pointer to the dictionary to use in the search.
   Dict* dict_;
+  // Cache of the transitions looked up in the dawgs of dict_ on the current
+  // line.
+  DawgTransitionCache dawg_cache_;
   // True if the language is space-delimited, which is true for most languages
   // except chi*, jpn, tha.
   bool space_delimited_;
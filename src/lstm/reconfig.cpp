@@ -18,6 +18,8 @@
 
 #include "reconfig.h"
 
+#include <algorithm>  // for std::min
+
 namespace tesseract {
 
 Reconfig::Reconfig(const STRING& name, int ni, int x_scale, int y_scale)
@@ -67,21 +69,22 @@ void Reconfig::Forward(bool debug, const NetworkIO& input,
                        const TransposedArray* input_transpose,
                        NetworkScratch* scratch, NetworkIO* output) {
   output->ResizeScaled(input, x_scale_, y_scale_, no_);
-  back_map_ = input.stride_map();
+  if (IsTraining()) back_map_ = input.stride_map();
   StrideMap::Index dest_index(output->stride_map());
   do {
     int out_t = dest_index.t();
     StrideMap::Index src_index(input.stride_map(), dest_index.index(FD_BATCH),
                                dest_index.index(FD_HEIGHT) * y_scale_,
                                dest_index.index(FD_WIDTH) * x_scale_);
+    int num_x = std::min(x_scale_, src_index.MaxIndexOfDim(FD_WIDTH) + 1 -
+                                       src_index.index(FD_WIDTH));
+    int num_y = std::min(y_scale_, src_index.MaxIndexOfDim(FD_HEIGHT) + 1 -
+                                       src_index.index(FD_HEIGHT));
     // Stack x_scale_ groups of y_scale_ inputs together.
-    for (int x = 0; x < x_scale_; ++x) {
-      for (int y = 0; y < y_scale_; ++y) {
-        StrideMap::Index src_xy(src_index);
-        if (src_xy.AddOffset(x, FD_WIDTH) && src_xy.AddOffset(y, FD_HEIGHT)) {
-          output->CopyTimeStepGeneral(out_t, (x * y_scale_ + y) * ni_, ni_,
-                                      input, src_xy.t(), 0);
-        }
+    for (int x = 0; x < num_x; ++x) {
+      for (int y = 0; y < num_y; ++y) {
+        output->CopyTimeStepGeneral(out_t, (x * y_scale_ + y) * ni_, ni_,
+                                    input, src_index.OffsetT(x, y), 0);
       }
     }
   } while (dest_index.Increment());
@@ -100,14 +103,16 @@ bool Reconfig::Backward(bool debug, const NetworkIO& fwd_deltas,
                                 src_index.index(FD_BATCH),
                                 src_index.index(FD_HEIGHT) * y_scale_,
                                 src_index.index(FD_WIDTH) * x_scale_);
+    int num_x = std::min(x_scale_, dest_index.MaxIndexOfDim(FD_WIDTH) + 1 -
+                                       dest_index.index(FD_WIDTH));
+    int num_y = std::min(y_scale_, dest_index.MaxIndexOfDim(FD_HEIGHT) + 1 -
+                                       dest_index.index(FD_HEIGHT));
     // Unstack x_scale_ groups of y_scale_ inputs that are together.
-    for (int x = 0; x < x_scale_; ++x) {
-      for (int y = 0; y < y_scale_; ++y) {
-        StrideMap::Index dest_xy(dest_index);
-        if (dest_xy.AddOffset(x, FD_WIDTH) && dest_xy.AddOffset(y, FD_HEIGHT)) {
-          back_deltas->CopyTimeStepGeneral(dest_xy.t(), 0, ni_, fwd_deltas,
-                                           in_t, (x * y_scale_ + y) * ni_);
-        }
+    for (int x = 0; x < num_x; ++x) {
+      for (int y = 0; y < num_y; ++y) {
+        back_deltas->CopyTimeStepGeneral(dest_index.OffsetT(x, y), 0, ni_,
+                                         fwd_deltas, in_t,
+                                         (x * y_scale_ + y) * ni_);
       }
     }
   } while (src_index.Increment());
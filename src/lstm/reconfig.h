@@ -52,6 +52,8 @@ class Reconfig : public Network {
   // the last used scale factor. Call it before any forward, and it will return
   // the minimum scale factor of the paths through the GlobalMinimax.
   int XScaleFactor() const override;
+  int x_scale() const { return x_scale_; }
+  int y_scale() const { return y_scale_; }
 
   // Writes to the given file. Returns false in case of error.
   bool Serialize(TFile* fp) const override;
@@ -20,6 +20,7 @@
 
 #include <cstdio>
 
+#include "lstm.h"
 #include "networkscratch.h"
 
 namespace tesseract {
@@ -54,6 +55,14 @@ void Reversed::SetNetwork(Network* network) {
 void Reversed::Forward(bool debug, const NetworkIO& input,
                        const TransposedArray* input_transpose,
                        NetworkScratch* scratch, NetworkIO* output) {
+  if (type_ == NT_XREVERSED && stack_[0]->type() == NT_LSTM) {
+    // Let the LSTM run right to left instead of reversing the data twice.
+    auto* lstm = static_cast<LSTM*>(stack_[0]);
+    if (lstm->CanForwardXReversed()) {
+      lstm->ForwardXReversed(debug, input, scratch, output);
+      return;
+    }
+  }
   NetworkScratch::IO rev_input(input, scratch);
   ReverseData(input, rev_input);
   NetworkScratch::IO rev_output(input, scratch);
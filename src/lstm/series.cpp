@@ -18,7 +18,10 @@
 
 #include "series.h"
 
+#include "convolve.h"
 #include "fullyconnected.h"
+#include "layerprofile.h"
+#include "maxpool.h"
 #include "networkscratch.h"
 #include "scrollview.h"
 #include "tprintf.h"
@@ -73,6 +76,16 @@ int Series::RemapOutputs(int old_no, const std::vector<int>& code_map) {
   return num_weights_;
 }
 
+// Converts a float network to an int network, with the output range of
+// each layer given as the input range of the next.
+float Series::ConvertToInt(float input_range) {
+  for (int i = 0; i < stack_.size(); ++i) {
+    input_range = stack_[i]->ConvertToInt(input_range);
+  }
+  int_range_ = input_range;
+  return int_range_;
+}
+
 // Sets needs_to_backprop_ to needs_backprop and returns true if
 // needs_backprop || any weights in this network so the next layer forward
 // can be told to produce backprop for this layer if needed.
@@ -102,6 +115,19 @@ void Series::CacheXScaleFactor(int factor) {
   stack_[0]->CacheXScaleFactor(factor);
 }
 
+// Returns true if network is a Series of just a Convolve and a non-softmax
+// FullyConnected, as built for a C spec, set up for inference, so that it can
+// run fused with a Maxpool that follows it.
+static bool IsConvSeries(const Network* network) {
+  if (network->type() != NT_SERIES || network->IsTraining()) return false;
+  const PointerVector<Network>& stack =
+      static_cast<const Series*>(network)->stack();
+  return stack.size() == 2 && stack[0]->type() == NT_CONVOLVE &&
+         FullyConnected::IsFullyConnectedType(stack[1]->type()) &&
+         stack[1]->type() != NT_SOFTMAX && !stack[0]->IsTraining() &&
+         !stack[1]->IsTraining() && !stack[1]->IsCalibrating();
+}
+
 // Runs forward propagation of activations on the input line.
 // See NetworkCpp for a detailed discussion of the arguments.
 void Series::Forward(bool debug, const NetworkIO& input,
@@ -109,18 +135,55 @@ void Series::Forward(bool debug, const NetworkIO& input,
                      NetworkScratch* scratch, NetworkIO* output) {
   int stack_size = stack_.size();
   ASSERT_HOST(stack_size > 1);
+  // An Input layer only copies its input, which isn't needed for inference.
+  int first = !IsTraining() && stack_[0]->type() == NT_INPUT ? 1 : 0;
   // Revolving intermediate buffers.
   NetworkScratch::IO buffer1(input, scratch);
   NetworkScratch::IO buffer2(input, scratch);
   // Run each network in turn, giving the output of n as the input to n + 1,
   // with the final network providing the real output.
-  stack_[0]->Forward(debug, input, input_transpose, scratch, buffer1);
-  for (int i = 1; i < stack_size; i += 2) {
-    stack_[i]->Forward(debug, *buffer1, nullptr, scratch,
-                       i + 1 < stack_size ? buffer2 : output);
-    if (i + 1 == stack_size) return;
-    stack_[i + 1]->Forward(debug, *buffer2, nullptr, scratch,
-                           i + 2 < stack_size ? buffer1 : output);
+  const NetworkIO* src = &input;
+  const TransposedArray* src_transpose = input_transpose;
+  int num_run = 0;
+  for (int i = first; i < stack_size; ++i, ++num_run) {
+    // A convolution series feeding a Maxpool runs as one step for inference.
+    if (!debug && i + 1 < stack_size && IsConvSeries(stack_[i]) &&
+        stack_[i + 1]->type() == NT_MAXPOOL && !stack_[i + 1]->IsTraining()) {
+      const PointerVector<Network>& conv_stack =
+          static_cast<Series*>(stack_[i])->stack();
+      ++i;
+      NetworkIO* dest = i + 1 == stack_size
+                            ? output
+                            : (num_run % 2 == 0 ? buffer1 : buffer2);
+      LayerTimer timer(stack_[i - 1], stack_[i], *src);
+      static_cast<Convolve*>(conv_stack[0])->ForwardWithFullyConnectedMaxpool(
+          *src, static_cast<FullyConnected*>(conv_stack[1]),
+          static_cast<const Maxpool*>(stack_[i]), scratch, dest);
+      src = dest;
+      src_transpose = nullptr;
+      continue;
+    }
+    // A Convolve feeding a FullyConnected runs as one step for inference.
+    bool fuse = !debug && i + 1 < stack_size &&
+                stack_[i]->type() == NT_CONVOLVE &&
+                FullyConnected::IsFullyConnectedType(stack_[i + 1]->type()) &&
+                !stack_[i]->IsTraining() && !stack_[i + 1]->IsTraining();
+    if (fuse) ++i;
+    NetworkIO* dest = i + 1 == stack_size
+                          ? output
+                          : (num_run % 2 == 0 ? buffer1 : buffer2);
+    // A nested Series is profiled by its own layers.
+    bool nested = stack_[i]->type() == NT_SERIES;
+    LayerTimer timer(nested ? nullptr : stack_[fuse ? i - 1 : i],
+                     fuse ? stack_[i] : nullptr, *src);
+    if (fuse) {
+      static_cast<Convolve*>(stack_[i - 1])->ForwardWithFullyConnected(
+          *src, static_cast<FullyConnected*>(stack_[i]), scratch, dest);
+    } else {
+      stack_[i]->Forward(debug, *src, src_transpose, scratch, dest);
+    }
+    src = dest;
+    src_transpose = nullptr;
   }
 }
 
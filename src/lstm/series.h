@@ -49,6 +49,9 @@ class Series : public Plumbing {
   // Recursively searches the network for softmaxes with old_no outputs,
   // and remaps their outputs according to code_map. See network.h for details.
   int RemapOutputs(int old_no, const std::vector<int>& code_map) override;
+  // Converts a float network to an int network, with the output range of
+  // each layer given as the input range of the next.
+  float ConvertToInt(float input_range) override;
 
   // Sets needs_to_backprop_ to needs_backprop and returns true if
   // needs_backprop || any weights in this network so the next layer forward
@@ -55,6 +55,15 @@ class StrideMap {
     }
     // Accesses the index to the underlying array.
     int t() const { return t_; }
+    // Returns the index to the underlying array of the location offset by
+    // x_offset, y_offset from *this, without checking that it is valid.
+    // The layers that visit a window around every location check the window
+    // against MaxIndexOfDim once, which is much cheaper than AddOffset on a
+    // copy of the index for each location in the window.
+    int OffsetT(int x_offset, int y_offset) const {
+      return t_ + x_offset * stride_map_->t_increments_[FD_WIDTH] +
+             y_offset * stride_map_->t_increments_[FD_HEIGHT];
+    }
     int index(FlexDimensions dimension) const { return indices_[dimension]; }
     // Initializes the indices to the first valid location.
     void InitToFirst() {
@@ -17,8 +17,14 @@
 
 #include "weightmatrix.h"
 
+#include <algorithm>            // for std::min
 #include <cassert>              // for assert
+#include <cmath>                // for std::nearbyint, std::nextafter
+#include <cstring>              // for memcpy
+#include <numeric>              // for std::iota
+#include <vector>               // for std::vector
 #include "intsimdmatrix.h"
+#include "numthreads.h"          // for NumThreads
 #include "simddetect.h"         // for DotProduct
 #include "statistc.h"
 #include "tprintf.h"
@@ -35,6 +41,15 @@ static inline double log2(double n) {
 const int kAdamCorrectionIterations = 200000;
 // Epsilon in Adam to prevent division by zero.
 const double kAdamEpsilon = 1e-8;
+// Minimum fraction of zero blocks for the sparse dot products, which skip
+// them, to be faster than the dense SIMD ones.
+const double kMinSparseFraction = 0.75;
+// Number of rows of u in each tile of SumOuterTransposed, which share each
+// row of v while it is in the L1 cache.
+const int kOuterRowTile = 4;
+// Number of samples in each block of SumOuterTransposed, chosen so that the
+// block of all the rows of v stays in the L2 cache for typical layer sizes.
+const int kOuterSampleBlock = 128;
 
 // Computes matrix.vector v = Wu.
 // u is of size W.dim2() - add_bias_fwd and the output v is of size
@@ -58,6 +73,17 @@ static inline void MatrixDotVectorInternal(const GENERIC_2D_ARRAY<double>& w,
   }
 }
 
+// As MatrixDotVectorInternal, but in single precision, always with the bias.
+static inline void MatrixDotVectorFloat32(const GENERIC_2D_ARRAY<float>& w,
+                                          const float* u, double* v) {
+  int num_results = w.dim1();
+  int extent = w.dim2() - 1;
+  for (int i = 0; i < num_results; ++i) {
+    const float* wi = w[i];
+    v[i] = DotProductFloat(wi, u, extent) + wi[extent];
+  }
+}
+
 // Copies the whole input transposed, converted to double, into *this.
 void TransposedArray::Transpose(const GENERIC_2D_ARRAY<double>& input) {
   int width = input.dim1();
@@ -123,6 +149,11 @@ int WeightMatrix::RemapOutputs(const std::vector<int>& code_map) {
 // Store a multiplicative scale factor (as a double) that will reproduce
 // the original value, subject to rounding errors.
 void WeightMatrix::ConvertToInt() {
+  if (float32_mode_) {
+    FloatToDouble(wf32_, &wf_);
+    wf32_.Resize(1, 1, 0.0f);
+    float32_mode_ = false;
+  }
   wi_.ResizeNoInit(wf_.dim1(), wf_.dim2());
   scales_.init_to_size(wi_.dim1(), 0.0);
   int dim2 = wi_.dim2();
@@ -142,9 +173,368 @@ void WeightMatrix::ConvertToInt() {
     }
   }
   wf_.Resize(1, 1, 0.0);
+  pruned_.Resize(0, 0, 0);
   int_mode_ = true;
-  if (IntSimdMatrix::intSimdMatrix) {
-    IntSimdMatrix::intSimdMatrix->Init(wi_, shaped_w_);
+  SetupDotProducts();
+}
+
+// Multiplies the weights of the first num_inputs inputs by factor.
+void WeightMatrix::ScaleInputs(double factor, int num_inputs) {
+  assert(!int_mode_);
+  if (float32_mode_) {
+    for (int i = 0; i < wf32_.dim1(); ++i) {
+      float* row = wf32_[i];
+      for (int j = 0; j < num_inputs; ++j) row[j] *= factor;
+    }
+  } else {
+    for (int i = 0; i < wf_.dim1(); ++i) {
+      double* row = wf_[i];
+      for (int j = 0; j < num_inputs; ++j) row[j] *= factor;
+    }
+  }
+}
+
+// Converts a double network to single precision for inference only.
+void WeightMatrix::ConvertToFloat32() {
+  if (int_mode_ || float32_mode_) return;
+  int dim1 = wf_.dim1();
+  int dim2 = wf_.dim2();
+  wf32_.ResizeNoInit(dim1, dim2);
+  for (int i = 0; i < dim1; ++i) {
+    const double* wfi = wf_[i];
+    float* wsi = wf32_[i];
+    for (int j = 0; j < dim2; ++j) wsi[j] = static_cast<float>(wfi[j]);
+  }
+  wf_.Resize(1, 1, 0.0);
+  float32_mode_ = true;
+  SetupDotProducts();
+}
+
+// Returns the number of blocks of block_size needed to cover size elements.
+static int NumBlocks(int size, int block_size) {
+  return (size + block_size - 1) / block_size;
+}
+
+// Returns true if all the weights in block (r, c) of w are zero.
+template <typename T>
+static bool IsZeroBlock(const GENERIC_2D_ARRAY<T>& w, int r, int c) {
+  int row_end = std::min((r + 1) * kSparseBlockRows, w.dim1());
+  int col_end = std::min((c + 1) * kSparseBlockCols, w.dim2() - 1);
+  for (int i = r * kSparseBlockRows; i < row_end; ++i) {
+    const T* row = w[i];
+    for (int j = c * kSparseBlockCols; j < col_end; ++j) {
+      if (row[j] != 0) return false;
+    }
+  }
+  return true;
+}
+
+// Copies block (r, c) of w to block, padding with zeros beyond the edges of
+// w.
+template <typename T>
+static void ReadBlock(const GENERIC_2D_ARRAY<T>& w, int r, int c, T* block) {
+  int row_end = std::min((r + 1) * kSparseBlockRows, w.dim1());
+  int col_end = std::min((c + 1) * kSparseBlockCols, w.dim2() - 1);
+  memset(block, 0, kSparseBlockSize * sizeof(T));
+  for (int i = r * kSparseBlockRows; i < row_end; ++i) {
+    const T* row = w[i];
+    T* block_row = block + (i - r * kSparseBlockRows) * kSparseBlockCols;
+    for (int j = c * kSparseBlockCols; j < col_end; ++j) {
+      block_row[j - c * kSparseBlockCols] = row[j];
+    }
+  }
+}
+
+// Copies block to block (r, c) of w, except any padding beyond its edges.
+template <typename T>
+static void WriteBlock(const T* block, int r, int c, GENERIC_2D_ARRAY<T>* w) {
+  int row_end = std::min((r + 1) * kSparseBlockRows, w->dim1());
+  int col_end = std::min((c + 1) * kSparseBlockCols, w->dim2() - 1);
+  for (int i = r * kSparseBlockRows; i < row_end; ++i) {
+    T* row = (*w)[i];
+    const T* block_row = block + (i - r * kSparseBlockRows) * kSparseBlockCols;
+    for (int j = c * kSparseBlockCols; j < col_end; ++j) {
+      row[j] = block_row[j - c * kSparseBlockCols];
+    }
+  }
+}
+
+// If at least kMinSparseFraction of the blocks of w, excluding the bias, are
+// zero, fills the compressed rows of the other blocks, as described for
+// WeightMatrix::block_starts_, and returns true.
+template <typename T>
+static bool BuildSparseBlocks(const GENERIC_2D_ARRAY<T>& w,
+                              std::vector<int>* block_starts,
+                              std::vector<int>* block_cols,
+                              std::vector<T>* blocks) {
+  int num_block_rows = NumBlocks(w.dim1(), kSparseBlockRows);
+  int num_block_cols = NumBlocks(w.dim2() - 1, kSparseBlockCols);
+  int num_blocks = num_block_rows * num_block_cols;
+  if (num_blocks == 0) return false;
+  std::vector<int> starts;
+  std::vector<int> cols;
+  for (int r = 0; r < num_block_rows; ++r) {
+    starts.push_back(cols.size());
+    for (int c = 0; c < num_block_cols; ++c) {
+      if (!IsZeroBlock(w, r, c)) cols.push_back(c);
+    }
+  }
+  starts.push_back(cols.size());
+  if (cols.size() > num_blocks * (1.0 - kMinSparseFraction)) return false;
+  blocks->resize(cols.size() * kSparseBlockSize);
+  for (int r = 0; r < num_block_rows; ++r) {
+    for (int b = starts[r]; b < starts[r + 1]; ++b) {
+      ReadBlock(w, r, cols[b], &(*blocks)[b * kSparseBlockSize]);
+    }
+  }
+  block_starts->swap(starts);
+  block_cols->swap(cols);
+  return true;
+}
+
+// Computes the dot products with u of the rows of the weights stored as
+// sparse blocks, excluding the bias, and calls finish(row, total) for each
+// of the num_out rows.
+template <typename T, typename Acc, class Finish>
+static void SparseDotVector(int num_out, int num_in,
+                            const std::vector<int>& block_starts,
+                            const std::vector<int>& block_cols,
+                            const std::vector<T>& blocks, const T* u,
+                            Finish finish) {
+  int num_block_rows = block_starts.size() - 1;
+  for (int r = 0; r < num_block_rows; ++r) {
+    Acc totals[kSparseBlockRows] = {};
+    for (int b = block_starts[r]; b < block_starts[r + 1]; ++b) {
+      int col = block_cols[b] * kSparseBlockCols;
+      int num_cols = std::min(kSparseBlockCols, num_in - col);
+      const T* wb = &blocks[b * kSparseBlockSize];
+      const T* ub = u + col;
+      if (num_cols == kSparseBlockCols) {
+        // The common case, with a fixed size for the compiler to unroll.
+        for (int i = 0; i < kSparseBlockRows; ++i, wb += kSparseBlockCols) {
+          Acc total = 0;
+          for (int j = 0; j < kSparseBlockCols; ++j) total += wb[j] * ub[j];
+          totals[i] += total;
+        }
+      } else {
+        for (int i = 0; i < kSparseBlockRows; ++i, wb += kSparseBlockCols) {
+          for (int j = 0; j < num_cols; ++j) totals[i] += wb[j] * ub[j];
+        }
+      }
+    }
+    int row = r * kSparseBlockRows;
+    int num_rows = std::min(kSparseBlockRows, num_out - row);
+    for (int i = 0; i < num_rows; ++i) finish(row + i, totals[i]);
+  }
+}
+
+// Sets up the block sparse weights or the SIMD shaped weights.
+void WeightMatrix::SetupDotProducts() {
+  block_starts_.clear();
+  block_cols_.clear();
+  sparse_wi_.clear();
+  sparse_wf32_.clear();
+  bool sparse = false;
+  if (int_mode_) {
+    sparse = BuildSparseBlocks(wi_, &block_starts_, &block_cols_, &sparse_wi_);
+  } else if (float32_mode_) {
+    sparse =
+        BuildSparseBlocks(wf32_, &block_starts_, &block_cols_, &sparse_wf32_);
+  }
+  device_w_.reset();
+  if (int_mode_ && !sparse && IntSimdMatrix::intSimdMatrix) {
+    const IntSimdMatrix* m = IntSimdMatrix::intSimdMatrix;
+    m->Init(wi_, shaped_w_);
+    if (m->uploadWeightsFunction != nullptr) {
+      void* device_w =
+          m->uploadWeightsFunction(wi_.dim1(), wi_.dim2(), &shaped_w_[0]);
+      // Released with the last copy of this matrix.
+      if (device_w != nullptr) {
+        device_w_.reset(device_w, m->releaseWeightsFunction);
+      }
+    }
+  } else {
+    shaped_w_.clear();
+    shaped_w_.shrink_to_fit();
+  }
+}
+
+// Prunes the fraction of the blocks with the smallest sum of squares.
+int WeightMatrix::PruneBlocks(double fraction) {
+  assert(!int_mode_ && !float32_mode_);
+  int num_block_rows = NumBlocks(wf_.dim1(), kSparseBlockRows);
+  int num_block_cols = NumBlocks(wf_.dim2() - 1, kSparseBlockCols);
+  int num_blocks = num_block_rows * num_block_cols;
+  int num_pruned = std::min(IntCastRounded(fraction * num_blocks), num_blocks);
+  if (num_pruned <= 0) return 0;
+  if (pruned_.dim1() != num_block_rows || pruned_.dim2() != num_block_cols) {
+    pruned_.Resize(num_block_rows, num_block_cols, 0);
+  }
+  std::vector<double> sums(num_blocks, 0.0);
+  for (int i = 0; i < wf_.dim1(); ++i) {
+    const double* row = wf_[i];
+    double* block_sums = &sums[i / kSparseBlockRows * num_block_cols];
+    for (int j = 0; j + 1 < wf_.dim2(); ++j) {
+      block_sums[j / kSparseBlockCols] += row[j] * row[j];
+    }
+  }
+  std::vector<int> order(num_blocks);
+  std::iota(order.begin(), order.end(), 0);
+  std::nth_element(order.begin(), order.begin() + num_pruned - 1, order.end(),
+                   [&sums](int a, int b) { return sums[a] < sums[b]; });
+  for (int b = 0; b < num_pruned; ++b) {
+    pruned_(order[b] / num_block_cols, order[b] % num_block_cols) = 1;
+  }
+  ZeroPrunedBlocks();
+  wf_t_.Transpose(wf_);
+  return num_pruned;
+}
+
+// Zeroes the weights and training updates of the pruned blocks.
+void WeightMatrix::ZeroPrunedBlocks() {
+  if (pruned_.dim1() == 0) return;
+  int num_in = wf_.dim2() - 1;
+  for (int i = 0; i < wf_.dim1(); ++i) {
+    const int8_t* pruned_row = pruned_[i / kSparseBlockRows];
+    for (int j = 0; j < num_in; ++j) {
+      if (!pruned_row[j / kSparseBlockCols]) continue;
+      wf_(i, j) = 0.0;
+      if (updates_.dim1() == wf_.dim1()) updates_(i, j) = 0.0;
+      if (dw_sq_sum_.dim1() == wf_.dim1()) dw_sq_sum_(i, j) = 0.0;
+    }
+  }
+}
+
+// Returns the allocated bytes of an array.
+template <typename T>
+static int64_t AllocatedBytes(const GENERIC_2D_ARRAY<T>& array) {
+  return static_cast<int64_t>(array.size_allocated()) * sizeof(T);
+}
+
+// Adds the allocated bytes of the weights and training state to usage.
+void WeightMatrix::AddMemoryUsage(MemoryUsage* usage) const {
+  usage->Add(MEMORY_WEIGHTS_INT,
+             AllocatedBytes(wi_) + scales_.size_reserved() * sizeof(double) +
+                 shaped_w_.capacity() + sparse_wi_.capacity());
+  usage->Add(MEMORY_WEIGHTS_FLOAT,
+             AllocatedBytes(wf_) + AllocatedBytes(wf32_) +
+                 sparse_wf32_.capacity() * sizeof(float) +
+                 AllocatedBytes(wf_t_) + AllocatedBytes(dw_) +
+                 AllocatedBytes(updates_) + AllocatedBytes(dw_sq_sum_));
+}
+
+// Helper copies the rows of all the parts into *result, one after the other.
+template <typename T>
+static void ConcatRows(const std::vector<const GENERIC_2D_ARRAY<T>*>& parts,
+                       GENERIC_2D_ARRAY<T>* result) {
+  int dim1 = 0;
+  int dim2 = parts[0]->dim2();
+  for (const auto* part : parts) {
+    assert(part->dim2() == dim2);
+    dim1 += part->dim1();
+  }
+  result->ResizeNoInit(dim1, dim2);
+  int row = 0;
+  for (const auto* part : parts) {
+    for (int i = 0; i < part->dim1(); ++i, ++row) {
+      memcpy((*result)[row], (*part)[i], dim2 * sizeof(T));
+    }
+  }
+}
+
+// Sets *this to the concatenation of the outputs of parts.
+void WeightMatrix::InitFused(const std::vector<const WeightMatrix*>& parts) {
+  assert(!parts.empty());
+  int_mode_ = parts[0]->int_mode_;
+  float32_mode_ = parts[0]->float32_mode_;
+  use_adam_ = parts[0]->use_adam_;
+  if (int_mode_) {
+    std::vector<const GENERIC_2D_ARRAY<int8_t>*> arrays;
+    scales_.truncate(0);
+    for (const auto* part : parts) {
+      assert(part->int_mode_);
+      arrays.push_back(&part->wi_);
+      for (int i = 0; i < part->scales_.size(); ++i) {
+        scales_.push_back(part->scales_[i]);
+      }
+    }
+    ConcatRows(arrays, &wi_);
+  } else if (float32_mode_) {
+    std::vector<const GENERIC_2D_ARRAY<float>*> arrays;
+    for (const auto* part : parts) {
+      assert(part->float32_mode_);
+      arrays.push_back(&part->wf32_);
+    }
+    ConcatRows(arrays, &wf32_);
+  } else {
+    std::vector<const GENERIC_2D_ARRAY<double>*> arrays;
+    for (const auto* part : parts) {
+      assert(!part->int_mode_ && !part->float32_mode_);
+      arrays.push_back(&part->wf_);
+    }
+    ConcatRows(arrays, &wf_);
+  }
+  SetupDotProducts();
+}
+
+// Helper copies the given rows of src into *result.
+template <typename T>
+static void CopyRows(const GENERIC_2D_ARRAY<T>& src,
+                     const std::vector<int>& rows, GENERIC_2D_ARRAY<T>* result) {
+  int dim2 = src.dim2();
+  result->ResizeNoInit(rows.size(), dim2);
+  for (int i = 0; i < rows.size(); ++i) {
+    memcpy((*result)[i], src[rows[i]], dim2 * sizeof(T));
+  }
+}
+
+// Sets *this to the given rows of src, in the same mode.
+void WeightMatrix::InitRows(const WeightMatrix& src,
+                            const std::vector<int>& rows) {
+  int_mode_ = src.int_mode_;
+  float32_mode_ = src.float32_mode_;
+  use_adam_ = src.use_adam_;
+  if (int_mode_) {
+    CopyRows(src.wi_, rows, &wi_);
+    scales_.truncate(0);
+    for (int row : rows) scales_.push_back(src.scales_[row]);
+  } else if (float32_mode_) {
+    CopyRows(src.wf32_, rows, &wf32_);
+  } else {
+    CopyRows(src.wf_, rows, &wf_);
+  }
+  SetupDotProducts();
+}
+
+// Sets *this to the given weights, converted to the same mode as src.
+void WeightMatrix::InitConverted(const GENERIC_2D_ARRAY<double>& weights,
+                                 const WeightMatrix& src) {
+  int_mode_ = false;
+  float32_mode_ = false;
+  use_adam_ = false;
+  wf_ = weights;
+  if (src.int_mode_) {
+    ConvertToInt();
+  } else if (src.float32_mode_) {
+    ConvertToFloat32();
+  }
+}
+
+// Copies the weights to *weights as double, whatever the mode.
+void WeightMatrix::GetDoubleWeights(GENERIC_2D_ARRAY<double>* weights) const {
+  if (int_mode_) {
+    int dim1 = wi_.dim1();
+    int dim2 = wi_.dim2();
+    weights->ResizeNoInit(dim1, dim2);
+    for (int i = 0; i < dim1; ++i) {
+      const int8_t* wii = wi_[i];
+      double* wdi = (*weights)[i];
+      for (int j = 0; j < dim2; ++j) wdi[j] = wii[j] * scales_[i];
+    }
+  } else if (float32_mode_) {
+    FloatToDouble(wf32_, weights);
+  } else {
+    *weights = wf_;
   }
 }
 
@@ -163,6 +553,16 @@ void WeightMatrix::InitBackward() {
 const int kInt8Flag = 1;
 // Flag on mode to indicate that this weightmatrix uses adam.
 const int kAdamFlag = 4;
+// Flag on mode to indicate that the training updates and adam moments are
+// stored as float to save space, while the weights themselves stay double.
+const int kCompactFlag = 8;
+// Flag on mode to indicate that the int weights are stored as their non-zero
+// blocks, or that the float weights are followed by the mask of the pruned
+// blocks.
+const int kSparseFlag = 16;
+// Flag on mode to indicate that the float weights are stored as IEEE half
+// precision, without any training data.
+const int kHalfFlag = 32;
 // Flag on mode to indicate that this weightmatrix uses double. Set
 // independently of kInt8Flag as even in int mode the scales can
 // be float or double.
@@ -172,17 +572,38 @@ const int kDoubleFlag = 128;
 bool WeightMatrix::Serialize(bool training, TFile* fp) const {
   // For backward compatibility, add kDoubleFlag to mode to indicate the doubles
   // format, without errs, so we can detect and read old format weight matrices.
-  uint8_t mode =
-      (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) | kDoubleFlag;
+  bool compact = training && fp->compact() && !int_mode_ && !float32_mode_;
+  bool half = !training && fp->half_precision() && !int_mode_;
+  bool sparse = int_mode_ ? is_sparse() : pruned_.dim1() > 0;
+  uint8_t mode = (int_mode_ ? kInt8Flag : 0) | (use_adam_ ? kAdamFlag : 0) |
+                 (compact ? kCompactFlag : 0) | (sparse ? kSparseFlag : 0) |
+                 (half ? kHalfFlag : 0) | kDoubleFlag;
   if (!fp->Serialize(&mode)) return false;
-  if (int_mode_) {
-    if (!wi_.Serialize(fp)) return false;
+  if (half) {
+    if (!SerializeHalf(fp)) return false;
+  } else if (compact) {
+    if (!wf_.Serialize(fp)) return false;
+    GENERIC_2D_ARRAY<float> float_array;
+    DoubleToFloat(updates_, &float_array);
+    if (!float_array.Serialize(fp)) return false;
+    if (use_adam_) {
+      DoubleToFloat(dw_sq_sum_, &float_array);
+      if (!float_array.Serialize(fp)) return false;
+    }
+  } else if (int_mode_) {
+    if (sparse ? !SerializeSparse(fp) : !wi_.Serialize(fp)) return false;
     if (!scales_.Serialize(fp)) return false;
+  } else if (float32_mode_) {
+    // The file format is always double.
+    GENERIC_2D_ARRAY<double> wf;
+    FloatToDouble(wf32_, &wf);
+    if (!wf.Serialize(fp)) return false;
   } else {
     if (!wf_.Serialize(fp)) return false;
     if (training && !updates_.Serialize(fp)) return false;
     if (training && use_adam_ && !dw_sq_sum_.Serialize(fp)) return false;
   }
+  if (!int_mode_ && sparse && !pruned_.Serialize(fp)) return false;
   return true;
 }
 
@@ -192,21 +613,191 @@ bool WeightMatrix::DeSerialize(bool training, TFile* fp) {
   uint8_t mode;
   if (!fp->DeSerialize(&mode)) return false;
   int_mode_ = (mode & kInt8Flag) != 0;
+  float32_mode_ = false;
   use_adam_ = (mode & kAdamFlag) != 0;
   if ((mode & kDoubleFlag) == 0) return DeSerializeOld(training, fp);
+  bool sparse = (mode & kSparseFlag) != 0;
+  pruned_.Resize(0, 0, 0);
   if (int_mode_) {
-    if (!wi_.DeSerialize(fp)) return false;
+    if (sparse ? !DeSerializeSparse(fp) : !wi_.DeSerialize(fp)) return false;
     if (!scales_.DeSerialize(fp)) return false;
-    if (IntSimdMatrix::intSimdMatrix) {
-      IntSimdMatrix::intSimdMatrix->Init(wi_, shaped_w_);
-    }
+    SetupDotProducts();
+  } else if ((mode & kHalfFlag) != 0) {
+    if (!DeSerializeHalf(fp)) return false;
+    // There is no training data, so training starts afresh.
+    if (training) InitBackward();
+    if (sparse && !pruned_.DeSerialize(fp)) return false;
   } else {
     if (!wf_.DeSerialize(fp)) return false;
-    if (training) {
+    if ((mode & kCompactFlag) != 0) {
+      // The compact format always has the training data, so it must be read,
+      // or skipped without copying when not training.
+      if (training) {
+        GENERIC_2D_ARRAY<float> float_array;
+        InitBackward();
+        if (!float_array.DeSerialize(fp)) return false;
+        FloatToDouble(float_array, &updates_);
+        if (use_adam_) {
+          if (!float_array.DeSerialize(fp)) return false;
+          FloatToDouble(float_array, &dw_sq_sum_);
+        }
+      } else {
+        if (!GENERIC_2D_ARRAY<float>::SkipDeSerialize(fp)) return false;
+        if (use_adam_ && !GENERIC_2D_ARRAY<float>::SkipDeSerialize(fp)) {
+          return false;
+        }
+      }
+    } else if (training) {
       InitBackward();
       if (!updates_.DeSerialize(fp)) return false;
       if (use_adam_ && !dw_sq_sum_.DeSerialize(fp)) return false;
     }
+    if (sparse && !pruned_.DeSerialize(fp)) return false;
+  }
+  return true;
+}
+
+// Writes the dimensions of wi_, one byte per block that is non-zero if the
+// block is stored, the stored blocks, and then the bias weights.
+bool WeightMatrix::SerializeSparse(TFile* fp) const {
+  int32_t dims[2] = {wi_.dim1(), wi_.dim2()};
+  if (!fp->Serialize(dims, 2)) return false;
+  int num_block_rows = block_starts_.size() - 1;
+  GENERIC_2D_ARRAY<int8_t> stored(
+      num_block_rows, NumBlocks(dims[1] - 1, kSparseBlockCols), 0);
+  for (int r = 0; r < num_block_rows; ++r) {
+    for (int b = block_starts_[r]; b < block_starts_[r + 1]; ++b) {
+      stored(r, block_cols_[b]) = 1;
+    }
+  }
+  if (!stored.Serialize(fp)) return false;
+  if (!sparse_wi_.empty() &&
+      !fp->Serialize(&sparse_wi_[0], sparse_wi_.size())) {
+    return false;
+  }
+  std::vector<int8_t> bias(dims[0]);
+  for (int i = 0; i < dims[0]; ++i) bias[i] = wi_(i, dims[1] - 1);
+  return bias.empty() || fp->Serialize(&bias[0], bias.size());
+}
+
+// Reads wi_ as written by SerializeSparse.
+bool WeightMatrix::DeSerializeSparse(TFile* fp) {
+  int32_t dims[2];
+  if (!fp->DeSerialize(dims, 2)) return false;
+  if (dims[0] < 0 || dims[1] < 1) return false;
+  GENERIC_2D_ARRAY<int8_t> stored;
+  if (!stored.DeSerialize(fp)) return false;
+  if (stored.dim1() != NumBlocks(dims[0], kSparseBlockRows) ||
+      stored.dim2() != NumBlocks(dims[1] - 1, kSparseBlockCols)) {
+    return false;
+  }
+  wi_.Resize(dims[0], dims[1], 0);
+  int8_t block[kSparseBlockSize];
+  for (int r = 0; r < stored.dim1(); ++r) {
+    for (int c = 0; c < stored.dim2(); ++c) {
+      if (!stored(r, c)) continue;
+      if (!fp->DeSerialize(block, kSparseBlockSize)) return false;
+      WriteBlock(block, r, c, &wi_);
+    }
+  }
+  for (int i = 0; i < dims[0]; ++i) {
+    if (!fp->DeSerialize(&wi_(i, dims[1] - 1))) return false;
+  }
+  return true;
+}
+
+// Converts a float to IEEE half precision, rounding to nearest even, with
+// overflow to infinity.
+static uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs_bits = bits & 0x7fffffff;
+  if (abs_bits >= 0x7f800000) {
+    // Infinity stays infinity and NaN stays a (quiet) NaN.
+    return sign | 0x7c00 | (abs_bits > 0x7f800000 ? 0x200 : 0);
+  }
+  // 65520 and above round to more than the largest half, 65504.
+  if (abs_bits >= 0x477ff000) return sign | 0x7c00;
+  if (abs_bits < 0x38800000) {
+    // Below the smallest normal half, 2^-14, so the result is a multiple of
+    // 2^-24. Scaling by a power of 2 is exact, and nearbyint rounds to even.
+    float abs_value;
+    memcpy(&abs_value, &abs_bits, sizeof(abs_value));
+    return sign | static_cast<uint16_t>(std::nearbyint(abs_value * 16777216.0f));
+  }
+  // Rebias the exponent from 127 to 15 and round the mantissa from 23 bits to
+  // 10, to nearest even. A carry out of the mantissa correctly increments the
+  // exponent.
+  abs_bits += 0xfff + ((abs_bits >> 13) & 1);
+  return sign | ((abs_bits - 0x38000000) >> 13);
+}
+
+// Converts a double to float, rounding to odd: towards zero, with the last
+// bit set if the result is inexact. Rounding that to half precision gives the
+// same as rounding the double directly, whereas rounding to the nearest float
+// first could make a double just off a tie of the half rounding into the tie.
+static float DoubleToFloatRoundOdd(double value) {
+  float result = static_cast<float>(value);
+  if (!std::isfinite(result) || result == value) return result;
+  if (std::fabs(result) > std::fabs(value)) {
+    result = std::nextafter(result, 0.0f);
+  }
+  uint32_t bits;
+  memcpy(&bits, &result, sizeof(bits));
+  bits |= 1;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// Converts an IEEE half precision value to float, which is exact.
+static float HalfToFloat(uint16_t half) {
+  uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0) {
+    // Zero or subnormal.
+    float value = std::ldexp(static_cast<float>(mantissa), -24);
+    memcpy(&bits, &value, sizeof(bits));
+    bits |= sign;
+  } else if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// Writes the dimensions of the float weights and then the weights as half
+// precision.
+bool WeightMatrix::SerializeHalf(TFile* fp) const {
+  int32_t dims[2] = {NumOutputs(), NumInputs() + 1};
+  if (!fp->Serialize(dims, 2)) return false;
+  std::vector<uint16_t> row(dims[1]);
+  for (int i = 0; i < dims[0]; ++i) {
+    for (int j = 0; j < dims[1]; ++j) {
+      row[j] = FloatToHalf(float32_mode_ ? wf32_(i, j)
+                                         : DoubleToFloatRoundOdd(wf_(i, j)));
+    }
+    if (!row.empty() && !fp->Serialize(&row[0], row.size())) return false;
+  }
+  return true;
+}
+
+// Reads wf_ as written by SerializeHalf.
+bool WeightMatrix::DeSerializeHalf(TFile* fp) {
+  int32_t dims[2];
+  if (!fp->DeSerialize(dims, 2)) return false;
+  if (dims[0] < 0 || dims[1] < 0) return false;
+  wf_.ResizeNoInit(dims[0], dims[1]);
+  std::vector<uint16_t> row(dims[1]);
+  for (int i = 0; i < dims[0]; ++i) {
+    if (!row.empty() && !fp->DeSerialize(&row[0], row.size())) return false;
+    double* wf_row = wf_[i];
+    for (int j = 0; j < dims[1]; ++j) wf_row[j] = HalfToFloat(row[j]);
   }
   return true;
 }
@@ -217,10 +808,21 @@ bool WeightMatrix::DeSerializeOld(bool training, TFile* fp) {
   GENERIC_2D_ARRAY<float> float_array;
   if (int_mode_) {
     if (!wi_.DeSerialize(fp)) return false;
-    GenericVector<float> old_scales;
-    if (!old_scales.DeSerialize(fp)) return false;
-    scales_.resize_no_init(old_scales.size());
-    for (int i = 0; i < old_scales.size(); ++i) scales_[i] = old_scales[i];
+    // The old scales are a GenericVector<float>, converted from in place if
+    // possible.
+    uint32_t num_scales;
+    if (!fp->DeSerialize(&num_scales)) return false;
+    const float* old_scales;
+    GenericVector<float> scales_copy;
+    if (!fp->DeSerializeView(&old_scales, num_scales)) {
+      scales_copy.resize_no_init(num_scales);
+      if (num_scales > 0 && !fp->DeSerialize(&scales_copy[0], num_scales)) {
+        return false;
+      }
+      old_scales = &scales_copy[0];
+    }
+    scales_.resize_no_init(num_scales);
+    for (uint32_t i = 0; i < num_scales; ++i) scales_[i] = old_scales[i];
   } else {
     if (!float_array.DeSerialize(fp)) return false;
     FloatToDouble(float_array, &wf_);
@@ -241,13 +843,23 @@ bool WeightMatrix::DeSerializeOld(bool training, TFile* fp) {
 // implement the bias, but it doesn't actually have it.
 // Asserts that the call matches what we have.
 void WeightMatrix::MatrixDotVector(const double* u, double* v) const {
-  assert(!int_mode_);
+  assert(!int_mode_ && !float32_mode_);
   MatrixDotVectorInternal(wf_, true, false, u, v);
 }
 
 void WeightMatrix::MatrixDotVector(const int8_t* u, double* v) const {
   assert(int_mode_);
-  if (IntSimdMatrix::intSimdMatrix) {
+  if (is_sparse()) {
+    int num_in = wi_.dim2() - 1;
+    SparseDotVector<int8_t, int>(
+        wi_.dim1(), num_in, block_starts_, block_cols_, sparse_wi_, u,
+        [this, num_in, v](int i, int total) {
+          // Add in the bias and correct for integer values, as in
+          // IntSimdMatrix::MatrixDotVector.
+          v[i] = (static_cast<double>(total) / INT8_MAX + wi_(i, num_in)) *
+                 scales_[i];
+        });
+  } else if (IntSimdMatrix::intSimdMatrix) {
     IntSimdMatrix::intSimdMatrix->matrixDotVectorFunction(
       wi_.dim1(), wi_.dim2(), &shaped_w_[0], &scales_[0], u, v);
   } else {
@@ -255,6 +867,50 @@ void WeightMatrix::MatrixDotVector(const int8_t* u, double* v) const {
   }
 }
 
+void WeightMatrix::MatrixDotVector(const float* u, double* v) const {
+  assert(float32_mode_);
+  if (is_sparse()) {
+    int num_in = wf32_.dim2() - 1;
+    SparseDotVector<float, float>(
+        wf32_.dim1(), num_in, block_starts_, block_cols_, sparse_wf32_, u,
+        [this, num_in, v](int i, float total) {
+          v[i] = total + wf32_(i, num_in);
+        });
+  } else {
+    MatrixDotVectorFloat32(wf32_, u, v);
+  }
+}
+
+void WeightMatrix::MatrixDotMatrix(const int8_t* u, int u_stride,
+                                   int num_vectors, double* v,
+                                   int v_stride) const {
+  assert(int_mode_);
+  if (is_sparse()) {
+    for (int t = 0; t < num_vectors; ++t) {
+      MatrixDotVector(u + t * u_stride, v + t * v_stride);
+    }
+  } else if (device_w_ != nullptr &&
+             IntSimdMatrix::intSimdMatrix->deviceMatrixDotMatrixFunction) {
+    IntSimdMatrix::intSimdMatrix->deviceMatrixDotMatrixFunction(
+      device_w_.get(), wi_.dim1(), wi_.dim2(), &shaped_w_[0], &scales_[0], u,
+      u_stride, num_vectors, v, v_stride);
+  } else if (IntSimdMatrix::intSimdMatrix &&
+             IntSimdMatrix::intSimdMatrix->matrixDotMatrixFunction) {
+    IntSimdMatrix::intSimdMatrix->matrixDotMatrixFunction(
+      wi_.dim1(), wi_.dim2(), &shaped_w_[0], &scales_[0], u, u_stride,
+      num_vectors, v, v_stride);
+  } else if (IntSimdMatrix::intSimdMatrix) {
+    for (int t = 0; t < num_vectors; ++t) {
+      IntSimdMatrix::intSimdMatrix->matrixDotVectorFunction(
+        wi_.dim1(), wi_.dim2(), &shaped_w_[0], &scales_[0], u + t * u_stride,
+        v + t * v_stride);
+    }
+  } else {
+    IntSimdMatrix::MatrixDotMatrix(wi_, scales_, u, u_stride, num_vectors, v,
+                                   v_stride);
+  }
+}
+
 // MatrixDotVector for peep weights, MultiplyAccumulate adds the
 // component-wise products of *this[0] and v to inout.
 void WeightMatrix::MultiplyAccumulate(const double* v, double* inout) {
@@ -292,19 +948,35 @@ void WeightMatrix::SumOuterTransposed(const TransposedArray& u,
   int num_samples = u.dim2();
   // v is missing the last element in dim1.
   assert(v.dim1() == num_inputs);
+  int num_tiles = (num_outputs + kOuterRowTile - 1) / kOuterRowTile;
+  // The samples are taken in blocks, so the rows of v are read from memory
+  // once per block and tile of kOuterRowTile rows of u, instead of once per
+  // row of u, and the partial dot products are accumulated in dw_.
 #ifdef _OPENMP
-#pragma omp parallel for num_threads(4) if (in_parallel)
+#pragma omp parallel for num_threads(NumThreads(4)) schedule(static) \
+    if (in_parallel)
 #endif
-  for (int i = 0; i < num_outputs; ++i) {
-    double* dwi = dw_[i];
-    const double* ui = u[i];
-    for (int j = 0; j < num_inputs; ++j) {
-      dwi[j] = DotProduct(ui, v[j], num_samples);
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    int start_i = tile * kOuterRowTile;
+    int end_i = std::min(start_i + kOuterRowTile, num_outputs);
+    for (int i = start_i; i < end_i; ++i) {
+      double* dwi = dw_[i];
+      for (int j = 0; j < num_inputs; ++j) dwi[j] = 0.0;
+      // The last element of v is missing, presumed 1.0f.
+      double total = 0.0;
+      const double* ui = u[i];
+      for (int k = 0; k < num_samples; ++k) total += ui[k];
+      dwi[num_inputs] = total;
+    }
+    for (int k = 0; k < num_samples; k += kOuterSampleBlock) {
+      int block_size = std::min(kOuterSampleBlock, num_samples - k);
+      for (int j = 0; j < num_inputs; ++j) {
+        const double* vj = v[j] + k;
+        for (int i = start_i; i < end_i; ++i) {
+          dw_[i][j] += DotProduct(u[i] + k, vj, block_size);
+        }
+      }
     }
-    // The last element of v is missing, presumed 1.0f.
-    double total = 0.0;
-    for (int k = 0; k < num_samples; ++k) total += ui[k];
-    dwi[num_inputs] = total;
   }
 }
 
@@ -330,6 +1002,7 @@ void WeightMatrix::Update(double learning_rate, double momentum,
     if (momentum > 0.0) wf_ += updates_;
     if (momentum >= 0.0) updates_ *= momentum;
   }
+  ZeroPrunedBlocks();
   wf_t_.Transpose(wf_);
 }
 
@@ -340,6 +1013,25 @@ void WeightMatrix::AddDeltas(const WeightMatrix& other) {
   dw_ += other.dw_;
 }
 
+// Sets the dw_ of *this to the mean of the dw_ of others, which must not be
+// empty.
+void WeightMatrix::AverageDeltas(
+    const std::vector<const WeightMatrix*>& others) {
+  assert(!others.empty());
+  dw_ = others[0]->dw_;
+  for (size_t i = 1; i < others.size(); ++i) AddDeltas(*others[i]);
+  if (others.size() > 1) dw_ *= 1.0 / others.size();
+}
+
+// Copies the float weights of other, which has the same shape, to *this.
+void WeightMatrix::CopyWeights(const WeightMatrix& other) {
+  assert(!int_mode_ && !other.int_mode_);
+  assert(wf_.dim1() == other.wf_.dim1());
+  assert(wf_.dim2() == other.wf_.dim2());
+  wf_ = other.wf_;
+  wf_t_ = other.wf_t_;
+}
+
 // Sums the products of weight updates in *this and other, splitting into
 // positive (same direction) in *same and negative (different direction) in
 // *changed.
@@ -382,6 +1074,12 @@ void WeightMatrix::Debug2D(const char* msg) {
         HistogramWeight(wi_[i][j] * scales_[i], &histogram);
       }
     }
+  } else if (float32_mode_) {
+    for (int i = 0; i < wf32_.dim1(); ++i) {
+      for (int j = 0; j < wf32_.dim2(); ++j) {
+        HistogramWeight(wf32_[i][j], &histogram);
+      }
+    }
   } else {
     for (int i = 0; i < wf_.dim1(); ++i) {
       for (int j = 0; j < wf_.dim2(); ++j) {
@@ -408,4 +1106,19 @@ void WeightMatrix::FloatToDouble(const GENERIC_2D_ARRAY<float>& wf,
   }
 }
 
+// Utility function converts an array of double to the corresponding array
+// of float.
+/* static */
+void WeightMatrix::DoubleToFloat(const GENERIC_2D_ARRAY<double>& wd,
+                                 GENERIC_2D_ARRAY<float>* wf) {
+  int dim1 = wd.dim1();
+  int dim2 = wd.dim2();
+  wf->ResizeNoInit(dim1, dim2);
+  for (int i = 0; i < dim1; ++i) {
+    const double* wdi = wd[i];
+    float* wfi = (*wf)[i];
+    for (int j = 0; j < dim2; ++j) wfi[j] = static_cast<float>(wdi[j]);
+  }
+}
+
 }  // namespace tesseract.
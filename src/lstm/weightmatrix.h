@@ -19,9 +19,11 @@
 #define TESSERACT_LSTM_WEIGHTMATRIX_H_
 
 #include <memory>
+#include <vector>
 #include "genericvector.h"
 #include "intsimdmatrix.h"
 #include "matrix.h"
+#include "memoryusage.h"
 #include "tprintf.h"
 
 namespace tesseract {
@@ -59,12 +61,18 @@ class TransposedArray : public GENERIC_2D_ARRAY<double> {
   }
 };  // class TransposedArray
 
+// Size of the blocks of weights that are pruned together, and skipped together
+// by the sparse dot products.
+const int kSparseBlockRows = 4;
+const int kSparseBlockCols = 8;
+const int kSparseBlockSize = kSparseBlockRows * kSparseBlockCols;
+
 // Generic weight matrix for network layers. Can store the matrix as either
 // an array of floats or int8_t. Provides functions to compute the forward and
 // backward steps with the matrix and updates to the weights.
 class WeightMatrix {
  public:
-  WeightMatrix() : int_mode_(false), use_adam_(false) {}
+  WeightMatrix() : int_mode_(false), float32_mode_(false), use_adam_(false) {}
   // Sets up the network for training. Initializes weights using weights of
   // scale `range` picked according to the random number generator `randomizer`.
   // Note the order is outputs, inputs, as this is the order of indices to
@@ -87,6 +95,36 @@ class WeightMatrix {
   // Store a multiplicative scale factor (as a float) that will reproduce
   // the original value, subject to rounding errors.
   void ConvertToInt();
+  // Multiplies the weights of the first num_inputs inputs by factor, leaving
+  // the other inputs and the bias unchanged. Used before ConvertToInt to fold
+  // the int_range of those inputs into the weights. Not valid in int mode.
+  void ScaleInputs(double factor, int num_inputs);
+  // Converts a double network to single precision for inference only.
+  // Halves the memory used by the weights and doubles the SIMD width of the
+  // dot products. Has no effect on an int network.
+  void ConvertToFloat32();
+  // Sets *this to the concatenation of the outputs of parts, which must all
+  // have the same number of inputs and be in the same mode, so a single
+  // MatrixDotVector computes all of them with one pass over the input.
+  // For inference only, as the result can't be trained.
+  void InitFused(const std::vector<const WeightMatrix*>& parts);
+  // Sets *this to the given rows of src, in the same mode, so that just
+  // those outputs can be computed. Gets the training state back from
+  // InitFused with InitBackward.
+  void InitRows(const WeightMatrix& src, const std::vector<int>& rows);
+  // Sets *this to the given weights, converted to the same mode as src.
+  // For inference only.
+  void InitConverted(const GENERIC_2D_ARRAY<double>& weights,
+                     const WeightMatrix& src);
+  // Copies the weights to *weights as double, whatever the mode. Int weights
+  // are multiplied by their scales, so they work on the float input.
+  void GetDoubleWeights(GENERIC_2D_ARRAY<double>* weights) const;
+  // Sets to zero the given fraction of the blocks of kSparseBlockRows x
+  // kSparseBlockCols weights, excluding the bias, with the smallest sum of
+  // squares, including any already pruned, and holds them at zero through
+  // any further training. Returns the number of pruned blocks. Only valid in
+  // double mode.
+  int PruneBlocks(double fraction);
   // Returns the size rounded up to an internal factor used by the SIMD
   // implementation for its input.
   int RoundInputs(int size) const {
@@ -98,12 +136,31 @@ class WeightMatrix {
   bool is_int_mode() const {
     return int_mode_;
   }
-  int NumOutputs() const { return int_mode_ ? wi_.dim1() : wf_.dim1(); }
+  bool is_float32_mode() const {
+    return float32_mode_;
+  }
+  int NumOutputs() const {
+    return int_mode_ ? wi_.dim1() : float32_mode_ ? wf32_.dim1() : wf_.dim1();
+  }
+  // Returns the number of inputs, excluding the bias.
+  int NumInputs() const {
+    int dim2 = int_mode_ ? wi_.dim2()
+                         : float32_mode_ ? wf32_.dim2() : wf_.dim2();
+    return dim2 - 1;
+  }
   // Provides one set of weights. Only used by peep weight maxpool.
   const double* GetWeights(int index) const { return wf_[index]; }
   // Provides access to the deltas (dw_).
   double GetDW(int i, int j) const { return dw_(i, j); }
 
+  // Adds the allocated bytes of the weights, int or float, to usage, with
+  // any training state as float.
+  void AddMemoryUsage(MemoryUsage* usage) const;
+  // Returns true if the dot products skip the zero blocks of the weights.
+  bool is_sparse() const {
+    return !block_starts_.empty();
+  }
+
   // Allocates any needed memory for running Backward, and zeroes the deltas,
   // thus eliminating any existing momentum.
   void InitBackward();
@@ -120,9 +177,20 @@ class WeightMatrix {
   // u is of size W.dim2() - 1 and the output v is of size W.dim1().
   // u is imagined to have an extra element at the end with value 1, to
   // implement the bias, but it doesn't actually have it.
-  // Asserts that the call matches what we have.
+  // Asserts that the call matches what we have: a double input is only valid
+  // in double mode, so in float32 mode the caller must pass its float input
+  // (NetworkIO::f) rather than have it converted on every call.
   void MatrixDotVector(const double* u, double* v) const;
   void MatrixDotVector(const int8_t* u, double* v) const;
+  // As above, but for a float input and only valid in float32 mode.
+  void MatrixDotVector(const float* u, double* v) const;
+  // Computes matrix.matrix v_t = Wu_t for num_vectors inputs u_t, which are
+  // u_stride apart in u, writing the results v_stride apart in v.
+  // Equivalent to num_vectors calls to MatrixDotVector, but the weights are
+  // only streamed from memory once for all the inputs.
+  // Each u_t must be padded (using RoundInputs) or followed by further data.
+  void MatrixDotMatrix(const int8_t* u, int u_stride, int num_vectors,
+                       double* v, int v_stride) const;
   // MatrixDotVector for peep weights, MultiplyAccumulate adds the
   // component-wise products of *this[0] and v to inout.
   void MultiplyAccumulate(const double* v, double* inout);
@@ -135,6 +203,8 @@ class WeightMatrix {
   // from u and v, starting with u[i][offset] and v[j][offset].
   // Note that (matching MatrixDotVector) v[last][] is missing, presumed 1.0.
   // Runs parallel if requested. Note that inputs must be transposed.
+  // The rows of u are taken in small tiles and the samples in blocks, so that
+  // each row of v is reused from the cache by all the rows of a tile.
   void SumOuterTransposed(const TransposedArray& u, const TransposedArray& v,
                           bool parallel);
   // Updates the weights using the given learning rate, momentum and adam_beta.
@@ -143,6 +213,11 @@ class WeightMatrix {
               int num_samples);
   // Adds the dw_ in other to the dw_ is *this.
   void AddDeltas(const WeightMatrix& other);
+  // Sets the dw_ of *this to the mean of the dw_ of others, which must not be
+  // empty.
+  void AverageDeltas(const std::vector<const WeightMatrix*>& others);
+  // Copies the float weights of other, which has the same shape, to *this.
+  void CopyWeights(const WeightMatrix& other);
   // Sums the products of weight updates in *this and other, splitting into
   // positive (same direction) in *same and negative (different direction) in
   // *changed.
@@ -155,15 +230,37 @@ class WeightMatrix {
   // of double.
   static void FloatToDouble(const GENERIC_2D_ARRAY<float>& wf,
                             GENERIC_2D_ARRAY<double>* wd);
+  // Utility function converts an array of double to the corresponding array
+  // of float.
+  static void DoubleToFloat(const GENERIC_2D_ARRAY<double>& wd,
+                            GENERIC_2D_ARRAY<float>* wf);
 
  private:
+  // Sets up the block sparse weights for the dot products if enough of the
+  // blocks of wi_ or wf32_ are zero, or else the shaped weights for the SIMD
+  // code in int mode.
+  void SetupDotProducts();
+  // Zeroes the weights and training updates of the blocks in pruned_.
+  void ZeroPrunedBlocks();
+  // Writes/reads wi_ as only the blocks used by the sparse dot products, plus
+  // the bias.
+  bool SerializeSparse(TFile* fp) const;
+  bool DeSerializeSparse(TFile* fp);
+  // Writes/reads the float weights as IEEE half precision, which is accurate
+  // enough for inference, at a quarter of the size of the doubles.
+  bool SerializeHalf(TFile* fp) const;
+  bool DeSerializeHalf(TFile* fp);
+
   // Choice between float and 8 bit int implementations.
   GENERIC_2D_ARRAY<double> wf_;
   GENERIC_2D_ARRAY<int8_t> wi_;
+  // Single precision copy of wf_, which replaces it in float32 mode.
+  GENERIC_2D_ARRAY<float> wf32_;
   // Transposed copy of wf_, used only for Backward, and set with each Update.
   TransposedArray wf_t_;
-  // Which of wf_ and wi_ are we actually using.
+  // Which of wf_, wf32_ and wi_ are we actually using.
   bool int_mode_;
+  bool float32_mode_;
   // True if we are running adam in this weight matrix.
   bool use_adam_;
   // If we are using wi_, then scales_ is a factor to restore the row product
@@ -178,6 +275,22 @@ class WeightMatrix {
   GENERIC_2D_ARRAY<double> dw_sq_sum_;
   // The weights matrix reorganized in whatever way suits this instance.
   std::vector<int8_t> shaped_w_;
+  // Copy of shaped_w_ on the device, if the selected IntSimdMatrix has one,
+  // set up by SetupDotProducts. Shared by copies of this matrix.
+  std::shared_ptr<void> device_w_;
+  // Training only: one entry per block of weights, excluding the bias, which
+  // is non-zero if the block has been pruned and must be held at zero.
+  // Empty if nothing is pruned.
+  GENERIC_2D_ARRAY<int8_t> pruned_;
+  // If set up by SetupDotProducts, the non-zero blocks of wi_ or wf32_ in
+  // compressed rows. For each row of blocks r, block_cols_[b] for b in
+  // [block_starts_[r], block_starts_[r + 1]) is the column of a block whose
+  // weights are in sparse_wi_ or sparse_wf32_ at b * kSparseBlockSize,
+  // padded with zeros at the edges of the matrix.
+  std::vector<int> block_starts_;
+  std::vector<int> block_cols_;
+  std::vector<int8_t> sparse_wi_;
+  std::vector<float> sparse_wf32_;
 };
 
 }  // namespace tesseract.
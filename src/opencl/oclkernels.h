@@ -1050,6 +1050,32 @@ void kernel_ThresholdRectToPix_OneChan(
 }
 )
 
+KERNEL(
+// Integer dot products of the rows of the int8 weights w, each num_in long
+// and followed by the bias, with num_vectors int8 inputs u_stride apart.
+// The bias and the scales are applied by the caller.
+__kernel
+void kernel_MatrixDotMatrixInt8(
+    __global const char *w,
+    const int num_out,
+    const int num_in,
+    __global const char *u,
+    const int u_stride,
+    const int num_vectors,
+    __global int *totals) {
+
+    const int i = get_global_id(0);
+    const int t = get_global_id(1);
+    if (i >= num_out || t >= num_vectors) return;
+    __global const char *wi = w + i * (num_in + 1);
+    __global const char *ut = u + t * u_stride;
+    int total = 0;
+    for (int j = 0; j < num_in; ++j) {
+        total += wi[j] * ut[j];
+    }
+    totals[t * num_out + i] = total;
+}
+)
  ; // close char*
 
 #endif  // USE_EXTERNAL_KERNEL
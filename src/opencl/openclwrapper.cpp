@@ -45,11 +45,16 @@
 
 #ifdef USE_OPENCL
 
+#include <algorithm>  // for std::max
 #include <cstdio>
 #include <cstring>    // for memset, strcpy, ...
+#include <map>
+#include <mutex>      // for std::mutex
+#include <string>
 #include <vector>
 
 #include "errcode.h"  // for ASSERT_HOST
+#include "intsimdmatrix.h"  // for IntSimdMatrix
 
 GPUEnv OpenclDevice::gpuEnv;
 
@@ -78,6 +83,9 @@ static const l_uint32 rmask32[] = {
 
 static cl_mem pixsCLBuffer, pixdCLBuffer,
     pixdCLIntermediate;     // Morph operations buffers
+// Size in words of each of the morph buffers, which are kept for the next
+// images while they are big enough.
+static size_t morphBufferWords;
 static cl_mem pixThBuffer;  // output from thresholdtopix calculation
 static cl_int clStatus;
 static KernelEnv rEnv;
@@ -592,6 +600,38 @@ static void legalizeFileName(char* fileName) {
   }
 }
 
+// Returns the path of the named cache file (kernel binaries, build log and
+// device profile), in the directory given by TESSERACT_OPENCL_CACHE_DIR, or
+// in the working directory if that is not set.
+static std::string cacheFilePath(const char* fileName) {
+  const char* dir = getenv("TESSERACT_OPENCL_CACHE_DIR");
+  if (dir == nullptr || dir[0] == '\0') return fileName;
+  std::string path(dir);
+  if (path.back() != '/' && path.back() != '\\') path += '/';
+  return path + fileName;
+}
+
+// Returns a hash of the kernel source, which is part of the names of the
+// cached binaries, so that a binary of older kernels is never loaded.
+static uint32_t kernelSourceHash() {
+  uint32_t hash = 2166136261u;
+  for (const char* c = kernel_src; *c != '\0'; ++c) {
+    hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+  }
+  return hash;
+}
+
+// Sets fileName to the legalized name of the cached binary of the kernel file
+// clFileName for the named device.
+static void binaryFileName(const char* clFileName, const char* deviceName,
+                           char* fileName, size_t size) {
+  const char* str = strstr(clFileName, ".cl");
+  int name_length = static_cast<int>(str - clFileName);
+  snprintf(fileName, size, "%.*s-%s-%08x.bin", name_length, clFileName,
+           deviceName, kernelSourceHash());
+  legalizeFileName(fileName);
+}
+
 static void populateGPUEnvFromDevice(GPUEnv* gpuInfo, cl_device_id device) {
   // tprintf("[DS] populateGPUEnvFromDevice\n");
   size_t size;
@@ -690,41 +730,58 @@ static Pix* mapOutputCLBuffer(const KernelEnv& rEnv, cl_mem clbuffer, Pix* pixd,
   return pixd;
 }
 
-void OpenclDevice::releaseMorphCLBuffers() {
+// Frees just the three morph buffers, which pixGetLinesCL swaps around.
+static void releaseMorphBuffers() {
   if (pixdCLIntermediate != nullptr) clReleaseMemObject(pixdCLIntermediate);
   if (pixsCLBuffer != nullptr) clReleaseMemObject(pixsCLBuffer);
   if (pixdCLBuffer != nullptr) clReleaseMemObject(pixdCLBuffer);
+  pixdCLIntermediate = pixsCLBuffer = pixdCLBuffer = nullptr;
+  morphBufferWords = 0;
+}
+
+void OpenclDevice::releaseMorphCLBuffers() {
+  releaseMorphBuffers();
   if (pixThBuffer != nullptr) clReleaseMemObject(pixThBuffer);
-  pixdCLIntermediate = pixsCLBuffer = pixdCLBuffer = pixThBuffer = nullptr;
+  pixThBuffer = nullptr;
 }
 
 int OpenclDevice::initMorphCLAllocations(l_int32 wpl, l_int32 h, Pix* pixs) {
   SetKernelEnv(&rEnv);
-
-  if (pixThBuffer != nullptr) {
-    pixsCLBuffer = allocateZeroCopyBuffer(rEnv, nullptr, wpl * h,
+  clStatus = CL_SUCCESS;
+  size_t words = static_cast<size_t>(wpl) * h;
+  if (words > morphBufferWords) {
+    // The buffers are kept for the next images, so they are only made again
+    // when an image is bigger than all the ones before.
+    releaseMorphBuffers();
+    pixsCLBuffer = allocateZeroCopyBuffer(rEnv, nullptr, words,
                                           CL_MEM_ALLOC_HOST_PTR, &clStatus);
+    if (clStatus == CL_SUCCESS) {
+      pixdCLBuffer = allocateZeroCopyBuffer(rEnv, nullptr, words,
+                                            CL_MEM_ALLOC_HOST_PTR, &clStatus);
+    }
+    if (clStatus == CL_SUCCESS) {
+      pixdCLIntermediate = allocateZeroCopyBuffer(
+          rEnv, nullptr, words, CL_MEM_ALLOC_HOST_PTR, &clStatus);
+    }
+    if (clStatus != CL_SUCCESS) {
+      releaseMorphBuffers();
+      return (int)clStatus;
+    }
+    morphBufferWords = words;
+  }
 
+  if (pixThBuffer != nullptr) {
     // Get the output from ThresholdToPix operation
     clStatus =
         clEnqueueCopyBuffer(rEnv.mpkCmdQueue, pixThBuffer, pixsCLBuffer, 0, 0,
-                            sizeof(l_uint32) * wpl * h, 0, nullptr, nullptr);
+                            sizeof(l_uint32) * words, 0, nullptr, nullptr);
   } else {
     // Get data from the source image
-    l_uint32* srcdata =
-        reinterpret_cast<l_uint32*>(malloc(wpl * h * sizeof(l_uint32)));
-    memcpy(srcdata, pixGetData(pixs), wpl * h * sizeof(l_uint32));
-
-    pixsCLBuffer = allocateZeroCopyBuffer(rEnv, srcdata, wpl * h,
-                                          CL_MEM_USE_HOST_PTR, &clStatus);
+    clStatus = clEnqueueWriteBuffer(rEnv.mpkCmdQueue, pixsCLBuffer, CL_TRUE, 0,
+                                    sizeof(l_uint32) * words, pixGetData(pixs),
+                                    0, nullptr, nullptr);
   }
 
-  pixdCLBuffer = allocateZeroCopyBuffer(rEnv, nullptr, wpl * h,
-                                        CL_MEM_ALLOC_HOST_PTR, &clStatus);
-
-  pixdCLIntermediate = allocateZeroCopyBuffer(rEnv, nullptr, wpl * h,
-                                              CL_MEM_ALLOC_HOST_PTR, &clStatus);
-
   return (int)clStatus;
 }
 
@@ -742,6 +799,7 @@ int OpenclDevice::InitEnv() {
 }
 
 int OpenclDevice::ReleaseOpenclRunEnv() {
+  releaseMorphCLBuffers();
   ReleaseOpenclEnv(&gpuEnv);
 #ifdef SAL_WIN32
   FreeOpenclDll();
@@ -830,17 +888,13 @@ int OpenclDevice::BinaryGenerated(const char* clFileName, FILE** fhandle) {
   cl_int clStatus;
   int status = 0;
   FILE* fd = nullptr;
-  char fileName[256] = {0}, cl_name[128] = {0};
+  char fileName[1280] = {0};
   char deviceName[1024];
   clStatus = clGetDeviceInfo(gpuEnv.mpArryDevsID[i], CL_DEVICE_NAME,
                              sizeof(deviceName), deviceName, nullptr);
   CHECK_OPENCL(clStatus, "clGetDeviceInfo");
-  const char* str = strstr(clFileName, ".cl");
-  memcpy(cl_name, clFileName, str - clFileName);
-  cl_name[str - clFileName] = '\0';
-  sprintf(fileName, "%s-%s.bin", cl_name, deviceName);
-  legalizeFileName(fileName);
-  fd = fopen(fileName, "rb");
+  binaryFileName(clFileName, deviceName, fileName, sizeof(fileName));
+  fd = fopen(cacheFilePath(fileName).c_str(), "rb");
   status = (fd != nullptr) ? 1 : 0;
   if (fd != nullptr) {
     *fhandle = fd;
@@ -863,7 +917,7 @@ int OpenclDevice::CachedOfKernerPrg(const GPUEnv* gpuEnvCached,
 int OpenclDevice::WriteBinaryToFile(const char* fileName, const char* birary,
                                     size_t numBytes) {
   FILE* output = nullptr;
-  output = fopen(fileName, "wb");
+  output = fopen(cacheFilePath(fileName).c_str(), "wb");
   if (output == nullptr) {
     return 0;
   }
@@ -919,7 +973,7 @@ int OpenclDevice::GeneratBinFromKernelSource(cl_program program,
 
   /* dump out each binary into its own separate file. */
   for (i = 0; i < numDevices; i++) {
-    char fileName[256] = {0}, cl_name[128] = {0};
+    char fileName[1280] = {0};
 
     if (binarySizes[i] != 0) {
       char deviceName[1024];
@@ -927,11 +981,7 @@ int OpenclDevice::GeneratBinFromKernelSource(cl_program program,
                                  sizeof(deviceName), deviceName, nullptr);
       CHECK_OPENCL(clStatus, "clGetDeviceInfo");
 
-      const char* str = strstr(clFileName, ".cl");
-      memcpy(cl_name, clFileName, str - clFileName);
-      cl_name[str - clFileName] = '\0';
-      sprintf(fileName, "%s-%s.bin", cl_name, deviceName);
-      legalizeFileName(fileName);
+      binaryFileName(clFileName, deviceName, fileName, sizeof(fileName));
       if (!WriteBinaryToFile(fileName, binaries[i], binarySizes[i])) {
         tprintf("[OD] write binary[%s] failed\n", fileName);
         return 0;
@@ -1058,7 +1108,7 @@ int OpenclDevice::CompileKernelFile(GPUEnv* gpuInfo, const char* buildOption) {
       return 0;
     }
 
-    fd1 = fopen("kernel-build.log", "w+");
+    fd1 = fopen(cacheFilePath("kernel-build.log").c_str(), "w+");
     if (fd1 != nullptr) {
       fwrite(&buildLog[0], sizeof(char), length, fd1);
       fclose(fd1);
@@ -1767,6 +1817,183 @@ int OpenclDevice::HistogramRectOCL(void* imageData,
   return retVal;
 }
 
+// Serializes the use of the queue by the threads of
+// LSTMRecognizer::RecognizeLines.
+static std::mutex matrixQueueMutex;
+
+void* OpenclDevice::UploadMatrixWeightsOCL(int num_out, int num_in,
+                                           const int8_t* w) {
+  if (num_out <= 0 || !selectedDeviceIsOpenCL()) return nullptr;
+  cl_int clStatus;
+  KernelEnv matKern;
+  SetKernelEnv(&matKern);
+  size_t w_size = static_cast<size_t>(num_out) * (num_in + 1);
+  cl_mem weightsBuffer = clCreateBuffer(
+      matKern.mpkContext, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, w_size,
+      const_cast<int8_t*>(w), &clStatus);
+  CHECK_OPENCL(clStatus, "clCreateBuffer weightsBuffer");
+  if (clStatus != CL_SUCCESS) return nullptr;
+  return weightsBuffer;
+}
+
+void OpenclDevice::ReleaseMatrixWeightsOCL(void* weights) {
+  if (weights != nullptr) clReleaseMemObject(static_cast<cl_mem>(weights));
+}
+
+int OpenclDevice::MatrixDotMatrixOCL(void* weights, int num_out, int num_in,
+                                     const int8_t* u, int u_stride,
+                                     int num_vectors, int* totals) {
+  if (weights == nullptr || num_out <= 0 || num_vectors <= 0 ||
+      !selectedDeviceIsOpenCL())
+    return -1;
+  cl_mem weightsBuffer = static_cast<cl_mem>(weights);
+  std::lock_guard<std::mutex> lock(matrixQueueMutex);
+  cl_int clStatus;
+  KernelEnv matKern;
+  SetKernelEnv(&matKern);
+  size_t u_size = static_cast<size_t>(num_vectors - 1) * u_stride + num_in;
+  cl_mem inputBuffer = clCreateBuffer(
+      matKern.mpkContext, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, u_size,
+      const_cast<int8_t*>(u), &clStatus);
+  CHECK_OPENCL(clStatus, "clCreateBuffer inputBuffer");
+  if (clStatus != CL_SUCCESS) return -1;
+  size_t totals_size = static_cast<size_t>(num_out) * num_vectors;
+  cl_mem totalsBuffer =
+      clCreateBuffer(matKern.mpkContext, CL_MEM_WRITE_ONLY,
+                     totals_size * sizeof(cl_int), nullptr, &clStatus);
+  CHECK_OPENCL(clStatus, "clCreateBuffer totalsBuffer");
+  if (clStatus != CL_SUCCESS) {
+    clReleaseMemObject(inputBuffer);
+    return -1;
+  }
+  matKern.mpkKernel = clCreateKernel(matKern.mpkProgram,
+                                     "kernel_MatrixDotMatrixInt8", &clStatus);
+  CHECK_OPENCL(clStatus, "clCreateKernel kernel_MatrixDotMatrixInt8");
+  int retVal = -1;
+  if (clStatus == CL_SUCCESS) {
+    clStatus = clSetKernelArg(matKern.mpkKernel, 0, sizeof(cl_mem),
+                              &weightsBuffer);
+    clStatus |= clSetKernelArg(matKern.mpkKernel, 1, sizeof(int), &num_out);
+    clStatus |= clSetKernelArg(matKern.mpkKernel, 2, sizeof(int), &num_in);
+    clStatus |=
+        clSetKernelArg(matKern.mpkKernel, 3, sizeof(cl_mem), &inputBuffer);
+    clStatus |= clSetKernelArg(matKern.mpkKernel, 4, sizeof(int), &u_stride);
+    clStatus |=
+        clSetKernelArg(matKern.mpkKernel, 5, sizeof(int), &num_vectors);
+    clStatus |=
+        clSetKernelArg(matKern.mpkKernel, 6, sizeof(cl_mem), &totalsBuffer);
+    CHECK_OPENCL(clStatus, "clSetKernelArg kernel_MatrixDotMatrixInt8");
+    size_t local_work_size[] = {GROUPSIZE_X, GROUPSIZE_Y};
+    size_t global_work_size[] = {
+        static_cast<size_t>((num_out + GROUPSIZE_X - 1) / GROUPSIZE_X *
+                            GROUPSIZE_X),
+        static_cast<size_t>((num_vectors + GROUPSIZE_Y - 1) / GROUPSIZE_Y *
+                            GROUPSIZE_Y)};
+    if (clStatus == CL_SUCCESS) {
+      clStatus = clEnqueueNDRangeKernel(
+          matKern.mpkCmdQueue, matKern.mpkKernel, 2, nullptr,
+          global_work_size, local_work_size, 0, nullptr, nullptr);
+      CHECK_OPENCL(clStatus, "clEnqueueNDRangeKernel MatrixDotMatrixInt8");
+    }
+    if (clStatus == CL_SUCCESS) {
+      clStatus = clEnqueueReadBuffer(matKern.mpkCmdQueue, totalsBuffer,
+                                     CL_TRUE, 0, totals_size * sizeof(cl_int),
+                                     totals, 0, nullptr, nullptr);
+      CHECK_OPENCL(clStatus, "clEnqueueReadBuffer totalsBuffer");
+    }
+    if (clStatus == CL_SUCCESS) retVal = 0;
+    clReleaseKernel(matKern.mpkKernel);
+  }
+  clReleaseMemObject(totalsBuffer);
+  clReleaseMemObject(inputBuffer);
+  return retVal;
+}
+
+namespace tesseract {
+
+// Computes a single matrix.vector on the CPU, as a launch for one input
+// would cost more than it saves. The shape of intSimdMatrixOpenCL leaves the
+// weights in rows of the inputs followed by the bias.
+static void matrixDotVectorOpenCL(int dim1, int dim2, const int8_t* wi,
+                                  const double* scales, const int8_t* u,
+                                  double* v) {
+  int num_in = dim2 - 1;
+  for (int i = 0; i < dim1; ++i, wi += dim2) {
+    int total = 0;
+    for (int j = 0; j < num_in; ++j) total += wi[j] * u[j];
+    // Add in the bias and correct for integer values.
+    v[i] = (static_cast<double>(total) / INT8_MAX + wi[num_in]) * scales[i];
+  }
+}
+
+// Computes a tile of inputs on the CPU, for weights that are not on the
+// device.
+static void matrixDotMatrixOpenCL(int dim1, int dim2, const int8_t* wi,
+                                  const double* scales, const int8_t* u,
+                                  int u_stride, int num_vectors, double* v,
+                                  int v_stride) {
+  for (int t = 0; t < num_vectors; ++t) {
+    matrixDotVectorOpenCL(dim1, dim2, wi, scales, u + t * u_stride,
+                          v + t * v_stride);
+  }
+}
+
+static void* uploadWeightsOpenCL(int dim1, int dim2, const int8_t* wi) {
+  return OpenclDevice::UploadMatrixWeightsOCL(dim1, dim2 - 1, wi);
+}
+
+static void releaseWeightsOpenCL(void* device_w) {
+  OpenclDevice::ReleaseMatrixWeightsOCL(device_w);
+}
+
+// Computes the integer products of a tile of inputs on the device, falling
+// back to the CPU if it fails.
+static void deviceMatrixDotMatrixOpenCL(void* device_w, int dim1, int dim2,
+                                        const int8_t* wi,
+                                        const double* scales, const int8_t* u,
+                                        int u_stride, int num_vectors,
+                                        double* v, int v_stride) {
+  int num_in = dim2 - 1;
+  std::vector<int> totals(static_cast<size_t>(dim1) * num_vectors);
+  if (OpenclDevice::MatrixDotMatrixOCL(device_w, dim1, num_in, u, u_stride,
+                                       num_vectors, &totals[0]) != 0) {
+    for (int t = 0; t < num_vectors; ++t) {
+      matrixDotVectorOpenCL(dim1, dim2, wi, scales, u + t * u_stride,
+                            v + t * v_stride);
+    }
+    return;
+  }
+  for (int t = 0; t < num_vectors; ++t) {
+    const int* total = &totals[static_cast<size_t>(t) * dim1];
+    double* vt = v + t * v_stride;
+    for (int i = 0; i < dim1; ++i) {
+      vt[i] = (static_cast<double>(total[i]) / INT8_MAX +
+               wi[i * dim2 + num_in]) *
+              scales[i];
+    }
+  }
+}
+
+const IntSimdMatrix IntSimdMatrix::intSimdMatrixOpenCL = {
+  // Functions.
+  matrixDotVectorOpenCL,
+  matrixDotMatrixOpenCL,
+  // Number of 32 bit outputs held in each register.
+  1,
+  // Maximum number of registers that we will use to hold outputs.
+  1,
+  // Number of 8 bit inputs in the inputs register.
+  1,
+  // Number of inputs in each weight group.
+  1,
+  // Device functions.
+  uploadWeightsOpenCL,
+  releaseWeightsOpenCL,
+  deviceMatrixDotMatrixOpenCL
+};
+
+}  // namespace tesseract
+
 /*************************************************************************
  * Threshold the rectangle, taking everything except the image buffer pointer
  * from the class, using thresholds/hi_values to the output IMAGE.
@@ -1812,6 +2039,7 @@ int OpenclDevice::ThresholdRectToPixOCL(unsigned char* imageData,
   CHECK_OPENCL(clStatus, "clCreateBuffer imageBuffer");
 
   /* map pix as write only */
+  if (pixThBuffer != nullptr) clReleaseMemObject(pixThBuffer);
   pixThBuffer =
       clCreateBuffer(rEnv.mpkContext, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
                      pixSize, pixData, &clStatus);
@@ -2485,7 +2713,9 @@ ds_device OpenclDevice::getDeviceSelection() {
       ds_profile* profile;
       status = initDSProfile(&profile, "v0.1");
       // try reading scores from file
-      const char* fileName = "tesseract_opencl_profile_devices.dat";
+      std::string profilePath =
+          cacheFilePath("tesseract_opencl_profile_devices.dat");
+      const char* fileName = profilePath.c_str();
       status = readProfileFromFile(profile, deserializeScore, fileName);
       if (status != DS_SUCCESS) {
         // need to run evaluation
@@ -135,7 +135,9 @@ class OpenclDevice {
 
   /* OpenCL implementations of Morphological operations*/
 
-  // Initialization of OCL buffers used in Morph operations
+  // Initialization of OCL buffers used in Morph operations. The buffers are
+  // kept for the next images until releaseMorphCLBuffers, and only made
+  // again for a bigger image.
   static int initMorphCLAllocations(l_int32 wpl, l_int32 h, Pix* pixs);
   static void releaseMorphCLBuffers();
 
@@ -177,6 +179,22 @@ class OpenclDevice {
                                    int rect_height, int rect_width,
                                    int rect_top, int rect_left);
 
+  /* for LSTM inference */
+  // Copies the num_out rows of int8 weights w, each num_in long and followed
+  // by the bias, to the device. Returns the handle of the device buffer, to be
+  // freed with ReleaseMatrixWeightsOCL, or nullptr on failure.
+  static void* UploadMatrixWeightsOCL(int num_out, int num_in,
+                                      const int8_t* w);
+  // Frees a buffer returned by UploadMatrixWeightsOCL.
+  static void ReleaseMatrixWeightsOCL(void* weights);
+  // Writes to totals[t * num_out + i] the integer dot product of row i of the
+  // weights uploaded by UploadMatrixWeightsOCL, with input t of the
+  // num_vectors int8 inputs that are u_stride apart in u. Returns 0 on
+  // success, or -1 if the caller has to compute the products itself.
+  static int MatrixDotMatrixOCL(void* weights, int num_out, int num_in,
+                                const int8_t* u, int u_stride,
+                                int num_vectors, int* totals);
+
   static ds_device getDeviceSelection();
   static ds_device selectedDevice;
   static bool deviceIsSelected;
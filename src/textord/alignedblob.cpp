@@ -376,7 +376,8 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
   // search does not go into an infinite loop. New blobs must extend the
   // line beyond start_y.
   int start_y = top_to_bottom ? box.bottom() : box.top();
-  if (WithinTestRegion(2, x_start, start_y)) {
+  bool debug = WithinTestRegion(2, x_start, start_y);
+  if (debug) {
     tprintf("Column edges for blob at (%d,%d)->(%d,%d) are [%d, %d]\n",
             box.left(), box.top(), box.right(), box.bottom(),
             left_column_edge, right_column_edge);
@@ -408,7 +409,7 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
   }
   // Setup a vertical search for an aligned blob.
   GridSearch<BLOBNBOX, BLOBNBOX_CLIST, BLOBNBOX_C_IT> vsearch(this);
-  if (WithinTestRegion(2, x_start, start_y))
+  if (debug)
     tprintf("Starting %s %s search at %d-%d,%d, search_size=%d, gutter=%d\n",
             p.ragged ? "Ragged" : "Aligned", p.right_tab ? "Right" : "Left",
             xmin, xmax, start_y, p.max_v_gap, p.min_gutter);
@@ -427,7 +428,7 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
     int n_y = (nbox.top() + nbox.bottom()) / 2;
     if ((!top_to_bottom && n_y > start_y + p.max_v_gap) ||
         (top_to_bottom && n_y < start_y - p.max_v_gap)) {
-      if (WithinTestRegion(2, x_start, start_y))
+      if (debug)
         tprintf("Neighbour too far at (%d,%d)->(%d,%d)\n",
                 nbox.left(), nbox.bottom(), nbox.right(), nbox.top());
       break;  // Gone far enough.
@@ -454,7 +455,7 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
     int n_left = nbox.left();
     int n_right = nbox.right();
     int n_x = p.right_tab ? n_right : n_left;
-    if (WithinTestRegion(2, x_start, start_y))
+    if (debug)
       tprintf("neighbour at (%d,%d)->(%d,%d), n_x=%d, n_y=%d, xatn=%d\n",
               nbox.left(), nbox.bottom(), nbox.right(), nbox.top(),
               n_x, n_y, x_at_n_y);
@@ -466,7 +467,7 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
       if (bbox->right_tab_type() >= TT_MAYBE_ALIGNED)
         bbox->set_right_tab_type(TT_DELETED);
       *end_y = top_to_bottom ? nbox.top() : nbox.bottom();
-      if (WithinTestRegion(2, x_start, start_y))
+      if (debug)
         tprintf("gutter\n");
       return nullptr;
     }
@@ -478,7 +479,7 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
       if (bbox->left_tab_type() >= TT_MAYBE_ALIGNED)
         bbox->set_left_tab_type(TT_DELETED);
       *end_y = top_to_bottom ? nbox.top() : nbox.bottom();
-      if (WithinTestRegion(2, x_start, start_y))
+      if (debug)
         tprintf("gutter\n");
       return nullptr;
     }
@@ -489,7 +490,7 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
         n_x >= x_at_n_y - p.l_align_tolerance) {
       // Aligned so keep it. If it is a marked tab save it as result,
       // otherwise keep it as backup_result to return in case of later failure.
-      if (WithinTestRegion(2, x_start, start_y))
+      if (debug)
         tprintf("aligned, seeking%d, l=%d, r=%d\n",
                 p.right_tab, neighbour->left_tab_type(),
                 neighbour->right_tab_type());
@@ -513,14 +514,14 @@ BLOBNBOX* AlignedBlob::FindAlignedBlob(const AlignedBlobParams& p,
             result = neighbour;
         }
       } else if (backup_result == nullptr) {
-        if (WithinTestRegion(2, x_start, start_y))
+        if (debug)
           tprintf("Backup\n");
         backup_result = neighbour;
       } else {
         TBOX backup_box = backup_result->bounding_box();
         if ((p.right_tab && backup_box.right() < nbox.right()) ||
             (!p.right_tab && backup_box.left() > nbox.left())) {
-          if (WithinTestRegion(2, x_start, start_y))
+          if (debug)
             tprintf("Better backup\n");
           backup_result = neighbour;
         }
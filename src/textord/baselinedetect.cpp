@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <cfloat>               // for FLT_MAX
 #include <cmath>                // for M_PI
+#include <vector>               // for std::vector
 #include "allheaders.h"
 #include "blobbox.h"
 #include "detlinefit.h"
@@ -789,7 +790,7 @@ double BaselineBlock::FitLineSpacingModel(
 
 BaselineDetect::BaselineDetect(int debug_level, const FCOORD& page_skew,
                                TO_BLOCK_LIST* blocks)
-    : page_skew_(page_skew), debug_level_(debug_level) {
+    : page_skew_(page_skew), debug_level_(debug_level), num_threads_(0) {
   TO_BLOCK_IT it(blocks);
   for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
     TO_BLOCK* to_block = it.data();
@@ -810,14 +811,25 @@ BaselineDetect::BaselineDetect(int debug_level, const FCOORD& page_skew,
 // block-wise and page-wise data to smooth small blocks/rows, and applies
 // smoothing based on block/page-level skew and block-level linespacing.
 void BaselineDetect::ComputeStraightBaselines(bool use_box_bottoms) {
-  GenericVector<double> block_skew_angles;
-  for (int i = 0; i < blocks_.size(); ++i) {
+  const int num_blocks = blocks_.size();
+  const int num_threads = debug_level_ > 0 ? 1
+                                           : block_loop_threads(num_threads_);
+  // The angles are gathered in block order afterwards, so the median does
+  // not depend on the order in which the blocks are fitted.
+  std::vector<char> good_skew(num_blocks, false);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int i = 0; i < num_blocks; ++i) {
     BaselineBlock* bl_block = blocks_[i];
     if (debug_level_ > 0)
       tprintf("Fitting initial baselines...\n");
-    if (bl_block->FitBaselinesAndFindSkew(use_box_bottoms)) {
-      block_skew_angles.push_back(bl_block->skew_angle());
-    }
+    good_skew[i] = bl_block->FitBaselinesAndFindSkew(use_box_bottoms);
+  }
+  GenericVector<double> block_skew_angles;
+  for (int i = 0; i < num_blocks; ++i) {
+    if (good_skew[i])
+      block_skew_angles.push_back(blocks_[i]->skew_angle());
   }
   // Compute a page-wide default skew for blocks with too little information.
   double default_block_skew = page_skew_.angle();
@@ -829,7 +841,10 @@ void BaselineDetect::ComputeStraightBaselines(bool use_box_bottoms) {
   }
   // Set bad lines in each block to the default block skew and then force fit
   // a linespacing model where it makes sense to do so.
-  for (int i = 0; i < blocks_.size(); ++i) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int i = 0; i < num_blocks; ++i) {
     BaselineBlock* bl_block = blocks_[i];
     bl_block->ParallelizeBaselines(default_block_skew);
     bl_block->SetupBlockParameters();  // This replaced compute_row_stats.
@@ -846,7 +861,14 @@ void BaselineDetect::ComputeBaselineSplinesAndXheights(const ICOORD& page_tr,
                                                        bool remove_noise,
                                                        bool show_final_rows,
                                                       Textord* textord) {
-  for (int i = 0; i < blocks_.size(); ++i) {
+  const int num_blocks = blocks_.size();
+  // Drawing the rows needs the shared window.
+  const int num_threads = debug_level_ > 0 || show_final_rows
+                              ? 1 : block_loop_threads(num_threads_);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int i = 0; i < num_blocks; ++i) {
     BaselineBlock* bl_block = blocks_[i];
     if (enable_splines)
       bl_block->PrepareForSplineFitting(page_tr, remove_noise);
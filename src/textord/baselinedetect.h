@@ -246,6 +246,11 @@ class BaselineDetect {
 
   ~BaselineDetect() = default;
 
+  // Sets the number of threads for the per-block steps, 0 for the default.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+
   // Finds the initial baselines for each TO_ROW in each TO_BLOCK, gathers
   // block-wise and page-wise data to smooth small blocks/rows, and applies
   // smoothing based on block/page-level skew and block-level linespacing.
@@ -268,6 +273,8 @@ class BaselineDetect {
   FCOORD page_skew_;
   // Amount of debug output to produce.
   int debug_level_;
+  // Requested number of threads for the per-block steps.
+  int num_threads_;
   // The blocks that we are working with.
   PointerVector<BaselineBlock> blocks_;
 };
@@ -80,6 +80,7 @@ void IntGrid::Init(int gridsize, const ICOORD& bleft, const ICOORD& tright) {
   GridBase::Init(gridsize, bleft, tright);
   delete [] grid_;
   grid_ = new int[gridbuckets_];
+  cell_bytes_.Set(static_cast<int64_t>(gridbuckets_) * sizeof(grid_[0]));
   Clear();
 }
 
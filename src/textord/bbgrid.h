@@ -21,10 +21,13 @@
 #ifndef TESSERACT_TEXTORD_BBGRID_H_
 #define TESSERACT_TEXTORD_BBGRID_H_
 
+#include <algorithm>      // for std::find, std::remove
 #include <unordered_set>
+#include <vector>
 
 #include "clst.h"
 #include "coutln.h"
+#include "memoryusage.h"
 #include "rect.h"
 #include "scrollview.h"
 
@@ -90,6 +93,8 @@ class GridBase {
   int gridbuckets_;  // Total cells in grid.
   ICOORD bleft_;     // Pixel coords of bottom-left of grid.
   ICOORD tright_;    // Pixel coords of top-right of grid.
+  // The bytes of the cells, which the subclasses set as they allocate them.
+  TrackedBytes cell_bytes_;
 
  private:
 };
@@ -142,12 +147,14 @@ class IntGrid : public GridBase {
   int* grid_;  // 2-d array of ints.
 };
 
-// The BBGrid class holds C_LISTs of template classes BBC (bounding box class)
-// in a grid for fast neighbour access.
+// The BBGrid class holds arrays of pointers to template classes BBC
+// (bounding box class) in a grid for fast neighbour access.
 // The BBC class must have a member const TBOX& bounding_box() const.
 // The BBC class must have been CLISTIZEH'ed elsewhere to make the
-// list class BBC_CLIST and the iterator BBC_C_IT.
-// Use of C_LISTs enables BBCs to exist in multiple cells simultaneously.
+// list class BBC_CLIST and the iterator BBC_C_IT, which are still used by
+// the users of the grid, although each cell is a contiguous array, so that
+// searches don't have to chase list links.
+// Storing pointers enables BBCs to exist in multiple cells simultaneously.
 // As a consequence, ownership of BBCs is assumed to be elsewhere and
 // persistent for at least the life of the BBGrid, or at least until Clear is
 // called which removes all references to inserted objects without actually
@@ -219,7 +226,8 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class BBGrid
   virtual void HandleClick(int x, int y);
 
  protected:
-  BBC_CLIST* grid_;  // 2-d array of CLISTS of BBC elements.
+  // 2-d array of cells of BBC elements, each sorted by SortByBoxLeft.
+  std::vector<BBC*>* grid_;
 
  private:
 };
@@ -237,7 +245,8 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
  public:
   GridSearch(BBGrid<BBC, BBC_CLIST, BBC_C_IT>* grid)
       : grid_(grid), unique_mode_(false),
-        previous_return_(nullptr), next_return_(nullptr) {
+        previous_return_(nullptr), next_return_(nullptr),
+        cell_(nullptr), cell_index_(0) {
   }
 
   // Get the grid x, y coords of the most recently returned BBC.
@@ -327,6 +336,10 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   void StartRectSearch(const TBOX& rect);
   // Return the next bbox in the rectangular search or nullptr if complete.
   BBC* NextRectSearch();
+  // Runs a whole rectangular search at once, appending to results all that
+  // NextRectSearch would return, in the same order. The boxes of each cell
+  // are tested together with FilterOverlappingBoxes.
+  void RectSearchAll(const TBOX& rect, std::vector<BBC*>* results);
 
   // Remove the last returned BBC. Will not invalidate this. May invalidate
   // any other concurrent GridSearch on the same grid. If any others are
@@ -344,6 +357,9 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   // Factored out function to set the iterator to the current x_, y_
   // grid coords and mark the cycle pt.
   void SetIterator();
+  // Returns true if the cell at x_, y_ has nothing more to return.
+  // Finds next_return_ again if the cell was changed since the last return.
+  bool CellDone();
 
  private:
   // The grid we are searching.
@@ -361,11 +377,16 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT> class GridSearch {
   int y_;
   bool unique_mode_;
   BBC* previous_return_;  // Previous return from Next*.
-  BBC* next_return_;  // Current value of it_.data() used for repositioning.
-  // An iterator over the list at (x_, y_) in the grid_.
-  BBC_C_IT it_;
+  BBC* next_return_;  // Next element of cell_, used for repositioning.
+  // The cell at (x_, y_) in the grid_, and the index of next_return_ in it.
+  std::vector<BBC*>* cell_;
+  int cell_index_;
   // Set of unique returned elements used when unique_mode_ is true.
   std::unordered_set<BBC*, PtrHash<BBC> > returns_;
+  // Scratch space for the boxes of a cell and the indices of the hits among
+  // them in RectSearchAll.
+  std::vector<TBOX> cell_boxes_;
+  std::vector<int> hit_indices_;
 };
 
 // Sort function to sort a BBC by bounding_box().left().
@@ -386,6 +407,24 @@ int SortByBoxLeft(const void* void1, const void* void2) {
   return p1->bounding_box().top() - p2->bounding_box().top();
 }
 
+// Inserts bbox into the cell, keeping it sorted by SortByBoxLeft, unless it
+// is there already. As with CLIST::add_sorted, bbox goes after any elements
+// that compare equal to it.
+template<class BBC>
+void InsertSortedByBoxLeft(BBC* bbox, std::vector<BBC*>* cell) {
+  if (cell->empty() || SortByBoxLeft<BBC>(&cell->back(), &bbox) < 0) {
+    cell->push_back(bbox);
+    return;
+  }
+  if (cell->back() == bbox) return;
+  auto it = cell->begin();
+  for (; it != cell->end(); ++it) {
+    if (*it == bbox) return;
+    if (SortByBoxLeft<BBC>(&*it, &bbox) > 0) break;
+  }
+  cell->insert(it, bbox);
+}
+
 // Sort function to sort a BBC by bounding_box().right() in right-to-left order.
 template<class BBC>
 int SortRightToLeft(const void* void1, const void* void2) {
@@ -449,14 +488,15 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Init(int gridsize,
                                             const ICOORD& tright) {
   GridBase::Init(gridsize, bleft, tright);
   delete [] grid_;
-  grid_ = new BBC_CLIST[gridbuckets_];
+  grid_ = new std::vector<BBC*>[gridbuckets_];
+  cell_bytes_.Set(static_cast<int64_t>(gridbuckets_) * sizeof(grid_[0]));
 }
 
 // Clear all lists, but leave the array of lists present.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::Clear() {
   for (int i = 0; i < gridbuckets_; ++i) {
-    grid_[i].shallow_clear();
+    grid_[i].clear();
   }
 }
 
@@ -498,7 +538,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertBBox(bool h_spread, bool v_spread,
   int grid_index = start_y * gridwidth_;
   for (int y = start_y; y <= end_y; ++y, grid_index += gridwidth_) {
     for (int x = start_x; x <= end_x; ++x) {
-      grid_[grid_index + x].add_sorted(SortByBoxLeft<BBC>, true, bbox);
+      InsertSortedByBoxLeft(bbox, &grid_[grid_index + x]);
     }
   }
 }
@@ -521,8 +561,7 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::InsertPixPtBBox(int left, int bottom,
     l_uint32* data = pixGetData(pix) + y * pixGetWpl(pix);
     for (int x = 0; x < width; ++x) {
       if (GET_DATA_BIT(data, x)) {
-        grid_[(bottom + y) * gridwidth_ + x + left].
-          add_sorted(SortByBoxLeft<BBC>, true, bbox);
+        InsertSortedByBoxLeft(bbox, &grid_[(bottom + y) * gridwidth_ + x + left]);
       }
     }
   }
@@ -540,11 +579,8 @@ void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox(BBC* bbox) {
   int grid_index = start_y * gridwidth_;
   for (int y = start_y; y <= end_y; ++y, grid_index += gridwidth_) {
     for (int x = start_x; x <= end_x; ++x) {
-      BBC_C_IT it(&grid_[grid_index + x]);
-      for (it.mark_cycle_pt(); !it.cycled_list(); it.forward()) {
-        if (it.data() == bbox)
-          it.extract();
-      }
+      std::vector<BBC*>& cell = grid_[grid_index + x];
+      cell.erase(std::remove(cell.begin(), cell.end(), bbox), cell.end());
     }
   }
 }
@@ -564,7 +600,7 @@ IntGrid* BBGrid<BBC, BBC_CLIST, BBC_C_IT>::CountCellElements() {
   auto* intgrid = new IntGrid(gridsize(), bleft(), tright());
   for (int y = 0; y < gridheight(); ++y) {
     for (int x = 0; x < gridwidth(); ++x) {
-      int cell_count = grid_[y * gridwidth() + x].length();
+      int cell_count = grid_[y * gridwidth() + x].size();
       intgrid->SetGridCell(x, y, cell_count);
     }
   }
@@ -640,14 +676,12 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void BBGrid<BBC, BBC_CLIST, BBC_C_IT>::AssertNoDuplicates() {
   // Process all grid cells.
   for (int i = gridwidth_ * gridheight_ - 1; i >= 0; --i) {
-    // Iterate over all elements excent the last.
-    for (BBC_C_IT it(&grid_[i]); !it.at_last(); it.forward()) {
-      BBC* ptr = it.data();
-      BBC_C_IT it2(it);
-      // None of the rest of the elements in the list should equal ptr.
-      for (it2.forward(); !it2.at_first(); it2.forward()) {
-        ASSERT_HOST(it2.data() != ptr);
-      }
+    const std::vector<BBC*>& cell = grid_[i];
+    // Iterate over all elements except the last.
+    for (size_t j = 0; j + 1 < cell.size(); ++j) {
+      // None of the rest of the elements in the cell should equal cell[j].
+      ASSERT_HOST(std::find(cell.begin() + j + 1, cell.end(), cell[j]) ==
+                  cell.end());
     }
   }
 }
@@ -678,7 +712,7 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextFullSearch() {
   int x;
   int y;
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++x_;
       if (x_ >= grid_->gridwidth_) {
         --y_;
@@ -714,7 +748,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRadSearch(int x, int y,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRadSearch() {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++rad_index_;
       if (rad_index_ >= radius_) {
         ++rad_dir_;
@@ -762,7 +796,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartSideSearch(int x,
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextSideSearch(bool right_to_left) {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (right_to_left)
@@ -804,7 +838,7 @@ template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextVerticalSearch(
     bool top_to_bottom) {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++rad_index_;
       if (rad_index_ > radius_) {
         if (top_to_bottom)
@@ -843,7 +877,7 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::StartRectSearch(const TBOX& rect) {
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
   do {
-    while (it_.cycled_list()) {
+    while (CellDone()) {
       ++x_;
       if (x_ > max_radius_) {
         --y_;
@@ -861,6 +895,33 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::NextRectSearch() {
   return previous_return_;
 }
 
+// Runs a whole rectangular search at once, appending to results all that
+// NextRectSearch would return, in the same order.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RectSearchAll(
+    const TBOX& rect, std::vector<BBC*>* results) {
+  StartRectSearch(rect);
+  for (; y_ >= y_origin_; --y_) {
+    for (x_ = x_origin_; x_ <= max_radius_; ++x_) {
+      const std::vector<BBC*>& cell = grid_->grid_[y_ * grid_->gridwidth_ + x_];
+      const int cell_size = cell.size();
+      if (cell_size == 0) continue;
+      cell_boxes_.resize(cell_size);
+      hit_indices_.resize(cell_size);
+      for (int i = 0; i < cell_size; ++i)
+        cell_boxes_[i] = cell[i]->bounding_box();
+      int num_hits = FilterOverlappingBoxes(rect_, &cell_boxes_[0], cell_size,
+                                            &hit_indices_[0]);
+      for (int h = 0; h < num_hits; ++h) {
+        BBC* bbox = cell[hit_indices_[h]];
+        if (unique_mode_ && !returns_.insert(bbox).second) continue;
+        results->push_back(bbox);
+      }
+    }
+  }
+  CommonEnd();
+}
+
 // Remove the last returned BBC. Will not invalidate this. May invalidate
 // any other concurrent GridSearch on the same grid. If any others are
 // in use, call RepositionIterator on those, to continue without harm.
@@ -872,16 +933,14 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RemoveBBox() {
     // if previous_return_ is not on the list, then it has been removed already.
     BBC* prev_data = nullptr;
     BBC* new_previous_return = nullptr;
-    it_.move_to_first();
-    for (it_.mark_cycle_pt(); !it_.cycled_list();) {
-      if (it_.data() ==  previous_return_) {
+    for (size_t i = 0; i < cell_->size();) {
+      if ((*cell_)[i] == previous_return_) {
         new_previous_return = prev_data;
-        it_.extract();
-        it_.forward();
-        next_return_ = it_.cycled_list() ? nullptr : it_.data();
+        cell_->erase(cell_->begin() + i);
+        next_return_ = i < cell_->size() ? (*cell_)[i] : nullptr;
       } else {
-        prev_data = it_.data();
-        it_.forward();
+        prev_data = (*cell_)[i];
+        ++i;
       }
     }
     grid_->RemoveBBox(previous_return_);
@@ -898,17 +957,18 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::RepositionIterator() {
   // Reset the iterator back to one past the previous return.
   // If the previous_return_ is no longer in the list, then
   // next_return_ serves as a backup.
-  it_.move_to_first();
+  cell_index_ = 0;
   // Special case, the first element was removed and reposition
   // iterator was called. In this case, the data is fine, but the
   // cycle point is not. Detect it and return.
-  if (!it_.empty() && it_.data() == next_return_) {
-    it_.mark_cycle_pt();
+  const int cell_size = cell_->size();
+  if (cell_size > 0 && (*cell_)[0] == next_return_)
     return;
-  }
-  for (it_.mark_cycle_pt(); !it_.cycled_list(); it_.forward()) {
-    if (it_.data() == previous_return_ ||
-        it_.data_relative(1) == next_return_) {
+  for (; cell_index_ < cell_size; ++cell_index_) {
+    // As the cell used to be a circular list, the last element is
+    // followed by the first.
+    if ((*cell_)[cell_index_] == previous_return_ ||
+        (*cell_)[(cell_index_ + 1) % cell_size] == next_return_) {
       CommonNext();
       return;
     }
@@ -926,16 +986,16 @@ void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonStart(int x, int y) {
   y_ = y_origin_;
   SetIterator();
   previous_return_ = nullptr;
-  next_return_ = it_.empty() ? nullptr : it_.data();
   returns_.clear();
 }
 
 // Factored out helper to complete a next search.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonNext() {
-  previous_return_ = it_.data();
-  it_.forward();
-  next_return_ = it_.cycled_list() ? nullptr : it_.data();
+  previous_return_ = (*cell_)[cell_index_];
+  ++cell_index_;
+  next_return_ = cell_index_ < static_cast<int>(cell_->size())
+                     ? (*cell_)[cell_index_] : nullptr;
   return previous_return_;
 }
 
@@ -951,8 +1011,31 @@ BBC* GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CommonEnd() {
 // grid coords and mark the cycle pt.
 template<class BBC, class BBC_CLIST, class BBC_C_IT>
 void GridSearch<BBC, BBC_CLIST, BBC_C_IT>::SetIterator() {
-  it_= &(grid_->grid_[y_ * grid_->gridwidth_ + x_]);
-  it_.mark_cycle_pt();
+  cell_ = &grid_->grid_[y_ * grid_->gridwidth_ + x_];
+  cell_index_ = 0;
+  next_return_ = cell_->empty() ? nullptr : (*cell_)[0];
+}
+
+// Returns true if the cell at x_, y_ has nothing more to return.
+// Finds next_return_ again if the cell was changed since the last return.
+template<class BBC, class BBC_CLIST, class BBC_C_IT>
+bool GridSearch<BBC, BBC_CLIST, BBC_C_IT>::CellDone() {
+  if (next_return_ == nullptr)
+    return true;
+  const int cell_size = cell_->size();
+  if (cell_index_ >= cell_size || (*cell_)[cell_index_] != next_return_) {
+    // Other elements were inserted or removed, probably by another search.
+    auto it = std::find(cell_->begin(), cell_->end(), next_return_);
+    if (it != cell_->end()) {
+      cell_index_ = it - cell_->begin();
+    } else if (cell_index_ < cell_size) {
+      next_return_ = (*cell_)[cell_index_];
+    } else {
+      next_return_ = nullptr;
+      return true;
+    }
+  }
+  return false;
 }
 
 }  // namespace tesseract.
@@ -39,46 +39,47 @@ static const float kFPTolerance = 0.1;
 static const float kFixedPitchThreshold = 0.35;
 
 // rank statistics for a small collection of float values.
+// The values are never fully sorted: each rank query selects the order
+// statistics it needs in linear time, as only a handful of ranks are asked
+// for per row while the pass2 loop re-estimates the pitch many times.
 class SimpleStats {
  public:
-  SimpleStats(): finalized_(false), values_() { }
+  SimpleStats(): values_() { }
   ~SimpleStats() { }
 
   void Clear() {
     values_.clear();
-    finalized_ = false;
   }
 
   void Add(float value) {
     values_.push_back(value);
-    finalized_ = false;
-  }
-
-  void Finish() {
-    values_.sort(float_compare);
-    finalized_ = true;
   }
 
   float ile(double frac) {
-    if (!finalized_) Finish();
     if (values_.empty()) return 0.0;
-    if (frac >= 1.0) return values_.back();
-    if (frac <= 0.0 || values_.size() == 1) return values_[0];
+    if (frac >= 1.0) {
+      return *std::max_element(values_.begin(), values_.end());
+    }
+    if (frac <= 0.0 || values_.size() == 1) return minimum();
     int index = static_cast<int>((values_.size() - 1) * frac);
     float reminder = (values_.size() - 1) * frac - index;
 
-    return values_[index] * (1.0 - reminder) +
-        values_[index + 1] * reminder;
+    // Select the index-th smallest value. Everything after it is no smaller,
+    // so the next order statistic is the minimum of the rest.
+    std::nth_element(values_.begin(), values_.begin() + index, values_.end());
+    float lower = values_[index];
+    float upper = *std::min_element(values_.begin() + index + 1,
+                                    values_.end());
+    return lower * (1.0 - reminder) + upper * reminder;
   }
 
   float median() {
     return ile(0.5);
   }
 
-  float minimum() {
-    if (!finalized_) Finish();
+  float minimum() const {
     if (values_.empty()) return 0.0;
-    return values_[0];
+    return *std::min_element(values_.begin(), values_.end());
   }
 
   int size() const {
@@ -86,14 +87,7 @@ class SimpleStats {
   }
 
  private:
-  static int float_compare(const void* a, const void* b) {
-    const auto* f_a = static_cast<const float*>(a);
-    const auto* f_b = static_cast<const float*>(b);
-    return (*f_a > *f_b) ? 1 : ((*f_a < *f_b) ? -1 : 0);
-  }
-
-  bool finalized_;
-  GenericVector<float> values_;
+  std::vector<float> values_;
 };
 
 // statistics for a small collection of float pairs (x, y).
@@ -109,8 +103,23 @@ class LocalCorrelation {
   LocalCorrelation(): finalized_(false) { }
   ~LocalCorrelation() { }
 
+  // Sorts the samples by x and accumulates the vote weighted y/x ratios, so
+  // each EstimateYFor is a pair of binary searches instead of a scan over
+  // all the rows of the page.
   void Finish() {
-    values_.sort(float_pair_compare);
+    std::stable_sort(values_.begin(), values_.end(),
+                     [](const float_pair& a, const float_pair& b) {
+                       return a.x < b.x;
+                     });
+    ratio_sums_.resize(values_.size() + 1);
+    vote_sums_.resize(values_.size() + 1);
+    ratio_sums_[0] = 0.0f;
+    vote_sums_[0] = 0;
+    for (size_t i = 0; i < values_.size(); ++i) {
+      ratio_sums_[i + 1] =
+          ratio_sums_[i] + values_[i].vote * values_[i].y / values_[i].x;
+      vote_sums_[i + 1] = vote_sums_[i] + values_[i].vote;
+    }
     finalized_ = true;
   }
 
@@ -129,11 +138,16 @@ class LocalCorrelation {
 
   float EstimateYFor(float x, float r) {
     ASSERT_HOST(finalized_);
-    int start = 0, end = values_.size();
-    // Because the number of samples (used_) is assumed to be small,
-    // just use linear search to find values within the range.
-    while (start < values_.size() && values_[start].x < x * (1.0 - r)) start++;
-    while (end - 1 >= 0 && values_[end - 1].x > x * (1.0 + r)) end--;
+    // Find the samples within the range.
+    const double low = x * (1.0 - r), high = x * (1.0 + r);
+    size_t start = std::lower_bound(values_.begin(), values_.end(), low,
+                                    [](const float_pair& a, double v) {
+                                      return a.x < v;
+                                    }) - values_.begin();
+    size_t end = std::upper_bound(values_.begin(), values_.end(), high,
+                                  [](double v, const float_pair& a) {
+                                    return v < a.x;
+                                  }) - values_.begin();
 
     // Fall back to the global average if there are no data within r
     // of x.
@@ -143,25 +157,18 @@ class LocalCorrelation {
     }
 
     // Compute weighted average of the values.
-    float rc = 0;
-    int vote = 0;
-    for (int i = start; i < end; i++) {
-      rc += values_[i].vote * x * values_[i].y / values_[i].x;
-      vote += values_[i].vote;
-    }
+    float rc = x * (ratio_sums_[end] - ratio_sums_[start]);
+    int vote = vote_sums_[end] - vote_sums_[start];
 
     return rc / vote;
   }
 
  private:
-  static int float_pair_compare(const void* a, const void* b) {
-    const auto* f_a = static_cast<const float_pair*>(a);
-    const auto* f_b = static_cast<const float_pair*>(b);
-    return (f_a->x > f_b->x) ? 1 : ((f_a->x < f_b->x) ? -1 : 0);
-  }
-
   bool finalized_;
-  GenericVector<struct float_pair> values_;
+  std::vector<float_pair> values_;
+  // Prefix sums of vote * y / x and of vote over the sorted values_.
+  std::vector<float> ratio_sums_;
+  std::vector<int> vote_sums_;
 };
 
 // Class to represent a character on a fixed pitch row.  A FPChar may
@@ -488,7 +495,6 @@ void FPRow::Init(TO_ROW *row) {
       }
     }
   }
-  heights_.Finish();
   height_ = heights_.ile(0.875);
 }
 
@@ -631,12 +637,6 @@ void FPRow::EstimatePitch(bool pass1) {
     cx0 = cx1;
   }
 
-  good_pitches_.Finish();
-  all_pitches_.Finish();
-  good_gaps_.Finish();
-  all_gaps_.Finish();
-  heights_.Finish();
-
   height_ = heights_.ile(0.875);
   if (all_pitches_.size() == 0) {
     pitch_ = 0.0f;
@@ -34,6 +34,7 @@
 #include "blobbox.h"
 #include "scrollview.h"
 #include "tablefind.h"
+#include "tracing.h"
 #include "params.h"
 #include "workingpartset.h"
 
@@ -80,6 +81,8 @@ ColumnFinder::ColumnFinder(int gridsize,
   : TabFind(gridsize, bleft, tright, vlines, vertical_x, vertical_y,
             resolution),
     cjk_script_(cjk_script),
+    num_threads_(0),
+    compute_edge_offsets_(true),
     min_gutter_width_(static_cast<int>(kMinGutterWidthGrid * gridsize)),
     mean_column_gap_(tright.x() - bleft.x()),
     tabfind_aligned_gap_fraction_(aligned_gap_fraction),
@@ -145,6 +148,7 @@ void ColumnFinder::SetupAndFilterNoise(PageSegMode pageseg_mode,
   part_grid_.Init(gridsize(), bleft(), tright());
   delete stroke_width_;
   stroke_width_ = new StrokeWidth(gridsize(), bleft(), tright());
+  stroke_width_->set_num_threads(num_threads_);
   min_gutter_width_ = static_cast<int>(kMinGutterWidthGrid * gridsize());
   input_block->ReSetAndReFilterBlobs();
   #ifndef GRAPHICS_DISABLED
@@ -288,6 +292,7 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
                              Pix* grey_pix, DebugPixa* pixa_debug,
                              BLOCK_LIST* blocks, BLOBNBOX_LIST* diacritic_blobs,
                              TO_BLOCK_LIST* to_blocks) {
+  TraceSpan span("ColumnFinder::FindBlocks");
   pixOr(photo_mask_pix, photo_mask_pix, nontext_map_);
   stroke_width_->FindLeaderPartitions(input_block, &part_grid_);
   stroke_width_->RemoveLineResidue(&big_parts_);
@@ -321,7 +326,8 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
   // here as the c_blobs haven't been touched by rotation or anything yet,
   // so no denorm is required, yet the text has been separated from image, so
   // no time is wasted running it on image blobs.
-  input_block->ComputeEdgeOffsets(thresholds_pix, grey_pix);
+  if (compute_edge_offsets_)
+    input_block->ComputeEdgeOffsets(thresholds_pix, grey_pix);
 
   // A note about handling right-to-left scripts (Hebrew/Arabic):
   // The columns must be reversed and come out in right-to-left instead of
@@ -387,19 +393,22 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
 
     part_grid_.GridFindMargins(best_columns_);
     // Split and merge the partitions by looking at local neighbours.
-    GridSplitPartitions();
+    // Only the margins near the partitions that change need recomputing.
+    GenericVector<TBOX> changed_boxes;
+    GridSplitPartitions(&changed_boxes);
     // Resolve unknown partitions by adding to an existing partition, fixing
     // the type, or declaring them noise.
-    part_grid_.GridFindMargins(best_columns_);
-    GridMergePartitions();
+    part_grid_.GridFindMarginsNear(best_columns_, changed_boxes);
+    changed_boxes.truncate(0);
+    GridMergePartitions(&changed_boxes);
     // Insert any unused noise blobs that are close enough to an appropriate
     // partition.
-    InsertRemainingNoise(input_block);
+    InsertRemainingNoise(input_block, &changed_boxes);
     // Add horizontal line separators as partitions.
-    GridInsertHLinePartitions();
-    GridInsertVLinePartitions();
+    GridInsertHLinePartitions(&changed_boxes);
+    GridInsertVLinePartitions(&changed_boxes);
     // Recompute margins based on a local neighbourhood search.
-    part_grid_.GridFindMargins(best_columns_);
+    part_grid_.GridFindMarginsNear(best_columns_, changed_boxes);
     SetPartitionTypes();
   }
   if (textord_tabfind_show_initial_partitions) {
@@ -416,6 +425,7 @@ int ColumnFinder::FindBlocks(PageSegMode pageseg_mode, Pix* scaled_color,
       TableFinder table_finder;
       table_finder.Init(gridsize(), bleft(), tright());
       table_finder.set_resolution(resolution_);
+      table_finder.set_num_threads(num_threads_);
       table_finder.set_left_to_right_language(
           !input_block->block->right_to_left());
       // Copy cleaned partitions from part_grid_ to clean_part_grid_ and
@@ -956,7 +966,7 @@ void ColumnFinder::ReleaseBlobsAndCleanupUnused(TO_BLOCK* block) {
 }
 
 // Splits partitions that cross columns where they have nothing in the gap.
-void ColumnFinder::GridSplitPartitions() {
+void ColumnFinder::GridSplitPartitions(GenericVector<TBOX>* changed_boxes) {
   // Iterate the ColPartitions in the grid.
   GridSearch<ColPartition, ColPartition_CLIST, ColPartition_C_IT>
     gsearch(&part_grid_);
@@ -1017,6 +1027,7 @@ void ColumnFinder::GridSplitPartitions() {
     if (bbox == nullptr) {
       // There seems to be nothing in the hole, so split the partition.
       gsearch.RemoveBBox();
+      changed_boxes->push_back(part->bounding_box());
       int x_middle = (margin_box.left() + margin_box.right()) / 2;
       if (debug) {
         tprintf("Splitting part at %d:", x_middle);
@@ -1048,7 +1059,7 @@ void ColumnFinder::GridSplitPartitions() {
 
 // Merges partitions where there is vertical overlap, within a single column,
 // and the horizontal gap is small enough.
-void ColumnFinder::GridMergePartitions() {
+void ColumnFinder::GridMergePartitions(GenericVector<TBOX>* changed_boxes) {
   // Iterate the ColPartitions in the grid.
   GridSearch<ColPartition, ColPartition_CLIST, ColPartition_C_IT>
     gsearch(&part_grid_);
@@ -1126,7 +1137,9 @@ void ColumnFinder::GridMergePartitions() {
             gsearch.RemoveBBox();
             rsearch.RepositionIterator();
             modified_box = true;
+            changed_boxes->push_back(part->bounding_box());
           }
+          changed_boxes->push_back(neighbour_box);
           part->Absorb(neighbour, WidthCB());
         } else if (debug) {
           tprintf("Neighbour failed hgap test\n");
@@ -1143,6 +1156,7 @@ void ColumnFinder::GridMergePartitions() {
       // Because the box has changed, it has to be removed first, otherwise
       // add_sorted may fail to keep a single copy of the pointer.
       part_grid_.InsertBBox(true, true, part);
+      changed_boxes->push_back(part->bounding_box());
       gsearch.RepositionIterator();
     }
   }
@@ -1150,7 +1164,8 @@ void ColumnFinder::GridMergePartitions() {
 
 // Inserts remaining noise blobs into the most applicable partition if any.
 // If there is no applicable partition, then the blobs are deleted.
-void ColumnFinder::InsertRemainingNoise(TO_BLOCK* block) {
+void ColumnFinder::InsertRemainingNoise(TO_BLOCK* block,
+                                        GenericVector<TBOX>* changed_boxes) {
   BLOBNBOX_IT blob_it(&block->noise_blobs);
   for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
     BLOBNBOX* blob = blob_it.data();
@@ -1187,8 +1202,10 @@ void ColumnFinder::InsertRemainingNoise(TO_BLOCK* block) {
         best_part->Print();
       }
       part_grid_.RemoveBBox(best_part);
+      changed_boxes->push_back(best_part->bounding_box());
       best_part->AddBox(blob);
       part_grid_.InsertBBox(true, true, best_part);
+      changed_boxes->push_back(best_part->bounding_box());
       blob->set_owner(best_part);
       blob->set_flow(best_part->flow());
       blob->set_region_type(best_part->blob_type());
@@ -1255,7 +1272,8 @@ void ColumnFinder::GridRemoveUnderlinePartitions() {
 }
 
 // Add horizontal line separators as partitions.
-void ColumnFinder::GridInsertHLinePartitions() {
+void ColumnFinder::GridInsertHLinePartitions(
+    GenericVector<TBOX>* changed_boxes) {
   TabVector_IT hline_it(&horizontal_lines_);
   for (hline_it.mark_cycle_pt(); !hline_it.cycled_list(); hline_it.forward()) {
     TabVector* hline = hline_it.data();
@@ -1275,15 +1293,18 @@ void ColumnFinder::GridInsertHLinePartitions() {
         break;
       }
     }
-    if (!any_image)
+    if (!any_image) {
       part_grid_.InsertBBox(true, true, part);
-    else
+      changed_boxes->push_back(part->bounding_box());
+    } else {
       delete part;
+    }
   }
 }
 
 // Add horizontal line separators as partitions.
-void ColumnFinder::GridInsertVLinePartitions() {
+void ColumnFinder::GridInsertVLinePartitions(
+    GenericVector<TBOX>* changed_boxes) {
   TabVector_IT vline_it(dead_vectors());
   for (vline_it.mark_cycle_pt(); !vline_it.cycled_list(); vline_it.forward()) {
     TabVector* vline = vline_it.data();
@@ -1313,10 +1334,12 @@ void ColumnFinder::GridInsertVLinePartitions() {
         break;
       }
     }
-    if (!any_image)
+    if (!any_image) {
       part_grid_.InsertBBox(true, true, part);
-    else
+      changed_boxes->push_back(part->bounding_box());
+    } else {
       delete part;
+    }
   }
 }
 
@@ -74,6 +74,16 @@ class ColumnFinder : public TabFind {
   void set_cjk_script(bool is_cjk) {
     cjk_script_ = is_cjk;
   }
+  // Sets the number of threads requested for the parallel parts of the
+  // layout analysis. See NumThreads.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+  // Whether FindBlocks computes the sub-pixel edge offsets of the blob
+  // outlines, which only the legacy classifier uses.
+  void set_compute_edge_offsets(bool flag) {
+    compute_edge_offsets_ = flag;
+  }
 
   // ======================================================================
   // The main function of ColumnFinder is broken into pieces to facilitate
@@ -233,20 +243,26 @@ class ColumnFinder : public TabFind {
   // ownership to the output blocks.
   void ReleaseBlobsAndCleanupUnused(TO_BLOCK* block);
   // Splits partitions that cross columns where they have nothing in the gap.
-  void GridSplitPartitions();
+  // The boxes of the partitions that are changed are added to changed_boxes.
+  void GridSplitPartitions(GenericVector<TBOX>* changed_boxes);
   // Merges partitions where there is vertical overlap, within a single column,
   // and the horizontal gap is small enough.
-  void GridMergePartitions();
+  // The boxes of the partitions that are changed are added to changed_boxes.
+  void GridMergePartitions(GenericVector<TBOX>* changed_boxes);
   // Inserts remaining noise blobs into the most applicable partition if any.
   // If there is no applicable partition, then the blobs are deleted.
-  void InsertRemainingNoise(TO_BLOCK* block);
+  // The boxes of the partitions that are changed are added to changed_boxes.
+  void InsertRemainingNoise(TO_BLOCK* block,
+                            GenericVector<TBOX>* changed_boxes);
   // Remove partitions that come from horizontal lines that look like
   // underlines, but are not part of a table.
   void GridRemoveUnderlinePartitions();
   // Add horizontal line separators as partitions.
-  void GridInsertHLinePartitions();
+  // The boxes of the added partitions are added to changed_boxes.
+  void GridInsertHLinePartitions(GenericVector<TBOX>* changed_boxes);
   // Add vertical line separators as partitions.
-  void GridInsertVLinePartitions();
+  // The boxes of the added partitions are added to changed_boxes.
+  void GridInsertVLinePartitions(GenericVector<TBOX>* changed_boxes);
   // For every ColPartition in the grid, sets its type based on position
   // in the columns.
   void SetPartitionTypes();
@@ -298,6 +314,10 @@ class ColumnFinder : public TabFind {
   // If true then the page language is cjk, so it is safe to perform
   // FixBrokenCJK.
   bool cjk_script_;
+  // Number of threads requested for the parallel parts of layout analysis.
+  int num_threads_;
+  // If true, FindBlocks computes the edge offsets of the blob outlines.
+  bool compute_edge_offsets_;
   // The minimum gutter width to apply for finding columns.
   // Modified when vertical text is detected to prevent detection of
   // vertical text lines as columns.
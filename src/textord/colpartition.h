@@ -23,6 +23,7 @@
 
 #include "bbgrid.h"
 #include "blobbox.h"       // For BlobRegionType.
+#include "freelist.h"       // For FREE_LIST_ALLOCATED.
 #include "ocrblock.h"
 #include "rect.h"           // For TBOX.
 #include "scrollview.h"
@@ -77,6 +78,7 @@ class ColPartition : public ELIST2_LINK {
    * @param vertical is the direction of logical vertical on the possibly skewed image.
    */
   ColPartition(BlobRegionType blob_type, const ICOORD& vertical);
+  FREE_LIST_ALLOCATED(ColPartition, kMaxFreePartitionBytes)
   /**
    * Constructs a fake ColPartition with no BLOBNBOXes to represent a
    * horizontal or vertical line, given a type and a bounding box.
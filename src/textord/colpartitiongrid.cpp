@@ -25,6 +25,7 @@
 #include "imagefind.h"
 
 #include <algorithm>
+#include <vector>
 
 namespace tesseract {
 
@@ -353,9 +354,9 @@ void ColPartitionGrid::FindOverlappingPartitions(const TBOX& box,
                                                  const ColPartition* not_this,
                                                  ColPartition_CLIST* parts) {
   ColPartitionGridSearch rsearch(this);
-  rsearch.StartRectSearch(box);
-  ColPartition* part;
-  while ((part = rsearch.NextRectSearch()) != nullptr) {
+  std::vector<ColPartition*> overlaps;
+  rsearch.RectSearchAll(box, &overlaps);
+  for (ColPartition* part : overlaps) {
     if (part != not_this)
       parts->add_sorted(SortByBoxLeft<ColPartition>, true, part);
   }
@@ -982,6 +983,46 @@ void ColPartitionGrid::GridFindMargins(ColPartitionSet** best_columns) {
   }
 }
 
+// As GridFindMargins, but only for the ColPartitions that share a grid row
+// with any of changed_boxes, which must include the old and new boxes of
+// every partition that has been changed, added or removed since the margins
+// were last computed.
+void ColPartitionGrid::GridFindMarginsNear(
+    ColPartitionSet** best_columns, const GenericVector<TBOX>& changed_boxes) {
+  if (changed_boxes.empty()) return;
+  // Mark the changed rows, and count them up to each row, so the test of
+  // each partition is just a difference of two counts.
+  std::vector<int> changed_counts(gridheight() + 1, 0);
+  for (int i = 0; i < changed_boxes.size(); ++i) {
+    const TBOX& box = changed_boxes[i];
+    int grid_x, bottom_y, top_y;
+    GridCoords(box.left(), box.bottom(), &grid_x, &bottom_y);
+    GridCoords(box.right(), box.top(), &grid_x, &top_y);
+    for (int y = bottom_y; y <= top_y; ++y) changed_counts[y + 1] = 1;
+  }
+  for (int y = 0; y < gridheight(); ++y)
+    changed_counts[y + 1] += changed_counts[y];
+  // Iterate the ColPartitions in the grid.
+  ColPartitionGridSearch gsearch(this);
+  gsearch.StartFullSearch();
+  ColPartition* part;
+  while ((part = gsearch.NextFullSearch()) != nullptr) {
+    const TBOX& box = part->bounding_box();
+    int grid_x, bottom_y, top_y;
+    GridCoords(box.left(), box.bottom(), &grid_x, &bottom_y);
+    GridCoords(box.right(), box.top(), &grid_x, &top_y);
+    if (changed_counts[top_y + 1] == changed_counts[bottom_y]) continue;
+    ColPartitionSet* columns = best_columns != nullptr
+                             ? best_columns[gsearch.GridY()]
+                             : nullptr;
+    FindPartitionMargins(columns, part);
+    if (AlignedBlob::WithinTestRegion(2, box.left(), box.bottom())) {
+      tprintf("Computed margins for part:");
+      part->Print();
+    }
+  }
+}
+
 // Improves the margins of the ColPartitions in the list by calling
 // FindPartitionMargins on each.
 // best_columns, which may be nullptr, is an array of pointers indicating the
@@ -153,6 +153,14 @@ class ColPartitionGrid : public BBGrid<ColPartition,
   // FindPartitionMargins on each.
   void GridFindMargins(ColPartitionSet** best_columns);
 
+  // As GridFindMargins, but only for the ColPartitions that share a grid row
+  // with any of changed_boxes, which must include the old and new boxes of
+  // every partition that has been changed, added or removed since the margins
+  // were last computed. The margins of the rest can't have changed, as
+  // FindMargin only looks at partitions that overlap in y.
+  void GridFindMarginsNear(ColPartitionSet** best_columns,
+                           const GenericVector<TBOX>& changed_boxes);
+
   // Improves the margins of the ColPartitions in the list by calling
   // FindPartitionMargins on each.
   void ListFindMargins(ColPartitionSet** best_columns,
@@ -22,9 +22,12 @@
 #include "config_auto.h"
 #endif
 
+#include <algorithm>
 #include "allheaders.h"
+#include "bitvector.h"
 #include "debugpixa.h"
 #include "devanagari_processing.h"
+#include "helpers.h"
 #include "statistc.h"
 #include "tordmain.h"
 
@@ -122,16 +125,14 @@ bool ShiroRekhaSplitter::Split(bool split_for_pageseg, DebugPixa* pixa_debug) {
   boxaDestroy(&tmp_boxa);
   pixDestroy(&pix_for_ccs);
 
-  // Iterate over all connected components. Get their bounding boxes and clip
-  // out the image regions corresponding to these boxes from the original image.
-  // Conditionally run splitting on each of them.
+  // Iterate over all connected components. Get their bounding boxes and
+  // conditionally run splitting on the corresponding regions of the original
+  // image.
   Boxa* regions_to_clear = boxaCreate(0);
   int num_ccs = 0;
   if (ccs != nullptr) num_ccs = pixaGetCount(ccs);
   for (int i = 0; i < num_ccs; ++i) {
     Box* box = ccs->boxa->box[i];
-    Pix* word_pix = pixClipRectangle(orig_pix_, box, nullptr);
-    ASSERT_HOST(word_pix);
     int xheight = GetXheightForCC(box);
     if (xheight == kUnspecifiedXheight && segmentation_block_list_ &&
         devanagari_split_debugimage) {
@@ -143,13 +144,12 @@ bool ShiroRekhaSplitter::Split(bool split_for_pageseg, DebugPixa* pixa_debug) {
     // larger graphemes.
     if (xheight == kUnspecifiedXheight ||
         (box->w > xheight / 3 && box->h > xheight / 2)) {
-      SplitWordShiroRekha(split_strategy, word_pix, xheight,
-                          box->x, box->y, regions_to_clear);
+      SplitWordShiroRekha(split_strategy, orig_pix_, box, xheight,
+                          regions_to_clear);
     } else if (devanagari_split_debuglevel > 0) {
       tprintf("CC dropped from splitting: %d,%d (%d, %d)\n",
               box->x, box->y, box->w, box->h);
     }
-    pixDestroy(&word_pix);
   }
   // Actually clear the boxes now.
   for (int i = 0; i < boxaGetCount(regions_to_clear); ++i) {
@@ -217,12 +217,12 @@ int ShiroRekhaSplitter::GetXheightForCC(Box* cc_bbox) {
 }
 
 // Returns a list of regions (boxes) which should be cleared in the original
-// image so as to perform shiro-rekha splitting. Pix is assumed to carry one
-// (or less) word only. Xheight measure could be the global estimate, the row
-// estimate, or unspecified. If unspecified, over splitting may occur, since a
-// conservative estimate of stroke width along with an associated multiplier
-// is used in its place. It is advisable to have a specified xheight when
-// splitting for classification/training.
+// image so as to perform shiro-rekha splitting. The word_box region of pix is
+// assumed to carry one (or less) word only. Xheight measure could be the
+// global estimate, the row estimate, or unspecified. If unspecified, over
+// splitting may occur, since a conservative estimate of stroke width along
+// with an associated multiplier is used in its place. It is advisable to have
+// a specified xheight when splitting for classification/training.
 // A vertical projection histogram of all the on-pixels in the input pix is
 // computed. The maxima of this histogram is regarded as an approximate location
 // of the shiro-rekha. By descending on the maxima's peak on both sides,
@@ -234,18 +234,19 @@ int ShiroRekhaSplitter::GetXheightForCC(Box* cc_bbox) {
 // to over-splitting).
 void ShiroRekhaSplitter::SplitWordShiroRekha(SplitStrategy split_strategy,
                                              Pix* pix,
+                                             const Box* word_box,
                                              int xheight,
-                                             int word_left,
-                                             int word_top,
                                              Boxa* regions_to_clear) {
   if (split_strategy == NO_SPLIT) {
     return;
   }
-  int width = pixGetWidth(pix);
-  int height = pixGetHeight(pix);
+  int word_left = word_box->x;
+  int word_top = word_box->y;
+  int width = word_box->w;
+  int height = word_box->h;
   // Statistically determine the yextents of the shiro-rekha.
   int shirorekha_top, shirorekha_bottom, shirorekha_ylevel;
-  GetShiroRekhaYExtents(pix, &shirorekha_top, &shirorekha_bottom,
+  GetShiroRekhaYExtents(pix, word_box, &shirorekha_top, &shirorekha_bottom,
                         &shirorekha_ylevel);
   // Since the shiro rekha is also a stroke, its width is equal to the stroke
   // width.
@@ -271,13 +272,11 @@ void ShiroRekhaSplitter::SplitWordShiroRekha(SplitStrategy split_strategy,
     return;
   }
 
-  // Clear the ascender and descender regions of the word.
-  // Obtain a vertical projection histogram for the resulting image.
-  Box* box_to_clear = boxCreate(0, shirorekha_top - stroke_width / 3,
-                                width, 5 * stroke_width / 3);
-  Pix* word_in_xheight = pixCopy(nullptr, pix);
-  pixClearInRect(word_in_xheight, box_to_clear);
-  // Also clear any pixels which are below shirorekha_bottom + some leeway.
+  // Leave out the shiro-rekha itself and the descender region of the word.
+  // Obtain a vertical projection histogram for the remaining rows.
+  int rekha_clear_top = shirorekha_top - stroke_width / 3;
+  int rekha_clear_bottom = rekha_clear_top + 5 * stroke_width / 3;
+  // Also leave out any pixels which are below shirorekha_bottom + some leeway.
   // The leeway is set to xheight if the information is available, else it is a
   // multiplier applied to the stroke width.
   int leeway_to_keep = stroke_width * 3;
@@ -287,14 +286,17 @@ void ShiroRekhaSplitter::SplitWordShiroRekha(SplitStrategy split_strategy,
     // shiro-rekha.
     leeway_to_keep = xheight - stroke_width;
   }
-  box_to_clear->y = shirorekha_bottom + leeway_to_keep;
-  box_to_clear->h = height - box_to_clear->y;
-  pixClearInRect(word_in_xheight, box_to_clear);
-  boxDestroy(&box_to_clear);
+  int keep_bottom = shirorekha_bottom + leeway_to_keep;
 
   PixelHistogram vert_hist;
-  vert_hist.ConstructVerticalCountHist(word_in_xheight);
-  pixDestroy(&word_in_xheight);
+  int upper_rows_end = std::min(rekha_clear_top, keep_bottom);
+  vert_hist.Init(width);
+  vert_hist.AddVerticalCounts(
+      pix, word_left, word_top,
+      word_top + ClipToRange(upper_rows_end, 0, height));
+  vert_hist.AddVerticalCounts(
+      pix, word_left, word_top + ClipToRange(rekha_clear_bottom, 0, height),
+      word_top + ClipToRange(keep_bottom, 0, height));
 
   // If the number of black pixel in any column of the image is less than a
   // fraction of the stroke width, treat it as noise / a stray mark. Perform
@@ -422,15 +424,16 @@ int ShiroRekhaSplitter::GetModeHeight(Pix* pix) {
   return heights.mode();
 }
 
-// This method returns y-extents of the shiro-rekha computed from the input
-// word image.
-void ShiroRekhaSplitter::GetShiroRekhaYExtents(Pix* word_pix,
+// This method returns y-extents of the shiro-rekha computed from the word_box
+// region of the input image.
+void ShiroRekhaSplitter::GetShiroRekhaYExtents(Pix* pix,
+                                               const Box* word_box,
                                                int* shirorekha_top,
                                                int* shirorekha_bottom,
                                                int* shirorekha_ylevel) {
   // Compute a histogram from projecting the word on a vertical line.
   PixelHistogram hist_horiz;
-  hist_horiz.ConstructHorizontalCountHist(word_pix);
+  hist_horiz.ConstructHorizontalCountHist(pix, word_box);
   // Get the ylevel where the top-line exists. This is basically the global
   // maxima in the horizontal histogram.
   int topline_onpixel_count = 0;
@@ -442,7 +445,7 @@ void ShiroRekhaSplitter::GetShiroRekhaYExtents(Pix* word_pix,
   int llimit = topline_ylevel;
   while (ulimit > 0 && hist_horiz.hist()[ulimit] >= thresh)
     --ulimit;
-  while (llimit < pixGetHeight(word_pix) && hist_horiz.hist()[llimit] >= thresh)
+  while (llimit < hist_horiz.length() && hist_horiz.hist()[llimit] >= thresh)
     ++llimit;
 
   if (shirorekha_top) *shirorekha_top = ulimit;
@@ -465,36 +468,95 @@ int PixelHistogram::GetHistogramMaximum(int* count) const {
   return best_value;
 }
 
-// Methods to construct histograms from images.
-void PixelHistogram::ConstructVerticalCountHist(Pix* pix) {
-  Clear();
+// Returns the mask of the bits of a raster word that hold the pixels
+// [x_start, x_end) of the row, given the index of the word in the row.
+static l_uint32 RowWordMask(int word_index, int x_start, int x_end) {
+  l_uint32 mask = 0xffffffff;
+  int first_pixel = word_index * 32;
+  if (x_start > first_pixel) mask &= 0xffffffff >> (x_start - first_pixel);
+  if (x_end < first_pixel + 32) mask &= ~(0xffffffff >> (x_end - first_pixel));
+  return mask;
+}
+
+// Returns the region of pix covered by box, or the whole of pix if box is
+// nullptr, clipped to the image.
+static void GetHistogramRegion(Pix* pix, const Box* box, int* left, int* top,
+                               int* right, int* bottom) {
   int width = pixGetWidth(pix);
   int height = pixGetHeight(pix);
-  hist_ = new int[width];
-  length_ = width;
-  int wpl = pixGetWpl(pix);
-  l_uint32 *data = pixGetData(pix);
-  for (int i = 0; i < width; ++i)
+  if (box == nullptr) {
+    *left = *top = 0;
+    *right = width;
+    *bottom = height;
+  } else {
+    *left = ClipToRange(box->x, 0, width);
+    *top = ClipToRange(box->y, 0, height);
+    *right = ClipToRange(box->x + box->w, *left, width);
+    *bottom = ClipToRange(box->y + box->h, *top, height);
+  }
+}
+
+void PixelHistogram::Init(int length) {
+  Clear();
+  length_ = length;
+  hist_ = new int[length_];
+  for (int i = 0; i < length_; ++i)
     hist_[i] = 0;
-  for (int i = 0; i < height; ++i) {
-    l_uint32 *line = data + i * wpl;
-    for (int j = 0; j < width; ++j)
-      if (GET_DATA_BIT(line, j))
-        ++(hist_[j]);
+}
+
+// Methods to construct histograms from images. Both work on whole 32 bit
+// raster words, which lets them skip the mostly empty background quickly.
+void PixelHistogram::ConstructVerticalCountHist(Pix* pix, const Box* box) {
+  Clear();
+  int left, top, right, bottom;
+  GetHistogramRegion(pix, box, &left, &top, &right, &bottom);
+  Init(right - left);
+  AddVerticalCounts(pix, left, top, bottom);
+}
+
+void PixelHistogram::AddVerticalCounts(Pix* pix, int x_start, int y_start,
+                                       int y_end) {
+  int x_end = x_start + length_;
+  ASSERT_HOST(x_start >= 0 && x_end <= pixGetWidth(pix));
+  y_start = std::max(y_start, 0);
+  y_end = std::min(y_end, pixGetHeight(pix));
+  if (length_ <= 0) return;
+  int wpl = pixGetWpl(pix);
+  int first_word = x_start / 32;
+  int last_word = (x_end - 1) / 32;
+  const l_uint32* data = pixGetData(pix);
+  for (int y = y_start; y < y_end; ++y) {
+    const l_uint32* line = data + y * wpl;
+    for (int w = first_word; w <= last_word; ++w) {
+      l_uint32 word = line[w] & RowWordMask(w, x_start, x_end);
+      // The leftmost pixel is in the most significant bit.
+      for (int x = w * 32 - x_start; word != 0; ++x, word <<= 1) {
+        if (word & 0x80000000) ++hist_[x];
+      }
+    }
   }
 }
 
-void PixelHistogram::ConstructHorizontalCountHist(Pix* pix) {
+void PixelHistogram::ConstructHorizontalCountHist(Pix* pix, const Box* box) {
   Clear();
-  Numa* counts = pixCountPixelsByRow(pix, nullptr);
-  length_ = numaGetCount(counts);
+  int left, top, right, bottom;
+  GetHistogramRegion(pix, box, &left, &top, &right, &bottom);
+  length_ = bottom - top;
   hist_ = new int[length_];
+  int wpl = pixGetWpl(pix);
+  const l_uint32* data = pixGetData(pix);
+  int first_word = left / 32;
+  int last_word = (right - 1) / 32;
   for (int i = 0; i < length_; ++i) {
-    l_int32 val = 0;
-    numaGetIValue(counts, i, &val);
-    hist_[i] = val;
+    const l_uint32* line = data + (top + i) * wpl;
+    int count = 0;
+    for (int w = first_word; left < right && w <= last_word; ++w) {
+      l_uint32 word = line[w] & RowWordMask(w, left, right);
+      for (; word != 0; word >>= 8)
+        count += BitVector::hamming_table_[word & 0xff];
+    }
+    hist_[i] = count;
   }
-  numaDestroy(&counts);
 }
 
 }  // namespace tesseract.
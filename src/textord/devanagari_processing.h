@@ -55,9 +55,18 @@ class PixelHistogram {
     return length_;
   }
 
+  // Clears any existing data and sets the histogram to length zero counts.
+  void Init(int length);
+
   // Methods to construct histograms from images. These clear any existing data.
-  void ConstructVerticalCountHist(Pix* pix);
-  void ConstructHorizontalCountHist(Pix* pix);
+  // If box is given, only the pixels inside it are counted, so the region
+  // doesn't have to be clipped out of pix first.
+  void ConstructVerticalCountHist(Pix* pix, const Box* box = nullptr);
+  void ConstructHorizontalCountHist(Pix* pix, const Box* box = nullptr);
+
+  // Adds the per-column on-pixel counts of rows [y_start, y_end) of pix,
+  // starting at column x_start, to the current histogram.
+  void AddVerticalCounts(Pix* pix, int x_start, int y_start, int y_end);
 
   // This method returns the global-maxima for the histogram. The frequency of
   // the global maxima is returned in count, if specified.
@@ -167,26 +176,26 @@ class ShiroRekhaSplitter {
   int GetXheightForCC(Box* cc_bbox);
 
   // Returns a list of regions (boxes) which should be cleared in the original
-  // image so as to perform shiro-rekha splitting. Pix is assumed to carry one
-  // (or less) word only. Xheight measure could be the global estimate, the row
-  // estimate, or unspecified. If unspecified, over splitting may occur, since a
-  // conservative estimate of stroke width along with an associated multiplier
-  // is used in its place. It is advisable to have a specified xheight when
-  // splitting for classification/training.
+  // image so as to perform shiro-rekha splitting. The word_box region of pix
+  // is assumed to carry one (or less) word only. Xheight measure could be the
+  // global estimate, the row estimate, or unspecified. If unspecified, over
+  // splitting may occur, since a conservative estimate of stroke width along
+  // with an associated multiplier is used in its place. It is advisable to
+  // have a specified xheight when splitting for classification/training.
   void SplitWordShiroRekha(SplitStrategy split_strategy,
                            Pix* pix,
+                           const Box* word_box,
                            int xheight,
-                           int word_left,
-                           int word_top,
                            Boxa* regions_to_clear);
 
   // Returns a new box object for the corresponding TBOX, based on the original
   // image's coordinate system.
   Box* GetBoxForTBOX(const TBOX& tbox) const;
 
-  // This method returns y-extents of the shiro-rekha computed from the input
-  // word image.
-  static void GetShiroRekhaYExtents(Pix* word_pix,
+  // This method returns y-extents of the shiro-rekha computed from the
+  // word_box region of the input image. The extents are relative to the top
+  // of word_box.
+  static void GetShiroRekhaYExtents(Pix* pix, const Box* word_box,
                                     int* shirorekha_top,
                                     int* shirorekha_bottom,
                                     int* shirorekha_ylevel);
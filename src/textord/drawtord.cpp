@@ -23,6 +23,13 @@
 #include          "pithsync.h"
 #include          "topitch.h"
 #include          "drawtord.h"
+#include          "makerow.h"
+#include          "numthreads.h"
+#include          "tovars.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
 
 #define TO_WIN_XPOS     0       //default window pos
 #define TO_WIN_YPOS     0
@@ -34,6 +41,27 @@ BOOL_VAR (textord_show_fixed_cuts, false,
 
 ScrollView* to_win = nullptr;
 
+/**********************************************************************
+ * block_loop_threads
+ *
+ * Return the number of threads for an independent loop over the blocks.
+ **********************************************************************/
+int block_loop_threads(int num_threads) {
+#ifndef GRAPHICS_DISABLED
+  if (textord_show_initial_rows || textord_show_parallel_rows ||
+      textord_show_expanded_rows || textord_show_final_rows ||
+      textord_show_final_blobs || textord_show_initial_words ||
+      textord_show_fixed_cuts || textord_show_row_cuts ||
+      textord_show_page_cuts)
+    return 1;
+#endif
+#ifdef _OPENMP
+  return tesseract::NumThreads(omp_get_max_threads(), num_threads);
+#else
+  return 1;
+#endif
+}
+
 /**********************************************************************
  * create_to_win
  *
@@ -32,6 +32,11 @@ extern STRING_VAR_H (to_debugfile, DEBUG_WIN_NAME, "Name of debugfile");
 extern STRING_VAR_H (to_smdfile, NO_SMD, "Name of SMD file");
 extern ScrollView* to_win;
 extern FILE *to_debug;
+// Returns the number of threads to use for a loop over the blocks of a page
+// that processes each block independently, given the requested number of
+// threads (see NumThreads). The debug displays all draw in to_win, so they
+// need a single thread.
+int block_loop_threads(int num_threads);
 // Creates a static display window for textord, and returns a pointer to it.
 ScrollView* create_to_win(ICOORD page_tr);
 void close_to_win();  // Destroy the textord window.
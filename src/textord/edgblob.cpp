@@ -26,35 +26,6 @@
 #include "config_auto.h"
 #endif
 
-// Control parameters used in outline_complexity(), which rejects an outline
-// if any one of the 3 conditions is satisfied:
-//  - number of children exceeds edges_max_children_per_outline
-//  - number of nested layers exceeds edges_max_children_layers
-//  - joint complexity exceeds edges_children_count_limit(as in child_count())
-static BOOL_VAR(edges_use_new_outline_complexity, false,
-                "Use the new outline complexity module");
-static INT_VAR(edges_max_children_per_outline, 10,
-               "Max number of children inside a character outline");
-static INT_VAR(edges_max_children_layers, 5,
-               "Max layers of nested children inside a character outline");
-static BOOL_VAR(edges_debug, false,
-                "turn on debugging for this module");
-
-static INT_VAR(edges_children_per_grandchild, 10,
-               "Importance ratio for chucking outlines");
-static INT_VAR(edges_children_count_limit, 45,
-               "Max holes allowed in blob");
-static BOOL_VAR(edges_children_fix, false,
-                "Remove boxy parents of char-like children");
-static INT_VAR(edges_min_nonhole, 12,
-               "Min pixels for potential char in box");
-static INT_VAR(edges_patharea_ratio, 40,
-               "Max lensq/area for acceptable child outline");
-static double_VAR(edges_childarea, 0.5,
-                  "Min area fraction of child outline");
-static double_VAR(edges_boxarea, 0.875,
-                  "Min area fraction of grandchild for box");
-
 /**
  * @name OL_BUCKETS::OL_BUCKETS
  *
@@ -63,7 +34,8 @@ static double_VAR(edges_boxarea, 0.875,
 
 OL_BUCKETS::OL_BUCKETS(
 ICOORD bleft,                    // corners
-ICOORD tright):         bl(bleft), tr(tright) {
+ICOORD tright,
+const EdgeParams& params):  params_(params), bl(bleft), tr(tright) {
   bxdim =(tright.x() - bleft.x()) / BUCKETSIZE + 1;
   bydim =(tright.y() - bleft.y()) / BUCKETSIZE + 1;
                                  // make array
@@ -127,7 +99,7 @@ int32_t OL_BUCKETS::outline_complexity(
   ymax =(olbox.top() - bl.y()) / BUCKETSIZE;
   child_count = 0;
   grandchild_count = 0;
-  if (++depth > edges_max_children_layers)  // nested loops are too deep
+  if (++depth > params_.max_children_layers)  // nested loops are too deep
     return max_count + depth;
 
   for (yindex = ymin; yindex <= ymax; yindex++) {
@@ -142,22 +114,22 @@ int32_t OL_BUCKETS::outline_complexity(
           continue;
         child_count++;
 
-        if (child_count > edges_max_children_per_outline) {   // too fragmented
-          if (edges_debug)
+        if (child_count > params_.max_children_per_outline) {  // too fragmented
+          if (params_.debug)
             tprintf("Discard outline on child_count=%d > "
                     "max_children_per_outline=%d\n",
                     child_count,
-                    static_cast<int32_t>(edges_max_children_per_outline));
+                    static_cast<int32_t>(params_.max_children_per_outline));
           return max_count + child_count;
         }
 
         // Compute the "complexity" of each child recursively
         int32_t remaining_count = max_count - child_count - grandchild_count;
         if (remaining_count > 0)
-          grandchild_count += edges_children_per_grandchild *
+          grandchild_count += params_.children_per_grandchild *
                               outline_complexity(child, remaining_count, depth);
         if (child_count + grandchild_count > max_count) {  // too complex
-          if (edges_debug)
+          if (params_.debug)
             tprintf("Disgard outline on child_count=%d + grandchild_count=%d "
                     "> max_count=%d\n",
                     child_count, grandchild_count, max_count);
@@ -216,15 +188,15 @@ int32_t OL_BUCKETS::count_children(                   // recursive count
           child_count++;
           if (child_count <= max_count) {
             int max_grand =(max_count - child_count) /
-                            edges_children_per_grandchild;
+                            params_.children_per_grandchild;
             if (max_grand > 0)
               grandchild_count += count_children(child, max_grand) *
-                                  edges_children_per_grandchild;
+                                  params_.children_per_grandchild;
             else
               grandchild_count += count_children(child, 1);
           }
           if (child_count + grandchild_count > max_count) {
-            if (edges_debug)
+            if (params_.debug)
               tprintf("Discarding parent with child count=%d, gc=%d\n",
                       child_count,grandchild_count);
             return child_count + grandchild_count;
@@ -233,23 +205,23 @@ int32_t OL_BUCKETS::count_children(                   // recursive count
             parent_area = outline->outer_area();
             if (parent_area < 0)
               parent_area = -parent_area;
-            max_parent_area = outline->bounding_box().area() * edges_boxarea;
+            max_parent_area = outline->bounding_box().area() * params_.boxarea;
             if (parent_area < max_parent_area)
               parent_box = false;
           }
           if (parent_box &&
-              (!edges_children_fix ||
-               child->bounding_box().height() > edges_min_nonhole)) {
+              (!params_.children_fix ||
+               child->bounding_box().height() > params_.min_nonhole)) {
             child_area = child->outer_area();
             if (child_area < 0)
               child_area = -child_area;
-            if (edges_children_fix) {
+            if (params_.children_fix) {
               if (parent_area - child_area < max_parent_area) {
                 parent_box = false;
                 continue;
               }
               if (grandchild_count > 0) {
-                if (edges_debug)
+                if (params_.debug)
                   tprintf("Discarding parent of area %d, child area=%d, max%g "
                           "with gc=%d\n",
                           parent_area, child_area, max_parent_area,
@@ -258,8 +230,8 @@ int32_t OL_BUCKETS::count_children(                   // recursive count
               }
               child_length = child->pathlength();
               if (child_length * child_length >
-                  child_area * edges_patharea_ratio) {
-                if (edges_debug)
+                  child_area * params_.patharea_ratio) {
+                if (params_.debug)
                   tprintf("Discarding parent of area %d, child area=%d, max%g "
                           "with child length=%d\n",
                           parent_area, child_area, max_parent_area,
@@ -267,8 +239,8 @@ int32_t OL_BUCKETS::count_children(                   // recursive count
                 return max_count + 1;
               }
             }
-            if (child_area < child->bounding_box().area() * edges_childarea) {
-              if (edges_debug)
+            if (child_area < child->bounding_box().area() * params_.childarea) {
+              if (params_.debug)
                 tprintf("Discarding parent of area %d, child area=%d, max%g "
                         "with child rect=%d\n",
                         parent_area, child_area, max_parent_area,
@@ -328,7 +300,8 @@ void OL_BUCKETS::extract_children(                     // recursive count
  */
 
 void extract_edges(Pix* pix,  // thresholded image
-                   BLOCK *block) {  // block to scan
+                   BLOCK *block,  // block to scan
+                   const EdgeParams& params) {
   C_OUTLINE_LIST outlines;       // outlines in block
   C_OUTLINE_IT out_it = &outlines;
 
@@ -337,7 +310,7 @@ void extract_edges(Pix* pix,  // thresholded image
   ICOORD tright;
   block->pdblk.bounding_box(bleft, tright);
                                  // make blobs
-  outlines_to_blobs(block, bleft, tright, &outlines);
+  outlines_to_blobs(block, bleft, tright, &outlines, params);
 }
 
 
@@ -351,9 +324,10 @@ void outlines_to_blobs(               // find blobs
                        BLOCK *block,  // block to scan
                        ICOORD bleft,
                        ICOORD tright,
-                       C_OUTLINE_LIST *outlines) {
+                       C_OUTLINE_LIST *outlines,
+                       const EdgeParams& params) {
                                  // make buckets
-  OL_BUCKETS buckets(bleft, tright);
+  OL_BUCKETS buckets(bleft, tright, params);
 
   fill_buckets(outlines, &buckets);
   empty_buckets(block, &buckets);
@@ -441,15 +415,16 @@ bool capture_children(                       // find children
   C_OUTLINE *outline;            // master outline
   int32_t child_count;             // no of children
 
+  const EdgeParams& params = buckets->params();
   outline = blob_it->data();
-  if (edges_use_new_outline_complexity)
+  if (params.use_new_outline_complexity)
     child_count = buckets->outline_complexity(outline,
-                                               edges_children_count_limit,
+                                               params.children_count_limit,
                                                0);
   else
     child_count = buckets->count_children(outline,
-                                           edges_children_count_limit);
-  if (child_count > edges_children_count_limit)
+                                           params.children_count_limit);
+  if (child_count > params.children_count_limit)
     return false;
 
   if (child_count > 0)
@@ -29,12 +29,35 @@
 
 #define BUCKETSIZE      16
 
+// Control parameters used in outline_complexity() and count_children(), taken
+// from the edges_* member params of Textord, so that engines with different
+// settings can extract edges concurrently. outline_complexity() rejects an
+// outline if any one of the 3 conditions is satisfied:
+//  - number of children exceeds max_children_per_outline
+//  - number of nested layers exceeds max_children_layers
+//  - joint complexity exceeds children_count_limit(as in child_count())
+// The defaults are those of the params.
+struct EdgeParams {
+  bool use_new_outline_complexity = false;
+  int max_children_per_outline = 10;
+  int max_children_layers = 5;
+  bool debug = false;
+  int children_per_grandchild = 10;
+  int children_count_limit = 45;
+  bool children_fix = false;
+  int min_nonhole = 12;
+  int patharea_ratio = 40;
+  double childarea = 0.5;
+  double boxarea = 0.875;
+};
+
 class OL_BUCKETS
 {
   public:
     OL_BUCKETS(               //constructor
                ICOORD bleft,  //corners
-               ICOORD tright);
+               ICOORD tright,
+               const EdgeParams& params);
 
     ~OL_BUCKETS () = default;
 
@@ -62,8 +85,12 @@ class OL_BUCKETS
     void extract_children(                     //single level get
                           C_OUTLINE *outline,  //parent outline
                           C_OUTLINE_IT *it);   //destination iterator
+    const EdgeParams& params() const {
+      return params_;
+    }
 
   private:
+    const EdgeParams& params_;   //complexity limits
     std::unique_ptr<C_OUTLINE_LIST[]> buckets;    //array of buckets
     int16_t bxdim;                 //size of array
     int16_t bydim;
@@ -73,12 +100,14 @@ class OL_BUCKETS
 };
 
 void extract_edges(Pix* pix,        // thresholded image
-                   BLOCK* block);   // block to scan
+                   BLOCK* block,    // block to scan
+                   const EdgeParams& params = EdgeParams());
 void outlines_to_blobs(               //find blobs
                        BLOCK *block,  //block to scan
                        ICOORD bleft,  //block box //outlines in block
                        ICOORD tright,
-                       C_OUTLINE_LIST *outlines);
+                       C_OUTLINE_LIST *outlines,
+                       const EdgeParams& params = EdgeParams());
 void fill_buckets(                           //find blobs
                   C_OUTLINE_LIST *outlines,  //outlines in block
                   OL_BUCKETS *buckets        //output buckets
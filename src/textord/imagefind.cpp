@@ -23,6 +23,7 @@
 
 #include "imagefind.h"
 #include "colpartitiongrid.h"
+#include "imagepyramid.h"
 #include "linlsq.h"
 #include "statistc.h"
 #include "params.h"
@@ -32,6 +33,9 @@
 #include <algorithm>
 
 static INT_VAR(textord_tabfind_show_images, false, "Show image blobs");
+static INT_VAR(textord_imagefind_reduction, 2,
+               "Factor (2 or 4) by which to reduce the image to find "
+               "halftone image regions");
 
 namespace tesseract {
 
@@ -59,14 +63,22 @@ const int kNoisePadding = 4;
 // The returned pix may be nullptr, meaning no images found.
 // If not nullptr, it must be PixDestroyed by the caller.
 // If textord_tabfind_show_images, debug images are appended to pixa_debug.
-Pix* ImageFind::FindImages(Pix* pix, DebugPixa* pixa_debug) {
+// If pyramid is not nullptr, the reduced image is taken from it.
+Pix* ImageFind::FindImages(Pix* pix, DebugPixa* pixa_debug,
+                           ImagePyramid* pyramid) {
   // Not worth looking at small images.
   if (pixGetWidth(pix) < kMinImageFindSize ||
       pixGetHeight(pix) < kMinImageFindSize)
     return pixCreate(pixGetWidth(pix), pixGetHeight(pix), 1);
 
-  // Reduce by factor 2.
-  Pix *pixr = pixReduceRankBinaryCascade(pix, 1, 0, 0, 0);
+  // Reduce by factor 2, or by 4 if requested, which is much faster on large
+  // pages. The expanded mask is refined at full resolution by the seed fill
+  // into the source image below.
+  int reduction = textord_imagefind_reduction >= 4 ? 4 : 2;
+  Pix *pixr = pyramid != nullptr
+                  ? pyramid->GetReduction(pix, reduction)
+                  : pixReduceRankBinaryCascade(pix, 1, reduction > 2 ? 1 : 0,
+                                               0, 0);
   if (textord_tabfind_show_images && pixa_debug != nullptr)
     pixa_debug->AddPix(pixr, "CascadeReduced");
 
@@ -100,7 +112,7 @@ Pix* ImageFind::FindImages(Pix* pix, DebugPixa* pixa_debug) {
     return pixCreate(pixGetWidth(pix), pixGetHeight(pix), 1);
 
   // Expand back up again.
-  Pix *pixht = pixExpandReplicate(pixht2, 2);
+  Pix *pixht = pixExpandReplicate(pixht2, reduction);
   if (textord_tabfind_show_images && pixa_debug != nullptr)
     pixa_debug->AddPix(pixht, "HalftoneReplicated");
   pixDestroy(&pixht2);
@@ -36,6 +36,7 @@ namespace tesseract {
 
 class ColPartitionGrid;
 class ColPartition_LIST;
+class ImagePyramid;
 class TabFind;
 
 // The ImageFind class is a simple static function wrapper class that
@@ -47,7 +48,9 @@ class ImageFind {
   // The returned pix may be nullptr, meaning no images found.
   // If not nullptr, it must be PixDestroyed by the caller.
   // If textord_tabfind_show_images, debug images are appended to pixa_debug.
-  static Pix* FindImages(Pix* pix, DebugPixa* pixa_debug);
+  // If pyramid is not nullptr, the reduced image is taken from it.
+  static Pix* FindImages(Pix* pix, DebugPixa* pixa_debug,
+                         ImagePyramid* pyramid = nullptr);
 
   // Generates a Boxa, Pixa pair from the input binary (image mask) pix,
   // analgous to pixConnComp, except that connected components which are nearly
@@ -32,11 +32,18 @@
 #endif
 
 #include "allheaders.h"
+#include "imagepyramid.h"  // for ImagePyramid
+#include "numthreads.h"  // for NumThreads
+#include "params.h"
 
 #include <algorithm>
 
 namespace tesseract {
 
+static INT_VAR(textord_linefind_reduction, 1,
+               "Factor (1, 2 or 4) by which to reduce the image to find "
+               "candidate rule lines faster on high resolution pages");
+
 /// Denominator of resolution makes max pixel width to allow thin lines.
 const int kThinLineFraction = 20;
 /// Denominator of resolution makes min pixels to demand line lengths to be.
@@ -60,6 +67,36 @@ const double kMaxNonLineDensity = 0.25;
 const double kMaxStaveHeight = 1.0;
 // Minimum fraction of pixels in a music rectangle connected to the staves.
 const double kMinMusicPixelFraction = 0.75;
+// Min resolution of the reduced image when finding lines on a reduced copy.
+const int kMinLineFindReducedResolution = 150;
+
+// Returns the factor (1, 2 or 4) by which to reduce an image of the given
+// resolution to find the candidate lines: textord_linefind_reduction, but
+// limited so the reduced image keeps kMinLineFindReducedResolution.
+static int LineFindReduction(int resolution) {
+  int reduction = textord_linefind_reduction >= 4
+                      ? 4 : textord_linefind_reduction >= 2 ? 2 : 1;
+  while (reduction > 1 &&
+         resolution / reduction < kMinLineFindReducedResolution)
+    reduction /= 2;
+  return reduction;
+}
+
+// Returns the given reduced pix expanded back to the size of full_pix.
+// If mask is true, the result is anded with full_pix, so it contains exactly
+// the pixels of full_pix that are under the reduced pix.
+// The reduced pix is destroyed.
+static Pix* ExpandToFullSize(int reduction, Pix* full_pix, bool mask,
+                             Pix** reduced_pix) {
+  Pix* pix_expanded = pixExpandReplicate(*reduced_pix, reduction);
+  pixDestroy(reduced_pix);
+  Pix* result = pixCreate(pixGetWidth(full_pix), pixGetHeight(full_pix), 1);
+  pixOr(result, result, pix_expanded);
+  pixDestroy(&pix_expanded);
+  if (mask)
+    pixAnd(result, result, full_pix);
+  return result;
+}
 
 // Erases the unused blobs from the line_pix image, taking into account
 // whether this was a horizontal or vertical line set.
@@ -239,12 +276,14 @@ static int FilterFalsePositives(int resolution, Pix* nonline_pix,
 // appear in v_lines or h_lines.
 // The output vectors are owned by the list and Frozen (cannot refit) by
 // having no boxes, as there is no need to refit or merge separator lines.
-// The detected lines are removed from the pix.
+// The detected lines are removed from the pix, so the pyramid, if any, is
+// invalidated.
 void LineFinder::FindAndRemoveLines(int resolution, bool debug, Pix* pix,
                                     int* vertical_x, int* vertical_y,
                                     Pix** pix_music_mask,
                                     TabVector_LIST* v_lines,
-                                    TabVector_LIST* h_lines) {
+                                    TabVector_LIST* h_lines,
+                                    int num_threads, ImagePyramid* pyramid) {
   if (pix == nullptr || vertical_x == nullptr || vertical_y == nullptr) {
     tprintf("Error in parameters for LineFinder::FindAndRemoveLines\n");
     return;
@@ -257,7 +296,7 @@ void LineFinder::FindAndRemoveLines(int resolution, bool debug, Pix* pix,
   Pixa* pixa_display = debug ? pixaCreate(0) : nullptr;
   GetLineMasks(resolution, pix, &pix_vline, &pix_non_vline, &pix_hline,
                &pix_non_hline, &pix_intersections, pix_music_mask,
-               pixa_display);
+               pixa_display, num_threads, pyramid);
   // Find lines, convert to TabVector_LIST and remove those that are used.
   FindAndRemoveVLines(resolution, pix_intersections, vertical_x, vertical_y,
                       &pix_vline, pix_non_vline, pix, v_lines);
@@ -298,6 +337,7 @@ void LineFinder::FindAndRemoveLines(int resolution, bool debug, Pix* pix,
   }
   if (pixa_display != nullptr)
     pixaAddPix(pixa_display, pix, L_CLONE);
+  if (pyramid != nullptr) pyramid->Invalidate();
 
   pixDestroy(&pix_vline);
   pixDestroy(&pix_non_vline);
@@ -571,7 +611,11 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
                               Pix** pix_vline, Pix** pix_non_vline,
                               Pix** pix_hline, Pix** pix_non_hline,
                               Pix** pix_intersections, Pix** pix_music_mask,
-                              Pixa* pixa_display) {
+                              Pixa* pixa_display, int num_threads,
+                              ImagePyramid* pyramid) {
+  // The vertical and horizontal morphology is independent, so it can use
+  // 2 threads. Leptonica is reentrant for operations on different images.
+  num_threads = NumThreads(2, num_threads);
   Pix* pix_closed = nullptr;
   Pix* pix_hollow = nullptr;
 
@@ -582,6 +626,30 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
             resolution, max_line_width, min_line_length);
   }
   int closing_brick = max_line_width / 3;
+  // The brick operations at full resolution dominate the cost of line finding
+  // on big pages, so they may be done on a reduced copy of the image. The
+  // reduction is rank 1, so every pixel of a line is under a pixel of the
+  // reduced line mask, and anding the expanded masks with the source refines
+  // them back to exactly the full resolution pixels of the candidate lines.
+  int reduction = LineFindReduction(resolution);
+#ifdef USE_OPENCL
+  if (OpenclDevice::selectedDeviceIsOpenCL()) reduction = 1;
+#endif
+  Pix* pix_reduced = nullptr;
+  if (reduction > 1) {
+    pix_reduced = pyramid != nullptr
+                      ? pyramid->GetReduction(src_pix, reduction)
+                      : pixReduceRankBinaryCascade(
+                            src_pix, 1, reduction > 2 ? 1 : 0, 0, 0);
+    max_line_width /= reduction;
+    min_line_length /= reduction;
+    closing_brick = max_line_width / 3;
+    if (pixa_display != nullptr) {
+      tprintf("Finding lines at 1/%d resolution, max line width = %d,"
+              " min length=%d\n", reduction, max_line_width, min_line_length);
+    }
+  }
+  Pix* pix_find = reduction > 1 ? pix_reduced : src_pix;
 
 // only use opencl if compiled w/ OpenCL and selected device is opencl
 #ifdef USE_OPENCL
@@ -600,7 +668,7 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   // Close up small holes, making it less likely that false alarms are found
   // in thickened text (as it will become more solid) and also smoothing over
   // some line breaks and nicks in the edges of the lines.
-  pix_closed = pixCloseBrick(nullptr, src_pix, closing_brick, closing_brick);
+  pix_closed = pixCloseBrick(nullptr, pix_find, closing_brick, closing_brick);
   if (pixa_display != nullptr)
     pixaAddPix(pixa_display, pix_closed, L_CLONE);
   // Open up with a big box to detect solid areas, which can then be subtracted.
@@ -617,10 +685,28 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   // 1 inch/kMinLineLengthFraction in length.
   if (pixa_display != nullptr)
     pixaAddPix(pixa_display, pix_hollow, L_CLONE);
-  *pix_vline = pixOpenBrick(nullptr, pix_hollow, 1, min_line_length);
-  *pix_hline = pixOpenBrick(nullptr, pix_hollow, min_line_length, 1);
+#ifdef _OPENMP
+#pragma omp parallel sections num_threads(num_threads) if (num_threads > 1)
+#endif  // _OPENMP
+  {
+#ifdef _OPENMP
+#pragma omp section
+#endif  // _OPENMP
+    *pix_vline = pixOpenBrick(nullptr, pix_hollow, 1, min_line_length);
+#ifdef _OPENMP
+#pragma omp section
+#endif  // _OPENMP
+    *pix_hline = pixOpenBrick(nullptr, pix_hollow, min_line_length, 1);
+  }
 
   pixDestroy(&pix_hollow);
+  if (reduction > 1) {
+    pixDestroy(&pix_reduced);
+    *pix_vline = ExpandToFullSize(reduction, src_pix, true, pix_vline);
+    *pix_hline = ExpandToFullSize(reduction, src_pix, true, pix_hline);
+    if (pix_music_mask != nullptr)
+      pix_closed = ExpandToFullSize(reduction, src_pix, false, &pix_closed);
+  }
 #ifdef USE_OPENCL
   }
 #endif
@@ -643,6 +729,8 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   Pix* pix_nonlines = nullptr;
   *pix_intersections = nullptr;
   Pix* extra_non_hlines = nullptr;
+  *pix_non_vline = nullptr;
+  *pix_non_hline = nullptr;
   if (!v_empty) {
     // Subtract both line candidates from the source to get definite non-lines.
     pix_nonlines = pixSubtract(nullptr, src_pix, *pix_vline);
@@ -654,8 +742,31 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
       // and vice versa.
       extra_non_hlines = pixSubtract(nullptr, *pix_vline, *pix_intersections);
     }
-    *pix_non_vline = pixErodeBrick(nullptr, pix_nonlines, kMaxLineResidue, 1);
-    pixSeedfillBinary(*pix_non_vline, *pix_non_vline, pix_nonlines, 8);
+  } else if (!h_empty) {
+    pix_nonlines = pixSubtract(nullptr, src_pix, *pix_hline);
+  }
+  // The non-lines of each direction are the non-line pixels that survive a
+  // thin opening across that direction, plus their connected residue.
+#ifdef _OPENMP
+#pragma omp parallel sections num_threads(num_threads) if (num_threads > 1)
+#endif  // _OPENMP
+  {
+#ifdef _OPENMP
+#pragma omp section
+#endif  // _OPENMP
+    if (!v_empty) {
+      *pix_non_vline = pixErodeBrick(nullptr, pix_nonlines, kMaxLineResidue, 1);
+      pixSeedfillBinary(*pix_non_vline, *pix_non_vline, pix_nonlines, 8);
+    }
+#ifdef _OPENMP
+#pragma omp section
+#endif  // _OPENMP
+    if (!h_empty) {
+      *pix_non_hline = pixErodeBrick(nullptr, pix_nonlines, 1, kMaxLineResidue);
+      pixSeedfillBinary(*pix_non_hline, *pix_non_hline, pix_nonlines, 8);
+    }
+  }
+  if (!v_empty) {
     if (!h_empty) {
       // Candidate hlines are not vlines.
       pixOr(*pix_non_vline, *pix_non_vline, *pix_hline);
@@ -667,20 +778,13 @@ void LineFinder::GetLineMasks(int resolution, Pix* src_pix,
   } else {
     // No vertical lines.
     pixDestroy(pix_vline);
-    *pix_non_vline = nullptr;
-    if (!h_empty) {
-      pix_nonlines = pixSubtract(nullptr, src_pix, *pix_hline);
-    }
   }
   if (h_empty) {
     pixDestroy(pix_hline);
-    *pix_non_hline = nullptr;
     if (v_empty) {
       return;
     }
   } else {
-    *pix_non_hline = pixErodeBrick(nullptr, pix_nonlines, 1, kMaxLineResidue);
-    pixSeedfillBinary(*pix_non_hline, *pix_non_hline, pix_nonlines, 8);
     if (extra_non_hlines != nullptr) {
       pixOr(*pix_non_hline, *pix_non_hline, extra_non_hlines);
       pixDestroy(&extra_non_hlines);
@@ -30,6 +30,7 @@ class ICOORD;
 
 namespace tesseract {
 
+class ImagePyramid;
 class TabVector_LIST;
 
 /**
@@ -57,12 +58,20 @@ class LineFinder {
    * having no boxes, as there is no need to refit or merge separator lines.
    *
    * The detected lines are removed from the pix.
+   *
+   * The vertical and horizontal line masks are computed concurrently if
+   * num_threads allows it. See NumThreads.
+   *
+   * If pyramid is not nullptr, the reduced image to search is taken from it,
+   * and it is invalidated after the lines are removed from pix.
    */
   static void FindAndRemoveLines(int resolution,  bool debug, Pix* pix,
                                  int* vertical_x, int* vertical_y,
                                  Pix** pix_music_mask,
                                  TabVector_LIST* v_lines,
-                                 TabVector_LIST* h_lines);
+                                 TabVector_LIST* h_lines,
+                                 int num_threads = 0,
+                                 ImagePyramid* pyramid = nullptr);
 
   /**
    * Converts the Boxa array to a list of C_BLOB, getting rid of severely
@@ -129,11 +138,14 @@ class LineFinder {
   // but any of the returns that are empty will be nullptr on output.
   // None of the input (1st level) pointers may be nullptr except pix_music_mask,
   // which will disable music detection, and pixa_display, which is for debug.
+  // The independent vertical and horizontal operations run on up to 2 threads.
+  // The reduced image, if any, comes from pyramid unless it is nullptr.
   static void GetLineMasks(int resolution, Pix* src_pix,
                            Pix** pix_vline, Pix** pix_non_vline,
                            Pix** pix_hline, Pix** pix_non_hline,
                            Pix** pix_intersections, Pix** pix_music_mask,
-                           Pixa* pixa_display);
+                           Pixa* pixa_display, int num_threads,
+                           ImagePyramid* pyramid);
 
   // Returns a list of boxes corresponding to the candidate line segments. Sets
   // the line_crossings member of the boxes so we can later determine the number
@@ -197,22 +197,34 @@ float make_single_row(ICOORD page_tr, bool allow_sub_blobs,
  *
  * Arrange the blobs into rows.
  */
-float make_rows(ICOORD page_tr, TO_BLOCK_LIST *port_blocks) {
+float make_rows(ICOORD page_tr, TO_BLOCK_LIST *port_blocks,
+                int num_threads) {
   float port_m;                  // global skew
   float port_err;                // global noise
   TO_BLOCK_IT block_it;          // iterator
+  std::vector<TO_BLOCK*> blocks;
 
   block_it.set_to_list(port_blocks);
   for (block_it.mark_cycle_pt(); !block_it.cycled_list();
        block_it.forward())
-  make_initial_textrows(page_tr, block_it.data(), FCOORD(1.0f, 0.0f),
-      !textord_test_landscape);
+    blocks.push_back(block_it.data());
+  const int num_blocks = blocks.size();
+  // The rows of each block are made independently, apart from the page skew.
+  num_threads = block_loop_threads(num_threads);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blocks; ++b)
+    make_initial_textrows(page_tr, blocks[b], FCOORD(1.0f, 0.0f),
+        !textord_test_landscape);
                                  // compute globally
   compute_page_skew(port_blocks, port_m, port_err);
-  block_it.set_to_list(port_blocks);
-  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
-    cleanup_rows_making(page_tr, block_it.data(), port_m, FCOORD(1.0f, 0.0f),
-                 block_it.data()->block->pdblk.bounding_box().left(),
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blocks; ++b) {
+    cleanup_rows_making(page_tr, blocks[b], port_m, FCOORD(1.0f, 0.0f),
+                 blocks[b]->block->pdblk.bounding_box().left(),
                  !textord_test_landscape);
   }
   return port_m;                 // global skew
@@ -2300,6 +2312,7 @@ void assign_blobs_to_rows(                      //find lines
                                  //iterators
   BLOBNBOX_IT blob_it = &block->blobs;
   TO_ROW_IT row_it = block->get_rows ();
+  std::vector<BLOBNBOX*> blobs;  //frozen in x order
 
   ycoord =
     (block->block->pdblk.bounding_box ().bottom () +
@@ -2311,19 +2324,22 @@ void assign_blobs_to_rows(                      //find lines
     to_win->SetCursor(block->block->pdblk.bounding_box ().left (), ycoord);
 #endif
   testpt = ICOORD (textord_test_x, textord_test_y);
-  blob_it.sort (blob_x_order);
+  // Every blob leaves the list for a row, so take them all out up front
+  // and put back only the rejects, which then stay in x order.
+  freeze_blobs_in_x(&block->blobs, true, &blobs);
+  blob_it.set_to_list (&block->blobs);
   smooth_factor = 1.0;
   block_skew = 0.0f;
   row_count = row_it.length ();  //might have rows
-  if (!blob_it.empty ()) {
-    left_x = blob_it.data ()->bounding_box ().left ();
+  if (!blobs.empty ()) {
+    left_x = blobs[0]->bounding_box ().left ();
   }
   else {
     left_x = block->block->pdblk.bounding_box ().left ();
   }
   last_x = left_x;
-  for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
-    blob = blob_it.data ();
+  for (BLOBNBOX* frozen_blob : blobs) {
+    blob = frozen_blob;
     if (gradient != nullptr) {
       block_skew = (1 - 1 / g_length) * blob->bounding_box ().bottom ()
         + *gradient / g_length * blob->bounding_box ().left ();
@@ -2397,12 +2413,12 @@ void assign_blobs_to_rows(                      //find lines
         }
       }
       if (overlap_result == ASSIGN)
-        dest_row->add_blob (blob_it.extract (), top, bottom,
+        dest_row->add_blob (blob, top, bottom,
           block->line_size);
       if (overlap_result == NEW_ROW) {
         if (make_new_rows && top - bottom < block->max_blob_size) {
           dest_row =
-            new TO_ROW (blob_it.extract (), top, bottom,
+            new TO_ROW (blob, top, bottom,
             block->line_size);
           row_count++;
           if (bottom > row_it.data ()->min_y ())
@@ -2421,7 +2437,7 @@ void assign_blobs_to_rows(                      //find lines
     else if (make_new_rows && top - bottom < block->max_blob_size) {
       overlap_result = NEW_ROW;
       dest_row =
-        new TO_ROW(blob_it.extract(), top, bottom, block->line_size);
+        new TO_ROW(blob, top, bottom, block->line_size);
       row_count++;
       row_it.add_after_then_move(dest_row);
       smooth_factor = 1.0 / (row_count * textord_skew_lag +
@@ -2429,6 +2445,8 @@ void assign_blobs_to_rows(                      //find lines
     }
     else
       overlap_result = REJECT;
+    if (overlap_result == REJECT)
+      blob_it.add_after_then_move (blob);  //back on the block
     if (blob->bounding_box ().contains(testpt) && textord_debug_blob) {
       if (overlap_result != REJECT) {
         tprintf("Test blob assigned to row at (%g,%g) on pass %d\n",
@@ -2587,6 +2605,25 @@ int blob_x_order(                    //sort function
 }
 
 
+/**
+ * @name freeze_blobs_in_x
+ *
+ * Copy the blobs of the list to a contiguous array sorted in x.
+ */
+void freeze_blobs_in_x(BLOBNBOX_LIST *blobs, bool extract,
+                       std::vector<BLOBNBOX*>* frozen) {
+  BLOBNBOX_IT blob_it(blobs);
+  frozen->clear();
+  frozen->reserve(blobs->length());
+  for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward())
+    frozen->push_back(extract ? blob_it.extract() : blob_it.data());
+  std::stable_sort(frozen->begin(), frozen->end(),
+                   [](const BLOBNBOX* blob1, const BLOBNBOX* blob2) {
+    return blob1->bounding_box().left() < blob2->bounding_box().left();
+  });
+}
+
+
 /**
  * @name row_y_order
  *
@@ -24,6 +24,7 @@
 #include          "blobs.h"
 #include          "blobbox.h"
 #include          "statistc.h"
+#include          <vector>
 
 enum OVERLAP_STATE
 {
@@ -135,7 +136,8 @@ void fill_heights(TO_ROW *row, float gradient, int min_height,
 float make_single_row(ICOORD page_tr, bool allow_sub_blobs, TO_BLOCK* block,
                       TO_BLOCK_LIST* blocks);
 float make_rows(ICOORD page_tr,              // top right
-                TO_BLOCK_LIST *port_blocks);
+                TO_BLOCK_LIST *port_blocks,  // blocks to do
+                int num_threads = 0);        // 0 = default
 void make_initial_textrows(ICOORD page_tr,
                            TO_BLOCK* block,  // block to do
                            FCOORD rotation,  // for drawing
@@ -275,6 +277,13 @@ OVERLAP_STATE most_overlapping_row(TO_ROW_IT* row_it,  //iterator
 int blob_x_order(                    //sort function
                  const void *item1,  //items to compare
                  const void *item2);
+// Copies the blobs of the list into a contiguous array ordered in x as
+// blob_x_order, for the read-mostly passes that would otherwise walk and
+// re-sort the list. Equal left edges keep their list order. If extract,
+// the blobs are moved out of the list, leaving it empty, so the caller
+// can redistribute them without per-blob list surgery.
+void freeze_blobs_in_x(BLOBNBOX_LIST *blobs, bool extract,
+                       std::vector<BLOBNBOX*>* frozen);
 int row_y_order(                    //sort function
                 const void *item1,  //items to compare
                 const void *item2);
@@ -18,7 +18,8 @@
 
 #include "scanedg.h"
 
-#include <memory>  // std::unique_ptr
+#include <cstring>  // std::memcpy, std::memset
+#include <memory>   // std::unique_ptr
 
 #include "allheaders.h"
 #include "edgloop.h"
@@ -28,6 +29,79 @@
 // Flips between WHITE_PIX and BLACK_PIX.
 #define FLIP_COLOUR(pix)  (1-(pix))
 
+// Number of CRACKEDGEs allocated at once by CrackEdgeArena.
+const int kCrackEdgeBlockSize = 1024;
+
+/**********************************************************************
+ * CrackEdgeArena::AddEdges
+ *
+ * Allocate another array of edges and put them on the free list.
+ **********************************************************************/
+
+void CrackEdgeArena::AddEdges() {
+  CRACKEDGE* edges = new CRACKEDGE[kCrackEdgeBlockSize];
+  blocks_.emplace_back(edges);
+  for (int i = 0; i < kCrackEdgeBlockSize - 1; ++i)
+    edges[i].next = &edges[i + 1];
+  edges[kCrackEdgeBlockSize - 1].next = free_cracks_;
+  free_cracks_ = edges;
+}
+
+/**********************************************************************
+ * unpack_line
+ *
+ * Convert count pixels of a line of a binary image, starting at x, to
+ * one byte per pixel of WHITE_PIX or BLACK_PIX. Whole words are handled
+ * at once, as most of them are all white or all black.
+ **********************************************************************/
+
+static void unpack_line(const l_uint32* line,  // image line
+                        int x,                 // first pixel
+                        int count,             // number of pixels
+                        uint8_t* pixels) {
+  int index = 0;
+                                 // up to a word boundary
+  for (; index < count && ((x + index) & 31) != 0; ++index)
+    pixels[index] = GET_DATA_BIT(line, x + index) ^ 1;
+  for (; index + 32 <= count; index += 32) {
+    const l_uint32 word = line[(x + index) >> 5];
+    if (word == 0) {
+      memset(pixels + index, WHITE_PIX, 32);
+    } else if (word == 0xffffffff) {
+      memset(pixels + index, BLACK_PIX, 32);
+    } else {
+      for (int bit = 0; bit < 32; ++bit)    // most significant bit first
+        pixels[index + bit] = ((word >> (31 - bit)) & 1) ^ 1;
+    }
+  }
+  for (; index < count; ++index)
+    pixels[index] = GET_DATA_BIT(line, x + index) ^ 1;
+}
+
+/**********************************************************************
+ * uniform_run
+ *
+ * Return the number of pixels, a multiple of 8 and at most max_run, from
+ * the start of both lines that are all of the given colour.
+ **********************************************************************/
+
+static int uniform_run(const uint8_t* bwpos,    // thresholded line
+                       const uint8_t* upperpos, // thresholded prev line
+                       int colour,              // colour to match
+                       int max_run) {
+  // Every byte holds colour.
+  const uint64_t pattern = colour * UINT64_C(0x0101010101010101);
+  int run = 0;
+  for (; run + 8 <= max_run; run += 8) {
+    uint64_t pixels;
+    uint64_t upper;
+    memcpy(&pixels, bwpos + run, sizeof(pixels));
+    memcpy(&upper, upperpos + run, sizeof(upper));
+    if (((pixels ^ pattern) | (upper ^ pattern)) != 0) break;
+  }
+  return run;
+}
+
 /**********************************************************************
  * block_edges
  *
@@ -46,7 +120,7 @@ void block_edges(Pix *t_pix,           // thresholded image
   int wpl = pixGetWpl(t_pix);
                                  // lines in progress
   std::unique_ptr<CRACKEDGE*[]> ptrline(new CRACKEDGE*[width + 1]);
-  CRACKEDGE *free_cracks = nullptr;
+  CrackEdgeArena arena;
 
   block->bounding_box(bleft, tright);  // block box
   ASSERT_HOST(tright.x() <= width);
@@ -56,25 +130,25 @@ void block_edges(Pix *t_pix,           // thresholded image
     ptrline[x] = nullptr;           //  no lines in progress
 
   std::unique_ptr<uint8_t[]> bwline(new uint8_t[width]);
+                                 // previous line
+  std::unique_ptr<uint8_t[]> upperline(new uint8_t[width]);
 
   const uint8_t margin = WHITE_PIX;
+  memset(upperline.get(), margin, block_width * sizeof(upperline[0]));
 
   for (int y = tright.y() - 1; y >= bleft.y() - 1; y--) {
     if (y >= bleft.y() && y < tright.y()) {
       // Get the binary pixels from the image.
       l_uint32* line = pixGetData(t_pix) + wpl * (height - 1 - y);
-      for (int x = 0; x < block_width; ++x) {
-        bwline[x] = GET_DATA_BIT(line, x + bleft.x()) ^ 1;
-      }
+      unpack_line(line, bleft.x(), block_width, bwline.get());
       make_margins(block, &line_it, bwline.get(), margin, bleft.x(), tright.x(), y);
     } else {
       memset(bwline.get(), margin, block_width * sizeof(bwline[0]));
     }
-    line_edges(bleft.x(), y, block_width,
-               margin, bwline.get(), ptrline.get(), &free_cracks, outline_it);
+    line_edges(bleft.x(), y, block_width, margin, bwline.get(),
+               upperline.get(), ptrline.get(), &arena, outline_it);
+    bwline.swap(upperline);
   }
-
-  free_crackedges(free_cracks);  // really free them
 }
 
 
@@ -137,6 +211,8 @@ void make_margins(                         //get a line
  *
  * Scan a line for edges and update the edges in progress.
  * When edges close into loops, send them for approximation.
+ * Runs where neither this line nor the previous one changes colour cannot
+ * hold any edges, so they are skipped 8 pixels at a time.
  **********************************************************************/
 
 void line_edges(int16_t x,                         // coord of line start
@@ -144,10 +220,11 @@ void line_edges(int16_t x,                         // coord of line start
                 int16_t xext,                      // width of line
                 uint8_t uppercolour,               // start of prev line
                 uint8_t * bwpos,                   // thresholded line
+                const uint8_t * upperpos,          // thresholded prev line
                 CRACKEDGE ** prevline,           // edges in progress
-                CRACKEDGE **free_cracks,
+                CrackEdgeArena* arena,
                 C_OUTLINE_IT* outline_it) {
-  CrackPos pos = {free_cracks, x, y };
+  CrackPos pos = {arena, x, y };
   int xmax;                      // max x coord
   int prevcolour;                // of previous pixel
   CRACKEDGE *current;            // current h edge
@@ -158,7 +235,7 @@ void line_edges(int16_t x,                         // coord of line start
   current = nullptr;                // nothing yet
 
                                  // do each pixel
-  for (; pos.x < xmax; pos.x++, prevline++) {
+  for (; pos.x < xmax; pos.x++, prevline++, upperpos++) {
     const int colour = *bwpos++; // current pixel
     if (*prevline != nullptr) {
                                  // changed above
@@ -167,7 +244,7 @@ void line_edges(int16_t x,                         // coord of line start
       if (colour == prevcolour) {
         if (colour == uppercolour) {
                                  // finish a line
-          join_edges(current, *prevline, free_cracks, outline_it);
+          join_edges(current, *prevline, arena, outline_it);
           current = nullptr;        // no edge now
         } else {
                                  // new horiz edge
@@ -179,7 +256,7 @@ void line_edges(int16_t x,                         // coord of line start
           *prevline = v_edge(colour - prevcolour, *prevline, &pos);
                                  // 8 vs 4 connection
         else if (colour == WHITE_PIX) {
-          join_edges(current, *prevline, free_cracks, outline_it);
+          join_edges(current, *prevline, arena, outline_it);
           current = h_edge(uppercolour - colour, nullptr, &pos);
           *prevline = v_edge(colour - prevcolour, current, &pos);
         } else {
@@ -194,16 +271,26 @@ void line_edges(int16_t x,                         // coord of line start
         *prevline = current = v_edge(colour - prevcolour, current, &pos);
         prevcolour = colour;
       }
-      if (colour != uppercolour)
+      if (colour != uppercolour) {
         current = h_edge(uppercolour - colour, current, &pos);
-      else
+      } else {
         current = nullptr;          // no edge now
+        if (*prevline == nullptr) {
+                                 // skip plain pixels
+          const int run = uniform_run(bwpos, upperpos + 1, colour,
+                                      xmax - 1 - pos.x);
+          pos.x += run;
+          prevline += run;
+          bwpos += run;
+          upperpos += run;
+        }
+      }
     }
   }
   if (current != nullptr) {
                                  // out of block
     if (*prevline != nullptr) {     // got one to join to?
-      join_edges(current, *prevline, free_cracks, outline_it);
+      join_edges(current, *prevline, arena, outline_it);
       *prevline = nullptr;          // tidy now
     } else {
                                  // fake vertical
@@ -227,12 +314,7 @@ CRACKEDGE *h_edge(int sign,                       // sign of edge
                   CrackPos* pos) {
   CRACKEDGE *newpt;              // return value
 
-  if (*pos->free_cracks != nullptr) {
-    newpt = *pos->free_cracks;
-    *pos->free_cracks = newpt->next;  // get one fast
-  } else {
-    newpt = new CRACKEDGE;
-  }
+  newpt = pos->arena->New();     // get one fast
   newpt->pos.set_y(pos->y + 1);       // coords of pt
   newpt->stepy = 0;              // edge is horizontal
 
@@ -278,12 +360,7 @@ CRACKEDGE *v_edge(int sign,                       // sign of edge
                   CrackPos* pos) {
   CRACKEDGE *newpt;              // return value
 
-  if (*pos->free_cracks != nullptr) {
-    newpt = *pos->free_cracks;
-    *pos->free_cracks = newpt->next;  // get one fast
-  } else {
-    newpt = new CRACKEDGE;
-  }
+  newpt = pos->arena->New();     // get one fast
   newpt->pos.set_x(pos->x);           // coords of pt
   newpt->stepx = 0;              // edge is vertical
 
@@ -327,7 +404,7 @@ CRACKEDGE *v_edge(int sign,                       // sign of edge
 
 void join_edges(CRACKEDGE *edge1,  // edges to join
                 CRACKEDGE *edge2,   // no specific order
-                CRACKEDGE **free_cracks,
+                CrackEdgeArena* arena,
                 C_OUTLINE_IT* outline_it) {
   if (edge1->pos.x() + edge1->stepx != edge2->pos.x()
   || edge1->pos.y() + edge1->stepy != edge2->pos.y()) {
@@ -339,9 +416,7 @@ void join_edges(CRACKEDGE *edge1,  // edges to join
   if (edge1->next == edge2) {
                                  // already closed
     complete_edge(edge1, outline_it);
-                                 // attach freelist to end
-    edge1->prev->next = *free_cracks;
-    *free_cracks = edge1;         // and free list
+    arena->FreeLoop(edge1);      // recycle the edges
   } else {
                                  // update opposite ends
     edge2->prev->next = edge1->next;
@@ -350,20 +425,3 @@ void join_edges(CRACKEDGE *edge1,  // edges to join
     edge2->prev = edge1;
   }
 }
-
-
-/**********************************************************************
- * free_crackedges
- *
- * Really free the CRACKEDGEs by giving them back to delete.
- **********************************************************************/
-
-void free_crackedges(CRACKEDGE *start) {
-  CRACKEDGE *current;            // current edge to free
-  CRACKEDGE *next;               // next one to free
-
-  for (current = start; current != nullptr; current = next) {
-    next = current->next;
-    delete current;              // delete them all
-  }
-}
@@ -19,6 +19,8 @@
 #ifndef           SCANEDG_H
 #define           SCANEDG_H
 
+#include          <memory>      // std::unique_ptr
+#include          <vector>      // std::vector
 #include          "params.h"
 #include          "scrollview.h"
 #include          "pdblock.h"
@@ -26,8 +28,34 @@
 
 class C_OUTLINE_IT;
 
+// Storage for the CRACKEDGEs of a block. The edges are allocated in arrays
+// rather than one at a time, and finished loops are recycled through a
+// free list. All the edges are deleted with the arena.
+class CrackEdgeArena {
+ public:
+  // Returns an unused edge.
+  CRACKEDGE* New() {
+    if (free_cracks_ == nullptr) AddEdges();
+    CRACKEDGE* edge = free_cracks_;
+    free_cracks_ = edge->next;
+    return edge;
+  }
+  // Puts the closed loop containing edge back on the free list.
+  void FreeLoop(CRACKEDGE* edge) {
+    edge->prev->next = free_cracks_;
+    free_cracks_ = edge;
+  }
+
+ private:
+  // Allocates another array of edges and puts them on the free list.
+  void AddEdges();
+
+  CRACKEDGE* free_cracks_ = nullptr;             // Freelist of unused edges.
+  std::vector<std::unique_ptr<CRACKEDGE[]>> blocks_;  // All allocated edges.
+};
+
 struct CrackPos {
-  CRACKEDGE** free_cracks;   // Freelist for fast allocation.
+  CrackEdgeArena* arena;     // Storage for fast allocation.
   int x;                     // Position of new edge.
   int y;
 };
@@ -49,8 +77,9 @@ void line_edges(int16_t x,                     // coord of line start
                 int16_t xext,                  // width of line
                 uint8_t uppercolour,           // start of prev line
                 uint8_t * bwpos,               // thresholded line
+                const uint8_t * upperpos,      // thresholded prev line
                 CRACKEDGE ** prevline,       // edges in progress
-                CRACKEDGE **free_cracks,
+                CrackEdgeArena* arena,
                 C_OUTLINE_IT* outline_it);
 CRACKEDGE *h_edge(int sign,                  // sign of edge
                   CRACKEDGE * join,          // edge to join to
@@ -60,8 +89,7 @@ CRACKEDGE *v_edge(int sign,                  // sign of edge
                   CrackPos* pos);
 void join_edges(CRACKEDGE *edge1,            // edges to join
                 CRACKEDGE *edge2,            // no specific order
-                CRACKEDGE **free_cracks,
+                CrackEdgeArena* arena,
                 C_OUTLINE_IT* outline_it);
-void free_crackedges(CRACKEDGE *start);
 
 #endif
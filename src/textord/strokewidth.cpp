@@ -34,6 +34,11 @@
 #include "tabfind.h"
 #include "textlineprojection.h"
 #include "tordmain.h"  // For SetBlobStrokeWidth.
+#include "numthreads.h"  // for NumThreads
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
 
 namespace tesseract {
 
@@ -109,7 +114,8 @@ const double kNoiseOverlapAreaFactor = 1.0 / 512;
 StrokeWidth::StrokeWidth(int gridsize,
                          const ICOORD& bleft, const ICOORD& tright)
   : BlobGrid(gridsize, bleft, tright), nontext_map_(nullptr), projection_(nullptr),
-    denorm_(nullptr), grid_box_(bleft, tright), rerotation_(1.0f, 0.0f) {
+    denorm_(nullptr), grid_box_(bleft, tright), rerotation_(1.0f, 0.0f),
+    num_threads_(0) {
   leaders_win_ = nullptr;
   widths_win_ = nullptr;
   initial_widths_win_ = nullptr;
@@ -142,10 +148,12 @@ StrokeWidth::~StrokeWidth() {
 void StrokeWidth::SetNeighboursOnMediumBlobs(TO_BLOCK* block) {
   // Run a preliminary strokewidth neighbour detection on the medium blobs.
   InsertBlobList(&block->blobs);
+  std::vector<BLOBNBOX*> blobs;
   BLOBNBOX_IT blob_it(&block->blobs);
   for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
-    SetNeighbours(false, false, blob_it.data());
+    blobs.push_back(blob_it.data());
   }
+  SetNeighboursOnBlobs(false, false, blobs);
   Clear();
 }
 
@@ -446,13 +454,12 @@ void StrokeWidth::FindLeadersAndMarkNoise(TO_BLOCK* block,
                                           ColPartition_LIST* leader_parts) {
   InsertBlobList(&block->small_blobs);
   InsertBlobList(&block->noise_blobs);
+  // For every bbox in the grid, set its neighbours.
+  std::vector<BLOBNBOX*> blobs;
+  GetGridBlobs(&blobs);
+  SetNeighboursOnBlobs(true, false, blobs);
   BlobGridSearch gsearch(this);
   BLOBNBOX* bbox;
-  // For every bbox in the grid, set its neighbours.
-  gsearch.StartFullSearch();
-  while ((bbox = gsearch.NextFullSearch()) != nullptr) {
-    SetNeighbours(true, false, bbox);
-  }
   ColPartition_IT part_it(leader_parts);
   gsearch.StartFullSearch();
   while ((bbox = gsearch.NextFullSearch()) != nullptr) {
@@ -798,21 +805,30 @@ void StrokeWidth::AccumulateOverlaps(const BLOBNBOX* not_this, bool debug,
 // so display_if_debugging is true on the final call to display the results.
 void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
                                             bool display_if_debugging) {
-  BlobGridSearch gsearch(this);
-  BLOBNBOX* bbox;
+  // The first 3 passes only change the blob being visited, and only read
+  // state of the other blobs that the pass doesn't change, so they can run
+  // in parallel.
+  std::vector<BLOBNBOX*> blobs;
+  GetGridBlobs(&blobs);
   // For every bbox in the grid, set its neighbours.
-  gsearch.StartFullSearch();
-  while ((bbox = gsearch.NextFullSearch()) != nullptr) {
-    SetNeighbours(false, display_if_debugging, bbox);
-  }
+  SetNeighboursOnBlobs(false, display_if_debugging, blobs);
+  const int num_blobs = blobs.size();
+  const int num_threads = NumBlobThreads();
   // Where vertical or horizontal wins by a big margin, clarify it.
-  gsearch.StartFullSearch();
-  while ((bbox = gsearch.NextFullSearch()) != nullptr) {
-    SimplifyObviousNeighbours(bbox);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64) \
+    if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blobs; ++b) {
+    SimplifyObviousNeighbours(blobs[b]);
   }
   // Now try to make the blobs only vertical or horizontal using neighbours.
-  gsearch.StartFullSearch();
-  while ((bbox = gsearch.NextFullSearch()) != nullptr) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64) \
+    if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blobs; ++b) {
+    BLOBNBOX* bbox = blobs[b];
     if (FindingVerticalOnly(pageseg_mode)) {
       bbox->set_vert_possible(true);
       bbox->set_horz_possible(false);
@@ -827,6 +843,10 @@ void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
       textord_tabfind_show_strokewidths > 1) {
     initial_widths_win_ = DisplayGoodBlobs("InitialStrokewidths", 400, 0);
   }
+  // The smoothing passes read the flow of the neighbours as they change, so
+  // they must run in grid order.
+  BlobGridSearch gsearch(this);
+  BLOBNBOX* bbox;
   // Improve flow direction with neighbours.
   gsearch.StartFullSearch();
   while ((bbox = gsearch.NextFullSearch()) != nullptr) {
@@ -848,6 +868,43 @@ void StrokeWidth::FindTextlineFlowDirection(PageSegMode pageseg_mode,
   }
 }
 
+// Returns the number of threads to use for a pass over the blobs that only
+// changes the blob being visited.
+int StrokeWidth::NumBlobThreads() const {
+#ifdef _OPENMP
+  if (textord_debug_tabfind < 2)
+    return NumThreads(omp_get_max_threads(), num_threads_);
+#endif  // _OPENMP
+  return 1;
+}
+
+// Returns the blobs in the grid in the order of a full search.
+void StrokeWidth::GetGridBlobs(std::vector<BLOBNBOX*>* blobs) {
+  blobs->clear();
+  BlobGridSearch gsearch(this);
+  BLOBNBOX* bbox;
+  gsearch.StartFullSearch();
+  while ((bbox = gsearch.NextFullSearch()) != nullptr) {
+    blobs->push_back(bbox);
+  }
+}
+
+// Calls SetNeighbours on all the given blobs. SetNeighbours only changes the
+// neighbours (and maybe the region type) of the blob it is given, and the
+// searches only read the grid, so the blobs are independent.
+void StrokeWidth::SetNeighboursOnBlobs(bool leaders, bool activate_line_trap,
+                                       const std::vector<BLOBNBOX*>& blobs) {
+  const int num_blobs = blobs.size();
+  const int num_threads = NumBlobThreads();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64) \
+    if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blobs; ++b) {
+    SetNeighbours(leaders, activate_line_trap, blobs[b]);
+  }
+}
+
 // Sets the neighbours and good_stroke_neighbours members of the blob by
 // searching close on all 4 sides.
 // When finding leader dots/dashes, there is a slightly different rule for
@@ -25,6 +25,8 @@
 #include "colpartitiongrid.h"
 #include "textlineprojection.h"
 
+#include <vector>
+
 class DENORM;
 class ScrollView;
 class TO_BLOCK;
@@ -59,6 +61,12 @@ class StrokeWidth : public BlobGrid {
   StrokeWidth(int gridsize, const ICOORD& bleft, const ICOORD& tright);
   ~StrokeWidth() override;
 
+  // Sets the number of threads requested for the passes over all the blobs
+  // that only change the blob being visited. See NumThreads.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+
   // Sets the neighbours member of the medium-sized blobs in the block.
   // Searches on 4 sides of each blob for similar-sized, similar-strokewidth
   // blobs and sets pointers to the good neighbours.
@@ -135,6 +143,17 @@ class StrokeWidth : public BlobGrid {
   // neighbourhood of each grid cell.
   void ComputeNoiseDensity(TO_BLOCK* block, TabFind* line_grid);
 
+  // Returns the number of threads to use for a pass over the blobs that only
+  // changes the blob being visited, and only reads the grid and the other
+  // blobs, so the result doesn't depend on the order of the blobs.
+  // Debug output needs a single thread to make sense.
+  int NumBlobThreads() const;
+  // Returns the blobs in the grid in the order of a full search.
+  void GetGridBlobs(std::vector<BLOBNBOX*>* blobs);
+  // Calls SetNeighbours on all the given blobs, on NumBlobThreads() threads.
+  void SetNeighboursOnBlobs(bool leaders, bool activate_line_trap,
+                            const std::vector<BLOBNBOX*>& blobs);
+
   // Detects and marks leader dots/dashes.
   //    Leaders are horizontal chains of small or noise blobs that look
   //    monospace according to ColPartition::MarkAsLeaderIfMonospaced().
@@ -340,6 +359,8 @@ class StrokeWidth : public BlobGrid {
   TBOX grid_box_;
   // Rerotation to get back to the original image.
   FCOORD rerotation_;
+  // Number of threads requested for the independent passes over the blobs.
+  int num_threads_;
   // Windows for debug display.
   ScrollView* leaders_win_;
   ScrollView* initial_widths_win_;
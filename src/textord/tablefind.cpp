@@ -27,8 +27,13 @@
 #include "allheaders.h"
 
 #include "colpartitionset.h"
+#include "numthreads.h"  // for NumThreads
 #include "tablerecog.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
 namespace tesseract {
 
 // These numbers are used to calculate the global median stats.
@@ -161,7 +166,8 @@ TableFinder::TableFinder()
       global_median_xheight_(0),
       global_median_blob_width_(0),
       global_median_ledding_(0),
-      left_to_right_language_(true) {
+      left_to_right_language_(true),
+      num_threads_(0) {
 }
 
 TableFinder::~TableFinder() {
@@ -1835,16 +1841,31 @@ void TableFinder::RecognizeTables() {
   ColSegment_CLIST good_tables;
   ColSegment_C_IT good_it(&good_tables);
 
+  std::vector<ColSegment*> found_tables;
   ColSegmentGridSearch gsearch(&table_grid_);
   gsearch.StartFullSearch();
   ColSegment* found_table = nullptr;
   while ((found_table = gsearch.NextFullSearch()) != nullptr) {
     gsearch.RemoveBBox();
-
-    // The goal is to make the tables persistent in a list.
-    // When that happens, this will move into the search loop.
-    const TBOX& found_box = found_table->bounding_box();
-    StructuredTable* table_structure = recognizer.RecognizeTable(found_box);
+    found_tables.push_back(found_table);
+  }
+  // Recognition only reads the text and line grids, so the tables can be
+  // recognized in parallel and then processed in the order of the search.
+  const int num_tables = found_tables.size();
+  std::vector<StructuredTable*> table_structures(num_tables);
+  int num_threads = 1;
+#ifdef _OPENMP
+  if (!textord_show_tables)
+    num_threads = NumThreads(omp_get_max_threads(), num_threads_);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int t = 0; t < num_tables; ++t) {
+    table_structures[t] =
+        recognizer.RecognizeTable(found_tables[t]->bounding_box());
+  }
+  for (int t = 0; t < num_tables; ++t) {
+    found_table = found_tables[t];
+    StructuredTable* table_structure = table_structures[t];
 
     // Process a table. Good tables are inserted into the grid again later on
     // We can't change boxes in the grid while it is running a search.
@@ -140,6 +140,10 @@ class TableFinder {
   }
   // Change the reading order. Initially it is left to right.
   void set_left_to_right_language(bool order);
+  // Number of threads for recognizing the tables, 0 for the default.
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
 
   // Initialize
   void Init(int grid_size, const ICOORD& bottom_left, const ICOORD& top_right);
@@ -423,6 +427,8 @@ class TableFinder {
   ColSegmentGrid table_grid_;
   // The reading order of text. Defaults to true, for languages such as English.
   bool left_to_right_language_;
+  // Number of threads for the table recognition, 0 for the default.
+  int num_threads_;
 };
 
 }  // namespace tesseract.
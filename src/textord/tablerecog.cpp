@@ -69,6 +69,7 @@ const double kMinFilledArea = 0.35;
 StructuredTable::StructuredTable()
     : text_grid_(nullptr),
       line_grid_(nullptr),
+      text_candidates_(nullptr),
       is_lined_(false),
       space_above_(0),
       space_below_(0),
@@ -91,6 +92,14 @@ void StructuredTable::set_line_grid(ColPartitionGrid* line_grid) {
 void StructuredTable::set_max_text_height(int height) {
   max_text_height_ = height;
 }
+void StructuredTable::set_text_candidates(
+    const std::vector<ColPartition*>* candidates) {
+  text_candidates_ = candidates;
+  text_candidate_boxes_.clear();
+  if (candidates == nullptr) return;
+  for (ColPartition* part : *candidates)
+    text_candidate_boxes_.push_back(part->bounding_box());
+}
 bool StructuredTable::is_lined() const {
   return is_lined_;
 }
@@ -186,8 +195,10 @@ bool StructuredTable::FindLinedStructure() {
 // Finds the cellular structure given a particular box.
 bool StructuredTable::FindWhitespacedStructure() {
   ClearStructure();
-  FindWhitespacedColumns();
-  FindWhitespacedRows();
+  std::vector<ColPartition*> texts;
+  FindTextPartitions(&texts);
+  FindWhitespacedColumns(texts);
+  FindWhitespacedRows(texts);
 
   if (!VerifyWhitespacedTable()) {
     return false;
@@ -346,12 +357,45 @@ bool StructuredTable::VerifyWhitespacedTable() {
   return row_count() >= 2 && column_count() >= 2 && cell_count() >= 6;
 }
 
+// Finds the text partitions that overlap the bounding box, from the
+// candidates if there are any, or else from text_grid_.
+void StructuredTable::FindTextPartitions(std::vector<ColPartition*>* texts) {
+  texts->clear();
+  if (text_candidates_ != nullptr) {
+    const int num_candidates = text_candidates_->size();
+    if (num_candidates == 0)
+      return;
+    std::vector<int> hits(num_candidates);
+    int num_hits = FilterOverlappingBoxes(bounding_box_,
+                                          &text_candidate_boxes_[0],
+                                          num_candidates, &hits[0]);
+    for (int h = 0; h < num_hits; ++h)
+      texts->push_back((*text_candidates_)[hits[h]]);
+    return;
+  }
+  ColPartitionGridSearch gsearch(text_grid_);
+  gsearch.SetUniqueMode(true);
+  std::vector<ColPartition*> parts;
+  gsearch.RectSearchAll(bounding_box_, &parts);
+  for (ColPartition* part : parts) {
+    if (part->IsTextType())
+      texts->push_back(part);
+  }
+}
+
 // Finds vertical splits in the ColPartitions of text_grid_ by considering
 // all possible "good" guesses. A good guess is just the left/right sides of
 // the partitions, since these locations will uniquely define where the
 // extremal values where the splits can occur. The split happens
 // in the middle of the two nearest partitions.
 void StructuredTable::FindWhitespacedColumns() {
+  std::vector<ColPartition*> texts;
+  FindTextPartitions(&texts);
+  FindWhitespacedColumns(texts);
+}
+
+void StructuredTable::FindWhitespacedColumns(
+    const std::vector<ColPartition*>& texts) {
   // Set of the extents of all partitions on the page.
   GenericVectorEqEq<int> left_sides;
   GenericVectorEqEq<int> right_sides;
@@ -359,14 +403,7 @@ void StructuredTable::FindWhitespacedColumns() {
   // Look at each text partition. We want to find the partitions
   // that have extremal left/right sides. These will give us a basis
   // for the table columns.
-  ColPartitionGridSearch gsearch(text_grid_);
-  gsearch.SetUniqueMode(true);
-  gsearch.StartRectSearch(bounding_box_);
-  ColPartition* text = nullptr;
-  while ((text = gsearch.NextRectSearch()) != nullptr) {
-    if (!text->IsTextType())
-      continue;
-
+  for (ColPartition* text : texts) {
     ASSERT_HOST(text->bounding_box().left() < text->bounding_box().right());
     int spacing = static_cast<int>(text->median_width() *
                                    kHorizontalSpacing / 2.0 + 0.5);
@@ -397,6 +434,13 @@ void StructuredTable::FindWhitespacedColumns() {
 // extremal values where the splits can occur. The split happens
 // in the middle of the two nearest partitions.
 void StructuredTable::FindWhitespacedRows() {
+  std::vector<ColPartition*> texts;
+  FindTextPartitions(&texts);
+  FindWhitespacedRows(texts);
+}
+
+void StructuredTable::FindWhitespacedRows(
+    const std::vector<ColPartition*>& texts) {
   // Set of the extents of all partitions on the page.
   GenericVectorEqEq<int> bottom_sides;
   GenericVectorEqEq<int> top_sides;
@@ -409,14 +453,7 @@ void StructuredTable::FindWhitespacedRows() {
   // that have extremal bottom/top sides. These will give us a basis
   // for the table rows. Because the textlines can be skewed and close due
   // to warping, the height of the partitions is toned down a little bit.
-  ColPartitionGridSearch gsearch(text_grid_);
-  gsearch.SetUniqueMode(true);
-  gsearch.StartRectSearch(bounding_box_);
-  ColPartition* text = nullptr;
-  while ((text = gsearch.NextRectSearch()) != nullptr) {
-    if (!text->IsTextType())
-      continue;
-
+  for (ColPartition* text : texts) {
     ASSERT_HOST(text->bounding_box().bottom() < text->bounding_box().top());
     min_bottom = std::min(min_bottom, static_cast<int>(text->bounding_box().bottom()));
     max_top = std::max(max_top, static_cast<int>(text->bounding_box().top()));
@@ -747,7 +784,12 @@ StructuredTable* TableRecognizer::RecognizeTable(const TBOX& guess) {
   // Fallback to whitespace if that failed.
   // TODO(nbeato): Break this apart to take advantage of horizontal
   // lines or vertical lines when present.
-  if (RecognizeWhitespacedTable(guess, table))
+  std::vector<ColPartition*> candidates;
+  FindTextCandidates(guess, &candidates);
+  table->set_text_candidates(&candidates);
+  bool found = RecognizeWhitespacedTable(guess, table);
+  table->set_text_candidates(nullptr);
+  if (found)
     return table;
 
   // No table found...
@@ -1009,6 +1051,22 @@ bool TableRecognizer::RecognizeWhitespacedTable(const TBOX& guess_box,
   return table->FindWhitespacedStructure();
 }
 
+// Finds the text partitions in the full height strip of the page above and
+// below guess_box. RecognizeWhitespacedTable only moves the top and bottom
+// of the table, so these include every partition it may look at.
+void TableRecognizer::FindTextCandidates(
+    const TBOX& guess_box, std::vector<ColPartition*>* candidates) {
+  TBOX strip(guess_box.left(), -INT16_MAX, guess_box.right(), INT16_MAX);
+  ColPartitionGridSearch gsearch(text_grid_);
+  gsearch.SetUniqueMode(true);
+  std::vector<ColPartition*> parts;
+  gsearch.RectSearchAll(strip, &parts);
+  for (ColPartition* part : parts) {
+    if (part->IsTextType())
+      candidates->push_back(part);
+  }
+}
+
 // Finds the closest value to y that can safely cause a horizontal
 // split in the partitions.
 // This function has been buggy and not as reliable as I would've
@@ -20,6 +20,7 @@
 #ifndef TABLERECOG_H_
 #define TABLERECOG_H_
 
+#include <vector>
 #include "colpartitiongrid.h"
 #include "genericvector.h"
 
@@ -84,6 +85,12 @@ class StructuredTable {
   // Filters text partitions that are ridiculously tall to prevent
   // merging rows.
   void set_max_text_height(int height);
+  // Restricts the text partitions that FindWhitespacedStructure considers to
+  // candidates, so the many boxes tried for one table do not each search
+  // the text grid. candidates must hold every text partition of the text
+  // grid that can overlap those boxes, and must outlive its use here.
+  // nullptr goes back to searching the text grid.
+  void set_text_candidates(const std::vector<ColPartition*>* candidates);
 
   // Basic accessors. Some are treated as attributes despite having indirect
   // representation.
@@ -159,10 +166,14 @@ class StructuredTable {
   // You could add things like maximum number of ColPartitions per cell or
   // similar.
   bool VerifyWhitespacedTable();
+  // Finds the text partitions that overlap the bounding box.
+  void FindTextPartitions(std::vector<ColPartition*>* texts);
   // Find the columns of a table using whitespace.
   void FindWhitespacedColumns();
+  void FindWhitespacedColumns(const std::vector<ColPartition*>& texts);
   // Find the rows of a table using whitespace.
   void FindWhitespacedRows();
+  void FindWhitespacedRows(const std::vector<ColPartition*>& texts);
 
   ////////
   //////// Functions to provide information about the table.
@@ -236,6 +247,9 @@ class StructuredTable {
   // Input data, used as read only data to make decisions.
   ColPartitionGrid* text_grid_;    // Text ColPartitions
   ColPartitionGrid* line_grid_;    // Line ColPartitions
+  // Optional superset of the text partitions to consider, and their boxes.
+  const std::vector<ColPartition*>* text_candidates_;
+  std::vector<TBOX> text_candidate_boxes_;
   // Table structure.
   // bounding box is a convenient external representation.
   // cell_x_ and cell_y_ indicate the grid lines.
@@ -351,6 +365,11 @@ class TableRecognizer {
   // that this method will fail if the guess_box center is not
   // mostly within the table.
   bool RecognizeWhitespacedTable(const TBOX& guess_box, StructuredTable* table);
+  // Finds the text partitions in the full height strip of the page above and
+  // below guess_box, which include all those RecognizeWhitespacedTable may
+  // look at.
+  void FindTextCandidates(const TBOX& guess_box,
+                          std::vector<ColPartition*>* candidates);
 
   // Finds the location of a horizontal split relative to y.
   // This function is mostly unused now. If the SolveWhitespacedTable
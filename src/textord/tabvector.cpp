@@ -28,6 +28,9 @@
 #include "statistc.h"
 
 #include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
 
 namespace tesseract {
 
@@ -355,13 +358,49 @@ void TabVector::ApplyConstraints() {
 void TabVector::MergeSimilarTabVectors(const ICOORD& vertical,
                                        TabVector_LIST* vectors,
                                        BlobGrid* grid) {
+  // SimilarTo can only be true for vectors on the same side with sort keys
+  // within kSimilarRaggedDist * v_scale of each other, so instead of testing
+  // every later vector, the candidates are looked up by sort key in an index
+  // of the vectors not yet visited, holding (sort_key_, list position) for
+  // each side. The candidates are then tested in list order, so the merges
+  // are exactly those of an exhaustive pairwise scan.
+  int v_scale = std::max(abs(vertical.y()), 1);
+  int64_t max_key_dist =
+      static_cast<int64_t>(std::max(kSimilarVectorDist, kSimilarRaggedDist)) *
+      v_scale;
+  std::vector<TabVector*> list_order;
+  std::set<std::pair<int, int>> left_keys, right_keys;
   TabVector_IT it1(vectors);
   for (it1.mark_cycle_pt(); !it1.cycled_list(); it1.forward()) {
+    TabVector* v = it1.data();
+    if (v->IsLeftTab())
+      left_keys.insert(std::make_pair(v->sort_key_, list_order.size()));
+    else if (v->IsRightTab())
+      right_keys.insert(std::make_pair(v->sort_key_, list_order.size()));
+    list_order.push_back(v);
+  }
+  std::vector<int> candidates;
+  int index1 = 0;
+  for (it1.mark_cycle_pt(); !it1.cycled_list(); it1.forward(), ++index1) {
     TabVector* v1 = it1.data();
-    TabVector_IT it2(it1);
-    for (it2.forward(); !it2.at_first(); it2.forward()) {
-      TabVector* v2 = it2.data();
+    if (!v1->IsLeftTab() && !v1->IsRightTab()) continue;
+    std::set<std::pair<int, int>>* keys =
+        v1->IsLeftTab() ? &left_keys : &right_keys;
+    keys->erase(std::make_pair(v1->sort_key_, index1));
+    int min_key = static_cast<int>(
+        std::max<int64_t>(v1->sort_key_ - max_key_dist, INT32_MIN));
+    int max_key = static_cast<int>(
+        std::min<int64_t>(v1->sort_key_ + max_key_dist, INT32_MAX));
+    candidates.clear();
+    for (auto it = keys->lower_bound(std::make_pair(min_key, 0));
+         it != keys->end() && it->first <= max_key; ++it) {
+      candidates.push_back(it->second);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (int index2 : candidates) {
+      TabVector* v2 = list_order[index2];
       if (v2->SimilarTo(vertical, *v1, grid)) {
+        keys->erase(std::make_pair(v2->sort_key_, index2));
         // Merge into the forward one, in case the combined vector now
         // overlaps one in between.
         if (textord_debug_tabfind) {
@@ -377,6 +416,7 @@ void TabVector::MergeSimilarTabVectors(const ICOORD& vertical,
         if (textord_debug_tabfind && abs(merged_vector.x()) > 100) {
           v2->Print("Garbage result of merge?");
         }
+        keys->insert(std::make_pair(v2->sort_key_, index2));
         break;
       }
     }
@@ -24,6 +24,7 @@
 #include "clst.h"
 #include "elst.h"
 #include "elst2.h"
+#include "freelist.h"
 #include "rect.h"
 #include "bbgrid.h"
 
@@ -115,6 +116,7 @@ class TabVector : public ELIST2_LINK {
   // copy constructor instead of operator=.
   TabVector() = default;
   ~TabVector() = default;
+  FREE_LIST_ALLOCATED(TabVector, kMaxFreePartitionBytes)
 
   // Public factory to build a TabVector from a list of boxes.
   // The TabVector will be of the given alignment type.
@@ -16,6 +16,8 @@
 
 #include "blobgrid.h"      // For BlobGrid
 
+#include <vector>
+
 class DENORM;
 struct Pix;
 struct TPOINT;
@@ -162,8 +164,13 @@ class TextlineProjection {
                               TPOINT start_pt, TPOINT end_pt) const;
 
   // Helper function to add 1 to a rectangle in source image coords to the
-  // internal projection pix_.
-  void IncrementRectangle8Bit(const TBOX& box);
+  // difference image increments, which has a border of 1 pixel right and
+  // below the size of pix_.
+  void IncrementRectangle(const TBOX& box, std::vector<int>* increments) const;
+  // Integrates the difference image increments into pix_, saturating at 255.
+  void IntegrateIncrements(const std::vector<int>& increments);
+  // Builds row_sums_ and col_sums_ from pix_.
+  void ComputeLineSums();
   // Inserts a list of blobs into the projection.
   // Rotation is a multiple of 90 degrees to get from blob coords to
   // nontext_map coords, image_box is the bounds of the nontext_map.
@@ -171,7 +178,8 @@ class TextlineProjection {
   // flags, but the spreading is truncated by set pixels in the nontext_map
   // and also by the horizontal rule line limits on the blobs.
   void ProjectBlobs(BLOBNBOX_LIST* blobs, const FCOORD& rotation,
-                    const TBOX& image_box, Pix* nontext_map);
+                    const TBOX& image_box, Pix* nontext_map,
+                    std::vector<int>* increments);
   // Pads the bounding box of the given blob according to whether it is on
   // a horizontal or vertical text line, taking into account tab-stops near
   // the blob. Returns true if padding was in the horizontal direction.
@@ -199,6 +207,11 @@ class TextlineProjection {
   // textline density map. As with a horizontal projection, the map has
   // dips in the gaps between textlines.
   Pix* pix_;
+  // Running sums of pix_ along each row and down each column, so the sum of
+  // an axis-aligned segment is the difference of 2 entries. Each row holds
+  // width + 1 entries starting with 0, and each column height + 1.
+  std::vector<int> row_sums_;
+  std::vector<int> col_sums_;
 };
 
 }  // namespace tesseract.
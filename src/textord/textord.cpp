@@ -28,6 +28,7 @@
 #include "makerow.h"
 #include "pageres.h"
 #include "tordmain.h"
+#include "tracing.h"
 #include "wordseg.h"
 
 namespace tesseract {
@@ -35,6 +36,8 @@ namespace tesseract {
 Textord::Textord(CCStruct* ccstruct)
     : ccstruct_(ccstruct),
       use_cjk_fp_model_(false),
+      num_threads_(0),
+      compute_edge_offsets_(true),
       // makerow.cpp ///////////////////////////////////////////
       BOOL_MEMBER(textord_single_height_mode, false,
                   "Script has no xheight, so use a single mode",
@@ -174,6 +177,34 @@ Textord::Textord(CCStruct* ccstruct)
                     "Don't let sp minus kn get too small", ccstruct_->params()),
       double_MEMBER(tosp_pass_wide_fuzz_sp_to_context, 0.75,
                     "How wide fuzzies need context", ccstruct_->params()),
+      // edgblob.cpp ///////////////////////////////////////////
+      BOOL_MEMBER(edges_use_new_outline_complexity, false,
+                  "Use the new outline complexity module", ccstruct_->params()),
+      INT_MEMBER(edges_max_children_per_outline, 10,
+                 "Max number of children inside a character outline",
+                 ccstruct_->params()),
+      INT_MEMBER(edges_max_children_layers, 5,
+                 "Max layers of nested children inside a character outline",
+                 ccstruct_->params()),
+      BOOL_MEMBER(edges_debug, false, "turn on debugging for this module",
+                  ccstruct_->params()),
+      INT_MEMBER(edges_children_per_grandchild, 10,
+                 "Importance ratio for chucking outlines", ccstruct_->params()),
+      INT_MEMBER(edges_children_count_limit, 45, "Max holes allowed in blob",
+                 ccstruct_->params()),
+      BOOL_MEMBER(edges_children_fix, false,
+                  "Remove boxy parents of char-like children",
+                  ccstruct_->params()),
+      INT_MEMBER(edges_min_nonhole, 12, "Min pixels for potential char in box",
+                 ccstruct_->params()),
+      INT_MEMBER(edges_patharea_ratio, 40,
+                 "Max lensq/area for acceptable child outline",
+                 ccstruct_->params()),
+      double_MEMBER(edges_childarea, 0.5, "Min area fraction of child outline",
+                    ccstruct_->params()),
+      double_MEMBER(edges_boxarea, 0.875,
+                    "Min area fraction of grandchild for box",
+                    ccstruct_->params()),
       // tordmain.cpp ///////////////////////////////////////////
       BOOL_MEMBER(textord_no_rejects, false, "Don't remove noise blobs",
                   ccstruct_->params()),
@@ -224,7 +255,28 @@ Textord::Textord(CCStruct* ccstruct)
       double_MEMBER(textord_blshift_maxshift, 0.00, "Max baseline shift",
                     ccstruct_->params()),
       double_MEMBER(textord_blshift_xfraction, 9.99,
-                    "Min size of baseline shift", ccstruct_->params()) {}
+                    "Min size of baseline shift", ccstruct_->params()),
+      INT_MEMBER(textord_max_page_blobs, 200000,
+                 "Max blobs of a page, beyond which the small and noise blobs"
+                 " are dropped, and then all. 0 for no limit.",
+                 ccstruct_->params()) {}
+
+// Returns the edges_* params of this engine.
+EdgeParams Textord::edge_params() const {
+  EdgeParams params;
+  params.use_new_outline_complexity = edges_use_new_outline_complexity;
+  params.max_children_per_outline = edges_max_children_per_outline;
+  params.max_children_layers = edges_max_children_layers;
+  params.debug = edges_debug;
+  params.children_per_grandchild = edges_children_per_grandchild;
+  params.children_count_limit = edges_children_count_limit;
+  params.children_fix = edges_children_fix;
+  params.min_nonhole = edges_min_nonhole;
+  params.patharea_ratio = edges_patharea_ratio;
+  params.childarea = edges_childarea;
+  params.boxarea = edges_boxarea;
+  return params;
+}
 
 // Make the textlines and words inside each block.
 void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
@@ -232,6 +284,7 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
                           Pix* thresholds_pix, Pix* grey_pix,
                           bool use_box_bottoms, BLOBNBOX_LIST* diacritic_blobs,
                           BLOCK_LIST* blocks, TO_BLOCK_LIST* to_blocks) {
+  TraceSpan span("Textord::TextordPage");
   page_tr_.set_x(width);
   page_tr_.set_y(height);
   if (to_blocks->empty()) {
@@ -243,7 +296,8 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
       // Compute the edge offsets whether or not there is a grey_pix.
       // We have by-passed auto page seg, so we have to run it here.
       // By page segmentation mode there is no non-text to avoid running on.
-      to_block->ComputeEdgeOffsets(thresholds_pix, grey_pix);
+      if (compute_edge_offsets_)
+        to_block->ComputeEdgeOffsets(thresholds_pix, grey_pix);
     }
   } else if (!PSM_SPARSE(pageseg_mode)) {
     // AutoPageSeg does not need to find_components as it did that already.
@@ -277,7 +331,7 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
   float gradient;
   // Do it the old fashioned way.
   if (PSM_LINE_FIND_ENABLED(pageseg_mode)) {
-    gradient = make_rows(page_tr_, to_blocks);
+    gradient = make_rows(page_tr_, to_blocks, num_threads_);
   } else if (!PSM_SPARSE(pageseg_mode)) {
     // RAW_LINE, SINGLE_LINE, SINGLE_WORD and SINGLE_CHAR all need a single row.
     gradient = make_single_row(page_tr_, pageseg_mode != PSM_RAW_LINE,
@@ -287,6 +341,7 @@ void Textord::TextordPage(PageSegMode pageseg_mode, const FCOORD& reskew,
   }
   BaselineDetect baseline_detector(textord_baseline_debug,
                                    reskew, to_blocks);
+  baseline_detector.set_num_threads(num_threads_);
   baseline_detector.ComputeStraightBaselines(use_box_bottoms);
   baseline_detector.ComputeBaselineSplinesAndXheights(
       page_tr_, pageseg_mode != PSM_RAW_LINE, textord_heavy_nr,
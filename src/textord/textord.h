@@ -24,6 +24,7 @@
 #include "ccstruct.h"
 #include "bbgrid.h"
 #include "blobbox.h"
+#include "edgblob.h"
 #include "gap_map.h"
 #include "publictypes.h"  // For PageSegMode.
 
@@ -95,6 +96,18 @@ class Textord {
   void set_use_cjk_fp_model(bool flag) {
     use_cjk_fp_model_ = flag;
   }
+  // Number of threads for the per-block steps, 0 for the default.
+  int num_threads() const {
+    return num_threads_;
+  }
+  void set_num_threads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+  // Whether to compute the sub-pixel edge offsets of the blob outlines, which
+  // only the legacy classifier uses.
+  void set_compute_edge_offsets(bool flag) {
+    compute_edge_offsets_ = flag;
+  }
 
   // tospace.cpp ///////////////////////////////////////////
   void to_spacing(
@@ -107,6 +120,9 @@ class Textord {
   ROW *make_blob_words(TO_ROW *row,     // row to make
                        FCOORD rotation  // for drawing
                        );
+  // edgblob.cpp ///////////////////////////////////////////
+  // Returns the edges_* params of this engine.
+  EdgeParams edge_params() const;
   // tordmain.cpp ///////////////////////////////////////////
   void find_components(Pix* pix, BLOCK_LIST *blocks, TO_BLOCK_LIST *to_blocks);
   void filter_blobs(ICOORD page_tr, TO_BLOCK_LIST* blocks, bool testing_on);
@@ -119,6 +135,8 @@ class Textord {
   ICOORD page_tr_;
 
   bool use_cjk_fp_model_;
+  int num_threads_;
+  bool compute_edge_offsets_;
 
   // makerow.cpp ///////////////////////////////////////////
   // Make the textlines inside each block.
@@ -369,6 +387,24 @@ class Textord {
                "Don't let sp minus kn get too small");
   double_VAR_H(tosp_pass_wide_fuzz_sp_to_context, 0.75,
                "How wide fuzzies need context");
+  // edgblob.cpp ///////////////////////////////////////////
+  BOOL_VAR_H(edges_use_new_outline_complexity, false,
+             "Use the new outline complexity module");
+  INT_VAR_H(edges_max_children_per_outline, 10,
+            "Max number of children inside a character outline");
+  INT_VAR_H(edges_max_children_layers, 5,
+            "Max layers of nested children inside a character outline");
+  BOOL_VAR_H(edges_debug, false, "turn on debugging for this module");
+  INT_VAR_H(edges_children_per_grandchild, 10,
+            "Importance ratio for chucking outlines");
+  INT_VAR_H(edges_children_count_limit, 45, "Max holes allowed in blob");
+  BOOL_VAR_H(edges_children_fix, false,
+             "Remove boxy parents of char-like children");
+  INT_VAR_H(edges_min_nonhole, 12, "Min pixels for potential char in box");
+  INT_VAR_H(edges_patharea_ratio, 40,
+            "Max lensq/area for acceptable child outline");
+  double_VAR_H(edges_childarea, 0.5, "Min area fraction of child outline");
+  double_VAR_H(edges_boxarea, 0.875, "Min area fraction of grandchild for box");
   // tordmain.cpp ///////////////////////////////////////////
   BOOL_VAR_H(textord_no_rejects, false, "Don't remove noise blobs");
   BOOL_VAR_H(textord_show_blobs, false, "Display unsorted blobs");
@@ -397,6 +433,9 @@ class Textord {
   BOOL_VAR_H(textord_noise_debug, false, "Debug row garbage detector");
   double_VAR_H(textord_blshift_maxshift, 0.00, "Max baseline shift");
   double_VAR_H(textord_blshift_xfraction, 9.99, "Min size of baseline shift");
+  INT_VAR_H(textord_max_page_blobs, 200000,
+            "Max blobs of a page, beyond which the small and noise blobs are"
+            " dropped, and then all. 0 for no limit.");
 };
 }  // namespace tesseract.
 
@@ -33,6 +33,7 @@
 #endif
 
 #include <memory>
+#include <vector>
 
 static BOOL_VAR (textord_all_prop, false, "All doc is proportial text");
 BOOL_VAR (textord_debug_pitch_test, false,
@@ -81,12 +82,14 @@ void compute_fixed_pitch(ICOORD page_tr,              // top right
                          TO_BLOCK_LIST* port_blocks,  // input list
                          float gradient,              // page skew
                          FCOORD rotation,             // for drawing
-                         bool testing_on) {          // correct orientation
+                         bool testing_on,             // correct orientation
+                         int num_threads) {
   TO_BLOCK_IT block_it;          //iterator
   TO_BLOCK *block;               //current block;
   TO_ROW *row;                   //current row
   int block_index;               //block number
   int row_index;                 //row number
+  std::vector<TO_BLOCK*> blocks;
 
 #ifndef GRAPHICS_DISABLED
   if (textord_show_initial_words && testing_on) {
@@ -96,22 +99,26 @@ void compute_fixed_pitch(ICOORD page_tr,              // top right
 #endif
 
   block_it.set_to_list (port_blocks);
-  block_index = 1;
   for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
-  block_it.forward ()) {
-    block = block_it.data ();
-    compute_block_pitch(block, rotation, block_index, testing_on);
-    block_index++;
-  }
+  block_it.forward ())
+    blocks.push_back(block_it.data());
+  const int num_blocks = blocks.size();
+  // The pitch of each block is found on its own, but the rows to fix are
+  // compared with those of all the blocks, so that stays serial.
+  num_threads = block_loop_threads(num_threads);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blocks; ++b)
+    compute_block_pitch(blocks[b], rotation, b + 1, testing_on);
 
   if (!try_doc_fixed (page_tr, port_blocks, gradient)) {
-    block_index = 1;
-    for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
-    block_it.forward ()) {
-      block = block_it.data ();
-      if (!try_block_fixed (block, block_index))
-        try_rows_fixed(block, block_index, testing_on);
-      block_index++;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+    for (int b = 0; b < num_blocks; ++b) {
+      if (!try_block_fixed (blocks[b], b + 1))
+        try_rows_fixed(blocks[b], b + 1, testing_on);
     }
   }
 
@@ -45,7 +45,8 @@ void compute_fixed_pitch(ICOORD page_tr,              // top right
                          TO_BLOCK_LIST* port_blocks,  // input list
                          float gradient,              // page skew
                          FCOORD rotation,             // for drawing
-                         bool testing_on);           // correct orientation
+                         bool testing_on,             // correct orientation
+                         int num_threads = 0);        // 0 = default
 void fix_row_pitch(                        //get some value
                    TO_ROW *bad_row,        //row to fix
                    TO_BLOCK *bad_block,    //block of bad_row
@@ -22,6 +22,9 @@
 #endif
 
 #include "tordmain.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <cfloat>               // for FLT_MAX
 #include <cmath>                // for ceil, floor, M_PI
 #include <cstdint>              // for INT16_MAX, uint32_t, int32_t, int16_t
@@ -30,6 +33,7 @@
 #include "blobbox.h"            // for BLOBNBOX_IT, BLOBNBOX, TO_BLOCK, TO_B...
 #include "ccstruct.h"           // for CCStruct, CCStruct::kXHeightFraction
 #include "clst.h"               // for CLISTIZE
+#include "counters.h"           // for CountEvent, COUNTER_BLOBS_FOUND
 #include "coutln.h"             // for C_OUTLINE_IT, C_OUTLINE_LIST, C_OUTLINE
 #include "drawtord.h"           // for plot_box_list, to_win, create_to_win
 #include "edgblob.h"            // for extract_edges
@@ -38,6 +42,7 @@
 #include "makerow.h"            // for textord_test_x, textord_test_y, texto...
 #include "morph.h"              // for L_BOUNDARY_BG
 #include "ocrblock.h"           // for BLOCK_IT, BLOCK, BLOCK_LIST (ptr only)
+#include "numthreads.h"         // for NumThreads
 #include "ocrrow.h"             // for ROW, ROW_IT, ROW_LIST, tweak_row_base...
 #include "params.h"             // for DoubleParam, BoolParam, IntParam
 #include "pdblock.h"            // for PDBLK
@@ -52,6 +57,7 @@
 #include "textord.h"            // for Textord, WordWithBox, WordGrid, WordS...
 #include "tprintf.h"            // for tprintf
 #include "werd.h"               // for WERD_IT, WERD, WERD_LIST, W_DONT_CHOP
+#include <vector>               // for std::vector
 
 struct Box;
 
@@ -64,41 +70,39 @@ CLISTIZE(WordWithBox)
 /**********************************************************************
  * SetBlobStrokeWidth
  *
- * Set the horizontal and vertical stroke widths in the blob.
+ * Set the horizontal and vertical stroke widths in the blob from
+ * dist_pix, the distance function of the whole page, as made by
+ * pixDistanceFunction(pix, 4, 8, L_BOUNDARY_BG), which takes one pass over
+ * the page instead of one per blob.
  **********************************************************************/
-void SetBlobStrokeWidth(Pix* pix, BLOBNBOX* blob) {
-  // Cut the blob rectangle into a Pix.
-  int pix_height = pixGetHeight(pix);
+void SetBlobStrokeWidth(Pix* dist_pix, BLOBNBOX* blob) {
   const TBOX& box = blob->bounding_box();
   int width = box.width();
   int height = box.height();
-  Box* blob_pix_box = boxCreate(box.left(), pix_height - box.top(),
-                                width, height);
-  Pix* pix_blob = pixClipRectangle(pix, blob_pix_box, nullptr);
-  boxDestroy(&blob_pix_box);
-  Pix* dist_pix = pixDistanceFunction(pix_blob, 4, 8, L_BOUNDARY_BG);
-  pixDestroy(&pix_blob);
-  // Compute the stroke widths.
-  uint32_t* data = pixGetData(dist_pix);
+  // The stroke widths are found from the part of dist_pix in the blob box.
   int wpl = pixGetWpl(dist_pix);
+  uint32_t* data = pixGetData(dist_pix) +
+                   (pixGetHeight(dist_pix) - box.top()) * wpl;
+  int left = box.left();
   // Horizontal width of stroke.
   STATS h_stats(0, width + 1);
   for (int y = 0; y < height; ++y) {
     uint32_t* pixels = data + y*wpl;
     int prev_pixel = 0;
-    int pixel = GET_DATA_BYTE(pixels, 0);
+    int pixel = GET_DATA_BYTE(pixels, left);
     for (int x = 1; x < width; ++x) {
-      int next_pixel = GET_DATA_BYTE(pixels, x);
+      int next_pixel = GET_DATA_BYTE(pixels, left + x);
       // We are looking for a pixel that is equal to its vertical neighbours,
       // yet greater than its left neighbour.
       if (prev_pixel < pixel &&
-          (y == 0 || pixel == GET_DATA_BYTE(pixels - wpl, x - 1)) &&
-          (y == height - 1 || pixel == GET_DATA_BYTE(pixels + wpl, x - 1))) {
+          (y == 0 || pixel == GET_DATA_BYTE(pixels - wpl, left + x - 1)) &&
+          (y == height - 1 ||
+           pixel == GET_DATA_BYTE(pixels + wpl, left + x - 1))) {
         if (pixel > next_pixel) {
           // Single local max, so an odd width.
           h_stats.add(pixel * 2 - 1, 1);
         } else if (pixel == next_pixel && x + 1 < width &&
-                 pixel > GET_DATA_BYTE(pixels, x + 1)) {
+                 pixel > GET_DATA_BYTE(pixels, left + x + 1)) {
           // Double local max, so an even width.
           h_stats.add(pixel * 2, 1);
         }
@@ -111,20 +115,21 @@ void SetBlobStrokeWidth(Pix* pix, BLOBNBOX* blob) {
   STATS v_stats(0, height + 1);
   for (int x = 0; x < width; ++x) {
     int prev_pixel = 0;
-    int pixel = GET_DATA_BYTE(data, x);
+    int pixel = GET_DATA_BYTE(data, left + x);
     for (int y = 1; y < height; ++y) {
       uint32_t* pixels = data + y*wpl;
-      int next_pixel = GET_DATA_BYTE(pixels, x);
+      int next_pixel = GET_DATA_BYTE(pixels, left + x);
       // We are looking for a pixel that is equal to its horizontal neighbours,
       // yet greater than its upper neighbour.
       if (prev_pixel < pixel &&
-          (x == 0 || pixel == GET_DATA_BYTE(pixels - wpl, x - 1)) &&
-          (x == width - 1 || pixel == GET_DATA_BYTE(pixels - wpl, x + 1))) {
+          (x == 0 || pixel == GET_DATA_BYTE(pixels - wpl, left + x - 1)) &&
+          (x == width - 1 ||
+           pixel == GET_DATA_BYTE(pixels - wpl, left + x + 1))) {
         if (pixel > next_pixel) {
           // Single local max, so an odd width.
           v_stats.add(pixel * 2 - 1, 1);
         } else if (pixel == next_pixel && y + 1 < height &&
-                 pixel > GET_DATA_BYTE(pixels + wpl, x)) {
+                 pixel > GET_DATA_BYTE(pixels + wpl, left + x)) {
           // Double local max, so an even width.
           v_stats.add(pixel * 2, 1);
         }
@@ -133,7 +138,6 @@ void SetBlobStrokeWidth(Pix* pix, BLOBNBOX* blob) {
       pixel = next_pixel;
     }
   }
-  pixDestroy(&dist_pix);
   // Store the horizontal and vertical width in the blob, keeping both
   // widths if there is enough information, otherwise only the one with
   // the most samples.
@@ -163,11 +167,13 @@ void SetBlobStrokeWidth(Pix* pix, BLOBNBOX* blob) {
  * assign_blobs_to_blocks2
  *
  * Make a list of TO_BLOCKs for portrait and landscape orientation.
+ * The stroke widths of the blobs are set on up to num_threads threads.
  **********************************************************************/
 
 void assign_blobs_to_blocks2(Pix* pix,
                              BLOCK_LIST *blocks,          // blocks to process
-                             TO_BLOCK_LIST *port_blocks) {  // output list
+                             TO_BLOCK_LIST *port_blocks,  // output list
+                             int num_threads) {
   BLOCK *block;                  // current block
   BLOBNBOX *newblob;             // created blob
   C_BLOB *blob;                  // current blob
@@ -177,6 +183,7 @@ void assign_blobs_to_blocks2(Pix* pix,
                                  // destination iterator
   TO_BLOCK_IT port_block_it = port_blocks;
   TO_BLOCK *port_block;          // created block
+  std::vector<BLOBNBOX*> new_blobs;
 
   for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
     block = block_it.data();
@@ -188,7 +195,7 @@ void assign_blobs_to_blocks2(Pix* pix,
     for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
       blob = blob_it.extract();
       newblob = new BLOBNBOX(blob);  // Convert blob to BLOBNBOX.
-      SetBlobStrokeWidth(pix, newblob);
+      new_blobs.push_back(newblob);
       port_box_it.add_after_then_move(newblob);
     }
 
@@ -200,12 +207,27 @@ void assign_blobs_to_blocks2(Pix* pix,
     for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
       blob = blob_it.extract();
       newblob = new BLOBNBOX(blob);  // Convert blob to BLOBNBOX.
-      SetBlobStrokeWidth(pix, newblob);
+      new_blobs.push_back(newblob);
       port_box_it.add_after_then_move(newblob);
     }
 
     port_block_it.add_after_then_move(port_block);
   }
+  if (new_blobs.empty()) return;
+  // Each blob only reads the distance function in its own box, so they can
+  // all be done in parallel.
+  Pix* dist_pix = pixDistanceFunction(pix, 4, 8, L_BOUNDARY_BG);
+  if (dist_pix == nullptr) return;
+  const int num_blobs = new_blobs.size();
+#ifdef _OPENMP
+  num_threads = NumThreads(omp_get_max_threads(), num_threads);
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64) \
+    if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blobs; ++b) {
+    SetBlobStrokeWidth(dist_pix, new_blobs[b]);
+  }
+  pixDestroy(&dist_pix);
 }
 
 /**********************************************************************
@@ -216,6 +238,29 @@ void assign_blobs_to_blocks2(Pix* pix,
  * grades on different lists in the matching TO_BLOCK in to_blocks.
  **********************************************************************/
 
+// Deletes the blobs of the list and their C_BLOBs.
+static void DeleteBlobs(BLOBNBOX_LIST* blobs) {
+  BLOBNBOX_IT blob_it(blobs);
+  for (blob_it.mark_cycle_pt(); !blob_it.cycled_list(); blob_it.forward()) {
+    delete blob_it.data()->cblob();
+    delete blob_it.extract();
+  }
+}
+
+// Returns the number of blobs of all the sizes in the blocks.
+static int CountBlobs(TO_BLOCK_LIST* to_blocks) {
+  int num_blobs = 0;
+  TO_BLOCK_IT to_block_it(to_blocks);
+  for (to_block_it.mark_cycle_pt(); !to_block_it.cycled_list();
+       to_block_it.forward()) {
+    TO_BLOCK* to_block = to_block_it.data();
+    num_blobs += to_block->blobs.length() + to_block->noise_blobs.length() +
+                 to_block->small_blobs.length() +
+                 to_block->large_blobs.length();
+  }
+  return num_blobs;
+}
+
 void Textord::find_components(Pix* pix, BLOCK_LIST *blocks,
                               TO_BLOCK_LIST *to_blocks) {
   int width = pixGetWidth(pix);
@@ -232,13 +277,40 @@ void Textord::find_components(Pix* pix, BLOCK_LIST *blocks,
        block_it.forward()) {
     BLOCK* block = block_it.data();
     if (block->pdblk.poly_block() == nullptr || block->pdblk.poly_block()->IsText()) {
-      extract_edges(pix, block);
+      extract_edges(pix, block, edge_params());
     }
   }
 
-  assign_blobs_to_blocks2(pix, blocks, to_blocks);
+  assign_blobs_to_blocks2(pix, blocks, to_blocks, num_threads_);
   ICOORD page_tr(width, height);
   filter_blobs(page_tr, to_blocks, !textord_test_landscape);
+  int num_blobs = CountBlobs(to_blocks);
+  CountEvent(COUNTER_BLOBS_FOUND, num_blobs);
+  // Halftones and dithered images make a vast number of blobs, on which the
+  // layout analysis takes forever, so they are cut down to the text sized
+  // blobs, or if still too many, the page is left empty.
+  if (textord_max_page_blobs <= 0 || num_blobs <= textord_max_page_blobs)
+    return;
+  TO_BLOCK_IT to_block_it(to_blocks);
+  for (to_block_it.mark_cycle_pt(); !to_block_it.cycled_list();
+       to_block_it.forward()) {
+    TO_BLOCK* to_block = to_block_it.data();
+    DeleteBlobs(&to_block->noise_blobs);
+    DeleteBlobs(&to_block->small_blobs);
+  }
+  int num_kept = CountBlobs(to_blocks);
+  if (num_kept > textord_max_page_blobs) {
+    for (to_block_it.mark_cycle_pt(); !to_block_it.cycled_list();
+         to_block_it.forward()) {
+      TO_BLOCK* to_block = to_block_it.data();
+      DeleteBlobs(&to_block->blobs);
+      DeleteBlobs(&to_block->large_blobs);
+    }
+    num_kept = 0;
+  }
+  tprintf("Warning: %d blobs on the page > textord_max_page_blobs=%d,"
+          " kept %d\n", num_blobs, static_cast<int>(textord_max_page_blobs),
+          num_kept);
 }
 
 /**********************************************************************
@@ -29,9 +29,9 @@ struct Pix;
 namespace tesseract {
 class Tesseract;
 
-void SetBlobStrokeWidth(Pix* pix, BLOBNBOX* blob);
+void SetBlobStrokeWidth(Pix* dist_pix, BLOBNBOX* blob);
 void assign_blobs_to_blocks2(Pix* pix, BLOCK_LIST *blocks,
-                             TO_BLOCK_LIST *port_blocks);
+                             TO_BLOCK_LIST *port_blocks, int num_threads = 0);
 }  // namespace tesseract
 
 void tweak_row_baseline(ROW *row,
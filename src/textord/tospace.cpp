@@ -37,6 +37,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 #define MAXSPACING      128      /*max expected spacing in pix */
 
@@ -46,21 +47,25 @@ void Textord::to_spacing(
     TO_BLOCK_LIST *blocks  //blocks on page
                          ) {
   TO_BLOCK_IT block_it;          //iterator
-  TO_BLOCK *block;               //current block;
-  TO_ROW *row;                   //current row
-  int block_index;               //block number
-  int row_index;                 //row number
-  //estimated width of real spaces for whole block
-  int16_t block_space_gap_width;
-  //estimated width of non space gaps for whole block
-  int16_t block_non_space_gap_width;
-  bool old_text_ord_proportional;//old fixed/prop result
+  std::vector<TO_BLOCK*> to_blocks;
 
   block_it.set_to_list (blocks);
-  block_index = 1;
   for (block_it.mark_cycle_pt (); !block_it.cycled_list ();
-  block_it.forward ()) {
-    block = block_it.data ();
+  block_it.forward ())
+    to_blocks.push_back(block_it.data());
+  const int num_blocks = to_blocks.size();
+  const int num_threads = block_loop_threads(num_threads_);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blocks; ++b) {
+    TO_BLOCK* block = to_blocks[b];
+    int block_index = b + 1;     //block number
+    //estimated width of real spaces for whole block
+    int16_t block_space_gap_width;
+    //estimated width of non space gaps for whole block
+    int16_t block_non_space_gap_width;
+    bool old_text_ord_proportional;//old fixed/prop result
     std::unique_ptr<GAPMAP> gapmap(new GAPMAP (block)); //map of big vert gaps in blk
     block_spacing_stats(block,
                         gapmap.get(),
@@ -79,9 +84,9 @@ void Textord::to_spacing(
     }
     // row iterator
     TO_ROW_IT row_it(block->get_rows());
-    row_index = 1;
+    int row_index = 1;           //row number
     for (row_it.mark_cycle_pt (); !row_it.cycled_list (); row_it.forward ()) {
-      row = row_it.data ();
+      TO_ROW* row = row_it.data ();
       if ((row->pitch_decision == PITCH_DEF_PROP) ||
       (row->pitch_decision == PITCH_CORR_PROP)) {
         if ((tosp_debug_level > 0) && !old_text_ord_proportional)
@@ -107,7 +112,6 @@ void Textord::to_spacing(
 #endif
       row_index++;
     }
-    block_index++;
   }
 }
 
@@ -16,6 +16,7 @@
  *
  **********************************************************************/
 
+#include <vector>       // for std::vector
 #include "blobbox.h"
 #include "statistc.h"
 #include "drawtord.h"
@@ -99,20 +100,25 @@ void make_words(tesseract::Textord *textord,
                 BLOCK_LIST *blocks,            // block list
                 TO_BLOCK_LIST *port_blocks) {  // output list
   TO_BLOCK_IT block_it;          // iterator
-  TO_BLOCK *block;               // current block
+  std::vector<TO_BLOCK*> to_blocks;
 
   if (textord->use_cjk_fp_model()) {
     compute_fixed_pitch_cjk(page_tr, port_blocks);
   } else {
     compute_fixed_pitch(page_tr, port_blocks, gradient, FCOORD(0.0f, -1.0f),
-                        !bool(textord_test_landscape));
+                        !bool(textord_test_landscape), textord->num_threads());
   }
   textord->to_spacing(page_tr, port_blocks);
   block_it.set_to_list(port_blocks);
-  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward()) {
-    block = block_it.data();
-    make_real_words(textord, block, FCOORD(1.0f, 0.0f));
-  }
+  for (block_it.mark_cycle_pt(); !block_it.cycled_list(); block_it.forward())
+    to_blocks.push_back(block_it.data());
+  const int num_blocks = to_blocks.size();
+  const int num_threads = block_loop_threads(textord->num_threads());
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic) if (num_threads > 1)
+#endif  // _OPENMP
+  for (int b = 0; b < num_blocks; ++b)
+    make_real_words(textord, to_blocks[b], FCOORD(1.0f, 0.0f));
 }
 
 
@@ -186,7 +192,7 @@ int32_t row_words(                  //compute space size
   ICOORD testpt;
   TBOX blob_box;                  //bounding box
                                  //iterator
-  BLOBNBOX_IT blob_it = row->blob_list ();
+  std::vector<BLOBNBOX*> blobs; //frozen in x order
   STATS gap_stats (0, maxwidth);
   STATS cluster_stats[4];        //clusters
 
@@ -198,16 +204,16 @@ int32_t row_words(                  //compute space size
   prev_valid = false;
   prev_x = -INT32_MAX;
   testing_row = false;
-  for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
-    blob = blob_it.data ();
-    blob_box = blob->bounding_box ();
+  freeze_blobs_in_x(row->blob_list(), false, &blobs);
+  for (BLOBNBOX* frozen_blob : blobs) {
+    blob_box = frozen_blob->bounding_box ();
     if (blob_box.contains (testpt))
       testing_row = true;
     gap_stats.add (blob_box.width (), 1);
   }
   gap_stats.clear ();
-  for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
-    blob = blob_it.data ();
+  for (BLOBNBOX* frozen_blob : blobs) {
+    blob = frozen_blob;
     if (!blob->joined_to_prev ()) {
       blob_box = blob->bounding_box ();
       if (prev_valid && blob_box.left () - prev_x < maxwidth) {
@@ -356,7 +362,7 @@ int32_t row_words2(                  //compute space size
   ICOORD testpt;
   TBOX blob_box;                  //bounding box
                                  //iterator
-  BLOBNBOX_IT blob_it = row->blob_list ();
+  std::vector<BLOBNBOX*> blobs; //frozen in x order
   STATS gap_stats (0, maxwidth);
                                  //gap sizes
   float gaps[BLOCK_STATS_CLUSTERS];
@@ -374,8 +380,9 @@ int32_t row_words2(                  //compute space size
                                  //min blob size
   min_width = static_cast<int32_t>(block->pr_space);
   total_count = 0;
-  for (blob_it.mark_cycle_pt (); !blob_it.cycled_list (); blob_it.forward ()) {
-    blob = blob_it.data ();
+  freeze_blobs_in_x(row->blob_list(), false, &blobs);
+  for (BLOBNBOX* frozen_blob : blobs) {
+    blob = frozen_blob;
     if (!blob->joined_to_prev ()) {
       blob_box = blob->bounding_box ();
       this_valid = blob_box.width () >= min_width;
@@ -392,9 +399,8 @@ int32_t row_words2(                  //compute space size
   if (valid_count < total_count * textord_words_minlarge) {
     gap_stats.clear ();
     prev_x = -INT16_MAX;
-    for (blob_it.mark_cycle_pt (); !blob_it.cycled_list ();
-    blob_it.forward ()) {
-      blob = blob_it.data ();
+    for (BLOBNBOX* frozen_blob : blobs) {
+      blob = frozen_blob;
       if (!blob->joined_to_prev ()) {
         blob_box = blob->bounding_box ();
         if (blob_box.left () - prev_x < maxwidth) {
@@ -32,6 +32,10 @@
 static STRING_PARAM_FLAG(classifier, "", "Classifier to test");
 static STRING_PARAM_FLAG(lang, "eng", "Language to test");
 static STRING_PARAM_FLAG(tessdata_dir, "", "Directory of traineddata files");
+static INT_PARAM_FLAG(eval_threads, 1,
+                      "Number of threads to classify samples on concurrently.");
+static INT_PARAM_FLAG(sample_stride, 1,
+                      "Test only every nth sample, for quick checks.");
 
 enum ClassifierName {
   CN_PRUNER,
@@ -107,19 +111,33 @@ static tesseract::ShapeClassifier* InitializeClassifier(
 // pruner   : Tesseract class pruner only.
 // full     : Tesseract full classifier.
 //            with an input trainer.)
+//
+// With -eval_threads n, the samples are classified on n threads, each with its
+// own instance of the classifier, and -sample_stride n tests only every nth
+// sample for a quick estimate, eg while tuning shapeclustering.
 int main(int argc, char **argv) {
   tesseract::CheckSharedLibraryVersion();
   ParseArguments(&argc, &argv);
   STRING file_prefix;
   tesseract::MasterTrainer* trainer =
       tesseract::LoadTrainingData(argc, argv, false, nullptr, &file_prefix);
-  tesseract::TessBaseAPI* api;
-  // Decode the classifier string.
-  tesseract::ShapeClassifier* shape_classifier = InitializeClassifier(
-      FLAGS_classifier.c_str(), trainer->unicharset(), argc, argv, &api);
-  if (shape_classifier == nullptr) {
-    fprintf(stderr, "Classifier init failed!:%s\n", FLAGS_classifier.c_str());
-    return 1;
+  // Each thread needs its own classifier, as a classifier keeps scratch
+  // state in its Tesseract instance.
+  int num_threads = std::max(1, static_cast<int>(FLAGS_eval_threads));
+  GenericVector<tesseract::TessBaseAPI*> apis;
+  GenericVector<tesseract::ShapeClassifier*> shape_classifiers;
+  for (int t = 0; t < num_threads; ++t) {
+    tesseract::TessBaseAPI* api = nullptr;
+    // Decode the classifier string.
+    tesseract::ShapeClassifier* shape_classifier = InitializeClassifier(
+        FLAGS_classifier.c_str(), trainer->unicharset(), argc, argv, &api);
+    apis.push_back(api);
+    if (shape_classifier == nullptr) {
+      fprintf(stderr, "Classifier init failed!:%s\n",
+              FLAGS_classifier.c_str());
+      return 1;
+    }
+    shape_classifiers.push_back(shape_classifier);
   }
 
   // We want to test junk as well if it is available.
@@ -127,11 +145,12 @@ int main(int argc, char **argv) {
   // We want to test with replicated samples too.
   trainer->ReplicateAndRandomizeSamplesIfRequired();
 
-  trainer->TestClassifierOnSamples(tesseract::CT_UNICHAR_TOP1_ERR,
-                                   std::max(3, static_cast<int>(FLAGS_debug_level)), false,
-                                   shape_classifier, nullptr);
-  delete shape_classifier;
-  delete api;
+  trainer->TestClassifiersOnSamples(tesseract::CT_UNICHAR_TOP1_ERR,
+                                    std::max(3, static_cast<int>(FLAGS_debug_level)), false,
+                                    shape_classifiers, FLAGS_sample_stride,
+                                    nullptr);
+  shape_classifiers.delete_data_pointers();
+  apis.delete_data_pointers();
   delete trainer;
 
   return 0;
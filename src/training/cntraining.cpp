@@ -25,9 +25,15 @@
 #include "ocrfeatures.h"
 #include "clusttool.h"
 #include "cluster.h"
+#include <atomic>
 #include <cstring>
 #include <cstdio>
 #include <cmath>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+#include "numthreads.h"
 #include "unichar.h"
 #include "commontraining.h"
 
@@ -109,11 +115,8 @@ int main(int argc, char *argv[]) {
 
   const char  *PageName;
   LIST  CharList = NIL_LIST;
-  CLUSTERER *Clusterer = nullptr;
-  LIST    ProtoList = NIL_LIST;
   LIST    NormProtoList = NIL_LIST;
   LIST pCharList;
-  LABELEDLIST CharSample;
   FEATURE_DEFS_STRUCT FeatureDefs;
   InitFeatureDefs(&FeatureDefs);
 
@@ -138,36 +141,58 @@ int main(int argc, char *argv[]) {
   // The norm protos will count the source protos, so we keep them here in
   // freeable_protos, so they can be freed later.
   GenericVector<LIST> freeable_protos;
+  // The classes are clustered in parallel, each with its own copy of Config,
+  // and their protos are added to NormProtoList in the order of CharList, so
+  // the output doesn't depend on the number of threads.
+  std::vector<LABELEDLIST> char_samples;
   iterate(pCharList) {
+    char_samples.push_back(reinterpret_cast<LABELEDLIST>first_node(pCharList));
+  }
+  int num_chars = char_samples.size();
+  std::vector<LIST> proto_lists(num_chars, NIL_LIST);
+  std::atomic<bool> clusterer_failed(false);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(tesseract::NumThreads(omp_get_max_threads())) \
+    schedule(dynamic)
+#endif  // _OPENMP
+  for (int c = 0; c < num_chars; ++c) {
     //Cluster
-    CharSample = reinterpret_cast<LABELEDLIST>first_node(pCharList);
-    Clusterer =
+    LABELEDLIST CharSample = char_samples[c];
+    CLUSTERER* Clusterer =
       SetUpForClustering(FeatureDefs, CharSample, PROGRAM_FEATURE_TYPE);
     if (Clusterer == nullptr) {  // To avoid a SIGSEGV
-      fprintf(stderr, "Error: nullptr clusterer!\n");
-      return 1;
+      clusterer_failed = true;
+      continue;
     }
-    float SavedMinSamples = Config.MinSamples;
+    CLUSTERCONFIG config = Config;
     // To disable the tendency to produce a single cluster for all fonts,
     // make MagicSamples an impossible to achieve number:
-    // Config.MagicSamples = CharSample->SampleCount * 10;
-    Config.MagicSamples = CharSample->SampleCount;
-    while (Config.MinSamples > 0.001) {
-      ProtoList = ClusterSamples(Clusterer, &Config);
+    // config.MagicSamples = CharSample->SampleCount * 10;
+    config.MagicSamples = CharSample->SampleCount;
+    LIST ProtoList = NIL_LIST;
+    while (config.MinSamples > 0.001) {
+      ProtoList = ClusterSamples(Clusterer, &config);
       if (NumberOfProtos(ProtoList, true, false) > 0) {
         break;
       } else {
-        Config.MinSamples *= 0.95;
+        config.MinSamples *= 0.95;
         printf("0 significant protos for %s."
                " Retrying clustering with MinSamples = %f%%\n",
-               CharSample->Label, Config.MinSamples);
+               CharSample->Label, config.MinSamples);
       }
     }
-    Config.MinSamples = SavedMinSamples;
-    AddToNormProtosList(&NormProtoList, ProtoList, CharSample->Label);
-    freeable_protos.push_back(ProtoList);
+    proto_lists[c] = ProtoList;
     FreeClusterer(Clusterer);
   }
+  if (clusterer_failed) {
+    fprintf(stderr, "Error: nullptr clusterer!\n");
+    return 1;
+  }
+  for (int c = 0; c < num_chars; ++c) {
+    AddToNormProtosList(&NormProtoList, proto_lists[c],
+                        char_samples[c]->Label);
+    freeable_protos.push_back(proto_lists[c]);
+  }
   FreeTrainingSamples(CharList);
   int desc_index = ShortNameToFeatureType(FeatureDefs, PROGRAM_FEATURE_TYPE);
   WriteNormProtos(FLAGS_D.c_str(), NormProtoList,
@@ -66,6 +66,25 @@
 // This will create  /home/$USER/temp/eng.* files with individual tessdata
 // components from tessdata/eng.traineddata.
 //
+// Specify option -c to convert the LSTM component to int. An optional file
+// listing lstmf files gives lines on which the ranges of the int activations
+// are calibrated:
+//
+// combine_tessdata -c tessdata/eng.traineddata eng.calibration_files.txt
+//
+// Specify option -f to store the float weights of the LSTM component as half
+// precision, for a smaller file that is still accurate for recognition. Any
+// training data in the LSTM component is removed, as it is not needed for
+// recognition and would keep the weights in full precision:
+//
+// combine_tessdata -f tessdata/eng.traineddata
+//
+
+// Max number of lines used to calibrate the int ranges.
+const int kCalibrationLines = 1000;
+// Max memory for the calibration lines.
+const int64_t kCalibrationMemory = 1024 * 1048576LL;
+
 int main(int argc, char **argv) {
   tesseract::CheckSharedLibraryVersion();
 
@@ -144,7 +163,9 @@ int main(int argc, char **argv) {
 
     // Write the updated traineddata file.
     tm.OverwriteComponents(new_traineddata_filename, argv+3, argc-3);
-  } else if (argc == 3 && strcmp(argv[1], "-c") == 0) {
+  } else if (((argc == 3 || argc == 4) && strcmp(argv[1], "-c") == 0) ||
+             (argc == 3 && strcmp(argv[1], "-f") == 0)) {
+    bool to_half = strcmp(argv[1], "-f") == 0;
     if (!tm.Init(argv[2])) {
       tprintf("Failed to read %s\n", argv[2]);
       return EXIT_FAILURE;
@@ -159,12 +180,40 @@ int main(int argc, char **argv) {
       tprintf("Failed to deserialize LSTM in %s!\n", argv[2]);
       return EXIT_FAILURE;
     }
-    recognizer.ConvertToInt();
+    if (to_half && recognizer.IsIntMode()) {
+      tprintf("LSTM in %s is already int, so has no float weights!\n",
+              argv[2]);
+      return EXIT_FAILURE;
+    }
+    if (to_half && recognizer.HasTrainingData()) {
+      // Weights are only written as half precision without training data.
+      tprintf("Removing the training data from the LSTM in %s\n", argv[2]);
+      recognizer.StripTrainingData();
+    }
+    if (argc == 4) {
+      // Calibrate the int ranges of the activations on the listed lines.
+      GenericVector<STRING> filenames;
+      if (!tesseract::LoadFileLinesToStrings(argv[3], &filenames)) {
+        tprintf("Failed to load list of calibration files from %s\n",
+                argv[3]);
+        return EXIT_FAILURE;
+      }
+      tesseract::DocumentCache calibration_data(kCalibrationMemory);
+      if (!calibration_data.LoadDocuments(filenames, tesseract::CS_SEQUENTIAL,
+                                          nullptr)) {
+        tprintf("Failed to load calibration data from %s\n", argv[3]);
+        return EXIT_FAILURE;
+      }
+      int num_lines =
+          recognizer.CalibrateIntRanges(&calibration_data, kCalibrationLines);
+      tprintf("Calibrated int ranges on %d lines\n", num_lines);
+    }
+    if (!to_half) recognizer.ConvertToInt();
     GenericVector<char> lstm_data;
     fp.OpenWrite(&lstm_data);
+    fp.set_half_precision(to_half);
     ASSERT_HOST(recognizer.Serialize(&tm, &fp));
-    tm.OverwriteEntry(tesseract::TESSDATA_LSTM, &lstm_data[0],
-                      lstm_data.size());
+    tm.OverwriteEntry(tesseract::TESSDATA_LSTM, &lstm_data);
     if (!tm.SaveFile(argv[2], nullptr)) {
       tprintf("Failed to write modified traineddata:%s!\n", argv[2]);
       return EXIT_FAILURE;
@@ -193,7 +242,13 @@ int main(int argc, char **argv) {
         argv[0]);
     printf(
         "Usage for compacting LSTM component to int:\n"
-        "  %s -c traineddata_file\n",
+        "  %s -c traineddata_file [calibration_listfile]\n"
+        "  (the optional file lists lstmf files of lines to calibrate the\n"
+        "  ranges of the int activations)\n",
+        argv[0]);
+    printf(
+        "Usage for compacting LSTM component to half precision float:\n"
+        "  %s -f traineddata_file\n",
         argv[0]);
     return 1;
   }
@@ -22,9 +22,8 @@ namespace tesseract {
 static bool IntFlagExists(const char* flag_name, int32_t* value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<IntParam*> empty;
   IntParam *p = ParamUtils::FindParam<IntParam>(
-      full_flag_name.string(), GlobalParams()->int_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   if (p == nullptr) return false;
   *value = (int32_t)(*p);
   return true;
@@ -33,9 +32,8 @@ static bool IntFlagExists(const char* flag_name, int32_t* value) {
 static bool DoubleFlagExists(const char* flag_name, double* value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<DoubleParam*> empty;
   DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      full_flag_name.string(), GlobalParams()->double_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   if (p == nullptr) return false;
   *value = static_cast<double>(*p);
   return true;
@@ -44,9 +42,8 @@ static bool DoubleFlagExists(const char* flag_name, double* value) {
 static bool BoolFlagExists(const char* flag_name, bool* value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<BoolParam*> empty;
   BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      full_flag_name.string(), GlobalParams()->bool_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   if (p == nullptr) return false;
   *value = bool(*p);
   return true;
@@ -55,9 +52,8 @@ static bool BoolFlagExists(const char* flag_name, bool* value) {
 static bool StringFlagExists(const char* flag_name, const char** value) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<StringParam*> empty;
   StringParam *p = ParamUtils::FindParam<StringParam>(
-      full_flag_name.string(), GlobalParams()->string_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   *value = (p != nullptr) ? p->string() : nullptr;
   return p != nullptr;
 }
@@ -65,9 +61,8 @@ static bool StringFlagExists(const char* flag_name, const char** value) {
 static void SetIntFlagValue(const char* flag_name, const int32_t new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<IntParam*> empty;
   IntParam *p = ParamUtils::FindParam<IntParam>(
-      full_flag_name.string(), GlobalParams()->int_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -75,9 +70,8 @@ static void SetIntFlagValue(const char* flag_name, const int32_t new_val) {
 static void SetDoubleFlagValue(const char* flag_name, const double new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<DoubleParam*> empty;
   DoubleParam *p = ParamUtils::FindParam<DoubleParam>(
-      full_flag_name.string(), GlobalParams()->double_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -85,9 +79,8 @@ static void SetDoubleFlagValue(const char* flag_name, const double new_val) {
 static void SetBoolFlagValue(const char* flag_name, const bool new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<BoolParam*> empty;
   BoolParam *p = ParamUtils::FindParam<BoolParam>(
-      full_flag_name.string(), GlobalParams()->bool_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(new_val);
 }
@@ -95,9 +88,8 @@ static void SetBoolFlagValue(const char* flag_name, const bool new_val) {
 static void SetStringFlagValue(const char* flag_name, const char* new_val) {
   STRING full_flag_name("FLAGS_");
   full_flag_name += flag_name;
-  GenericVector<StringParam*> empty;
   StringParam *p = ParamUtils::FindParam<StringParam>(
-      full_flag_name.string(), GlobalParams()->string_params, empty);
+      full_flag_name.string(), GlobalParams(), nullptr);
   ASSERT_HOST(p != nullptr);
   p->set_value(STRING(new_val));
 }
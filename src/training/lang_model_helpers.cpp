@@ -129,15 +129,20 @@ static bool WriteDawg(const GenericVector<STRING>& words,
                       TessdataType file_type, TessdataManager* traineddata) {
   // The first 3 arguments are not used in this case.
   Trie trie(DAWG_TYPE_WORD, "", SYSTEM_DAWG_PERM, unicharset.size(), 0);
-  trie.add_word_list(words, unicharset, reverse_policy);
-  tprintf("Reducing Trie to SquishedDawg\n");
-  std::unique_ptr<SquishedDawg> dawg(trie.trie_to_dawg());
+  // Sorted word lists are built in a single pass, without a trie.
+  std::unique_ptr<SquishedDawg> dawg(
+      trie.sorted_word_list_to_dawg(words, unicharset, reverse_policy));
+  if (dawg == nullptr) {
+    trie.add_word_list(words, unicharset, reverse_policy);
+    tprintf("Reducing Trie to SquishedDawg\n");
+    dawg.reset(trie.trie_to_dawg());
+  }
   if (dawg == nullptr || dawg->NumEdges() == 0) return false;
   TFile fp;
   GenericVector<char> dawg_data;
   fp.OpenWrite(&dawg_data);
   if (!dawg->write_squished_dawg(&fp)) return false;
-  traineddata->OverwriteEntry(file_type, &dawg_data[0], dawg_data.size());
+  traineddata->OverwriteEntry(file_type, &dawg_data);
   return true;
 }
 
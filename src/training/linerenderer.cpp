@@ -0,0 +1,217 @@
+/**********************************************************************
+ * File:        linerenderer.cpp
+ * Description: Renders text to degraded text line images with their boxes
+ *              and transcriptions, ready for LSTM training.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **********************************************************************/
+
+#include "linerenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "allheaders.h"  // from leptonica
+#include "boxread.h"
+#include "degradeimage.h"
+#include "pango_font_info.h"
+#include "rect.h"
+#include "tprintf.h"
+
+namespace tesseract {
+
+// Returns the Pango font description of font_name at the size in options.
+static std::string FontDescription(const std::string& font_name,
+                                   const LineRenderOptions& options) {
+  return font_name + " " + std::to_string(options.ptsize);
+}
+
+LineRenderer::LineRenderer(const std::string& font_name,
+                           const LineRenderOptions& options)
+    : options_(options),
+      render_(FontDescription(font_name, options), options.xsize,
+              options.ysize) {
+  render_.set_add_ligatures(options_.ligatures);
+  render_.set_leading(options_.leading);
+  render_.set_resolution(options_.resolution);
+  render_.set_char_spacing(options_.char_spacing * options_.ptsize);
+  render_.set_h_margin(options_.margin);
+  render_.set_v_margin(options_.margin);
+  render_.set_strip_unrenderable_words(options_.strip_unrenderable_words);
+  randomizer_.set_seed(options_.seed);
+}
+
+// Renders all of utf8_text, adding its text lines to lines, named as if they
+// came from image_name. Returns the number of lines added.
+int LineRenderer::RenderText(const std::string& utf8_text,
+                             const std::string& image_name,
+                             DocumentData* lines) {
+  int num_lines = 0;
+  const char* text = utf8_text.c_str();
+  int text_length = utf8_text.size();
+  for (int offset = 0, page = 0;
+       offset < text_length &&
+       (options_.max_pages == 0 || page < options_.max_pages);
+       ++page) {
+    Pix* pix = nullptr;
+    int consumed =
+        render_.RenderToImage(text + offset, text_length - offset, &pix);
+    // Nothing rendered means nothing ever will be, so stop rather than loop.
+    if (consumed <= 0) {
+      pixDestroy(&pix);
+      break;
+    }
+    offset += consumed;
+    if (pix == nullptr) continue;
+    float rotation = 0.0f;
+    if (options_.degrade_image) {
+      pix = DegradeImage(pix, options_.exposure, &randomizer_,
+                         options_.rotate_image ? &rotation : nullptr);
+    }
+    if (options_.distort_image) {
+      Pix* distorted = PrepareDistortedPix(
+          pix, false, options_.invert, options_.white_noise,
+          options_.smooth_noise, options_.blur, 1, &randomizer_, nullptr);
+      if (distorted != nullptr) {
+        pixDestroy(&pix);
+        pix = distorted;
+      }
+    }
+    render_.RotatePageBoxes(rotation);
+    Pix* gray_pix = pixConvertTo8(pix, false);
+    pixDestroy(&pix);
+    Pix* binary = pixThresholdToBinary(gray_pix, 128);
+    pixDestroy(&gray_pix);
+    // The boxes of each page are used up as soon as it is rendered.
+    num_lines += AddPageLines(binary, image_name, page, render_.GetBoxesStr(),
+                              lines);
+    render_.ClearBoxes();
+    pixDestroy(&binary);
+  }
+  return num_lines;
+}
+
+// Cuts the text lines of a rendered page out of pix, using the boxes of the
+// page in box_str, and adds them to lines, in the same way as lstm.train does
+// from a tif and a box file. Returns the number of lines added.
+int LineRenderer::AddPageLines(Pix* pix, const std::string& image_name,
+                               int page_number, const std::string& box_str,
+                               DocumentData* lines) {
+  GenericVector<TBOX> boxes;
+  GenericVector<STRING> texts;
+  if (!ReadMemBoxes(-1, false, box_str.c_str(), false, &boxes, &texts,
+                    nullptr, nullptr)) {
+    return 0;
+  }
+  int num_lines = 0;
+  int height = pixGetHeight(pix);
+  TBOX image_box(0, 0, pixGetWidth(pix), height);
+  int box_count = boxes.size();
+  // Process all the text lines, as separated by \t boxes.
+  int end_box = 0;
+  while (end_box < box_count && texts[end_box] == "\t") ++end_box;
+  for (int start_box = end_box; start_box < box_count; start_box = end_box) {
+    TBOX line_box = boxes[start_box];
+    for (end_box = start_box + 1;
+         end_box < box_count && texts[end_box] != "\t"; ++end_box) {
+      line_box += boxes[end_box];
+    }
+    line_box.pad(kImagePadding, kImagePadding);
+    line_box &= image_box;
+    if (!line_box.null_box()) {
+      Box* clip_box = boxCreate(line_box.left(), height - line_box.top(),
+                                line_box.width(), line_box.height());
+      Pix* line_pix = pixClipRectangle(pix, clip_box, nullptr);
+      boxDestroy(&clip_box);
+      if (line_pix != nullptr) {
+        auto* line = new ImageData(false, line_pix);
+        line->set_imagefilename(image_name.c_str());
+        line->set_page_number(page_number);
+        // Copy the boxes and shift them so they are relative to the line.
+        ICOORD shift = -line_box.botleft();
+        GenericVector<TBOX> line_boxes;
+        GenericVector<STRING> line_texts;
+        for (int b = start_box; b < end_box; ++b) {
+          TBOX box = boxes[b];
+          box.move(shift);
+          line_boxes.push_back(box);
+          line_texts.push_back(texts[b]);
+        }
+        GenericVector<int> page_numbers;
+        page_numbers.init_to_size(line_boxes.size(), page_number);
+        line->AddBoxes(line_boxes, line_texts, page_numbers);
+        lines->AddPageToDocument(line);
+        ++num_lines;
+      }
+    }
+    while (end_box < box_count && texts[end_box] == "\t") ++end_box;
+  }
+  return num_lines;
+}
+
+// Checks that the font with the given description name is available, and if
+// it is only available with the trailing comma that Pango adds to some names,
+// adds the comma. Returns false with an explanation if there is no such font.
+bool LineRenderer::FindFont(std::string* font_name) {
+  if (FontUtils::IsAvailableFont(font_name->c_str())) return true;
+  std::string comma_name = *font_name + ',';
+  std::string pango_name;
+  if (!FontUtils::IsAvailableFont(comma_name.c_str(), &pango_name)) {
+    tprintf("Could not find font named '%s'.\n", font_name->c_str());
+    if (!pango_name.empty()) {
+      tprintf("Pango suggested font '%s'.\n", pango_name.c_str());
+    }
+    return false;
+  }
+  *font_name = comma_name;
+  return true;
+}
+
+// Renders utf8_text with each of the given fonts, on up to num_threads
+// threads, into one serialized DocumentData per font. Each thread has its own
+// LineRenderer, while all of them share the font configuration, which must be
+// set up before the threads start. Returns false if any font gave no lines.
+bool LineRenderer::RenderFonts(const std::string& utf8_text,
+                               const std::vector<std::string>& font_names,
+                               const LineRenderOptions& options,
+                               int num_threads,
+                               std::vector<GenericVector<char>>* documents) {
+  int num_fonts = font_names.size();
+  documents->clear();
+  documents->resize(num_fonts);
+  std::atomic<int> next_font(0);
+  std::atomic<int> num_failed(0);
+  auto render_fonts = [&]() {
+    for (int f = next_font++; f < num_fonts; f = next_font++) {
+      LineRenderer renderer(font_names[f], options);
+      DocumentData lines(font_names[f].c_str());
+      int num_lines = renderer.RenderText(utf8_text, font_names[f], &lines);
+      if (num_lines == 0 || !lines.SaveToBuffer(&(*documents)[f])) {
+        tprintf("Failed to render any lines with font %s\n",
+                font_names[f].c_str());
+        ++num_failed;
+      } else {
+        tprintf("Rendered %d lines with font %s\n", num_lines,
+                font_names[f].c_str());
+      }
+    }
+  };
+  num_threads = ClipToRange<int>(num_threads, 1, std::max(num_fonts, 1));
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) threads.emplace_back(render_fonts);
+  render_fonts();
+  for (auto& thread : threads) thread.join();
+  return num_failed == 0;
+}
+
+}  // namespace tesseract
@@ -0,0 +1,109 @@
+/**********************************************************************
+ * File:        linerenderer.h
+ * Description: Renders text to degraded text line images with their boxes
+ *              and transcriptions, ready for LSTM training.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **********************************************************************/
+#ifndef TESSERACT_TRAINING_LINERENDERER_H_
+#define TESSERACT_TRAINING_LINERENDERER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "genericvector.h"
+#include "helpers.h"  // For TRand.
+#include "imagedata.h"
+#include "stringrenderer.h"
+
+struct Pix;
+
+namespace tesseract {
+
+// The settings of a LineRenderer, with the same meaning and defaults as the
+// text2image flags of the same names.
+struct LineRenderOptions {
+  int ptsize = 12;
+  int xsize = 3600;
+  int ysize = 4800;
+  int margin = 100;
+  int leading = 12;
+  int resolution = 300;
+  // Inter-character space in ems.
+  double char_spacing = 0.0;
+  bool ligatures = false;
+  bool strip_unrenderable_words = true;
+  bool degrade_image = true;
+  int exposure = 0;
+  bool rotate_image = true;
+  bool distort_image = false;
+  bool invert = true;
+  bool white_noise = true;
+  bool smooth_noise = true;
+  bool blur = true;
+  // Maximum number of pages to render, or 0 for no limit.
+  int max_pages = 0;
+  // Seed for the random degradation, so that the output is repeatable.
+  uint64_t seed = 0x1234567;
+};
+
+// Renders text with a single font the way text2image does, degrades the pages
+// and cuts them into text lines, each an ImageData with its boxes and
+// transcription, which is what lstm.train makes from a tif and a box file.
+// The lines go straight into a DocumentData, so synthetic training data can be
+// written to an lstmf file, or handed to the trainer, without any intermediate
+// image or box files.
+// A LineRenderer is not thread-safe, but several of them, each on its own
+// thread, may render at the same time.
+class LineRenderer {
+ public:
+  // The font_name is a Pango font description name without the size, which
+  // comes from the options.
+  LineRenderer(const std::string& font_name, const LineRenderOptions& options);
+
+  // Renders all of utf8_text, adding its text lines to lines, named as if they
+  // came from image_name. Returns the number of lines added.
+  int RenderText(const std::string& utf8_text, const std::string& image_name,
+                 DocumentData* lines);
+
+  // Cuts the text lines of a rendered page out of pix, using the boxes of the
+  // page in box_str, in which the lines are separated by tab boxes, and adds
+  // them to lines. Returns the number of lines added.
+  static int AddPageLines(Pix* pix, const std::string& image_name,
+                          int page_number, const std::string& box_str,
+                          DocumentData* lines);
+
+  // Checks that the font with the given description name is available, and if
+  // it is only available with the trailing comma that Pango adds to some
+  // names, adds the comma. Returns false with an explanation if there is no
+  // such font.
+  static bool FindFont(std::string* font_name);
+
+  // Renders utf8_text with each of the given fonts, on up to num_threads
+  // threads, into documents, one serialized DocumentData per font, in the
+  // order of font_names. The font configuration must have been set up, and
+  // the fonts found, before calling. Returns false if any font gave no lines.
+  static bool RenderFonts(const std::string& utf8_text,
+                          const std::vector<std::string>& font_names,
+                          const LineRenderOptions& options, int num_threads,
+                          std::vector<GenericVector<char>>* documents);
+
+ private:
+  LineRenderOptions options_;
+  StringRenderer render_;
+  TRand randomizer_;
+};
+
+}  // namespace tesseract
+
+#endif  // TESSERACT_TRAINING_LINERENDERER_H_
@@ -20,6 +20,7 @@
 #endif
 #include "commontraining.h"
 #include "genericvector.h"
+#include "layerprofile.h"
 #include "lstmtester.h"
 #include "strngs.h"
 #include "tprintf.h"
@@ -33,6 +34,11 @@ static STRING_PARAM_FLAG(eval_listfile, "",
 static INT_PARAM_FLAG(max_image_MB, 2000, "Max memory to use for images.");
 static INT_PARAM_FLAG(verbosity, 1,
                       "Amount of diagnosting information to output (0-2).");
+static INT_PARAM_FLAG(eval_threads, 1,
+                      "Number of threads to evaluate lines on concurrently.");
+static BOOL_PARAM_FLAG(profile_layers, false,
+                       "Print the time and operations of each layer of the "
+                       "network.");
 
 int main(int argc, char **argv) {
   tesseract::CheckSharedLibraryVersion();
@@ -63,8 +69,7 @@ int main(int argc, char **argv) {
       tprintf("Failed to load model from: %s\n", FLAGS_model.c_str());
       return 1;
     }
-    mgr.OverwriteEntry(tesseract::TESSDATA_LSTM, &model_data[0],
-                       model_data.size());
+    mgr.OverwriteEntry(tesseract::TESSDATA_LSTM, &model_data);
   }
   tesseract::LSTMTester tester(static_cast<int64_t>(FLAGS_max_image_MB) *
                                1048576);
@@ -72,10 +77,18 @@ int main(int argc, char **argv) {
     tprintf("Failed to load eval data from: %s\n", FLAGS_eval_listfile.c_str());
     return 1;
   }
+  tester.SetNumThreads(FLAGS_eval_threads);
   double errs = 0.0;
+  if (FLAGS_profile_layers) tesseract::LayerProfile::Start();
   STRING result =
       tester.RunEvalSync(0, &errs, mgr,
                          /*training_stage (irrelevant)*/ 0, FLAGS_verbosity);
   tprintf("%s\n", result.string());
+  if (FLAGS_profile_layers) {
+    tesseract::LayerProfile::Stop();
+    std::string profile;
+    tesseract::LayerProfile::Print(&profile);
+    tprintf("%s", profile.c_str());
+  }
   return 0;
 } /* main */
@@ -17,12 +17,55 @@
 ///////////////////////////////////////////////////////////////////////
 
 #include "lstmtester.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "genericvector.h"
 
 namespace tesseract {
 
+// Number of lines given to each thread in a round of a parallel evaluation.
+const int kEvalLinesPerThread = 8;
+
+// The outcome of evaluating a single line.
+struct LineEvaluation {
+  Trainability trainability = UNENCODABLE;
+  double char_error = 0.0;
+  double word_error = 0.0;
+  // The recognized text, only filled in if it is to be printed.
+  STRING ocr_text;
+};
+
+// Evaluates the given line with the given trainer at the given iteration,
+// filling in evaluation. The ocr_text is only decoded if verbosity asks for it
+// to be printed.
+static void EvaluateLine(const ImageData* line, int eval_iteration,
+                         int verbosity, LSTMTrainer* trainer,
+                         LineEvaluation* evaluation) {
+  trainer->SetIteration(eval_iteration);
+  NetworkIO fwd_outputs, targets;
+  evaluation->trainability =
+      trainer->PrepareForBackward(line, &fwd_outputs, &targets);
+  evaluation->ocr_text = "";
+  if (evaluation->trainability == UNENCODABLE) return;
+  evaluation->char_error = trainer->NewSingleError(tesseract::ET_CHAR_ERROR);
+  evaluation->word_error = trainer->NewSingleError(tesseract::ET_WORD_RECERR);
+  if (verbosity > 1 || (verbosity > 0 && evaluation->trainability != PERFECT)) {
+    GenericVector<int> ocr_labels;
+    GenericVector<int> xcoords;
+    trainer->LabelsFromOutputs(fwd_outputs, &ocr_labels, &xcoords);
+    evaluation->ocr_text = trainer->DecodeLabels(ocr_labels);
+  }
+}
+
 LSTMTester::LSTMTester(int64_t max_memory)
-    : test_data_(max_memory), total_pages_(0), async_running_(false) {}
+    : test_data_(max_memory),
+      total_pages_(0),
+      num_threads_(1),
+      async_running_(false) {}
 
 // Loads a set of lstmf files that were created using the lstm.train config to
 // tesseract into memory ready for testing. Returns false if nothing was
@@ -78,38 +121,78 @@ STRING LSTMTester::RunEvalAsync(int iteration, const double* training_errors,
 }
 
 // Runs an evaluation synchronously on the stored data and returns a string
-// describing the results.
+// describing the results. With more than one thread, the lines are evaluated
+// in rounds, each thread with its own trainer and scratch space, all sharing
+// the one loaded network, and the errors are summed in the order of the lines,
+// so the result is the same as with a single thread.
 STRING LSTMTester::RunEvalSync(int iteration, const double* training_errors,
                                const TessdataManager& model_mgr,
                                int training_stage, int verbosity) {
-  LSTMTrainer trainer;
-  trainer.InitCharSet(model_mgr);
+  int num_threads = std::max(1, num_threads_);
+#ifndef _OPENMP
+  num_threads = 1;
+#endif
+  std::vector<std::unique_ptr<LSTMTrainer>> trainers(num_threads);
+  trainers[0].reset(new LSTMTrainer);
+  trainers[0]->InitCharSet(model_mgr);
   TFile fp;
   if (!model_mgr.GetComponent(TESSDATA_LSTM, &fp) ||
-      !trainer.DeSerialize(&model_mgr, &fp)) {
+      !trainers[0]->DeSerialize(&model_mgr, &fp)) {
     return "Deserialize failed";
   }
+  // Evaluation only runs the network forward, and without its training data,
+  // the network doesn't change in Forward, so the threads can share it.
+  trainers[0]->StripTrainingData();
+  for (int t = 1; t < num_threads; ++t) {
+    trainers[t].reset(new LSTMTrainer);
+    trainers[t]->ShareModel(*trainers[0]);
+  }
+  // The threads are already busy with a line each.
+  if (num_threads > 1) {
+    for (auto& trainer : trainers) trainer->SetNumThreads(1);
+  }
+  // A single thread works straight on the lines in the cache. Otherwise each
+  // round of lines is copied, as fetching the later lines of a round may
+  // evict the earlier ones from the cache.
+  int round_size = num_threads == 1 ? 1 : num_threads * kEvalLinesPerThread;
+  std::vector<std::unique_ptr<ImageData>> copies(round_size);
+  std::vector<const ImageData*> lines(round_size);
+  std::vector<LineEvaluation> evaluations(round_size);
   int eval_iteration = 0;
   double char_error = 0.0;
   double word_error = 0.0;
   int error_count = 0;
   while (error_count < total_pages_) {
-    const ImageData* trainingdata = test_data_.GetPageBySerial(eval_iteration);
-    trainer.SetIteration(++eval_iteration);
-    NetworkIO fwd_outputs, targets;
-    Trainability result =
-        trainer.PrepareForBackward(trainingdata, &fwd_outputs, &targets);
-    if (result != UNENCODABLE) {
-      char_error += trainer.NewSingleError(tesseract::ET_CHAR_ERROR);
-      word_error += trainer.NewSingleError(tesseract::ET_WORD_RECERR);
+    for (int s = 0; s < round_size; ++s) {
+      lines[s] = test_data_.GetPageBySerial(eval_iteration + s);
+      if (num_threads > 1) {
+        copies[s].reset(lines[s] == nullptr ? nullptr : lines[s]->Copy());
+        lines[s] = copies[s].get();
+      }
+    }
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+#endif
+    for (int s = 0; s < round_size; ++s) {
+#ifdef _OPENMP
+      LSTMTrainer* trainer = trainers[omp_get_thread_num()].get();
+#else
+      LSTMTrainer* trainer = trainers[0].get();
+#endif
+      EvaluateLine(lines[s], eval_iteration + s + 1, verbosity, trainer,
+                   &evaluations[s]);
+    }
+    eval_iteration += round_size;
+    for (int s = 0; s < round_size && error_count < total_pages_; ++s) {
+      const LineEvaluation& evaluation = evaluations[s];
+      if (evaluation.trainability == UNENCODABLE) continue;
+      char_error += evaluation.char_error;
+      word_error += evaluation.word_error;
       ++error_count;
-      if (verbosity > 1 || (verbosity > 0 && result != PERFECT)) {
-        tprintf("Truth:%s\n", trainingdata->transcription().string());
-        GenericVector<int> ocr_labels;
-        GenericVector<int> xcoords;
-        trainer.LabelsFromOutputs(fwd_outputs, &ocr_labels, &xcoords);
-        STRING ocr_text = trainer.DecodeLabels(ocr_labels);
-        tprintf("OCR  :%s\n", ocr_text.string());
+      if (verbosity > 1 ||
+          (verbosity > 0 && evaluation.trainability != PERFECT)) {
+        tprintf("Truth:%s\n", lines[s]->transcription().string());
+        tprintf("OCR  :%s\n", evaluation.ocr_text.string());
       }
     }
   }
@@ -41,6 +41,13 @@ class LSTMTester {
   // loaded.
   bool LoadAllEvalData(const GenericVector<STRING>& filenames);
 
+  // Sets the number of threads used to run an evaluation. The threads share
+  // one loaded network, each with its own recognizer state and scratch space.
+  // The results do not depend on the number of threads.
+  void SetNumThreads(int num_threads) {
+    num_threads_ = num_threads;
+  }
+
   // Runs an evaluation asynchronously on the stored eval data and returns a
   // string describing the results of the previous test. Args match TestCallback
   // declared in lstmtrainer.h:
@@ -78,6 +85,8 @@ class LSTMTester {
   // The data to test with.
   DocumentCache test_data_;
   int total_pages_;
+  // Number of threads to evaluate with.
+  int num_threads_;
   // Flag that indicates an asynchronous test is currently running.
   // Protected by running_mutex_.
   bool async_running_;
@@ -18,8 +18,18 @@
 #ifdef GOOGLE_TESSERACT
 #include "base/commandlineflags.h"
 #endif
+#include <algorithm>  // for std::min
+#include <cctype>
 #include <cerrno>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
 #include "commontraining.h"
+#ifdef PANGO_ENABLE_ENGINE
+#include "fileio.h"
+#include "linerenderer.h"
+#endif
 #include "lstmtester.h"
 #include "lstmtrainer.h"
 #include "params.h"
@@ -48,6 +58,19 @@ static BOOL_PARAM_FLAG(stop_training, false,
                        "Just convert the training model to a runtime model.");
 static BOOL_PARAM_FLAG(convert_to_int, false,
                        "Convert the recognition model to an integer model.");
+static DOUBLE_PARAM_FLAG(prune_fraction, 0.0,
+                         "Fraction of the blocks of weights to prune from the "
+                         "continue_from model before fine-tuning it.");
+static STRING_PARAM_FLAG(teacher_model, "",
+                         "Traineddata file of a model to distill into the "
+                         "network being trained.");
+static DOUBLE_PARAM_FLAG(teacher_weight, 0.5,
+                         "Weight of the teacher_model outputs in the targets.");
+static STRING_PARAM_FLAG(calibration_listfile, "",
+                         "File listing lstmf files of lines on which to "
+                         "calibrate the int activations for convert_to_int.");
+static INT_PARAM_FLAG(calibration_lines, 1000,
+                      "Max number of lines to calibrate the int activations.");
 static BOOL_PARAM_FLAG(sequential_training, false,
                        "Use the training files sequentially instead of round-robin.");
 static INT_PARAM_FLAG(append_index, -1, "Index in continue_from Network at which to"
@@ -62,10 +85,116 @@ static STRING_PARAM_FLAG(old_traineddata, "",
                          " character set that is to be replaced");
 static BOOL_PARAM_FLAG(randomly_rotate, false,
                        "Train OSD and randomly turn training samples upside-down");
+static INT_PARAM_FLAG(prefetch_lines, 32,
+                      "Number of lines ahead to decode in the background");
+static INT_PARAM_FLAG(prefetch_threads, 1,
+                      "Number of threads decoding lines in the background");
+static INT_PARAM_FLAG(batch_size, 1,
+                      "Number of lines to train on as a single mini-batch");
+static INT_PARAM_FLAG(train_threads, 1,
+                      "Number of lines to train on concurrently");
+static BOOL_PARAM_FLAG(hogwild, false,
+                       "With train_threads > 1, apply the gradient of each line"
+                       " without waiting for the other threads");
+static INT_PARAM_FLAG(eval_threads, 1,
+                      "Number of threads to evaluate lines on concurrently");
+static BOOL_PARAM_FLAG(background_checkpoints, false,
+                       "Write checkpoints on a separate thread while training"
+                       " continues");
+static BOOL_PARAM_FLAG(compact_checkpoints, false,
+                       "Write the training moments in checkpoints as float");
+static BOOL_PARAM_FLAG(atomic_checkpoints, false,
+                       "Write checkpoints to a temporary file, then rename it");
+#ifdef PANGO_ENABLE_ENGINE
+static STRING_PARAM_FLAG(synth_text, "",
+                         "File of text to render into synthetic training lines");
+static STRING_PARAM_FLAG(synth_fonts_file, "",
+                         "File listing the fonts to render --synth_text with,"
+                         " one per line");
+static INT_PARAM_FLAG(synth_threads, 1,
+                      "Number of fonts to render --synth_text with"
+                      " concurrently");
+static INT_PARAM_FLAG(synth_ptsize, 12, "Size of the synthetic text");
+static INT_PARAM_FLAG(synth_exposure, 0,
+                      "Exposure level in photocopier of the synthetic text");
+#endif
 
 // Number of training images to train between calls to MaintainCheckpoints.
 const int kNumPagesPerBatch = 100;
 
+#ifdef PANGO_ENABLE_ENGINE
+// Prefix of the names of the synthetic training documents, which are never
+// written to disk.
+const char kSynthPrefix[] = "synth:";
+
+// The serialized synthetic training documents, by name. It is filled before
+// training starts and not changed after, so it can be read by any thread.
+static std::map<std::string, GenericVector<char>> synth_documents;
+
+// FileReader that reads the synthetic training documents from memory and
+// anything else from disk.
+static bool ReadSynthOrFile(const STRING& filename, GenericVector<char>* data) {
+  auto it = synth_documents.find(filename.string());
+  if (it == synth_documents.end()) {
+    return tesseract::LoadDataFromFile(filename, data);
+  }
+  *data = it->second;
+  return true;
+}
+
+// Renders --synth_text with each of the fonts in --synth_fonts_file into
+// synth_documents, and adds their names to filenames, so the trainer reads
+// the rendered lines through ReadSynthOrFile as if they were lstmf files.
+// Returns false on error.
+static bool RenderSyntheticData(GenericVector<STRING>* filenames) {
+  std::string text;
+  if (!tesseract::File::ReadFileToString(FLAGS_synth_text.c_str(), &text)) {
+    tprintf("Failed to read file: %s\n", FLAGS_synth_text.c_str());
+    return false;
+  }
+  // Remove the unicode mark if present.
+  if (strncmp(text.c_str(), "\xef\xbb\xbf", 3) == 0) text.erase(0, 3);
+  GenericVector<STRING> lines;
+  if (!tesseract::LoadFileLinesToStrings(FLAGS_synth_fonts_file.c_str(),
+                                         &lines)) {
+    tprintf("Failed to read file: %s\n", FLAGS_synth_fonts_file.c_str());
+    return false;
+  }
+  std::vector<std::string> font_names;
+  for (int i = 0; i < lines.size(); ++i) {
+    std::string font_name = lines[i].string();
+    while (!font_name.empty() &&
+           isspace(static_cast<unsigned char>(font_name.back()))) {
+      font_name.pop_back();
+    }
+    if (font_name.empty()) continue;
+    if (!tesseract::LineRenderer::FindFont(&font_name)) {
+      tprintf("Please correct %s.\n", FLAGS_synth_fonts_file.c_str());
+      return false;
+    }
+    font_names.push_back(font_name);
+  }
+  if (font_names.empty()) {
+    tprintf("No fonts listed in %s\n", FLAGS_synth_fonts_file.c_str());
+    return false;
+  }
+  tesseract::LineRenderOptions options;
+  options.ptsize = FLAGS_synth_ptsize;
+  options.exposure = FLAGS_synth_exposure;
+  std::vector<GenericVector<char>> documents;
+  if (!tesseract::LineRenderer::RenderFonts(text, font_names, options,
+                                            FLAGS_synth_threads, &documents)) {
+    return false;
+  }
+  for (size_t f = 0; f < font_names.size(); ++f) {
+    std::string name = kSynthPrefix + font_names[f];
+    synth_documents[name] = documents[f];
+    filenames->push_back(STRING(name.c_str()));
+  }
+  return true;
+}
+#endif
+
 // Apart from command-line flags, input is a collection of lstmf files, that
 // were previously created using tesseract with the lstm.train config file.
 // The program iterates over the inputs, feeding the data to the network,
@@ -102,11 +231,18 @@ int main(int argc, char **argv) {
   STRING checkpoint_file = FLAGS_model_output.c_str();
   checkpoint_file += "_checkpoint";
   STRING checkpoint_bak = checkpoint_file + ".bak";
+  tesseract::FileReader file_reader = nullptr;
+#ifdef PANGO_ENABLE_ENGINE
+  file_reader = ReadSynthOrFile;
+#endif
   tesseract::LSTMTrainer trainer(
-      nullptr, nullptr, nullptr, nullptr, FLAGS_model_output.c_str(),
+      file_reader, nullptr, nullptr, nullptr, FLAGS_model_output.c_str(),
       checkpoint_file.c_str(), FLAGS_debug_interval,
       static_cast<int64_t>(FLAGS_max_image_MB) * 1048576);
   trainer.InitCharSet(FLAGS_traineddata.c_str());
+  trainer.set_checkpoint_options(FLAGS_background_checkpoints,
+                                 FLAGS_compact_checkpoints,
+                                 FLAGS_atomic_checkpoints);
 
   // Reading something from an existing model doesn't require many flags,
   // so do it now and exit.
@@ -119,6 +255,22 @@ int main(int argc, char **argv) {
     if (FLAGS_debug_network) {
       trainer.DebugNetwork();
     } else {
+      if (FLAGS_convert_to_int && !FLAGS_calibration_listfile.empty()) {
+        GenericVector<STRING> filenames;
+        tesseract::DocumentCache calibration_data(
+            static_cast<int64_t>(FLAGS_max_image_MB) * 1048576);
+        if (!tesseract::LoadFileLinesToStrings(
+                FLAGS_calibration_listfile.c_str(), &filenames) ||
+            !calibration_data.LoadDocuments(filenames, tesseract::CS_SEQUENTIAL,
+                                            nullptr)) {
+          tprintf("Failed to load calibration data from %s\n",
+                  FLAGS_calibration_listfile.c_str());
+          return EXIT_FAILURE;
+        }
+        int num_lines = trainer.CalibrateIntRanges(&calibration_data,
+                                                   FLAGS_calibration_lines);
+        tprintf("Calibrated int ranges on %d lines\n", num_lines);
+      }
       if (FLAGS_convert_to_int) trainer.ConvertToInt();
       if (!trainer.SaveTraineddata(FLAGS_model_output.c_str())) {
         tprintf("Failed to write recognition model : %s\n",
@@ -129,17 +281,33 @@ int main(int argc, char **argv) {
   }
 
   // Get the list of files to process.
-  if (FLAGS_train_listfile.empty()) {
+  bool synthetic = false;
+#ifdef PANGO_ENABLE_ENGINE
+  if (FLAGS_synth_text.empty() != FLAGS_synth_fonts_file.empty()) {
+    tprintf("--synth_text and --synth_fonts_file must be given together\n");
+    return EXIT_FAILURE;
+  }
+  synthetic = !FLAGS_synth_text.empty();
+#endif
+  if (FLAGS_train_listfile.empty() && !synthetic) {
     tprintf("Must supply a list of training filenames! --train_listfile\n");
     return EXIT_FAILURE;
   }
   GenericVector<STRING> filenames;
-  if (!tesseract::LoadFileLinesToStrings(FLAGS_train_listfile.c_str(),
+  if (!FLAGS_train_listfile.empty() &&
+      !tesseract::LoadFileLinesToStrings(FLAGS_train_listfile.c_str(),
                                          &filenames)) {
     tprintf("Failed to load list of training filenames from %s\n",
             FLAGS_train_listfile.c_str());
     return EXIT_FAILURE;
   }
+#ifdef PANGO_ENABLE_ENGINE
+  if (synthetic && !RenderSyntheticData(&filenames)) {
+    tprintf("Failed to render synthetic training data from %s\n",
+            FLAGS_synth_text.c_str());
+    return EXIT_FAILURE;
+  }
+#endif
 
   // Checkpoints always take priority if they are available.
   if (trainer.TryLoadingCheckpoint(checkpoint_file.string(), nullptr) ||
@@ -158,6 +326,10 @@ int main(int argc, char **argv) {
       }
       tprintf("Continuing from %s\n", FLAGS_continue_from.c_str());
       trainer.InitIterations();
+      if (FLAGS_prune_fraction > 0.0) {
+        tprintf("Pruned %d blocks of weights\n",
+                trainer.PruneWeights(FLAGS_prune_fraction));
+      }
     }
     if (FLAGS_continue_from.empty() || FLAGS_append_index >= 0) {
       if (FLAGS_append_index >= 0) {
@@ -179,6 +351,11 @@ int main(int argc, char **argv) {
       trainer.set_perfect_delay(FLAGS_perfect_sample_delay);
     }
   }
+  if (!FLAGS_teacher_model.empty() &&
+      !trainer.LoadTeacher(FLAGS_teacher_model.c_str(),
+                           FLAGS_teacher_weight)) {
+    return EXIT_FAILURE;
+  }
   if (!trainer.LoadAllTrainingData(filenames,
                                    FLAGS_sequential_training
                                        ? tesseract::CS_SEQUENTIAL
@@ -187,6 +364,8 @@ int main(int argc, char **argv) {
     tprintf("Load of images failed!!\n");
     return EXIT_FAILURE;
   }
+  trainer.mutable_training_data()->StartPrefetch(FLAGS_prefetch_lines,
+                                                 FLAGS_prefetch_threads);
 
   tesseract::LSTMTester tester(static_cast<int64_t>(FLAGS_max_image_MB) *
                                1048576);
@@ -197,6 +376,7 @@ int main(int argc, char **argv) {
               FLAGS_eval_listfile.c_str());
       return EXIT_FAILURE;
     }
+    tester.SetNumThreads(FLAGS_eval_threads);
     tester_callback =
         NewPermanentTessCallback(&tester, &tesseract::LSTMTester::RunEvalAsync);
   }
@@ -207,7 +387,17 @@ int main(int argc, char **argv) {
          iteration < target_iteration &&
          (iteration < FLAGS_max_iterations || FLAGS_max_iterations == 0);
          iteration = trainer.training_iteration()) {
-      trainer.TrainOnLine(&trainer, false);
+      if (FLAGS_batch_size > 1) {
+        trainer.TrainOnBatch(&trainer, FLAGS_batch_size);
+      } else if (FLAGS_train_threads > 1) {
+        int num_samples = target_iteration - iteration;
+        if (FLAGS_max_iterations > 0)
+          num_samples = std::min(num_samples, FLAGS_max_iterations - iteration);
+        trainer.TrainOnLines(&trainer, num_samples, FLAGS_train_threads,
+                             FLAGS_hogwild);
+      } else {
+        trainer.TrainOnLine(&trainer, false);
+      }
     }
     STRING log_str;
     trainer.MaintainCheckpoints(tester_callback, &log_str);
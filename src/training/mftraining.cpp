@@ -29,6 +29,10 @@
 #include <cmath>                // for M_PI
 #include <cstring>
 #include <cstdio>
+#include <vector>                 // for std::vector
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
 
 #include "classify.h"
 #include "cluster.h"
@@ -42,6 +46,7 @@
 #include "mastertrainer.h"
 #include "mergenf.h"
 #include "mf.h"
+#include "numthreads.h"
 #include "ocrfeatures.h"
 #include "oldlist.h"
 #include "protos.h"
@@ -94,10 +99,11 @@ static void DisplayProtoList(const char* ch, LIST protolist) {
 }
 #endif  // GRAPHICS_DISABLED
 
-// Helper to run clustering on a single config.
+// Helper to run clustering on a single config. Returns the protos to be
+// added to its class by MergeOneConfig. Only reads the shared data, so many
+// configs may be clustered in parallel.
 // Mostly copied from the old mftraining, but with renamed variables.
 static LIST ClusterOneConfig(int shape_id, const char* class_label,
-                             LIST mf_classes,
                              const ShapeTable& shape_table,
                              MasterTrainer* trainer) {
   int num_samples;
@@ -105,13 +111,14 @@ static LIST ClusterOneConfig(int shape_id, const char* class_label,
                                                       feature_defs,
                                                       shape_id,
                                                       &num_samples);
-  Config.MagicSamples = num_samples;
-  LIST proto_list = ClusterSamples(clusterer, &Config);
+  CLUSTERCONFIG config = Config;
+  config.MagicSamples = num_samples;
+  LIST proto_list = ClusterSamples(clusterer, &config);
   CleanUpUnusedData(proto_list);
 
   // Merge protos where reasonable to make more of them significant by
   // representing almost all samples of the class/font.
-  MergeInsignificantProtos(proto_list, class_label, clusterer, &Config);
+  MergeInsignificantProtos(proto_list, class_label, clusterer, &config);
   #ifndef GRAPHICS_DISABLED
   if (strcmp(FLAGS_test_ch.c_str(), class_label) == 0)
     DisplayProtoList(FLAGS_test_ch.c_str(), proto_list);
@@ -121,6 +128,13 @@ static LIST ClusterOneConfig(int shape_id, const char* class_label,
                                          false,
                                          clusterer->SampleSize);
   FreeClusterer(clusterer);
+  return proto_list;
+}
+
+// Helper to add the protos of a single config, made by ClusterOneConfig, to
+// a new config of its class, which is created if necessary.
+static LIST MergeOneConfig(int shape_id, const char* class_label,
+                           LIST proto_list, LIST mf_classes) {
   MERGE_CLASS merge_class = FindClass(mf_classes, class_label);
   if (merge_class == nullptr) {
     merge_class = NewLabeledClass(class_label);
@@ -250,7 +264,7 @@ int main (int argc, char **argv) {
 
   // Now train each config separately.
   int num_configs = shape_table->NumShapes();
-  LIST mf_classes = NIL_LIST;
+  std::vector<const char*> class_labels(num_configs);
   for (int s = 0; s < num_configs; ++s) {
     int unichar_id, font_id;
     if (unicharset == &shape_set) {
@@ -260,9 +274,23 @@ int main (int argc, char **argv) {
       // Get the real unichar_id from the shape table/unicharset.
       shape_table->GetFirstUnicharAndFont(s, &unichar_id, &font_id);
     }
-    const char* class_label = unicharset->id_to_unichar(unichar_id);
-    mf_classes = ClusterOneConfig(s, class_label, mf_classes, *shape_table,
-                                  trainer);
+    class_labels[s] = unicharset->id_to_unichar(unichar_id);
+  }
+  // The configs are clustered in parallel, and then merged into their classes
+  // in order, so the output doesn't depend on the number of threads.
+  std::vector<LIST> proto_lists(num_configs, NIL_LIST);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(tesseract::NumThreads(omp_get_max_threads())) \
+    schedule(dynamic)
+#endif  // _OPENMP
+  for (int s = 0; s < num_configs; ++s) {
+    proto_lists[s] = ClusterOneConfig(s, class_labels[s], *shape_table,
+                                      trainer);
+  }
+  LIST mf_classes = NIL_LIST;
+  for (int s = 0; s < num_configs; ++s) {
+    mf_classes = MergeOneConfig(s, class_labels[s], proto_lists[s],
+                                mf_classes);
   }
   STRING inttemp_file = file_prefix;
   inttemp_file += "inttemp";
@@ -33,6 +33,7 @@
 #include <sys/param.h>
 #endif
 #include <algorithm>
+#include <mutex>
 
 #include "pango_font_info.h"
 #include "commandlineflags.h"
@@ -72,6 +73,11 @@ const int kDefaultResolution = 300;
 std::string PangoFontInfo::fonts_dir_;
 std::string PangoFontInfo::cache_dir_;
 
+// Guards the font configuration and the cached list of available fonts, which
+// are shared by all the threads that render text. Recursive, as listing the
+// fonts may initialize the font configuration, which clears the list.
+static std::recursive_mutex font_cache_mutex;
+
 PangoFontInfo::PangoFontInfo()
     : desc_(nullptr), resolution_(kDefaultResolution) {
   Clear();
@@ -110,6 +116,7 @@ std::string PangoFontInfo::DescriptionName() const {
 // FLAGS_fonts_dir and the cache to FLAGS_fontconfig_tmpdir.
 /* static */
 void PangoFontInfo::SoftInitFontConfig() {
+  std::lock_guard<std::recursive_mutex> lock(font_cache_mutex);
   if (fonts_dir_.empty()) {
     HardInitFontConfig(FLAGS_fonts_dir.c_str(),
                        FLAGS_fontconfig_tmpdir.c_str());
@@ -121,6 +128,7 @@ void PangoFontInfo::SoftInitFontConfig() {
 /* static */
 void PangoFontInfo::HardInitFontConfig(const std::string& fonts_dir,
                                        const std::string& cache_dir) {
+  std::lock_guard<std::recursive_mutex> lock(font_cache_mutex);
   if (!cache_dir_.empty()) {
     File::DeleteMatchingFiles(
         File::JoinPath(cache_dir_.c_str(), "*cache-?").c_str());
@@ -548,6 +556,7 @@ static bool ShouldIgnoreFontFamilyName(const char* query) {
 // Outputs description names of available fonts.
 /* static */
 const std::vector<std::string>& FontUtils::ListAvailableFonts() {
+  std::lock_guard<std::recursive_mutex> lock(font_cache_mutex);
   if (!available_fonts_.empty()) {
     return available_fonts_;
   }
@@ -783,7 +792,10 @@ bool FontUtils::SelectFont(const char* utf8_word, const int utf8_len,
 
 // PangoFontInfo is reinitialized, so clear the static list of fonts.
 /* static */
-void FontUtils::ReInit() { available_fonts_.clear(); }
+void FontUtils::ReInit() {
+  std::lock_guard<std::recursive_mutex> lock(font_cache_mutex);
+  available_fonts_.clear();
+}
 
 // Print info about used font backend
 /* static */
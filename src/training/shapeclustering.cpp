@@ -34,6 +34,8 @@ static INT_PARAM_FLAG(display_canonical_font, -1,
                       "Display canonical sample of this font, canonical_class2");
 static STRING_PARAM_FLAG(canonical_class1, "", "Class to show ambigs for");
 static STRING_PARAM_FLAG(canonical_class2, "", "Class to show ambigs for");
+static STRING_PARAM_FLAG(distance_cache, "",
+                         "File of sample distances to reuse between runs");
 
 // Loads training data, if requested displays debug information, otherwise
 // creates the master shape table by shape clustering and writes it to a file.
@@ -44,6 +46,8 @@ static STRING_PARAM_FLAG(canonical_class2, "", "Class to show ambigs for");
 // NOT in the cloud.
 // Otherwise, if FLAGS_canonical_class1 is set, prints a table of font-wise
 // cluster distances between FLAGS_canonical_class1 and FLAGS_canonical_class2.
+// If FLAGS_distance_cache is set, the sample distances are loaded from it if
+// it exists and matches the training data, and saved to it afterwards.
 int main(int argc, char **argv) {
   tesseract::CheckSharedLibraryVersion();
 
@@ -69,7 +73,14 @@ int main(int argc, char **argv) {
                             FLAGS_canonical_class2.c_str());
     return 0;
   }
+  if (!FLAGS_distance_cache.empty())
+    trainer->LoadDistanceCache(FLAGS_distance_cache.c_str());
   trainer->SetupMasterShapes();
+  if (!FLAGS_distance_cache.empty() &&
+      !trainer->SaveDistanceCache(FLAGS_distance_cache.c_str())) {
+    tprintf("Failed to write distance cache %s\n",
+            FLAGS_distance_cache.c_str());
+  }
   WriteShapeTable(file_prefix, trainer->master_shapes());
   delete trainer;
 
@@ -0,0 +1,271 @@
+///////////////////////////////////////////////////////////////////////
+// File:        tesseract_bench.cpp
+// Description: Benchmark of the throughput and latency of recognition.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+// Recognizes the pages of a corpus over a pool of engines on some threads,
+// first for warm-up and then timed, and reports the pages per second, the
+// percentiles of the latency of a page, the peak resident set and the time
+// spent in each stage of recognition, as text and optionally as JSON, which
+// CI can compare between builds.
+
+#ifdef GOOGLE_TESSERACT
+#include "base/commandlineflags.h"
+#endif
+#include <algorithm>  // for std::sort
+#include <atomic>     // for std::atomic
+#include <chrono>     // for std::chrono::steady_clock
+#include <cstdint>    // for int64_t
+#include <cstdio>     // for fopen, snprintf
+#include <fstream>    // for std::ifstream
+#include <mutex>      // for std::mutex
+#include <string>     // for std::string
+#include <thread>     // for std::thread
+#include <vector>     // for std::vector
+#if !defined(_WIN32)
+#include <sys/resource.h>  // for getrusage
+#endif
+#include "allheaders.h"  // for pixRead, pixDestroy
+#include "baseapi.h"
+#include "commontraining.h"
+#include "enginepool.h"
+#include "genericvector.h"
+#include "strngs.h"
+#include "tprintf.h"
+#include "tracing.h"
+
+static STRING_PARAM_FLAG(corpus, "", "File listing the images to recognize.");
+static STRING_PARAM_FLAG(tessdata_dir, "", "Directory of the traineddata.");
+static STRING_PARAM_FLAG(lang, "eng", "Language(s) to recognize.");
+static INT_PARAM_FLAG(oem, tesseract::OEM_LSTM_ONLY, "OCR engine mode.");
+static INT_PARAM_FLAG(psm, tesseract::PSM_AUTO, "Page segmentation mode.");
+static INT_PARAM_FLAG(threads, 1, "Threads, each with an engine of the pool.");
+static INT_PARAM_FLAG(warmup_iterations, 1,
+                      "Times to recognize the corpus before timing.");
+static INT_PARAM_FLAG(iterations, 3, "Times to recognize the corpus timed.");
+static STRING_PARAM_FLAG(json, "", "File to write the results to as JSON.");
+
+namespace {
+
+// The results of the timed iterations.
+struct BenchResults {
+  int pages = 0;
+  int failures = 0;
+  double wall_ms = 0.0;
+  std::vector<double> latencies_ms;  // Sorted.
+  int64_t peak_rss_bytes = 0;
+  std::vector<tesseract::Tracing::SpanTotal> stages;
+};
+
+// Returns the largest resident set of the process so far, or 0 if it is not
+// known on this platform.
+int64_t PeakResidentBytes() {
+#if defined(_WIN32)
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// Returns the latency below which fraction of the pages are, by the
+// nearest rank.
+double Percentile(const std::vector<double>& sorted, double fraction) {
+  if (sorted.empty()) return 0.0;
+  size_t rank = static_cast<size_t>(fraction * sorted.size() + 0.5);
+  if (rank > 0) --rank;
+  return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// Recognizes all the pages iterations times on num_threads threads, which
+// lease the engines of pool, and adds the latencies of the pages to
+// latencies_ms, if not null. Returns the number of pages that failed.
+int RunIterations(const std::vector<Pix*>& pages, int iterations,
+                  int num_threads, tesseract::TessEnginePool* pool,
+                  const GenericVector<STRING>& names,
+                  const GenericVector<STRING>& values,
+                  std::vector<double>* latencies_ms) {
+  const int num_jobs = iterations * pages.size();
+  std::atomic<int> next_job(0);
+  std::atomic<int> failures(0);
+  std::mutex mutex;
+  auto run = [&]() {
+    for (int job = next_job++; job < num_jobs; job = next_job++) {
+      tesseract::TessBaseAPI* api =
+          pool->Acquire(FLAGS_lang.c_str(),
+                        static_cast<tesseract::OcrEngineMode>(
+                            static_cast<int>(FLAGS_oem)),
+                        &names, &values);
+      if (api == nullptr) {
+        ++failures;
+        continue;
+      }
+      auto start = std::chrono::steady_clock::now();
+      api->SetImage(pages[job % pages.size()]);
+      char* text = api->GetUTF8Text();
+      std::chrono::duration<double, std::milli> latency =
+          std::chrono::steady_clock::now() - start;
+      if (text == nullptr) ++failures;
+      delete[] text;
+      api->Clear();
+      pool->Release(api);
+      if (latencies_ms != nullptr) {
+        std::lock_guard<std::mutex> lock(mutex);
+        latencies_ms->push_back(latency.count());
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) threads.push_back(std::thread(run));
+  run();
+  for (auto& thread : threads) thread.join();
+  return failures;
+}
+
+void PrintResults(const BenchResults& results) {
+  const std::vector<double>& latencies = results.latencies_ms;
+  double mean = 0.0;
+  for (double latency : latencies) mean += latency;
+  if (!latencies.empty()) mean /= latencies.size();
+  tprintf("Pages: %d in %.3f s, %.3f pages/s, %d failed\n", results.pages,
+          results.wall_ms / 1000.0,
+          results.pages * 1000.0 / std::max(results.wall_ms, 1e-3),
+          results.failures);
+  tprintf("Latency ms: mean %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f\n",
+          mean, Percentile(latencies, 0.50), Percentile(latencies, 0.95),
+          Percentile(latencies, 0.99),
+          latencies.empty() ? 0.0 : latencies.back());
+  tprintf("Peak RSS: %.3f MB\n", results.peak_rss_bytes / 1048576.0);
+  tprintf("Stages (total ms over all threads, count, mean ms):\n");
+  for (const auto& stage : results.stages) {
+    tprintf("%12.3f %8ld %10.3f  %s\n", stage.total_us / 1000.0,
+            static_cast<long>(stage.count),
+            stage.total_us / 1000.0 / std::max<int64_t>(stage.count, 1),
+            stage.name.c_str());
+  }
+}
+
+// Writes the results to filename as a JSON object. The names of the stages
+// are literals of the source, which need no escaping.
+bool WriteJson(const BenchResults& results, const char* filename) {
+  FILE* fp = fopen(filename, "w");
+  if (fp == nullptr) return false;
+  const std::vector<double>& latencies = results.latencies_ms;
+  double mean = 0.0;
+  for (double latency : latencies) mean += latency;
+  if (!latencies.empty()) mean /= latencies.size();
+  fprintf(fp,
+          "{\"lang\":\"%s\",\"oem\":%d,\"psm\":%d,\"threads\":%d,"
+          "\"iterations\":%d,\"pages\":%d,\"failures\":%d,\"wall_ms\":%.3f,"
+          "\"pages_per_s\":%.3f,\n",
+          FLAGS_lang.c_str(), static_cast<int>(FLAGS_oem),
+          static_cast<int>(FLAGS_psm), static_cast<int>(FLAGS_threads),
+          static_cast<int>(FLAGS_iterations), results.pages,
+          results.failures, results.wall_ms,
+          results.pages * 1000.0 / std::max(results.wall_ms, 1e-3));
+  fprintf(fp,
+          "\"latency_ms\":{\"mean\":%.3f,\"p50\":%.3f,\"p95\":%.3f,"
+          "\"p99\":%.3f,\"max\":%.3f},\"peak_rss_bytes\":%ld,\n\"stages\":[",
+          mean, Percentile(latencies, 0.50), Percentile(latencies, 0.95),
+          Percentile(latencies, 0.99),
+          latencies.empty() ? 0.0 : latencies.back(),
+          static_cast<long>(results.peak_rss_bytes));
+  for (size_t i = 0; i < results.stages.size(); ++i) {
+    const auto& stage = results.stages[i];
+    fprintf(fp, "%s\n{\"name\":\"%s\",\"count\":%ld,\"total_ms\":%.3f}",
+            i > 0 ? "," : "", stage.name.c_str(),
+            static_cast<long>(stage.count), stage.total_us / 1000.0);
+  }
+  fprintf(fp, "]}\n");
+  return fclose(fp) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  tesseract::CheckSharedLibraryVersion();
+  ParseArguments(&argc, &argv);
+  if (FLAGS_corpus.empty()) {
+    tprintf("Must provide a --corpus!\n");
+    return 1;
+  }
+  if (FLAGS_threads < 1 || FLAGS_iterations < 1 ||
+      FLAGS_warmup_iterations < 0) {
+    tprintf("--threads and --iterations must be positive!\n");
+    return 1;
+  }
+  std::ifstream corpus(FLAGS_corpus.c_str());
+  if (!corpus) {
+    tprintf("Cannot read corpus list %s\n", FLAGS_corpus.c_str());
+    return 1;
+  }
+  std::vector<Pix*> pages;
+  std::string filename;
+  while (std::getline(corpus, filename)) {
+    if (filename.empty()) continue;
+    Pix* pix = pixRead(filename.c_str());
+    if (pix == nullptr) {
+      tprintf("Cannot read image %s\n", filename.c_str());
+      return 1;
+    }
+    pages.push_back(pix);
+  }
+  if (pages.empty()) {
+    tprintf("No images in %s\n", FLAGS_corpus.c_str());
+    return 1;
+  }
+
+  int exit_code = 0;
+  {
+    tesseract::TessEnginePool pool(
+        FLAGS_tessdata_dir.empty() ? nullptr : FLAGS_tessdata_dir.c_str(),
+        FLAGS_threads);
+    GenericVector<STRING> names, values;
+    names.push_back("tessedit_pageseg_mode");
+    STRING psm;
+    psm.add_str_int("", FLAGS_psm);
+    values.push_back(psm);
+    RunIterations(pages, FLAGS_warmup_iterations, FLAGS_threads, &pool,
+                  names, values, nullptr);
+
+    BenchResults results;
+    results.pages = FLAGS_iterations * pages.size();
+    tesseract::Tracing::Start();
+    auto start = std::chrono::steady_clock::now();
+    results.failures =
+        RunIterations(pages, FLAGS_iterations, FLAGS_threads, &pool, names,
+                      values, &results.latencies_ms);
+    std::chrono::duration<double, std::milli> wall =
+        std::chrono::steady_clock::now() - start;
+    tesseract::Tracing::Stop();
+    results.wall_ms = wall.count();
+    std::sort(results.latencies_ms.begin(), results.latencies_ms.end());
+    results.peak_rss_bytes = PeakResidentBytes();
+    tesseract::Tracing::GetTotals(&results.stages);
+
+    PrintResults(results);
+    if (!FLAGS_json.empty() && !WriteJson(results, FLAGS_json.c_str())) {
+      tprintf("Cannot write %s\n", FLAGS_json.c_str());
+      exit_code = 1;
+    }
+    if (results.failures > 0) exit_code = 1;
+  }
+  for (Pix* pix : pages) pixDestroy(&pix);
+  return exit_code;
+} /* main */
@@ -26,12 +26,16 @@
  *
  **********************************************************************/
 
+#include <cctype>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -43,6 +47,8 @@
 #include "errcode.h"
 #include "fileio.h"
 #include "helpers.h"
+#include "imagedata.h"
+#include "linerenderer.h"
 #include "normstrngs.h"
 #include "stringrenderer.h"
 #include "tlog.h"
@@ -149,6 +155,18 @@ static BOOL_PARAM_FLAG(strip_unrenderable_words, true,
 // Font name.
 static STRING_PARAM_FLAG(font, "Arial", "Font description name to use");
 
+static STRING_PARAM_FLAG(fonts_file, "",
+                         "File listing font description names, one per line, "
+                         "to render the text with instead of --font. Each font "
+                         "is rendered to its own outputs, named "
+                         "outputbase.font_name");
+static INT_PARAM_FLAG(num_threads, 1,
+                      "Number of fonts of --fonts_file to render concurrently");
+
+static BOOL_PARAM_FLAG(output_lstmf, false,
+                       "Output the text lines straight to an lstmf file ready "
+                       "for LSTM training, instead of a tif and a box file");
+
 static BOOL_PARAM_FLAG(ligatures, false,
                        "Rebuild and render ligatures");
 
@@ -336,7 +354,8 @@ static void ExtractFontProperties(const std::string &utf8_text,
 }
 
 static bool MakeIndividualGlyphs(Pix* pix, const std::vector<BoxChar*>& vbox,
-                                 const int input_tiff_page) {
+                                 const int input_tiff_page,
+                                 const std::string& outputbase) {
   // If checks fail, return false without exiting text2image
   if (!pix) {
     tprintf("ERROR: MakeIndividualGlyphs(): Input Pix* is nullptr\n");
@@ -353,7 +372,7 @@ static bool MakeIndividualGlyphs(Pix* pix, const std::vector<BoxChar*>& vbox,
   int n_boxes_saved = 0;
   int current_tiff_page = 0;
   int y_previous = 0;
-  static int glyph_count = 0;
+  static std::atomic<int> glyph_count(0);
   for (int i = 0; i < n_boxes; i++) {
     // Get one bounding box
     Box* b = vbox[i]->mutable_box();
@@ -407,7 +426,7 @@ static bool MakeIndividualGlyphs(Pix* pix, const std::vector<BoxChar*>& vbox,
     // Write out
     Pix* pix_glyph_sq_pad_8 = pixConvertTo8(pix_glyph_sq_pad, false);
     char filename[1024];
-    snprintf(filename, 1024, "%s_%d.jpg", FLAGS_outputbase.c_str(),
+    snprintf(filename, 1024, "%s_%d.jpg", outputbase.c_str(),
              glyph_count++);
     if (pixWriteJpeg(filename, pix_glyph_sq_pad_8, 100, 0)) {
       tprintf("ERROR: MakeIndividualGlyphs(): Failed to write JPEG to %s,"
@@ -432,13 +451,246 @@ static bool MakeIndividualGlyphs(Pix* pix, const std::vector<BoxChar*>& vbox,
 }  // namespace tesseract
 
 using tesseract::DegradeImage;
+using tesseract::DocumentData;
 using tesseract::ExtractFontProperties;
 using tesseract::File;
 using tesseract::FontUtils;
+using tesseract::LineRenderer;
 using tesseract::SpanUTF8NotWhitespace;
 using tesseract::SpanUTF8Whitespace;
 using tesseract::StringRenderer;
 
+// Returns a new StringRenderer for the given font, set up from the flags.
+// The caller takes ownership.
+static StringRenderer* NewRenderer(const std::string& font_name) {
+  char font_desc_name[1024];
+  snprintf(font_desc_name, 1024, "%s %d", font_name.c_str(),
+            static_cast<int>(FLAGS_ptsize));
+
+  auto* render = new StringRenderer(font_desc_name, FLAGS_xsize, FLAGS_ysize);
+  render->set_add_ligatures(FLAGS_ligatures);
+  render->set_leading(FLAGS_leading);
+  render->set_resolution(FLAGS_resolution);
+  render->set_char_spacing(FLAGS_char_spacing * FLAGS_ptsize);
+  render->set_h_margin(FLAGS_margin);
+  render->set_v_margin(FLAGS_margin);
+  render->set_output_word_boxes(FLAGS_output_word_boxes);
+  render->set_box_padding(FLAGS_box_padding);
+  render->set_strip_unrenderable_words(FLAGS_strip_unrenderable_words);
+  render->set_underline_start_prob(FLAGS_underline_start_prob);
+  render->set_underline_continuation_prob(FLAGS_underline_continuation_prob);
+
+  // Set text rendering orientation and their forms. The writing mode has
+  // already been checked by Main.
+  if (FLAGS_writing_mode == "horizontal") {
+    // Render regular horizontal text (default).
+    render->set_vertical_text(false);
+    render->set_gravity_hint_strong(false);
+    render->set_render_fullwidth_latin(false);
+  } else if (FLAGS_writing_mode == "vertical") {
+    // Render vertical text. Glyph orientation is selected by Pango.
+    render->set_vertical_text(true);
+    render->set_gravity_hint_strong(false);
+    render->set_render_fullwidth_latin(false);
+  } else if (FLAGS_writing_mode == "vertical-upright") {
+    // Render vertical text. Glyph orientation is set to be upright.
+    // Also Basic Latin characters are converted to their fullwidth forms
+    // on rendering, since fullwidth Latin characters are well designed to fit
+    // vertical text lines, while .box files store halfwidth Basic Latin
+    // unichars.
+    render->set_vertical_text(true);
+    render->set_gravity_hint_strong(true);
+    render->set_render_fullwidth_latin(true);
+  }
+  return render;
+}
+
+// Renders the text with render, to outputs named by outputbase: a tif file of
+// the pages and a box file, or, with --output_lstmf, an lstmf file of the
+// text lines. With --find_fonts, renders with each font that can render the
+// text instead. Returns false on error.
+static bool RenderText(const std::string& src_utf8,
+                       const std::string& outputbase, StringRenderer* render) {
+  int im = 0;
+  std::vector<float> page_rotation;
+  const char* to_render_utf8 = src_utf8.c_str();
+
+  tesseract::TRand randomizer;
+  randomizer.set_seed(kRandomSeed);
+  std::vector<std::string> font_names;
+  DocumentData lstmf_data(outputbase.c_str());
+  int num_lstmf_lines = 0;
+  // We use a two pass mechanism to rotate images in both direction.
+  // The first pass(0) will rotate the images in random directions and
+  // the second pass(1) will mirror those rotations.
+  int num_pass = FLAGS_bidirectional_rotation ? 2 : 1;
+  for (int pass = 0; pass < num_pass; ++pass) {
+    int page_num = 0;
+    std::string font_used;
+    for (size_t offset = 0;
+         offset < strlen(to_render_utf8) &&
+         (FLAGS_max_pages == 0 || page_num < FLAGS_max_pages);
+         ++im, ++page_num) {
+      tlog(1, "Starting page %d\n", im);
+      Pix* pix = nullptr;
+      if (FLAGS_find_fonts) {
+        offset += render->RenderAllFontsToImage(FLAGS_min_coverage,
+                                                to_render_utf8 + offset,
+                                                strlen(to_render_utf8 + offset),
+                                                &font_used, &pix);
+      } else {
+        offset += render->RenderToImage(to_render_utf8 + offset,
+                                        strlen(to_render_utf8 + offset), &pix);
+      }
+      if (pix != nullptr) {
+        float rotation = 0;
+        if (pass == 1) {
+          // Pass 2, do mirror rotation.
+          rotation = -1 * page_rotation[page_num];
+        }
+        if (FLAGS_degrade_image) {
+          pix = DegradeImage(pix, FLAGS_exposure, &randomizer,
+                             FLAGS_rotate_image ? &rotation : nullptr);
+        }
+        if (FLAGS_distort_image) {
+         //TODO: perspective is set to false and box_reduction to 1.
+          pix = PrepareDistortedPix(pix, false, FLAGS_invert,
+                             FLAGS_white_noise, FLAGS_smooth_noise, FLAGS_blur,
+                             1, &randomizer, nullptr);
+        }
+        render->RotatePageBoxes(rotation);
+
+        if (pass == 0) {
+          // Pass 1, rotate randomly and store the rotation..
+          page_rotation.push_back(rotation);
+        }
+
+        Pix* gray_pix = pixConvertTo8(pix, false);
+        pixDestroy(&pix);
+        Pix* binary = pixThresholdToBinary(gray_pix, 128);
+        pixDestroy(&gray_pix);
+        char tiff_name[1024];
+        if (FLAGS_output_lstmf) {
+          // No tif is written, but the lines still name the image they would
+          // have come from.
+          snprintf(tiff_name, 1024, "%s.tif", outputbase.c_str());
+        } else if (FLAGS_find_fonts) {
+          if (FLAGS_render_per_font) {
+            std::string fontname_for_file = tesseract::StringReplace(
+                font_used, " ", "_");
+            snprintf(tiff_name, 1024, "%s.%s.tif", outputbase.c_str(),
+                     fontname_for_file.c_str());
+            pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, "w");
+            tprintf("Rendered page %d to file %s\n", im, tiff_name);
+          } else {
+            font_names.push_back(font_used);
+          }
+        } else {
+          snprintf(tiff_name, 1024, "%s.tif", outputbase.c_str());
+          pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, im == 0 ? "w" : "a");
+          tprintf("Rendered page %d to file %s\n", im, tiff_name);
+        }
+        // Make individual glyphs
+        if (FLAGS_output_individual_glyph_images) {
+          if (!MakeIndividualGlyphs(binary, render->GetBoxes(), im,
+                                    outputbase)) {
+            tprintf("ERROR: Individual glyphs not saved\n");
+          }
+        }
+        if (FLAGS_output_lstmf) {
+          // The boxes of each page are used up as soon as it is rendered.
+          num_lstmf_lines += LineRenderer::AddPageLines(
+              binary, tiff_name, im, render->GetBoxesStr(), &lstmf_data);
+          render->ClearBoxes();
+        }
+        pixDestroy(&binary);
+      }
+      if (FLAGS_find_fonts && offset != 0) {
+        // We just want a list of names, or some sample images so we don't need
+        // to render more than the first page of the text.
+        break;
+      }
+    }
+  }
+  if (FLAGS_output_lstmf) {
+    std::string lstmf_name = outputbase + ".lstmf";
+    if (!lstmf_data.SaveDocument(lstmf_name.c_str(), nullptr)) {
+      tprintf("Failed to write training data to %s!\n", lstmf_name.c_str());
+      return false;
+    }
+    tprintf("Rendered %d lines to file %s\n", num_lstmf_lines,
+            lstmf_name.c_str());
+  } else if (!FLAGS_find_fonts) {
+    std::string box_name = outputbase;
+    box_name += ".box";
+    render->WriteAllBoxes(box_name);
+  } else if (!FLAGS_render_per_font && !font_names.empty()) {
+    std::string filename = outputbase;
+    filename += ".fontlist.txt";
+    FILE* fp = fopen(filename.c_str(), "wb");
+    if (fp == nullptr) {
+      tprintf("Failed to create output font list %s\n", filename.c_str());
+    } else {
+      for (size_t i = 0; i < font_names.size(); ++i) {
+        fprintf(fp, "%s\n", font_names[i].c_str());
+      }
+      fclose(fp);
+    }
+  }
+  return true;
+}
+
+// Renders the text with each of the fonts listed in --fonts_file, on up to
+// --num_threads threads, each font to outputs named outputbase.font_name.
+// Each thread has its own StringRenderer, and so its own Pango context, while
+// all of them share the font configuration and the cache of fonts, which are
+// set up before the threads start. Returns the exit code.
+static int RenderFontList(const std::string& src_utf8) {
+  GenericVector<STRING> lines;
+  if (!tesseract::LoadFileLinesToStrings(FLAGS_fonts_file.c_str(), &lines)) {
+    tprintf("Failed to read file: %s\n", FLAGS_fonts_file.c_str());
+    return EXIT_FAILURE;
+  }
+  std::vector<std::string> font_names;
+  std::vector<std::string> outputbases;
+  for (int i = 0; i < lines.size(); ++i) {
+    std::string font_name = lines[i].string();
+    while (!font_name.empty() &&
+           isspace(static_cast<unsigned char>(font_name.back()))) {
+      font_name.pop_back();
+    }
+    if (font_name.empty()) continue;
+    std::string fontname_for_file =
+        tesseract::StringReplace(font_name, " ", "_");
+    if (!LineRenderer::FindFont(&font_name)) {
+      tprintf("Please correct %s.\n", FLAGS_fonts_file.c_str());
+      return EXIT_FAILURE;
+    }
+    font_names.push_back(font_name);
+    outputbases.push_back(std::string(FLAGS_outputbase.c_str()) + "." +
+                          fontname_for_file);
+  }
+  if (font_names.empty()) {
+    tprintf("No fonts listed in %s\n", FLAGS_fonts_file.c_str());
+    return EXIT_FAILURE;
+  }
+  std::atomic<int> next_font(0);
+  std::atomic<int> num_failed(0);
+  auto render_fonts = [&]() {
+    for (int f = next_font++; f < static_cast<int>(font_names.size());
+         f = next_font++) {
+      std::unique_ptr<StringRenderer> render(NewRenderer(font_names[f]));
+      if (!RenderText(src_utf8, outputbases[f], render.get())) ++num_failed;
+    }
+  };
+  int num_threads = ClipToRange<int>(FLAGS_num_threads, 1, font_names.size());
+  std::vector<std::thread> threads;
+  for (int t = 1; t < num_threads; ++t) threads.emplace_back(render_fonts);
+  render_fonts();
+  for (auto& thread : threads) thread.join();
+  return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 static int Main() {
   if (FLAGS_list_available_fonts) {
     const std::vector<std::string>& all_fonts = FontUtils::ListAvailableFonts();
@@ -469,66 +721,34 @@ static int Main() {
     tprintf("Use '--unicharset_file' only if '--render_ngrams' is set.\n");
     exit(1);
   }
+  if (!FLAGS_fonts_file.empty() &&
+      (FLAGS_find_fonts || FLAGS_only_extract_font_properties)) {
+    tprintf("'--fonts_file' cannot be used with '--find_fonts' or "
+            "'--only_extract_font_properties'.\n");
+    exit(1);
+  }
+  const std::string writing_mode = FLAGS_writing_mode.c_str();
+  if (writing_mode != "horizontal" && writing_mode != "vertical" &&
+      writing_mode != "vertical-upright") {
+    tprintf("Invalid writing mode: %s\n", FLAGS_writing_mode.c_str());
+    exit(1);
+  }
+  if (FLAGS_output_lstmf &&
+      (FLAGS_find_fonts || writing_mode != "horizontal")) {
+    tprintf("'--output_lstmf' needs horizontal text and no '--find_fonts'.\n");
+    exit(1);
+  }
 
   std::string font_name = FLAGS_font.c_str();
-  if (!FLAGS_find_fonts && !FontUtils::IsAvailableFont(font_name.c_str())) {
-    font_name += ',';
-    std::string pango_name;
-    if (!FontUtils::IsAvailableFont(font_name.c_str(), &pango_name)) {
-      tprintf("Could not find font named '%s'.\n", FLAGS_font.c_str());
-      if (!pango_name.empty()) {
-        tprintf("Pango suggested font '%s'.\n", pango_name.c_str());
-      }
-      tprintf("Please correct --font arg.\n");
-      exit(1);
-    }
+  if (FLAGS_fonts_file.empty() && !FLAGS_find_fonts &&
+      !LineRenderer::FindFont(&font_name)) {
+    tprintf("Please correct --font arg.\n");
+    exit(1);
   }
 
   if (FLAGS_render_ngrams)
     FLAGS_output_word_boxes = true;
 
-  char font_desc_name[1024];
-  snprintf(font_desc_name, 1024, "%s %d", font_name.c_str(),
-            static_cast<int>(FLAGS_ptsize));
-
-  StringRenderer render(font_desc_name, FLAGS_xsize, FLAGS_ysize);
-  render.set_add_ligatures(FLAGS_ligatures);
-  render.set_leading(FLAGS_leading);
-  render.set_resolution(FLAGS_resolution);
-  render.set_char_spacing(FLAGS_char_spacing * FLAGS_ptsize);
-  render.set_h_margin(FLAGS_margin);
-  render.set_v_margin(FLAGS_margin);
-  render.set_output_word_boxes(FLAGS_output_word_boxes);
-  render.set_box_padding(FLAGS_box_padding);
-  render.set_strip_unrenderable_words(FLAGS_strip_unrenderable_words);
-  render.set_underline_start_prob(FLAGS_underline_start_prob);
-  render.set_underline_continuation_prob(FLAGS_underline_continuation_prob);
-
-  // Set text rendering orientation and their forms.
-  if (FLAGS_writing_mode == "horizontal") {
-    // Render regular horizontal text (default).
-    render.set_vertical_text(false);
-    render.set_gravity_hint_strong(false);
-    render.set_render_fullwidth_latin(false);
-  } else if (FLAGS_writing_mode == "vertical") {
-    // Render vertical text. Glyph orientation is selected by Pango.
-    render.set_vertical_text(true);
-    render.set_gravity_hint_strong(false);
-    render.set_render_fullwidth_latin(false);
-  } else if (FLAGS_writing_mode == "vertical-upright") {
-    // Render vertical text. Glyph orientation is set to be upright.
-    // Also Basic Latin characters are converted to their fullwidth forms
-    // on rendering, since fullwidth Latin characters are well designed to fit
-    // vertical text lines, while .box files store halfwidth Basic Latin
-    // unichars.
-    render.set_vertical_text(true);
-    render.set_gravity_hint_strong(true);
-    render.set_render_fullwidth_latin(true);
-  } else {
-    tprintf("Invalid writing mode: %s\n", FLAGS_writing_mode.c_str());
-    exit(1);
-  }
-
   std::string src_utf8;
   // This c_str is NOT redundant!
   if (!File::ReadFileToString(FLAGS_text.c_str(), &src_utf8)) {
@@ -597,120 +817,19 @@ static int Main() {
     tlog(1, "Rendered ngram string of size %d\n", rand_utf8.length());
     src_utf8.swap(rand_utf8);
   }
+  if (!FLAGS_fonts_file.empty()) return RenderFontList(src_utf8);
+
+  std::unique_ptr<StringRenderer> render(NewRenderer(font_name));
   if (FLAGS_only_extract_font_properties) {
     tprintf("Extracting font properties only\n");
-    ExtractFontProperties(src_utf8, &render, FLAGS_outputbase.c_str());
+    ExtractFontProperties(src_utf8, render.get(), FLAGS_outputbase.c_str());
     tprintf("Done!\n");
     return 0;
   }
 
-  int im = 0;
-  std::vector<float> page_rotation;
-  const char* to_render_utf8 = src_utf8.c_str();
-
-  tesseract::TRand randomizer;
-  randomizer.set_seed(kRandomSeed);
-  std::vector<std::string> font_names;
-  // We use a two pass mechanism to rotate images in both direction.
-  // The first pass(0) will rotate the images in random directions and
-  // the second pass(1) will mirror those rotations.
-  int num_pass = FLAGS_bidirectional_rotation ? 2 : 1;
-  for (int pass = 0; pass < num_pass; ++pass) {
-    int page_num = 0;
-    std::string font_used;
-    for (size_t offset = 0;
-         offset < strlen(to_render_utf8) &&
-         (FLAGS_max_pages == 0 || page_num < FLAGS_max_pages);
-         ++im, ++page_num) {
-      tlog(1, "Starting page %d\n", im);
-      Pix* pix = nullptr;
-      if (FLAGS_find_fonts) {
-        offset += render.RenderAllFontsToImage(FLAGS_min_coverage,
-                                               to_render_utf8 + offset,
-                                               strlen(to_render_utf8 + offset),
-                                               &font_used, &pix);
-      } else {
-        offset += render.RenderToImage(to_render_utf8 + offset,
-                                       strlen(to_render_utf8 + offset), &pix);
-      }
-      if (pix != nullptr) {
-        float rotation = 0;
-        if (pass == 1) {
-          // Pass 2, do mirror rotation.
-          rotation = -1 * page_rotation[page_num];
-        }
-        if (FLAGS_degrade_image) {
-          pix = DegradeImage(pix, FLAGS_exposure, &randomizer,
-                             FLAGS_rotate_image ? &rotation : nullptr);
-        }
-        if (FLAGS_distort_image) {
-         //TODO: perspective is set to false and box_reduction to 1.
-          pix = PrepareDistortedPix(pix, false, FLAGS_invert,
-                             FLAGS_white_noise, FLAGS_smooth_noise, FLAGS_blur,
-                             1, &randomizer, nullptr);
-        }
-        render.RotatePageBoxes(rotation);
-
-        if (pass == 0) {
-          // Pass 1, rotate randomly and store the rotation..
-          page_rotation.push_back(rotation);
-        }
-
-        Pix* gray_pix = pixConvertTo8(pix, false);
-        pixDestroy(&pix);
-        Pix* binary = pixThresholdToBinary(gray_pix, 128);
-        pixDestroy(&gray_pix);
-        char tiff_name[1024];
-        if (FLAGS_find_fonts) {
-          if (FLAGS_render_per_font) {
-            std::string fontname_for_file = tesseract::StringReplace(
-                font_used, " ", "_");
-            snprintf(tiff_name, 1024, "%s.%s.tif", FLAGS_outputbase.c_str(),
-                     fontname_for_file.c_str());
-            pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, "w");
-            tprintf("Rendered page %d to file %s\n", im, tiff_name);
-          } else {
-            font_names.push_back(font_used);
-          }
-        } else {
-          snprintf(tiff_name, 1024, "%s.tif", FLAGS_outputbase.c_str());
-          pixWriteTiff(tiff_name, binary, IFF_TIFF_G4, im == 0 ? "w" : "a");
-          tprintf("Rendered page %d to file %s\n", im, tiff_name);
-        }
-        // Make individual glyphs
-        if (FLAGS_output_individual_glyph_images) {
-          if (!MakeIndividualGlyphs(binary, render.GetBoxes(), im)) {
-            tprintf("ERROR: Individual glyphs not saved\n");
-          }
-        }
-        pixDestroy(&binary);
-      }
-      if (FLAGS_find_fonts && offset != 0) {
-        // We just want a list of names, or some sample images so we don't need
-        // to render more than the first page of the text.
-        break;
-      }
-    }
-  }
-  if (!FLAGS_find_fonts) {
-    std::string box_name = FLAGS_outputbase.c_str();
-    box_name += ".box";
-    render.WriteAllBoxes(box_name);
-  } else if (!FLAGS_render_per_font && !font_names.empty()) {
-    std::string filename = FLAGS_outputbase.c_str();
-    filename += ".fontlist.txt";
-    FILE* fp = fopen(filename.c_str(), "wb");
-    if (fp == nullptr) {
-      tprintf("Failed to create output font list %s\n", filename.c_str());
-    } else {
-      for (size_t i = 0; i < font_names.size(); ++i) {
-        fprintf(fp, "%s\n", font_names[i].c_str());
-      }
-      fclose(fp);
-    }
-  }
-
-  return 0;
+  return RenderText(src_utf8, FLAGS_outputbase.c_str(), render.get())
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
 }
 
 int main(int argc, char** argv) {
@@ -20,7 +20,11 @@
 // normalizes the text according to command-line options and generates
 // a unicharset.
 
+#include <algorithm>
 #include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
 #include "boxread.h"
 #include "commandlineflags.h"
 #include "commontraining.h"     // CheckSharedLibraryVersion
@@ -35,20 +39,38 @@ static STRING_PARAM_FLAG(output_unicharset, "unicharset", "Output file path");
 static INT_PARAM_FLAG(norm_mode, 1,
                       "Normalization mode: 1=Combine graphemes, "
                       "2=Split graphemes, 3=Pure unicode");
+static INT_PARAM_FLAG(norm_threads, 1,
+                      "Number of threads to normalize text on concurrently.");
 
 namespace tesseract {
 
+// Number of lines of a plain text file given to each thread in a round of
+// normalization. Bounds the memory used on large corpus files.
+const int kNormLinesPerThread = 4096;
+
 // Helper normalizes and segments the given strings according to norm_mode, and
-// adds the segmented parts to unicharset.
+// adds the segmented parts to unicharset. The strings are normalized on
+// num_threads threads, but added in order, so the unicharset is the same
+// for any number of threads.
 static void AddStringsToUnicharset(const GenericVector<STRING>& strings,
-                                   int norm_mode, UNICHARSET* unicharset) {
-  for (int i = 0; i < strings.size(); ++i) {
-    std::vector<std::string> normalized;
-    if (NormalizeCleanAndSegmentUTF8(UnicodeNormMode::kNFC, OCRNorm::kNone,
-                                     static_cast<GraphemeNormMode>(norm_mode),
-                                     /*report_errors*/ true,
-                                     strings[i].string(), &normalized)) {
-      for (const std::string& normed : normalized) {
+                                   int norm_mode, int num_threads,
+                                   UNICHARSET* unicharset) {
+  const int num_strings = strings.size();
+  std::vector<std::vector<std::string>> normalized(num_strings);
+  std::vector<char> normalized_ok(num_strings);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 64) \
+    if (num_threads > 1)
+#endif
+  for (int i = 0; i < num_strings; ++i) {
+    normalized_ok[i] = NormalizeCleanAndSegmentUTF8(
+        UnicodeNormMode::kNFC, OCRNorm::kNone,
+        static_cast<GraphemeNormMode>(norm_mode),
+        /*report_errors*/ true, strings[i].string(), &normalized[i]);
+  }
+  for (int i = 0; i < num_strings; ++i) {
+    if (normalized_ok[i]) {
+      for (const std::string& normed : normalized[i]) {
 
        // normed is a UTF-8 encoded string
         if (normed.empty() || IsUTF8Whitespace(normed.c_str())) continue;
@@ -60,10 +82,64 @@ static void AddStringsToUnicharset(const GenericVector<STRING>& strings,
   }
 }
 
+// Helper adds the lines of a plain text file to the unicharset, starting with
+// the already read first_line, reading the rest of the file in rounds of
+// lines so the whole file is never in memory at once. Empty lines are
+// skipped, as with STRING::split.
+static void AddTextFileToUnicharset(const std::string& first_line,
+                                    std::ifstream* file, int norm_mode,
+                                    int num_threads, UNICHARSET* unicharset) {
+  const int round_size = num_threads * kNormLinesPerThread;
+  GenericVector<STRING> lines;
+  lines.push_back(STRING(first_line.c_str()));
+  std::string line;
+  while (std::getline(*file, line)) {
+    if (line.empty()) continue;
+    lines.push_back(STRING(line.c_str()));
+    if (lines.size() >= round_size) {
+      AddStringsToUnicharset(lines, norm_mode, num_threads, unicharset);
+      lines.truncate(0);
+    }
+  }
+  AddStringsToUnicharset(lines, norm_mode, num_threads, unicharset);
+}
+
 static int Main(int argc, char** argv) {
   UNICHARSET unicharset;
+  int num_threads = std::max(1, static_cast<int>(FLAGS_norm_threads));
+#ifndef _OPENMP
+  num_threads = 1;
+#endif
   // Load input files
   for (int arg = 1; arg < argc; ++arg) {
+    std::ifstream file(argv[arg], std::ios::binary);
+    if (!file) {
+      tprintf("Failed to read data from: %s\n", argv[arg]);
+      continue;
+    }
+    // A box file can only be recognized by parsing it all, but a file whose
+    // first line is not a box is plain text, which is streamed, as text
+    // corpora can be much bigger than box files.
+    std::string first_line;
+    bool any_data = false;
+    while (std::getline(file, first_line)) {
+      any_data = true;
+      if (!first_line.empty()) break;
+    }
+    if (!any_data) continue;
+    int page;
+    STRING utf8_str;
+    TBOX box;
+    if (first_line.empty() ||
+        !ParseBoxFileStr(first_line.c_str(), &page, &utf8_str, &box)) {
+      tprintf("Extracting unicharset from plain text file %s\n", argv[arg]);
+      if (!first_line.empty()) {
+        AddTextFileToUnicharset(first_line, &file, FLAGS_norm_mode,
+                                num_threads, &unicharset);
+      }
+      continue;
+    }
+    file.close();
     STRING file_data = tesseract::ReadFile(argv[arg], /*reader*/ nullptr);
     if (file_data.length() == 0) continue;
     GenericVector<STRING> texts;
@@ -76,7 +152,7 @@ static int Main(int argc, char** argv) {
       texts.truncate(0);
       file_data.split('\n', &texts);
     }
-    AddStringsToUnicharset(texts, FLAGS_norm_mode, &unicharset);
+    AddStringsToUnicharset(texts, FLAGS_norm_mode, num_threads, &unicharset);
   }
   SetupBasicProperties(/*report_errors*/ true, /*decompose*/ false,
                        &unicharset);
@@ -101,7 +177,7 @@ int main(int argc, char** argv) {
   if (argc < 2) {
     tprintf(
         "Usage: %s [--output_unicharset filename] [--norm_mode mode]"
-        " box_or_text_file [...]\n",
+        " [--norm_threads n] box_or_text_file [...]\n",
         argv[0]);
     tprintf("Where mode means:\n");
     tprintf(" 1=combine graphemes (use for Latin and other simple scripts)\n");
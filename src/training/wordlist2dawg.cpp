@@ -34,13 +34,18 @@ int main(int argc, char** argv) {
   if (argc > 1 && (!strcmp(argv[1], "-v") || !strcmp(argv[1], "--version"))) {
     printf("%s\n", tesseract::TessBaseAPI::Version());
     return 0;
-  } else if (!(argc == 4 || (argc == 5 && strcmp(argv[1], "-t") == 0) ||
-             (argc == 6 && strcmp(argv[1], "-r") == 0))) {
+  } else if (!(argc == 4 ||
+                 (argc == 5 && (strcmp(argv[1], "-t") == 0 ||
+                                strcmp(argv[1], "-s") == 0)) ||
+                 (argc == 6 && strcmp(argv[1], "-r") == 0))) {
     printf("Usage: %s -v | --version |\n"
-           "       %s [-t | -r [reverse policy] ] word_list_file"
+           "       %s [-t | -s | -r [reverse policy] ] word_list_file"
            " dawg_file unicharset_file\n", argv[0], argv[0]);
     return 1;
   }
+  // With -s the word list must be sorted (as by LC_ALL=C sort), and the dawg
+  // is built from it in a single pass, without building a trie.
+  bool sorted = argc == 5 && strcmp(argv[1], "-s") == 0;
   tesseract::Classify *classify = new tesseract::Classify();
   int argv_index = 0;
   if (argc == 5) ++argv_index;
@@ -65,7 +70,24 @@ int main(int argc, char** argv) {
     return 1;
   }
   const UNICHARSET &unicharset = classify->getDict().getUnicharset();
-  if (argc == 4 || argc == 6) {
+  if (sorted) {
+    tesseract::Trie trie(
+        // the first 3 arguments are not used in this case
+        tesseract::DAWG_TYPE_WORD, "", SYSTEM_DAWG_PERM,
+        unicharset.size(), classify->getDict().dawg_debug_level);
+    tprintf("Building SquishedDawg from sorted word list '%s'\n",
+            wordlist_filename);
+    tesseract::SquishedDawg *dawg = trie.read_sorted_word_list_to_dawg(
+        wordlist_filename, unicharset, reverse_policy);
+    if (dawg == nullptr) {
+      tprintf("Failed to build dawg from sorted word list '%s'\n",
+              wordlist_filename);
+      exit(1);
+    }
+    tprintf("Writing squished DAWG to '%s'\n", dawg_filename);
+    dawg->write_squished_dawg(dawg_filename);
+    delete dawg;
+  } else if (argc == 4 || argc == 6) {
     tesseract::Trie trie(
         // the first 3 arguments are not used in this case
         tesseract::DAWG_TYPE_WORD, "", SYSTEM_DAWG_PERM,
@@ -85,7 +107,7 @@ int main(int argc, char** argv) {
       tprintf("Dawg is empty, skip producing the output file\n");
     }
     delete dawg;
-  } else if (argc == 5) {
+  } else if (argc == 5) {  // -t
     tprintf("Loading dawg DAWG from '%s'\n", dawg_filename);
     tesseract::SquishedDawg words(
         dawg_filename,
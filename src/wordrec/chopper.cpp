@@ -24,6 +24,7 @@
 #include "blamer.h"    // for BlamerBundle, IRR_CORRECT
 #include "blobs.h"     // for TPOINT, TBLOB, EDGEPT, TESSLINE, divisible_blob
 #include "callcpp.h"   // for Red
+#include "counters.h"  // for CountEvent, COUNTER_CHOP_ATTEMPTS
 #include "dict.h"      // for Dict
 #include "lm_pain_points.h" // for LMPainPoints
 #include "lm_state.h"  // for BestChoiceBundle
@@ -211,6 +212,7 @@ namespace tesseract {
 SEAM *Wordrec::attempt_blob_chop(TWERD *word, TBLOB *blob, int32_t blob_number,
                                  bool italic_blob,
                                  const GenericVector<SEAM*>& seams) {
+  CountEvent(COUNTER_CHOP_ATTEMPTS);
   if (repair_unchopped_blobs)
     preserve_outline_tree (blob->outlines);
   TBLOB *other_blob = TBLOB::ShallowCopy(*blob);       /* Make new blob */
@@ -323,13 +325,19 @@ SEAM *Wordrec::chop_overlapping_blob(const GenericVector<TBOX>& boxes,
  * Although the blob is chopped, the returned SEAM is yet to be inserted into
  * word->seam_array and the resulting blobs are unclassified, so this function
  * can be used by ApplyBox as well as during recognition.
+ * If chop_failed is not nullptr, it flags the blobs that could not be chopped
+ * by an earlier call, which are not searched for a seam again, and is updated
+ * with any new failures. A failed chop only depends on the outlines of the
+ * blob and the seams with split points on it, which stay the same until the
+ * blob itself is chopped, so the result is the same as without it.
  */
 SEAM* Wordrec::improve_one_blob(const GenericVector<BLOB_CHOICE*>& blob_choices,
                                 DANGERR *fixpt,
                                 bool split_next_to_fragment,
                                 bool italic_blob,
                                 WERD_RES* word,
-                                int* blob_number) {
+                                int* blob_number,
+                                GenericVector<bool>* chop_failed) {
   float rating_ceiling = FLT_MAX;
   SEAM *seam = nullptr;
   do {
@@ -346,11 +354,14 @@ SEAM* Wordrec::improve_one_blob(const GenericVector<BLOB_CHOICE*>& blob_choices,
     if (*blob_number == -1)
       return nullptr;
 
-    // TODO(rays) it may eventually help to allow italic_blob to be true,
-    seam = chop_numbered_blob(word->chopped_word, *blob_number, italic_blob,
-                              word->seam_array);
-    if (seam != nullptr)
-      return seam;  // Success!
+    if (chop_failed == nullptr || !(*chop_failed)[*blob_number]) {
+      // TODO(rays) it may eventually help to allow italic_blob to be true,
+      seam = chop_numbered_blob(word->chopped_word, *blob_number, italic_blob,
+                                word->seam_array);
+      if (seam != nullptr)
+        return seam;  // Success!
+      if (chop_failed != nullptr) (*chop_failed)[*blob_number] = true;
+    }
     if (blob_choices[*blob_number] == nullptr)
       return nullptr;
     if (!split_point_from_dict) {
@@ -458,7 +469,17 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
                                   LMPainPoints* pain_points,
                                   GenericVector<SegSearchPending>* pending) {
   int blob_number;
+  // Blobs that failed to chop are remembered across iterations, so each blob
+  // is searched for a seam at most once, instead of on every iteration that
+  // it is still among the worst rated.
+  GenericVector<bool> chop_failed;
+  chop_failed.init_to_size(word->ratings->dimension(), false);
+  int num_chops = 0;
   do {  // improvement loop.
+    // Each chop classifies more blobs, which takes long on a big word.
+    if (Cancelled()) break;
+    // The word keeps the best choice of the chops made so far.
+    if (chop_max_iterations > 0 && num_chops >= chop_max_iterations) break;
     // Make a simple vector of BLOB_CHOICEs to make it easy to pick which
     // one to chop.
     GenericVector<BLOB_CHOICE*> blob_choices;
@@ -473,8 +494,10 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
       }
     }
     SEAM* seam = improve_one_blob(blob_choices, &best_choice_bundle->fixpt,
-                                  false, false, word, &blob_number);
+                                  false, false, word, &blob_number,
+                                  &chop_failed);
     if (seam == nullptr) break;
+    ++num_chops;
     // A chop has been made. We have to correct all the data structures to
     // take into account the extra bottom-level blob.
     // Put the seam into the seam_array and correct everything else on the
@@ -483,6 +506,8 @@ void Wordrec::improve_by_chopping(float rating_cert_scale,
     word->InsertSeam(blob_number, seam);
     // Insert a new entry in the beam array.
     best_choice_bundle->beam.insert(new LanguageModelState, blob_number);
+    // Both halves of the chopped blob are new.
+    chop_failed.insert(false, blob_number);
     // Fixpts are outdated, but will get recalculated.
     best_choice_bundle->fixpt.clear();
     // Remap existing pain points.
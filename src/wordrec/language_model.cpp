@@ -505,12 +505,13 @@ ViterbiStateEntry* LanguageModel::GetNextParentVSE(
     LanguageModelFlagsType blob_choice_flags, const UNICHARSET& unicharset,
     WERD_RES* word_res, ViterbiStateEntry_IT* vse_it,
     LanguageModelFlagsType* top_choice_flags) const {
+  const int debug_level = language_model_debug_level;
   for (; !vse_it->cycled_list(); vse_it->forward()) {
     ViterbiStateEntry* parent_vse = vse_it->data();
     // Only consider the parent if it has been updated or
     // if the current ratings cell has just been classified.
     if (!just_classified && !parent_vse->updated) continue;
-    if (language_model_debug_level > 2)
+    if (debug_level > 2)
       parent_vse->Print("Considering");
     // If the parent is non-alnum, then upper counts as lower.
     *top_choice_flags = blob_choice_flags;
@@ -540,7 +541,7 @@ ViterbiStateEntry* LanguageModel::GetNextParentVSE(
     if (parent_vse->competing_vse != nullptr) {
       const BLOB_CHOICE* competing_b = parent_vse->competing_vse->curr_b;
       UNICHAR_ID other_id = competing_b->unichar_id();
-      if (language_model_debug_level >= 5) {
+      if (debug_level >= 5) {
         tprintf("Parent %s has competition %s\n",
                 unicharset.id_to_unichar(parent_id),
                 unicharset.id_to_unichar(other_id));
@@ -549,9 +550,9 @@ ViterbiStateEntry* LanguageModel::GetNextParentVSE(
         // If other_id matches bc wrt position and size, and parent_id, doesn't,
         // don't bind to the current parent.
         if (bc->PosAndSizeAgree(*competing_b, word_res->x_height,
-                                language_model_debug_level >= 5) &&
+                                debug_level >= 5) &&
             !bc->PosAndSizeAgree(*parent_b, word_res->x_height,
-                                language_model_debug_level >= 5))
+                                debug_level >= 5))
           continue;  // Competing blobchoice has a better vertical match.
       }
     }
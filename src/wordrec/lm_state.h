@@ -25,6 +25,7 @@
 #include "associate.h"       // for AssociateStats
 #include "dawg.h"            // for DawgPositionVector
 #include "elst.h"            // for ELIST_ITERATOR, ELISTIZEH, ELIST_LINK
+#include "freelist.h"        // for FREE_LIST_ALLOCATED
 #include "genericvector.h"   // for PointerVector
 #include "lm_consistency.h"  // for LMConsistencyInfo
 #include "ratngs.h"          // for BLOB_CHOICE, PermuterType
@@ -32,6 +33,7 @@
 #include "strngs.h"          // for STRING
 #include "unichar.h"         // for UNICHAR_ID
 #include "unicharset.h"      // for UNICHARSET
+#include <cstddef>           // for size_t
 
 namespace tesseract {
 
@@ -57,12 +59,18 @@ using LanguageModelFlagsType = unsigned char;
 /// that it represents (WERD_CHOICE) can be constructed by following these
 /// parent pointers.
 
+/// Max number of free blocks kept per thread for each of the structs below,
+/// of which the segmentation search creates and destroys thousands for every
+/// word.
+const size_t kLMMaxFreeBlocks = 4096;
+
 /// Struct for storing additional information used by Dawg language model
 /// component. It stores the set of active dawgs in which the sequence of
 /// letters on a path can be found.
 struct LanguageModelDawgInfo {
   LanguageModelDawgInfo(const DawgPositionVector *a, PermuterType pt)
       : active_dawgs(*a), permuter(pt) {}
+  FREE_LIST_ALLOCATED(LanguageModelDawgInfo, kLMMaxFreeBlocks)
   DawgPositionVector active_dawgs;
   PermuterType permuter;
 };
@@ -73,6 +81,7 @@ struct LanguageModelNgramInfo {
   LanguageModelNgramInfo(const char *c, int l, bool p, float nc, float ncc)
     : context(c), context_unichar_step_len(l), pruned(p), ngram_cost(nc),
       ngram_and_classifier_cost(ncc) {}
+  FREE_LIST_ALLOCATED(LanguageModelNgramInfo, kLMMaxFreeBlocks)
   STRING context;  ///< context string
   /// Length of the context measured by advancing using UNICHAR::utf8_step()
   /// (should be at most the order of the character ngram model used).
@@ -123,6 +132,7 @@ struct ViterbiStateEntry : public ELIST_LINK {
     delete ngram_info;
     delete debug_str;
   }
+  FREE_LIST_ALLOCATED(ViterbiStateEntry, kLMMaxFreeBlocks)
   /// Comparator function for sorting ViterbiStateEntry_LISTs in
   /// non-increasing order of costs.
   static int Compare(const void *e1, const void *e2) {
@@ -198,6 +208,7 @@ struct LanguageModelState {
     viterbi_state_entries_prunable_max_cost(FLT_MAX),
     viterbi_state_entries_length(0) {}
   ~LanguageModelState() {}
+  FREE_LIST_ALLOCATED(LanguageModelState, kLMMaxFreeBlocks)
 
   /// Clears the viterbi search state back to its initial conditions.
   void Clear();
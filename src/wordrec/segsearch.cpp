@@ -75,6 +75,8 @@ void Wordrec::SegSearch(WERD_RES* word_res,
       (!SegSearchDone(num_futile_classifications) ||
           (blamer_bundle != nullptr &&
               blamer_bundle->GuidedSegsearchStillGoing()))) {
+    // Stop with the best choice so far if out of time.
+    if (Cancelled()) break;
     // Get the next valid "pain point".
     bool found_nothing = true;
     LMPainPointsType pp_type;
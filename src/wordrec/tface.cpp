@@ -24,6 +24,7 @@
 #include "callcpp.h"
 #include "chop.h"
 #include "featdefs.h"
+#include "initprofile.h"
 #include "pageres.h"
 #include "params_model.h"
 #endif
@@ -43,8 +44,12 @@ void Wordrec::program_editup(const char *textbase,
   if (textbase != nullptr) imagefile = textbase;
 #ifndef DISABLED_LEGACY_ENGINE
   InitFeatureDefs(&feature_defs_);
-  InitAdaptiveClassifier(init_classifier);
+  {
+    InitPhase phase("classifier");
+    InitAdaptiveClassifier(init_classifier);
+  }
   if (init_dict) {
+    InitPhase phase("dictionary");
     getDict().SetupForLoad(Dict::GlobalDawgCache());
     getDict().Load(lang, init_dict);
     getDict().FinishLoad();
@@ -104,6 +104,9 @@ Wordrec::Wordrec() :
                 params()),
   INT_MEMBER(chop_x_y_weight, 3, "X / Y  length weight",
              params()),
+  INT_MEMBER(chop_max_iterations, 0,
+             "Max chops of a word by improve_by_chopping, 0 for no limit",
+             params()),
   INT_MEMBER(segment_adjust_debug, 0, "Segmentation adjustment debug",
              params()),
   BOOL_MEMBER(assume_fixed_pitch_char_segment, false,
@@ -23,6 +23,7 @@
 
 #include <cstdint>             // for int16_t, int32_t
 #include "classify.h"          // for Classify
+#include "ocrclass.h"          // for ETEXT_DESC
 #include "params.h"            // for INT_VAR_H, IntParam, BOOL_VAR_H, BoolP...
 #include "ratngs.h"            // for WERD_CHOICE
 
@@ -44,6 +45,17 @@ class Wordrec : public Classify {
   Wordrec();
   virtual ~Wordrec() = default;
 
+  // Sets the monitor whose deadline and cancel function stop the layout
+  // analysis, the chopper and the segmentation search early, keeping what
+  // they found so far. nullptr for none.
+  void set_monitor(const ETEXT_DESC* monitor) {
+    monitor_ = monitor;
+  }
+  // Returns true if the monitor asks to stop.
+  bool Cancelled() const {
+    return monitor_ != nullptr && monitor_->cancelled(0);
+  }
+
   // tface.cpp
   void program_editup(const char *textbase, TessdataManager *init_classifier,
                       TessdataManager *init_dict);
@@ -53,6 +65,8 @@ class Wordrec : public Classify {
 
   // Member variables
   WERD_CHOICE *prev_word_best_choice_;
+  // See set_monitor. Not owned.
+  const ETEXT_DESC* monitor_ = nullptr;
 };
 
 }  // namespace tesseract
@@ -75,6 +89,7 @@ class Wordrec : public Classify {
 #include "genericvector.h"     // for GenericVector
 #include "language_model.h"
 #include "matrix.h"
+#include "ocrclass.h"          // for ETEXT_DESC
 #include "oldlist.h"           // for LIST
 #include "params.h"            // for INT_VAR_H, IntParam, BOOL_VAR_H, BoolP...
 #include "points.h"            // for ICOORD
@@ -225,6 +240,8 @@ class Wordrec : public Classify {
   double_VAR_H(chop_ok_split, 100.0, "OK split limit");
   double_VAR_H(chop_good_split, 50.0, "Good split limit");
   INT_VAR_H(chop_x_y_weight, 3, "X / Y  length weight");
+  INT_VAR_H(chop_max_iterations, 0,
+            "Max chops of a word by improve_by_chopping, 0 for no limit");
   INT_VAR_H(segment_adjust_debug, 0, "Segmentation adjustment debug");
   BOOL_VAR_H(assume_fixed_pitch_char_segment, false,
              "include fixed-pitch heuristics in char segmentation");
@@ -250,6 +267,17 @@ class Wordrec : public Classify {
   Wordrec();
   ~Wordrec() override = default;
 
+  // Sets the monitor whose deadline and cancel function stop the layout
+  // analysis, the chopper and the segmentation search early, keeping what
+  // they found so far. nullptr for none.
+  void set_monitor(const ETEXT_DESC* monitor) {
+    monitor_ = monitor;
+  }
+  // Returns true if the monitor asks to stop.
+  bool Cancelled() const {
+    return monitor_ != nullptr && monitor_->cancelled(0);
+  }
+
   // Fills word->alt_choices with alternative paths found during
   // chopping/segmentation search that are kept in best_choices.
   void SaveAltChoices(const LIST &best_choices, WERD_RES *word);
@@ -382,7 +410,8 @@ class Wordrec : public Classify {
                          bool split_next_to_fragment,
                          bool italic_blob,
                          WERD_RES *word,
-                         int *blob_number);
+                         int *blob_number,
+                         GenericVector<bool>* chop_failed = nullptr);
   SEAM *chop_one_blob(const GenericVector<TBOX> &boxes,
                       const GenericVector<BLOB_CHOICE*> &blob_choices,
                       WERD_RES *word_res,
@@ -479,6 +508,8 @@ class Wordrec : public Classify {
   // This variable is modified by PAGE_RES_IT when iterating over
   // words to OCR on the page.
   WERD_CHOICE *prev_word_best_choice_;
+  // See set_monitor. Not owned.
+  const ETEXT_DESC* monitor_ = nullptr;
   // Sums of blame reasons computed by the blamer.
   GenericVector<int> blame_reasons_;
   // Function used to fill char choice lattices.
@@ -40,6 +40,14 @@ void build(Solution &s)
 
         libtesseract -=
             "src/api/tesseractmain.cpp",
+            "src/arch/activationavx512.cpp",
+            "src/arch/activationneon.cpp",
+            "src/arch/classprunerneon.cpp",
+            "src/arch/dotproductneon.cpp",
+            "src/arch/intsimdmatrixavx512.cpp",
+            "src/arch/intsimdmatrixneon.cpp",
+            "src/arch/quantizeneon.cpp",
+            "src/arch/selectionneon.cpp",
             "src/viewer/svpaint.cpp";
 
         libtesseract.Public +=
@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////
+// File:        arch_benchmark.cc
+// Description: Throughput of the dot product, int matrix and gradient code.
+//
+// (C) Copyright 2019, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+// Measures the speed of each of the available dot product and int matrix
+// implementations (as selected by the dotproduct config variable) on the
+// weight matrix shapes of LSTM models, and prints a table of the results in
+// GFLOP/s (float) or GOPS (int8), counting a multiply-add as 2 operations.
+// The last two columns are the weight gradient of a line of kOuterSamples
+// timesteps, by a plain row-by-row loop of dot products, and by
+// WeightMatrix::SumOuterTransposed.
+//
+// Usage: arch_benchmark [model.traineddata | <outputs>x<inputs>] ...
+// Without arguments, the eng and chi_sim models of tessdata and tessdata_best
+// are used if they are found.
+
+#include <algorithm>  // for std::sort, std::unique
+#include <chrono>     // for std::chrono::steady_clock
+#include <cstdio>     // for printf
+#include <functional> // for std::function
+#include <string>     // for std::string
+#include <utility>    // for std::pair
+#include <vector>     // for std::vector
+#include "genericvector.h"
+#include "helpers.h"         // for TRand
+#include "intsimdmatrix.h"   // for IntSimdMatrix
+#include "lstmrecognizer.h"  // for LSTMRecognizer
+#include "matrix.h"          // for GENERIC_2D_ARRAY
+#include "params.h"          // for ParamUtils
+#include "simddetect.h"      // for SIMDDetect, DotProduct
+#include "tessdatamanager.h" // for TessdataManager
+#include "weightmatrix.h"    // for WeightMatrix
+
+#ifndef TESSDATA_DIR
+#define TESSDATA_DIR "../tessdata"
+#endif
+#ifndef TESSDATA_BEST_DIR
+#define TESSDATA_BEST_DIR "../tessdata_best"
+#endif
+
+namespace tesseract {
+
+// Minimum time spent timing each kernel on each shape.
+const double kMinSeconds = 0.05;
+// Number of timesteps in the weight gradient, typical of a training line.
+const int kOuterSamples = 500;
+
+using Shape = std::pair<int, int>;
+
+// Receives the results, so the computation is not optimized away.
+static volatile double sink;
+
+// Appends the weight matrix shapes of the LSTM model in the given traineddata
+// file to shapes. Returns false if it can't be loaded.
+static bool AddModelShapes(const char* filename, std::vector<Shape>* shapes) {
+  TessdataManager mgr;
+  if (!mgr.Init(filename) || !mgr.IsLSTMAvailable()) return false;
+  LSTMRecognizer recognizer;
+  if (!recognizer.Load(nullptr, nullptr, &mgr)) return false;
+  std::vector<Shape> model_shapes;
+  recognizer.MatrixShapes(&model_shapes);
+  printf("%s (%s):", filename, recognizer.IsIntMode() ? "int" : "float");
+  for (const auto& shape : model_shapes) {
+    printf(" %dx%d", shape.first, shape.second);
+  }
+  printf("\n");
+  shapes->insert(shapes->end(), model_shapes.begin(), model_shapes.end());
+  return true;
+}
+
+// Runs func repeatedly for at least kMinSeconds and returns the number of
+// operations per second in units of 1e9, given ops operations per call.
+static double Rate(double ops, const std::function<void()>& func) {
+  func();  // Warm up the caches.
+  int reps = 1;
+  for (;;) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) func();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (elapsed.count() >= kMinSeconds) {
+      return ops * reps / elapsed.count() / 1e9;
+    }
+    reps *= 2;
+  }
+}
+
+// Times all the kernels on a matrix of the given shape with the
+// currently selected code, and prints a row of the results.
+static void BenchmarkShape(const Shape& shape, TRand* randomizer) {
+  const int num_out = shape.first;
+  const int num_in = shape.second;
+  const double ops = 2.0 * num_out * num_in;
+  // Raw dot products with the weights as rows of a matrix.
+  std::vector<double> wd(num_out * (num_in + 1));
+  for (auto& w : wd) w = randomizer->SignedRand(0.5);
+  std::vector<float> wf(wd.begin(), wd.end());
+  std::vector<double> ud(num_in);
+  for (auto& u : ud) u = randomizer->SignedRand(1.0);
+  std::vector<float> uf(ud.begin(), ud.end());
+  std::vector<double> v(num_out + 64);
+  double dot = Rate(ops, [&]() {
+    for (int i = 0; i < num_out; ++i) {
+      v[i] = DotProduct(&ud[0], &wd[i * (num_in + 1)], num_in);
+    }
+    sink = v[0];
+  });
+  double dot_float = Rate(ops, [&]() {
+    for (int i = 0; i < num_out; ++i) {
+      v[i] = DotProductFloat(&uf[0], &wf[i * (num_in + 1)], num_in);
+    }
+    sink = v[0];
+  });
+  // Raw int matrix code.
+  const IntSimdMatrix* matrix = IntSimdMatrix::intSimdMatrix;
+  GENERIC_2D_ARRAY<int8_t> wi(num_out, num_in + 1, 0);
+  for (int i = 0; i < num_out; ++i) {
+    for (int j = 0; j <= num_in; ++j) {
+      wi(i, j) = static_cast<int8_t>(randomizer->SignedRand(INT8_MAX));
+    }
+  }
+  GenericVector<double> scales;
+  scales.init_to_size(num_out, 1.0 / INT8_MAX);
+  std::vector<int8_t> shaped_w;
+  if (matrix != nullptr) matrix->Init(wi, shaped_w);
+  std::vector<int8_t> ui(matrix != nullptr ? matrix->RoundInputs(num_in)
+                                           : num_in, 0);
+  for (int j = 0; j < num_in; ++j) {
+    ui[j] = static_cast<int8_t>(randomizer->SignedRand(INT8_MAX));
+  }
+  double int_matrix = Rate(ops, [&]() {
+    if (matrix != nullptr) {
+      matrix->matrixDotVectorFunction(num_out, num_in + 1, &shaped_w[0],
+                                      &scales[0], &ui[0], &v[0]);
+    } else {
+      IntSimdMatrix::MatrixDotVector(wi, scales, &ui[0], &v[0]);
+    }
+    sink = v[0];
+  });
+  // WeightMatrix in each of its inference modes.
+  WeightMatrix weights;
+  weights.InitWeightsFloat(num_out, num_in + 1, false, 0.5f, randomizer);
+  double weights_double = Rate(ops, [&]() {
+    weights.MatrixDotVector(&ud[0], &v[0]);
+    sink = v[0];
+  });
+  // Weight gradient of a line, with the errors and inputs transposed.
+  const double outer_ops = ops * kOuterSamples;
+  TransposedArray errors_t, inputs_t;
+  errors_t.Resize(num_out, kOuterSamples, 0.0);
+  inputs_t.Resize(num_in, kOuterSamples, 0.0);
+  for (int t = 0; t < kOuterSamples; ++t) {
+    for (int i = 0; i < num_out; ++i) {
+      errors_t(i, t) = randomizer->SignedRand(1.0);
+    }
+    for (int j = 0; j < num_in; ++j) {
+      inputs_t(j, t) = randomizer->SignedRand(1.0);
+    }
+  }
+  GENERIC_2D_ARRAY<double> dw(num_out, num_in + 1, 0.0);
+  double outer_ref = Rate(outer_ops, [&]() {
+    for (int i = 0; i < num_out; ++i) {
+      for (int j = 0; j < num_in; ++j) {
+        dw(i, j) = DotProduct(errors_t[i], inputs_t[j], kOuterSamples);
+      }
+    }
+    sink = dw(0, 0);
+  });
+  double outer = Rate(outer_ops, [&]() {
+    weights.SumOuterTransposed(errors_t, inputs_t, true);
+  });
+  weights.ConvertToFloat32();
+  double weights_float = Rate(ops, [&]() {
+    weights.MatrixDotVector(&uf[0], &v[0]);
+    sink = v[0];
+  });
+  weights.ConvertToInt();
+  std::vector<int8_t> uw(weights.RoundInputs(num_in), 0);
+  std::copy(ui.begin(), ui.begin() + num_in, uw.begin());
+  double weights_int = Rate(ops, [&]() {
+    weights.MatrixDotVector(&uw[0], &v[0]);
+    sink = v[0];
+  });
+  printf("%5dx%-5d %-18s %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+         num_out, num_in, SIMDDetect::KernelName(), dot, dot_float,
+         int_matrix, weights_double, weights_float, weights_int, outer_ref,
+         outer);
+}
+
+static int Main(int argc, char** argv) {
+  std::vector<Shape> shapes;
+  for (int arg = 1; arg < argc; ++arg) {
+    int num_out, num_in;
+    char extra;
+    if (sscanf(argv[arg], "%dx%d%c", &num_out, &num_in, &extra) == 2) {
+      shapes.emplace_back(num_out, num_in);
+    } else if (!AddModelShapes(argv[arg], &shapes)) {
+      fprintf(stderr, "Can't load LSTM model from %s\n", argv[arg]);
+      return 1;
+    }
+  }
+  if (argc <= 1) {
+    const char* kModels[] = {
+      TESSDATA_DIR "/eng.traineddata", TESSDATA_DIR "/chi_sim.traineddata",
+      TESSDATA_BEST_DIR "/eng.traineddata",
+      TESSDATA_BEST_DIR "/chi_sim.traineddata"};
+    for (const char* model : kModels) AddModelShapes(model, &shapes);
+  }
+  std::sort(shapes.begin(), shapes.end());
+  shapes.erase(std::unique(shapes.begin(), shapes.end()), shapes.end());
+  if (shapes.empty()) {
+    fprintf(stderr,
+            "Usage: %s [model.traineddata | <outputs>x<inputs>] ...\n",
+            argv[0]);
+    return 1;
+  }
+  printf("\n%-11s %-18s %9s %9s %9s %9s %9s %9s %9s %9s\n", "shape",
+         "dotproduct", "dot", "dot_f32", "int8", "wm", "wm_f32", "wm_int8",
+         "outer", "wm_outer");
+  TRand randomizer;
+  for (const char* method : SIMDDetect::AvailableMethods()) {
+    ParamUtils::SetParam("dotproduct", method, SET_PARAM_CONSTRAINT_NONE,
+                         GlobalParams());
+    SIMDDetect::Update();
+    for (const auto& shape : shapes) {
+      randomizer.set_seed(shape.first * 1000 + shape.second);
+      BenchmarkShape(shape, &randomizer);
+    }
+  }
+  return 0;
+}
+
+}  // namespace tesseract
+
+int main(int argc, char** argv) {
+  return tesseract::Main(argc, argv);
+}
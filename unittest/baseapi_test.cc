@@ -9,7 +9,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -25,6 +27,7 @@
 #include "log.h"        // for LOG
 #include "ocrblock.h"   // for class BLOCK
 #include "pageres.h"
+#include "renderer.h"   // for TessTextRenderer
 
 namespace {
 
@@ -145,6 +148,169 @@ TEST_F(TesseractTest, HOCRContainsBaseline) {
   pixDestroy(&src_pix);
 }
 
+// The hOCR, ALTO and TSV written to a stream should be the same as the
+// strings, and the stream should keep its own locale and precision.
+TEST_F(TesseractTest, StreamedOutputMatchesStrings) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  Pix* src_pix = pixRead(TestDataNameToPath("HelloGoogle.tif").c_str());
+  CHECK(src_pix);
+  api.SetInputName("HelloGoogle.tif");
+  api.SetImage(src_pix);
+  std::unique_ptr<char[]> hocr(api.GetHOCRText(0));
+  std::unique_ptr<char[]> alto(api.GetAltoText(0));
+  std::unique_ptr<char[]> tsv(api.GetTSVText(0));
+  ASSERT_TRUE(hocr != nullptr && alto != nullptr && tsv != nullptr);
+  EXPECT_THAT(hocr.get(), HasSubstr("Hello"));
+
+  std::stringstream hocr_stream, alto_stream, tsv_stream;
+  hocr_stream.precision(3);
+  EXPECT_TRUE(api.GetHOCRText(nullptr, 0, hocr_stream));
+  EXPECT_TRUE(api.GetAltoText(nullptr, 0, alto_stream));
+  EXPECT_TRUE(api.GetTSVText(0, tsv_stream));
+  EXPECT_EQ(hocr.get(), hocr_stream.str());
+  EXPECT_EQ(alto.get(), alto_stream.str());
+  EXPECT_EQ(tsv.get(), tsv_stream.str());
+  EXPECT_EQ(3, hocr_stream.precision());
+  pixDestroy(&src_pix);
+}
+
+// Reads the records of a page of tbr output, and returns the text of its
+// words separated by spaces, or an empty string if the data is malformed.
+static std::string ReadTbrWords(const std::string& data, int* num_choices) {
+  size_t pos = 0;
+  auto skip = [&data, &pos](size_t size) {
+    pos += size;
+    return pos <= data.size();
+  };
+  auto read_int = [&data, &pos]() {
+    uint32_t value = 0;
+    for (int i = 0; i < 4 && pos < data.size(); ++i, ++pos)
+      value |= static_cast<uint32_t>(static_cast<uint8_t>(data[pos])) << (8 * i);
+    return static_cast<int32_t>(value);
+  };
+  std::string words;
+  *num_choices = 0;
+  while (pos < data.size()) {
+    int tag = data[pos++];
+    bool ok = true;
+    if (tag == tesseract::kTbrPage) {
+      ok = skip(20);
+    } else if (tag == tesseract::kTbrBlock || tag == tesseract::kTbrPara) {
+      ok = skip(17);
+    } else if (tag == tesseract::kTbrLine) {
+      ok = skip(45);
+    } else if (tag == tesseract::kTbrWord) {
+      if (!words.empty()) words += ' ';
+      ok = skip(21);
+    } else if (tag == tesseract::kTbrSymbol || tag == tesseract::kTbrChoice) {
+      ok = skip(tag == tesseract::kTbrSymbol ? 20 : 4);
+      int length = read_int();
+      ok = ok && length >= 0 && pos + length <= data.size();
+      if (ok && tag == tesseract::kTbrSymbol)
+        words.append(data, pos, length);
+      if (tag == tesseract::kTbrChoice) ++*num_choices;
+      ok = ok && skip(length);
+    } else if (tag == tesseract::kTbrEndPage) {
+      return pos == data.size() ? words : "";
+    } else {
+      ok = false;
+    }
+    if (!ok) return "";
+  }
+  return "";
+}
+
+// The tbr output should have the same words as the text, and the choices of
+// the symbols when asked for.
+TEST_F(TesseractTest, BinaryResultTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  // The LSTM only keeps the choices of its symbols in a choice mode.
+  api.SetVariable("lstm_choice_mode", "2");
+  Pix* src_pix = pixRead(TestDataNameToPath("HelloGoogle.tif").c_str());
+  CHECK(src_pix);
+  api.SetImage(src_pix);
+  std::string data;
+  ASSERT_TRUE(api.GetBinaryResult(0, false, &data));
+  int num_choices;
+  EXPECT_EQ("Hello Google", ReadTbrWords(data, &num_choices));
+  EXPECT_EQ(0, num_choices);
+  ASSERT_TRUE(api.GetBinaryResult(0, true, &data));
+  EXPECT_EQ("Hello Google", ReadTbrWords(data, &num_choices));
+  EXPECT_GT(num_choices, 0);
+
+  std::string outputbase = file::JoinPath(FLAGS_test_tmpdir, "binary");
+  {
+    tesseract::TessBinaryRenderer renderer(outputbase.c_str());
+    EXPECT_TRUE(renderer.BeginDocument("binary"));
+    EXPECT_TRUE(renderer.AddImage(&api));
+    EXPECT_TRUE(renderer.EndDocument());
+  }
+  std::string file_data;
+  CHECK_OK(file::GetContents(outputbase + ".tbr", &file_data,
+                             file::Defaults()));
+  ASSERT_GT(file_data.size(), 4);
+  EXPECT_EQ(std::string("TBR\1", 4), file_data.substr(0, 4));
+  EXPECT_EQ("Hello Google", ReadTbrWords(file_data.substr(4), &num_choices));
+  pixDestroy(&src_pix);
+}
+
+// The result arrays of the words and symbols should have the same text,
+// boxes and confidences as the iterator, and the symbols of each word.
+TEST_F(TesseractTest, ResultArraysTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  api.SetImage(src_pix);
+  tesseract::ResultArrays words, symbols, lines;
+  ASSERT_TRUE(api.GetResultArrays(tesseract::RIL_WORD, &words));
+  ASSERT_TRUE(api.GetResultArrays(tesseract::RIL_SYMBOL, &symbols));
+  ASSERT_TRUE(api.GetResultArrays(tesseract::RIL_TEXTLINE, &lines));
+  ASSERT_GT(words.size(), 0);
+  EXPECT_EQ(4 * words.size(), words.boxes.size());
+  EXPECT_EQ(words.size() + 1, words.text_offsets.size());
+
+  std::unique_ptr<tesseract::ResultIterator> it(api.GetIterator());
+  int w = 0;
+  do {
+    ASSERT_LT(w, words.size());
+    std::unique_ptr<char[]> text(it->GetUTF8Text(tesseract::RIL_WORD));
+    EXPECT_EQ(text.get(), words.text.substr(words.text_offsets[w],
+                                            words.text_offsets[w + 1] -
+                                                words.text_offsets[w]));
+    int left, top, right, bottom;
+    it->BoundingBox(tesseract::RIL_WORD, &left, &top, &right, &bottom);
+    EXPECT_EQ(left, words.boxes[4 * w]);
+    EXPECT_EQ(bottom, words.boxes[4 * w + 3]);
+    EXPECT_EQ(it->Confidence(tesseract::RIL_WORD), words.confidences[w]);
+    ++w;
+  } while (it->Next(tesseract::RIL_WORD));
+  EXPECT_EQ(w, words.size());
+
+  // The symbols of each word are its text, and the words are in lines.
+  std::vector<std::string> word_texts(words.size());
+  for (int s = 0; s < symbols.size(); ++s) {
+    int word = symbols.parents[s];
+    ASSERT_TRUE(word >= 0 && word < words.size());
+    word_texts[word] += symbols.text.substr(
+        symbols.text_offsets[s],
+        symbols.text_offsets[s + 1] - symbols.text_offsets[s]);
+  }
+  for (int i = 0; i < words.size(); ++i) {
+    EXPECT_EQ(word_texts[i], words.text.substr(words.text_offsets[i],
+                                               words.text_offsets[i + 1] -
+                                                   words.text_offsets[i]));
+    EXPECT_TRUE(words.parents[i] >= 0 && words.parents[i] < lines.size());
+    if (i > 0) {
+      EXPECT_GE(words.parents[i], words.parents[i - 1]);
+    }
+  }
+  EXPECT_THAT(lines.text, HasSubstr("quick brown"));
+  pixDestroy(&src_pix);
+}
+
 // A provided document we once misread "RICK SNYDER" as "FUCK SNYDER"
 // causing a bit of an embarrassment.  This was due to bad baseline fitting
 // which has been addressed by both better baseline finding and by
@@ -227,6 +393,409 @@ TEST_F(TesseractTest, BasicLSTMTest) {
   pixDestroy(&src_pix);
 }
 
+// Tests that a kept layout gives the same text as a fresh one when the page
+// is recognized again with another engine mode, and is dropped by SetImage.
+TEST_F(TesseractTest, KeepLayoutTest) {
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  tesseract::TessBaseAPI fresh_api;
+  fresh_api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string fresh_text = GetCleanedTextResult(&fresh_api, src_pix);
+
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_TESSERACT_ONLY);
+  api.SetKeepLayout(true);
+  std::string ocr_text = GetCleanedTextResult(&api, src_pix);
+  EXPECT_FALSE(ocr_text.empty());
+  EXPECT_TRUE(api.HasKeptLayout());
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  EXPECT_EQ(0, api.Recognize(nullptr));
+  char* result = api.GetUTF8Text();
+  ocr_text = result;
+  delete[] result;
+  absl::StripAsciiWhitespace(&ocr_text);
+  EXPECT_STREQ(fresh_text.c_str(), ocr_text.c_str());
+  EXPECT_TRUE(api.HasKeptLayout());
+  api.SetImage(src_pix);
+  EXPECT_FALSE(api.HasKeptLayout());
+  pixDestroy(&src_pix);
+}
+
+// Tests that the adaptive thresholding methods recognize a clean page as well
+// as Otsu, also with several threads.
+TEST_F(TesseractTest, AdaptiveThresholdingTest) {
+  std::string truth_text;
+  CHECK_OK(file::GetContents(TestDataNameToPath("phototest.gold.txt"),
+                             &truth_text, file::Defaults()));
+  absl::StripAsciiWhitespace(&truth_text);
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  for (const char* method : {"1", "2"}) {
+    tesseract::TessBaseAPI api;
+    api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+    api.SetVariable("thresholding_method", method);
+    api.SetVariable("tessedit_num_threads", "3");
+    std::string ocr_text = GetCleanedTextResult(&api, src_pix);
+    EXPECT_STREQ(truth_text.c_str(), ocr_text.c_str()) << method;
+  }
+  pixDestroy(&src_pix);
+}
+
+// Tests that a color page over the image memory limit is recognized from grey,
+// and that a page that doesn't fit even so is rejected.
+TEST_F(TesseractTest, ImageMemoryLimitTest) {
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  Pix* color_pix = pixConvertTo32(src_pix);
+  pixDestroy(&src_pix);
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string color_text = GetCleanedTextResult(&api, color_pix);
+  EXPECT_EQ(32, pixGetDepth(api.GetInputImage()));
+
+  // A limit that fits the grey and binary images, but not the color one.
+  int64_t num_pixels = pixGetWidth(color_pix) * pixGetHeight(color_pix);
+  int limit_mb = static_cast<int>((num_pixels * 9 / 8) >> 20) + 1;
+  ASSERT_GT(num_pixels * 41 / 8, static_cast<int64_t>(limit_mb) << 20);
+  api.SetVariable("image_memory_limit_mb", std::to_string(limit_mb).c_str());
+  std::string grey_text = GetCleanedTextResult(&api, color_pix);
+  EXPECT_EQ(8, pixGetDepth(api.GetInputImage()));
+  EXPECT_STREQ(color_text.c_str(), grey_text.c_str());
+
+  Pix* big_pix = pixScale(color_pix, 4.0f, 4.0f);
+  api.SetImage(big_pix);
+  EXPECT_EQ(nullptr, api.GetInputImage());
+  EXPECT_EQ(nullptr, api.GetUTF8Text());
+  pixDestroy(&big_pix);
+  pixDestroy(&color_pix);
+}
+
+// Tests that the work caps make a page give no text instead of taking long,
+// and that generous ones leave the text as it is.
+TEST_F(TesseractTest, WorkCapsTest) {
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string text = GetCleanedTextResult(&api, src_pix);
+  EXPECT_FALSE(text.empty());
+
+  api.SetVariable("textord_max_page_blobs", "10");
+  EXPECT_STREQ("", GetCleanedTextResult(&api, src_pix).c_str());
+  api.SetVariable("textord_max_page_blobs", "0");
+  api.SetVariable("lstm_max_line_timesteps", "2");
+  EXPECT_STREQ("", GetCleanedTextResult(&api, src_pix).c_str());
+  api.SetVariable("lstm_max_line_timesteps", "20000");
+  EXPECT_STREQ(text.c_str(), GetCleanedTextResult(&api, src_pix).c_str());
+  pixDestroy(&src_pix);
+}
+
+// Tests that an over-sampled page is recognized at a reduced size, with the
+// word boxes in the coordinates of the input image.
+TEST_F(TesseractTest, AutoDownscaleTest) {
+  std::string truth_text;
+  CHECK_OK(file::GetContents(TestDataNameToPath("phototest.gold.txt"),
+                             &truth_text, file::Defaults()));
+  absl::StripAsciiWhitespace(&truth_text);
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  Pix* grey_pix = pixConvertTo8(src_pix, false);
+  pixDestroy(&src_pix);
+  Pix* big_pix = pixScale(grey_pix, 3.0f, 3.0f);
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  api.SetVariable("tessedit_auto_downscale", "1");
+  std::string ocr_text = GetCleanedTextResult(&api, big_pix);
+  EXPECT_STREQ(truth_text.c_str(), ocr_text.c_str());
+  Pix* binary_pix = api.GetThresholdedImage();
+  EXPECT_LT(pixGetWidth(binary_pix), pixGetWidth(big_pix));
+  pixDestroy(&binary_pix);
+  std::unique_ptr<tesseract::ResultIterator> it(api.GetIterator());
+  ASSERT_TRUE(it != nullptr);
+  int left, top, right, bottom;
+  int max_right = 0;
+  do {
+    ASSERT_TRUE(it->BoundingBox(tesseract::RIL_WORD, &left, &top, &right,
+                                &bottom));
+    max_right = std::max(max_right, right);
+  } while (it->Next(tesseract::RIL_WORD));
+  EXPECT_GT(max_right, pixGetWidth(big_pix) / 2);
+  EXPECT_LE(max_right, pixGetWidth(big_pix));
+
+  // A page of ordinary text size is not reduced.
+  EXPECT_STREQ(truth_text.c_str(),
+               GetCleanedTextResult(&api, grey_pix).c_str());
+  binary_pix = api.GetThresholdedImage();
+  EXPECT_EQ(pixGetWidth(grey_pix), pixGetWidth(binary_pix));
+  pixDestroy(&binary_pix);
+  pixDestroy(&big_pix);
+  pixDestroy(&grey_pix);
+}
+
+// Tests that a blank page is rejected with a reason before layout analysis,
+// and that a page of text is not.
+TEST_F(TesseractTest, BlankPageRejectTest) {
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  api.SetVariable("textord_blank_page_reject", "1");
+  std::string text = GetCleanedTextResult(&api, src_pix);
+  EXPECT_FALSE(text.empty());
+  EXPECT_EQ(nullptr, api.GetBlankPageReason());
+
+  Pix* blank_pix = pixCreate(2550, 3300, 1);
+  pixSetResolution(blank_pix, 300, 300);
+  EXPECT_STREQ("", GetCleanedTextResult(&api, blank_pix).c_str());
+  EXPECT_STREQ("no ink", api.GetBlankPageReason());
+  // A few specks of noise are not text either.
+  pixRasterop(blank_pix, 100, 100, 3, 3, PIX_SET, nullptr, 0, 0);
+  pixRasterop(blank_pix, 2000, 3000, 2, 2, PIX_SET, nullptr, 0, 0);
+  EXPECT_STREQ("", GetCleanedTextResult(&api, blank_pix).c_str());
+  EXPECT_STREQ("no text-sized components", api.GetBlankPageReason());
+  pixDestroy(&blank_pix);
+  pixDestroy(&src_pix);
+}
+
+// Tests that a greyscale image given as a view of a caller's buffer, with
+// padded lines, gives the same text as the same image given as a Pix.
+TEST_F(TesseractTest, SetImageViewTest) {
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  Pix* grey_pix = pixConvertTo8(src_pix, false);
+  pixDestroy(&src_pix);
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string pix_text = GetCleanedTextResult(&api, grey_pix);
+
+  int width = pixGetWidth(grey_pix);
+  int height = pixGetHeight(grey_pix);
+  int bytes_per_line = width + 13;
+  std::vector<unsigned char> buffer(bytes_per_line * height);
+  for (int y = 0; y < height; ++y) {
+    const l_uint32* line = pixGetData(grey_pix) + y * pixGetWpl(grey_pix);
+    for (int x = 0; x < width; ++x)
+      buffer[y * bytes_per_line + x] = GET_DATA_BYTE(line, x);
+  }
+  api.SetImageView(&buffer[0], width, height, bytes_per_line);
+  api.SetSourceResolution(pixGetYRes(grey_pix));
+  char* result = api.GetUTF8Text();
+  std::string view_text = result;
+  delete[] result;
+  absl::StripAsciiWhitespace(&view_text);
+  EXPECT_STREQ(pix_text.c_str(), view_text.c_str());
+  pixDestroy(&grey_pix);
+}
+
+// Tests that reading the pages of a file list ahead of their recognition
+// gives the same text, in the same order, as reading each one when needed.
+TEST_F(TesseractTest, PagePrefetchTest) {
+  std::string filelist = file::JoinPath(FLAGS_test_tmpdir, "prefetch.txt");
+  CHECK_OK(file::WriteStringToFile(
+      absl::StrCat(TestDataNameToPath("HelloGoogle.tif"), "\n",
+                   TestDataNameToPath("phototest.tif"), "\n",
+                   TestDataNameToPath("HelloGoogle.tif"), "\n"),
+      filelist));
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string texts[2];
+  for (int depth = 0; depth < 2; ++depth) {
+    std::string outputbase =
+        file::JoinPath(FLAGS_test_tmpdir, absl::StrCat("prefetch", depth));
+    api.SetVariable("page_prefetch_depth", depth == 0 ? "0" : "2");
+    {
+      tesseract::TessTextRenderer renderer(outputbase.c_str());
+      EXPECT_TRUE(api.ProcessPages(filelist.c_str(), nullptr, 0, &renderer));
+    }
+    CHECK_OK(file::GetContents(outputbase + ".txt", &texts[depth],
+                               file::Defaults()));
+  }
+  EXPECT_THAT(texts[0], HasSubstr("Hello Google"));
+  EXPECT_STREQ(texts[0].c_str(), texts[1].c_str());
+}
+
+// Tests that recognizing the pages of a file list on several engines at once
+// renders the same text, in page order, as recognizing them one at a time.
+TEST_F(TesseractTest, PageParallelTest) {
+  std::string filelist = file::JoinPath(FLAGS_test_tmpdir, "parallel.txt");
+  std::string pages;
+  for (int i = 0; i < 5; ++i) {
+    absl::StrAppend(&pages, TestDataNameToPath("HelloGoogle.tif"), "\n",
+                    TestDataNameToPath("phototest.tif"), "\n");
+  }
+  CHECK_OK(file::WriteStringToFile(pages, filelist));
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string texts[2];
+  for (int i = 0; i < 2; ++i) {
+    std::string outputbase =
+        file::JoinPath(FLAGS_test_tmpdir, absl::StrCat("parallel", i));
+    api.SetVariable("page_parallel_jobs", i == 0 ? "1" : "3");
+    {
+      tesseract::TessTextRenderer renderer(outputbase.c_str());
+      EXPECT_TRUE(api.ProcessPages(filelist.c_str(), nullptr, 0, &renderer));
+      EXPECT_EQ(9, renderer.imagenum());
+    }
+    CHECK_OK(file::GetContents(outputbase + ".txt", &texts[i],
+                               file::Defaults()));
+  }
+  EXPECT_THAT(texts[0], HasSubstr("Hello Google"));
+  EXPECT_STREQ(texts[0].c_str(), texts[1].c_str());
+}
+
+// Tests that encoding the page images of a PDF while the next page is
+// recognized writes the same document as encoding each one in turn.
+TEST_F(TesseractTest, PDFBackgroundImagesTest) {
+  std::string filelist = file::JoinPath(FLAGS_test_tmpdir, "pdfimages.txt");
+  CHECK_OK(file::WriteStringToFile(
+      absl::StrCat(TestDataNameToPath("HelloGoogle.tif"), "\n",
+                   TestDataNameToPath("phototest.tif"), "\n"),
+      filelist));
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::string pdfs[2];
+  for (int i = 0; i < 2; ++i) {
+    std::string outputbase =
+        file::JoinPath(FLAGS_test_tmpdir, absl::StrCat("pdfimages", i));
+    api.SetVariable("pdf_background_images", i == 0 ? "false" : "true");
+    {
+      tesseract::TessPDFRenderer renderer(outputbase.c_str(),
+                                          TessdataPath().c_str());
+      EXPECT_TRUE(api.ProcessPages(filelist.c_str(), nullptr, 0, &renderer));
+    }
+    CHECK_OK(file::GetContents(outputbase + ".pdf", &pdfs[i],
+                               file::Defaults()));
+    // The documents only differ in their creation date.
+    size_t date = pdfs[i].find("/CreationDate");
+    ASSERT_NE(std::string::npos, date);
+    pdfs[i].erase(date, pdfs[i].find('\n', date) - date);
+  }
+  EXPECT_THAT(pdfs[0], HasSubstr("%%EOF"));
+  EXPECT_EQ(pdfs[0], pdfs[1]);
+}
+
+// Tests that a batch of line images gets the text of each line, word boxes
+// inside the image, and that rectangles of an image give the same words.
+TEST_F(TesseractTest, RecognizeBatchTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  Pix* src_pix = pixRead(TestDataNameToPath("HelloGoogle.tif").c_str());
+  CHECK(src_pix);
+  std::vector<Pix*> images = {src_pix, nullptr, src_pix};
+  std::vector<tesseract::BatchResult> results;
+  EXPECT_TRUE(api.RecognizeBatch(images, tesseract::PSM_SINGLE_LINE,
+                                 &results));
+  ASSERT_EQ(3, results.size());
+  EXPECT_THAT(results[0].text, HasSubstr("Hello Google"));
+  EXPECT_EQ(results[0].text, results[2].text);
+  EXPECT_TRUE(results[1].text.empty());
+  EXPECT_TRUE(results[1].words.empty());
+  EXPECT_EQ(0.0f, results[1].confidence);
+  ASSERT_FALSE(results[0].words.empty());
+  int width = pixGetWidth(src_pix);
+  int height = pixGetHeight(src_pix);
+  for (const auto& word : results[0].words) {
+    EXPECT_FALSE(word.text.empty());
+    EXPECT_GT(word.confidence, 0.0f);
+    EXPECT_LE(0, word.left);
+    EXPECT_LT(word.left, word.right);
+    EXPECT_LE(word.right, width);
+    EXPECT_LE(0, word.top);
+    EXPECT_LT(word.top, word.bottom);
+    EXPECT_LE(word.bottom, height);
+  }
+
+  // The same image as the right half of a white one twice as wide.
+  Pix* grey_pix = pixConvertTo8(src_pix, false);
+  Pix* wide_pix = pixCreate(2 * width, height, 8);
+  pixSetAll(wide_pix);
+  pixRasterop(wide_pix, width, 0, width, height, PIX_SRC, grey_pix, 0, 0);
+  Boxa* boxes = boxaCreate(1);
+  boxaAddBox(boxes, boxCreate(width, 0, width, height), L_INSERT);
+  std::vector<tesseract::BatchResult> rect_results;
+  EXPECT_TRUE(api.RecognizeBatch(wide_pix, boxes, tesseract::PSM_SINGLE_LINE,
+                                 &rect_results));
+  ASSERT_EQ(1, rect_results.size());
+  EXPECT_EQ(results[0].text, rect_results[0].text);
+  ASSERT_EQ(results[0].words.size(), rect_results[0].words.size());
+  for (size_t w = 0; w < results[0].words.size(); ++w) {
+    EXPECT_EQ(results[0].words[w].left + width,
+              rect_results[0].words[w].left);
+    EXPECT_EQ(results[0].words[w].top, rect_results[0].words[w].top);
+  }
+  boxaDestroy(&boxes);
+  pixDestroy(&wide_pix);
+  pixDestroy(&grey_pix);
+  pixDestroy(&src_pix);
+}
+
+// Tests that regions of one image get the text of just their region, with
+// word boxes in the coordinates of the image, whatever their mode.
+TEST_F(TesseractTest, RecognizeRegionsTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  Pix* src_pix = pixRead(TestDataNameToPath("HelloGoogle.tif").c_str());
+  CHECK(src_pix);
+  int width = pixGetWidth(src_pix);
+  int height = pixGetHeight(src_pix);
+  // HelloGoogle as the right half of a white image twice as wide.
+  Pix* grey_pix = pixConvertTo8(src_pix, false);
+  Pix* wide_pix = pixCreate(2 * width, height, 8);
+  pixSetAll(wide_pix);
+  pixRasterop(wide_pix, width, 0, width, height, PIX_SRC, grey_pix, 0, 0);
+  api.SetImage(wide_pix);
+  std::vector<tesseract::BatchRegion> regions = {
+      {width, 0, width, height, tesseract::PSM_SINGLE_LINE},
+      {width, 0, width, height, tesseract::PSM_SINGLE_BLOCK},
+      {0, 0, width, height, tesseract::PSM_SINGLE_BLOCK},
+      {3 * width, 0, width, height, tesseract::PSM_SINGLE_LINE}};
+  std::vector<tesseract::BatchResult> results;
+  EXPECT_TRUE(api.RecognizeRegions(regions, &results));
+  ASSERT_EQ(4, results.size());
+  for (int r = 0; r < 2; ++r) {
+    EXPECT_THAT(results[r].text, HasSubstr("Hello Google"));
+    EXPECT_GT(results[r].confidence, 0.0f);
+    for (const auto& word : results[r].words) {
+      EXPECT_LE(width, word.left);
+      EXPECT_LT(word.left, word.right);
+      EXPECT_LE(word.right, 2 * width);
+      EXPECT_LE(0, word.top);
+      EXPECT_LT(word.top, word.bottom);
+      EXPECT_LE(word.bottom, height);
+    }
+  }
+  // The white half has no text, and the last region is off the image.
+  EXPECT_TRUE(results[2].words.empty());
+  EXPECT_TRUE(results[3].words.empty());
+
+  // The whole image is recognized as usual afterwards.
+  std::unique_ptr<char[]> text(api.GetUTF8Text());
+  EXPECT_THAT(text.get(), HasSubstr("Hello Google"));
+  pixDestroy(&wide_pix);
+  pixDestroy(&grey_pix);
+  pixDestroy(&src_pix);
+}
+
+// Tests that extra words can be attached and detached after Init.
+TEST_F(TesseractTest, AttachExtraWordsTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  EXPECT_EQ(0, api.IsValidWord("qwxzvy"));
+  int num_dawgs = api.NumDawgs();
+  EXPECT_TRUE(api.AttachExtraWords("qwxzvy\r\nzvyqwx\n"));
+  EXPECT_EQ(num_dawgs + 1, api.NumDawgs());
+  EXPECT_NE(0, api.IsValidWord("qwxzvy"));
+  EXPECT_NE(0, api.IsValidWord("zvyqwx"));
+  // Attaching again replaces the words.
+  EXPECT_TRUE(api.AttachExtraWords("zvyqwx"));
+  EXPECT_EQ(num_dawgs + 1, api.NumDawgs());
+  EXPECT_EQ(0, api.IsValidWord("qwxzvy"));
+  api.DetachExtraWords();
+  EXPECT_EQ(num_dawgs, api.NumDawgs());
+  EXPECT_EQ(0, api.IsValidWord("zvyqwx"));
+  EXPECT_NE(0, api.IsValidWord("the"));
+}
+
 // Test that LSTM's character bounding boxes are properly converted to
 // Tesseract structures. Note that we can't guarantee that LSTM's
 // character boxes fall completely within Tesseract's word box because
@@ -310,6 +879,97 @@ TEST_F(TesseractTest, InitConfigOnlyTest) {
   }
 }
 
+// Tests that a compiled profile sets its variables, that the previous values
+// revert it, and that a snapshot restores variables set since.
+TEST_F(TesseractTest, VariableProfileTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  GenericVector<STRING> names, values;
+  names.push_back(STRING("tessedit_char_whitelist"));
+  values.push_back(STRING("0123456789"));
+  names.push_back(STRING("tessedit_pageseg_mode"));
+  values.push_back(STRING("7"));
+  tesseract::VariableProfile profile, previous, snapshot;
+  api.SaveVariables(&snapshot);
+  EXPECT_GT(snapshot.size(), 0);
+  ASSERT_TRUE(api.CompileVariables(&names, &values, &profile));
+  EXPECT_EQ(2, profile.size());
+  api.ApplyVariables(profile, &previous);
+  EXPECT_STREQ("0123456789", api.GetStringVariable("tessedit_char_whitelist"));
+  int psm;
+  EXPECT_TRUE(api.GetIntVariable("tessedit_pageseg_mode", &psm));
+  EXPECT_EQ(7, psm);
+  api.ApplyVariables(previous, nullptr);
+  EXPECT_STREQ("", api.GetStringVariable("tessedit_char_whitelist"));
+  EXPECT_TRUE(api.GetIntVariable("tessedit_pageseg_mode", &psm));
+  EXPECT_EQ(tesseract::PSM_SINGLE_BLOCK, psm);
+
+  // Unknown variables and init only variables are rejected.
+  names.push_back(STRING("no_such_variable"));
+  values.push_back(STRING("1"));
+  names.push_back(STRING("tessedit_ocr_engine_mode"));
+  values.push_back(STRING("0"));
+  EXPECT_FALSE(api.CompileVariables(&names, &values, &profile));
+  EXPECT_EQ(2, profile.size());
+
+  api.SetVariable("tessedit_char_blacklist", "xyz");
+  api.SetVariable("tessedit_pageseg_mode", "11");
+  api.ApplyVariables(snapshot, nullptr);
+  EXPECT_STREQ("", api.GetStringVariable("tessedit_char_blacklist"));
+  EXPECT_TRUE(api.GetIntVariable("tessedit_pageseg_mode", &psm));
+  EXPECT_EQ(tesseract::PSM_SINGLE_BLOCK, psm);
+}
+
+// Tests that Init profiles the phases it runs, and only those.
+TEST_F(TesseractTest, InitProfileTest) {
+  tesseract::TessBaseAPI api;
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  std::unique_ptr<char[]> profile(api.GetInitProfileText());
+  std::string text = profile.get();
+  LOG(INFO) << "Init profile:\n" << text;
+  EXPECT_NE(std::string::npos, text.find(" Init\n"));
+  EXPECT_NE(std::string::npos, text.find("   language eng\n"));
+  EXPECT_NE(std::string::npos, text.find("     traineddata\n"));
+  EXPECT_NE(std::string::npos, text.find("     lstm\n"));
+  // The classifier of the legacy engine is not loaded.
+  EXPECT_EQ(std::string::npos, text.find("inttemp"));
+
+  // Initializing the same language again reuses it.
+  api.Init(TessdataPath().c_str(), "eng", tesseract::OEM_LSTM_ONLY);
+  profile.reset(api.GetInitProfileText());
+  text = profile.get();
+  EXPECT_NE(std::string::npos, text.find(" Init\n"));
+  EXPECT_EQ(std::string::npos, text.find("language"));
+}
+
+// Tests that an engine initialized like another has its variables and gets
+// the same text.
+TEST_F(TesseractTest, InitLikeTest) {
+  tesseract::TessBaseAPI source;
+  GenericVector<STRING> vars_vec, vars_values;
+  vars_vec.push_back(STRING("tessedit_char_blacklist"));
+  vars_values.push_back(STRING("|"));
+  ASSERT_EQ(0, source.Init(TessdataPath().c_str(), "eng",
+                           tesseract::OEM_LSTM_ONLY, nullptr, 0, &vars_vec,
+                           &vars_values, false));
+  source.SetVariable("tessedit_pageseg_mode", "6");
+  tesseract::TessBaseAPI copy;
+  EXPECT_EQ(-1, copy.InitLike(copy));
+  ASSERT_EQ(0, copy.InitLike(source));
+  EXPECT_STREQ("eng", copy.GetInitLanguagesAsString());
+  EXPECT_EQ(tesseract::OEM_LSTM_ONLY, copy.oem());
+  EXPECT_STREQ("|", copy.GetStringVariable("tessedit_char_blacklist"));
+  int psm;
+  EXPECT_TRUE(copy.GetIntVariable("tessedit_pageseg_mode", &psm));
+  EXPECT_EQ(tesseract::PSM_SINGLE_BLOCK, psm);
+
+  Pix* src_pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(src_pix);
+  EXPECT_EQ(GetCleanedTextResult(&source, src_pix),
+            GetCleanedTextResult(&copy, src_pix));
+  pixDestroy(&src_pix);
+}
+
 // Tests if two instances of Tesseract/LSTM can co-exist in the same thread.
 // NOTE: This is not an exhaustive test and current support for multiple
 // instances in Tesseract is fragile. This test is intended largely as a means
@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////
+// File:        blobchoicecache_test.cc
+// Description: Tests the cache of the choices of the adaptive classifier.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <vector>
+#include "blobchoicecache.h"
+#include "blobs.h"
+#include "include_gunit.h"
+#include "ratngs.h"
+
+namespace tesseract {
+namespace {
+
+class BlobChoiceCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+  }
+
+  // Returns a new blob with a single polygonal outline through the given
+  // vertices, which must be in anticlockwise order.
+  static TBLOB* MakeBlob(const std::vector<ICOORD>& vertices) {
+    EDGEPT* first = nullptr;
+    EDGEPT* prev = nullptr;
+    for (const ICOORD& vertex : vertices) {
+      auto* pt = new EDGEPT;
+      pt->pos.x = vertex.x();
+      pt->pos.y = vertex.y();
+      if (first == nullptr) first = pt;
+      else prev->next = pt;
+      pt->prev = prev;
+      prev = pt;
+    }
+    prev->next = first;
+    first->prev = prev;
+    auto* blob = new TBLOB;
+    blob->outlines = TESSLINE::BuildFromOutlineList(first);
+    return blob;
+  }
+
+  // Returns a new triangular blob with its lower left corner at left.
+  static TBLOB* MakeTriangle(int left, int height) {
+    return MakeBlob({ICOORD(left, 0), ICOORD(left + 30, 0),
+                     ICOORD(left + 15, height)});
+  }
+
+  // Sets choices to a single choice of unichar_id with the given rating.
+  static void MakeChoices(UNICHAR_ID unichar_id, float rating,
+                          BLOB_CHOICE_LIST* choices) {
+    BLOB_CHOICE_IT it(choices);
+    it.add_to_end(new BLOB_CHOICE(unichar_id, rating, -rating / 10, -1, 0.0f,
+                                  0.0f, 0.0f, BCC_ADAPTED_CLASSIFIER));
+  }
+
+  // Expects choices to hold just the choice made by MakeChoices.
+  static void ExpectChoices(UNICHAR_ID unichar_id, float rating,
+                            BLOB_CHOICE_LIST* choices) {
+    ASSERT_EQ(1, choices->length());
+    BLOB_CHOICE_IT it(choices);
+    EXPECT_EQ(unichar_id, it.data()->unichar_id());
+    EXPECT_FLOAT_EQ(rating, it.data()->rating());
+  }
+};
+
+// Tests that a stored blob is found again, also as a separate copy of the
+// same outline, and that a different blob is not.
+TEST_F(BlobChoiceCacheTest, HitsAndMisses) {
+  std::unique_ptr<TBLOB> blob(MakeTriangle(0, 40));
+  std::unique_ptr<TBLOB> same(MakeTriangle(0, 40));
+  std::unique_ptr<TBLOB> taller(MakeTriangle(0, 41));
+  std::unique_ptr<TBLOB> moved(MakeTriangle(5, 40));
+  BlobChoiceCache cache;
+  BLOB_CHOICE_LIST choices;
+  MakeChoices(3, 10.0f, &choices);
+  BlobChoiceKey key = BlobChoiceCache::MakeKey(*blob);
+  BLOB_CHOICE_LIST found;
+  EXPECT_FALSE(cache.Lookup(key, &found));
+  EXPECT_TRUE(found.empty());
+  cache.Store(key, &choices);
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_TRUE(cache.Lookup(key, &found));
+  ExpectChoices(3, 10.0f, &found);
+  // The cached choices are a copy, so they survive the stored list.
+  choices.clear();
+  BLOB_CHOICE_LIST copy;
+  EXPECT_TRUE(cache.Lookup(BlobChoiceCache::MakeKey(*same), &copy));
+  ExpectChoices(3, 10.0f, &copy);
+  BLOB_CHOICE_LIST other;
+  EXPECT_FALSE(cache.Lookup(BlobChoiceCache::MakeKey(*taller), &other));
+  EXPECT_FALSE(cache.Lookup(BlobChoiceCache::MakeKey(*moved), &other));
+  EXPECT_TRUE(other.empty());
+}
+
+// Tests that an entry whose hash matches but whose fingerprint doesn't is
+// never returned, and that storing the other blob replaces it.
+TEST_F(BlobChoiceCacheTest, HashCollision) {
+  std::unique_ptr<TBLOB> blob(MakeTriangle(0, 40));
+  BlobChoiceKey key = BlobChoiceCache::MakeKey(*blob);
+  EXPECT_EQ(1, key.num_outlines);
+  EXPECT_EQ(3, key.num_points);
+  BlobChoiceCache cache;
+  BLOB_CHOICE_LIST choices;
+  MakeChoices(3, 10.0f, &choices);
+  cache.Store(key, &choices);
+  BlobChoiceKey keys[4] = {key, key, key, key};
+  keys[0].box.set_right(key.box.right() + 1);
+  keys[1].num_outlines = 2;
+  keys[2].num_points = 4;
+  keys[3].num_steps = 1;
+  for (const BlobChoiceKey& collision : keys) {
+    BLOB_CHOICE_LIST found;
+    EXPECT_FALSE(cache.Lookup(collision, &found));
+    EXPECT_TRUE(found.empty());
+  }
+  BLOB_CHOICE_LIST other_choices;
+  MakeChoices(5, 20.0f, &other_choices);
+  cache.Store(keys[1], &other_choices);
+  EXPECT_EQ(1u, cache.size());
+  BLOB_CHOICE_LIST found;
+  EXPECT_FALSE(cache.Lookup(key, &found));
+  EXPECT_TRUE(cache.Lookup(keys[1], &found));
+  ExpectChoices(5, 20.0f, &found);
+}
+
+// Tests that Clear, which Classify::ClearBlobChoiceCache calls whenever the
+// adapted templates change, forgets every blob.
+TEST_F(BlobChoiceCacheTest, Clear) {
+  BlobChoiceCache cache;
+  std::vector<BlobChoiceKey> keys;
+  for (int b = 0; b < 5; ++b) {
+    std::unique_ptr<TBLOB> blob(MakeTriangle(b * 40, 30 + b));
+    keys.push_back(BlobChoiceCache::MakeKey(*blob));
+    BLOB_CHOICE_LIST choices;
+    MakeChoices(b, b + 1.0f, &choices);
+    cache.Store(keys.back(), &choices);
+  }
+  EXPECT_EQ(keys.size(), cache.size());
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+  for (const BlobChoiceKey& key : keys) {
+    BLOB_CHOICE_LIST found;
+    EXPECT_FALSE(cache.Lookup(key, &found));
+  }
+}
+
+}  // namespace
+}  // namespace tesseract
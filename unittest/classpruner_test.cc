@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////
+// File:        classpruner_test.cc
+// Description: Tests the vectorized class pruner accumulation and config
+//              evidence of the legacy classifier against scalar code.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include "classpruner.h"
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+#include "simddetect.h"
+#include "tprintf.h"
+
+namespace tesseract {
+namespace {
+
+// Number of words in the (24 x 24 x 24 x 2) array of a class pruner.
+const int kWordsPerPruner = 24 * 24 * 24 * 2;
+
+class ClassPrunerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    random_.set_seed(2020);
+    pruners_.resize(kNumPruners);
+    for (auto& pruner : pruners_) {
+      pruner.resize(kWordsPerPruner);
+      for (auto& word : pruner) {
+        word = static_cast<uint32_t>(random_.IntRand()) << 16 ^
+               static_cast<uint32_t>(random_.IntRand());
+      }
+      pruner_ptrs_.push_back(pruner.data());
+    }
+    offsets_.resize(kNumFeatures);
+    for (auto& offset : offsets_) {
+      offset = random_.IntRand() % (kWordsPerPruner / 2) * 2;
+    }
+    for (int p = 0; p < kNumProtos; ++p) {
+      // Sparse config words, as most protos belong to few configs.
+      uint32_t word = 0;
+      for (int b = random_.IntRand() % 4; b >= 0; --b) {
+        word |= 1u << (random_.IntRand() % kConfigsPerWord);
+      }
+      config_words_.push_back(p % 7 == 0 ? ~0u : word);
+      evidence_.push_back(static_cast<uint8_t>(random_.IntRand() % 256));
+    }
+  }
+
+  // Computes the expected counts in the way of ClassPruner::ComputeScores.
+  std::vector<int> ExpectedCounts(int num_features) const {
+    std::vector<int> counts(kNumPruners * kClassesPerPruner, kInitialCount);
+    for (int f = 0; f < num_features; ++f) {
+      for (int p = 0; p < kNumPruners; ++p) {
+        int class_id = p * kClassesPerPruner;
+        for (int w = 0; w < 2; ++w) {
+          uint32_t word = pruners_[p][offsets_[f] + w];
+          for (int c = 0; c < kClassesPerPruner / 2; ++c) {
+            counts[class_id++] += word & 3;
+            word >>= 2;
+          }
+        }
+      }
+    }
+    return counts;
+  }
+
+  // Checks that the given function matches ExpectedCounts.
+  void ExpectEqualResults(ClassPrunerFunction add_counts) const {
+    for (int num_features : {0, 1, 7, kNumFeatures}) {
+      std::vector<int> counts(kNumPruners * kClassesPerPruner, kInitialCount);
+      add_counts(pruner_ptrs_.data(), kNumPruners, offsets_.data(),
+                 num_features, counts.data());
+      EXPECT_EQ(ExpectedCounts(num_features), counts);
+    }
+  }
+
+  // Computes the expected config evidence in the way of
+  // IntegerMatcher::UpdateTablesForFeature.
+  std::vector<uint8_t> ExpectedEvidence(int num_protos) const {
+    std::vector<uint8_t> best(kConfigsPerWord, kInitialCount);
+    for (int p = 0; p < num_protos; ++p) {
+      for (int c = 0; c < kConfigsPerWord; ++c) {
+        if ((config_words_[p] >> c & 1) && evidence_[p] > best[c]) {
+          best[c] = evidence_[p];
+        }
+      }
+    }
+    return best;
+  }
+
+  // Checks that the given function matches ExpectedEvidence.
+  void ExpectEqualEvidence(ConfigEvidenceFunction max_evidence) const {
+    for (int num_protos : {0, 1, 5, kNumProtos}) {
+      std::vector<uint8_t> best(kConfigsPerWord, kInitialCount);
+      max_evidence(config_words_.data(), evidence_.data(), num_protos,
+                   best.data());
+      EXPECT_EQ(ExpectedEvidence(num_protos), best);
+    }
+  }
+
+  static const int kNumPruners = 5;
+  static const int kNumProtos = 63;
+  static const int kNumFeatures = 97;
+  // Counts don't start at zero, to check that they are added to.
+  static const int kInitialCount = 11;
+  TRand random_;
+  std::vector<std::vector<uint32_t>> pruners_;
+  std::vector<const uint32_t*> pruner_ptrs_;
+  std::vector<int> offsets_;
+  std::vector<uint32_t> config_words_;
+  std::vector<uint8_t> evidence_;
+};
+
+// Tests that the selected code matches the scalar unpacking.
+TEST_F(ClassPrunerTest, Selected) {
+  if (AddClassPrunerCounts == nullptr) {
+    tprintf("No vectorized class pruner selected! Not tested!");
+    return;
+  }
+  ExpectEqualResults(AddClassPrunerCounts);
+  ExpectEqualEvidence(MaxConfigEvidence);
+}
+
+// Tests that the AVX2 implementation gets the same result as the scalar code.
+TEST_F(ClassPrunerTest, AVX2) {
+#if defined(AVX2)
+  if (!SIMDDetect::IsAVX2Available()) {
+    tprintf("No AVX2 found! Not tested!");
+    return;
+  }
+  ExpectEqualResults(AddClassPrunerCountsAVX2);
+  ExpectEqualEvidence(MaxConfigEvidenceAVX2);
+#else
+  tprintf("AVX2 unsupported! Not tested!");
+#endif
+}
+
+// Tests that the NEON implementation gets the same result as the scalar code.
+TEST_F(ClassPrunerTest, NEON) {
+#if defined(NEON)
+  if (!SIMDDetect::IsNEONAvailable()) {
+    tprintf("No NEON found! Not tested!");
+    return;
+  }
+  ExpectEqualResults(AddClassPrunerCountsNEON);
+  ExpectEqualEvidence(MaxConfigEvidenceNEON);
+#else
+  tprintf("NEON unsupported! Not tested!");
+#endif
+}
+
+}  // namespace
+}  // namespace tesseract
@@ -0,0 +1,104 @@
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <thread>
+
+#include "counters.h"
+
+#include "include_gunit.h"
+
+using tesseract::CountEvent;
+using tesseract::CounterName;
+using tesseract::Counters;
+using tesseract::CounterSnapshot;
+using tesseract::ScopedCounters;
+
+namespace {
+
+// Tests that events are counted in the Counters of the scope of the thread
+// that counts them, and in the process-wide counters.
+TEST(CountersTest, CountsInScope) {
+  CounterSnapshot before;
+  Counters::ProcessSnapshot(&before);
+  Counters outer, inner;
+  {
+    ScopedCounters counting(&outer);
+    CountEvent(tesseract::COUNTER_DAWG_LOOKUPS);
+    {
+      ScopedCounters inner_counting(&inner);
+      CountEvent(tesseract::COUNTER_DAWG_LOOKUPS, 2);
+    }
+    CountEvent(tesseract::COUNTER_BEAM_NODES, 10);
+    // Another thread counts outside of any scope until it enters one.
+    std::thread thread([&outer] {
+      CountEvent(tesseract::COUNTER_BEAM_NODES, 100);
+      ScopedCounters counting(&outer);
+      CountEvent(tesseract::COUNTER_BEAM_NODES, 1000);
+    });
+    thread.join();
+  }
+  CountEvent(tesseract::COUNTER_DAWG_LOOKUPS, 4);
+
+  CounterSnapshot snapshot;
+  outer.Snapshot(&snapshot);
+  EXPECT_EQ(1, snapshot.values[tesseract::COUNTER_DAWG_LOOKUPS]);
+  EXPECT_EQ(1010, snapshot.values[tesseract::COUNTER_BEAM_NODES]);
+  EXPECT_EQ(0, snapshot.values[tesseract::COUNTER_TEXTLINES]);
+  inner.Snapshot(&snapshot);
+  EXPECT_EQ(2, snapshot.values[tesseract::COUNTER_DAWG_LOOKUPS]);
+
+  Counters::ProcessSnapshot(&snapshot);
+  EXPECT_EQ(7, snapshot.values[tesseract::COUNTER_DAWG_LOOKUPS] -
+                   before.values[tesseract::COUNTER_DAWG_LOOKUPS]);
+  EXPECT_EQ(1110, snapshot.values[tesseract::COUNTER_BEAM_NODES] -
+                      before.values[tesseract::COUNTER_BEAM_NODES]);
+}
+
+// Tests that the process-wide counters keep what was counted by Counters
+// that are reset or destroyed.
+TEST(CountersTest, ProcessKeepsRetiredCounts) {
+  CounterSnapshot before;
+  Counters::ProcessSnapshot(&before);
+  Counters kept;
+  {
+    Counters destroyed;
+    ScopedCounters counting(&destroyed);
+    CountEvent(tesseract::COUNTER_CHOP_ATTEMPTS, 3);
+  }
+  {
+    ScopedCounters counting(&kept);
+    CountEvent(tesseract::COUNTER_CHOP_ATTEMPTS, 5);
+  }
+  kept.Reset();
+  CounterSnapshot snapshot;
+  kept.Snapshot(&snapshot);
+  EXPECT_EQ(0, snapshot.values[tesseract::COUNTER_CHOP_ATTEMPTS]);
+  Counters::ProcessSnapshot(&snapshot);
+  EXPECT_EQ(8, snapshot.values[tesseract::COUNTER_CHOP_ATTEMPTS] -
+                   before.values[tesseract::COUNTER_CHOP_ATTEMPTS]);
+}
+
+// Tests that every counter has a distinct name.
+TEST(CountersTest, Names) {
+  EXPECT_STREQ("blobs_found", CounterName(tesseract::COUNTER_BLOBS_FOUND));
+  EXPECT_STREQ("traineddata_bytes",
+               CounterName(tesseract::COUNTER_TRAINEDDATA_BYTES));
+  for (int i = 0; i < tesseract::COUNTER_COUNT; ++i) {
+    const char* name = CounterName(static_cast<tesseract::CounterId>(i));
+    ASSERT_TRUE(name != nullptr);
+    for (int j = 0; j < i; ++j) {
+      EXPECT_STRNE(name, CounterName(static_cast<tesseract::CounterId>(j)));
+    }
+  }
+  EXPECT_EQ(nullptr, CounterName(tesseract::COUNTER_COUNT));
+}
+
+}  // namespace
@@ -15,7 +15,10 @@
 #include <string>
 #include <vector>
 
+#include "dawg.h"
 #include "ratngs.h"
+#include "simddetect.h"
+#include "tessdatamanager.h"
 #include "unicharset.h"
 #include "trie.h"
 
@@ -105,4 +108,189 @@ TEST_F(DawgTest, TestMatching) {
   EXPECT_TRUE(trie.prefix_in_dawg(space_apos, true));
 }
 
+TEST_F(DawgTest, TestSquishedEdgeSearch) {
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  tesseract::Trie trie(tesseract::DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM,
+                       unicharset.size(), 0);
+  GenericVector<STRING> words;
+  for (const char* word : {"a", "an", "and", "ant", "anti", "bat", "bath",
+                           "baths", "cat", "cats", "catch", "dog", "dot"}) {
+    words.push_back(word);
+  }
+  ASSERT_TRUE(
+      trie.add_word_list(words, unicharset, tesseract::Trie::RRP_DO_NO_REVERSE));
+  std::unique_ptr<tesseract::SquishedDawg> dawg(trie.trie_to_dawg());
+  // Every edge of every node must be found by edge_char_of, with and without
+  // the vectorized search, as the first edge of its unichar_id.
+  tesseract::FindKeyFunction find_key = tesseract::FindKey;
+  for (int vectorized = 0; vectorized < 2; ++vectorized) {
+    tesseract::FindKey = vectorized ? find_key : nullptr;
+    std::vector<NODE_REF> nodes = {0};
+    std::set<NODE_REF> seen = {0};
+    for (size_t n = 0; n < nodes.size(); ++n) {
+      for (bool word_end : {false, true}) {
+        tesseract::NodeChildVector children;
+        dawg->unichar_ids_of(nodes[n], &children, word_end);
+        for (int id = 0; id < unicharset.size(); ++id) {
+          EDGE_REF expected = NO_EDGE;
+          for (int c = 0; c < children.size(); ++c) {
+            if (children[c].unichar_id == id) {
+              expected = children[c].edge_ref;
+              break;
+            }
+          }
+          EXPECT_EQ(expected, dawg->edge_char_of(nodes[n], id, word_end));
+        }
+        for (int c = 0; c < children.size(); ++c) {
+          NODE_REF next = dawg->next_node(children[c].edge_ref);
+          if (next != 0 && seen.insert(next).second) nodes.push_back(next);
+        }
+      }
+    }
+    EXPECT_TRUE(dawg->word_in_dawg(WERD_CHOICE("baths", unicharset)));
+    EXPECT_FALSE(dawg->word_in_dawg(WERD_CHOICE("bats", unicharset)));
+  }
+  tesseract::FindKey = find_key;
+}
+
+TEST_F(DawgTest, TestSortedWordList) {
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  GenericVector<STRING> words;
+  for (const char* word : {"a", "an", "and", "ant", "anti", "bat", "bath",
+                           "baths", "bats", "cat", "catch", "cats", "hat",
+                           "hath", "hats", "that", "thats"}) {
+    words.push_back(word);
+  }
+  tesseract::Trie trie(tesseract::DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM,
+                       unicharset.size(), 0);
+  std::unique_ptr<tesseract::SquishedDawg> sorted_dawg(
+      trie.sorted_word_list_to_dawg(words, unicharset,
+                                    tesseract::Trie::RRP_DO_NO_REVERSE));
+  ASSERT_TRUE(sorted_dawg != nullptr);
+  ASSERT_TRUE(
+      trie.add_word_list(words, unicharset, tesseract::Trie::RRP_DO_NO_REVERSE));
+  std::unique_ptr<tesseract::SquishedDawg> dawg(trie.trie_to_dawg());
+  // It must have the same words, in no more edges, after a round trip.
+  GenericVector<char> dawg_data;
+  tesseract::TFile fp;
+  fp.OpenWrite(&dawg_data);
+  ASSERT_TRUE(sorted_dawg->write_squished_dawg(&fp));
+  tesseract::SquishedDawg loaded_dawg(tesseract::DAWG_TYPE_WORD, "eng",
+                                      SYSTEM_DAWG_PERM, 0);
+  tesseract::TFile in;
+  ASSERT_TRUE(in.Open(&dawg_data[0], dawg_data.size()));
+  ASSERT_TRUE(loaded_dawg.Load(&in));
+  EXPECT_LE(loaded_dawg.NumEdges(), dawg->NumEdges());
+  for (int w = 0; w < words.size(); ++w) {
+    EXPECT_TRUE(
+        loaded_dawg.word_in_dawg(WERD_CHOICE(words[w].string(), unicharset)));
+  }
+  for (const char* word : {"anth", "ba", "bathe", "cath", "th", "thatch"}) {
+    EXPECT_FALSE(loaded_dawg.word_in_dawg(WERD_CHOICE(word, unicharset)));
+  }
+  // Words that share a prefix must be together.
+  words.push_back("bag");
+  EXPECT_TRUE(trie.sorted_word_list_to_dawg(
+                  words, unicharset, tesseract::Trie::RRP_DO_NO_REVERSE) ==
+              nullptr);
+}
+
+TEST_F(DawgTest, TestMappedDawg) {
+  UNICHARSET unicharset;
+  unicharset.load_from_file(file::JoinPath(TESTING_DIR, "eng.unicharset").c_str());
+  tesseract::Trie trie(tesseract::DAWG_TYPE_WORD, "eng", SYSTEM_DAWG_PERM,
+                       unicharset.size(), 0);
+  GenericVector<STRING> words;
+  for (const char* word : {"a", "an", "and", "ant", "bat", "baths", "cat"}) {
+    words.push_back(word);
+  }
+  ASSERT_TRUE(
+      trie.add_word_list(words, unicharset, tesseract::Trie::RRP_DO_NO_REVERSE));
+  std::unique_ptr<tesseract::SquishedDawg> dawg(trie.trie_to_dawg());
+  GenericVector<char> dawg_data;
+  tesseract::TFile fp;
+  fp.OpenWrite(&dawg_data);
+  ASSERT_TRUE(dawg->write_squished_dawg(&fp));
+  // An odd sized entry before the dawg leaves its edges unaligned.
+  tesseract::TessdataManager mgr;
+  mgr.SetVersionString("odd");
+  mgr.OverwriteEntry(tesseract::TESSDATA_LSTM_SYSTEM_DAWG, &dawg_data[0],
+                     dawg_data.size());
+  std::string traineddata = OutputNameToPath("mapped_dawg.traineddata");
+  ASSERT_TRUE(mgr.SaveFile(traineddata.c_str(), nullptr));
+  tesseract::TessdataManager mapped_mgr;
+  ASSERT_TRUE(mapped_mgr.Init(traineddata.c_str()));
+  int size;
+  std::shared_ptr<const char> mapped = mapped_mgr.GetMappedComponent(
+      tesseract::TESSDATA_LSTM_SYSTEM_DAWG, &size);
+#ifndef _WIN32
+  ASSERT_NE(nullptr, mapped);
+#endif
+  if (mapped == nullptr) return;
+  EXPECT_EQ(dawg_data.size(), size);
+  tesseract::SquishedDawg mapped_dawg(tesseract::DAWG_TYPE_WORD, "eng",
+                                      SYSTEM_DAWG_PERM, 0);
+  ASSERT_TRUE(mapped_dawg.LoadMapped(mapped, size));
+  // Edges are found through the key index, as in a loaded dawg.
+  EXPECT_TRUE(dawg->has_edge_keys());
+  EXPECT_TRUE(mapped_dawg.has_edge_keys());
+  EXPECT_EQ(dawg->MemoryBytes(), mapped_dawg.MemoryBytes());
+  // The edges stay mapped without the TessdataManager.
+  mapped.reset();
+  mapped_mgr.Clear();
+  for (int w = 0; w < words.size(); ++w) {
+    EXPECT_TRUE(mapped_dawg.word_in_dawg(
+        WERD_CHOICE(words[w].string(), unicharset)));
+  }
+  EXPECT_FALSE(mapped_dawg.word_in_dawg(WERD_CHOICE("bats", unicharset)));
+  // It must write back the same dawg.
+  GenericVector<char> mapped_data;
+  tesseract::TFile out;
+  out.OpenWrite(&mapped_data);
+  ASSERT_TRUE(mapped_dawg.write_squished_dawg(&out));
+  ASSERT_EQ(dawg_data.size(), mapped_data.size());
+  EXPECT_EQ(0, memcmp(&dawg_data[0], &mapped_data[0], dawg_data.size()));
+}
+
+TEST_F(DawgTest, TestComponentsLoadOnUse) {
+  const char kAmbigs[] = "v6\nrn m 1\n";
+  const char kConfig[] = "tessedit_pageseg_mode 6\n";
+  tesseract::TessdataManager mgr;
+  mgr.SetVersionString("lazy");
+  mgr.OverwriteEntry(tesseract::TESSDATA_AMBIGS, kAmbigs, strlen(kAmbigs));
+  mgr.OverwriteEntry(tesseract::TESSDATA_LANG_CONFIG, kConfig,
+                     strlen(kConfig));
+  std::string traineddata = OutputNameToPath("lazy.traineddata");
+  ASSERT_TRUE(mgr.SaveFile(traineddata.c_str(), nullptr));
+  GenericVector<char> saved;
+  mgr.Serialize(&saved);
+
+  tesseract::TessdataManager lazy_mgr;
+  ASSERT_TRUE(lazy_mgr.Init(traineddata.c_str()));
+  EXPECT_EQ("lazy", lazy_mgr.VersionString());
+  EXPECT_TRUE(lazy_mgr.IsComponentAvailable(tesseract::TESSDATA_AMBIGS));
+  EXPECT_TRUE(lazy_mgr.IsComponentAvailable(tesseract::TESSDATA_LANG_CONFIG));
+  EXPECT_FALSE(lazy_mgr.IsComponentAvailable(tesseract::TESSDATA_LSTM));
+  EXPECT_FALSE(lazy_mgr.IsComponentUsed(tesseract::TESSDATA_AMBIGS));
+  EXPECT_FALSE(lazy_mgr.IsComponentUsed(tesseract::TESSDATA_LANG_CONFIG));
+
+  tesseract::TFile fp;
+  ASSERT_TRUE(lazy_mgr.GetComponent(tesseract::TESSDATA_AMBIGS, &fp));
+  EXPECT_TRUE(lazy_mgr.IsComponentUsed(tesseract::TESSDATA_AMBIGS));
+  EXPECT_FALSE(lazy_mgr.IsComponentUsed(tesseract::TESSDATA_LANG_CONFIG));
+  char line[32];
+  ASSERT_NE(nullptr, fp.FGets(line, sizeof(line)));
+  EXPECT_STREQ("v6\n", line);
+  ASSERT_NE(nullptr, fp.FGets(line, sizeof(line)));
+  EXPECT_STREQ("rn m 1\n", line);
+
+  // Components that were never used are still written back.
+  GenericVector<char> reserialized;
+  lazy_mgr.Serialize(&reserialized);
+  ASSERT_EQ(saved.size(), reserialized.size());
+  EXPECT_EQ(0, memcmp(&saved[0], &reserialized[0], saved.size()));
+}
+
 }  // namespace
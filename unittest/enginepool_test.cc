@@ -0,0 +1,203 @@
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allheaders.h"
+#include "baseapi.h"
+#include "enginepool.h"
+#include "genericvector.h"
+#include "include_gunit.h"
+#include "ocrclass.h"
+#include "resultiterator.h"
+#include "strngs.h"
+
+namespace {
+
+using tesseract::EnginePoolStats;
+using tesseract::TessBaseAPI;
+using tesseract::TessEnginePool;
+
+class EnginePoolTest : public testing::Test {
+ protected:
+  static std::string TestDataNameToPath(const std::string& name) {
+    return file::JoinPath(TESTING_DIR, name);
+  }
+
+  // Returns the text that api recognizes in pix.
+  static std::string Recognize(TessBaseAPI* api, Pix* pix) {
+    api->SetImage(pix);
+    char* result = api->GetUTF8Text();
+    std::string text = result != nullptr ? result : "";
+    delete[] result;
+    return text;
+  }
+};
+
+// Tests that engines are reused for the same profile, initialized again for
+// another, and that a lease waits for an engine when they are all leased.
+TEST_F(EnginePoolTest, LeasesEngines) {
+  TessEnginePool pool(TESSDATA_DIR, 2);
+  TessBaseAPI* a = pool.Acquire("eng", tesseract::OEM_LSTM_ONLY, nullptr,
+                                nullptr);
+  ASSERT_TRUE(a != nullptr);
+  pool.Release(a);
+  EXPECT_EQ(a, pool.Acquire("eng", tesseract::OEM_LSTM_ONLY, nullptr,
+                            nullptr));
+  GenericVector<STRING> names, values;
+  names.push_back("tessedit_char_whitelist");
+  values.push_back("0123456789");
+  TessBaseAPI* b = pool.Acquire("eng", tesseract::OEM_LSTM_ONLY, &names,
+                                &values);
+  ASSERT_TRUE(b != nullptr);
+  EXPECT_NE(a, b);
+  EXPECT_STREQ("0123456789", b->GetStringVariable("tessedit_char_whitelist"));
+  EXPECT_STREQ("", a->GetStringVariable("tessedit_char_whitelist"));
+  EnginePoolStats stats = pool.GetStats();
+  EXPECT_EQ(2, stats.engines);
+  EXPECT_EQ(2, stats.leased);
+  EXPECT_EQ(3, stats.leases);
+  EXPECT_EQ(2, stats.inits);
+
+  // The pool is full, so the next lease waits for b, and initializes it
+  // again without the whitelist.
+  TessBaseAPI* c = nullptr;
+  std::thread lessee([&pool, &c] {
+    c = pool.Acquire("eng", tesseract::OEM_LSTM_ONLY, nullptr, nullptr);
+  });
+  while (pool.GetStats().waits == 0) std::this_thread::yield();
+  pool.Release(b);
+  lessee.join();
+  EXPECT_EQ(b, c);
+  EXPECT_STREQ("", c->GetStringVariable("tessedit_char_whitelist"));
+  pool.Release(a);
+  pool.Release(c);
+  stats = pool.GetStats();
+  EXPECT_EQ(0, stats.leased);
+  EXPECT_EQ(3, stats.inits);
+  EXPECT_EQ(0, stats.failed_inits);
+
+  EXPECT_EQ(nullptr, pool.Acquire("no_such_lang", tesseract::OEM_LSTM_ONLY,
+                                  nullptr, nullptr));
+  EXPECT_EQ(1, pool.GetStats().failed_inits);
+  EXPECT_EQ(0, pool.GetStats().leased);
+}
+
+// Tests that threads sharing a pool of fewer engines all get the same text.
+TEST_F(EnginePoolTest, SharedByThreads) {
+  Pix* pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(pix);
+  TessEnginePool pool(TESSDATA_DIR, 2);
+  TessBaseAPI* api = pool.Acquire("eng", tesseract::OEM_LSTM_ONLY, nullptr,
+                                  nullptr);
+  ASSERT_TRUE(api != nullptr);
+  std::string truth = Recognize(api, pix);
+  pool.Release(api);
+  EXPECT_FALSE(truth.empty());
+
+  const int kNumThreads = 4;
+  std::vector<std::string> texts(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.push_back(std::thread([&pool, pix, &texts, t] {
+      TessBaseAPI* api = pool.Acquire("eng", tesseract::OEM_LSTM_ONLY,
+                                      nullptr, nullptr);
+      if (api == nullptr) return;
+      texts[t] = Recognize(api, pix);
+      pool.Release(api);
+    }));
+  }
+  for (auto& thread : threads) thread.join();
+  for (const auto& text : texts) EXPECT_EQ(truth, text);
+  EXPECT_LE(pool.GetStats().engines, 2);
+  pixDestroy(&pix);
+}
+
+// Tests that queued recognitions call back with the results of their pages,
+// and that a monitor can cancel one.
+TEST_F(EnginePoolTest, RecognizesAsync) {
+  Pix* pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(pix);
+  TessEnginePool pool(TESSDATA_DIR, 2);
+  const int kNumPages = 5;
+  std::vector<std::string> texts(kNumPages);
+  std::vector<std::future<int>> results;
+  for (int p = 0; p < kNumPages; ++p) {
+    results.push_back(pool.RecognizeAsync(
+        pix, "eng", tesseract::OEM_LSTM_ONLY, nullptr, nullptr, nullptr,
+        [&texts, p](int status, tesseract::ResultIterator* it) {
+          if (status != 0 || it == nullptr) return;
+          do {
+            char* text = it->GetUTF8Text(tesseract::RIL_BLOCK);
+            if (text != nullptr) texts[p] += text;
+            delete[] text;
+          } while (it->Next(tesseract::RIL_BLOCK));
+        }));
+  }
+  ETEXT_DESC monitor;
+  monitor.cancel = [](void*, int) { return true; };
+  bool cancelled_called = false;
+  std::future<int> cancelled = pool.RecognizeAsync(
+      pix, "eng", tesseract::OEM_LSTM_ONLY, nullptr, nullptr, &monitor,
+      [&cancelled_called](int status, tesseract::ResultIterator* it) {
+        cancelled_called = status != 0 && it == nullptr;
+      });
+  // The caller's pix is not needed once the pages are queued.
+  pixDestroy(&pix);
+  for (auto& result : results) EXPECT_EQ(0, result.get());
+  EXPECT_EQ(-1, cancelled.get());
+  EXPECT_TRUE(cancelled_called);
+  for (const auto& text : texts) {
+    EXPECT_NE(std::string::npos, text.find("quick brown dog"));
+    EXPECT_EQ(texts[0], text);
+  }
+  EnginePoolStats stats = pool.GetStats();
+  EXPECT_EQ(0, stats.queued);
+  EXPECT_EQ(0, stats.leased);
+  EXPECT_LE(stats.engines, 2);
+}
+
+// Tests that threads pinned to two sets of CPUs get the same results, with
+// engines of their own for each set, and that the sets can't be changed once
+// the threads are started.
+TEST_F(EnginePoolTest, PinsThreadsToNodes) {
+#if defined(__linux__)
+  Pix* pix = pixRead(TestDataNameToPath("phototest.tif").c_str());
+  CHECK(pix);
+  TessEnginePool pool(TESSDATA_DIR, 2);
+  // Both sets hold CPU 0, which every host has.
+  EXPECT_FALSE(pool.SetNodeCpus({{0}, {}}));
+  EXPECT_TRUE(pool.SetNodeCpus({{0}, {0}}));
+  const int kNumPages = 4;
+  std::vector<std::string> texts(kNumPages);
+  std::vector<std::future<int>> results;
+  for (int p = 0; p < kNumPages; ++p) {
+    results.push_back(pool.RecognizeAsync(
+        pix, "eng", tesseract::OEM_LSTM_ONLY, nullptr, nullptr, nullptr,
+        [&texts, p](int status, tesseract::ResultIterator* it) {
+          if (status != 0 || it == nullptr) return;
+          char* text = it->GetUTF8Text(tesseract::RIL_BLOCK);
+          if (text != nullptr) texts[p] = text;
+          delete[] text;
+        }));
+  }
+  pixDestroy(&pix);
+  for (auto& result : results) EXPECT_EQ(0, result.get());
+  for (const auto& text : texts) EXPECT_EQ(texts[0], text);
+  EXPECT_FALSE(pool.SetNodeCpus({{0}}));
+  EXPECT_LE(pool.GetStats().engines, 2);
+#endif
+}
+
+}  // namespace
@@ -1,10 +1,22 @@
 #include "baseapi.h"
 #include "leptonica/allheaders.h"
+#include "tracing.h"
 
 #include <libgen.h>     // for dirname
 #include <cstdio>       // for printf
-#include <cstdlib>      // for std::getenv, std::setenv
+#include <cstdlib>      // for std::getenv, std::setenv, std::atof
 #include <string>       // for std::string
+#include <vector>       // for std::vector
+
+// In the performance mode, which is on if either budget is set, an input on
+// which a stage of recognition takes longer than TESS_FUZZ_STAGE_BUDGET_MS,
+// or the engine, model included, reaches more than TESS_FUZZ_MEMORY_BUDGET_MB,
+// aborts, so the fuzzer keeps it as a finding, like a crash. The stages are
+// the spans of the tracing, and the memory is the page high-water mark of
+// the engine. The -timeout and -rss_limit_mb options of libFuzzer only catch
+// inputs that are slow or big enough to look like hangs or leaks.
+static double stage_budget_ms = 0.0;
+static double memory_budget_mb = 0.0;
 
 class BitReader {
  private:
@@ -57,6 +69,11 @@ extern "C" int LLVMFuzzerInitialize(int* /*pArgc*/, char*** pArgv) {
   /* Silence output */
   api->SetVariable("debug_file", "/dev/null");
 
+  const char* budget = std::getenv("TESS_FUZZ_STAGE_BUDGET_MS");
+  if (budget != nullptr) stage_budget_ms = std::atof(budget);
+  budget = std::getenv("TESS_FUZZ_MEMORY_BUDGET_MB");
+  if (budget != nullptr) memory_budget_mb = std::atof(budget);
+
   return 0;
 }
 
@@ -82,6 +99,8 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
 
   auto pix = createPix(BR, 100, 100);
 
+  if (stage_budget_ms > 0.0) tesseract::Tracing::Start();
+
   api->SetImage(pix);
 
   char* outText = api->GetUTF8Text();
@@ -89,5 +108,26 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
   pixDestroy(&pix);
   delete[] outText;
 
+  if (stage_budget_ms > 0.0) {
+    tesseract::Tracing::Stop();
+    std::vector<tesseract::Tracing::SpanTotal> stages;
+    tesseract::Tracing::GetTotals(&stages);
+    for (const auto& stage : stages) {
+      if (stage.total_us > stage_budget_ms * 1000.0) {
+        printf("Stage %s took %.3f ms > budget %.3f ms\n", stage.name.c_str(),
+               stage.total_us / 1000.0, stage_budget_ms);
+        std::abort();
+      }
+    }
+  }
+  if (memory_budget_mb > 0.0) {
+    double peak_mb = api->GetPageMemoryHighWater() / 1048576.0;
+    if (peak_mb > memory_budget_mb) {
+      printf("Page took %.3f MB > budget %.3f MB\n", peak_mb,
+             memory_budget_mb);
+      std::abort();
+    }
+  }
+
   return 0;
 }
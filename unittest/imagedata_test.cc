@@ -9,19 +9,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 
+#include "allheaders.h"
 #include "imagedata.h"
 #include "include_gunit.h"
 #include "log.h"
+#include "serialis.h"
 
 using tesseract::DocumentCache;
 using tesseract::DocumentData;
 using tesseract::ImageData;
+using tesseract::ImageFingerprint;
+using tesseract::TFile;
 
 namespace {
 
@@ -36,8 +41,11 @@ class ImagedataTest : public ::testing::Test {
   ImagedataTest() {}
 
   // Creates a fake DocumentData, writes it to a file, and returns the filename.
+  // If indexed, the file is written in the indexed format, optionally
+  // compressed.
   std::string MakeFakeDoc(int num_pages, unsigned doc_id,
-                     std::vector<std::string>* page_texts) {
+                     std::vector<std::string>* page_texts,
+                     bool indexed = false, bool compress = false) {
     // The size of the fake images that we will use.
     const int kImageSize = 1048576;
     // Not using a real image here - just an array of zeros! We are just testing
@@ -57,8 +65,15 @@ class ImagedataTest : public ::testing::Test {
     }
     // Write it to a file.
     std::string filename = file::JoinPath(
-        FLAGS_test_tmpdir, absl::StrCat("documentdata", doc_id, ".lstmf"));
-    EXPECT_TRUE(write_doc.SaveDocument(filename.c_str(), nullptr));
+        FLAGS_test_tmpdir,
+        absl::StrCat(indexed ? "indexeddata" : "documentdata", doc_id,
+                     compress ? "z" : "", ".lstmf"));
+    if (indexed) {
+      EXPECT_TRUE(
+          write_doc.SaveIndexedDocument(filename.c_str(), compress, nullptr));
+    } else {
+      EXPECT_TRUE(write_doc.SaveDocument(filename.c_str(), nullptr));
+    }
     return filename;
   }
 };
@@ -131,4 +146,156 @@ TEST_F(ImagedataTest, CachesMultiDocs) {
   }
 }
 
+TEST_F(ImagedataTest, PrefetchesInOrder) {
+  // This test verifies that decoding pages ahead in the background doesn't
+  // change the pages that come out, even when reading out of order.
+  const std::vector<int> kNumPages = {6, 5, 7};
+  const int kPageReadOrder[] = {0, 1, 2, 3, 9, 10, 4, 5, 17, 18, 19, 20, -1};
+  std::vector<std::vector<std::string>> page_texts;
+  GenericVector<STRING> filenames;
+  for (size_t d = 0; d < kNumPages.size(); ++d) {
+    page_texts.emplace_back(std::vector<std::string>());
+    std::string filename = MakeFakeDoc(kNumPages[d], d, &page_texts.back());
+    filenames.push_back(STRING(filename.c_str()));
+  }
+  DocumentCache plain_cache(8000000);
+  plain_cache.LoadDocuments(filenames, tesseract::CS_SEQUENTIAL, nullptr);
+  DocumentCache prefetch_cache(8000000);
+  prefetch_cache.LoadDocuments(filenames, tesseract::CS_SEQUENTIAL, nullptr);
+  prefetch_cache.StartPrefetch(4, 2);
+  for (int p = 0; kPageReadOrder[p] >= 0; ++p) {
+    int serial = kPageReadOrder[p];
+    const ImageData* plain_data = plain_cache.GetPageBySerial(serial);
+    const ImageData* prefetch_data = prefetch_cache.GetPageBySerial(serial);
+    CHECK(plain_data != nullptr);
+    CHECK(prefetch_data != nullptr);
+    EXPECT_STREQ(plain_data->transcription().string(),
+                 prefetch_data->transcription().string());
+  }
+  prefetch_cache.StopPrefetch();
+}
+
+TEST_F(ImagedataTest, ReadsIndexedDocs) {
+  // This test verifies that indexed documents, compressed or not, are cached
+  // like plain ones, and that their pages can be read directly.
+  const int kNumPages = 8;
+  const int kMemoryAllowances[] = {2000000, 4000000, 100000000, 0};
+  const int kPageReadOrder[] = {0, 1, 5, 2, 7, 6, 3, 4, -1};
+  for (int c = 0; c < 2; ++c) {
+    std::vector<std::string> page_texts;
+    std::string filename =
+        MakeFakeDoc(kNumPages, 0, &page_texts, /*indexed=*/true, c == 1);
+    for (int m = 0; kMemoryAllowances[m] > 0; ++m) {
+      DocumentData read_doc("My document");
+      EXPECT_TRUE(read_doc.LoadDocument(filename.c_str(), 0,
+                                        kMemoryAllowances[m], nullptr));
+      EXPECT_EQ(kNumPages, read_doc.NumPages());
+      for (int p = 0; kPageReadOrder[p] >= 0; ++p) {
+        int page = kPageReadOrder[p];
+        const ImageData* imagedata = read_doc.GetPage(page);
+        ASSERT_NE(nullptr, imagedata);
+        EXPECT_STREQ(page_texts[page].c_str(),
+                     imagedata->transcription().string());
+      }
+    }
+    DocumentData direct_doc("My document");
+    direct_doc.SetDocument(filename.c_str(), 0, nullptr);
+    for (int p = 0; kPageReadOrder[p] >= 0; ++p) {
+      int page = kPageReadOrder[p];
+      std::unique_ptr<ImageData> imagedata(direct_doc.ReadPage(page));
+      ASSERT_NE(nullptr, imagedata);
+      EXPECT_STREQ(page_texts[page].c_str(),
+                   imagedata->transcription().string());
+    }
+  }
+  // Pages of a plain document can be read directly too.
+  std::vector<std::string> page_texts;
+  std::string filename = MakeFakeDoc(kNumPages, 1, &page_texts);
+  DocumentData plain_doc("My document");
+  plain_doc.SetDocument(filename.c_str(), 0, nullptr);
+  std::unique_ptr<ImageData> imagedata(plain_doc.ReadPage(kNumPages + 3));
+  ASSERT_NE(nullptr, imagedata);
+  EXPECT_STREQ(page_texts[3].c_str(), imagedata->transcription().string());
+}
+
+TEST_F(ImagedataTest, KeepsDecodedImage) {
+  // This test verifies that an image kept without encoding it scales like an
+  // encoded one, and gets encoded when it is serialized.
+  const int kWidth = 300;
+  const int kHeight = 60;
+  Pix* pix = pixCreate(kWidth, kHeight, 8);
+  pixSetAll(pix);
+  pixSetPixel(pix, 10, 20, 0);
+  ImageData kept(false, pixCopy(nullptr, pix), /*keep_decoded=*/true);
+  ImageData encoded(false, pix);
+  EXPECT_TRUE(kept.IsDecoded());
+  EXPECT_EQ(0, kept.MemoryUsed());
+  EXPECT_FALSE(encoded.IsDecoded());
+  for (const ImageData* imagedata : {&kept, &encoded}) {
+    float scale_factor;
+    int width, height;
+    Pix* scaled = imagedata->PreScale(kHeight / 2, kHeight, &scale_factor,
+                                      &width, &height, nullptr);
+    ASSERT_NE(nullptr, scaled);
+    EXPECT_FLOAT_EQ(0.5f, scale_factor);
+    EXPECT_EQ(kWidth / 2, width);
+    EXPECT_EQ(kHeight / 2, height);
+    pixDestroy(&scaled);
+  }
+  GenericVector<char> data;
+  TFile fp;
+  fp.OpenWrite(&data);
+  EXPECT_TRUE(kept.Serialize(&fp));
+  TFile in;
+  ASSERT_TRUE(in.Open(&data[0], data.size()));
+  ImageData read;
+  ASSERT_TRUE(read.DeSerialize(&in));
+  EXPECT_LT(0, read.MemoryUsed());
+  Pix* kept_pix = kept.GetPix();
+  Pix* read_pix = read.GetPix();
+  ASSERT_NE(nullptr, read_pix);
+  l_int32 same = 0;
+  pixEqual(kept_pix, read_pix, &same);
+  EXPECT_TRUE(same);
+  pixDestroy(&kept_pix);
+  pixDestroy(&read_pix);
+  std::unique_ptr<ImageData> copy(kept.Copy());
+  EXPECT_TRUE(copy->IsDecoded());
+}
+
+TEST_F(ImagedataTest, ContentHash) {
+  // This test verifies that the content hash depends only on the pixels, not
+  // on how the image is held.
+  Pix* pix = pixCreate(101, 40, 8);
+  pixSetAll(pix);
+  pixSetPixel(pix, 50, 20, 0);
+  ImageData kept(false, pixCopy(nullptr, pix), /*keep_decoded=*/true);
+  ImageData encoded(false, pixCopy(nullptr, pix));
+  EXPECT_EQ(kept.ContentHash(), encoded.ContentHash());
+  pixSetPixel(pix, 51, 20, 0);
+  ImageData changed(false, pix);
+  EXPECT_NE(kept.ContentHash(), changed.ContentHash());
+}
+
+TEST_F(ImagedataTest, Fingerprint) {
+  // This test verifies that the fingerprint holds the size and both hashes,
+  // and that the second hash also changes with the pixels.
+  Pix* pix = pixCreate(101, 40, 8);
+  pixSetAll(pix);
+  ImageData kept(false, pixCopy(nullptr, pix), /*keep_decoded=*/true);
+  ImageData encoded(false, pixCopy(nullptr, pix));
+  ImageFingerprint fingerprint = kept.Fingerprint();
+  EXPECT_EQ(101, fingerprint.width);
+  EXPECT_EQ(40, fingerprint.height);
+  EXPECT_EQ(8, fingerprint.depth);
+  EXPECT_EQ(kept.ContentHash(), fingerprint.hash);
+  EXPECT_TRUE(fingerprint == encoded.Fingerprint());
+  pixSetPixel(pix, 3, 7, 0);
+  ImageData changed(false, pix);
+  ImageFingerprint changed_fingerprint = changed.Fingerprint();
+  EXPECT_NE(fingerprint.hash, changed_fingerprint.hash);
+  EXPECT_NE(fingerprint.check, changed_fingerprint.check);
+  EXPECT_TRUE(fingerprint != changed_fingerprint);
+}
+
 }  // namespace.
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////
+// File:        input_test.cc
+// Description: Tests the cutting of wide blank gaps from a line image by
+//              Input::CompressBlankColumns.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <vector>
+#include "allheaders.h"
+#include "include_gunit.h"
+#include "input.h"
+
+namespace tesseract {
+namespace {
+
+const int kXScale = 4;
+const int kHeight = 3;
+// Two timesteps of blank may be kept from each gap.
+const int kMaxGapWidth = 2 * kXScale;
+// Not a multiple of kXScale, so the last timestep is only 2 columns wide.
+const int kWidth = 11 * kXScale + 2;
+
+class InputTest : public ::testing::Test {
+ protected:
+  // Returns a white 8 bit image kWidth wide, with a black column at each of
+  // the given x coordinates.
+  static Pix* MakeLine(const std::vector<int>& black_columns) {
+    Pix* pix = pixCreate(kWidth, kHeight, 8);
+    pixSetAll(pix);
+    for (int x : black_columns) {
+      for (int y = 0; y < kHeight; ++y) pixSetPixel(pix, x, y, 0);
+    }
+    return pix;
+  }
+
+  // Checks that the top row of pix is black at the given x coordinates and
+  // white everywhere else.
+  static void ExpectBlackColumns(Pix* pix,
+                                 const std::vector<int>& black_columns) {
+    for (int x = 0; x < pixGetWidth(pix); ++x) {
+      l_uint32 value;
+      pixGetPixel(pix, x, 0, &value);
+      bool black = std::find(black_columns.begin(), black_columns.end(), x) !=
+                   black_columns.end();
+      EXPECT_EQ(value, black ? 0u : 255u) << "x=" << x;
+    }
+  }
+};
+
+// Tests that the narrow last timestep is mapped, and kept with its text, when
+// it follows a gap that is cut.
+TEST_F(InputTest, PartialTimestepAfterGap) {
+  Pix* pix = MakeLine({1, 11 * kXScale});
+  std::vector<int> timestep_map;
+  Pix* result =
+      Input::CompressBlankColumns(pix, kXScale, kMaxGapWidth, &timestep_map);
+  ASSERT_NE(result, nullptr);
+  // Timesteps 2 to 9 of the gap are cut.
+  const std::vector<int> kMap = {0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 3};
+  EXPECT_EQ(timestep_map, kMap);
+  EXPECT_EQ(pixGetWidth(result), 3 * kXScale + 2);
+  ExpectBlackColumns(result, {1, 3 * kXScale});
+  pixDestroy(&result);
+  pixDestroy(&pix);
+}
+
+// Tests that the narrow last timestep is mapped when it is part of a gap that
+// runs to the end of the line, and keeps only its own columns.
+TEST_F(InputTest, PartialTimestepInGap) {
+  Pix* pix = MakeLine({1});
+  std::vector<int> timestep_map;
+  Pix* result =
+      Input::CompressBlankColumns(pix, kXScale, kMaxGapWidth, &timestep_map);
+  ASSERT_NE(result, nullptr);
+  // Timesteps 2 to 10 of the gap are cut.
+  const std::vector<int> kMap = {0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2};
+  EXPECT_EQ(timestep_map, kMap);
+  EXPECT_EQ(pixGetWidth(result), 2 * kXScale + 2);
+  ExpectBlackColumns(result, {1});
+  pixDestroy(&result);
+  pixDestroy(&pix);
+}
+
+}  // namespace
+}  // namespace tesseract
@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////
+// File:        intfx_test.cc
+// Description: Tests the reusable and per-word forms of the integer feature
+//              extraction of the legacy classifier.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include "blobs.h"
+#include "classify.h"
+#include "include_gunit.h"
+#include "intfx.h"
+
+namespace tesseract {
+namespace {
+
+class IntFxTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    InitIntegerFX();
+  }
+
+  // Returns a new blob with a single polygonal outline through the given
+  // vertices, which must be in anticlockwise order.
+  static TBLOB* MakeBlob(const std::vector<ICOORD>& vertices) {
+    EDGEPT* first = nullptr;
+    EDGEPT* prev = nullptr;
+    for (const ICOORD& vertex : vertices) {
+      auto* pt = new EDGEPT;
+      pt->pos.x = vertex.x();
+      pt->pos.y = vertex.y();
+      if (first == nullptr) first = pt;
+      else prev->next = pt;
+      pt->prev = prev;
+      prev = pt;
+    }
+    prev->next = first;
+    first->prev = prev;
+    auto* blob = new TBLOB;
+    blob->outlines = TESSLINE::BuildFromOutlineList(first);
+    return blob;
+  }
+
+  // Makes a word of blobs of varying shape and size.
+  static void MakeWord(int num_blobs, TWERD* word) {
+    for (int b = 0; b < num_blobs; ++b) {
+      int left = b * 60;
+      int height = 40 + 17 * b;
+      word->blobs.push_back(MakeBlob({ICOORD(left, 0),
+                                      ICOORD(left + 30 + 5 * b, 10),
+                                      ICOORD(left + 40, height),
+                                      ICOORD(left + 10, height - 7 * b),
+                                      ICOORD(left - b, 20)}));
+    }
+  }
+
+  static void ExpectEqualFeatures(const GenericVector<INT_FEATURE_STRUCT>& a,
+                                  const GenericVector<INT_FEATURE_STRUCT>& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (int i = 0; i < a.size(); ++i) {
+      EXPECT_EQ(a[i].X, b[i].X);
+      EXPECT_EQ(a[i].Y, b[i].Y);
+      EXPECT_EQ(a[i].Theta, b[i].Theta);
+    }
+  }
+
+  // Expects features to be the same as freshly extracted features of blob.
+  static void ExpectFreshFeatures(const TBLOB& blob,
+                                  const BlobFeatures& features) {
+    GenericVector<INT_FEATURE_STRUCT> bl_features;
+    GenericVector<INT_FEATURE_STRUCT> cn_features;
+    INT_FX_RESULT_STRUCT fx_info;
+    Classify::ExtractFeatures(blob, false, &bl_features, &cn_features,
+                              &fx_info, nullptr);
+    EXPECT_GT(cn_features.size(), 0);
+    EXPECT_EQ(fx_info.NumBL, features.fx_info.NumBL);
+    EXPECT_EQ(fx_info.NumCN, features.fx_info.NumCN);
+    EXPECT_EQ(fx_info.Length, features.fx_info.Length);
+    EXPECT_EQ(fx_info.Width, features.fx_info.Width);
+    ExpectEqualFeatures(bl_features, features.bl_features);
+    ExpectEqualFeatures(cn_features, features.cn_features);
+  }
+};
+
+// Tests that a BlobFeatures used for several blobs holds just the features
+// of the last one.
+TEST_F(IntFxTest, ReusedBuffers) {
+  TWERD word;
+  MakeWord(4, &word);
+  BlobFeatures features;
+  for (int b = word.NumBlobs() - 1; b >= 0; --b) {
+    Classify::ExtractFeatures(*word.blobs[b], false, &features);
+    ExpectFreshFeatures(*word.blobs[b], features);
+  }
+}
+
+// Tests that the features of a whole word match those of each blob, also
+// when the vector has been used for a longer word before.
+TEST_F(IntFxTest, WordFeatures) {
+  TWERD long_word;
+  MakeWord(6, &long_word);
+  TWERD word;
+  MakeWord(3, &word);
+  std::vector<BlobFeatures> features;
+  Classify::ExtractWordFeatures(long_word, false, &features);
+  ASSERT_EQ(6, features.size());
+  for (int b = 0; b < long_word.NumBlobs(); ++b) {
+    ExpectFreshFeatures(*long_word.blobs[b], features[b]);
+  }
+  Classify::ExtractWordFeatures(word, false, &features);
+  EXPECT_EQ(6, features.size());
+  for (int b = 0; b < word.NumBlobs(); ++b) {
+    ExpectFreshFeatures(*word.blobs[b], features[b]);
+  }
+}
+
+}  // namespace
+}  // namespace tesseract
@@ -19,8 +19,10 @@
 #include "genericvector.h"
 #include "include_gunit.h"
 #include "matrix.h"
+#include "serialis.h"
 #include "simddetect.h"
 #include "tprintf.h"
+#include "weightmatrix.h"
 
 namespace tesseract {
 namespace {
@@ -86,14 +88,57 @@ class IntSimdMatrixTest : public ::testing::Test {
     // Compare sum of all results with expected value.
     EXPECT_FLOAT_EQ(total, -423243.392011);
   }
+  // Tests a range of sizes and numbers of input vectors for the matrix.matrix
+  // product, comparing the results against the generic vector version.
+  void ExpectEqualMatrixResults(const IntSimdMatrix& matrix) {
+    for (int num_out = 1; num_out < 130; num_out += 7) {
+      for (int num_in = 1; num_in < 130; num_in += 5) {
+        for (int num_vectors = 1; num_vectors <= 5; ++num_vectors) {
+          GENERIC_2D_ARRAY<int8_t> w = InitRandom(num_out, num_in + 1);
+          // Consecutive inputs are num_in apart, with padding only at the end,
+          // as in NetworkIO.
+          int u_stride = num_in;
+          std::vector<int8_t> u =
+              RandomVector(u_stride * (num_vectors - 1) + num_in, matrix);
+          GenericVector<double> scales = RandomScales(num_out);
+          int v_stride = num_out + 3;
+          std::vector<double> base_result(v_stride * num_vectors);
+          for (int t = 0; t < num_vectors; ++t) {
+            IntSimdMatrix::MatrixDotVector(w, scales, &u[t * u_stride],
+                                           &base_result[t * v_stride]);
+          }
+          std::vector<double> test_result(v_stride * num_vectors);
+          if (matrix.matrixDotMatrixFunction) {
+            std::vector<int8_t> shaped_wi;
+            matrix.Init(w, shaped_wi);
+            matrix.matrixDotMatrixFunction(
+                w.dim1(), w.dim2(), &shaped_wi[0], &scales[0], &u[0], u_stride,
+                num_vectors, &test_result[0], v_stride);
+          } else {
+            IntSimdMatrix::MatrixDotMatrix(w, scales, &u[0], u_stride,
+                                           num_vectors, &test_result[0],
+                                           v_stride);
+          }
+          for (int t = 0; t < num_vectors; ++t) {
+            for (int i = 0; i < num_out; ++i) {
+              EXPECT_FLOAT_EQ(base_result[t * v_stride + i],
+                              test_result[t * v_stride + i])
+                  << "t=" << t << " i=" << i;
+            }
+          }
+        }
+      }
+    }
+  }
 
   TRand random_;
 };
 
 // Test the C++ implementation without SIMD.
 TEST_F(IntSimdMatrixTest, C) {
-  static const IntSimdMatrix matrix = {nullptr, 1, 1, 1, 1};
+  static const IntSimdMatrix matrix = {nullptr, nullptr, 1, 1, 1, 1};
   ExpectEqualResults(matrix);
+  ExpectEqualMatrixResults(matrix);
 }
 
 // Tests that the SSE implementation gets the same result as the vanilla.
@@ -106,6 +151,7 @@ TEST_F(IntSimdMatrixTest, SSE) {
     return;
   }
   ExpectEqualResults(IntSimdMatrix::intSimdMatrixSSE);
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixSSE);
 #else
   tprintf("SSE unsupported! Not tested!");
 #endif
@@ -121,10 +167,122 @@ TEST_F(IntSimdMatrixTest, AVX2) {
     return;
   }
   ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVX2);
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixAVX2);
 #else
   tprintf("AVX2 unsupported! Not tested!");
 #endif
 }
 
+// Tests that the NEON implementation gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, NEON) {
+#if defined(NEON)
+  if (SIMDDetect::IsNEONAvailable()) {
+    tprintf("NEON found! Continuing...");
+  } else {
+    tprintf("No NEON found! Not tested!");
+    return;
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixNEON);
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixNEON);
+#else
+  tprintf("NEON unsupported! Not tested!");
+#endif
+}
+
+// Tests that the AVX512 implementation gets the same result as the vanilla.
+TEST_F(IntSimdMatrixTest, AVX512) {
+#if defined(AVX512BW)
+  if (SIMDDetect::IsAVX512BWAvailable()) {
+    tprintf("AVX512 found! Continuing...");
+  } else {
+    tprintf("No AVX512 found! Not tested!");
+    return;
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVX512);
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixAVX512);
+#else
+  tprintf("AVX512 unsupported! Not tested!");
+#endif
+}
+
+// Tests that the AVX512 VNNI implementation gets the same result as the
+// vanilla.
+TEST_F(IntSimdMatrixTest, AVX512VNNI) {
+#if defined(AVX512VNNI)
+  if (SIMDDetect::IsAVX512BWAvailable() &&
+      SIMDDetect::IsAVX512VNNIAvailable()) {
+    tprintf("AVX512 VNNI found! Continuing...");
+  } else {
+    tprintf("No AVX512 VNNI found! Not tested!");
+    return;
+  }
+  ExpectEqualResults(IntSimdMatrix::intSimdMatrixAVX512VNNI);
+  ExpectEqualMatrixResults(IntSimdMatrix::intSimdMatrixAVX512VNNI);
+#else
+  tprintf("AVX512 VNNI unsupported! Not tested!");
+#endif
+}
+
+// Tests that the C++ implementation gets the right result for the input sizes
+// that it has a fixed-size dot product for, as well as their neighbours.
+TEST_F(IntSimdMatrixTest, SpecializedSizes) {
+  const int kSizes[] = {9, 64, 80, 144, 160, 192, 288, 512, 608};
+  static const IntSimdMatrix matrix = {nullptr, nullptr, 1, 1, 1, 1};
+  const int kNumOut = 11;
+  for (int size : kSizes) {
+    for (int num_in = size - 1; num_in <= size + 1; ++num_in) {
+      GENERIC_2D_ARRAY<int8_t> w = InitRandom(kNumOut, num_in + 1);
+      std::vector<int8_t> u = RandomVector(num_in, matrix);
+      GenericVector<double> scales = RandomScales(kNumOut);
+      std::vector<double> result(kNumOut);
+      IntSimdMatrix::MatrixDotVector(w, scales, u.data(), result.data());
+      for (int i = 0; i < kNumOut; ++i) {
+        int total = 0;
+        for (int j = 0; j < num_in; ++j) total += w(i, j) * u[j];
+        double expected =
+            (static_cast<double>(total) / INT8_MAX + w(i, num_in)) * scales[i];
+        EXPECT_DOUBLE_EQ(expected, result[i]) << "num_in=" << num_in;
+      }
+    }
+  }
+}
+
+// Tests that a pruned int matrix uses the sparse dot product, which gets the
+// same result as its dense weights, and keeps it through serialization.
+TEST_F(IntSimdMatrixTest, SparseWeights) {
+  const int kNumOut = 37;
+  const int kNumIn = 75;
+  WeightMatrix w;
+  w.InitWeightsFloat(kNumOut, kNumIn + 1, false, 0.5f, &random_);
+  EXPECT_GT(w.PruneBlocks(0.9), 0);
+  w.ConvertToInt();
+  EXPECT_TRUE(w.is_sparse());
+  GENERIC_2D_ARRAY<double> weights;
+  w.GetDoubleWeights(&weights);
+  std::vector<int8_t> u(w.RoundInputs(kNumIn), 0);
+  for (int j = 0; j < kNumIn; ++j) {
+    u[j] = static_cast<int8_t>(random_.SignedRand(INT8_MAX));
+  }
+  std::vector<double> result(kNumOut);
+  w.MatrixDotVector(u.data(), result.data());
+  for (int i = 0; i < kNumOut; ++i) {
+    double total = 0.0;
+    for (int j = 0; j < kNumIn; ++j) total += weights(i, j) * u[j];
+    EXPECT_NEAR(total / INT8_MAX + weights(i, kNumIn), result[i], 1e-6);
+  }
+  GenericVector<char> data;
+  TFile write_fp;
+  write_fp.OpenWrite(&data);
+  ASSERT_TRUE(w.Serialize(false, &write_fp));
+  TFile read_fp;
+  ASSERT_TRUE(read_fp.Open(&data[0], data.size()));
+  WeightMatrix w2;
+  ASSERT_TRUE(w2.DeSerialize(false, &read_fp));
+  EXPECT_TRUE(w2.is_sparse());
+  std::vector<double> result2(kNumOut);
+  w2.MatrixDotVector(u.data(), result2.data());
+  for (int i = 0; i < kNumOut; ++i) EXPECT_EQ(result[i], result2[i]);
+}
+
 }  // namespace
 }  // namespace tesseract
@@ -0,0 +1,87 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "commandlineflags.h"
+#include "genericvector.h"
+#include "imagedata.h"
+#include "include_gunit.h"
+#include "linerenderer.h"
+
+// Flags defined in pango_font_info.cpp
+DECLARE_STRING_PARAM_FLAG(fonts_dir);
+DECLARE_STRING_PARAM_FLAG(fontconfig_tmpdir);
+
+namespace {
+
+const char kEngText[] = "the quick brown fox jumps over the lazy dog";
+
+using tesseract::DocumentData;
+using tesseract::ImageData;
+using tesseract::LineRenderOptions;
+using tesseract::LineRenderer;
+
+class LineRendererTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    static std::locale system_locale("");
+    std::locale::global(system_locale);
+  }
+
+  static void SetUpTestCase() {
+    FLAGS_fonts_dir = TESTING_DIR;
+    FLAGS_fontconfig_tmpdir = FLAGS_test_tmpdir;
+  }
+
+  // Returns options for a small page that holds a line of kEngText.
+  static LineRenderOptions SmallPageOptions() {
+    LineRenderOptions options;
+    options.ptsize = 10;
+    options.xsize = 600;
+    options.ysize = 600;
+    options.margin = 20;
+    return options;
+  }
+};
+
+TEST_F(LineRendererTest, RendersTextLines) {
+  LineRenderOptions options = SmallPageOptions();
+  options.degrade_image = false;
+  LineRenderer renderer("Verdana", options);
+  DocumentData lines("lines");
+  EXPECT_EQ(1, renderer.RenderText(kEngText, "eng.Verdana.tif", &lines));
+  std::unique_ptr<ImageData> line(lines.TakePage(0));
+  ASSERT_TRUE(line != nullptr);
+  EXPECT_STREQ("eng.Verdana.tif", line->imagefilename().string());
+  EXPECT_GT(line->boxes().size(), 0);
+  EXPECT_EQ(line->boxes().size(), line->box_texts().size());
+  EXPECT_NE(std::string::npos,
+            std::string(line->transcription().string()).find("quick"));
+}
+
+TEST_F(LineRendererTest, RendersFontsRepeatably) {
+  // The same font rendered on different threads must give the same lines,
+  // degradation included, as each renderer has its own seeded randomizer.
+  std::vector<std::string> font_names = {"Verdana", "Verdana"};
+  std::vector<GenericVector<char>> documents;
+  EXPECT_TRUE(LineRenderer::RenderFonts(kEngText, font_names,
+                                        SmallPageOptions(), 2, &documents));
+  ASSERT_EQ(2, documents.size());
+  ASSERT_GT(documents[0].size(), 0);
+  ASSERT_EQ(documents[0].size(), documents[1].size());
+  EXPECT_EQ(0, memcmp(&documents[0][0], &documents[1][0],
+                      documents[0].size()));
+}
+
+}  // namespace
@@ -0,0 +1,155 @@
+///////////////////////////////////////////////////////////////////////
+// File:        lstm_forward_test.cc
+// Description: Tests that running the rows of a 1-D LSTM as a batch gives
+//              the same outputs as running each row on its own.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <utility>
+#include <vector>
+#include "helpers.h"
+#include "include_gunit.h"
+#include "lstm.h"
+#include "networkio.h"
+#include "networkscratch.h"
+#include "stridemap.h"
+
+namespace tesseract {
+namespace {
+
+const int kNumInputs = 13;
+const int kNumStates = 10;
+
+class LSTMForwardTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    random_.set_seed(4321);
+  }
+
+  // Sets up lstm with random int weights, for inference, as it is loaded
+  // from a traineddata file.
+  void InitLSTM(LSTM* lstm) {
+    lstm->InitWeights(0.5f, &random_);
+    lstm->SetEnableTraining(TS_DISABLED);
+    lstm->ConvertToInt(1.0f);
+  }
+
+  // Sets input to a batch of images of the given heights and widths, of int
+  // random values.
+  void MakeInput(const std::vector<std::pair<int, int>>& h_w_pairs,
+                 NetworkIO* input) {
+    StrideMap stride_map;
+    stride_map.SetStride(h_w_pairs);
+    input->ResizeToMap(true, stride_map, kNumInputs);
+    input->Zero();
+    StrideMap::Index index(input->stride_map());
+    do {
+      input->Randomize(index.t(), 0, kNumInputs, &random_);
+    } while (index.Increment());
+  }
+
+  // Sets row to a copy of row y of image b of input, as a batch of one.
+  static void CopyRow(const NetworkIO& input, int b, int y, NetworkIO* row) {
+    StrideMap::Index src(input.stride_map(), b, y, 0);
+    int width = src.MaxIndexOfDim(FD_WIDTH) + 1;
+    StrideMap stride_map;
+    stride_map.SetStride({std::make_pair(1, width)});
+    row->ResizeToMap(true, stride_map, input.NumFeatures());
+    row->set_int_range(input.int_range());
+    for (int x = 0; x < width; ++x) {
+      int src_t = StrideMap::Index(input.stride_map(), b, y, x).t();
+      row->CopyTimeStepFrom(x, input, src_t);
+    }
+  }
+
+  // Runs lstm over input, the whole batch at once, which uses ForwardRows, and
+  // then over each row of input on its own, which uses the timestep loop, and
+  // expects the outputs to be the same.
+  void ExpectSameOutputs(LSTM* lstm, bool x_reversed, const NetworkIO& input) {
+    NetworkScratch scratch;
+    NetworkIO batch_output;
+    if (x_reversed) {
+      lstm->ForwardXReversed(false, input, &scratch, &batch_output);
+    } else {
+      lstm->Forward(false, input, nullptr, &scratch, &batch_output);
+    }
+    bool summary = lstm->type() == NT_LSTM_SUMMARY;
+    std::vector<double> batch_values(kNumStates), row_values(kNumStates);
+    const StrideMap& input_map = input.stride_map();
+    int num_rows = 0;
+    for (int b = 0; b < input_map.Size(FD_BATCH); ++b) {
+      StrideMap::Index image(input_map, b, 0, 0);
+      int height = image.MaxIndexOfDim(FD_HEIGHT) + 1;
+      for (int y = 0; y < height; ++y, ++num_rows) {
+        NetworkIO row, row_output;
+        CopyRow(input, b, y, &row);
+        if (x_reversed) {
+          lstm->ForwardXReversed(false, row, &scratch, &row_output);
+        } else {
+          lstm->Forward(false, row, nullptr, &scratch, &row_output);
+        }
+        int width = summary ? 1 : row.Width();
+        ASSERT_EQ(width, row_output.Width());
+        for (int x = 0; x < width; ++x) {
+          int t = StrideMap::Index(batch_output.stride_map(), b, y, x).t();
+          batch_output.ReadTimeStep(t, &batch_values[0]);
+          row_output.ReadTimeStep(x, &row_values[0]);
+          for (int i = 0; i < kNumStates; ++i) {
+            EXPECT_EQ(row_values[i], batch_values[i])
+                << "image " << b << " row " << y << " x " << x << " state "
+                << i;
+          }
+        }
+      }
+    }
+    // More rows than a tile of ForwardRows, so some images take several.
+    EXPECT_GT(num_rows, 16);
+  }
+
+  TRand random_;
+};
+
+// A batch of images of different heights and widths, one taller than a tile
+// of rows and one a single row high.
+const std::vector<std::pair<int, int>> kRaggedBatch = {
+    {7, 5}, {1, 9}, {21, 3}, {4, 12}};
+
+TEST_F(LSTMForwardTest, Forward) {
+  LSTM lstm("LSTM", kNumInputs, kNumStates, kNumStates, false, NT_LSTM);
+  InitLSTM(&lstm);
+  NetworkIO input;
+  MakeInput(kRaggedBatch, &input);
+  ExpectSameOutputs(&lstm, false, input);
+}
+
+TEST_F(LSTMForwardTest, XReversed) {
+  LSTM lstm("LSTM", kNumInputs, kNumStates, kNumStates, false, NT_LSTM);
+  InitLSTM(&lstm);
+  ASSERT_TRUE(lstm.CanForwardXReversed());
+  NetworkIO input;
+  MakeInput(kRaggedBatch, &input);
+  ExpectSameOutputs(&lstm, true, input);
+}
+
+TEST_F(LSTMForwardTest, Summary) {
+  LSTM lstm("LSTM", kNumInputs, kNumStates, kNumStates, false,
+            NT_LSTM_SUMMARY);
+  InitLSTM(&lstm);
+  NetworkIO input;
+  MakeInput(kRaggedBatch, &input);
+  ExpectSameOutputs(&lstm, false, input);
+}
+
+}  // namespace
+}  // namespace tesseract
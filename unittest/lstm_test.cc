@@ -21,6 +21,7 @@
 // --fontlist "Arial" --maxpages 10
 //
 
+#include "layerprofile.h"
 #include "lstm_test.h"
 
 namespace tesseract {
@@ -142,6 +143,48 @@ TEST_F(LSTMTrainerTest, DeterminismTest) {
   LOG(INFO) << "********** *** ************\n" ;
 }
 
+// Tests that TrainOnLines with a single thread trains exactly as the same
+// number of calls to TrainOnLine does, as the round gradients are averaged.
+TEST_F(LSTMTrainerTest, TrainOnLinesTest) {
+  const int kNumSamples = kTrainerIterations / 3;
+  SetupTrainerEng("[1,32,0,1 S4,2 L2xy16 Ct1,1,16 S8,1 Lbx100 O1c1]",
+                  "2-D-2-layer-lstm", false, false);
+  for (int s = 0; s < kNumSamples; ++s) {
+    trainer_->TrainOnLine(trainer_.get(), false);
+  }
+  int iteration_a = trainer_->training_iteration();
+  double act_error_a = trainer_->ActivationError();
+  double char_error_a = trainer_->CharError();
+  SetupTrainerEng("[1,32,0,1 S4,2 L2xy16 Ct1,1,16 S8,1 Lbx100 O1c1]",
+                  "2-D-2-layer-lstm", false, false);
+  trainer_->TrainOnLines(trainer_.get(), kNumSamples, 1, false);
+  EXPECT_EQ(iteration_a, trainer_->training_iteration());
+  EXPECT_FLOAT_EQ(act_error_a, trainer_->ActivationError());
+  EXPECT_FLOAT_EQ(char_error_a, trainer_->CharError());
+}
+
+// Tests that a compact checkpoint is smaller than a full precision one, and
+// restores a trainer that carries on much as the original does.
+TEST_F(LSTMTrainerTest, CompactCheckpointTest) {
+  SetupTrainerEng("[1,32,0,1 S4,2 L2xy16 Ct1,1,16 S8,1 Lbx100 O1c1]",
+                  "2-D-2-layer-lstm", false, true);
+  TrainIterations(kTrainerIterations / 3);
+  GenericVector<char> full_data;
+  EXPECT_TRUE(trainer_->SaveTrainingDump(FULL, trainer_.get(), &full_data));
+  trainer_->set_checkpoint_options(false, true, false);
+  GenericVector<char> compact_data;
+  EXPECT_TRUE(
+      trainer_->SaveTrainingDump(FULL, trainer_.get(), &compact_data));
+  EXPECT_LT(compact_data.size(), full_data.size());
+  double lstm_2d_err_a = TrainIterations(kTrainerIterations / 3);
+  SetupTrainerEng("[1,32,0,1 S4,2 L2xy16 Ct1,1,16 S8,1 Lbx100 O1c1]",
+                  "2-D-2-layer-lstm", false, true);
+  EXPECT_TRUE(trainer_->ReadTrainingDump(compact_data, trainer_.get()));
+  double lstm_2d_err_b = TrainIterations(kTrainerIterations / 3);
+  EXPECT_NEAR(lstm_2d_err_a, lstm_2d_err_b, 2.0);
+  LOG(INFO) << "********** *** ************\n" ;
+}
+
 // The baseline network against which to test the built-in softmax.
 TEST_F(LSTMTrainerTest, SoftmaxBaselineTest) {
   // A basic single-layer, single direction LSTM.
@@ -218,4 +261,39 @@ TEST_F(LSTMTrainerTest, TestLayerAccess) {
   }
 }
 
+// Tests that the layer profile adds up the forward passes of each layer.
+TEST_F(LSTMTrainerTest, TestLayerProfile) {
+  SetupTrainerEng("[1,32,0,1 Ct5,5,16 Mp2,2 Lfys32 Lbx128 O1c1]", "SQU-lstm",
+                  false, false);
+  const int kIterations = 5;
+  LayerProfile::Start();
+  TestIterations(kIterations);
+  LayerProfile::Stop();
+  // Nothing is added up once stopped.
+  TestIterations(1);
+  std::vector<LayerProfile::Layer> layers = LayerProfile::Layers();
+  int num_found = 0;
+  for (const auto& layer : layers) {
+    LOG(INFO) << layer.spec << " " << layer.ms << "ms " << layer.ops
+              << " ops\n";
+    // Every layer runs once per forward pass of the network.
+    EXPECT_EQ(layers[0].calls, layer.calls);
+    EXPECT_GE(layer.calls, kIterations);
+    EXPECT_GE(layer.timesteps, layer.calls);
+    if (layer.spec == "Mp2,2") {
+      ++num_found;
+      EXPECT_EQ(0.0, layer.ops);
+    } else if (layer.spec == "Lbx128") {
+      ++num_found;
+      EXPECT_EQ(2.0 * 128 * (4 * (128 + 32 + 1)) * layer.timesteps,
+                layer.ops);
+    }
+  }
+  EXPECT_EQ(2, num_found);
+  std::string text;
+  LayerProfile::Print(&text);
+  EXPECT_NE(std::string::npos, text.find("Lbx128\n"));
+  EXPECT_NE(std::string::npos, text.find("total\n"));
+}
+
 }  // namespace tesseract.
@@ -14,8 +14,12 @@
 // limitations under the License.
 ///////////////////////////////////////////////////////////////////////
 
+#include <string>
+#include <utility>
+
 #include "matrix.h"
 #include "genericvector.h"
+#include "strngs.h"
 #include "include_gunit.h"
 
 namespace {
@@ -135,4 +139,44 @@ TEST_F(MatrixTest, RotatingTranspose_0_2) {
   EXPECT_EQ(6, m(15, 0));
 }
 
+// Tests that moving a matrix takes its array and leaves the source empty.
+TEST_F(MatrixTest, Move) {
+  const int* data = &src_(0, 0);
+  GENERIC_2D_ARRAY<int> m(std::move(src_));
+  EXPECT_EQ(1, m.dim1());
+  EXPECT_EQ(kInputSize_, m.dim2());
+  EXPECT_EQ(data, &m(0, 0));
+  EXPECT_EQ(0, src_.num_elements());
+  GENERIC_2D_ARRAY<int> n;
+  n = std::move(m);
+  EXPECT_EQ(data, &n(0, 0));
+  EXPECT_EQ(kInputSize_ - 1, n(0, kInputSize_ - 1));
+}
+
+// Tests that moving a GenericVector takes its data, and that insert/remove
+// shift the elements correctly.
+TEST_F(MatrixTest, GenericVectorMove) {
+  GenericVector<STRING> v;
+  for (int i = 0; i < 20; ++i) v.emplace_back(std::to_string(i).c_str());
+  v.insert(STRING("x"), 5);
+  v.remove(0);
+  EXPECT_EQ(20, v.size());
+  EXPECT_STREQ("x", v[4].string());
+  EXPECT_STREQ("5", v[5].string());
+  EXPECT_STREQ("19", v.back().string());
+  const STRING* data = &v[0];
+  GenericVector<STRING> w(std::move(v));
+  EXPECT_EQ(0, v.size());
+  EXPECT_EQ(data, &w[0]);
+  v = std::move(w);
+  EXPECT_EQ(20, v.size());
+  EXPECT_EQ(0, w.size());
+  GenericVector<int> ints;
+  for (int i = 0; i < 100; ++i) ints.push_front(i);
+  ints.remove(50);
+  EXPECT_EQ(99, ints.size());
+  EXPECT_EQ(99, ints[0]);
+  EXPECT_EQ(48, ints[50]);
+}
+
 }  // namespace
@@ -0,0 +1,113 @@
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "allheaders.h"
+#include "baseapi.h"
+#include "memoryusage.h"
+
+#include "include_gunit.h"
+
+using tesseract::MemoryCategoryName;
+using tesseract::MemoryTracker;
+using tesseract::MemoryUsage;
+using tesseract::ScopedMemoryTracker;
+using tesseract::TrackedBytes;
+
+namespace {
+
+// Tests that tracked bytes are taken back from the tracker they were added
+// to, wherever they change or are destroyed, and that the peak holds.
+TEST(MemoryUsageTest, TracksLiveAndPeakBytes) {
+  MemoryTracker tracker;
+  std::unique_ptr<TrackedBytes> grid(new TrackedBytes);
+  {
+    ScopedMemoryTracker tracking(&tracker);
+    grid->Set(1000);
+    TrackedBytes other;
+    other.Set(500);
+    EXPECT_EQ(1500, tracker.bytes());
+  }
+  EXPECT_EQ(1000, tracker.bytes());
+  EXPECT_EQ(1500, tracker.peak());
+  // Outside of the scope, and on another thread, the same tracker is used.
+  grid->Set(200);
+  std::thread thread([&grid] { grid.reset(); });
+  thread.join();
+  EXPECT_EQ(0, tracker.bytes());
+  EXPECT_EQ(1500, tracker.peak());
+  tracker.ResetPeak();
+  EXPECT_EQ(0, tracker.peak());
+  // Without a tracker, nothing is recorded.
+  TrackedBytes untracked;
+  untracked.Set(100);
+  EXPECT_EQ(0, tracker.bytes());
+}
+
+TEST(MemoryUsageTest, TotalAndNames) {
+  MemoryUsage usage;
+  usage.Add(tesseract::MEMORY_WEIGHTS_INT, 300);
+  usage.Add(tesseract::MEMORY_DAWGS, 20);
+  usage.Add(tesseract::MEMORY_WEIGHTS_INT, 1);
+  EXPECT_EQ(301, usage.bytes[tesseract::MEMORY_WEIGHTS_INT]);
+  EXPECT_EQ(321, usage.Total());
+  std::string text;
+  usage.Print(&text);
+  EXPECT_NE(std::string::npos, text.find("weights_int"));
+  EXPECT_NE(std::string::npos, text.find("total"));
+  for (int i = 0; i < tesseract::MEMORY_COUNT; ++i) {
+    const char* name = tesseract::TessBaseAPI::GetMemoryCategoryName(i);
+    ASSERT_TRUE(name != nullptr);
+    for (int j = 0; j < i; ++j) {
+      EXPECT_STRNE(name, tesseract::TessBaseAPI::GetMemoryCategoryName(j));
+    }
+  }
+  EXPECT_EQ(nullptr, MemoryCategoryName(tesseract::MEMORY_COUNT));
+}
+
+// Tests that an engine reports the memory of its model, and of a page once
+// it is recognized, with the grids of the layout at their peak.
+TEST(MemoryUsageTest, EngineReportsSubsystems) {
+  tesseract::TessBaseAPI api;
+  ASSERT_EQ(0, api.Init(TESSDATA_DIR, "eng", tesseract::OEM_LSTM_ONLY));
+  int64_t loaded[tesseract::MEMORY_COUNT];
+  EXPECT_EQ(tesseract::MEMORY_COUNT,
+            api.GetMemoryUsage(loaded, tesseract::MEMORY_COUNT));
+  EXPECT_GT(loaded[tesseract::MEMORY_WEIGHTS_INT] +
+                loaded[tesseract::MEMORY_WEIGHTS_FLOAT],
+            0);
+  EXPECT_GT(loaded[tesseract::MEMORY_DAWGS], 0);
+  EXPECT_EQ(0, loaded[tesseract::MEMORY_PAGE_RES]);
+
+  Pix* pix = pixRead(file::JoinPath(TESTING_DIR, "phototest.tif").c_str());
+  ASSERT_TRUE(pix != nullptr);
+  api.SetImage(pix);
+  std::unique_ptr<char[]> text(api.GetUTF8Text());
+  int64_t page[tesseract::MEMORY_COUNT];
+  api.GetMemoryUsage(page, tesseract::MEMORY_COUNT);
+  EXPECT_GT(page[tesseract::MEMORY_PAGE_RES], 0);
+  EXPECT_GT(page[tesseract::MEMORY_IMAGES], 0);
+  EXPECT_GT(page[tesseract::MEMORY_NETWORK_SCRATCH], 0);
+  int64_t total = 0;
+  for (int64_t bytes : page) total += bytes;
+  // The layout analysis made grids, which add to the high-water mark.
+  EXPECT_GT(api.GetPageMemoryHighWater(),
+            total - page[tesseract::MEMORY_BBGRIDS]);
+  std::unique_ptr<char[]> report(api.GetMemoryUsageText());
+  EXPECT_NE(nullptr, strstr(report.get(), "page high-water mark"));
+  api.End();
+  pixDestroy(&pix);
+}
+
+}  // namespace
@@ -184,4 +184,93 @@ TEST_F(NetworkioTest, CopyWithXYTranspose) {
   EXPECT_EQ(next_t, 40);
 }
 
+// Tests that CopyBatchElement extracts each image as a batch of one.
+TEST_F(NetworkioTest, CopyBatchElement) {
+  NetworkIO nio;
+  SetupNetworkIO(&nio);
+  const int kHeights[] = {3, 4};
+  const int kWidths[] = {4, 5};
+  const int kStarts[] = {0, 12};
+  for (int b = 0; b < 2; ++b) {
+    NetworkIO copy;
+    copy.CopyBatchElement(nio, b);
+    EXPECT_EQ(copy.stride_map().Size(FD_BATCH), 1);
+    EXPECT_EQ(copy.stride_map().Size(FD_HEIGHT), kHeights[b]);
+    EXPECT_EQ(copy.stride_map().Size(FD_WIDTH), kWidths[b]);
+    EXPECT_EQ(copy.Width(), kHeights[b] * kWidths[b]);
+    StrideMap::Index index(copy.stride_map());
+    int pos = 0;
+    do {
+      // There is no padding, so t and the values both increase by one.
+      EXPECT_EQ(index.t(), pos);
+      EXPECT_EQ(copy.i(index.t())[0], kStarts[b] + pos);
+      EXPECT_EQ(copy.i(index.t())[1], -(kStarts[b] + pos));
+      ++pos;
+    } while (index.Increment());
+    EXPECT_EQ(pos, kHeights[b] * kWidths[b]);
+  }
+}
+
+// Tests that CopyWithTimestepMap expands a single row as given by the map.
+TEST_F(NetworkioTest, CopyWithTimestepMap) {
+  const int kCutWidth = 5;
+  std::vector<std::pair<int, int>> h_w_pairs(1, std::make_pair(1, kCutWidth));
+  StrideMap stride_map;
+  stride_map.SetStride(h_w_pairs);
+  NetworkIO cut;
+  cut.ResizeToMap(false, stride_map, 2);
+  for (int t = 0; t < kCutWidth; ++t) {
+    cut.f(t)[0] = t;
+    cut.f(t)[1] = -t;
+  }
+  // Timesteps 2 to 5 were cut out after timestep 1, and the map has an extra
+  // timestep beyond the end of cut, which gets the last one.
+  const std::vector<int> kMap = {0, 1, 1, 1, 1, 2, 3, 4, 5};
+  NetworkIO full;
+  full.CopyWithTimestepMap(cut, kMap);
+  EXPECT_EQ(full.stride_map().Size(FD_BATCH), 1);
+  EXPECT_EQ(full.stride_map().Size(FD_HEIGHT), 1);
+  EXPECT_EQ(full.Width(), static_cast<int>(kMap.size()));
+  for (int t = 0; t < full.Width(); ++t) {
+    int src_t = std::min(kMap[t], kCutWidth - 1);
+    EXPECT_EQ(full.f(t)[0], src_t);
+    EXPECT_EQ(full.f(t)[1], -src_t);
+  }
+}
+
+// Tests that int values are written and read in the int_range, and that
+// CopyPacking rescales them to the int_range of the destination.
+TEST_F(NetworkioTest, IntRange) {
+  const int kWidth = 3;
+  const double kValues[kWidth] = {4.0, -2.0, 0.5};
+  NetworkIO io;
+  io.Resize2d(true, kWidth, 1);
+  EXPECT_EQ(io.int_range(), 1.0f);
+  io.set_int_range(4.0f);
+  for (int t = 0; t < kWidth; ++t) io.WriteTimeStep(t, &kValues[t]);
+  EXPECT_EQ(io.i(0)[0], INT8_MAX);
+  EXPECT_NEAR(io.MaxAbs(), 4.0f, 1e-6);
+  for (int t = 0; t < kWidth; ++t) {
+    double value;
+    io.ReadTimeStep(t, &value);
+    EXPECT_NEAR(value, kValues[t], 4.0 / INT8_MAX);
+  }
+  // A copy keeps the range, but a new size resets it.
+  NetworkIO reversed;
+  reversed.CopyWithXReversal(io);
+  EXPECT_EQ(reversed.int_range(), 4.0f);
+  NetworkIO packed;
+  packed.Resize2d(true, kWidth, 2);
+  EXPECT_EQ(packed.int_range(), 1.0f);
+  packed.set_int_range(8.0f);
+  packed.Zero();
+  EXPECT_EQ(packed.CopyPacking(io, 1), 2);
+  for (int t = 0; t < kWidth; ++t) {
+    double values[2];
+    packed.ReadTimeStep(t, values);
+    EXPECT_EQ(values[0], 0.0);
+    EXPECT_NEAR(values[1], kValues[t], 8.0 / INT8_MAX);
+  }
+}
+
 }  // namespace
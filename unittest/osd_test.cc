@@ -33,11 +33,13 @@ class TestClass : public testing::Test {
 };
 
 #ifndef DISABLED_LEGACY_ENGINE
-static void OSDTester(int expected_deg, const char* imgname, const char* tessdatadir) {
+static void OSDTester(int expected_deg, const char* imgname, const char* tessdatadir,
+                      bool fast = false) {
   // log.info() << tessdatadir << " for image: " << imgname << std::endl;
   std::unique_ptr<tesseract::TessBaseAPI> api(new tesseract::TessBaseAPI());
   ASSERT_FALSE(api->Init(tessdatadir, "osd"))
       << "Could not initialize tesseract.";
+  if (fast) api->SetVariable("osd_fast", "1");
   Pix* image = pixRead(imgname);
   ASSERT_TRUE(image != nullptr) << "Failed to read test image.";
   api->SetImage(image);
@@ -72,6 +74,17 @@ TEST_P(OSDTest, MatchOrientationDegrees) {
 #endif
 }
 
+// Fast OSD on the reduced image must find the same orientation.
+TEST_P(OSDTest, FastMatchOrientationDegrees) {
+#ifdef DISABLED_LEGACY_ENGINE
+  // Skip test because TessBaseAPI::DetectOrientationScript is missing.
+  GTEST_SKIP();
+#else
+  OSDTester(std::get<0>(GetParam()), std::get<1>(GetParam()),
+            std::get<2>(GetParam()), true);
+#endif
+}
+
 INSTANTIATE_TEST_CASE_P(
     TessdataEngEuroHebrew, OSDTest,
     ::testing::Combine(::testing::Values(0),
@@ -0,0 +1,78 @@
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "include_gunit.h"
+#include "params.h"
+#include "strngs.h"
+
+namespace {
+
+using tesseract::BoolParam;
+using tesseract::DoubleParam;
+using tesseract::IntParam;
+using tesseract::ParamUtils;
+using tesseract::ParamsVectors;
+using tesseract::StringParam;
+
+// Tests that params are found by name and type, in the globals first.
+TEST(ParamsTest, FindsParams) {
+  ParamsVectors params;
+  IntParam int_param(3, "params_test_int", "", false, &params);
+  BoolParam bool_param(true, "params_test_bool", "", false, &params);
+  StringParam string_param("abc", "params_test_string", "", false, &params);
+  DoubleParam double_param(0.5, "params_test_double", "", false, &params);
+  EXPECT_EQ(&int_param, params.Find<IntParam>("params_test_int"));
+  EXPECT_EQ(&bool_param, params.Find<BoolParam>("params_test_bool"));
+  EXPECT_EQ(&string_param, params.Find<StringParam>("params_test_string"));
+  EXPECT_EQ(&double_param, params.Find<DoubleParam>("params_test_double"));
+  EXPECT_EQ(nullptr, params.Find<BoolParam>("params_test_int"));
+  EXPECT_EQ(nullptr, params.Find<IntParam>("params_test_none"));
+
+  IntParam global_param(4, "params_test_int", "", false, GlobalParams());
+  EXPECT_EQ(&global_param, ParamUtils::FindParam<IntParam>(
+                               "params_test_int", GlobalParams(), &params));
+  EXPECT_TRUE(ParamUtils::SetParam("params_test_double", "2.5",
+                                   tesseract::SET_PARAM_CONSTRAINT_NONE,
+                                   &params));
+  EXPECT_EQ(2.5, static_cast<double>(double_param));
+  STRING value;
+  EXPECT_TRUE(ParamUtils::GetParamAsString("params_test_int", &params, &value));
+  EXPECT_STREQ("4", value.c_str());
+}
+
+// Tests that the first of params with the same name is found, and the next
+// one once it is deleted.
+TEST(ParamsTest, FindsFirstOfSameName) {
+  ParamsVectors params;
+  auto* first = new IntParam(1, "params_test_same", "", false, &params);
+  auto* second = new IntParam(2, "params_test_same", "", false, &params);
+  IntParam third(3, "params_test_same", "", false, &params);
+  EXPECT_EQ(first, params.Find<IntParam>("params_test_same"));
+  delete second;
+  EXPECT_EQ(first, params.Find<IntParam>("params_test_same"));
+  delete first;
+  EXPECT_EQ(&third, params.Find<IntParam>("params_test_same"));
+  EXPECT_EQ(1, params.int_params.size());
+  {
+    IntParam other(4, "params_test_other", "", false, &params);
+    EXPECT_EQ(&other, params.Find<IntParam>("params_test_other"));
+  }
+  EXPECT_EQ(nullptr, params.Find<IntParam>("params_test_other"));
+
+  ParamsVectors other_params;
+  auto* moved = new IntParam(5, "params_test_same", "", false, &other_params);
+  third.ResetFrom(&other_params);
+  EXPECT_EQ(5, static_cast<int32_t>(third));
+  delete moved;
+  EXPECT_EQ(nullptr, other_params.Find<IntParam>("params_test_same"));
+}
+
+}  // namespace
@@ -0,0 +1,323 @@
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Performance regression tests of the hot paths, which are not run by make
+// check. Each case times an operation on a fixed input and compares it with
+// the budget of the case in the budgets file, failing if it is slower than
+// the budget by more than the tolerance. The times are measured as multiples
+// of a fixed scalar calibration loop, so one budgets file roughly holds
+// across machines of the same architecture. Every case must be listed in the
+// budgets file: a case without an entry fails, and a case whose budget is
+// "-", not calibrated yet, is reported as skipped. With TESS_PERF_RECORD=1
+// the costs of all the cases that ran are written back to the budgets file.
+//
+// Environment:
+//   TESS_PERF_BUDGETS    The budgets file, default perf_budgets.txt in the
+//                        source directory.
+//   TESS_PERF_TOLERANCE  The allowed slowdown as a fraction, default 0.15.
+//   TESS_PERF_RECORD     If 1, write the measured costs as the new budgets.
+
+#include <algorithm>  // for std::sort
+#include <chrono>     // for std::chrono::steady_clock
+#include <cmath>      // for std::sqrt
+#include <cstdio>     // for fopen, fprintf
+#include <cstdlib>    // for getenv, atof
+#include <cstring>    // for strcmp
+#include <fstream>    // for std::ifstream
+#include <functional> // for std::function
+#include <map>        // for std::map
+#include <memory>     // for std::unique_ptr
+#include <set>        // for std::set
+#include <sstream>    // for std::istringstream
+#include <string>     // for std::string
+
+#include "include_gunit.h"
+
+#include "allheaders.h"
+#include "baseapi.h"
+#include "dawg.h"
+#include "helpers.h"
+#include "log.h"  // for LOG
+#include "lstmrecognizer.h"
+#include "matrix.h"
+#include "pageiterator.h"
+#include "ratngs.h"
+#include "recodebeam.h"
+#include "tessdatamanager.h"
+#include "thresholder.h"
+
+namespace {
+
+#ifdef PERF_BUDGETS_FILE
+const char kDefaultBudgetsFile[] = PERF_BUDGETS_FILE;
+#else
+const char kDefaultBudgetsFile[] = "perf_budgets.txt";
+#endif
+
+// Times each operation is run before timing it, and times it is timed, of
+// which the median is taken, as it is robust to the odd preempted run.
+const int kWarmupRuns = 1;
+const int kTimedRuns = 7;
+
+const char* BudgetsFile() {
+  const char* file = getenv("TESS_PERF_BUDGETS");
+  return file != nullptr ? file : kDefaultBudgetsFile;
+}
+
+double Tolerance() {
+  const char* tolerance = getenv("TESS_PERF_TOLERANCE");
+  return tolerance != nullptr ? atof(tolerance) : 0.15;
+}
+
+bool RecordBudgets() {
+  const char* record = getenv("TESS_PERF_RECORD");
+  return record != nullptr && strcmp(record, "1") == 0;
+}
+
+// Returns the median wall time in ms of running fn.
+double MedianMs(const std::function<void()>& fn) {
+  for (int i = 0; i < kWarmupRuns; ++i) fn();
+  std::vector<double> times;
+  for (int i = 0; i < kTimedRuns; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    times.push_back(elapsed.count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+// A fixed loop of dependent scalar arithmetic, whose time is the unit of
+// the costs, so they scale with the speed of the machine.
+double CalibrationMs() {
+  static double calibration_ms = 0.0;
+  if (calibration_ms == 0.0) {
+    volatile double sink = 0.0;
+    calibration_ms = MedianMs([&sink]() {
+      double x = 1.0;
+      for (int i = 0; i < 4000000; ++i) x = std::sqrt(x + i) * 0.5 + 1.0;
+      sink = x;
+    });
+  }
+  return calibration_ms;
+}
+
+// The budgets read from the budgets file and the costs measured by the run,
+// which are written back to the file at the end if recording.
+class PerfBudgets : public ::testing::Environment {
+ public:
+  static PerfBudgets* Get() {
+    static PerfBudgets* budgets = new PerfBudgets;
+    return budgets;
+  }
+
+  void SetUp() override {
+    std::ifstream file(BudgetsFile());
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      std::istringstream fields(line);
+      std::string name, cost;
+      if (!(fields >> name >> cost)) continue;
+      if (cost == "-") {
+        uncalibrated_.insert(name);
+      } else {
+        budgets_[name] = atof(cost.c_str());
+      }
+    }
+  }
+
+  void TearDown() override {
+    if (!RecordBudgets() || measured_.empty()) return;
+    for (const auto& cost : measured_) {
+      budgets_[cost.first] = cost.second;
+      uncalibrated_.erase(cost.first);
+    }
+    FILE* fp = fopen(BudgetsFile(), "w");
+    if (fp == nullptr) {
+      LOG(ERROR) << "Cannot write " << BudgetsFile();
+      return;
+    }
+    fprintf(fp,
+            "# Budgets of unittest/perf_test, in multiples of the time of"
+            " its calibration loop.\n"
+            "# A budget of - is not calibrated yet, and its case is"
+            " skipped.\n"
+            "# Regenerate with TESS_PERF_RECORD=1 make check-perf.\n");
+    for (const auto& budget : budgets_) {
+      fprintf(fp, "%s %.4f\n", budget.first.c_str(), budget.second);
+    }
+    for (const auto& name : uncalibrated_) fprintf(fp, "%s -\n", name.c_str());
+    fclose(fp);
+  }
+
+  // Checks the median time of fn against the budget of the case name.
+  void Check(const std::string& name, const std::function<void()>& fn) {
+    double cost = MedianMs(fn) / CalibrationMs();
+    measured_[name] = cost;
+    auto budget = budgets_.find(name);
+    if (budget == budgets_.end()) {
+      LOG(INFO) << name << ": cost " << cost << ", no budget";
+      if (RecordBudgets()) return;
+      if (uncalibrated_.count(name) > 0) {
+        GTEST_SKIP() << name << " has no calibrated budget in "
+                     << BudgetsFile() << ", record one with TESS_PERF_RECORD=1";
+      }
+      ADD_FAILURE() << name << " is missing from " << BudgetsFile();
+      return;
+    }
+    double limit = budget->second * (1.0 + Tolerance());
+    LOG(INFO) << name << ": cost " << cost << ", budget " << budget->second;
+    EXPECT_LE(cost, limit) << name << " is " << cost / budget->second
+                           << " times its budget";
+  }
+
+ private:
+  PerfBudgets() = default;
+
+  std::map<std::string, double> budgets_;
+  // Cases listed with a budget of "-", which are skipped until recorded.
+  std::set<std::string> uncalibrated_;
+  std::map<std::string, double> measured_;
+};
+
+::testing::Environment* const kPerfBudgets =
+    ::testing::AddGlobalTestEnvironment(PerfBudgets::Get());
+
+std::string TestingFile(const char* name) {
+  return file::JoinPath(TESTING_DIR, name);
+}
+
+// Returns a pix of the test image, or null if it can't be read.
+Pix* ReadTestingPix(const char* name) {
+  return pixRead(TestingFile(name).c_str());
+}
+
+class PerfTest : public ::testing::Test {};
+
+TEST_F(PerfTest, RecognizeLine) {
+  tesseract::TessBaseAPI api;
+  ASSERT_EQ(api.Init(TESSDATA_DIR, "eng", tesseract::OEM_LSTM_ONLY), 0);
+  api.SetPageSegMode(tesseract::PSM_RAW_LINE);
+  for (const char* image : {"HelloGoogle.tif", "trainingitalline.tif"}) {
+    Pix* pix = ReadTestingPix(image);
+    ASSERT_TRUE(pix != nullptr) << image;
+    PerfBudgets::Get()->Check(std::string("RecognizeLine/") + image, [&]() {
+      api.SetImage(pix);
+      EXPECT_EQ(api.Recognize(nullptr), 0);
+    });
+    pixDestroy(&pix);
+  }
+  api.End();
+}
+
+// Decodes outputs of the eng model that are random, but always the same,
+// each timestep peaked on a few codes, as in real outputs.
+TEST_F(PerfTest, RecodeBeamSearchDecode) {
+  tesseract::TessdataManager mgr;
+  std::string traineddata = file::JoinPath(TESSDATA_DIR, "eng.traineddata");
+  ASSERT_TRUE(mgr.Init(traineddata.c_str()));
+  tesseract::LSTMRecognizer recognizer;
+  ASSERT_TRUE(recognizer.Load(nullptr, nullptr, &mgr));
+  const int kWidth = 400;
+  const int num_outputs = recognizer.NumOutputs();
+  GENERIC_2D_ARRAY<float> outputs(kWidth, num_outputs, 0.0f);
+  tesseract::TRand random;
+  random.set_seed(42);
+  for (int t = 0; t < kWidth; ++t) {
+    float total = 0.0f;
+    for (int c = 0; c < num_outputs; ++c) {
+      outputs(t, c) = 1e-4f * random.UnsignedRand(1.0);
+      total += outputs(t, c);
+    }
+    // Most of the probability on a null or a random code, some on another.
+    int best = random.IntRand() % 2 == 0 ? recognizer.null_char()
+                                         : random.IntRand() % num_outputs;
+    int second = random.IntRand() % num_outputs;
+    outputs(t, best) += 0.8f;
+    outputs(t, second) += 0.2f;
+    total += 1.0f;
+    for (int c = 0; c < num_outputs; ++c) outputs(t, c) /= total;
+  }
+  tesseract::RecodeBeamSearch search(recognizer.GetRecoder(),
+                                     recognizer.null_char(), false, nullptr);
+  PerfBudgets::Get()->Check("RecodeBeamSearch/Decode", [&]() {
+    search.Decode(outputs, 3.5, -0.125, -25.0, nullptr);
+  });
+}
+
+TEST_F(PerfTest, SquishedDawgLookup) {
+  tesseract::TessdataManager mgr;
+  std::string traineddata = file::JoinPath(TESSDATA_DIR, "eng.traineddata");
+  ASSERT_TRUE(mgr.Init(traineddata.c_str()));
+  tesseract::LSTMRecognizer recognizer;
+  ASSERT_TRUE(recognizer.Load(nullptr, nullptr, &mgr));
+  tesseract::TFile fp;
+  ASSERT_TRUE(mgr.GetComponent(tesseract::TESSDATA_LSTM_SYSTEM_DAWG, &fp));
+  tesseract::SquishedDawg dawg(tesseract::DAWG_TYPE_WORD, "eng",
+                               SYSTEM_DAWG_PERM, 0);
+  ASSERT_TRUE(dawg.Load(&fp));
+  const UNICHARSET& unicharset = recognizer.GetUnicharset();
+  std::vector<std::unique_ptr<WERD_CHOICE>> words;
+  for (const char* word :
+       {"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+        "recognition", "character", "Tesseract", "zzyzx", "qwrtp",
+        "information", "between", "government"}) {
+    words.emplace_back(new WERD_CHOICE(word, unicharset));
+  }
+  int found = 0;
+  PerfBudgets::Get()->Check("SquishedDawg/word_in_dawg", [&]() {
+    found = 0;
+    for (int i = 0; i < 2000; ++i) {
+      for (const auto& word : words) found += dawg.word_in_dawg(*word);
+    }
+  });
+  // The common words must be found, or the lookups are not of real words.
+  EXPECT_GT(found, 0);
+}
+
+TEST_F(PerfTest, Threshold) {
+  Pix* pix = ReadTestingPix("phototest.tif");
+  ASSERT_TRUE(pix != nullptr);
+  Pix* grey = pixConvertTo8(pix, false);
+  pixDestroy(&pix);
+  tesseract::ImageThresholder thresholder;
+  PerfBudgets::Get()->Check("ImageThresholder/ThresholdToPix", [&]() {
+    thresholder.SetImage(grey);
+    Pix* binary = nullptr;
+    EXPECT_TRUE(thresholder.ThresholdToPix(tesseract::PSM_AUTO, &binary));
+    pixDestroy(&binary);
+  });
+  pixDestroy(&grey);
+}
+
+// ColumnFinder is timed through the layout analysis of a binary image, of
+// which it is most of the time.
+TEST_F(PerfTest, ColumnFinder) {
+  tesseract::TessBaseAPI api;
+  ASSERT_EQ(api.Init(TESSDATA_DIR, "eng", tesseract::OEM_LSTM_ONLY), 0);
+  api.SetPageSegMode(tesseract::PSM_AUTO);
+  Pix* pix = ReadTestingPix("8087_054.3B.tif");
+  ASSERT_TRUE(pix != nullptr);
+  Pix* binary = pixConvertTo1(pix, 128);
+  pixDestroy(&pix);
+  PerfBudgets::Get()->Check("ColumnFinder/8087_054.3B.tif", [&]() {
+    api.SetImage(binary);
+    std::unique_ptr<tesseract::PageIterator> it(api.AnalyseLayout());
+    EXPECT_TRUE(it != nullptr);
+  });
+  pixDestroy(&binary);
+  api.End();
+}
+
+}  // namespace
@@ -21,8 +21,11 @@
 #include <fstream>
 #include <iostream>
 #include <locale>
+#include <chrono>
 #include <memory>               // std::unique_ptr
 #include <string>
+#include <thread>
+#include <vector>
 #include "baseapi.h"
 #include "gmock/gmock.h"
 #include "include_gunit.h"
@@ -159,4 +162,41 @@ TEST(QuickTest, NewProgressReporting) {
   NewProgressTester(TESTING_DIR "/phototest.tif", TESSDATA_DIR "_fast", "eng");
 }
 
+// Tests that a cancellation stops the layout analysis, before any words are
+// recognized, and that a passed deadline stops the recognition as well.
+TEST(QuickTest, CancelStopsLayout) {
+  std::unique_ptr<tesseract::TessBaseAPI> api(new tesseract::TessBaseAPI());
+  ASSERT_FALSE(api->Init(TESSDATA_DIR "_fast", "eng"))
+      << "Could not initialize tesseract.";
+  Pix* image = pixRead(TESTING_DIR "/phototest.tif");
+  ASSERT_TRUE(image != nullptr) << "Failed to read test image.";
+  api->SetImage(image);
+
+  ETEXT_DESC monitor;
+  std::vector<int> cancel_words;
+  monitor.cancel = [](void* words, int num_words) -> bool {
+    static_cast<std::vector<int>*>(words)->push_back(num_words);
+    return true;
+  };
+  monitor.cancel_this = &cancel_words;
+  EXPECT_NE(0, api->Recognize(&monitor));
+  ASSERT_EQ(1, cancel_words.size());
+  EXPECT_EQ(0, cancel_words[0]);
+
+  api->SetImage(image);
+  ETEXT_DESC deadline;
+  deadline.set_deadline_msecs(1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  EXPECT_NE(0, api->Recognize(&deadline));
+
+  // Without a monitor, the page is recognized as usual.
+  api->SetImage(image);
+  EXPECT_EQ(0, api->Recognize(nullptr));
+  std::unique_ptr<char[]> text(api->GetUTF8Text());
+  EXPECT_THAT(text.get(), ::testing::HasSubstr("quick brown"));
+
+  api->End();
+  pixDestroy(&image);
+}
+
 }  // namespace
@@ -25,6 +25,7 @@
 
 using tesseract::CCUtil;
 using tesseract::Dict;
+using tesseract::LSTMLatticeNode;
 using tesseract::PointerVector;
 using tesseract::RecodeBeamSearch;
 using tesseract::RecodedCharID;
@@ -428,6 +429,86 @@ TEST_F(RecodeBeamTest, DoesEnglish) {
   ExpectCorrect(outputs, transcription);
 }
 
+TEST_F(RecodeBeamTest, DoesGreedyDecoding) {
+  for (const char* lang : {"chi_sim", "kor", "mar", "eng"}) {
+    LOG(INFO) << "Testing greedy " << lang << "\n";
+    LoadUnicharset(std::string(lang) + ".unicharset");
+    // Correctly reproduce the first kNumchars characters from easy output.
+    std::string truth_utf8;
+    GenericVector<int> transcription;
+    for (int i = SPECIAL_UNICHAR_CODES_COUNT; i < kNumChars; ++i) {
+      transcription.push_back(i);
+      truth_utf8 += ccutil_.unicharset.id_to_unichar(i);
+    }
+    GENERIC_2D_ARRAY<float> outputs =
+        GenerateRandomPaddedOutputs(transcription, kPadding);
+    RecodeBeamSearch beam_search(recoder_, encoded_null_char_, false, nullptr);
+    beam_search.DecodeGreedy(outputs, 3.5, -0.125, nullptr);
+    // The random padding decodes to anything, so only the start must match.
+    GenericVector<int> unichar_ids, xcoords;
+    GenericVector<float> certainties, ratings;
+    beam_search.ExtractBestPathAsUnicharIds(false, &ccutil_.unicharset,
+                                            &unichar_ids, &certainties,
+                                            &ratings, &xcoords);
+    std::string u_decoded;
+    for (int u = 0; u < unichar_ids.size(); ++u) {
+      if (u_decoded.size() >= truth_utf8.size()) break;
+      u_decoded += ccutil_.unicharset.id_to_unichar(unichar_ids[u]);
+    }
+    EXPECT_EQ(truth_utf8, u_decoded);
+  }
+}
+
+TEST_F(RecodeBeamTest, DoesKeepLattice) {
+  LOG(INFO) << "Testing lattice eng\n";
+  LoadUnicharset("eng.unicharset");
+  GenericVector<int> transcription;
+  for (int i = SPECIAL_UNICHAR_CODES_COUNT; i < kNumChars; ++i) {
+    transcription.push_back(i);
+  }
+  GENERIC_2D_ARRAY<float> outputs =
+      GenerateRandomPaddedOutputs(transcription, kPadding);
+  RecodeBeamSearch beam_search(recoder_, encoded_null_char_, false, nullptr);
+  beam_search.SetLatticeSize(4);
+  beam_search.Decode(outputs, 3.5, -0.125, -25.0, nullptr);
+  PointerVector<WERD_RES> words;
+  beam_search.ExtractBestPathAsWords(TBOX(0, 0, outputs.dim1(), 20), 2.0f,
+                                     false, &ccutil_.unicharset, &words);
+  GenericVector<int> labels, xcoords;
+  beam_search.ExtractBestPathAsLabels(&labels, &xcoords);
+  ASSERT_GT(words.size(), 0);
+  const std::vector<LSTMLatticeNode>* lattice = words[0]->lstm_lattice.get();
+  ASSERT_TRUE(lattice != nullptr);
+  for (int w = 1; w < words.size(); ++w) {
+    EXPECT_EQ(lattice, words[w]->lstm_lattice.get());
+  }
+  // Each node follows on from the timestep before its prev, and the best
+  // path can be traced back from one of the nodes of the last timestep.
+  int last_t = outputs.dim1() - 1;
+  bool found_best = false;
+  for (size_t i = 0; i < lattice->size(); ++i) {
+    const LSTMLatticeNode& node = (*lattice)[i];
+    EXPECT_EQ(node.timestep * 2, node.x);
+    if (node.prev >= 0) {
+      EXPECT_LT(node.prev, i);
+      EXPECT_EQ((*lattice)[node.prev].timestep + 1, node.timestep);
+    } else {
+      EXPECT_EQ(0, node.timestep);
+    }
+    if (node.timestep != last_t) continue;
+    std::vector<int> codes;
+    for (int n = i; n >= 0; n = (*lattice)[n].prev) {
+      if ((*lattice)[n].code != encoded_null_char_ && !(*lattice)[n].duplicate)
+        codes.insert(codes.begin(), (*lattice)[n].code);
+    }
+    if (codes.size() == labels.size() &&
+        std::equal(codes.begin(), codes.end(), &labels[0])) {
+      found_best = true;
+    }
+  }
+  EXPECT_TRUE(found_best);
+}
+
 TEST_F(RecodeBeamTest, DISABLED_EngDictionary) {
   LOG(INFO) << "Testing eng dictionary" << "\n";
   LoadUnicharset("eng_beam.unicharset");
@@ -9,6 +9,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <vector>
+
 #include "rect.h"
 
 #include "include_gunit.h"
@@ -173,4 +175,23 @@ TEST_F(TBOXTest, OverlapYFractionZeroSize) {
   EXPECT_DOUBLE_EQ(0.0, small.y_overlap_fraction(zero));
 }
 
+TEST_F(TBOXTest, FilterOverlappingMatchesOverlap) {
+  TBOX query(10, 10, 30, 30);
+  std::vector<TBOX> boxes;
+  for (int x = 0; x < 40; x += 3) {
+    for (int y = 0; y < 40; y += 7) {
+      boxes.push_back(TBOX(x, y, x + 2, y + 4));
+    }
+  }
+  std::vector<int> indices(boxes.size());
+  int num_found = FilterOverlappingBoxes(query, &boxes[0], boxes.size(),
+                                         &indices[0]);
+  std::vector<int> expected;
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    if (query.overlap(boxes[i])) expected.push_back(i);
+  }
+  indices.resize(num_found);
+  EXPECT_EQ(expected, indices);
+}
+
 }  // namespace
@@ -91,6 +91,24 @@ TEST_F(StridemapTest, Indexing) {
   } while (index.Decrement());
 }
 
+TEST_F(StridemapTest, OffsetT) {
+  // This test verifies that OffsetT gives the same t as AddOffset on a copy
+  // for all the valid neighbours of every location in a batch.
+  StrideMap stride_map;
+  stride_map.SetStride({{3, 4}, {4, 5}, {2, 3}});
+  StrideMap::Index index(stride_map);
+  do {
+    for (int x = -2; x <= 2; ++x) {
+      for (int y = -2; y <= 2; ++y) {
+        StrideMap::Index copy(index);
+        if (copy.AddOffset(x, FD_WIDTH) && copy.AddOffset(y, FD_HEIGHT)) {
+          EXPECT_EQ(copy.t(), index.OffsetT(x, y));
+        }
+      }
+    }
+  } while (index.Increment());
+}
+
 TEST_F(StridemapTest, Scaling) {
   // This test verifies that with a batch of arrays of different sizes, the
   // scaling/reduction functions work as expected.
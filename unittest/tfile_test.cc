@@ -178,4 +178,33 @@ TEST_F(TfileTest, BigEndian) {
   m3.ExpectEq(m2);
 }
 
+TEST_F(TfileTest, NoCopyView) {
+  // This test verifies that Tfile can read raw memory in place, and give
+  // views of the native-endian data in it.
+  GenericVector<char> data;
+  TFile fpw;
+  fpw.OpenWrite(&data);
+  int32_t values[] = {1, 2, 3, 4, 5};
+  int32_t count = 5;
+  EXPECT_TRUE(fpw.Serialize(&count));
+  EXPECT_TRUE(fpw.Serialize(values, count));
+  TFile fpr;
+  fpr.OpenNoCopy(&data[0], data.size());
+  int32_t read_count;
+  EXPECT_TRUE(fpr.DeSerialize(&read_count));
+  EXPECT_EQ(count, read_count);
+  const int32_t* view;
+  EXPECT_TRUE(fpr.DeSerializeView(&view, read_count));
+  EXPECT_EQ(&data[sizeof(count)], reinterpret_cast<const char*>(view));
+  for (int i = 0; i < count; ++i) EXPECT_EQ(values[i], view[i]);
+  // There is nothing left to view.
+  EXPECT_FALSE(fpr.DeSerializeView(&view, 1));
+  // Data that needs swapping can't be viewed, and is left to be read.
+  fpr.Rewind();
+  fpr.set_swap(true);
+  EXPECT_TRUE(fpr.Skip(sizeof(count)));
+  EXPECT_FALSE(fpr.DeSerializeView(&view, read_count));
+  EXPECT_EQ(static_cast<int>(sizeof(count)), fpr.Offset());
+}
+
 }  // namespace
@@ -0,0 +1,90 @@
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tracing.h"
+
+#include "include_gunit.h"
+
+using tesseract::TraceSpan;
+using tesseract::Tracing;
+
+namespace {
+
+// Returns the number of times pattern occurs in text.
+int CountOccurrences(const std::string& text, const std::string& pattern) {
+  int count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+// Tests that the spans of each thread are recorded only while tracing is
+// started, and are written as complete events.
+TEST(TracingTest, RecordsSpansWhileStarted) {
+  { TraceSpan span("before"); }
+  Tracing::Start();
+  {
+    TraceSpan outer("outer");
+    { TraceSpan inner("inner \"quoted\""); }
+    std::thread thread([] { TraceSpan span("other thread"); });
+    thread.join();
+  }
+  Tracing::Stop();
+  { TraceSpan span("after"); }
+
+  std::string json;
+  Tracing::WriteChromeTrace(&json);
+  EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+  EXPECT_EQ(3, CountOccurrences(json, "\"ph\":\"X\""));
+  EXPECT_EQ(1, CountOccurrences(json, "\"name\":\"outer\""));
+  EXPECT_EQ(1, CountOccurrences(json, "\"name\":\"inner \\\"quoted\\\"\""));
+  EXPECT_EQ(1, CountOccurrences(json, "\"name\":\"other thread\""));
+  EXPECT_EQ(0, CountOccurrences(json, "before"));
+  EXPECT_EQ(0, CountOccurrences(json, "after"));
+  // The spans of another thread have another tid.
+  size_t other = json.find("other thread");
+  size_t outer = json.find("\"outer\"");
+  std::string other_tid = json.substr(json.find("\"tid\":", other), 8);
+  std::string outer_tid = json.substr(json.find("\"tid\":", outer), 8);
+  EXPECT_NE(other_tid, outer_tid);
+
+  // Starting again forgets the spans.
+  Tracing::Start();
+  Tracing::Stop();
+  Tracing::WriteChromeTrace(&json);
+  EXPECT_EQ(0, CountOccurrences(json, "\"ph\":\"X\""));
+}
+
+// Tests that the totals add up the spans of each name.
+TEST(TracingTest, TotalsByName) {
+  Tracing::Start();
+  for (int i = 0; i < 3; ++i) {
+    TraceSpan outer("outer");
+    { TraceSpan inner("inner"); }
+  }
+  Tracing::Stop();
+  std::vector<Tracing::SpanTotal> totals;
+  Tracing::GetTotals(&totals);
+  ASSERT_EQ(2, totals.size());
+  EXPECT_EQ("inner", totals[0].name);
+  EXPECT_EQ(3, totals[0].count);
+  EXPECT_EQ("outer", totals[1].name);
+  EXPECT_EQ(3, totals[1].count);
+  EXPECT_GE(totals[1].total_us, totals[0].total_us);
+}
+
+}  // namespace
@@ -140,11 +140,14 @@ class UnicharcompressTest : public ::testing::Test {
               << code_range;
   }
   // Checks for extensions of the current code that either finish a code, or
-  // extend it and checks those extensions recursively.
+  // extend it and checks those extensions recursively. Also checks that the
+  // decoding trie states agree with the codes.
   void CheckCodeExtensions(const RecodedCharID& code,
                            const std::vector<RecodedCharID>& times_seen) {
     RecodedCharID extended = code;
     int length = code.length();
+    int state = compressed_.GetPrefixState(code);
+    EXPECT_GE(state, 0);
     const GenericVector<int>* final_codes = compressed_.GetFinalCodes(code);
     if (final_codes != nullptr) {
       for (int i = 0; i < final_codes->size(); ++i) {
@@ -153,6 +156,7 @@ class UnicharcompressTest : public ::testing::Test {
         extended.Set(length, ending);
         int unichar_id = compressed_.DecodeUnichar(extended);
         EXPECT_NE(INVALID_UNICHAR_ID, unichar_id);
+        EXPECT_EQ(unichar_id, compressed_.GetFinalUnichar(state, i));
       }
     }
     const GenericVector<int>* next_codes = compressed_.GetNextCodes(code);
@@ -161,6 +165,8 @@ class UnicharcompressTest : public ::testing::Test {
         int extension = (*next_codes)[i];
         EXPECT_GT(times_seen[extension](length), 0);
         extended.Set(length, extension);
+        EXPECT_EQ(compressed_.GetNextState(state, i),
+                  compressed_.GetPrefixState(extended));
         CheckCodeExtensions(extended, times_seen);
       }
     }
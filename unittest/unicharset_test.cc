@@ -147,6 +147,38 @@ TEST(UnicharsetTest, MultibyteBigrams) {
   EXPECT_EQ(v.unichar_to_id("\u0ccd\u0cad"), 7);
 }
 
+TEST(UnicharsetTest, Backtracking) {
+  // This test verifies that encode_string backs off from a short match that
+  // leaves the rest of the string unencodable, and encodes what it can of a
+  // string that can't be fully encoded.
+  UNICHARSET u;
+  u.unichar_insert("a");
+  u.unichar_insert("ab");
+  u.unichar_insert("c");
+  EXPECT_EQ(u.size(), 6);
+  EXPECT_EQ(u.unichar_to_id("ab"), 4);
+  EXPECT_EQ(u.unichar_to_id("b"), INVALID_UNICHAR_ID);
+  EXPECT_EQ(u.unichar_to_id("abc"), INVALID_UNICHAR_ID);
+  GenericVector<int> labels;
+  GenericVector<char> lengths;
+  EXPECT_TRUE(u.encode_string("abc", true, &labels, &lengths, nullptr));
+  std::vector<int> v(&labels[0], &labels[0] + labels.size());
+  EXPECT_THAT(v, ElementsAreArray({4, 5}));
+  std::vector<char> l(&lengths[0], &lengths[0] + lengths.size());
+  EXPECT_THAT(l, ElementsAreArray({2, 1}));
+  int encoded_length;
+  EXPECT_FALSE(
+      u.encode_string("abcxa", true, &labels, &lengths, &encoded_length));
+  EXPECT_EQ(3, encoded_length);
+  v = std::vector<int>(&labels[0], &labels[0] + labels.size());
+  EXPECT_THAT(v, ElementsAreArray({4, 5}));
+  EXPECT_FALSE(
+      u.encode_string("abcxa", false, &labels, &lengths, &encoded_length));
+  EXPECT_EQ(5, encoded_length);
+  v = std::vector<int>(&labels[0], &labels[0] + labels.size());
+  EXPECT_THAT(v, ElementsAreArray({4, 5, INVALID_UNICHAR_ID, 3}));
+}
+
 TEST(UnicharsetTest, OldStyle) {
   // This test verifies an old unicharset that contains fi/fl ligatures loads
   // and keeps all the entries.
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////
+// File:        weightmatrix_test.cc
+// Description: Tests the serialization of WeightMatrix as half precision.
+//
+// (C) Copyright 2020, Google Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+///////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include "genericvector.h"
+#include "helpers.h"
+#include "include_gunit.h"
+#include "matrix.h"
+#include "serialis.h"
+#include "weightmatrix.h"
+
+namespace tesseract {
+namespace {
+
+class WeightMatrixTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::locale::global(std::locale(""));
+    random_.set_seed(1234);
+  }
+
+  // Returns value rounded to the nearest IEEE half precision value, ties to
+  // even, computed independently of the conversion in WeightMatrix.
+  static double RoundToHalf(double value) {
+    // Below the smallest normal half, values are multiples of 2^-24.
+    if (std::fabs(value) < std::ldexp(1.0, -14)) {
+      return std::ldexp(std::nearbyint(std::ldexp(value, 24)), -24);
+    }
+    // Otherwise they have 11 significant bits.
+    int exponent;
+    double mantissa = std::frexp(value, &exponent);
+    return std::ldexp(std::nearbyint(std::ldexp(mantissa, 11)), exponent - 11);
+  }
+
+  // Serializes w into data, as half precision if half.
+  static void Serialize(const WeightMatrix& w, bool training, bool half,
+                        GenericVector<char>* data) {
+    TFile fp;
+    fp.OpenWrite(data);
+    fp.set_half_precision(half);
+    ASSERT_TRUE(w.Serialize(training, &fp));
+  }
+
+  // Deserializes data into w.
+  static void DeSerialize(GenericVector<char>* data, bool training,
+                          WeightMatrix* w) {
+    TFile fp;
+    ASSERT_TRUE(fp.Open(&(*data)[0], data->size()));
+    ASSERT_TRUE(w->DeSerialize(training, &fp));
+  }
+
+  static void ExpectEqualWeights(const GENERIC_2D_ARRAY<double>& expected,
+                                 const WeightMatrix& w) {
+    GENERIC_2D_ARRAY<double> weights;
+    w.GetDoubleWeights(&weights);
+    ASSERT_EQ(expected.dim1(), weights.dim1());
+    ASSERT_EQ(expected.dim2(), weights.dim2());
+    for (int i = 0; i < expected.dim1(); ++i) {
+      for (int j = 0; j < expected.dim2(); ++j) {
+        EXPECT_EQ(expected(i, j), weights(i, j)) << i << "," << j;
+      }
+    }
+  }
+
+  TRand random_;
+};
+
+// Tests that weights serialized as half precision come back as the rounded
+// halves of the original, in a file of about a quarter of the size.
+TEST_F(WeightMatrixTest, HalfRoundTrip) {
+  const int kNumOut = 37;
+  const int kNumIn = 75;
+  WeightMatrix w;
+  w.InitWeightsFloat(kNumOut, kNumIn + 1, false, 0.5f, &random_);
+  GENERIC_2D_ARRAY<double> weights;
+  w.GetDoubleWeights(&weights);
+  GENERIC_2D_ARRAY<double> halves(kNumOut, kNumIn + 1, 0.0);
+  for (int i = 0; i < kNumOut; ++i) {
+    for (int j = 0; j <= kNumIn; ++j) halves(i, j) = RoundToHalf(weights(i, j));
+  }
+  GenericVector<char> full_data, half_data;
+  Serialize(w, false, false, &full_data);
+  Serialize(w, false, true, &half_data);
+  EXPECT_LT(half_data.size() * 3, full_data.size());
+  WeightMatrix w2;
+  DeSerialize(&half_data, false, &w2);
+  EXPECT_FALSE(w2.is_int_mode());
+  EXPECT_FALSE(w2.is_float32_mode());
+  ExpectEqualWeights(halves, w2);
+  // Halves are exact in float, so float32 mode keeps them as they are.
+  WeightMatrix w3;
+  DeSerialize(&half_data, false, &w3);
+  w3.ConvertToFloat32();
+  EXPECT_TRUE(w3.is_float32_mode());
+  ExpectEqualWeights(halves, w3);
+  // The halves convert to int exactly as the rounded values do.
+  WeightMatrix w4;
+  DeSerialize(&half_data, false, &w4);
+  w4.ConvertToInt();
+  WeightMatrix expected_int;
+  expected_int.InitConverted(halves, w4);
+  EXPECT_TRUE(w4.is_int_mode());
+  GENERIC_2D_ARRAY<double> int_weights;
+  expected_int.GetDoubleWeights(&int_weights);
+  ExpectEqualWeights(int_weights, w4);
+  // And a half matrix written again as half precision is unchanged.
+  GenericVector<char> rewritten_data;
+  Serialize(w2, false, true, &rewritten_data);
+  ASSERT_EQ(half_data.size(), rewritten_data.size());
+  for (int i = 0; i < half_data.size(); ++i) {
+    EXPECT_EQ(half_data[i], rewritten_data[i]);
+  }
+}
+
+// Tests that a matrix serialized with its training data keeps its full
+// precision, as half precision only applies without training data.
+TEST_F(WeightMatrixTest, HalfNotWithTraining) {
+  const int kNumOut = 11;
+  const int kNumIn = 20;
+  WeightMatrix w;
+  w.InitWeightsFloat(kNumOut, kNumIn + 1, false, 0.5f, &random_);
+  GENERIC_2D_ARRAY<double> weights;
+  w.GetDoubleWeights(&weights);
+  GenericVector<char> data;
+  Serialize(w, true, true, &data);
+  WeightMatrix w2;
+  DeSerialize(&data, true, &w2);
+  ExpectEqualWeights(weights, w2);
+}
+
+}  // namespace
+}  // namespace tesseract